@@ -56,6 +56,9 @@ endfunction(piglit_include_target_api)
 # In addition to calling `add_executable`, it adds to each object file
 # a dependency on piglit_dispatch's generated files.
 #
+# With PIGLIT_BUILD_TEST_MODULES the OpenGL tests are also built as
+# modules, see piglit_add_test_module.
+#
 function(piglit_add_executable name)
 
     piglit_create_manifest_file(${name})
@@ -66,8 +69,40 @@ function(piglit_add_executable name)
 
     install(TARGETS ${name} DESTINATION ${PIGLIT_INSTALL_LIBDIR}/bin)
 
+    if(PIGLIT_BUILD_TEST_MODULES AND piglit_target_api STREQUAL "gl")
+        piglit_add_test_module(${name} ${ARGV})
+    endif()
+
 endfunction(piglit_add_executable)
 
+#
+# function piglit_add_test_module
+#
+# Build the sources of the test `name` into bin/modules/${name}.so, which
+# piglit-test-host loads to run the test in its own process. The test's
+# main() is renamed by PIGLIT_GL_TEST_CONFIG_BEGIN; tests with a main() of
+# their own are still built, and the host refuses to run them.
+#
+# The module is linked with the libraries linked to every target of the
+# directory. The symbols of libraries only linked to the executable are
+# left undefined, and the host refuses the modules it can't load.
+#
+function(piglit_add_test_module name)
+
+    list(REMOVE_AT ARGV 0)
+    add_library(${name}_module MODULE ${ARGV})
+    add_dependencies(${name}_module piglit_dispatch_gen)
+    target_compile_definitions(${name}_module PRIVATE PIGLIT_TEST_MODULE)
+    set_target_properties(${name}_module PROPERTIES
+        OUTPUT_NAME ${name}
+        PREFIX ""
+        LIBRARY_OUTPUT_DIRECTORY ${CMAKE_BINARY_DIR}/bin/modules)
+
+    install(TARGETS ${name}_module
+            DESTINATION ${PIGLIT_INSTALL_LIBDIR}/bin/modules)
+
+endfunction(piglit_add_test_module)
+
 #
 # function piglit_add_library
 #
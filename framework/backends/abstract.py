@@ -39,16 +39,16 @@ from framework.status import INCOMPLETE
 
 
 @contextlib.contextmanager
-def write_compressed(filename):
+def write_compressed(filename, mode=None):
     """Write a the final result using desired compression.
 
     This helper function reads the piglit.conf to decide whether to use
-    compression, and what type of compression to use.
+    compression, and what type of compression to use, unless mode is given.
 
     Currently it implements no compression
 
     """
-    mode = compression.get_mode()
+    mode = mode or compression.get_mode()
     if mode != 'none':
         # if the suffix (final .xxx) is a known compression suffix
         suffix = os.path.splitext(filename)[1]
@@ -138,6 +138,9 @@ class Backend(metaclass=abc.ABCMeta):
         overwrite that value with the final value. That object needs to take a
         'data' parameter which is a result.TestResult object.
 
+        It may also be called after the with statement, to write a result that
+        is only known later; until then the test stays incomplete.
+
         Arguments:
         name -- the name of the test to be written
         data -- a TestResult object representing the test data
@@ -167,7 +170,7 @@ class FileBackend(Backend):
         self._counter = itertools.count(file_start_count)
         self._write_final = write_compressed
 
-    __INCOMPLETE = TestResult(result=INCOMPLETE)
+    _INCOMPLETE = TestResult(result=INCOMPLETE)
 
     def __fsync(self, file_):
         """ Sync the file to disk
@@ -212,7 +215,7 @@ class FileBackend(Backend):
             next(self._counter), self._file_extension))
 
         with open(file_, 'w') as f:
-            self._write(f, name, self.__INCOMPLETE)
+            self._write(f, name, self._INCOMPLETE)
             self.__fsync(f)
 
         yield finish
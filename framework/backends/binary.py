@@ -0,0 +1,373 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Module providing a compact binary backend for piglit.
+
+The JSON results repeat the full name of every test, the status names and the
+command and environment of every test, which are mostly the same. This format
+holds the same data with every distinct string stored once.
+
+A results file starts with MAGIC and the version of the format, followed by
+the metadata of the run as a JSON document and then a record per test. Each
+string is written the first time it is used and then referred to by its
+index, and statuses are stored as a byte. The test names are stored as their
+group, which is shared by all of the tests in it, and their last element.
+
+"""
+
+import collections
+import json
+import os
+import shutil
+import struct
+
+from framework import exceptions, grouptools, results, status
+from .abstract import write_compressed
+from .register import Registry
+from . import compression
+from . import json as json_backend
+
+__all__ = [
+    'REGISTRY',
+    'BinaryBackend',
+]
+
+MAGIC = b'PIGLITR\0'
+
+# The current version of the binary format
+CURRENT_BINARY_VERSION = 2
+
+# The statuses, by the byte they are stored as
+_STATUSES = status.ALL
+_STATUS_CODES = {str(s): i for i, s in enumerate(_STATUSES)}
+
+# The fields of a TestResult stored as strings, which may be None
+_TEXT_FIELDS = ('command', 'environment', 'err', 'out', 'exception',
+                'traceback', 'dmesg')
+
+# The fields of a TestResult stored as JSON. They are usually all the same
+# for every test, so they are interned like the other strings.
+_JSON_FIELDS = ('images', 'pid', 'metrics', 'resources', 'attempts')
+
+# The JSON fields of each older version of the format
+_OLD_JSON_FIELDS = {
+    1: _JSON_FIELDS[:4],
+}
+
+_TIME = struct.Struct('<dd')
+_HEADER = struct.Struct('<8sI')
+
+# The record types
+_END = 0
+_TEST = 1
+
+
+class _Writer(object):
+    """Writes the records of a results file to f, a binary file."""
+
+    def __init__(self, f, metadata):
+        self.__f = f
+        self.__strings = {}
+
+        header = json.dumps(metadata, default=json_backend.piglit_encoder)
+        buf = bytearray(_HEADER.pack(MAGIC, CURRENT_BINARY_VERSION))
+        self.__bytes(buf, header.encode('utf-8'))
+        f.write(buf)
+
+    @staticmethod
+    def __uint(buf, value):
+        while value >= 0x80:
+            buf.append((value & 0x7f) | 0x80)
+            value >>= 7
+        buf.append(value)
+
+    def __bytes(self, buf, value):
+        self.__uint(buf, len(value))
+        buf.extend(value)
+
+    def __string(self, buf, value):
+        """Write a reference to a string.
+
+        0 is None, 1 is a new string that follows and the others are the
+        index of a string that was already written plus 2.
+
+        """
+        if value is None:
+            buf.append(0)
+            return
+        index = self.__strings.get(value)
+        if index is None:
+            self.__strings[value] = len(self.__strings)
+            buf.append(1)
+            self.__bytes(buf, value.encode('utf-8', 'surrogatepass'))
+        else:
+            self.__uint(buf, index + 2)
+
+    def __json(self, buf, value):
+        self.__string(buf, json.dumps(value,
+                                      default=json_backend.piglit_encoder))
+
+    def write_test(self, name, test):
+        """Write a test, in the form TestResult.to_json() returns."""
+        buf = bytearray([_TEST])
+        group, leaf = grouptools.splitname(name)
+        self.__string(buf, group)
+        self.__string(buf, leaf)
+        buf.append(_STATUS_CODES[str(test['result'])])
+
+        returncode = test.get('returncode')
+        if returncode is None:
+            buf.append(0)
+        else:
+            # zigzag, the return code of a crash is negative
+            self.__uint(buf, ((returncode << 1) ^ (returncode >> 63)) + 1)
+
+        time = test.get('time') or {}
+        buf.extend(_TIME.pack(time.get('start', 0.0), time.get('end', 0.0)))
+
+        for field in _TEXT_FIELDS:
+            self.__string(buf, test.get(field))
+        for field in _JSON_FIELDS:
+            self.__json(buf, test.get(field))
+
+        subtests = dict(test.get('subtests') or {})
+        subtests.pop('__type__', None)
+        times = subtests.pop('__times__', None)
+        self.__uint(buf, len(subtests))
+        for subtest, result in subtests.items():
+            self.__string(buf, subtest)
+            buf.append(_STATUS_CODES[str(result)])
+        self.__json(buf, times)
+
+        self.__f.write(buf)
+
+    def close(self):
+        self.__f.write(bytes([_END]))
+
+
+class _Reader(object):
+    """Reads the records of a results file from data, a bytes object."""
+
+    def __init__(self, data):
+        self.__data = data
+        self.__strings = []
+
+        if len(data) < _HEADER.size:
+            raise ValueError('truncated header')
+        magic, version = _HEADER.unpack_from(data)
+        if magic != MAGIC:
+            raise ValueError('not a piglit binary results file')
+        if version == CURRENT_BINARY_VERSION:
+            self.__fields = _JSON_FIELDS
+        elif version in _OLD_JSON_FIELDS:
+            self.__fields = _OLD_JSON_FIELDS[version]
+        else:
+            raise ValueError('unsupported version {}'.format(version))
+        self.__pos = _HEADER.size
+
+        self.metadata = json.loads(
+            self.__bytes().decode('utf-8'),
+            object_pairs_hook=collections.OrderedDict)
+
+    def __byte(self):
+        value = self.__data[self.__pos]
+        self.__pos += 1
+        return value
+
+    def __uint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.__byte()
+            value |= (byte & 0x7f) << shift
+            if byte < 0x80:
+                return value
+            shift += 7
+
+    def __bytes(self):
+        length = self.__uint()
+        start = self.__pos
+        self.__pos += length
+        if self.__pos > len(self.__data):
+            raise ValueError('truncated string')
+        return self.__data[start:self.__pos]
+
+    def __string(self):
+        ref = self.__uint()
+        if ref == 0:
+            return None
+        if ref == 1:
+            value = self.__bytes().decode('utf-8', 'surrogatepass')
+            self.__strings.append(value)
+            return value
+        return self.__strings[ref - 2]
+
+    def __json(self):
+        return json.loads(self.__string(),
+                          object_pairs_hook=collections.OrderedDict)
+
+    def tests(self):
+        """Yield the name and the dictionary form of each test."""
+        while True:
+            kind = self.__byte()
+            if kind == _END:
+                return
+            if kind != _TEST:
+                raise ValueError('unknown record type {}'.format(kind))
+
+            group = self.__string()
+            leaf = self.__string()
+            name = grouptools.join(group, leaf) if group else leaf
+            test = {'result': _STATUSES[self.__byte()]}
+
+            returncode = self.__uint()
+            if returncode:
+                returncode -= 1
+                test['returncode'] = (returncode >> 1) ^ -(returncode & 1)
+            else:
+                test['returncode'] = None
+
+            start, end = _TIME.unpack_from(self.__data, self.__pos)
+            self.__pos += _TIME.size
+            test['time'] = {'start': start, 'end': end}
+
+            for field in _TEXT_FIELDS:
+                value = self.__string()
+                if value is not None:
+                    test[field] = value
+            for field in self.__fields:
+                test[field] = self.__json()
+
+            subtests = collections.OrderedDict()
+            for _ in range(self.__uint()):
+                subtest = self.__string()
+                subtests[subtest] = _STATUSES[self.__byte()]
+            times = self.__json()
+            if times:
+                subtests['__times__'] = times
+            test['subtests'] = subtests
+
+            yield name, test
+
+
+class BinaryBackend(json_backend.JSONBackend):
+    """Piglit's compact binary backend.
+
+    While the tests run this writes the same files as the JSON backend, so
+    that runs can be resumed the same way, and only the final file is in the
+    binary format.
+
+    """
+    _file_extension = 'pbr'
+
+    def finalize(self, metadata=None):
+        self._close_log()
+        tests_dir = os.path.join(self._dest, 'tests')
+
+        with open(os.path.join(self._dest, 'metadata.json'), 'r') as f:
+            data = json.load(f, object_pairs_hook=collections.OrderedDict)
+        if metadata:
+            data.update(metadata)
+
+        with self._write_final(os.path.join(self._dest, 'results.pbr')) as f:
+            f.flush()
+            writer = _Writer(f.buffer, data)
+            wrote = False
+            for name, test in json_backend._read_tests(tests_dir):
+                writer.write_test(name, test)
+                wrote = True
+
+            if not wrote:
+                raise exceptions.PiglitUserError(
+                    'No tests were run, not writing a result file',
+                    exitcode=2)
+            writer.close()
+
+        # Delete the temporary files
+        os.unlink(os.path.join(self._dest, 'metadata.json'))
+        shutil.rmtree(tests_dir)
+
+
+def load_results(filename, compression_):
+    """Load a binary results file, or a run that wasn't finalized."""
+    if not os.path.isdir(filename):
+        filepath = filename
+    elif (os.path.exists(os.path.join(filename, 'metadata.json')) and
+          not os.path.exists(os.path.join(
+              filename, 'results.pbr.' + compression_))):
+        return json_backend._resume(filename)
+    else:
+        for name in ['results.pbr.{}'.format(compression_), 'results.pbr']:
+            if os.path.exists(os.path.join(filename, name)):
+                filepath = os.path.join(filename, name)
+                break
+        else:
+            raise exceptions.PiglitFatalError(
+                'No results found in "{}" (compression: {})'.format(
+                    filename, compression_))
+
+    assert compression_ in compression.COMPRESSORS, \
+        'unsupported compression type'
+
+    with compression.DECOMPRESSORS[compression_](filepath) as f:
+        data = f.buffer.read()
+
+    try:
+        reader = _Reader(data)
+        testrun = reader.metadata
+        testrun['tests'] = collections.OrderedDict(reader.tests())
+    except (ValueError, IndexError, struct.error) as e:
+        raise exceptions.PiglitFatalError(
+            'While loading binary results file: "{}",\n'
+            'the following error occurred:\n{}'.format(filepath, str(e)))
+
+    return results.TestrunResult.from_dict(testrun)
+
+
+def set_meta(results_):
+    """Set binary specific metadata on a TestrunResult."""
+    results_.results_version = json_backend.CURRENT_JSON_VERSION
+
+
+def write_results(results_, file_):
+    """Write a TestrunResult out to a file."""
+    data = results_.to_json()
+    tests = data.pop('tests')
+    data.pop('totals', None)
+    data.pop('__type__', None)
+
+    with write_compressed(file_) as f:
+        f.flush()
+        writer = _Writer(f.buffer, data)
+        for name, test in tests.items():
+            writer.write_test(name, test)
+        writer.close()
+
+    return True
+
+
+REGISTRY = Registry(
+    extensions=['.pbr'],
+    backend=BinaryBackend,
+    load=load_results,
+    meta=set_meta,
+    write=write_results,
+)
@@ -24,7 +24,7 @@
 This includes both compression and decompression support.
 
 This provides a low level interface of dictionaries, COMPRESSORS and
-DECOMPRESSORS, which use compression modes ('bz2', 'gz', 'xz', 'none') to
+DECOMPRESSORS, which use compression modes ('bz2', 'gz', 'xz', 'zst', 'none') to
 provide open-like functions with correct mode settings for writing or reading,
 respectively.
 
@@ -48,6 +48,12 @@ import lzma
 import os
 import subprocess
 
+try:
+    import zstandard
+    _ZSTD_MODULE = True
+except ImportError:
+    _ZSTD_MODULE = False
+
 from framework import core
 from framework import exceptions
 
@@ -69,15 +75,67 @@ class UnsupportedCompressor(exceptions.PiglitInternalError):
 
 
 
+def _zstd_bin(args, **kwargs):
+    """Start the zstd binary, as a fallback for the zstandard module."""
+    try:
+        return subprocess.Popen(['zstd', '-q'] + args, **kwargs)
+    except OSError as e:
+        if e.errno != errno.ENOENT:
+            raise
+        raise exceptions.PiglitFatalError(
+            'zst compression requires the zstandard python module or a '
+            'zstd binary')
+
+
+@contextlib.contextmanager
+def _compress_zstd(filename):
+    """Write zstd compressed text, using all CPUs to compress it."""
+    with open(filename, 'wb') as raw:
+        if _ZSTD_MODULE:
+            compressor = zstandard.ZstdCompressor(threads=-1)
+            with io.TextIOWrapper(compressor.stream_writer(raw),
+                                  encoding='utf-8') as f:
+                yield f
+            return
+
+        proc = _zstd_bin(['-T0', '-c'], stdin=subprocess.PIPE, stdout=raw)
+        try:
+            with io.TextIOWrapper(proc.stdin, encoding='utf-8') as f:
+                yield f
+        finally:
+            if proc.wait() != 0:
+                raise exceptions.PiglitFatalError(
+                    'zstd failed to compress "{}"'.format(filename))
+
+
+@contextlib.contextmanager
+def _decompress_zstd(filename):
+    """Read zstd compressed text, decompressing it as it is read."""
+    if _ZSTD_MODULE:
+        with open(filename, 'rb') as raw:
+            reader = zstandard.ZstdDecompressor().stream_reader(raw)
+            with io.TextIOWrapper(reader, encoding='utf-8') as f:
+                yield f
+        return
+
+    proc = _zstd_bin(['-d', '-c', filename], stdout=subprocess.PIPE)
+    try:
+        with io.TextIOWrapper(proc.stdout, encoding='utf-8') as f:
+            yield f
+    finally:
+        proc.wait()
+
+
 DEFAULT = 'bz2'
 
-COMPRESSION_SUFFIXES = ['.gz', '.bz2', '.xz']
+COMPRESSION_SUFFIXES = ['.gz', '.bz2', '.xz', '.zst']
 
 COMPRESSORS = {
     'bz2': functools.partial(bz2.open, mode='wt'),
     'gz': functools.partial(gzip.open, mode='wt'),
     'none': functools.partial(open, mode='w'),
     'xz': functools.partial(lzma.open, mode='wt'),
+    'zst': _compress_zstd,
 }
 
 DECOMPRESSORS = {
@@ -85,6 +143,7 @@ DECOMPRESSORS = {
     'gz': functools.partial(gzip.open, mode='rt'),
     'none': functools.partial(open, mode='r'),
     'xz': functools.partial(lzma.open, mode='rt'),
+    'zst': _decompress_zstd,
 }
 
 
@@ -22,10 +22,14 @@
 """ Module providing json backend for piglit """
 
 import collections
+import contextlib
 import functools
+import hashlib
 import os
 import shutil
 import sys
+import threading
+import time
 
 import json
 
@@ -35,7 +39,7 @@ try:
 except ImportError:
     _STREAMS = False
 
-from framework import status, results, exceptions
+from framework import status, results, exceptions, options
 from .abstract import FileBackend, write_compressed
 from .register import Registry
 from . import compression
@@ -46,7 +50,7 @@ __all__ = [
 ]
 
 # The current version of the JSON results
-CURRENT_JSON_VERSION = 10
+CURRENT_JSON_VERSION = 11
 
 # The minimum JSON format supported
 MINIMUM_SUPPORTED_VERSION = 7
@@ -54,6 +58,36 @@ MINIMUM_SUPPORTED_VERSION = 7
 # The level to indent a final file
 INDENT = 4
 
+# The log that test results are appended to during a run. It has a .json
+# extension so that backends.get_extension() finds the right backend for an
+# unfinished run, but it is a sequence of records, each one being the length
+# of a JSON document in bytes on a line of its own, followed by the document
+# and a newline.
+LOG_NAME = 'log.json'
+
+# With --sync, the seconds between two syncs of the log to disk
+SYNC_INTERVAL = 0.5
+
+# The checkpoint of the log, which lists the tests whose final record is in
+# the log before a given offset, so that resuming doesn't need to read them.
+# It is a sequence of blocks, each one being the names of the tests finished
+# since the previous block, one per line, followed by a line with '#' and the
+# size of the log when the block was written.
+CHECKPOINT_NAME = 'checkpoint'
+
+# The seconds between two checkpoints
+CHECKPOINT_INTERVAL = 5.0
+
+# The fields of a test, and of each of its attempts, that are stored in the
+# blobs of the results file. Many tests print the same warnings or skip for
+# the same reason, and most of them have the same environment, so each
+# distinct value is stored once, and a test refers to it by its hash as
+# {"__blob__": <hash>}.
+BLOB_FIELDS = ('out', 'err', 'environment')
+
+# Shorter strings stay in the tests, a reference wouldn't be smaller
+MIN_BLOB_SIZE = 48
+
 
 def piglit_encoder(obj):
     """ Encoder for piglit that can transform additional classes into json
@@ -70,6 +104,66 @@ def piglit_encoder(obj):
     return obj
 
 
+class _Blobs(object):
+    """The table of the BLOB_FIELDS strings of a results file."""
+
+    def __init__(self):
+        self._hashes = collections.OrderedDict()
+
+    def __ref(self, value):
+        digest = self._hashes.get(value)
+        if digest is None:
+            digest = hashlib.sha256(
+                value.encode('utf-8', 'surrogatepass')).hexdigest()[:16]
+            self._hashes[value] = digest
+        return {'__blob__': digest}
+
+    def pack(self, test):
+        """Return a copy of test, a dict, referring to the blobs."""
+        test = dict(test)
+        for key in BLOB_FIELDS:
+            value = test.get(key)
+            if isinstance(value, str) and len(value) >= MIN_BLOB_SIZE:
+                test[key] = self.__ref(value)
+        if test.get('attempts'):
+            test['attempts'] = [self.pack(a) for a in test['attempts']]
+        return test
+
+    def to_json(self):
+        return collections.OrderedDict(
+            (d, v) for v, d in self._hashes.items())
+
+
+def _pack_results(data):
+    """Return a copy of data, the dict form of a TestrunResult, with its
+    BLOB_FIELDS moved to blobs."""
+    blobs = _Blobs()
+    data = collections.OrderedDict(data)
+    data['tests'] = collections.OrderedDict(
+        (n, blobs.pack(piglit_encoder(t))) for n, t in data['tests'].items())
+    data['blobs'] = blobs.to_json()
+    return data
+
+
+def _expand_blobs(data):
+    """Replace the references to the blobs in data, a loaded results file."""
+    blobs = data.pop('blobs', None)
+    if not blobs:
+        return data
+
+    def expand(test):
+        for key in BLOB_FIELDS:
+            value = test.get(key)
+            if isinstance(value, dict):
+                test[key] = blobs[value['__blob__']]
+        for attempt in test.get('attempts') or []:
+            expand(attempt)
+
+    for test in data['tests'].values():
+        expand(test)
+    return data
+
+
 class JSONBackend(FileBackend):
     """ Piglit's native JSON backend
 
@@ -77,14 +171,97 @@ class JSONBackend(FileBackend):
     json module.
 
     This class is atomic, writes either completely fail or completely succeed.
-    To achieve this it writes individual files for each test and for the
-    metadata, and composes them at the end into a single file and removes the
-    intermediate files. When it tries to compose these files if it cannot read
-    a file it just ignores it, making the result atomic.
+    To achieve this it writes the metadata to a file and appends each test to
+    a log, first as incomplete and then with its result, and composes them at
+    the end into a single file and removes the intermediate files. A record
+    that was cut short by a crash is ignored, making the result atomic.
 
     """
     _file_extension = 'json'
 
+    def __init__(self, dest, **kwargs):
+        super(JSONBackend, self).__init__(dest, **kwargs)
+        self._log = None
+        self._log_lock = threading.Lock()
+        self._dirty = False
+        self._stop_sync = threading.Event()
+        self._syncer = None
+        self._finished = []
+        self._checkpoint_time = time.monotonic()
+
+    def _sync_log(self):
+        """Sync the log every SYNC_INTERVAL seconds while it is written."""
+        while not self._stop_sync.wait(SYNC_INTERVAL):
+            with self._log_lock:
+                dirty, self._dirty = self._dirty, False
+            # Tests can keep appending while this runs, the log is only
+            # closed once this thread is done.
+            if dirty:
+                os.fsync(self._log.fileno())
+
+    def _append(self, name, data):
+        """Append a record for a test to the log.
+
+        Every record is flushed right away. With --sync, syncing it to disk is
+        left to a thread that does it for all the records written in the
+        last SYNC_INTERVAL seconds at once, instead of once per record.
+
+        """
+        record = json.dumps({name: data}, default=piglit_encoder).encode(
+            'utf-8')
+
+        with self._log_lock:
+            if self._log is None:
+                self._log = open(os.path.join(self._dest, 'tests', LOG_NAME),
+                                 'ab')
+                if options.OPTIONS.sync:
+                    self._syncer = threading.Thread(target=self._sync_log,
+                                                    daemon=True)
+                    self._syncer.start()
+
+            self._log.write(b'%d\n' % len(record))
+            self._log.write(record)
+            self._log.write(b'\n')
+            self._log.flush()
+            self._dirty = True
+
+            if data.result != status.INCOMPLETE:
+                self._finished.append(name)
+                if (time.monotonic() - self._checkpoint_time >=
+                        CHECKPOINT_INTERVAL):
+                    self._checkpoint()
+
+    def _checkpoint(self):
+        """Add the tests finished since the last checkpoint to it."""
+        _write_checkpoint(os.path.join(self._dest, 'tests'), self._finished,
+                          self._log.tell())
+        self._finished = []
+        self._checkpoint_time = time.monotonic()
+
+    def _close_log(self):
+        if self._syncer is not None:
+            self._stop_sync.set()
+            self._syncer.join()
+            self._syncer = None
+        if self._log is not None:
+            if options.OPTIONS.sync:
+                os.fsync(self._log.fileno())
+            self._log.close()
+            self._log = None
+
+    @contextlib.contextmanager
+    def write_test(self, name):
+        """Write a test.
+
+        When this context manager is opened it appends a record with the
+        status incomplete to the log, and when it is called with the final
+        result it appends another record for the same test. When the log is
+        read only the last record of each test counts.
+
+        """
+        self._append(name, self._INCOMPLETE)
+        yield functools.partial(self._append, name)
+
     def initialize(self, metadata):
         """ Write boilerplate json code
 
@@ -118,10 +295,8 @@ class JSONBackend(FileBackend):
         containers that are still open and closes the file
 
         """
+        self._close_log()
         tests_dir = os.path.join(self._dest, 'tests')
-        file_list = sorted(
-            (f for f in os.listdir(tests_dir) if f.endswith('.json')),
-            key=lambda p: int(os.path.splitext(p)[0]))
 
         # If jsonstreams is not present then build a complete tree of all of
         # the data and write it with json.dump
@@ -139,20 +314,8 @@ class JSONBackend(FileBackend):
                 data.update(metadata)
 
             # Add the tests to the dictionary
-            data['tests'] = collections.OrderedDict()
-
-            for test in file_list:
-                test = os.path.join(tests_dir, test)
-                if os.path.isfile(test):
-                    # Try to open the json snippets. If we fail to open a test
-                    # then throw the whole thing out. This gives us atomic
-                    # writes, the writing worked and is valid or it didn't
-                    # work.
-                    try:
-                        with open(test, 'r') as f:
-                            data['tests'].update(json.load(f))
-                    except ValueError:
-                        pass
+            data['tests'] = collections.OrderedDict(
+                _read_sorted_tests(tests_dir))
 
             if not data['tests']:
                 raise exceptions.PiglitUserError(
@@ -164,7 +327,8 @@ class JSONBackend(FileBackend):
             # write out the combined file. Use the compression writer from the
             # FileBackend
             with self._write_final(os.path.join(self._dest, 'results.json')) as f:
-                json.dump(data, f, default=piglit_encoder, indent=INDENT)
+                json.dump(_pack_results(data.to_json()), f,
+                          default=piglit_encoder, indent=INDENT)
 
         # Otherwise use jsonstreams to write the final dictionary. This uses an
         # external library, but is slightly faster and uses considerably less
@@ -183,25 +347,20 @@ class JSONBackend(FileBackend):
                     if metadata:
                         s.iterwrite(metadata.items())
 
+                    blobs = _Blobs()
                     with s.subobject('tests') as t:
                         wrote = False
-                        for test in file_list:
-                            test = os.path.join(tests_dir, test)
-                            if os.path.isfile(test):
-                                try:
-                                    with open(test, 'r') as f:
-                                        a = json.load(f)
-                                except ValueError:
-                                    continue
-
-                                t.iterwrite(a.items())
-                                wrote = True
+                        for name, test in _read_sorted_tests(tests_dir):
+                            t.write(name, blobs.pack(test))
+                            wrote = True
 
                     if not wrote:
                         raise exceptions.PiglitUserError(
                             'No tests were run.',
                             exitcode=2)
 
+                    s.write('blobs', blobs.to_json())
+
         # Delete the temporary files
         os.unlink(os.path.join(self._dest, 'metadata.json'))
         shutil.rmtree(os.path.join(self._dest, 'tests'))
@@ -211,6 +370,162 @@ class JSONBackend(FileBackend):
         json.dump({name: data}, f, default=piglit_encoder)
 
 
+def _read_log(path, offset=0, ends=None):
+    """Yield each record of the log at path as a dictionary.
+
+    Reading starts at offset, which must be the start of a record, and stops
+    at a record that was not completely written. If ends is a list, the
+    offset of the end of each record is appended to it.
+
+    """
+    with open(path, 'rb') as f:
+        f.seek(offset)
+        while True:
+            record = _read_record(f)
+            if record is None:
+                return
+            if ends is not None:
+                ends.append(f.tell())
+            yield record
+
+
+def _read_record(f):
+    """Read the record of the log at the position of f.
+
+    Returns None if it was not completely written.
+
+    """
+    header = f.readline()
+    try:
+        length = int(header)
+    except ValueError:
+        return None
+    record = f.read(length)
+    if len(record) != length or f.read(1) != b'\n':
+        return None
+    try:
+        return json.loads(record.decode('utf-8'),
+                          object_pairs_hook=collections.OrderedDict)
+    except ValueError:
+        return None
+
+
+def _write_checkpoint(tests_dir, names, offset):
+    """Append a block to the checkpoint in tests_dir."""
+    with open(os.path.join(tests_dir, CHECKPOINT_NAME), 'a') as f:
+        for name in names:
+            f.write(name + '\n')
+        f.write('#{}\n'.format(offset))
+        if options.OPTIONS.sync:
+            f.flush()
+            os.fsync(f.fileno())
+
+
+def _read_checkpoint(tests_dir):
+    """Return the finished tests in the checkpoint and the offset it covers.
+
+    A block that was not completely written is ignored, its tests are found
+    in the log after the offset of the previous one.
+
+    """
+    names = []
+    block = []
+    offset = 0
+    try:
+        with open(os.path.join(tests_dir, CHECKPOINT_NAME), 'r') as f:
+            for line in f:
+                if not line.endswith('\n'):
+                    break
+                if line.startswith('#'):
+                    names.extend(block)
+                    block = []
+                    offset = int(line[1:])
+                else:
+                    block.append(line[:-1])
+    except (OSError, ValueError):
+        pass
+    return names, offset
+
+
+def _read_records(tests_dir):
+    """Yield every record in tests_dir, and where it was read from.
+
+    Results written by older versions of piglit, as one file per test, are
+    read before the log so that runs started by them can still be resumed.
+    Their location is the name of the file, the one of a record of the log
+    is its offset.
+
+    """
+    legacy = sorted(
+        (l for l in os.listdir(tests_dir)
+         if l.endswith('.json') and l != LOG_NAME),
+        key=lambda p: int(os.path.splitext(p)[0]))
+    for file_ in legacy:
+        with open(os.path.join(tests_dir, file_), 'r') as f:
+            try:
+                yield json.load(f, object_pairs_hook=collections.OrderedDict), \
+                    file_
+            except ValueError:
+                continue
+
+    log = os.path.join(tests_dir, LOG_NAME)
+    if os.path.exists(log):
+        ends = [0]
+        for record in _read_log(log, ends=ends):
+            yield record, ends[-2]
+
+
+def _read_tests(tests_dir, locations=False):
+    """Yield the name and the last result of every test in tests_dir.
+
+    This reads the log in a single pass. Tests are yielded as soon as they
+    have a final result, and the ones that never got one are yielded as
+    incomplete at the end.
+
+    With locations, where the result was read from is yielded in place of
+    the result, see _read_records.
+
+    """
+    incomplete = collections.OrderedDict()
+    done = set()
+    for record, location in _read_records(tests_dir):
+        for name, test in record.items():
+            if name in done:
+                continue
+            value = location if locations else test
+            if test['result'] == str(status.INCOMPLETE):
+                incomplete[name] = value
+            else:
+                incomplete.pop(name, None)
+                done.add(name)
+                yield name, value
+
+    yield from incomplete.items()
+
+
+def _read_sorted_tests(tests_dir):
+    """Yield the same tests as _read_tests, in the order of their names.
+
+    Only where the result of each test is is kept while reading the log, and
+    the results are then read again in order, so that results files can be
+    merged as sorted streams without the run being held in memory.
+
+    """
+    locations = sorted(_read_tests(tests_dir, locations=True))
+    log = os.path.join(tests_dir, LOG_NAME)
+    with open(log, 'rb') if os.path.exists(log) else \
+            contextlib.nullcontext() as log:
+        for name, location in locations:
+            if isinstance(location, int):
+                log.seek(location)
+                record = _read_record(log)
+            else:
+                with open(os.path.join(tests_dir, location), 'r') as f:
+                    record = json.load(
+                        f, object_pairs_hook=collections.OrderedDict)
+            yield name, record[name]
+
+
 def load_results(filename, compression_):
     """ Loader function for TestrunResult class
 
@@ -246,10 +561,117 @@ def load_results(filename, compression_):
     assert compression_ in compression.COMPRESSORS, \
         'unsupported compression type'
 
+    index = _index_path(filepath)
+    if index is not None:
+        try:
+            return _load_index(index, filepath)
+        except (OSError, ValueError, KeyError):
+            pass
+
     with compression.DECOMPRESSORS[compression_](filepath) as f:
         testrun = _load(f)
 
-    return results.TestrunResult.from_dict(_update_results(testrun, filepath))
+    testrun = results.TestrunResult.from_dict(
+        _expand_blobs(_update_results(testrun, filepath)))
+
+    if index is not None:
+        try:
+            _write_index(index, filepath, testrun)
+        except OSError:
+            pass
+
+    return testrun
+
+
+class _IndexEntry(object):
+    """Reads the full dictionary form of one test from an index."""
+    __slots__ = ['path', 'offset', 'length']
+
+    def __init__(self, path, offset, length):
+        self.path = path
+        self.offset = offset
+        self.length = length
+
+    def __call__(self):
+        with open(self.path, 'rb') as f:
+            f.seek(self.offset)
+            return json.loads(f.read(self.length).decode('utf-8'))
+
+
+def _index_path(filepath):
+    """Return the name of the index of a results file, if it can have one.
+
+    The index is a hidden file next to the results, so that loading the
+    directory still finds the results themselves.
+
+    """
+    if not os.path.isfile(filepath):
+        return None
+    dirname, basename = os.path.split(filepath)
+    return os.path.join(dirname, '.{}.index'.format(basename))
+
+
+def _source_stamp(filepath):
+    stat = os.stat(filepath)
+    return [stat.st_size, stat.st_mtime_ns]
+
+
+def _write_index(index, filepath, testrun):
+    """Write an index of testrun, which was loaded from filepath.
+
+    The index starts with the part of each test that is not in the EAGER
+    keys of results.LazyTestResult, as one JSON document per test. It is
+    followed by a JSON document with the rest of the results and where to
+    find the documents of each test. The last line is the offset of that
+    document, so that it can be found without reading the rest.
+
+    """
+    header = testrun.to_json()
+    tests = header.pop('tests')
+    header['tests'] = collections.OrderedDict()
+    header['source'] = _source_stamp(filepath)
+
+    tmp = index + '.tmp'
+    with open(tmp, 'wb') as f:
+        for name, test in tests.items():
+            eager = {k: v for k, v in test.items()
+                     if k in results.LazyTestResult.EAGER}
+            data = json.dumps(test, default=piglit_encoder).encode('utf-8')
+            eager['__index__'] = [f.tell(), len(data)]
+            header['tests'][name] = eager
+            f.write(data)
+
+        offset = f.tell()
+        f.write(json.dumps(header, default=piglit_encoder).encode('utf-8'))
+        f.write(b'\n%d\n' % offset)
+    os.replace(tmp, index)
+
+
+def _load_index(index, filepath):
+    """Load the results from an index, if it is up to date.
+
+    This raises ValueError if the index doesn't match filepath, or an
+    OSError if there is no index.
+
+    """
+    with open(index, 'rb') as f:
+        f.seek(-32, os.SEEK_END)
+        offset = int(f.read().split(b'\n')[-2])
+        f.seek(offset)
+        header = json.loads(f.read().rsplit(b'\n', 2)[0].decode('utf-8'),
+                            object_pairs_hook=collections.OrderedDict)
+
+    if header.pop('source') != _source_stamp(filepath):
+        raise ValueError('results index is out of date')
+
+    tests = header['tests']
+    header['tests'] = {}
+    testrun = results.TestrunResult.from_dict(header)
+    for name, test in tests.items():
+        testrun.tests[name] = results.LazyTestResult.from_dict(
+            test, _IndexEntry(index, *test.pop('__index__')))
+
+    return testrun
 
 
 def set_meta(results):
@@ -290,21 +712,67 @@ def _resume(results_dir):
     meta['tests'] = collections.OrderedDict()
 
     # Load all of the test names and added them to the test list
-    tests_dir = os.path.join(results_dir, 'tests')
-    file_list = sorted(
-        (l for l in os.listdir(tests_dir) if l.endswith('.json')),
-        key=lambda p: int(os.path.splitext(p)[0]))
-
-    for file_ in file_list:
-        with open(os.path.join(tests_dir, file_), 'r') as f:
-            try:
-                meta['tests'].update(json.load(f))
-            except ValueError:
-                continue
+    meta['tests'].update(_read_tests(os.path.join(results_dir, 'tests')))
 
     return results.TestrunResult.from_dict(meta)
 
 
+def resume_state(results_dir, no_retry=False):
+    """Load what piglit resume needs from a partially completed run.
+
+    Returns a TestrunResult with the metadata of the run and no tests, and
+    the names of the tests that don't need to run again: those with a final
+    result, and with no_retry the incomplete ones as well.
+
+    The tests in the checkpoint are not read from the log, only the records
+    after it are. A record that was cut short by a crash is cut off the log,
+    so that the records of the resumed run can be read after it, and the
+    tests finished after the last checkpoint are added to it.
+
+    """
+    tests_dir = os.path.join(results_dir, 'tests')
+    log = os.path.join(tests_dir, LOG_NAME)
+
+    with open(os.path.join(results_dir, 'metadata.json'), 'r') as f:
+        meta = json.load(f)
+    assert meta['results_version'] == CURRENT_JSON_VERSION, \
+        "Old results version, resume impossible"
+    meta['tests'] = {}
+    testrun = results.TestrunResult.from_dict(meta)
+
+    legacy = any(l.endswith('.json') and l != LOG_NAME
+                 for l in os.listdir(tests_dir))
+    if legacy or not os.path.exists(log):
+        tests = _read_tests(tests_dir)
+        return testrun, {n for n, t in tests
+                         if no_retry or t['result'] != str(status.INCOMPLETE)}
+
+    finished, offset = _read_checkpoint(tests_dir)
+    size = os.path.getsize(log)
+    if no_retry or offset > size:
+        # The incomplete tests are not in the checkpoint, and a log that is
+        # shorter than it was not synced to disk before a crash.
+        finished, offset = [], 0
+
+    exclude = set(finished)
+    tail = []
+    ends = [offset]
+    for record in _read_log(log, offset, ends):
+        for name, test in record.items():
+            if no_retry or test['result'] != str(status.INCOMPLETE):
+                if name not in exclude:
+                    exclude.add(name)
+                    tail.append(name)
+
+    if ends[-1] < size:
+        with open(log, 'r+b') as f:
+            f.truncate(ends[-1])
+    if tail and not no_retry:
+        _write_checkpoint(tests_dir, tail, ends[-1])
+
+    return testrun, exclude
+
+
 def _update_results(results, filepath):
     """ Update results to the latest version
 
@@ -326,6 +794,7 @@ def _update_results(results, filepath):
             7: _update_seven_to_eight,
             8: _update_eight_to_nine,
             9: _update_nine_to_ten,
+            10: _update_ten_to_eleven,
         }
 
         while results['results_version'] < CURRENT_JSON_VERSION:
@@ -359,8 +828,11 @@ def _update_results(results, filepath):
 
 def write_results(results, file_):
     """Write the values of the results out to a file."""
+    if hasattr(results, 'to_json'):
+        results = results.to_json()
     with write_compressed(file_) as f:
-        json.dump(results, f, default=piglit_encoder, indent=INDENT)
+        json.dump(_pack_results(results), f, default=piglit_encoder,
+                  indent=INDENT)
 
     return True
 
@@ -419,6 +891,18 @@ def _update_nine_to_ten(result):
     return result
 
 
+def _update_ten_to_eleven(result):
+    """Update json results from version 10 to 11.
+
+    Version 11 can store the BLOB_FIELDS of the tests in a table of blobs.
+    Older results have all of them inline, which is still valid.
+
+    """
+    result['results_version'] = 11
+
+    return result
+
+
 REGISTRY = Registry(
     extensions=['.json'],
     backend=JSONBackend,
@@ -252,11 +252,13 @@ class JUnitSubtestWriter(JUnitWriter):
                                     time=str(data.time.total),
                                     tests=str(len(data.subtests)))
             for test, result in data.subtests.items():
-                etree.SubElement(element,
-                                 'testcase',
-                                 name=self._make_full_test_name(test),
-                                 classname=testname,
-                                 status=str(result))
+                sub = etree.SubElement(element,
+                                       'testcase',
+                                       name=self._make_full_test_name(test),
+                                       classname=testname,
+                                       status=str(result))
+                if test in data.subtests.times:
+                    sub.attrib['time'] = str(data.subtests.times[test])
 
         else:
             element = super(JUnitSubtestWriter, self)._make_root(
@@ -302,6 +304,36 @@ class JUnitSubtestWriter(JUnitWriter):
         f.write(str(etree.tostring(element).decode('utf-8')))
 
 
+# lxml has a pretty print we want to use. These are the parts of the results
+# document around the testcases, for each serialization.
+if etree.__name__ == 'lxml.etree':
+    _DOCUMENT = ('<testsuites>\n  <testsuite>\n', '  </testsuite>\n</testsuites>\n')
+
+    def _tostring(element):
+        return etree.tostring(element, pretty_print=True).decode('utf-8')
+else:
+    _DOCUMENT = ('<testsuites><testsuite>', '</testsuite></testsuites>')
+
+    def _tostring(element):
+        return etree.tostring(element).decode('utf-8')
+
+
+def _testsuite_child(element):
+    """Return element as it is serialized in the piglit testsuite.
+
+    With pretty printing that depends on the depth of the element, so it is
+    serialized in a document of its own at the same depth.
+
+    """
+    root = etree.Element('testsuites')
+    etree.SubElement(root, 'testsuite').append(element)
+    text = _tostring(root)
+
+    head, tail = _DOCUMENT
+    assert text.startswith(head) and text.endswith(tail)
+    return text[len(head):len(text) - len(tail)]
+
+
 class JUnitBackend(FileBackend):
     """ Backend that produces ANT JUnit XML
 
@@ -347,42 +379,53 @@ class JUnitBackend(FileBackend):
         os.mkdir(tests)
 
     def finalize(self, metadata=None):
-        """ Scoop up all of the individual pieces and put them together """
-        root = etree.Element('testsuites')
-        piglit = etree.Element('testsuite', name='piglit')
-        root.append(piglit)
-        for each in os.listdir(os.path.join(self._dest, 'tests')):
-            with open(os.path.join(self._dest, 'tests', each), 'r') as f:
-                # parse returns an element tree, and that's not what we want,
-                # we want the first (and only) Element node
-                # If the element cannot be properly parsed then consider it a
-                # failed transaction and ignore it.
-                try:
-                    piglit.append(etree.parse(f).getroot())
-                except etree.ParseError:
-                    continue
+        """ Scoop up all of the individual pieces and put them together
+
+        The test files are written out one at a time, in the order the tests
+        were started, so that the whole document is never held in memory.
+        The output is the same as serializing a tree of all of them.
+
+        """
+        tests = os.path.join(self._dest, 'tests')
+        body = os.path.join(self._dest, 'results.xml.tests')
+
+        def order(name):
+            number = name.split('.', 1)[0]
+            return (int(number), name) if number.isdigit() else \
+                (float('inf'), name)
+
+        num_tests = 0
+        with open(body, 'w') as out:
+            for each in sorted(os.listdir(tests), key=order):
+                with open(os.path.join(tests, each), 'r') as f:
+                    # If the element cannot be properly parsed then consider
+                    # it a failed transaction and ignore it.
+                    try:
+                        element = etree.parse(f).getroot()
+                    except etree.ParseError:
+                        continue
+                out.write(_testsuite_child(element))
+                num_tests += 1
 
-        num_tests = len(piglit)
         if not num_tests:
+            os.unlink(body)
             raise exceptions.PiglitUserError(
                 'No tests were run, not writing a result file',
                 exitcode=2)
 
-        # set the test count by counting the number of tests.
-        # This must be unicode (py3 str)
-        piglit.attrib['tests'] = str(num_tests)
-
-
+        head, tail = _DOCUMENT
         with open(os.path.join(self._dest, 'results.xml'), 'w') as f:
             f.write("<?xml version='1.0' encoding='utf-8'?>\n")
-            # lxml has a pretty print we want to use
-            if etree.__name__ == 'lxml.etree':
-                out = etree.tostring(root, pretty_print=True)
-            else:
-                out = etree.tostring(root)
-            f.write(out.decode('utf-8'))
-
-        shutil.rmtree(os.path.join(self._dest, 'tests'))
+            # set the test count by counting the number of tests.
+            f.write(head.replace('<testsuite>',
+                                 '<testsuite name="piglit" tests="{}">'.format(
+                                     num_tests)))
+            with open(body, 'r') as b:
+                shutil.copyfileobj(b, f)
+            f.write(tail)
+
+        os.unlink(body)
+        shutil.rmtree(tests)
 
 
 def _load(results_file):
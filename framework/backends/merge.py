@@ -0,0 +1,328 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Merge JSON results files, such as those of a run split between machines.
+
+The tests of a results file are written in the order of their names, so the
+files are merged like sorted lists: each one is read a test at a time, and
+the test with the smallest name is written next. Only a test per file and
+the blobs of the files are held in memory.
+
+Files written before the tests were sorted, or with a results version older
+than 10, are loaded completely and sorted in memory instead.
+
+"""
+
+import collections
+import heapq
+import json
+import os
+
+from framework import exceptions, status
+from .abstract import write_compressed
+from . import compression
+from . import json as json_backend
+
+__all__ = [
+    'POLICIES',
+    'merge',
+]
+
+# How a test that is in several of the files is resolved. Each function is
+# passed the results, in the order of the files, and returns the one kept.
+POLICIES = collections.OrderedDict([
+    ('worst', lambda tests: max(
+        reversed(tests), key=lambda t: status.status_lookup(t['result']))),
+    ('best', lambda tests: min(
+        tests, key=lambda t: (status.status_lookup(t['result']) < status.PASS,
+                              status.status_lookup(t['result'])))),
+    ('first', lambda tests: tests[0]),
+    ('last', lambda tests: tests[-1]),
+    ('error', None),
+])
+
+
+class _Stream(object):
+    """Reads a JSON document from a file, a value at a time."""
+
+    _CHUNK = 1 << 16
+
+    def __init__(self, f):
+        self.__file = f
+        self.__buffer = ''
+        self.__pos = 0
+        self.__decoder = json.JSONDecoder(
+            object_pairs_hook=collections.OrderedDict)
+
+    def __fill(self):
+        """Read more of the file, returns False at its end."""
+        # Read at least as much as is buffered, so that a large value doesn't
+        # get decoded again for each chunk.
+        data = self.__file.read(max(self._CHUNK, len(self.__buffer)))
+        if not data:
+            return False
+        self.__buffer = self.__buffer[self.__pos:] + data
+        self.__pos = 0
+        return True
+
+    def peek(self):
+        """Return the next character that isn't whitespace, '' at the end."""
+        while True:
+            while self.__pos < len(self.__buffer):
+                char = self.__buffer[self.__pos]
+                if not char.isspace():
+                    return char
+                self.__pos += 1
+            if not self.__fill():
+                return ''
+
+    def expect(self, chars):
+        """Read one of chars and return it."""
+        char = self.peek()
+        if not char or char not in chars:
+            raise ValueError('expected one of {!r} in JSON, found {!r}'.format(
+                chars, char))
+        self.__pos += 1
+        return char
+
+    def value(self):
+        """Read the next value."""
+        self.peek()
+        while True:
+            try:
+                value, end = self.__decoder.raw_decode(self.__buffer,
+                                                       self.__pos)
+            except ValueError:
+                if not self.__fill():
+                    raise
+                continue
+            # A number at the end of the buffer may go on in the file
+            if end == len(self.__buffer) and self.__fill():
+                continue
+            self.__pos = end
+            return value
+
+    def members(self):
+        """Yield the key of each member of an object.
+
+        The caller must read the value of each member before the next key.
+
+        """
+        self.expect('{')
+        if self.peek() == '}':
+            self.__pos += 1
+            return
+        while True:
+            key = self.value()
+            self.expect(':')
+            yield key
+            if self.expect(',}') == '}':
+                return
+
+
+class _Input(object):
+    """A results file being merged."""
+
+    def __init__(self, path):
+        extension, self.mode = _extension(path)
+        if extension != '.json':
+            raise exceptions.PiglitFatalError(
+                'Only JSON results can be merged: "{}"'.format(path))
+        self.path = path
+        self.metadata = collections.OrderedDict()
+        self.blobs = {}
+        self.sorted = True
+        self.__scan()
+
+    def __open(self):
+        return compression.DECOMPRESSORS[self.mode](self.path)
+
+    def __scan(self):
+        """Read everything but the tests, and check their order."""
+        with self.__open() as f:
+            stream = _Stream(f)
+            for key in stream.members():
+                if key == 'tests':
+                    last = None
+                    for name in stream.members():
+                        stream.value()
+                        if last is not None and name <= last:
+                            self.sorted = False
+                        last = name
+                elif key == 'blobs':
+                    self.blobs = stream.value()
+                else:
+                    self.metadata[key] = stream.value()
+
+        version = self.metadata.get('results_version', 0)
+        if version > json_backend.CURRENT_JSON_VERSION:
+            raise exceptions.PiglitFatalError(
+                'Results version {} of "{}" is newer than this piglit '
+                'supports'.format(version, self.path))
+        if version < 10:
+            self.sorted = False
+
+    def tests(self):
+        """Yield the name and the dictionary of each test, by name."""
+        if not self.sorted:
+            testrun = json_backend.load_results(self.path, self.mode)
+            for name in sorted(testrun.tests):
+                yield name, json.loads(json.dumps(
+                    testrun.tests[name].to_json(),
+                    default=json_backend.piglit_encoder))
+            return
+
+        with self.__open() as f:
+            stream = _Stream(f)
+            for key in stream.members():
+                if key != 'tests':
+                    stream.value()
+                    continue
+                for name in stream.members():
+                    test = stream.value()
+                    json_backend._expand_blobs(
+                        {'tests': {name: test}, 'blobs': self.blobs})
+                    yield name, test
+
+
+def _extension(path):
+    """Return the extension and the compression of the results file path."""
+    name, suffix = os.path.splitext(path)
+    if suffix in compression.COMPRESSION_SUFFIXES:
+        return os.path.splitext(name)[1], suffix[1:]
+    return suffix, 'none'
+
+
+def _find(path):
+    """Return the results file in path, if it is a results directory."""
+    if not os.path.isdir(path):
+        return path
+    for name in sorted(os.listdir(path)):
+        if name.startswith('results.json'):
+            return os.path.join(path, name)
+    raise exceptions.PiglitFatalError(
+        'No JSON results found in "{}"'.format(path))
+
+
+def merge(paths, output, policy='worst', name=None, mode=None):
+    """Merge the results files or directories in paths into output.
+
+    The result kept for a test that is in several files is chosen by policy,
+    one of POLICIES; 'error' makes duplicates fatal. The output is compressed
+    with mode, and by default with the compression of the inputs if they all
+    use the same one.
+
+    Returns the name of the file written.
+
+    """
+    choose = POLICIES[policy]
+    inputs = [_Input(_find(p)) for p in paths]
+    if not inputs:
+        raise exceptions.PiglitFatalError('No results to merge')
+
+    if mode is None:
+        modes = {i.mode for i in inputs}
+        mode = modes.pop() if len(modes) == 1 else compression.get_mode()
+
+    metadata = collections.OrderedDict(inputs[0].metadata)
+    for key in ['tests', 'totals', 'blobs']:
+        metadata.pop(key, None)
+    metadata['results_version'] = json_backend.CURRENT_JSON_VERSION
+    if name is not None:
+        metadata['name'] = name
+    times = [i.metadata['time_elapsed'] for i in inputs
+             if 'time_elapsed' in i.metadata]
+    if times:
+        metadata['time_elapsed'] = collections.OrderedDict([
+            ('start', min(t['start'] for t in times)),
+            ('end', max(t['end'] for t in times)),
+            ('__type__', 'TimeAttribute'),
+        ])
+
+    def keyed(index, tests):
+        for name_, test in tests:
+            yield name_, index, test
+
+    merged = heapq.merge(*[keyed(i, each.tests())
+                           for i, each in enumerate(inputs)],
+                         key=lambda t: (t[0], t[1]))
+
+    # The name write_compressed() gives the file
+    written = output
+    if mode != 'none':
+        base, suffix = os.path.splitext(output)
+        if suffix in compression.COMPRESSION_SUFFIXES:
+            written = '{}.{}'.format(base, mode)
+        else:
+            written = '{}.{}'.format(output, mode)
+
+    # The output is written by hand so that only one test is encoded at a
+    # time, jsonstreams is optional.
+    blobs = json_backend._Blobs()
+    with write_compressed(output, mode) as f:
+        f.write('{\n')
+        for key, value in metadata.items():
+            f.write('    {}: {},\n'.format(json.dumps(key), _dumps(value)))
+        f.write('    "tests": {')
+
+        first = True
+        duplicates = []
+        for name_, tests in _groups(merged):
+            if len(tests) > 1 and choose is None:
+                duplicates.append(name_)
+                continue
+            f.write('{}\n        {}: {}'.format(
+                '' if first else ',', json.dumps(name_),
+                _dumps(blobs.pack(choose(tests) if len(tests) > 1
+                                  else tests[0]), 8)))
+            first = False
+
+        f.write('\n    }},\n    "blobs": {}\n}}\n'.format(
+            _dumps(blobs.to_json())))
+
+    if duplicates:
+        os.unlink(written)
+        raise exceptions.PiglitFatalError(
+            '{} tests are in more than one of the results, such as "{}"'.format(
+                len(duplicates), duplicates[0]))
+
+    return written
+
+
+def _groups(merged):
+    """Yield each name in merged with the list of its tests."""
+    name = None
+    tests = []
+    for name_, _, test in merged:
+        if name_ != name and tests:
+            yield name, tests
+            tests = []
+        name = name_
+        tests.append(test)
+    if tests:
+        yield name, tests
+
+
+def _dumps(value, indent=4):
+    """Encode value indented to the level of the members of the output."""
+    return json.dumps(value, default=json_backend.piglit_encoder,
+                      indent=json_backend.INDENT).replace(
+                          '\n', '\n' + ' ' * indent)
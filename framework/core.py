@@ -29,7 +29,9 @@ historically reasons is called "core" in piglit.
 import configparser
 import errno
 import functools
+import json
 import os
+import struct
 import subprocess
 import time
 
@@ -39,9 +41,13 @@ __all__ = [
     'PIGLIT_CONFIG',
     'PLATFORMS',
     'PiglitConfig',
+    'binary_identity',
+    'cache_dir',
     'collect_system_info',
     'get_option',
+    'load_cache',
     'parse_listfile',
+    'store_cache',
 ]
 
 PLATFORMS = ["glx", "x11_egl", "wayland", "gbm", "mixed_glx_egl", "wgl", "surfaceless_egl"]
@@ -132,6 +138,127 @@ def get_option(env_varname, config_option, default=None, required=False):
     return opt or default
 
 
+def cache_dir():
+    """Return the directory piglit keeps its caches in.
+
+    Caches go to PIGLIT_CACHE_DIR, then the piglit.conf [core]:cache_dir
+    option, then $XDG_CACHE_HOME/piglit, then $HOME/.cache/piglit.
+
+    """
+    return get_option(
+        'PIGLIT_CACHE_DIR', ('core', 'cache_dir'),
+        default=os.path.join(
+            os.environ.get('XDG_CACHE_HOME',
+                           os.path.expandvars('$HOME/.cache')),
+            'piglit'))
+
+
+def _cache_file(name):
+    """Return the path of the cache called name."""
+    return os.path.join(cache_dir(), name + '.json')
+
+
+def load_cache(name):
+    """Return the dictionary kept in the cache called name.
+
+    A cache that doesn't exist or can't be read is empty.
+
+    """
+    try:
+        with open(_cache_file(name), 'r') as f:
+            data = json.load(f)
+    except (OSError, ValueError):
+        return {}
+    return data if isinstance(data, dict) else {}
+
+
+def store_cache(name, data):
+    """Replace the dictionary kept in the cache called name with data.
+
+    Caches are only there to save time, so failing to write one is ignored.
+
+    """
+    filename = _cache_file(name)
+    tmp = '{}.{}.tmp'.format(filename, os.getpid())
+    try:
+        check_dir(os.path.dirname(filename))
+        with open(tmp, 'w') as f:
+            json.dump(data, f)
+        os.replace(tmp, filename)
+    except OSError:
+        pass
+
+
+def _build_id(f):
+    """Return the GNU build-id of the ELF file f as a hex string, or None."""
+    ident = f.read(64)
+    if len(ident) < 64 or ident[:4] != b'\x7fELF':
+        return None
+    end = {1: '<', 2: '>'}.get(ident[5])
+    if end is None:
+        return None
+    if ident[4] == 2:
+        phoff, = struct.unpack_from(end + 'Q', ident, 0x20)
+        phentsize, phnum = struct.unpack_from(end + 'HH', ident, 0x36)
+        phdr = struct.Struct(end + 'IIQQQQ')
+    elif ident[4] == 1:
+        phoff, = struct.unpack_from(end + 'I', ident, 0x1c)
+        phentsize, phnum = struct.unpack_from(end + 'HH', ident, 0x2a)
+        phdr = struct.Struct(end + 'IIIIII')
+    else:
+        return None
+
+    for i in range(phnum):
+        f.seek(phoff + i * phentsize)
+        header = f.read(phdr.size)
+        if len(header) < phdr.size:
+            return None
+        fields = phdr.unpack(header)
+        # PT_NOTE. The offset and the size are in different places in the
+        # 32 and 64 bit headers.
+        if fields[0] != 4:
+            continue
+        if ident[4] == 2:
+            offset, size = fields[2], fields[5]
+        else:
+            offset, size = fields[1], fields[4]
+
+        f.seek(offset)
+        notes = f.read(size)
+        pos = 0
+        while pos + 12 <= len(notes):
+            namesz, descsz, type_ = struct.unpack_from(end + 'III', notes, pos)
+            pos += 12
+            name = notes[pos:pos + namesz]
+            pos += (namesz + 3) & ~3
+            desc = notes[pos:pos + descsz]
+            pos += (descsz + 3) & ~3
+            # NT_GNU_BUILD_ID
+            if type_ == 3 and name == b'GNU\0':
+                return desc.hex()
+    return None
+
+
+def binary_identity(path):
+    """Return a value that changes whenever the executable at path changes.
+
+    This is meant to be part of the key of caches of what an executable
+    reports, such as the list of its tests. It is made of the modification
+    time, the size and, for ELF files that have one, the build-id. If path
+    doesn't exist None is returned.
+
+    """
+    try:
+        st = os.stat(path)
+        with open(path, 'rb') as f:
+            build_id = _build_id(f)
+    except OSError:
+        return None
+    except struct.error:
+        build_id = None
+    return [st.st_mtime_ns, st.st_size, build_id]
+
+
 def check_dir(dirname, failifexists=False, handler=None):
     """Check for the existence of a directory and create it if possible.
 
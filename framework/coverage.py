@@ -0,0 +1,234 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Record which driver sources each test runs, and select tests by them.
+
+"piglit run --coverage-record" runs each test with GCOV_PREFIX set to a
+directory of its own, so that a driver built with --coverage (by gcc or
+clang) writes the .gcda files of the test there when it exits. The objects
+that have a counter that isn't zero are then added to coverage.jsonl in the
+results directory, under the name of the test.
+
+"piglit run --coverage-from <results> --coverage-diff <diff>" then only runs
+the tests that ran a file changed by the diff, and a random sample of the
+others. An object is matched with a changed file by the name of its source
+and the directory it was built in, which must contain the directory of the
+changed file, as meson and most CMake builds lay them out. If a changed file
+matches no object, such as a header, every test is run.
+
+The coverage of tests run by a long lived process, such as with
+--shader-runner-server or --test-host, is only written when that process
+exits, and isn't recorded.
+"""
+
+import contextlib
+import hashlib
+import json
+import os
+import shutil
+import struct
+import tempfile
+import threading
+
+from framework import exceptions
+
+__all__ = [
+    'COVERAGE_FILE',
+    'Recorder',
+    'changed_files',
+    'load',
+    'record',
+    'select',
+]
+
+COVERAGE_FILE = 'coverage.jsonl'
+
+# The tag of the arc counters records of a .gcda file
+_ARCS_TAG = 0x01a10000
+
+
+def _covered(path):
+    """Return whether a counter of the .gcda file at path isn't zero."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) < 12:
+        return False
+    for order in '<>':
+        if data[:4] == struct.pack(order + 'I', 0x67636461):  # 'gcda'
+            break
+    else:
+        return False
+
+    # Record lengths are counted in bytes since GCC 12, and in words before.
+    # The version is the major version, as a digit before GCC 10 and then as
+    # 'A' + its tens and a digit, followed by the minor version and '*'.
+    version = struct.unpack(order + 'I', data[4:8])[0].to_bytes(4, 'big')
+    unit = 1 if version[:1].isalpha() and version[:2] >= b'B2' else 4
+
+    # Skip the magic, version and stamp, GCC 12 also writes a checksum
+    pos = 16 if unit == 1 else 12
+    while pos + 8 <= len(data):
+        tag, length = struct.unpack(order + 'Ii', data[pos:pos + 8])
+        pos += 8
+        # A negative length is a record of that many counters that are all 0
+        if length < 0:
+            continue
+        size = length * unit
+        if tag == _ARCS_TAG:
+            counters = data[pos:pos + size]
+            if counters.strip(b'\0'):
+                return True
+        pos += size
+    return False
+
+
+class Recorder(object):
+    """Writes the coverage of each test to the results directory."""
+
+    def __init__(self, results_dir):
+        self._path = os.path.join(results_dir, COVERAGE_FILE)
+        self._lock = threading.Lock()
+
+    @contextlib.contextmanager
+    def record(self, name, test):
+        """Record the coverage of the test name while in the context.
+
+        GCOV_PREFIX is set in the environment of test for the duration.
+
+        """
+        prefix = tempfile.mkdtemp(prefix='piglit-gcov-')
+        env = test.env
+        previous = env.get('GCOV_PREFIX')
+        env['GCOV_PREFIX'] = prefix
+        try:
+            yield
+        finally:
+            if previous is None:
+                del env['GCOV_PREFIX']
+            else:
+                env['GCOV_PREFIX'] = previous
+            objects = []
+            for root, _, files in os.walk(prefix):
+                for file_ in files:
+                    if not file_.endswith('.gcda'):
+                        continue
+                    path = os.path.join(root, file_)
+                    try:
+                        if _covered(path):
+                            objects.append(
+                                '/' + os.path.relpath(path, prefix)[:-5])
+                    except OSError:
+                        pass
+            shutil.rmtree(prefix, ignore_errors=True)
+            line = json.dumps([name, sorted(objects)]) + '\n'
+            with self._lock, open(self._path, 'a') as f:
+                f.write(line)
+
+
+_RECORDERS = {}
+_RECORDERS_LOCK = threading.Lock()
+
+
+def record(results_dir, name, test):
+    """Return the context recording the coverage of test into results_dir."""
+    with _RECORDERS_LOCK:
+        if results_dir not in _RECORDERS:
+            _RECORDERS[results_dir] = Recorder(results_dir)
+        return _RECORDERS[results_dir].record(name, test)
+
+
+def load(results_path):
+    """Return a dict of test name to the objects it ran, from results_path.
+
+    results_path is the results directory of a run with --coverage-record.
+    The last record of a test wins, such as that of a resumed run.
+    """
+    path = os.path.join(results_path, COVERAGE_FILE)
+    coverage = {}
+    try:
+        with open(path, 'r') as f:
+            for line in f:
+                try:
+                    name, objects = json.loads(line)
+                except ValueError:
+                    # The last line of an interrupted run
+                    continue
+                coverage[name] = objects
+    except OSError as e:
+        raise exceptions.PiglitFatalError(
+            'Cannot read the coverage of {}: {}'.format(results_path, e))
+    return coverage
+
+
+def changed_files(diff):
+    """Return the files changed by the unified diff in the string diff."""
+    files = set()
+    for line in diff.splitlines():
+        if not line.startswith(('--- ', '+++ ')):
+            continue
+        path = line[4:].split('\t')[0].strip()
+        if path == '/dev/null':
+            continue
+        if path.startswith(('a/', 'b/')):
+            path = path[2:]
+        files.add(path)
+    return sorted(files)
+
+
+def _matches(changed, obj):
+    """Return whether the object obj is built from the file changed."""
+    directory, name = os.path.split(changed)
+    obj_dir, obj_name = os.path.split(obj)
+    if obj_name not in (name, os.path.splitext(name)[0]):
+        return False
+    return not directory or '/{}/'.format(directory) in obj_dir + '/'
+
+
+def select(coverage, changes, sample):
+    """Return a filter of the tests to run for the changed files.
+
+    It keeps the tests in coverage that ran an object of one of changes, the
+    tests that aren't in coverage, and the fraction sample of the others,
+    chosen at random but the same for the same changes. Every test is kept
+    if a change matches no object.
+    """
+    objects = {o for each in coverage.values() for o in each}
+    hit = set()
+    for changed in changes:
+        matches = {o for o in objects if _matches(changed, o)}
+        if not matches:
+            print('Coverage: nothing is known to run {}, running every '
+                  'test'.format(changed))
+            return lambda name, test: True
+        hit |= matches
+
+    skipped = {n for n, each in coverage.items()
+               if not hit.intersection(each)}
+    seed = '\n'.join(sorted(changes)).encode('utf-8')
+
+    def filter_(name, _):
+        if name not in skipped:
+            return True
+        # The sample only depends on the changes and the name of the test
+        digest = hashlib.sha1(seed + b'\0' + name.encode('utf-8')).digest()
+        return int.from_bytes(digest[:8], 'big') < sample * 2 ** 64
+
+    return filter_
@@ -22,9 +22,10 @@
 
 """ Module implementing classes for reading posix dmesg
 
-Currently this module only has the default DummyDmesg, and a LinuxDmesg.
-The method used on Linux requires that timestamps are enabled, and no other
-posix system has timestamps.
+Currently this module only has the default DummyDmesg, a KmsgDmesg, and a
+LinuxDmesg. KmsgDmesg reads /dev/kmsg on Linux and works with concurrent runs,
+LinuxDmesg is used where /dev/kmsg can't be read. The method LinuxDmesg uses
+requires that timestamps are enabled, and no other posix system has timestamps.
 
 On OSX and *BSD one would likely want to implement a system that reads the
 sysloger, since timestamps can be added by the sysloger, and are not inserted
@@ -37,10 +38,14 @@ dmesg implementation for their OS.
 """
 
 import abc
+import collections
 import gzip
+import os
 import re
+import select
 import subprocess
 import sys
+import threading
 import warnings
 
 from framework import exceptions
@@ -48,6 +53,7 @@ from framework import exceptions
 __all__ = [
     'BaseDmesg',
     'DummyDmesg',
+    'KmsgDmesg',
     'LinuxDmesg',
     'get_dmesg',
 ]
@@ -67,9 +73,13 @@ class BaseDmesg(metaclass=abc.ABCMeta):
     This class is not thread safe, because it does not black between the start
     of the test and the reading of dmesg, which means that if two tests run at
     the same time, and test A creates an entri in dmesg, but test B finishes
-    first, test B will be marked as having the dmesg error.
+    first, test B will be marked as having the dmesg error. Subclasses that
+    can tell which tests were running when a message was logged set
+    concurrent, and can be used when tests run concurrently.
 
     """
+    concurrent = False
+
     @abc.abstractmethod
     def __init__(self):
         # A list containing all messages since the last time dmesg was read.
@@ -108,6 +118,13 @@ class BaseDmesg(metaclass=abc.ABCMeta):
         result -- A TestResult instance
 
         """
+        # Get a new snapshot of dmesg
+        self.update_dmesg()
+
+        return self._apply_messages(result, self._new_messages)
+
+    def _apply_messages(self, result, messages):
+        """ Update result with the dmesg messages logged while it ran """
         def replace(res):
             """ helper to replace statuses with the new dmesg status
 
@@ -121,15 +138,12 @@ class BaseDmesg(metaclass=abc.ABCMeta):
                 "fail": "dmesg-fail"
             }.get(res, res)
 
-        # Get a new snapshot of dmesg
-        self.update_dmesg()
-
-        # if update_dmesg() found new entries replace the results of the test
-        # and subtests
-        if self._new_messages:
+        # if there are new entries replace the results of the test and
+        # subtests
+        if messages:
 
             if self.regex:
-                for line in self._new_messages:
+                for line in messages:
                     if self.regex.search(line):
                         break
                 else:
@@ -142,7 +156,7 @@ class BaseDmesg(metaclass=abc.ABCMeta):
                 result.subtests[key] = replace(value)
 
             # Add the dmesg values to the result
-            result.dmesg = "\n".join(self._new_messages)
+            result.dmesg = "\n".join(messages)
 
         return result
 
@@ -222,6 +236,213 @@ class LinuxDmesg(BaseDmesg):
         return 'LinuxDmesg()'
 
 
+def parse_kmsg(data):
+    """ Parse records read from /dev/kmsg
+
+    Each record is a "priority,sequence,timestamp,flags;message" line,
+    followed by lines starting with a space that give its context. Return a
+    (sequence, line) tuple for each record at a level that
+    LinuxDmesg.DMESG_COMMAND prints, with the line formatted like dmesg does.
+
+    """
+    records = []
+    for record in data.splitlines():
+        prefix, sep, message = record.partition(';')
+        if not sep or record.startswith(' '):
+            continue
+        try:
+            priority, sequence, timestamp = \
+                [int(f) for f in prefix.split(',')[:3]]
+        except ValueError:
+            continue
+        # The low bits are the level, the others the facility
+        if priority & 7 > KmsgDmesg.MAX_LEVEL:
+            continue
+        records.append((sequence, '[{:5d}.{:06d}] {}'.format(
+            timestamp // 1000000, timestamp % 1000000, message)))
+    return records
+
+
+class KmsgDmesg(BaseDmesg):
+    """ Read the kernel messages from /dev/kmsg as they are logged
+
+    A thread reads each message as the kernel logs it. When a test starts and
+    ends the messages logged until then are read, and the messages of the
+    test are those read in between. The start and end are kept per thread,
+    so tests can run concurrently; a message logged while several tests run
+    is given to all of them.
+
+    Worker processes forked from the one that made the instance read
+    /dev/kmsg themselves.
+
+    """
+    KMSG = '/dev/kmsg'
+
+    # The lowest priority of LinuxDmesg.DMESG_COMMAND, notice
+    MAX_LEVEL = 5
+
+    # How long to wait in seconds for the messages to be read, the thread
+    # only has to drain a non-blocking file.
+    TIMEOUT = 5
+
+    concurrent = True
+
+    def __init__(self):
+        # pylint: disable=super-init-not-called
+        self._new_messages = []
+        self.regex = None
+        self._pid = None
+        self._start()
+
+    def _open(self):
+        """ Open /dev/kmsg, positioned after the messages already logged """
+        fd = os.open(self.KMSG, os.O_RDONLY | os.O_NONBLOCK | os.O_CLOEXEC)
+        try:
+            os.lseek(fd, 0, os.SEEK_END)
+        except OSError:
+            os.close(fd)
+            raise
+        return fd
+
+    def _start(self):
+        self._kmsg = self._open()
+        self._wake_read, self._wake_write = os.pipe()
+        os.set_blocking(self._wake_write, False)
+        self._pid = os.getpid()
+
+        self._cond = threading.Condition()
+        # (sequence, line) of the messages a running test may need
+        self._messages = collections.deque()
+        # The sequence number of the last message read
+        self._position = -1
+        # The sequence numbers the running tests started at
+        self._starts = collections.Counter()
+        self._requested = 0
+        self._served = 0
+        self._closed = False
+        self._local = threading.local()
+
+        self._thread = threading.Thread(target=self._reader, daemon=True)
+        self._thread.start()
+
+    def _drain(self):
+        records = []
+        while True:
+            try:
+                data = os.read(self._kmsg, 8192)
+            except BlockingIOError:
+                break
+            except BrokenPipeError:
+                # The kernel overwrote messages before they were read, the
+                # next read gets the oldest one left.
+                continue
+            if not data:
+                break
+            records.extend(parse_kmsg(data.decode('utf-8', 'replace')))
+        return records
+
+    def _reader(self):
+        poller = select.poll()
+        poller.register(self._kmsg, select.POLLIN)
+        poller.register(self._wake_read, select.POLLIN)
+
+        while True:
+            with self._cond:
+                if self._closed:
+                    return
+                requested = self._requested
+
+            records = self._drain()
+
+            with self._cond:
+                if self._starts:
+                    self._messages.extend(records)
+                if records:
+                    self._position = records[-1][0]
+                self._served = requested
+                self._cond.notify_all()
+
+            poller.poll()
+            try:
+                os.read(self._wake_read, 4096)
+            except BlockingIOError:
+                pass
+
+    def _sync(self):
+        """ Wait until the messages logged before the call are read
+
+        Must be called with self._cond held.
+
+        """
+        self._requested += 1
+        request = self._requested
+        try:
+            os.write(self._wake_write, b'\0')
+        except BlockingIOError:
+            # The reader has wake ups pending already
+            pass
+        if not self._cond.wait_for(lambda: self._served >= request,
+                                   timeout=self.TIMEOUT):
+            warnings.warn("Timed out reading {}, messages of the test may be "
+                          "missing".format(self.KMSG), RuntimeWarning)
+
+    def update_dmesg(self):
+        """ Mark the start of a test on this thread """
+        if self._pid != os.getpid():
+            # A forked process, its parent's thread doesn't exist here and
+            # its reads would take the records from the parent.
+            os.close(self._kmsg)
+            os.close(self._wake_read)
+            os.close(self._wake_write)
+            self._start()
+
+        with self._cond:
+            self._end_test()
+            self._sync()
+            self._local.start = self._position
+            self._starts[self._position] += 1
+
+    def _end_test(self):
+        """ Forget the start of the test on this thread, return it """
+        start = getattr(self._local, 'start', None)
+        if start is None:
+            return None
+        self._local.start = None
+
+        self._starts[start] -= 1
+        if not self._starts[start]:
+            del self._starts[start]
+        oldest = min(self._starts) if self._starts else self._position
+        while self._messages and self._messages[0][0] <= oldest:
+            self._messages.popleft()
+        return start
+
+    def update_result(self, result):
+        """ Update result with the messages logged since update_dmesg() """
+        with self._cond:
+            if getattr(self._local, 'start', None) is None:
+                return result
+            self._sync()
+            start = self._local.start
+            messages = [l for s, l in self._messages if s > start]
+            self._end_test()
+
+        return self._apply_messages(result, messages)
+
+    def close(self):
+        """ Stop reading /dev/kmsg """
+        with self._cond:
+            self._closed = True
+        os.write(self._wake_write, b'\0')
+        self._thread.join()
+        os.close(self._kmsg)
+        os.close(self._wake_read)
+        os.close(self._wake_write)
+
+    def __repr__(self):
+        return 'KmsgDmesg()'
+
+
 class DummyDmesg(BaseDmesg):
     """ An dummy class for dmesg on non unix-like systems
 
@@ -256,5 +477,10 @@ def get_dmesg(not_dummy=True):
 
     """
     if sys.platform.startswith('linux') and not_dummy:
-        return LinuxDmesg()
+        try:
+            return KmsgDmesg()
+        except OSError:
+            # Without CAP_SYSLOG when dmesg_restrict is set, or on kernels
+            # older than 3.5
+            return LinuxDmesg()
     return DummyDmesg()
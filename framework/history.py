@@ -0,0 +1,287 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""A history of the results of many runs, for queries across them.
+
+"piglit run --history <file>" adds the status and duration of every test
+of the run to a SQLite database once the run is finished, and "piglit
+summary history" adds older results and queries it. The results are keyed
+by test and then run, so all of the history of a test is read from a single
+range of the index, and runs are only ever added.
+
+Runs are ordered by the time they started, so that results added out of
+order still give the right transitions.
+
+A history can be given to --schedule-from in place of a results file, the
+durations of the tests are then the median of their last few runs. The
+timeouts of --adaptive-timeout are taken from the 99th percentile of a
+longer window of runs, and --prioritize runs the tests that failed or changed
+status in the last runs first.
+"""
+
+import os
+import sqlite3
+
+from framework import backends, grouptools
+from framework import status as so
+
+__all__ = [
+    'History',
+    'append',
+    'is_history',
+    'timeouts',
+]
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS runs (
+    id INTEGER PRIMARY KEY,
+    name TEXT,
+    start REAL,
+    path TEXT
+);
+CREATE TABLE IF NOT EXISTS tests (
+    id INTEGER PRIMARY KEY,
+    name TEXT UNIQUE NOT NULL
+);
+CREATE TABLE IF NOT EXISTS results (
+    test INTEGER NOT NULL,
+    run INTEGER NOT NULL,
+    status TEXT NOT NULL,
+    duration REAL,
+    PRIMARY KEY (test, run)
+) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS runs_start ON runs (start, id);
+"""
+
+# The first bytes of a SQLite database
+_MAGIC = b'SQLite format 3\0'
+
+# The number of latest runs the durations for scheduling are taken from
+_SCHEDULE_RUNS = 5
+
+# The number of latest runs the durations for timeouts are taken from
+_TIMEOUT_RUNS = 20
+
+# The number of latest runs the statuses for --prioritize are taken from
+_PRIORITY_RUNS = 10
+
+
+def is_history(path):
+    """Return whether path is a history rather than results."""
+    try:
+        with open(path, 'rb') as f:
+            return f.read(len(_MAGIC)) == _MAGIC
+    except OSError:
+        return False
+
+
+def percentile(values, fraction):
+    """Return the fraction percentile of the sorted list values."""
+    if not values:
+        return None
+    pos = (len(values) - 1) * fraction
+    low = int(pos)
+    high = min(low + 1, len(values) - 1)
+    return values[low] + (values[high] - values[low]) * (pos - low)
+
+
+class History(object):
+    """A history database at path, created if it doesn't exist."""
+
+    def __init__(self, path):
+        self.path = path
+        self._db = sqlite3.connect(path)
+        self._db.executescript(_SCHEMA)
+
+    def close(self):
+        self._db.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *_):
+        self.close()
+
+    def _test_ids(self, names):
+        """Return the ids of the tests names, adding the missing ones."""
+        self._db.executemany('INSERT OR IGNORE INTO tests (name) VALUES (?)',
+                             ((n,) for n in names))
+        return dict(self._db.execute('SELECT name, id FROM tests'))
+
+    def add(self, testrun, path=None):
+        """Add the results of testrun, a TestrunResult, as a new run.
+
+        Subtests are added under their full name, with an even share of the
+        time of their test. Returns the id of the run.
+
+        """
+        rows = []
+        for name, result in testrun.tests.items():
+            duration = result.time.total
+            if result.subtests:
+                for sub, status in result.subtests.items():
+                    rows.append((grouptools.join(name, sub), str(status),
+                                 duration / len(result.subtests)))
+            else:
+                rows.append((name, str(result.result), duration))
+
+        with self._db:
+            run = self._db.execute(
+                'INSERT INTO runs (name, start, path) VALUES (?, ?, ?)',
+                (getattr(testrun, 'name', None), testrun.time_elapsed.start,
+                 path and os.path.abspath(path))).lastrowid
+            ids = self._test_ids(r[0] for r in rows)
+            self._db.executemany(
+                'INSERT INTO results (test, run, status, duration) '
+                'VALUES (?, ?, ?, ?)',
+                ((ids[n], run, s, d) for n, s, d in rows))
+        return run
+
+    def runs(self):
+        """Return the (id, name, start, path) of every run, oldest first."""
+        return self._db.execute(
+            'SELECT id, name, start, path FROM runs ORDER BY start, id'
+        ).fetchall()
+
+    def results(self, test):
+        """Return the (run name, start, status, duration) of test, oldest
+        first.
+        """
+        return self._db.execute(
+            'SELECT runs.name, runs.start, results.status, results.duration '
+            'FROM results JOIN runs ON runs.id = results.run '
+            'WHERE results.test = (SELECT id FROM tests WHERE name = ?) '
+            'ORDER BY runs.start, runs.id', (test,)).fetchall()
+
+    def transitions(self, test):
+        """Return the runs where the status of test changed.
+
+        Each one is (run name, start, previous status, status); the first
+        run of the test is one with a previous status of None. Runs without
+        the test are skipped over.
+
+        """
+        changes = []
+        previous = None
+        for name, start, status, _ in self.results(test):
+            if status != previous:
+                changes.append((name, start, previous, status))
+                previous = status
+        return changes
+
+    def durations(self, test, fractions=(0.5, 0.9, 0.99), runs=None):
+        """Return the percentiles of the duration of test, as a dict.
+
+        Only the last runs are used, if given.
+
+        """
+        values = [r[3] for r in self.results(test) if r[3] is not None]
+        if runs:
+            values = values[-runs:]
+        values.sort()
+        return {f: percentile(values, f) for f in fractions}
+
+    def latest_durations(self, runs=_SCHEDULE_RUNS, fraction=0.5):
+        """Return a dict of the fraction percentile of each test's duration
+        in the last runs.
+
+        The subtests of a test are also added up under the name of the
+        test, unless it is in the history itself.
+
+        """
+        last = [r[0] for r in self.runs()[-runs:]]
+        if not last:
+            return {}
+
+        values = {}
+        groups = {}
+        for name, run, duration in self._db.execute(
+                'SELECT tests.name, results.run, results.duration '
+                'FROM results JOIN tests ON tests.id = results.test '
+                'WHERE results.run IN ({}) AND results.duration IS NOT NULL'
+                .format(','.join('?' * len(last))), last):
+            values.setdefault(name, []).append(duration)
+            group = grouptools.groupname(name)
+            if group:
+                groups[group, run] = groups.get((group, run), 0) + duration
+        totals = {}
+        for (group, _), duration in groups.items():
+            totals.setdefault(group, []).append(duration)
+        for group, durations in totals.items():
+            values.setdefault(group, durations)
+        return {n: percentile(sorted(v), fraction)
+                for n, v in values.items()}
+
+    def latest_statuses(self, runs=_PRIORITY_RUNS):
+        """Return a dict of each test's statuses in the last runs, oldest
+        first.
+
+        Tests recorded as subtests also get the worst of the statuses of
+        their subtests in each run, unless they are in the history
+        themselves.
+
+        """
+        last = [r[0] for r in self.runs()[-runs:]]
+        if not last:
+            return {}
+
+        values = {}
+        groups = {}
+        for name, run, result in self._db.execute(
+                'SELECT tests.name, results.run, results.status '
+                'FROM results JOIN tests ON tests.id = results.test '
+                'JOIN runs ON runs.id = results.run '
+                'WHERE results.run IN ({}) ORDER BY runs.start, runs.id'
+                .format(','.join('?' * len(last))), last):
+            values.setdefault(name, []).append(result)
+            group = grouptools.groupname(name)
+            if group:
+                worst = groups.get((group, run))
+                if worst is None or (so.status_lookup(result) >
+                                     so.status_lookup(worst)):
+                    groups[group, run] = result
+
+        totals = {}
+        for (group, _), result in groups.items():
+            totals.setdefault(group, []).append(result)
+        for group, statuses in totals.items():
+            values.setdefault(group, statuses)
+        return values
+
+
+def append(path, results_path):
+    """Add the results at results_path to the history at path."""
+    with History(path) as history:
+        history.add(backends.load(results_path), results_path)
+
+
+def timeouts(path, factor, floor, ceiling):
+    """Return a dict of test name to timeout from the history at path.
+
+    The timeout of a test is factor times the 99th percentile of its
+    duration in the last runs, but at least floor and at most ceiling
+    seconds.
+
+    """
+    with History(path) as history:
+        durations = history.latest_durations(_TIMEOUT_RUNS, 0.99)
+    return {n: min(max(d * factor, floor), ceiling)
+            for n, d in durations.items()}
@@ -25,12 +25,18 @@
 This module provides a class LogManager, which acts as a state manager
 returning BaseLog derived instances to individual tests.
 
+The logs of a LogManager only update the counters of the shared state when a
+test starts or ends; the quiet log's status line is printed by a thread at
+RATE times a second instead, so a run of many short tests doesn't spend its
+time waiting on the terminal.
+
 """
 
 import sys
 import abc
 import itertools
 import threading
+import time
 import collections
 from http.server import HTTPServer, BaseHTTPRequestHandler
 
@@ -137,7 +143,9 @@ class QuietLog(BaseLog):
             'Invalid status for logger: {}'.format(status)
         self._state['summary'][status] += 1
 
-        self._print_summary()
+        # With a renderer the line is printed at its rate
+        if 'renderer' not in self._state:
+            self._print_summary()
         self._state['running'].remove(self.__counter)
 
     def log(self, status):
@@ -145,6 +153,9 @@ class QuietLog(BaseLog):
             self._log(status)
 
     def summary(self):
+        renderer = self._state.get('renderer')
+        if renderer is not None:
+            renderer.stop()
         with self._LOCK:
             self._print_summary()
             self._print('\n')
@@ -188,6 +199,51 @@ class QuietLog(BaseLog):
         self._state['lastlength'] = len(out)
 
 
+class _StatusLine(QuietLog):
+    """ The status line of the QuietLogs, which isn't a test of its own """
+
+    def __init__(self, state, state_lock):
+        # pylint: disable=non-parent-init-called,super-init-not-called
+        BaseLog.__init__(self, state, state_lock)
+        self._endcode = '\r' if sys.stdout.isatty() else '\n'
+
+
+class _Renderer(threading.Thread):
+    """ Print the status line of the QuietLogs RATE times a second
+
+    The line is only printed when a test has started or ended since it was
+    last printed.
+
+    Arguments:
+    state -- the state dict from LogManager
+
+    """
+    RATE = 10
+
+    def __init__(self, state, state_lock):
+        super(_Renderer, self).__init__(daemon=True)
+        self._line = _StatusLine(state, state_lock)
+        self._state = state
+        self._lock = state_lock
+        self._done = threading.Event()
+
+    def run(self):
+        last = None
+        while not self._done.wait(1 / self.RATE):
+            with self._lock:
+                current = (self._state['complete'],
+                           tuple(self._state['running']))
+                if current != last:
+                    self._line._print_summary()  # pylint: disable=protected-access
+                    last = current
+
+    def stop(self):
+        """ Stop printing, waiting for a line being printed """
+        self._done.set()
+        if self.is_alive():
+            self.join()
+
+
 class VerboseLog(QuietLog):
     """ A more verbose version of the QuietLog
 
@@ -266,20 +322,43 @@ class HTTPLogServer(threading.Thread):
 
         def do_GET(self):
             if self.path == "/summary":
-                self.send_response(200)
-                self.end_headers()
                 with self.server.state_lock:
-                    status = {
-                        "complete": self.server.state["complete"],
-                        "running" : self.server.state["running"],
-                        "total"   : self.server.state["total"],
-                        "results" : self.server.state["summary"],
-                    }
-                self.wfile.write(json.dumps(status, indent=self.INDENT))
+                    status = self._summary(self.server.state)
+                self._send(status)
+            elif self.path == "/durations":
+                with self.server.state_lock:
+                    durations = dict(self.server.state["durations"])
+                self._send(durations)
             else:
                 self.send_response(404)
                 self.end_headers()
 
+        def _send(self, value):
+            self.send_response(200)
+            self.end_headers()
+            self.wfile.write(
+                json.dumps(value, indent=self.INDENT).encode('utf-8'))
+
+        @staticmethod
+        def _summary(state):
+            """ The progress of the run, with the throughput in tests per
+            second and the estimated seconds left, once a test completed.
+            """
+            now = time.monotonic()
+            elapsed = now - state["start"]
+            complete = state["complete"]
+            throughput = complete / elapsed if complete and elapsed else None
+            return {
+                "complete": complete,
+                "running" : {n: now - s for n, s in state["running"].items()},
+                "total"   : state["total"],
+                "results" : state["summary"],
+                "elapsed" : elapsed,
+                "throughput": throughput,
+                "eta"     : ((state["total"] - complete) / throughput
+                             if throughput else None),
+            }
+
     def __init__(self, state, state_lock):
         super(HTTPLogServer, self).__init__()
         port = int(PIGLIT_CONFIG.safe_get("http", "port", fallback=8080))
@@ -297,7 +376,12 @@ class HTTPLogServer(threading.Thread):
 
 
 class HTTPLog(BaseLog):
-    """ A Logger that serves status information over http """
+    """ A Logger that serves status information over http
+
+    /summary gives the progress of the run and the time the running tests
+    have run for, /durations the time each completed test took.
+
+    """
 
     def __init__(self, state, state_lock):
         super(HTTPLog, self).__init__(state, state_lock)
@@ -306,11 +390,12 @@ class HTTPLog(BaseLog):
     def start(self, name):
         with self._LOCK:
             self._name = name
-            self._state['running'].append(self._name)
+            self._state['running'][self._name] = time.monotonic()
 
     def log(self, status):
         with self._LOCK:
-            self._state['running'].remove(self._name)
+            start = self._state['running'].pop(self._name)
+            self._state['durations'][self._name] = time.monotonic() - start
             self._state['complete'] += 1
             assert status in self.SUMMARY_KEYS
             self._state['summary'][str(status)] += 1
@@ -356,11 +441,37 @@ class LogManager(object):
         }
         self._state_lock = threading.Lock()
 
+        if self._log is QuietLog:
+            self._state['renderer'] = _Renderer(self._state,
+                                                self._state_lock)
+            self._state['renderer'].start()
+
         # start the http server for http logger
         if logger == 'http':
+            self._state['start'] = time.monotonic()
+            self._state['running'] = {}
+            self._state['durations'] = {}
             self.log_server = HTTPLogServer(self._state, self._state_lock)
             self.log_server.start()
 
     def get(self):
         """ Return a new log instance """
         return self._log(self._state, self._state_lock)
+
+    def note(self, message):
+        """ Print message on a line of its own, above the status line
+
+        This is for what should be seen before the run is over, such as a
+        regression. The dummy logger doesn't print it.
+
+        """
+        if self._log is DummyLog:
+            return
+        with self._state_lock:
+            pad = max(self._state['lastlength'] - len(message), 0)
+            if sys.stdout.isatty():
+                sys.stdout.write('\r')
+            sys.stdout.write(message + ' ' * pad + '\n')
+            sys.stdout.flush()
+            # The status line was overwritten, no need to pad over it again
+            self._state['lastlength'] = 0
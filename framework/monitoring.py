@@ -28,14 +28,22 @@ The patterns of the errors are defined in piglit.conf, at the section
 monitored-errors.
 
 When one of the regex is found in the corresponding source Piglit will abort
-with code 3.
+with code 3. The sources are read by a thread every POLL_INTERVAL seconds
+while piglit runs, so monitoring costs the same however short the tests are.
+
+GpuHangMonitor watches the GPU reset counters instead, to pause the run while
+the GPU recovers from a hang rather than abort it.
 
 """
 
 import abc
 import errno
+import glob
 import os
 import re
+import sys
+import threading
+import time
 
 from framework.core import PIGLIT_CONFIG
 from framework.dmesg import LinuxDmesg
@@ -43,6 +51,7 @@ from framework import exceptions
 
 __all__ = [
     'BaseMonitoring',
+    'GpuHangMonitor',
     'Monitoring',
     'MonitoringFile',
     'MonitoringLinuxDmesg',
@@ -65,11 +74,17 @@ class Monitoring(object):
     # run forever)
     _abort_error = None
     _monitoring_rules = None
+    _thread = None
+
+    # How often in seconds the thread reads the sources
+    POLL_INTERVAL = 1.0
 
     def __init__(self, monitoring_enabled):
         """Create a LinuxMonitored instance"""
         # Get the monitoring rules from piglit.conf and store them into a dict.
         self._monitoring_rules = {}
+        self._lock = threading.Lock()
+        self._stop = threading.Event()
 
         if monitoring_enabled and PIGLIT_CONFIG.has_section('monitored-errors'):
             for key, _ in PIGLIT_CONFIG.items('monitored-errors'):
@@ -80,6 +95,8 @@ class Monitoring(object):
 
                     self.add_rule(key, type, parameters, regex)
 
+            self.start()
+
     @property
     def abort_needed(self):
         """Simply return if _abort_error variable is not empty"""
@@ -119,7 +136,8 @@ class Monitoring(object):
             raise exceptions.PiglitFatalError(
                 "No available monitoring class for the type {}.".format(type))
 
-        self._monitoring_rules[key] = rule
+        with self._lock:
+            self._monitoring_rules[key] = rule
 
     def delete_rule(self, key):
         """Remove a monitoring rule
@@ -128,11 +146,45 @@ class Monitoring(object):
         key -- The rule key
 
         """
-        self._monitoring_rules.pop(key, None)
+        with self._lock:
+            self._monitoring_rules.pop(key, None)
+
+    def start(self):
+        """Read the sources on a thread until stop() is called
+
+        update_monitoring() and check_monitoring() do nothing while the
+        thread runs, it sets abort_needed itself.
+
+        """
+        if self._monitoring_rules and self._thread is None:
+            self._update_monitoring()
+            self._stop.clear()
+            self._thread = threading.Thread(target=self._monitor, daemon=True)
+            self._thread.start()
+
+    def stop(self):
+        """Stop the thread, checking the sources a last time"""
+        if self._thread is None:
+            return
+        self._stop.set()
+        self._thread.join()
+        self._thread = None
+        if not self.abort_needed:
+            self._check_monitoring()
+
+    def _monitor(self):
+        while not self._stop.wait(self.POLL_INTERVAL):
+            self._check_monitoring()
+            if self.abort_needed:
+                break
 
     def update_monitoring(self):
         """Update the new messages for each monitoring object"""
-        if self._monitoring_rules:
+        if self._thread is None:
+            self._update_monitoring()
+
+    def _update_monitoring(self):
+        with self._lock:
             for monitoring_rule in self._monitoring_rules.values():
                 monitoring_rule.update_monitoring()
 
@@ -144,10 +196,14 @@ class Monitoring(object):
         set itself on abort_needed state.
 
         """
+        if self._thread is None:
+            self._check_monitoring()
+
+    def _check_monitoring(self):
         # Get a new snapshot of the source
-        self.update_monitoring()
+        self._update_monitoring()
 
-        if self._monitoring_rules:
+        with self._lock:
             for rule_key, monitoring_rule in self._monitoring_rules.items():
                 # Get error message
                 self._abort_error = monitoring_rule.check_monitoring()
@@ -159,6 +215,102 @@ class Monitoring(object):
                     break
 
 
+class GpuHangMonitor(object):
+    """Pause the tests while the GPU recovers from a hang
+
+    A thread reads the GPU reset counters of the kernel every POLL_INTERVAL
+    seconds. When one of them goes up, wait() holds back the tests that are
+    about to start until the counters have not changed for RECOVERY_TIME
+    seconds, and hung_since() tells the tests that were running that they
+    should run again.
+
+    The sources are the globs of the 'sources' option of the gpu-hang section
+    of piglit.conf, DEFAULT_SOURCES by default. A file is read as a counter,
+    the sum of the numbers in it, and a glob matching a file it didn't match
+    before also counts as a hang, which is how devcoredump dumps are counted.
+
+    """
+
+    POLL_INTERVAL = 0.25
+    RECOVERY_TIME = 2.0
+
+    DEFAULT_SOURCES = [
+        # A dump is added for each hang by xe, amdgpu, msm, panfrost, v3d...
+        '/sys/class/devcoredump/devcd*',
+        '/sys/kernel/debug/dri/*/i915_reset_info',
+    ]
+
+    def __init__(self, sources=None):
+        if sources is None:
+            sources = PIGLIT_CONFIG.safe_get('gpu-hang', 'sources')
+            sources = sources.split() if sources else self.DEFAULT_SOURCES
+        self._sources = sources
+        self._lock = threading.Lock()
+        self._hangs = 0
+        self._running = threading.Event()
+        self._running.set()
+        self._stop = threading.Event()
+        self._seen, self._count = self._read()
+        self._thread = threading.Thread(target=self._monitor, daemon=True)
+        self._thread.start()
+
+    @property
+    def hangs(self):
+        """The number of hangs seen so far"""
+        with self._lock:
+            return self._hangs
+
+    def wait(self):
+        """Wait until the GPU isn't recovering, return hangs"""
+        self._running.wait()
+        return self.hangs
+
+    def hung_since(self, hangs):
+        """Return whether the GPU hung since wait() returned hangs"""
+        return self.hangs != hangs
+
+    def stop(self):
+        """Stop the thread"""
+        self._stop.set()
+        self._thread.join()
+        self._running.set()
+
+    def _read(self):
+        """Return the files the sources match and the sum of their counters"""
+        paths = set()
+        count = 0
+        for source in self._sources:
+            for path in glob.glob(source):
+                paths.add(path)
+                if not os.path.isfile(path):
+                    continue
+                try:
+                    with open(path, 'r') as f:
+                        count += sum(int(n) for n in
+                                     re.findall(r'\d+', f.read(4096)))
+                except (OSError, UnicodeDecodeError):
+                    pass
+        return paths, count
+
+    def _monitor(self):
+        recovered = None
+        while not self._stop.wait(self.POLL_INTERVAL):
+            paths, count = self._read()
+            if paths - self._seen or count > self._count:
+                if self._running.is_set():
+                    print('GPU hang detected, waiting for it to recover',
+                          file=sys.stderr)
+                with self._lock:
+                    self._hangs += 1
+                self._running.clear()
+                recovered = time.monotonic() + self.RECOVERY_TIME
+            elif recovered is not None and time.monotonic() >= recovered:
+                self._running.set()
+                recovered = None
+            self._seen |= paths
+            self._count = count
+
+
 class BaseMonitoring(metaclass=abc.ABCMeta):
     """Abstract base class for Monitoring derived objects
 
@@ -46,6 +46,65 @@ class _Options(object):  # pylint: disable=too-many-instance-attributes
     valgrind -- True if valgrind is to be used
     env -- environment variables set for each test before run
     deqp_mustpass -- True to enable the use of the deqp mustpass list feature.
+    shader_runner_server -- True to feed batched shader tests to long lived
+                            shader_runner processes.
+    test_host -- True to run the OpenGL tests built as modules in long lived
+                 piglit-test-host processes.
+    fork_server -- True to run the OpenGL tests built as modules in children
+                   of a piglit-test-host fork server.
+    schedule_from -- the path of a previous run to take test durations from.
+    process_loop -- True to wait on all running tests from a single thread.
+    perf_baseline -- the path of a previous run to compare perf tests with.
+    perf_threshold -- the relative change of a perf test measurement, in the
+                      wrong direction, that counts as a regression.
+    perf_configs -- [name, env] pairs to run each perf test under, see
+                    framework.test.perf.
+    perf_rounds -- how many times each perf test runs under each of
+                   perf_configs.
+    devices -- the devices to spread the tests over, see
+               framework.profile.parse_device.
+    result_cache -- 'off', 'on' to reuse the cached results of tests whose
+                    inputs and driver haven't changed, or 'refresh' to run
+                    every test and cache its result.
+    retries -- how many more times to run the tests that failed or crashed,
+               at the end of the run.
+    output_limit -- when not 0, only the first and last this many bytes of
+                    the stdout and stderr of each test are kept in its
+                    result, with the PIGLIT lines in between.
+    output_spill_dir -- where the whole output of the tests cut by
+                        output_limit is written as gzip files, or None.
+    history -- the path of a history the results are added to once the run
+               is finished, see framework.history, or None.
+    adaptive_timeout -- the path of a history the timeouts of the tests are
+                        taken from, or None. The timeout of a test is then
+                        adaptive_timeout_factor times the 99th percentile
+                        of its past durations, but at least
+                        adaptive_timeout_floor and at most
+                        adaptive_timeout_ceiling seconds, or its usual
+                        timeout if that is shorter.
+    gpu_hang_detection -- True to hold the tests back while the GPU recovers
+                          from a hang and run the ones it interrupted again,
+                          see framework.monitoring.GpuHangMonitor.
+    coverage_record -- the results directory the driver code coverage of
+                       each test is recorded in, see framework.coverage, or
+                       None.
+    coverage_from -- the results directory of a run with coverage_record,
+                     to select the tests to run by coverage_changes, or None.
+    coverage_changes -- the changed files whose tests are run.
+    coverage_sample -- the fraction of the other tests that is also run.
+    prioritize -- the path of a history whose recent failures, and tests
+                  whose status changed, are run first, or None.
+    max_regressions -- stop the run after this many regressions from the
+                       prioritize history, or 0 to not stop.
+    glslparser_offline -- 'glslang' or 'mesa' to compile the glslparser tests
+                          with that standalone compiler instead of a GL
+                          context, or None.
+    shader_cache -- 'inherit' to leave the disk shader cache of the driver
+                    to the environment, or 'cold', 'seed' or 'shared', see
+                    framework.shadercache.
+    shader_cache_dir -- the directory of a shared shader cache, or the
+                        directory or tar archive a seeded one is restored
+                        from, or None.
     """
 
     def __init__(self):
@@ -57,6 +116,35 @@ class _Options(object):  # pylint: disable=too-many-instance-attributes
         self.jobs = None
         self.force_glsl = False
         self.spirv = False
+        self.shader_runner_server = False
+        self.test_host = False
+        self.fork_server = False
+        self.schedule_from = None
+        self.process_loop = False
+        self.perf_baseline = None
+        self.perf_threshold = 0.05
+        self.perf_configs = []
+        self.perf_rounds = 5
+        self.devices = []
+        self.result_cache = 'off'
+        self.retries = 0
+        self.output_limit = 0
+        self.output_spill_dir = None
+        self.history = None
+        self.adaptive_timeout = None
+        self.adaptive_timeout_factor = 10.0
+        self.adaptive_timeout_floor = 5.0
+        self.adaptive_timeout_ceiling = 600.0
+        self.gpu_hang_detection = False
+        self.coverage_record = None
+        self.coverage_from = None
+        self.coverage_changes = []
+        self.coverage_sample = 0.1
+        self.prioritize = None
+        self.max_regressions = 0
+        self.glslparser_offline = None
+        self.shader_cache = 'inherit'
+        self.shader_cache_dir = None
 
         # env is used to set some base environment variables that are not going
         # to change across runs, without sending them to os.environ which is
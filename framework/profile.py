@@ -35,35 +35,110 @@ import copy
 import gzip
 import importlib
 import itertools
+import json
 import multiprocessing
 import multiprocessing.dummy
 import os
 import re
+import sys
+import threading
+import zlib
 import xml.etree.ElementTree as et
 
-from framework import grouptools, exceptions, status
+from framework import core, grouptools, exceptions, resultcache, status
+from framework import shadercache
 from framework.dmesg import get_dmesg
-from framework.log import LogManager
-from framework.monitoring import Monitoring
-from framework.test.base import Test, DummyTest, TestPlaceholder
+from framework.log import DummyLog, LogManager
+from framework.monitoring import GpuHangMonitor, Monitoring
+from framework.test.base import (
+    Test, DummyTest, TestPlaceholder, RESOURCE_CLASSES
+)
 from framework.test.piglit_test import (
-    PiglitCLTest, PiglitGLTest, ASMParserTest, BuiltInConstantsTest,
-    CLProgramTester, VkRunnerTest, ROOT_DIR,
+    PiglitCLTest, PiglitGLTest, ASMParserTest, MultiASMParserTest,
+    BuiltInConstantsTest, CLProgramTester, VkRunnerTest, MultiVkRunnerTest,
+    ROOT_DIR,
 )
 from framework.test.shader_test import ShaderTest, MultiShaderTest
-from framework.test.glsl_parser_test import GLSLParserTest
+from framework.test.glsl_parser_test import GLSLParserTest, MultiGLSLParserTest
 from framework.test.xorg import XTSTest, RendercheckTest
 from framework.options import OPTIONS
+from framework.results import TestResult
 
 __all__ = [
+    'Devices',
     'RegexFilter',
+    'ResourceGate',
     'TestDict',
     'TestProfile',
     'load_test_profile',
+    'parse_device',
     'run',
+    'thread_budget',
 ]
 
 
+# The characters that make a regex more than a literal string
+_REGEX_SPECIAL = re.compile(r'[.^$*+?{}\[\]|()]')
+_REGEX_ESCAPE = re.compile(r'\\(.)')
+# Things whose meaning would change once merged into a single regex
+_REGEX_UNMERGEABLE = re.compile(r'\\[1-9]|\(\?P=|\(\?[aiLmsux]+\)')
+
+
+def _literal(regex):
+    """Return the string regex matches if it is a literal, else None."""
+    if '\\' in regex:
+        if re.search(r'\\[0-9A-Za-z]', regex):
+            return None
+        # Only look for specials outside of the escapes
+        if _REGEX_SPECIAL.search(_REGEX_ESCAPE.sub('', regex)):
+            return None
+        return _REGEX_ESCAPE.sub(r'\1', regex)
+    if _REGEX_SPECIAL.search(regex):
+        return None
+    return regex
+
+
+class _NameTrie(object):
+    """Matches test names against exact names and prefixes.
+
+    The trie is keyed on the groups of the names. Each node holds whether a
+    name ending there matches, and the beginnings of the next group that
+    make a name match whatever follows them.
+    """
+
+    def __init__(self):
+        self.__root = {}
+
+    def __node(self, groups):
+        node = self.__root
+        for group in groups:
+            node = node.setdefault(group, {})
+        return node
+
+    def add_exact(self, name):
+        self.__node(name.split(grouptools.SEPARATOR))[None] = True
+
+    def add_prefix(self, prefix):
+        groups = prefix.split(grouptools.SEPARATOR)
+        partial = groups.pop()
+        node = self.__node(groups)
+        node[()] = node.get((), ()) + (partial, )
+
+    def __bool__(self):
+        return bool(self.__root)
+
+    def match(self, name):
+        node = self.__root
+        for group in name.split(grouptools.SEPARATOR):
+            partials = node.get(())
+            if partials and any(group.startswith(p) for p in partials):
+                return True
+            node = node.get(group)
+            if node is None:
+                return False
+        return node.get(None, False)
+
+
 class RegexFilter(object):
     """An object to be passed to TestProfile.filter.
 
@@ -74,6 +149,10 @@ class RegexFilter(object):
     a test that matches any regex will not be scheduled. Regardless of the
     value of the inverse flag if filters is empty then the test will be run.
 
+    Lists of thousands of names, such as expectation files, are common, so
+    the regexes are not searched one by one: the anchored literal ones go in
+    a _NameTrie and the others are merged into a single regex.
+
     Arguments:
     filters -- a list of regex compiled objects.
 
@@ -81,10 +160,41 @@ class RegexFilter(object):
     inverse -- Inverse the sense of the match.
     """
 
+    # Only the name is looked at, so XMLProfile can apply this before
+    # creating the test.
+    names_only = True
+
     def __init__(self, filters, inverse=False):
         self.filters = [re.compile(f, flags=re.IGNORECASE) for f in filters]
         self.inverse = inverse
 
+        self._trie = _NameTrie()
+        merged = []
+        self._regexes = []
+        for regex in filters:
+            anchored = regex.startswith('^')
+            exact = anchored and regex.endswith('$') and \
+                not regex.endswith('\\$')
+            literal = _literal(regex[int(anchored):len(regex) - int(exact)])
+            if literal is not None and anchored:
+                if exact:
+                    self._trie.add_exact(literal.lower())
+                else:
+                    self._trie.add_prefix(literal.lower())
+            elif _REGEX_UNMERGEABLE.search(regex):
+                self._regexes.append(re.compile(regex, flags=re.IGNORECASE))
+            else:
+                merged.append(regex)
+        if merged:
+            try:
+                self._regexes.append(re.compile(
+                    '|'.join('(?:{})'.format(r) for r in merged),
+                    flags=re.IGNORECASE))
+            except re.error:
+                # Such as the same group name used by two of them
+                self._regexes.extend(re.compile(r, flags=re.IGNORECASE)
+                                     for r in merged)
+
     def __call__(self, name, _):  # pylint: disable=invalid-name
         # This needs to match the signature (name, test), since it doesn't need
         # the test instance use _.
@@ -94,10 +204,9 @@ class RegexFilter(object):
         if not self.filters:
             return True
 
-        if not self.inverse:
-            return any(r.search(name) for r in self.filters)
-        else:
-            return not any(r.search(name) for r in self.filters)
+        matched = ((self._trie and self._trie.match(name.lower())) or
+                   any(r.search(name) for r in self._regexes))
+        return matched != self.inverse
 
 
 class TestDict(collections.abc.MutableMapping):
@@ -110,6 +219,10 @@ class TestDict(collections.abc.MutableMapping):
     This class doesn't accept keyword arguments, this is intentional. This is
     because the TestDict class is ordered, and keyword arguments are unordered,
     which is a design mismatch.
+
+    Copies share their tests with the original until either of them is
+    modified, so that profiles derived from another, like quick_gl, don't
+    duplicate the whole list of tests.
     """
     def __init__(self):
         # This counter is incremented once when the allow_reassignment context
@@ -117,6 +230,20 @@ class TestDict(collections.abc.MutableMapping):
         # allows stacking of the context manager
         self.__allow_reassignment = 0
         self.__container = collections.OrderedDict()
+        # Whether __container may be shared with copies of this instance
+        self.__shared = False
+
+    def __copy__(self):
+        new = type(self).__new__(type(self))
+        new.__dict__.update(self.__dict__)
+        self.__shared = new.__shared = True
+        return new
+
+    def __unshare(self):
+        """Give this instance its own container before modifying it."""
+        if self.__shared:
+            self.__container = collections.OrderedDict(self.__container)
+            self.__shared = False
 
     def __setitem__(self, key, value):
         """Enforce types on set operations.
@@ -161,6 +288,7 @@ class TestDict(collections.abc.MutableMapping):
                 "A test has already been assigned the name: {}\n{}".format(
                     key, error))
 
+        self.__unshare()
         self.__container[key] = value
 
     def __getitem__(self, key):
@@ -182,7 +310,11 @@ class TestDict(collections.abc.MutableMapping):
 
     def __delitem__(self, key):
         """Lower the value before returning."""
-        del self.__container[key.lower()]
+        key = key.lower()
+        if key not in self.__container:
+            raise KeyError(key)
+        self.__unshare()
+        del self.__container[key]
 
     def __len__(self):
         return len(self.__container)
@@ -342,8 +474,12 @@ def make_test(element):
         return GLSLParserTest(**options)
     if type_ == 'asm_parser':
         return ASMParserTest(**options)
+    if type_ == 'multi_asm_parser':
+        return MultiASMParserTest(**options)
     if type_ == 'vkrunner':
         return VkRunnerTest(**options)
+    if type_ == 'multi_vkrunner':
+        return MultiVkRunnerTest(**options)
     if type_ == 'multi_shader':
         options['skips'] = []
         for e in element.findall('./Skips/Skip/option'):
@@ -351,6 +487,15 @@ def make_test(element):
             process(e, skips)
             options['skips'].append(skips)
         return MultiShaderTest(**options)
+    if type_ == 'multi_glsl_parser':
+        # One Skip per test, even when it has no requirements
+        options['skips'] = []
+        for skip in element.findall('./Skips/Skip'):
+            skips = {}
+            for e in skip.findall('./option'):
+                process(e, skips)
+            options['skips'].append(skips)
+        return MultiGLSLParserTest(**options)
     if type_ == 'xts':
         return XTSTest(**options)
     if type_ == 'rendercheck':
@@ -372,6 +517,9 @@ class XMLProfile(object):
 
     def __len__(self):
         if not (self.filters or self.forced_test_list):
+            index = self._load_index()
+            if index is not None:
+                return index['count']
             with gzip.open(self.filename, 'rt') as f:
                 iter_ = et.iterparse(f, events=(b'start', ))
                 for _, elem in iter_:
@@ -385,8 +533,56 @@ class XMLProfile(object):
     def teardown(self):
         pass
 
-    def _itertests(self):
-        """Always iterates tests instead of using the forced test_list."""
+    def _load_index(self):
+        """Return the index written by tests/serializer.py, or None.
+
+        The index is ignored if it doesn't match the XML file.
+        """
+        if not hasattr(self, '_index'):
+            self._index = None
+            try:
+                with open(self.filename + '.index', 'r') as f:
+                    index = json.load(f)
+                if index['size'] == os.path.getsize(self.filename):
+                    self._index = index
+            except (OSError, ValueError, KeyError):
+                pass
+        return self._index
+
+    def _itertests_indexed(self, index, names=None):
+        """Iterate the tests using the index.
+
+        Filters that only look at names are applied to the index, so that
+        only the tests that pass them are read from the file and created.
+        """
+        names_only = [f for f in self.filters
+                      if getattr(f, 'names_only', False)]
+        wanted = [t for t in index['tests']
+                  if (names is None or t[0] in names) and
+                  all(f(t[0], None) for f in names_only)]
+
+        with open(self.filename, 'rb') as f:
+            current, data = None, None
+            for name, member, start, length in wanted:
+                if member != current:
+                    offset, size = index['members'][member]
+                    f.seek(offset)
+                    data = zlib.decompress(f.read(size), 16 + zlib.MAX_WBITS)
+                    current = member
+                yield name, make_test(et.fromstring(data[start:start + length]))
+
+    def _itertests(self, names=None):
+        """Always iterates tests instead of using the forced test_list.
+
+        If names is given only the tests in it are created.
+        """
+        index = self._load_index()
+        if index is not None:
+            for k, v in self.filters.run(
+                    self._itertests_indexed(index, names)):
+                yield k, v
+            return
+
         def _iter():
             with gzip.open(self.filename, 'rt') as f:
                 doc = et.iterparse(f, events=(b'end', ))
@@ -395,8 +591,8 @@ class XMLProfile(object):
                     if e.tag != 'Test':
                         continue
                     k = e.attrib['name']
-                    v = make_test(e)
-                    yield k, v
+                    if names is None or k in names:
+                        yield k, make_test(e)
                     root.clear()
 
         for k, v in self.filters.run(_iter()):
@@ -404,7 +600,7 @@ class XMLProfile(object):
 
     def itertests(self):
         if self.forced_test_list:
-            alltests = dict(self._itertests())
+            alltests = dict(self._itertests(set(self.forced_test_list)))
             opts = collections.OrderedDict()
             for n in self.forced_test_list:
                 if self.options['ignore_missing'] and n not in alltests:
@@ -628,7 +824,340 @@ def load_test_profile(filename, python=None):
             'Did you specify the right file?'.format(filename))
 
 
-def run(profiles, logger, backend, concurrency, jobs):
+# Durations loaded by load_durations, by results path
+_DURATIONS = {}
+
+
+def load_durations(results_path):
+    """Return a dict of test name to run time from a previous run.
+
+    Subtests are given an even share of the time of their test, under their
+    full name. Returns None if there is no such run, in which case tests are
+    run in profile order. Each run is only loaded once.
+
+    results_path can also be a history, see framework.history, the run time
+    of each test is then its median over the last few runs.
+    """
+    if not results_path:
+        return None
+    if results_path in _DURATIONS:
+        return _DURATIONS[results_path]
+
+    # Importing these at the top would be circular
+    from framework import backends, history
+
+    if history.is_history(results_path):
+        with history.History(results_path) as store:
+            durations = store.latest_durations() or None
+        _DURATIONS[results_path] = durations
+        return durations
+
+    try:
+        results = backends.load(results_path)
+    except (backends.BackendError, backends.BackendNotImplementedError,
+            exceptions.PiglitFatalError, OSError) as e:
+        print('Warning: Not scheduling from {}: {}'.format(results_path, e),
+              file=sys.stderr)
+        durations = None
+    else:
+        durations = {}
+        for name, result in results.tests.items():
+            durations[name] = result.time.total
+            for sub in result.subtests:
+                durations[grouptools.join(name, sub)] = \
+                    result.time.total / len(result.subtests)
+
+    _DURATIONS[results_path] = durations
+    return durations
+
+
+def order_by_duration(test_list, durations):
+    """Return the (name, test) pairs of test_list, longest first.
+
+    durations maps test names to their run time in seconds, usually from a
+    previous run. Tests missing from it are assumed to take the median time
+    of the known ones, so that new tests neither hold up the start of the
+    run nor trail at the end of it. Tests of equal duration keep their
+    profile order.
+    """
+    test_list = list(test_list)
+    if not durations:
+        return test_list
+
+    known = sorted(durations.values())
+    default = known[len(known) // 2]
+    return sorted(test_list, key=lambda x: durations.get(x[0], default),
+                  reverse=True)
+
+
+def load_statuses(history_path):
+    """Return a dict of test name to its statuses in the last runs of the
+    history at history_path, oldest first, or None if there is no history.
+    """
+    if not history_path:
+        return None
+
+    # Importing this at the top would be circular
+    from framework import history
+
+    with history.History(history_path) as store:
+        return store.latest_statuses()
+
+
+# The last statuses of the tests order_by_priority() puts first
+_PROBLEM_STATUSES = frozenset([
+    'fail', 'crash', 'timeout', 'warn', 'dmesg-warn', 'dmesg-fail',
+    'incomplete'])
+
+
+def order_by_priority(test_list, statuses):
+    """Return the (name, test) pairs of test_list, likeliest to regress first.
+
+    statuses maps test names to their statuses in the last runs, oldest
+    first. The tests that last failed come first, then the ones whose
+    status changed in those runs, such as flaky tests, then the others.
+    The order of test_list is kept otherwise, such as that of
+    order_by_duration().
+    """
+    test_list = list(test_list)
+    if not statuses:
+        return test_list
+
+    def priority(x):
+        recent = statuses.get(x[0])
+        if not recent:
+            return 0
+        if recent[-1] in _PROBLEM_STATUSES:
+            return 2
+        return 1 if len(set(recent)) > 1 else 0
+
+    return sorted(test_list, key=priority, reverse=True)
+
+
+def _is_regression(before, after):
+    """Return whether the status after is a regression from before.
+
+    This is what the summaries count as a regression.
+    """
+    before = status.status_lookup(before)
+    after = status.status_lookup(after)
+    return before < after and min(before, after) >= status.PASS
+
+
+# The environment variables that select a software rasterizer whose threads
+# share the cores with the other jobs, and the values that do.
+_SOFTWARE_DRIVERS = {
+    'GALLIUM_DRIVER': ('llvmpipe', ),
+    'LIBGL_ALWAYS_SOFTWARE': ('1', 'true', 'yes'),
+    'VK_ICD_FILENAMES': ('lvp_icd', ),
+    'VK_DRIVER_FILES': ('lvp_icd', ),
+}
+
+
+def thread_budget(concurrency, jobs):
+    """Share the cores out between the jobs of a software rasterizer run.
+
+    Each llvmpipe or lavapipe context starts LP_NUM_THREADS rasterizer
+    threads, one per core by default, so running a test per core is
+    oversubscribed many times over. The cores are instead shared out: the
+    tests that aren't run concurrently are usually the heavy ones and get a
+    quarter of them, or all of them when every test runs on its own, and the
+    concurrent jobs share the others.
+
+    The number of cores comes from PIGLIT_THREAD_BUDGET or the piglit.conf
+    [core]:thread_budget option, and defaults to the number of CPUs when a
+    software rasterizer is selected by the environment. 0 disables this.
+    When jobs isn't given, the number of jobs is chosen so that each of them
+    gets LP_NUM_THREADS threads, or one if it isn't set.
+
+    Returns the number of jobs, and the LP_NUM_THREADS of the concurrent and
+    of the other tests. The latter two are None if there's no budget.
+    """
+    env = dict(os.environ, **OPTIONS.env)
+    software = any(v in env.get(k, '').lower()
+                   for k, values in _SOFTWARE_DRIVERS.items() for v in values)
+    budget = int(core.get_option(
+        'PIGLIT_THREAD_BUDGET', ('core', 'thread_budget'),
+        default=str(os.cpu_count() or 1) if software else '0'))
+    if budget <= 0:
+        return jobs, None, None
+
+    if concurrency == 'none':
+        return jobs, None, budget
+
+    heavy = max(1, budget // 4) if concurrency == 'some' else None
+    shared = max(1, budget - (heavy or 0))
+    if jobs is None:
+        threads = env.get('LP_NUM_THREADS', '')
+        threads = int(threads) if threads.isdigit() and int(threads) else 1
+        jobs = max(1, shared // threads)
+    else:
+        threads = max(1, shared // jobs)
+    return jobs, threads, heavy or threads
+
+
+def _set_threads(test, threads):
+    """Set the LP_NUM_THREADS of test, unless it sets its own."""
+    if threads is not None and 'LP_NUM_THREADS' not in test.env:
+        test.env['LP_NUM_THREADS'] = str(threads)
+
+
+def parse_device(spec):
+    """Return the environment that makes a test use the device spec.
+
+    spec is either the path of a DRM node, such as /dev/dri/renderD129, which
+    is given to the tests as WAFFLE_GBM_DEVICE, or comma separated VAR=VALUE
+    assignments, such as DRI_PRIME=1 or MESA_VK_DEVICE_SELECT=1002:73bf.
+    """
+    if '=' not in spec:
+        return {'WAFFLE_GBM_DEVICE': spec}
+
+    env = {}
+    for assignment in spec.split(','):
+        var, _, value = assignment.partition('=')
+        if not var.strip():
+            raise exceptions.PiglitFatalError(
+                'Invalid device "{}", expected VAR=VALUE[,VAR=VALUE...] or '
+                'the path of a DRM node'.format(spec))
+        env[var.strip()] = value
+    return env
+
+
+class Devices(object):
+    """Pins each thread running tests to one of the devices.
+
+    The threads are given the devices in turn the first time they run a
+    test, so every device gets the same number of jobs, and as the jobs all
+    take their tests from the same queue the tests are balanced between the
+    devices.
+    """
+
+    def __init__(self, specs, first=None):
+        self.__devices = [(spec, parse_device(spec)) for spec in specs]
+        self.__next = first or itertools.count()
+        self.__local = threading.local()
+
+    def __next_index(self):
+        if isinstance(self.__next, itertools.count):
+            return next(self.__next)
+        # A multiprocessing.Value shared by the worker processes
+        with self.__next.get_lock():
+            index = self.__next.value
+            self.__next.value += 1
+        return index
+
+    def pin(self, test):
+        """Set the environment of test for the device of this thread.
+
+        Returns the name of the device, to tag the result with.
+        """
+        device = getattr(self.__local, 'device', None)
+        if device is None:
+            device = self.__devices[self.__next_index() % len(self.__devices)]
+            self.__local.device = device
+        spec, env = device
+        for var, value in env.items():
+            test.env.setdefault(var, value)
+        return spec
+
+
+class ResourceGate(object):
+    """Admits the tests that use a lot of a resource while they fit in it.
+
+    Each test of a resource class (see Test.resource_class) waits until its
+    weight fits with those of the running tests of its class, so that, say,
+    only one test that may use all of the VRAM runs at a time but alongside
+    any number of tests that use little. A test always fits if no other test
+    of its class is running.
+
+    The state is kept in multiprocessing objects of context, so that the
+    gate can be shared by forked worker processes as well as threads.
+    """
+
+    # The weights are counted in thousandths, to keep the sums exact
+    _SCALE = 1000
+
+    def __init__(self, context=multiprocessing):
+        self.__cond = context.Condition()
+        self.__used = context.Array('i', len(RESOURCE_CLASSES), lock=False)
+
+    @contextlib.contextmanager
+    def admit(self, test):
+        """Wait until test fits, and hold its share while in the context."""
+        class_ = getattr(test, 'resource_class', None)
+        if class_ is None:
+            yield
+            return
+
+        index = RESOURCE_CLASSES.index(class_)
+        weight = int(round(test.resource_weight * self._SCALE))
+        with self.__cond:
+            self.__cond.wait_for(
+                lambda: (not self.__used[index] or
+                         self.__used[index] + weight <= self._SCALE))
+            self.__used[index] += weight
+        try:
+            yield
+        finally:
+            with self.__cond:
+                self.__used[index] -= weight
+                self.__cond.notify_all()
+
+
+# The tests run by the worker processes, and the options to run them with.
+# These are set before the workers are forked, so that each worker inherits
+# them and only the index of a test has to be sent to it.
+# The statuses of the tests that are run again with --retry-failures
+_RETRY_STATUSES = frozenset([status.FAIL, status.CRASH])
+
+_WORKER_TESTS = []
+_WORKER_OPTIONS = {}
+# The Devices of the worker processes, if the tests run on several devices
+_WORKER_DEVICES = None
+# The ResourceGate the worker processes share with the parent
+_WORKER_GATE = None
+# The Event the parent sets when the run stops early
+_WORKER_STOP = None
+
+
+def _init_worker(devices, first, gate, stop):
+    """Set up a new worker process.
+
+    It gets its own device, if there are devices, the gate, and the event
+    that is set when the run stops early.
+    """
+    global _WORKER_DEVICES, _WORKER_GATE, _WORKER_STOP
+    if devices:
+        _WORKER_DEVICES = Devices(devices, first)
+    _WORKER_GATE = gate
+    _WORKER_STOP = stop
+
+
+def _execute_in_worker(index):
+    """Run _WORKER_TESTS[index] in a worker process.
+
+    Returns the index and the result in its JSON form, which unlike the
+    TestResult can be sent back to the parent.
+    """
+    # Importing this at the top would be circular
+    from framework.backends.json import piglit_encoder
+
+    if _WORKER_STOP.is_set():
+        return index, None
+
+    name, test = _WORKER_TESTS[index]
+    device = _WORKER_DEVICES and _WORKER_DEVICES.pin(test)
+    with _WORKER_GATE.admit(test):
+        test.execute(name, DummyLog(None, None), _WORKER_OPTIONS)
+    if device:
+        test.result.resources['device'] = device
+    result = json.loads(json.dumps(test.result, default=piglit_encoder))
+    test.result = None
+    return index, result
+
+
+def run(profiles, logger, backend, concurrency, jobs, durations=None,
+        processes=False):
     """Runs all tests using Thread pool.
 
     When called this method will flatten out self.tests into self.test_list,
@@ -646,20 +1175,118 @@ def run(profiles, logger, backend, concurrency, jobs):
     logger   -- a log.LogManager instance.
     backend  -- a results.Backend derived instance.
     jobs     -- maximum number of concurrent jobs. Use os.cpu_count() by default
+
+    Keyword Arguments:
+    durations -- a dict of test name to run time in seconds. If given, tests
+                 are started longest first, see order_by_duration().
+    processes -- run the concurrent tests in a pool of forked worker
+                 processes instead of threads, so that the Python side of
+                 running and interpreting tests isn't serialized by the GIL.
+                 Results and logging are still handled by this process.
+
+    With OPTIONS.retries the tests that failed or crashed are run again, up
+    to that many times, once all of the others are done. Their result is
+    only written then, with the earlier ones in its attempts.
+
+    With OPTIONS.gpu_hang_detection no test is started while the GPU
+    recovers from a hang, and the tests that were running during it are run
+    once more, see GpuHangMonitor. This doesn't cover the tests run by
+    worker processes.
+
+    With OPTIONS.prioritize the tests that last failed or changed status in
+    that history are started first, see order_by_priority(), and each
+    regression from it is printed as soon as its test is done. The run
+    stops once there are OPTIONS.max_regressions of them, if it isn't 0.
     """
     chunksize = 1
 
     profiles = [(p, p.itertests()) for p in profiles]
     log = LogManager(logger, sum(len(p) for p, _ in profiles))
 
+    jobs, threads, heavy_threads = thread_budget(concurrency, jobs)
+
+    devices = Devices(OPTIONS.devices) if OPTIONS.devices else None
+    # The forked worker processes need the gate and stop to be forkable
+    mp_context = multiprocessing.get_context('fork') if processes \
+        else multiprocessing
+    gate = ResourceGate(mp_context)
+    statuses = load_statuses(OPTIONS.prioritize)
+    # The tests that regressed from statuses, and the event set once there
+    # are too many of them
+    regressions = []
+    stop = mp_context.Event()
+    # The tests to run again, with the writer of their result
+    failed = []
+    hangs = GpuHangMonitor() if OPTIONS.gpu_hang_detection else None
+
+    def check(name, result):
+        """Print result if it is a regression, stopping if there are enough.
+        """
+        recent = statuses and statuses.get(name)
+        if not recent or not _is_regression(recent[-1], result):
+            return
+        regressions.append(name)
+        log.note('regression: {} ({} -> {})'.format(name, recent[-1], result))
+        if 0 < OPTIONS.max_regressions <= len(regressions):
+            stop.set()
+
+    def write(name, test, profile, w):
+        """Write the result of test with w, unless it is to be run again."""
+        if OPTIONS.retries and test.result.result in _RETRY_STATUSES:
+            failed.append((name, test, profile, w))
+            return
+        check(name, test.result.result)
+        shadercache.TOTALS.add(test.result)
+        w(test.result)
+        # The result has been written, don't keep its output around for as
+        # long as the profile holds the test.
+        test.result = None
+
     def test(name, test, profile, this_pool=None):
         """Function to call test.execute from map"""
-        with backend.write_test(name) as w:
+        if stop.is_set():
+            return
+        _set_threads(test, threads if this_pool is multi else heavy_threads)
+        device = devices and devices.pin(test)
+        hung = hangs and hangs.wait()
+        with gate.admit(test), backend.write_test(name) as w:
             test.execute(name, log.get(), profile.options)
-            w(test.result)
+            if hangs and hangs.hung_since(hung):
+                # The hang is most likely some other test's, so this one
+                # gets a second chance once the GPU has recovered
+                previous = test.result
+                test.result = None
+                hangs.wait()
+                with resultcache.bypass():
+                    test.execute(name, DummyLog(None, None), profile.options)
+                test.result.add_attempt(previous)
+            if device:
+                test.result.resources['device'] = device
+            write(name, test, profile, w)
         if profile.options['monitor'].abort_needed:
             this_pool.terminate()
 
+    def retry(name, test, profile, w, retry_log):
+        """Run test again until it passes, up to OPTIONS.retries times."""
+        l = retry_log.get()
+        l.start(name)
+        for _ in range(OPTIONS.retries):
+            previous = test.result
+            test.result = None
+            # The test kept the environment, and so the device, it had
+            with resultcache.bypass(), gate.admit(test):
+                test.execute(name, DummyLog(None, None), profile.options)
+            if 'device' in previous.resources:
+                test.result.resources['device'] = previous.resources['device']
+            test.result.add_attempt(previous)
+            if test.result.result not in _RETRY_STATUSES:
+                break
+        l.log(test.result.result)
+        check(name, test.result.result)
+        shadercache.TOTALS.add(test.result)
+        w(test.result)
+        test.result = None
+
     def run_threads(pool, profile, test_list, filterby=None):
         """ Open a pool, close it, and join it """
         if filterby:
@@ -668,13 +1295,66 @@ def run(profiles, logger, backend, concurrency, jobs):
             # more code, and adding side-effects
             test_list = (x for x in test_list if filterby(x))
 
-        for n, t in test_list:
-            pool.apply_async(test, [n, t, profile, pool])
+        if durations is not None:
+            test_list = order_by_duration(test_list, durations)
+        if statuses:
+            test_list = order_by_priority(test_list, statuses)
+
+        return [pool.apply_async(test, [n, t, profile, pool])
+                for n, t in test_list]
+
+    def run_processes(profile, test_list, serial_list):
+        """Run test_list in worker processes and serial_list in this one."""
+        _WORKER_TESTS[:] = order_by_priority(
+            order_by_duration(test_list, durations), statuses)
+        for _, test_ in _WORKER_TESTS:
+            _set_threads(test_, threads)
+        _WORKER_OPTIONS.clear()
+        _WORKER_OPTIONS.update(profile.options)
+
+        def done(ret):
+            index, result = ret
+            if result is None:
+                return
+            name, test_ = _WORKER_TESTS[index]
+            test_.result = TestResult.from_dict(result)
+            result = test_.result.result
+
+            l = log.get()
+            l.start(name)
+            with backend.write_test(name) as w:
+                write(name, test_, profile, w)
+            l.log(result)
+
+        # Fork before any test of this process is running, so that the
+        # workers don't inherit the pipes of a running test.
+        context = multiprocessing.get_context('fork')
+        workers = context.Pool(jobs, initializer=_init_worker,
+                               initargs=(OPTIONS.devices,
+                                         context.Value('i', 0), gate, stop))
+        try:
+            pending = run_threads(single, profile, serial_list)
+            for i in range(len(_WORKER_TESTS)):
+                workers.apply_async(_execute_in_worker, [i], callback=done)
+            workers.close()
+            workers.join()
+            for r in pending:
+                r.wait()
+        finally:
+            workers.terminate()
 
     def run_profile(profile, test_list):
         """Run an individual profile."""
         profile.setup()
-        if concurrency == "all":
+        if processes and concurrency != "none":
+            test_list = list(test_list)
+            run_processes(
+                profile,
+                [x for x in test_list
+                 if concurrency == "all" or x[1].run_concurrent],
+                [x for x in test_list
+                 if concurrency != "all" and not x[1].run_concurrent])
+        elif concurrency == "all":
             run_threads(multi, profile, test_list)
         elif concurrency == "none":
             run_threads(single, profile, test_list)
@@ -710,6 +1390,34 @@ def run(profiles, logger, backend, concurrency, jobs):
     finally:
         log.get().summary()
 
+    if failed and (stop.is_set() or
+                   any(p.options['monitor'].abort_needed for p, _ in profiles)):
+        for name, test_, _, w in failed:
+            w(test_.result)
+    elif failed:
+        # A pool per kind of test again, the first ones are closed
+        pools = [multiprocessing.dummy.Pool(1),
+                 multiprocessing.dummy.Pool(jobs)]
+        retry_log = LogManager(logger, len(failed))
+        try:
+            for name, test_, profile, w in failed:
+                concurrent = (concurrency == "all" or
+                              concurrency == "some" and test_.run_concurrent)
+                pools[concurrent].apply_async(
+                    retry, [name, test_, profile, w, retry_log])
+            for pool in pools:
+                pool.close()
+                pool.join()
+        finally:
+            retry_log.get().summary()
+
+    if hangs:
+        hangs.stop()
+
     for p, _ in profiles:
+        p.options['monitor'].stop()
         if p.options['monitor'].abort_needed:
             raise exceptions.PiglitAbort(p.options['monitor'].error_message)
+    if stop.is_set():
+        raise exceptions.PiglitAbort(
+            'Stopped after {} regressions'.format(len(regressions)))
@@ -26,16 +26,21 @@ import os
 import os.path as path
 import re
 import shutil
+import sqlite3
 import sys
 import time
 
 from framework import core, backends, options
+from framework import coverage
 from framework import dmesg
 from framework import exceptions
+from framework import history
 from framework import monitoring
 from framework import profile
+from framework import shadercache
+from framework import sharding
 from framework.results import TimeAttribute
-from framework.test import base
+from framework.test import base, perf, piglit_test
 from . import parsers
 
 __all__ = ['run',
@@ -147,7 +152,8 @@ def _run_parser(input_):
     parser.add_argument("--dmesg",
                         action="store_true",
                         help="Capture a difference in dmesg before and "
-                             "after each test. Implies -1/--no-concurrency")
+                             "after each test. Implies -1/--no-concurrency "
+                             "unless /dev/kmsg can be read")
     parser.add_argument("--abort-on-monitored-error",
                         action="store_true",
                         dest="monitored",
@@ -242,6 +248,256 @@ def _run_parser(input_):
     parser.add_argument("--spirv",
                         action="store_true",
                         help="Run shader runner tests with the -spirv (try SPIR-V) option")
+    parser.add_argument("--glslparser-offline",
+                        dest="glslparser_offline",
+                        choices=["glslang", "mesa"],
+                        help="Compile the glslparser tests with glslangValidator "
+                             "or Mesa's standalone glsl_compiler instead of "
+                             "creating a GL context, so that they run "
+                             "without a GPU. The requirements of the tests "
+                             "aren't checked.")
+
+    parser.add_argument("--shader-runner-server",
+                        dest="shader_runner_server",
+                        action="store_true",
+                        help="Keep one shader_runner process per job and feed "
+                             "it the shader tests over a pipe. Only affects "
+                             "runs without process isolation.")
+    parser.add_argument("--test-host",
+                        dest="test_host",
+                        action="store_true",
+                        help="Run the OpenGL tests that were built as modules "
+                             "(PIGLIT_BUILD_TEST_MODULES) in one "
+                             "piglit-test-host process per job instead of "
+                             "starting a process for each of them.")
+    parser.add_argument("--fork-server",
+                        dest="fork_server",
+                        action="store_true",
+                        help="Like --test-host, but run each test in a child "
+                             "forked from one piglit-test-host process, so "
+                             "that a crash only takes the test down.")
+    parser.add_argument("--process-loop",
+                        dest="process_loop",
+                        action="store_true",
+                        help="Wait for the output and timeouts of all running "
+                             "tests from a single thread, instead of one "
+                             "thread per job. Helps with many jobs. Only "
+                             "affects POSIX systems.")
+    parser.add_argument("--schedule-from",
+                        dest="schedule_from",
+                        metavar="<Results Path>",
+                        help="Start the tests that took longest in this "
+                             "previous run first, to shorten the tail of the "
+                             "run.")
+    parser.add_argument("--history",
+                        dest="history",
+                        metavar="<History Path>",
+                        help="Add the status and duration of every test to "
+                             "this history database once the run is "
+                             "finished, creating it if needed. See piglit "
+                             "summary history. It can also be given to "
+                             "--schedule-from.")
+    parser.add_argument("--adaptive-timeout",
+                        dest="adaptive_timeout",
+                        metavar="<History Path>",
+                        help="Time out each test after a multiple of the "
+                             "99th percentile of its duration in this "
+                             "history, so that hangs are caught in seconds. "
+                             "Tests that aren't in it keep their usual "
+                             "timeout.")
+    parser.add_argument("--adaptive-timeout-factor",
+                        dest="adaptive_timeout_factor",
+                        type=float,
+                        default=10.0,
+                        metavar="<float>",
+                        help="The multiple of the duration of a test its "
+                             "adaptive timeout is. (default: %(default)s)")
+    parser.add_argument("--adaptive-timeout-floor",
+                        dest="adaptive_timeout_floor",
+                        type=float,
+                        default=5.0,
+                        metavar="<seconds>",
+                        help="The shortest adaptive timeout. "
+                             "(default: %(default)s)")
+    parser.add_argument("--adaptive-timeout-ceiling",
+                        dest="adaptive_timeout_ceiling",
+                        type=float,
+                        default=600.0,
+                        metavar="<seconds>",
+                        help="The longest adaptive timeout. "
+                             "(default: %(default)s)")
+    parser.add_argument("--gpu-hang-detection",
+                        dest="gpu_hang_detection",
+                        action="store_true",
+                        help="Watch the GPU reset counters of the kernel. "
+                             "After a hang no test starts until the GPU has "
+                             "recovered, and the tests that were running "
+                             "are run again. The counters are set in the "
+                             "gpu-hang section of piglit.conf.")
+    parser.add_argument("--coverage-record",
+                        dest="coverage_record",
+                        action="store_true",
+                        help="Record which objects of a driver built with "
+                             "--coverage each test runs, in coverage.jsonl "
+                             "in the results directory. Needs process "
+                             "isolation.")
+    parser.add_argument("--coverage-from",
+                        dest="coverage_from",
+                        metavar="<Results Path>",
+                        help="Only run the tests that ran a file changed by "
+                             "--coverage-diff in this run recorded with "
+                             "--coverage-record, and a sample of the others.")
+    parser.add_argument("--coverage-diff",
+                        dest="coverage_diff",
+                        metavar="<Diff Path>",
+                        help="The diff of the driver for --coverage-from, "
+                             "'-' for the standard input.")
+    parser.add_argument("--coverage-sample",
+                        dest="coverage_sample",
+                        type=float,
+                        default=0.1,
+                        metavar="<fraction>",
+                        help="The fraction of the tests that didn't run the "
+                             "changed files that --coverage-from also runs. "
+                             "(default: %(default)s)")
+    parser.add_argument("--prioritize",
+                        dest="prioritize",
+                        metavar="<History Path>",
+                        help="Start the tests that failed or changed status "
+                             "in the last runs of this history first, and "
+                             "print each regression from it as soon as it "
+                             "is seen. Durations are taken from it too, "
+                             "unless --schedule-from is given.")
+    parser.add_argument("--max-regressions",
+                        dest="max_regressions",
+                        type=int,
+                        default=0,
+                        metavar="<int>",
+                        help="Stop the run once this many tests regressed "
+                             "from the --prioritize history. It can be "
+                             "resumed. (default: don't stop)")
+    parser.add_argument("--perf-baseline",
+                        dest="perf_baseline",
+                        metavar="<Results Path>",
+                        help="Compare the measurements of perf tests with "
+                             "those of this previous run, and fail the ones "
+                             "that got worse by more than --perf-threshold.")
+    parser.add_argument("--perf-threshold",
+                        dest="perf_threshold",
+                        type=float,
+                        default=0.05,
+                        metavar="<fraction>",
+                        help="The relative change of a perf test measurement "
+                             "that counts as a regression. Default: "
+                             "%(default)s")
+    parser.add_argument("--perf-config",
+                        dest="perf_configs",
+                        action="append",
+                        type=perf.perf_config,
+                        default=[],
+                        metavar="<name>[:<VAR>=<value>,...]",
+                        help="Run each perf test with these environment "
+                             "variables, and with those of the other "
+                             "--perf-config options, interleaved, and report "
+                             "the changes from the first configuration. For "
+                             "example --perf-config off:mesa_glthread=false "
+                             "--perf-config on:mesa_glthread=true.")
+    parser.add_argument("--perf-rounds",
+                        dest="perf_rounds",
+                        type=int,
+                        default=5,
+                        metavar="<count>",
+                        help="How many times to run each perf test under "
+                             "each --perf-config. Default: %(default)s")
+    parser.add_argument("--worker-processes",
+                        dest="worker_processes",
+                        action="store_true",
+                        help="Run concurrent tests from a pool of worker "
+                             "processes rather than threads. Not supported "
+                             "on Windows.")
+    parser.add_argument("--result-cache",
+                        dest="result_cache",
+                        action="store_const",
+                        const="on",
+                        default="off",
+                        help="Reuse the result of a previous run of a test "
+                             "when its command, input files, environment "
+                             "and the driver libraries haven't changed "
+                             "since, instead of running it again.")
+    parser.add_argument("--refresh-result-cache",
+                        dest="result_cache",
+                        action="store_const",
+                        const="refresh",
+                        help="Run every test and replace its result in the "
+                             "cache used by --result-cache.")
+    parser.add_argument("--shader-cache",
+                        dest="shader_cache",
+                        choices=shadercache.MODES,
+                        default="inherit",
+                        help="Run the tests with an empty disk shader cache "
+                             "kept in the results (cold), one restored "
+                             "from --shader-cache-dir into the results "
+                             "(seed), or the cache in --shader-cache-dir "
+                             "(shared), and report its hits and misses. "
+                             "By default the cache is left to the "
+                             "environment.")
+    parser.add_argument("--shader-cache-dir",
+                        dest="shader_cache_dir",
+                        metavar="<path>",
+                        type=path.abspath,
+                        help="The directory of the shared shader cache, or "
+                             "the directory or tar archive the seeded one "
+                             "is restored from.")
+    parser.add_argument("--retry-failures",
+                        dest="retries",
+                        type=int,
+                        default=0,
+                        metavar="<count>",
+                        help="Once every test has run, run the tests that "
+                             "failed or crashed again, up to this many times "
+                             "each or until they pass. The result of every "
+                             "attempt is kept. Default: %(default)s")
+    parser.add_argument("--output-limit",
+                        dest="output_limit",
+                        type=int,
+                        default=0,
+                        metavar="<bytes>",
+                        help="Only keep the first and last <bytes> of the "
+                             "stdout and stderr of each test in the results, "
+                             "along with the PIGLIT lines in between. The "
+                             "output is read as it comes, so the rest is "
+                             "never held in memory. Default: no limit")
+    parser.add_argument("--spill-output",
+                        dest="spill_output",
+                        action="store_true",
+                        help="With --output-limit, write the whole output of "
+                             "the tests that were cut to gzip files in the "
+                             "output directory of the results.")
+    parser.add_argument("--device",
+                        dest="devices",
+                        action="append",
+                        default=[],
+                        metavar="<device>",
+                        help="Spread the tests over this device and the "
+                             "others given with --device, each job running "
+                             "its tests on one of them. A device is the path "
+                             "of a DRM node, set as WAFFLE_GBM_DEVICE, or "
+                             "VAR=VALUE[,VAR=VALUE...] to set for the tests, "
+                             "such as DRI_PRIME=1. The results are tagged "
+                             "with the device they ran on.")
+    shard_parser = parser.add_mutually_exclusive_group()
+    shard_parser.add_argument("--shard-coordinator",
+                              dest="shard_coordinator",
+                              metavar="<[host:]port>",
+                              help="Don't run tests, hand them out to "
+                                   "--shard-worker instances and collect "
+                                   "their results")
+    shard_parser.add_argument("--shard-worker",
+                              dest="shard_worker",
+                              metavar="<url>",
+                              help="Run the tests handed out by the "
+                                   "--shard-coordinator at this URL. The "
+                                   "local results hold the tests run here")
 
     return parser.parse_args(unparsed)
 
@@ -261,6 +517,8 @@ def _create_metadata(args, name, forced_test_list):
     opts['forced_test_list'] = forced_test_list
     opts['ignore_missing'] = args.ignore_missing
     opts['timeout'] = args.timeout
+    opts['schedule_from'] = args.schedule_from
+    opts['worker_processes'] = args.worker_processes
 
     metadata = {'options': opts}
     metadata['name'] = name
@@ -309,11 +567,16 @@ def run(input_):
     base.Test.timeout = args.timeout
     _disable_windows_exception_messages()
 
-    # If dmesg is requested we must have serial run, this is because dmesg
-    # isn't reliable with threaded run
-    if args.dmesg or args.monitored:
+    # Most dmesg implementations can't tell which of the tests running at once
+    # logged a message, with those we must have serial run
+    dmesg_ = dmesg.get_dmesg(args.dmesg) if args.dmesg else None
+    if (dmesg_ and not dmesg_.concurrent) or args.monitored:
         args.concurrency = "none"
 
+    if args.worker_processes and sys.platform == 'win32':
+        raise exceptions.PiglitFatalError(
+            '--worker-processes is not supported on Windows')
+
     # Pass arguments into Options
     options.OPTIONS.execute = args.execute
     options.OPTIONS.valgrind = args.valgrind
@@ -323,9 +586,55 @@ def run(input_):
     options.OPTIONS.jobs = args.jobs
     options.OPTIONS.force_glsl = args.glsl
     options.OPTIONS.spirv = args.spirv
+    options.OPTIONS.shader_runner_server = args.shader_runner_server
+    options.OPTIONS.test_host = args.test_host
+    options.OPTIONS.fork_server = args.fork_server
+    options.OPTIONS.schedule_from = args.schedule_from
+    options.OPTIONS.process_loop = args.process_loop
+    options.OPTIONS.perf_baseline = args.perf_baseline
+    options.OPTIONS.perf_threshold = args.perf_threshold
+    options.OPTIONS.perf_configs = args.perf_configs
+    options.OPTIONS.perf_rounds = args.perf_rounds
+    options.OPTIONS.devices = args.devices
+    options.OPTIONS.result_cache = args.result_cache
+    options.OPTIONS.retries = args.retries
+    options.OPTIONS.output_limit = args.output_limit
+    if args.history:
+        options.OPTIONS.history = path.abspath(args.history)
+    if args.adaptive_timeout:
+        options.OPTIONS.adaptive_timeout = path.abspath(args.adaptive_timeout)
+    options.OPTIONS.adaptive_timeout_factor = args.adaptive_timeout_factor
+    options.OPTIONS.adaptive_timeout_floor = args.adaptive_timeout_floor
+    options.OPTIONS.adaptive_timeout_ceiling = args.adaptive_timeout_ceiling
+    options.OPTIONS.gpu_hang_detection = args.gpu_hang_detection
+    if args.coverage_record:
+        options.OPTIONS.coverage_record = path.abspath(args.results_path)
+    if args.prioritize:
+        options.OPTIONS.prioritize = path.abspath(args.prioritize)
+    elif args.max_regressions:
+        raise exceptions.PiglitFatalError(
+            '--max-regressions needs --prioritize')
+    options.OPTIONS.max_regressions = args.max_regressions
+    options.OPTIONS.glslparser_offline = args.glslparser_offline
+    options.OPTIONS.shader_cache = args.shader_cache
+    options.OPTIONS.shader_cache_dir = args.shader_cache_dir
+    if args.coverage_from:
+        if not args.coverage_diff:
+            raise exceptions.PiglitFatalError(
+                '--coverage-from needs --coverage-diff')
+        options.OPTIONS.coverage_from = path.abspath(args.coverage_from)
+        options.OPTIONS.coverage_changes = _read_changes(args.coverage_diff)
+        options.OPTIONS.coverage_sample = args.coverage_sample
+    if args.spill_output and args.output_limit:
+        options.OPTIONS.output_spill_dir = path.join(
+            path.abspath(args.results_path), 'output')
+    for device in args.devices:
+        profile.parse_device(device)
 
     # Set the platform to pass to waffle
     options.OPTIONS.env['PIGLIT_PLATFORM'] = args.platform
+    _set_spirv_cache()
+    _set_glslparser_offline()
 
     # Change working directory to the root of the piglit directory
     piglit_dir = path.dirname(path.realpath(sys.argv[0]))
@@ -341,6 +650,8 @@ def run(input_):
         raise exceptions.PiglitFatalError(
             'Cannot overwrite existing folder without the -o/--overwrite '
             'option being set.')
+    shader_cache = shadercache.setup(args.shader_cache, args.results_path,
+                                     args.shader_cache_dir)
 
     # If a test list is provided then set the forced_test_list value.
     forced_test_list = None
@@ -372,13 +683,15 @@ def run(input_):
         profiles[0].forced_test_list = forced_test_list
 
     # Set the dmesg type
-    if args.dmesg:
+    if dmesg_:
         for p in profiles:
-            p.options['dmesg'] = dmesg.get_dmesg(args.dmesg)
+            p.options['dmesg'] = dmesg_
 
     if args.monitored:
+        # One thread reads the sources for all of the profiles
+        monitor = monitoring.Monitoring(args.monitored)
         for p in profiles:
-            p.options['monitor'] = monitoring.Monitoring(args.monitored)
+            p.options['monitor'] = monitor
 
     if args.ignore_missing:
         for p in profiles:
@@ -390,16 +703,94 @@ def run(input_):
                                                  inverse=True))
         if args.include_tests:
             p.filters.append(profile.RegexFilter(args.include_tests))
-
-    profile.run(profiles, args.log_level, backend, args.concurrency, args.jobs)
+    _add_coverage_filter(profiles)
+
+    if args.shard_coordinator:
+        names = [n for p in profiles for n, _ in p.itertests()]
+        durations = profile.load_durations(
+            args.schedule_from or options.OPTIONS.prioritize)
+        if durations is not None:
+            names = [n for n, _ in profile.order_by_duration(
+                ((n, None) for n in names), durations)]
+        sharding.coordinate(names, backend, args.shard_coordinator,
+                            args.log_level)
+    elif args.shard_worker:
+        sharding.work(args.shard_worker, profiles, args.log_level,
+                      args.concurrency, args.jobs, backend)
+    else:
+        profile.run(profiles, args.log_level, backend, args.concurrency,
+                    args.jobs,
+                    durations=profile.load_durations(
+                        args.schedule_from or options.OPTIONS.prioritize),
+                    processes=args.worker_processes)
 
     time_elapsed.end = time.time()
     backend.finalize({'time_elapsed': time_elapsed.to_json()})
+    _report_shader_cache(args.results_path, shader_cache)
+    _add_to_history(args.results_path)
 
     print('Thank you for running Piglit!\n'
           'Results have been written to ' + args.results_path)
 
 
+def _set_spirv_cache():
+    """Use the SPIR-V precompiled by the build, unless a cache is set."""
+    if 'PIGLIT_SPIRV_CACHE' in os.environ:
+        return
+    cache = path.join(piglit_test.ROOT_DIR, 'tests', 'spirv')
+    if path.isdir(cache):
+        options.OPTIONS.env['PIGLIT_SPIRV_CACHE'] = cache
+
+
+def _set_glslparser_offline():
+    """Pass the compiler of --glslparser-offline to glslparsertest."""
+    if options.OPTIONS.glslparser_offline:
+        options.OPTIONS.env['PIGLIT_GLSLPARSER_OFFLINE'] = \
+            options.OPTIONS.glslparser_offline
+
+
+def _report_shader_cache(results_path, directory):
+    """Print and record the shader cache stats of a --shader-cache run."""
+    if directory is None:
+        return
+    shadercache.TOTALS.write(results_path, directory)
+    print(str(shadercache.TOTALS).capitalize())
+
+
+def _read_changes(diff_path):
+    """Return the files changed by the diff at diff_path, - for stdin."""
+    try:
+        if diff_path == '-':
+            return coverage.changed_files(sys.stdin.read())
+        with open(diff_path, 'r') as f:
+            return coverage.changed_files(f.read())
+    except OSError as e:
+        raise exceptions.PiglitFatalError(
+            'Cannot read the diff {}: {}'.format(diff_path, e))
+
+
+def _add_coverage_filter(profiles):
+    """Only run the tests of the changed files, with --coverage-from."""
+    if not options.OPTIONS.coverage_from:
+        return
+    filter_ = coverage.select(coverage.load(options.OPTIONS.coverage_from),
+                              options.OPTIONS.coverage_changes,
+                              options.OPTIONS.coverage_sample)
+    for p in profiles:
+        p.filters.append(filter_)
+
+
+def _add_to_history(results_path):
+    """Add the finished run at results_path to the --history, if any."""
+    if not options.OPTIONS.history:
+        return
+    try:
+        history.append(options.OPTIONS.history, results_path)
+    except (sqlite3.Error, OSError) as e:
+        print('Warning: Not added to the history {}: {}'.format(
+            options.OPTIONS.history, e), file=sys.stderr)
+
+
 @exceptions.handler
 def resume(input_):
     unparsed = parsers.parse_config(input_)[1]
@@ -429,7 +820,10 @@ def resume(input_):
     args = parser.parse_args(unparsed)
     _disable_windows_exception_messages()
 
-    results = backends.load(args.results_path)
+    # Don't re-run tests that have already completed, incomplete status tests
+    # have obviously not completed.
+    results, exclude_tests = backends.json.resume_state(args.results_path,
+                                                        args.no_retry)
     options.OPTIONS.execute = results.options['execute']
     options.OPTIONS.valgrind = results.options['valgrind']
     options.OPTIONS.sync = results.options['sync']
@@ -439,10 +833,55 @@ def resume(input_):
     options.OPTIONS.no_retry = args.no_retry
     options.OPTIONS.force_glsl = results.options['force_glsl']
     options.OPTIONS.spirv = results.options['spirv']
+    options.OPTIONS.shader_runner_server = results.options.get(
+        'shader_runner_server', False)
+    options.OPTIONS.test_host = results.options.get('test_host', False)
+    options.OPTIONS.fork_server = results.options.get('fork_server', False)
+    options.OPTIONS.schedule_from = results.options.get('schedule_from')
+    options.OPTIONS.process_loop = results.options.get('process_loop', False)
+    options.OPTIONS.perf_baseline = results.options.get('perf_baseline')
+    options.OPTIONS.perf_threshold = results.options.get('perf_threshold',
+                                                         0.05)
+    options.OPTIONS.perf_configs = results.options.get('perf_configs', [])
+    options.OPTIONS.perf_rounds = results.options.get('perf_rounds', 5)
+    options.OPTIONS.devices = results.options.get('devices', [])
+    options.OPTIONS.result_cache = results.options.get('result_cache', 'off')
+    options.OPTIONS.retries = results.options.get('retries', 0)
+    options.OPTIONS.output_limit = results.options.get('output_limit', 0)
+    options.OPTIONS.output_spill_dir = results.options.get('output_spill_dir')
+    options.OPTIONS.history = results.options.get('history')
+    options.OPTIONS.adaptive_timeout = results.options.get('adaptive_timeout')
+    options.OPTIONS.adaptive_timeout_factor = results.options.get(
+        'adaptive_timeout_factor', 10.0)
+    options.OPTIONS.adaptive_timeout_floor = results.options.get(
+        'adaptive_timeout_floor', 5.0)
+    options.OPTIONS.adaptive_timeout_ceiling = results.options.get(
+        'adaptive_timeout_ceiling', 600.0)
+    options.OPTIONS.gpu_hang_detection = results.options.get(
+        'gpu_hang_detection', False)
+    options.OPTIONS.coverage_record = results.options.get('coverage_record')
+    options.OPTIONS.coverage_from = results.options.get('coverage_from')
+    options.OPTIONS.coverage_changes = results.options.get(
+        'coverage_changes', [])
+    options.OPTIONS.coverage_sample = results.options.get(
+        'coverage_sample', 0.1)
+    options.OPTIONS.prioritize = results.options.get('prioritize')
+    options.OPTIONS.max_regressions = results.options.get('max_regressions',
+                                                          0)
+    options.OPTIONS.glslparser_offline = results.options.get(
+        'glslparser_offline')
+    options.OPTIONS.shader_cache = results.options.get('shader_cache',
+                                                       'inherit')
+    options.OPTIONS.shader_cache_dir = results.options.get('shader_cache_dir')
 
     core.get_config(args.config_file)
 
     options.OPTIONS.env['PIGLIT_PLATFORM'] = results.options['platform']
+    _set_spirv_cache()
+    _set_glslparser_offline()
+    shader_cache = shadercache.setup(
+        options.OPTIONS.shader_cache, args.results_path,
+        options.OPTIONS.shader_cache_dir, resume=True)
     base.Test.timeout = results.options['timeout']
 
     results.options['env'] = core.collect_system_info()
@@ -451,15 +890,12 @@ def resume(input_):
     # Resume only works with the JSON backend
     backend = backends.get_backend('json')(
         args.results_path,
-        file_start_count=len(results.tests) + 1)
+        file_start_count=len(exclude_tests) + 1)
     # Specifically do not initialize again, everything initialize does is done.
 
-    # Don't re-run tests that have already completed, incomplete status tests
-    # have obviously not completed.
-    exclude_tests = set()
-    for name, result in results.tests.items():
-        if args.no_retry or result.result != 'incomplete':
-            exclude_tests.add(name)
+    monitor = None
+    if results.options['monitoring']:
+        monitor = monitoring.Monitoring(results.options['monitoring'])
 
     profiles = [profile.load_test_profile(p)
                 for p in results.options['profile']]
@@ -469,9 +905,8 @@ def resume(input_):
         if results.options['dmesg']:
             p.dmesg = dmesg.get_dmesg(results.options['dmesg'])
 
-        if results.options['monitoring']:
-            p.options['monitor'] = monitoring.Monitoring(
-                results.options['monitoring'])
+        if monitor:
+            p.options['monitor'] = monitor
 
         if results.options['ignore_missing']:
             p.options['ignore_missing'] = results.options['ignore_missing']
@@ -488,6 +923,7 @@ def resume(input_):
 
         if results.options['forced_test_list']:
             p.forced_test_list = results.options['forced_test_list']
+    _add_coverage_filter(profiles)
 
     # This is resumed, don't bother with time since it won't be accurate anyway
     try:
@@ -496,12 +932,18 @@ def resume(input_):
             results.options['log_level'],
             backend,
             results.options['concurrent'],
-            args.jobs)
+            args.jobs,
+            durations=profile.load_durations(
+                results.options.get('schedule_from') or
+                results.options.get('prioritize')),
+            processes=results.options.get('worker_processes', False))
     except exceptions.PiglitUserError as e:
         if str(e) != 'no matching tests':
             raise
 
     backend.finalize()
+    _report_shader_cache(args.results_path, shader_cache)
+    _add_to_history(args.results_path)
 
     print("Thank you for running Piglit!\n"
           "Results have been written to {0}".format(args.results_path))
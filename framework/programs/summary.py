@@ -26,17 +26,20 @@ import os
 import os.path as path
 import sys
 import errno
+import time
 
-from framework import summary, status, core, backends, exceptions
+from framework import summary, status, core, backends, exceptions, history
 from . import parsers
 
 __all__ = [
     'aggregate',
     'console',
+    'merge',
     'csv',
     'html',
-    'feature'
-    'formatted'
+    'feature',
+    'formatted',
+    'history_',
 ]
 
 DEFAULT_FMT_STR="{name} ::: {time} ::: {returncode} ::: {result}"
@@ -70,6 +73,24 @@ def html(input_):
                              "given as arguments. This speeds up HTML "
                              "generation, but reduces the info in the HTML "
                              "pages. May be used multiple times")
+    parser.add_argument("-i", "--incremental",
+                        action="store_true",
+                        help="Only write the pages of tests whose result "
+                             "changed since the last summary written to the "
+                             "same directory")
+    parser.add_argument("-j", "--jobs",
+                        action="store",
+                        type=int,
+                        default=core.PIGLIT_CONFIG.safe_get(
+                            'core', 'jobs', None),
+                        help="Set the number of processes writing pages. "
+                             "By default, the reported number of CPUs is used.")
+    parser.add_argument("-c", "--client-side",
+                        action="store_true",
+                        help="Write a single page that renders the summary "
+                             "in the browser from a few data files, instead "
+                             "of a page per test. The details of a test are "
+                             "only loaded when it is opened")
     parser.add_argument("summaryDir",
                         metavar="<Summary Directory>",
                         help="Directory to put HTML files in")
@@ -112,7 +133,8 @@ def html(input_):
         args.resultsFiles.extend(core.parse_listfile(args.list))
 
     # Create the HTML output
-    summary.html(args.resultsFiles, args.summaryDir, args.exclude_details)
+    summary.html(args.resultsFiles, args.summaryDir, args.exclude_details,
+                 args.jobs, args.incremental, args.client_side)
 
 
 @exceptions.handler
@@ -158,6 +180,35 @@ def console(input_):
                            const="regressions",
                            dest='mode',
                            help="Only display tests that regressed.")
+    excGroup1.add_argument("-P", "--perf",
+                           action="store_const",
+                           const="perf",
+                           dest='mode',
+                           help="Only display the measurements of perf "
+                                "tests, with their change from the first "
+                                "results file.")
+    excGroup1.add_argument("-R", "--resources",
+                           action="store_const",
+                           const="resources",
+                           dest='mode',
+                           help="Only display the CPU time, memory, context "
+                                "switches and GPU time of each test.")
+    excGroup1.add_argument("-T", "--time",
+                           action="store_const",
+                           const="time",
+                           dest='mode',
+                           help="Only display where the time went: the "
+                                "slowest tests, subtests and groups, "
+                                "histograms of the durations of the tests "
+                                "of those groups, and the time of the tests "
+                                "that timed out or crashed, with their "
+                                "change from the first results file.")
+    parser.add_argument("-n", "--top",
+                        type=int,
+                        default=20,
+                        metavar="<int>",
+                        help="How many of the slowest tests, subtests and "
+                             "groups --time lists. Default: 20")
     parser.add_argument("-l", "--list",
                         action="store",
                         help="Use test results from a list file")
@@ -179,7 +230,7 @@ def console(input_):
         args.results.extend(core.parse_listfile(args.list))
 
     # Generate the output
-    summary.console(args.results, args.mode or 'all')
+    summary.console(args.results, args.mode or 'all', args.top)
 
 
 @exceptions.handler
@@ -285,6 +336,83 @@ def aggregate(input_):
     print("Aggregated file written to: {}{}".format(outfile, comp_ext))
 
 
+@exceptions.handler
+def merge(input_):
+    """Merge several results files into one, a test at a time."""
+    unparsed = parsers.parse_config(input_)[1]
+
+    parser = argparse.ArgumentParser(parents=[parsers.CONFIG])
+    parser.add_argument('-o', '--output',
+                        required=True,
+                        help="Name of the merged results file, the "
+                             "compression suffix is added to it")
+    parser.add_argument('-p', '--policy',
+                        choices=list(backends.merge.POLICIES),
+                        default='worst',
+                        help="Which result to keep for a test that is in "
+                             "more than one of the results: the worst or "
+                             "best status, the one from the first or last "
+                             "results given, or error out. "
+                             "Default: worst")
+    parser.add_argument('-n', '--name',
+                        help="Name of the merged run. "
+                             "Default: the name of the first results")
+    parser.add_argument('results',
+                        metavar="<Results Path(s)>",
+                        nargs='+',
+                        help="Results files or directories to merge")
+    args = parser.parse_args(unparsed)
+
+    written = backends.merge.merge(args.results, args.output, args.policy,
+                                   args.name)
+    print("Merged file written to: {}".format(written))
+
+
+@exceptions.handler
+def history_(input_):
+    """Add results to a history, and show the history of tests."""
+    unparsed = parsers.parse_config(input_)[1]
+
+    parser = argparse.ArgumentParser(parents=[parsers.CONFIG])
+    parser.add_argument('-a', '--add',
+                        action='append',
+                        default=[],
+                        metavar='<Results Path>',
+                        help="Add these results to the history first. May "
+                             "be used multiple times")
+    parser.add_argument('history',
+                        metavar='<History Path>',
+                        help="The history database")
+    parser.add_argument('tests',
+                        metavar='<Test>',
+                        nargs='*',
+                        help="Print when the status of these tests changed, "
+                             "and percentiles of their duration")
+    args = parser.parse_args(unparsed)
+
+    with history.History(args.history) as store:
+        for results in args.add:
+            store.add(backends.load(results), results)
+
+        if not args.tests:
+            print('{} runs'.format(len(store.runs())))
+
+        for test in args.tests:
+            print(test)
+            changes = store.transitions(test)
+            if not changes:
+                print('    no results')
+                continue
+            for name, start, previous, current in changes:
+                print('    {}: {} -> {} ({})'.format(
+                    time.strftime('%Y-%m-%d %H:%M', time.localtime(start)),
+                    previous or 'new', current, name))
+            durations = store.durations(test)
+            print('    duration: {}'.format(', '.join(
+                'p{:g} {:.3f}s'.format(f * 100, d)
+                for f, d in sorted(durations.items()) if d is not None)))
+
+
 @exceptions.handler
 def feature(input_):
     parser = argparse.ArgumentParser()
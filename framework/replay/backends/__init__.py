@@ -57,6 +57,7 @@ __all__ = [
     'DumpBackendError',
     'DumpBackendNotImplementedError',
     'dump',
+    'profile',
 ]
 
 
@@ -91,14 +92,7 @@ def _register():
 DUMPBACKENDS = _register()
 
 
-def dump(trace_path, output_dir=None, calls=None):
-    """Wrapper for dumping traces.
-
-    This function will attempt to determine how to dump the trace file (based
-    on file extension), and then pass the trace file path, output_dir and calls
-    into the appropriate instance, and then call dump in such instance.
-
-    """
+def _backend(trace_path):
     name, extension = path.splitext(trace_path)
 
     for dump_backend in DUMPBACKENDS.values():
@@ -109,8 +103,31 @@ def dump(trace_path, output_dir=None, calls=None):
                 raise DumpBackendNotImplementedError(
                     'DumpBackend for "{}" is not implemented'.format(extension))
 
-            instance = backend(trace_path, output_dir, calls)
-            return instance.dump()
+            return backend
 
     raise DumpBackendError(
         'No module supports file extensions "{}"'.format(extension))
+
+
+def dump(trace_path, output_dir=None, calls=None, **kwargs):
+    """Wrapper for dumping traces.
+
+    This function will attempt to determine how to dump the trace file (based
+    on file extension), and then pass the trace file path, output_dir, calls
+    and any keyword arguments into the appropriate instance, and then call
+    dump in such instance.
+
+    """
+    instance = _backend(trace_path)(trace_path, output_dir, calls, **kwargs)
+    return instance.dump()
+
+
+def profile(trace_path, **kwargs):
+    """Wrapper for profiling traces.
+
+    Like dump, this picks the backend from the file extension, and then calls
+    profile in an instance of it, which replays the trace once and returns its
+    frame times in nanoseconds.
+
+    """
+    return _backend(trace_path)(trace_path, **kwargs).profile()
@@ -39,6 +39,8 @@ from os import path
 from framework import core
 from framework.replay.options import OPTIONS
 
+from . import DumpBackendNotImplementedError
+
 
 class DumpBackend(metaclass=abc.ABCMeta):
     """ Base class for dump backends
@@ -66,10 +68,18 @@ class DumpBackend(metaclass=abc.ABCMeta):
         calls      -- an array of the calls in the trace for which we want to
                       dump images.
 
+        Keyword arguments that apply to all backends:
+
+        raw_images -- if True, backends which capture uncompressed images may
+                      leave them as they are instead of encoding them to PNG.
+                      The images are named like the PNGs would be, with
+                      their own extension.
+
         """
         self._trace_path = trace_path
         self._output_dir = output_dir
         self._calls = calls or []
+        self._raw_images = kwargs.get('raw_images', False)
 
         if self._output_dir is None:
             self._output_dir = path.join('trace', OPTIONS.device_name,
@@ -100,6 +110,22 @@ class DumpBackend(metaclass=abc.ABCMeta):
                 '[dump_trace_images] Process failed with error code: {}'.format(
                     ret.returncode))
 
+    @staticmethod
+    def _run_profile_command(cmd, env):
+        ret = subprocess.run(cmd, stdout=subprocess.PIPE,
+                             stderr=subprocess.PIPE, env=env)
+        print(f"[profile_trace] Running: {' '.join(cmd)}\n")
+        if ret.returncode:
+            # Print the command logs if the process returns with an error code.
+            stdout = ret.stdout.decode(errors="replace")
+            print(f"[profile_trace] {stdout}")
+            stderr = ret.stderr.decode(errors="replace")
+            print(f"[profile_trace] {stderr}")
+            raise RuntimeError(
+                f'[profile_trace] Process failed with error code: {ret.returncode}'
+            )
+        return ret
+
     @abc.abstractmethod
     def _get_last_frame_call(self):
         """Get the number of the last frame call from the trace"""
@@ -112,6 +138,17 @@ class DumpBackend(metaclass=abc.ABCMeta):
 
         """
 
+    def profile(self):
+        """ Replay the trace once and return its frame times
+
+        The frame times are in nanoseconds. Backends which can only measure
+        the whole replay return a single frame time, its mean.
+
+        """
+        raise DumpBackendNotImplementedError(
+            '{} can not profile "{}"'.format(type(self).__name__,
+                                             self._trace_path))
+
 
 def dump_handler(func):
     """ Decorator function for handling trace dumps.
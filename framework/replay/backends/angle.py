@@ -6,11 +6,13 @@
 
 """ Module providing an ANGLE dump backend for replayer """
 
+import re
 from os import chdir, path, rename
 from typing import List, Union
 
 from framework import core, exceptions
 
+from . import DumpBackendError
 from .abstract import DumpBackend, dump_handler
 from .register import Registry
 
@@ -19,6 +21,10 @@ __all__ = [
     'ANGLETraceBackend',
 ]
 
+# The mean frame time of each trial, printed by angle_trace_tests like
+# "*RESULT TraceTest.wall_time: angle_vulkan_trex_200= 1.234 ms"
+_WALL_TIME_RE = re.compile(r'wall_time:[^=]*=\s*([0-9.]+)\s*ms')
+
 
 class ANGLETraceBackend(DumpBackend):
     """ replayer's ANGLE dump backend
@@ -43,12 +49,15 @@ class ANGLETraceBackend(DumpBackend):
                 f'Invalid trace_path: "{self._trace_path}" tried to be dumped '
                 'by the ANGLETraceBackend.\n')
 
+    def _test_name(self) -> str:
+        # we start from library, including path and we need only the test name here
+        lib_name: str = self._trace_path.split("libangle_restricted_traces_")[1]
+        return lib_name[:-3]
+
     @dump_handler
     def dump(self):
         '''dumps screenshots'''
-        # we start from library, including path and we need only the test name here
-        lib_name: str = self._trace_path.split("libangle_restricted_traces_")[1]
-        test_name: str = lib_name[:-3]
+        test_name: str = self._test_name()
 
         # change working directory into where .so is placed
         angle_path: str = path.dirname(self._trace_path)
@@ -65,6 +74,22 @@ class ANGLETraceBackend(DumpBackend):
         piglit_screenshot: str = f'{path.join(self._output_dir, path.basename(self._trace_path))}-.png'
         rename(angle_screenshot, piglit_screenshot)
 
+    def profile(self) -> List[int]:
+        '''returns the mean frame time of each trial'''
+        test_name: str = self._test_name()
+        chdir(path.dirname(self._trace_path))
+
+        cmd = self._retrace_cmd + ['--gtest_filter=TraceTest.' + test_name,
+                                   '--use-angle=vulkan']
+        ret = self._run_profile_command(cmd, None)
+        wall_times: List[str] = _WALL_TIME_RE.findall(
+            ret.stdout.decode(errors='replace'))
+        if not wall_times:
+            raise DumpBackendError(
+                f'[profile_trace] angle_trace_tests reported no frame times '
+                f'for {self._trace_path}')
+        return [round(float(t) * 1e6) for t in wall_times]
+
 
 REGISTRY = Registry(
     extensions=['.so'],
@@ -67,24 +67,6 @@ def _collect_frame_times(stream):
     return frame_times[-int(_LOOP_TIMES):]
 
 
-def _run_command(cmd: str, env: dict) -> subprocess.CompletedProcess:
-    ret: subprocess.CompletedProcess = subprocess.run(
-        cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, env=env
-    )
-    logoutput = f"[profile_trace] Running: {' '.join(cmd)}\n".encode()
-    print(logoutput.decode(errors='replace'))
-    if ret.returncode:
-        # Print the command logs if the process returns with an error code.
-        stdout = ret.stdout.decode(errors="replace")
-        print(f"[profile_trace] {stdout}")
-        stderr = ret.stderr.decode(errors="replace")
-        print(f"[profile_trace] {stderr}")
-        raise RuntimeError(
-            f'[profile_trace] Process failed with error code: {ret.returncode}'
-        )
-    return ret
-
-
 class APITraceBackend(DumpBackend):
     """ replayer's apitrace dump backend
 
@@ -159,11 +141,7 @@ class APITraceBackend(DumpBackend):
                                    self._trace_path]
         self._run_logged_command(cmd, None)
 
-    @staticmethod
-    def profile(trace_path):
-        return APITraceBackend(trace_path)._profile()
-
-    def _profile(self):
+    def profile(self):
         # We need to run in singlethread mode to avoid a use after free bug
         # in which the OpenGL context is queried for further results after
         # it has been destroyed in the replay thread when replay finishes
@@ -174,7 +152,7 @@ class APITraceBackend(DumpBackend):
                                    '--pframes',
                                    'opengl:GPU Duration',
                                    self._trace_path]
-        ret = _run_command(cmd, None)
+        ret = self._run_profile_command(cmd, None)
         return _collect_frame_times(ret.stdout.decode().splitlines())
 
 
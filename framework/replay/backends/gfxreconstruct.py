@@ -52,6 +52,10 @@ _VERSION_RE = re.compile(r'\s*GFXReconstruct Version\s*([0-9]\.[0-9]\.[0-9])')
 
 _TOTAL_FRAMES_RE = re.compile(r'\s*Total frames:\s*([0-9]*)')
 
+# The summary printed by gfxrecon-replay at the end of a replay, like
+# "35.650065 fps, 0.280504 seconds, 10 frames, 1 loop, framerange 1-10"
+_MEASUREMENT_RE = re.compile(r'fps,\s*([0-9.]+) seconds,\s*([0-9]+) frames')
+
 
 class GFXReconstructBackend(DumpBackend):
     """ replayer's GFXReconstruct dump backend
@@ -108,23 +112,27 @@ class GFXReconstructBackend(DumpBackend):
                 'is {}. Try to update, at least to the {} version.'.format(
                     current, _MIN_VERSION))
 
-    @dump_handler
-    def dump(self):
-        from PIL import Image
-        outputprefix = path.join(self._output_dir,
-                                 path.basename(self._trace_path))
+    def _gfxrecon_replay_cmd(self):
         gfxrecon_replay_bin = core.get_option(
             'PIGLIT_REPLAY_GFXRECON_REPLAY_BINARY',
             ('replay', 'gfxrecon-replay_bin'),
             default='gfxrecon-replay')
         self._check_version(gfxrecon_replay_bin)
-        if not self._calls:
-            self._calls = [str(self._get_last_frame_call())]
         gfxrecon_replay_extra_args = core.get_option(
             'PIGLIT_REPLAY_GFXRECON_REPLAY_EXTRA_ARGS',
             ('replay', 'gfxrecon-replay_extra_args'),
             default='').split()
-        cmd = ([gfxrecon_replay_bin] + gfxrecon_replay_extra_args +
+        return [gfxrecon_replay_bin] + gfxrecon_replay_extra_args
+
+    @dump_handler
+    def dump(self):
+        from PIL import Image
+        outputprefix = path.join(self._output_dir,
+                                 path.basename(self._trace_path))
+        replay_cmd = self._gfxrecon_replay_cmd()
+        if not self._calls:
+            self._calls = [str(self._get_last_frame_call())]
+        cmd = (replay_cmd +
                ['--screenshots', ','.join(self._calls),
                 '--screenshot-dir', self._output_dir,
                 self._trace_path])
@@ -133,11 +141,37 @@ class GFXReconstructBackend(DumpBackend):
             bmp = '{}_frame_{}.bmp'.format(path.join(self._output_dir,
                                                      'screenshot'),
                                            c)
+            if self._raw_images:
+                os.replace(bmp, '{}-{}.bmp'.format(outputprefix, c))
+                continue
             outputfile = '{}-{}.png'.format(outputprefix, c)
             print('Writing: {} to {}'.format(bmp, outputfile))
             Image.open(bmp).save(outputfile)
             os.remove(bmp)
 
+    def profile(self):
+        # gfxrecon-replay only reports the duration of the whole measurement
+        # range, so this returns its mean frame time. The first frame, which
+        # mostly loads resources, is left out of the range.
+        replay_cmd = self._gfxrecon_replay_cmd()
+        last_frame = self._get_last_frame_call()
+        if last_frame < 2:
+            raise DumpBackendError(
+                '[profile_trace] Unable to get the frames of {}'.format(
+                    self._trace_path))
+        cmd = (replay_cmd +
+               ['--measurement-frame-range', '1-{}'.format(last_frame),
+                self._trace_path])
+        ret = self._run_profile_command(cmd, None)
+        measurement = _MEASUREMENT_RE.search(
+            ret.stdout.decode(errors='replace'))
+        if not measurement or not int(measurement.group(2)):
+            raise DumpBackendError(
+                '[profile_trace] gfxrecon-replay reported no frame times '
+                'for {}'.format(self._trace_path))
+        seconds, frames = measurement.groups()
+        return [round(float(seconds) * 1e9 / int(frames))]
+
 
 REGISTRY = Registry(
     extensions=['.gfxr'],
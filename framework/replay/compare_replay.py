@@ -23,9 +23,14 @@
 #
 # SPDX-License-Identifier: MIT
 
+import collections
+import contextlib
+import io
 import json  # type: ignore
+import multiprocessing
 import os
 import shutil
+from concurrent.futures import ProcessPoolExecutor
 from glob import glob
 from os import path
 
@@ -40,9 +45,32 @@ __all__ = ['from_yaml',
            'trace']
 
 
+# The extensions of the images the backends dump, PNG and the uncompressed
+# ones left with raw_images
+_IMAGE_EXTENSIONS = ['.png', '.bmp']
+
+# The variables selecting the GPU of a job for Mesa's GL and Vulkan drivers
+_GPU_VARIABLES = ['DRI_PRIME', 'MESA_VK_DEVICE_SELECT']
+
+
+def _encode_png(image_file):
+    """Return the PNG of image_file, encoding it if it is uncompressed."""
+    root, ext = path.splitext(image_file)
+    if ext == '.png':
+        return image_file
+
+    from PIL import Image
+    png = root + '.png'
+    with Image.open(image_file) as image:
+        image.save(png)
+    os.remove(image_file)
+    return png
+
+
 def _replay(trace_path, results_path):
     try:
-        success = backends.dump(trace_path, results_path, [])
+        # The image is only encoded to PNG when it is kept
+        success = backends.dump(trace_path, results_path, [], raw_images=True)
     except (backends.DumpBackendNotImplementedError,
             backends.DumpBackendError) as e:
         print(e)
@@ -54,7 +82,8 @@ def _replay(trace_path, results_path):
         return None, None
     else:
         file_name = path.basename(trace_path)
-        files = glob(path.join(results_path, file_name + '-*' + '.png'))
+        files = [f for ext in _IMAGE_EXTENSIONS
+                 for f in glob(path.join(results_path, file_name + '-*' + ext))]
         if not files:
             print('[check_image] No dumped files found '
                   'in the results path "{}". '
@@ -107,6 +136,7 @@ def _check_trace(trace_path, expected_checksum):
         result = status.FAIL
 
     if result is not status.PASS or OPTIONS.keep_image:
+        image_file = _encode_png(image_file)
         root, ext = path.splitext(image_file)
         image_file_dest = '{}-{}{}'.format(root, checksum, ext)
         shutil.move(image_file, image_file_dest)
@@ -123,6 +153,83 @@ def _print_result(result, trace_path, json_result):
     print(output)
 
 
+def _init_job(options, gpus, gpu_counter):
+    """Set up a worker process of _check_traces_in_jobs.
+
+    The options are passed as the workers aren't necessarily forked from
+    the process that set them. Each worker keeps the next of the GPUs.
+    """
+    for key, value in options.items():
+        setattr(OPTIONS, key, value)
+
+    if gpus:
+        with gpu_counter.get_lock():
+            gpu = gpus[gpu_counter.value % len(gpus)]
+            gpu_counter.value += 1
+        for variable in _GPU_VARIABLES:
+            os.environ[variable] = gpu
+
+
+def _download_job(trace_path):
+    """Download a trace, returning what was printed."""
+    output = io.StringIO()
+    with contextlib.redirect_stdout(output):
+        ensure_file(trace_path)
+    return output.getvalue()
+
+
+def _check_trace_job(trace_path, expected_checksum):
+    """Check a trace, returning the name of the result and what was printed.
+
+    The name is returned as the status objects don't keep their identity
+    through pickling.
+    """
+    output = io.StringIO()
+    with contextlib.redirect_stdout(output):
+        result, _ = _check_trace(trace_path, expected_checksum)
+    return str(result), output.getvalue()
+
+
+def _print_job(download_output, check):
+    result, output = check.result()
+    print(download_output + output, end='', flush=True)
+    return status.status_lookup(result)
+
+
+def _check_traces_in_jobs(traces):
+    """Check the traces on OPTIONS.jobs worker processes, returning the results.
+
+    The traces are all downloaded as soon as possible on as many other
+    workers, and each is replayed once it's downloaded. What they print is
+    printed in the order of traces, like when they are checked one after
+    the other.
+    """
+    options = dict(OPTIONS)
+    gpu_counter = multiprocessing.Value('i', 0)
+    results = []
+
+    with ProcessPoolExecutor(OPTIONS.jobs, initializer=_init_job,
+                             initargs=(options, [], None)) as downloads, \
+            ProcessPoolExecutor(OPTIONS.jobs, initializer=_init_job,
+                                initargs=(options, OPTIONS.gpus,
+                                          gpu_counter)) as replays:
+        fetched = [downloads.submit(_download_job, t['path'])
+                   for t in traces]
+
+        pending = collections.deque()
+        for t, download in zip(traces, fetched):
+            pending.append((download.result(),
+                            replays.submit(_check_trace_job, t['path'],
+                                           t['checksum'])))
+            while pending and pending[0][1].done():
+                results.append(_print_job(*pending.popleft()))
+
+        while pending:
+            results.append(_print_job(*pending.popleft()))
+
+    return results
+
+
 def from_yaml(yaml_file):
     y = qty.load_yaml(yaml_file)
 
@@ -131,9 +238,14 @@ def from_yaml(yaml_file):
     global_result = status.PASS
     # TODO: print in subtest format
     # json_results = {}
-    t_list = qty.traces(y, device_name=OPTIONS.device_name, checksum=True)
-    for t in t_list:
-        result, json_result = _check_trace(t['path'], t['checksum'])
+    t_list = list(qty.traces(y, device_name=OPTIONS.device_name,
+                             checksum=True))
+    if OPTIONS.jobs > 1 and len(t_list) > 1:
+        results = _check_traces_in_jobs(t_list)
+    else:
+        results = (_check_trace(t['path'], t['checksum'])[0]
+                   for t in t_list)
+    for result in results:
         if result is not status.PASS and global_result is not status.CRASH:
             global_result = result
         # json_results.update(json_result)
@@ -26,11 +26,16 @@
 import base64
 import hashlib
 import hmac
+import json
+import os
+import tempfile
+import threading
 import xml.etree.ElementTree as ET
+from concurrent.futures import ThreadPoolExecutor
 from email.utils import formatdate
 from os import path, remove
 from pathlib import Path
-from typing import Any, Dict, List, Optional
+from typing import Any, Callable, Dict, Iterable, List, Optional
 
 import requests
 from requests.adapters import HTTPAdapter, Retry
@@ -40,10 +45,12 @@ from requests.utils import requote_uri
 from framework import core, exceptions
 from framework.replay.local_file_adapter import LocalFileAdapter
 from framework.replay.options import OPTIONS
+from framework.replay.trace_cache import TraceCache
 
-__all__ = ['ensure_file']
+__all__ = ['ensure_file', 'Prefetcher']
 
 minio_credentials = None
+_minio_credentials_lock = threading.Lock()
 
 
 def sign_with_hmac(key, message):
@@ -56,6 +63,12 @@ def sign_with_hmac(key, message):
 
 
 def get_minio_credentials(url):
+    # Files may be downloaded from several threads
+    with _minio_credentials_lock:
+        return _get_minio_credentials(url)
+
+
+def _get_minio_credentials(url):
     global minio_credentials
 
     if minio_credentials is not None:
@@ -232,12 +245,14 @@ def chase_redirects(session: requests.Session, request: requests.PreparedRequest
 
 
 @core.timer_ms
-def download(url: str, file_path: str, headers: Dict[str, str], attempts: int = 2) -> None:
+def download(url: str, file_path: str, headers: Dict[str, str], attempts: int = 2) -> Any:
     """Downloads a URL content into a file
 
     :param url: URL to download
     :param file_path: Local file name to contain the data downloaded
     :param attempts: Number of attempts
+
+    :return: The headers of the response
     """
     retries = Retry(
         backoff_factor=20,
@@ -264,18 +279,75 @@ def download(url: str, file_path: str, headers: Dict[str, str], attempts: int =
         # chunk_size must be equal to s3cp upload chunk for md5 digest to match
         chunk_size = chunk_size_from_headers(response.headers)
 
-        with open(file_path, "wb") as file:
-            for chunk in response.iter_content(chunk_size=chunk_size):
-                if chunk:
-                    file.write(chunk)
-                    md5.update(chunk)
-                    md5_digests.append(hashlib.md5(chunk).digest())
-            local_file_checksums = [
-                    hashlib.md5(b''.join(md5_digests)).hexdigest() + '-' + str(len(md5_digests)),
-                    md5.hexdigest()
-            ]
+        # Download next to the file and move it in place once verified, so
+        # that a file being downloaded by another process is never seen
+        # half written.
+        fd, part_path = tempfile.mkstemp(
+            dir=path.dirname(file_path) or None,
+            prefix=path.basename(file_path) + '.', suffix='.part')
+        try:
+            with os.fdopen(fd, "wb") as file:
+                for chunk in response.iter_content(chunk_size=chunk_size):
+                    if chunk:
+                        file.write(chunk)
+                        md5.update(chunk)
+                        md5_digests.append(hashlib.md5(chunk).digest())
+                local_file_checksums = [
+                        hashlib.md5(b''.join(md5_digests)).hexdigest() + '-' + str(len(md5_digests)),
+                        md5.hexdigest()
+                ]
+
+            verify_file_integrity(part_path, response.headers, local_file_checksums)
+            os.replace(part_path, file_path)
+        finally:
+            if path.exists(part_path):
+                remove(part_path)
+
+    write_verified_checksum(file_path, response.headers)
+    return response.headers
 
-    verify_file_integrity(file_path, response.headers, local_file_checksums)
+
+def _verified_checksum_path(file_path: str) -> str:
+    return str(file_path) + '.verified'
+
+
+def write_verified_checksum(file_path: str, headers: Any) -> None:
+    """Record that file_path matches the ETag in headers.
+
+    The checksums are computed while downloading, so this spares reading
+    the whole file again to verify it before the next use.
+    """
+    etag = headers.get("etag", "").strip('\"').lower()
+    if not etag:
+        return
+
+    stat = os.stat(file_path)
+    with open(_verified_checksum_path(file_path), 'w') as f:
+        json.dump({'etag': etag,
+                   'size': stat.st_size,
+                   'mtime_ns': stat.st_mtime_ns}, f)
+
+
+def is_verified(file_path: str, headers: Any) -> bool:
+    """Whether file_path was verified against the ETag in headers.
+
+    This holds as long as the file keeps the size and modification time it
+    had when it was verified.
+    """
+    etag = headers.get("etag", "").strip('\"').lower()
+    if not etag:
+        return False
+
+    try:
+        with open(_verified_checksum_path(file_path), 'r') as f:
+            verified = json.load(f)
+        stat = os.stat(file_path)
+    except (OSError, ValueError):
+        return False
+
+    return (verified.get('etag') == etag and
+            verified.get('size') == stat.st_size and
+            verified.get('mtime_ns') == stat.st_mtime_ns)
 
 
 def verify_file_integrity(file_path: str, headers: Any, local_file_checksums: Any) -> None:
@@ -338,7 +410,52 @@ def verify_local_file_checksum(url, file_path, headers, destination_file_path):
     )
     remote_headers = response.headers
 
+    if is_verified(destination_file_path, remote_headers):
+        print(f"[check_image] {file_path} was already verified", flush=True)
+        return
+
     check_md5()
+    write_verified_checksum(destination_file_path, remote_headers)
+
+
+def _etag(headers: Any) -> str:
+    return headers.get("etag", "").strip('\"').lower()
+
+
+def get_cache() -> Optional[TraceCache]:
+    """The cache shared by the runs on this machine, if there is one."""
+    if not OPTIONS.download['cache_dir']:
+        return None
+    return TraceCache(OPTIONS.download['cache_dir'],
+                      OPTIONS.download['cache_size'])
+
+
+def ensure_file_from_cache(cache: TraceCache, url: str, file_path: str,
+                           headers: Any, destination_file_path: str) -> bool:
+    """Place file_path from cache if the trace at url is cached there.
+
+    The trace is looked up by the ETag the server has for it.
+    """
+    print(f"[check_image] Requesting headers for {file_path}", end=" ", flush=True)
+    try:
+        response = requests.head(url + file_path, timeout=60, headers=headers)
+    except requests.exceptions.RequestException as err:
+        print(f"failed with {err}", flush=True)
+        return False
+    print(f"returned {response.status_code}.", flush=True)
+
+    etag = _etag(response.headers)
+    if response.status_code >= 400 or not etag:
+        return False
+
+    how = cache.get(etag, destination_file_path)
+    if how is None:
+        return False
+
+    print(f"[check_image] Took {file_path} from the cache ({how})", flush=True)
+    # The trace was verified when it was added to the cache
+    write_verified_checksum(destination_file_path, response.headers)
+    return True
 
 
 def ensure_file(file_path):
@@ -370,6 +487,74 @@ def ensure_file(file_path):
         verify_local_file_checksum(url, file_path, headers, destination_file_path)
         return
 
+    cache = get_cache()
+    if (cache is not None and not OPTIONS.download['force'] and
+            ensure_file_from_cache(cache, url, file_path, headers,
+                                   destination_file_path)):
+        return
+
     print(f"[check_image] Downloading file {file_path}", end=" ", flush=True)
 
-    download(url + file_path, destination_file_path, headers)
+    remote_headers = download(url + file_path, destination_file_path, headers)
+
+    if cache is not None and _etag(remote_headers):
+        try:
+            cache.put(_etag(remote_headers), destination_file_path)
+        except OSError as err:
+            print(f"[check_image] Couldn't add {file_path} to the cache: {err}")
+
+
+class Prefetcher(object):
+    """Fetch files ahead of their use with a bounded pool of threads.
+
+    The files are fetched in the order they will be used, at most ahead
+    files past the last one waited for and jobs of them at a time. A fetch
+    that fails is left to the user of the file, which has to fetch it again
+    and report the error anyway.
+
+    :param file_paths: the files in the order they will be used
+    :param fetch: the function fetching a file, ensure_file by default
+    :param ahead: how many files to fetch past the one in use
+    :param jobs: how many files to fetch at the same time
+    """
+
+    def __init__(self, file_paths: Iterable[str],
+                 fetch: Callable[[str], Any] = ensure_file,
+                 ahead: int = 4, jobs: int = 4) -> None:
+        self._paths = list(file_paths)
+        self._index = {p: i for i, p in enumerate(self._paths)}
+        self._fetch = fetch
+        self._ahead = ahead
+        self._futures: Dict[str, Any] = {}
+        self._next = 0
+        self._lock = threading.Lock()
+        # The threads don't survive a fork into worker processes
+        self._pid = os.getpid()
+        self._executor = ThreadPoolExecutor(max_workers=max(jobs, 1))
+
+        self._schedule(0)
+
+    def _schedule(self, current: int) -> None:
+        with self._lock:
+            end = min(len(self._paths), current + self._ahead + 1)
+            while self._next < end:
+                file_path = self._paths[self._next]
+                self._futures[file_path] = self._executor.submit(
+                    self._fetch, file_path)
+                self._next += 1
+
+    def wait(self, file_path: str) -> None:
+        """Wait until file_path is fetched, and fetch the next ones."""
+        if os.getpid() != self._pid or file_path not in self._index:
+            return
+
+        self._schedule(self._index[file_path])
+        try:
+            self._futures[file_path].result()
+        except Exception:  # pylint: disable=broad-except
+            pass
+
+    def shutdown(self) -> None:
+        """Cancel the fetches that didn't start."""
+        if os.getpid() == self._pid:
+            self._executor.shutdown(wait=False, cancel_futures=True)
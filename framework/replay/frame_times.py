@@ -24,23 +24,108 @@
 # SPDX-License-Identifier: MIT
 
 import json  # type: ignore
+import math
+import os
 from os import path
 
-from framework import status
+from framework import core, status
 from framework.replay import backends
 from framework.replay import query_traces_yaml as qty
-from framework.replay.backends.apitrace import APITraceBackend
 from framework.replay.download_utils import ensure_file
 from framework.replay.options import OPTIONS
+from framework.test.perf import t_975
 
-__all__ = ['from_yaml',
+__all__ = ['PROFILE_EXTENSIONS',
+           'from_yaml',
+           'frame_time_stats',
            'trace']
 
+# The extensions of the traces whose backends can profile them
+PROFILE_EXTENSIONS = '.trace,.gfxr,.so'
+
+_WARMUP_FRAMES = core.get_option('PIGLIT_REPLAY_WARMUP_FRAMES',
+                                 ('replay', 'warmup_frames'),
+                                 default='5')
+
+_ITERATIONS = core.get_option('PIGLIT_REPLAY_ITERATIONS',
+                              ('replay', 'iterations'),
+                              default='1')
+
+_WARMUP_ITERATIONS = core.get_option('PIGLIT_REPLAY_WARMUP_ITERATIONS',
+                                     ('replay', 'warmup_iterations'),
+                                     default='0')
+
+
+def _percentile(ordered, fraction):
+    """Interpolate the percentile between the closest ranks of ordered."""
+    rank = fraction * (len(ordered) - 1)
+    low = math.floor(rank)
+    high = min(low + 1, len(ordered) - 1)
+    return ordered[low] + (ordered[high] - ordered[low]) * (rank - low)
+
+
+def frame_time_stats(frame_times, warmup=0):
+    """Return the statistics of frame_times as result metrics.
+
+    The first warmup frames are left out, unless there would be none left.
+    The mean has a 95% confidence interval (mean +- ci) and is noisy, like the
+    measurements of tests/perf, when its coefficient of variation is over
+    PIGLIT_PERF_MAX_CV. The percentiles are as noisy as the mean.
+    """
+    if warmup < len(frame_times):
+        frame_times = frame_times[warmup:]
+    count = len(frame_times)
+    mean = sum(frame_times) / count
+    variance = (sum((t - mean) ** 2 for t in frame_times) / (count - 1)
+                if count > 1 else 0.0)
+    stddev = math.sqrt(variance)
+    cv = stddev / mean if mean else 0.0
+    ci = t_975(count - 1) * stddev / math.sqrt(count) if count > 1 else 0.0
+    noisy = cv > float(os.environ.get('PIGLIT_PERF_MAX_CV', '0.05'))
+
+    metrics = {
+        'frame_time_mean': {
+            'value': mean,
+            'unit': 'ns',
+            'stddev': stddev,
+            'variance': variance,
+            'cv': cv,
+            'ci': ci,
+            'samples': count,
+            'noisy': noisy,
+        },
+    }
+    ordered = sorted(frame_times)
+    for percentile in (50, 90, 99):
+        metrics['frame_time_p{}'.format(percentile)] = {
+            'value': _percentile(ordered, percentile / 100),
+            'unit': 'ns',
+            'samples': count,
+            'noisy': noisy,
+        }
+
+    return metrics
+
+
+def _steady_frame_times(iterations, warmup_iterations, warmup_frames):
+    """Return the frame times of iterations once the replays are warm.
+
+    The first warmup_iterations are left out, and so are the first
+    warmup_frames of each remaining iteration, unless there would be none
+    left.
+    """
+    if warmup_iterations < len(iterations):
+        iterations = iterations[warmup_iterations:]
+    return [t for frame_times in iterations
+            for t in (frame_times[warmup_frames:]
+                      if warmup_frames < len(frame_times) else frame_times)]
+
 
 def _replay(trace_path):
     try:
         success = True
-        frame_times = APITraceBackend.profile(trace_path)
+        iterations = [backends.profile(trace_path)
+                      for _ in range(max(int(_ITERATIONS), 1))]
     except (backends.DumpBackendNotImplementedError,
             backends.DumpBackendError) as e:
         print(e)
@@ -51,7 +136,7 @@ def _replay(trace_path):
               "See above logs for more information.".format(trace_path))
         return None
     else:
-        return frame_times
+        return iterations
 
 
 def _run_trace(trace_path):
@@ -59,10 +144,12 @@ def _run_trace(trace_path):
 
     json_result = {}
 
-    frame_times = _replay(path.join(OPTIONS.db_path, trace_path))
-    if frame_times is None:
+    iterations = _replay(path.join(OPTIONS.db_path, trace_path))
+    if iterations is None:
+        frame_times = None
         print('[frame_times] error')
     else:
+        frame_times = [t for i in iterations for t in i]
         print(f'[frame_times] {format(len(frame_times))}')
 
     json_result['images'] = [
@@ -72,6 +159,19 @@ def _run_trace(trace_path):
     if frame_times is None:
         return status.CRASH, json_result
 
+    steady_frame_times = _steady_frame_times(
+        iterations, int(_WARMUP_ITERATIONS), int(_WARMUP_FRAMES))
+    if steady_frame_times:
+        metrics = frame_time_stats(steady_frame_times)
+        mean = metrics['frame_time_mean']
+        print('[frame_times] mean: {:.0f} +- {:.0f} ns, p50: {:.0f} ns, '
+              'p90: {:.0f} ns, p99: {:.0f} ns'.format(
+                  mean['value'], mean['ci'],
+                  metrics['frame_time_p50']['value'],
+                  metrics['frame_time_p90']['value'],
+                  metrics['frame_time_p99']['value']))
+        json_result['metrics'] = metrics
+
     return status.PASS, json_result
 
 
@@ -91,7 +191,8 @@ def from_yaml(yaml_file):
     global_result = status.PASS
     # TODO: print in subtest format
     # json_results = {}
-    t_list = qty.traces(y, trace_extensions=".trace", device_name=OPTIONS.device_name)
+    t_list = qty.traces(y, trace_extensions=PROFILE_EXTENSIONS,
+                       device_name=OPTIONS.device_name)
     for t in t_list:
         result, json_result = _run_trace(t['path'])
         if result is not status.PASS and global_result is not status.CRASH:
@@ -29,8 +29,31 @@ from PIL import Image
 
 __all__ = ['hexdigest_from_image']
 
+# Image.tobytes() encodes in chunks of at least this size too
+_CHUNK_SIZE = 1 << 16
+
 
 def hexdigest_from_image(file_path):
-    image_md5 = md5(Image.open(file_path).tobytes())
+    """Return the MD5 of the pixels of the image at file_path.
+
+    This is the MD5 of Image.tobytes(), but the chunks the raw encoder
+    produces are hashed as they come instead of being joined into a copy of
+    the whole image first. The checksum doesn't depend on the file format, so
+    an uncompressed dump has the checksum of the PNG it would be encoded to.
+    """
+    image_md5 = md5()
+
+    with Image.open(file_path) as image:
+        image.load()
+        encoder = Image._getencoder(image.mode, 'raw', image.mode)
+        encoder.setimage(image.im)
+        chunk_size = max(_CHUNK_SIZE, image.size[0] * 4)
+        errcode = 0
+        while not errcode:
+            _, errcode, data = encoder.encode(chunk_size)
+            image_md5.update(data)
+        if errcode < 0:
+            raise OSError('encoder error {} hashing {}'.format(errcode,
+                                                               file_path))
 
     return image_md5.hexdigest()
@@ -58,6 +58,10 @@ class _Options(object):  # pylint: disable=too-many-instance-attributes
     keep_image -- Whether to always keep the dumped images or not.
     db_path -- The path to the objects db or where it will be created.
     results_path -- The path in which to place the results.
+    jobs -- How many traces to replay at the same time when comparing from
+            a YAML file.
+    gpus -- The values DRI_PRIME and MESA_VK_DEVICE_SELECT are set to for
+            each job, which take turns using them, if any.
     download.url -- The URL from which to download the files.
     download.caching_proxy_url -- The URL of the caching proxy acting as
                                   a prefix for download.url
@@ -67,6 +71,11 @@ class _Options(object):  # pylint: disable=too-many-instance-attributes
     download.minio_bucket -- Name of bucket in MinIO server containing the traces
     download.role_session_name -- Role session name for authentication with MinIO
     download.jwt -- JWT token for authentication with MinIO
+    download.cache_dir -- The directory of the trace cache shared by the runs
+                          on this machine, if any.
+    download.cache_size -- The size in bytes the least recently used traces
+                           are evicted from the cache down to, or 0 to keep
+                           all of them.
     """
 
     def __init__(self):
@@ -74,13 +83,17 @@ class _Options(object):  # pylint: disable=too-many-instance-attributes
         self.keep_image = False
         self.db_path = None
         self.results_path = None
+        self.jobs = 1
+        self.gpus = []
         self.download = {'url': None,
                          'caching_proxy_url': None,
                          'force': False,
                          'minio_host': '',
                          'minio_bucket': '',
                          'role_session_name': '',
-                         'jwt': ''}
+                         'jwt': '',
+                         'cache_dir': None,
+                         'cache_size': 0}
 
     def clear(self):
         """Reinitialize all values to defaults."""
@@ -42,8 +42,12 @@ def _from_yaml(args):
     options.OPTIONS.download['minio_bucket'] = args.download_minio_bucket
     options.OPTIONS.download['role_session_name'] = args.download_role_session_name
     options.OPTIONS.download['jwt'] = args.download_jwt
+    options.OPTIONS.download['cache_dir'] = args.download_cache_dir
+    options.OPTIONS.download['cache_size'] = args.download_cache_size
     options.OPTIONS.db_path = args.db_path
     options.OPTIONS.results_path = args.output
+    options.OPTIONS.gpus = args.gpus
+    options.OPTIONS.jobs = args.jobs or len(args.gpus) or 1
 
     return compare_replay.from_yaml(args.yaml_file)
 
@@ -58,6 +62,8 @@ def _trace(args):
     options.OPTIONS.download['minio_bucket'] = args.download_minio_bucket
     options.OPTIONS.download['role_session_name'] = args.download_role_session_name
     options.OPTIONS.download['jwt'] = args.download_jwt
+    options.OPTIONS.download['cache_dir'] = args.download_cache_dir
+    options.OPTIONS.download['cache_size'] = args.download_cache_size
     options.OPTIONS.db_path = args.db_path
     options.OPTIONS.results_path = args.output
 
@@ -91,6 +97,7 @@ def compare(input_):
                  parsers.DOWNLOAD_MINIO_BUCKET,
                  parsers.DOWNLOAD_ROLE_SESSION_NAME,
                  parsers.DOWNLOAD_JWT,
+                 parsers.DOWNLOAD_CACHE,
                  parsers.DB_PATH,
                  parsers.RESULTS_PATH],
         help=('Compares a specific trace given a checksum and a device.'))
@@ -116,7 +123,9 @@ def compare(input_):
                  parsers.DOWNLOAD_MINIO_BUCKET,
                  parsers.DOWNLOAD_ROLE_SESSION_NAME,
                  parsers.DOWNLOAD_JWT,
+                 parsers.DOWNLOAD_CACHE,
                  parsers.DB_PATH,
+                 parsers.JOBS,
                  parsers.RESULTS_PATH],
         help=('Compares from a traces description file listing traces '
               'and their checksums for a given device.'))
@@ -40,6 +40,8 @@ def _ensure_file(args):
     options.OPTIONS.download['minio_bucket'] = args.download_minio_bucket
     options.OPTIONS.download['role_session_name'] = args.download_role_session_name
     options.OPTIONS.download['jwt'] = args.download_jwt
+    options.OPTIONS.download['cache_dir'] = args.download_cache_dir
+    options.OPTIONS.download['cache_size'] = args.download_cache_size
     options.OPTIONS.db_path = args.db_path
 
     return download_utils.ensure_file(args.file_path)
@@ -55,6 +57,7 @@ def download(input_):
                                               parsers.DOWNLOAD_MINIO_BUCKET,
                                               parsers.DOWNLOAD_ROLE_SESSION_NAME,
                                               parsers.DOWNLOAD_JWT,
+                                              parsers.DOWNLOAD_CACHE,
                                               parsers.DB_PATH])
     parser.add_argument(
         'file_path',
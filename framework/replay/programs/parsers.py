@@ -24,8 +24,11 @@
 # SPDX-License-Identifier: MIT
 
 import argparse
+import os
 from typing import Any
 
+from framework.replay.trace_cache import parse_size
+
 
 class FileContentType(argparse.FileType):
     """A FileType type argument which reads the file content
@@ -132,6 +135,24 @@ download_jwt_group.add_argument(
     help=("File containing JWT token for authentication with MinIO"),
 )
 
+DOWNLOAD_CACHE = argparse.ArgumentParser(add_help=False)
+DOWNLOAD_CACHE.add_argument(
+    '--download-cache-dir',
+    dest='download_cache_dir',
+    required=False,
+    default=os.environ.get('PIGLIT_REPLAY_CACHE_DIR'),
+    help=('a directory in which to keep the downloaded files for other runs '
+          'on this machine. Defaults to the value of PIGLIT_REPLAY_CACHE_DIR'))
+DOWNLOAD_CACHE.add_argument(
+    '--download-cache-size',
+    dest='download_cache_size',
+    required=False,
+    type=parse_size,
+    default=os.environ.get('PIGLIT_REPLAY_CACHE_SIZE', '0'),
+    help=('the size, like "50G", down to which the least recently used files '
+          'are removed from the cache. Defaults to the value of '
+          'PIGLIT_REPLAY_CACHE_SIZE, or 0 to keep all of them'))
+
 DB_PATH = argparse.ArgumentParser(add_help=False)
 DB_PATH.add_argument(
     '-p', '--db-path',
@@ -141,6 +162,25 @@ DB_PATH.add_argument(
     help=('the path to the objects db or where it will be created. '
           'Defaults to "./replayer-db/".'))
 
+JOBS = argparse.ArgumentParser(add_help=False)
+JOBS.add_argument(
+    '-j', '--jobs',
+    dest='jobs',
+    required=False,
+    type=int,
+    default=None,
+    help=('how many traces to replay at the same time. Defaults to the '
+          'number of --gpus, or 1'))
+JOBS.add_argument(
+    '--gpus',
+    dest='gpus',
+    required=False,
+    type=lambda s: [g for g in s.split(',') if g],
+    default=[],
+    help=('a comma-separated list of the GPUs to replay on, as values of '
+          'DRI_PRIME and MESA_VK_DEVICE_SELECT like "1002:73bf". Each job '
+          'keeps one, taking them in turns'))
+
 RESULTS_PATH = argparse.ArgumentParser(add_help=False)
 RESULTS_PATH.add_argument(
     '-o', '--output',
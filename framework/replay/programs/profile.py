@@ -42,6 +42,8 @@ def _from_yaml(args):
     options.OPTIONS.download['minio_bucket'] = args.download_minio_bucket
     options.OPTIONS.download['role_session_name'] = args.download_role_session_name
     options.OPTIONS.download['jwt'] = args.download_jwt
+    options.OPTIONS.download['cache_dir'] = args.download_cache_dir
+    options.OPTIONS.download['cache_size'] = args.download_cache_size
     options.OPTIONS.db_path = args.db_path
     options.OPTIONS.results_path = args.output
 
@@ -57,6 +59,8 @@ def _trace(args):
     options.OPTIONS.download['minio_bucket'] = args.download_minio_bucket
     options.OPTIONS.download['role_session_name'] = args.download_role_session_name
     options.OPTIONS.download['jwt'] = args.download_jwt
+    options.OPTIONS.download['cache_dir'] = args.download_cache_dir
+    options.OPTIONS.download['cache_size'] = args.download_cache_size
     options.OPTIONS.db_path = args.db_path
     options.OPTIONS.results_path = args.output
 
@@ -89,6 +93,7 @@ def profile(input_):
                  parsers.DOWNLOAD_MINIO_BUCKET,
                  parsers.DOWNLOAD_ROLE_SESSION_NAME,
                  parsers.DOWNLOAD_JWT,
+                 parsers.DOWNLOAD_CACHE,
                  parsers.DB_PATH,
                  parsers.RESULTS_PATH],
         help=('Profiles specific trace given a device.'))
@@ -109,6 +114,7 @@ def profile(input_):
                  parsers.DOWNLOAD_MINIO_BUCKET,
                  parsers.DOWNLOAD_ROLE_SESSION_NAME,
                  parsers.DOWNLOAD_JWT,
+                 parsers.DOWNLOAD_CACHE,
                  parsers.DB_PATH,
                  parsers.RESULTS_PATH],
         help=('Profiles from a traces description file listing traces.'))
@@ -0,0 +1,186 @@
+# coding=utf-8
+#
+# Copyright © 2026 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+"""A content-addressed cache of downloaded traces.
+
+The cache is a directory that several runs on a machine can share. Each
+trace is stored under the ETag the server gave it, which is the MD5
+checksum of its content (or the checksum of its parts for multipart
+uploads), so the same trace is stored once whatever path it has in a db.
+
+Traces are put into and taken from the cache by reflinking them where the
+filesystem allows it, by hardlinking them otherwise, and by copying them
+only when neither works. The entries are touched when they are used, and
+the least recently used ones are removed when the cache grows past its
+size.
+"""
+
+import os
+import re
+import shutil
+import tempfile
+import time
+from os import path
+from typing import Optional
+
+try:
+    import fcntl
+except ImportError:
+    fcntl = None
+
+__all__ = ['TraceCache', 'parse_size']
+
+# From linux/fs.h
+_FICLONE = 0x40049409
+
+_SIZE_UNITS = {'': 1, 'K': 1 << 10, 'M': 1 << 20, 'G': 1 << 30, 'T': 1 << 40}
+
+
+def parse_size(size: str) -> int:
+    """Parse a size in bytes with an optional K, M, G or T suffix."""
+    match = re.match(r'^\s*(\d+)\s*([KMGT]?)i?B?\s*$', size, re.IGNORECASE)
+    if match is None:
+        raise ValueError('invalid size: {}'.format(size))
+    return int(match.group(1)) * _SIZE_UNITS[match.group(2).upper()]
+
+
+def _reflink(src: str, dst: str) -> bool:
+    if fcntl is None:
+        return False
+    try:
+        with open(src, 'rb') as s, open(dst, 'wb') as d:
+            fcntl.ioctl(d.fileno(), _FICLONE, s.fileno())
+        return True
+    except OSError:
+        return False
+
+
+def place(src: str, dst: str) -> str:
+    """Make dst a file with the content of src, without copying if possible.
+
+    dst appears at once, complete. Return how it was made: "reflink",
+    "hardlink" or "copy".
+    """
+    fd, tmp = tempfile.mkstemp(dir=path.dirname(dst) or None,
+                               prefix=path.basename(dst) + '.',
+                               suffix='.part')
+    os.close(fd)
+    try:
+        if _reflink(src, tmp):
+            how = 'reflink'
+        else:
+            os.remove(tmp)
+            try:
+                os.link(src, tmp)
+                how = 'hardlink'
+            except OSError:
+                shutil.copyfile(src, tmp)
+                how = 'copy'
+        os.replace(tmp, dst)
+    finally:
+        if path.exists(tmp):
+            os.remove(tmp)
+    return how
+
+
+class TraceCache(object):
+    """A directory of traces named after their ETag.
+
+    :param directory: where the traces are stored
+    :param max_size: the size in bytes to evict traces down to, or 0 to
+                     keep all of them
+    """
+
+    def __init__(self, directory: str, max_size: int = 0) -> None:
+        self.directory = directory
+        self.max_size = max_size
+
+    def path(self, etag: str) -> str:
+        """The path of the trace with the given ETag."""
+        etag = etag.strip('"').lower()
+        return path.join(self.directory, etag[:2], etag)
+
+    def get(self, etag: str, file_path: str) -> Optional[str]:
+        """Place the trace with the given ETag at file_path if it is cached.
+
+        Return how it was placed, or None if it isn't cached.
+        """
+        entry = self.path(etag)
+        try:
+            how = place(entry, file_path)
+        except FileNotFoundError:
+            return None
+
+        # Only the access time is updated, hardlinks to the entry would see
+        # a new modification time.
+        try:
+            os.utime(entry, ns=(time.time_ns(), os.stat(entry).st_mtime_ns))
+        except OSError:
+            pass
+        return how
+
+    def put(self, etag: str, file_path: str) -> None:
+        """Add the trace at file_path, which has the given ETag."""
+        entry = self.path(etag)
+        os.makedirs(path.dirname(entry), exist_ok=True)
+        place(file_path, entry)
+        self.evict(keep=entry)
+
+    def _entries(self):
+        for dirpath, _, filenames in os.walk(self.directory):
+            for filename in filenames:
+                if filename.endswith('.part') or filename == '.lock':
+                    continue
+                entry = path.join(dirpath, filename)
+                try:
+                    yield entry, os.stat(entry)
+                except FileNotFoundError:
+                    pass
+
+    def evict(self, keep: Optional[str] = None) -> None:
+        """Remove the least recently used traces down to max_size.
+
+        keep is never removed, even if it is the only trace and larger than
+        max_size.
+        """
+        if not self.max_size:
+            return
+
+        with open(path.join(self.directory, '.lock'), 'w') as lock:
+            # Runs sharing the cache must not evict the same traces twice
+            if fcntl is not None:
+                fcntl.flock(lock.fileno(), fcntl.LOCK_EX)
+
+            entries = sorted(self._entries(), key=lambda e: e[1].st_atime_ns)
+            total = sum(s.st_size for _, s in entries)
+            for entry, stat in entries:
+                if total <= self.max_size:
+                    break
+                if entry == keep:
+                    continue
+                try:
+                    os.remove(entry)
+                except FileNotFoundError:
+                    pass
+                total -= stat.st_size
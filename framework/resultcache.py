@@ -0,0 +1,194 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Reuse the results of tests that would run exactly as they did before.
+
+With "piglit run --result-cache" the result of each test is kept in the
+piglit cache directory, under a key made of the test's command, the
+executable and the files named on the command line, the environment and the
+identity of the driver (see framework.wflinfo.driver_identity). A later run
+that computes the same key takes the result from there instead of running
+the test.
+
+Rebuilding the driver changes its identity, so all of its results are
+invalidated at once. Only the results of the last few drivers are kept.
+Crashes, timeouts and results that come from dmesg or from an exception in
+piglit itself are not cached, since they are as likely to come from the
+machine as from the test.
+"""
+
+import contextlib
+import hashlib
+import json
+import os
+import shutil
+import threading
+
+from framework import core, status
+from framework.options import OPTIONS
+from framework.results import TestResult
+from framework.wflinfo import driver_identity
+
+__all__ = [
+    'ResultCache',
+    'bypass',
+    'get',
+]
+
+# The statuses that only depend on the test and the driver
+_CACHEABLE = frozenset([status.PASS, status.WARN, status.FAIL, status.SKIP])
+
+# The number of drivers whose results are kept
+_KEEP_DRIVERS = 4
+
+_LOCK = threading.Lock()
+_CACHE = None
+_LOCAL = threading.local()
+
+
+def _input_files(command, cwd):
+    """Yield the paths of the executable and the files command names."""
+    for i, arg in enumerate(command):
+        if os.sep in arg:
+            path = os.path.join(cwd or os.getcwd(), arg)
+        elif i == 0:
+            path = shutil.which(arg)
+        else:
+            continue
+        if path and os.path.isfile(path):
+            yield path
+
+
+class ResultCache(object):
+    """The cached results of the tests run with one driver.
+
+    Arguments:
+    directory -- the directory each driver has a directory of results in.
+    driver -- the identity of the driver.
+
+    Keyword Arguments:
+    refresh -- if True no result is reused, but the new ones are still
+               stored.
+
+    """
+    def __init__(self, directory, driver, refresh=False):
+        self.__dir = os.path.join(directory, driver)
+        self.__refresh = refresh
+        self.__prune(directory)
+
+    def __prune(self, directory):
+        """Remove the results of all but the last few drivers."""
+        try:
+            core.check_dir(self.__dir)
+            os.utime(self.__dir)
+            drivers = [os.path.join(directory, d)
+                       for d in os.listdir(directory)]
+            drivers.sort(key=os.path.getmtime, reverse=True)
+        except OSError:
+            return
+        for stale in drivers[_KEEP_DRIVERS:]:
+            shutil.rmtree(stale, ignore_errors=True)
+
+    def key(self, test):
+        """Return the key of the result of test, or None if it can't have one.
+        """
+        if not test.cache_results:
+            return None
+        try:
+            command = test.command
+        except AssertionError:
+            return None
+
+        digest = hashlib.sha1()
+        digest.update(json.dumps([
+            type(test).__module__, type(test).__name__, command, test.cwd,
+            sorted(test.env.items()), sorted(OPTIONS.env.items()),
+            OPTIONS.valgrind,
+        ]).encode('utf-8'))
+        for path in _input_files(command, test.cwd):
+            digest.update(json.dumps(
+                [path, core.binary_identity(path)]).encode('utf-8'))
+        return digest.hexdigest()
+
+    def load(self, key):
+        """Return the TestResult cached under key, or None."""
+        if self.__refresh:
+            return None
+        try:
+            with open(os.path.join(self.__dir, key + '.json'), 'r') as f:
+                result = TestResult.from_dict(json.load(f))
+        except (OSError, ValueError, KeyError, TypeError):
+            return None
+        result.resources['cached'] = True
+        return result
+
+    def store(self, key, result):
+        """Cache result under key, if it is one worth keeping."""
+        # Importing this at the top would be circular
+        from framework.backends.json import piglit_encoder
+
+        if result.result not in _CACHEABLE or result.exception:
+            return
+
+        filename = os.path.join(self.__dir, key + '.json')
+        tmp = '{}.{}.{}.tmp'.format(filename, os.getpid(),
+                                    threading.get_ident())
+        try:
+            with open(tmp, 'w') as f:
+                json.dump(result, f, default=piglit_encoder)
+            os.replace(tmp, filename)
+        except OSError:
+            pass
+
+
+def get():
+    """Return the ResultCache of this run, or None if it doesn't use one.
+
+    There is none without --result-cache, inside of bypass(), or if the
+    driver can't be identified, since then its results could not be
+    invalidated.
+
+    """
+    global _CACHE
+    if OPTIONS.result_cache == 'off' or getattr(_LOCAL, 'bypass', False):
+        return None
+    with _LOCK:
+        if _CACHE is None:
+            driver = driver_identity()
+            _CACHE = False if driver is None else ResultCache(
+                os.path.join(core.cache_dir(), 'results'), driver,
+                refresh=OPTIONS.result_cache == 'refresh')
+        return _CACHE or None
+
+
+@contextlib.contextmanager
+def bypass():
+    """Run the tests executed by this thread without the cache.
+
+    This is for running tests again because their result is in doubt, which
+    the cached result would only repeat.
+
+    """
+    _LOCAL.bypass = True
+    try:
+        yield
+    finally:
+        _LOCAL.bypass = False
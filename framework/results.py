@@ -25,19 +25,27 @@
 import collections
 import copy
 import datetime
+import sys
 
 from framework import status, exceptions, grouptools
 
 __all__ = [
+    'LazyTestResult',
     'TestrunResult',
     'TestResult',
 ]
 
 
 class Subtests(collections.abc.MutableMapping):
-    """A dict-like object that stores Statuses as values."""
+    """A dict-like object that stores Statuses as values.
+
+    times holds the seconds each subtest took, for the subtests the test
+    reported a time for.
+
+    """
     def __init__(self, dict_=None):
         self.__container = collections.OrderedDict()
+        self.times = {}
 
         if dict_ is not None:
             self.update(dict_)
@@ -50,6 +58,7 @@ class Subtests(collections.abc.MutableMapping):
 
     def __delitem__(self, name):
         del self.__container[name.lower()]
+        self.times.pop(name.lower(), None)
 
     def __iter__(self):
         return iter(self.__container)
@@ -60,17 +69,24 @@ class Subtests(collections.abc.MutableMapping):
     def __repr__(self):
         return repr(self.__container)
 
+    def set_time(self, name, seconds):
+        self.times[name.lower()] = seconds
+
     def to_json(self):
         res = dict(self)
         res['__type__'] = 'Subtests'
+        if self.times:
+            res['__times__'] = self.times
         return res
 
     @classmethod
     def from_dict(cls, dict_):
         if '__type__' in dict_:
             del dict_['__type__']
+        times = dict_.pop('__times__', {})
 
         res = cls(dict_)
+        res.times.update(times)
 
         return res
 
@@ -144,7 +160,7 @@ class TestResult(object):
     """An object representing the result of a single test."""
     __slots__ = ['returncode', '_err', '_out', 'time', 'command', 'traceback',
                  'environment', 'subtests', 'dmesg', '__result', 'images',
-                 'exception', 'pid']
+                 'exception', 'pid', 'metrics', 'resources', 'attempts']
     err = StringDescriptor('_err')
     out = StringDescriptor('_out')
 
@@ -159,6 +175,13 @@ class TestResult(object):
         self.traceback = None
         self.exception = None
         self.pid = []
+        self.metrics = collections.OrderedDict()
+        # The CPU time, memory and context switches of the test's processes,
+        # and the GPU time of each engine when the test reports it
+        self.resources = {}
+        # The earlier results of a test that was run again because it failed,
+        # oldest first, see add_attempt
+        self.attempts = []
         if result:
             self.result = result
         else:
@@ -208,6 +231,9 @@ class TestResult(object):
             'dmesg': self.dmesg,
             'images': self.images,
             'pid': self.pid,
+            'metrics': self.metrics,
+            'resources': self.resources,
+            'attempts': self.attempts,
         }
         return obj
 
@@ -236,6 +262,12 @@ class TestResult(object):
             inst.subtests = Subtests.from_dict(dict_['subtests'])
         if 'time' in dict_:
             inst.time = TimeAttribute.from_dict(dict_['time'])
+        if 'metrics' in dict_:
+            inst.metrics = collections.OrderedDict(dict_['metrics'])
+        if 'resources' in dict_:
+            inst.resources = dict(dict_['resources'])
+        if dict_.get('attempts'):
+            inst.attempts = list(dict_['attempts'])
 
         # out and err must be set manually to avoid replacing the setter
         if 'out' in dict_:
@@ -257,8 +289,94 @@ class TestResult(object):
             self.result = dict_['result']
             if 'images' in dict_:
                 self.images = dict_['images']
+            if 'metrics' in dict_:
+                self.metrics.update(dict_['metrics'])
         elif 'subtest' in dict_:
             self.subtests.update(dict_['subtest'])
+            if 'time' in dict_:
+                for name in dict_['subtest']:
+                    self.subtests.set_time(name, dict_['time'])
+        elif 'gpu' in dict_:
+            self.resources['gpu'] = dict_['gpu']
+        elif 'metrics' in dict_:
+            self.metrics.update(dict_['metrics'])
+
+    def add_attempt(self, attempt):
+        """Record attempt, the result of an earlier run of this test.
+
+        Only the parts that can differ from one run to the next are kept: the
+        status, return code, times, output and exception of the test and of
+        its subtests.
+
+        """
+        data = attempt.to_json()
+        self.attempts.extend(attempt.attempts)
+        self.attempts.append({k: data[k] for k in [
+            'result', 'returncode', 'time', 'out', 'err', 'exception',
+            'subtests']})
+
+    def add_rusage(self, rusage):
+        """Add the resource usage of a process of the test.
+
+        Arguments:
+        rusage -- the struct_rusage os.wait4() returned for the process
+
+        """
+        # ru_maxrss is in kilobytes on Linux and the BSDs, in bytes on OSX
+        maxrss = rusage.ru_maxrss * (1 if sys.platform == 'darwin' else 1024)
+        res = self.resources
+        res['utime'] = res.get('utime', 0) + rusage.ru_utime
+        res['stime'] = res.get('stime', 0) + rusage.ru_stime
+        res['maxrss'] = max(res.get('maxrss', 0), maxrss)
+        res['nvcsw'] = res.get('nvcsw', 0) + rusage.ru_nvcsw
+        res['nivcsw'] = res.get('nivcsw', 0) + rusage.ru_nivcsw
+
+
+class LazyTestResult(TestResult):
+    """A TestResult that only reads its text fields when they are used.
+
+    Summaries mostly look at the status of tests. The output, command,
+    environment and the like make up most of the size of a result, so this
+    leaves them out and calls load, which returns them as a dictionary, the
+    first time one is accessed.
+
+    """
+    __slots__ = ['_load']
+
+    # These are the attribute names, with the underscore for out and err
+    LAZY = frozenset(['command', 'environment', '_err', '_out', 'dmesg',
+                      'traceback', 'exception', 'images'])
+
+    # The keys that are read right away
+    EAGER = frozenset(['__type__', 'result', 'returncode', 'subtests', 'time',
+                       'pid', 'metrics', 'resources', 'attempts'])
+
+    def __getattr__(self, name):
+        # Only called when name hasn't been set yet
+        if name not in self.LAZY or getattr(self, '_load', None) is None:
+            raise AttributeError(name)
+
+        load, self._load = self._load, None
+        full = TestResult.from_dict(load())
+        for each in self.LAZY:
+            setattr(self, each, getattr(full, each, ''))
+        return getattr(self, name)
+
+    @classmethod
+    def from_dict(cls, dict_, load):
+        """Create a result from the EAGER keys of its dictionary form.
+
+        Arguments:
+        dict_ -- a dictionary with the EAGER keys of the result.
+        load -- a callable returning the dictionary form of the whole result.
+
+        """
+        inst = super(LazyTestResult, cls).from_dict(dict_)
+        for each in ['command', 'environment', 'dmesg', 'traceback',
+                     'exception', 'images']:
+            delattr(inst, each)
+        inst._load = load
+        return inst
 
 
 class Totals(dict):
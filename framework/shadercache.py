@@ -0,0 +1,191 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Give the disk shader cache of the driver a known state for a run.
+
+Whether the driver finds the shaders of the tests in its disk cache changes
+how long they take, and whether the compiler runs at all. With
+"piglit run --shader-cache <mode>" the tests use a cache directory of the
+run instead of whichever one the environment gives:
+
+cold -- an empty directory in the results, so that every shader is
+        compiled once in the run.
+seed -- a directory in the results, filled from the directory or the tar
+        archive of --shader-cache-dir first, for instance the cache kept
+        by an earlier cold run.
+shared -- the directory of --shader-cache-dir as is, kept warm by all of
+          the runs that use it.
+
+The cache directory is given to Mesa and to the NVIDIA driver, and Mesa is
+asked to print its hits and misses when a process exits. Those are kept in
+the resources of each result, and the totals of the run are written to
+shader-cache.json in the results.
+"""
+
+import json
+import os
+import re
+import shutil
+import tarfile
+import threading
+
+from framework import exceptions
+from framework.options import OPTIONS
+
+__all__ = [
+    'MODES',
+    'TOTALS',
+    'Totals',
+    'parse_stats',
+    'setup',
+]
+
+MODES = ['inherit', 'cold', 'seed', 'shared']
+
+# The name of the cache directory in the results of cold and seed runs
+_DIR_NAME = 'shader-cache'
+
+# Printed by Mesa's disk cache on destruction with
+# MESA_SHADER_CACHE_SHOW_STATS, once for each cache of the process
+_STATS_RE = re.compile(r'disk shader cache:\s+hits = (\d+), misses = (\d+)')
+
+
+def _restore(source, directory):
+    """Fill the new directory with the cache in source."""
+    if os.path.isdir(source):
+        shutil.copytree(source, directory, symlinks=True)
+        return
+    if not (os.path.isfile(source) and tarfile.is_tarfile(source)):
+        raise exceptions.PiglitFatalError(
+            'The shader cache to seed from, {}, is neither a directory nor '
+            'a tar archive'.format(source))
+
+    os.makedirs(directory)
+    with tarfile.open(source) as tar:
+        if hasattr(tarfile, 'data_filter'):
+            tar.extractall(directory, filter='data')
+        else:
+            tar.extractall(directory)
+
+    # An archive of the cache directory of an earlier run, rather than of
+    # its contents
+    entries = os.listdir(directory)
+    inner = os.path.join(directory, _DIR_NAME)
+    if entries == [_DIR_NAME] and os.path.isdir(inner):
+        for entry in os.listdir(inner):
+            os.rename(os.path.join(inner, entry),
+                      os.path.join(directory, entry))
+        os.rmdir(inner)
+
+
+def setup(mode, results_path, source=None, resume=False):
+    """Point the drivers at the shader cache of mode.
+
+    Return the cache directory, or None when mode is 'inherit'. source is
+    the directory of a shared cache, or what a seeded one is restored from.
+    When resuming the cache of the run is used as it was left.
+
+    """
+    if mode == 'inherit':
+        return None
+    if mode in ('seed', 'shared') and not source:
+        raise exceptions.PiglitFatalError(
+            '--shader-cache {} needs --shader-cache-dir'.format(mode))
+
+    if mode == 'shared':
+        directory = os.path.abspath(source)
+        os.makedirs(directory, exist_ok=True)
+    else:
+        directory = os.path.join(results_path, _DIR_NAME)
+        if not resume:
+            if os.path.exists(directory):
+                shutil.rmtree(directory)
+            if mode == 'seed':
+                _restore(source, directory)
+            else:
+                os.makedirs(directory)
+
+    env = OPTIONS.env
+    env['MESA_SHADER_CACHE_DIR'] = directory
+    # The name of MESA_SHADER_CACHE_DIR before Mesa 21.1
+    env['MESA_GLSL_CACHE_DIR'] = directory
+    env['MESA_SHADER_CACHE_DISABLE'] = 'false'
+    env['MESA_SHADER_CACHE_SHOW_STATS'] = 'true'
+    env['__GL_SHADER_DISK_CACHE'] = '1'
+    env['__GL_SHADER_DISK_CACHE_PATH'] = directory
+    env['__GL_SHADER_DISK_CACHE_SKIP_CLEANUP'] = '1'
+    return directory
+
+
+def parse_stats(output):
+    """Return the shader cache hits and misses printed in output, or None."""
+    stats = None
+    for match in _STATS_RE.finditer(output):
+        if stats is None:
+            stats = {'hits': 0, 'misses': 0}
+        stats['hits'] += int(match.group(1))
+        stats['misses'] += int(match.group(2))
+    return stats
+
+
+class Totals(object):
+    """The shader cache hits and misses of the tests of a run."""
+
+    def __init__(self):
+        self.__lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+        self.tests = 0
+
+    def add(self, result):
+        """Count the stats of result, unless it comes from the result cache.
+        """
+        stats = result.resources.get('shader_cache')
+        if not stats or result.resources.get('cached'):
+            return
+        with self.__lock:
+            self.hits += stats['hits']
+            self.misses += stats['misses']
+            self.tests += 1
+
+    def write(self, results_path, directory):
+        """Write the totals and the cache directory of the run to
+        shader-cache.json in results_path.
+        """
+        with open(os.path.join(results_path, 'shader-cache.json'), 'w') as f:
+            json.dump({
+                'mode': OPTIONS.shader_cache,
+                'source': OPTIONS.shader_cache_dir,
+                'directory': directory,
+                'hits': self.hits,
+                'misses': self.misses,
+                'tests': self.tests,
+            }, f, indent=4)
+
+    def __str__(self):
+        lookups = self.hits + self.misses
+        return 'shader cache: {} hits, {} misses ({:.1f}% hit rate)'.format(
+            self.hits, self.misses,
+            100.0 * self.hits / lookups if lookups else 0.0)
+
+
+# The totals of the tests run by this process
+TOTALS = Totals()
@@ -0,0 +1,296 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Split one run between several machines.
+
+A coordinator, started with "piglit run --shard-coordinator", owns the
+results of the run. Workers, started with "piglit run --shard-worker" on
+each test machine with the same profile, ask it for a few tests at a time
+over HTTP and send back each result, which the coordinator writes through
+its backend. The finalized results look like those of a single run.
+
+Once every test has been handed out, workers that ask for more get tests
+that are still running on another worker, and whichever result comes back
+first is kept. This way a slow or dead machine doesn't hold up the end of
+the run.
+
+There is no authentication; the coordinator should only listen on a
+trusted network.
+"""
+
+import collections
+import contextlib
+import json
+import os
+import socket
+import threading
+import time
+import urllib.error
+import urllib.request
+import uuid
+from http.server import HTTPServer, BaseHTTPRequestHandler
+
+from framework import status
+from framework.options import OPTIONS
+from framework.profile import Devices
+from framework.log import LogManager
+from framework.results import TestResult
+from framework.test.base import DummyTest
+
+__all__ = [
+    'Coordinator',
+    'WorkQueue',
+    'coordinate',
+    'work',
+]
+
+# Number of tests a worker thread asks for at once.
+CHUNK_SIZE = 4
+
+# At most this many workers run the same test at the same time.
+MAX_COPIES = 2
+
+
+class WorkQueue(object):
+    """The tests of a run, and which workers they were given to.
+
+    Tests are handed out in order. When there are none left, tests that are
+    still running on other workers are handed out again, oldest first.
+    """
+
+    def __init__(self, names):
+        self._pending = collections.deque(names)
+        self._running = collections.OrderedDict()
+        self._done = set()
+        self.total = len(self._pending)
+
+    @property
+    def finished(self):
+        return len(self._done) == self.total
+
+    def take(self, worker, count):
+        """Return a list of up to count tests for worker to run.
+
+        The second member of the returned tuple lists the tests that were
+        given out for the first time. An empty list of tests means that
+        there is currently nothing to do for this worker.
+        """
+        names = []
+        while self._pending and len(names) < count:
+            name = self._pending.popleft()
+            self._running[name] = {worker}
+            names.append(name)
+        new = list(names)
+
+        if not names:
+            for name, workers in self._running.items():
+                if worker not in workers and len(workers) < MAX_COPIES:
+                    workers.add(worker)
+                    names.append(name)
+                    if len(names) == count:
+                        break
+
+        return names, new
+
+    def complete(self, name):
+        """Mark name as done, return True for its first result only."""
+        if name not in self._running:
+            return False
+        del self._running[name]
+        self._done.add(name)
+        return True
+
+
+class Coordinator(object):
+    """Hands out tests and writes the results that come back.
+
+    Each test is started in the backend and the log when it is first given
+    to a worker, so that an interrupted run can be resumed like a regular
+    one.
+    """
+
+    def __init__(self, names, backend, log):
+        self.queue = WorkQueue(names)
+        self._backend = backend
+        self._log = log
+        self._writers = {}
+
+    def assign(self, worker, count):
+        names, new = self.queue.take(worker, count)
+        for name in new:
+            log = self._log.get()
+            log.start(name)
+            manager = self._backend.write_test(name)
+            self._writers[name] = (manager, manager.__enter__(), log)
+        return names
+
+    def report(self, name, result):
+        if not self.queue.complete(name):
+            return
+        manager, writer, log = self._writers.pop(name)
+        result = TestResult.from_dict(result)
+        writer(result)
+        manager.__exit__(None, None, None)
+        log.log(result.result)
+
+
+class _RequestHandler(BaseHTTPRequestHandler):
+    def do_POST(self):
+        length = int(self.headers.get('Content-Length', 0))
+        request = json.loads(self.rfile.read(length).decode('utf-8'))
+        coordinator = self.server.coordinator
+
+        if self.path == '/next':
+            reply = {
+                'tests': coordinator.assign(request['worker'],
+                                            request['count']),
+                'done': coordinator.queue.finished,
+            }
+        elif self.path == '/result':
+            coordinator.report(request['name'], request['result'])
+            reply = {}
+        else:
+            self.send_response(404)
+            self.end_headers()
+            return
+
+        data = json.dumps(reply).encode('utf-8')
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def log_message(self, *args):
+        # The log already shows what is going on.
+        pass
+
+
+def coordinate(names, backend, address, logger):
+    """Hand out the tests in names until all of them have a result.
+
+    Arguments:
+    names   -- the names of the tests to run, in the order to start them.
+    backend -- a results.Backend derived instance to write the results to.
+    address -- a "[host:]port" string to listen on.
+    logger  -- the name of the log.LogManager logger to use.
+    """
+    host, _, port = address.rpartition(':')
+    log = LogManager(logger, len(names))
+    coordinator = Coordinator(names, backend, log)
+
+    # Requests are tiny, so a single threaded server avoids having to
+    # lock the queue and the backend.
+    httpd = HTTPServer((host, int(port)), _RequestHandler)
+    httpd.coordinator = coordinator
+    try:
+        while not coordinator.queue.finished:
+            httpd.handle_request()
+    finally:
+        httpd.server_close()
+        log.get().summary()
+
+
+def _post(url, path, data):
+    request = urllib.request.Request(
+        url.rstrip('/') + path,
+        data=json.dumps(data).encode('utf-8'),
+        headers={'Content-Type': 'application/json'})
+    with urllib.request.urlopen(request) as f:
+        return json.loads(f.read().decode('utf-8'))
+
+
+def work(url, profiles, logger, concurrency, jobs, backend):
+    """Run tests handed out by the coordinator at url until there are none.
+
+    Results are sent to the coordinator and also written to the local
+    backend, which then holds the part of the run done on this machine.
+    """
+    # Importing this at the top would be circular
+    from framework.backends.json import piglit_encoder
+
+    tests = collections.OrderedDict()
+    for p in profiles:
+        p.setup()
+        for name, test in p.itertests():
+            tests[name] = (test, p.options)
+
+    worker = '{}-{}-{}'.format(socket.gethostname(), os.getpid(),
+                               uuid.uuid4().hex[:8])
+    log = LogManager(logger, len(tests))
+    serial = threading.Lock()
+    devices = Devices(OPTIONS.devices) if OPTIONS.devices else None
+
+    def run():
+        while True:
+            try:
+                reply = _post(url, '/next',
+                              {'worker': worker, 'count': CHUNK_SIZE})
+            except (urllib.error.URLError, ConnectionError):
+                # The coordinator stops once it has all the results
+                return
+
+            if reply['done']:
+                return
+            if not reply['tests']:
+                time.sleep(1)
+                continue
+
+            for name in reply['tests']:
+                if name in tests:
+                    test, options = tests[name]
+                else:
+                    test, options = DummyTest(name, status.NOTRUN), {}
+
+                if concurrency == 'all' or (concurrency == 'some' and
+                                            test.run_concurrent):
+                    lock = contextlib.suppress()
+                else:
+                    lock = serial
+
+                device = devices and devices.pin(test)
+                with lock:
+                    with backend.write_test(name) as w:
+                        test.execute(name, log.get(), options)
+                        if device:
+                            test.result.resources['device'] = device
+                        w(test.result)
+
+                result = json.loads(json.dumps(test.result,
+                                               default=piglit_encoder))
+                try:
+                    _post(url, '/result', {'name': name, 'result': result})
+                except (urllib.error.URLError, ConnectionError):
+                    return
+
+    if concurrency == 'none':
+        jobs = 1
+    threads = [threading.Thread(target=run)
+               for _ in range(jobs or os.cpu_count() or 1)]
+    try:
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+    finally:
+        log.get().summary()
+        for p in profiles:
+            p.teardown()
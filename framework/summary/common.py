@@ -23,6 +23,7 @@
 
 """Shared functions for summary generation."""
 
+import array
 import re
 import operator
 
@@ -51,6 +52,11 @@ class Results(object):  # pylint: disable=too-few-public-methods
         subtests.
 
         """
+        row = self.names._rows.get(name)
+        if row is not None:
+            _, statuses, columns = self.names._columns
+            return [statuses[column[row]] or so.NOTRUN for column in columns]
+
         results = []
         for res in self.results:
             try:
@@ -60,31 +66,50 @@ class Results(object):  # pylint: disable=too-few-public-methods
         return results
 
 
+def _changed_missing(prev, cur):
+    """Changes when a run has no result: anything but skip <-> notrun."""
+    prev = so.NOTRUN if prev is None else prev
+    cur = so.NOTRUN if cur is None else cur
+    return cur != prev and {cur, prev} != {so.SKIP, so.NOTRUN}
+
+
+# The categories that compare each run with the previous one. The first
+# function is used when both runs have a result for the test, the second one
+# when either of them doesn't, which then gets None for it.
+#
+# By ensuring that min(x, y) is >= so.PASS regressions and fixes leave out
+# NOTRUN and SKIP.
+_DIFFS = (
+    ('changes', operator.ne, _changed_missing),
+    ('regressions', lambda x, y: x < y and min(x, y) >= so.PASS, None),
+    ('fixes', lambda x, y: x > y and min(x, y) >= so.PASS, None),
+    ('enabled', lambda x, y: x is so.NOTRUN and y is not so.NOTRUN,
+     lambda x, y: x is None and y is not None),
+    ('disabled', lambda x, y: x is not so.NOTRUN and y is so.NOTRUN,
+     lambda x, y: x is not None and y is None),
+)
+
+# The categories of a single run. It is critical to use is not == for skips,
+# otherwise so.NOTRUN would also be added.
+_SINGLES = (
+    ('problems', lambda x: x > so.PASS),
+    ('skips', lambda x: x is so.SKIP),
+    ('incomplete', lambda x: x is so.INCOMPLETE),
+)
+
+
 class Names(object):
     """Class containing names of tests for various statuses.
 
     Members contain lists of sets of names that have a status.
 
-    Each status is lazily evaluated and cached.
+    The results of every test are looked up once, and all of the categories
+    are then computed together the first time one of them is used.
 
     """
     def __init__(self, tests):
         self.__results = tests.results
 
-    def __diff(self, comparator, handler=None):
-        """Helper for simplifying comparators using find_diffs."""
-        ret = ['']
-        if handler is None:
-            ret.extend(find_diffs(self.__results, self.all, comparator))
-        else:
-            ret.extend(find_diffs(self.__results, self.all, comparator,
-                                  handler=handler))
-        return ret
-
-    def __single(self, comparator):
-        """Helper for simplifying comparators using find_single."""
-        return find_single(self.__results, self.all, comparator)
-
     @lazy_property
     def all(self):
         """A set of all tests in all runs."""
@@ -99,73 +124,126 @@ class Names(object):
         return all_
 
     @lazy_property
-    def changes(self):
-        def handler(names, name, prev, cur):
-            """Handle missing tests.
+    def _columns(self):
+        """The results of all tests, as one column of small ints per run.
 
-            For changes we want literally anything where the first result
-            isn't the same as the second result.
+        Returns the test names, the statuses the ints stand for and the
+        columns, which are aligned on the names. 0 stands for a missing
+        result.
 
-            """
-            def _get(res):
+        """
+        names = list(self.all)
+        statuses = [None]
+        codes = {}
+        columns = []
+        for res in self.__results:
+            column = array.array('H')
+            for name in names:
                 try:
-                    return res.get_result(name)
+                    result = res.get_result(name)
                 except KeyError:
-                    return so.NOTRUN
+                    column.append(0)
+                    continue
+                code = codes.get(id(result))
+                if code is None:
+                    code = codes[id(result)] = len(statuses)
+                    statuses.append(result)
+                column.append(code)
+            columns.append(column)
+        return names, statuses, columns
+
+    @lazy_property
+    def _rows(self):
+        """The index of each test name in the _columns."""
+        return {name: i for i, name in enumerate(self._columns[0])}
 
-            # Add any case of a != b except skip <-> notrun
-            cur = _get(cur)
-            prev = _get(prev)
-            if cur != prev and {cur, prev} != {so.SKIP, so.NOTRUN}:
-                names.add(name)
+    @lazy_property
+    def _diffs(self):
+        """The names of each _DIFFS category, per pair of runs."""
+        names, statuses, columns = self._columns
+        width = len(statuses)
+
+        # Each category gets a bit in a table indexed by the pair of status
+        # codes, so that a single lookup per test finds all of them.
+        masks = []
+        for prev in statuses:
+            for cur in statuses:
+                mask = 0
+                for bit, (_, compare, missing) in enumerate(_DIFFS):
+                    if prev is not None and cur is not None:
+                        hit = compare(prev, cur)
+                    else:
+                        hit = missing is not None and missing(prev, cur)
+                    if hit:
+                        mask |= 1 << bit
+                masks.append(mask)
+
+        diffs = {category: [''] for category, _, _ in _DIFFS}
+        for prev, cur in zip(columns[:-1], columns[1:]):
+            found = [set() for _ in _DIFFS]
+            for name, p, c in zip(names, prev, cur):
+                mask = masks[p * width + c]
+                while mask:
+                    bit = mask & -mask
+                    found[bit.bit_length() - 1].add(name)
+                    mask ^= bit
+            for (category, _, _), names_ in zip(_DIFFS, found):
+                diffs[category].append(names_)
+        return diffs
 
-        return self.__diff(operator.ne, handler=handler)
+    @lazy_property
+    def _singles(self):
+        """The names of each _SINGLES category, per run."""
+        names, statuses, columns = self._columns
+        masks = [0] + [
+            sum(1 << bit for bit, (_, func) in enumerate(_SINGLES)
+                if func(status))
+            for status in statuses[1:]]
+
+        singles = {category: [] for category, _ in _SINGLES}
+        for column in columns:
+            found = [set() for _ in _SINGLES]
+            for name, code in zip(names, column):
+                mask = masks[code]
+                while mask:
+                    bit = mask & -mask
+                    found[bit.bit_length() - 1].add(name)
+                    mask ^= bit
+            for (category, _), names_ in zip(_SINGLES, found):
+                singles[category].append(names_)
+        return singles
+
+    @lazy_property
+    def changes(self):
+        return self._diffs['changes']
 
     @lazy_property
     def problems(self):
-        return self.__single(lambda x: x > so.PASS)
+        return self._singles['problems']
 
     @lazy_property
     def skips(self):
-        # It is critical to use is not == here, otherwise so.NOTRUN will also
-        # be added to this list
-        return self.__single(lambda x: x is so.SKIP)
+        return self._singles['skips']
 
     @lazy_property
     def regressions(self):
-        # By ensureing that min(x, y) is >= so.PASS we eliminate NOTRUN and SKIP
-        # from these pages
-        return self.__diff(lambda x, y: x < y and min(x, y) >= so.PASS)
+        return self._diffs['regressions']
 
     @lazy_property
     def fixes(self):
-        # By ensureing that min(x, y) is >= so.PASS we eliminate NOTRUN and SKIP
-        # from these pages
-        return self.__diff(lambda x, y: x > y and min(x, y) >= so.PASS)
+        return self._diffs['fixes']
 
     @lazy_property
     def enabled(self):
-        def handler(names, name, prev, cur):
-            if _result_in(name, cur) and not _result_in(name, prev):
-                names.add(name)
-
-        return self.__diff(
-            lambda x, y: x is so.NOTRUN and y is not so.NOTRUN,
-            handler=handler)
+        return self._diffs['enabled']
 
     @lazy_property
     def disabled(self):
-        def handler(names, name, prev, cur):
-            if _result_in(name, prev) and not _result_in(name, cur):
-                names.add(name)
-
-        return self.__diff(
-            lambda x, y: x is not so.NOTRUN and y is so.NOTRUN,
-            handler=handler)
+        return self._diffs['disabled']
 
     @lazy_property
     def incomplete(self):
-        return self.__single(lambda x: x is so.INCOMPLETE)
+        return self._singles['incomplete']
 
     @lazy_property
     def all_changes(self):
@@ -276,17 +354,6 @@ def escape_pathname(key):
     return re.sub(r'[/\\]', '_', key)
 
 
-def _result_in(name, result):
-    """If a result (or a subtest result) exists return True, else False."""
-    try:
-        # This is a little hacky, but I don't know of a better way where we
-        # ensure the value is truthy
-        _ = result.get_result(name)
-        return True
-    except KeyError:
-        return False
-
-
 def find_diffs(results, tests, comparator, handler=lambda *a: None):
     """Generate diffs between two or more sets of results.
 
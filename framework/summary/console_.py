@@ -27,6 +27,7 @@ import textwrap
 import time
 
 from framework import grouptools, backends
+from . import timing
 from .common import Results
 
 __all__ = [
@@ -102,10 +103,158 @@ def _print_result(results, list_):
             statuses=' '.join(str(r) for r in results.get_result(test))))
 
 
-def console(resultsFiles, mode):
+def _format_metric(value, unit):
+    return '{:.4g} {}'.format(value, unit)
+
+
+def _print_perf(results):
+    """Print the measurements of perf tests in each run.
+
+    Every run after the first shows its change from the first, positive when
+    it got better.
+    """
+    # Importing this at the top would be circular
+    from framework.test.perf import relative_change
+
+    names = set()
+    for res in results.results:
+        names.update(n for n, t in res.tests.items() if t.metrics)
+
+    for test in sorted(names):
+        metrics = [res.tests[test].metrics if test in res.tests else {}
+                   for res in results.results]
+        metric_names = []
+        for each in metrics:
+            metric_names.extend(m for m in each if m not in metric_names)
+
+        for metric in metric_names:
+            values = []
+            first = metrics[0].get(metric)
+            for each in metrics:
+                current = each.get(metric)
+                if current is None:
+                    values.append('-')
+                elif current is first or not first or not first['value']:
+                    values.append(_format_metric(current['value'],
+                                                 current['unit']))
+                else:
+                    values.append('{} ({:+.1%})'.format(
+                        _format_metric(current['value'], current['unit']),
+                        relative_change(current['value'], first['value'],
+                                        current['unit'])))
+            print("{test}: {metric}: {values}".format(
+                test=grouptools.format(test),
+                metric=metric,
+                values=', '.join(values)))
+
+
+# The order, name, scale and unit of the resources of TestResult
+_RESOURCES = [
+    ('utime', 'user', 1, 's'),
+    ('stime', 'sys', 1, 's'),
+    ('maxrss', 'max rss', 1 / (1 << 20), 'MiB'),
+    ('nvcsw', 'voluntary switches', 1, ''),
+    ('nivcsw', 'involuntary switches', 1, ''),
+]
+
+
+def _resource_values(resources):
+    """Return the resources of a test as (name, value, unit) tuples."""
+    values = [(name, resources[key] * scale, unit)
+              for key, name, scale, unit in _RESOURCES if key in resources]
+    for engine, busy in sorted(resources.get('gpu', {}).items()):
+        values.append(('gpu ' + engine, busy / 1e9, 's'))
+    return values
+
+
+def _print_resources(results):
+    """Print the CPU time, memory, context switches and GPU time of the tests
+    in each run.
+    """
+    names = set()
+    for res in results.results:
+        names.update(n for n, t in res.tests.items() if t.resources)
+
+    for test in sorted(names):
+        values = [
+            dict((n, (v, u)) for n, v, u in _resource_values(
+                res.tests[test].resources if test in res.tests else {}))
+            for res in results.results]
+        seen = []
+        for each in values:
+            seen.extend(n for n in each if n not in seen)
+
+        for name in seen:
+            print("{test}: {name}: {values}".format(
+                test=grouptools.format(test),
+                name=name,
+                values=', '.join(
+                    _format_metric(*each[name]).rstrip() if name in each
+                    else '-' for each in values)))
+
+
+def _format_times(values):
+    """Format the seconds in values, each after the first with its change
+    from the first.
+    """
+    out = []
+    for seconds in values:
+        if seconds is None:
+            out.append('-')
+            continue
+        change = timing.change(seconds, values[0])
+        if seconds is values[0] or change is None:
+            out.append('{:.2f} s'.format(seconds))
+        else:
+            out.append('{:.2f} s ({:+.1%})'.format(seconds, change))
+    return ', '.join(out)
+
+
+def _print_time(results, top):
+    """Print where the time of each run went: the slowest tests, subtests
+    and groups, the durations of the tests of those groups and the time of
+    the tests that timed out or crashed.
+    """
+    timings = [timing.Timing(r) for r in results.results]
+    print('runs: {}'.format(', '.join(t.name for t in timings)))
+
+    for kind in ['tests', 'subtests', 'groups']:
+        names = timing.slowest(timings, kind, top)
+        if not names:
+            continue
+        print('slowest {}:'.format(kind))
+        for name in names:
+            print('    {}: {}'.format(
+                grouptools.format(name),
+                _format_times([getattr(t, kind).get(name) for t in timings])))
+
+    groups = timing.slowest(timings, 'groups', top)
+    if groups:
+        print('durations: {}'.format(' '.join(
+            '{:>7}'.format(b) for b in timing.bucket_names())))
+        for group in groups:
+            for each in timings:
+                print('    {}{}: {}'.format(
+                    grouptools.format(group),
+                    ' ({})'.format(each.name) if len(timings) > 1 else '',
+                    ' '.join('{:>7}'.format(c)
+                             for c in each.histogram(group))))
+
+    print('lost:')
+    for status in timing.LOST:
+        print('    {}: {}'.format(
+            status, _format_times([t.lost[status] for t in timings])))
+    print('    total: {}'.format(_format_times([t.total for t in timings])))
+
+
+def console(resultsFiles, mode, top=20):
     """ Write summary information to the console for the given list of
-    results files in the given mode."""
-    assert mode in ['summary', 'diff', 'incomplete', 'fixes', 'problems', 'regressions', 'all'], mode
+    results files in the given mode.
+
+    top is how many of the slowest tests, subtests and groups the time mode
+    lists.
+    """
+    assert mode in ['summary', 'diff', 'incomplete', 'fixes', 'problems', 'regressions', 'perf', 'resources', 'time', 'all'], mode
     results = Results([backends.load(r) for r in resultsFiles])
 
     # Print the name of the test and the status from each test run
@@ -123,5 +272,11 @@ def console(resultsFiles, mode):
         _print_result(results, results.names.all_problems)
     elif mode == 'regressions':
         _print_result(results, results.names.all_regressions)
+    elif mode == 'perf':
+        _print_perf(results)
+    elif mode == 'resources':
+        _print_resources(results)
+    elif mode == 'time':
+        _print_time(results, top)
     elif mode == 'summary':
         _print_summary(results)
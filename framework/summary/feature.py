@@ -22,9 +22,76 @@
 # OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 # DEALINGS IN THE SOFTWARE.
 
+"""Feature readiness: the pass rate of the tests of each feature.
+
+A feature is the tests of the profile whose names match its include regex
+and not its exclude regex. Matching the regexes of every feature against
+every test is most of the work, so the members of each feature are kept in
+the "feature_index" cache, under a key made of the feature descriptions and
+the identity of the profile, and scoring a run is then only set lookups.
+"""
+
+import hashlib
 import json
+import os
+
+from framework import core, profile, status
+
+# The number of profile and feature description pairs kept in the cache
+_KEEP_INDEXES = 8
+
+
+def _profile_names(prof):
+    """Return the identity of prof and its test names.
+
+    An XML profile with an index is identified by its file, and its names
+    are read from the index without creating the tests.
+
+    """
+    if isinstance(prof, profile.XMLProfile):
+        index = prof._load_index()  # pylint: disable=protected-access
+        if index is not None:
+            stat = os.stat(prof.filename)
+            return ([prof.filename, stat.st_size, stat.st_mtime],
+                    [t[0] for t in index['tests']])
+
+    names = sorted(n for n, _ in prof.itertests())
+    digest = hashlib.sha1('\n'.join(names).encode('utf-8')).hexdigest()
+    return digest, names
+
+
+def _regex_filter(regex, inverse=False):
+    """Return a RegexFilter of regex, which matches all if blank."""
+    return profile.RegexFilter(
+        [regex] if regex and not regex.isspace() else [], inverse=inverse)
+
 
-from framework import profile, status
+def feature_index(prof, feature_data):
+    """Return the set of test names of prof in each feature of feature_data.
+    """
+    identity, names = _profile_names(prof)
+    key = hashlib.sha1(json.dumps(
+        [identity, feature_data], sort_keys=True).encode('utf-8')).hexdigest()
+
+    cache = core.load_cache('feature_index')
+    if key in cache:
+        return {f: set(n) for f, n in cache[key].items()}
+
+    index = {}
+    for feature, desc in feature_data.items():
+        include = _regex_filter(desc["include_tests"])
+        exclude = _regex_filter(desc["exclude_tests"], inverse=True)
+        index[feature] = [n for n in names
+                          if include(n, None) and exclude(n, None)]
+
+    # Keep the newest indexes, the key moves to the end when replaced
+    cache.pop(key, None)
+    cache[key] = index
+    for stale in list(cache)[:-_KEEP_INDEXES]:
+        del cache[stale]
+    core.store_cache('feature_index', cache)
+
+    return {f: set(n) for f, n in index.items()}
 
 
 class FeatResults(object):  # pylint: disable=too-few-public-methods
@@ -40,43 +107,24 @@ class FeatResults(object):  # pylint: disable=too-few-public-methods
 
         self.feat_fractions = {}
         self.feat_status = {}
-        self.features = set()
+        self.features = set(feature_data)
         self.results = results
 
-        profiles = {}
-
         # we expect all the result sets to be for the same profile
         profile_orig = profile.load_test_profile(results[0].options['profile'][0])
-
-        for feature in feature_data:
-            self.features.add(feature)
-
-            profiles[feature] = profile_orig.copy()
-
-            incl_str = feature_data[feature]["include_tests"]
-            excl_str = feature_data[feature]["exclude_tests"]
-
-            profiles[feature].filters.append(
-                profile.RegexFilter(
-                    [incl_str] if incl_str and not incl_str.isspace() else []))
-            profiles[feature].filters.append(
-                profile.RegexFilter(
-                    [excl_str] if excl_str and not excl_str.isspace() else [],
-                    inverse=True))
+        members = feature_index(profile_orig, feature_data)
 
         for results in self.results:
             self.feat_fractions[results.name] = {}
             self.feat_status[results.name] = {}
 
-            for feature in feature_data:
-                result_set = set(results.tests)
-                profile_set = set(a for a, _ in profiles[feature].itertests())
-
-                common_set = profile_set & result_set
-                passed_list = [x for x in common_set if results.tests[x].result == status.PASS]
+            result_set = set(results.tests)
+            passed_set = set(n for n, r in results.tests.items()
+                             if r.result == status.PASS)
 
-                total = len(common_set)
-                passed = len(passed_list)
+            for feature in feature_data:
+                total = len(members[feature] & result_set)
+                passed = len(members[feature] & passed_set)
 
                 self.feat_fractions[results.name][feature] = (passed, total)
                 if total == 0:
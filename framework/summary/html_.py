@@ -25,6 +25,8 @@
 
 import errno
 import getpass
+import json
+import multiprocessing
 import os
 import shutil
 import sys
@@ -38,8 +40,11 @@ from mako.lookup import TemplateLookup
 
 # a local variable status exists, prevent accidental overloading by renaming
 # the module
+import framework.status as so
 from framework import backends, exceptions, core
+from framework.backends.json import piglit_encoder
 
+from . import timing
 from .common import Results, escape_filename, escape_pathname
 from .feature import FeatResults
 
@@ -75,6 +80,74 @@ _TEMPLATES = TemplateLookup(
     module_directory=os.path.join(_TEMP_DIR, "html-summary"))
 
 
+# The name of the file, in the destination, that records what each test
+# page was generated from.
+_DIGESTS = '.digests.json'
+
+# What the page rendering functions work on. This is filled in before the
+# worker processes are forked, so that they inherit it instead of having the
+# results pickled and sent to them.
+_STATE = {}
+
+# The number of tests whose details are in each data file of the client side
+# summary.
+_SHARD_SIZE = 2000
+
+# The pages of the summary, other than all.
+_PAGES = ('changes', 'problems', 'skips', 'fixes', 'regressions', 'enabled',
+          'disabled')
+
+
+def _map(func, items, jobs):
+    """Return the list of func(item) for each of items.
+
+    When possible the calls are spread between jobs processes (the number of
+    CPUs if None). They are forked from this one, so they share the
+    templates it has already compiled, as well as _STATE.
+
+    """
+    items = list(items)
+    if (jobs == 1 or len(items) < 2 or
+            'fork' not in multiprocessing.get_all_start_methods()):
+        return [func(i) for i in items]
+
+    with multiprocessing.get_context('fork').Pool(jobs) as pool:
+        return pool.map(func, items, chunksize=max(1, min(
+            256, len(items) // (4 * (jobs or os.cpu_count() or 1)))))
+
+
+def _test_digest(value):
+    """Return a digest of everything the page of a test shows."""
+    return zlib.crc32(json.dumps(value, default=piglit_encoder,
+                                 sort_keys=True).encode('utf-8'))
+
+
+def _load_digests(destination):
+    """Load the digests of the test pages already in destination.
+
+    Template changes invalidate all of the pages, so in that case nothing is
+    returned.
+
+    """
+    try:
+        with open(os.path.join(destination, _DIGESTS), 'r') as f:
+            digests = json.load(f)
+    except (OSError, ValueError):
+        return {}
+
+    template = os.path.join(_TEMPLATE_DIR, 'test_result.mako')
+    if digests.get('template') != os.stat(template).st_mtime_ns:
+        return {}
+    return digests.get('pages', {})
+
+
+def _write_digests(destination, pages):
+    template = os.path.join(_TEMPLATE_DIR, 'test_result.mako')
+    with open(os.path.join(destination, _DIGESTS), 'w') as f:
+        json.dump({'template': os.stat(template).st_mtime_ns,
+                   'pages': pages}, f)
+
+
 def _copy_static_files(destination):
     """Copy static files into the results directory."""
     shutil.copy(os.path.join(_TEMPLATE_DIR, "index.css"),
@@ -83,13 +156,58 @@ def _copy_static_files(destination):
                 os.path.join(destination, "result.css"))
 
 
-def _make_testrun_info(results, destination, exclude=None):
-    """Create the pages for each results file."""
+def _render_test_page(page):
+    """Write the page of a single test, unless _STATE says it is current.
+
+    Returns the path of the page relative to the destination and the digest
+    of the test, or None if the page couldn't be written.
+
+    """
+    html_path, run, key = page
+    destination = _STATE['destination']
+    value = _STATE['results'].results[run].tests[key]
+    relpath = os.path.relpath(html_path, destination)
+    digest = _test_digest(value)
+
+    if _STATE['digests'].get(relpath) == digest and \
+            os.path.exists(html_path):
+        return relpath, digest
+
+    temp_path = os.path.dirname(html_path)
+    core.check_dir(temp_path)
+
+    try:
+        with open(html_path, 'wb') as out:
+            out.write(_TEMPLATES.get_template(
+                'test_result.mako').render(
+                    testname=key,
+                    value=value,
+                    css=os.path.relpath(
+                        os.path.join(destination, "result.css"), temp_path),
+                    index=os.path.relpath(
+                        os.path.join(destination, "index.html"), temp_path)))
+    except OSError as e:
+        if e.errno == errno.ENAMETOOLONG:
+            print('WARN: filename "{}" too long'.format(html_path))
+            return None
+        else:
+            raise
+
+    return relpath, digest
+
+
+def _make_testrun_info(results, destination, exclude=None, jobs=None,
+                       incremental=False):
+    """Create the pages for each results file.
+
+    With incremental, the pages of tests whose result is the same as when
+    they were last written to destination are left alone.
+
+    """
     exclude = exclude or {}
-    result_css = os.path.join(destination, "result.css")
-    index = os.path.join(destination, "index.html")
+    pages = []
 
-    for each in results.results:
+    for run, each in enumerate(results.results):
         name = escape_pathname(each.name)
         try:
             core.check_dir(os.path.join(destination, name), True)
@@ -110,58 +228,78 @@ def _make_testrun_info(results, destination, exclude=None):
 
         # Then build the individual test results
         for key, value in each.tests.items():
-            html_path = os.path.join(destination, name,
-                                     escape_filename(key + ".html"))
-            temp_path = os.path.dirname(html_path)
-
             if value.result not in exclude:
-                core.check_dir(temp_path)
-
-                try:
-                    with open(html_path, 'wb') as out:
-                        out.write(_TEMPLATES.get_template(
-                            'test_result.mako').render(
-                                testname=key,
-                                value=value,
-                                css=os.path.relpath(result_css, temp_path),
-                                index=os.path.relpath(index, temp_path)))
-                except OSError as e:
-                    if e.errno == errno.ENAMETOOLONG:
-                        print('WARN: filename "{}" too long'.format(html_name))
-                    else:
-                        raise
-
-
-def _make_comparison_pages(results, destination, exclude):
-    """Create the pages of comparisons."""
-    pages = frozenset(['changes', 'problems', 'skips', 'fixes',
-                       'regressions', 'enabled', 'disabled'])
+                pages.append((os.path.join(destination, name,
+                                           escape_filename(key + ".html")),
+                              run, key))
+
+    _STATE['results'] = results
+    _STATE['destination'] = destination
+    _STATE['digests'] = _load_digests(destination) if incremental else {}
+
+    # Compile the template before forking.
+    _TEMPLATES.get_template('test_result.mako')
+    written = _map(_render_test_page, pages, jobs)
+    _write_digests(destination, dict(w for w in written if w is not None))
+
+
+def _render_comparison_page(page):
+    """Write one of the comparison pages, described by _STATE."""
+    results = _STATE['results']
+    destination = _STATE['destination']
+    exclude = _STATE['exclude']
+    pages = _STATE['pages']
 
     # Index.html is a bit of a special case since there is index, all, and
     # alltests, where the other pages all use the same name. ie,
     # changes.html, changes, and page=changes.
-    with open(os.path.join(destination, "index.html"), 'wb') as out:
-        out.write(_TEMPLATES.get_template('index.mako').render(
-            results=results,
-            page='all',
-            pages=pages,
-            exclude=exclude))
-
-    # Generate the rest of the pages
-    for page in pages:
-        with open(os.path.join(destination, page + '.html'), 'wb') as out:
-            # If there is information to display display it
-            if sum(getattr(results.counts, page)) > 0:
-                out.write(_TEMPLATES.get_template('index.mako').render(
-                    results=results,
-                    pages=pages,
-                    page=page,
-                    exclude=exclude))
-            # otherwise provide an empty page
-            else:
-                out.write(
-                    _TEMPLATES.get_template('empty_status.mako').render(
-                        page=page, pages=pages))
+    if page == 'all':
+        with open(os.path.join(destination, "index.html"), 'wb') as out:
+            out.write(_TEMPLATES.get_template('index.mako').render(
+                results=results,
+                page='all',
+                pages=pages,
+                exclude=exclude))
+        return
+
+    with open(os.path.join(destination, page + '.html'), 'wb') as out:
+        # If there is information to display display it
+        if sum(getattr(results.counts, page)) > 0:
+            out.write(_TEMPLATES.get_template('index.mako').render(
+                results=results,
+                pages=pages,
+                page=page,
+                exclude=exclude))
+        # otherwise provide an empty page
+        else:
+            out.write(
+                _TEMPLATES.get_template('empty_status.mako').render(
+                    page=page, pages=pages))
+
+
+def _make_comparison_pages(results, destination, exclude, jobs=None):
+    """Create the pages of comparisons."""
+    pages = frozenset(_PAGES)
+
+    _STATE['results'] = results
+    _STATE['destination'] = destination
+    _STATE['exclude'] = exclude
+    _STATE['pages'] = pages
+
+    # Every page needs the names of all tests, so find them only once, and
+    # compile the templates, before forking.
+    _ = results.names.all
+    _TEMPLATES.get_template('index.mako')
+    _TEMPLATES.get_template('empty_status.mako')
+    _map(_render_comparison_page, ['all'] + sorted(pages), jobs)
+
+
+def _make_time_info(results, destination, top=20):
+    """Create the page of where the time of each run went."""
+    with open(os.path.join(destination, "time.html"), 'wb') as out:
+        out.write(_TEMPLATES.get_template('time.mako').render(
+            timings=[timing.Timing(r) for r in results.results],
+            top=top))
 
 
 def _make_feature_info(results, destination):
@@ -172,7 +310,122 @@ def _make_feature_info(results, destination):
             results=results))
 
 
-def html(results, destination, exclude):
+def _write_script(path, callback, *args):
+    """Write a script calling piglit.<callback>(*args) to path.
+
+    The data of the client side summary is written as scripts rather than
+    JSON, since pages opened from a file:// URL can load scripts but not
+    fetch files.
+
+    """
+    with open(path, 'w') as f:
+        f.write('piglit.{}({});\n'.format(callback, ','.join(
+            json.dumps(a, default=piglit_encoder, separators=(',', ':'))
+            for a in args)))
+
+
+def _group_status(totals):
+    """Return the worst status and the fraction of the totals of a group."""
+    worst = so.NOTRUN
+    num = den = 0
+    for key, value in totals.items():
+        if value > 0:
+            status = so.status_lookup(key)
+            worst = max(worst, status)
+            num += status.fraction[0] * value
+            den += status.fraction[1] * value
+    return [str(worst), '{}/{}'.format(num, den)]
+
+
+def _write_shard(shard):
+    """Write the details of some of the tests of a run, described by _STATE."""
+    run, number, keys = shard
+    tests = _STATE['results'].results[run].tests
+    data = {}
+    for key in keys:
+        value = tests[key].to_json()
+        value['time'] = str(tests[key].time.delta)
+        data[key] = value
+    _write_script(os.path.join(_STATE['destination'], 'data',
+                               'tests-{}-{}.js'.format(run, number)),
+                  'shard', run, number, data)
+
+
+def _make_client_side(results, destination, exclude, jobs=None):
+    """Write the data of the client side summary.
+
+    data/index.js has the status of every test in every run, which is all
+    the summary tables need. The details of the tests are split between
+    data/tests-<run>-<n>.js files of _SHARD_SIZE tests each, in the order
+    of their names, and only the file with the test being looked at is
+    loaded.
+
+    """
+    data_dir = os.path.join(destination, 'data')
+    core.check_dir(data_dir)
+
+    names = sorted(results.names.all)
+    rows = {name: i for i, name in enumerate(names)}
+    statuses = ['notrun']
+    codes = {'notrun': 0}
+    columns = [[] for _ in results.results]
+    for name in names:
+        for column, result in zip(columns, results.get_result(name)):
+            code = codes.get(str(result))
+            if code is None:
+                code = codes[str(result)] = len(statuses)
+                statuses.append(str(result))
+            column.append(code)
+
+    groups = {}
+    for run, each in enumerate(results.results):
+        for group, totals in each.totals.items():
+            groups.setdefault(group, [['notrun', '0/0']] * len(columns))
+            groups[group][run] = _group_status(totals)
+
+    shards = []
+    firsts = []
+    for run, each in enumerate(results.results):
+        keys = sorted(k for k, v in each.tests.items()
+                      if v.result not in exclude)
+        firsts.append(keys[::_SHARD_SIZE])
+        for number, first in enumerate(range(0, len(keys), _SHARD_SIZE)):
+            shards.append((run, number, keys[first:first + _SHARD_SIZE]))
+
+        _write_script(os.path.join(data_dir, 'run-{}.js'.format(run)),
+                      'run', run, {
+                          'name': each.name,
+                          'totals': each.totals['root'],
+                          'time': str(each.time_elapsed.delta),
+                          'options': each.options,
+                          'info': each.info,
+                      })
+
+    _write_script(os.path.join(data_dir, 'index.js'), 'index', {
+        'runs': [each.name for each in results.results],
+        'statuses': statuses,
+        'exclude': sorted(str(s) for s in exclude),
+        'tests': names,
+        'results': columns,
+        'groups': groups,
+        'pages': {page: sorted(rows[n] for n in
+                               getattr(results.names, 'all_' + page))
+                  for page in _PAGES},
+        'shards': firsts,
+    })
+
+    _STATE['results'] = results
+    _STATE['destination'] = destination
+    _map(_write_shard, shards, jobs)
+
+    shutil.copy(os.path.join(_TEMPLATE_DIR, 'summary.html'),
+                os.path.join(destination, 'index.html'))
+    shutil.copy(os.path.join(_TEMPLATE_DIR, 'summary.js'),
+                os.path.join(destination, 'summary.js'))
+
+
+def html(results, destination, exclude, jobs=None, incremental=False,
+         client_side=False):
     """
     Produce HTML summaries.
 
@@ -181,12 +434,28 @@ def html(results, destination, exclude):
     The beauty of this approach is that mako is leveraged to do the
     heavy lifting, this method just passes it a bunch of dicts and lists
     of dicts, which mako turns into pretty HTML.
+
+    The pages are written by up to jobs processes. With incremental, only
+    the test pages that changed since the last summary written to
+    destination are written again.
+
+    With client_side, a single page is written instead, which renders the
+    summary in the browser from data files and loads the details of a test
+    when it is opened.
+
+    time.html shows where the time of each run went, see
+    framework.summary.timing.
     """
     results = Results([backends.load(i) for i in results])
 
     _copy_static_files(destination)
-    _make_testrun_info(results, destination, exclude)
-    _make_comparison_pages(results, destination, exclude)
+    _make_time_info(results, destination)
+    if client_side:
+        _make_client_side(results, destination, exclude, jobs)
+        return
+
+    _make_testrun_info(results, destination, exclude, jobs, incremental)
+    _make_comparison_pages(results, destination, exclude, jobs)
 
 
 def feat(results, destination, feat_desc):
@@ -0,0 +1,118 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Where the time of the tests of runs went, for the time summaries.
+
+The time of a test is the time its result records, so tests that ran at the
+same time each count their own. The time of a group is the sum of the times
+of the tests in it, at any depth. Subtests are only listed when their test
+recorded their times.
+"""
+
+import collections
+
+from framework import grouptools
+
+__all__ = [
+    'BUCKETS',
+    'LOST',
+    'Timing',
+    'bucket_names',
+    'change',
+    'slowest',
+]
+
+# The upper bounds of the buckets of the duration histograms, in seconds. The
+# last bucket has none.
+BUCKETS = [0.1, 1.0, 10.0, 60.0, None]
+
+# The statuses the time of a test is counted as lost with
+LOST = ['timeout', 'crash']
+
+
+def bucket_names():
+    """Return the names of BUCKETS, such as '<1s' and '>=60s'."""
+    names = ['<{:g}s'.format(b) for b in BUCKETS[:-1]]
+    names.append('>={:g}s'.format(BUCKETS[-2]))
+    return names
+
+
+def _bucket(seconds):
+    for i, bound in enumerate(BUCKETS):
+        if bound is None or seconds < bound:
+            return i
+
+
+def change(seconds, first):
+    """Return the relative change from first to seconds, or None."""
+    if seconds is None or not first:
+        return None
+    return (seconds - first) / first
+
+
+class Timing(object):
+    """The times of the tests, subtests and groups of a TestrunResult."""
+
+    def __init__(self, testrun):
+        self.name = testrun.name
+        self.tests = {}
+        self.subtests = {}
+        self.groups = collections.defaultdict(float)
+        self.lost = collections.OrderedDict((s, 0.0) for s in LOST)
+
+        for name, result in testrun.tests.items():
+            seconds = result.time.total
+            self.tests[name] = seconds
+            for sub, sub_seconds in result.subtests.times.items():
+                self.subtests[grouptools.join(name, sub)] = sub_seconds
+
+            group = grouptools.groupname(name)
+            while group:
+                self.groups[group] += seconds
+                group = grouptools.groupname(group)
+
+            status = str(result.result)
+            if status in self.lost:
+                self.lost[status] += seconds
+
+    @property
+    def total(self):
+        return sum(self.tests.values())
+
+    def histogram(self, group):
+        """Return how many tests of group took the time of each of BUCKETS."""
+        counts = [0] * len(BUCKETS)
+        prefix = group + grouptools.SEPARATOR
+        for name, seconds in self.tests.items():
+            if name.startswith(prefix):
+                counts[_bucket(seconds)] += 1
+        return counts
+
+
+def slowest(timings, kind, count):
+    """Return the count names of kind ('tests', 'subtests' or 'groups') that
+    took longest in any of timings, slowest first.
+    """
+    longest = {}
+    for timing in timings:
+        for name, seconds in getattr(timing, kind).items():
+            longest[name] = max(longest.get(name, 0.0), seconds)
+    return sorted(longest, key=lambda n: (-longest[n], n))[:count]
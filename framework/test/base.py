@@ -27,16 +27,26 @@ import abc
 import collections
 import copy
 import errno
+import gzip
+import inspect
 import itertools
+import locale
 import os
+import selectors
 import signal
+import sqlite3
 import subprocess
 import sys
+import tempfile
+import threading
 import time
 import traceback
 import warnings
 
+from framework import coverage
 from framework import exceptions
+from framework import resultcache
+from framework import shadercache
 from framework import status
 from framework.options import OPTIONS
 from framework.results import TestResult
@@ -52,6 +62,43 @@ if os.name == 'posix':
 # pylint: enable=wrong-import-position,wrong-import-order
 
 
+class _RusagePopen(subprocess.Popen):
+    """A Popen that keeps the resource usage of the process once reaped.
+
+    Popen reaps with os.waitpid() in _try_wait() and _internal_poll(), these
+    use os.wait4() instead to get the rusage of the process along with its
+    status.
+    """
+    rusage = None
+
+    def _wait4(self, pid, flags):
+        pid, sts, rusage = os.wait4(pid, flags)
+        if pid == self.pid:
+            self.rusage = rusage
+        return pid, sts
+
+    def _try_wait(self, wait_flags):
+        try:
+            return self._wait4(self.pid, wait_flags)
+        except ChildProcessError:
+            # Like Popen, the child is dead but its status is lost
+            return self.pid, 0
+
+    def _internal_poll(self, *args, **kwargs):
+        kwargs['_waitpid'] = self._wait4
+        return super(_RusagePopen, self)._internal_poll(*args, **kwargs)
+
+
+# The methods _RusagePopen overrides are private, only use it with the ones it
+# was written for.
+if (hasattr(os, 'wait4') and hasattr(subprocess.Popen, '_try_wait') and
+        '_waitpid' in inspect.signature(
+            subprocess.Popen._internal_poll).parameters):
+    _Popen = _RusagePopen
+else:
+    _Popen = subprocess.Popen
+
+
 __all__ = [
     'Test',
     'TestIsSkip',
@@ -98,8 +145,324 @@ def is_crash_returncode(returncode):
         return returncode < 0
 
 
+class _OutputCapture(object):
+    """Collects what a test writes to one of its pipes.
+
+    Without a limit everything is kept. With one, only the first and last
+    limit bytes are kept, along with the lines in between that start with
+    one of KEEP, which are the ones the results are parsed from. The lines
+    are picked out as the output arrives, so the whole of it is never held
+    in memory. If spill_dir is set the whole output of a test that went
+    over the limit is also written there, gzipped.
+    """
+
+    KEEP = (b'PIGLIT',)
+
+    # Lines in the middle of the output are cut to this many bytes
+    MAX_LINE = 65536
+
+    def __init__(self, limit=0, spill_dir=None, prefix='test', suffix='.out'):
+        self.limit = limit
+        self.spill_dir = spill_dir
+        self.prefix = prefix
+        self.suffix = suffix
+        self.spill_path = None
+        self.omitted = 0
+        self._chunks = []
+        self._size = 0
+        self._tail = bytearray()
+        self._line = None
+        self._kept = []
+        self._spill = None
+
+    def write(self, data):
+        if not self.limit:
+            self._chunks.append(data)
+            return
+        if self._spill is not None:
+            self._spill.write(data)
+
+        room = self.limit - self._size
+        if room > 0:
+            self._chunks.append(data[:room])
+            self._size += min(room, len(data))
+            data = data[room:]
+            if not data:
+                return
+
+        if self._line is None:
+            # The first byte past the head, the line it ends goes on from
+            # the last one of the head.
+            head = b''.join(self._chunks)
+            self._chunks = [head]
+            self._line = bytearray(head[head.rfind(b'\n') + 1:])
+            del self._line[self.MAX_LINE:]
+            self._open_spill(head + data)
+
+        self._tail += data
+        excess = len(self._tail) - self.limit
+        if excess > 0:
+            self._drop(self._tail[:excess])
+            del self._tail[:excess]
+
+    def _open_spill(self, data):
+        if not self.spill_dir:
+            return
+        try:
+            os.makedirs(self.spill_dir, exist_ok=True)
+            fd, self.spill_path = tempfile.mkstemp(
+                prefix=self.prefix + '-', suffix=self.suffix + '.gz',
+                dir=self.spill_dir)
+            self._spill = gzip.GzipFile(fileobj=os.fdopen(fd, 'wb'),
+                                        mode='wb')
+            self._spill.write(data)
+        except OSError:
+            self._spill = None
+            self.spill_path = None
+
+    def _drop(self, data):
+        """Count data as omitted, keeping the lines that start with KEEP."""
+        self.omitted += len(data)
+        start = 0
+        while True:
+            end = data.find(b'\n', start)
+            stop = len(data) if end < 0 else end + 1
+            room = self.MAX_LINE - len(self._line)
+            if room > 0:
+                self._line += data[start:min(stop, start + room)]
+            if end < 0:
+                return
+            if self._line.startswith(self.KEEP):
+                if not self._line.endswith(b'\n'):
+                    self._line += b'\n'
+                self._kept.append(bytes(self._line))
+            self._line = bytearray()
+            start = stop
+
+    def value(self):
+        """Return what was kept of the output, as bytes."""
+        if self._spill is not None:
+            fileobj = self._spill.fileobj
+            self._spill.close()
+            fileobj.close()
+            self._spill = None
+            if not self.omitted:
+                os.unlink(self.spill_path)
+                self.spill_path = None
+
+        head = b''.join(self._chunks)
+        if not self.omitted:
+            return head + bytes(self._tail)
+
+        note = '[piglit: {} bytes of output omitted'.format(self.omitted)
+        if self.spill_path:
+            note += ', the whole output is in {}'.format(self.spill_path)
+        note += ']\n'
+        if head and not head.endswith(b'\n'):
+            head += b'\n'
+        return (head + note.encode('ascii') + b''.join(self._kept) +
+                bytes(self._tail))
+
+
+def _output_captures(command):
+    """Return the captures for the stdout and stderr of command."""
+    prefix = os.path.basename(str(command[0])) if command else 'test'
+    return (_OutputCapture(OPTIONS.output_limit, OPTIONS.output_spill_dir,
+                           prefix, '.out'),
+            _OutputCapture(OPTIONS.output_limit, OPTIONS.output_spill_dir,
+                           prefix, '.err'))
+
+
+def _limit_output(text, capture):
+    """Cut text, output that was read all at once, like capture would."""
+    encoding = locale.getpreferredencoding(False)
+    capture.write(text.encode(encoding, 'replace'))
+    return capture.value().decode(encoding, 'replace')
+
+
+class _ProcessLoop(object):
+    """Waits for the output and the timeouts of all running tests.
+
+    With many jobs, having each job thread wait on the pipes of its own test
+    keeps the runner busy switching between threads. This instead handles
+    the pipes and timeouts of every test from one thread and a single
+    selector, and only wakes up the job thread of a test once it is done.
+    Interpreting the output still happens in the job threads.
+
+    Only available on POSIX, where pipes can be selected on.
+    """
+
+    class _Waiter(object):
+        def __init__(self, proc, timeout, captures):
+            self.proc = proc
+            self.captures = captures or (_OutputCapture(), _OutputCapture())
+            self.open = 2
+            self.deadline = time.monotonic() + timeout if timeout else None
+            self.timed_out = False
+            self.done = threading.Event()
+
+    def __init__(self):
+        self.pid = os.getpid()
+        self._selector = selectors.DefaultSelector()
+        self._lock = threading.Lock()
+        self._new = []
+        self._waiting = set()
+        self._exiting = []
+        self._wake_r, self._wake_w = os.pipe()
+        os.set_blocking(self._wake_r, False)
+        self._selector.register(self._wake_r, selectors.EVENT_READ)
+        thread = threading.Thread(target=self._loop, daemon=True)
+        thread.start()
+
+    def wait(self, proc, timeout=None, captures=None):
+        """Wait for proc to exit, return its stdout, stderr and whether it
+        was killed for running longer than timeout seconds.
+
+        The output goes through captures, a pair of _OutputCapture, and is
+        returned as bytes.
+        """
+        waiter = self._Waiter(proc, timeout, captures)
+        with self._lock:
+            self._new.append(waiter)
+        os.write(self._wake_w, b'\0')
+        waiter.done.wait()
+        return (waiter.captures[0].value(), waiter.captures[1].value(),
+                waiter.timed_out)
+
+    def _add_new(self):
+        with self._lock:
+            new, self._new = self._new, []
+        for waiter in new:
+            for i, pipe in enumerate([waiter.proc.stdout, waiter.proc.stderr]):
+                self._selector.register(pipe.fileno(), selectors.EVENT_READ,
+                                        (waiter, i))
+            self._waiting.add(waiter)
+
+    def _all(self):
+        return itertools.chain(self._waiting, self._exiting)
+
+    def _check_timeouts(self):
+        now = time.monotonic()
+        for waiter in self._all():
+            if waiter.deadline is None or waiter.deadline > now:
+                continue
+            if not waiter.timed_out:
+                # Like Test._run_command, give the test 3 seconds to exit
+                # before killing its whole session.
+                waiter.timed_out = True
+                waiter.deadline = now + 3
+                waiter.proc.terminate()
+            else:
+                waiter.deadline = None
+                try:
+                    os.killpg(os.getpgid(waiter.proc.pid), signal.SIGKILL)
+                except OSError:
+                    pass
+
+    def _finish(self, waiter):
+        """Reap the processes whose pipes are closed."""
+        if waiter is not None:
+            self._waiting.discard(waiter)
+            self._exiting.append(waiter)
+        for waiter in list(self._exiting):
+            if waiter.proc.poll() is not None:
+                waiter.proc.stdout.close()
+                waiter.proc.stderr.close()
+                self._exiting.remove(waiter)
+                waiter.done.set()
+
+    def _loop(self):
+        while True:
+            timeout = None
+            deadlines = [w.deadline for w in self._all()
+                         if w.deadline is not None]
+            if deadlines:
+                timeout = max(min(deadlines) - time.monotonic(), 0)
+            if self._exiting:
+                # A process can close its pipes a little before it exits
+                timeout = 0.01 if timeout is None else min(timeout, 0.01)
+
+            for key, _ in self._selector.select(timeout):
+                if key.fileobj == self._wake_r:
+                    try:
+                        os.read(self._wake_r, 4096)
+                    except BlockingIOError:
+                        pass
+                    self._add_new()
+                    continue
+
+                waiter, i = key.data
+                data = os.read(key.fileobj, 65536)
+                if data:
+                    waiter.captures[i].write(data)
+                    continue
+                self._selector.unregister(key.fileobj)
+                waiter.open -= 1
+                if waiter.open == 0:
+                    self._finish(waiter)
+
+            self._check_timeouts()
+            if self._exiting:
+                self._finish(None)
+
+
+_PROCESS_LOOP = None
+_PROCESS_LOOP_LOCK = threading.Lock()
+
+
+def _get_process_loop():
+    """Return the _ProcessLoop of this process, starting it if needed."""
+    global _PROCESS_LOOP
+    with _PROCESS_LOOP_LOCK:
+        # The thread of the loop doesn't survive a fork
+        if _PROCESS_LOOP is None or _PROCESS_LOOP.pid != os.getpid():
+            _PROCESS_LOOP = _ProcessLoop()
+        return _PROCESS_LOOP
+
+
+_ADAPTIVE_TIMEOUTS = None
+_ADAPTIVE_TIMEOUTS_LOCK = threading.Lock()
+
+
+def _adaptive_timeout(name, timeout):
+    """Return the timeout of the test name under OPTIONS.adaptive_timeout.
+
+    timeout, the usual timeout of the test, is kept for tests that aren't in
+    the history, and when it is shorter.
+    """
+    global _ADAPTIVE_TIMEOUTS
+    with _ADAPTIVE_TIMEOUTS_LOCK:
+        if _ADAPTIVE_TIMEOUTS is None:
+            # Importing this at the top would be circular
+            from framework import history
+            try:
+                _ADAPTIVE_TIMEOUTS = history.timeouts(
+                    OPTIONS.adaptive_timeout, OPTIONS.adaptive_timeout_factor,
+                    OPTIONS.adaptive_timeout_floor,
+                    OPTIONS.adaptive_timeout_ceiling)
+            except sqlite3.Error as e:
+                warnings.warn('Not using adaptive timeouts from {}: {}'.format(
+                    OPTIONS.adaptive_timeout, e))
+                _ADAPTIVE_TIMEOUTS = {}
+
+    adaptive = _ADAPTIVE_TIMEOUTS.get(name)
+    if adaptive is None:
+        return timeout
+    return adaptive if timeout is None else min(adaptive, timeout)
+
+
+def _decode_output(data, errors='strict'):
+    """Decode the output of a test like universal_newlines does."""
+    data = data.decode(locale.getpreferredencoding(False), errors)
+    return data.replace('\r\n', '\n').replace('\r', '\n')
+
+
 TestPlaceholder = collections.namedtuple('TestPlaceholder', ['test_class', 'test_name'])
 
+# The resources tests can be scheduled by, see Test.resource_class
+RESOURCE_CLASSES = ('vram', 'host_memory')
+
+
 class Test(metaclass=abc.ABCMeta):
     """ Abstract base class for Test classes
 
@@ -117,20 +480,60 @@ class Test(metaclass=abc.ABCMeta):
 
     Keyword Arguments:
     run_concurrent -- If True the test is thread safe. Default: False
+    resource_class -- The scarce resource the test uses a lot of, one of
+                      RESOURCE_CLASSES, or None. Default: None
+    resource_weight -- The share of that resource the test may use, between
+                       0 and 1. The tests of a class that run at the same time
+                       don't get more than all of it. Default: 1.0
 
     """
-    __slots__ = ['run_concurrent', 'env', 'result', 'cwd', '_command']
+    __slots__ = ['run_concurrent', '_env', '_result', 'cwd', '_command',
+                 'resource_class', 'resource_weight']
     timeout = None
+    # False for tests whose results don't only depend on their inputs and the
+    # driver, which --result-cache must not reuse.
+    cache_results = True
 
-    def __init__(self, command, run_concurrent=False, env=None, cwd=None):
+    def __init__(self, command, run_concurrent=False, env=None, cwd=None,
+                 resource_class=None, resource_weight=1.0):
         assert isinstance(command, list), command
+        assert resource_class is None or resource_class in RESOURCE_CLASSES, \
+            resource_class
+        assert 0 < resource_weight <= 1, resource_weight
 
         self.run_concurrent = run_concurrent
+        self.resource_class = resource_class
+        self.resource_weight = resource_weight
         self._command = copy.copy(command)
-        self.env = env or {}
-        self.result = TestResult()
+        self._env = env or None
+        self._result = None
         self.cwd = cwd
 
+    # A profile can hold hundreds of thousands of tests, most of which never
+    # set an environment and only need a result once they run, so both are
+    # only created when they are first used.
+
+    @property
+    def env(self):
+        if self._env is None:
+            self._env = {}
+        return self._env
+
+    @env.setter
+    def env(self, new):
+        self._env = new
+
+    @property
+    def result(self):
+        if self._result is None:
+            self._result = TestResult()
+        return self._result
+
+    @result.setter
+    def result(self, new):
+        """Set the result, None drops it so that a fresh one is created."""
+        self._result = new
+
     def execute(self, path, log, options):
         """ Run a test
 
@@ -145,12 +548,32 @@ class Test(metaclass=abc.ABCMeta):
         log.start(path)
         # Run the test
         if OPTIONS.execute:
+            cache = resultcache.get()
+            key = cache and cache.key(self)
+            cached = cache.load(key) if key else None
+            if cached is not None:
+                self.result = cached
+                log.log(self.result.result)
+                return
+
+            if OPTIONS.adaptive_timeout and not _SUPPRESS_TIMEOUT:
+                self.timeout = _adaptive_timeout(path, self.timeout)
+
             try:
                 self.result.time.start = time.time()
                 options['dmesg'].update_dmesg()
                 options['monitor'].update_monitoring()
-                self.run()
+                if OPTIONS.coverage_record:
+                    with coverage.record(OPTIONS.coverage_record, path, self):
+                        self.run()
+                else:
+                    self.run()
                 self.result.time.end = time.time()
+                if OPTIONS.shader_cache != 'inherit':
+                    stats = shadercache.parse_stats(
+                        self.result.out + self.result.err)
+                    if stats:
+                        self.result.resources['shader_cache'] = stats
                 self.result = options['dmesg'].update_result(self.result)
                 options['monitor'].check_monitoring()
             # This is a rare case where a bare exception is okay, since we're
@@ -163,6 +586,8 @@ class Test(metaclass=abc.ABCMeta):
                 self.result.traceback = "".join(
                     traceback.format_tb(exc_traceback))
 
+            if key:
+                cache.store(key, self.result)
             log.log(self.result.result)
         else:
             log.log('dry-run')
@@ -273,20 +698,41 @@ class Test(metaclass=abc.ABCMeta):
         fullenv = {str(k): str(v) for k, v in _base}
 
         try:
-            proc = subprocess.Popen(map(str, command),
-                                    stdout=subprocess.PIPE,
-                                    stderr=subprocess.PIPE,
-                                    cwd=self.cwd,
-                                    env=fullenv,
-                                    universal_newlines=True,
-                                    **_EXTRA_POPEN_ARGS)
+            proc = _Popen(map(str, command),
+                          stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE,
+                          cwd=self.cwd,
+                          env=fullenv,
+                          universal_newlines=True,
+                          **_EXTRA_POPEN_ARGS)
 
             self.result.pid.append(proc.pid)
-            if not _SUPPRESS_TIMEOUT:
+            # The process loop reads the output as it comes, which is also
+            # how a limited output is kept bounded.
+            if ((OPTIONS.process_loop or OPTIONS.output_limit) and
+                    os.name == 'posix'):
+                out, err, timed_out = _get_process_loop().wait(
+                    proc, None if _SUPPRESS_TIMEOUT else self.timeout,
+                    _output_captures(command))
+                # A cut can land in the middle of a character
+                errors = 'replace' if OPTIONS.output_limit else 'strict'
+                out = _decode_output(out, errors)
+                err = _decode_output(err, errors)
+                if timed_out:
+                    self._add_rusage(proc)
+                    self.result.out, self.result.err = out, err
+                    message = 'Test run time exceeded timeout value ' \
+                              '({} seconds)\n'.format(self.timeout)
+                    raise TestRunError(message, 'timeout')
+            elif not _SUPPRESS_TIMEOUT:
                 out, err = proc.communicate(timeout=self.timeout)
             else:
                 out, err = proc.communicate()
+            if OPTIONS.output_limit and os.name != 'posix':
+                out, err = (_limit_output(text, capture) for text, capture
+                            in zip((out, err), _output_captures(command)))
             returncode = proc.returncode
+            self._add_rusage(proc)
         except OSError as e:
             # Different sets of tests get built under different build
             # configurations.  If a developer chooses to not build a test,
@@ -310,6 +756,7 @@ class Test(metaclass=abc.ABCMeta):
             # Since the process isn't running it's safe to get any remaining
             # stdout/stderr values out and store them.
             self.result.out, self.result.err = proc.communicate()
+            self._add_rusage(proc)
 
             raise TestRunError(
                 'Test run time exceeded timeout value ({} seconds)\n'.format(
@@ -324,6 +771,12 @@ class Test(metaclass=abc.ABCMeta):
         self.result.err = err
         self.result.returncode = returncode
 
+    def _add_rusage(self, proc):
+        """Add the resource usage of proc, once it is reaped, to the result"""
+        rusage = getattr(proc, 'rusage', None)
+        if rusage is not None:
+            self.result.add_rusage(rusage)
+
     def __eq__(self, other):
         return self.command == other.command
 
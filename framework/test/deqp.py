@@ -20,12 +20,18 @@
 # SOFTWARE.
 
 import abc
+import errno
+import itertools
 import os
+import re
 import subprocess
+import tempfile
+import threading
 
 from framework import core, grouptools, exceptions
 from framework import options
-from framework.profile import TestProfile
+from framework import status
+from framework.profile import TestProfile, load_durations
 from framework.test.base import Test, is_crash_returncode, TestRunError, TestPlaceholder
 
 __all__ = [
@@ -40,6 +46,22 @@ _EXTRA_ARGS = core.get_option('PIGLIT_DEQP_EXTRA_ARGS',
                               ('deqp', 'extra_args'),
                               default='').split()
 
+# When tests are run without process isolation, the cases of a group are run
+# in batches that should take about this many seconds.
+_BATCH_TIME = float(core.get_option('PIGLIT_DEQP_BATCH_TIME',
+                                    ('deqp', 'batch_time'),
+                                    default='20'))
+
+# The time a case is assumed to take when there are no durations to go by.
+_CASE_TIME = 0.1
+
+# The suffix make_batches() gives to the second and later batches of a group.
+_BATCH_SUFFIX = re.compile(r'#\d+(?=@[^@]*$)')
+
+
+_CASE_START = re.compile(r"^Test case '(?P<name>.+)'\.\.$")
+_CASE_END = re.compile(r'^  \w+ \(.*\)$')
+
 
 def select_source(bin_, filename, mustpass, extra_args):
     """Return either the mustpass list or the generated list."""
@@ -51,8 +73,18 @@ def select_source(bin_, filename, mustpass, extra_args):
 
 
 def make_profile(test_list, test_class):
-    """Create a TestProfile instance."""
+    """Create a TestProfile instance.
+
+    Without process isolation, each test of the profile runs a batch of
+    cases in a single dEQP process, see make_batches().
+    """
     profile = TestProfile()
+    if not options.OPTIONS.process_isolation:
+        durations = load_durations(options.OPTIONS.schedule_from)
+        for name, cases in make_batches(test_list, durations):
+            profile.test_list[name] = TestPlaceholder(test_class, cases)
+        return profile
+
     for testname in test_list:
         # deqp uses '.' as the testgroup separator.
         piglit_name = testname.replace('.', grouptools.SEPARATOR)
@@ -61,6 +93,50 @@ def make_profile(test_list, test_class):
     return profile
 
 
+def make_batches(test_list, durations=None):
+    """Split the cases of test_list in batches, yield (name, cases) pairs.
+
+    Each batch holds cases of a single group, which is also the name of the
+    batch, and the cases become its subtests. Groups that are expected to
+    take longer than _BATCH_TIME are split, the second batch of
+    "dEQP-GLES2@functional@foo" being named "dEQP-GLES2@functional@foo#2".
+
+    durations maps test names to run times, as returned by load_durations().
+    A previous batched run gives the durations of the cases through their
+    subtests.
+    """
+    if durations:
+        durations = {_BATCH_SUFFIX.sub('', k): v for k, v in durations.items()}
+        known = sorted(durations.values())
+        default = known[len(known) // 2]
+    else:
+        durations = {}
+        default = _CASE_TIME
+
+    counts = {}
+    for group, cases in itertools.groupby(
+            test_list, key=lambda c: c.rpartition('.')[0]):
+        group = group.replace('.', grouptools.SEPARATOR)
+        batch, time_ = [], 0.0
+        for case in cases:
+            duration = durations.get(
+                case.replace('.', grouptools.SEPARATOR).lower(), default)
+            if batch and time_ + duration > _BATCH_TIME:
+                yield _batch_name(group, counts), tuple(batch)
+                batch, time_ = [], 0.0
+            batch.append(case)
+            time_ += duration
+        yield _batch_name(group, counts), tuple(batch)
+
+
+def _batch_name(group, counts):
+    """Return the name of the next batch of group."""
+    counts[group] = counts.get(group, 0) + 1
+    if counts[group] == 1:
+        return group
+    return '{}#{}'.format(group, counts[group])
+
+
 def gen_mustpass_tests(mustpass):
     """Return a testlist from the mustpass list."""
     with open(mustpass, 'r') as f:
@@ -87,9 +163,26 @@ def gen_caselist_txt(bin_, caselist, extra_args):
     #      build host. In other words, when the build host and test target
     #      differ then we cannot pre-generate the caselist on the build host:
     #      we must *dynamically* generate it during the testrun.
+    #
+    # Generating the caselist takes a while for the larger suites, so the
+    # file is reused for as long as neither the binary nor the file itself
+    # changed since it was generated.
     basedir = os.path.dirname(bin_)
     caselist_path = os.path.join(basedir, caselist)
 
+    key = '\0'.join([os.path.realpath(bin_), caselist] + list(extra_args))
+    identity = core.binary_identity(bin_)
+    cache = core.load_cache('deqp_caselist')
+    entry = cache.get(key)
+    if identity is not None and entry and entry['binary'] == identity:
+        try:
+            st = os.stat(caselist_path)
+        except OSError:
+            pass
+        else:
+            if entry['caselist'] == [st.st_mtime_ns, st.st_size]:
+                return caselist_path
+
     # TODO: need to catch some exceptions here...
     with open(os.devnull, 'w') as d:
         env = os.environ.copy()
@@ -100,6 +193,14 @@ def gen_caselist_txt(bin_, caselist, extra_args):
             [bin_, '--deqp-runmode=txt-caselist'] + extra_args, cwd=basedir,
             stdout=d, stderr=d, env=env)
     assert os.path.exists(caselist_path)
+
+    if identity is not None:
+        st = os.stat(caselist_path)
+        # Other profiles may have stored their caselists in the meantime
+        cache = core.load_cache('deqp_caselist')
+        cache[key] = {'binary': identity,
+                      'caselist': [st.st_mtime_ns, st.st_size]}
+        core.store_cache('deqp_caselist', cache)
     return caselist_path
 
 
@@ -142,7 +243,13 @@ class DEQPBaseTest(Test, metaclass=abc.ABCMeta):
         return _EXTRA_ARGS
 
     def __init__(self, case_name):
-        command = [self.deqp_bin, '--deqp-case=' + case_name]
+        """Run case_name, or each case of a tuple of cases as subtests."""
+        if isinstance(case_name, tuple):
+            self.cases = case_name
+            command = [self.deqp_bin]
+        else:
+            self.cases = None
+            command = [self.deqp_bin, '--deqp-case=' + case_name]
 
         super(DEQPBaseTest, self).__init__(command)
 
@@ -151,25 +258,50 @@ class DEQPBaseTest(Test, metaclass=abc.ABCMeta):
         # This must be called after super or super will overwrite it
         self.cwd = os.path.dirname(self.deqp_bin)
 
+        if self.cases is not None:
+            self.result.subtests.update(
+                {self._subtest_name(c): status.NOTRUN for c in self.cases})
+
     @Test.command.getter
     def command(self):
         """Return the command plus any extra arguments."""
         command = super(DEQPBaseTest, self).command
         return command + self.extra_args
 
-    def __find_map(self):
-        """Run over the lines and set the result."""
+    @staticmethod
+    def _subtest_name(case):
+        """Return the name of case as a subtest of its batch."""
+        return case.rpartition('.')[2]
+
+    def _case_status(self, out):
+        """Return the status printed in out, the output of one case.
+
+        Returns None if there isn't one.
+        """
         # splitting this into a separate function allows us to return cleanly,
         # otherwise this requires some break/else/continue madness
-        for line in self.result.out.split('\n'):
+        for line in out.split('\n'):
             line = line.lstrip()
             for k, v in self.__RESULT_MAP.items():
                 if line.startswith(k):
-                    self.result.result = v
-                    return
+                    return v
+        return None
+
+    def _stop_status(self, out):
+        """Return the status of a case that stopped dEQP, given its output."""
+        return status.CRASH
+
+    def __find_map(self):
+        """Run over the lines and set the result."""
+        result = self._case_status(self.result.out)
+        if result is not None:
+            self.result.result = result
 
     def interpret_result(self):
-        if is_crash_returncode(self.result.returncode):
+        if self.cases is not None:
+            # The subtests were set while running the batch.
+            self.result.result = max(self.result.subtests.values())
+        elif is_crash_returncode(self.result.returncode):
             self.result.result = 'crash'
         elif self.result.returncode != 0:
             self.result.result = 'fail'
@@ -182,6 +314,10 @@ class DEQPBaseTest(Test, metaclass=abc.ABCMeta):
 
     def _run_command(self, *args, **kwargs):
         """Rerun the command if X11 connection failure happens."""
+        if self.cases is not None:
+            self._run_batch()
+            return
+
         for _ in range(5):
             super(DEQPBaseTest, self)._run_command(*args, **kwargs)
             x_err_msg = "FATAL ERROR: Failed to open display"
@@ -190,3 +326,108 @@ class DEQPBaseTest(Test, metaclass=abc.ABCMeta):
             return
 
         raise TestRunError('Failed to connect to X server 5 times', 'fail')
+
+    def _run_batch(self):
+        """Run the cases of the batch, restarting dEQP from the next case
+        whenever one crashes or times out.
+
+        Like ReducedProcessMixin, the output of each dEQP process is joined
+        with "\n\n====RESUME====\n\n". The timeout applies to each case
+        rather than to the whole batch.
+        """
+        _base = itertools.chain(os.environ.items(),
+                                options.OPTIONS.env.items(),
+                                self.env.items())
+        fullenv = {str(k): str(v) for k, v in _base}
+
+        remaining = list(self.cases)
+        out = []
+        returncode = 0
+        while remaining:
+            run_out, run_returncode, statuses = self.__run_cases(remaining,
+                                                                 fullenv)
+            if not statuses:
+                # dEQP stopped before starting any case; blame the first one
+                # so that this can't loop forever.
+                statuses[remaining[0]] = self._stop_status(run_out)
+
+            for case, result in statuses.items():
+                self.result.subtests[self._subtest_name(case)] = result
+            remaining = [c for c in remaining if c not in statuses]
+
+            out.append(run_out)
+            if returncode == 0:
+                returncode = run_returncode
+
+        self.result.out = '\n\n====RESUME====\n\n'.join(out)
+        self.result.err = ''
+        self.result.returncode = returncode
+
+    def __run_cases(self, cases, env):
+        """Run cases in one dEQP process.
+
+        Returns the output, the returncode and a dict of the status of each
+        case that was started.
+        """
+        with tempfile.NamedTemporaryFile('w', prefix='piglit-deqp-',
+                                         suffix='.txt', delete=False) as f:
+            f.write('\n'.join(cases) + '\n')
+
+        command = [self.deqp_bin, '--deqp-caselist-file=' + f.name] + \
+            self.extra_args
+        try:
+            proc = subprocess.Popen([str(c) for c in command],
+                                    stdout=subprocess.PIPE,
+                                    stderr=subprocess.STDOUT,
+                                    cwd=self.cwd,
+                                    env=env,
+                                    universal_newlines=True)
+        except OSError as e:
+            os.unlink(f.name)
+            if e.errno == errno.ENOENT:
+                raise TestRunError("Test executable not found.\n", 'skip')
+            raise
+        self.result.pid.append(proc.pid)
+
+        killed = []
+
+        def kill():
+            killed.append(True)
+            proc.kill()
+
+        out = []
+        statuses = {}
+        current, case_out, timer = None, [], None
+        try:
+            for line in proc.stdout:
+                out.append(line)
+                match = _CASE_START.match(line)
+                if match:
+                    current, case_out = match.group('name'), []
+                    if timer is not None:
+                        timer.cancel()
+                    if self.timeout:
+                        timer = threading.Timer(self.timeout, kill)
+                        timer.start()
+                elif current is not None:
+                    case_out.append(line)
+                    if not _CASE_END.match(line):
+                        continue
+                    if timer is not None:
+                        timer.cancel()
+                    result = self._case_status(''.join(case_out))
+                    statuses[current] = result or status.FAIL
+                    current = None
+        finally:
+            if timer is not None:
+                timer.cancel()
+            returncode = proc.wait()
+            os.unlink(f.name)
+
+        if current is not None:
+            if killed:
+                statuses[current] = status.TIMEOUT
+            else:
+                statuses[current] = self._stop_status(''.join(case_out))
+
+        return ''.join(out), returncode, statuses
@@ -30,14 +30,15 @@ import sys
 import re
 import io
 
-from framework import exceptions, options
-from .base import TestIsSkip
-from .opengl import FastSkipMixin
+from framework import exceptions, options, status
+from .base import ReducedProcessMixin, TestIsSkip
+from .opengl import FastSkipMixin, FastSkip
 from .piglit_test import PiglitBaseTest, TEST_BIN_DIR, ROOT_DIR
 
 __all__ = [
     'GLSLParserTest',
     'GLSLParserNoConfigError',
+    'MultiGLSLParserTest',
 ]
 
 # In different configurations piglit may have one or both of these.
@@ -282,6 +283,17 @@ class Parser(object):
         return keys
 
 
+def _check_binary(binary):
+    """Raise TestIsSkip if the glslparsertest binary wasn't built."""
+    if os.path.basename(binary) == 'glslparsertest' and not _HAS_GL_BIN:
+        raise TestIsSkip('Test is for desktop OpenGL, but piglit was not '
+                         'built with OpenGL support.')
+    elif (os.path.basename(binary) == 'glslparsertest_gles2'
+          and not _HAS_GLES_BIN):
+        raise TestIsSkip('Test is for OpenGL ES, but piglit was not '
+                         'built with OpenGL ES support.')
+
+
 class GLSLParserTest(FastSkipMixin, PiglitBaseTest):
     """A Test derived class specifically for glslparser.
 
@@ -323,12 +335,143 @@ class GLSLParserTest(FastSkipMixin, PiglitBaseTest):
             shader_version=parsed.shader_version)
 
     def is_skip(self):
-        if os.path.basename(self.command[0]) == 'glslparsertest' and not _HAS_GL_BIN:
-            raise TestIsSkip('Test is for desktop OpenGL, but piglit was not '
-                             'built with OpenGL support.')
-        elif (os.path.basename(self.command[0]) == 'glslparsertest_gles2'
-              and not _HAS_GLES_BIN):
-            raise TestIsSkip('Test is for OpenGL ES, but piglit was not '
-                             'built with OpenGL ES support.')
-
-        super(GLSLParserTest, self).is_skip()
+        _check_binary(self.command[0])
+        if options.OPTIONS.glslparser_offline:
+            # The requirements of the test need a context to be checked
+            super(FastSkipMixin, self).is_skip()
+        else:
+            super(GLSLParserTest, self).is_skip()
+
+
+class MultiGLSLParserTest(ReducedProcessMixin, PiglitBaseTest):
+    """Run several glslparser tests in one glslparsertest process.
+
+    glslparsertest --batch compiles all of them in the context for one GLSL
+    version, and reports each as a subtest named after its file. The tests
+    that skip in the python layer are left out of the command, and the run
+    is resumed after a test that crashes.
+
+    Arguments:
+    prog -- the glslparsertest binary to use
+    version -- the glsl_version of all of the tests
+    tests -- a list with the glslparsertest arguments of each test, starting
+             with its file
+    subtests -- the subtest name of each test
+    skips -- the FastSkip arguments of each test
+    """
+
+    def __init__(self, prog, version, tests, subtests, skips, env=None):
+        super(MultiGLSLParserTest, self).__init__(
+            self._batch(prog, version, tests),
+            subtests=subtests,
+            run_concurrent=True,
+            env=env)
+
+        self.prog = prog
+        self.version = version
+        self.tests = tests
+        self.subtests = subtests
+        self.skips = [FastSkip(**s) for s in skips]
+        self._tests = tests
+
+    @staticmethod
+    def _batch(prog, version, tests):
+        command = [prog, '--batch', version]
+        for i, args in enumerate(tests):
+            if i:
+                command.append('--')
+            command.extend(args)
+        return command
+
+    @classmethod
+    def new(cls, filenames, installednames=None):
+        """Parse the files and create an instance.
+
+        All of the files must want the same glsl_version, and thus the same
+        binary.
+        """
+        assert filenames
+        installednames = installednames or [None] * len(filenames)
+        prog = None
+        version = None
+        tests = []
+        subtests = []
+        skips = []
+
+        for filename, installname in zip(filenames, installednames):
+            parsed = Parser(filename, installname)
+            if prog is None:
+                prog = parsed.command[0]
+                version = parsed.config['glsl_version']
+            elif parsed.config['glsl_version'] != version:
+                raise exceptions.PiglitInternalError(
+                    'GLSL versions {} and {} in the same command!\n'
+                    'in file: {}'.format(version,
+                                         parsed.config['glsl_version'],
+                                         filename))
+
+            tests.append(parsed.command[1:])
+            subtests.append(os.path.basename(filename).lower())
+            skips.append({
+                'extensions': parsed.extensions,
+                'shader_version': parsed.shader_version,
+                'api': parsed.api,
+            })
+
+        return cls(prog, version, tests, subtests, skips)
+
+    def _process_skips(self):
+        tests = []
+        expected = []
+        offline = options.OPTIONS.glslparser_offline
+        for test, name, skip in zip(self.tests, self.subtests, self.skips):
+            try:
+                if not offline:
+                    skip.test()
+            except TestIsSkip:
+                self.result.subtests[name] = status.SKIP
+            else:
+                tests.append(test)
+                expected.append(name)
+
+        self._tests = tests
+        self._expected = expected
+
+    def is_skip(self):
+        _check_binary(self.prog)
+        super(MultiGLSLParserTest, self).is_skip()
+
+    def run(self):
+        self._process_skips()
+        super(MultiGLSLParserTest, self).run()
+
+    def _command_for(self, tests):
+        tests = [[os.path.join(ROOT_DIR, t[0])] + t[1:] for t in tests]
+        return self.keys() + self._batch(
+            os.path.join(TEST_BIN_DIR, self.prog), self.version, tests)
+
+    @PiglitBaseTest.command.getter
+    def command(self):
+        return self._command_for(self._tests)
+
+    def _is_subtest(self, line):
+        return line.startswith('PIGLIT TEST:')
+
+    def _resume(self, current):
+        return self._command_for(self._tests[current:])
+
+    def _stop_status(self):
+        # A test that exits with a skip, instead of reporting a subtest,
+        # skips. The run is resumed after it either way.
+        if self.result.out.endswith('PIGLIT: {"result": "skip" }\n'):
+            return status.SKIP
+        if self.result.returncode > 0:
+            return status.FAIL
+        return status.CRASH
+
+    def _is_cherry(self):
+        # glslparsertest exits with 0 when it skips, so only a run that
+        # didn't end with a skip is complete.
+        return (
+            self.result.returncode == 0 and not
+            self.result.out.endswith('PIGLIT: {"result": "skip" }\n'))
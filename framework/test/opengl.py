@@ -59,6 +59,12 @@ class FastSkip(object):
 
     info = wflinfo.WflInfo()
 
+    # The result of _check() for each set of requirements, as long as info is
+    # _decisions_info. Many tests share the same requirements, so this is
+    # much smaller than the number of tests.
+    _decisions = {}
+    _decisions_info = None
+
     def __init__(self, api=None, extensions=None, api_version=None,
                  shader_version=None):
         self.extensions = extensions or set()
@@ -75,6 +81,22 @@ class FastSkip(object):
         Raises:
         TestIsSkip   -- if any of the conditions passed to self are false
         """
+        if FastSkip._decisions_info is not self.info:
+            FastSkip._decisions = {}
+            FastSkip._decisions_info = self.info
+
+        key = (self.api, frozenset(self.extensions), self.api_version,
+               self.shader_version)
+        try:
+            reason = FastSkip._decisions[key]
+        except KeyError:
+            reason = FastSkip._decisions[key] = self._check()
+
+        if reason is not None:
+            raise TestIsSkip(reason)
+
+    def _check(self):
+        """Return why the test should be skipped, or None."""
         if not self.api:
             check = self.info.compat
         elif self.api in ['gles2', 'gles3']:
@@ -87,27 +109,26 @@ class FastSkip(object):
         if check.extensions:
             for extension in self.extensions:
                 if extension not in check.extensions:
-                    raise TestIsSkip(
-                        'Test requires extension {} '
-                        'which is not available'.format(extension))
+                    return ('Test requires extension {} '
+                            'which is not available'.format(extension))
 
         # TODO: Be able to handle any operator
         if (check.api_version is not None
                 and self.api_version is not None
                 and self.api_version > check.api_version):
-            raise TestIsSkip(
-                'Test requires OpenGL {} version {}, '
-                'but only {} is available'.format(
-                    self.api, self.api_version, check.api_version))
+            return ('Test requires OpenGL {} version {}, '
+                    'but only {} is available'.format(
+                        self.api, self.api_version, check.api_version))
 
         # TODO: Be able to handle any operator
         if (check.shader_version is not None
                 and self.shader_version is not None
                 and self.shader_version > check.shader_version):
-            raise TestIsSkip(
-                'Test requires OpenGL {} Shader Language version {}, '
-                'but only {} is available'.format(
-                    self.api, self.shader_version, check.shader_version))
+            return ('Test requires OpenGL {} Shader Language version {}, '
+                    'but only {} is available'.format(
+                        self.api, self.shader_version, check.shader_version))
+
+        return None
 
 
 class FastSkipMixin(object):
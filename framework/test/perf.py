@@ -0,0 +1,342 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Run the benchmarks of tests/perf as piglit tests.
+
+The benchmarks write the statistics of each of their measurements with
+perf_report() to the file named by PIGLIT_PERF_JSON, one JSON object per line.
+PerfTest stores these in the metrics of its result and adds a subtest per
+measurement. When a baseline run is given, a measurement that got worse by more
+than the threshold fails, or warns if either side was too noisy to tell.
+Measurements the benchmark reports as unstable, because the clocks moved or
+something was throttled while they were taken, always warn, and so don't
+fail.
+
+With PIGLIT_PERF_COUNTERS in the environment, the benchmarks also report the
+GPU counters of each measurement, per iteration, as "<measurement>:
+<counter>". These are compared with the baseline to explain a change, but
+don't become subtests themselves.
+
+With --perf-config, each benchmark instead runs under every given environment
+configuration, such as mesa_glthread=true and false, for --perf-rounds rounds
+with the runs of the configurations interleaved. Each measurement becomes one
+metric per configuration, named "<measurement> [<configuration>]", with the
+mean over the rounds and its confidence interval; those of the configurations
+after the first also get their change from the first one.
+"""
+
+import json
+import math
+import os
+import tempfile
+import threading
+
+from framework import status
+from framework.options import OPTIONS
+from .piglit_test import PiglitBaseTest
+
+__all__ = [
+    'PerfTest',
+    'compare_to_baseline',
+    'config_metrics',
+    'perf_config',
+    'relative_change',
+    't_975',
+]
+
+# Units of times and sizes, where a smaller number is better. The others are
+# rates.
+_LOWER_IS_BETTER = frozenset(['s', 'ms', 'us', 'usec', 'ns', 'MB'])
+
+_BASELINES = {}
+_BASELINES_LOCK = threading.Lock()
+
+# The 97.5th percentile of Student's t distribution by degrees of freedom, for
+# two-sided 95% confidence intervals. Past the table it is close enough to
+# the normal distribution.
+_T_975 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262,
+          2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101,
+          2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052,
+          2.048, 2.045, 2.042]
+
+
+def t_975(dof):
+    if dof <= len(_T_975):
+        return _T_975[dof - 1]
+    if dof <= 60:
+        return 2.000
+    return 1.960
+
+
+def _mean_ci(values):
+    """Return the mean of values and the half width of its 95% interval."""
+    count = len(values)
+    mean = sum(values) / count
+    if count < 2:
+        return mean, 0.0
+    stddev = math.sqrt(sum((v - mean) ** 2 for v in values) / (count - 1))
+    return mean, t_975(count - 1) * stddev / math.sqrt(count)
+
+
+def perf_config(value):
+    """Parse a --perf-config value, NAME[:VAR=VALUE[,VAR=VALUE...]].
+
+    Return [NAME, {VAR: VALUE}], which survives the round trip through the
+    JSON of the results when a run is resumed.
+    """
+    name, _, assignments = value.partition(':')
+    if not name:
+        raise ValueError('a configuration needs a name')
+    env = {}
+    for assignment in filter(None, assignments.split(',')):
+        var, sep, val = assignment.partition('=')
+        if not sep or not var:
+            raise ValueError('expected VAR=VALUE, got {!r}'.format(assignment))
+        env[var] = val
+    return [name, env]
+
+
+def relative_change(value, baseline, unit):
+    """Return how much better value is than baseline, as a fraction.
+
+    The result is negative when value is worse, whichever direction is better
+    for unit.
+    """
+    change = (value - baseline) / baseline
+    return -change if unit in _LOWER_IS_BETTER else change
+
+
+def _get_baseline(path):
+    """Load the results at path once per process."""
+    # Importing this at the top would be circular
+    from framework import backends
+
+    with _BASELINES_LOCK:
+        if path not in _BASELINES:
+            _BASELINES[path] = backends.load(path)
+        return _BASELINES[path]
+
+
+def _baseline_metrics(name):
+    if not OPTIONS.perf_baseline or name is None:
+        return {}
+    base = _get_baseline(OPTIONS.perf_baseline).tests.get(name)
+    return base.metrics if base is not None else {}
+
+
+def _significant(metric, base):
+    """Return whether the change from base to metric isn't just noise.
+
+    When both have a confidence interval the change is significant if the
+    intervals don't overlap, otherwise if neither is noisy.
+    """
+    if metric.get('unstable') or base.get('unstable'):
+        return False
+    if 'ci' in metric and 'ci' in base:
+        return abs(metric['value'] - base['value']) > metric['ci'] + base['ci']
+    return not (metric['noisy'] or base.get('noisy'))
+
+
+def compare_to_baseline(name, metrics):
+    """Compare metrics with those of the test name in the baseline run.
+
+    Add the baseline value and the change to each metric found in the
+    baseline, and return the status of each metric to use as subtests. GPU
+    counters only get their baseline and raw change.
+    """
+    baseline = _baseline_metrics(name)
+    subtests = {}
+    for metric_name, metric in metrics.items():
+        base = baseline.get(metric_name)
+        if metric.get('counter'):
+            if base and base['value']:
+                metric['baseline'] = base['value']
+                metric['change'] = (
+                    (metric['value'] - base['value']) / base['value'])
+            continue
+
+        result = status.PASS
+        if base and base['value']:
+            metric['baseline'] = base['value']
+            metric['change'] = relative_change(
+                metric['value'], base['value'], metric['unit'])
+            if metric['change'] < -OPTIONS.perf_threshold:
+                if _significant(metric, base):
+                    result = status.FAIL
+                else:
+                    result = status.WARN
+        if metric.get('unstable'):
+            result = status.WARN
+        subtests[metric_name] = result
+    return subtests
+
+
+def config_metrics(configs, runs):
+    """Combine the metrics of the runs of each configuration.
+
+    runs maps the name of each of configs to the metrics of its runs, one per
+    round. The runs of the other configurations are compared with those of the
+    first one of the same round, so that drift across the rounds cancels out.
+    """
+    base_name = configs[0][0]
+    metrics = {}
+    for name, _ in configs:
+        names = sorted(set(m for run in runs[name] for m in run))
+        for metric_name in names:
+            found = [run[metric_name] for run in runs[name]
+                     if metric_name in run]
+            unit = found[0]['unit']
+            value, ci = _mean_ci([m['value'] for m in found])
+            metric = {
+                'value': value,
+                'unit': unit,
+                'ci': ci,
+                'samples': len(found),
+                'noisy': any(m['noisy'] for m in found),
+            }
+            if any(m.get('unstable') for m in found):
+                metric['unstable'] = True
+
+            changes = [
+                relative_change(run[metric_name]['value'],
+                                base[metric_name]['value'], unit)
+                for run, base in zip(runs[name], runs[base_name])
+                if metric_name in run and metric_name in base and
+                base[metric_name]['value']]
+            if name != base_name and changes:
+                metric['delta'], metric['delta_ci'] = _mean_ci(changes)
+
+            metrics['{} [{}]'.format(metric_name, name)] = metric
+    return metrics
+
+
+class PerfTest(PiglitBaseTest):
+    """A benchmark of tests/perf.
+
+    These never run concurrently with other tests, which would skew the
+    measurements. Unlike PiglitGLTest this doesn't add -auto, which most of
+    the benchmarks don't expect among their own arguments; they exit once they
+    are done either way.
+    """
+    # The measurements change from one run to the next
+    cache_results = False
+
+    def __init__(self, command, **kwargs):
+        kwargs['run_concurrent'] = False
+        super(PerfTest, self).__init__(command, **kwargs)
+        self.name = None
+
+    def execute(self, path, log, options):
+        # The name is needed to find the same test in the baseline.
+        self.name = path
+        super(PerfTest, self).execute(path, log, options)
+
+    def _run_command(self, *args, **kwargs):
+        if not OPTIONS.perf_configs:
+            self.result.metrics.update(self._run_once({}, *args, **kwargs))
+            return
+
+        configs = OPTIONS.perf_configs
+        runs = {name: [] for name, _ in configs}
+        out = []
+        for round_ in range(OPTIONS.perf_rounds):
+            # Alternate the order so that the first and last configurations
+            # don't always run on a colder or warmer machine.
+            for name, env in configs if round_ % 2 == 0 else configs[::-1]:
+                metrics = self._run_once(env, *args, **kwargs)
+                out.append('[{}]\n{}'.format(name, self.result.out))
+                if self.result.returncode != 0:
+                    self.result.out = '\n'.join(out)
+                    return
+                runs[name].append(metrics)
+
+        self.result.metrics.update(config_metrics(configs, runs))
+        out.append(self._format_deltas(configs))
+        self.result.out = '\n'.join(out)
+
+    def _run_once(self, env, *args, **kwargs):
+        """Run the benchmark with env added, and return its metrics."""
+        fd, path = tempfile.mkstemp(prefix='piglit-perf-', suffix='.json')
+        os.close(fd)
+
+        saved_env = self.env
+        self.env = dict(saved_env)
+        self.env.update(env)
+        self.env['PIGLIT_PERF_JSON'] = path
+        try:
+            super(PerfTest, self)._run_command(*args, **kwargs)
+            with open(path, 'r') as f:
+                return self._parse_metrics(f)
+        finally:
+            self.env = saved_env
+            os.unlink(path)
+
+    @staticmethod
+    def _parse_metrics(f):
+        metrics = {}
+        for line in f:
+            try:
+                report = json.loads(line)
+            except ValueError:
+                # The last line of a benchmark that crashed
+                continue
+
+            metrics[report['name']] = {
+                'value': report['median'],
+                'unit': report['unit'],
+                'stddev': report['stddev'],
+                'cv': report['cv'],
+                'samples': report['samples'],
+                'noisy': report['noisy'],
+            }
+            if report.get('counter'):
+                metrics[report['name']]['counter'] = True
+            for key in ['gpu_mhz', 'cpu_mhz']:
+                if report.get(key):
+                    metrics[report['name']][key] = report[key]
+            if report.get('unstable'):
+                metrics[report['name']]['unstable'] = True
+        return metrics
+
+    def _read_metrics(self, f):
+        self.result.metrics.update(self._parse_metrics(f))
+
+    def _format_deltas(self, configs):
+        """Return the change of each metric from the first configuration."""
+        lines = ['Changes from [{}]:'.format(configs[0][0])]
+        for name, metric in sorted(self.result.metrics.items()):
+            if 'delta' in metric:
+                lines.append('  {}: {:+.1%} +- {:.1%}'.format(
+                    name, metric['delta'], metric['delta_ci']))
+        return '\n'.join(lines)
+
+    def interpret_result(self):
+        super(PerfTest, self).interpret_result()
+
+        # The benchmarks only print a result line when they skip or fail.
+        if (self.result.raw_result is status.NOTRUN and
+                self.result.returncode == 0):
+            self.result.result = status.PASS
+        if self.result.raw_result is not status.PASS:
+            return
+
+        self.result.subtests.update(
+            compare_to_baseline(self.name, self.result.metrics))
@@ -25,14 +25,30 @@
 
 """ Module provides a base class for Tests """
 
+import array
+import atexit
+import collections
 import glob
+import itertools
 import os
+import re
+import selectors
+import shutil
+import signal
+import socket
+import subprocess
 import sys
 import json
+import tempfile
+import threading
+import time
 
 from framework import core, options
 from framework import status
-from .base import Test, WindowResizeMixin, ValgrindMixin, TestIsSkip
+from .base import (Test, WindowResizeMixin, ValgrindMixin, TestIsSkip,
+                   TestRunError, ReducedProcessMixin, is_crash_returncode,
+                   _decode_output, _EXTRA_POPEN_ARGS, _Popen)
+from .opengl import FastSkip
 
 
 __all__ = [
@@ -40,7 +56,10 @@ __all__ = [
     'PiglitGLTest',
     'PiglitBaseTest',
     'PiglitReplayerTest',
+    'ForkServer',
+    'TestHost',
     'VkRunnerTest',
+    'MultiVkRunnerTest',
     'CL_CONCURRENT',
     'ROOT_DIR',
     'TEST_BIN_DIR',
@@ -108,6 +127,307 @@ class PiglitBaseTest(ValgrindMixin, Test):
         super(PiglitBaseTest, self).interpret_result()
 
 
+#: How long, in seconds, a process running a chunk of subtests should take
+#: once the time a subtest takes is known. Long enough for the process and
+#: context creation to be small in comparison, short enough to keep all the
+#: workers busy until the end.
+SUBTEST_CHUNK_SECONDS = 2.0
+
+SubtestChunk = collections.namedtuple(
+    'SubtestChunk', ['out', 'err', 'returncode', 'timed_out', 'statuses',
+                     'times', 'result'])
+
+
+HostRun = collections.namedtuple(
+    'HostRun', ['out', 'err', 'returncode', 'timed_out', 'pid'])
+
+
+class TestHost(object):
+    """A long lived piglit-test-host process.
+
+    The process runs the OpenGL tests built as modules in its own process, one
+    line of its stdin per test, see tests/util/piglit-test-host.c.
+
+    If the process stops while running a test (because the test crashed, or
+    called exit() on its own) the output of the test is returned with the
+    return code of the process, and a new process is started for the next
+    test.
+
+    Arguments:
+    command -- the command to start the host with
+    env -- the complete environment to start the host with
+    """
+    _host_line = re.compile(r'^PIGLIT-HOST: (?P<kind>\w+) (?P<value>.*)$')
+
+    def __init__(self, command, env):
+        self.command = [str(c) for c in command]
+        self.env = env
+        self.proc = None
+
+    def _start(self):
+        # In its own process group, so that tests it forked are killed with
+        # it on timeout.
+        self.proc = subprocess.Popen(self.command,
+                                     stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT,
+                                     env=self.env,
+                                     universal_newlines=True,
+                                     bufsize=1,
+                                     start_new_session=True)
+
+    def _kill(self, proc):
+        try:
+            os.killpg(proc.pid, signal.SIGKILL)
+        except OSError:
+            pass
+
+    def run(self, module, command, isolate=False, timeout=None):
+        """Run the test command, built as module.
+
+        If isolate the host forks and runs the test in the child. Return a
+        HostRun, with stderr in out, or None if the host can't run the module.
+        """
+        if self.proc is None or self.proc.poll() is not None:
+            self._start()
+
+        timer = None
+        if timeout:
+            timer = threading.Timer(timeout, self._kill, [self.proc])
+            timer.start()
+
+        fields = (['fork'] if isolate else []) + [module] + command
+        pid = self.proc.pid
+        out = []
+        try:
+            self.proc.stdin.write('\t'.join(str(f) for f in fields) + '\n')
+            self.proc.stdin.flush()
+
+            for line in self.proc.stdout:
+                match = self._host_line.match(line.rstrip('\n'))
+                if match is None:
+                    out.append(line)
+                elif match.group('kind') == 'unsupported':
+                    return None
+                elif match.group('kind') == 'signal':
+                    return HostRun(''.join(out), '',
+                                   -int(match.group('value')), False, pid)
+                else:
+                    return HostRun(''.join(out), '',
+                                   int(match.group('value')), False, pid)
+        except (OSError, ValueError):
+            # The pipe was closed from the other end, the process is gone.
+            pass
+        finally:
+            if timer is not None:
+                timer.cancel()
+
+        returncode = self.proc.wait()
+        self.proc = None
+        timed_out = timer is not None and timer.finished.is_set()
+        return HostRun(''.join(out), '', returncode, timed_out, pid)
+
+    def close(self):
+        if self.proc is not None and self.proc.poll() is None:
+            self.proc.stdin.close()
+            self.proc.wait()
+        self.proc = None
+
+
+_HOSTS = threading.local()
+_ALL_HOSTS = []
+_ALL_HOSTS_LOCK = threading.Lock()
+
+
+def _get_host(env):
+    """Return the test host of the calling thread for the given environment.
+
+    Each worker thread of the runner keeps its own hosts, so there are never
+    more hosts than jobs.
+    """
+    hosts = getattr(_HOSTS, 'hosts', None)
+    if hosts is None:
+        hosts = _HOSTS.hosts = {}
+
+    key = tuple(sorted(env.items()))
+    if key not in hosts:
+        hosts[key] = TestHost([os.path.join(TEST_BIN_DIR, 'piglit-test-host')],
+                              env)
+        with _ALL_HOSTS_LOCK:
+            _ALL_HOSTS.append(hosts[key])
+    return hosts[key]
+
+
+class ForkServer(object):
+    """A long lived "piglit-test-host -fork-server" process.
+
+    The server forks a child for each test, which runs the test from the
+    module the server loaded, without executing anything. Unlike with
+    TestHost a test that crashes only takes itself down, and the server can be
+    shared by all of the jobs.
+
+    Each test connects to the Unix socket of the server and passes it the
+    write ends of the pipes the output of the test is read from, see
+    tests/util/piglit-test-host.c.
+
+    Arguments:
+    command -- the command to start the server with
+    env -- the complete environment to start the server with
+    """
+    def __init__(self, command, env):
+        self.command = [str(c) for c in command]
+        self.env = env
+        self.proc = None
+        self._dir = None
+        self._lock = threading.Lock()
+
+    @property
+    def _path(self):
+        return os.path.join(self._dir, 'socket')
+
+    def _start(self):
+        self._dir = tempfile.mkdtemp(prefix='piglit-fork-server-')
+        self.proc = subprocess.Popen(self.command + ['-fork-server',
+                                                     self._path],
+                                     stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE,
+                                     env=self.env,
+                                     universal_newlines=True)
+        # The server prints a line once it listens, or exits
+        self.proc.stdout.readline()
+
+    def _connect(self):
+        with self._lock:
+            if self.proc is None or self.proc.poll() is not None:
+                self.close()
+                self._start()
+            path = self._path
+
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            sock.connect(path)
+        except OSError:
+            sock.close()
+            return None
+        return sock
+
+    @staticmethod
+    def _read_output(out_r, err_r, pid, timeout):
+        """Read stdout and stderr of the test until both are closed.
+
+        Return them, and whether the test was killed for running longer than
+        timeout.
+        """
+        data = {out_r: [], err_r: []}
+        deadline = time.monotonic() + timeout if timeout else None
+        timed_out = False
+
+        with selectors.DefaultSelector() as sel:
+            sel.register(out_r, selectors.EVENT_READ)
+            sel.register(err_r, selectors.EVENT_READ)
+            while sel.get_map():
+                wait = None
+                if deadline is not None and not timed_out:
+                    wait = max(deadline - time.monotonic(), 0)
+                events = sel.select(wait)
+                if not events and not timed_out:
+                    timed_out = True
+                    try:
+                        os.killpg(pid, signal.SIGKILL)
+                    except OSError:
+                        pass
+                for key, _ in events:
+                    chunk = os.read(key.fd, 65536)
+                    if chunk:
+                        data[key.fd].append(chunk)
+                    else:
+                        sel.unregister(key.fd)
+
+        return (_decode_output(b''.join(data[out_r])),
+                _decode_output(b''.join(data[err_r])), timed_out)
+
+    def run(self, module, command, timeout=None):
+        """Run the test command, built as module, in a child of the server.
+
+        Return a HostRun, or None if the server can't run the module.
+        """
+        sock = self._connect()
+        if sock is None:
+            return None
+
+        out_r, out_w = os.pipe()
+        err_r, err_w = os.pipe()
+        try:
+            with sock, sock.makefile('r') as reply:
+                line = '\t'.join(str(f) for f in [module] + command) + '\n'
+                try:
+                    sock.sendmsg([line.encode('utf-8')],
+                                 [(socket.SOL_SOCKET, socket.SCM_RIGHTS,
+                                   array.array('i', [out_w, err_w]))])
+                finally:
+                    os.close(out_w)
+                    os.close(err_w)
+
+                fields = reply.readline().split()
+                if len(fields) != 2 or fields[0] != 'pid':
+                    return None
+                pid = int(fields[1])
+
+                out, err, timed_out = self._read_output(out_r, err_r, pid,
+                                                        timeout)
+
+                # The server is gone if there is no status
+                fields = reply.readline().split()
+                returncode = -signal.SIGKILL
+                if len(fields) == 2 and fields[0] == 'exit':
+                    returncode = int(fields[1])
+                elif len(fields) == 2 and fields[0] == 'signal':
+                    returncode = -int(fields[1])
+        finally:
+            os.close(out_r)
+            os.close(err_r)
+
+        return HostRun(out, err, returncode, timed_out, pid)
+
+    def close(self):
+        if self.proc is not None and self.proc.poll() is None:
+            self.proc.stdin.close()
+            self.proc.wait()
+        self.proc = None
+        if self._dir is not None:
+            shutil.rmtree(self._dir, ignore_errors=True)
+            self._dir = None
+
+
+_FORK_SERVERS = {}
+_FORK_SERVERS_LOCK = threading.Lock()
+
+
+def _get_fork_server(env):
+    """Return the fork server for the given environment.
+
+    The servers are shared by all of the worker threads of the runner.
+    """
+    key = tuple(sorted(env.items()))
+    with _FORK_SERVERS_LOCK:
+        if key not in _FORK_SERVERS:
+            _FORK_SERVERS[key] = ForkServer(
+                [os.path.join(TEST_BIN_DIR, 'piglit-test-host')], env)
+        return _FORK_SERVERS[key]
+
+
+@atexit.register
+def _close_hosts():
+    with _ALL_HOSTS_LOCK:
+        for host in _ALL_HOSTS:
+            host.close()
+        del _ALL_HOSTS[:]
+    with _FORK_SERVERS_LOCK:
+        for server in _FORK_SERVERS.values():
+            server.close()
+        _FORK_SERVERS.clear()
+
+
 class PiglitGLTest(WindowResizeMixin, PiglitBaseTest):
     """ OpenGL specific Piglit test class
 
@@ -124,9 +444,21 @@ class PiglitGLTest(WindowResizeMixin, PiglitBaseTest):
     all of them. This will probably be mainly used to exclude gbm. These
     options are mutually exclusive.
 
+    With the test_host option the test is run by a piglit-test-host process if
+    it was built as a module. Tests that change the state of the process in
+    ways the tests run after them would notice set isolate_in_host, so that
+    the host runs them in a child process. With the fork_server option every
+    test is run in a child of a piglit-test-host fork server.
+
+    Tests whose subtests are a piglit_subtest table, which
+    piglit_parse_subtest_args() lists with -list-subtests and selects with
+    -subtest, can set parallel_subtests. Their subtests are then run in
+    chunks by as many processes at a time as there are jobs, with the size
+    of the chunks following the time the subtests take.
+
     """
     def __init__(self, command, require_platforms=None, exclude_platforms=None,
-                 **kwargs):
+                 isolate_in_host=False, parallel_subtests=False, **kwargs):
         # TODO: There is a design flaw in python2, keyword args can be
         # fulfilled as positional arguments. This sounds really great, until
         # you realize that because of it you cannot use the splat operator with
@@ -151,6 +483,253 @@ class PiglitGLTest(WindowResizeMixin, PiglitBaseTest):
         else:
             raise Exception("Error: exclude_platforms is not valid")
 
+        self.isolate_in_host = isolate_in_host
+        self.parallel_subtests = parallel_subtests
+
+    @property
+    def host_module(self):
+        """The module of the test for piglit-test-host, or None.
+
+        None if neither the test_host nor the fork_server option is set, if
+        the test can't be run by the host, or if its module wasn't built.
+        """
+        if not (options.OPTIONS.test_host or options.OPTIONS.fork_server) or \
+                options.OPTIONS.valgrind or self.cwd is not None:
+            return None
+        module = os.path.join(TEST_BIN_DIR, 'modules',
+                              self._command[0] + '.so')
+        return module if os.path.exists(module) else None
+
+    def _run_command(self, *args, **kwargs):
+        """Run the test through a piglit-test-host if its module was built.
+
+        Otherwise, or if the host can't load the module, the executable is
+        run.
+        """
+        if self.parallel_subtests and self.run_concurrent and \
+                not options.OPTIONS.valgrind and self._run_subtest_chunks():
+            return
+
+        module = self.host_module
+        if module is None:
+            super(PiglitGLTest, self)._run_command(*args, **kwargs)
+            return
+
+        _base = itertools.chain(os.environ.items(),
+                                options.OPTIONS.env.items(),
+                                self.env.items())
+        fullenv = {str(k): str(v) for k, v in _base}
+        if options.OPTIONS.fork_server:
+            ran = _get_fork_server(fullenv).run(module, self.command,
+                                                self.timeout)
+        else:
+            ran = _get_host(fullenv).run(module, self.command,
+                                         self.isolate_in_host, self.timeout)
+        if ran is None:
+            super(PiglitGLTest, self)._run_command(*args, **kwargs)
+            return
+
+        self.result.pid.append(ran.pid)
+        self.result.out = ran.out
+        self.result.err = ran.err
+        if ran.timed_out:
+            raise TestRunError(
+                'Test run time exceeded timeout value ({} seconds)\n'.format(
+                    self.timeout),
+                'timeout')
+        self.result.returncode = ran.returncode
+
+    def _list_subtests(self, env):
+        """Return the (argument, name) pairs of the subtests of the test.
+
+        The argument is what -subtest takes, the name is what the subtest is
+        reported as. Returns an empty list if the test can't list them.
+        """
+        try:
+            proc = subprocess.run([str(c) for c in self.command] +
+                                  ['-list-subtests'],
+                                  stdout=subprocess.PIPE,
+                                  stderr=subprocess.DEVNULL,
+                                  cwd=self.cwd, env=env,
+                                  universal_newlines=True,
+                                  timeout=self.timeout or 60)
+        except (OSError, subprocess.TimeoutExpired, UnicodeDecodeError):
+            return []
+        if proc.returncode != 0:
+            return []
+
+        subtests = []
+        for line in proc.stdout.splitlines():
+            if not line or line.startswith('PIGLIT'):
+                continue
+            arg, sep, name = line.partition(': ')
+            subtests.append((arg, name if sep else arg))
+        return subtests
+
+    def _run_chunk(self, chunk, env):
+        """Run the subtests of chunk, a list of arguments, in one process."""
+        command = [str(c) for c in self.command]
+        for arg in chunk:
+            command += ['-subtest', arg]
+
+        try:
+            proc = _Popen(command,
+                          stdout=subprocess.PIPE,
+                          stderr=subprocess.PIPE,
+                          cwd=self.cwd,
+                          env=env,
+                          **_EXTRA_POPEN_ARGS)
+        except OSError:
+            return SubtestChunk('', '', None, False, {}, {}, status.CRASH)
+        with self._chunk_lock:
+            self.result.pid.append(proc.pid)
+
+        timed_out = False
+        try:
+            out, err = proc.communicate(timeout=self.timeout)
+        except subprocess.TimeoutExpired:
+            timed_out = True
+            if sys.platform != 'win32':
+                os.killpg(os.getpgid(proc.pid), signal.SIGKILL)
+            else:
+                proc.kill()
+            out, err = proc.communicate()
+        with self._chunk_lock:
+            self._add_rusage(proc)
+
+        out, err = _decode_output(out), _decode_output(err)
+        statuses = {}
+        times = {}
+        result = None
+        for line in out.split('\n'):
+            if not line.startswith('PIGLIT:'):
+                continue
+            try:
+                deserial = json.loads(line[8:])
+            except ValueError:
+                continue
+            if 'subtest' in deserial:
+                for name, value in deserial['subtest'].items():
+                    statuses[name.lower()] = value
+                    if 'time' in deserial:
+                        times[name.lower()] = deserial['time']
+            elif 'result' in deserial:
+                result = deserial['result']
+
+        return SubtestChunk(out, err, proc.returncode, timed_out, statuses,
+                            times, result)
+
+    def _run_subtest_chunks(self):
+        """Run the subtests in chunks, in parallel processes.
+
+        The first chunk each worker runs has a single subtest, after which
+        the chunks are sized to take about SUBTEST_CHUNK_SECONDS at the
+        average time the subtests took so far, but never more than an even
+        share of what is left. When a process stops before reporting all
+        of its subtests, the first missing one gets the status of the stop
+        and the others go back to the queue, as with ReducedProcessMixin.
+
+        Returns False if the test can't list its subtests, in which case it
+        has to be run as a whole.
+        """
+        _base = itertools.chain(os.environ.items(),
+                                options.OPTIONS.env.items(),
+                                self.env.items())
+        env = {str(k): str(v) for k, v in _base}
+
+        subtests = self._list_subtests(env)
+        if not subtests:
+            return False
+
+        names = dict(subtests)
+        pending = collections.deque(arg for arg, _ in subtests)
+        jobs = min(options.OPTIONS.jobs or os.cpu_count() or 1, len(pending))
+        measured = {'seconds': 0.0, 'count': 0}
+        chunks = []
+        self._chunk_lock = threading.Lock()
+
+        for _, name in subtests:
+            self.result.subtests[name] = status.NOTRUN
+
+        def chunk_size():
+            share = -(-len(pending) // jobs)
+            if not measured['count']:
+                return 1
+            average = measured['seconds'] / measured['count']
+            if average <= 0:
+                return share
+            return max(1, min(share, int(SUBTEST_CHUNK_SECONDS / average)))
+
+        def finish(chunk, ran, elapsed):
+            """Record the chunk, with self._chunk_lock held."""
+            chunks.append(ran)
+            for name, value in ran.statuses.items():
+                self.result.subtests[name] = value
+            for name, seconds in ran.times.items():
+                self.result.subtests.set_time(name, seconds)
+
+            missing = [a for a in chunk
+                       if names[a].lower() not in ran.statuses]
+            done = len(chunk) - len(missing)
+            if done:
+                measured['seconds'] += (sum(ran.times.values())
+                                        if len(ran.times) == done
+                                        else elapsed)
+                measured['count'] += done
+
+            if not missing:
+                return
+            if ran.timed_out:
+                stop = status.TIMEOUT
+            elif is_crash_returncode(ran.returncode):
+                stop = status.CRASH
+            elif ran.result is not None:
+                # The test chose not to run them, for instance because
+                # of a missing extension.
+                for arg in missing:
+                    self.result.subtests[names[arg]] = ran.result
+                return
+            else:
+                stop = status.FAIL
+            self.result.subtests[names[missing[0]]] = stop
+            pending.extendleft(reversed(missing[1:]))
+
+        def worker():
+            while True:
+                with self._chunk_lock:
+                    if not pending:
+                        return
+                    chunk = [pending.popleft()
+                             for _ in range(min(chunk_size(), len(pending)))]
+
+                start = time.monotonic()
+                ran = self._run_chunk(chunk, env)
+                elapsed = time.monotonic() - start
+
+                with self._chunk_lock:
+                    finish(chunk, ran, elapsed)
+
+        threads = [threading.Thread(target=worker) for _ in range(jobs)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        def strip(out):
+            # Only keep the subtest lines of the protocol: the subtests were
+            # enumerated above and the result follows from theirs.
+            return '\n'.join(
+                l for l in out.split('\n')
+                if not l.startswith('PIGLIT:') or '"subtest"' in l)
+
+        self.result.out = '\n\n====RESUME====\n\n'.join(
+            strip(c.out) for c in chunks)
+        self.result.err = '\n\n====RESUME====\n\n'.join(
+            c.err for c in chunks)
+        self.result.returncode = next(
+            (c.returncode for c in chunks if c.returncode != 0), 0)
+        return True
+
     def is_skip(self):
         """ Native Piglit-test specific skip checking
 
@@ -199,6 +778,99 @@ class ASMParserTest(PiglitBaseTest):
         return self.keys() + command + [os.path.join(ROOT_DIR, self.filename)]
 
 
+class MultiASMParserTest(ReducedProcessMixin, PiglitBaseTest):
+
+    """Run several ASM parser tests of one program type in one process.
+
+    asmparsertest --batch compiles all of the files in one context, and
+    reports each as a subtest named after its file. The files that require
+    an extension known to be missing are left out of the command, and the
+    run is resumed after a file that crashes.
+
+    Arguments:
+    type_ -- the program type of all of the files, like ARBvp1.0
+    filenames -- a list of paths, relative to ROOT_DIR, of the files
+    extensions -- the extensions that each file requires
+    """
+
+    _TYPE_EXTENSIONS = {
+        'ARBvp1.0': 'GL_ARB_vertex_program',
+        'ARBfp1.0': 'GL_ARB_fragment_program',
+        'NVvp1.0': 'GL_NV_vertex_program',
+        'NVfp1.0': 'GL_NV_fragment_program',
+    }
+
+    def __init__(self, type_, filenames, extensions=None, env=None):
+        assert filenames
+        subtests = [os.path.basename(f).lower() for f in filenames]
+        super(MultiASMParserTest, self).__init__(
+            ['asmparsertest', '--batch', type_],
+            subtests=subtests,
+            env=env)
+
+        self.type_ = type_
+        self.filenames = list(filenames)
+        self.subtests = subtests
+        self.extensions = extensions or [[] for _ in filenames]
+        self._filenames = self.filenames
+
+    @classmethod
+    def new(cls, type_, filenames, installednames):
+        """Create an instance, reading the "# REQUIRE" lines of filenames.
+
+        installednames are the paths of the same files relative to ROOT_DIR.
+        """
+        extensions = []
+        for filename in filenames:
+            with open(filename, 'r') as f:
+                extensions.append(re.findall(r'# REQUIRE (\S+)', f.read()))
+        return cls(type_, installednames, extensions)
+
+    def _process_skips(self):
+        type_ext = self._TYPE_EXTENSIONS.get(self.type_)
+        filenames = []
+        expected = []
+        for filename, name, exts in zip(self.filenames, self.subtests,
+                                        self.extensions):
+            exts = set(exts)
+            if type_ext:
+                exts.add(type_ext)
+            try:
+                FastSkip(extensions=exts).test()
+            except TestIsSkip:
+                self.result.subtests[name] = status.SKIP
+            else:
+                filenames.append(filename)
+                expected.append(name)
+
+        self._filenames = filenames
+        self._expected = expected
+
+    def run(self):
+        self._process_skips()
+        super(MultiASMParserTest, self).run()
+
+    def _command_for(self, filenames):
+        return self.keys() + super(MultiASMParserTest, self).command + \
+            [os.path.join(ROOT_DIR, f) for f in filenames]
+
+    @PiglitBaseTest.command.getter
+    def command(self):
+        return self._command_for(self._filenames)
+
+    def _is_subtest(self, line):
+        return line.startswith('PIGLIT TEST:')
+
+    def _resume(self, current):
+        return self._command_for(self._filenames[current:])
+
+    def _stop_status(self):
+        if self.result.returncode > 0:
+            return status.FAIL
+        return status.CRASH
+
+
+
 class BuiltInConstantsTest(PiglitBaseTest):
 
     """Test class for handling built in constants tests."""
@@ -260,6 +932,170 @@ class VkRunnerTest(PiglitBaseTest):
         return self.keys() + self._command + [os.path.join(ROOT_DIR, self.filename)]
 
 
+class MultiVkRunnerTest(VkRunnerTest):
+    """Run several VkRunner shader test files with a single vkrunner.
+
+    The Vulkan instance and device are then created once for all of the
+    files instead of once per file. Each file is a subtest.
+
+    vkrunner prints the name of each script before running it when it is
+    given more than one, and only prints something for a script that
+    doesn't pass. The scripts that printed nothing are therefore passes,
+    and the others are run again on their own to get their status. If
+    vkrunner stops, the script it was running gets the status of the stop
+    and it is restarted with the scripts that are left, as with
+    MultiShaderTest.
+
+    Arguments:
+    filenames -- a list of paths, relative to ROOT_DIR, of the test files
+    """
+
+    def __init__(self, filenames, env=None):
+        assert filenames
+        super(MultiVkRunnerTest, self).__init__(filenames[0], env=env)
+        self.filenames = list(filenames)
+        self.result.subtests.update(
+            {self._subtest_name(f): status.NOTRUN for f in self.filenames})
+
+    @staticmethod
+    def _subtest_name(filename):
+        return os.path.splitext(os.path.basename(filename))[0]
+
+    def _files_command(self, filenames):
+        return self.keys() + self._command + \
+            [os.path.join(ROOT_DIR, f) for f in filenames]
+
+    @PiglitBaseTest.command.getter
+    def command(self):
+        return self._files_command(self.filenames)
+
+    def _run_files(self, filenames):
+        """Run vkrunner on filenames.
+
+        Returns the output, the return code (None after a timeout) and
+        whether it timed out.
+        """
+        try:
+            super(MultiVkRunnerTest, self)._run_command(
+                _command=self._files_command(filenames))
+        except TestRunError as e:
+            if e.status != 'timeout':
+                raise
+            return self.result.out, None, True
+        return self.result.out, self.result.returncode, False
+
+    @staticmethod
+    def _piglit_result(out):
+        """Return the result of the PIGLIT: line of out, or None."""
+        result = None
+        for line in out.split('\n'):
+            if line.startswith('PIGLIT:'):
+                try:
+                    result = json.loads(line[8:]).get('result', result)
+                except ValueError:
+                    pass
+        return result
+
+    def _run_alone(self, filename):
+        """Run a single file and return its output and status."""
+        out, returncode, timed_out = self._run_files([filename])
+        if timed_out:
+            return out, status.TIMEOUT
+        if is_crash_returncode(returncode):
+            return out, status.CRASH
+        result = self._piglit_result(out)
+        if result is None:
+            return out, status.FAIL
+        if returncode != 0 and result == 'pass':
+            return out, status.WARN
+        return out, result
+
+    def _sections(self, out, filenames):
+        """Split out into the output of each script it started.
+
+        Returns a list of (filename, lines) for the scripts started, in
+        order, and the lines before the first one.
+        """
+        names = {os.path.join(ROOT_DIR, f): f for f in filenames}
+        names.update({f: f for f in filenames})
+        sections = []
+        before = []
+        expected = iter(filenames)
+        for line in out.split('\n'):
+            name = names.get(line.strip())
+            if name is not None and name in expected:
+                sections.append((name, []))
+            elif line.startswith('PIGLIT:') or not line.strip():
+                continue
+            elif sections:
+                sections[-1][1].append(line)
+            else:
+                before.append(line)
+        return sections, before
+
+    def _run_command(self, *args, **kwargs):
+        remaining = list(self.filenames)
+        recheck = []
+        outs = []
+        returncode = 0
+
+        while remaining:
+            out, run_returncode, timed_out = self._run_files(remaining)
+            outs.append(out)
+            if returncode == 0 and run_returncode:
+                returncode = run_returncode
+            stopped = timed_out or is_crash_returncode(run_returncode)
+
+            sections, before = self._sections(out, remaining)
+            if not sections:
+                # Nothing tells the scripts apart, run them one by one
+                # unless they all passed.
+                if not stopped and not before and \
+                        self._piglit_result(out) == 'pass':
+                    for f in remaining:
+                        self.result.subtests[self._subtest_name(f)] = \
+                            status.PASS
+                else:
+                    recheck.extend(remaining)
+                break
+
+            if before:
+                recheck.append(sections[0][0])
+            for i, (filename, lines) in enumerate(sections):
+                last = i == len(sections) - 1
+                name = self._subtest_name(filename)
+                if last and stopped:
+                    self.result.subtests[name] = \
+                        status.TIMEOUT if timed_out else status.CRASH
+                elif lines:
+                    recheck.append(filename)
+                elif filename not in recheck:
+                    self.result.subtests[name] = status.PASS
+
+            remaining = remaining[len(sections):]
+            if not stopped and remaining:
+                # vkrunner exited before starting them.
+                recheck.extend(remaining)
+                break
+
+        for filename in recheck:
+            out, result = self._run_alone(filename)
+            outs.append(out)
+            self.result.subtests[self._subtest_name(filename)] = result
+
+        self.result.out = '\n\n====RESUME====\n\n'.join(outs)
+        self.result.err = ''
+        self.result.returncode = returncode
+
+    def interpret_result(self):
+        # The subtests were set while running, the PIGLIT: lines are the
+        # results of the different vkrunner processes.
+        self.result.out = '\n'.join(
+            l for l in self.result.out.split('\n')
+            if not l.startswith('PIGLIT:'))
+        Test.interpret_result(self)
+
+
 class PiglitReplayerTest(PiglitBaseTest):
     """ Make a PiglitTest instance for a Replayer test
 
@@ -268,14 +1104,35 @@ class PiglitReplayerTest(PiglitBaseTest):
     Arguments:
     extra_args -- to pass to replayer
 
+    Keyword Arguments:
+    trace_path -- the trace replayed, to wait for PREFETCHER to download it
+
+    The frame time metrics of profiled traces are compared with those of the
+    baseline run like the measurements of perf tests.
+
     """
 
     RESULTS_PATH = None
+    PREFETCHER = None
+    # Profiled traces are measured, and the others write their images
+    cache_results = False
 
-    def __init__(self, subcommand, extra_args, **kwargs):
+    def __init__(self, subcommand, extra_args, trace_path=None, **kwargs):
         super(PiglitReplayerTest, self).__init__(
             ['replayer.py', subcommand, 'trace'], **kwargs)
         self.extra_args = extra_args
+        self.trace_path = trace_path
+        self.name = None
+
+    def execute(self, path, log, options):
+        # The name is needed to find the same test in the baseline.
+        self.name = path
+        super(PiglitReplayerTest, self).execute(path, log, options)
+
+    def run(self):
+        if self.PREFETCHER is not None and self.trace_path is not None:
+            self.PREFETCHER.wait(self.trace_path)
+        super(PiglitReplayerTest, self).run()
 
     @PiglitBaseTest.command.getter
     def command(self):
@@ -293,3 +1150,9 @@ class PiglitReplayerTest(PiglitBaseTest):
             self.result.returncode = -1
 
         super(PiglitReplayerTest, self).interpret_result()
+
+        if self.result.metrics and self.result.raw_result is status.PASS:
+            # Importing this at the top would be circular
+            from .perf import compare_to_baseline
+            self.result.subtests.update(
+                compare_to_baseline(self.name, self.result.metrics))
@@ -24,24 +24,172 @@
 
 """ This module enables running shader tests. """
 
+import atexit
+import hashlib
 import io
+import itertools
+import json
 import os
 import re
+import struct
+import subprocess
+import threading
 
+from framework import core
 from framework import exceptions
 from framework import status
 from framework import options
-from .base import ReducedProcessMixin, TestIsSkip
+from .base import ReducedProcessMixin, TestIsSkip, is_crash_returncode
 from .opengl import FastSkipMixin, FastSkip
 from .piglit_test import PiglitBaseTest, ROOT_DIR
 
 __all__ = [
+    'BUNDLE_NAME',
+    'ShaderRunnerServer',
     'ShaderTest',
+    'read_bundle',
+    'write_bundle',
 ]
 
 
+# The requirements of the shader_test files parsed by previous runs, by file
+# name, see Parser.parse.
+_REQUIREMENTS = None
+_REQUIREMENTS_LOCK = threading.Lock()
+
+
+def _store_requirements():
+    core.store_cache('shader_test', _REQUIREMENTS)
+
+
+def _requirements():
+    """Return the cached requirements, loading them the first time.
+
+    Changes to this module can change how files are parsed, so they drop
+    the whole cache.
+
+    """
+    global _REQUIREMENTS
+    if _REQUIREMENTS is None:
+        parser = os.stat(__file__).st_mtime_ns
+        _REQUIREMENTS = core.load_cache('shader_test')
+        if _REQUIREMENTS.get('parser') != parser:
+            _REQUIREMENTS = {'parser': parser, 'files': {}}
+        atexit.register(_store_requirements)
+    return _REQUIREMENTS['files']
+
+
+# The bundle of the shader tests of a directory of generated tests, see
+# write_bundle().
+BUNDLE_NAME = 'tests.shader_bundle'
+
+# The layout of a bundle, see the comment on bundles in
+# tests/shaders/shader_runner.c. The header holds the magic, version, byte
+# order, number of tests, offset of their table and offset and size of the
+# JSON list of their requirements. Each entry of the table holds the offset
+# and size of the text and of the name of a test.
+_BUNDLE_MAGIC = b'PSHBNDL\0'
+_BUNDLE_VERSION = 1
+_BUNDLE_BYTE_ORDER = 0x01020304
+_BUNDLE_HEADER = struct.Struct('=8sII4Q')
+_BUNDLE_ENTRY = struct.Struct('=4Q')
+
+# The requirements of the bundles read, by path
+_BUNDLES = {}
+_BUNDLES_LOCK = threading.Lock()
+
+
+def write_bundle(path, filenames):
+    """Write the shader_test files filenames into a bundle at path.
+
+    shader_runner runs the test at index i of the bundle when it is given
+    "<path>#<i>" in place of a file name, and the requirements of the tests
+    are parsed once, here. The file is only written if its contents change.
+
+    """
+    requirements = []
+    texts = []
+    for filename in filenames:
+        parser = Parser(filename)
+        parser._parse()
+        requirements.append(dict(parser.requirements(), name=parser.name))
+        with open(filename, 'rb') as f:
+            texts.append((f.read() + b'\0',
+                          parser.name.encode('utf-8') + b'\0'))
+
+    index = json.dumps(requirements, sort_keys=True).encode('utf-8') + b'\0'
+    table = _BUNDLE_HEADER.size
+    offset = table + _BUNDLE_ENTRY.size * len(texts) + len(index)
+    entries = []
+    for text, name in texts:
+        entries.append(_BUNDLE_ENTRY.pack(offset, len(text),
+                                          offset + len(text), len(name)))
+        offset += len(text) + len(name)
+
+    contents = b''.join(
+        [_BUNDLE_HEADER.pack(_BUNDLE_MAGIC, _BUNDLE_VERSION,
+                             _BUNDLE_BYTE_ORDER, len(texts), table,
+                             table + _BUNDLE_ENTRY.size * len(texts),
+                             len(index))] +
+        entries + [index] + [b''.join(t) for t in texts])
+
+    try:
+        with open(path, 'rb') as f:
+            if f.read() == contents:
+                return
+    except OSError:
+        pass
+    with open(path, 'wb') as f:
+        f.write(contents)
+
+
+def read_bundle(path):
+    """Return the requirements of the tests of the bundle at path.
+
+    They are a list of the dicts of Parser.requirements(), with the name of
+    each test added, in the order of the tests. Only the header and the
+    requirements are read, once per bundle.
+
+    """
+    with _BUNDLES_LOCK:
+        if path in _BUNDLES:
+            return _BUNDLES[path]
+
+    try:
+        with open(path, 'rb') as f:
+            magic, version, byte_order, _, _, offset, size = \
+                _BUNDLE_HEADER.unpack(f.read(_BUNDLE_HEADER.size))
+            if (magic, version, byte_order) != (
+                    _BUNDLE_MAGIC, _BUNDLE_VERSION, _BUNDLE_BYTE_ORDER):
+                raise ValueError('not a bundle of this version and machine')
+            f.seek(offset)
+            requirements = json.loads(f.read(size).rstrip(b'\0').decode(
+                'utf-8'))
+    except (OSError, struct.error, ValueError) as e:
+        raise exceptions.PiglitFatalError(
+            'Cannot read the shader test bundle "{}": {}'.format(path, e))
+
+    with _BUNDLES_LOCK:
+        _BUNDLES[path] = requirements
+    return requirements
+
+
+def _bundle_entry(filename):
+    """Return the bundle and index of a test named "<bundle>#<index>", or
+    None for a file.
+    """
+    path, sep, index = filename.rpartition('#')
+    if not sep or not path.endswith('.shader_bundle') or not index.isdigit():
+        return None
+    return path, int(index)
+
+
 class Parser(object):
-    """An object responsible for parsing a shader_test file."""
+    """An object responsible for parsing a shader_test file.
+
+    The file can also be a test of a bundle, named "<bundle>#<index>", its
+    requirements are then read from the bundle.
+    """
 
     _is_gl = re.compile(r'GL (<|<=|=|>=|>) \d\.\d')
     _match_gl_version = re.compile(
@@ -51,15 +199,68 @@ class Parser(object):
 
     def __init__(self, filename):
         self.filename = filename
+        self.name = os.path.basename(os.path.splitext(filename)[0])
         self.extensions = set()
         self.api_version = 0.0
         self.shader_version = 0.0
         self.api = None
         self.prog = None
+        self.vertex_shader = ''
         self.__op = None
         self.__sl_op = None
 
     def parse(self):
+        """Find the requirements of the file.
+
+        Parsing all of the shader_tests is a large part of loading a profile,
+        so the results are cached between runs, and only files whose size or
+        modification time changed are parsed again.
+
+        """
+        entry = _bundle_entry(self.filename)
+        if entry is not None:
+            requirements = read_bundle(os.path.join(ROOT_DIR, entry[0]))
+            self.load(requirements[entry[1]])
+            self.name = requirements[entry[1]]['name']
+            return
+
+        stat = os.stat(os.path.join(ROOT_DIR, self.filename))
+        stamp = [stat.st_size, stat.st_mtime_ns]
+
+        with _REQUIREMENTS_LOCK:
+            cached = _requirements().get(self.filename)
+            if cached is not None and cached['stamp'] == stamp:
+                self.load(cached)
+                return
+
+        self._parse()
+
+        with _REQUIREMENTS_LOCK:
+            cached = self.requirements()
+            cached['stamp'] = stamp
+            _requirements()[self.filename] = cached
+
+    def requirements(self):
+        """Return the requirements found by parse(), as a dict."""
+        return {
+            'api': self.api,
+            'extensions': sorted(self.extensions),
+            'api_version': self.api_version,
+            'shader_version': self.shader_version,
+            'prog': self.prog,
+            'vertex_shader': self.vertex_shader,
+        }
+
+    def load(self, requirements):
+        """Set the requirements from a dict returned by requirements()."""
+        self.api = requirements['api']
+        self.extensions = set(requirements['extensions'])
+        self.api_version = requirements['api_version']
+        self.shader_version = requirements['shader_version']
+        self.prog = requirements['prog']
+        self.vertex_shader = requirements['vertex_shader']
+
+    def _parse(self):
         # Iterate over the lines in shader file looking for the config section.
         # By using a generator this can be split into two for loops at minimal
         # cost. The first one looks for the start of the config block or raises
@@ -130,6 +331,22 @@ class Parser(object):
                         self.api = 'core'
                 break
 
+        # Identify the vertex shader, so that files sharing it can be run
+        # one after the other by the same shader_runner, which then compiles
+        # it only once.
+        source = []
+        in_vertex_shader = line.startswith('[vertex shader]')
+        for line in lines:
+            if line.startswith('['):
+                if in_vertex_shader:
+                    break
+                in_vertex_shader = line.startswith('[vertex shader]')
+            elif in_vertex_shader:
+                source.append(line)
+        if source:
+            self.vertex_shader = hashlib.sha1(
+                ''.join(source).encode('utf-8')).hexdigest()
+
         # Select the correct binary to run the test, but be as conservative as
         # possible by always selecting the lowest version that meets the
         # criteria.
@@ -201,6 +418,127 @@ class ShaderTest(FastSkipMixin, PiglitBaseTest):
         self._command = [n for n in new if n not in ['-auto', '-fbo']]
 
 
+class ShaderRunnerServer(object):
+    """A long lived "shader_runner -server" process.
+
+    The process reads the path of a shader_test file on each line of its
+    stdin and prints a subtest result line for it once it is done, keeping its
+    GL context around as long as the tests it gets fed allow it.
+
+    If the process stops before reporting a result (because it crashed, or
+    because the test called piglit_report_result() on its own) the output is
+    turned into a subtest result for the file that was running, and a new
+    process is started for the next file.
+
+    Arguments:
+    command -- the command to start the server with
+    env -- the complete environment to start the server with
+    """
+    _subtest_line = 'PIGLIT: {"subtest"'
+    _result_line = re.compile(r'^PIGLIT: {"result": "(?P<result>\w+)" }$')
+
+    def __init__(self, command, env):
+        self.command = [str(c) for c in command]
+        self.env = env
+        self.proc = None
+
+    def _start(self):
+        self.proc = subprocess.Popen(self.command,
+                                     stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE,
+                                     stderr=subprocess.STDOUT,
+                                     env=self.env,
+                                     universal_newlines=True,
+                                     bufsize=1)
+
+    def run(self, filename, name, timeout=None):
+        """Run a single file and return its output.
+
+        The returned output always ends with a subtest result line for name,
+        even if the process died while running it.
+        """
+        if self.proc is None or self.proc.poll() is not None:
+            self._start()
+
+        timer = None
+        if timeout:
+            timer = threading.Timer(timeout, self.proc.kill)
+            timer.start()
+
+        out = []
+        try:
+            self.proc.stdin.write(filename + '\n')
+            self.proc.stdin.flush()
+
+            for line in self.proc.stdout:
+                out.append(line)
+                if line.startswith(self._subtest_line):
+                    return ''.join(out)
+        except (OSError, ValueError):
+            # The pipe was closed from the other end, the process is gone.
+            pass
+        finally:
+            if timer is not None:
+                timer.cancel()
+
+        returncode = self.proc.wait()
+        self.proc = None
+
+        result = status.CRASH
+        if timer is not None and timer.finished.is_set() and \
+                is_crash_returncode(returncode):
+            result = status.TIMEOUT
+        elif not is_crash_returncode(returncode):
+            result = status.FAIL
+            for line in out:
+                match = self._result_line.match(line.rstrip('\n'))
+                if match:
+                    result = status.status_lookup(match.group('result'))
+                    out.remove(line)
+                    break
+
+        out.append('PIGLIT: {{"subtest": {{"{}" : "{}"}}}}\n'.format(
+            name, result))
+        return ''.join(out)
+
+    def close(self):
+        if self.proc is not None and self.proc.poll() is None:
+            self.proc.stdin.close()
+            self.proc.wait()
+        self.proc = None
+
+
+_SERVERS = threading.local()
+_ALL_SERVERS = []
+_ALL_SERVERS_LOCK = threading.Lock()
+
+
+def _get_server(command, env):
+    """Return the server of the calling thread for the given command.
+
+    Each worker thread of the runner keeps its own servers, so there are never
+    more shader_runner processes than jobs.
+    """
+    servers = getattr(_SERVERS, 'servers', None)
+    if servers is None:
+        servers = _SERVERS.servers = {}
+
+    key = (tuple(command), tuple(sorted(env.items())))
+    if key not in servers:
+        servers[key] = ShaderRunnerServer(command, env)
+        with _ALL_SERVERS_LOCK:
+            _ALL_SERVERS.append(servers[key])
+    return servers[key]
+
+
+@atexit.register
+def _close_servers():
+    with _ALL_SERVERS_LOCK:
+        for server in _ALL_SERVERS:
+            server.close()
+        del _ALL_SERVERS[:]
+
+
 class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
     """A Shader class that can run more than one test at a time.
 
@@ -231,6 +569,7 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
         prog = None
         subtests = []
         skips = []
+        keys = []
 
         # Walk each subtest, and either add it to the list of tests to run, or
         # determine it is skip, and set the result of that test in the subtests
@@ -238,7 +577,7 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
         for each in filenames:
             parser = Parser(each)
             parser.parse()
-            subtests.append(os.path.basename(os.path.splitext(each)[0]).lower())
+            subtests.append(parser.name.lower())
 
             if prog is not None:
                 # This allows mixing GLES2 and GLES3 shader test files
@@ -266,8 +605,14 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
                 'shader_version': parser.shader_version,
                 'api': parser.api,
             })
+            keys.append((parser.api or '', parser.vertex_shader))
 
-        return cls(prog, installednames or filenames, subtests, skips)
+        # Run the files with the same vertex shader next to each other, the
+        # sort is stable so the order is otherwise kept.
+        order = sorted(range(len(keys)), key=keys.__getitem__)
+        files = installednames or filenames
+        return cls(prog, [files[i] for i in order],
+                   [subtests[i] for i in order], [skips[i] for i in order])
 
     def _process_skips(self):
         r_files = []
@@ -302,6 +647,44 @@ class MultiShaderTest(ReducedProcessMixin, PiglitBaseTest):
         shaderfiles = [os.path.join(ROOT_DIR, s) for s in shaderfiles]
         return self.keys() + [command[0]] + shaderfiles + ['-auto', '-report-subtests']
 
+    @property
+    def server_command(self):
+        """The command used to start the -server version of shader_runner."""
+        command = self.keys() + [super(MultiShaderTest, self).command[0],
+                                 '-server', '-auto', '-fbo']
+        if options.OPTIONS.force_glsl:
+            command.append('-glsl')
+        elif options.OPTIONS.spirv:
+            command.append('-spirv')
+        return command
+
+    def _run_command(self, *args, **kwargs):
+        """Run the files through a shader_runner server if requested.
+
+        Otherwise shader_runner is started with all of the files on its
+        command line, and restarted after crashes by ReducedProcessMixin.
+        """
+        if not options.OPTIONS.shader_runner_server:
+            super(MultiShaderTest, self)._run_command(*args, **kwargs)
+            return
+
+        _base = itertools.chain(os.environ.items(),
+                                options.OPTIONS.env.items(),
+                                self.env.items())
+        fullenv = {str(k): str(v) for k, v in _base}
+        server = _get_server(self.server_command, fullenv)
+
+        out = []
+        for filename, name in zip(self._command[1:], self._expected):
+            out.append(server.run(os.path.join(ROOT_DIR, filename), name,
+                                  self.timeout))
+            if server.proc is not None:
+                self.result.pid.append(server.proc.pid)
+
+        self.result.out = ''.join(out)
+        self.result.err = ''
+        self.result.returncode = 0
+
     def _is_subtest(self, line):
         return line.startswith('PIGLIT TEST:')
 
@@ -19,18 +19,185 @@
 # OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 # SOFTWARE.
 
+import concurrent.futures
 import errno
+import glob
+import hashlib
 import os
+import struct
 import subprocess
 import sys
+import sysconfig
 import threading
 
+from framework import core
 from framework import exceptions
 from framework.core import lazy_property
 from framework.options import OPTIONS
 # from framework.test import piglit_test
 
 
+# Environment variables with these prefixes can change the driver that is
+# used or what it supports, and so are part of the driver identity.
+_DRIVER_ENV = ('MESA_', 'LIBGL_', 'GALLIUM_', 'EGL_', '__GLX_', '__EGL_',
+               'DRI_', 'DISPLAY', 'WAYLAND_DISPLAY')
+
+_CACHE_LOCK = threading.Lock()
+
+# The profiles that are probed together when the cache misses.
+_PROFILES = ('core', 'compat', 'none', 'gles1', 'gles2')
+
+# The libraries that make up the GL drivers, relative to a library directory.
+_DRIVER_LIBS = ('libGL.so*', 'libGLX*.so*', 'libEGL*.so*', 'libGLES*.so*',
+                'libOpenGL.so*', 'libgbm.so*', 'libgallium*.so',
+                'dri/*_dri.so', 'gbm/*.so')
+
+_PT_NOTE = 4
+_NT_GNU_BUILD_ID = 3
+
+
+def _elf_build_id(filename):
+    """Return the GNU build-id of the ELF file filename as hex, or None.
+
+    Only the program headers and the notes are read, not the whole file.
+
+    """
+    try:
+        with open(filename, 'rb') as f:
+            header = f.read(64)
+            if len(header) < 52 or header[:4] != b'\x7fELF':
+                return None
+            is64 = header[4] == 2
+            order = '<' if header[5] == 1 else '>'
+            if is64:
+                phoff, = struct.unpack_from(order + 'Q', header, 32)
+                phentsize, phnum = struct.unpack_from(order + 'HH', header, 54)
+                phdr = order + 'IIQQQQQQ'
+            else:
+                phoff, = struct.unpack_from(order + 'I', header, 28)
+                phentsize, phnum = struct.unpack_from(order + 'HH', header, 42)
+                phdr = order + 'IIIIIIII'
+
+            f.seek(phoff)
+            headers = f.read(phentsize * phnum)
+            for i in range(phnum):
+                fields = struct.unpack_from(phdr, headers, i * phentsize)
+                if is64:
+                    p_type, _, p_offset, _, _, p_filesz, _, p_align = fields
+                else:
+                    p_type, p_offset, _, _, p_filesz, _, _, p_align = fields
+                if p_type != _PT_NOTE:
+                    continue
+
+                align = 8 if p_align == 8 else 4
+                f.seek(p_offset)
+                notes = f.read(p_filesz)
+                pos = 0
+                while pos + 12 <= len(notes):
+                    namesz, descsz, n_type = struct.unpack_from(
+                        order + 'III', notes, pos)
+                    pos += 12
+                    name = notes[pos:pos + namesz]
+                    pos += -(-namesz // align) * align
+                    desc = notes[pos:pos + descsz]
+                    pos += -(-descsz // align) * align
+                    if n_type == _NT_GNU_BUILD_ID and name == b'GNU\0':
+                        return desc.hex()
+    except (OSError, struct.error):
+        pass
+    return None
+
+
+def _driver_globs():
+    """Return the patterns of the driver libraries that may be loaded."""
+    globs = []
+    dirs = [d for d in os.environ.get('LD_LIBRARY_PATH', '').split(':') if d]
+    multiarch = sysconfig.get_config_var('MULTIARCH')
+    for prefix in ['/usr/local/lib', '/usr/lib', '/lib']:
+        if multiarch:
+            dirs.append(os.path.join(prefix, multiarch))
+        dirs.append(prefix)
+    dirs.extend(['/usr/lib64', '/lib64'])
+    for directory in dirs:
+        globs.extend(os.path.join(directory, p) for p in _DRIVER_LIBS)
+
+    # These have the drivers themselves rather than dri/ and gbm/
+    for var in ['LIBGL_DRIVERS_PATH', 'GBM_BACKENDS_PATH']:
+        for directory in os.environ.get(var, '').split(':'):
+            if directory:
+                globs.append(os.path.join(directory, '*.so'))
+    return globs
+
+
+def _driver_files():
+    """Return the GL driver libraries installed, once each."""
+    files = []
+    seen = set()
+    for pattern in _driver_globs():
+        for name in sorted(glob.glob(pattern)):
+            try:
+                st = os.stat(name)
+            except OSError:
+                continue
+            # The same file is usually reached by several symlinks, and
+            # the dri drivers are hardlinks of one library.
+            if (st.st_dev, st.st_ino) in seen:
+                continue
+            seen.add((st.st_dev, st.st_ino))
+            files.append((os.path.realpath(name), st))
+    return files
+
+
+def _render_devices():
+    """Return the PCI vendor and device ids of the DRM devices."""
+    devices = []
+    for device in sorted(glob.glob('/sys/class/drm/card[0-9]*/device')):
+        ids = []
+        for name in ['vendor', 'device']:
+            try:
+                with open(os.path.join(device, name), 'r') as f:
+                    ids.append(f.read().strip())
+            except OSError:
+                ids.append('')
+        devices.append(':'.join(ids))
+    return devices
+
+
+def driver_identity(describe=None):
+    """Return a string identifying the driver and platform, or None.
+
+    This is a digest of the build-ids of the GL driver libraries (or their
+    size and modification time when they have none), the GPUs, the platform
+    and the environment variables that usually change which driver or
+    features are used, so it changes whenever the driver is rebuilt.
+
+    When no driver library is found describe is called, if given, and the
+    string it returns is used instead of the libraries. None is returned if
+    there is neither.
+
+    """
+    digest = hashlib.sha1()
+    files = _driver_files()
+    if files:
+        for name, st in files:
+            build_id = _elf_build_id(name) or '{}:{}'.format(
+                st.st_size, st.st_mtime_ns)
+            digest.update('{}={}\n'.format(name, build_id).encode('utf-8'))
+        for device in _render_devices():
+            digest.update(device.encode('utf-8'))
+    else:
+        raw = describe() if describe is not None else None
+        if raw is None:
+            return None
+        digest.update(raw.encode('utf-8'))
+
+    digest.update(OPTIONS.env.get('PIGLIT_PLATFORM', '').encode('utf-8'))
+    for name, value in sorted(os.environ.items()):
+        if name.startswith(_DRIVER_ENV):
+            digest.update('{}={}'.format(name, value).encode('utf-8'))
+    return digest.hexdigest()
+
+
 class StopWflinfo(exceptions.PiglitException):
     """Exception called when wlfinfo getter should stop."""
     def __init__(self, reason):
@@ -81,18 +248,33 @@ class WflInfo(object):
         self.__dict__ = cls.__shared_state
         return self
 
-    @staticmethod
-    def __call_wflinfo(opts):
+    def __call_wflinfo(self, opts):
         """Helper to call wflinfo and reduce code duplication.
 
         This catches and handles CalledProcessError and OSError.ernno == 2
         gracefully: it passes them to allow platforms without a particular
         gl/gles version or wflinfo (resepctively) to work.
 
+        The output is remembered, so that the versions and extensions of a
+        profile come from a single call.
+
         Arguments:
         opts -- arguments to pass to wflinfo other than verbose and platform
 
         """
+        outputs = self.__dict__.setdefault('_outputs', {})
+        key = tuple(opts)
+        if key not in outputs:
+            try:
+                outputs[key] = self.__run_wflinfo(opts)
+            except StopWflinfo as e:
+                outputs[key] = e
+        if isinstance(outputs[key], StopWflinfo):
+            raise outputs[key]
+        return outputs[key]
+
+    @staticmethod
+    def __run_wflinfo(opts):
         with open(os.devnull, 'w') as d:
             try:
                 # Get the piglit platform string and, if needed, convert it
@@ -128,6 +310,36 @@ class WflInfo(object):
                 raise
         return raw.decode('utf-8')
 
+    @staticmethod
+    def __profile_opts(profile):
+        """Return the wflinfo arguments that describe profile."""
+        if profile in ['core', 'compat', 'none']:
+            return ['--verbose', '--api', 'gl', '--profile', profile]
+        return ['--verbose', '--api', profile]
+
+    def __probe(self, profiles):
+        """Run wflinfo for all of the profiles at once.
+
+        Each call creates a context, which is much of the time a run spends
+        before the first test starts, so the calls run in parallel.
+
+        """
+        outputs = self.__dict__.setdefault('_outputs', {})
+        missing = [self.__profile_opts(p) for p in profiles
+                   if tuple(self.__profile_opts(p)) not in outputs]
+        if not missing:
+            return
+
+        def run(opts):
+            try:
+                return self.__run_wflinfo(opts)
+            except StopWflinfo as e:
+                return e
+
+        with concurrent.futures.ThreadPoolExecutor(len(missing)) as pool:
+            for opts, output in zip(missing, pool.map(run, missing)):
+                outputs[tuple(opts)] = output
+
     @staticmethod
     def __getline(lines, name):
         """Find a line in a list return it."""
@@ -141,8 +353,7 @@ class WflInfo(object):
         ret = 0.0
         if profile in ['core', 'compat', 'none']:
             try:
-                raw = self.__call_wflinfo(
-                    ['--verbose', '--api', 'gl', '--profile', profile])
+                raw = self.__call_wflinfo(self.__profile_opts(profile))
             except StopWflinfo as e:
                 if e.reason not in ['Called', 'OSError']:
                     raise
@@ -156,7 +367,7 @@ class WflInfo(object):
                     pass
         elif profile in ['gles2', 'gles3']:
             try:
-                raw = self.__call_wflinfo(['--verbose', '--api', profile])
+                raw = self.__call_wflinfo(self.__profile_opts(profile))
             except StopWflinfo as e:
                 if e.reason not in ['Called', 'OSError']:
                     raise
@@ -177,7 +388,7 @@ class WflInfo(object):
         ret = 0.0
         if profile in ['core', 'compat', 'none']:
             try:
-                raw = self.__call_wflinfo(['--api', 'gl', '--profile', profile])
+                raw = self.__call_wflinfo(self.__profile_opts(profile))
             except StopWflinfo as e:
                 if e.reason not in ['Called', 'OSError']:
                     raise
@@ -192,7 +403,7 @@ class WflInfo(object):
                     pass
         else:
             try:
-                raw = self.__call_wflinfo(['--api', profile])
+                raw = self.__call_wflinfo(self.__profile_opts(profile))
             except StopWflinfo as e:
                 if e.reason not in ['Called', 'OSError']:
                     raise
@@ -230,10 +441,7 @@ class WflInfo(object):
                 ret.split('\n'), 'OpenGL extensions')[_trim:].split()))
 
         try:
-            if profile in ['core', 'compat', 'none']:
-                helper(['--verbose', '--api', 'gl', '--profile', profile])
-            else:
-                helper(['--verbose', '--api', profile])
+            helper(self.__profile_opts(profile))
         except StopWflinfo as e:
             # Handle wflinfo not being installed by returning an empty set. This
             # will essentially make FastSkipMixin a no-op.
@@ -247,12 +455,82 @@ class WflInfo(object):
             return set()
         return ret
 
+    def __driver_identity(self):
+        """Return a string identifying the driver and platform, or None.
+
+        See driver_identity(). When no driver library is found the basic (non
+        verbose) wflinfo output, which names the renderer and the driver
+        version, is used instead of the build-ids. None of the rest needs a
+        context, so a run with a cached driver doesn't call wflinfo at all.
+
+        """
+        identity = self.__dict__.get('_identity', False)
+        if identity is not False:
+            return identity
+
+        def describe():
+            try:
+                return self.__call_wflinfo(['--api', 'gl'])
+            except StopWflinfo:
+                return None
+
+        identity = driver_identity(describe)
+        self.__dict__['_identity'] = identity
+        return identity
+
+    def __cached_info(self, identity, profile):
+        if identity is None:
+            return None
+        cached = core.load_cache('wflinfo').get(identity, {}).get(profile)
+        if cached is None:
+            return None
+        return ProfileInfo(cached['shader_version'], cached['api_version'],
+                           set(cached['extensions']))
+
     def __build_info(self, profile):
-        return ProfileInfo(
-            self.__get_shader_version(profile),
-            self.__get_language_version(profile),
-            self.__get_extensions(profile)
-        )
+        """Get the information about profile.
+
+        As long as the driver doesn't change, this is the same from one run to
+        the next, so it is cached between runs. When it isn't cached, all of
+        the profiles are probed at once and cached together.
+
+        """
+        identity = self.__driver_identity()
+        info = self.__cached_info(identity, profile)
+        if info is not None:
+            return info
+
+        with _CACHE_LOCK:
+            # Another profile may have probed this one in the meantime
+            info = self.__cached_info(identity, profile)
+            if info is not None:
+                return info
+
+            profiles = list(_PROFILES)
+            if profile not in profiles:
+                profiles.append(profile)
+            self.__probe(profiles)
+
+            infos = {}
+            for each in profiles:
+                infos[each] = ProfileInfo(
+                    self.__get_shader_version(each),
+                    self.__get_language_version(each),
+                    self.__get_extensions(each)
+                )
+
+            if identity is not None:
+                cache = core.load_cache('wflinfo')
+                entry = cache.setdefault(identity, {})
+                for each, each_info in infos.items():
+                    entry[each] = {
+                        'shader_version': each_info.shader_version,
+                        'api_version': each_info.api_version,
+                        'extensions': sorted(each_info.extensions),
+                    }
+                core.store_cache('wflinfo', cache)
+
+        return infos[profile]
 
     @lazy_property
     def core(self):
@@ -51,10 +51,13 @@
 import collections
 import itertools
 import functools
+import os
 import warnings
 
 import numpy as np
 
+from modules import utils
+
 if np.lib.NumpyVersion(np.__version__) >= '2.0.0b1':
     np.set_printoptions(legacy = "1.25")
 
@@ -159,6 +162,11 @@ class GlslBuiltinType(object):
     def __repr__(self):
         return 'glsl_{0}'.format(self.__name)
 
+    def __reduce__(self):
+        # Unpickle the types of the cached test suite as the declarations
+        # below
+        return 'glsl_{0}'.format(self.__name)
+
 
 # Concrete declarations of GlslBuiltinType
 glsl_bool   = GlslBuiltinType('bool',   None,       1, 1, 110)
@@ -1110,7 +1118,6 @@ def _make_componentwise_test_vectors(test_suite_dict):
       [np.linspace(-20, 20, 2).astype(np.int64), np.linspace(-30, 30, 2).astype(np.int64), bools],
       extension="ARB_gpu_shader_int64",
       template_spirv='OpSelect {0} {3} {2} {1}')
-_make_componentwise_test_vectors(test_suite)
 
 
 def _make_vector_relational_test_vectors(test_suite_dict):
@@ -1198,7 +1205,6 @@ def _make_vector_relational_test_vectors(test_suite_dict):
       None)
     f('not', 1, 110, lambda x: not x, 'b',
       'OpLogicalNot {} {}')
-_make_vector_relational_test_vectors(test_suite)
 
 
 def _make_vector_or_matrix_test_vectors(test_suite_dict):
@@ -2013,7 +2019,6 @@ def _make_vector_or_matrix_test_vectors(test_suite_dict):
       template='({0} >> {1})',
       template_spirv=spirv_right_shift_operator,
       extension="ARB_gpu_shader_int64")
-_make_vector_or_matrix_test_vectors(test_suite)
 
 
 def _check_signature_safety(test_suite_dict):
@@ -2028,4 +2033,19 @@ def _check_signature_safety(test_suite_dict):
             raise Exception(
                 'Duplicate signature found for {0}'.format(name_argtype_combo))
         name_argtype_combos.add(name_argtype_combo)
-_check_signature_safety(test_suite)
+
+
+def _make_test_suite():
+    test_suite_dict = {}
+    _make_componentwise_test_vectors(test_suite_dict)
+    _make_vector_relational_test_vectors(test_suite_dict)
+    _make_vector_or_matrix_test_vectors(test_suite_dict)
+    _check_signature_safety(test_suite_dict)
+    return test_suite_dict
+
+
+# Computing the test vectors takes a while, and every generator importing
+# this module needs the same ones.
+test_suite.update(utils.cached(
+    os.path.splitext(os.path.basename(__file__))[0],
+    [__file__], _make_test_suite, np.__version__))
@@ -51,9 +51,12 @@
 import collections
 import itertools
 import functools
+import os
 
 import numpy as np
 
+from modules import utils
+
 if np.lib.NumpyVersion(np.__version__) >= '2.0.0b1':
     np.set_printoptions(legacy = "1.25")
 
@@ -151,6 +154,11 @@ class GlslBuiltinType(object):
     def __repr__(self):
         return 'glsl_{0}'.format(self.__name)
 
+    def __reduce__(self):
+        # Unpickle the types of the cached test suite as the declarations
+        # below
+        return 'glsl_{0}'.format(self.__name)
+
 
 # Concrete declarations of GlslBuiltinType
 glsl_bool   = GlslBuiltinType('bool',   None,       1, 1, 110)
@@ -801,8 +809,6 @@ def _make_componentwise_test_vectors(test_suite_dict):
       [np.linspace(-1.9, 1.9, 4), np.linspace(-1.9, 1.9, 4),
        np.linspace(-2.0, 2.0, 4)])
 
-_make_componentwise_test_vectors(test_suite)
-
 
 def _make_vector_relational_test_vectors(test_suite_dict):
     """Add test vectors to test_suite_dict for GLSL built-in functions
@@ -855,8 +861,6 @@ def _make_vector_relational_test_vectors(test_suite_dict):
     f('equal', 2, lambda x, y: x == y, 'v')
     f('notEqual', 2, lambda x, y: x != y, 'v')
 
-_make_vector_relational_test_vectors(test_suite)
-
 
 def _make_vector_or_matrix_test_vectors(test_suite_dict):
     """Add test vectors to test_suite_dict for GLSL built-in functions
@@ -1157,7 +1161,6 @@ def _make_vector_or_matrix_test_vectors(test_suite_dict):
     f('inverse', 1, np.linalg.inv, None, [dsquaredmats])
 
     f('determinant', 1, np.linalg.det, None, [dsquaredmats])
-_make_vector_or_matrix_test_vectors(test_suite)
 
 
 def _check_signature_safety(test_suite_dict):
@@ -1172,4 +1175,19 @@ def _check_signature_safety(test_suite_dict):
             raise Exception(
                 'Duplicate signature found for {0}'.format(name_argtype_combo))
         name_argtype_combos.add(name_argtype_combo)
-_check_signature_safety(test_suite)
+
+
+def _make_test_suite():
+    test_suite_dict = {}
+    _make_componentwise_test_vectors(test_suite_dict)
+    _make_vector_relational_test_vectors(test_suite_dict)
+    _make_vector_or_matrix_test_vectors(test_suite_dict)
+    _check_signature_safety(test_suite_dict)
+    return test_suite_dict
+
+
+# Computing the test vectors takes a while, and every generator importing
+# this module needs the same ones.
+test_suite.update(utils.cached(
+    os.path.splitext(os.path.basename(__file__))[0],
+    [__file__], _make_test_suite, np.__version__))
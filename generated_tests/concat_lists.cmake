@@ -0,0 +1,11 @@
+# Write the concatenation of the files INPUTS, separated by |, to
+# OUTPUT.
+#
+# Used by piglit_make_sharded_generated_tests to join the file lists
+# of the shards of a generator.
+string(REPLACE "|" ";" inputs "${INPUTS}")
+file(WRITE ${OUTPUT} "")
+foreach(input ${inputs})
+	file(READ ${input} contents)
+	file(APPEND ${OUTPUT} "${contents}")
+endforeach(input)
@@ -801,7 +801,7 @@ class ShaderTest(object):
         filename = self.filename()
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             f.write(shader_test)
 
 
@@ -1213,7 +1213,7 @@ def main():
         action='store_true',
         help="Don't output files, just generate a list of filenames to stdout")
     options, args = parser.parse_args()
-    for test in all_tests():
+    for test in utils.shard(all_tests()):
         if not options.names_only:
             test.generate_shader_test()
         print(test.filename())
@@ -83,7 +83,7 @@ def print_config(f, type_name, utype_name):
 def begin_test(type_name, utype_name):
     fileName = os.path.join(DIR_NAME, 'builtin-shuffle2-{}-{}.cl'.format(type_name, utype_name))
     print(fileName)
-    f = open(fileName, 'w')
+    f = utils.open_if_changed(fileName)
     print_config(f, type_name, utype_name)
     return f
 
@@ -52,7 +52,7 @@ def feat_req(type_name):
 def begin_test(suffix, type_name, mem_type, vec_sizes, addr_space, aligned):
     file_name = os.path.join(DIR_NAME, "vload{}-{}-{}.cl".format(suffix, type_name, addr_space))
     print(file_name)
-    f = open(file_name, 'w')
+    f = utils.open_if_changed(file_name)
     f.write(textwrap.dedent(("""\
     /*!
     [config]
@@ -87,7 +87,7 @@ def main():
 
         print(name)
 
-        with open(name, 'w') as f:
+        with utils.open_if_changed(name) as f:
             try:
                 f.write(TEMPLATE.render_unicode(
                     func='equal', input=x[0:2], expected=x[2]))
@@ -108,7 +108,7 @@ def main():
 
         print(name)
 
-        with open(name, 'w') as f:
+        with utils.open_if_changed(name) as f:
             try:
                 f.write(TEMPLATE.render_unicode(
                     func='notEqual', input=x[0:2], expected=expected))
@@ -571,7 +571,7 @@ class RegularTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
+            with utils.open_if_changed(filename) as test_file:
                 try:
                     test_file.write(TEMPLATES.get_template(
                         'compiler.{}.mako'.format(self._stage)).render_unicode(
@@ -595,7 +595,7 @@ class RegularTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
+            with utils.open_if_changed(filename) as test_file:
                 try:
                     test_file.write(TEMPLATES.get_template(
                         'execution.{}.shader_test.mako'.format(self._stage)).render_unicode(
@@ -777,7 +777,7 @@ class ZeroSignTestTuple(TestTuple):
         self._filenames.append(filename)
 
         if not self._names_only:
-            with open(filename, 'w') as test_file:
+            with utils.open_if_changed(filename) as test_file:
                 try:
                     test_file.write(TEMPLATES.get_template(
                         'execution-zero-sign.{}.shader_test.mako'.format(
@@ -844,8 +844,8 @@ def main():
 
     np.seterr(divide='ignore')
 
-    for test in (list(RegularTestTuple.all_tests(args.names_only)) +
-                 list(ZeroSignTestTuple.all_tests(args.names_only))):
+    for test in utils.shard(list(RegularTestTuple.all_tests(args.names_only)) +
+                            list(ZeroSignTestTuple.all_tests(args.names_only))):
         test.generate_test_files()
         for filename in test.filenames:
             print(filename)
@@ -154,7 +154,7 @@ def _gen_tests(ext, version, stage, path, extra_name, extra_extensions):
         name = os.path.join(path, '{}-{}.{}'.format(test, extra_name, stage))
 
         # Open in bytes mode to avoid weirdness in python 2/3 compatibility
-        with open(name, 'wb') as f:
+        with utils.open_if_changed(name, 'wb') as f:
             try:
                 f.write(template.render(
                     version=version,
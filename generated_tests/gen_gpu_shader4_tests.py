@@ -279,7 +279,7 @@ def main():
             for stage in ['frag', 'vert']:
                 filename = '{0}.{1}'.format(name, stage)
                 print(filename)
-                with open(filename, 'w+') as f:
+                with utils.open_if_changed(filename) as f:
                     try:
                         f.write(TEMPLATES.get_template(
                             '{0}.{1}.mako'.format('unary_op', stage)).render_unicode(
@@ -303,7 +303,7 @@ def main():
             for stage in ['frag', 'vert']:
                 filename = '{0}.{1}'.format(name, stage)
                 print(filename)
-                with open(filename, 'w+') as f:
+                with utils.open_if_changed(filename) as f:
                     try:
                         f.write(TEMPLATES.get_template(
                             '{0}.{1}.mako'.format('binary_op', stage)).render_unicode(
@@ -331,7 +331,7 @@ def main():
                 for stage in ['frag', 'vert']:
                     filename = '{0}.{1}'.format(name, stage)
                     print(filename)
-                    with open(filename, 'w+') as f:
+                    with utils.open_if_changed(filename) as f:
                         try:
                             f.write(TEMPLATES.get_template(
                                 '{0}.{1}.mako'.format(tests[0], stage)).render_unicode(
@@ -377,7 +377,7 @@ def main():
                 for stage in stages:
                     filename = '{0}.{1}'.format(name, stage)
                     print(filename)
-                    with open(filename, 'w+') as f:
+                    with utils.open_if_changed(filename) as f:
                         try:
                             f.write(TEMPLATES.get_template(
                                 '{0}.{1}.mako'.format(tests[0], stage)).render_unicode(
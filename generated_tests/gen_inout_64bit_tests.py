@@ -34,6 +34,7 @@ from mako.template import Template
 from mako import exceptions
 
 import random_ubo
+from modules import utils
 
 
 
@@ -240,7 +241,7 @@ def do_test(root_types, explicit_locations, glsl_version, extensions,
 
     print(fullname)
 
-    shader_file = open(fullname, "w", buffering=1)
+    shader_file = utils.open_if_changed(fullname)
 
     names = random_ubo.unique_name_dict()
 
@@ -82,7 +82,7 @@ def apply_indent(text, prefix):
 
 
 def save_shader_text(filepath, shader_text):
-    with open(filepath, 'w') as test_file:
+    with utils.open_if_changed(filepath) as test_file:
         test_file.write(shader_text)
 
 
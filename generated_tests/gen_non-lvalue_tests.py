@@ -68,7 +68,7 @@ def generate(dirname, type_name, op, usage, shader_target):
             _NAMES[op], type_name, usage, shader_target))
 
     print(filename)
-    with open(filename, 'w') as f:
+    with utils.open_if_changed(filename) as f:
         try:
             f.write(TEMPLATES.get_template(
                 '{0}.glsl_parser_test.mako'.format(usage)).render_unicode(
@@ -42,7 +42,7 @@ def main():
                   'mat3x4', 'mat4', 'mat4x2', 'mat4x3', 'mat4x4']:
         name = os.path.join(dirname, 'outerProduct-{0}.vert'.format(type_))
         print(name)
-        with open(name, 'w+') as f:
+        with utils.open_if_changed(name) as f:
             try:
                 f.write(TEMPLATE.render_unicode(type=type_))
             except:
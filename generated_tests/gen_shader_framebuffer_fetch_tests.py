@@ -66,7 +66,7 @@ def gen(src, tests):
     for t in tests:
         print(t['path'])
         utils.safe_makedirs(os.path.dirname(t['path']))
-        with open(t['path'], 'w') as f:
+        with utils.open_if_changed(t['path']) as f:
             try:
                 f.write(template.render(**t))
             except:
@@ -149,7 +149,7 @@ def gen(name, src, tests):
         dirname = os.path.dirname(filename)
         utils.safe_makedirs(dirname)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             try:
                 f.write(template.render(header = gen_header, **t))
             except:
@@ -58,6 +58,7 @@ import sys
 from mako import exceptions
 
 from templates import template_file
+from modules import utils
 
 
 
@@ -215,7 +216,7 @@ def drop_signbit(xs):
 def main():
     """ Main function """
 
-    for signature, test_vectors in test_suite.items():
+    for signature, test_vectors in utils.shard(test_suite.items()):
         arg_float_check = all(arg.base_type == glsl_float for arg in signature.argtypes)
         arg_mat_check = any(arg.is_matrix for arg in signature.argtypes)
         # Filter the test vectors down to only those which deal exclusively in
@@ -248,7 +249,7 @@ def main():
                 num_elements = signature.rettype.num_cols * signature.rettype.num_rows
                 invocation = signature.template.format( *['arg{0}'.format(i)
                                                         for i in range(len(signature.argtypes))])
-                with open(output_filename, 'w') as f:
+                with utils.open_if_changed(output_filename) as f:
                     try:
                         f.write(template.render_unicode( signature=signature,
                                                         is_complex_tolerance=_is_sequence(tolerance),
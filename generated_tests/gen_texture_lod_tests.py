@@ -89,7 +89,7 @@ def main():
                 dimensions=params.dimensions,
                 coord=params.coord))
         print(name)
-        with open(name, 'w+') as f:
+        with utils.open_if_changed(name) as f:
             try:
                 f.write(TEMPLATES.get_template(
                     'frag_lod.glsl_parser_test.mako').render_unicode(param=params))
@@ -108,7 +108,7 @@ def main():
 
         for stage in ['frag', 'vert']:
             print('{0}.{1}'.format(name, stage))
-            with open('{0}.{1}'.format(name, stage), 'w+') as f:
+            with utils.open_if_changed('{0}.{1}'.format(name, stage)) as f:
                 try:
                     f.write(TEMPLATES.get_template(
                         'tex_grad.{0}.mako'.format(stage)).render_unicode(
@@ -28,7 +28,7 @@ import sys
 from mako import exceptions
 
 from templates import template_dir
-from modules.utils import lazy_property, safe_makedirs
+from modules.utils import lazy_property, open_if_changed, safe_makedirs
 
 TEMPLATES = template_dir(os.path.basename(os.path.splitext(__file__)[0]))
 FS_TEMPLATE = TEMPLATES.get_template('fs.shader_test.mako')
@@ -150,7 +150,7 @@ def make_fs(name, params):
     """Generate a fragment shader test."""
     dirname = DIRNAME.format(params.formated_version)
     safe_makedirs(dirname)
-    with open(os.path.join(dirname, name), 'w') as f:
+    with open_if_changed(os.path.join(dirname, name)) as f:
         try:
             f.write(FS_TEMPLATE.render_unicode(params=params))
         except:
@@ -163,7 +163,7 @@ def make_vs(name, params):
     """Generate a vertex shader test."""
     dirname = DIRNAME.format(params.formated_version)
     safe_makedirs(dirname)
-    with open(os.path.join(dirname, name), 'w') as f:
+    with open_if_changed(os.path.join(dirname, name)) as f:
         try:
             f.write(VS_TEMPLATE.render_unicode(params=params))
         except:
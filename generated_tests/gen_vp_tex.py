@@ -53,7 +53,7 @@ def main():
         for target in targets_1:
             fname = os.path.join(dirname,
                                  "{}-{:0>2d}.txt".format(inst.lower(), i))
-            with open(fname, 'w') as f:
+            with utils.open_if_changed(fname) as f:
                 try:
                     f.write(template.render_unicode(target=target, inst=inst))
                 except:
@@ -66,7 +66,7 @@ def main():
         for target in targets_1:
             fname = os.path.join(dirname,
                                  "{}-{:0>2d}.txt".format(inst.lower(), i))
-            with open(fname, 'w') as f:
+            with utils.open_if_changed(fname) as f:
                 try:
                     f.write(template.render_unicode(target=target, inst=inst))
                 except:
@@ -79,7 +79,7 @@ def main():
         for target in ["CUBE", "RECT"]:
             fname = os.path.join(dirname,
                                  "{}-{:0>2d}.txt".format(inst.lower(), i))
-            with open(fname, 'w') as f:
+            with utils.open_if_changed(fname) as f:
                 try:
                     f.write(template.render_unicode(target=target, inst=inst))
                 except:
@@ -90,7 +90,7 @@ def main():
 
         template = TEMPLATES.get_template('nvvp3.mako')
         fname = os.path.join(dirname, "{}-{:0>2d}.txt".format(inst.lower(), i))
-        with open(fname, 'w') as f:
+        with utils.open_if_changed(fname) as f:
             try:
                 f.write(template.render_unicode(target="SHADOWRECT", inst=inst))
             except:
@@ -103,7 +103,7 @@ def main():
         for target in ["SHADOW1D", "SHADOW2D", "SHADOWRECT"]:
             fname = os.path.join(dirname,
                                  "{}-{:0>2d}.txt".format(inst.lower(), i))
-            with open(fname, 'w') as f:
+            with utils.open_if_changed(fname) as f:
                 try:
                     f.write(template.render_unicode(target=target, inst=inst))
                 except:
@@ -120,7 +120,7 @@ def main():
         name = "float16-float32-constant-{m}x{n}x{k}-acc-{acc_constant}.vk_shader_test".format(**t)
         filename = os.path.join(base_dir, name)
 
-        with open(filename, "w") as f:
+        with utils.open_if_changed(filename) as f:
             try:
                 f.write(templ.render_unicode(**t))
             except:
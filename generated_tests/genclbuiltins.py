@@ -1,6 +1,8 @@
 # coding=utf-8
 import os
 
+from modules import clpack, utils
+
 __all__ = ['gen', 'DATA_SIZES', 'MAX_VALUES', 'MAX', 'MIN', 'BMIN', 'BMAX',
            'SMIN', 'SMAX', 'UMIN', 'UMAX', 'TYPE', 'T', 'U', 'B']
 
@@ -429,66 +431,71 @@ def gen(types, minVersions, functions, testDefs, dirName):
 
     # Loop over all data types being tested. Create one output file per data
     # type
-    for dataType in types:
-        for fnName in functions:
-            # Merge all of the generic/signed/unsigned/custom test definitions
-            if (dataType, fnName) not in testDefs:
-                continue
-            functionDef = testDefs[(dataType, fnName)]
-
-            # Check if the function actually exists for this data type
-            if (not functionDef.keys()):
-                continue
-
-            clcVersionMin = minVersions[fnName]
-
-            fileName = 'builtin-' + dataType + '-' + fnName + '-' + \
-                str(float(clcVersionMin)/10)+'.generated.cl'
-
-            fileName = os.path.join(dirName, fileName)
-
-            with open(fileName, 'w') as f:
-                print(fileName)
-                # Write the file header
-                f.write('/*!\n' +
-                        '[config]\n' +
-                        'name: Test '+dataType+' '+fnName+' built-in on CL 1.1\n' +
-                        'clc_version_min: '+str(clcVersionMin)+'\n' +
-                        'dimensions: 1\n'
-                )
-                if (dataType == 'double'):
-                    f.write('require_device_extensions: cl_khr_fp64\n')
-                if (dataType in ('long', 'ulong')):
-                    f.write('require_device_features: int64\n')
-
-                # Blank line  to provide separation between config header and tests
-                f.write('\n')
-
-                # Write all tests for the built-in function
-                tests = functionDef['values']
-                argCount = len(functionDef['arg_types'])
-                fnType = functionDef['function_type']
-
-                outputValues = tests[0]
-                numTests = len(outputValues)
-
-                # Handle all available scalar/vector widths
-                sizes = sorted(VEC_WIDTHS)
-                sizes.insert(0, 1)  # Add 1-wide scalar to the vector widths
-                for vecSize in sizes:
-                    if (getNumOutArgs(functionDef) == 1):
-                        print_test(f, fnName, dataType, functionDef, tests,
+    combinations = [(dataType, fnName) for dataType in types for fnName in functions
+                    # Merge all of the generic/signed/unsigned/custom test definitions
+                    if (dataType, fnName) in testDefs]
+    for dataType, fnName in utils.shard(combinations):
+        functionDef = testDefs[(dataType, fnName)]
+
+        # Check if the function actually exists for this data type
+        if (not functionDef.keys()):
+            continue
+
+        clcVersionMin = minVersions[fnName]
+
+        fileName = 'builtin-' + dataType + '-' + fnName + '-' + \
+            str(float(clcVersionMin)/10)+'.generated.cl'
+
+        fileName = os.path.join(dirName, fileName)
+
+        with utils.open_if_changed(fileName) as f:
+            print(fileName)
+            # Write the file header
+            f.write('/*!\n' +
+                    '[config]\n' +
+                    'name: Test '+dataType+' '+fnName+' built-in on CL 1.1\n' +
+                    'clc_version_min: '+str(clcVersionMin)+'\n' +
+                    'dimensions: 1\n'
+            )
+            if (dataType == 'double'):
+                f.write('require_device_extensions: cl_khr_fp64\n')
+            if (dataType in ('long', 'ulong')):
+                f.write('require_device_features: int64\n')
+
+            # Blank line  to provide separation between config header and tests
+            f.write('\n')
+
+            # Write all tests for the built-in function
+            tests = functionDef['values']
+            argCount = len(functionDef['arg_types'])
+            fnType = functionDef['function_type']
+
+            outputValues = tests[0]
+            numTests = len(outputValues)
+
+            # Handle all available scalar/vector widths
+            sizes = sorted(VEC_WIDTHS)
+            sizes.insert(0, 1)  # Add 1-wide scalar to the vector widths
+            for vecSize in sizes:
+                if (getNumOutArgs(functionDef) == 1):
+                    print_test(f, fnName, dataType, functionDef, tests,
+                               numTests, vecSize, fnType)
+                else:
+                    for loc in ['_private', '_local', '_global']:
+                        print_test(f, fnName + loc, dataType, functionDef, tests,
                                    numTests, vecSize, fnType)
-                    else:
-                        for loc in ['_private', '_local', '_global']:
-                            print_test(f, fnName + loc, dataType, functionDef, tests,
-                                       numTests, vecSize, fnType)
 
-                # Terminate the header section
-                f.write('!*/\n\n')
+            # Terminate the header section
+            f.write('!*/\n\n')
+
+            if (dataType == 'double'):
+                f.write('#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n\n')
 
-                if (dataType == 'double'):
-                    f.write('#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n\n')
+            # Generate the actual kernels
+            generate_kernels(f, dataType, fnName, functionDef)
 
-                # Generate the actual kernels
-                generate_kernels(f, dataType, fnName, functionDef)
+        # Pack the test so that cl-program-tester doesn't have to parse
+        # all of the values
+        packName = os.path.splitext(fileName)[0] + '.program_pack'
+        print(packName)
+        clpack.pack_file(fileName, packName)
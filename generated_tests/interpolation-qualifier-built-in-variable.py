@@ -80,7 +80,7 @@ def make_fs_vs_tests(fs_mode, vs_mode, dirname):
                 VS_TO_FS_VARIABLE_MAP[var]))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             try:
                 f.write(TEMPLATES.get_template('vs-fs.shader_test.mako').render_unicode(
                     vs_mode=vs_mode,
@@ -104,7 +104,7 @@ def make_vs_unused_tests(vs_mode, dirname):
                 VS_TO_FS_VARIABLE_MAP[var]))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             try:
                 f.write(
                     TEMPLATES.get_template('vs-unused.shader_test.mako').render_unicode(
@@ -127,7 +127,7 @@ def make_fs_unused_tests(fs_mode, vs_mode, dirname):
                 VS_TO_FS_VARIABLE_MAP[var]))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             try:
                 f.write(TEMPLATES.get_template('fs-unused.shader_test.mako').render_unicode(
                     vs_mode=vs_mode,
@@ -151,7 +151,7 @@ def make_vs_fs_unused_tests(fs_mode, vs_mode, dirname):
                 VS_TO_FS_VARIABLE_MAP[var]))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             try:
                 f.write(TEMPLATES.get_template(
                     'fs-vs-unused.shader_test.mako').render_unicode(
@@ -176,7 +176,7 @@ def make_vs_fs_flip_tests(fs_mode, vs_mode, dirname):
                 vs_mode, this_side, fs_mode, other_side))
         print(filename)
 
-        with open(filename, 'w') as f:
+        with utils.open_if_changed(filename) as f:
             try:
                 f.write(TEMPLATES.get_template(
                     'vs-fs-flip.shader_test.mako').render_unicode(
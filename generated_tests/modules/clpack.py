@@ -0,0 +1,218 @@
+# encoding=utf-8
+# Copyright © 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Pack OpenCL program tests for cl-program-tester.
+
+A packed test (.program_pack) is a .cl file with a comment config, or a
+.program_test file, in which the values of the buffer arguments are already
+converted to their OpenCL types. cl-program-tester maps these instead of
+parsing every value with regular expressions, which is most of the start up
+time of tests with large arrays.
+
+The file is laid out as:
+
+    header     _HEADER, in the byte order of this machine
+    config     the configuration, '\\0' terminated
+    source     the program source, '\\0' terminated, if packed from a .cl file
+    data       the values, each aligned to _ALIGNMENT bytes
+
+In the packed configuration a buffer value is replaced by "packed <offset>",
+the offset of its value in data. Values that can't be packed exactly as
+cl-program-tester would convert them, like half values, stay as they are.
+"""
+
+import math
+import re
+import struct
+
+from .utils import open_if_changed
+
+__all__ = ['pack', 'pack_file']
+
+MAGIC = b'PCLPACK\0'
+VERSION = 1
+BYTE_ORDER = 0x01020304
+
+# magic, version, byte order, then offset and size of config, source and data
+_HEADER = struct.Struct('=8sII6Q')
+_ALIGNMENT = 16
+
+# struct formats of the types that can be packed, by bits for integers
+_INTEGER_TYPES = {
+    'char': 8, 'uchar': 8,
+    'short': 16, 'ushort': 16,
+    'int': 32, 'uint': 32,
+    'long': 64, 'ulong': 64,
+}
+_UNSIGNED_FORMATS = {8: 'B', 16: 'H', 32: 'I', 64: 'Q'}
+_FLOAT_FORMATS = {'float': 'f', 'double': 'd'}
+
+_COMMENT_CONFIG = re.compile(r'/\*!(.*)!\*/', re.DOTALL)
+_BUFFER_ARG = re.compile(
+    r'^(?P<head>\s*arg_(?:in|out)\s*:\s*\d+\s+buffer\s+'
+    r'(?P<type>[a-z]+)(?P<width>\d*)\[(?P<length>\d+)\])'
+    r'\s+(?P<values>.*?)'
+    r'(?P<tail>\s+tolerance\s+\S+(?:\s+ulp)?)?\s*$')
+
+# The values cl-program-tester accepts, see REGEX_INT, REGEX_UINT and
+# REGEX_FLOAT in program-tester.c
+_INT = re.compile(r'^[+-]?(0[Xx][0-9a-fA-F]+|[0-9]+)$')
+_FLOAT = re.compile(r'^[+-]?[0-9]+(\.[0-9]+)?(e[+-]?[0-9]+)?$')
+_FLOAT_HEX = re.compile(r'^[+-]?0[Xx][0-9a-fA-F.]+([pP][+-]?[0-9]+)?$')
+_FLOAT_SPECIAL = re.compile(r'^[+-]?(nan|NAN|NaN|infinity|INFINITY|Infinity|'
+                            r'inf|INF|Inf)$')
+
+
+def _parse_int(token):
+    """Parse token like strtoll() with base 0 does."""
+    if not _INT.match(token):
+        raise ValueError(token)
+    sign = -1 if token[0] == '-' else 1
+    digits = token.lstrip('+-')
+    if digits[:2] in ('0x', '0X'):
+        return sign * int(digits, 16)
+    if len(digits) > 1 and digits[0] == '0':
+        return sign * int(digits, 8)
+    return sign * int(digits, 10)
+
+
+def _parse_float(token):
+    """Parse token like strtod() does."""
+    if _FLOAT.match(token) or _FLOAT_SPECIAL.match(token):
+        return float(token)
+    if _FLOAT_HEX.match(token):
+        return float.fromhex(token)
+    raise ValueError(token)
+
+
+def _to_float(value):
+    """Return value, or infinity where the C conversion to float overflows.
+
+    struct refuses to pack these.
+    """
+    try:
+        struct.pack('=f', value)
+    except OverflowError:
+        return math.copysign(float('inf'), value)
+    return value
+
+
+def _pack_values(type_, width, length, tokens):
+    """Return the values as cl-program-tester would lay them out in memory.
+
+    Raises ValueError if they can't be packed.
+    """
+    # 3-component vectors take the memory of 4
+    mem_width = 4 if width == 3 else width
+    if len(tokens) != length * width:
+        raise ValueError('expected {} values'.format(length * width))
+
+    if type_ in _INTEGER_TYPES:
+        bits = _INTEGER_TYPES[type_]
+        if type_.startswith('u') and any(t.startswith('-') for t in tokens):
+            raise ValueError('negative unsigned value')
+        values = [_parse_int(t) for t in tokens]
+        if any(not -2**63 <= v < 2**64 for v in values):
+            raise ValueError('value out of range')
+        # Like the C conversion, keep the low bits
+        values = [v & (2**bits - 1) for v in values]
+        fmt = _UNSIGNED_FORMATS[bits]
+    elif type_ in _FLOAT_FORMATS:
+        values = [_parse_float(t) for t in tokens]
+        fmt = _FLOAT_FORMATS[type_]
+        if fmt == 'f':
+            values = [_to_float(v) for v in values]
+    else:
+        raise ValueError('type {} is not packed'.format(type_))
+
+    padded = []
+    for i in range(length):
+        padded.extend(values[i * width:(i + 1) * width])
+        padded.extend([0] * (mem_width - width))
+
+    return struct.pack('={}{}'.format(len(padded), fmt), *padded)
+
+
+def _pack_config(config, data):
+    """Replace the buffer values of config by references into data."""
+    lines = []
+    for line in config.split('\n'):
+        match = _BUFFER_ARG.match(line)
+        # Leave lines with comments or continuations to cl-program-tester
+        if match and '#' not in line and not line.rstrip().endswith('\\'):
+            width = int(match.group('width') or 1)
+            try:
+                packed = _pack_values(match.group('type'), width,
+                                      int(match.group('length')),
+                                      match.group('values').split())
+            except ValueError:
+                pass
+            else:
+                line = '{} packed {}{}'.format(match.group('head'), len(data),
+                                               match.group('tail') or '')
+                data.extend(packed)
+                data.extend(b'\0' * (-len(data) % _ALIGNMENT))
+        lines.append(line)
+
+    return '\n'.join(lines)
+
+
+def pack(text, is_source):
+    """Return the packed test of text.
+
+    If is_source text is a program with a comment config, otherwise it is the
+    contents of a .program_test file.
+    """
+    source = b''
+    if is_source:
+        match = _COMMENT_CONFIG.search(text)
+        if match is None:
+            raise ValueError('no comment config')
+        config = match.group(1)
+        # The compiler doesn't need the config, keep the lines numbered as
+        # in the original for the build log.
+        source = (text[:match.start()] + '\n' * config.count('\n') +
+                  text[match.end():]).encode('utf-8') + b'\0'
+    else:
+        config = text
+
+    data = bytearray()
+    config = _pack_config(config, data).encode('utf-8') + b'\0'
+
+    config_offset = _HEADER.size
+    source_offset = config_offset + len(config)
+    data_offset = source_offset + len(source)
+    padding = -data_offset % _ALIGNMENT
+    data_offset += padding
+
+    header = _HEADER.pack(MAGIC, VERSION, BYTE_ORDER,
+                          config_offset, len(config),
+                          source_offset, len(source),
+                          data_offset, len(data))
+    return header + config + source + b'\0' * padding + bytes(data)
+
+
+def pack_file(in_name, out_name):
+    """Pack the .cl or .program_test file in_name into out_name."""
+    with open(in_name, 'r') as f:
+        text = f.read()
+    with open_if_changed(out_name, 'wb') as f:
+        f.write(pack(text, in_name.endswith('.cl')))
@@ -24,6 +24,11 @@
 import os
 import errno
 import functools
+import hashlib
+import io
+import pickle
+import sys
+import tempfile
 
 
 def safe_makedirs(dirs):
@@ -46,6 +51,139 @@ def safe_makedirs(dirs):
                 raise
 
 
+class _ChangedFile(object):
+    """A file that is only written when it is closed, and only if its
+    contents changed.
+
+    See open_if_changed().
+    """
+    def __init__(self, filename, mode):
+        self.name = filename
+        self.__binary = 'b' in mode
+        self.__buffer = io.BytesIO() if self.__binary else io.StringIO()
+
+    def write(self, data):
+        return self.__buffer.write(data)
+
+    def writelines(self, lines):
+        self.__buffer.writelines(lines)
+
+    def flush(self):
+        pass
+
+    def close(self):
+        if self.__buffer is None:
+            return
+        contents = self.__buffer.getvalue()
+        self.__buffer = None
+        if self.__binary:
+            contents = bytes(contents)
+        else:
+            contents = contents.encode('utf-8')
+
+        try:
+            with open(self.name, 'rb') as f:
+                if f.read() == contents:
+                    return
+        except (IOError, OSError):
+            pass
+
+        with open(self.name, 'wb') as f:
+            f.write(contents)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        if exc_type is None:
+            self.close()
+        else:
+            self.__buffer = None
+
+
+def open_if_changed(filename, mode='w'):
+    """Open filename for writing, keeping the file as it is if the same
+    contents are written to it again.
+
+    This is used in place of open() by the generators so that regenerating
+    tests that didn't change doesn't touch them, and what depends on them
+    doesn't see them as new. The file is written when it is closed.
+
+    """
+    return _ChangedFile(filename, mode)
+
+
+def _shard_of_run():
+    """Return the index and count of the shard set in PIGLIT_GEN_SHARD."""
+    value = os.environ.get('PIGLIT_GEN_SHARD')
+    if not value:
+        return 0, 1
+    index, count = (int(v) for v in value.split('/'))
+    if not 0 <= index < count:
+        raise ValueError('invalid PIGLIT_GEN_SHARD: {}'.format(value))
+    return index, count
+
+
+def shard(iterable):
+    """Yield the items of iterable that this run of the generator makes.
+
+    The build can split a large generator into shards that run in parallel
+    by setting PIGLIT_GEN_SHARD to "<index>/<count>". Shard index makes
+    every count-th item starting from item index, without it every item is
+    made.
+
+    """
+    index, count = _shard_of_run()
+    for i, item in enumerate(iterable):
+        if i % count == index:
+            yield item
+
+
+def cached(name, sources, compute, version=''):
+    """Return the value compute() returns, from a cache shared by the
+    generators.
+
+    The value is pickled in <name>.pickle in PIGLIT_GEN_CACHE_DIR, or in the
+    current directory, and computed again when the contents of any of the
+    files in sources or version change, so every generator importing a
+    module with expensive values doesn't have to compute them again.
+
+    """
+    key = hashlib.sha256((sys.version + version).encode('utf-8'))
+    for source in sources:
+        with open(source, 'rb') as f:
+            key.update(f.read())
+    key = key.hexdigest()
+
+    directory = os.environ.get('PIGLIT_GEN_CACHE_DIR', os.getcwd())
+    filename = os.path.join(directory, name + '.pickle')
+    try:
+        with open(filename, 'rb') as f:
+            cache_key, value = pickle.load(f)
+        if cache_key == key:
+            return value
+    except Exception:  # pylint: disable=broad-except
+        # Missing, truncated, or pickled from other classes
+        pass
+
+    value = compute()
+
+    # Generators running in parallel may compute the value at the same time,
+    # each of them replaces the cache with a complete file.
+    safe_makedirs(directory)
+    fd, tmp = tempfile.mkstemp(dir=directory, prefix=name + '.',
+                               suffix='.tmp')
+    try:
+        with os.fdopen(fd, 'wb') as f:
+            pickle.dump((key, value), f, pickle.HIGHEST_PROTOCOL)
+        os.replace(tmp, filename)
+    except OSError:
+        # The cache is only an optimization
+        if os.path.exists(tmp):
+            os.remove(tmp)
+    return value
+
+
 class lazy_property(object):
     """Decorator for lazy property loading.
 
@@ -25,6 +25,7 @@ import os
 import errno
 import random
 import random_ubo
+from modules import utils
 
 def do_test(requirements, packing, seed=0):
     random.seed(seed, version=2)
@@ -42,7 +43,7 @@ def do_test(requirements, packing, seed=0):
     basename = random_ubo.generate_file_name(requirements, packing)
     fullname = os.path.join(path, basename)
 
-    file = open(fullname, "w")
+    file = utils.open_if_changed(fullname)
 
     fields, required_layouts = random_ubo.generate_ubo(
         requirements,
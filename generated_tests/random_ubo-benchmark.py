@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+# coding=utf-8
+
+# Copyright (c) 2026 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Generate shader_test benchmarks of reading random block layouts.
+
+Each layout is made by random_ubo from a list of requirements, the way the
+random UBO tests are, with its arrays grown until the block is about
+BLOCK_BYTES under std140.  The same members are then declared as a std140
+uniform block, a std140 shader storage block and a std430 shader storage
+block, and a fragment shader reads every one of them for each pixel with
+"benchmark draw rect".
+
+The arrays are read in loops, either with the loop counter as the index or
+with an index that also depends on the pixel, which the compiler can't
+resolve and which differs between the invocations of a subgroup.
+
+The tests are written to perf/ubo-layout, which the shader profiles skip
+and tests/perf.py runs.
+"""
+
+import os
+import random
+
+import random_ubo
+from random_ubo import (align, array_base_type, array_elements, isarray,
+                        ismatrix, isstructure, isvector, matrix_dimensions,
+                        struct_types, vector_size)
+from modules import utils
+
+# The std140 size the arrays of a layout are grown to, at most.  This
+# leaves room under the 16 KiB minimum of GL_MAX_UNIFORM_BLOCK_SIZE.
+BLOCK_BYTES = 8192
+
+# The name of each layout, and the requirements random_ubo makes it from.
+LAYOUTS = [
+    ("float-array", [["array", "float"]]),
+    ("vec3-array", [["array", "vec3"]]),
+    ("vec4-array", [["array", "vec4"]]),
+    ("mat4-array-row-major", [["row_major", "array", "mat4"]]),
+    ("mat4-array-column-major", [["column_major", "array", "mat4"]]),
+    ("mat2x3-array-row-major", [["row_major", "array", "mat2x3"]]),
+    ("mat2x3-array-column-major", [["column_major", "array", "mat2x3"]]),
+    ("struct-array", [["array", "struct", "vec3", "float"]]),
+    ("mixed", [["array", "int"], ["array", "vec2"], ["struct", "mat3"]]),
+]
+
+# The kinds of block, their packing and the requirements of their tests.
+BLOCKS = [
+    ("ubo", random_ubo.std140_packing_rules(), "GL >= 3.3\nGLSL >= 3.30"),
+    ("ssbo", random_ubo.std140_packing_rules(), "GL >= 4.3\nGLSL >= 4.30"),
+    ("ssbo", random_ubo.std430_packing_rules(), "GL >= 4.3\nGLSL >= 4.30"),
+]
+
+TEMPLATE = """\
+[require]
+{requirements}
+
+# LAYOUT {layout}
+
+[vertex shader passthrough]
+
+[fragment shader]
+{structs}
+{declaration} {{
+{members}
+}};
+
+out vec4 piglit_fragcolor;
+
+void main()
+{{
+    /* An index the compiler can't see through, for the dynamic reads. */
+    int d = int(gl_FragCoord.x) ^ int(gl_FragCoord.y);
+    float acc = 0.0;
+
+{reads}
+    piglit_fragcolor = vec4(acc, 0.0, 0.0, 1.0);
+}}
+
+[test]
+{setup}benchmark draw rect -1 -1 2 2
+"""
+
+
+def block_size(fields, layouts, packing):
+    """Return the size of a block of fields, in bytes."""
+    offset = 0
+    for (field_type, _), layout in zip(fields, layouts):
+        row_major = layout == "row_major"
+        offset = align(offset, packing.base_alignment(field_type, row_major))
+        offset += packing.size(field_type, row_major)
+    return align(offset, 16)
+
+
+def grow_arrays(fields, layouts, packing):
+    """Double the arrays of fields while the block fits in BLOCK_BYTES."""
+    while True:
+        grown = [("{}[{}]".format(array_base_type(t), 2 * array_elements(t))
+                  if isarray(t) else t, n) for t, n in fields]
+        if grown == fields or \
+           block_size(grown, layouts, packing) > BLOCK_BYTES:
+            return fields
+        fields = grown
+
+
+def to_float(type, expr):
+    """Return a float expression that reads all of the components of expr.
+    """
+    if ismatrix(type):
+        c, r = matrix_dimensions(type)
+        return "dot({} * vec{}(1.0), vec{}(1.0))".format(expr, c, r)
+    if isvector(type):
+        n = vector_size(type)
+        return "dot(vec{0}({1}), vec{0}(1.0))".format(n, expr)
+    return "float({})".format(expr)
+
+
+def emit_reads(type, expr, dynamic, depth=0):
+    """Return the lines of GLSL adding all of expr, of type, to acc."""
+    if isarray(type):
+        n = array_elements(type)
+        i = "i{}".format(depth)
+        index = "({} + d) % {}".format(i, n) if dynamic else i
+        body = emit_reads(array_base_type(type),
+                          "{}[{}]".format(expr, index), dynamic, depth + 1)
+        return (["for (int {0} = 0; {0} < {1}; {0}++) {{".format(i, n)] +
+                ["    " + l for l in body] + ["}"])
+    if isstructure(type):
+        lines = []
+        for (field_type, field_name) in struct_types[type]:
+            lines.extend(emit_reads(field_type,
+                                    "{}.{}".format(expr, field_name),
+                                    dynamic, depth))
+        return lines
+    return ["acc += {};".format(to_float(type, expr))]
+
+
+def emit_test(name, fields, layouts, kind, packing, requirements, dynamic):
+    """Return the shader_test of reading fields from a block of kind."""
+    structs = []
+    for s in random_ubo.iterate_structures(fields, [], []):
+        structs.append(random_ubo.fields_to_glsl_struct(s))
+
+    members = []
+    for (field_type, field_name), layout in zip(fields, layouts):
+        qualifier = ""
+        if layout and not layout.startswith("#"):
+            qualifier = "layout({}) ".format(layout)
+        members.append("    {}{} {};".format(qualifier, field_type,
+                                             field_name))
+
+    if kind == "ubo":
+        declaration = "layout({}) uniform UB1".format(packing.layout_string())
+        setup = ""
+    else:
+        declaration = "layout({}, binding = 0) readonly buffer SB1".format(
+            packing.layout_string())
+        setup = "ssbo 0 {}\n".format(block_size(fields, layouts, packing))
+
+    reads = []
+    for (field_type, field_name) in fields:
+        reads.extend("    " + l
+                     for l in emit_reads(field_type, field_name, dynamic))
+
+    return TEMPLATE.format(requirements=requirements,
+                           layout=name,
+                           structs="\n".join(structs),
+                           declaration=declaration,
+                           members="\n".join(members),
+                           reads="\n".join(reads),
+                           setup=setup)
+
+
+def main():
+    path = os.path.join("perf", "ubo-layout")
+    os.makedirs(path, exist_ok=True)
+
+    for seed, (name, description) in enumerate(LAYOUTS):
+        random.seed(seed, version=2)
+        fields, required_layouts = random_ubo.generate_ubo(
+            description, random_ubo.ALL130_TYPES)
+        layouts = random_ubo.generate_layouts(fields, required_layouts, False)
+        fields = grow_arrays(fields, layouts,
+                             random_ubo.std140_packing_rules())
+
+        for kind, packing, requirements in BLOCKS:
+            for dynamic in [False, True]:
+                filename = os.path.join(path, "{}-{}-{}-{}.shader_test".format(
+                    name, kind, packing.layout_string(),
+                    "dynamic" if dynamic else "constant"))
+                print(filename)
+                with utils.open_if_changed(filename) as f:
+                    f.write(emit_test(name, fields, layouts, kind, packing,
+                                      requirements, dynamic))
+
+
+if __name__ == '__main__':
+    main()
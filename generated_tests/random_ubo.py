@@ -1593,6 +1593,44 @@ class shared_packing_rules(std140_packing_rules):
         return False
 
 
+class std430_packing_rules(std140_packing_rules):
+    """The std140 rules without rounding the alignment of arrays, structures
+    and matrices up to that of a vec4.  Only for shader storage blocks.
+    """
+    def layout_string(self):
+        return "std430"
+
+    def base_alignment(self, type, row_major):
+        if isarray(type):
+            return self.base_alignment(array_base_type(type), row_major)
+
+        if isscalar(type) or isvector(type) or ismatrix(type):
+            return super(std430_packing_rules, self).base_alignment(type,
+                                                                   row_major)
+
+        if type not in struct_types:
+            raise Exception("Unknown type {}".format(type))
+
+        return max(self.base_alignment(field_type, row_major)
+                   for (field_type, field_name) in struct_types[type])
+
+    def matrix_stride(self, type, row_major):
+        c, r = matrix_dimensions(type)
+        prefix = "dvec" if type[0] == 'd' else "vec"
+        return self.base_alignment(
+            "{}{}".format(prefix, c if row_major else r), False)
+
+    def array_stride(self, type, row_major):
+        base_type = without_array(type)
+
+        if not isstructure(base_type):
+            return max(self.base_alignment(base_type, row_major),
+                       self.size(base_type, row_major))
+        else:
+            return align(self.size(base_type, row_major),
+                         self.base_alignment(base_type, row_major))
+
+
 class unique_name_dict:
     """Helper class to generate a unique name for each field.
 
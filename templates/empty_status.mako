@@ -19,6 +19,7 @@
           | <a href="${i}.html">${i}</a>
         % endif
       % endfor
+      | <a href="time.html">time</a>
     </p>
     <h1>No ${page}</h1>
   </body>
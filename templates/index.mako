@@ -77,6 +77,7 @@
           | <a href="${i}.html">${i}</a>
         % endif
       % endfor
+      | <a href="time.html">time</a>
     </p>
     <table>
       <colgroup>
@@ -0,0 +1,309 @@
+/*
+ * Renders the client side HTML summary, written by
+ * framework/summary/html_.py when -c/--client-side is given.
+ *
+ * data/index.js calls piglit.index() with the status of every test in every
+ * run, from which the summary tables are built. The system info of each run
+ * and the details of the tests are only loaded when they are shown, from
+ * data/run-<run>.js and data/tests-<run>-<n>.js. The latter each have the
+ * tests of a range of names, index.shards has the first name of each.
+ *
+ * The data files are scripts rather than JSON so that they can also be
+ * loaded when the summary is opened from a file:// URL.
+ */
+
+"use strict";
+
+var piglit = (function () {
+  var index = null;
+  var loaded = {};
+  var waiting = {};
+
+  function escape(text) {
+    return String(text).replace(/[&<>"']/g, function (c) {
+      return {"&": "&amp;", "<": "&lt;", ">": "&gt;", "\"": "&quot;",
+              "'": "&#39;"}[c];
+    });
+  }
+
+  function show(html, stylesheet) {
+    document.getElementById("index-css").disabled = stylesheet !== "index";
+    document.getElementById("result-css").disabled = stylesheet !== "result";
+    document.getElementById("content").innerHTML = html;
+    window.scrollTo(0, 0);
+  }
+
+  /* Call done with the data of the script src, loading it if needed. */
+  function load(src, done) {
+    if (src in loaded) {
+      done(loaded[src]);
+      return;
+    }
+    if (src in waiting) {
+      waiting[src].push(done);
+      return;
+    }
+    waiting[src] = [done];
+
+    var script = document.createElement("script");
+    script.src = src;
+    script.onerror = function () {
+      delete waiting[src];
+      show("<p>Could not load " + escape(src) + "</p>", "index");
+    };
+    document.head.appendChild(script);
+  }
+
+  function provide(src, data) {
+    var callbacks = waiting[src] || [];
+    loaded[src] = data;
+    delete waiting[src];
+    callbacks.forEach(function (done) { done(data); });
+  }
+
+  function groupname(name) {
+    var i = name.lastIndexOf("@");
+    return i < 0 ? "" : name.slice(0, i);
+  }
+
+  function groupCells(group) {
+    var cells = "";
+    var values = index.groups[group] || [];
+    for (var run = 0; run < index.runs.length; run++) {
+      var value = values[run] || ["notrun", "0/0"];
+      cells += "<td class=\"" + value[0] + "\"><b>" + value[1] +
+        "</b></td>";
+    }
+    return cells;
+  }
+
+  function renderPage(page) {
+    var rows = [];
+    var tests = index.pages[page];
+    var pages = ["all"].concat(Object.keys(index.pages));
+    var exclude = {};
+    var current = [];
+    var run, i, j;
+
+    index.exclude.forEach(function (s) { exclude[s] = true; });
+    if (tests === undefined) {
+      tests = index.tests.map(function (_, i) { return i; });
+    }
+
+    rows.push("<h1>Result summary</h1>");
+    rows.push("<p>Currently showing: " + escape(page) + "</p><p>Show: ");
+    rows.push(pages.map(function (p) {
+      return p === page ? p : "<a href=\"#" + p + "\">" + p + "</a>";
+    }).join(" | "));
+    rows.push(" | <a href=\"time.html\">time</a>");
+    rows.push("</p>");
+
+    if (tests.length === 0) {
+      rows.push("<p>No tests to show.</p>");
+      show(rows.join(""), "index");
+      return;
+    }
+
+    rows.push("<table><colgroup><col />");
+    for (run = 0; run < index.runs.length; run++)
+      rows.push("<col />");
+    rows.push("</colgroup><tr><th/>");
+    index.runs.forEach(function (name, run) {
+      rows.push("<th class=\"head\"><b>" + escape(name) +
+                "</b><br>(<a href=\"#run/" + run + "\">info</a>)</th>");
+    });
+    rows.push("</tr><tr><td class=\"head\"><b>all</b></td>" +
+              groupCells("root") + "</tr>");
+
+    for (i = 0; i < tests.length; i++) {
+      var name = index.tests[tests[i]];
+      var parts = name.split("@");
+      var group = parts.slice(0, -1);
+      var common = 0;
+
+      while (common < current.length && common < group.length &&
+             current[common] === group[common])
+        common++;
+      current = current.slice(0, common);
+
+      for (j = common; j < group.length; j++) {
+        current.push(group[j]);
+        rows.push("<tr><td><div class=\"head\" style=\"margin-left: " +
+                  (j + 1) * 1.75 + "em\"><b>" + escape(group[j]) +
+                  "</b></div></td>" + groupCells(current.join("@")) +
+                  "</tr>");
+      }
+
+      rows.push("<tr><td><div class=\"group\" style=\"margin-left: " +
+                (group.length + 1) * 1.75 + "em\">" +
+                escape(parts[parts.length - 1]) + "</div></td>");
+      for (run = 0; run < index.runs.length; run++) {
+        var result = index.statuses[index.results[run][tests[i]]];
+
+        if (result in exclude || result === "notrun") {
+          rows.push("<td class=\"" + result + "\">" + result + "</td>");
+        } else {
+          rows.push("<td class=\"" + result + "\"><a href=\"#test/" + run +
+                    "/" + encodeURIComponent(name) + "\">" + result +
+                    "</a></td>");
+        }
+      }
+      rows.push("</tr>");
+    }
+    rows.push("</table>");
+    show(rows.join(""), "index");
+  }
+
+  function detail(label, value) {
+    return "<tr><td>" + label + "</td><td>" + value + "</td></tr>";
+  }
+
+  function pre(value) {
+    return "<pre>" + escape(value === null ? "" : value) + "</pre>";
+  }
+
+  function renderRun(run) {
+    load("data/run-" + run + ".js", function (data) {
+      var rows = [];
+      var totals = Object.keys(data.totals).sort(function (a, b) {
+        return data.totals[b] - data.totals[a] || (a < b ? 1 : -1);
+      });
+      var sum = 0;
+
+      rows.push("<h1>System info for " + escape(data.name) + "</h1>");
+      rows.push("<p><a href=\"#all\">Back to summary</a></p>");
+      rows.push("<table><tr><th>Detail</th><th>Value</th></tr>");
+      rows.push(detail("totals", "<table>" + totals.map(function (key) {
+        sum += data.totals[key];
+        return "<tr><td>" + escape(key) + "</td><td>" + data.totals[key] +
+          "</td></tr>";
+      }).join("") + "<tr><td>total</td><td>" + sum + "</td></tr></table>"));
+      rows.push(detail("time_elapsed", escape(data.time)));
+      rows.push(detail("name", escape(data.name)));
+      rows.push(detail("options", pre(JSON.stringify(data.options, null, 2))));
+      rows.push(detail("info", "<table>" +
+        Object.keys(data.info).sort().map(function (key) {
+          var sub = data.info[key];
+          if (typeof sub !== "object" || sub === null)
+            return "<tr><td>" + escape(key) + "</td><td>" + pre(sub) +
+              "</td></tr>";
+          return Object.keys(sub).sort().map(function (subkey) {
+            return "<tr><td>" + escape(subkey) + "</td><td>" +
+              pre(sub[subkey]) + "</td></tr>";
+          }).join("");
+        }).join("") + "</table>"));
+      rows.push("</table>");
+      show(rows.join(""), "result");
+    });
+  }
+
+  /* Call done with the details of key in run, or undefined. */
+  function lookup(run, key, done) {
+    var firsts = index.shards[run];
+    var lo = 0, hi = firsts.length;
+
+    /* Find the last shard whose first name is <= key. */
+    while (lo < hi) {
+      var mid = (lo + hi) >> 1;
+      if (firsts[mid] <= key)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if (lo === 0) {
+      done(undefined);
+      return;
+    }
+    load("data/tests-" + run + "-" + (lo - 1) + ".js", function (data) {
+      done(data[key]);
+    });
+  }
+
+  function renderTest(run, name) {
+    /* The results of subtests are in the details of their test. */
+    lookup(run, name, function (value) {
+      if (value !== undefined) {
+        renderDetails(name, value);
+        return;
+      }
+      lookup(run, groupname(name), function (value) {
+        if (value === undefined)
+          show("<p>No details for " + escape(name) + "</p>", "index");
+        else
+          renderDetails(groupname(name), value);
+      });
+    });
+  }
+
+  function renderDetails(name, value) {
+    var rows = [];
+    var back = "<p><a href=\"#all\">Back to summary</a></p>";
+
+    rows.push("<h1>Results for " + escape(name) + "</h1>");
+    rows.push("<h2>Overview</h2><div><p><b>Result:</b> " +
+              escape(value.result) + "</p></div>" + back);
+    rows.push("<h2>Details</h2><table><tr><th>Detail</th><th>Value</th></tr>");
+    rows.push(detail("Returncode", escape(value.returncode)));
+    rows.push(detail("Time", escape(value.time)));
+    if (value.subtests && Object.keys(value.subtests).length > 1) {
+      rows.push(detail("Subtests", "<table>" +
+        Object.keys(value.subtests).filter(function (key) {
+          return key !== "__type__";
+        }).map(function (key) {
+          return "<tr><td>" + escape(key) + "</td><td>" +
+            escape(value.subtests[key]) + "</td></tr>";
+        }).join("") + "</table>"));
+    }
+    if (value.resources && Object.keys(value.resources).length)
+      rows.push(detail("Resources",
+                       pre(JSON.stringify(value.resources, null, 2))));
+    (value.images || []).forEach(function (image) {
+      rows.push(detail("Images", ["image_ref", "image_render"].filter(
+        function (key) { return key in image; }).map(function (key) {
+          return "<a href=\"file://" + escape(image[key]) + "\">" + key +
+            "</a>";
+        }).join(" ")));
+    });
+    if (value.metrics && Object.keys(value.metrics).length)
+      rows.push(detail("Metrics", pre(JSON.stringify(value.metrics, null, 2))));
+    rows.push(detail("Stdout", pre(value.out)));
+    rows.push(detail("Stderr", pre(value.err)));
+    if (value.environment)
+      rows.push(detail("Environment", pre(value.environment)));
+    rows.push(detail("Command", pre(value.command)));
+    if (value.exception)
+      rows.push(detail("Exception", pre(value.exception)));
+    if (value.traceback)
+      rows.push(detail("Traceback", pre(value.traceback)));
+    rows.push(detail("dmesg", pre(value.dmesg)));
+    rows.push("</table>" + back);
+    show(rows.join(""), "result");
+  }
+
+  function route() {
+    var hash = window.location.hash.slice(1);
+    var match;
+
+    if ((match = /^run\/(\d+)$/.exec(hash)) !== null) {
+      renderRun(Number(match[1]));
+    } else if ((match = /^test\/(\d+)\/(.*)$/.exec(hash)) !== null) {
+      renderTest(Number(match[1]), decodeURIComponent(match[2]));
+    } else {
+      renderPage(hash in index.pages ? hash : "all");
+    }
+  }
+
+  return {
+    index: function (data) {
+      index = data;
+      window.addEventListener("hashchange", route);
+      route();
+    },
+    run: function (run, data) {
+      provide("data/run-" + run + ".js", data);
+    },
+    shard: function (run, number, data) {
+      provide("data/tests-" + run + "-" + number + ".js", data);
+    },
+  };
+})();
@@ -77,6 +77,35 @@
         <td>Time</td>
         <td>${value.time.delta}</td>
       </tr>
+    % if value.resources:
+      <tr>
+        <td>Resources</td>
+        <td>
+          <table>
+          % if 'utime' in value.resources:
+            <tr>
+              <td>CPU time</td>
+              <td>${'{:.3f}'.format(value.resources['utime'])} s user, ${'{:.3f}'.format(value.resources['stime'])} s sys</td>
+            </tr>
+            <tr>
+              <td>Max RSS</td>
+              <td>${'{:.1f}'.format(value.resources['maxrss'] / (1 << 20))} MiB</td>
+            </tr>
+            <tr>
+              <td>Context switches</td>
+              <td>${value.resources['nvcsw']} voluntary, ${value.resources['nivcsw']} involuntary</td>
+            </tr>
+          % endif
+          % for engine, busy in sorted(value.resources.get('gpu', {}).items()):
+            <tr>
+              <td>GPU ${engine | h}</td>
+              <td>${'{:.3f}'.format(busy / 1e9)} s</td>
+            </tr>
+          % endfor
+          </table>
+        </td>
+      </tr>
+    % endif
     % if value.images:
       <tr>
         <td>Images</td>
@@ -98,6 +127,36 @@
           </table>
         </td>
       </tr>
+    % endif
+    % if value.metrics:
+      <tr>
+        <td>Metrics</td>
+        <td>
+          <table>
+            <tr>
+              <th>Measurement</th>
+              <th>Value</th>
+              <th>CV</th>
+              <th>Baseline</th>
+              <th>Change</th>
+            </tr>
+          % for name, metric in value.metrics.items():
+            <tr>
+              <td>${name | h}</td>
+              <td>${'{:.4g}'.format(metric['value'])} ${metric['unit'] | h}</td>
+              <td>${'{:.1%}'.format(metric.get('cv', 0))}${' (noisy)' if metric.get('noisy') else ''}</td>
+            % if 'baseline' in metric:
+              <td>${'{:.4g}'.format(metric['baseline'])}</td>
+              <td>${'{:+.1%}'.format(metric['change'])}</td>
+            % else:
+              <td></td>
+              <td></td>
+            % endif
+            </tr>
+          % endfor
+          </table>
+        </td>
+      </tr>
     % endif
       <tr>
         <td>Stdout</td>
@@ -0,0 +1,103 @@
+<%!
+  from framework import grouptools
+  from framework.summary import timing
+
+  def format_time(seconds, first):
+      if seconds is None:
+          return '-'
+      change = timing.change(seconds, first)
+      if seconds is first or change is None:
+          return '{:.2f} s'.format(seconds)
+      return '{:.2f} s ({:+.1%})'.format(seconds, change)
+%>
+<!DOCTYPE html>
+<html lang="en">
+  <head>
+    <meta charset="UTF-8">
+    <title>Time summary</title>
+    <link rel="stylesheet" href="index.css">
+  </head>
+  <body>
+    <h1>Time summary</h1>
+    <p>
+      <a href="index.html">Back to summary</a>
+    </p>
+    <p>The time of a group is the sum of the times of its tests, tests that
+      ran at the same time each count their own. Changes are from the first
+      results.</p>
+    % for kind in ['tests', 'subtests', 'groups']:
+      <% names = timing.slowest(timings, kind, top) %>
+      % if names:
+    <h2>Slowest ${kind}</h2>
+    <table>
+      <tr>
+        <th/>
+        % for each in timings:
+        <th class="head">${each.name}</th>
+        % endfor
+      </tr>
+        % for name in names:
+      <%
+        values = [getattr(t, kind).get(name) for t in timings]
+      %>
+      <tr>
+        <td>${grouptools.format(name)}</td>
+          % for value in values:
+        <td>${format_time(value, values[0])}</td>
+          % endfor
+      </tr>
+        % endfor
+    </table>
+      % endif
+    % endfor
+    <% groups = timing.slowest(timings, 'groups', top) %>
+    % if groups:
+    <h2>Durations of the tests of the slowest groups</h2>
+    <table>
+      <tr>
+        <th/>
+        <th/>
+        % for bucket in timing.bucket_names():
+        <th class="head">${bucket}</th>
+        % endfor
+      </tr>
+      % for group in groups:
+        % for each in timings:
+      <tr>
+        <td>${grouptools.format(group)}</td>
+        <td>${each.name}</td>
+          % for count in each.histogram(group):
+        <td>${count}</td>
+          % endfor
+      </tr>
+        % endfor
+      % endfor
+    </table>
+    % endif
+    <h2>Time lost</h2>
+    <table>
+      <tr>
+        <th/>
+        % for each in timings:
+        <th class="head">${each.name}</th>
+        % endfor
+      </tr>
+      % for status in timing.LOST:
+      <% values = [t.lost[status] for t in timings] %>
+      <tr>
+        <td>${status}</td>
+        % for value in values:
+        <td>${format_time(value, values[0])}</td>
+        % endfor
+      </tr>
+      % endfor
+      <% values = [t.total for t in timings] %>
+      <tr>
+        <td>total</td>
+        % for value in values:
+        <td>${format_time(value, values[0])}</td>
+        % endfor
+      </tr>
+    </table>
+  </body>
+</html>
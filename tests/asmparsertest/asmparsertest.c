@@ -21,6 +21,16 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+/**
+ * \file asmparsertest.c
+ *
+ * Load assembly programs of the type given as the first argument and check
+ * that each either compiles or, if it has a "# FAIL" comment, fails to.
+ *
+ * With --batch before the type, each file is reported as a subtest named
+ * after the file, and a file that fails or skips doesn't stop the others.
+ */
+
 #include <ctype.h>
 
 #include "piglit-util-gl.h"
@@ -100,9 +110,10 @@ dos_line_endings(const char *input, size_t length)
 }
 
 
-void
+enum piglit_result
 compile(const char *filename, GLenum target, int use_ARB)
 {
+	enum piglit_result result = PIGLIT_PASS;
 	GLenum err;
 	GLuint prognum[2];
 	char *buf;
@@ -121,7 +132,7 @@ compile(const char *filename, GLenum target, int use_ARB)
 	buf = piglit_load_text_file(filename, &sz);
 	if (buf == NULL) {
 		fprintf(stderr, "Failed to open %s\n", filename);
-		piglit_report_result(PIGLIT_FAIL);
+		return PIGLIT_FAIL;
 	}
 
 
@@ -147,7 +158,11 @@ compile(const char *filename, GLenum target, int use_ARB)
 			}
 
 			extension[i] = '\0';
-			piglit_require_extension(extension);
+			if (!piglit_is_extension_supported(extension)) {
+				printf("Test requires %s\n", extension);
+				free(buf);
+				return PIGLIT_SKIP;
+			}
 		}
 	}
 
@@ -197,25 +212,72 @@ compile(const char *filename, GLenum target, int use_ARB)
 		}
 
 		if ((err == GL_NO_ERROR) != (expected_fail == FALSE)) {
-			piglit_report_result(PIGLIT_FAIL);
+			result = PIGLIT_FAIL;
 		}
 	}
 
+	if (use_ARB) {
+		glDeleteProgramsARB(2, prognum);
+	} else {
+		glDeleteProgramsNV(2, prognum);
+	}
+
 	free(buf);
 	free(converted_buffers[0]);
 	free(converted_buffers[1]);
 
+	return result;
+}
+
+
+/**
+ * Compile each file of a batch and report it as a subtest named after the
+ * file. If the program type isn't supported, all of them are skipped.
+ */
+void
+run_batch(int num_files, char **files, GLenum target, int use_ARB,
+	  bool supported)
+{
+	enum piglit_result result;
+	const char *name;
+	int i;
+
+	for (i = 0; i < num_files; i++) {
+		name = strrchr(files[i], PIGLIT_PATH_SEP);
+		name = name ? name + 1 : files[i];
+
+		/* Print the name before compiling, so that the run can be
+		 * resumed after this file if it crashes.
+		 */
+		printf("PIGLIT TEST: %i - %s\n", i, name);
+		fprintf(stderr, "PIGLIT TEST: %i - %s\n", i, name);
+
+		result = supported ? compile(files[i], target, use_ARB)
+				   : PIGLIT_SKIP;
+		piglit_report_subtest_result(result, "%s", name);
+	}
+
+	exit(0);
 }
 
 
 void
 piglit_init(int argc, char **argv)
 {
+	enum piglit_result result;
+	const char *extension;
 	GLenum target;
 	unsigned i;
 	int use_ARB;
+	bool batch = false;
 
 
+	if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+		batch = true;
+		argc--;
+		argv++;
+	}
+
 	if (argc < 3) {
 		piglit_report_result(PIGLIT_FAIL);
 	}
@@ -224,25 +286,34 @@ piglit_init(int argc, char **argv)
 	use_ARB = 1;
 	if (strcmp(argv[1], "ARBvp1.0") == 0) {
 		target = GL_VERTEX_PROGRAM_ARB;
-		piglit_require_extension("GL_ARB_vertex_program");
+		extension = "GL_ARB_vertex_program";
 	} else if (strcmp(argv[1], "ARBfp1.0") == 0) {
 		target = GL_FRAGMENT_PROGRAM_ARB;
-		piglit_require_extension("GL_ARB_fragment_program");
+		extension = "GL_ARB_fragment_program";
 	} else if (strcmp(argv[1], "NVvp1.0") == 0) {
 		target = GL_VERTEX_PROGRAM_NV;
-		piglit_require_extension("GL_NV_vertex_program");
+		extension = "GL_NV_vertex_program";
 		use_ARB = 0;
 	} else if (strcmp(argv[1], "NVfp1.0") == 0) {
 		target = GL_FRAGMENT_PROGRAM_NV;
-		piglit_require_extension("GL_NV_fragment_program");
+		extension = "GL_NV_fragment_program";
 		use_ARB = 0;
 	} else {
 		target = GL_NONE;
 		piglit_report_result(PIGLIT_FAIL);
 	}
 
+	if (batch) {
+		run_batch(argc - 2, argv + 2, target, use_ARB,
+			  piglit_is_extension_supported(extension));
+	}
+
+	piglit_require_extension(extension);
+
 	for (i = 2; i < argc; i++) {
-		compile(argv[i], target, use_ARB);
+		result = compile(argv[i], target, use_ARB);
+		if (result != PIGLIT_PASS)
+			piglit_report_result(result);
 	}
 
 	piglit_report_result(PIGLIT_PASS);
@@ -0,0 +1,51 @@
+# encoding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+"""Bundle the generated shader tests of each directory into one file.
+
+See write_bundle() in framework/test/shader_test.py. The shader profiles run
+the tests of a bundle in place of the files of its directory.
+"""
+
+import argparse
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+
+from framework.test.shader_test import BUNDLE_NAME, write_bundle
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('directory',
+                        help='the generated_tests directory of the build')
+    args = parser.parse_args()
+
+    for dirpath, _, filenames in os.walk(args.directory):
+        tests = sorted(f for f in filenames if f.endswith('.shader_test'))
+        if tests:
+            write_bundle(os.path.join(dirpath, BUNDLE_NAME),
+                         [os.path.join(dirpath, f) for f in tests])
+
+
+if __name__ == '__main__':
+    main()
@@ -105,9 +105,16 @@ with profile.test_list.group_manager(PiglitCLTest, 'interop') as g:
 
 
 def add_program_test_dir(group, dirpath, buildbase, installbase):
-    for filename in os.listdir(os.path.join(buildbase, dirpath)):
+    filenames = os.listdir(os.path.join(buildbase, dirpath))
+    packed = set(os.path.splitext(f)[0] for f in filenames
+                 if f.endswith('.program_pack'))
+
+    for filename in filenames:
         testname, ext = os.path.splitext(filename)
-        if ext not in ['.cl', '.program_test']:
+        if ext not in ['.cl', '.program_test', '.program_pack']:
+            continue
+        # Run the packed form of a test instead, if there is one
+        if ext != '.program_pack' and testname in packed:
             continue
 
         profile.test_list[grouptools.join(group, testname)] = CLProgramTester(
@@ -445,9 +445,13 @@ char *source =
 
 #include "piglit-util.h"
 #include "piglit-framework-cl-program.h"
+#include "report.h"
 
 #define EXPECTED_NONCE 1322941352
 
+/* The nonces, and so the hashes, of a benchmark launch. */
+#define BENCHMARK_GLOBAL_SIZE (1 << 20)
+
 PIGLIT_CL_PROGRAM_TEST_CONFIG_BEGIN
 
 	config.name = "Bitcoin phatk kernel";
@@ -458,6 +462,58 @@ PIGLIT_CL_PROGRAM_TEST_CONFIG_BEGIN
 
 PIGLIT_CL_PROGRAM_TEST_CONFIG_END
 
+static cl_command_queue bench_queue;
+static cl_kernel bench_kernel;
+static bool bench_failed;
+
+static double
+run(unsigned count)
+{
+	const size_t global_size = BENCHMARK_GLOBAL_SIZE;
+	const size_t local_size = 256;
+	int64_t start = piglit_time_get_nano();
+	unsigned i;
+
+	for (i = 0; i < count && !bench_failed; i++) {
+		if (!piglit_cl_enqueue_ND_range_kernel(bench_queue, bench_kernel,
+						       1, NULL, &global_size,
+						       &local_size, NULL))
+			bench_failed = true;
+	}
+	clFinish(bench_queue);
+
+	return (piglit_time_get_nano() - start) * 0.000000001;
+}
+
+/**
+ * Measure the hashes/sec of the kernel for the duration, so that codegen
+ * regressions of the CL compiler show up in the perf profile.
+ */
+static enum piglit_result
+benchmark(double duration, const struct piglit_cl_program_test_env* env)
+{
+	struct perf_stats stats;
+	char *device_name;
+	char name[256];
+	double rate;
+
+	bench_queue = env->context->command_queues[0];
+	bench_kernel = env->kernel;
+	rate = perf_measure_rate(run, duration, &stats);
+	if (bench_failed)
+		return PIGLIT_FAIL;
+
+	device_name = piglit_cl_get_device_info(env->device_id, CL_DEVICE_NAME);
+	printf("%s: %.2f Mhashes/sec\n", device_name,
+	       rate * BENCHMARK_GLOBAL_SIZE / 1e6);
+	snprintf(name, sizeof(name), "%s phatk", device_name);
+	perf_report("cl-program-bitcoin-phatk", name, "hashes/sec",
+		    BENCHMARK_GLOBAL_SIZE, &stats);
+	free(device_name);
+
+	return PIGLIT_PASS;
+}
+
 enum piglit_result
 piglit_cl_test(const int argc,
                const char** argv,
@@ -466,6 +522,7 @@ piglit_cl_test(const int argc,
 {
 	unsigned i;
 	enum piglit_result result = PIGLIT_PASS;
+	const char *duration;
 
 	size_t global_size = 32768;
 	size_t local_size = 256;
@@ -537,6 +594,12 @@ piglit_cl_test(const int argc,
 			data[15]);
 		result = PIGLIT_FAIL;
 	}
+
+	/* Only benchmark the kernel once it is known to work. */
+	duration = piglit_cl_get_arg_value(argc, argv, "duration");
+	if (duration && result == PIGLIT_PASS)
+		result = benchmark(atof(duration), env);
+
 	clReleaseMemObject(buffer);
 
 	return result;
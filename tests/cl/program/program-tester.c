@@ -37,6 +37,13 @@
 #ifdef HAVE_LIBGEN_H
 #include <libgen.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 /* Regexes */
 
@@ -97,6 +104,7 @@
 #define REGEX_RANDOM       "(RANDOM|random)"
 #define REGEX_REPEAT       "(REPEAT|repeat)[[:space:]]+" \
                            REGEX_DEFINE_ARRAY(REGEX_ARRAY_VALUE)
+#define REGEX_PACKED       "(PACKED|packed)[[:space:]]+([[:digit:]]+)"
 
 /* Types */
 #define REGEX_DEFINE_TYPE(type)  type"|"type"2|"type"3|"type"4|"type"8|"type"16"
@@ -203,7 +211,7 @@
  * Value argument:
  *   index<whitespace>type<whitespace>value
  * Buffer argument:
- *   index<whitespace>buffer<whitespace>type[size]<whitespace>(value|random|repeat value)<whitespace>tolerance<whitespace>value
+ *   index<whitespace>buffer<whitespace>type[size]<whitespace>(value|random|repeat value|packed offset)<whitespace>tolerance<whitespace>value
  * Image argument:
  *   index<whitespace>image<whitespace>type<whitespace>
  *                    (value|random|repeat value)<whitespace>
@@ -233,7 +241,8 @@
 #define REGEX_ARG_SAMPLER_FILTER_MODE       "filter_mode[[:space:]]+(" REGEX_SAMPLER_FILTER_MODE ")"
 #define REGEX_ARG_VALUE   REGEX_DEFINE_ARG( "(" REGEX_TYPE ")", REGEX_ARRAY )
 #define REGEX_ARG_BUFFER  REGEX_DEFINE_ARG( "buffer[[:space:]]+(" REGEX_TYPE ")\\[([[:digit:]]+)\\]", \
-                                            REGEX_ARRAY "|" REGEX_RANDOM "|" REGEX_REPEAT )           \
+                                            REGEX_ARRAY "|" REGEX_RANDOM "|" REGEX_REPEAT "|"         \
+                                            REGEX_PACKED )                                            \
                           "([[:space:]]+" "("REGEX_ARG_TOLERANCE "|" REGEX_ARG_TOLERANCE_ULP")" ")?"
 #define REGEX_ARG_IMAGE   REGEX_DEFINE_ARG( "image[[:space:]]+(" REGEX_TYPE ")",             \
                                             REGEX_ARRAY "|" REGEX_RANDOM "|" REGEX_REPEAT )  \
@@ -276,6 +285,7 @@ PIGLIT_CL_PROGRAM_TEST_CONFIG_BEGIN
 
 	config.init_func = (piglit_cl_test_init_t*)init;
 	config.clean_func = (piglit_cl_test_clean_t*)clean;
+	config.thread_safe = true;
 
 PIGLIT_CL_PROGRAM_TEST_CONFIG_END
 
@@ -288,6 +298,13 @@ size_t   global_offset[3] = {0, 0, 0};
 bool     local_work_size_null = false;
 bool     global_offset_null = true;
 
+/*
+ * Command queues the tests are spread over, from -queues or
+ * PIGLIT_CL_QUEUES.  With more than one, the tests are enqueued in batches
+ * and waited for together instead of one after the other.
+ */
+unsigned int num_queues = 1;
+
 /* Helper functions */
 
 void
@@ -351,6 +368,9 @@ struct test_arg {
 	int64_t toli;
 	uint64_t tolu;
 	uint64_t ulp;
+	double tolf; // absolute, for floating-point types
+
+	bool packed; // value points into the packed test file
 
 	/* image data */
 	piglit_image_desc   image_desc;
@@ -379,6 +399,9 @@ struct test_arg create_test_arg()
 		.toli = 0,
 		.tolu = 0,
 		.ulp = 0,
+		.tolf = 0,
+
+		.packed = false,
 	};
 
 	return ta;
@@ -530,11 +553,15 @@ free_tests()
 
 	for(i = 0; i < num_tests; i++) {
 		for(j = 0; j < tests[i].num_args_in; j++) {
-			free(tests[i].args_in[j].value);
+			if(!tests[i].args_in[j].packed) {
+				free(tests[i].args_in[j].value);
+			}
 		}
 		free(tests[i].args_in);
 		for(j = 0; j < tests[i].num_args_out; j++) {
-			free(tests[i].args_out[j].value);
+			if(!tests[i].args_out[j].packed) {
+				free(tests[i].args_out[j].value);
+			}
 		}
 		free(tests[i].args_out);
 	}
@@ -575,6 +602,59 @@ free_dynamic_strs()
 	}
 }
 
+/*
+ * Packed test files
+ *
+ * A .program_pack file holds a test configuration in which the values of
+ * buffer arguments are already converted to their OpenCL types, so they
+ * don't have to be parsed, and optionally the program source.  They are
+ * written by generated_tests/modules/clpack.py.  The file starts with
+ * struct packed_header in the byte order of the machine that wrote it,
+ * followed by the configuration and the source, each terminated by '\0',
+ * and by the data that "packed offset" values refer to.
+ */
+#define PACKED_MAGIC       "PCLPACK"
+#define PACKED_VERSION     1
+#define PACKED_BYTE_ORDER  0x01020304
+
+struct packed_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t config_offset;
+	uint64_t config_size;
+	uint64_t source_offset;
+	uint64_t source_size;
+	uint64_t data_offset;
+	uint64_t data_size;
+};
+
+char* packed_file = NULL;
+size_t packed_file_size = 0;
+bool packed_file_mapped = false;
+const char* packed_data = NULL;
+size_t packed_data_size = 0;
+
+void
+unmap_packed_file()
+{
+	if(packed_file == NULL) {
+		return;
+	}
+
+#ifdef HAVE_SYS_MMAN_H
+	if(packed_file_mapped) {
+		munmap(packed_file, packed_file_size);
+	} else
+#endif
+	{
+		free(packed_file);
+	}
+
+	packed_file = NULL;
+	packed_data = NULL;
+}
+
 /* Clean */
 
 void
@@ -584,6 +664,7 @@ clean(const int argc,
 {
 	free_dynamic_strs();
 	free_tests();
+	unmap_packed_file();
 }
 
 NORETURN void
@@ -591,9 +672,102 @@ exit_report_result(enum piglit_result result)
 {
 	free_dynamic_strs();
 	free_tests();
+	unmap_packed_file();
 	piglit_report_result(result);
 }
 
+/*
+ * Return the section of the packed file at offset, checking that it is in
+ * the file and, for strings, that it is terminated.
+ */
+char*
+get_packed_section(uint64_t offset, uint64_t size, bool string,
+                   const char* name)
+{
+	if(   offset > packed_file_size
+	   || size > packed_file_size - offset
+	   || (string && (size == 0 || packed_file[offset + size - 1] != '\0'))) {
+		fprintf(stderr, "Invalid packed file, bad %s section.\n", name);
+		exit_report_result(PIGLIT_WARN);
+	}
+
+	return packed_file + offset;
+}
+
+/*
+ * Map the packed file and return its configuration.  The source of the
+ * program is returned in source, or NULL if the configuration names one.
+ */
+char*
+map_packed_file(const char* filename, char** source)
+{
+	struct packed_header header;
+	FILE* file = fopen(filename, "rb");
+	char* config_str;
+
+	if(file == NULL) {
+		fprintf(stderr, "Could not open %s.\n", filename);
+		exit_report_result(PIGLIT_WARN);
+	}
+	fseek(file, 0, SEEK_END);
+	packed_file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+#ifdef HAVE_SYS_MMAN_H
+	packed_file = mmap(NULL, packed_file_size, PROT_READ | PROT_WRITE,
+	                   MAP_PRIVATE, fileno(file), 0);
+	if(packed_file == MAP_FAILED) {
+		packed_file = NULL;
+	} else {
+		packed_file_mapped = true;
+	}
+#endif
+	if(packed_file == NULL) {
+		packed_file = malloc(packed_file_size);
+		if(fread(packed_file, 1, packed_file_size, file) != packed_file_size) {
+			fclose(file);
+			fprintf(stderr, "Could not read %s.\n", filename);
+			exit_report_result(PIGLIT_WARN);
+		}
+	}
+	fclose(file);
+
+	if(packed_file_size < sizeof(header)) {
+		fprintf(stderr, "Invalid packed file, %s is too short.\n", filename);
+		exit_report_result(PIGLIT_WARN);
+	}
+	memcpy(&header, packed_file, sizeof(header));
+	if(memcmp(header.magic, PACKED_MAGIC, sizeof(PACKED_MAGIC))) {
+		fprintf(stderr, "Invalid packed file, %s is not a packed test.\n",
+		        filename);
+		exit_report_result(PIGLIT_WARN);
+	}
+	if(header.version != PACKED_VERSION) {
+		fprintf(stderr, "Invalid packed file, version %u is not supported.\n",
+		        header.version);
+		exit_report_result(PIGLIT_WARN);
+	}
+	if(header.byte_order != PACKED_BYTE_ORDER) {
+		fprintf(stderr, "Invalid packed file, %s was packed on a machine of different byte order.\n",
+		        filename);
+		exit_report_result(PIGLIT_WARN);
+	}
+
+	config_str = get_packed_section(header.config_offset, header.config_size,
+	                                true, "config");
+	if(header.source_size > 0) {
+		*source = get_packed_section(header.source_offset,
+		                             header.source_size, true, "source");
+	} else {
+		*source = NULL;
+	}
+	packed_data = get_packed_section(header.data_offset, header.data_size,
+	                                 false, "data");
+	packed_data_size = header.data_size;
+
+	return strdup(config_str);
+}
+
 /* Regex functions */
 
 bool
@@ -925,10 +1099,16 @@ void
 print_usage(const int argc, const char** argv)
 {
 	printf("Usage:\n" \
-	       "  %s [options] CONFIG.program_test\n"
+	       "  %s [options] CONFIG.program_test|CONFIG.program_pack\n"
 	       "  %s [options] [-config CONFIG.program_test] PROGRAM.cl|PROGRAM.bin\n"
 	       "\n"
+	       "Options:\n"
+	       "  -queues N  Spread the tests over N command queues and run them\n"
+	       "             concurrently. Defaults to PIGLIT_CL_QUEUES, or 1.\n"
+	       "\n"
 	       "Notes:\n"
+	       "  - CONFIG.program_pack is a packed test, see\n"
+	       "    generated_tests/modules/clpack.py.\n"
 	       "  - If CONFIG is not specified and PROGRAM has a comment config then a\n"
 	       "    comment config is used.\n"
 	       "  - If there is no CONFIG or comment config, then the program is only\n"
@@ -1034,6 +1214,35 @@ get_test_arg_value(struct test_arg* test_arg, const char* value, size_t length)
 	free(float_array);
 }
 
+void
+get_test_arg_packed_value(struct test_arg* test_arg, const char* value)
+{
+	regmatch_t pmatch[3];
+	char* offset_str = NULL;
+	uint64_t offset;
+
+	regex_get_matches(value, REGEX_PACKED, pmatch, 3, 0);
+	regex_get_match_str(&offset_str, value, pmatch, 2);
+	offset = get_uint(offset_str);
+	free(offset_str);
+
+	if(packed_data == NULL) {
+		fprintf(stderr,
+		        "Invalid configuration, packed values are only allowed in packed files: %s\n",
+		        value);
+		exit_report_result(PIGLIT_WARN);
+	}
+	if(offset > packed_data_size || test_arg->size > packed_data_size - offset) {
+		fprintf(stderr,
+		        "Invalid configuration, packed value is out of the packed data: %s\n",
+		        value);
+		exit_report_result(PIGLIT_WARN);
+	}
+
+	test_arg->value = (void*)(packed_data + offset);
+	test_arg->packed = true;
+}
+
 void
 get_test_arg_tolerance(struct test_arg* test_arg, const char* tolerance_str)
 {
@@ -1082,11 +1291,9 @@ get_test_arg_tolerance(struct test_arg* test_arg, const char* tolerance_str)
 			break;
 		case TYPE_HALF:
 		case TYPE_FLOAT:
-		case TYPE_DOUBLE: {
-			float value = get_float(value_str);
-			test_arg->ulp = *((uint64_t*)(&value));
+		case TYPE_DOUBLE:
+			test_arg->tolf = get_float(value_str);
 			break;
-			}
 		}
 
 		free(value_str);
@@ -1255,6 +1462,8 @@ get_test_arg(const char* src, struct test* test, bool arg_in)
 				                   get_array_length(repeat_value_str));
 
 				free(repeat_value_str);
+			} else if(regex_match(value, REGEX_FULL_MATCH(REGEX_PACKED))) {
+				get_test_arg_packed_value(&test_arg, value);
 			} else if(regex_match(value, REGEX_ARRAY)) {
 				get_test_arg_value(&test_arg,
 				                   value,
@@ -1888,6 +2097,7 @@ init(const int argc,
 {
 	const char * main_argument = piglit_cl_get_unnamed_arg(argc, argv, 0);
 	const char * config_file = NULL;
+	const char * queues_arg = NULL;
 
 	char* config_str = NULL;
 	unsigned int config_str_size;
@@ -1895,9 +2105,11 @@ init(const int argc,
 
 	enum main_argument_type_t {
 		ARG_CONFIG,
+		ARG_PACKED,
 		ARG_SOURCE,
 		ARG_BINARY
 	} main_argument_type;
+	char* packed_source = NULL;
 
 	FILE* temp_file;
 
@@ -1913,7 +2125,7 @@ init(const int argc,
 			print_usage_and_warn(argc, argv, "No main argument.");
 		}
 	}
-	if(!regex_match(main_argument, "\\.(cl|program_test|bin)$")) {
+	if(!regex_match(main_argument, "\\.(cl|program_test|program_pack|bin)$")) {
 		print_usage_and_warn(argc, argv, "Invalid main argument.");
 	}
 	temp_file = fopen(main_argument, "r");
@@ -1933,8 +2145,19 @@ init(const int argc,
 		}
 		fclose(temp_file);
 	}
-	// no config argument if using .program_test
-	if(regex_match(main_argument, "\\.program_test$") && config_arg_present) {
+	// valid queues argument
+	queues_arg = piglit_cl_get_arg_value(argc, argv, "queues");
+	if(queues_arg == NULL) {
+		queues_arg = getenv("PIGLIT_CL_QUEUES");
+	}
+	if(queues_arg != NULL && strcmp(queues_arg, "") != 0) {
+		if(atoi(queues_arg) < 1) {
+			print_usage_and_warn(argc, argv, "Invalid queues argument.");
+		}
+		num_queues = atoi(queues_arg);
+	}
+	// no config argument if using .program_test or .program_pack
+	if(regex_match(main_argument, "\\.(program_test|program_pack)$") && config_arg_present) {
 		print_usage_and_warn(argc,
 		                     argv,
 		                     "Cannot use config argument if main argument is already a config file.");
@@ -1946,6 +2169,10 @@ init(const int argc,
 
 		config_file = main_argument;
 		config_str = piglit_load_text_file(config_file, &config_str_size);
+	} else if(regex_match(main_argument, "\\.program_pack$")) {
+		main_argument_type = ARG_PACKED;
+
+		config_str = map_packed_file(main_argument, &packed_source);
 	} else if(regex_match(main_argument, "\\.cl$")) {
 		main_argument_type = ARG_SOURCE;
 
@@ -1981,6 +2208,12 @@ init(const int argc,
 
 	/* Set program */
 	switch(main_argument_type) {
+	case ARG_PACKED:
+		if(packed_source != NULL) {
+			config->program_source = packed_source;
+			break;
+		}
+		/* fall through */
 	case ARG_CONFIG:
 		if(   config->program_source_file != NULL
 		   || config->program_binary_file != NULL) {
@@ -2039,19 +2272,126 @@ init(const int argc,
 
 /* Memory object functions */
 
+/*
+ * Buffers are reused by all tests of a context instead of being created for
+ * every argument.  A buffer that is too small for an argument is replaced by
+ * one as large as the largest argument seen so far, so the pool soon stops
+ * growing.
+ */
+struct pool_buffer {
+	cl_mem mem;
+	size_t size;
+	bool in_use;
+};
+
+struct buffer_pool {
+	struct pool_buffer* buffers;
+	unsigned int num_buffers;
+	size_t max_size;
+};
+
 struct mem_arg {
 	cl_uint index;
 	cl_mem mem;
 	cl_mem_object_type type;
+	struct buffer_pool* pool; /**< Pool of \c mem, or NULL */
+};
+
+/* A kernel test enqueued with the reads of its results */
+struct pending_test {
+	struct test test;
+	enum piglit_result result; /**< PIGLIT_PASS if the rest is valid */
+	cl_kernel kernel;
+	struct mem_arg* mem_args;
+	unsigned int num_mem_args;
+	cl_sampler* sampler_args;
+	unsigned int num_sampler_args;
+	void** read_values;
+	size_t* mismatches; /**< Counted per out argument, or NULL */
 };
 
+cl_mem
+acquire_pool_buffer(struct buffer_pool* pool, piglit_cl_context context,
+                    size_t size)
+{
+	unsigned i;
+	struct pool_buffer* free_buffer = NULL;
+
+	for(i = 0; i < pool->num_buffers; i++) {
+		if(pool->buffers[i].in_use)
+			continue;
+
+		free_buffer = &pool->buffers[i];
+		if(free_buffer->size >= size) {
+			free_buffer->in_use = true;
+			return free_buffer->mem;
+		}
+	}
+
+	if(size > pool->max_size) {
+		pool->max_size = size;
+	}
+
+	if(free_buffer == NULL) {
+		struct pool_buffer new_buffer = { NULL, 0, false };
+
+		add_dynamic_array((void**)&pool->buffers,
+		                  &pool->num_buffers,
+		                  sizeof(struct pool_buffer),
+		                  &new_buffer);
+		free_buffer = &pool->buffers[pool->num_buffers - 1];
+	} else {
+		clReleaseMemObject(free_buffer->mem);
+	}
+
+	free_buffer->mem = piglit_cl_create_buffer(context,
+	                                           CL_MEM_READ_WRITE,
+	                                           pool->max_size);
+	free_buffer->size = free_buffer->mem != NULL ? pool->max_size : 0;
+	free_buffer->in_use = free_buffer->mem != NULL;
+
+	return free_buffer->mem;
+}
+
+void
+release_pool_buffer(struct buffer_pool* pool, cl_mem mem)
+{
+	unsigned i;
+
+	for(i = 0; i < pool->num_buffers; i++) {
+		if(pool->buffers[i].mem == mem) {
+			pool->buffers[i].in_use = false;
+		}
+	}
+}
+
+void
+free_buffer_pool(struct buffer_pool* pool)
+{
+	unsigned i;
+
+	for(i = 0; i < pool->num_buffers; i++) {
+		if(pool->buffers[i].mem != NULL) {
+			clReleaseMemObject(pool->buffers[i].mem);
+		}
+	}
+
+	free(pool->buffers); pool->buffers = NULL;
+	pool->num_buffers = 0;
+	pool->max_size = 0;
+}
+
 void
 free_mem_args(struct mem_arg** mem_args, unsigned int* num_mem_args)
 {
 	unsigned i;
 
 	for(i = 0; i < *num_mem_args; i++) {
-		clReleaseMemObject((*mem_args)[i].mem);
+		if((*mem_args)[i].pool != NULL) {
+			release_pool_buffer((*mem_args)[i].pool, (*mem_args)[i].mem);
+		} else if((*mem_args)[i].mem != NULL) {
+			clReleaseMemObject((*mem_args)[i].mem);
+		}
 	}
 
 	free(*mem_args); *mem_args = NULL;
@@ -2071,6 +2411,184 @@ free_sampler_args(cl_sampler** sampler_args, unsigned int* num_sampler_args)
 	*num_sampler_args = 0;
 }
 
+void
+free_read_values(void*** read_values, unsigned int num_read_values)
+{
+	unsigned i;
+
+	if(*read_values == NULL)
+		return;
+
+	for(i = 0; i < num_read_values; i++) {
+		free((*read_values)[i]);
+	}
+
+	free(*read_values); *read_values = NULL;
+}
+
+/*
+ * Comparing results
+ *
+ * The count_* kernels only count the values that are not certainly within
+ * tolerance, in loops without calls or early exits so that the compiler can
+ * vectorize them.  Only for an argument where they count some does
+ * check_test_arg_value() go over the values again with the exact probes, and
+ * print the first MAX_PRINTED_MISMATCHES values that are out of tolerance.
+ */
+#define MAX_PRINTED_MISMATCHES 8
+
+#define DEFINE_COUNT_INTEGER(name, cl_type, diff_type)                         \
+size_t                                                                         \
+name(const cl_type* value, const cl_type* expect, size_t count,               \
+     uint64_t tolerance)                                                       \
+{                                                                              \
+	size_t i;                                                                  \
+	size_t mismatches = 0;                                                     \
+                                                                               \
+	for(i = 0; i < count; i++) {                                               \
+		diff_type diff = value[i] > expect[i] ?                                \
+		                 (diff_type)value[i] - (diff_type)expect[i] :          \
+		                 (diff_type)expect[i] - (diff_type)value[i];           \
+		mismatches += (uint64_t)diff > tolerance;                              \
+	}                                                                          \
+                                                                               \
+	return mismatches;                                                         \
+}
+
+DEFINE_COUNT_INTEGER(count_char_mismatches,   cl_char,   int64_t)
+DEFINE_COUNT_INTEGER(count_uchar_mismatches,  cl_uchar,  uint64_t)
+DEFINE_COUNT_INTEGER(count_short_mismatches,  cl_short,  int64_t)
+DEFINE_COUNT_INTEGER(count_ushort_mismatches, cl_ushort, uint64_t)
+DEFINE_COUNT_INTEGER(count_int_mismatches,    cl_int,    int64_t)
+DEFINE_COUNT_INTEGER(count_uint_mismatches,   cl_uint,   uint64_t)
+DEFINE_COUNT_INTEGER(count_long_mismatches,   cl_long,   uint64_t)
+DEFINE_COUNT_INTEGER(count_ulong_mismatches,  cl_ulong,  uint64_t)
+
+#undef DEFINE_COUNT_INTEGER
+
+/*
+ * The floating-point kernels take 1 ULP of a value as the power of two of its
+ * exponent less the mantissa bits, which is what piglit_cl_probe_floating()
+ * gets from nextafter() for all but the largest finite value.  Infinity and
+ * NaN never compare within tolerance here and are left to the exact probe.
+ */
+#define DEFINE_COUNT_FLOATING(name, cl_type, uint_type, mant_bits, exp_mask,  \
+                              abs_fn)                                          \
+size_t                                                                         \
+name(const cl_type* value, const cl_type* expect, size_t count,               \
+     uint64_t ulp, double tolf)                                                \
+{                                                                              \
+	size_t i;                                                                  \
+	size_t mismatches = 0;                                                     \
+	cl_type ulps = ulp;                                                        \
+                                                                               \
+	for(i = 0; i < count; i++) {                                               \
+		uint_type bits;                                                        \
+		uint_type exp;                                                         \
+		cl_type one_ulp;                                                       \
+		cl_type diff;                                                          \
+                                                                               \
+		memcpy(&bits, &expect[i], sizeof(bits));                               \
+		exp = (bits >> mant_bits) & exp_mask;                                  \
+		bits = exp > mant_bits ? (exp - mant_bits) << mant_bits :              \
+		                         (uint_type)1 << (exp ? exp - 1 : 0);          \
+		memcpy(&one_ulp, &bits, sizeof(bits));                                 \
+                                                                               \
+		diff = abs_fn(value[i] - expect[i]);                                   \
+		mismatches += !(diff <= ulps * one_ulp || diff <= tolf);               \
+	}                                                                          \
+                                                                               \
+	return mismatches;                                                         \
+}
+
+DEFINE_COUNT_FLOATING(count_float_mismatches,  cl_float,  uint32_t, 23, 0xff,
+                      fabsf)
+DEFINE_COUNT_FLOATING(count_double_mismatches, cl_double, uint64_t, 52, 0x7ff,
+                      fabs)
+
+#undef DEFINE_COUNT_FLOATING
+
+size_t
+count_half_mismatches(const cl_half* value, const cl_half* expect,
+                      size_t count, uint64_t ulp)
+{
+	size_t i;
+	size_t mismatches = 0;
+
+	for(i = 0; i < count; i++) {
+		mismatches += !piglit_cl_compare_half(value[i], expect[i], ulp);
+	}
+
+	return mismatches;
+}
+
+/*
+ * Copy the padding of 3-component vectors from the expected values, so that
+ * the values can be compared as one array.
+ */
+void
+copy_padding(struct test_arg test_arg, void* value, size_t elem_size)
+{
+	size_t i;
+
+	for(i = 0; i < test_arg.length; i++) {
+		size_t offset = (i*test_arg.cl_mem_size + test_arg.cl_size) * elem_size;
+
+		memcpy((char*)value + offset,
+		       (char*)test_arg.value + offset,
+		       (test_arg.cl_mem_size - test_arg.cl_size) * elem_size);
+	}
+}
+
+/*
+ * Count the values of an out argument that are out of tolerance without
+ * printing anything, so that it can run on any thread.
+ */
+size_t
+count_test_arg_mismatches(struct test_arg test_arg,
+                          void* value)
+{
+	size_t count = test_arg.length * test_arg.cl_mem_size;
+	size_t mismatches = 0;
+
+	if(count > 0 && test_arg.cl_size != test_arg.cl_mem_size) {
+		copy_padding(test_arg, value, test_arg.size / count);
+	}
+
+#define COUNTI(enum_type, type, cl_type, tolerance)                          \
+	case enum_type:                                                          \
+		mismatches = count_##type##_mismatches((cl_type*)value,              \
+		                                       (cl_type*)test_arg.value,     \
+		                                       count, tolerance);            \
+		break;
+#define COUNTF(enum_type, type, cl_type)                                     \
+	case enum_type:                                                          \
+		mismatches = count_##type##_mismatches((cl_type*)value,              \
+		                                       (cl_type*)test_arg.value,     \
+		                                       count, test_arg.ulp,          \
+		                                       test_arg.tolf);               \
+		break;
+
+	switch(test_arg.cl_type) {
+		COUNTI(TYPE_CHAR,   char,   cl_char,   test_arg.toli)
+		COUNTI(TYPE_UCHAR,  uchar,  cl_uchar,  test_arg.tolu)
+		COUNTI(TYPE_SHORT,  short,  cl_short,  test_arg.toli)
+		COUNTI(TYPE_USHORT, ushort, cl_ushort, test_arg.tolu)
+		COUNTI(TYPE_INT,    int,    cl_int,    test_arg.toli)
+		COUNTI(TYPE_UINT,   uint,   cl_uint,   test_arg.tolu)
+		COUNTI(TYPE_LONG,   long,   cl_long,   test_arg.toli)
+		COUNTI(TYPE_ULONG,  ulong,  cl_ulong,  test_arg.tolu)
+		COUNTI(TYPE_HALF,   half,   cl_half,   test_arg.ulp)
+		COUNTF(TYPE_FLOAT,  float,  cl_float)
+		COUNTF(TYPE_DOUBLE, double, cl_double)
+	}
+
+#undef COUNTF
+#undef COUNTI
+
+	return mismatches;
+}
+
 bool
 check_test_arg_value(struct test_arg test_arg,
                      void* value)
@@ -2079,97 +2597,101 @@ check_test_arg_value(struct test_arg test_arg,
 	size_t c; // component in element
 	size_t ra; // offset from the beginning of parsed array
 	size_t rb; // offset from the beginning of buffer
+	size_t mismatches;
+	const char* type_name = NULL;
 
-#define CASEI(enum_type, type, cl_type)                                     \
-	case enum_type:                                                         \
-		for(i = 0; i < test_arg.length; i++) {                              \
-			for(c = 0; c < test_arg.cl_size; c++) {                         \
-				rb = i*test_arg.cl_mem_size + c;                            \
-				if(!piglit_cl_probe_integer(((cl_type*)value)[rb],          \
-				                            ((cl_type*)test_arg.value)[rb], \
-				                            test_arg.toli)) {               \
-					ra = i*test_arg.cl_size + c;                            \
-					printf("Error at %s[%zu]\n", type, ra);                 \
-					return false;                                           \
-				}                                                           \
-			}                                                               \
-		}                                                                   \
+	if(count_test_arg_mismatches(test_arg, value) == 0) {
 		return true;
-#define CASEU(enum_type, type, cl_type)                                      \
+	}
+
+	/*
+	 * Go over the values again with the probes, which also print what was
+	 * expected.  The floating-point kernels may have counted values that
+	 * are within tolerance after all.
+	 */
+	mismatches = 0;
+
+#define CASEI(enum_type, type, cl_type, probe, compare)                      \
 	case enum_type:                                                          \
+		type_name = type;                                                    \
 		for(i = 0; i < test_arg.length; i++) {                               \
 			for(c = 0; c < test_arg.cl_size; c++) {                          \
 				rb = i*test_arg.cl_mem_size + c;                             \
-				if(!piglit_cl_probe_uinteger(((cl_type*)value)[rb],          \
-				                             ((cl_type*)test_arg.value)[rb], \
-				                             test_arg.tolu)) {               \
-					ra = i*test_arg.cl_size + c;                             \
-					printf("Error at %s[%zu]\n", type, ra);                  \
-					return false;                                            \
+				if(compare) {                                                \
+					continue;                                                \
 				}                                                            \
-			}                                                                \
-		}                                                                    \
-		return true;
-#define CASEH(enum_type, type, cl_type)                                      \
-	case enum_type:                                                          \
-		for(i = 0; i < test_arg.length; i++) {                               \
-			for(c = 0; c < test_arg.cl_size; c++) {                          \
-				rb = i*test_arg.cl_mem_size + c;                             \
-				if(!piglit_cl_probe_half(((cl_type*)value)[rb],          \
-				                             ((cl_type*)test_arg.value)[rb], \
-				                             test_arg.ulp)) {               \
-					ra = i*test_arg.cl_size + c;                             \
+				ra = i*test_arg.cl_size + c;                                 \
+				if(mismatches < MAX_PRINTED_MISMATCHES) {                    \
 					printf("Error at %s[%zu]\n", type, ra);                  \
-					return false;                                            \
+					probe;                                                   \
 				}                                                            \
+				mismatches++;                                                \
 			}                                                                \
 		}                                                                    \
-		return true;
-#define CASEF(enum_type, type, cl_type, testfn)				\
-	case enum_type:                                                          \
-		for(i = 0; i < test_arg.length; i++) {                               \
-			for(c = 0; c < test_arg.cl_size; c++) {                          \
-				rb = i*test_arg.cl_mem_size + c;                             \
-				if(!testfn(((cl_type*)value)[rb],          \
-		                           ((cl_type*)test_arg.value)[rb], \
-		                           test_arg.ulp)) {                \
-					ra = i*test_arg.cl_size + c;                             \
-					printf("Error at %s[%zu]\n", type, ra);                  \
-					return false;                                            \
-				}                                                            \
-			}                                                                \
-		}                                                                    \
-		return true;
+		break;
+#define V(cl_type) (((cl_type*)value)[rb])
+#define E(cl_type) (((cl_type*)test_arg.value)[rb])
+#define CASEINT(enum_type, type, cl_type, probe_fn, tolerance)               \
+	CASEI(enum_type, type, cl_type,                                          \
+	      probe_fn(V(cl_type), E(cl_type), tolerance),                       \
+	      (V(cl_type) > E(cl_type) ? (uint64_t)V(cl_type) - E(cl_type) :   \
+	                                 (uint64_t)E(cl_type) - V(cl_type)) <= \
+	      (uint64_t)tolerance)
+#define CASEF(enum_type, type, cl_type, probe_fn, compare_fn)                \
+	CASEI(enum_type, type, cl_type,                                          \
+	      probe_fn(V(cl_type), E(cl_type), test_arg.ulp),                    \
+	      compare_fn(V(cl_type), E(cl_type), test_arg.ulp) ||                \
+	      fabs(V(cl_type) - E(cl_type)) <= test_arg.tolf)
 
 	switch(test_arg.cl_type) {
-		CASEI(TYPE_CHAR,   "char",   cl_char)
-		CASEU(TYPE_UCHAR,  "uchar",  cl_uchar)
-		CASEI(TYPE_SHORT,  "short",  cl_short)
-		CASEU(TYPE_USHORT, "ushort", cl_ushort)
-		CASEI(TYPE_INT,    "int",    cl_int)
-		CASEU(TYPE_UINT,   "uint",   cl_uint)
-		CASEI(TYPE_LONG,   "long",   cl_long)
-		CASEU(TYPE_ULONG,  "ulong",  cl_ulong)
-		CASEH(TYPE_HALF,   "half",   cl_half)
-		CASEF(TYPE_FLOAT,  "float",  cl_float, piglit_cl_probe_floating)
-		CASEF(TYPE_DOUBLE,  "double",  cl_double, piglit_cl_probe_double)
+		CASEINT(TYPE_CHAR,   "char",   cl_char,   piglit_cl_probe_integer,  test_arg.toli)
+		CASEINT(TYPE_UCHAR,  "uchar",  cl_uchar,  piglit_cl_probe_uinteger, test_arg.tolu)
+		CASEINT(TYPE_SHORT,  "short",  cl_short,  piglit_cl_probe_integer,  test_arg.toli)
+		CASEINT(TYPE_USHORT, "ushort", cl_ushort, piglit_cl_probe_uinteger, test_arg.tolu)
+		CASEINT(TYPE_INT,    "int",    cl_int,    piglit_cl_probe_integer,  test_arg.toli)
+		CASEINT(TYPE_UINT,   "uint",   cl_uint,   piglit_cl_probe_uinteger, test_arg.tolu)
+		CASEINT(TYPE_LONG,   "long",   cl_long,   piglit_cl_probe_integer,  test_arg.toli)
+		CASEINT(TYPE_ULONG,  "ulong",  cl_ulong,  piglit_cl_probe_uinteger, test_arg.tolu)
+		CASEI(TYPE_HALF,     "half",   cl_half,
+		      piglit_cl_probe_half(V(cl_half), E(cl_half), test_arg.ulp),
+		      piglit_cl_compare_half(V(cl_half), E(cl_half), test_arg.ulp))
+		CASEF(TYPE_FLOAT,    "float",  cl_float,  piglit_cl_probe_floating,
+		      piglit_cl_compare_floating)
+		CASEF(TYPE_DOUBLE,   "double", cl_double, piglit_cl_probe_double,
+		      piglit_cl_compare_double)
 	}
 
 #undef CASEF
-#undef CASEU
+#undef CASEINT
+#undef E
+#undef V
 #undef CASEI
 
-	return true;
+	if(mismatches > MAX_PRINTED_MISMATCHES) {
+		printf("... and %zu more errors\n",
+		       mismatches - MAX_PRINTED_MISMATCHES);
+	}
+	if(mismatches > 0) {
+		printf("%zu of %zu %s values out of tolerance\n",
+		       mismatches, test_arg.length * test_arg.cl_size, type_name);
+	}
+
+	return mismatches == 0;
 }
 
-/* Run the kernel test */
+/*
+ * Set up a kernel test and enqueue it on queue, followed by the reads of its
+ * results.  On PIGLIT_PASS the test is held in pending until it has been
+ * checked, otherwise everything it used is already released.
+ */
 enum piglit_result
-test_kernel(const struct piglit_cl_program_test_config* config,
-            const struct piglit_cl_program_test_env* env,
-            struct test test)
+enqueue_test(const struct piglit_cl_program_test_config* config,
+             const struct piglit_cl_program_test_env* env,
+             struct test test,
+             struct buffer_pool* pool,
+             cl_command_queue queue,
+             struct pending_test* pending)
 {
-	enum piglit_result result = PIGLIT_PASS;
-
 	// all
 	unsigned j;
 	char* kernel_name;
@@ -2182,6 +2704,9 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 	cl_sampler *sampler_args = NULL;
 	unsigned int num_sampler_args = 0;
 
+	// validating results
+	void** read_values = NULL;
+
 	/* Check if this device supports the local work size. */
 	if (!piglit_cl_framework_check_local_work_size(env->device_id,
 						test.local_work_size)) {
@@ -2229,22 +2754,26 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			struct mem_arg mem_arg;
 			mem_arg.index = test_arg.index;
 			mem_arg.type = CL_MEM_OBJECT_BUFFER;
+			mem_arg.pool = NULL;
 
 			if(test_arg.value != NULL) {
-				mem_arg.mem = piglit_cl_create_buffer(env->context,
-				                                            CL_MEM_READ_WRITE,
-				                                            test_arg.size);
+				mem_arg.mem = acquire_pool_buffer(pool,
+				                                  env->context,
+				                                  test_arg.size);
+				mem_arg.pool = pool;
 				if(   mem_arg.mem != NULL
-				   && piglit_cl_write_buffer(env->context->command_queues[0],
-				                             mem_arg.mem,
-				                             0,
-				                             test_arg.size,
-				                             test_arg.value)
+				   && piglit_cl_enqueue_write_buffer(queue,
+				                                     mem_arg.mem,
+				                                     0,
+				                                     test_arg.size,
+				                                     test_arg.value)
 				   && piglit_cl_set_kernel_arg(kernel,
 				                               mem_arg.index,
 				                               sizeof(cl_mem),
 				                               &mem_arg.mem)) {
 					arg_set = true;
+				} else if(mem_arg.mem != NULL) {
+					release_pool_buffer(pool, mem_arg.mem);
 				}
 			} else {
 				mem_arg.mem = NULL;
@@ -2266,6 +2795,7 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			struct mem_arg mem_arg;
 			mem_arg.index = test_arg.index;
 			mem_arg.type = test_arg.image_desc.image_type;
+			mem_arg.pool = NULL;
 
 			if(!test_arg.value) {
 				printf("Image argument cannot be null.\n");
@@ -2278,7 +2808,7 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			                                     &test_arg.image_format,
 			                                     &test_arg.image_desc);
 			if(   mem_arg.mem != NULL
-			   && piglit_cl_write_whole_image(env->context->command_queues[0],
+			   && piglit_cl_write_whole_image(queue,
 			                                  mem_arg.mem,
 			                                  test_arg.value)
 			   && piglit_cl_set_kernel_arg(kernel,
@@ -2346,6 +2876,7 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			struct mem_arg mem_arg;
 			mem_arg.index = test_arg.index;
 			mem_arg.type = CL_MEM_OBJECT_BUFFER;
+			mem_arg.pool = NULL;
 
 			for(k = 0; k < num_mem_args; k++) {
 				if(mem_args[k].index != mem_arg.index)
@@ -2368,15 +2899,18 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			}
 
 			if(test_arg.value != NULL) {
-				mem_arg.mem = piglit_cl_create_buffer(env->context,
-				                                            CL_MEM_READ_WRITE,
-				                                            test_arg.size);
+				mem_arg.mem = acquire_pool_buffer(pool,
+				                                  env->context,
+				                                  test_arg.size);
+				mem_arg.pool = pool;
 				if(   mem_arg.mem != NULL
 				   && piglit_cl_set_kernel_arg(kernel,
 				                               mem_arg.index,
 				                               sizeof(cl_mem),
 				                               &mem_arg.mem)) {
 					arg_set = true;
+				} else if(mem_arg.mem != NULL) {
+					release_pool_buffer(pool, mem_arg.mem);
 				}
 			} else {
 				mem_arg.mem = NULL;
@@ -2400,6 +2934,7 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			struct mem_arg mem_arg;
 			mem_arg.index = test_arg.index;
 			mem_arg.type = test_arg.image_desc.image_type;
+			mem_arg.pool = NULL;
 
 			for(k = 0; k < num_mem_args; k++) {
 				if(mem_args[k].index == mem_arg.index) {
@@ -2458,12 +2993,13 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 	/* Execute kernel */
 	printf("Running the kernel...\n");
 
-	if(!piglit_cl_execute_ND_range_kernel(env->context->command_queues[0],
+	if(!piglit_cl_enqueue_ND_range_kernel(queue,
 	                                      kernel,
 	                                      test.work_dimensions,
 	                                      test.global_offset_null ? NULL : test.global_offset,
 	                                      test.global_work_size,
-	                                      test.local_work_size_null ? NULL : test.local_work_size)) {
+	                                      test.local_work_size_null ? NULL : test.local_work_size,
+	                                      NULL)) {
 		printf("Failed to enqueue the kernel\n");
 		clReleaseKernel(kernel);
 		free_mem_args(&mem_args, &num_mem_args);
@@ -2471,98 +3007,46 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 		return PIGLIT_FAIL;
 	}
 
-	/* Check results */
+	/* Read back all results, then check them */
 	printf("Validating results...\n");
 
+	read_values = calloc(test.num_args_out, sizeof(void*));
+
 	for(j = 0; j < test.num_args_out; j++) {
 		unsigned k;
 		bool arg_valid = false;
 		struct test_arg test_arg = test.args_out[j];
+		struct mem_arg mem_arg;
+
+		/* Find the right buffer */
+		for(k = 0; k < num_mem_args; k++) {
+			if(mem_args[k].index == test_arg.index) {
+				mem_arg = mem_args[k];
+			}
+		}
 
 		switch(test_arg.type) {
 		case TEST_ARG_VALUE:
 			// Not accepted by parser
 			break;
-		case TEST_ARG_BUFFER: {
-			struct mem_arg mem_arg;
-
-			/* Find the right buffer */
-			for(k = 0; k < num_mem_args; k++) {
-				if(mem_args[k].index == test_arg.index) {
-					mem_arg = mem_args[k];
-				}
-			}
-
+		case TEST_ARG_BUFFER:
 			if(test_arg.value != NULL) {
-				void* read_value = malloc(test_arg.size);
-
-				if(piglit_cl_read_buffer(env->context->command_queues[0],
-					                     mem_arg.mem,
-					                     0,
-					                     test_arg.size,
-					                     read_value)) {
-					arg_valid = true;
-					if(check_test_arg_value(test_arg, read_value)) {
-						printf(" Argument %u: PASS%s\n",
-						                     test_arg.index,
-						                     !test.expect_test_fail ? "" : " (not expected)");
-						if(test.expect_test_fail) {
-							piglit_merge_result(&result, PIGLIT_FAIL);
-						}
-					} else {
-						printf(" Argument %u: FAIL%s\n",
-						                     test_arg.index,
-						                     !test.expect_test_fail ? "" : " (expected)");
-						if(!test.expect_test_fail) {
-							piglit_merge_result(&result, PIGLIT_FAIL);
-						}
-					}
-				}
-
-				free(read_value);
+				read_values[j] = malloc(test_arg.size);
+				arg_valid = piglit_cl_enqueue_read_buffer(queue,
+				                                          mem_arg.mem,
+				                                          0,
+				                                          test_arg.size,
+				                                          read_values[j]);
 			}
-
 			break;
-		}
-		case TEST_ARG_IMAGE: {
-			struct mem_arg mem_arg;
-
-			/* Find the right buffer */
-			for(k = 0; k < num_mem_args; k++) {
-				if(mem_args[k].index == test_arg.index) {
-					mem_arg = mem_args[k];
-				}
-			}
-
+		case TEST_ARG_IMAGE:
 			if(test_arg.value != NULL) {
-				void* read_value = malloc(test_arg.size);
-
-				if(piglit_cl_read_whole_image(env->context->command_queues[0],
-					                          mem_arg.mem,
-					                          read_value)) {
-					arg_valid = true;
-					if(check_test_arg_value(test_arg, read_value)) {
-						printf(" Argument %u: PASS%s\n",
-						                     test_arg.index,
-						                     !test.expect_test_fail ? "" : " (not expected)");
-						if(test.expect_test_fail) {
-							piglit_merge_result(&result, PIGLIT_FAIL);
-						}
-					} else {
-						printf(" Argument %u: FAIL%s\n",
-						                     test_arg.index,
-						                     !test.expect_test_fail ? "" : " (expected)");
-						if(!test.expect_test_fail) {
-							piglit_merge_result(&result, PIGLIT_FAIL);
-						}
-					}
-				}
-
-				free(read_value);
+				read_values[j] = malloc(test_arg.size);
+				arg_valid = piglit_cl_read_whole_image(queue,
+				                                       mem_arg.mem,
+				                                       read_values[j]);
 			}
-
 			break;
-		}
 		case TEST_ARG_SAMPLER:
 			// Not accepted by parser
 			break;
@@ -2574,14 +3058,247 @@ test_kernel(const struct piglit_cl_program_test_config* config,
 			clReleaseKernel(kernel);
 			free_mem_args(&mem_args, &num_mem_args);
 			free_sampler_args(&sampler_args, &num_sampler_args);
+			free_read_values(&read_values, test.num_args_out);
 			return PIGLIT_FAIL;
 		}
 	}
 
-	/* Clean memory used by test */
-	clReleaseKernel(kernel);
-	free_mem_args(&mem_args, &num_mem_args);
-	free_sampler_args(&sampler_args, &num_sampler_args);
+	pending->test = test;
+	pending->kernel = kernel;
+	pending->mem_args = mem_args;
+	pending->num_mem_args = num_mem_args;
+	pending->sampler_args = sampler_args;
+	pending->num_sampler_args = num_sampler_args;
+	pending->read_values = read_values;
+	pending->mismatches = NULL;
+	return PIGLIT_PASS;
+}
+
+/* Release everything held by an enqueued test */
+void
+release_pending_test(struct pending_test* pending)
+{
+	clReleaseKernel(pending->kernel);
+	free_mem_args(&pending->mem_args, &pending->num_mem_args);
+	free_sampler_args(&pending->sampler_args, &pending->num_sampler_args);
+	free_read_values(&pending->read_values, pending->test.num_args_out);
+	free(pending->mismatches);
+	pending->mismatches = NULL;
+}
+
+/* Check the results of a test whose queue has finished */
+enum piglit_result
+check_pending_test(struct pending_test* pending)
+{
+	enum piglit_result result = PIGLIT_PASS;
+	struct test test = pending->test;
+	unsigned j;
+
+	for(j = 0; j < test.num_args_out; j++) {
+		struct test_arg test_arg = test.args_out[j];
+		bool valid;
+
+		/* Only values already found out of tolerance are checked again */
+		if(pending->mismatches != NULL && pending->mismatches[j] == 0) {
+			valid = true;
+		} else {
+			valid = check_test_arg_value(test_arg, pending->read_values[j]);
+		}
+
+		if(valid) {
+			printf(" Argument %u: PASS%s\n",
+			       test_arg.index,
+			       !test.expect_test_fail ? "" : " (not expected)");
+			if(test.expect_test_fail) {
+				piglit_merge_result(&result, PIGLIT_FAIL);
+			}
+		} else {
+			printf(" Argument %u: FAIL%s\n",
+			       test_arg.index,
+			       !test.expect_test_fail ? "" : " (expected)");
+			if(!test.expect_test_fail) {
+				piglit_merge_result(&result, PIGLIT_FAIL);
+			}
+		}
+	}
+
+	return result;
+}
+
+/* Run the kernel test */
+enum piglit_result
+test_kernel(const struct piglit_cl_program_test_config* config,
+            const struct piglit_cl_program_test_env* env,
+            struct test test,
+            struct buffer_pool* pool)
+{
+	cl_command_queue queue = env->context->command_queues[0];
+	struct pending_test pending;
+	enum piglit_result result;
+	cl_int errNo;
+
+	result = enqueue_test(config, env, test, pool, queue, &pending);
+	if(result != PIGLIT_PASS) {
+		return result;
+	}
+
+	errNo = clFinish(queue);
+	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
+		printf("Failed to run the kernel: %s\n",
+		       piglit_cl_get_error_name(errNo));
+		result = PIGLIT_FAIL;
+	} else {
+		result = check_pending_test(&pending);
+	}
+
+	release_pending_test(&pending);
+	return result;
+}
+
+/* Most tests enqueued before waiting for them, bounding the buffers held */
+#define MAX_PENDING_TESTS 64
+/* Most threads counting mismatches */
+#define MAX_COUNT_THREADS 8
+
+struct count_mismatches_args {
+	struct pending_test* pending;
+	unsigned int num_pending;
+	unsigned int first;
+	unsigned int stride;
+};
+
+static void*
+count_mismatches_thread(void* data)
+{
+	struct count_mismatches_args* args = data;
+	unsigned int i, j;
+
+	for(i = args->first; i < args->num_pending; i += args->stride) {
+		struct pending_test* pending = &args->pending[i];
+
+		if(pending->result != PIGLIT_PASS) {
+			continue;
+		}
+
+		pending->mismatches = malloc(pending->test.num_args_out * sizeof(size_t));
+		for(j = 0; j < pending->test.num_args_out; j++) {
+			pending->mismatches[j] =
+				count_test_arg_mismatches(pending->test.args_out[j],
+				                          pending->read_values[j]);
+		}
+	}
+
+	return NULL;
+}
+
+/* Count the mismatches of finished tests, on several threads if possible */
+void
+count_pending_mismatches(struct pending_test* pending, unsigned int num_pending)
+{
+	struct count_mismatches_args args[MAX_COUNT_THREADS];
+	unsigned int num_threads = 1;
+	unsigned int i;
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_t threads[MAX_COUNT_THREADS];
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if(num_cpus > 1) {
+		num_threads = MIN3((unsigned int)num_cpus, MAX_COUNT_THREADS,
+		                   num_pending);
+	}
+#endif
+
+	for(i = 0; i < num_threads; i++) {
+		args[i].pending = pending;
+		args[i].num_pending = num_pending;
+		args[i].first = i;
+		args[i].stride = num_threads;
+	}
+
+#ifdef PIGLIT_HAS_PTHREADS
+	for(i = 1; i < num_threads; i++) {
+		if(pthread_create(&threads[i], NULL, count_mismatches_thread,
+		                  &args[i])) {
+			count_mismatches_thread(&args[i]);
+			threads[i] = pthread_self();
+		}
+	}
+#endif
+	count_mismatches_thread(&args[0]);
+#ifdef PIGLIT_HAS_PTHREADS
+	for(i = 1; i < num_threads; i++) {
+		if(!pthread_equal(threads[i], pthread_self())) {
+			pthread_join(threads[i], NULL);
+		}
+	}
+#endif
+}
+
+/*
+ * Run the tests spread over queues in batches.  The tests of a batch are all
+ * enqueued before waiting for the queues once, then their results are
+ * counted in parallel and reported in order.
+ */
+enum piglit_result
+run_tests_concurrently(const struct piglit_cl_program_test_config* config,
+                       const struct piglit_cl_program_test_env* env,
+                       struct buffer_pool* pool,
+                       cl_command_queue* queues,
+                       unsigned int num_queues)
+{
+	enum piglit_result result = PIGLIT_SKIP;
+	struct pending_test pending[MAX_PENDING_TESTS];
+	unsigned int first, i, q;
+
+	for(first = 0; first < num_tests; first += MAX_PENDING_TESTS) {
+		unsigned int num_pending = MIN2(num_tests - first, MAX_PENDING_TESTS);
+		bool finished = true;
+
+		for(i = 0; i < num_pending; i++) {
+			cl_command_queue queue = queues[i % num_queues];
+			struct test test = tests[first + i];
+
+			printf("> Enqueueing kernel test: %s\n",
+			       test.name != NULL ? test.name : "");
+
+			pending[i].result = enqueue_test(config, env, test, pool,
+			                                 queue, &pending[i]);
+			if(pending[i].result == PIGLIT_PASS) {
+				clFlush(queue);
+			}
+		}
+
+		for(q = 0; q < num_queues; q++) {
+			cl_int errNo = clFinish(queues[q]);
+
+			if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
+				printf("Failed to run the kernels: %s\n",
+				       piglit_cl_get_error_name(errNo));
+				finished = false;
+			}
+		}
+
+		if(finished) {
+			count_pending_mismatches(pending, num_pending);
+		}
+
+		for(i = 0; i < num_pending; i++) {
+			enum piglit_result test_result = pending[i].result;
+			struct test test = tests[first + i];
+
+			if(test_result == PIGLIT_PASS) {
+				printf("> Checking kernel test: %s\n",
+				       test.name != NULL ? test.name : "");
+				test_result = finished ? check_pending_test(&pending[i])
+				                       : PIGLIT_FAIL;
+				release_pending_test(&pending[i]);
+			}
+
+			piglit_merge_result(&result, test_result);
+			piglit_report_subtest_result(test_result, "%s", test.name);
+		}
+	}
+
 	return result;
 }
 
@@ -2596,6 +3313,7 @@ piglit_cl_test(const int argc,
 	enum piglit_result result = PIGLIT_SKIP;
 
 	unsigned i;
+	struct buffer_pool pool = { NULL, 0, 0 };
 
 	/* Print building status */
 	if(!config->expect_build_fail) {
@@ -2613,18 +3331,48 @@ piglit_cl_test(const int argc,
 	}
 
 	/* Run the tests */
-	for(i = 0; i< num_tests; i++) {
-		enum piglit_result test_result;
-		char* test_name = tests[i].name != NULL ? tests[i].name : "";
+	if(num_queues > 1 && num_tests > 1) {
+		cl_command_queue* queues = malloc(num_queues * sizeof(cl_command_queue));
+		unsigned int q;
+
+		queues[0] = env->context->command_queues[0];
+		for(q = 1; q < num_queues; q++) {
+			cl_int errNo;
+
+			queues[q] = clCreateCommandQueue(env->context->cl_ctx,
+			                                 env->device_id,
+			                                 0,
+			                                 &errNo);
+			if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
+				printf("Could not create command queue, using %u\n", q);
+				break;
+			}
+		}
 
-		printf("> Running kernel test: %s\n", test_name);
+		piglit_merge_result(&result,
+		                    run_tests_concurrently(config, env, &pool,
+		                                           queues, q));
 
-		test_result = test_kernel(config, env, tests[i]);
-		piglit_merge_result(&result, test_result);
+		for(i = 1; i < q; i++) {
+			clReleaseCommandQueue(queues[i]);
+		}
+		free(queues);
+	} else {
+		for(i = 0; i< num_tests; i++) {
+			enum piglit_result test_result;
+			char* test_name = tests[i].name != NULL ? tests[i].name : "";
+
+			printf("> Running kernel test: %s\n", test_name);
+
+			test_result = test_kernel(config, env, tests[i], &pool);
+			piglit_merge_result(&result, test_result);
 
-		piglit_report_subtest_result(test_result, "%s", tests[i].name);
+			piglit_report_subtest_result(test_result, "%s", tests[i].name);
+		}
 	}
 
+	free_buffer_pool(&pool);
+
 	/* Print result */
 	if(num_tests > 0) {
 		switch(result) {
@@ -55,7 +55,9 @@ class DEQPVKTest(deqp.DEQPBaseTest):
             [x for x in _EXTRA_ARGS if not x.startswith('--deqp-case')]
 
     def interpret_result(self):
-        if 'Failed to compile shader at vkGlslToSpirV' in self.result.out:
+        if self.cases is not None:
+            super(DEQPVKTest, self).interpret_result()
+        elif 'Failed to compile shader at vkGlslToSpirV' in self.result.out:
             self.result.result = 'skip'
             self.result.out += \
                 '\n\nMarked as skip because GLSLang failed to compile shaders'
@@ -66,6 +68,16 @@ class DEQPVKTest(deqp.DEQPBaseTest):
         else:
             super(DEQPVKTest, self).interpret_result()
 
+    def _case_status(self, out):
+        if 'Failed to compile shader at vkGlslToSpirV' in out:
+            return 'skip'
+        return super(DEQPVKTest, self)._case_status(out)
+
+    def _stop_status(self, out):
+        if _DEQP_ASSERT.search(out):
+            return 'skip'
+        return super(DEQPVKTest, self)._stop_status(out)
+
 
 profile = deqp.make_profile(  # pylint: disable=invalid-name
     deqp.iter_deqp_test_cases(
@@ -37,6 +37,7 @@
  */
 
 #include <algorithm>
+#include <vector>
 
 #include "piglit-util-gl.h"
 
@@ -190,6 +191,52 @@ static float clearColor[4] = {
 	0.5, 0.5, 0.5, 0.5
 };
 
+/*
+ * The source texels and weight a destination row or column is filtered
+ * from, computed once per axis since the filter is separable.
+ */
+struct Taps
+{
+	bool inside;
+	GLint src0, src1;
+	float weight;
+};
+
+static std::vector<Taps>
+axis_taps(const TestCase &test, GLint src0, GLint src1, GLint dst0, GLint dst1,
+	  GLint srcSize, GLint dstSize)
+{
+	GLint srcD = src1 - src0;
+	GLint dstD = dst1 - dst0;
+
+	std::vector<Taps> taps(dstSize);
+
+	for (GLint dst = 0; dst < dstSize; ++dst) {
+		Taps &tap = taps[dst];
+		tap.inside = false;
+		tap.src0 = tap.src1 = 0;
+		tap.weight = 0.0f;
+
+		if (dst < dst0 || dst >= dst1) {
+			continue;
+		}
+
+		float src = src0 + (dst - dst0 + 0.5) * srcD / dstD;
+		if (src < 0 || src >= srcSize) {
+			continue;
+		}
+
+		src -= 0.5f;
+
+		filter(test, src, tap.src0, tap.src1, tap.weight);
+		clamp(tap.src0, 0, srcSize - 1);
+		clamp(tap.src1, 0, srcSize - 1);
+		tap.inside = true;
+	}
+
+	return taps;
+}
+
 static GLboolean
 verify(const TestCase &test, GLuint srcFBO, GLuint dstFBO, GLuint numChannels)
 {
@@ -211,83 +258,63 @@ verify(const TestCase &test, GLuint srcFBO, GLuint dstFBO, GLuint numChannels)
 		std::swap(dstY0, dstY1);
 	}
 
-	GLint srcDX = srcX1 - srcX0;
-	GLint srcDY = srcY1 - srcY0;
-	GLint dstDX = dstX1 - dstX0;
-	GLint dstDY = dstY1 - dstY0;
-
 	GLint dstW = piglit_width;
 	GLint dstH = piglit_height;
 
-	float *srcPixels = new float[test.srcH * test.srcW * numChannels];
-
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, srcFBO);
-	glReadPixels(0, 0, test.srcW, test.srcH, GL_RGB, GL_FLOAT, srcPixels);
+	/* Every test case draws the same image in a source of its size, so
+	 * it only has to be read back when the size changes.
+	 */
+	static std::vector<float> srcPixels;
+	static GLint srcW = 0, srcH = 0;
 
-	float *expectedDstPixels = new float[dstH * dstW * numChannels];
+	if (test.srcW != srcW || test.srcH != srcH) {
+		srcW = test.srcW;
+		srcH = test.srcH;
+		srcPixels.resize(srcH * srcW * numChannels);
 
-	for (GLint dstY = 0; dstY < dstH; ++dstY) {
-		for (GLint dstX = 0; dstX < dstW; ++dstX) {
-			float *dstPixel = expectedDstPixels + (dstY * dstW + dstX) * numChannels;
-			for (GLuint c = 0; c < numChannels; ++c) {
-				dstPixel[c] = clearColor[c];
-			}
-		}
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, srcFBO);
+		glReadPixels(0, 0, srcW, srcH, GL_RGB, GL_FLOAT, &srcPixels[0]);
 	}
 
-	GLint dstX0clamped = std::max(dstX0, 0);
-	GLint dstY0clamped = std::max(dstY0, 0);
-	GLint dstX1clamped = std::min(dstX1, dstW);
-	GLint dstY1clamped = std::min(dstY1, dstH);
+	std::vector<Taps> tapsX = axis_taps(test, srcX0, srcX1, dstX0, dstX1,
+					    srcW, dstW);
+	std::vector<Taps> tapsY = axis_taps(test, srcY0, srcY1, dstY0, dstY1,
+					    srcH, dstH);
 
-	for (GLint dstY = dstY0clamped; dstY < dstY1clamped; ++dstY) {
-		float srcY = srcY0 + (dstY - dstY0 + 0.5) * srcDY / dstDY;
-		if (srcY < 0 || srcY >= test.srcH) {
-			continue;
-		}
+	float *expectedDstPixels = new float[dstH * dstW * numChannels];
 
-		srcY -= 0.5f;
+	for (GLint dstY = 0; dstY < dstH; ++dstY) {
+		const Taps &tapY = tapsY[dstY];
+		const float *srcRow0 = &srcPixels[tapY.src0 * srcW * numChannels];
+		const float *srcRow1 = &srcPixels[tapY.src1 * srcW * numChannels];
+		float *dstRow = expectedDstPixels + dstY * dstW * numChannels;
 
-		GLint srcPixelY0, srcPixelY1;
-		float weightY;
-		filter(test, srcY, srcPixelY0, srcPixelY1, weightY);
-		clamp(srcPixelY0, 0, test.srcH - 1);
-		clamp(srcPixelY1, 0, test.srcH - 1);
+		for (GLint dstX = 0; dstX < dstW; ++dstX) {
+			const Taps &tapX = tapsX[dstX];
+			float *dstPixel = dstRow + dstX * numChannels;
 
-		for (GLint dstX = dstX0clamped; dstX < dstX1clamped; ++dstX) {
-			float srcX = srcX0 + (dstX - dstX0 + 0.5) * srcDX / dstDX;
-			if (srcX < 0 || srcX >= test.srcW) {
+			if (!tapX.inside || !tapY.inside) {
+				for (GLuint c = 0; c < numChannels; ++c) {
+					dstPixel[c] = clearColor[c];
+				}
 				continue;
 			}
 
-			srcX -= 0.5f;
-
-			GLint srcPixelX0, srcPixelX1;
-			float weightX;
-			filter(test, srcX, srcPixelX0, srcPixelX1, weightX);
-			clamp(srcPixelX0, 0, test.srcW - 1);
-			clamp(srcPixelX1, 0, test.srcW - 1);
-
-			float *srcPixel00 = srcPixels + (srcPixelY0 * test.srcW + srcPixelX0) * numChannels;
-			float *srcPixel01 = srcPixels + (srcPixelY0 * test.srcW + srcPixelX1) * numChannels;
-			float *srcPixel10 = srcPixels + (srcPixelY1 * test.srcW + srcPixelX0) * numChannels;
-			float *srcPixel11 = srcPixels + (srcPixelY1 * test.srcW + srcPixelX1) * numChannels;
-
-			float *dstPixel = expectedDstPixels
-				        + (dstY * dstW + dstX) * numChannels;
+			const float *srcPixel00 = srcRow0 + tapX.src0 * numChannels;
+			const float *srcPixel01 = srcRow0 + tapX.src1 * numChannels;
+			const float *srcPixel10 = srcRow1 + tapX.src0 * numChannels;
+			const float *srcPixel11 = srcRow1 + tapX.src1 * numChannels;
 
 			for (GLuint c = 0; c < numChannels; ++c) {
 				dstPixel[c] = lerp2d(srcPixel00[c],
 						     srcPixel01[c],
 						     srcPixel10[c],
 						     srcPixel11[c],
-						     weightX, weightY);
+						     tapX.weight, tapY.weight);
 			}
 		}
 	}
 
-	delete [] srcPixels;
-
 	float *observedDstPixels = new float[dstH * dstW * numChannels];
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, dstFBO);
 	glReadPixels(0, 0, dstW, dstH, GL_RGB, GL_FLOAT, observedDstPixels);
@@ -33,6 +33,10 @@
  * There are 2 components to the test;
  *   1. Predefined sanity tests ensuring bounding box calculations are correct
  *   2. Randomised triangle drawing to attempt to test all possible triangles
+ *
+ * Rasterization is invariant under translation by whole pixels, so in
+ * automatic mode the triangles are moved to separate tiles of the
+ * framebuffer and a whole batch of them is drawn and read back at once.
  */
 
 #include "piglit-util-gl.h"
@@ -41,6 +45,8 @@
 #include <time.h>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 /* Data structures */
 struct Vector
@@ -89,6 +95,7 @@ bool use_fbo = false;
 bool break_on_fail = false;
 bool print_triangle = false;
 int random_test_count = 100;
+unsigned num_threads = std::max(std::thread::hardware_concurrency(), 1u);
 
 /* filling convention */
 static enum filling_convention_t {
@@ -144,6 +151,25 @@ namespace std {
 	}
 }
 
+/* Calls func(i) for every i in [0, count), spread over num_threads threads */
+template<typename Func>
+void parallel_for(size_t count, const Func& func)
+{
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i = next++; i < count; i = next++)
+			func(i);
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t t = 1; t < std::min<size_t>(num_threads, count); ++t)
+		threads.emplace_back(work);
+
+	work();
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
 /* Proper rounding of float to integer */
 int64_t iround(float v)
 {
@@ -154,6 +180,24 @@ int64_t iround(float v)
 	return (int64_t)v;
 }
 
+/* The colour of the pixels drawn by rast_triangle */
+#define RAST_COLOR 0x00FF00FF
+
+/* The width and height of the blocks rast_triangle works on */
+#define RAST_BLOCK 8
+
+/* Half-edge function, positive on the inside of the edge */
+struct Edge
+{
+	int64_t at(int64_t x, int64_t y) const
+	{
+		return c + step_x * x + step_y * y;
+	}
+
+	/* Value at pixel (0, 0) and change per pixel right and up */
+	int64_t c, step_x, step_y;
+};
+
 /* Based on http://devmaster.net/forums/topic/1145-advanced-rasterization */
 void rast_triangle(uint8_t* buffer, uint32_t stride, const Triangle& tri)
 {
@@ -255,45 +299,77 @@ void rast_triangle(uint8_t* buffer, uint32_t stride, const Triangle& tri)
 			break;
 	}
 
-	int64_t cy1 = c1 + dx12 * (miny << FIXED_SHIFT) - dy12 * (minx << FIXED_SHIFT);
-	int64_t cy2 = c2 + dx23 * (miny << FIXED_SHIFT) - dy23 * (minx << FIXED_SHIFT);
-	int64_t cy3 = c3 + dx31 * (miny << FIXED_SHIFT) - dy31 * (minx << FIXED_SHIFT);
-
-	/* Perform rasterization */
-	buffer += miny * stride;
-	for (int64_t y = miny; y <= maxy; y++) {
-		int64_t cx1 = cy1;
-		int64_t cx2 = cy2;
-		int64_t cx3 = cy3;
+	const Edge edges[3] = {
+		{ c1, -fdy12, fdx12 },
+		{ c2, -fdy23, fdx23 },
+		{ c3, -fdy31, fdx31 },
+	};
 
-		for (int64_t x = minx; x <= maxx; x++) {
-			if (cx1 > 0 && cx2 > 0 && cx3 > 0) {
-				((uint32_t*)buffer)[x] = 0x00FF00FF;
+	/* Perform rasterization, a block at a time. The edge functions are
+	 * linear, so a block whose corners are all outside of one edge is
+	 * skipped and one whose corners are all inside of every edge is
+	 * filled; only the blocks an edge goes through are tested per pixel.
+	 */
+	const int64_t block_mask = ~(int64_t)(RAST_BLOCK - 1);
+	for (int64_t by = miny & block_mask; by <= maxy; by += RAST_BLOCK) {
+		const int64_t y0 = std::max(by, miny);
+		const int64_t y1 = std::min(by + RAST_BLOCK - 1, maxy);
+
+		for (int64_t bx = minx & block_mask; bx <= maxx; bx += RAST_BLOCK) {
+			const int64_t x0 = std::max(bx, minx);
+			const int64_t x1 = std::min(bx + RAST_BLOCK - 1, maxx);
+			const int n = x1 - x0 + 1;
+
+			bool outside = false, inside = true;
+			for (int e = 0; e < 3; ++e) {
+				const int corners = (edges[e].at(x0, y0) > 0) +
+						    (edges[e].at(x1, y0) > 0) +
+						    (edges[e].at(x0, y1) > 0) +
+						    (edges[e].at(x1, y1) > 0);
+				outside |= corners == 0;
+				inside &= corners == 4;
 			}
 
-			cx1 -= fdy12;
-			cx2 -= fdy23;
-			cx3 -= fdy31;
-		}
+			if (outside)
+				continue;
+
+			for (int64_t y = y0; y <= y1; y++) {
+				uint32_t *row = (uint32_t *)(buffer + y * stride) + x0;
 
-		cy1 += fdx12;
-		cy2 += fdx23;
-		cy3 += fdx31;
+				if (inside) {
+					std::fill(row, row + n, RAST_COLOR);
+					continue;
+				}
 
-		buffer += stride;
+				const int64_t e1 = edges[0].at(x0, y);
+				const int64_t e2 = edges[1].at(x0, y);
+				const int64_t e3 = edges[2].at(x0, y);
+
+				/* No branches, so that this is compiled to
+				 * vector compares and selects.
+				 */
+				for (int i = 0; i < n; i++) {
+					const bool in =
+						(e1 + edges[0].step_x * i > 0) &
+						(e2 + edges[1].step_x * i > 0) &
+						(e3 + edges[2].step_x * i > 0);
+					row[i] = in ? RAST_COLOR : row[i];
+				}
+			}
+		}
 	}
 }
 
 
-/* Prints an ascii representation of the triangle */
-void triangle_art(uint32_t* buffer)
+/* Prints an ascii representation of the triangle in the given rectangle */
+void triangle_art(uint32_t* buffer, int x0, int y0, int width, int height)
 {
-	int minx = fbo_width - 1, miny = fbo_height - 1;
-	int maxx = 0, maxy = 0;
+	int minx = x0 + width - 1, miny = y0 + height - 1;
+	int maxx = x0, maxy = y0;
 
 	/* Find bounds so we dont have to print whole screen */
-	for (int y = 0; y < fbo_height; ++y) {
-		for (int x = 0; x < fbo_width; ++x) {
+	for (int y = y0; y < y0 + height; ++y) {
+		for (int x = x0; x < x0 + width; ++x) {
 			if (buffer[y*fbo_width + x] & 0xFFFFFF00) {
 				if (x < minx) minx = x;
 				if (y < miny) miny = y;
@@ -307,8 +383,10 @@ void triangle_art(uint32_t* buffer)
 	if (minx > maxx || miny > maxy)
 		return;
 
-	--minx; --miny;
-	++maxx; ++maxy;
+	minx = std::max(minx - 1, x0);
+	miny = std::max(miny - 1, y0);
+	maxx = std::min(maxx + 1, x0 + width - 1);
+	maxy = std::min(maxy + 1, y0 + height - 1);
 
 	/* Print an ascii representation of triangle */
 	for (int y = maxy; y >= miny; --y) {
@@ -356,8 +434,25 @@ uint32_t* check_triangle()
 }
 
 
+/* Prints the triangle that failed, and the picture of it in the given
+ * rectangle of result if requested
+ */
+void report_fail(int id, const Triangle& tri, uint32_t* result,
+		 int x, int y, int width, int height)
+{
+	printf("FAIL: %d. (%f, %f), (%f, %f), (%f, %f)\n", id,
+	       tri[0].x, tri[0].y, tri[1].x, tri[1].y, tri[2].x, tri[2].y);
+
+	if (print_triangle) {
+		triangle_art(result, x, y, width, height);
+	}
+
+	fflush(stdout);
+}
+
+
 /* Performs test using tri */
-GLboolean test_triangle(const Triangle& tri)
+GLboolean test_triangle(const Triangle& tri, int id)
 {
 	static uint32_t* buffer = 0;
 	if (!buffer) buffer = new uint32_t[fbo_width * fbo_height];
@@ -378,18 +473,155 @@ GLboolean test_triangle(const Triangle& tri)
 
 	/* Check the result and print relevant error messages */
 	if (uint32_t* result = check_triangle()) {
-		printf("FAIL: %d. (%f, %f), (%f, %f), (%f, %f)\n", test_id,
-		       tri[0].x, tri[0].y, tri[1].x, tri[1].y, tri[2].x, tri[2].y);
+		report_fail(id, tri, result, 0, 0, fbo_width, fbo_height);
+		return GL_FALSE;
+	}
+
+	return GL_TRUE;
+}
+
 
-		if (print_triangle) {
-			triangle_art(result);
+/* Returns the size of the smallest square tile tri fits in, or 0 if it is
+ * too big to share the framebuffer with other triangles. A triangle inside
+ * [0, size) only covers pixel centers inside of that tile.
+ */
+int tile_size(const Triangle& tri)
+{
+	float lo = tri[0].x, hi = tri[0].x;
+	for (int i = 0; i < 3; ++i) {
+		lo = std::min(lo, std::min(tri[i].x, tri[i].y));
+		hi = std::max(hi, std::max(tri[i].x, tri[i].y));
+	}
+
+	if (lo < 0.0f)
+		return 0;
+
+	int size = 1;
+	while (size <= hi)
+		size *= 2;
+
+	return size * 2 <= std::min(fbo_width, fbo_height) ? size : 0;
+}
+
+
+/* Checks that a pixel read back from OpenGL is black or yellow, the red
+ * and green channels are only ever fully on or off
+ */
+bool check_pixel(uint32_t pixel)
+{
+	const bool red = (pixel >> 24) >= 0x80;
+	const bool green = ((pixel >> 16) & 0xFF) >= 0x80;
+	const bool blue = ((pixel >> 8) & 0xFF) >= 0x80;
+
+	return red == green && !blue;
+}
+
+
+/* Performs the test of tris[batch[i]] for every i, moving each of them to its
+ * own size by size tile. Returns the number of triangles that failed.
+ */
+int test_batch(const std::vector<Triangle>& tris, const std::vector<int>& ids,
+	       const std::vector<int>& batch, int size)
+{
+	static uint32_t* buffer = 0;
+	static uint32_t* result = 0;
+	if (!buffer) buffer = new uint32_t[fbo_width * fbo_height];
+	if (!result) result = new uint32_t[fbo_width * fbo_height];
+
+	const int columns = fbo_width / size;
+	std::vector<Triangle> moved(batch.size());
+	for (size_t i = 0; i < batch.size(); ++i) {
+		const float x = (i % columns) * size;
+		const float y = (i / columns) * size;
+
+		for (int j = 0; j < 3; ++j) {
+			moved[i][j] = Vector(tris[batch[i]][j].x + x,
+					     tris[batch[i]][j].y + y);
 		}
+	}
 
-		fflush(stdout);
-		return GL_FALSE;
+	/* Clear OpenGL and software buffer */
+	glClear(GL_COLOR_BUFFER_BIT);
+	memset(buffer, 0, sizeof(uint32_t) * fbo_width * fbo_height);
+
+	/* Software rasterise the triangles and blit them to OpenGL, each one
+	 * only writes to its own tile
+	 */
+	parallel_for(moved.size(), [&](size_t i) {
+		rast_triangle((uint8_t*)buffer, fbo_width * 4, moved[i]);
+	});
+	glDrawPixels(fbo_width, fbo_height, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer);
+
+	/* Draw OpenGL triangles */
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 0, moved[0].v);
+	glDrawArrays(GL_TRIANGLES, 0, 3 * moved.size());
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	/* Check every tile */
+	glReadPixels(0, 0, fbo_width, fbo_height, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, result);
+
+	std::vector<char> failed(moved.size(), 0);
+	parallel_for(moved.size(), [&](size_t i) {
+		const int x = (i % columns) * size;
+		const int y = (i / columns) * size;
+
+		for (int py = y; py < y + size && !failed[i]; ++py) {
+			for (int px = x; px < x + size; ++px) {
+				if (!check_pixel(result[py * fbo_width + px])) {
+					failed[i] = 1;
+					break;
+				}
+			}
+		}
+	});
+
+	int fail_count = 0;
+	for (size_t i = 0; i < moved.size(); ++i) {
+		if (failed[i]) {
+			report_fail(ids[batch[i]], tris[batch[i]], result,
+				    (i % columns) * size, (i / columns) * size,
+				    size, size);
+			++fail_count;
+		}
 	}
 
-	return GL_TRUE;
+	return fail_count;
+}
+
+
+/* Performs the tests of tris, whose ids are in ids. The triangles that fit in
+ * the same size of tile are tested a framebuffer full at a time, the others
+ * one by one. Returns the number of triangles that failed.
+ */
+int test_triangles(const std::vector<Triangle>& tris, const std::vector<int>& ids)
+{
+	/* The triangles waiting for a batch, by log2 of their tile size */
+	std::vector<std::vector<int> > pending(log2u(fbo_width) + 1);
+	int fail_count = 0;
+
+	for (size_t i = 0; i < tris.size() && !(fail_count && break_on_fail); ++i) {
+		const int size = tile_size(tris[i]);
+		if (!size) {
+			if (!test_triangle(tris[i], ids[i]))
+				++fail_count;
+			continue;
+		}
+
+		std::vector<int>& batch = pending[log2u(size)];
+		batch.push_back(i);
+		if ((int)batch.size() == (fbo_width / size) * (fbo_height / size)) {
+			fail_count += test_batch(tris, ids, batch, size);
+			batch.clear();
+		}
+	}
+
+	for (size_t i = 0; i < pending.size() && !(fail_count && break_on_fail); ++i) {
+		if (!pending[i].empty())
+			fail_count += test_batch(tris, ids, pending[i], 1 << i);
+	}
+
+	return fail_count;
 }
 
 
@@ -555,18 +787,19 @@ piglit_display(void)
 		int fail_count = 0;
 
 		printf("Running %d fixed tests\n", (int)fixed_tests.size());
-		for (std::vector<Triangle>::iterator itr = fixed_tests.begin(); itr != fixed_tests.end() && !(fail_count && break_on_fail); ++itr) {
-			if (!test_triangle(*itr))
-				++fail_count;
-		}
-
-		printf("Running %d random tests\n", random_test_count);
-		for (int i = 0; i < random_test_count && !(fail_count && break_on_fail); ++i) {
-			Triangle tri;
-			random_triangle(tri);
+		fail_count += test_triangles(fixed_tests,
+					     std::vector<int>(fixed_tests.size(), test_id));
+
+		if (!(fail_count && break_on_fail)) {
+			std::vector<Triangle> tris(random_test_count);
+			std::vector<int> ids(random_test_count);
+			for (int i = 0; i < random_test_count; ++i) {
+				random_triangle(tris[i]);
+				ids[i] = test_id;
+			}
 
-			if (!test_triangle(tri))
-				++fail_count;
+			printf("Running %d random tests\n", random_test_count);
+			fail_count += test_triangles(tris, ids);
 		}
 
 		printf("Failed %d tests\n", fail_count);
@@ -577,7 +810,7 @@ piglit_display(void)
 	} else {
 		Triangle tri;
 		random_triangle(tri);
-		pass &= test_triangle(tri);
+		pass &= test_triangle(tri, test_id);
 
 		glDisable(GL_BLEND);
 
@@ -700,6 +933,8 @@ piglit_init(int argc, char **argv)
 				seed = strtoul(argv[++i], NULL, 0);
 			} else if (strcmp(argv[i], "-subpixel_bits") == 0) {
 				in_subpixel_bits = strtoul(argv[++i], NULL, 0);
+			} else if (strcmp(argv[i], "-threads") == 0) {
+				num_threads = std::max(strtoul(argv[++i], NULL, 0), 1ul);
 			}
 		}
 	}
@@ -1,18 +1,26 @@
 # coding=utf-8
 """A profile that runs only GLSLParserTest instances."""
 
+import collections
 import os
 
+from framework.options import OPTIONS
 from framework import grouptools
 from framework.profile import TestProfile
-from framework.test.glsl_parser_test import GLSLParserTest, GLSLParserNoConfigError
-from framework.test.piglit_test import ASMParserTest, ROOT_DIR
+from framework.test.glsl_parser_test import (
+    GLSLParserTest, GLSLParserNoConfigError, MultiGLSLParserTest)
+from framework.test.piglit_test import (
+    ASMParserTest, MultiASMParserTest, ROOT_DIR)
 from .py_modules.constants import GENERATED_TESTS_DIR, TESTS_DIR
 
 __all__ = ['profile']
 
 profile = TestProfile()
 
+# Without process isolation the tests of a group that want the same GLSL
+# version are run in one glslparsertest process.
+glslparser_tests = collections.defaultdict(list)
+
 # Find and add all shader tests.
 basepath = os.path.normpath(os.path.join(TESTS_DIR, '..'))
 gen_basepath = os.path.relpath(os.path.join(GENERATED_TESTS_DIR, '..'), basepath)
@@ -38,6 +46,11 @@ for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
                     # legacy test, and continue
                     continue
 
+                if not OPTIONS.process_isolation:
+                    glslparser_tests[(groupname, test._command[3])].append(
+                        (filepath, installpath))
+                    continue
+
                 # For glslparser tests you can have multiple tests with the
                 # same name, but a different stage, so keep the extension.
                 testname = filename
@@ -49,6 +62,27 @@ for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
 
             profile.test_list[group] = test
 
+versions = collections.Counter(g for g, _ in glslparser_tests)
+for (group, version), files in glslparser_tests.items():
+    # This makes the xml output reproducible, as os.walk() order is random
+    files.sort()
+    files, installedfiles = (list(f) for f in zip(*files))
+
+    # A single file is a normal test, as with process isolation.
+    if len(files) == 1:
+        name = grouptools.join(group, os.path.basename(files[0]))
+        assert name not in profile.test_list, name
+        profile.test_list[name] = GLSLParserTest.new(files[0],
+                                                     installedfiles[0])
+        continue
+
+    # Only name the batch after its version if the group has several.
+    if versions[group] > 1:
+        group = grouptools.join(group, 'glsl-' + version.replace(' ', '-'))
+    assert group not in profile.test_list, group
+
+    profile.test_list[group] = MultiGLSLParserTest.new(files, installedfiles)
+
 # Collect and add all asmparsertests
 for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
     _basedir = os.path.join(basedir, 'asmparsertest', 'shaders')
@@ -58,10 +92,19 @@ for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
         type_ = os.path.basename(dirpath)
 
         dirname = os.path.relpath(dirpath, os.path.join(basedir, '..'))
-        for filename in filenames:
-            if not os.path.splitext(filename)[1] == '.txt':
-                continue
+        filenames = sorted(f for f in filenames
+                           if os.path.splitext(f)[1] == '.txt')
 
+        # Without process isolation the files of a program type are
+        # compiled in one asmparsertest process.
+        if not OPTIONS.process_isolation and len(filenames) > 1:
+            assert base_group not in profile.test_list, base_group
+            profile.test_list[base_group] = MultiASMParserTest.new(
+                type_, [os.path.join(dirpath, f) for f in filenames],
+                [os.path.join(dirname, f) for f in filenames])
+            continue
+
+        for filename in filenames:
             group = grouptools.join(base_group, filename)
             profile.test_list[group] = ASMParserTest(
                 type_, os.path.join(dirname, filename))
@@ -29,23 +29,59 @@
  *
  * Tests that compiling (but not linking or drawing with) a given
  * shader either succeeds or fails as expected.
+ *
+ * With --batch, many shaders that want the same GLSL version are tested
+ * in one context, each reported as a subtest.
+ *
+ * When PIGLIT_GLSLPARSER_OFFLINE names a standalone compiler, "glslang" or
+ * "mesa", the shaders are compiled by it instead, without creating a
+ * context, so that the tests can run on hosts without a GPU or a display.
+ * The requirements of the tests can't be checked then, and nothing is
+ * linked.
  */
 
 #include <errno.h>
 
 #include "piglit-util-gl.h"
+#include "piglit-subprocess.h"
 
 #define COMPAT_FLAG (1u << 31)
 
 static unsigned parse_glsl_version_number(const char *str);
 static int process_options(int argc, char **argv);
+static enum piglit_result run_test(int argc, char **argv);
+static void run_batch(int argc, char **argv);
+
+static bool batch_mode = false;
+static const char *offline_compiler = NULL;
 
 PIGLIT_GL_TEST_CONFIG_BEGIN
 
-	argc = process_options(argc, argv);
-	if (argc > 3) {
+	const char *version_arg = NULL;
+
+	if (argc > 2 && strcmp(argv[1], "--batch") == 0) {
+		/* The context is picked from the version of the batch, the
+		 * options of each test are processed before it is run.
+		 */
+		batch_mode = true;
+		version_arg = argv[2];
+	} else {
+		argc = process_options(argc, argv);
+		if (argc > 3)
+			version_arg = argv[3];
+	}
+
+	offline_compiler = getenv("PIGLIT_GLSLPARSER_OFFLINE");
+	if (offline_compiler != NULL && offline_compiler[0] != '\0') {
+		if (batch_mode)
+			run_batch(argc, argv);
+		piglit_report_result(run_test(argc, argv));
+	}
+	offline_compiler = NULL;
+
+	if (version_arg) {
 		const unsigned int version
-			= parse_glsl_version_number(argv[3]);
+			= parse_glsl_version_number(version_arg);
 		const bool compat = !!(version & COMPAT_FLAG);
 		const unsigned int int_version = version & ~COMPAT_FLAG;
 		switch (int_version) {
@@ -96,6 +132,7 @@ PIGLIT_GL_TEST_CONFIG_END
 static char *filename;
 static int expected_pass;
 static int gl_version_times_10 = 0;
+static unsigned glsl_version = 0;
 static int check_link = 0;
 static unsigned requested_version = 110;
 static bool test_requires_geometry_shader4 = false;
@@ -239,7 +276,22 @@ attach_complementary_shader(GLuint shader_prog, GLenum type)
 		attach_dummy_shader(shader_prog, GL_FRAGMENT_SHADER);
 }
 
-static void
+/**
+ * Like piglit_require_extension(), but return whether the extension is
+ * supported instead of exiting, so that a batch can go on with the next
+ * test.
+ */
+static bool
+require_extension(const char *name)
+{
+	if (!piglit_is_extension_supported(name)) {
+		printf("Test requires %s\n", name);
+		return false;
+	}
+	return true;
+}
+
+static bool
 require_feature(int gl_ver, const char *gl_ext, int es_ver, const char *es_ext)
 {
 	const int required_ver = piglit_is_gles() ? es_ver : gl_ver;
@@ -249,11 +301,33 @@ require_feature(int gl_ver, const char *gl_ext, int es_ver, const char *es_ext)
 	    !piglit_is_extension_supported(required_ext)) {
 		printf("Test requires version %g or %s\n",
 		       required_ver / 10.0, required_ext);
-		piglit_report_result(PIGLIT_SKIP);
+		return false;
 	}
+	return true;
 }
 
-static void
+/* Return the stage of the shader, from the extension of its file. */
+static GLenum
+get_shader_type(void)
+{
+	const char *ext = filename + strlen(filename) - 4;
+
+	if (strcmp(ext, "frag") == 0)
+		return GL_FRAGMENT_SHADER;
+	else if (strcmp(ext, "vert") == 0)
+		return GL_VERTEX_SHADER;
+	else if (strcmp(ext, "tesc") == 0)
+		return GL_TESS_CONTROL_SHADER;
+	else if (strcmp(ext, "tese") == 0)
+		return GL_TESS_EVALUATION_SHADER;
+	else if (strcmp(ext, "geom") == 0)
+		return GL_GEOMETRY_SHADER;
+	else if (strcmp(ext, "comp") == 0)
+		return GL_COMPUTE_SHADER;
+	return GL_NONE;
+}
+
+static enum piglit_result
 test(void)
 {
 	GLint prog;
@@ -266,42 +340,29 @@ test(void)
 	GLenum type;
 	char *failing_stage = NULL;
 
-	if (strcmp(filename + strlen(filename) - 4, "frag") == 0)
-		type = GL_FRAGMENT_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "vert") == 0)
-		type = GL_VERTEX_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "tesc") == 0)
-		type = GL_TESS_CONTROL_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "tese") == 0)
-		type = GL_TESS_EVALUATION_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "geom") == 0)
-		type = GL_GEOMETRY_SHADER;
-	else if (strcmp(filename + strlen(filename) - 4, "comp") == 0)
-		type = GL_COMPUTE_SHADER;
-	else {
-		type = GL_NONE;
+	type = get_shader_type();
+	if (type == GL_NONE) {
 		fprintf(stderr, "Couldn't determine type of program %s\n",
 			filename);
-		piglit_report_result(PIGLIT_FAIL);
+		return PIGLIT_FAIL;
 	}
 
-	piglit_require_vertex_shader();
-	piglit_require_fragment_shader();
-
 	if (type == GL_TESS_CONTROL_SHADER || type == GL_TESS_EVALUATION_SHADER) {
-		require_feature(40, "GL_ARB_tessellation_shader",
-				32, "GL_OES_tessellation_shader");
+		if (!require_feature(40, "GL_ARB_tessellation_shader",
+				     32, "GL_OES_tessellation_shader"))
+			return PIGLIT_SKIP;
 	}
 
 	if (type == GL_COMPUTE_SHADER) {
-		require_feature(43, "GL_ARB_compute_shader", 31, NULL);
+		if (!require_feature(43, "GL_ARB_compute_shader", 31, NULL))
+			return PIGLIT_SKIP;
 	}
 
 	prog_string = piglit_load_text_file(filename, NULL);
 	if (prog_string == NULL) {
 		fprintf(stderr, "Couldn't open program %s: %s\n",
 			filename, strerror(errno));
-		exit(1);
+		return PIGLIT_FAIL;
 	}
 
 	if (dummy_shader_include) {
@@ -399,15 +460,84 @@ test(void)
 		free(info);
 	free(prog_string);
 	glDeleteShader(prog);
-	piglit_report_result (pass ? PIGLIT_PASS : PIGLIT_FAIL);
+	return pass ? PIGLIT_PASS : PIGLIT_FAIL;
+}
+
+/**
+ * Compile the shader with the standalone compiler offline_compiler rather
+ * than with the GL.
+ */
+static enum piglit_result
+test_offline(void)
+{
+	char version[16];
+	char *arguments[8];
+	uint8_t *output = NULL;
+	size_t output_size = 0;
+	GLenum type;
+	bool ok;
+	bool pass;
+	int n = 0;
+
+	if (strcmp(offline_compiler, "glslang") == 0) {
+		/* The stage is taken from the extension of the file. */
+		arguments[n] = getenv("PIGLIT_GLSLANG_BINARY");
+		if (arguments[n++] == NULL)
+			arguments[n - 1] = "glslangValidator";
+	} else if (strcmp(offline_compiler, "mesa") == 0) {
+		arguments[n] = getenv("PIGLIT_GLSL_COMPILER_BINARY");
+		if (arguments[n++] == NULL)
+			arguments[n - 1] = "glsl_compiler";
+		snprintf(version, sizeof(version), "%u", requested_version);
+		arguments[n++] = "--version";
+		arguments[n++] = version;
+	} else {
+		fprintf(stderr, "Unknown offline compiler %s, expected glslang "
+			"or mesa\n", offline_compiler);
+		return PIGLIT_FAIL;
+	}
+	arguments[n++] = filename;
+	arguments[n] = NULL;
+
+	type = get_shader_type();
+	if (type == GL_NONE) {
+		fprintf(stderr, "Couldn't determine type of program %s\n",
+			filename);
+		return PIGLIT_FAIL;
+	}
+
+	/* The output of a compiler that fails isn't kept by
+	 * piglit_subprocess(), only what it writes to stderr is shown.
+	 */
+	ok = piglit_subprocess(arguments, 0, NULL, &output_size, &output);
+	pass = expected_pass == ok;
+
+	if (ok) {
+		fprintf(pass ? stdout : stderr,
+			"Successfully compiled %s shader %s with %s: %.*s\n",
+			get_shader_name(type), filename, arguments[0],
+			(int) output_size, (const char *) output);
+		free(output);
+	} else {
+		fprintf(pass ? stdout : stderr,
+			"Failed to compile %s shader %s with %s\n",
+			get_shader_name(type), filename, arguments[0]);
+	}
+
+	return pass ? PIGLIT_PASS : PIGLIT_FAIL;
 }
 
 static void usage(char *name)
 {
 	printf("%s {options} <filename.frag|filename.vert> <pass|fail> "
 	       "{requested GLSL version} {list of required GL extensions}\n", name);
+	printf("%s --batch <GLSL version> {test} {-- test}...\n", name);
 	printf("\nSupported options:\n");
 	printf("  --check-link: also detect link failures\n");
+	printf("\nWith --batch, each test has the arguments of a single test "
+	       "and is run in a\ncontext for the GLSL version of the batch. "
+	       "Without tests on the command\nline they are read from stdin, "
+	       "one per line.\n");
 	exit(1);
 }
 
@@ -485,40 +615,45 @@ parse_glsl_version_string(const char *str)
 }
 
 
-static void
-check_version(unsigned glsl_version)
+static enum piglit_result
+check_version(void)
 {
+	const char *es_compat = NULL;
+
 	if (!piglit_is_gles()) {
-		if (requested_version == 100) {
-			piglit_require_extension("GL_ARB_ES2_compatibility");
-			return;
-		} else if (requested_version == 300) {
-			piglit_require_extension("GL_ARB_ES3_compatibility");
-			return;
-		} else if (requested_version == 310) {
-			piglit_require_extension("GL_ARB_ES3_1_compatibility");
-			return;
-		} else if (requested_version == 320) {
-			piglit_require_extension("GL_ARB_ES3_2_compatibility");
-			return;
-		}
+		if (requested_version == 100)
+			es_compat = "GL_ARB_ES2_compatibility";
+		else if (requested_version == 300)
+			es_compat = "GL_ARB_ES3_compatibility";
+		else if (requested_version == 310)
+			es_compat = "GL_ARB_ES3_1_compatibility";
+		else if (requested_version == 320)
+			es_compat = "GL_ARB_ES3_2_compatibility";
 	}
 
+	if (es_compat)
+		return require_extension(es_compat) ? PIGLIT_PASS : PIGLIT_SKIP;
+
 	if (glsl_version < requested_version) {
 		fprintf(stderr,
 			"GLSL version is %u.%u, but requested version %u.%u is required\n",
 			glsl_version / 100, glsl_version % 100,
 			requested_version / 100, requested_version % 100);
-		piglit_report_result(PIGLIT_SKIP);
+		return PIGLIT_SKIP;
 	}
+
+	return PIGLIT_PASS;
 }
 
 
-void
-piglit_init(int argc, char**argv)
+/**
+ * Check the requirements of the test in argv, which are the arguments of a
+ * single test after its options are processed, and run it.
+ */
+static enum piglit_result
+run_test(int argc, char **argv)
 {
-	const char *glsl_version_string;
-	unsigned glsl_version = 0;
+	enum piglit_result result;
 	int i;
 
 	if (argc < 3)
@@ -535,9 +670,121 @@ piglit_init(int argc, char**argv)
 	else
 		usage(argv[0]);
 
+	requested_version = 110;
 	if (argc > 3)
 		requested_version = parse_glsl_version_number(argv[3]) & ~COMPAT_FLAG;
 
+	/* There is no GL to check the requirements against. */
+	if (offline_compiler != NULL)
+		return test_offline();
+
+	result = check_version();
+	if (result != PIGLIT_PASS)
+		return result;
+
+	for (i = 4; i < argc; i++) {
+		if (argv[i][0] == '!') {
+			if (piglit_is_extension_supported(argv[i] + 1))
+				return PIGLIT_SKIP;
+		} else {
+			if (!require_extension(argv[i]))
+				return PIGLIT_SKIP;
+			if (strstr(argv[i], "geometry_shader4") != NULL)
+				test_requires_geometry_shader4 = true;
+		}
+	}
+
+	return test();
+}
+
+
+/**
+ * Run one test of a batch, whose arguments are in argv after the program
+ * name, and report it as a subtest named after its file.
+ */
+static void
+run_batch_test(int test_num, int argc, char **argv)
+{
+	enum piglit_result result;
+	const char *name;
+
+	check_link = 0;
+	dummy_shader_include = false;
+	shader_include_path = NULL;
+	test_requires_geometry_shader4 = false;
+
+	argc = process_options(argc, argv);
+	if (argc < 2)
+		usage(argv[0]);
+
+	name = strrchr(argv[1], PIGLIT_PATH_SEP);
+	name = name ? name + 1 : argv[1];
+
+	/* Print the name before running the test, so that the run can be
+	 * resumed after it if it crashes.
+	 */
+	printf("PIGLIT TEST: %i - %s\n", test_num, name);
+	fprintf(stderr, "PIGLIT TEST: %i - %s\n", test_num, name);
+
+	result = run_test(argc, argv);
+	piglit_report_subtest_result(result, "%s", name);
+}
+
+
+/**
+ * Run the tests of a batch, which are the arguments after the GLSL version
+ * separated by "--", or the lines of stdin if there are none.
+ */
+static void
+run_batch(int argc, char **argv)
+{
+	char *args[64];
+	char line[4096];
+	int test_num = 0;
+	int num_args;
+	int i;
+
+	args[0] = argv[0];
+
+	if (argc > 3) {
+		num_args = 1;
+		for (i = 3; i <= argc; i++) {
+			if (i == argc || strcmp(argv[i], "--") == 0) {
+				if (num_args > 1)
+					run_batch_test(test_num++, num_args,
+						       args);
+				num_args = 1;
+			} else if (num_args < ARRAY_SIZE(args)) {
+				args[num_args++] = argv[i];
+			}
+		}
+		exit(0);
+	}
+
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		char *arg = strtok(line, " \t\r\n");
+
+		num_args = 1;
+		while (arg != NULL && num_args < ARRAY_SIZE(args)) {
+			args[num_args++] = arg;
+			arg = strtok(NULL, " \t\r\n");
+		}
+
+		if (num_args > 1)
+			run_batch_test(test_num++, num_args, args);
+	}
+	exit(0);
+}
+
+
+void
+piglit_init(int argc, char**argv)
+{
+	const char *glsl_version_string;
+
+	if (argc < 3)
+		usage(argv[0]);
+
 	gl_version_times_10 = piglit_get_gl_version();
 
 	if (gl_version_times_10 < 20
@@ -552,19 +799,13 @@ piglit_init(int argc, char**argv)
 	if (glsl_version_string != NULL)
 		glsl_version = parse_glsl_version_string(glsl_version_string);
 
-	check_version(glsl_version);
+	piglit_require_vertex_shader();
+	piglit_require_fragment_shader();
 
-	for (i = 4; i < argc; i++) {
-		if (argv[i][0] == '!') {
-			piglit_require_not_extension(argv[i] + 1);
-		} else {
-			piglit_require_extension(argv[i]);
-			if (strstr(argv[i], "geometry_shader4") != NULL)
-				test_requires_geometry_shader4 = true;
-		}
-	}
+	if (batch_mode)
+		run_batch(argc, argv);
 
-	test();
+	piglit_report_result(run_test(argc, argv));
 }
 
 enum piglit_result
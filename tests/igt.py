@@ -33,6 +33,7 @@ drm. Even if you have rendernode support enabled.
 
 """
 
+import concurrent.futures
 import os
 import re
 import subprocess
@@ -145,37 +146,73 @@ def list_tests(listname):
     return []
 
 
-def add_subtest_cases(test):
-    """Get subtest instances."""
+def list_subtests(test):
+    """Return the return code of --list-subtests and the subtests listed."""
     try:
         out = subprocess.check_output(
             [os.path.join(IGT_TEST_ROOT, test), '--list-subtests'],
             env=os.environ.copy(),
             universal_newlines=True)
     except subprocess.CalledProcessError as e:
-        # a return code of 79 indicates there are no subtests
-        if e.returncode == 79:
-            profile.test_list[grouptools.join('igt', test)] = IGTTest(test)
-        elif e.returncode != 0:
-            print("Error: Could not list subtests for " + test)
-        else:
-            raise
+        return e.returncode, []
+    return 0, [s for s in out.splitlines() if s]
+
 
-        # If we reach here there are no subtests.
+def add_subtest_cases(test, returncode, subtests):
+    """Add the instances of the subtests of test."""
+    # a return code of 79 indicates there are no subtests
+    if returncode == 79:
+        profile.test_list[grouptools.join('igt', test)] = IGTTest(test)
+        return
+    elif returncode != 0:
+        print("Error: Could not list subtests for " + test)
         return
 
-    for subtest in (s for s in out.splitlines() if s):
+    for subtest in subtests:
         profile.test_list[grouptools.join('igt', test, subtest)] = \
             IGTTest(test, ['--run-subtest', subtest])
 
 
 def populate_profile():
+    """Add every test of the test lists.
+
+    Listing the subtests means running each of the binaries, so the lists
+    are cached by binary. The binaries that changed since they were last
+    listed are listed again all at once.
+
+    """
     tests = []
     for test_list in TEST_LISTS:
         tests.extend(list_tests(test_list))
 
+    cache = core.load_cache('igt_subtests')
+    listed = {}
+    stale = []
+    for test in tests:
+        path = os.path.realpath(os.path.join(IGT_TEST_ROOT, test))
+        identity = core.binary_identity(path)
+        entry = cache.get(path)
+        if identity is not None and entry and entry['binary'] == identity:
+            listed[test] = entry['returncode'], entry['subtests']
+        else:
+            stale.append((test, path, identity))
+
+    if stale:
+        with concurrent.futures.ThreadPoolExecutor() as executor:
+            results = executor.map(list_subtests, [s[0] for s in stale])
+            for (test, path, identity), result in zip(stale, results):
+                listed[test] = result
+                # Failures are not cached, they are reported every time
+                if identity is not None and result[0] in (0, 79):
+                    cache[path] = {'binary': identity,
+                                   'returncode': result[0],
+                                   'subtests': result[1]}
+                else:
+                    cache.pop(path, None)
+        core.store_cache('igt_subtests', cache)
+
     for test in tests:
-        add_subtest_cases(test)
+        add_subtest_cases(test, *listed[test])
 
 
 populate_profile()
@@ -66,12 +66,7 @@ namespace glsl
       void setUniform(const std::string& name, const Value& value)
       {
          loadProgram();
-
-         if (mVertex)
-            mVertex->variable(name) = value;
-
-         if (mFragment)
-            mFragment->variable(name) = value;
+         setShaderVariable(name, value);
 
          mShaderState[name] = value;
 
@@ -87,11 +82,7 @@ namespace glsl
          loadProgram();
 
          Value value = Value((float)sampler);
-         if (mVertex)
-            mVertex->variable(name) = value;
-
-         if (mFragment)
-            mFragment->variable(name) = value;
+         setShaderVariable(name, value);
 
          mShaderState[name] = value;
 
@@ -99,6 +90,16 @@ namespace glsl
          glUniform1i(mShaderState[name].location(), sampler);
       }
 
+      /* Set the value the shaders see in software, without touching GL */
+      void setShaderVariable(const std::string& name, const Value& value)
+      {
+         if (mVertex)
+            mVertex->variable(name) = value;
+
+         if (mFragment)
+            mFragment->variable(name) = value;
+      }
+
       void applyState()
       {
          loadProgram();
@@ -35,6 +35,7 @@
 
 #include "glsl/shader.h"
 #include "tests/random.h"
+#include "tests/pipeline.h"
 
 #include "version.h"
 
@@ -56,7 +57,10 @@ FrameBuffer gFrameBuffer;
 
 bool RandomTest::enabled = true;
 
+unsigned int random_test_seed = 0xbeefface;
+int random_test_first = 0;
 int random_test_count = 10000;
+unsigned int random_test_threads = std::thread::hardware_concurrency() / 2;
 
 bool test_perform_next = false;
 std::vector<Test*> tests;
@@ -77,9 +81,12 @@ piglit_display(void)
          pass &= test->run();
       }
 
-      RandomTest rnd;
-      for (int i = 0; i < random_test_count; ++i)
-         pass &= rnd.run();
+      RandomTestPipeline pipeline(random_test_seed, random_test_first,
+                                  random_test_count, random_test_threads);
+      while (RandomTest* rnd = pipeline.next()) {
+         pass &= rnd->runPrepared();
+         delete rnd;
+      }
    } else {
       if (test_perform_next) {
          test_current++;
@@ -135,7 +142,6 @@ void piglit_init(int argc, char** argv)
    std::cout << "git head: " << GIT_HEAD << std::endl;
 
    gFrameBuffer.setSize(piglit_width, piglit_height);
-   gRandom.setImplementation(new Mersenne(0xbeefface));
 
    for (int i = 1; i < argc; ++i) {
       if (strcmp(argv[i], "-rgba32f") == 0) {
@@ -151,6 +157,12 @@ void piglit_init(int argc, char** argv)
             tests.push_back(new RandomTest(argv[++i]));
          } else if (strcmp(argv[i], "-count") == 0) {
             random_test_count = atoi(argv[++i]);
+         } else if (strcmp(argv[i], "-first") == 0) {
+            random_test_first = atoi(argv[++i]);
+         } else if (strcmp(argv[i], "-seed") == 0) {
+            random_test_seed = strtoul(argv[++i], NULL, 16);
+         } else if (strcmp(argv[i], "-threads") == 0) {
+            random_test_threads = atoi(argv[++i]);
          } else if (strcmp(argv[i], "-type") == 0) {
             gFrameBuffer.setType(glStringToEnum(argv[++i]));
          } else if (strcmp(argv[i], "-internalformat") == 0) {
@@ -161,6 +173,8 @@ void piglit_init(int argc, char** argv)
       }
    }
 
+   gRandom.setImplementation(new Mersenne(random_test_seed));
+
    if (gFrameBuffer.type() != GL_FLOAT && gFrameBuffer.type() != GL_HALF_FLOAT && !gFrameBuffer.clamped()) {
       gFrameBuffer.setClamped(true);
    }
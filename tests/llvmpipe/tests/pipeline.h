@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "random.h"
+#include "../utils/mersenne.h"
+
+/*
+ * Prepares random tests on worker threads, so the GL thread only has to
+ * draw and probe them.
+ *
+ * The generator of every test is seeded from the seed of the run and the
+ * index of the test, so the tests and their ids are the same whatever the
+ * number of threads, a range of them can be run without generating the
+ * ones before it, and a failing test can be rerun alone with -test <id>.
+ * With no threads the tests are prepared on the GL thread as they are
+ * asked for.
+ */
+class RandomTestPipeline
+{
+public:
+   RandomTestPipeline(unsigned int seed, int first, int count, unsigned int threads)
+      : mFirst(first), mNextPrepare(0), mNextRun(0), mDepth(threads * 2), mStop(false)
+   {
+      for (int i = 0; i < count; ++i)
+         mIds.push_back(Mersenne(Mersenne::caseSeed(seed, first + i)).state());
+
+      for (unsigned int i = 0; i < threads; ++i)
+         mThreads.push_back(std::thread(&RandomTestPipeline::worker, this));
+   }
+
+   ~RandomTestPipeline()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mLock);
+         mStop = true;
+      }
+      mSpace.notify_all();
+
+      for (std::vector<std::thread>::iterator itr = mThreads.begin(); itr != mThreads.end(); ++itr)
+         itr->join();
+
+      for (std::map<size_t, RandomTest*>::iterator itr = mPrepared.begin(); itr != mPrepared.end(); ++itr)
+         delete itr->second;
+   }
+
+   /* The next prepared test, in order, or NULL after the last one */
+   RandomTest* next()
+   {
+      if (mNextRun == mIds.size())
+         return NULL;
+
+      if (mThreads.empty())
+         return prepare(mNextRun++);
+
+      std::unique_lock<std::mutex> lock(mLock);
+      while (mPrepared.find(mNextRun) == mPrepared.end())
+         mReady.wait(lock);
+
+      RandomTest* test = mPrepared[mNextRun];
+      mPrepared.erase(mNextRun++);
+      lock.unlock();
+
+      mSpace.notify_all();
+      return test;
+   }
+
+private:
+   RandomTest* prepare(size_t index)
+   {
+      Mersenne random;
+      RandomTest* test = new RandomTest(mIds[index], mFirst + index);
+
+      Random::setThreadImplementation(&random);
+      test->prepare();
+      Random::setThreadImplementation(NULL);
+
+      return test;
+   }
+
+   void worker()
+   {
+      std::unique_lock<std::mutex> lock(mLock);
+
+      for (;;) {
+         /* Stay at most mDepth tests ahead of the GL thread */
+         while (!mStop && mNextPrepare < mIds.size() && mNextPrepare >= mNextRun + mDepth)
+            mSpace.wait(lock);
+
+         if (mStop || mNextPrepare == mIds.size())
+            return;
+
+         size_t index = mNextPrepare++;
+         lock.unlock();
+
+         RandomTest* test = prepare(index);
+
+         lock.lock();
+         mPrepared[index] = test;
+         mReady.notify_one();
+      }
+   }
+
+private:
+   std::vector<std::string> mIds;
+   int mFirst;
+   size_t mNextPrepare;
+   size_t mNextRun;
+   size_t mDepth;
+   bool mStop;
+
+   std::map<size_t, RandomTest*> mPrepared;
+   std::vector<std::thread> mThreads;
+   std::mutex mLock;
+   std::condition_variable mReady;
+   std::condition_variable mSpace;
+};
@@ -24,6 +24,7 @@
 #pragma once
 
 #include "test.h"
+#include "render.h"
 #include "randomshader.h"
 
 class RandomTest : public Test
@@ -33,12 +34,13 @@ public:
 
 public:
    RandomTest()
-      : mLoadState(false)
+      : mLoadState(false), mPrepared(false), mUsesUniform(false), mIndex(-1)
    {
    }
 
-   RandomTest(const std::string& test)
-      : mLoadState(true), mRandomState(test)
+   RandomTest(const std::string& test, int index = -1)
+      : mLoadState(true), mPrepared(false), mUsesUniform(false), mIndex(index),
+        mRandomState(test)
    {
    }
 
@@ -46,10 +48,35 @@ public:
    {
    }
 
+   /*
+    * Generate the test and render its reference image. This needs no GL,
+    * so the tests can be prepared on other threads while the GL thread
+    * runs the previous ones.
+    */
+   void prepare()
+   {
+      generate();
+      renderReference(mReference);
+      mPrepared = true;
+   }
+
+   /* Run a prepared test, on the GL thread */
+   GLboolean runPrepared()
+   {
+      beginTest();
+      applyState();
+      draw();
+
+      return check(mReference);
+   }
+
 protected:
    virtual void dumpState()
    {
-      std::cout << "RandomTest id: " << mRandomState << std::endl;
+      std::cout << "RandomTest id: " << mRandomState;
+      if (mIndex >= 0)
+         std::cout << " (case " << mIndex << ")";
+      std::cout << std::endl;
 
       Test::dumpState();
    }
@@ -60,6 +87,24 @@ protected:
    }
 
    virtual void beginTest()
+   {
+      if (!mPrepared)
+         generate();
+
+      if (mShader.enabled && mUsesUniform) {
+         mShader.program->setUniform("colour", mUniformColour);
+      }
+
+      if (mTexture.enabled) {
+         uploadTexture();
+
+         if (mShader.enabled) {
+            mShader.program->setUniformSampler2D("texture_id", 0);
+         }
+      }
+   }
+
+   void generate()
    {
       if (mLoadState) {
          gRandom.setState(mRandomState);
@@ -97,8 +142,10 @@ protected:
          RandomShader shader;
          mShader.program = shader.program();
 
-         if (shader.usesUniform()) {
-            mShader.program->setUniform("colour", gRandom.random<Colour>());
+         mUsesUniform = shader.usesUniform();
+         if (mUsesUniform) {
+            mUniformColour = gRandom.random<Colour>();
+            mShader.program->setShaderVariable("colour", mUniformColour);
          }
 
          mTexture.enabled = shader.usesTexture();
@@ -111,10 +158,10 @@ protected:
          }
 
          generateTexture(mDraw.width, mDraw.height, image);
-         setTexture(mDraw.width, mDraw.height, image);
+         setTextureImage(mDraw.width, mDraw.height, image);
 
          if (mShader.enabled) {
-            mShader.program->setUniformSampler2D("texture_id", 0);
+            mShader.program->setShaderVariable("texture_id", glsl::Value(0.0f));
          }
       }
    }
@@ -145,5 +192,10 @@ protected:
 
 private:
    bool mLoadState;
+   bool mPrepared;
+   bool mUsesUniform;
+   Colour mUniformColour;
+   int mIndex;
    std::string mRandomState;
+   Render mReference;
 };
@@ -39,12 +39,18 @@ GLboolean Test::run()
    beginTest();
    applyState();
    draw();
+   renderReference(gRender);
 
+   return check(gRender);
+}
+
+GLboolean Test::check(Render& reference)
+{
    GLboolean pass = piglit_probe_image_rgba_error_mask(0, 0,
-                                                       gRender.width(), gRender.height(),
-                                                       gRender.frameBuffer(),
-                                                       gRender.channelMask(),
-                                                       gRender.alphaTestMask(),
+                                                       reference.width(), reference.height(),
+                                                       reference.frameBuffer(),
+                                                       reference.channelMask(),
+                                                       reference.alphaTestMask(),
                                                        dumpPrefix(),
                                                        &mErrorX, &mErrorY);
    if (!pass)
@@ -128,28 +134,10 @@ void Test::applyState()
       glClampColorARB(GL_CLAMP_VERTEX_COLOR_ARB, GL_FALSE);
       glClampColorARB(GL_CLAMP_FRAGMENT_COLOR_ARB, GL_FALSE);
    }
-
-   gRender.resize(gFrameBuffer.width(), gFrameBuffer.height());
-
-   gRender.setChannelBits(gFrameBuffer.channelBits());
-   gRender.setChannelMask(gFrameBuffer.channelMask());
-   gRender.setAlphaState(&mAlpha);
-   gRender.setBlendState(&mBlend);
-   gRender.setMaskState(&mMask);
-   gRender.setClearColour(mDraw.clear);
-   gRender.setShaderProgram(mShader.program);
 }
 
-void Test::draw()
+void Test::quad(float verts[4][3], float tex[4][2], Colour colours[4]) const
 {
-   if (!mDraw.enabled) {
-      return;
-   }
-
-   float verts[4][3];
-   float tex[4][2];
-   Colour colours[4];
-
    verts[0][0] = mDraw.x;
    verts[0][1] = mDraw.y;
    verts[0][2] = 0.0f;
@@ -177,6 +165,19 @@ void Test::draw()
    tex[3][0]   = 0.0f;
    tex[3][1]   = 1.0f;
    colours[3]  = mDraw.style == DrawState::Solid ? mDraw.colour : (mDraw.direction == DrawState::Horizontal ? mDraw.gradient1 : mDraw.gradient2);
+}
+
+void Test::draw()
+{
+   if (!mDraw.enabled) {
+      return;
+   }
+
+   float verts[4][3];
+   float tex[4][2];
+   Colour colours[4];
+
+   quad(verts, tex, colours);
 
    glEnableClientState(GL_VERTEX_ARRAY);
 
@@ -195,18 +196,41 @@ void Test::draw()
    glDisableClientState(GL_VERTEX_ARRAY);
    glDisableClientState(GL_COLOR_ARRAY);
    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+void Test::renderReference(Render& render)
+{
+   render.resize(gFrameBuffer.width(), gFrameBuffer.height());
+
+   render.setChannelBits(gFrameBuffer.channelBits());
+   render.setChannelMask(gFrameBuffer.channelMask());
+   render.setAlphaState(&mAlpha);
+   render.setBlendState(&mBlend);
+   render.setMaskState(&mMask);
+   render.setClearColour(mDraw.clear);
+   render.setShaderProgram(mShader.program);
+
+   render.setClampOutput(gFrameBuffer.type() != GL_FLOAT && gFrameBuffer.type() != GL_HALF_FLOAT);
+   render.clear();
+
+   if (!mDraw.enabled) {
+      return;
+   }
+
+   float verts[4][3];
+   float tex[4][2];
+   Colour colours[4];
 
-   gRender.setClampOutput(gFrameBuffer.type() != GL_FLOAT && gFrameBuffer.type() != GL_HALF_FLOAT);
-   gRender.clear();
+   quad(verts, tex, colours);
 
    if (mTexture.enabled) {
-      gRender.bindTexture2D(mTexture.width, mTexture.height, mTexture.image);
-      gRender.texCoordPointer((Vertex2f*)tex);
+      render.bindTexture2D(mTexture.width, mTexture.height, mTexture.image);
+      render.texCoordPointer((Vertex2f*)tex);
    }
 
-   gRender.colorPointer(colours);
-   gRender.vertexPointer((Vertex3f*)verts);
-   gRender.drawQuads(4);
+   render.colorPointer(colours);
+   render.vertexPointer((Vertex3f*)verts);
+   render.drawQuads(4);
 
-   gRender.render();
+   render.render();
 }
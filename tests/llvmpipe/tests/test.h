@@ -28,6 +28,8 @@
 #include "../utils/piglit-ext.h"
 #include "../utils/framebuffer.h"
 
+class Render;
+
 class Test {
 public:
    Test()
@@ -37,7 +39,7 @@ public:
       mDraw.height = piglit_height;
    }
 
-   ~Test()
+   virtual ~Test()
    {
    }
 
@@ -181,6 +183,13 @@ public:
 
    /* Texture */
    void setTexture(int width, int height, Colour* image)
+   {
+      setTextureImage(width, height, image);
+      uploadTexture();
+   }
+
+   /* Texture image, without uploading it to GL */
+   void setTextureImage(int width, int height, Colour* image)
    {
       if (mTexture.width != width || mTexture.height != height) {
          if (mTexture.bgra_u8)
@@ -206,7 +215,10 @@ public:
             bgra_u8[3] = float_to_ubyte(image->alpha());
          }
       }
+   }
 
+   void uploadTexture()
+   {
       if (mTexture.texture == 0)
          glGenTextures(1, &mTexture.texture);
 
@@ -270,6 +282,12 @@ protected:
    virtual void draw();
    virtual void dumpState();
 
+   /* Software render of the test, needs no GL and so no GL thread */
+   void renderReference(Render& render);
+   GLboolean check(Render& reference);
+
+   void quad(float verts[4][3], float tex[4][2], Colour colours[4]) const;
+
 protected:
    int mErrorX, mErrorY;
    DrawState mDraw;
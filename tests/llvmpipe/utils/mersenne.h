@@ -47,6 +47,21 @@ public:
       init(seed);
    }
 
+   /*
+    * The seed of the generator of case index of a run seeded with seed, so
+    * any case can be generated without generating those before it.
+    */
+   static uint32_t caseSeed(uint32_t seed, uint32_t index)
+   {
+      uint32_t x = seed + index * 0x9E3779B9;
+      x ^= x >> 16;
+      x *= 0x85EBCA6B;
+      x ^= x >> 13;
+      x *= 0xC2B2AE35;
+      x ^= x >> 16;
+      return x;
+   }
+
    virtual void setState(const std::string& state){
       uint32_t seed, index;
       sscanf(state.c_str(), "%08x%03d", &seed, &index);
@@ -25,6 +25,8 @@
 #include "mersenne.h"
 #include "piglit-ext.h"
 
+static thread_local IRandom* threadRandom = NULL;
+
 Random::Random()
    : mRandom(NULL)
 {
@@ -39,9 +41,14 @@ Random::~Random()
 {
 }
 
+IRandom* Random::impl()
+{
+   return threadRandom ? threadRandom : mRandom;
+}
+
 std::string Random::state()
 {
-   return mRandom->state();
+   return impl()->state();
 }
 
 void Random::setImplementation(IRandom* impl)
@@ -51,7 +58,12 @@ void Random::setImplementation(IRandom* impl)
 
 void Random::setState(const std::string& state)
 {
-   mRandom->setState(state);
+   impl()->setState(state);
+}
+
+void Random::setThreadImplementation(IRandom* impl)
+{
+   threadRandom = impl;
 }
 
 unsigned int Random::percent()
@@ -66,7 +78,7 @@ unsigned int Random::randomUInt()
 
 template<> int Random::random<int>()
 {
-   return abs(int(mRandom->value()));
+   return abs(int(impl()->value()));
 }
 
 template<> int Random::random<int>(int max)
@@ -81,7 +93,7 @@ template<> int Random::random<int>(int min, int max)
 
 template<> unsigned int Random::random<unsigned int>()
 {
-   return mRandom->value();
+   return impl()->value();
 }
 
 template<> unsigned int Random::random<unsigned int>(unsigned int max)
@@ -96,7 +108,8 @@ template<> unsigned int Random::random<unsigned int>(unsigned int min, unsigned
 
 template<> float Random::random<float>()
 {
-   return mRandom->value() / (float)mRandom->max();
+   IRandom* random = impl();
+   return random->value() / (float)random->max();
 }
 
 template<> float Random::random<float>(float max)
@@ -53,6 +53,9 @@ public:
    void setImplementation(IRandom* impl);
    void setState(const std::string& state);
 
+   /* While set, the calling thread draws from impl instead */
+   static void setThreadImplementation(IRandom* impl);
+
    template<typename T> T random();
    template<typename T> T random(T max);
    template<typename T> T random(T min, T max);
@@ -76,6 +79,7 @@ public:
 
 private:
    unsigned int randomUInt();
+   IRandom* impl();
 
 private:
    IRandom* mRandom;
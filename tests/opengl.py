@@ -597,7 +597,7 @@ with profile.test_list.group_manager(
     g(['gl-1.0-rastercolor'])
     g(['gl-1.0-read-cache-stress-test'])
     g(['gl-1.0-readpixsanity'])
-    g(['gl-1.0-logicop'])
+    g(['gl-1.0-logicop'], parallel_subtests=True)
     g(['gl-1.0-no-op-paths'])
     g(['gl-1.0-simple-readbuffer'])
     g(['gl-1.0-spot-light'])
@@ -623,8 +623,8 @@ with profile.test_list.group_manager(
         grouptools.join('spec', '!opengl 1.1')) as g:
     # putting slower tests first
     g(['streaming-texture-leak'])
-    g(['max-texture-size'])
-    g(['max-texture-size-level'])
+    g(['max-texture-size'], resource_class='vram')
+    g(['max-texture-size-level'], resource_class='vram')
     g(['large-tex'])
     g(['copyteximage', '1D'])
     g(['copyteximage', '2D'])
@@ -932,7 +932,7 @@ with profile.test_list.group_manager(
     g(['gl-3.0-multidrawarrays-vertexid'],
       'gl_VertexID used with glMultiDrawArrays')
     g(['gl-3.0-minmax'], 'minmax')
-    g(['gl-3.0-render-integer'], 'render-integer')
+    g(['gl-3.0-render-integer'], 'render-integer', parallel_subtests=True)
     g(['gl-3.0-required-sized-texture-formats', '30'],
       'required-sized-texture-formats')
     g(['gl-3.0-required-renderbuffer-attachment-formats', '30'],
@@ -1595,13 +1595,13 @@ with profile.test_list.group_manager(
 with profile.test_list.group_manager(
         PiglitGLTest, grouptools.join('spec', 'ARB_texture_multisample')) as g:
     g(['arb_texture_multisample-large-float-texture'], 'large-float-texture',
-      run_concurrent=False)
+      resource_class='vram')
     g(['arb_texture_multisample-large-float-texture', '--array'],
-      'large-float-texture-array', run_concurrent=False)
+      'large-float-texture-array', resource_class='vram')
     g(['arb_texture_multisample-large-float-texture', '--fp16'],
-      'large-float-texture-fp16', run_concurrent=False)
+      'large-float-texture-fp16', resource_class='vram')
     g(['arb_texture_multisample-large-float-texture', '--array', '--fp16'],
-      'large-float-texture-array-fp16', run_concurrent=False)
+      'large-float-texture-array-fp16', resource_class='vram')
     g(['arb_texture_multisample-minmax'])
     g(['texelFetch', 'fs', 'sampler2DMS', '4', '1x71-501x71'])
     g(['texelFetch', 'fs', 'sampler2DMS', '4', '1x130-501x130'])
@@ -2778,6 +2778,7 @@ with profile.test_list.group_manager(
     g(['compressedteximage', 'GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM'])
     g(['compressedteximage', 'GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT'])
     g(['compressedteximage', 'GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT'])
+    g(['compressed-reference-decode', 'GL_COMPRESSED_RGBA_BPTC_UNORM'])
     g(['fbo-generatemipmap-formats', 'GL_ARB_texture_compression_bptc-unorm'],
       'fbo-generatemipmap-formats unorm')
     g(['fbo-generatemipmap-formats', 'GL_ARB_texture_compression_bptc-float'],
@@ -3406,6 +3407,9 @@ with profile.test_list.group_manager(
         PiglitGLTest,
         grouptools.join('spec', 'ext_texture_compression_latc')) as g:
     g(['arb_texture_compression-invalid-formats', 'latc'], 'invalid formats')
+    for f in ['LUMINANCE_LATC1', 'SIGNED_LUMINANCE_LATC1',
+              'LUMINANCE_ALPHA_LATC2', 'SIGNED_LUMINANCE_ALPHA_LATC2']:
+        g(['compressed-reference-decode', 'GL_COMPRESSED_{}_EXT'.format(f)])
     g(['fbo-generatemipmap-formats', 'GL_EXT_texture_compression_latc'],
       'fbo-generatemipmap-formats')
     g(['fbo-generatemipmap-formats', 'GL_EXT_texture_compression_latc-signed'],
@@ -3419,6 +3423,8 @@ with profile.test_list.group_manager(
     g(['compressedteximage', 'GL_COMPRESSED_RED_GREEN_RGTC2_EXT'])
     g(['compressedteximage', 'GL_COMPRESSED_SIGNED_RED_RGTC1_EXT'])
     g(['compressedteximage', 'GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT'])
+    for f in ['RED_RGTC1', 'SIGNED_RED_RGTC1', 'RG_RGTC2', 'SIGNED_RG_RGTC2']:
+        g(['compressed-reference-decode', 'GL_COMPRESSED_' + f])
     g(['arb_texture_compression-invalid-formats', 'rgtc'], 'invalid formats')
     g(['rgtc-teximage-01'])
     g(['rgtc-teximage-02'])
@@ -3436,6 +3442,9 @@ with profile.test_list.group_manager(
     g(['compressedteximage', 'GL_COMPRESSED_RGBA_S3TC_DXT1_EXT'])
     g(['compressedteximage', 'GL_COMPRESSED_RGBA_S3TC_DXT3_EXT'])
     g(['compressedteximage', 'GL_COMPRESSED_RGBA_S3TC_DXT5_EXT'])
+    for f in ['RGB_S3TC_DXT1', 'RGBA_S3TC_DXT1', 'RGBA_S3TC_DXT3',
+              'RGBA_S3TC_DXT5']:
+        g(['compressed-reference-decode', 'GL_COMPRESSED_{}_EXT'.format(f)])
     g(['arb_texture_compression-invalid-formats', 's3tc'], 'invalid formats')
     g(['gen-compressed-teximage'])
     g(['s3tc-errors'])
@@ -3666,13 +3675,7 @@ with profile.test_list.group_manager(
         g(['ext_transform_feedback-alignment', str(alignment)],
           'alignment {0}'.format(alignment))
 
-    for output_type in ['float', 'vec2', 'vec3', 'vec4', 'mat2', 'mat2x3',
-                        'mat2x4', 'mat3x2', 'mat3', 'mat3x4', 'mat4x2',
-                        'mat4x3', 'mat4', 'int', 'ivec2', 'ivec3', 'ivec4',
-                        'uint', 'uvec2', 'uvec3', 'uvec4']:
-        for suffix in ['', '[2]', '[2]-no-subscript']:
-            g(['ext_transform_feedback-output-type', output_type, suffix],
-              'output-type {0}{1}'.format(output_type, suffix))
+    g(['ext_transform_feedback-output-type', 'batch'], 'output-type')
 
     for mode in ['discard', 'buffer', 'prims_generated', 'prims_written']:
         g(['ext_transform_feedback-generatemipmap', mode],
@@ -5005,6 +5008,10 @@ with profile.test_list.group_manager(
         for context in ['core', 'compat']:
             g(['oes_compressed_etc2_texture-miptree', tex_format, context])
 
+    for f in ['RGB8_ETC2', 'RGB8_PUNCHTHROUGH_ALPHA1_ETC2', 'RGBA8_ETC2_EAC',
+              'R11_EAC', 'SIGNED_R11_EAC', 'RG11_EAC', 'SIGNED_RG11_EAC']:
+        g(['compressed-reference-decode', 'GL_COMPRESSED_' + f])
+
 with profile.test_list.group_manager(
         PiglitGLTest,
         grouptools.join('spec', 'arb_shader_atomic_counters')) as g:
@@ -5115,7 +5122,8 @@ with profile.test_list.group_manager(
     g(['arb_shader_image_load_store-layer'], 'layer')
     g(['arb_shader_image_load_store-level'], 'level')
     g(['arb_shader_image_load_store-max-images'], 'max-images')
-    g(['arb_shader_image_load_store-max-size'], 'max-size')
+    g(['arb_shader_image_load_store-max-size'], 'max-size',
+      resource_class='vram')
     g(['arb_shader_image_load_store-minmax'], 'minmax')
     g(['arb_shader_image_load_store-qualifiers'], 'qualifiers')
     g(['arb_shader_image_load_store-restrict'], 'restrict')
@@ -5349,7 +5357,7 @@ with profile.test_list.group_manager(
 with profile.test_list.group_manager(
         PiglitGLTest,
         grouptools.join('spec', 'NV_image_formats')) as g:
-    g(['nv_image_formats-gles3'])
+    g(['nv_image_formats-gles3'], parallel_subtests=True)
 
 with profile.test_list.group_manager(
         PiglitGLTest,
@@ -0,0 +1,97 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""A profile that runs the benchmarks of tests/perf.
+
+Every measurement of a benchmark becomes a subtest of it. Pass a previous run
+of this profile with --perf-baseline to fail the measurements that regressed
+by more than --perf-threshold, and use "piglit summary console --perf" to see
+how they changed over several runs.
+
+To compare driver configurations within one run, pass --perf-config once per
+configuration, for example "--perf-config off:mesa_glthread=false
+--perf-config on:mesa_glthread=true", or "--perf-config errors
+--perf-config no_error:MESA_NO_ERROR=1" for KHR_no_error.
+
+Run it on an otherwise idle machine.
+"""
+
+import glob
+import os
+
+from framework import grouptools
+from framework.profile import TestProfile
+from framework.test.perf import PerfTest
+from framework.test.shader_test import ShaderTest
+from .py_modules.constants import GENERATED_TESTS_DIR, TESTS_DIR
+
+__all__ = ['profile']
+
+profile = TestProfile()
+
+
+def add_perf(name, *args):
+    profile.test_list[grouptools.join('perf', name)] = \
+        PerfTest([name] + list(args))
+
+
+add_perf('alloc-churn')
+add_perf('atomics')
+add_perf('barrier')
+add_perf('bindless')
+add_perf('buffer-streaming')
+add_perf('cl-compute')
+add_perf('cl-gl-interop')
+add_perf('cl-kernel-launch')
+add_perf('cl-program-bitcoin-phatk', '-duration', '0.5')
+add_perf('cl-transfer')
+add_perf('computeoverhead')
+add_perf('context-switch')
+add_perf('copy-bandwidth')
+add_perf('dlist')
+add_perf('depth-reject')
+add_perf('dma-buf-import')
+add_perf('draw-prim-sweep')
+add_perf('drawoverhead')
+add_perf('fast-clear')
+add_perf('indirect-draw')
+add_perf('multithread-submit')
+add_perf('msaa-resolve')
+add_perf('pixel-rate')
+add_perf('readback')
+add_perf('rop')
+add_perf('sync-latency')
+add_perf('teximage')
+add_perf('tex-sample')
+add_perf('texupload')
+add_perf('vertex-fetch')
+add_perf('xfb')
+add_perf('shader-compile', *sorted(glob.glob(os.path.join(
+    TESTS_DIR, 'spec', 'glsl-1.10', 'execution', '*.shader_test'))))
+
+# The UBO and SSBO layout benchmarks of generated_tests/random_ubo-benchmark.py
+for path in sorted(glob.glob(os.path.join(
+        GENERATED_TESTS_DIR, 'perf', 'ubo-layout', '*.shader_test'))):
+    test = ShaderTest.new(path)
+    test.run_concurrent = False
+    profile.test_list[grouptools.join(
+        'perf', 'ubo-layout', os.path.splitext(os.path.basename(path))[0])] = \
+        test
@@ -0,0 +1,484 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the costs of allocating GPU memory:
+ *
+ *  - create: the rate of creating, allocating and deleting buffers and 2D
+ *    RGBA8 textures of a few sizes
+ *  - first-use: the latency from creating a buffer or texture to the GPU
+ *    having written a word of it, from glCopyBufferSubData or
+ *    glTexSubImage2D, at the median and 99th percentile
+ *  - sparse: the rate of committing and uncommitting 16 MB of a sparse
+ *    texture (GL_ARB_sparse_texture) or buffer (GL_ARB_sparse_buffer)
+ *  - working set: the frame rate of sampling every one of a set of 64 MB
+ *    textures once per frame, for sets of 50%, 100% and 150% of the video
+ *    memory, as reported by GL_NVX_gpu_memory_info or GL_ATI_meminfo, or
+ *    given with -vram.  Larger sets are skipped once one runs out of memory.
+ *
+ * The peak resident set size of the process is reported after each group.
+ *
+ * Usage: alloc-churn [-duration SECONDS] [-vram MB]
+ */
+
+#include <string.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+static unsigned vram_mb;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-vram") && i + 1 < argc) {
+			vram_mb = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "alloc-churn [-duration SECONDS] "
+				"[-vram MB]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MB (1024 * 1024)
+#define FIRST_USE_SAMPLES 200
+/* The amount committed and uncommitted at once. */
+#define COMMIT_SIZE (16 * MB)
+#define SPARSE_TEXTURE_SIZE 8192
+#define SPARSE_BUFFER_SIZE (256 * MB)
+/* The textures of the working sets are 64 MB. */
+#define WORKING_SET_TEXTURE_SIZE 4096
+#define WORKING_SET_TEXTURE_MB 64
+
+static const unsigned buffer_sizes[] = { 4096, 256 * 1024, 16 * MB };
+static const unsigned texture_sizes[] = { 64, 1024, 4096 };
+static const unsigned working_set_percents[] = { 50, 100, 150 };
+
+static const char *vs_source =
+	"#version 150\n"
+	"in vec4 piglit_vertex;\n"
+	"void main() {\n"
+	"	gl_Position = piglit_vertex;\n"
+	"}\n";
+
+static const char *fs_source =
+	"#version 150\n"
+	"uniform sampler2D tex;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = texture(tex, vec2(0.5));\n"
+	"}\n";
+
+static GLuint src_buf, sample_prog;
+static int64_t samples[FIRST_USE_SAMPLES];
+
+/* The case being measured. */
+static unsigned cur_size;
+static GLuint *cur_textures;
+static unsigned cur_num_textures;
+static GLint commit_width, commit_height;
+
+static void
+print_row(const char *name, double value, const char *unit)
+{
+	printf("  %-32s, %12.2f, %s\n", name, value, unit);
+	fflush(stdout);
+}
+
+static void
+report_peak_rss(const char *group)
+{
+#ifndef _WIN32
+	struct rusage usage;
+	char name[64];
+
+	/* Linux gives ru_maxrss in kilobytes. */
+	getrusage(RUSAGE_SELF, &usage);
+	snprintf(name, sizeof(name), "peak rss after %s", group);
+	print_row(name, usage.ru_maxrss / 1024.0, "MB");
+	perf_report_value("alloc-churn", name, "MB", 1,
+			  usage.ru_maxrss / 1024.0);
+#endif
+}
+
+static void
+report_rate(const char *name, double rate, double scale, const char *unit)
+{
+	print_row(name, rate * scale, unit);
+	perf_report("alloc-churn", name, unit, scale, perf_last_stats());
+}
+
+static void
+create_buffers(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		GLuint buf;
+
+		glGenBuffers(1, &buf);
+		glBindBuffer(GL_ARRAY_BUFFER, buf);
+		glBufferData(GL_ARRAY_BUFFER, cur_size, NULL, GL_STATIC_DRAW);
+		glDeleteBuffers(1, &buf);
+	}
+}
+
+static void
+create_textures(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		GLuint tex;
+
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, cur_size, cur_size);
+		glDeleteTextures(1, &tex);
+	}
+}
+
+static void
+measure_create(void)
+{
+	char name[64];
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(buffer_sizes); i++) {
+		cur_size = buffer_sizes[i];
+		snprintf(name, sizeof(name), "create buffer %uK",
+			 cur_size / 1024);
+		report_rate(name, perf_measure_cpu_rate(create_buffers,
+							duration),
+			    1, "objects/s");
+	}
+
+	for (i = 0; i < ARRAY_SIZE(texture_sizes); i++) {
+		cur_size = texture_sizes[i];
+		snprintf(name, sizeof(name), "create texture %u", cur_size);
+		report_rate(name, perf_measure_cpu_rate(create_textures,
+							duration),
+			    1, "objects/s");
+	}
+
+	report_peak_rss("create");
+}
+
+static void
+first_use(const char *name, bool texture)
+{
+	static const GLubyte texel[4];
+	struct perf_latency latency;
+	unsigned i;
+
+	for (i = 0; i < FIRST_USE_SAMPLES; i++) {
+		int64_t start;
+		GLuint obj;
+
+		glFinish();
+		start = piglit_time_get_nano();
+		if (texture) {
+			glGenTextures(1, &obj);
+			glBindTexture(GL_TEXTURE_2D, obj);
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, cur_size,
+				       cur_size);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, cur_size - 1,
+					cur_size - 1, 1, 1, GL_RGBA,
+					GL_UNSIGNED_BYTE, texel);
+		} else {
+			glGenBuffers(1, &obj);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, obj);
+			glBufferData(GL_COPY_WRITE_BUFFER, cur_size, NULL,
+				     GL_STATIC_DRAW);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER,
+					    GL_COPY_WRITE_BUFFER, 0,
+					    cur_size - 4, 4);
+		}
+		glFinish();
+		samples[i] = piglit_time_get_nano() - start;
+
+		if (texture)
+			glDeleteTextures(1, &obj);
+		else
+			glDeleteBuffers(1, &obj);
+	}
+
+	perf_report_latency("alloc-churn", name, samples, FIRST_USE_SAMPLES,
+			    &latency);
+	printf("  %-32s, %12.2f, usec p50, %.2f p99\n", name, latency.p50,
+	       latency.p99);
+}
+
+static void
+measure_first_use(void)
+{
+	char name[64];
+	unsigned i;
+
+	glGenBuffers(1, &src_buf);
+	glBindBuffer(GL_COPY_READ_BUFFER, src_buf);
+	glBufferData(GL_COPY_READ_BUFFER, 4, NULL, GL_STATIC_DRAW);
+
+	for (i = 0; i < ARRAY_SIZE(buffer_sizes); i++) {
+		cur_size = buffer_sizes[i];
+		snprintf(name, sizeof(name), "first-use buffer %uK",
+			 cur_size / 1024);
+		first_use(name, false);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(texture_sizes); i++) {
+		cur_size = texture_sizes[i];
+		snprintf(name, sizeof(name), "first-use texture %u", cur_size);
+		first_use(name, true);
+	}
+
+	report_peak_rss("first-use");
+}
+
+static void
+commit_texture(unsigned count)
+{
+	const unsigned per_row = SPARSE_TEXTURE_SIZE / commit_width;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		unsigned region = i % (per_row * (SPARSE_TEXTURE_SIZE /
+						  commit_height));
+		GLint x = region % per_row * commit_width;
+		GLint y = region / per_row * commit_height;
+
+		glTexPageCommitmentARB(GL_TEXTURE_2D, 0, x, y, 0, commit_width,
+				       commit_height, 1, GL_TRUE);
+		glTexPageCommitmentARB(GL_TEXTURE_2D, 0, x, y, 0, commit_width,
+				       commit_height, 1, GL_FALSE);
+	}
+}
+
+static void
+commit_buffer(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		GLintptr offset =
+			(GLintptr)(i % (SPARSE_BUFFER_SIZE / COMMIT_SIZE)) *
+			COMMIT_SIZE;
+
+		glBufferPageCommitmentARB(GL_ARRAY_BUFFER, offset, COMMIT_SIZE,
+					  GL_TRUE);
+		glBufferPageCommitmentARB(GL_ARRAY_BUFFER, offset, COMMIT_SIZE,
+					  GL_FALSE);
+	}
+}
+
+static void
+measure_sparse(void)
+{
+	const double commit_mb = COMMIT_SIZE / MB;
+
+	if (piglit_is_extension_supported("GL_ARB_sparse_texture")) {
+		GLint page_x, page_y;
+		GLuint tex;
+
+		glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8,
+				      GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &page_x);
+		glGetInternalformativ(GL_TEXTURE_2D, GL_RGBA8,
+				      GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &page_y);
+
+		/* A region of COMMIT_SIZE, whole pages wide. */
+		commit_width = MAX2(page_x, 2048);
+		commit_height = COMMIT_SIZE / 4 / commit_width;
+
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, SPARSE_TEXTURE_SIZE,
+			       SPARSE_TEXTURE_SIZE);
+
+		if (commit_height % page_y == 0) {
+			report_rate("sparse texture commit",
+				    perf_measure_gpu_rate(commit_texture,
+							  duration),
+				    commit_mb, "MB/s");
+		} else {
+			printf("  %-32s, %12s\n", "sparse texture commit",
+			       "-");
+		}
+		glDeleteTextures(1, &tex);
+	} else {
+		printf("  %-32s, %12s\n", "sparse texture commit", "-");
+	}
+
+	if (piglit_is_extension_supported("GL_ARB_sparse_buffer")) {
+		GLuint buf;
+
+		glGenBuffers(1, &buf);
+		glBindBuffer(GL_ARRAY_BUFFER, buf);
+		glBufferStorage(GL_ARRAY_BUFFER, SPARSE_BUFFER_SIZE, NULL,
+				GL_SPARSE_STORAGE_BIT_ARB |
+				GL_DYNAMIC_STORAGE_BIT);
+		report_rate("sparse buffer commit",
+			    perf_measure_gpu_rate(commit_buffer, duration),
+			    commit_mb, "MB/s");
+		glDeleteBuffers(1, &buf);
+	} else {
+		printf("  %-32s, %12s\n", "sparse buffer commit", "-");
+	}
+
+	report_peak_rss("sparse");
+}
+
+static void
+sample_working_set(unsigned count)
+{
+	unsigned i, t;
+
+	for (i = 0; i < count; i++) {
+		for (t = 0; t < cur_num_textures; t++) {
+			glBindTexture(GL_TEXTURE_2D, cur_textures[t]);
+			piglit_draw_rect(-1, -1, 0.01, 0.01);
+		}
+	}
+}
+
+static unsigned
+query_vram_mb(void)
+{
+	GLint kb[4];
+
+	if (piglit_is_extension_supported("GL_NVX_gpu_memory_info")) {
+		glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, kb);
+		return kb[0] / 1024;
+	}
+	if (piglit_is_extension_supported("GL_ATI_meminfo")) {
+		/* The total isn't available, only the free memory. */
+		glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, kb);
+		return kb[0] / 1024;
+	}
+	return 0;
+}
+
+static void
+measure_working_set(void)
+{
+	GLuint fbo;
+	unsigned i;
+
+	if (!vram_mb)
+		vram_mb = query_vram_mb();
+	if (!vram_mb) {
+		printf("  %-32s, %12s, video memory size unknown, "
+		       "use -vram\n", "working set", "-");
+		return;
+	}
+
+	sample_prog = piglit_build_simple_program(vs_source, fs_source);
+	glGenFramebuffers(1, &fbo);
+
+	for (i = 0; i < ARRAY_SIZE(working_set_percents); i++) {
+		unsigned n = (vram_mb * working_set_percents[i] / 100 +
+			      WORKING_SET_TEXTURE_MB - 1) /
+			     WORKING_SET_TEXTURE_MB;
+		bool out_of_memory = false;
+		char name[64];
+		unsigned t;
+
+		cur_textures = calloc(n, sizeof(*cur_textures));
+		cur_num_textures = n;
+		glGenTextures(n, cur_textures);
+
+		/* Clear every texture, so that it is really allocated. */
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		for (t = 0; t < n && !out_of_memory; t++) {
+			glBindTexture(GL_TEXTURE_2D, cur_textures[t]);
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8,
+				       WORKING_SET_TEXTURE_SIZE,
+				       WORKING_SET_TEXTURE_SIZE);
+			glFramebufferTexture2D(GL_FRAMEBUFFER,
+					       GL_COLOR_ATTACHMENT0,
+					       GL_TEXTURE_2D, cur_textures[t],
+					       0);
+			glClear(GL_COLOR_BUFFER_BIT);
+			out_of_memory = glGetError() == GL_OUT_OF_MEMORY;
+		}
+		glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+
+		snprintf(name, sizeof(name), "working set %u%% (%u MB)",
+			 working_set_percents[i], n * WORKING_SET_TEXTURE_MB);
+		if (!out_of_memory) {
+			glUseProgram(sample_prog);
+			report_rate(name,
+				    perf_measure_gpu_rate(sample_working_set,
+							  duration),
+				    1, "frames/s");
+			glUseProgram(0);
+			out_of_memory = glGetError() == GL_OUT_OF_MEMORY;
+		}
+
+		glDeleteTextures(n, cur_textures);
+		free(cur_textures);
+
+		if (out_of_memory) {
+			printf("  %-32s, %12s, out of memory\n", name, "-");
+			break;
+		}
+	}
+
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteProgram(sample_prog);
+	report_peak_rss("working set");
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	piglit_require_extension("GL_ARB_texture_storage");
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	printf("  %-32s, %12s, %s\n", "Measurement", "Value", "Unit");
+
+	measure_create();
+	measure_first_use();
+	measure_sparse();
+	measure_working_set();
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
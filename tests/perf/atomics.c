@@ -0,0 +1,312 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the GPU throughput of atomic additions from 1M fragment or
+ * compute shader invocations, each doing ITERATIONS of them, to:
+ *
+ *  - counter: one atomic counter (the others are "-")
+ *  - ssbo: a uint array in a shader storage block
+ *  - image: a r32ui image buffer
+ *  - shared: a shared uint array, compute only, with as many addresses as
+ *    the work group has invocations at most
+ *
+ * Invocation i adds to address i % N, for N from 1 (all invocations contend
+ * for one address) to "distinct" (an address per invocation).
+ *
+ * Usage: atomics [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "atomics [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* The fragment stage covers a WIDTH x WIDTH framebuffer. */
+#define WIDTH 1024
+#define NUM_INVOCATIONS (WIDTH * WIDTH)
+#define LOCAL_SIZE 256
+#define ITERATIONS 16
+/* An address per invocation. */
+#define DISTINCT NUM_INVOCATIONS
+
+enum kind {
+	KIND_COUNTER,
+	KIND_SSBO,
+	KIND_IMAGE,
+	KIND_SHARED,
+	NUM_KINDS
+};
+
+static const char *kind_names[NUM_KINDS] = {
+	"counter",
+	"ssbo",
+	"image",
+	"shared",
+};
+
+static const unsigned address_counts[] = {
+	1, 16, 256, 4096, 65536, DISTINCT
+};
+
+static const char *kind_decls[NUM_KINDS] = {
+	"layout(binding = 0) uniform atomic_uint counter;\n",
+
+	"layout(std430, binding = 0) buffer Data { uint data[]; };\n",
+
+	"layout(r32ui, binding = 0) uniform uimageBuffer img;\n",
+
+	"shared uint s[SHARED];\n"
+	"layout(std430, binding = 0) buffer Data { uint data[]; };\n",
+};
+
+static const char *kind_bodies[NUM_KINDS] = {
+	"	for (int i = 0; i < ITERATIONS; i++)\n"
+	"		atomicCounterIncrement(counter);\n",
+
+	"	for (int i = 0; i < ITERATIONS; i++)\n"
+	"		atomicAdd(data[id % ADDRESSES], 1u);\n",
+
+	"	for (int i = 0; i < ITERATIONS; i++)\n"
+	"		imageAtomicAdd(img, int(id % ADDRESSES), 1u);\n",
+
+	"	uint local = gl_LocalInvocationIndex;\n"
+	"	if (local < SHARED)\n"
+	"		s[local] = 0u;\n"
+	"	barrier();\n"
+	"	for (int i = 0; i < ITERATIONS; i++)\n"
+	"		atomicAdd(s[local % SHARED], 1u);\n"
+	"	barrier();\n"
+	"	if (local < SHARED)\n"
+	"		data[gl_WorkGroupID.x * SHARED + local] = s[local];\n",
+};
+
+static const char *vs_source =
+	"#version 150\n"
+	"in vec4 piglit_vertex;\n"
+	"void main() {\n"
+	"	gl_Position = piglit_vertex;\n"
+	"}\n";
+
+static GLuint fbo, counter_buf, data_buf, image_tex;
+
+/* The case being measured. */
+static bool cur_compute;
+
+static bool
+kind_supported(enum kind kind, bool compute, unsigned addresses)
+{
+	static const GLenum fs_limits[NUM_KINDS] = {
+		GL_MAX_FRAGMENT_ATOMIC_COUNTERS,
+		GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS,
+		GL_MAX_FRAGMENT_IMAGE_UNIFORMS,
+		GL_NONE,
+	};
+	GLint limit;
+
+	if (kind == KIND_COUNTER && addresses != 1)
+		return false;
+	if (kind == KIND_SHARED)
+		return compute;
+	if (compute)
+		return true;
+
+	glGetIntegerv(fs_limits[kind], &limit);
+	return limit > 0;
+}
+
+static GLuint
+create_program(enum kind kind, bool compute, unsigned addresses)
+{
+	char header[256];
+	const char *fs_main =
+		"void main() {\n"
+		"	uint id = uint(gl_FragCoord.y) * WIDTH +\n"
+		"		  uint(gl_FragCoord.x);\n";
+	const char *cs_main =
+		"layout(local_size_x = LOCAL_SIZE) in;\n"
+		"void main() {\n"
+		"	uint id = gl_GlobalInvocationID.x;\n";
+	char *source;
+	GLuint prog;
+
+	snprintf(header, sizeof(header),
+		 "#version 430\n"
+		 "#define WIDTH %uu\n"
+		 "#define LOCAL_SIZE %u\n"
+		 "#define ITERATIONS %u\n"
+		 "#define ADDRESSES %uu\n"
+		 "#define SHARED %uu\n",
+		 WIDTH, LOCAL_SIZE, ITERATIONS, addresses,
+		 MIN2(addresses, LOCAL_SIZE));
+
+	asprintf(&source, "%s%s%s%s}\n", header, kind_decls[kind],
+		 compute ? cs_main : fs_main, kind_bodies[kind]);
+
+	if (compute)
+		prog = piglit_build_simple_program_multiple_shaders(
+			GL_COMPUTE_SHADER, source, 0);
+	else
+		prog = piglit_build_simple_program(vs_source, source);
+
+	free(source);
+	return prog;
+}
+
+static void
+run(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		if (cur_compute)
+			glDispatchCompute(NUM_INVOCATIONS / LOCAL_SIZE, 1, 1);
+		else
+			piglit_draw_rect(-1, -1, 2, 2);
+	}
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	GLuint tex;
+
+	piglit_require_gl_version(43);
+
+	/* Only the invocations matter, not the colors. */
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, WIDTH, WIDTH);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			       GL_TEXTURE_2D, tex, 0);
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glViewport(0, 0, WIDTH, WIDTH);
+
+	glGenBuffers(1, &counter_buf);
+	glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 0, counter_buf);
+	glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(GLuint), NULL,
+		     GL_DYNAMIC_COPY);
+
+	glGenBuffers(1, &data_buf);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, data_buf);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, NUM_INVOCATIONS * sizeof(GLuint),
+		     NULL, GL_DYNAMIC_COPY);
+
+	glGenTextures(1, &image_tex);
+	glBindTexture(GL_TEXTURE_BUFFER, image_tex);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, data_buf);
+	glBindImageTexture(0, image_tex, 0, GL_FALSE, 0, GL_READ_WRITE,
+			   GL_R32UI);
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	unsigned stage, k, a;
+
+	printf("  %-8s, %-8s", "Stage", "Kind");
+	for (a = 0; a < ARRAY_SIZE(address_counts); a++) {
+		if (address_counts[a] == DISTINCT)
+			printf(", %8s", "distinct");
+		else
+			printf(", %8u", address_counts[a]);
+	}
+	printf("   (Gatomics/s)\n");
+
+	for (stage = 0; stage < 2; stage++) {
+		cur_compute = stage == 1;
+
+		for (k = 0; k < NUM_KINDS; k++) {
+			printf("  %-8s, %-8s", cur_compute ? "compute" : "fragment",
+			       kind_names[k]);
+
+			for (a = 0; a < ARRAY_SIZE(address_counts); a++) {
+				const unsigned addresses = address_counts[a];
+				const double atomics =
+					(double)NUM_INVOCATIONS * ITERATIONS;
+				char name[64];
+				GLuint prog;
+				double rate;
+
+				if (!kind_supported(k, cur_compute, addresses)) {
+					printf(", %8s", "-");
+					continue;
+				}
+
+				prog = create_program(k, cur_compute, addresses);
+				glUseProgram(prog);
+				rate = perf_measure_gpu_rate(run, duration);
+				glUseProgram(0);
+				glDeleteProgram(prog);
+
+				if (!piglit_check_gl_error(GL_NO_ERROR))
+					piglit_report_result(PIGLIT_FAIL);
+
+				printf(", %8.2f", rate * atomics / 1e9);
+				fflush(stdout);
+
+				if (addresses == DISTINCT)
+					snprintf(name, sizeof(name),
+						 "%s %s distinct",
+						 cur_compute ? "compute" :
+							       "fragment",
+						 kind_names[k]);
+				else
+					snprintf(name, sizeof(name),
+						 "%s %s %u",
+						 cur_compute ? "compute" :
+							       "fragment",
+						 kind_names[k], addresses);
+				perf_report("atomics", name, "atomics/s",
+					    atomics, perf_last_stats());
+			}
+			printf("\n");
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure what barriers cost between dependent draws and dispatches, to
+ * tell which glMemoryBarrier bits each driver makes expensive.
+ *
+ * Each draw or dispatch increments every texel of a 256x256 image with
+ * imageLoad/imageStore, so that each depends on the previous one, and is
+ * followed by:
+ *
+ *  - no barrier, then each glMemoryBarrier bit alone, then all of them
+ *  - for draws, glMemoryBarrierByRegion with all the bits it accepts
+ *
+ * with the image declared coherent and not.  Draws also sample the texture
+ * they render to and are followed by glTextureBarrier or nothing.
+ *
+ * The time is taken on the CPU up to a glFinish, so that both the flushes
+ * on the CPU and the stalls on the GPU count.  The slowdown is relative to
+ * no barrier.
+ *
+ * Usage: barrier [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.1;
+
+#define SIZE 256
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 43;
+	config.supports_gl_core_version = 43;
+	config.window_width = SIZE;
+	config.window_height = SIZE;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "barrier [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+static const struct barrier {
+	const char *name;
+	GLbitfield bits;
+	/** GL version required */
+	unsigned gl_version;
+} barriers[] = {
+	{ "none", 0, 43 },
+	{ "VERTEX_ATTRIB_ARRAY", GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT, 43 },
+	{ "ELEMENT_ARRAY", GL_ELEMENT_ARRAY_BARRIER_BIT, 43 },
+	{ "UNIFORM", GL_UNIFORM_BARRIER_BIT, 43 },
+	{ "TEXTURE_FETCH", GL_TEXTURE_FETCH_BARRIER_BIT, 43 },
+	{ "SHADER_IMAGE_ACCESS", GL_SHADER_IMAGE_ACCESS_BARRIER_BIT, 43 },
+	{ "COMMAND", GL_COMMAND_BARRIER_BIT, 43 },
+	{ "PIXEL_BUFFER", GL_PIXEL_BUFFER_BARRIER_BIT, 43 },
+	{ "TEXTURE_UPDATE", GL_TEXTURE_UPDATE_BARRIER_BIT, 43 },
+	{ "BUFFER_UPDATE", GL_BUFFER_UPDATE_BARRIER_BIT, 43 },
+	{ "FRAMEBUFFER", GL_FRAMEBUFFER_BARRIER_BIT, 43 },
+	{ "TRANSFORM_FEEDBACK", GL_TRANSFORM_FEEDBACK_BARRIER_BIT, 43 },
+	{ "ATOMIC_COUNTER", GL_ATOMIC_COUNTER_BARRIER_BIT, 43 },
+	{ "SHADER_STORAGE", GL_SHADER_STORAGE_BARRIER_BIT, 43 },
+	{ "CLIENT_MAPPED_BUFFER", GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT, 44 },
+	{ "QUERY_BUFFER", GL_QUERY_BUFFER_BARRIER_BIT, 44 },
+	{ "ALL", GL_ALL_BARRIER_BITS, 43 },
+};
+
+/** The bits glMemoryBarrierByRegion accepts */
+#define BY_REGION_BITS (GL_ATOMIC_COUNTER_BARRIER_BIT | \
+			GL_FRAMEBUFFER_BARRIER_BIT | \
+			GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | \
+			GL_SHADER_STORAGE_BARRIER_BIT | \
+			GL_TEXTURE_FETCH_BARRIER_BIT | \
+			GL_UNIFORM_BARRIER_BIT)
+
+#define INCREMENT_IMAGE \
+	"layout(r32ui) uniform %s uimage2D img;\n" \
+	"void increment(ivec2 p) {\n" \
+	"	imageStore(img, p, imageLoad(img, p) + 1u);\n" \
+	"}\n"
+
+static const char vs_text[] =
+	"#version 430\n"
+	"void main() {\n"
+	"	gl_Position = vec4(gl_VertexID % 2 == 1 ? 1.0 : -1.0,\n"
+	"			   gl_VertexID / 2 == 1 ? 1.0 : -1.0, 0.0, 1.0);\n"
+	"}\n";
+
+static const char cs_text[] =
+	"#version 430\n"
+	"layout(local_size_x = 8, local_size_y = 8) in;\n"
+	INCREMENT_IMAGE
+	"void main() {\n"
+	"	increment(ivec2(gl_GlobalInvocationID.xy));\n"
+	"}\n";
+
+static const char fs_image_text[] =
+	"#version 430\n"
+	INCREMENT_IMAGE
+	"void main() {\n"
+	"	increment(ivec2(gl_FragCoord.xy));\n"
+	"}\n";
+
+static const char fs_texture_text[] =
+	"#version 430\n"
+	"uniform sampler2D tex;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = texelFetch(tex, ivec2(gl_FragCoord.xy), 0) +\n"
+	"		vec4(1.0 / 256.0);\n"
+	"}\n";
+
+/* The programs incrementing the image, indexed by coherent */
+static GLuint compute_progs[2], draw_progs[2];
+static GLuint texture_prog;
+static GLuint vao, image, texture, fbo;
+
+enum op {
+	OP_DISPATCH,
+	OP_DRAW,
+	OP_DRAW_BY_REGION,
+	OP_DRAW_TEXTURE,
+};
+
+static enum op cur_op;
+static GLbitfield cur_bits;
+
+static void
+run(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		switch (cur_op) {
+		case OP_DISPATCH:
+			glDispatchCompute(SIZE / 8, SIZE / 8, 1);
+			break;
+		case OP_DRAW:
+		case OP_DRAW_BY_REGION:
+		case OP_DRAW_TEXTURE:
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			break;
+		}
+
+		if (!cur_bits)
+			continue;
+		if (cur_op == OP_DRAW_TEXTURE)
+			glTextureBarrier();
+		else if (cur_op == OP_DRAW_BY_REGION)
+			glMemoryBarrierByRegion(cur_bits);
+		else
+			glMemoryBarrier(cur_bits);
+	}
+}
+
+static GLuint
+build_program(GLenum stage, const char *text, bool coherent)
+{
+	char *source;
+	GLuint prog;
+
+	if (asprintf(&source, text, coherent ? "coherent" : "") < 0)
+		abort();
+	if (stage == GL_COMPUTE_SHADER)
+		prog = piglit_build_simple_program_multiple_shaders(
+			GL_COMPUTE_SHADER, source, 0);
+	else
+		prog = piglit_build_simple_program(vs_text, source);
+	free(source);
+	return prog;
+}
+
+/** Return the rate of op with bits, printed relative to base if not 0. */
+static double
+measure(const char *what, enum op op, GLuint prog, const char *barrier,
+	GLbitfield bits, double base)
+{
+	const char *unit = op == OP_DISPATCH ? "dispatches/s" : "draws/s";
+	char name[128];
+	double rate;
+
+	cur_op = op;
+	cur_bits = bits;
+	glUseProgram(prog);
+
+	rate = perf_measure_cpu_rate(run, duration);
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	snprintf(name, sizeof(name), "%s %s", what, barrier);
+	perf_report("barrier", name, unit, 1, perf_last_stats());
+
+	printf("  %-22s, %-20s, %12.0f, %8.1f%%\n", what, barrier, rate,
+	       base ? (base / rate - 1) * 100 : 0.0);
+	return rate;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	for (unsigned coherent = 0; coherent < 2; coherent++) {
+		compute_progs[coherent] =
+			build_program(GL_COMPUTE_SHADER, cs_text, coherent);
+		draw_progs[coherent] =
+			build_program(GL_FRAGMENT_SHADER, fs_image_text, coherent);
+	}
+	texture_prog = piglit_build_simple_program(vs_text, fs_texture_text);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glGenTextures(1, &image);
+	glBindTexture(GL_TEXTURE_2D, image);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, SIZE, SIZE);
+	glBindImageTexture(0, image, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, SIZE, SIZE);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			       GL_TEXTURE_2D, texture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		piglit_report_result(PIGLIT_FAIL);
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+	glViewport(0, 0, SIZE, SIZE);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	const unsigned version = piglit_get_gl_version();
+	const bool has_by_region = version >= 45 ||
+		piglit_is_extension_supported("GL_ARB_ES3_1_compatibility");
+	const bool has_texture_barrier = version >= 45 ||
+		piglit_is_extension_supported("GL_ARB_texture_barrier");
+
+	printf("  %-22s, %-20s, %12s, %9s\n", "Operation", "Barrier", "Rate",
+	       "Slowdown");
+
+	for (unsigned coherent = 0; coherent < 2; coherent++) {
+		static const char *dispatch_names[] = {
+			"dispatch", "dispatch coherent",
+		};
+		static const char *draw_names[] = {
+			"draw", "draw coherent",
+		};
+		double dispatch_base = 0, draw_base = 0;
+
+		for (unsigned b = 0; b < ARRAY_SIZE(barriers); b++) {
+			const struct barrier *barrier = &barriers[b];
+			double rate;
+
+			if (version < barrier->gl_version)
+				continue;
+
+			rate = measure(dispatch_names[coherent], OP_DISPATCH,
+				       compute_progs[coherent], barrier->name,
+				       barrier->bits, dispatch_base);
+			if (!barrier->bits)
+				dispatch_base = rate;
+
+			rate = measure(draw_names[coherent], OP_DRAW,
+				       draw_progs[coherent], barrier->name,
+				       barrier->bits, draw_base);
+			if (!barrier->bits)
+				draw_base = rate;
+		}
+
+		if (has_by_region) {
+			measure(draw_names[coherent], OP_DRAW_BY_REGION,
+				draw_progs[coherent], "BY_REGION",
+				BY_REGION_BITS, draw_base);
+		}
+	}
+
+	if (has_texture_barrier) {
+		double base;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glBindTexture(GL_TEXTURE_2D, texture);
+
+		base = measure("draw sampling target", OP_DRAW_TEXTURE,
+			       texture_prog, "none", 0, 0);
+		measure("draw sampling target", OP_DRAW_TEXTURE, texture_prog,
+			"TextureBarrier", ~0u, base);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,416 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the draw rate when every draw switches between two sets of 1 to
+ * 16 textures sampled by the fragment shader, with these strategies:
+ *
+ *  - bind: glActiveTexture and glBindTexture for each texture
+ *  - multibind: one glBindTextures (GL_ARB_multi_bind)
+ *  - array: all the textures bound once to a sampler array, indexed from a
+ *    uniform set per draw (GLSL 4.00)
+ *  - bindless-ubo: resident handles (GL_ARB_bindless_texture) in a
+ *    uniform block, whose range is set per draw with glBindBufferRange
+ *  - bindless-ssbo: the same with a shader storage block
+ *
+ * Like drawoverhead, the triangles are degenerate, so the rate is the CPU
+ * cost of submitting and validating the draws and their bindings.
+ *
+ * Usage: bindless [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "bindless [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MAX_TEXTURES 16
+/* Every draw uses the other set than the previous one. */
+#define NUM_SETS 2
+
+enum mode {
+	MODE_BIND,
+	MODE_MULTIBIND,
+	MODE_ARRAY,
+	MODE_BINDLESS_UBO,
+	MODE_BINDLESS_SSBO,
+	NUM_MODES
+};
+
+static const char *mode_names[NUM_MODES] = {
+	"bind",
+	"multibind",
+	"array",
+	"bindless-ubo",
+	"bindless-ssbo",
+};
+
+static const unsigned texture_counts[] = { 1, 2, 4, 8, 16 };
+
+static const char *vs_source =
+	"#version 150\n"
+	"void main() {\n"
+	"	gl_Position = vec4(0.0);\n"
+	"}\n";
+
+static GLuint tex[NUM_SETS][MAX_TEXTURES];
+static GLuint64 handles[NUM_SETS][MAX_TEXTURES];
+static GLuint handle_ubo, handle_ssbo;
+static GLint ubo_alignment, ssbo_alignment, max_units;
+static bool has_bindless;
+
+/* The case being measured. */
+static enum mode cur_mode;
+static unsigned cur_count;
+static GLint cur_base_loc;
+static GLintptr cur_stride;
+
+static GLintptr
+align(GLintptr x, GLint alignment)
+{
+	return (x + alignment - 1) / alignment * alignment;
+}
+
+static bool
+mode_supported(enum mode mode, unsigned count)
+{
+	switch (mode) {
+	case MODE_BIND:
+		return (GLint)count <= max_units;
+	case MODE_MULTIBIND:
+		return (GLint)count <= max_units &&
+		       (piglit_get_gl_version() >= 44 ||
+			piglit_is_extension_supported("GL_ARB_multi_bind"));
+	case MODE_ARRAY:
+		return (GLint)(NUM_SETS * count) <= max_units &&
+		       piglit_get_gl_version() >= 40;
+	case MODE_BINDLESS_UBO:
+		return has_bindless;
+	case MODE_BINDLESS_SSBO:
+		return has_bindless &&
+		       (piglit_get_gl_version() >= 43 ||
+			piglit_is_extension_supported(
+				"GL_ARB_shader_storage_buffer_object"));
+	default:
+		assert(0);
+		return false;
+	}
+}
+
+/** Return a fragment shader summing one sample of each texture. */
+static char *
+get_fs_source(enum mode mode, unsigned count)
+{
+	char *s = malloc(4096);
+	unsigned i;
+
+	switch (mode) {
+	case MODE_BIND:
+	case MODE_MULTIBIND:
+		sprintf(s, "#version 150\n"
+			"uniform sampler2D s[%u];\n", count);
+		break;
+	case MODE_ARRAY:
+		sprintf(s, "#version 400\n"
+			"uniform sampler2D s[%u];\n"
+			"uniform int base;\n", NUM_SETS * count);
+		break;
+	case MODE_BINDLESS_UBO:
+		/* std140 rounds the elements of arrays up to a vec4. */
+		sprintf(s, "#version 400\n"
+			"#extension GL_ARB_bindless_texture : require\n"
+			"layout(std140) uniform Handles { uvec4 h[%u]; };\n",
+			count);
+		break;
+	case MODE_BINDLESS_SSBO:
+		sprintf(s, "#version 400\n"
+			"#extension GL_ARB_bindless_texture : require\n"
+			"#extension GL_ARB_shader_storage_buffer_object : require\n"
+			"layout(std430) buffer Handles { uvec2 h[%u]; };\n",
+			count);
+		break;
+	default:
+		assert(0);
+	}
+
+	strcat(s, "out vec4 color;\n"
+		  "void main() {\n"
+		  "	color = vec4(0.0);\n");
+	for (i = 0; i < count; i++) {
+		switch (mode) {
+		case MODE_ARRAY:
+			sprintf(s + strlen(s),
+				"	color += texture(s[base + %u], vec2(0.5));\n",
+				i);
+			break;
+		case MODE_BINDLESS_UBO:
+			sprintf(s + strlen(s),
+				"	color += texture(sampler2D(h[%u].xy), "
+				"vec2(0.5));\n", i);
+			break;
+		case MODE_BINDLESS_SSBO:
+			sprintf(s + strlen(s),
+				"	color += texture(sampler2D(h[%u]), "
+				"vec2(0.5));\n", i);
+			break;
+		default:
+			sprintf(s + strlen(s),
+				"	color += texture(s[%u], vec2(0.5));\n", i);
+			break;
+		}
+	}
+	strcat(s, "}\n");
+
+	return s;
+}
+
+/**
+ * Fill the buffer with the handles of each set, at stride bytes from one
+ * set to the next and elem_size bytes from one handle to the next.
+ */
+static void
+upload_handles(GLenum target, GLuint buf, GLintptr stride, unsigned count,
+	       unsigned elem_size)
+{
+	uint8_t *data = calloc(NUM_SETS, stride);
+	unsigned set, i;
+
+	for (set = 0; set < NUM_SETS; set++) {
+		for (i = 0; i < count; i++) {
+			uint32_t *h = (uint32_t *)(data + set * stride +
+						   i * elem_size);
+
+			h[0] = handles[set][i];
+			h[1] = handles[set][i] >> 32;
+		}
+	}
+
+	glBindBuffer(target, buf);
+	glBufferData(target, NUM_SETS * stride, data, GL_STATIC_DRAW);
+	free(data);
+}
+
+static GLuint
+create_program(enum mode mode, unsigned count)
+{
+	char *fs = get_fs_source(mode, count);
+	GLuint prog = piglit_build_simple_program(vs_source, fs);
+	GLint units[NUM_SETS * MAX_TEXTURES];
+	unsigned i;
+
+	free(fs);
+	glUseProgram(prog);
+
+	switch (mode) {
+	case MODE_BIND:
+	case MODE_MULTIBIND:
+	case MODE_ARRAY:
+		for (i = 0; i < ARRAY_SIZE(units); i++)
+			units[i] = i;
+		glUniform1iv(glGetUniformLocation(prog, "s"),
+			     mode == MODE_ARRAY ? NUM_SETS * count : count,
+			     units);
+		cur_base_loc = glGetUniformLocation(prog, "base");
+		break;
+	case MODE_BINDLESS_UBO:
+		glUniformBlockBinding(prog,
+				      glGetUniformBlockIndex(prog, "Handles"),
+				      0);
+		cur_stride = align(count * 16, ubo_alignment);
+		upload_handles(GL_UNIFORM_BUFFER, handle_ubo, cur_stride,
+			       count, 16);
+		break;
+	case MODE_BINDLESS_SSBO:
+		glShaderStorageBlockBinding(
+			prog,
+			glGetProgramResourceIndex(prog,
+						  GL_SHADER_STORAGE_BLOCK,
+						  "Handles"),
+			0);
+		cur_stride = align(count * 8, ssbo_alignment);
+		upload_handles(GL_SHADER_STORAGE_BUFFER, handle_ssbo,
+			       cur_stride, count, 8);
+		break;
+	default:
+		assert(0);
+	}
+
+	/* The array mode binds everything once. */
+	if (mode == MODE_ARRAY) {
+		for (i = 0; i < NUM_SETS * count; i++) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			glBindTexture(GL_TEXTURE_2D, tex[i / count][i % count]);
+		}
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	return prog;
+}
+
+static void
+draw_loop(unsigned count)
+{
+	unsigned i, j;
+
+	for (i = 0; i < count; i++) {
+		unsigned set = i % NUM_SETS;
+
+		switch (cur_mode) {
+		case MODE_BIND:
+			for (j = 0; j < cur_count; j++) {
+				glActiveTexture(GL_TEXTURE0 + j);
+				glBindTexture(GL_TEXTURE_2D, tex[set][j]);
+			}
+			break;
+		case MODE_MULTIBIND:
+			glBindTextures(0, cur_count, tex[set]);
+			break;
+		case MODE_ARRAY:
+			glUniform1i(cur_base_loc, set * cur_count);
+			break;
+		case MODE_BINDLESS_UBO:
+			glBindBufferRange(GL_UNIFORM_BUFFER, 0, handle_ubo,
+					  set * cur_stride, cur_count * 16);
+			break;
+		case MODE_BINDLESS_SSBO:
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0,
+					  handle_ssbo, set * cur_stride,
+					  cur_count * 8);
+			break;
+		default:
+			assert(0);
+		}
+
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const GLubyte texels[4 * 4 * 4];
+	unsigned set, i;
+	GLuint vao;
+
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_units);
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_alignment);
+	has_bindless = piglit_get_gl_version() >= 40 &&
+		       piglit_is_extension_supported("GL_ARB_bindless_texture");
+	if (mode_supported(MODE_BINDLESS_SSBO, 1))
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT,
+			      &ssbo_alignment);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenBuffers(1, &handle_ubo);
+	glGenBuffers(1, &handle_ssbo);
+
+	for (set = 0; set < NUM_SETS; set++) {
+		glGenTextures(MAX_TEXTURES, tex[set]);
+		for (i = 0; i < MAX_TEXTURES; i++) {
+			glBindTexture(GL_TEXTURE_2D, tex[set][i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 4, 4, 0,
+				     GL_RGBA, GL_UNSIGNED_BYTE, texels);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+					GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+					GL_NEAREST);
+
+			if (has_bindless) {
+				handles[set][i] =
+					glGetTextureHandleARB(tex[set][i]);
+				glMakeTextureHandleResidentARB(handles[set][i]);
+			}
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	unsigned m, c;
+
+	printf("  %-14s", "Textures/draw");
+	for (c = 0; c < ARRAY_SIZE(texture_counts); c++)
+		printf(", %8u", texture_counts[c]);
+	printf("   (Mdraws/s)\n");
+
+	for (m = 0; m < NUM_MODES; m++) {
+		printf("  %-14s", mode_names[m]);
+
+		for (c = 0; c < ARRAY_SIZE(texture_counts); c++) {
+			char name[64];
+			GLuint prog;
+			double rate;
+
+			cur_mode = m;
+			cur_count = texture_counts[c];
+
+			if (!mode_supported(cur_mode, cur_count)) {
+				printf(", %8s", "-");
+				continue;
+			}
+
+			prog = create_program(cur_mode, cur_count);
+			rate = perf_measure_cpu_rate(draw_loop, duration);
+			glDeleteProgram(prog);
+
+			if (!piglit_check_gl_error(GL_NO_ERROR))
+				piglit_report_result(PIGLIT_FAIL);
+
+			printf(", %8.2f", rate / 1000000);
+			fflush(stdout);
+
+			snprintf(name, sizeof(name), "%s %utex",
+				 mode_names[m], cur_count);
+			perf_report("bindless", name, "draws/s", 1,
+				    perf_last_stats());
+		}
+		printf("\n");
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,382 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the common ways of streaming vertex data to the GPU, each upload
+ * followed by a draw reading from it:
+ *
+ *  - orphaning: glBufferData(NULL) then glBufferSubData
+ *  - glBufferSubData to the next segment of a ring
+ *  - glMapBufferRange(GL_MAP_UNSYNCHRONIZED_BIT) of the next segment
+ *  - a persistent coherent mapping (GL_ARB_buffer_storage)
+ *  - a persistent mapping flushed with glFlushMappedBufferRange
+ *
+ * The ring methods fence every segment after drawing from it and wait for
+ * the fence before writing it again.  A wait that doesn't find the fence
+ * already signalled is counted as a stall.
+ *
+ * Usage: buffer-streaming [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "buffer-streaming [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Copy data out of a large array to avoid caching effects. */
+#define DATA_SIZE (32 * 1024 * 1024)
+/* Segments in the ring of the ring methods. */
+#define NUM_SEGMENTS 3
+/* Size of a vertex, the draws read one from the start of each upload. */
+#define VERTEX_SIZE 16
+
+static GLubyte *data;
+static GLuint vao, prog, bo;
+static GLubyte *map;
+static GLsync fences[NUM_SEGMENTS];
+static unsigned segment;
+static unsigned src;
+
+static GLsizeiptr upload_size;
+static unsigned num_stalls;
+static unsigned num_uploads;
+
+static const char *vs_source =
+	"#version 150\n"
+	"in vec4 v;\n"
+	"void main() {\n"
+	"	gl_Position = v;\n"
+	"}\n";
+
+static const char *fs_source =
+	"#version 150\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = vec4(1.0);\n"
+	"}\n";
+
+static const GLubyte *
+next_source(void)
+{
+	const GLubyte *p = data + src;
+
+	src += upload_size;
+	if (src + upload_size > DATA_SIZE)
+		src = 0;
+	return p;
+}
+
+static void
+draw_from(GLintptr offset)
+{
+	glDrawArrays(GL_POINTS, offset / VERTEX_SIZE, 1);
+}
+
+/** Wait until the GPU is done with the segment. */
+static void
+wait_segment(unsigned seg)
+{
+	if (!fences[seg])
+		return;
+
+	if (glClientWaitSync(fences[seg], 0, 0) == GL_TIMEOUT_EXPIRED) {
+		num_stalls++;
+		glClientWaitSync(fences[seg], GL_SYNC_FLUSH_COMMANDS_BIT,
+				 10 * 1000000000ull);
+	}
+	glDeleteSync(fences[seg]);
+	fences[seg] = NULL;
+}
+
+static void
+fence_segment(unsigned seg)
+{
+	fences[seg] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	segment = (seg + 1) % NUM_SEGMENTS;
+}
+
+static void
+create_buffer(void)
+{
+	glGenBuffers(1, &bo);
+	glBindBuffer(GL_ARRAY_BUFFER, bo);
+}
+
+static void
+setup_mutable(void)
+{
+	create_buffer();
+	glBufferData(GL_ARRAY_BUFFER, upload_size * NUM_SEGMENTS, NULL,
+		     GL_STREAM_DRAW);
+}
+
+static void
+setup_persistent(GLbitfield flags)
+{
+	create_buffer();
+	glBufferStorage(GL_ARRAY_BUFFER, upload_size * NUM_SEGMENTS, NULL,
+			GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | flags);
+	map = glMapBufferRange(GL_ARRAY_BUFFER, 0, upload_size * NUM_SEGMENTS,
+			       GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+			       (flags & GL_MAP_COHERENT_BIT ?
+				GL_MAP_COHERENT_BIT :
+				GL_MAP_FLUSH_EXPLICIT_BIT));
+}
+
+static void
+setup_coherent(void)
+{
+	setup_persistent(GL_MAP_COHERENT_BIT);
+}
+
+static void
+setup_flushed(void)
+{
+	setup_persistent(0);
+}
+
+static void
+teardown(void)
+{
+	unsigned i;
+
+	for (i = 0; i < NUM_SEGMENTS; i++) {
+		if (fences[i])
+			glDeleteSync(fences[i]);
+		fences[i] = NULL;
+	}
+	if (map)
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	map = NULL;
+	glDeleteBuffers(1, &bo);
+	segment = 0;
+}
+
+static void
+upload_orphan(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		glBufferData(GL_ARRAY_BUFFER, upload_size * NUM_SEGMENTS, NULL,
+			     GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, upload_size,
+				next_source());
+		draw_from(0);
+	}
+	num_uploads += count;
+	glFinish();
+}
+
+static void
+upload_subdata(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		GLintptr offset = segment * upload_size;
+
+		glBufferSubData(GL_ARRAY_BUFFER, offset, upload_size,
+				next_source());
+		draw_from(offset);
+		segment = (segment + 1) % NUM_SEGMENTS;
+	}
+	num_uploads += count;
+	glFinish();
+}
+
+static void
+upload_unsynchronized(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		GLintptr offset = segment * upload_size;
+		void *p;
+
+		wait_segment(segment);
+		p = glMapBufferRange(GL_ARRAY_BUFFER, offset, upload_size,
+				     GL_MAP_WRITE_BIT |
+				     GL_MAP_UNSYNCHRONIZED_BIT |
+				     GL_MAP_INVALIDATE_RANGE_BIT);
+		memcpy(p, next_source(), upload_size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		draw_from(offset);
+		fence_segment(segment);
+	}
+	num_uploads += count;
+	glFinish();
+}
+
+static void
+upload_coherent(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		GLintptr offset = segment * upload_size;
+
+		wait_segment(segment);
+		memcpy(map + offset, next_source(), upload_size);
+		draw_from(offset);
+		fence_segment(segment);
+	}
+	num_uploads += count;
+	glFinish();
+}
+
+static void
+upload_flushed(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		GLintptr offset = segment * upload_size;
+
+		wait_segment(segment);
+		memcpy(map + offset, next_source(), upload_size);
+		glFlushMappedBufferRange(GL_ARRAY_BUFFER, offset, upload_size);
+		draw_from(offset);
+		fence_segment(segment);
+	}
+	num_uploads += count;
+	glFinish();
+}
+
+static const struct {
+	const char *name;
+	void (*setup)(void);
+	perf_rate_func upload;
+	/** Whether stalls can be counted, which needs fences. */
+	bool fenced;
+	bool needs_buffer_storage;
+} methods[] = {
+	{ "BufferData orphaning", setup_mutable, upload_orphan, false, false },
+	{ "BufferSubData ring", setup_mutable, upload_subdata, false, false },
+	{ "unsynchronized map ring", setup_mutable, upload_unsynchronized,
+	  true, false },
+	{ "persistent coherent", setup_coherent, upload_coherent, true, true },
+	{ "persistent flushed", setup_flushed, upload_flushed, true, true },
+};
+
+static const GLsizeiptr sizes[] = {
+	4 * 1024,
+	64 * 1024,
+	1024 * 1024,
+	4 * 1024 * 1024,
+	16 * 1024 * 1024,
+};
+
+void
+piglit_init(int argc, char **argv)
+{
+	data = calloc(DATA_SIZE, 1);
+
+	prog = piglit_build_simple_program(vs_source, fs_source);
+	glBindAttribLocation(prog, 0, "v");
+	glLinkProgram(prog);
+	if (!piglit_link_check_status(prog))
+		piglit_report_result(PIGLIT_FAIL);
+	glUseProgram(prog);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glEnableVertexAttribArray(0);
+
+	/* Only the uploads and the vertex fetch matter. */
+	glEnable(GL_RASTERIZER_DISCARD);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	bool has_buffer_storage =
+		piglit_is_extension_supported("GL_ARB_buffer_storage");
+	unsigned m, s;
+
+	printf("  %-24s, %10s, %8s, %s\n", "Method", "Size", "GB/s",
+	       "Stalls per 1000 uploads");
+
+	for (m = 0; m < ARRAY_SIZE(methods); m++) {
+		if (methods[m].needs_buffer_storage && !has_buffer_storage)
+			continue;
+
+		for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+			char size[16], name[64];
+			double rate;
+
+			upload_size = sizes[s];
+			if (upload_size >= 1024 * 1024)
+				snprintf(size, sizeof(size), "%u MB",
+					 (unsigned)(upload_size >> 20));
+			else
+				snprintf(size, sizeof(size), "%u KB",
+					 (unsigned)(upload_size >> 10));
+
+			methods[m].setup();
+			glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0,
+					      NULL);
+			if (!piglit_check_gl_error(GL_NO_ERROR))
+				piglit_report_result(PIGLIT_FAIL);
+
+			num_stalls = 0;
+			num_uploads = 0;
+			rate = perf_measure_cpu_rate(methods[m].upload,
+						     duration);
+			teardown();
+
+			if (methods[m].fenced) {
+				printf("  %-24s, %10s, %8.2f, %.1f\n",
+				       methods[m].name, size,
+				       rate * upload_size / 1e9,
+				       1000.0 * num_stalls /
+				       MAX2(num_uploads, 1));
+			} else {
+				printf("  %-24s, %10s, %8.2f, -\n",
+				       methods[m].name, size,
+				       rate * upload_size / 1e9);
+			}
+
+			snprintf(name, sizeof(name), "%s, %s", methods[m].name,
+				 size);
+			perf_report("buffer-streaming", name, "GB/s",
+				    upload_size / 1e9, perf_last_stats());
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,311 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the throughput of common compute kernels, so that codegen
+ * regressions of the CL compiler show up as numbers:
+ *
+ *  - reduce: the sum of 4M floats, with a loop per work item and a tree in
+ *    local memory per work group, in GB/s read
+ *  - scan: the per work group inclusive prefix sum of 4M uints, the first
+ *    pass of a full scan, in GB/s read
+ *  - sgemm: a 1024x1024 matrix multiply tiled in local memory, in GFLOPS
+ *
+ * The bitcoin-phatk program test also measures its integer kernel with
+ * -duration.
+ *
+ * Usage: cl-compute [-duration SECONDS]
+ */
+
+#include "piglit-framework-cl-custom.h"
+#include "report.h"
+
+PIGLIT_CL_CUSTOM_TEST_CONFIG_BEGIN
+
+	config.name = "Compute kernel throughput";
+	config.run_per_device = true;
+
+PIGLIT_CL_CUSTOM_TEST_CONFIG_END
+
+#define LOCAL_SIZE 64
+#define TILE 8
+#define NUM_ELEMENTS (4 << 20)
+#define MATRIX_SIZE 1024
+/* The work items of reduce, each summing NUM_ELEMENTS / this. */
+#define REDUCE_ITEMS (64 << 10)
+
+static char *source =
+	"kernel void reduce(global const float *in, global float *out,\n"
+	"		    uint n)\n"
+	"{\n"
+	"	local float tmp[LOCAL_SIZE];\n"
+	"	uint lid = get_local_id(0);\n"
+	"	float sum = 0.0f;\n"
+	"\n"
+	"	for (uint i = get_global_id(0); i < n; i += get_global_size(0))\n"
+	"		sum += in[i];\n"
+	"	tmp[lid] = sum;\n"
+	"	barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"\n"
+	"	for (uint s = LOCAL_SIZE / 2; s > 0; s /= 2) {\n"
+	"		if (lid < s)\n"
+	"			tmp[lid] += tmp[lid + s];\n"
+	"		barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"	}\n"
+	"	if (lid == 0)\n"
+	"		out[get_group_id(0)] = tmp[0];\n"
+	"}\n"
+	"\n"
+	"kernel void scan(global const uint *in, global uint *out,\n"
+	"		  global uint *sums)\n"
+	"{\n"
+	"	local uint tmp[LOCAL_SIZE];\n"
+	"	uint lid = get_local_id(0), gid = get_global_id(0);\n"
+	"\n"
+	"	tmp[lid] = in[gid];\n"
+	"	barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"	for (uint offset = 1; offset < LOCAL_SIZE; offset *= 2) {\n"
+	"		uint v = lid >= offset ? tmp[lid - offset] : 0;\n"
+	"		barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"		tmp[lid] += v;\n"
+	"		barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"	}\n"
+	"	out[gid] = tmp[lid];\n"
+	"	if (lid == LOCAL_SIZE - 1)\n"
+	"		sums[get_group_id(0)] = tmp[lid];\n"
+	"}\n"
+	"\n"
+	"kernel void sgemm(global const float *a, global const float *b,\n"
+	"		   global float *c, uint n)\n"
+	"{\n"
+	"	local float ta[TILE][TILE], tb[TILE][TILE];\n"
+	"	uint lx = get_local_id(0), ly = get_local_id(1);\n"
+	"	uint x = get_global_id(0), y = get_global_id(1);\n"
+	"	float sum = 0.0f;\n"
+	"\n"
+	"	for (uint t = 0; t < n; t += TILE) {\n"
+	"		ta[ly][lx] = a[y * n + t + lx];\n"
+	"		tb[ly][lx] = b[(t + ly) * n + x];\n"
+	"		barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"		for (uint k = 0; k < TILE; k++)\n"
+	"			sum += ta[ly][k] * tb[k][lx];\n"
+	"		barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"	}\n"
+	"	c[y * n + x] = sum;\n"
+	"}\n";
+
+enum workload {
+	WORKLOAD_REDUCE,
+	WORKLOAD_SCAN,
+	WORKLOAD_SGEMM,
+	NUM_WORKLOADS
+};
+
+static const struct {
+	const char *name;
+	const char *unit;
+	cl_uint work_dim;
+	size_t global_size[2];
+	size_t local_size[2];
+	/** The work of a launch in unit. */
+	double work;
+} workloads[NUM_WORKLOADS] = {
+	[WORKLOAD_REDUCE] = {
+		"reduce", "GB/sec", 1,
+		{ REDUCE_ITEMS }, { LOCAL_SIZE },
+		NUM_ELEMENTS * sizeof(float) / 1e9,
+	},
+	[WORKLOAD_SCAN] = {
+		"scan", "GB/sec", 1,
+		{ NUM_ELEMENTS }, { LOCAL_SIZE },
+		NUM_ELEMENTS * sizeof(cl_uint) / 1e9,
+	},
+	[WORKLOAD_SGEMM] = {
+		"sgemm", "GFLOPS", 2,
+		{ MATRIX_SIZE, MATRIX_SIZE }, { TILE, TILE },
+		2.0 * MATRIX_SIZE * MATRIX_SIZE * MATRIX_SIZE / 1e9,
+	},
+};
+
+static bool launch_failed;
+
+/* The case being measured. */
+static cl_command_queue cur_queue;
+static cl_kernel cur_kernel;
+static enum workload cur_workload;
+
+static double
+run(unsigned count)
+{
+	int64_t start = piglit_time_get_nano();
+	unsigned i;
+
+	for (i = 0; i < count && !launch_failed; i++) {
+		if (!piglit_cl_enqueue_ND_range_kernel(
+			    cur_queue, cur_kernel,
+			    workloads[cur_workload].work_dim, NULL,
+			    workloads[cur_workload].global_size,
+			    workloads[cur_workload].local_size, NULL))
+			launch_failed = true;
+	}
+	clFinish(cur_queue);
+
+	return (piglit_time_get_nano() - start) * 0.000000001;
+}
+
+static cl_mem
+create_zeroed_buffer(piglit_cl_context context, size_t size)
+{
+	void *zeros = calloc(size, 1);
+	cl_mem buffer;
+	cl_int err;
+
+	buffer = clCreateBuffer(context->cl_ctx,
+				CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+				size, zeros, &err);
+	free(zeros);
+	if (!piglit_cl_check_error(err, CL_SUCCESS))
+		return NULL;
+	return buffer;
+}
+
+static bool
+set_args(enum workload workload, cl_kernel kernel, cl_mem *buffers)
+{
+	const cl_uint n = workload == WORKLOAD_SGEMM ? MATRIX_SIZE :
+						       NUM_ELEMENTS;
+
+	switch (workload) {
+	case WORKLOAD_REDUCE:
+		return piglit_cl_set_kernel_buffer_arg(kernel, 0, &buffers[0]) &&
+		       piglit_cl_set_kernel_buffer_arg(kernel, 1, &buffers[1]) &&
+		       piglit_cl_set_kernel_arg(kernel, 2, sizeof(n), &n);
+	case WORKLOAD_SCAN:
+		return piglit_cl_set_kernel_buffer_arg(kernel, 0, &buffers[0]) &&
+		       piglit_cl_set_kernel_buffer_arg(kernel, 1, &buffers[1]) &&
+		       piglit_cl_set_kernel_buffer_arg(kernel, 2, &buffers[2]);
+	case WORKLOAD_SGEMM:
+		return piglit_cl_set_kernel_buffer_arg(kernel, 0, &buffers[0]) &&
+		       piglit_cl_set_kernel_buffer_arg(kernel, 1, &buffers[1]) &&
+		       piglit_cl_set_kernel_buffer_arg(kernel, 2, &buffers[2]) &&
+		       piglit_cl_set_kernel_arg(kernel, 3, sizeof(n), &n);
+	default:
+		assert(!"unknown workload");
+		return false;
+	}
+}
+
+enum piglit_result
+piglit_cl_test(const int argc,
+	       const char **argv,
+	       const struct piglit_cl_custom_test_config *config,
+	       const struct piglit_cl_custom_test_env *env)
+{
+	const size_t matrix_bytes = MATRIX_SIZE * MATRIX_SIZE * sizeof(float);
+	const size_t array_bytes = NUM_ELEMENTS * sizeof(float);
+	enum piglit_result result = PIGLIT_PASS;
+	double duration = 0.5;
+	piglit_cl_context context;
+	cl_program program;
+	cl_mem buffers[3];
+	char *device_name;
+	char options[64];
+	const char *arg;
+	unsigned w, i;
+
+	arg = piglit_cl_get_arg_value(argc, argv, "duration");
+	if (arg)
+		duration = atof(arg);
+
+	context = piglit_cl_create_context(env->platform_id, &env->device_id, 1);
+	if (!context)
+		return PIGLIT_FAIL;
+
+	snprintf(options, sizeof(options), "-DLOCAL_SIZE=%u -DTILE=%u",
+		 LOCAL_SIZE, TILE);
+	program = piglit_cl_build_program_with_source(context, 1, &source,
+						      options);
+	if (!program) {
+		piglit_cl_release_context(context);
+		return PIGLIT_FAIL;
+	}
+
+	device_name = piglit_cl_get_device_info(env->device_id, CL_DEVICE_NAME);
+	cur_queue = context->command_queues[0];
+
+	printf("Device: %s\n", device_name);
+	for (w = 0; w < NUM_WORKLOADS && result == PIGLIT_PASS; w++) {
+		struct perf_stats stats;
+		char name[256];
+		double rate;
+
+		/* Inputs, then outputs. */
+		if (w == WORKLOAD_SGEMM) {
+			for (i = 0; i < 3; i++)
+				buffers[i] = create_zeroed_buffer(context,
+								  matrix_bytes);
+		} else {
+			buffers[0] = create_zeroed_buffer(context, array_bytes);
+			buffers[1] = create_zeroed_buffer(context, array_bytes);
+			buffers[2] = create_zeroed_buffer(context, array_bytes /
+								   LOCAL_SIZE);
+		}
+
+		cur_workload = w;
+		cur_kernel = piglit_cl_create_kernel(program,
+						     workloads[w].name);
+		if (!buffers[0] || !buffers[1] || !buffers[2] || !cur_kernel ||
+		    !set_args(w, cur_kernel, buffers)) {
+			result = PIGLIT_FAIL;
+		} else {
+			rate = perf_measure_rate(run, duration, &stats);
+			if (launch_failed) {
+				result = PIGLIT_FAIL;
+			} else {
+				printf("  %-8s, %10.2f %s\n", workloads[w].name,
+				       rate * workloads[w].work,
+				       workloads[w].unit);
+				fflush(stdout);
+
+				snprintf(name, sizeof(name), "%s %s",
+					 device_name, workloads[w].name);
+				perf_report("cl-compute", name,
+					    workloads[w].unit,
+					    workloads[w].work, &stats);
+			}
+		}
+
+		if (cur_kernel)
+			clReleaseKernel(cur_kernel);
+		for (i = 0; i < 3; i++) {
+			if (buffers[i])
+				clReleaseMemObject(buffers[i]);
+		}
+	}
+
+	free(device_name);
+	clReleaseProgram(program);
+	piglit_cl_release_context(context);
+
+	return result;
+}
@@ -0,0 +1,509 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the rate of handoffs of a GL buffer or texture between an
+ * OpenGL ES 3.0 context and an OpenCL context sharing it through
+ * cl_khr_gl_sharing.  In each handoff GL writes to the object, then a CL
+ * kernel writes all of it, then GL may use it again:
+ *
+ *  - finish: glFinish(), clEnqueueAcquireGLObjects(), the kernel,
+ *    clEnqueueReleaseGLObjects() and clFinish()
+ *  - event: the same, with the acquire waiting for a CL event created from
+ *    a GL fence (cl_khr_gl_event) instead of glFinish(), and
+ *    clWaitForEvents() on the event of the release instead of clFinish()
+ *  - copy: no sharing; GL reads the object back, it is written to a CL
+ *    buffer or image, then after the kernel read back and uploaded to GL
+ *
+ * The event columns are "-" without cl_khr_gl_event, the texture rows are
+ * "-" without image support.
+ *
+ * Usage: cl-gl-interop [-duration SECONDS]
+ */
+
+#include "piglit-framework-cl-custom.h"
+#include "piglit-util-egl.h"
+#include "piglit-util-gl.h"
+#include "report.h"
+
+PIGLIT_CL_CUSTOM_TEST_CONFIG_BEGIN
+
+	config.name = "CL/GL interop handoff";
+	config.run_per_device = true;
+
+PIGLIT_CL_CUSTOM_TEST_CONFIG_END
+
+enum sync_mode {
+	SYNC_FINISH,
+	SYNC_EVENT,
+	SYNC_COPY,
+	NUM_SYNC_MODES
+};
+
+static const char *sync_names[NUM_SYNC_MODES] = {
+	"finish",
+	"event",
+	"copy",
+};
+
+/* Objects of RGBA8 texels or uints, as many bytes for both kinds. */
+static const struct object {
+	const char *name;
+	bool texture;
+	unsigned width, height;
+} objects[] = {
+	{ "buffer 64K",        false, 16384,   1 },
+	{ "buffer 1M",         false, 262144,  1 },
+	{ "buffer 16M",        false, 4194304, 1 },
+	{ "texture 128x128",   true,  128,     128 },
+	{ "texture 512x512",   true,  512,     512 },
+	{ "texture 2048x2048", true,  2048,    2048 },
+};
+
+static char *source =
+	"kernel void touch_buffer(global uint *data) {\n"
+	"	data[get_global_id(0)] += 1;\n"
+	"}\n"
+	"kernel void touch_image(write_only image2d_t img) {\n"
+	"	write_imagef(img, (int2)(get_global_id(0), get_global_id(1)),\n"
+	"		     (float4)(0.5f));\n"
+	"}\n";
+
+static cl_event (CL_API_CALL *pclCreateEventFromGLsyncKHR)(cl_context context,
+							   cl_GLsync sync,
+							   cl_int *errcode_ret);
+
+static double duration = 0.5;
+
+static cl_context context;
+static cl_command_queue queue;
+static cl_kernel buffer_kernel, image_kernel;
+static GLuint fbo;
+static bool failed;
+
+/* The case being measured. */
+static const struct object *cur_object;
+static enum sync_mode cur_mode;
+static cl_mem cur_mem;
+static void *cur_staging;
+
+static bool
+init_gl(EGLDisplay *out_dpy, EGLContext *out_ctx)
+{
+	static const EGLint config_attribs[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR,
+		EGL_NONE,
+	};
+	static const EGLint context_attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 3,
+		EGL_NONE,
+	};
+	EGLDisplay dpy;
+	EGLConfig config = 0;
+	EGLint num_configs = 0;
+	EGLContext ctx;
+
+	dpy = piglit_egl_get_default_display(EGL_NONE);
+	if (!dpy || !eglInitialize(dpy, NULL, NULL))
+		return false;
+
+	if (!eglChooseConfig(dpy, config_attribs, &config, 1, &num_configs) ||
+	    num_configs == 0 || !piglit_egl_bind_api(EGL_OPENGL_ES_API)) {
+		eglTerminate(dpy);
+		return false;
+	}
+
+	ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+	if (!ctx) {
+		eglTerminate(dpy);
+		return false;
+	}
+	if (!eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+		eglDestroyContext(dpy, ctx);
+		eglTerminate(dpy);
+		return false;
+	}
+
+	piglit_dispatch_default_init(PIGLIT_DISPATCH_ES2);
+
+	*out_dpy = dpy;
+	*out_ctx = ctx;
+	return true;
+}
+
+static void
+check(cl_int err)
+{
+	if (!piglit_cl_check_error(err, CL_SUCCESS))
+		failed = true;
+}
+
+static size_t
+object_size(const struct object *obj)
+{
+	return (size_t)obj->width * obj->height * 4;
+}
+
+/* GL writes the first texel or element. */
+static void
+gl_produce(void)
+{
+	static const GLuint value = 0xffffffff;
+
+	if (cur_object->texture)
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA,
+				GL_UNSIGNED_BYTE, &value);
+	else
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(value), &value);
+}
+
+static void
+run_kernel(void)
+{
+	const size_t global_size[2] = { cur_object->width, cur_object->height };
+	cl_kernel kernel = cur_object->texture ? image_kernel : buffer_kernel;
+
+	check(clSetKernelArg(kernel, 0, sizeof(cl_mem), &cur_mem));
+	check(clEnqueueNDRangeKernel(queue, kernel,
+				     cur_object->texture ? 2 : 1, NULL,
+				     global_size, NULL, 0, NULL, NULL));
+}
+
+static void
+handoff_finish(void)
+{
+	gl_produce();
+	glFinish();
+
+	check(clEnqueueAcquireGLObjects(queue, 1, &cur_mem, 0, NULL, NULL));
+	run_kernel();
+	check(clEnqueueReleaseGLObjects(queue, 1, &cur_mem, 0, NULL, NULL));
+	check(clFinish(queue));
+}
+
+static void
+handoff_event(void)
+{
+	cl_event gl_done, cl_done;
+	GLsync sync;
+	cl_int err;
+
+	gl_produce();
+	sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+
+	gl_done = pclCreateEventFromGLsyncKHR(context, (cl_GLsync)sync, &err);
+	check(err);
+	if (failed) {
+		glDeleteSync(sync);
+		return;
+	}
+
+	check(clEnqueueAcquireGLObjects(queue, 1, &cur_mem, 1, &gl_done,
+					NULL));
+	run_kernel();
+	check(clEnqueueReleaseGLObjects(queue, 1, &cur_mem, 0, NULL,
+					&cl_done));
+	if (!failed) {
+		check(clWaitForEvents(1, &cl_done));
+		clReleaseEvent(cl_done);
+	}
+
+	clReleaseEvent(gl_done);
+	glDeleteSync(sync);
+}
+
+static void
+handoff_copy(void)
+{
+	const size_t size = object_size(cur_object);
+	const size_t origin[3] = { 0, 0, 0 };
+	const size_t region[3] = { cur_object->width, cur_object->height, 1 };
+	void *map;
+
+	gl_produce();
+
+	if (cur_object->texture) {
+		glReadPixels(0, 0, cur_object->width, cur_object->height,
+			     GL_RGBA, GL_UNSIGNED_BYTE, cur_staging);
+		check(clEnqueueWriteImage(queue, cur_mem, CL_FALSE, origin,
+					  region, 0, 0, cur_staging, 0, NULL,
+					  NULL));
+		run_kernel();
+		check(clEnqueueReadImage(queue, cur_mem, CL_TRUE, origin,
+					 region, 0, 0, cur_staging, 0, NULL,
+					 NULL));
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cur_object->width,
+				cur_object->height, GL_RGBA, GL_UNSIGNED_BYTE,
+				cur_staging);
+	} else {
+		map = glMapBufferRange(GL_ARRAY_BUFFER, 0, size,
+				       GL_MAP_READ_BIT);
+		if (!map) {
+			failed = true;
+			return;
+		}
+		check(clEnqueueWriteBuffer(queue, cur_mem, CL_TRUE, 0, size,
+					   map, 0, NULL, NULL));
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		run_kernel();
+		check(clEnqueueReadBuffer(queue, cur_mem, CL_TRUE, 0, size,
+					  cur_staging, 0, NULL, NULL));
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, cur_staging);
+	}
+}
+
+static double
+handoffs(unsigned count)
+{
+	int64_t start = piglit_time_get_nano();
+	unsigned i;
+
+	for (i = 0; i < count && !failed; i++) {
+		switch (cur_mode) {
+		case SYNC_FINISH:
+			handoff_finish();
+			break;
+		case SYNC_EVENT:
+			handoff_event();
+			break;
+		case SYNC_COPY:
+			handoff_copy();
+			break;
+		case NUM_SYNC_MODES:
+			break;
+		}
+	}
+	glFinish();
+
+	return (piglit_time_get_nano() - start) * 0.000000001;
+}
+
+/* Create the GL object, and the CL object sharing it or copied to. */
+static GLuint
+create_objects(const struct object *obj, enum sync_mode mode)
+{
+	const cl_image_format format = { CL_RGBA, CL_UNORM_INT8 };
+	cl_image_desc desc = {
+		.image_type = CL_MEM_OBJECT_IMAGE2D,
+		.image_width = obj->width,
+		.image_height = obj->height,
+	};
+	GLuint name;
+	cl_int err;
+
+	if (obj->texture) {
+		glGenTextures(1, &name);
+		glBindTexture(GL_TEXTURE_2D, name);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, obj->width,
+			       obj->height);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				       GL_TEXTURE_2D, name, 0);
+	} else {
+		glGenBuffers(1, &name);
+		glBindBuffer(GL_ARRAY_BUFFER, name);
+		glBufferData(GL_ARRAY_BUFFER, object_size(obj), NULL,
+			     GL_DYNAMIC_DRAW);
+	}
+
+	cur_staging = NULL;
+	if (mode != SYNC_COPY) {
+		if (obj->texture)
+			cur_mem = clCreateFromGLTexture(context,
+							CL_MEM_READ_WRITE,
+							GL_TEXTURE_2D, 0,
+							name, &err);
+		else
+			cur_mem = clCreateFromGLBuffer(context,
+						       CL_MEM_READ_WRITE,
+						       name, &err);
+	} else {
+		if (obj->texture)
+			cur_mem = clCreateImage(context, CL_MEM_READ_WRITE,
+						&format, &desc, NULL, &err);
+		else
+			cur_mem = clCreateBuffer(context, CL_MEM_READ_WRITE,
+						 object_size(obj), NULL,
+						 &err);
+		cur_staging = malloc(object_size(obj));
+	}
+	check(err);
+
+	return name;
+}
+
+static void
+destroy_objects(const struct object *obj, GLuint name)
+{
+	if (cur_mem)
+		clReleaseMemObject(cur_mem);
+	cur_mem = NULL;
+	free(cur_staging);
+
+	if (obj->texture)
+		glDeleteTextures(1, &name);
+	else
+		glDeleteBuffers(1, &name);
+}
+
+enum piglit_result
+piglit_cl_test(const int argc,
+	       const char **argv,
+	       const struct piglit_cl_custom_test_config *config,
+	       const struct piglit_cl_custom_test_env *env)
+{
+	cl_context_properties props[] = {
+		CL_GL_CONTEXT_KHR, 0,
+		CL_EGL_DISPLAY_KHR, 0,
+		CL_CONTEXT_PLATFORM, (cl_context_properties)env->platform_id,
+		0
+	};
+	cl_bool *image_support;
+	bool event_support;
+	char *device_name;
+	cl_program program;
+	EGLDisplay dpy;
+	EGLContext ctx;
+	const char *arg;
+	unsigned o, mode;
+	cl_int err;
+
+	arg = piglit_cl_get_arg_value(argc, argv, "duration");
+	if (arg)
+		duration = atof(arg);
+
+	if (!piglit_cl_is_device_extension_supported(env->device_id,
+						     "cl_khr_gl_sharing")) {
+		printf("cl_khr_gl_sharing not supported\n");
+		return PIGLIT_SKIP;
+	}
+	if (!init_gl(&dpy, &ctx)) {
+		printf("Could not create an OpenGL ES 3.0 context\n");
+		return PIGLIT_SKIP;
+	}
+
+	props[1] = (cl_context_properties)ctx;
+	props[3] = (cl_context_properties)dpy;
+	context = clCreateContext(props, 1, &env->device_id, NULL, NULL, &err);
+	if (err != CL_SUCCESS) {
+		printf("Could not create a CL context sharing the GL context: %s\n",
+		       piglit_cl_get_error_name(err));
+		eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE,
+			       EGL_NO_CONTEXT);
+		eglDestroyContext(dpy, ctx);
+		eglTerminate(dpy);
+		return PIGLIT_SKIP;
+	}
+	queue = clCreateCommandQueue(context, env->device_id, 0, &err);
+	check(err);
+
+	program = clCreateProgramWithSource(context, 1,
+					    (const char **)&source, NULL,
+					    &err);
+	check(err);
+	if (!failed)
+		check(clBuildProgram(program, 1, &env->device_id, "", NULL,
+				     NULL));
+	if (!failed) {
+		buffer_kernel = clCreateKernel(program, "touch_buffer", &err);
+		check(err);
+		image_kernel = clCreateKernel(program, "touch_image", &err);
+		check(err);
+	}
+
+	pclCreateEventFromGLsyncKHR =
+		clGetExtensionFunctionAddressForPlatform(env->platform_id,
+							 "clCreateEventFromGLsyncKHR");
+	event_support = pclCreateEventFromGLsyncKHR != NULL &&
+		piglit_cl_is_device_extension_supported(env->device_id,
+							"cl_khr_gl_event");
+	image_support = piglit_cl_get_device_info(env->device_id,
+						  CL_DEVICE_IMAGE_SUPPORT);
+	device_name = piglit_cl_get_device_info(env->device_id,
+						CL_DEVICE_NAME);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+	printf("Device: %s\n", device_name);
+	printf("  %-18s", "Object");
+	for (mode = 0; mode < NUM_SYNC_MODES; mode++)
+		printf(", %10s", sync_names[mode]);
+	printf("   (handoffs/sec)\n");
+
+	for (o = 0; o < ARRAY_SIZE(objects) && !failed; o++) {
+		cur_object = &objects[o];
+		printf("  %-18s", cur_object->name);
+
+		for (mode = 0; mode < NUM_SYNC_MODES && !failed; mode++) {
+			struct perf_stats stats;
+			char name[256];
+			GLuint gl_object;
+			double rate = 0;
+
+			if ((mode == SYNC_EVENT && !event_support) ||
+			    (cur_object->texture && !*image_support)) {
+				printf(", %10s", "-");
+				continue;
+			}
+
+			cur_mode = mode;
+			gl_object = create_objects(cur_object, mode);
+			if (!failed)
+				rate = perf_measure_rate(handoffs, duration,
+							 &stats);
+			destroy_objects(cur_object, gl_object);
+
+			if (!piglit_check_gl_error(GL_NO_ERROR))
+				failed = true;
+			if (failed)
+				break;
+
+			printf(", %10.0f", rate);
+			fflush(stdout);
+
+			snprintf(name, sizeof(name), "%s %s %s", device_name,
+				 cur_object->name, sync_names[mode]);
+			perf_report("cl-gl-interop", name, "handoffs/sec", 1,
+				    &stats);
+		}
+		printf("\n");
+	}
+
+	glDeleteFramebuffers(1, &fbo);
+	free(device_name);
+	free(image_support);
+	if (image_kernel)
+		clReleaseKernel(image_kernel);
+	if (buffer_kernel)
+		clReleaseKernel(buffer_kernel);
+	clReleaseProgram(program);
+	clReleaseCommandQueue(queue);
+	clReleaseContext(context);
+
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(dpy, ctx);
+	eglTerminate(dpy);
+
+	return failed ? PIGLIT_FAIL : PIGLIT_PASS;
+}
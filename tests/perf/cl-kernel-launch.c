@@ -0,0 +1,304 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the launch path of an empty OpenCL kernel with a single work
+ * item, on an in-order and an out-of-order command queue:
+ *
+ *  - submit: the rate of clEnqueueNDRangeKernel() calls, without the
+ *    clFinish() after them
+ *  - throughput: the rate of kernels enqueued and run, up to clFinish()
+ *  - chain: the same, with each kernel waiting for the event of the
+ *    previous one in its event wait list
+ *  - finish: the latency of enqueueing a kernel and waiting for it with
+ *    clFinish()
+ *  - event-wait: the same, waiting with clWaitForEvents() on its event
+ *
+ * The out-of-order rows are "-" when the device doesn't support
+ * CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE.  The median, 99th percentile and
+ * maximum of the latencies are printed in microseconds.
+ *
+ * Usage: cl-kernel-launch [-duration SECONDS] [-samples N]
+ */
+
+#include "piglit-framework-cl-custom.h"
+#include "report.h"
+
+PIGLIT_CL_CUSTOM_TEST_CONFIG_BEGIN
+
+	config.name = "Kernel launch overhead";
+	config.run_per_device = true;
+
+PIGLIT_CL_CUSTOM_TEST_CONFIG_END
+
+/* Iterations run before the latency samples are taken. */
+#define WARMUP 16
+
+enum queue_mode {
+	QUEUE_IN_ORDER,
+	QUEUE_OUT_OF_ORDER,
+	NUM_QUEUE_MODES
+};
+
+static const char *queue_names[NUM_QUEUE_MODES] = {
+	"in-order",
+	"out-of-order",
+};
+
+static char *source = "kernel void empty() {}\n";
+
+static double duration = 0.5;
+static unsigned num_samples = 1000;
+
+static cl_kernel kernel;
+static char *device_name;
+static bool launch_failed;
+
+/* The queue being measured. */
+static cl_command_queue cur_queue;
+
+static void
+enqueue(cl_uint num_events, const cl_event *wait_list, cl_event *event)
+{
+	const size_t global_size = 1;
+	cl_int err;
+
+	err = clEnqueueNDRangeKernel(cur_queue, kernel, 1, NULL, &global_size,
+				     NULL, num_events, wait_list, event);
+	if (!piglit_cl_check_error(err, CL_SUCCESS))
+		launch_failed = true;
+}
+
+static double
+submit(unsigned count)
+{
+	int64_t start, end;
+	unsigned i;
+
+	start = piglit_time_get_nano();
+	for (i = 0; i < count && !launch_failed; i++)
+		enqueue(0, NULL, NULL);
+	end = piglit_time_get_nano();
+	clFinish(cur_queue);
+
+	return (end - start) * 0.000000001;
+}
+
+static double
+throughput(unsigned count)
+{
+	int64_t start = piglit_time_get_nano();
+	unsigned i;
+
+	for (i = 0; i < count && !launch_failed; i++)
+		enqueue(0, NULL, NULL);
+	clFinish(cur_queue);
+
+	return (piglit_time_get_nano() - start) * 0.000000001;
+}
+
+static double
+chain(unsigned count)
+{
+	int64_t start = piglit_time_get_nano();
+	cl_event prev = NULL, event;
+	double t;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		enqueue(prev ? 1 : 0, prev ? &prev : NULL, &event);
+		if (launch_failed)
+			break;
+		if (prev)
+			clReleaseEvent(prev);
+		prev = event;
+	}
+	clFinish(cur_queue);
+	t = (piglit_time_get_nano() - start) * 0.000000001;
+
+	if (prev)
+		clReleaseEvent(prev);
+	return t;
+}
+
+static void
+measure_latency(bool event_wait, int64_t *samples)
+{
+	unsigned i;
+
+	for (i = 0; i < WARMUP + num_samples; i++) {
+		int64_t start = piglit_time_get_nano();
+		cl_event event;
+
+		if (event_wait) {
+			enqueue(0, NULL, &event);
+			if (launch_failed)
+				return;
+			clWaitForEvents(1, &event);
+		} else {
+			enqueue(0, NULL, NULL);
+			clFinish(cur_queue);
+		}
+
+		if (i >= WARMUP)
+			samples[i - WARMUP] = piglit_time_get_nano() - start;
+		if (event_wait)
+			clReleaseEvent(event);
+	}
+}
+
+static void
+print_rates(enum queue_mode mode)
+{
+	static const perf_time_func funcs[] = { submit, throughput, chain };
+	static const char *names[] = { "submit", "throughput", "chain" };
+	unsigned i;
+
+	printf("  %-12s", queue_names[mode]);
+	for (i = 0; i < ARRAY_SIZE(funcs); i++) {
+		struct perf_stats stats;
+		char name[256];
+		double rate;
+
+		if (!cur_queue) {
+			printf(", %12s", "-");
+			continue;
+		}
+
+		rate = perf_measure_rate(funcs[i], duration, &stats);
+		if (launch_failed)
+			return;
+		printf(", %12.0f", rate);
+		fflush(stdout);
+
+		snprintf(name, sizeof(name), "%s %s %s", device_name,
+			 queue_names[mode], names[i]);
+		perf_report("cl-kernel-launch", name, "kernels/sec", 1, &stats);
+	}
+	printf("\n");
+}
+
+static void
+print_latencies(enum queue_mode mode, int64_t *samples)
+{
+	static const char *names[] = { "finish", "event-wait" };
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		struct perf_latency latency;
+		char name[256];
+
+		printf("  %-12s, %-10s", queue_names[mode], names[i]);
+		if (!cur_queue) {
+			printf(", %10s, %10s, %10s\n", "-", "-", "-");
+			continue;
+		}
+
+		measure_latency(i == 1, samples);
+		if (launch_failed)
+			return;
+
+		snprintf(name, sizeof(name), "%s %s %s", device_name,
+			 queue_names[mode], names[i]);
+		perf_report_latency("cl-kernel-launch", name, samples,
+				    num_samples, &latency);
+		printf(", %10.1f, %10.1f, %10.1f\n", latency.p50, latency.p99,
+		       latency.max);
+	}
+}
+
+enum piglit_result
+piglit_cl_test(const int argc,
+	       const char **argv,
+	       const struct piglit_cl_custom_test_config *config,
+	       const struct piglit_cl_custom_test_env *env)
+{
+	cl_command_queue queues[NUM_QUEUE_MODES] = { NULL };
+	cl_command_queue_properties *props;
+	piglit_cl_context context;
+	cl_program program;
+	const char *arg;
+	int64_t *samples;
+	unsigned mode;
+	cl_int err;
+
+	arg = piglit_cl_get_arg_value(argc, argv, "duration");
+	if (arg)
+		duration = atof(arg);
+	arg = piglit_cl_get_arg_value(argc, argv, "samples");
+	if (arg)
+		num_samples = MAX2(atoi(arg), 1);
+
+	context = piglit_cl_create_context(env->platform_id, &env->device_id, 1);
+	if (!context)
+		return PIGLIT_FAIL;
+
+	program = piglit_cl_build_program_with_source(context, 1, &source, "");
+	if (!program) {
+		piglit_cl_release_context(context);
+		return PIGLIT_FAIL;
+	}
+	kernel = piglit_cl_create_kernel(program, "empty");
+
+	queues[QUEUE_IN_ORDER] = context->command_queues[0];
+	props = piglit_cl_get_device_info(env->device_id,
+					  CL_DEVICE_QUEUE_PROPERTIES);
+	if (*props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+		queues[QUEUE_OUT_OF_ORDER] =
+			clCreateCommandQueue(context->cl_ctx, env->device_id,
+					     CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+					     &err);
+		if (!piglit_cl_check_error(err, CL_SUCCESS))
+			launch_failed = true;
+	}
+	free(props);
+
+	device_name = piglit_cl_get_device_info(env->device_id,
+						CL_DEVICE_NAME);
+	samples = malloc(num_samples * sizeof(*samples));
+
+	printf("Device: %s\n", device_name);
+	printf("  %-12s, %12s, %12s, %12s   (kernels/sec)\n", "Queue",
+	       "submit", "throughput", "chain");
+	for (mode = 0; mode < NUM_QUEUE_MODES && !launch_failed; mode++) {
+		cur_queue = queues[mode];
+		print_rates(mode);
+	}
+
+	printf("  %-12s, %-10s, %10s, %10s, %10s\n", "Queue", "Wait",
+	       "p50 usec", "p99 usec", "max usec");
+	for (mode = 0; mode < NUM_QUEUE_MODES && !launch_failed; mode++) {
+		cur_queue = queues[mode];
+		print_latencies(mode, samples);
+	}
+
+	free(samples);
+	free(device_name);
+	if (queues[QUEUE_OUT_OF_ORDER])
+		clReleaseCommandQueue(queues[QUEUE_OUT_OF_ORDER]);
+	clReleaseKernel(kernel);
+	clReleaseProgram(program);
+	piglit_cl_release_context(context);
+
+	return launch_failed ? PIGLIT_FAIL : PIGLIT_PASS;
+}
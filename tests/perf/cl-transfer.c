@@ -0,0 +1,449 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the bandwidth of moving data between the application's memory
+ * and OpenCL memory objects, uploading and downloading, for sizes from
+ * 4 KiB to 64 MiB:
+ *
+ *  - read-write: clEnqueueWriteBuffer() and clEnqueueReadBuffer()
+ *  - map: mapping a buffer, copying to or from it and unmapping it
+ *  - use-host-ptr: the same with a CL_MEM_USE_HOST_PTR buffer of
+ *    page-aligned memory, which the driver may access without a copy
+ *  - alloc-host-ptr: the same with a CL_MEM_ALLOC_HOST_PTR buffer
+ *  - svm-coarse: the same with clEnqueueSVMMap() and clEnqueueSVMUnmap() of
+ *    coarse-grain SVM
+ *  - svm-fine: copying to or from fine-grain SVM, which needs no map
+ *  - sub-buffer: read-write through a sub-buffer at the device's base
+ *    address alignment into a larger buffer
+ *
+ * Each transfer waits for its completion.  The rows of the methods the
+ * device doesn't support, and of the sizes over CL_DEVICE_MAX_MEM_ALLOC_SIZE,
+ * are "-".  The latencies of the smallest size are printed in microseconds.
+ *
+ * Usage: cl-transfer [-duration SECONDS] [-samples N]
+ */
+
+#include "piglit-framework-cl-custom.h"
+#include "report.h"
+
+PIGLIT_CL_CUSTOM_TEST_CONFIG_BEGIN
+
+	config.name = "Memory transfer bandwidth";
+	config.run_per_device = true;
+
+PIGLIT_CL_CUSTOM_TEST_CONFIG_END
+
+/* Iterations run before the latency samples are taken. */
+#define WARMUP 16
+#define PAGE_SIZE 4096
+
+enum method {
+	METHOD_READ_WRITE,
+	METHOD_MAP,
+	METHOD_USE_HOST_PTR,
+	METHOD_ALLOC_HOST_PTR,
+	METHOD_SVM_COARSE,
+	METHOD_SVM_FINE,
+	METHOD_SUB_BUFFER,
+	NUM_METHODS
+};
+
+static const char *method_names[NUM_METHODS] = {
+	"read-write",
+	"map",
+	"use-host-ptr",
+	"alloc-host-ptr",
+	"svm-coarse",
+	"svm-fine",
+	"sub-buffer",
+};
+
+static const size_t sizes[] = {
+	4 << 10, 64 << 10, 1 << 20, 16 << 20, 64 << 20
+};
+
+#define MAX_SIZE (64 << 20)
+
+static double duration = 0.5;
+static unsigned num_samples = 1000;
+
+static piglit_cl_context context;
+static char *device_name;
+static bool transfer_failed;
+
+/* The application's data, and the page-aligned memory of the
+ * CL_MEM_USE_HOST_PTR buffers within host_alloc.
+ */
+static char *data, *host_alloc, *host_ptr;
+
+/* The case being measured. */
+static enum method cur_method;
+static bool cur_upload;
+static size_t cur_size;
+static cl_mem cur_mem, cur_parent;
+static void *cur_svm;
+
+static bool
+check(cl_int err)
+{
+	if (!piglit_cl_check_error(err, CL_SUCCESS)) {
+		transfer_failed = true;
+		return false;
+	}
+	return true;
+}
+
+static bool
+method_supported(enum method method, const struct piglit_cl_custom_test_env *env)
+{
+	switch (method) {
+	case METHOD_SVM_COARSE:
+	case METHOD_SVM_FINE: {
+#ifdef CL_VERSION_2_0
+		cl_device_svm_capabilities *caps;
+		bool supported;
+
+		if (env->version < 20)
+			return false;
+
+		caps = piglit_cl_get_device_info(env->device_id,
+						 CL_DEVICE_SVM_CAPABILITIES);
+		supported = *caps & (method == METHOD_SVM_COARSE ?
+				     CL_DEVICE_SVM_COARSE_GRAIN_BUFFER :
+				     CL_DEVICE_SVM_FINE_GRAIN_BUFFER);
+		free(caps);
+		return supported;
+#else //CL_VERSION_2_0
+		return false;
+#endif //CL_VERSION_2_0
+	}
+	case METHOD_SUB_BUFFER:
+		return env->version >= 11;
+	default:
+		return true;
+	}
+}
+
+/**
+ * Create the memory object of cur_method for cur_size, with the sub-buffer
+ * starting at align bytes.
+ */
+static bool
+create_memory(size_t align)
+{
+	static const cl_mem_flags flags[NUM_METHODS] = {
+		[METHOD_READ_WRITE] = CL_MEM_READ_WRITE,
+		[METHOD_MAP] = CL_MEM_READ_WRITE,
+		[METHOD_USE_HOST_PTR] = CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR,
+		[METHOD_ALLOC_HOST_PTR] = CL_MEM_READ_WRITE |
+					  CL_MEM_ALLOC_HOST_PTR,
+		[METHOD_SUB_BUFFER] = CL_MEM_READ_WRITE,
+	};
+	cl_int err;
+
+	switch (cur_method) {
+	case METHOD_SVM_COARSE:
+	case METHOD_SVM_FINE:
+#ifdef CL_VERSION_2_0
+		cur_svm = clSVMAlloc(context->cl_ctx,
+				     cur_method == METHOD_SVM_FINE ?
+				     CL_MEM_READ_WRITE |
+				     CL_MEM_SVM_FINE_GRAIN_BUFFER :
+				     CL_MEM_READ_WRITE, cur_size, 0);
+#endif //CL_VERSION_2_0
+		return cur_svm != NULL;
+	case METHOD_SUB_BUFFER: {
+		cl_buffer_region region = { align, cur_size };
+
+		cur_parent = clCreateBuffer(context->cl_ctx, flags[cur_method],
+					    align + cur_size, NULL, &err);
+		if (err != CL_SUCCESS)
+			return false;
+		cur_mem = clCreateSubBuffer(cur_parent, CL_MEM_READ_WRITE,
+					    CL_BUFFER_CREATE_TYPE_REGION,
+					    &region, &err);
+		return check(err);
+	}
+	default:
+		cur_mem = clCreateBuffer(context->cl_ctx, flags[cur_method],
+					 cur_size,
+					 cur_method == METHOD_USE_HOST_PTR ?
+					 host_ptr : NULL, &err);
+		return err == CL_SUCCESS;
+	}
+}
+
+static void
+release_memory(void)
+{
+	if (cur_mem)
+		clReleaseMemObject(cur_mem);
+	if (cur_parent)
+		clReleaseMemObject(cur_parent);
+#ifdef CL_VERSION_2_0
+	if (cur_svm)
+		clSVMFree(context->cl_ctx, cur_svm);
+#endif //CL_VERSION_2_0
+	cur_mem = cur_parent = NULL;
+	cur_svm = NULL;
+}
+
+static void
+copy(void *ptr)
+{
+	if (cur_upload)
+		memcpy(ptr, data, cur_size);
+	else
+		memcpy(data, ptr, cur_size);
+}
+
+/** Move cur_size bytes of data in the cur_upload direction, and wait. */
+static void
+transfer(void)
+{
+	cl_command_queue queue = context->command_queues[0];
+	cl_int err;
+	void *ptr;
+
+	switch (cur_method) {
+	case METHOD_READ_WRITE:
+	case METHOD_SUB_BUFFER:
+		if (cur_upload)
+			err = clEnqueueWriteBuffer(queue, cur_mem, CL_TRUE, 0,
+						   cur_size, data, 0, NULL,
+						   NULL);
+		else
+			err = clEnqueueReadBuffer(queue, cur_mem, CL_TRUE, 0,
+						  cur_size, data, 0, NULL,
+						  NULL);
+		check(err);
+		break;
+	case METHOD_MAP:
+	case METHOD_USE_HOST_PTR:
+	case METHOD_ALLOC_HOST_PTR:
+		ptr = clEnqueueMapBuffer(queue, cur_mem, CL_TRUE,
+					 cur_upload ? CL_MAP_WRITE : CL_MAP_READ,
+					 0, cur_size, 0, NULL, NULL, &err);
+		if (!check(err))
+			break;
+		copy(ptr);
+		check(clEnqueueUnmapMemObject(queue, cur_mem, ptr, 0, NULL,
+					      NULL));
+		check(clFinish(queue));
+		break;
+	case METHOD_SVM_COARSE:
+#ifdef CL_VERSION_2_0
+		err = clEnqueueSVMMap(queue, CL_TRUE,
+				      cur_upload ? CL_MAP_WRITE : CL_MAP_READ,
+				      cur_svm, cur_size, 0, NULL, NULL);
+		if (!check(err))
+			break;
+		copy(cur_svm);
+		check(clEnqueueSVMUnmap(queue, cur_svm, 0, NULL, NULL));
+		check(clFinish(queue));
+#endif //CL_VERSION_2_0
+		break;
+	case METHOD_SVM_FINE:
+		copy(cur_svm);
+		break;
+	default:
+		assert(!"unknown method");
+	}
+}
+
+static double
+run(unsigned count)
+{
+	int64_t start = piglit_time_get_nano();
+	unsigned i;
+
+	for (i = 0; i < count && !transfer_failed; i++)
+		transfer();
+
+	return (piglit_time_get_nano() - start) * 0.000000001;
+}
+
+static void
+print_rates(const bool *supported, size_t max_alloc, size_t align)
+{
+	unsigned m, s;
+
+	printf("  %-14s, %-8s", "Method", "Dir");
+	for (s = 0; s < ARRAY_SIZE(sizes); s++)
+		printf(", %5zu KiB", sizes[s] >> 10);
+	printf("   (GB/s)\n");
+
+	for (m = 0; m < NUM_METHODS; m++) {
+		cur_method = m;
+
+		for (cur_upload = true;; cur_upload = false) {
+			printf("  %-14s, %-8s", method_names[m],
+			       cur_upload ? "upload" : "download");
+
+			for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+				struct perf_stats stats;
+				char name[256];
+				double rate;
+
+				cur_size = sizes[s];
+				if (!supported[m] || cur_size > max_alloc ||
+				    !create_memory(align)) {
+					release_memory();
+					printf(", %9s", "-");
+					continue;
+				}
+
+				rate = perf_measure_rate(run, duration, &stats);
+				release_memory();
+				if (transfer_failed)
+					return;
+
+				printf(", %9.2f", rate * cur_size / 1e9);
+				fflush(stdout);
+
+				snprintf(name, sizeof(name), "%s %s %s %zu",
+					 device_name, method_names[m],
+					 cur_upload ? "upload" : "download",
+					 cur_size);
+				perf_report("cl-transfer", name, "GB/sec",
+					    cur_size / 1e9, &stats);
+			}
+			printf("\n");
+
+			if (!cur_upload)
+				break;
+		}
+	}
+}
+
+static void
+print_latencies(const bool *supported, size_t align)
+{
+	int64_t *samples = malloc(num_samples * sizeof(*samples));
+	unsigned m, i;
+
+	printf("  %-14s, %-8s, %10s, %10s, %10s\n", "Method", "Dir",
+	       "p50 usec", "p99 usec", "max usec");
+
+	cur_size = sizes[0];
+	for (m = 0; m < NUM_METHODS && !transfer_failed; m++) {
+		cur_method = m;
+
+		for (cur_upload = true;; cur_upload = false) {
+			struct perf_latency latency;
+			char name[256];
+
+			printf("  %-14s, %-8s", method_names[m],
+			       cur_upload ? "upload" : "download");
+
+			if (!supported[m] || !create_memory(align)) {
+				release_memory();
+				printf(", %10s, %10s, %10s\n", "-", "-", "-");
+			} else {
+				for (i = 0; i < WARMUP + num_samples; i++) {
+					int64_t start = piglit_time_get_nano();
+
+					transfer();
+					if (i >= WARMUP)
+						samples[i - WARMUP] =
+							piglit_time_get_nano() -
+							start;
+				}
+				release_memory();
+				if (transfer_failed)
+					break;
+
+				snprintf(name, sizeof(name), "%s %s %s",
+					 device_name, method_names[m],
+					 cur_upload ? "upload" : "download");
+				perf_report_latency("cl-transfer", name,
+						    samples, num_samples,
+						    &latency);
+				printf(", %10.1f, %10.1f, %10.1f\n",
+				       latency.p50, latency.p99, latency.max);
+			}
+
+			if (!cur_upload)
+				break;
+		}
+	}
+
+	free(samples);
+}
+
+enum piglit_result
+piglit_cl_test(const int argc,
+	       const char **argv,
+	       const struct piglit_cl_custom_test_config *config,
+	       const struct piglit_cl_custom_test_env *env)
+{
+	bool supported[NUM_METHODS];
+	cl_ulong *max_alloc;
+	cl_uint *align_bits;
+	const char *arg;
+	size_t align;
+	unsigned m;
+
+	arg = piglit_cl_get_arg_value(argc, argv, "duration");
+	if (arg)
+		duration = atof(arg);
+	arg = piglit_cl_get_arg_value(argc, argv, "samples");
+	if (arg)
+		num_samples = MAX2(atoi(arg), 1);
+
+	context = piglit_cl_create_context(env->platform_id, &env->device_id, 1);
+	if (!context)
+		return PIGLIT_FAIL;
+
+	for (m = 0; m < NUM_METHODS; m++)
+		supported[m] = method_supported(m, env);
+
+	max_alloc = piglit_cl_get_device_info(env->device_id,
+					      CL_DEVICE_MAX_MEM_ALLOC_SIZE);
+	align_bits = piglit_cl_get_device_info(env->device_id,
+					       CL_DEVICE_MEM_BASE_ADDR_ALIGN);
+	align = *align_bits / 8;
+	device_name = piglit_cl_get_device_info(env->device_id,
+						CL_DEVICE_NAME);
+
+	/* The same bytes go back and forth, only their movement matters. */
+	data = calloc(MAX_SIZE, 1);
+	host_alloc = malloc(MAX_SIZE + PAGE_SIZE);
+	host_ptr = (char *)(((uintptr_t)host_alloc + PAGE_SIZE - 1) &
+			    ~(uintptr_t)(PAGE_SIZE - 1));
+
+	printf("Device: %s\n", device_name);
+	print_rates(supported, *max_alloc, align);
+	if (!transfer_failed)
+		print_latencies(supported, align);
+
+	free(host_alloc);
+	free(data);
+	free(device_name);
+	free(align_bits);
+	free(max_alloc);
+	piglit_cl_release_context(context);
+
+	return transfer_failed ? PIGLIT_FAIL : PIGLIT_PASS;
+}
@@ -22,16 +22,29 @@
 
 /**
  * Common perf code.  This should be re-usable with other tests.
+ *
+ * Each measurement finds its number of iterations, is warmed up until the
+ * clocks settle, then taken PIGLIT_PERF_REPEAT times (1 by default) and
+ * the median is returned.  The statistics and reporting, which don't need
+ * GL, are in report.c.  With PIGLIT_PERF_COUNTERS, the GPU counters of one
+ * more run of the measured iterations are reported with the measurement.
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "common.h"
 
+static struct perf_stats last_stats;
+
 /**
- * Return iterations/second for the duration.
+ * Return iterations/second for the duration, and the number of iterations
+ * it settled on.
  */
 static double
 measure_rate(perf_rate_func f, double duration, unsigned initial_iterations,
-	     double (*measure_time)(perf_rate_func f, unsigned iterations))
+	     double (*measure_time)(perf_rate_func f, unsigned iterations),
+	     unsigned *out_iterations)
 {
 	unsigned iterations = initial_iterations;
 
@@ -64,6 +77,7 @@ measure_rate(perf_rate_func f, double duration, unsigned initial_iterations,
 		}
 
 		/* Return iterations per second. */
+		*out_iterations = iterations;
 		return iterations / t;
 	}
 }
@@ -99,6 +113,176 @@ measure_gpu_time(perf_rate_func f, unsigned iterations)
 	return nsecs * 0.000000001;
 }
 
+/** Number of sub-batches perf_measure_gpu_timing() splits iterations in. */
+#define TIMING_SUB_BATCHES 64
+
+/**
+ * Number of sub-batches whose queries can be in flight at once.  The
+ * results of a slot are read back just before it is reused, so this is
+ * how far the CPU may run ahead of the GPU before the measurement starts
+ * waiting for it.
+ */
+#define TIMING_RING_SIZE 8
+
+struct timing_slot {
+	GLuint queries[2];
+	GLint64 submitted;
+	bool pending;
+};
+
+static void
+collect_timing_slot(struct timing_slot *slot, struct perf_timing *timing)
+{
+	GLuint64 start, end;
+
+	if (!slot->pending)
+		return;
+
+	glGetQueryObjectui64v(slot->queries[0], GL_QUERY_RESULT, &start);
+	glGetQueryObjectui64v(slot->queries[1], GL_QUERY_RESULT, &end);
+	timing->gpu_busy += (end - start) * 0.000000001;
+	timing->latency += ((GLint64)start - slot->submitted) * 0.000000001;
+	slot->pending = false;
+}
+
+/**
+ * Run f for iterations in sub-batches bracketed by GL_TIMESTAMP queries,
+ * and split the time it takes between the CPU and the GPU.
+ *
+ * Unlike a single GL_TIME_ELAPSED query around the whole run, this doesn't
+ * count the time the GPU sits idle waiting for the CPU as GPU time, so
+ * comparing gpu_busy and cpu_submit shows which side limits the rate.
+ */
+void
+perf_measure_gpu_timing(perf_rate_func f, unsigned iterations,
+			struct perf_timing *timing)
+{
+	struct timing_slot ring[TIMING_RING_SIZE];
+	unsigned sub_batch = MAX2(iterations / TIMING_SUB_BATCHES, 1);
+	unsigned i;
+
+	memset(timing, 0, sizeof(*timing));
+	memset(ring, 0, sizeof(ring));
+	for (i = 0; i < TIMING_RING_SIZE; i++)
+		glGenQueries(2, ring[i].queries);
+
+	/* Wake up power management, like the other measurements. */
+	f(sub_batch);
+	glFinish();
+
+	for (i = 0; i < TIMING_SUB_BATCHES; i++) {
+		struct timing_slot *slot = &ring[i % TIMING_RING_SIZE];
+		int64_t t0;
+
+		collect_timing_slot(slot, timing);
+
+		/* The GL time at which the commands so far have reached the
+		 * GL, which is where the sub-batch gets submitted.
+		 */
+		glGetInteger64v(GL_TIMESTAMP, &slot->submitted);
+
+		t0 = piglit_time_get_nano();
+		glQueryCounter(slot->queries[0], GL_TIMESTAMP);
+		f(sub_batch);
+		glQueryCounter(slot->queries[1], GL_TIMESTAMP);
+		glFlush();
+		timing->cpu_submit += (piglit_time_get_nano() - t0) * 0.000000001;
+		slot->pending = true;
+	}
+
+	for (i = 0; i < TIMING_RING_SIZE; i++) {
+		collect_timing_slot(&ring[i], timing);
+		glDeleteQueries(2, ring[i].queries);
+	}
+
+	timing->gpu_busy /= (double)sub_batch * TIMING_SUB_BATCHES;
+	timing->cpu_submit /= (double)sub_batch * TIMING_SUB_BATCHES;
+	timing->latency /= TIMING_SUB_BATCHES;
+}
+
+/**
+ * The statistics of the last perf_measure_cpu_rate() or
+ * perf_measure_gpu_rate() call.
+ */
+const struct perf_stats *
+perf_last_stats(void)
+{
+	return &last_stats;
+}
+
+struct warm_up_data {
+	perf_rate_func f;
+	unsigned iterations;
+	double (*measure_time)(perf_rate_func f, unsigned iterations);
+};
+
+static double
+warm_up_rate(void *data)
+{
+	struct warm_up_data *w = data;
+
+	return w->iterations / w->measure_time(w->f, w->iterations);
+}
+
+/**
+ * Run iterations once more between the GPU counters of PIGLIT_PERF_COUNTERS,
+ * apart from the timed samples, and attach their value per iteration to the
+ * next perf_report().
+ */
+static void
+count_iterations(perf_rate_func f, unsigned iterations)
+{
+	double values[PIGLIT_MAX_PERF_COUNTERS];
+	const struct piglit_perf_counter *counters;
+	unsigned count, i;
+
+	if (!piglit_perf_counters_begin())
+		return;
+	f(iterations);
+	glFinish();
+	piglit_perf_counters_end(values);
+
+	counters = piglit_perf_counters(&count);
+	for (i = 0; i < count; i++) {
+		bool percentage = strcmp(counters[i].unit, "%") == 0;
+
+		perf_report_counter(counters[i].name, counters[i].unit,
+				    percentage ? values[i] :
+				    values[i] / iterations);
+	}
+}
+
+static double
+measure_repeated(perf_rate_func f, double duration, unsigned initial_iterations,
+		 double (*measure_time)(perf_rate_func f, unsigned iterations))
+{
+	double samples[PERF_MAX_SAMPLES];
+	unsigned count = perf_repeat_count();
+	struct perf_conditions conditions;
+	struct warm_up_data warm_up;
+	unsigned iterations, i;
+	bool settled;
+
+	measure_rate(f, duration, initial_iterations, measure_time,
+		     &iterations);
+
+	warm_up.f = f;
+	warm_up.iterations = MAX2(iterations / 4, 1);
+	warm_up.measure_time = measure_time;
+	settled = perf_warm_up(warm_up_rate, &warm_up);
+
+	perf_conditions_begin(&conditions, settled);
+	for (i = 0; i < count; i++) {
+		samples[i] = iterations / measure_time(f, iterations);
+		perf_conditions_sample(&conditions);
+	}
+
+	perf_compute_stats(samples, count, &last_stats);
+	perf_conditions_end(&conditions, &last_stats);
+	count_iterations(f, iterations);
+	return last_stats.median;
+}
+
 /**
  * Return iterations/second for the duration.
  * Use a longer duration if you want more precision.
@@ -106,7 +290,7 @@ measure_gpu_time(perf_rate_func f, unsigned iterations)
 double
 perf_measure_cpu_rate(perf_rate_func f, double duration)
 {
-	return measure_rate(f, duration, 1, measure_cpu_time);
+	return measure_repeated(f, duration, 1, measure_cpu_time);
 }
 
 /**
@@ -116,7 +300,7 @@ perf_measure_cpu_rate(perf_rate_func f, double duration)
 double
 perf_measure_gpu_rate(perf_rate_func f, double duration)
 {
-	return measure_rate(f, duration, 5, measure_gpu_time);
+	return measure_repeated(f, duration, 5, measure_gpu_time);
 }
 
 GLuint
@@ -23,9 +23,32 @@
 #define COMMON_H
 
 #include "piglit-util-gl.h"
+#include "report.h"
 
 typedef void (*perf_rate_func)(unsigned count);
 
+/**
+ * Where the time of a measurement goes, per iteration, from GL_TIMESTAMP
+ * queries around each sub-batch.  Requires GL_ARB_timer_query.
+ */
+struct perf_timing {
+	/** Time the GPU spent executing the sub-batches. */
+	double gpu_busy;
+	/** Time the CPU spent in the calls submitting the sub-batches. */
+	double cpu_submit;
+	/** Time from submitting a sub-batch to the GPU starting it, averaged
+	 * over the sub-batches rather than per iteration.
+	 */
+	double latency;
+};
+
+void
+perf_measure_gpu_timing(perf_rate_func f, unsigned iterations,
+			struct perf_timing *timing);
+
+const struct perf_stats *
+perf_last_stats(void);
+
 double
 perf_measure_cpu_rate(perf_rate_func f, double minDuration);
 
@@ -0,0 +1,352 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * The compute counterpart of drawoverhead: measure how many single
+ * workgroup dispatches the driver can submit per second, with and without
+ * a state change between them.
+ *
+ * The shaders read all of their SSBOs and images, but only write when a
+ * uniform has a value it never has, so the GPU does next to nothing.
+ *
+ * Usage: computeoverhead [-test N] [-duration SECONDS] [-nocolor]
+ */
+
+#include "common.h"
+#include <stdbool.h>
+#include "piglit-util-gl.h"
+
+static bool color = true;
+static int selected_test_index = -1;
+static int duration = 1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 43;
+	config.supports_gl_core_version = 43;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-nocolor")) {
+			color = false;
+		} else if (!strcmp(argv[i], "-test") && i + 1 < argc) {
+			selected_test_index = atoi(argv[++i]);
+			printf("Running only test %d\n", selected_test_index);
+		} else if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "computeoverhead [-test N] "
+				"[-duration SECONDS] [-nocolor]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MAX_BINDINGS 8
+
+static unsigned num_ssbos;
+static unsigned num_images;
+
+static GLuint prog[2];
+static GLuint ssbo[MAX_BINDINGS * 2];
+static GLuint tex[MAX_BINDINGS * 2];
+static GLuint indirect_bo;
+static GLint uniform_loc;
+
+static void
+get_cs_text(char *s, unsigned num_ssbos, unsigned num_images, bool is_second)
+{
+	unsigned i;
+
+	strcpy(s, "#version 430\n"
+		  "layout(local_size_x = 1) in;\n"
+		  "uniform vec4 u;\n");
+	for (i = 0; i < num_ssbos; i++)
+		sprintf(s + strlen(s),
+			"layout(binding = %u) buffer sb%u { vec4 v%u[]; };\n",
+			i, i, i);
+	for (i = 0; i < num_images; i++)
+		sprintf(s + strlen(s),
+			"layout(binding = %u, rgba8) uniform image2D i%u;\n",
+			i, i);
+
+	strcat(s, "void main() {\n"
+		  "	vec4 sum = u");
+	for (i = 0; i < num_ssbos; i++)
+		sprintf(s + strlen(s), " + v%u[int(u.x)]", i);
+	for (i = 0; i < num_images; i++)
+		sprintf(s + strlen(s), " + imageLoad(i%u, ivec2(u.xy))", i);
+	if (is_second)
+		strcat(s, " + vec4(0.5)");
+	strcat(s, ";\n"
+		  "	if (u.w == 12345.0) {\n");
+	for (i = 0; i < num_ssbos; i++)
+		sprintf(s + strlen(s), "		v%u[0] = sum;\n", i);
+	for (i = 0; i < num_images; i++)
+		sprintf(s + strlen(s),
+			"		imageStore(i%u, ivec2(0), sum);\n", i);
+	strcat(s, "	}\n"
+		  "}\n");
+}
+
+static void
+setup_shaders_and_resources(void)
+{
+	char s[4096];
+	unsigned i;
+
+	glUseProgram(0);
+	for (i = 0; i < ARRAY_SIZE(prog); i++) {
+		if (prog[i])
+			glDeleteProgram(prog[i]);
+
+		get_cs_text(s, num_ssbos, num_images, i == 1);
+		prog[i] = piglit_build_simple_program_multiple_shaders(
+			GL_COMPUTE_SHADER, s, 0);
+	}
+	glUseProgram(prog[0]);
+	uniform_loc = glGetUniformLocation(prog[0], "u");
+
+	/* Twice as many objects as bindings, so that every change binds a
+	 * different one.
+	 */
+	for (i = 0; i < num_ssbos * 2; i++) {
+		if (!ssbo[i]) {
+			glGenBuffers(1, &ssbo[i]);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo[i]);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, 16 * 4, NULL,
+				     GL_STATIC_DRAW);
+		}
+	}
+	for (i = 0; i < num_ssbos; i++)
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, ssbo[i]);
+
+	for (i = 0; i < num_images * 2; i++) {
+		if (!tex[i]) {
+			glGenTextures(1, &tex[i]);
+			glBindTexture(GL_TEXTURE_2D, tex[i]);
+			glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, 4, 4);
+		}
+	}
+	for (i = 0; i < num_images; i++)
+		glBindImageTexture(i, tex[i], 0, false, 0, GL_READ_WRITE,
+				   GL_RGBA8);
+
+	if (!indirect_bo) {
+		static const GLuint groups[3] = {1, 1, 1};
+
+		glGenBuffers(1, &indirect_bo);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirect_bo);
+		glBufferData(GL_DISPATCH_INDIRECT_BUFFER, sizeof(groups),
+			     groups, GL_STATIC_DRAW);
+	}
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+}
+
+static void
+dispatch(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++)
+		glDispatchCompute(1, 1, 1);
+}
+
+static void
+dispatch_indirect(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++)
+		glDispatchComputeIndirect(0);
+}
+
+static void
+dispatch_shader_change(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		glUseProgram(prog[i & 1]);
+		glDispatchCompute(1, 1, 1);
+	}
+	glUseProgram(prog[0]);
+}
+
+static void
+dispatch_one_ssbo_change(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0,
+				 ssbo[(i & 1) * num_ssbos]);
+		glDispatchCompute(1, 1, 1);
+	}
+}
+
+static void
+dispatch_many_ssbo_change(unsigned count)
+{
+	unsigned i, j;
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < num_ssbos; j++) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, j,
+					 ssbo[(i & 1) * num_ssbos + j]);
+		}
+		glDispatchCompute(1, 1, 1);
+	}
+}
+
+static void
+dispatch_one_img_change(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		glBindImageTexture(0, tex[(i & 1) * num_images], 0, false, 0,
+				   GL_READ_WRITE, GL_RGBA8);
+		glDispatchCompute(1, 1, 1);
+	}
+}
+
+static void
+dispatch_many_img_change(unsigned count)
+{
+	unsigned i, j;
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < num_images; j++) {
+			glBindImageTexture(j, tex[(i & 1) * num_images + j],
+					   0, false, 0, GL_READ_WRITE,
+					   GL_RGBA8);
+		}
+		glDispatchCompute(1, 1, 1);
+	}
+}
+
+static void
+dispatch_uniform_change(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		glUniform4f(uniform_loc, i & 1, 0, 0, 0);
+		glDispatchCompute(1, 1, 1);
+	}
+}
+
+#define COLOR_RESET	"\033[0m"
+#define COLOR_RED	"\033[31m"
+#define COLOR_GREEN	"\033[1;32m"
+#define COLOR_YELLOW	"\033[1;33m"
+#define COLOR_CYAN	"\033[1;36m"
+
+static double
+perf_run(const char *call, const char *change, perf_rate_func f,
+	 double base_rate)
+{
+	static unsigned test_index;
+	test_index++;
+
+	if (selected_test_index != -1 && test_index != selected_test_index)
+		return 0;
+
+	setup_shaders_and_resources();
+
+	double rate = perf_measure_cpu_rate(f, duration);
+	double ratio = base_rate ? rate / base_rate : 1;
+
+	const char *ratio_color = base_rate == 0 ? COLOR_RESET :
+		ratio > 0.7 ? COLOR_GREEN :
+		ratio > 0.4 ? COLOR_YELLOW : COLOR_RED;
+
+	printf(" %3u, %-24s (%u SSBO| %u Img) w/ %s change,%*s"
+	       "%s%5u%s, %s%.1f%%%s\n",
+	       test_index, call, num_ssbos, num_images, change,
+	       MAX2(22 - (int)strlen(change), 0), "",
+	       color ? COLOR_CYAN : "",
+	       (unsigned)(rate / 1000),
+	       color ? COLOR_RESET : "",
+	       color ? ratio_color : "",
+	       100 * ratio,
+	       color ? COLOR_RESET : "");
+
+	char name[256];
+	snprintf(name, sizeof(name), "%u: %s (%u SSBO, %u Img) w/ %s",
+		 test_index, call, num_ssbos, num_images, change);
+	perf_report("computeoverhead", name, "dispatches/sec", 1,
+		    perf_last_stats());
+	return rate;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	piglit_require_extension("GL_ARB_compute_shader");
+	piglit_require_extension("GL_ARB_shader_storage_buffer_object");
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	double base_rate;
+
+	puts("   #, Test name                                              ,"
+	     "Thousands dispatches/s, Difference vs the 1st");
+
+	num_ssbos = 1;
+	num_images = 1;
+	base_rate = perf_run("DispatchCompute", "no state", dispatch, 0);
+	perf_run("DispatchComputeIndirect", "no state", dispatch_indirect,
+		 base_rate);
+
+	perf_run("DispatchCompute", "shader program", dispatch_shader_change,
+		 base_rate);
+	num_ssbos = MAX_BINDINGS;
+	num_images = MAX_BINDINGS;
+	perf_run("DispatchCompute", "shader program", dispatch_shader_change,
+		 base_rate);
+
+	num_images = 0;
+	num_ssbos = 1;
+	perf_run("DispatchCompute", "1/1 SSBO", dispatch_one_ssbo_change,
+		 base_rate);
+	num_ssbos = MAX_BINDINGS;
+	perf_run("DispatchCompute", "1/8 SSBO", dispatch_one_ssbo_change,
+		 base_rate);
+	perf_run("DispatchCompute", "8/8 SSBOs", dispatch_many_ssbo_change,
+		 base_rate);
+
+	num_ssbos = 0;
+	num_images = 1;
+	perf_run("DispatchCompute", "1/1 image", dispatch_one_img_change,
+		 base_rate);
+	num_images = MAX_BINDINGS;
+	perf_run("DispatchCompute", "1/8 image", dispatch_one_img_change,
+		 base_rate);
+	perf_run("DispatchCompute", "8/8 images", dispatch_many_img_change,
+		 base_rate);
+
+	num_ssbos = 1;
+	num_images = 1;
+	perf_run("DispatchCompute", "uniform", dispatch_uniform_change,
+		 base_rate);
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,255 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the latency of the window system paths around contexts, on the
+ * platform piglit runs on (PIGLIT_PLATFORM: glx, x11_egl, wayland, gbm,
+ * surfaceless_egl):
+ *
+ *  - create-context, destroy-context: a context sharing objects with the
+ *    test's one
+ *  - make-current same: binding the context that is already current
+ *  - make-current switch: switching between two shared contexts, without
+ *    a drawable where the platform allows it
+ *  - make-current window: switching between a shared context and the
+ *    test's context and window
+ *  - swap vsync-off, swap vsync-on: the time between the returns of
+ *    consecutive piglit_swap_buffers() of cleared frames, with swap
+ *    intervals 0 and 1
+ *
+ * The swap interval is set with eglSwapInterval() or GLX_MESA_swap_control;
+ * the swap rows are "-" when neither applies.  The median, 99th percentile
+ * and maximum of the samples are printed in microseconds.
+ *
+ * Usage: context-switch [-samples N]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+#ifdef PIGLIT_HAS_EGL
+#include "piglit-util-egl.h"
+#endif
+#ifdef PIGLIT_HAS_GLX
+#include <GL/glx.h>
+#endif
+
+static unsigned num_samples = 200;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-samples") && i + 1 < argc) {
+			num_samples = MAX2(atoi(argv[++i]), 1);
+		} else {
+			fprintf(stderr, "context-switch [-samples N]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Iterations run before the samples are taken. */
+#define WARMUP 5
+
+static int64_t *samples;
+static void *ctx_a, *ctx_b;
+
+static bool
+set_swap_interval(int interval)
+{
+#ifdef PIGLIT_HAS_EGL
+	EGLDisplay egl_dpy = eglGetCurrentDisplay();
+
+	if (egl_dpy != EGL_NO_DISPLAY)
+		return eglSwapInterval(egl_dpy, interval);
+#endif
+#ifdef PIGLIT_HAS_GLX
+	Display *dpy = glXGetCurrentDisplay();
+
+	if (dpy && strstr(glXQueryExtensionsString(dpy, DefaultScreen(dpy)),
+			  "GLX_MESA_swap_control")) {
+		PFNGLXSWAPINTERVALMESAPROC swap_interval_mesa =
+			(PFNGLXSWAPINTERVALMESAPROC)
+			glXGetProcAddressARB((const GLubyte *)
+					     "glXSwapIntervalMESA");
+
+		return swap_interval_mesa(interval) == 0;
+	}
+#endif
+	(void)interval;
+	return false;
+}
+
+static void
+print_row(const char *name, bool supported)
+{
+	struct perf_latency latency;
+
+	if (!supported) {
+		printf("  %-20s, %10s, %10s, %10s\n", name, "-", "-", "-");
+		return;
+	}
+
+	perf_report_latency("context-switch", name, samples, num_samples,
+			    &latency);
+	printf("  %-20s, %10.1f, %10.1f, %10.1f\n", name, latency.p50,
+	       latency.p99, latency.max);
+}
+
+static void
+check_current(bool ok)
+{
+	if (!ok) {
+		printf("Failed to make a context current\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+}
+
+static void
+measure_create_destroy(void)
+{
+	int64_t *destroy_samples = malloc(num_samples * sizeof(*samples));
+	unsigned i;
+
+	for (i = 0; i < WARMUP + num_samples; i++) {
+		int64_t start, created;
+		void *ctx;
+
+		start = piglit_time_get_nano();
+		ctx = piglit_create_shared_context();
+		created = piglit_time_get_nano();
+		if (!ctx) {
+			printf("Failed to create a shared context\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+		piglit_destroy_shared_context(ctx);
+
+		if (i >= WARMUP) {
+			samples[i - WARMUP] = created - start;
+			destroy_samples[i - WARMUP] =
+				piglit_time_get_nano() - created;
+		}
+	}
+
+	print_row("create-context", true);
+	memcpy(samples, destroy_samples, num_samples * sizeof(*samples));
+	print_row("destroy-context", true);
+	free(destroy_samples);
+}
+
+/**
+ * Time making each of the contexts current in turn, where NULL is the
+ * test's context and window.
+ */
+static void
+measure_make_current(const char *name, void *first, void *second)
+{
+	unsigned i;
+
+	for (i = 0; i < WARMUP + num_samples; i++) {
+		void *ctx = i % 2 ? second : first;
+		int64_t start = piglit_time_get_nano();
+
+		check_current(ctx ? piglit_make_shared_context_current(ctx) :
+			      piglit_make_test_context_current());
+		if (i >= WARMUP)
+			samples[i - WARMUP] = piglit_time_get_nano() - start;
+	}
+
+	print_row(name, true);
+}
+
+static void
+measure_swap(const char *name, int interval)
+{
+	int64_t last;
+	unsigned i;
+
+	if (!set_swap_interval(interval)) {
+		print_row(name, false);
+		return;
+	}
+
+	last = piglit_time_get_nano();
+	for (i = 0; i < WARMUP + num_samples; i++) {
+		int64_t now;
+
+		glClearColor(i % 2, 0.0, 1.0, 1.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		piglit_swap_buffers();
+
+		now = piglit_time_get_nano();
+		if (i >= WARMUP)
+			samples[i - WARMUP] = now - last;
+		last = now;
+	}
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	print_row(name, true);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	samples = malloc(num_samples * sizeof(*samples));
+
+	ctx_a = piglit_create_shared_context();
+	ctx_b = piglit_create_shared_context();
+	if (!ctx_a || !ctx_b) {
+		printf("Shared contexts are not supported\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	const char *platform = getenv("PIGLIT_PLATFORM");
+
+	printf("Platform: %s\n", platform ? platform : "default");
+	printf("  %-20s, %10s, %10s, %10s\n", "Operation", "p50 usec",
+	       "p99 usec", "max usec");
+
+	measure_create_destroy();
+
+	measure_make_current("make-current same", ctx_a, ctx_a);
+	measure_make_current("make-current switch", ctx_a, ctx_b);
+	measure_make_current("make-current window", ctx_a, NULL);
+	check_current(piglit_make_test_context_current());
+
+	measure_swap("swap vsync-off", 0);
+	measure_swap("swap vsync-on", 1);
+
+	piglit_destroy_shared_context(ctx_a);
+	piglit_destroy_shared_context(ctx_b);
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,288 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the bandwidth of GPU copies, to tell whether the driver copies
+ * with a copy engine, the 3D pipe or a CPU fallback:
+ *
+ *  - glCopyImageSubData between textures of each texel size class, from
+ *    256x256 to 4096x4096
+ *  - glCopyImageSubData from RGTC1 and RGTC2 textures to RG32UI and
+ *    RGBA32UI textures of the size of their blocks, and back
+ *  - glBlitFramebuffer without scaling between textures of each class
+ *  - glCopyBufferSubData of 1 to 64 MiB
+ *
+ * The time is taken on the CPU up to a glFinish, so that copies done on the
+ * CPU or on another engine count in full.  GB/s are bytes copied, each read
+ * and written once.
+ *
+ * Usage: copy-bandwidth [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 33;
+	config.supports_gl_core_version = 33;
+	config.window_width = 64;
+	config.window_height = 64;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "copy-bandwidth [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Skip the sizes whose textures would be larger. */
+#define MAX_BYTES (64 * 1024 * 1024)
+
+static const struct format {
+	const char *name;
+	GLenum internal_format, format, type;
+	/** Bytes per texel, or per block of a compressed format. */
+	unsigned bytes;
+	/** Whether the format has 4x4 compressed blocks. */
+	bool compressed;
+} formats[] = {
+	{ "r8", GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, false },
+	{ "rg8", GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2, false },
+	{ "rgba8", GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false },
+	{ "rgba16f", GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, false },
+	{ "rgba32f", GL_RGBA32F, GL_RGBA, GL_FLOAT, 16, false },
+};
+
+/** Compressed formats and the uncompressed formats of their block size */
+static const struct format views[][2] = {
+	{
+		{ "rgtc1", GL_COMPRESSED_RED_RGTC1, 0, 0, 8, true },
+		{ "rg32ui", GL_RG32UI, GL_RG_INTEGER, GL_UNSIGNED_INT, 8, false },
+	},
+	{
+		{ "rgtc2", GL_COMPRESSED_RG_RGTC2, 0, 0, 16, true },
+		{ "rgba32ui", GL_RGBA32UI, GL_RGBA_INTEGER, GL_UNSIGNED_INT, 16,
+		  false },
+	},
+};
+
+static const unsigned sizes[] = { 256, 1024, 4096 };
+
+static const unsigned buffer_sizes[] = {
+	1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024,
+};
+
+static GLuint src, dst;
+static unsigned src_width, src_height;
+static unsigned copy_size;
+static GLuint fbos[2];
+static bool have_copy_image;
+
+static GLuint
+create_texture(const struct format *format, unsigned width, unsigned height)
+{
+	unsigned size = format->compressed ?
+		(width / 4) * (height / 4) * format->bytes :
+		width * height * format->bytes;
+	unsigned char *data = malloc(size);
+	GLuint tex;
+
+	/* Arbitrary contents, so that nothing is skipped as untouched. */
+	for (unsigned i = 0; i < size; i++)
+		data[i] = i * 7 + (i >> 8);
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexStorage2D(GL_TEXTURE_2D, 1, format->internal_format, width,
+		       height);
+	if (format->compressed) {
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width,
+					  height, format->internal_format,
+					  size, data);
+	} else {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+				format->format, format->type, data);
+	}
+	free(data);
+	return tex;
+}
+
+static void
+copy_image(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glCopyImageSubData(src, GL_TEXTURE_2D, 0, 0, 0, 0,
+				   dst, GL_TEXTURE_2D, 0, 0, 0, 0,
+				   src_width, src_height, 1);
+	}
+}
+
+static void
+blit(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glBlitFramebuffer(0, 0, src_width, src_height,
+				  0, 0, src_width, src_height,
+				  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+}
+
+static void
+copy_buffer(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+				    0, 0, copy_size);
+	}
+}
+
+static void
+measure(const char *op, const char *what, unsigned size, perf_rate_func f,
+	double bytes)
+{
+	char name[128];
+	double rate;
+
+	rate = perf_measure_cpu_rate(f, duration) * bytes / 1e9;
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	snprintf(name, sizeof(name), "%s %s %u", op, what, size);
+	perf_report("copy-bandwidth", name, "GB/s", bytes / 1e9,
+		    perf_last_stats());
+
+	printf("  %-11s, %-20s, %8u, %8.2f\n", op, what, size, rate);
+}
+
+static void
+measure_textures(const char *op, const struct format *src_format,
+		 const struct format *dst_format, unsigned size)
+{
+	unsigned texels = src_format->compressed ? size / 4 : size;
+	unsigned dst_size = size;
+	char what[64];
+
+	/* A texel of the uncompressed view is a block of the compressed one. */
+	if (src_format->compressed && !dst_format->compressed)
+		dst_size = size / 4;
+	else if (!src_format->compressed && dst_format->compressed)
+		dst_size = size * 4;
+
+	src_width = src_height = size;
+	src = create_texture(src_format, size, size);
+	dst = create_texture(dst_format, dst_size, dst_size);
+
+	if (!strcmp(op, "blit")) {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[0]);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				       GL_TEXTURE_2D, src, 0);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[1]);
+		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				       GL_TEXTURE_2D, dst, 0);
+	}
+
+	if (src_format == dst_format)
+		snprintf(what, sizeof(what), "%s", src_format->name);
+	else
+		snprintf(what, sizeof(what), "%s->%s", src_format->name,
+			 dst_format->name);
+
+	measure(op, what, size, !strcmp(op, "blit") ? blit : copy_image,
+		(double)texels * texels * src_format->bytes);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+	glDeleteTextures(1, &src);
+	glDeleteTextures(1, &dst);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	piglit_require_extension("GL_ARB_texture_storage");
+	have_copy_image = piglit_is_extension_supported("GL_ARB_copy_image");
+
+	glGenFramebuffers(2, fbos);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	GLuint buffers[2];
+
+	printf("  %-11s, %-20s, %8s, %8s\n", "Operation", "Format", "Size",
+	       "GB/s");
+
+	for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+		for (unsigned s = 0; s < ARRAY_SIZE(sizes); s++) {
+			if ((double)sizes[s] * sizes[s] * formats[f].bytes >
+			    MAX_BYTES)
+				continue;
+			if (have_copy_image) {
+				measure_textures("copy-image", &formats[f],
+						 &formats[f], sizes[s]);
+			}
+			measure_textures("blit", &formats[f], &formats[f],
+					 sizes[s]);
+		}
+	}
+
+	for (unsigned v = 0; have_copy_image && v < ARRAY_SIZE(views); v++) {
+		for (unsigned s = 0; s < ARRAY_SIZE(sizes); s++) {
+			measure_textures("copy-image", &views[v][0],
+					 &views[v][1], sizes[s]);
+			measure_textures("copy-image", &views[v][1],
+					 &views[v][0], sizes[s] / 4);
+		}
+	}
+
+	glGenBuffers(2, buffers);
+	for (unsigned s = 0; s < ARRAY_SIZE(buffer_sizes); s++) {
+		void *data = malloc(buffer_sizes[s]);
+
+		memset(data, 0x5a, buffer_sizes[s]);
+		glBindBuffer(GL_COPY_READ_BUFFER, buffers[0]);
+		glBufferData(GL_COPY_READ_BUFFER, buffer_sizes[s], data,
+			     GL_STATIC_DRAW);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+		glBufferData(GL_COPY_WRITE_BUFFER, buffer_sizes[s], NULL,
+			     GL_STATIC_DRAW);
+		free(data);
+
+		copy_size = buffer_sizes[s];
+		measure("copy-buffer", "buffer", copy_size, copy_buffer,
+			copy_size);
+	}
+	glDeleteBuffers(2, buffers);
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
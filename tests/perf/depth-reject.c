@@ -0,0 +1,367 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure how fast fragments are rejected by the depth and stencil tests
+ * ahead of the fragment shader (early Z, HiZ), with the depth and stencil
+ * attachments that the tests/hiz correctness tests use, plus 32-bit float
+ * depth.
+ *
+ * Each iteration clears the depth and stencil buffers and draws layers of
+ * full screen triangles with an expensive fragment shader:
+ *
+ *  - front-to-back: the first layer is nearest, so the later ones can all
+ *    be rejected early
+ *  - back-to-front: every layer passes the depth test and is shaded
+ *  - frag-depth: front-to-back, but the shader writes gl_FragDepth, which
+ *    disables early rejection
+ *  - depth+stencil: front-to-back with the stencil test enabled and
+ *    counting the fragments that pass
+ *  - stencil-reject: every layer fails the stencil test
+ *  - clear: only the clear of the depth and stencil buffers
+ *
+ * The results are in Gpixels/s of fragments drawn, or of pixels cleared.
+ *
+ * Usage: depth-reject [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "depth-reject [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define WIDTH 1920
+#define HEIGHT 1080
+/* Full screen layers drawn per iteration. */
+#define NUM_LAYERS 16
+
+/* The attachments, named like the tests in tests/hiz. */
+static const struct {
+	const char *name;
+	GLenum depth_format;
+	GLenum stencil_format;
+	GLenum depth_stencil_format;
+} formats[] = {
+	{ "d24-s0", GL_DEPTH_COMPONENT24, 0, 0 },
+	{ "d24-s8", GL_DEPTH_COMPONENT24, GL_STENCIL_INDEX8, 0 },
+	{ "d24s8", 0, 0, GL_DEPTH24_STENCIL8 },
+	{ "d32f-s0", GL_DEPTH_COMPONENT32F, 0, 0 },
+	{ "d32f-s8", GL_DEPTH_COMPONENT32F, GL_STENCIL_INDEX8, 0 },
+	{ "d32fs8", 0, 0, GL_DEPTH32F_STENCIL8 },
+	{ "d0-s8", 0, GL_STENCIL_INDEX8, 0 },
+};
+
+enum reject_mode {
+	MODE_FRONT_TO_BACK,
+	MODE_BACK_TO_FRONT,
+	MODE_FRAG_DEPTH,
+	MODE_DEPTH_STENCIL,
+	MODE_STENCIL_REJECT,
+	MODE_CLEAR,
+	MODE_COUNT
+};
+
+static const char *mode_names[MODE_COUNT] = {
+	"front-to-back",
+	"back-to-front",
+	"frag-depth",
+	"depth+stencil",
+	"stencil-reject",
+	"clear",
+};
+
+static GLuint vao, prog, frag_depth_prog;
+static GLint direction_loc, frag_depth_direction_loc;
+static GLuint fbo, color_rb, depth_rb, stencil_rb;
+
+/* The case being measured. */
+static unsigned cur_format;
+static enum reject_mode cur_mode;
+static GLbitfield clear_mask;
+
+/* Layer gl_InstanceID is at depth (2 * layer + 1) / NUM_LAYERS - 1, from
+ * front to back, or reversed if direction is -1.
+ */
+static const char *vs_source =
+	"#version 150\n"
+	"uniform float direction;\n"
+	"void main() {\n"
+	"	float z = direction * (float(2 * gl_InstanceID + 1) / %d.0 - 1.0);\n"
+	"	gl_Position = vec4(gl_VertexID == 1 ? 3.0 : -1.0,\n"
+	"			   gl_VertexID == 2 ? 3.0 : -1.0, z, 1.0);\n"
+	"}\n";
+
+static const char *fs_source =
+	"#version 150\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	vec2 v = gl_FragCoord.xy;\n"
+	"	for (int i = 0; i < 32; i++)\n"
+	"		v = sin(v * 1.7 + v.yx);\n"
+	"	color = vec4(v, 0.0, 1.0);\n"
+	"%s"
+	"}\n";
+
+static GLuint
+create_renderbuffer(GLenum format, GLenum attachment)
+{
+	GLuint rb;
+
+	glGenRenderbuffers(1, &rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, format, WIDTH, HEIGHT);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment,
+				  GL_RENDERBUFFER, rb);
+	return rb;
+}
+
+static void
+destroy_buffers(void)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteRenderbuffers(1, &color_rb);
+	glDeleteRenderbuffers(1, &depth_rb);
+	glDeleteRenderbuffers(1, &stencil_rb);
+	fbo = color_rb = depth_rb = stencil_rb = 0;
+}
+
+/**
+ * Create the framebuffer of a format, return false if the combination
+ * isn't supported.
+ */
+static bool
+create_buffers(void)
+{
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+	color_rb = create_renderbuffer(GL_RGBA8, GL_COLOR_ATTACHMENT0);
+	if (formats[cur_format].depth_stencil_format) {
+		depth_rb = create_renderbuffer(
+			formats[cur_format].depth_stencil_format,
+			GL_DEPTH_STENCIL_ATTACHMENT);
+	}
+	if (formats[cur_format].depth_format) {
+		depth_rb = create_renderbuffer(
+			formats[cur_format].depth_format,
+			GL_DEPTH_ATTACHMENT);
+	}
+	if (formats[cur_format].stencil_format) {
+		stencil_rb = create_renderbuffer(
+			formats[cur_format].stencil_format,
+			GL_STENCIL_ATTACHMENT);
+	}
+
+	if (!piglit_check_gl_error(GL_NO_ERROR) ||
+	    glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+	    GL_FRAMEBUFFER_COMPLETE) {
+		destroy_buffers();
+		return false;
+	}
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	return true;
+}
+
+static bool
+has_depth(void)
+{
+	return formats[cur_format].depth_format ||
+	       formats[cur_format].depth_stencil_format;
+}
+
+static bool
+has_stencil(void)
+{
+	return formats[cur_format].stencil_format ||
+	       formats[cur_format].depth_stencil_format;
+}
+
+static bool
+mode_supported(void)
+{
+	switch (cur_mode) {
+	case MODE_FRONT_TO_BACK:
+	case MODE_BACK_TO_FRONT:
+	case MODE_FRAG_DEPTH:
+		return has_depth();
+	case MODE_DEPTH_STENCIL:
+		return has_depth() && has_stencil();
+	case MODE_STENCIL_REJECT:
+		return has_stencil();
+	default:
+		return true;
+	}
+}
+
+/** Set the state of the current mode. */
+static void
+setup_mode(void)
+{
+	const float direction = cur_mode == MODE_BACK_TO_FRONT ? -1.0 : 1.0;
+
+	clear_mask = (has_depth() ? GL_DEPTH_BUFFER_BIT : 0) |
+		     (has_stencil() ? GL_STENCIL_BUFFER_BIT : 0);
+
+	if (cur_mode == MODE_FRAG_DEPTH) {
+		glUseProgram(frag_depth_prog);
+		glUniform1f(frag_depth_direction_loc, direction);
+	} else {
+		glUseProgram(prog);
+		glUniform1f(direction_loc, direction);
+	}
+
+	if (cur_mode != MODE_STENCIL_REJECT) {
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LESS);
+	}
+
+	if (cur_mode == MODE_DEPTH_STENCIL) {
+		glEnable(GL_STENCIL_TEST);
+		glStencilFunc(GL_ALWAYS, 0, ~0);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+	} else if (cur_mode == MODE_STENCIL_REJECT) {
+		/* The stencil buffer is cleared to 0. */
+		glEnable(GL_STENCIL_TEST);
+		glStencilFunc(GL_EQUAL, 1, ~0);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+	}
+}
+
+static void
+reset_mode(void)
+{
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_STENCIL_TEST);
+}
+
+static void
+draw_layers(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glClear(clear_mask);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 3, NUM_LAYERS);
+	}
+}
+
+static void
+clear(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++)
+		glClear(clear_mask);
+}
+
+static GLuint
+build_program(const char *extra_fs, GLint *direction)
+{
+	char vs[512], fs[512];
+	GLuint p;
+
+	snprintf(vs, sizeof(vs), vs_source, NUM_LAYERS);
+	snprintf(fs, sizeof(fs), fs_source, extra_fs);
+	p = piglit_build_simple_program(vs, fs);
+	*direction = glGetUniformLocation(p, "direction");
+	return p;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	prog = build_program("", &direction_loc);
+	frag_depth_prog = build_program(
+		"	gl_FragDepth = gl_FragCoord.z;\n",
+		&frag_depth_direction_loc);
+
+	/* The programs only use gl_VertexID and gl_InstanceID. */
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glClearDepth(1.0);
+	glClearStencil(0);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	printf("  %-8s, %-14s, %10s\n", "Format", "Mode", "Gpixels/s");
+
+	for (cur_format = 0; cur_format < ARRAY_SIZE(formats); cur_format++) {
+		for (cur_mode = 0; cur_mode < MODE_COUNT; cur_mode++) {
+			const double pixels = (double)WIDTH * HEIGHT *
+				(cur_mode == MODE_CLEAR ? 1 : NUM_LAYERS);
+			char name[64];
+			double rate;
+
+			if (!mode_supported() || !create_buffers()) {
+				printf("  %-8s, %-14s, %10s\n",
+				       formats[cur_format].name,
+				       mode_names[cur_mode], "-");
+				continue;
+			}
+
+			setup_mode();
+			rate = perf_measure_gpu_rate(cur_mode == MODE_CLEAR ?
+						     clear : draw_layers,
+						     duration);
+			if (!piglit_check_gl_error(GL_NO_ERROR))
+				piglit_report_result(PIGLIT_FAIL);
+			reset_mode();
+			destroy_buffers();
+
+			printf("  %-8s, %-14s, %10.2f\n",
+			       formats[cur_format].name,
+			       mode_names[cur_mode], rate * pixels / 1e9);
+
+			snprintf(name, sizeof(name), "%s %s",
+				 formats[cur_format].name,
+				 mode_names[cur_mode]);
+			perf_report("depth-reject", name, "Gpixels/s",
+				    pixels / 1e9, perf_last_stats());
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the cost of calling GL through piglit-dispatch, compared to
+ * calling the driver's entry point directly, using a call that does
+ * almost no work in the driver.
+ *
+ * Run with PIGLIT_DISPATCH_EAGER=1 to measure the dispatch table filled
+ * up front instead of through the resolve-on-first-call stubs.
+ */
+
+#include "common.h"
+#include "piglit-util-gl.h"
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 10;
+	config.supports_gl_core_version = 31;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+typedef GLboolean (APIENTRY *is_enabled_func)(GLenum cap);
+
+static is_enabled_func direct_is_enabled;
+
+static void
+dispatch_calls(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++)
+		glIsEnabled(GL_DEPTH_TEST);
+}
+
+static void
+direct_calls(unsigned count)
+{
+	const is_enabled_func f = direct_is_enabled;
+	unsigned i;
+	for (i = 0; i < count; i++)
+		f(GL_DEPTH_TEST);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	direct_is_enabled = (is_enabled_func)
+		piglit_dispatch_resolve_function("glIsEnabled");
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	double dispatch_rate, direct_rate;
+
+	dispatch_rate = perf_measure_cpu_rate(dispatch_calls, 1.0);
+	direct_rate = perf_measure_cpu_rate(direct_calls, 1.0);
+
+	printf("  Through piglit-dispatch: %.1f million calls/sec\n",
+	       dispatch_rate / 1e6);
+	printf("  Direct:                  %.1f million calls/sec\n",
+	       direct_rate / 1e6);
+	printf("  Dispatch overhead:       %.2f ns/call\n",
+	       (1.0 / dispatch_rate - 1.0 / direct_rate) * 1e9);
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure how fast display lists of immediate mode geometry compile with
+ * glNewList/glEndList and replay with glCallList.
+ *
+ * Each kind of list is built with 6, 96, 1536 and 24576 vertices, and
+ * measured in vertices per second, both compiling (including glFinish) and
+ * replaying.  The kinds are:
+ *
+ *  - a strip of glVertex, with glColor, and with glColor, glNormal and
+ *    glTexCoord per vertex
+ *  - the same attributes with glMaterial, and glEnable/glDisable, matrix
+ *    and blend state changes between strips of 12 vertices
+ *  - a glBegin/glEnd pair per triangle
+ *  - a list calling 16 lists holding a sixteenth of the vertices each,
+ *    from 96 vertices on
+ *
+ * The primitives cover a pixel, so that the rasterization costs nothing.
+ *
+ * Usage: dlist [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 10;
+	config.window_width = 64;
+	config.window_height = 64;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "dlist [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define NUM_CHILDREN 16
+#define STATE_STRIP 12
+
+static const unsigned counts[] = { 6, 96, 1536, 24576 };
+
+static void
+vertex(unsigned i)
+{
+	/* Within a pixel of the 64x64 window */
+	glVertex2f((i & 1) * 0.03f, (i & 2) * 0.015f);
+}
+
+static void
+emit_vertex(unsigned count)
+{
+	glBegin(GL_TRIANGLE_STRIP);
+	for (unsigned i = 0; i < count; i++)
+		vertex(i);
+	glEnd();
+}
+
+static void
+emit_color(unsigned count)
+{
+	glBegin(GL_TRIANGLE_STRIP);
+	for (unsigned i = 0; i < count; i++) {
+		glColor4ub(i, i * 3, i * 5, 255);
+		vertex(i);
+	}
+	glEnd();
+}
+
+static void
+emit_all_attribs(unsigned count)
+{
+	glBegin(GL_TRIANGLE_STRIP);
+	for (unsigned i = 0; i < count; i++) {
+		glColor4ub(i, i * 3, i * 5, 255);
+		glNormal3f(0, (i & 1) * 0.5f, 1);
+		glTexCoord2f(i & 1, (i & 2) * 0.5f);
+		vertex(i);
+	}
+	glEnd();
+}
+
+static void
+emit_state_changes(unsigned count)
+{
+	static const float diffuse[2][4] = {
+		{ 1, 0.5, 0.25, 1 },
+		{ 0.25, 0.5, 1, 1 },
+	};
+
+	for (unsigned first = 0; first < count; first += STATE_STRIP) {
+		unsigned n = first / STATE_STRIP;
+
+		if (n & 1) {
+			glEnable(GL_LIGHTING);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		} else {
+			glDisable(GL_LIGHTING);
+			glDisable(GL_BLEND);
+		}
+		glPushMatrix();
+		glTranslatef((n & 3) * 0.001f, 0, 0);
+
+		glBegin(GL_TRIANGLE_STRIP);
+		glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, diffuse[n & 1]);
+		for (unsigned i = first; i < first + STATE_STRIP && i < count; i++) {
+			glColor4ub(i, i * 3, i * 5, 255);
+			glNormal3f(0, (i & 1) * 0.5f, 1);
+			glTexCoord2f(i & 1, (i & 2) * 0.5f);
+			vertex(i);
+		}
+		glEnd();
+
+		glPopMatrix();
+	}
+	glDisable(GL_LIGHTING);
+	glDisable(GL_BLEND);
+}
+
+static void
+emit_small_prims(unsigned count)
+{
+	for (unsigned i = 0; i + 3 <= count; i += 3) {
+		glBegin(GL_TRIANGLES);
+		glColor4ub(i, i * 3, i * 5, 255);
+		vertex(i);
+		vertex(i + 1);
+		vertex(i + 2);
+		glEnd();
+	}
+}
+
+static GLuint children;
+
+static void
+emit_nested(unsigned count)
+{
+	for (unsigned i = 0; i < NUM_CHILDREN; i++)
+		glCallList(children + i);
+}
+
+static const struct kind {
+	const char *name;
+	void (*emit)(unsigned count);
+	bool nested;
+} kinds[] = {
+	{ "vertex", emit_vertex, false },
+	{ "color", emit_color, false },
+	{ "color+normal+texcoord", emit_all_attribs, false },
+	{ "state changes", emit_state_changes, false },
+	{ "begin/end per triangle", emit_small_prims, false },
+	{ "nested", emit_nested, true },
+};
+
+static const struct kind *cur_kind;
+static unsigned cur_count;
+static GLuint list;
+
+static void
+compile_list(unsigned iterations)
+{
+	for (unsigned i = 0; i < iterations; i++) {
+		glNewList(list, GL_COMPILE);
+		cur_kind->emit(cur_count);
+		glEndList();
+	}
+}
+
+static void
+call_list(unsigned iterations)
+{
+	for (unsigned i = 0; i < iterations; i++)
+		glCallList(list);
+}
+
+static void
+measure(const struct kind *kind, unsigned count)
+{
+	const double mverts = count / 1e6;
+	double compile_rate, call_rate;
+	char name[128];
+
+	if (kind->nested) {
+		for (unsigned i = 0; i < NUM_CHILDREN; i++) {
+			glNewList(children + i, GL_COMPILE);
+			emit_all_attribs(count / NUM_CHILDREN);
+			glEndList();
+		}
+	}
+
+	cur_kind = kind;
+	cur_count = count;
+
+	compile_rate = perf_measure_cpu_rate(compile_list, duration) * mverts;
+	snprintf(name, sizeof(name), "compile %s %u", kind->name, count);
+	perf_report("dlist", name, "Mverts/s", mverts, perf_last_stats());
+
+	call_rate = perf_measure_cpu_rate(call_list, duration) * mverts;
+	snprintf(name, sizeof(name), "call %s %u", kind->name, count);
+	perf_report("dlist", name, "Mverts/s", mverts, perf_last_stats());
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	printf("  %-24s, %8u, %16.2f, %13.2f\n", kind->name, count,
+	       compile_rate, call_rate);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	list = glGenLists(1);
+	children = glGenLists(NUM_CHILDREN);
+
+	glEnable(GL_LIGHT0);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	printf("  %-24s, %8s, %16s, %13s\n", "List", "Vertices",
+	       "Compile Mverts/s", "Call Mverts/s");
+
+	for (unsigned k = 0; k < ARRAY_SIZE(kinds); k++) {
+		for (unsigned c = 0; c < ARRAY_SIZE(counts); c++) {
+			/* Each child needs a triangle. */
+			if (kinds[k].nested && counts[c] < NUM_CHILDREN * 3)
+				continue;
+			measure(&kinds[k], counts[c]);
+		}
+	}
+
+	glDeleteLists(list, 1);
+	glDeleteLists(children, NUM_CHILDREN);
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
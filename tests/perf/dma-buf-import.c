@@ -0,0 +1,300 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure dma-buf imports for every modifier the driver can sample
+ * DRM_FORMAT_XRGB8888 buffers with:
+ *
+ *  - fill:   writing new data into the buffer, in GB/s
+ *  - import: eglCreateImageKHR, glEGLImageTargetTexture2DOES and
+ *            eglDestroyImageKHR of the buffer, in imports/sec
+ *  - sample: drawing a window-sized quad textured with the imported
+ *            image, in Mpixels/sec
+ *
+ * The buffer of each modifier comes from a piglit_dma_buf_pool, so it is
+ * allocated and exported once and only the measured work is repeated.
+ * Without EGL_EXT_image_dma_buf_import_modifiers only the buffers
+ * piglit_create_dma_buf() makes are measured.
+ *
+ * Usage: dma-buf-import [-duration SECONDS] [-size PIXELS]
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "common.h"
+#include "piglit-util-egl.h"
+#include "piglit-util-gl.h"
+#include "piglit-framework-gl/piglit_drm_dma_buf.h"
+
+static double duration = 0.5;
+static unsigned size = 2048;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 10;
+	config.window_width = 1024;
+	config.window_height = 1024;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-size") && i + 1 < argc) {
+			size = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "dma-buf-import [-duration SECONDS] "
+				"[-size PIXELS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define FOURCC DRM_FORMAT_XRGB8888
+#define MAX_MODIFIERS 64
+
+static EGLDisplay dpy;
+static struct piglit_dma_buf_pool *pool;
+static struct piglit_dma_buf *buf;
+static uint64_t cur_modifier;
+static unsigned char *data;
+static GLuint tex;
+
+static EGLImageKHR
+create_image(void)
+{
+	EGLint attr[6 + 3 * 10 + 1];
+	unsigned n = 0, p;
+
+	attr[n++] = EGL_WIDTH;
+	attr[n++] = buf->w;
+	attr[n++] = EGL_HEIGHT;
+	attr[n++] = buf->h;
+	attr[n++] = EGL_LINUX_DRM_FOURCC_EXT;
+	attr[n++] = FOURCC;
+
+	for (p = 0; p < buf->n_planes; p++) {
+		static const EGLint plane_attrs[3][5] = {
+			{ EGL_DMA_BUF_PLANE0_FD_EXT,
+			  EGL_DMA_BUF_PLANE0_OFFSET_EXT,
+			  EGL_DMA_BUF_PLANE0_PITCH_EXT,
+			  EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT,
+			  EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT },
+			{ EGL_DMA_BUF_PLANE1_FD_EXT,
+			  EGL_DMA_BUF_PLANE1_OFFSET_EXT,
+			  EGL_DMA_BUF_PLANE1_PITCH_EXT,
+			  EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT,
+			  EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT },
+			{ EGL_DMA_BUF_PLANE2_FD_EXT,
+			  EGL_DMA_BUF_PLANE2_OFFSET_EXT,
+			  EGL_DMA_BUF_PLANE2_PITCH_EXT,
+			  EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT,
+			  EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT },
+		};
+
+		attr[n++] = plane_attrs[p][0];
+		attr[n++] = buf->fd;
+		attr[n++] = plane_attrs[p][1];
+		attr[n++] = buf->offset[p];
+		attr[n++] = plane_attrs[p][2];
+		attr[n++] = buf->stride[p];
+		if (cur_modifier != DRM_FORMAT_MOD_INVALID) {
+			attr[n++] = plane_attrs[p][3];
+			attr[n++] = cur_modifier & 0xffffffff;
+			attr[n++] = plane_attrs[p][4];
+			attr[n++] = cur_modifier >> 32;
+		}
+	}
+	attr[n++] = EGL_NONE;
+
+	return eglCreateImageKHR(dpy, EGL_NO_CONTEXT, EGL_LINUX_DMA_BUF_EXT,
+				 (EGLClientBuffer)0, attr);
+}
+
+static void
+fill(unsigned count)
+{
+	struct piglit_dma_buf *b;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		/* The buffer is only put back, so the same one comes back. */
+		piglit_drm_dma_buf_pool_put(pool, buf);
+		if (piglit_drm_dma_buf_pool_get(pool, size, size, FOURCC,
+						cur_modifier, data,
+						&b) != PIGLIT_PASS)
+			piglit_report_result(PIGLIT_FAIL);
+		buf = b;
+	}
+}
+
+static void
+import(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		EGLImageKHR img = create_image();
+
+		glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)img);
+		eglDestroyImageKHR(dpy, img);
+	}
+	glFinish();
+}
+
+static void
+sample(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++)
+		piglit_draw_rect_tex(-1, -1, 2, 2, 0, 0, 1, 1);
+	glFinish();
+}
+
+static void
+report(const char *measure, const char *unit, double scale)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "%s, 0x%016" PRIx64, measure,
+		 cur_modifier);
+	perf_report("dma-buf-import", name, unit, scale, perf_last_stats());
+}
+
+/** Measure cur_modifier, return false if its buffers can't be used. */
+static bool
+measure(void)
+{
+	const double bytes = (double)size * size * 4;
+	const double pixels = (double)piglit_width * piglit_height;
+	double fill_rate, import_rate, sample_rate;
+	EGLImageKHR img;
+
+	buf = NULL;
+	if (piglit_drm_dma_buf_pool_get(pool, size, size, FOURCC,
+					cur_modifier, data,
+					&buf) != PIGLIT_PASS)
+		return false;
+
+	img = create_image();
+	if (img == EGL_NO_IMAGE_KHR) {
+		piglit_drm_dma_buf_pool_put(pool, buf);
+		return false;
+	}
+	glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, (GLeglImageOES)img);
+
+	fill_rate = perf_measure_cpu_rate(fill, duration);
+	report("fill", "GB/s", bytes / 1e9);
+
+	import_rate = perf_measure_cpu_rate(import, duration);
+	report("import", "imports/sec", 1);
+
+	/* The import measurement leaves the last image bound. */
+	sample_rate = perf_measure_cpu_rate(sample, duration);
+	report("sample", "Mpixels/sec", pixels / 1e6);
+
+	eglDestroyImageKHR(dpy, img);
+	piglit_drm_dma_buf_pool_put(pool, buf);
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	printf("  0x%016" PRIx64 ", %8.2f, %12.0f, %12.1f\n", cur_modifier,
+	       fill_rate * bytes / 1e9, import_rate,
+	       sample_rate * pixels / 1e6);
+	return true;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	unsigned i;
+
+	piglit_require_extension("GL_OES_EGL_image");
+
+	dpy = eglGetCurrentDisplay();
+	if (dpy == EGL_NO_DISPLAY) {
+		printf("Requires an EGL platform\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+	piglit_require_egl_extension(dpy, "EGL_EXT_image_dma_buf_import");
+
+	pool = piglit_drm_dma_buf_pool_create();
+	data = malloc((size_t)size * size * 4);
+	if (!pool || !data)
+		piglit_report_result(PIGLIT_FAIL);
+	for (i = 0; i < size * size * 4; i++)
+		data[i] = i * 7;
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glEnable(GL_TEXTURE_2D);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	EGLuint64KHR modifiers[MAX_MODIFIERS];
+	EGLBoolean external_only[MAX_MODIFIERS];
+	EGLint num_modifiers = 0;
+	unsigned measured = 0;
+	EGLint i;
+
+	if (piglit_is_egl_extension_supported(dpy,
+			"EGL_EXT_image_dma_buf_import_modifiers")) {
+		PFNEGLQUERYDMABUFMODIFIERSEXTPROC query_modifiers =
+			(PFNEGLQUERYDMABUFMODIFIERSEXTPROC)eglGetProcAddress(
+				"eglQueryDmaBufModifiersEXT");
+
+		query_modifiers(dpy, FOURCC, MAX_MODIFIERS, modifiers,
+				external_only, &num_modifiers);
+	}
+
+	printf("  %-18s, %8s, %12s, %12s\n", "Modifier", "GB/s", "Imports/s",
+	       "Mpixels/s");
+
+	if (num_modifiers == 0) {
+		cur_modifier = DRM_FORMAT_MOD_INVALID;
+		if (measure())
+			measured++;
+	}
+
+	for (i = 0; i < num_modifiers; i++) {
+		/* These can't be bound to GL_TEXTURE_2D. */
+		if (external_only[i])
+			continue;
+
+		cur_modifier = modifiers[i];
+		if (measure())
+			measured++;
+		else
+			printf("  0x%016" PRIx64 ", -, -, -\n", cur_modifier);
+	}
+
+	piglit_drm_dma_buf_pool_destroy(pool);
+	piglit_report_result(measured ? PIGLIT_PASS : PIGLIT_SKIP);
+	return PIGLIT_SKIP;
+}
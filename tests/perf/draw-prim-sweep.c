@@ -0,0 +1,593 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the primitive rate of a sweep of draw paths, amplification factors
+ * and triangle sizes, to size geometry budgets and to catch culling
+ * regressions.  The draw paths are:
+ *
+ *  - DrawArrays: a non-indexed triangle list
+ *  - DrawElements: an indexed triangle list sharing vertices along rows
+ *  - PrimRestart: indexed triangle strips, one per row, separated by the
+ *    primitive restart index
+ *  - Instanced: one row drawn as a triangle list, instanced once per row
+ *  - MultiDrawIndirect: the triangle list split into up to 64 draws of
+ *    glMultiDrawArraysIndirect
+ *  - Geometry: a geometry shader emitting 1 to 32 copies of each triangle
+ *  - Tessellation: triangle patches tessellated with levels 1 to 64
+ *
+ * The triangles are halves of quads from 1/4 of a pixel up to the full
+ * window wide, laid out in rows that wrap around the window.  The number of
+ * triangles per draw is limited so that no draw covers more than 64M pixels.
+ * Every configuration is measured with all triangles visible and with all of
+ * them culled by glCullFace(GL_FRONT_AND_BACK).
+ *
+ * The number of primitives is counted with a GL_PRIMITIVES_GENERATED query,
+ * so the rate of amplified draws is that of the triangles rasterized.
+ *
+ * Usage: draw-prim-sweep [-method NAME] [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#undef NDEBUG
+#include <assert.h>
+#include "piglit-util-gl.h"
+
+static const char *only_method;
+static double duration = 0.25;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 33;
+	config.supports_gl_core_version = 33;
+	config.window_width = 1024;
+	config.window_height = 1024;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-method") && i + 1 < argc) {
+			only_method = argv[++i];
+		} else if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "draw-prim-sweep [-method NAME] "
+				"[-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define WINDOW_SIZE 1024
+#define MAX_PRIMS (256 * 1024)
+#define PIXEL_BUDGET (64.0 * 1024 * 1024)
+#define MAX_ROW_QUADS 256
+#define MAX_INDIRECT_DRAWS 64
+#define RESTART_INDEX 0xffffffffu
+
+enum draw_method {
+	METHOD_ARRAYS,
+	METHOD_ELEMENTS,
+	METHOD_RESTART,
+	METHOD_INSTANCED,
+	METHOD_INDIRECT,
+	METHOD_GEOMETRY,
+	METHOD_TESSELLATION,
+	METHOD_COUNT
+};
+
+static const struct {
+	const char *name;
+	/* Zero terminated */
+	unsigned amplifications[8];
+} methods[METHOD_COUNT] = {
+	{ "DrawArrays", { 1 } },
+	{ "DrawElements", { 1 } },
+	{ "PrimRestart", { 1 } },
+	{ "Instanced", { 1 } },
+	{ "MultiDrawIndirect", { 1 } },
+	{ "Geometry", { 1, 2, 4, 8, 16, 32 } },
+	{ "Tessellation", { 1, 2, 4, 8, 16, 32, 64 } },
+};
+
+/* Quad sizes in pixels, the last one covers the window. */
+static const double sizes[] = {
+	0.25, 0.5, 1, 2, 4, 8, 16, 64, 256, WINDOW_SIZE
+};
+
+static const char *vs_source =
+	"#version 330\n"
+	"layout(location = 0) in vec2 pos;\n"
+	"layout(location = 1) in vec2 offset;\n"
+	"void main() {\n"
+	"	gl_Position = vec4(pos + offset, 0.0, 1.0);\n"
+	"}\n";
+
+static const char *fs_source =
+	"#version 330\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = vec4(1.0);\n"
+	"}\n";
+
+static const char *gs_source =
+	"#version 330\n"
+	"#define COPIES %u\n"
+	"layout(triangles) in;\n"
+	"layout(triangle_strip, max_vertices = %u) out;\n"
+	"void main() {\n"
+	"	for (int c = 0; c < COPIES; c++) {\n"
+	"		for (int i = 0; i < 3; i++) {\n"
+	"			gl_Position = gl_in[i].gl_Position +\n"
+	"				vec4(0.0, 0.0, float(c) / COPIES, 0.0);\n"
+	"			EmitVertex();\n"
+	"		}\n"
+	"		EndPrimitive();\n"
+	"	}\n"
+	"}\n";
+
+static const char *tcs_source =
+	"#version 400\n"
+	"layout(vertices = 3) out;\n"
+	"uniform float level;\n"
+	"void main() {\n"
+	"	gl_out[gl_InvocationID].gl_Position =\n"
+	"		gl_in[gl_InvocationID].gl_Position;\n"
+	"	if (gl_InvocationID == 0) {\n"
+	"		gl_TessLevelOuter[0] = level;\n"
+	"		gl_TessLevelOuter[1] = level;\n"
+	"		gl_TessLevelOuter[2] = level;\n"
+	"		gl_TessLevelInner[0] = level;\n"
+	"	}\n"
+	"}\n";
+
+static const char *tes_source =
+	"#version 400\n"
+	"layout(triangles, equal_spacing, ccw) in;\n"
+	"void main() {\n"
+	"	gl_Position = gl_TessCoord.x * gl_in[0].gl_Position +\n"
+	"		      gl_TessCoord.y * gl_in[1].gl_Position +\n"
+	"		      gl_TessCoord.z * gl_in[2].gl_Position;\n"
+	"}\n";
+
+static GLuint vao, prog, tess_prog;
+static GLuint geom_progs[ARRAY_SIZE(methods[0].amplifications)];
+static GLint level_loc;
+static bool has_tessellation, has_indirect;
+
+/* The buffers of the current size. */
+static GLuint list_vbo, grid_vbo, elem_ibo, strip_ibo, offset_vbo;
+static GLuint indirect_bo;
+static unsigned row_quads, rows, num_prims, num_draws;
+
+/* The draw being measured. */
+static enum draw_method cur_method;
+static unsigned draw_count, num_instances;
+
+static float
+to_clip(double pixels)
+{
+	return pixels * 2.0 / WINDOW_SIZE - 1.0;
+}
+
+static GLuint
+create_buffer(GLenum target, size_t size, const void *data)
+{
+	GLuint bo;
+
+	glGenBuffers(1, &bo);
+	glBindBuffer(target, bo);
+	glBufferData(target, size, data, GL_STATIC_DRAW);
+	return bo;
+}
+
+/**
+ * Create the buffers of every method for quads of the given size.
+ */
+static void
+create_buffers(double size)
+{
+	const unsigned max_prims = MIN2(MAX_PRIMS,
+					PIXEL_BUDGET / (size * size / 2));
+	const unsigned rows_fit = MAX2(1, WINDOW_SIZE / size);
+	unsigned row_vertices;
+	float *list, *grid, *offsets;
+	unsigned *elems, *strips;
+	unsigned x, y;
+
+	row_quads = CLAMP(WINDOW_SIZE / size, 1, MAX_ROW_QUADS);
+	rows = MAX2(1, max_prims / (2 * row_quads));
+	num_prims = rows * row_quads * 2;
+	row_vertices = 2 * (row_quads + 1);
+
+	list = malloc(num_prims * 3 * 2 * sizeof(float));
+	grid = malloc(rows * row_vertices * 2 * sizeof(float));
+	offsets = malloc(rows * 2 * sizeof(float));
+	elems = malloc(num_prims * 3 * sizeof(unsigned));
+	strips = malloc(rows * (row_vertices + 1) * sizeof(unsigned));
+
+	for (y = 0; y < rows; y++) {
+		const double bottom = (y % rows_fit) * size;
+		const float b = to_clip(bottom), t = to_clip(bottom + size);
+		float *l = list + y * row_quads * 12;
+		float *g = grid + y * row_vertices * 2;
+		unsigned *e = elems + y * row_quads * 6;
+		unsigned *s = strips + y * (row_vertices + 1);
+		const unsigned base = y * row_vertices;
+
+		/* Counter-clockwise triangles (x0, b), (x1, b), (x0, t) and
+		 * (x0, t), (x1, b), (x1, t).
+		 */
+		for (x = 0; x < row_quads; x++) {
+			const float x0 = to_clip(x * size);
+			const float x1 = to_clip((x + 1) * size);
+			const float quad[12] = {
+				x0, b, x1, b, x0, t,
+				x0, t, x1, b, x1, t,
+			};
+
+			memcpy(l + x * 12, quad, sizeof(quad));
+
+			e[x * 6 + 0] = base + 2 * x;
+			e[x * 6 + 1] = base + 2 * (x + 1);
+			e[x * 6 + 2] = base + 2 * x + 1;
+			e[x * 6 + 3] = base + 2 * x + 1;
+			e[x * 6 + 4] = base + 2 * (x + 1);
+			e[x * 6 + 5] = base + 2 * (x + 1) + 1;
+		}
+
+		/* Vertex 2x is the bottom of column x, 2x + 1 the top. */
+		for (x = 0; x <= row_quads; x++) {
+			g[x * 4 + 0] = to_clip(x * size);
+			g[x * 4 + 1] = b;
+			g[x * 4 + 2] = to_clip(x * size);
+			g[x * 4 + 3] = t;
+
+			s[x * 2 + 0] = base + 2 * x + 1;
+			s[x * 2 + 1] = base + 2 * x;
+		}
+		s[row_vertices] = RESTART_INDEX;
+
+		/* Instances move the first row where this one is. */
+		offsets[y * 2 + 0] = 0;
+		offsets[y * 2 + 1] = (y % rows_fit) * size * 2.0 / WINDOW_SIZE;
+	}
+
+	list_vbo = create_buffer(GL_ARRAY_BUFFER,
+				 num_prims * 3 * 2 * sizeof(float), list);
+	grid_vbo = create_buffer(GL_ARRAY_BUFFER,
+				 rows * row_vertices * 2 * sizeof(float), grid);
+	offset_vbo = create_buffer(GL_ARRAY_BUFFER,
+				   rows * 2 * sizeof(float), offsets);
+	elem_ibo = create_buffer(GL_ELEMENT_ARRAY_BUFFER,
+				 num_prims * 3 * sizeof(unsigned), elems);
+	strip_ibo = create_buffer(GL_ELEMENT_ARRAY_BUFFER,
+				  rows * (row_vertices + 1) * sizeof(unsigned),
+				  strips);
+
+	if (has_indirect) {
+		/* Whole rows per draw, the last one gets the rest. */
+		const unsigned rows_per_draw =
+			MAX2(1, rows / MAX_INDIRECT_DRAWS);
+		GLuint cmds[MAX_INDIRECT_DRAWS][4];
+
+		num_draws = MIN2(rows, MAX_INDIRECT_DRAWS);
+		for (unsigned i = 0; i < num_draws; i++) {
+			const unsigned first = i * rows_per_draw;
+			const unsigned last = i == num_draws - 1 ?
+				rows : first + rows_per_draw;
+
+			cmds[i][0] = (last - first) * row_quads * 6;
+			cmds[i][1] = 1;
+			cmds[i][2] = first * row_quads * 6;
+			cmds[i][3] = 0;
+		}
+		indirect_bo = create_buffer(GL_DRAW_INDIRECT_BUFFER,
+					    sizeof(cmds), cmds);
+	}
+
+	free(list);
+	free(grid);
+	free(offsets);
+	free(elems);
+	free(strips);
+}
+
+static void
+destroy_buffers(void)
+{
+	glDeleteBuffers(1, &list_vbo);
+	glDeleteBuffers(1, &grid_vbo);
+	glDeleteBuffers(1, &offset_vbo);
+	glDeleteBuffers(1, &elem_ibo);
+	glDeleteBuffers(1, &strip_ibo);
+	if (indirect_bo)
+		glDeleteBuffers(1, &indirect_bo);
+	indirect_bo = 0;
+}
+
+static GLuint
+get_geometry_program(unsigned index, unsigned copies)
+{
+	char gs[1024];
+
+	if (!geom_progs[index]) {
+		snprintf(gs, sizeof(gs), gs_source, copies, copies * 3);
+		geom_progs[index] = piglit_build_simple_program_multiple_shaders(
+			GL_VERTEX_SHADER, vs_source,
+			GL_GEOMETRY_SHADER, gs,
+			GL_FRAGMENT_SHADER, fs_source,
+			0);
+	}
+	return geom_progs[index];
+}
+
+/**
+ * Bind the program and buffers of a configuration, returning false if it
+ * isn't supported.
+ */
+static bool
+setup_draw(unsigned index, unsigned amplification)
+{
+	GLuint vbo = cur_method == METHOD_ELEMENTS ||
+		     cur_method == METHOD_RESTART ? grid_vbo : list_vbo;
+
+	if ((cur_method == METHOD_INDIRECT && !has_indirect) ||
+	    (cur_method == METHOD_TESSELLATION && !has_tessellation))
+		return false;
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(0);
+
+	if (cur_method == METHOD_INSTANCED) {
+		glBindBuffer(GL_ARRAY_BUFFER, offset_vbo);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+		glVertexAttribDivisor(1, 1);
+		glEnableVertexAttribArray(1);
+	} else {
+		glDisableVertexAttribArray(1);
+		glVertexAttrib2f(1, 0, 0);
+	}
+
+	switch (cur_method) {
+	case METHOD_ARRAYS:
+	case METHOD_INDIRECT:
+		glUseProgram(prog);
+		draw_count = num_prims * 3;
+		break;
+	case METHOD_ELEMENTS:
+		glUseProgram(prog);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elem_ibo);
+		draw_count = num_prims * 3;
+		break;
+	case METHOD_RESTART:
+		glUseProgram(prog);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, strip_ibo);
+		glEnable(GL_PRIMITIVE_RESTART);
+		draw_count = rows * (2 * (row_quads + 1) + 1);
+		break;
+	case METHOD_INSTANCED:
+		glUseProgram(prog);
+		draw_count = row_quads * 6;
+		num_instances = rows;
+		break;
+	case METHOD_GEOMETRY:
+		glUseProgram(get_geometry_program(index, amplification));
+		draw_count = MAX2(1, num_prims / amplification) * 3;
+		break;
+	case METHOD_TESSELLATION:
+		glUseProgram(tess_prog);
+		glUniform1f(level_loc, amplification);
+		glPatchParameteri(GL_PATCH_VERTICES, 3);
+		/* Roughly level^2 triangles per patch. */
+		draw_count = MAX2(1, num_prims /
+				  (amplification * amplification)) * 3;
+		break;
+	default:
+		assert(!"unhandled method");
+	}
+
+	if (cur_method == METHOD_INDIRECT)
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_bo);
+
+	return true;
+}
+
+static void
+finish_draw(void)
+{
+	if (cur_method == METHOD_INSTANCED)
+		glVertexAttribDivisor(1, 0);
+	if (cur_method == METHOD_RESTART)
+		glDisable(GL_PRIMITIVE_RESTART);
+}
+
+static void
+draw(unsigned iterations)
+{
+	for (unsigned i = 0; i < iterations; i++) {
+		switch (cur_method) {
+		case METHOD_ARRAYS:
+		case METHOD_GEOMETRY:
+			glDrawArrays(GL_TRIANGLES, 0, draw_count);
+			break;
+		case METHOD_ELEMENTS:
+			glDrawElements(GL_TRIANGLES, draw_count,
+				       GL_UNSIGNED_INT, NULL);
+			break;
+		case METHOD_RESTART:
+			glDrawElements(GL_TRIANGLE_STRIP, draw_count,
+				       GL_UNSIGNED_INT, NULL);
+			break;
+		case METHOD_INSTANCED:
+			glDrawArraysInstanced(GL_TRIANGLES, 0, draw_count,
+					      num_instances);
+			break;
+		case METHOD_INDIRECT:
+			glMultiDrawArraysIndirect(GL_TRIANGLES, NULL,
+						  num_draws, 0);
+			break;
+		case METHOD_TESSELLATION:
+			glDrawArrays(GL_PATCHES, 0, draw_count);
+			break;
+		default:
+			assert(!"unhandled method");
+		}
+	}
+}
+
+/** The number of primitives rasterized by one draw. */
+static unsigned
+count_prims(void)
+{
+	GLuint query, prims;
+
+	glGenQueries(1, &query);
+	glBeginQuery(GL_PRIMITIVES_GENERATED, query);
+	draw(1);
+	glEndQuery(GL_PRIMITIVES_GENERATED);
+	glGetQueryObjectuiv(query, GL_QUERY_RESULT, &prims);
+	glDeleteQueries(1, &query);
+	return prims;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	unsigned i;
+
+	if (only_method) {
+		for (i = 0; i < METHOD_COUNT; i++) {
+			if (!strcmp(only_method, methods[i].name))
+				break;
+		}
+		if (i == METHOD_COUNT) {
+			fprintf(stderr, "unknown method %s\n", only_method);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	}
+
+	has_tessellation = piglit_get_gl_version() >= 40;
+	has_indirect = piglit_get_gl_version() >= 43 ||
+		piglit_is_extension_supported("GL_ARB_multi_draw_indirect");
+
+	prog = piglit_build_simple_program(vs_source, fs_source);
+	if (has_tessellation) {
+		tess_prog = piglit_build_simple_program_multiple_shaders(
+			GL_VERTEX_SHADER, vs_source,
+			GL_TESS_CONTROL_SHADER, tcs_source,
+			GL_TESS_EVALUATION_SHADER, tes_source,
+			GL_FRAGMENT_SHADER, fs_source,
+			0);
+		level_loc = glGetUniformLocation(tess_prog, "level");
+	}
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glPrimitiveRestartIndex(RESTART_INDEX);
+	glViewport(0, 0, WINDOW_SIZE, WINDOW_SIZE);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	printf("  %-18s, %5s, %6s, %9s, %16s, %15s\n", "Method", "Amp",
+	       "Size", "Prims", "Visible Mprims/s", "Culled Mprims/s");
+
+	for (unsigned s = 0; s < ARRAY_SIZE(sizes); s++) {
+		char size_name[16];
+
+		if (s == ARRAY_SIZE(sizes) - 1)
+			snprintf(size_name, sizeof(size_name), "full");
+		else
+			snprintf(size_name, sizeof(size_name), "%gpx",
+				 sizes[s]);
+
+		create_buffers(sizes[s]);
+
+		for (cur_method = 0; cur_method < METHOD_COUNT; cur_method++) {
+			const unsigned *amps =
+				methods[cur_method].amplifications;
+
+			if (only_method &&
+			    strcmp(only_method, methods[cur_method].name))
+				continue;
+
+			for (unsigned a = 0; amps[a]; a++) {
+				double rates[2];
+				unsigned prims;
+
+				if (!setup_draw(a, amps[a])) {
+					printf("  %-18s, %5u, %6s, %9s, %16s, "
+					       "%15s\n",
+					       methods[cur_method].name,
+					       amps[a], size_name, "-", "-",
+					       "-");
+					continue;
+				}
+
+				prims = count_prims();
+
+				for (unsigned culled = 0; culled < 2;
+				     culled++) {
+					char name[64];
+
+					if (culled) {
+						glEnable(GL_CULL_FACE);
+						glCullFace(GL_FRONT_AND_BACK);
+					}
+
+					rates[culled] = perf_measure_gpu_rate(
+						draw, duration) * prims / 1e6;
+
+					snprintf(name, sizeof(name),
+						 "%s x%u %s%s",
+						 methods[cur_method].name,
+						 amps[a], size_name,
+						 culled ? " culled" : "");
+					perf_report("draw-prim-sweep", name,
+						    "Mprims/s", prims / 1e6,
+						    perf_last_stats());
+
+					glDisable(GL_CULL_FACE);
+				}
+
+				finish_draw();
+				if (!piglit_check_gl_error(GL_NO_ERROR))
+					piglit_report_result(PIGLIT_FAIL);
+
+				printf("  %-18s, %5u, %6s, %9u, %16.1f, "
+				       "%15.1f\n",
+				       methods[cur_method].name, amps[a],
+				       size_name, prims, rates[0], rates[1]);
+			}
+		}
+
+		destroy_buffers();
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
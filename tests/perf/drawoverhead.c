@@ -29,6 +29,7 @@ static bool color = true;
 static bool is_compat;
 static int selected_test_index = -1;
 static int duration = 1;
+static bool timestamps;
 
 PIGLIT_GL_TEST_CONFIG_BEGIN
 
@@ -76,8 +77,13 @@ PIGLIT_GL_TEST_CONFIG_BEGIN
 			i++;
 		}
 
+		if (!strcmp(argv[i], "-timestamps")) {
+			timestamps = true;
+		}
+
 		if (!strcmp(argv[i], "-help")) {
-			fprintf(stderr, "drawoverhead [-compat] [-test TESTNUM] [-nocolor]\n");
+			fprintf(stderr, "drawoverhead [-compat] [-test TESTNUM] [-nocolor] "
+				"[-duration SECONDS] [-timestamps]\n");
 			exit(1);
 		}
 	}
@@ -112,6 +118,8 @@ piglit_init(int argc, char **argv)
 	GLuint vao, ebo;
 
 	piglit_require_gl_version(30);
+	if (timestamps)
+		piglit_require_extension("GL_ARB_timer_query");
 
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
@@ -866,6 +874,25 @@ perf_run(const char *call, unsigned prog_index, const char *change,
 	       color ? ratio_color : "",
 	       100 * ratio,
 	       color ? COLOR_RESET : "");
+
+	char name[256];
+	snprintf(name, sizeof(name), "%u: %s (%u VBO, %u UBO, %u Tex, %u TBO, "
+		 "%u Img, %u ImB) w/ %s", test_index, call, num_vbos, num_ubos,
+		 num_textures, num_tbos, num_images, num_imgbos, change);
+	perf_report("drawoverhead", name, "draws/sec", 1, perf_last_stats());
+
+	/* Split the time of a quarter second of draws between the driver's
+	 * CPU path and the GPU.
+	 */
+	if (timestamps) {
+		struct perf_timing timing;
+
+		perf_measure_gpu_timing(f, MAX2(rate / 4, 64), &timing);
+		printf("       CPU submit %.1f ns/draw, GPU busy %.1f ns/draw, "
+		       "CPU-GPU latency %.1f us\n",
+		       timing.cpu_submit * 1e9, timing.gpu_busy * 1e9,
+		       timing.latency * 1e6);
+	}
 	return rate;
 }
 
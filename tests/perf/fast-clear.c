@@ -0,0 +1,364 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the GPU throughput of color clears of a 1920x1080 buffer, for a
+ * few formats, 1, 2, 4 and 8 samples and two kinds of clear colors:
+ *
+ *  - 0/1: alternating between (0, 0, 0, 0) and (1, 1, 1, 1), which most
+ *    hardware can fast clear
+ *  - other: alternating between two arbitrary colors, which a lot of
+ *    hardware can't
+ *
+ * The colors alternate so that no clear is redundant.  Each clear is done
+ * in one of these ways:
+ *
+ *  - clearbuffer: glClearBufferfv of the whole buffer
+ *  - scissored: glClearBufferfv of a scissor box of half the width and
+ *    height, which usually can't be fast cleared
+ *  - cleartexture: glClearTexImage, with GL_ARB_clear_texture
+ *  - clear+resolve: glClearBufferfv followed by a glBlitFramebuffer to a
+ *    single sampled buffer, multisampled buffers only
+ *  - clear+read: glClearBufferfv followed by a glReadPixels of the whole
+ *    buffer to a pixel buffer object, single sampled buffers only
+ *
+ * The results are in cleared surfaces per second and in GB/s of pixels
+ * cleared, plus the pixels resolved or read.
+ *
+ * Usage: fast-clear [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "fast-clear [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define WIDTH 1920
+#define HEIGHT 1080
+
+static const struct {
+	GLenum internal_format;
+	GLenum format;
+	GLenum type;
+	const char *name;
+	unsigned bytes_per_pixel;
+} formats[] = {
+	{ GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, "RGBA8", 4 },
+	{ GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, "RGB10_A2", 4 },
+	{ GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV,
+	  "R11F_G11F_B10F", 4 },
+	{ GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, "RGBA16F", 8 },
+	{ GL_RGBA32F, GL_RGBA, GL_FLOAT, "RGBA32F", 16 },
+};
+
+/* The two colors each kind of clear alternates between. */
+static const struct {
+	const char *name;
+	float colors[2][4];
+} clear_colors[] = {
+	{ "0/1", { { 0.0, 0.0, 0.0, 0.0 }, { 1.0, 1.0, 1.0, 1.0 } } },
+	{ "other", { { 0.2, 0.4, 0.6, 0.8 }, { 0.8, 0.6, 0.4, 0.2 } } },
+};
+
+enum clear_mode {
+	MODE_CLEAR_BUFFER,
+	MODE_SCISSORED,
+	MODE_CLEAR_TEXTURE,
+	MODE_CLEAR_RESOLVE,
+	MODE_CLEAR_READ,
+	MODE_COUNT
+};
+
+static const char *mode_names[MODE_COUNT] = {
+	"clearbuffer",
+	"scissored",
+	"cleartexture",
+	"clear+resolve",
+	"clear+read",
+};
+
+static GLuint tex, fbo, resolve_tex, resolve_fbo, pbo;
+static bool has_clear_texture;
+
+/* The clear being measured. */
+static unsigned cur_format, cur_color, cur_samples;
+static enum clear_mode cur_mode;
+
+static GLuint
+create_fbo(GLuint tex, GLenum target)
+{
+	GLuint fbo;
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target,
+			       tex, 0);
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	return fbo;
+}
+
+static void
+destroy_buffers(void)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteFramebuffers(1, &resolve_fbo);
+	glDeleteTextures(1, &tex);
+	glDeleteTextures(1, &resolve_tex);
+	glDeleteBuffers(1, &pbo);
+	tex = fbo = resolve_tex = resolve_fbo = pbo = 0;
+}
+
+/**
+ * Create the buffers of a clear, return false if the combination isn't
+ * supported.
+ */
+static bool
+create_buffers(void)
+{
+	const GLenum ifmt = formats[cur_format].internal_format;
+	const GLenum target = cur_samples > 1 ?
+		GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+
+	glGenTextures(1, &tex);
+	glBindTexture(target, tex);
+	if (cur_samples > 1) {
+		glTexImage2DMultisample(target, cur_samples, ifmt,
+					WIDTH, HEIGHT, GL_TRUE);
+	} else {
+		glTexStorage2D(target, 1, ifmt, WIDTH, HEIGHT);
+	}
+	fbo = create_fbo(tex, target);
+
+	if (cur_mode == MODE_CLEAR_RESOLVE) {
+		glGenTextures(1, &resolve_tex);
+		glBindTexture(GL_TEXTURE_2D, resolve_tex);
+		glTexStorage2D(GL_TEXTURE_2D, 1, ifmt, WIDTH, HEIGHT);
+		resolve_fbo = create_fbo(resolve_tex, GL_TEXTURE_2D);
+	} else if (cur_mode == MODE_CLEAR_READ) {
+		glGenBuffers(1, &pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)WIDTH * HEIGHT *
+			     formats[cur_format].bytes_per_pixel, NULL,
+			     GL_STREAM_READ);
+	}
+
+	if (!piglit_check_gl_error(GL_NO_ERROR) ||
+	    glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+	    GL_FRAMEBUFFER_COMPLETE) {
+		destroy_buffers();
+		return false;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+	    GL_FRAMEBUFFER_COMPLETE) {
+		destroy_buffers();
+		return false;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+	glViewport(0, 0, WIDTH, HEIGHT);
+	return true;
+}
+
+static void
+clear_buffer(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glClearBufferfv(GL_COLOR, 0,
+				clear_colors[cur_color].colors[i & 1]);
+	}
+}
+
+static void
+clear_texture(unsigned count)
+{
+	const GLenum format = formats[cur_format].format;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glClearTexImage(tex, 0, format, GL_FLOAT,
+				clear_colors[cur_color].colors[i & 1]);
+	}
+}
+
+static void
+clear_resolve(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+		glClearBufferfv(GL_COLOR, 0,
+				clear_colors[cur_color].colors[i & 1]);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolve_fbo);
+		glBlitFramebuffer(0, 0, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT,
+				  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+}
+
+static void
+clear_read(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glClearBufferfv(GL_COLOR, 0,
+				clear_colors[cur_color].colors[i & 1]);
+		glReadPixels(0, 0, WIDTH, HEIGHT, formats[cur_format].format,
+			     formats[cur_format].type, NULL);
+	}
+}
+
+static const perf_rate_func mode_funcs[MODE_COUNT] = {
+	clear_buffer,
+	clear_buffer,
+	clear_texture,
+	clear_resolve,
+	clear_read,
+};
+
+static bool
+mode_supported(void)
+{
+	switch (cur_mode) {
+	case MODE_CLEAR_TEXTURE:
+		return has_clear_texture;
+	case MODE_CLEAR_RESOLVE:
+		return cur_samples > 1;
+	case MODE_CLEAR_READ:
+		return cur_samples == 1;
+	default:
+		return true;
+	}
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	piglit_require_extension("GL_ARB_texture_storage");
+	has_clear_texture =
+		piglit_is_extension_supported("GL_ARB_clear_texture");
+}
+
+static void
+print_row(const char *surfaces, const char *gbs)
+{
+	printf("  %-14s, %7u, %-5s, %-13s, %10s, %8s\n",
+	       formats[cur_format].name, cur_samples,
+	       clear_colors[cur_color].name, mode_names[cur_mode],
+	       surfaces, gbs);
+}
+
+/** Measure the current clear and print and report its rate. */
+static void
+measure(void)
+{
+	const unsigned bpp = formats[cur_format].bytes_per_pixel;
+	const bool scissored = cur_mode == MODE_SCISSORED;
+	/* All samples written, plus one pixel of the resolve or read. */
+	double bytes = (double)WIDTH * HEIGHT * cur_samples * bpp;
+	char name[64], surfaces[16], gbs[16];
+	double rate;
+
+	if (scissored)
+		bytes /= 4;
+	if (cur_mode == MODE_CLEAR_RESOLVE || cur_mode == MODE_CLEAR_READ)
+		bytes += (double)WIDTH * HEIGHT * bpp;
+
+	if (!mode_supported() || !create_buffers()) {
+		print_row("-", "-");
+		return;
+	}
+
+	if (scissored) {
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(WIDTH / 4, HEIGHT / 4, WIDTH / 2, HEIGHT / 2);
+	}
+
+	rate = perf_measure_gpu_rate(mode_funcs[cur_mode], duration);
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+	glDisable(GL_SCISSOR_TEST);
+	destroy_buffers();
+
+	snprintf(surfaces, sizeof(surfaces), "%.1f", rate);
+	snprintf(gbs, sizeof(gbs), "%.1f", rate * bytes / 1e9);
+	print_row(surfaces, gbs);
+
+	snprintf(name, sizeof(name), "%s %ux %s %s",
+		 formats[cur_format].name, cur_samples,
+		 clear_colors[cur_color].name, mode_names[cur_mode]);
+	perf_report("fast-clear", name, "GB/s", bytes / 1e9,
+		    perf_last_stats());
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	GLint max_samples;
+
+	glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &max_samples);
+
+	printf("  %-14s, %7s, %-5s, %-13s, %10s, %8s\n", "Format", "Samples",
+	       "Color", "Clear", "Surfaces/s", "GB/s");
+
+	for (cur_format = 0; cur_format < ARRAY_SIZE(formats); cur_format++) {
+		for (cur_samples = 1; cur_samples <= 8 &&
+		     (GLint)cur_samples <= max_samples; cur_samples *= 2) {
+			for (cur_color = 0; cur_color < ARRAY_SIZE(clear_colors);
+			     cur_color++) {
+				for (cur_mode = 0; cur_mode < MODE_COUNT;
+				     cur_mode++)
+					measure();
+			}
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
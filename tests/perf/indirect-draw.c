@@ -0,0 +1,409 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure frames of N small objects, about a quarter of which are in view,
+ * culled and drawn in these ways:
+ *
+ *  - loop: culled on the CPU, one glDrawElementsBaseVertex per object, as
+ *    drawoverhead does
+ *  - multidraw: culled on the CPU, one glMultiDrawElementsBaseVertex
+ *  - mdi: culled on the CPU, the commands uploaded for one
+ *    glMultiDrawElementsIndirect
+ *  - gpu-cull: culled by a compute shader writing a command for every
+ *    object, with an instance count of 0 for the culled ones, for one
+ *    glMultiDrawElementsIndirect of N
+ *  - gpu-cull+count: culled by a compute shader appending the commands of
+ *    the visible objects, drawn with glMultiDrawElementsIndirectCountARB
+ *    and the count it wrote (GL_ARB_indirect_parameters)
+ *
+ * The draw rate counts the N objects of each frame, visible or not, at the
+ * rate frames complete on the GPU.  The CPU time per frame is that of the
+ * calls alone.
+ *
+ * Usage: indirect-draw [-duration SECONDS]
+ */
+
+#include <math.h>
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "indirect-draw [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define MAX_OBJECTS 65536
+/* Half the size of an object in clip space. */
+#define OBJECT_RADIUS 0.002f
+
+enum mode {
+	MODE_LOOP,
+	MODE_MULTIDRAW,
+	MODE_MDI,
+	MODE_GPU_CULL,
+	MODE_GPU_CULL_COUNT,
+	NUM_MODES
+};
+
+static const char *mode_names[NUM_MODES] = {
+	"loop",
+	"multidraw",
+	"mdi",
+	"gpu-cull",
+	"gpu-cull+count",
+};
+
+static const unsigned object_counts[] = { 256, 1024, 4096, 16384, 65536 };
+
+struct draw_command {
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;
+};
+
+static const char *vs_source =
+	"#version 150\n"
+	"in vec2 pos;\n"
+	"void main() {\n"
+	"	gl_Position = vec4(pos, 0.0, 1.0);\n"
+	"}\n";
+
+static const char *fs_source =
+	"#version 150\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = vec4(1.0);\n"
+	"}\n";
+
+static const char *cs_source =
+	"#version 430\n"
+	"layout(local_size_x = 64) in;\n"
+	"struct Command {\n"
+	"	uint count, instance_count, first_index;\n"
+	"	int base_vertex;\n"
+	"	uint base_instance;\n"
+	"};\n"
+	"layout(std430, binding = 0) readonly buffer Objects {\n"
+	"	vec4 objects[];\n"
+	"};\n"
+	"layout(std430, binding = 1) writeonly buffer Commands {\n"
+	"	Command commands[];\n"
+	"};\n"
+	"layout(std430, binding = 2) buffer Count {\n"
+	"	uint draw_count;\n"
+	"};\n"
+	"uniform uint num_objects;\n"
+	"uniform bool compact;\n"
+	"void main() {\n"
+	"	uint i = gl_GlobalInvocationID.x;\n"
+	"	if (i >= num_objects)\n"
+	"		return;\n"
+	"	vec4 o = objects[i];\n"
+	"	bool visible = all(lessThanEqual(abs(o.xy), vec2(1.0 + o.z)));\n"
+	"	uint slot = i;\n"
+	"	if (compact) {\n"
+	"		if (!visible)\n"
+	"			return;\n"
+	"		slot = atomicAdd(draw_count, 1u);\n"
+	"	}\n"
+	"	commands[slot] = Command(6u, visible ? 1u : 0u, 0u,\n"
+	"				 int(i * 4u), 0u);\n"
+	"}\n";
+
+static GLuint draw_prog, cull_prog;
+static GLuint object_buf, gpu_cmd_buf, count_buf, cpu_cmd_buf;
+static GLint num_objects_loc, compact_loc;
+static bool has_indirect_count;
+
+/* The object centers and radii, as in the Objects block. */
+static float objects[MAX_OBJECTS][4];
+
+/* The commands of the CPU culling modes. */
+static GLsizei counts[MAX_OBJECTS];
+static const void *offsets[MAX_OBJECTS];
+static GLint base_vertices[MAX_OBJECTS];
+static struct draw_command commands[MAX_OBJECTS];
+
+/* The case being measured. */
+static enum mode cur_mode;
+static unsigned cur_objects;
+
+static bool
+mode_supported(enum mode mode)
+{
+	return mode != MODE_GPU_CULL_COUNT || has_indirect_count;
+}
+
+/** Return how many objects are in view, and fill the commands for them. */
+static unsigned
+cpu_cull(void)
+{
+	unsigned i, n = 0;
+
+	for (i = 0; i < cur_objects; i++) {
+		const float limit = 1.0f + objects[i][2];
+
+		if (fabsf(objects[i][0]) > limit ||
+		    fabsf(objects[i][1]) > limit)
+			continue;
+
+		if (cur_mode == MODE_MDI) {
+			commands[n].count = 6;
+			commands[n].instance_count = 1;
+			commands[n].first_index = 0;
+			commands[n].base_vertex = i * 4;
+			commands[n].base_instance = 0;
+		} else {
+			counts[n] = 6;
+			offsets[n] = NULL;
+			base_vertices[n] = i * 4;
+		}
+		n++;
+	}
+
+	return n;
+}
+
+static void
+gpu_cull(bool compact)
+{
+	static const GLuint zero = 0;
+
+	glUseProgram(cull_prog);
+	glUniform1ui(num_objects_loc, cur_objects);
+	glUniform1i(compact_loc, compact);
+	if (compact) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, count_buf);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero),
+				&zero);
+	}
+	glDispatchCompute((cur_objects + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+	glUseProgram(draw_prog);
+}
+
+static void
+draw_frames(unsigned frames)
+{
+	unsigned f, i, n;
+
+	for (f = 0; f < frames; f++) {
+		switch (cur_mode) {
+		case MODE_LOOP:
+			n = cpu_cull();
+			for (i = 0; i < n; i++)
+				glDrawElementsBaseVertex(GL_TRIANGLES, 6,
+							 GL_UNSIGNED_INT, NULL,
+							 base_vertices[i]);
+			break;
+		case MODE_MULTIDRAW:
+			n = cpu_cull();
+			glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts,
+						      GL_UNSIGNED_INT,
+						      offsets, n,
+						      base_vertices);
+			break;
+		case MODE_MDI:
+			n = cpu_cull();
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cpu_cmd_buf);
+			glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+					n * sizeof(commands[0]), commands);
+			glMultiDrawElementsIndirect(GL_TRIANGLES,
+						    GL_UNSIGNED_INT, NULL, n,
+						    0);
+			break;
+		case MODE_GPU_CULL:
+			gpu_cull(false);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gpu_cmd_buf);
+			glMultiDrawElementsIndirect(GL_TRIANGLES,
+						    GL_UNSIGNED_INT, NULL,
+						    cur_objects, 0);
+			break;
+		case MODE_GPU_CULL_COUNT:
+			gpu_cull(true);
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gpu_cmd_buf);
+			glBindBuffer(GL_PARAMETER_BUFFER_ARB, count_buf);
+			glMultiDrawElementsIndirectCountARB(GL_TRIANGLES,
+							    GL_UNSIGNED_INT,
+							    NULL, 0,
+							    cur_objects, 0);
+			break;
+		default:
+			assert(0);
+		}
+	}
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const GLuint indices[6] = { 0, 1, 2, 2, 1, 3 };
+	float (*vertices)[2];
+	GLuint vao, vbo, ebo;
+	unsigned i;
+
+	piglit_require_gl_version(43);
+	has_indirect_count = piglit_get_gl_version() >= 46 ||
+		piglit_is_extension_supported("GL_ARB_indirect_parameters");
+
+	draw_prog = piglit_build_simple_program(vs_source, fs_source);
+	cull_prog = piglit_build_simple_program_multiple_shaders(
+		GL_COMPUTE_SHADER, cs_source, 0);
+	num_objects_loc = glGetUniformLocation(cull_prog, "num_objects");
+	compact_loc = glGetUniformLocation(cull_prog, "compact");
+
+	/* Scatter the objects over twice the view in each direction, so
+	 * that about a quarter of the first N are visible, in no particular
+	 * order.
+	 */
+	srand(0);
+	vertices = malloc(MAX_OBJECTS * 4 * sizeof(vertices[0]));
+	for (i = 0; i < MAX_OBJECTS; i++) {
+		float x = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+		float y = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+		unsigned v;
+
+		objects[i][0] = x;
+		objects[i][1] = y;
+		objects[i][2] = OBJECT_RADIUS;
+		objects[i][3] = 0;
+
+		for (v = 0; v < 4; v++) {
+			vertices[i * 4 + v][0] =
+				x + (v & 1 ? OBJECT_RADIUS : -OBJECT_RADIUS);
+			vertices[i * 4 + v][1] =
+				y + (v & 2 ? OBJECT_RADIUS : -OBJECT_RADIUS);
+		}
+	}
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, MAX_OBJECTS * 4 * sizeof(vertices[0]),
+		     vertices, GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(0);
+	glBindAttribLocation(draw_prog, 0, "pos");
+	glLinkProgram(draw_prog);
+	free(vertices);
+
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
+		     GL_STATIC_DRAW);
+
+	glGenBuffers(1, &object_buf);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, object_buf);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(objects), objects,
+		     GL_STATIC_DRAW);
+
+	glGenBuffers(1, &gpu_cmd_buf);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gpu_cmd_buf);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(commands), NULL,
+		     GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &count_buf);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, count_buf);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), NULL,
+		     GL_DYNAMIC_DRAW);
+
+	glGenBuffers(1, &cpu_cmd_buf);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cpu_cmd_buf);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(commands), NULL,
+		     GL_STREAM_DRAW);
+
+	glUseProgram(draw_prog);
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	unsigned m, c;
+
+	printf("  %-16s, %7s, %10s, %14s\n", "Mode", "Objects", "Mdraws/s",
+	       "CPU usec/frame");
+
+	for (m = 0; m < NUM_MODES; m++) {
+		for (c = 0; c < ARRAY_SIZE(object_counts); c++) {
+			double frame_rate, cpu_rate;
+			char name[64];
+
+			cur_mode = m;
+			cur_objects = object_counts[c];
+
+			if (!mode_supported(cur_mode)) {
+				printf("  %-16s, %7u, %10s, %14s\n",
+				       mode_names[m], cur_objects, "-", "-");
+				continue;
+			}
+
+			frame_rate = perf_measure_gpu_rate(draw_frames,
+							   duration);
+			snprintf(name, sizeof(name), "%s %u", mode_names[m],
+				 cur_objects);
+			perf_report("indirect-draw", name, "draws/s",
+				    cur_objects, perf_last_stats());
+
+			cpu_rate = perf_measure_cpu_rate(draw_frames, duration);
+			snprintf(name, sizeof(name), "%s %u cpu", mode_names[m],
+				 cur_objects);
+			perf_report("indirect-draw", name, "frames/s", 1,
+				    perf_last_stats());
+			glFinish();
+
+			if (!piglit_check_gl_error(GL_NO_ERROR))
+				piglit_report_result(PIGLIT_FAIL);
+
+			printf("  %-16s, %7u, %10.2f, %14.1f\n", mode_names[m],
+			       cur_objects, frame_rate * cur_objects / 1000000,
+			       1000000 / cpu_rate);
+			fflush(stdout);
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,372 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the GPU throughput of multisample resolves of a 1920x1080
+ * framebuffer, for 2, 4, 8 and 16 samples and a few color and depth
+ * formats:
+ *
+ *  - blit: glBlitFramebuffer to a single sampled buffer of the same size
+ *  - scaled fastest and nicest: glBlitFramebuffer to a buffer of 2/3 the
+ *    size with GL_EXT_framebuffer_multisample_blit_scaled, color only
+ *  - shader: a fragment shader averaging the samples with texelFetch(),
+ *    color only, for comparison
+ *
+ * The multisampled buffer holds a fan of thin triangles, so that many
+ * pixels have samples of different values.
+ *
+ * Usage: msaa-resolve [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "msaa-resolve [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define WIDTH 1920
+#define HEIGHT 1080
+#define SCALED_WIDTH (WIDTH * 2 / 3)
+#define SCALED_HEIGHT (HEIGHT * 2 / 3)
+/* Triangles of the fan drawn to the multisampled buffer. */
+#define NUM_TRIANGLES 1024
+
+static const struct {
+	GLenum internal_format;
+	const char *name;
+	unsigned bytes_per_pixel;
+	bool depth;
+} formats[] = {
+	{ GL_RGBA8, "RGBA8", 4, false },
+	{ GL_RGB10_A2, "RGB10_A2", 4, false },
+	{ GL_R11F_G11F_B10F, "R11F_G11F_B10F", 4, false },
+	{ GL_RGBA16F, "RGBA16F", 8, false },
+	{ GL_DEPTH_COMPONENT24, "DEPTH24", 4, true },
+	{ GL_DEPTH_COMPONENT32F, "DEPTH32F", 4, true },
+};
+
+enum resolve_mode {
+	MODE_BLIT,
+	MODE_SCALED_FASTEST,
+	MODE_SCALED_NICEST,
+	MODE_SHADER,
+	MODE_COUNT
+};
+
+static const char *mode_names[MODE_COUNT] = {
+	"blit",
+	"scaled fastest",
+	"scaled nicest",
+	"shader",
+};
+
+static GLuint vao, fill_prog, resolve_prog;
+static GLint samples_loc;
+static GLuint src_fbo, src_tex, dst_fbo, dst_tex;
+static bool has_blit_scaled;
+
+/* The resolve being measured. */
+static unsigned cur_format;
+static enum resolve_mode cur_mode;
+
+static const char *fill_vs_source =
+	"#version 150\n"
+	"void main() {\n"
+	"	vec2 pos = vec2(0.0);\n"
+	"	if (gl_VertexID != 0) {\n"
+	"		float angle = float(gl_VertexID) * 6.2831853 / "
+	"%d.0;\n"
+	"		pos = 2.0 * vec2(cos(angle), sin(angle));\n"
+	"	}\n"
+	"	gl_Position = vec4(pos, fract(float(gl_VertexID) * 0.618) * "
+	"1.8 - 0.9, 1.0);\n"
+	"}\n";
+
+static const char *fill_fs_source =
+	"#version 150\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	float h = fract(sin(float(gl_PrimitiveID)) * 43758.5453);\n"
+	"	color = vec4(h, fract(h * 7.0), fract(h * 13.0), 1.0);\n"
+	"}\n";
+
+static const char *resolve_vs_source =
+	"#version 150\n"
+	"void main() {\n"
+	"	gl_Position = vec4(gl_VertexID == 1 ? 3.0 : -1.0,\n"
+	"			   gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0);\n"
+	"}\n";
+
+static const char *resolve_fs_source =
+	"#version 150\n"
+	"uniform sampler2DMS tex;\n"
+	"uniform int samples;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	ivec2 p = ivec2(gl_FragCoord.xy);\n"
+	"	vec4 sum = vec4(0.0);\n"
+	"	for (int i = 0; i < samples; i++)\n"
+	"		sum += texelFetch(tex, p, i);\n"
+	"	color = sum / float(samples);\n"
+	"}\n";
+
+static GLuint
+create_fbo(GLuint tex, GLenum target, bool depth)
+{
+	GLuint fbo;
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER,
+			       depth ? GL_DEPTH_ATTACHMENT :
+			       GL_COLOR_ATTACHMENT0, target, tex, 0);
+	glDrawBuffer(depth ? GL_NONE : GL_COLOR_ATTACHMENT0);
+	glReadBuffer(depth ? GL_NONE : GL_COLOR_ATTACHMENT0);
+	return fbo;
+}
+
+static void
+destroy_buffers(void)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &src_fbo);
+	glDeleteFramebuffers(1, &dst_fbo);
+	glDeleteTextures(1, &src_tex);
+	glDeleteTextures(1, &dst_tex);
+	src_fbo = dst_fbo = src_tex = dst_tex = 0;
+}
+
+/**
+ * Create the framebuffers of a resolve and fill the multisampled one,
+ * return false if the combination isn't supported.
+ */
+static bool
+create_buffers(unsigned samples, unsigned dst_width, unsigned dst_height)
+{
+	const GLenum ifmt = formats[cur_format].internal_format;
+	const bool depth = formats[cur_format].depth;
+
+	glGenTextures(1, &src_tex);
+	glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, src_tex);
+	glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, samples, ifmt,
+				WIDTH, HEIGHT, GL_TRUE);
+	src_fbo = create_fbo(src_tex, GL_TEXTURE_2D_MULTISAMPLE, depth);
+
+	glGenTextures(1, &dst_tex);
+	glBindTexture(GL_TEXTURE_2D, dst_tex);
+	glTexStorage2D(GL_TEXTURE_2D, 1, ifmt, dst_width, dst_height);
+	dst_fbo = create_fbo(dst_tex, GL_TEXTURE_2D, depth);
+
+	if (!piglit_check_gl_error(GL_NO_ERROR) ||
+	    glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+	    GL_FRAMEBUFFER_COMPLETE) {
+		destroy_buffers();
+		return false;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, src_fbo);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+	    GL_FRAMEBUFFER_COMPLETE) {
+		destroy_buffers();
+		return false;
+	}
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_ALWAYS);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glUseProgram(fill_prog);
+	glDrawArrays(GL_TRIANGLE_FAN, 0, NUM_TRIANGLES + 2);
+	glDisable(GL_DEPTH_TEST);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, src_fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+	glViewport(0, 0, dst_width, dst_height);
+	return true;
+}
+
+static void
+resolve_blit(unsigned count)
+{
+	const bool depth = formats[cur_format].depth;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glBlitFramebuffer(0, 0, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT,
+				  depth ? GL_DEPTH_BUFFER_BIT :
+				  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+}
+
+static void
+resolve_scaled(unsigned count)
+{
+	const GLenum filter = cur_mode == MODE_SCALED_FASTEST ?
+		GL_SCALED_RESOLVE_FASTEST_EXT : GL_SCALED_RESOLVE_NICEST_EXT;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glBlitFramebuffer(0, 0, WIDTH, HEIGHT,
+				  0, 0, SCALED_WIDTH, SCALED_HEIGHT,
+				  GL_COLOR_BUFFER_BIT, filter);
+	}
+}
+
+static void
+resolve_shader(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++)
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static const perf_rate_func mode_funcs[MODE_COUNT] = {
+	resolve_blit,
+	resolve_scaled,
+	resolve_scaled,
+	resolve_shader,
+};
+
+static bool
+mode_supported(void)
+{
+	if (cur_mode == MODE_BLIT)
+		return true;
+	if (formats[cur_format].depth)
+		return false;
+	if (cur_mode == MODE_SHADER)
+		return true;
+	return has_blit_scaled;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	char fill_vs[512];
+
+	piglit_require_extension("GL_ARB_texture_storage");
+	has_blit_scaled = piglit_is_extension_supported(
+		"GL_EXT_framebuffer_multisample_blit_scaled");
+
+	snprintf(fill_vs, sizeof(fill_vs), fill_vs_source, NUM_TRIANGLES);
+	fill_prog = piglit_build_simple_program(fill_vs, fill_fs_source);
+	resolve_prog = piglit_build_simple_program(resolve_vs_source,
+						   resolve_fs_source);
+	samples_loc = glGetUniformLocation(resolve_prog, "samples");
+
+	/* Both programs only use gl_VertexID. */
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	GLint max_color_samples, max_depth_samples;
+	unsigned samples;
+
+	glGetIntegerv(GL_MAX_COLOR_TEXTURE_SAMPLES, &max_color_samples);
+	glGetIntegerv(GL_MAX_DEPTH_TEXTURE_SAMPLES, &max_depth_samples);
+
+	printf("  %-14s, %7s, %-14s, %10s, %8s\n", "Format", "Samples",
+	       "Resolve", "Gpixels/s", "GB/s");
+
+	for (cur_format = 0; cur_format < ARRAY_SIZE(formats); cur_format++) {
+		const unsigned bpp = formats[cur_format].bytes_per_pixel;
+		const GLint max_samples = formats[cur_format].depth ?
+			max_depth_samples : max_color_samples;
+
+		for (samples = 2; samples <= 16; samples *= 2) {
+			for (cur_mode = 0; cur_mode < MODE_COUNT; cur_mode++) {
+				const bool scaled =
+					cur_mode == MODE_SCALED_FASTEST ||
+					cur_mode == MODE_SCALED_NICEST;
+				const unsigned dst_width =
+					scaled ? SCALED_WIDTH : WIDTH;
+				const unsigned dst_height =
+					scaled ? SCALED_HEIGHT : HEIGHT;
+				/* All samples read, one pixel written. */
+				const double bytes = (double)WIDTH * HEIGHT *
+					samples * bpp +
+					(double)dst_width * dst_height * bpp;
+				char name[64];
+				double rate;
+
+				if (samples > max_samples || !mode_supported() ||
+				    !create_buffers(samples, dst_width,
+						    dst_height)) {
+					printf("  %-14s, %7u, %-14s, %10s, %8s\n",
+					       formats[cur_format].name, samples,
+					       mode_names[cur_mode], "-", "-");
+					continue;
+				}
+
+				if (cur_mode == MODE_SHADER) {
+					glUseProgram(resolve_prog);
+					glUniform1i(samples_loc, samples);
+					glBindTexture(GL_TEXTURE_2D_MULTISAMPLE,
+						      src_tex);
+				}
+
+				rate = perf_measure_gpu_rate(
+					mode_funcs[cur_mode], duration);
+				if (!piglit_check_gl_error(GL_NO_ERROR))
+					piglit_report_result(PIGLIT_FAIL);
+				destroy_buffers();
+
+				printf("  %-14s, %7u, %-14s, %10.2f, %8.1f\n",
+				       formats[cur_format].name, samples,
+				       mode_names[cur_mode],
+				       rate * WIDTH * HEIGHT / 1e9,
+				       rate * bytes / 1e9);
+
+				snprintf(name, sizeof(name), "%s %ux %s",
+					 formats[cur_format].name, samples,
+					 mode_names[cur_mode]);
+				perf_report("msaa-resolve", name, "GB/s",
+					    bytes / 1e9, perf_last_stats());
+			}
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,309 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure how submission scales with the number of threads, each with its
+ * own context sharing objects with the others.
+ *
+ * Every iteration of every thread uploads vertex data and a texture, and
+ * draws with them to the thread's framebuffer object, using a program
+ * shared by all contexts.  Each batch of iterations ends with a fence the
+ * thread waits on.  The scaling efficiency is the rate of N threads
+ * divided by N times the rate of a single thread; a driver that takes
+ * locks on these paths shows up well below 100%.
+ *
+ * Usage: multithread-submit [-threads N] [-duration SECONDS]
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef PIGLIT_HAS_X11
+#include <X11/Xlib.h>
+#endif
+
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static unsigned max_threads;
+static double duration = 1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+#ifdef PIGLIT_HAS_X11
+	/* The contexts of the other threads use the display too. */
+	XInitThreads();
+#endif
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+			max_threads = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "multithread-submit [-threads N] "
+				"[-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define FB_SIZE 64
+#define TEX_SIZE 32
+#define NUM_VERTICES 1024
+/* Iterations between two fences. */
+#define BATCH 16
+
+struct thread_data {
+	pthread_t thread;
+	void *ctx;
+	bool ok;
+	unsigned iterations;
+	double elapsed;
+};
+
+static GLuint prog;
+
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static unsigned num_ready;
+static bool go;
+
+static const char *vs_source =
+	"#version 150\n"
+	"in vec2 pos;\n"
+	"out vec2 texcoord;\n"
+	"void main() {\n"
+	"	texcoord = pos * 0.5 + 0.5;\n"
+	"	gl_Position = vec4(pos, 0.0, 1.0);\n"
+	"}\n";
+
+static const char *fs_source =
+	"#version 150\n"
+	"uniform sampler2D tex;\n"
+	"in vec2 texcoord;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	color = texture(tex, texcoord);\n"
+	"}\n";
+
+/** Wait for all of the threads to be set up, then start them together. */
+static void
+wait_for_start(void)
+{
+	pthread_mutex_lock(&mutex);
+	num_ready++;
+	pthread_cond_broadcast(&cond);
+	while (!go)
+		pthread_cond_wait(&cond, &mutex);
+	pthread_mutex_unlock(&mutex);
+}
+
+static void *
+thread_main(void *arg)
+{
+	struct thread_data *data = arg;
+	static float vertices[NUM_VERTICES][2];
+	static uint32_t texels[TEX_SIZE * TEX_SIZE];
+	GLuint fbo, rb, vao, vbo, tex;
+
+	data->ok = piglit_make_shared_context_current(data->ctx);
+	if (!data->ok) {
+		wait_for_start();
+		return NULL;
+	}
+
+	/* Framebuffers and vertex arrays aren't shared, so each thread has
+	 * its own along with its buffer and texture.
+	 */
+	glGenRenderbuffers(1, &rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, FB_SIZE, FB_SIZE);
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				  GL_RENDERBUFFER, rb);
+	glViewport(0, 0, FB_SIZE, FB_SIZE);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), NULL, GL_STREAM_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glEnableVertexAttribArray(0);
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TEX_SIZE, TEX_SIZE, 0,
+		     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	glUseProgram(prog);
+
+	data->ok = glCheckFramebufferStatus(GL_FRAMEBUFFER) ==
+		   GL_FRAMEBUFFER_COMPLETE && piglit_check_gl_error(GL_NO_ERROR);
+
+	wait_for_start();
+
+	int64_t start = piglit_time_get_nano();
+	int64_t end = start + duration * 1000000000.0;
+	int64_t now;
+	do {
+		for (unsigned i = 0; i < BATCH; i++) {
+			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices),
+					vertices);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+					TEX_SIZE, TEX_SIZE, GL_RGBA,
+					GL_UNSIGNED_BYTE, texels);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+
+		GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+				 1000000000);
+		glDeleteSync(fence);
+
+		data->iterations += BATCH;
+		now = piglit_time_get_nano();
+	} while (now < end);
+	data->elapsed = (now - start) * 0.000000001;
+
+	glDeleteTextures(1, &tex);
+	glDeleteBuffers(1, &vbo);
+	glDeleteVertexArrays(1, &vao);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteRenderbuffers(1, &rb);
+	glFinish();
+
+	piglit_make_shared_context_current(NULL);
+	return NULL;
+}
+
+/** Return the total iterations per second of num_threads threads. */
+static double
+run_threads(unsigned num_threads)
+{
+	struct thread_data *data = calloc(num_threads, sizeof(*data));
+	double rate = 0;
+	bool ok = true;
+	unsigned i;
+
+	/* Contexts are created here, the threads only make them current. */
+	for (i = 0; i < num_threads; i++) {
+		data[i].ctx = piglit_create_shared_context();
+		if (!data[i].ctx) {
+			printf("Failed to create a shared context\n");
+			piglit_report_result(PIGLIT_SKIP);
+		}
+	}
+
+	num_ready = 0;
+	go = false;
+	for (i = 0; i < num_threads; i++)
+		pthread_create(&data[i].thread, NULL, thread_main, &data[i]);
+
+	pthread_mutex_lock(&mutex);
+	while (num_ready < num_threads)
+		pthread_cond_wait(&cond, &mutex);
+	go = true;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&mutex);
+
+	for (i = 0; i < num_threads; i++) {
+		pthread_join(data[i].thread, NULL);
+		ok = ok && data[i].ok;
+		if (data[i].ok)
+			rate += data[i].iterations / data[i].elapsed;
+		piglit_destroy_shared_context(data[i].ctx);
+	}
+	free(data);
+
+	if (!ok) {
+		printf("Failed to set up a context in a thread\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+	return rate;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	if (!max_threads)
+		max_threads = MIN2(sysconf(_SC_NPROCESSORS_ONLN), 16);
+	max_threads = MAX2(max_threads, 1);
+
+	prog = piglit_build_simple_program_multiple_shaders(
+		GL_VERTEX_SHADER, vs_source,
+		GL_FRAGMENT_SHADER, fs_source,
+		0);
+	glBindAttribLocation(prog, 0, "pos");
+	glLinkProgram(prog);
+	if (!piglit_link_check_status(prog))
+		piglit_report_result(PIGLIT_FAIL);
+
+	/* Make sure the program is complete before other contexts use it. */
+	glFinish();
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	double samples[PERF_MAX_SAMPLES];
+	unsigned repeat = perf_repeat_count();
+	double base_rate = 0;
+	unsigned n = 1;
+
+	printf("  Threads, Thousands iterations/s, Scaling efficiency\n");
+
+	while (true) {
+		struct perf_stats stats;
+		char name[32];
+
+		for (unsigned r = 0; r < repeat; r++)
+			samples[r] = run_threads(n);
+		perf_compute_stats(samples, repeat, &stats);
+
+		if (n == 1)
+			base_rate = stats.median;
+
+		printf("  %7u, %22.1f, %17.1f%%\n", n, stats.median / 1000,
+		       100 * stats.median / (n * base_rate));
+
+		snprintf(name, sizeof(name), "%u threads", n);
+		perf_report("multithread-submit", name, "iterations/sec", 1,
+			    &stats);
+
+		if (n == max_threads)
+			break;
+		n = MIN2(n * 2, max_threads);
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
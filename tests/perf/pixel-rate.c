@@ -258,7 +258,8 @@ piglit_display(void)
 		}
 	}
 
-	GLuint queries[ARRAY_SIZE(progs)][ARRAY_SIZE(fbs)];
+	GLuint queries[ARRAY_SIZE(progs)][ARRAY_SIZE(fbs)][PERF_MAX_SAMPLES];
+	unsigned repeat = perf_repeat_count();
 
 	/* Gather times. */
 	for (unsigned i = 0; i < ARRAY_SIZE(progs); i++) {
@@ -269,7 +270,8 @@ piglit_display(void)
 				continue;
 
 			glBindFramebuffer(GL_FRAMEBUFFER, fbs[j].fbo);
-			queries[i][j] = perf_measure_gpu_time_get_query(run_draw, NUM_ITER);
+			for (unsigned r = 0; r < repeat; r++)
+				queries[i][j][r] = perf_measure_gpu_time_get_query(run_draw, NUM_ITER);
 		}
 	}
 
@@ -292,14 +294,26 @@ piglit_display(void)
 				continue;
 			}
 
-			double rate = perf_get_throughput_from_query(queries[i][j], NUM_ITER);
-			rate *= (double)TEST_FBO_SIZE * TEST_FBO_SIZE * MAX2(fbs[j].num_samples, 1);
+			double samples[PERF_MAX_SAMPLES];
+			struct perf_stats stats;
+			char name[128];
 
+			for (unsigned r = 0; r < repeat; r++) {
+				samples[r] = perf_get_throughput_from_query(queries[i][j][r], NUM_ITER);
+				samples[r] *= (double)TEST_FBO_SIZE * TEST_FBO_SIZE * MAX2(fbs[j].num_samples, 1);
+			}
+			perf_compute_stats(samples, repeat, &stats);
+			double rate = stats.median;
+
+			snprintf(name, sizeof(name), "%s, %s", progs[i].name, fbs[j].name);
 			if (gpu_freq_mhz) {
 				rate /= gpu_freq_mhz * 1000000.0;
 				printf(",%10.2f", rate);
+				perf_report("pixel-rate", name, "samples/clock",
+					    1 / (gpu_freq_mhz * 1000000.0), &stats);
 			} else {
 				printf(",%10.2f", rate / 1000000000);
+				perf_report("pixel-rate", name, "samples/sec", 1, &stats);
 			}
 			fflush(stdout);
 		}
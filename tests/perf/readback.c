@@ -0,0 +1,422 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure how fast the pixels of a rectangle of an RGBA8 framebuffer get to
+ * client memory, from a 1x1 probe up to a whole 3840x2160 frame, for
+ * several formats and types, including ones that the driver may have to
+ * convert to on the CPU, and these ways of reading:
+ *
+ *  - readpixels: glReadPixels to client memory
+ *  - pbo+fence: glReadPixels to a pixel buffer object, a fence waited on,
+ *    then the buffer mapped and copied
+ *  - pbo-async: the same with PBO_RING buffers in flight, copying the one
+ *    read PBO_RING - 1 iterations before, which only hides the latency
+ *  - gettexsubimage: glGetTextureSubImage of the framebuffer's texture,
+ *    with GL 4.5 or GL_ARB_get_texture_sub_image
+ *  - compute: a compute shader copying the pixels to a shader storage
+ *    buffer, which is then mapped and copied, with GL 4.3 and for the
+ *    formats that GLSL can pack
+ *
+ * Before each read a pixel of the rectangle is cleared, so that every read
+ * waits for rendering like the probes of a test do.  The results are in
+ * reads per second, the GB/s of pixels read are also printed.
+ *
+ * Usage: readback [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "readback [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define WIDTH 3840
+#define HEIGHT 2160
+/* PBOs in flight for pbo-async. */
+#define PBO_RING 3
+
+static const struct {
+	GLenum format;
+	GLenum type;
+	const char *name;
+	unsigned pixel_size;
+	/* The GLSL type and the expression packing vec4 c to it, for the
+	 * compute copy, NULL if there is none.
+	 */
+	const char *glsl_type;
+	const char *glsl_pack;
+} formats[] = {
+	{ GL_RGBA, GL_UNSIGNED_BYTE, "RGBA/ubyte", 4,
+	  "uint", "packUnorm4x8(c)" },
+	{ GL_BGRA, GL_UNSIGNED_BYTE, "BGRA/ubyte", 4,
+	  "uint", "packUnorm4x8(c.bgra)" },
+	{ GL_RGB, GL_UNSIGNED_BYTE, "RGB/ubyte", 3, NULL, NULL },
+	{ GL_RED, GL_UNSIGNED_BYTE, "R/ubyte", 1, NULL, NULL },
+	{ GL_RGB, GL_UNSIGNED_SHORT_5_6_5, "RGB/565", 2, NULL, NULL },
+	{ GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, "RGBA/2_10_10_10", 4,
+	  NULL, NULL },
+	{ GL_RGBA, GL_HALF_FLOAT, "RGBA/half", 8,
+	  "uvec2", "uvec2(packHalf2x16(c.rg), packHalf2x16(c.ba))" },
+	{ GL_RGBA, GL_FLOAT, "RGBA/float", 16, "vec4", "c" },
+};
+
+static const struct {
+	unsigned width, height;
+} sizes[] = {
+	{ 1, 1 },
+	{ 16, 16 },
+	{ 256, 256 },
+	{ 1920, 1080 },
+	{ WIDTH, HEIGHT },
+};
+
+enum read_mode {
+	MODE_READ_PIXELS,
+	MODE_PBO_FENCE,
+	MODE_PBO_ASYNC,
+	MODE_GET_TEX_SUB_IMAGE,
+	MODE_COMPUTE,
+	MODE_COUNT
+};
+
+static const char *mode_names[MODE_COUNT] = {
+	"readpixels",
+	"pbo+fence",
+	"pbo-async",
+	"gettexsubimage",
+	"compute",
+};
+
+static const char *cs_source =
+	"#version 430\n"
+	"layout(local_size_x = 8, local_size_y = 8) in;\n"
+	"layout(rgba8, binding = 0) readonly uniform image2D src;\n"
+	"layout(std430, binding = 0) writeonly buffer dst_buf {\n"
+	"	%s dst[];\n"
+	"};\n"
+	"uniform ivec4 rect;\n"
+	"void main() {\n"
+	"	ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+	"	if (p.x >= rect.z || p.y >= rect.w)\n"
+	"		return;\n"
+	"	vec4 c = imageLoad(src, rect.xy + p);\n"
+	"	dst[p.y * rect.z + p.x] = %s;\n"
+	"}\n";
+
+static GLuint tex, fbo, bufs[PBO_RING], compute_prog;
+static GLint rect_loc;
+static void *client;
+static bool has_get_tex_sub_image, has_compute;
+
+/* The read being measured. */
+static unsigned cur_format, cur_size, next_buf;
+static enum read_mode cur_mode;
+static GLint read_x, read_y;
+
+static unsigned
+read_bytes(void)
+{
+	return sizes[cur_size].width * sizes[cur_size].height *
+	       formats[cur_format].pixel_size;
+}
+
+/** Make the framebuffer busy, so that the read has to wait for it. */
+static void
+dirty(unsigned i)
+{
+	static const float colors[2][4] = {
+		{ 0.2, 0.4, 0.6, 0.8 },
+		{ 0.8, 0.6, 0.4, 0.2 },
+	};
+
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(read_x, read_y, 1, 1);
+	glClearBufferfv(GL_COLOR, 0, colors[i & 1]);
+	glDisable(GL_SCISSOR_TEST);
+}
+
+static void
+copy_buffer(GLenum target)
+{
+	const void *map = glMapBufferRange(target, 0, read_bytes(),
+					   GL_MAP_READ_BIT);
+	memcpy(client, map, read_bytes());
+	glUnmapBuffer(target);
+}
+
+static void
+read_pixels(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		dirty(i);
+		glReadPixels(read_x, read_y, sizes[cur_size].width,
+			     sizes[cur_size].height, formats[cur_format].format,
+			     formats[cur_format].type, client);
+	}
+}
+
+static void
+pbo_fence(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		GLsync fence;
+
+		dirty(i);
+		glReadPixels(read_x, read_y, sizes[cur_size].width,
+			     sizes[cur_size].height, formats[cur_format].format,
+			     formats[cur_format].type, NULL);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+				 GL_TIMEOUT_IGNORED);
+		glDeleteSync(fence);
+		copy_buffer(GL_PIXEL_PACK_BUFFER);
+	}
+}
+
+static void
+pbo_async(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		dirty(i);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, bufs[next_buf]);
+		glReadPixels(read_x, read_y, sizes[cur_size].width,
+			     sizes[cur_size].height, formats[cur_format].format,
+			     formats[cur_format].type, NULL);
+
+		/* The oldest read in flight. */
+		next_buf = (next_buf + 1) % PBO_RING;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, bufs[next_buf]);
+		copy_buffer(GL_PIXEL_PACK_BUFFER);
+	}
+}
+
+static void
+get_tex_sub_image(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		dirty(i);
+		glGetTextureSubImage(tex, 0, read_x, read_y, 0,
+				     sizes[cur_size].width,
+				     sizes[cur_size].height, 1,
+				     formats[cur_format].format,
+				     formats[cur_format].type,
+				     read_bytes(), client);
+	}
+}
+
+static void
+compute_copy(unsigned count)
+{
+	const unsigned w = sizes[cur_size].width;
+	const unsigned h = sizes[cur_size].height;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		dirty(i);
+		glDispatchCompute((w + 7) / 8, (h + 7) / 8, 1);
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+		copy_buffer(GL_SHADER_STORAGE_BUFFER);
+	}
+}
+
+static const perf_rate_func mode_funcs[MODE_COUNT] = {
+	read_pixels,
+	pbo_fence,
+	pbo_async,
+	get_tex_sub_image,
+	compute_copy,
+};
+
+static bool
+mode_supported(void)
+{
+	switch (cur_mode) {
+	case MODE_GET_TEX_SUB_IMAGE:
+		return has_get_tex_sub_image;
+	case MODE_COMPUTE:
+		return has_compute && formats[cur_format].glsl_type;
+	default:
+		return true;
+	}
+}
+
+/** Create the buffers and program of the current read. */
+static void
+setup_mode(void)
+{
+	unsigned i;
+
+	/* Somewhere else than the origin, unless it's the whole frame. */
+	read_x = (WIDTH - sizes[cur_size].width) / 3;
+	read_y = (HEIGHT - sizes[cur_size].height) / 3;
+
+	switch (cur_mode) {
+	case MODE_PBO_FENCE:
+	case MODE_PBO_ASYNC:
+		glGenBuffers(PBO_RING, bufs);
+		for (i = 0; i < PBO_RING; i++) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, bufs[i]);
+			glBufferData(GL_PIXEL_PACK_BUFFER, read_bytes(), NULL,
+				     GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, bufs[0]);
+		next_buf = 0;
+		break;
+	case MODE_COMPUTE: {
+		char cs[1024];
+
+		snprintf(cs, sizeof(cs), cs_source,
+			 formats[cur_format].glsl_type,
+			 formats[cur_format].glsl_pack);
+		compute_prog = piglit_build_simple_program_multiple_shaders(
+			GL_COMPUTE_SHADER, cs, 0);
+		glUseProgram(compute_prog);
+		glUniform4i(glGetUniformLocation(compute_prog, "rect"),
+			    read_x, read_y, sizes[cur_size].width,
+			    sizes[cur_size].height);
+		glBindImageTexture(0, tex, 0, GL_FALSE, 0, GL_READ_ONLY,
+				   GL_RGBA8);
+
+		glGenBuffers(1, bufs);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bufs[0]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, read_bytes(), NULL,
+			     GL_STREAM_READ);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void
+reset_mode(void)
+{
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glDeleteBuffers(PBO_RING, bufs);
+	memset(bufs, 0, sizeof(bufs));
+	glUseProgram(0);
+	glDeleteProgram(compute_prog);
+	compute_prog = 0;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	const unsigned max_pixel_size = 16;
+
+	has_get_tex_sub_image = piglit_get_gl_version() >= 45 ||
+		piglit_is_extension_supported("GL_ARB_get_texture_sub_image");
+	has_compute = piglit_get_gl_version() >= 43;
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, WIDTH, HEIGHT);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			       GL_TEXTURE_2D, tex, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		piglit_report_result(PIGLIT_FAIL);
+	glClearColor(0.5, 0.5, 0.5, 0.5);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	client = malloc((size_t)WIDTH * HEIGHT * max_pixel_size);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	printf("  %-16s, %-9s, %-14s, %10s, %8s\n", "Format", "Size", "Read",
+	       "Reads/s", "GB/s");
+
+	for (cur_format = 0; cur_format < ARRAY_SIZE(formats); cur_format++) {
+		for (cur_size = 0; cur_size < ARRAY_SIZE(sizes); cur_size++) {
+			for (cur_mode = 0; cur_mode < MODE_COUNT; cur_mode++) {
+				char size[16], name[64];
+				double rate;
+
+				snprintf(size, sizeof(size), "%ux%u",
+					 sizes[cur_size].width,
+					 sizes[cur_size].height);
+
+				if (!mode_supported()) {
+					printf("  %-16s, %-9s, %-14s, %10s, "
+					       "%8s\n",
+					       formats[cur_format].name, size,
+					       mode_names[cur_mode], "-", "-");
+					continue;
+				}
+
+				setup_mode();
+				rate = perf_measure_cpu_rate(
+					mode_funcs[cur_mode], duration);
+				if (!piglit_check_gl_error(GL_NO_ERROR))
+					piglit_report_result(PIGLIT_FAIL);
+				reset_mode();
+
+				printf("  %-16s, %-9s, %-14s, %10.1f, %8.2f\n",
+				       formats[cur_format].name, size,
+				       mode_names[cur_mode], rate,
+				       rate * read_bytes() / 1e9);
+
+				snprintf(name, sizeof(name), "%s %s %s",
+					 formats[cur_format].name, size,
+					 mode_names[cur_mode]);
+				perf_report("readback", name, "reads/s", 1,
+					    perf_last_stats());
+			}
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,600 @@
+/*
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ * Copyright (C) 2021  Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * The perf code that doesn't need GL: statistics, reporting and the timing
+ * of functions that wait for their own work, shared by the GL benchmarks
+ * through common.c and by the OpenCL ones.
+ *
+ * perf_report() appends the statistics of a measurement to the files named
+ * by PIGLIT_PERF_JSON (one JSON object per line) and PIGLIT_PERF_CSV, so
+ * that results can be tracked across driver builds.
+ *
+ * Before their samples, measurements are warmed up until the rate and the
+ * GPU clock stop changing, for at most PIGLIT_PERF_WARMUP rounds (10 by
+ * default).  PIGLIT_PERF_CPU pins the benchmark to that CPU, ideally one
+ * isolated from the scheduler.  On Linux the GPU and CPU clocks and the
+ * thermal throttling are read from sysfs between the samples, their mean
+ * clocks are reported, and a measurement whose clocks moved or that was
+ * throttled is reported as unstable.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "report.h"
+
+/**
+ * Number of times each measurement is taken, from PIGLIT_PERF_REPEAT.
+ */
+unsigned
+perf_repeat_count(void)
+{
+	static unsigned count;
+
+	if (!count) {
+		const char *env = getenv("PIGLIT_PERF_REPEAT");
+		count = env ? atoi(env) : 1;
+		count = CLAMP(count, 1, PERF_MAX_SAMPLES);
+	}
+	return count;
+}
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+static double
+sorted_median(const double *sorted, unsigned count)
+{
+	if (count % 2)
+		return sorted[count / 2];
+	return (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+void
+perf_compute_stats(const double *samples, unsigned count,
+		   struct perf_stats *stats)
+{
+	double sorted[PERF_MAX_SAMPLES], deviations[PERF_MAX_SAMPLES];
+	double median, limit = INFINITY;
+	unsigned i, kept = 0;
+
+	assert(count > 0 && count <= PERF_MAX_SAMPLES);
+	memset(stats, 0, sizeof(*stats));
+
+	memcpy(sorted, samples, count * sizeof(*samples));
+	qsort(sorted, count, sizeof(*sorted), compare_doubles);
+	median = sorted_median(sorted, count);
+
+	/* 1.4826 * MAD estimates the standard deviation of normally
+	 * distributed samples without being thrown off by the outliers.
+	 */
+	if (count >= 3) {
+		for (i = 0; i < count; i++)
+			deviations[i] = fabs(sorted[i] - median);
+		qsort(deviations, count, sizeof(*deviations), compare_doubles);
+		if (sorted_median(deviations, count) > 0)
+			limit = 3 * 1.4826 * sorted_median(deviations, count);
+	}
+
+	for (i = 0; i < count; i++) {
+		if (fabs(sorted[i] - median) <= limit)
+			sorted[kept++] = sorted[i];
+	}
+
+	stats->num_samples = kept;
+	stats->num_rejected = count - kept;
+	stats->median = sorted_median(sorted, kept);
+	stats->min = sorted[0];
+	stats->max = sorted[kept - 1];
+
+	for (i = 0; i < kept; i++)
+		stats->mean += sorted[i] / kept;
+	for (i = 0; i < kept; i++)
+		stats->stddev += (sorted[i] - stats->mean) *
+				 (sorted[i] - stats->mean);
+	stats->stddev = kept > 1 ? sqrt(stats->stddev / (kept - 1)) : 0;
+	stats->cv = stats->mean ? stats->stddev / stats->mean : 0;
+
+	const char *max_cv = getenv("PIGLIT_PERF_MAX_CV");
+	stats->noisy = stats->cv > (max_cv ? atof(max_cv) : 0.05);
+}
+
+
+/** How much the clocks may move during a measurement that is stable. */
+#define PERF_MAX_CLOCK_CHANGE 0.1
+
+/** How close two warm-up rounds have to be for the clocks to be settled. */
+#define PERF_WARMUP_TOLERANCE 0.02
+
+#ifdef __linux__
+static bool
+read_sysfs_double(const char *path, double *value)
+{
+	FILE *f = fopen(path, "r");
+	bool ok;
+
+	if (!f)
+		return false;
+	ok = fscanf(f, "%lf", value) == 1;
+	fclose(f);
+	return ok;
+}
+
+/** Return the current clock of the GPU in MHz, or 0 when it is unknown. */
+static double
+gpu_mhz(void)
+{
+	static const char *paths[] = {
+		"/sys/class/drm/card0/gt_act_freq_mhz",
+		"/sys/class/drm/card0/device/tile0/gt0/freq0/act_freq",
+		"/sys/class/drm/card0/gt_cur_freq_mhz",
+	};
+	char line[64];
+	double mhz;
+	unsigned i;
+	FILE *f;
+
+	for (i = 0; i < ARRAY_SIZE(paths); i++) {
+		if (read_sysfs_double(paths[i], &mhz))
+			return mhz;
+	}
+
+	/* amdgpu lists the levels, with a '*' after the current one. */
+	f = fopen("/sys/class/drm/card0/device/pp_dpm_sclk", "r");
+	if (!f)
+		return 0;
+	mhz = 0;
+	while (fgets(line, sizeof(line), f)) {
+		if (strchr(line, '*') && sscanf(line, "%*u: %lf", &mhz) == 1)
+			break;
+	}
+	fclose(f);
+	return mhz;
+}
+
+/** Return the current clock of the CPU we run on in MHz, or 0. */
+static double
+cpu_mhz(void)
+{
+	char path[128];
+	double khz;
+	int cpu = sched_getcpu();
+
+	snprintf(path, sizeof(path),
+		 "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq",
+		 cpu < 0 ? 0 : cpu);
+	return read_sysfs_double(path, &khz) ? khz / 1000 : 0;
+}
+
+/** Return how many times the CPU we run on was throttled so far. */
+static double
+cpu_throttle_count(void)
+{
+	static const char *names[] = {
+		"core_throttle_count",
+		"package_throttle_count",
+	};
+	char path[128];
+	double count, total = 0;
+	int cpu = sched_getcpu();
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/cpu/cpu%d/thermal_throttle/%s",
+			 cpu < 0 ? 0 : cpu, names[i]);
+		if (read_sysfs_double(path, &count))
+			total += count;
+	}
+	return total;
+}
+
+/** Return whether the GPU reports being throttled right now. */
+static bool
+gpu_throttled(void)
+{
+	double status;
+
+	return read_sysfs_double(
+		"/sys/class/drm/card0/gt/gt0/throttle_reason_status",
+		&status) && status != 0;
+}
+
+/**
+ * Pin the calling thread to the CPU of PIGLIT_PERF_CPU, the first time
+ * this is called.
+ */
+static void
+pin_thread(void)
+{
+	static bool pinned;
+	const char *env = getenv("PIGLIT_PERF_CPU");
+	cpu_set_t set;
+
+	if (pinned || !env)
+		return;
+	pinned = true;
+
+	CPU_ZERO(&set);
+	CPU_SET(atoi(env), &set);
+	if (sched_setaffinity(0, sizeof(set), &set) != 0)
+		fprintf(stderr, "perf: can't pin to CPU %s\n", env);
+}
+#else
+static double gpu_mhz(void) { return 0; }
+static double cpu_mhz(void) { return 0; }
+static double cpu_throttle_count(void) { return 0; }
+static bool gpu_throttled(void) { return false; }
+static void pin_thread(void) { }
+#endif
+
+static unsigned
+warmup_rounds(void)
+{
+	const char *env = getenv("PIGLIT_PERF_WARMUP");
+
+	return env ? atoi(env) : 10;
+}
+
+/**
+ * Call rate until two rounds in a row agree on it and on the GPU clock.
+ * Return false when they never did within PIGLIT_PERF_WARMUP rounds.
+ */
+bool
+perf_warm_up(double (*rate)(void *data), void *data)
+{
+	unsigned rounds = warmup_rounds();
+	double last_rate = 0, last_mhz = 0;
+	unsigned i;
+
+	pin_thread();
+	for (i = 0; i < rounds; i++) {
+		double r = rate(data);
+		double mhz = gpu_mhz();
+
+		if (i > 0 &&
+		    fabs(r - last_rate) <= last_rate * PERF_WARMUP_TOLERANCE &&
+		    fabs(mhz - last_mhz) <= last_mhz * PERF_WARMUP_TOLERANCE)
+			return true;
+		last_rate = r;
+		last_mhz = mhz;
+	}
+	return rounds == 0;
+}
+
+static void
+update_range(double value, double *min, double *max, double *sum)
+{
+	*min = MIN2(*min, value);
+	*max = MAX2(*max, value);
+	*sum += value;
+}
+
+/**
+ * Start watching the conditions of the samples of a measurement, once it
+ * was warmed up with perf_warm_up(), which returned settled.
+ */
+void
+perf_conditions_begin(struct perf_conditions *c, bool settled)
+{
+	memset(c, 0, sizeof(*c));
+	pin_thread();
+	c->settled = settled;
+	c->gpu_mhz_min = c->cpu_mhz_min = INFINITY;
+	c->throttle_count = cpu_throttle_count();
+	perf_conditions_sample(c);
+}
+
+/** Read the clocks and the throttling, after each sample. */
+void
+perf_conditions_sample(struct perf_conditions *c)
+{
+	update_range(gpu_mhz(), &c->gpu_mhz_min, &c->gpu_mhz_max,
+		     &c->gpu_mhz_sum);
+	update_range(cpu_mhz(), &c->cpu_mhz_min, &c->cpu_mhz_max,
+		     &c->cpu_mhz_sum);
+	c->throttled |= gpu_throttled();
+	c->readings++;
+}
+
+static bool
+clock_moved(double min, double max)
+{
+	return max > 0 && (max - min) > max * PERF_MAX_CLOCK_CHANGE;
+}
+
+/**
+ * Add the mean clocks of the samples to stats, and whether they were
+ * taken under unstable conditions.
+ */
+void
+perf_conditions_end(const struct perf_conditions *c, struct perf_stats *stats)
+{
+	bool throttled = c->throttled ||
+			 cpu_throttle_count() != c->throttle_count;
+
+	stats->gpu_mhz = c->gpu_mhz_sum / c->readings;
+	stats->cpu_mhz = c->cpu_mhz_sum / c->readings;
+	stats->unstable = !c->settled || throttled ||
+			  clock_moved(c->gpu_mhz_min, c->gpu_mhz_max) ||
+			  clock_moved(c->cpu_mhz_min, c->cpu_mhz_max);
+}
+
+struct warm_up_data {
+	perf_time_func f;
+	unsigned iterations;
+};
+
+static double
+warm_up_rate(void *data)
+{
+	struct warm_up_data *w = data;
+
+	return w->iterations / w->f(w->iterations);
+}
+
+
+/**
+ * Return iterations/second of f, doubling the iterations until they take
+ * the duration, and its statistics over PIGLIT_PERF_REPEAT samples taken
+ * once it is warmed up in stats.
+ */
+double
+perf_measure_rate(perf_time_func f, double duration, struct perf_stats *stats)
+{
+	double samples[PERF_MAX_SAMPLES];
+	unsigned count = perf_repeat_count();
+	unsigned iterations = 16;
+	unsigned i;
+	double t;
+
+	struct warm_up_data warm_up;
+	struct perf_conditions conditions;
+	bool settled;
+
+	pin_thread();
+	f(iterations);
+	/* f may return early when it fails, don't double forever then. */
+	while ((t = f(iterations)) < duration && iterations <= UINT_MAX / 2)
+		iterations *= 2;
+
+	warm_up.f = f;
+	warm_up.iterations = MAX2(iterations / 4, 1);
+	settled = perf_warm_up(warm_up_rate, &warm_up);
+
+	perf_conditions_begin(&conditions, settled);
+	for (i = 0; i < count; i++) {
+		samples[i] = iterations / f(iterations);
+		perf_conditions_sample(&conditions);
+	}
+
+	perf_compute_stats(samples, count, stats);
+	perf_conditions_end(&conditions, stats);
+	return stats->median;
+}
+
+static void
+write_json_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', f);
+		if ((unsigned char)*s >= 0x20)
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static void
+write_csv_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++) {
+		if (*s == '"')
+			fputc('"', f);
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static struct {
+	char name[64];
+	const char *unit;
+	double value;
+} counters[PERF_MAX_COUNTERS];
+static unsigned num_counters;
+
+/**
+ * Attach the value of a GPU counter to the next perf_report(), which
+ * reports it as "<name>: <counter>".  The unit has to outlive the call.
+ */
+void
+perf_report_counter(const char *counter, const char *unit, double value)
+{
+	if (num_counters == PERF_MAX_COUNTERS)
+		return;
+
+	snprintf(counters[num_counters].name, sizeof(counters[0].name), "%s",
+		 counter);
+	counters[num_counters].unit = unit;
+	counters[num_counters].value = value;
+	num_counters++;
+}
+
+static void
+write_report(const char *test, const char *name, const char *unit,
+	     double scale, const struct perf_stats *stats, bool counter)
+{
+	const char *path;
+	FILE *f;
+
+	path = getenv("PIGLIT_PERF_JSON");
+	if (path && (f = fopen(path, "a"))) {
+		fputs("{\"test\": ", f);
+		write_json_string(f, test);
+		fputs(", \"name\": ", f);
+		write_json_string(f, name);
+		fputs(", \"unit\": ", f);
+		write_json_string(f, unit);
+		fprintf(f, ", \"samples\": %u, \"rejected\": %u, "
+			"\"median\": %.9g, \"mean\": %.9g, \"stddev\": %.9g, "
+			"\"min\": %.9g, \"max\": %.9g, \"cv\": %.4f, "
+			"\"noisy\": %s, \"gpu_mhz\": %.0f, \"cpu_mhz\": %.0f, "
+			"\"unstable\": %s%s}\n",
+			stats->num_samples, stats->num_rejected,
+			stats->median * scale, stats->mean * scale,
+			stats->stddev * scale, stats->min * scale,
+			stats->max * scale, stats->cv,
+			stats->noisy ? "true" : "false",
+			stats->gpu_mhz, stats->cpu_mhz,
+			stats->unstable ? "true" : "false",
+			counter ? ", \"counter\": true" : "");
+		fclose(f);
+	}
+
+	path = getenv("PIGLIT_PERF_CSV");
+	if (path && (f = fopen(path, "a"))) {
+		fseek(f, 0, SEEK_END);
+		if (ftell(f) == 0)
+			fputs("test,name,unit,samples,rejected,median,mean,"
+			      "stddev,min,max,cv,noisy,gpu_mhz,cpu_mhz,"
+			      "unstable\n", f);
+		write_csv_string(f, test);
+		fputc(',', f);
+		write_csv_string(f, name);
+		fputc(',', f);
+		write_csv_string(f, unit);
+		fprintf(f, ",%u,%u,%.9g,%.9g,%.9g,%.9g,%.9g,%.4f,%d,%.0f,%.0f,"
+			"%d\n",
+			stats->num_samples, stats->num_rejected,
+			stats->median * scale, stats->mean * scale,
+			stats->stddev * scale, stats->min * scale,
+			stats->max * scale, stats->cv, stats->noisy,
+			stats->gpu_mhz, stats->cpu_mhz, stats->unstable);
+		fclose(f);
+	}
+}
+
+/**
+ * Append stats, as measured by test for name, to the PIGLIT_PERF_JSON and
+ * PIGLIT_PERF_CSV files.  Values are multiplied by scale and given in unit.
+ * This does nothing when neither variable is set.
+ *
+ * The counters attached with perf_report_counter() follow, as measurements
+ * of a single sample marked as counters.
+ */
+void
+perf_report(const char *test, const char *name, const char *unit,
+	    double scale, const struct perf_stats *stats)
+{
+	struct perf_stats counter_stats;
+	char full_name[128];
+	unsigned i;
+
+	if (stats->unstable)
+		printf("%s: measured under unstable clocks or throttling\n",
+		       name);
+	write_report(test, name, unit, scale, stats, false);
+
+	for (i = 0; i < num_counters; i++) {
+		memset(&counter_stats, 0, sizeof(counter_stats));
+		counter_stats.num_samples = 1;
+		counter_stats.median = counter_stats.mean =
+			counter_stats.min = counter_stats.max =
+			counters[i].value;
+		snprintf(full_name, sizeof(full_name), "%s: %s", name,
+			 counters[i].name);
+		write_report(test, full_name, counters[i].unit, 1,
+			     &counter_stats, true);
+	}
+	num_counters = 0;
+}
+
+static int
+compare_int64(const void *a, const void *b)
+{
+	const int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double
+percentile_usec(const int64_t *sorted, unsigned count, double p)
+{
+	return sorted[(unsigned)(p * (count - 1) + 0.5)] / 1000.0;
+}
+
+/**
+ * Report a single value, such as a percentile or a peak, measured by test
+ * for name, as if it were the median of count samples.
+ */
+void
+perf_report_value(const char *test, const char *name, const char *unit,
+		  unsigned count, double value)
+{
+	struct perf_stats stats;
+
+	memset(&stats, 0, sizeof(stats));
+	stats.num_samples = count;
+	stats.median = stats.mean = stats.min = stats.max = value;
+
+	perf_report(test, name, unit, 1, &stats);
+}
+
+/**
+ * Sort the count latencies in samples, in nanoseconds, return their
+ * percentiles in latency, and report the median and 99th percentile as
+ * "<name> p50" and "<name> p99".  Unlike rates, latencies are measured many
+ * more times than PERF_MAX_SAMPLES, for their tail.
+ */
+void
+perf_report_latency(const char *test, const char *name, int64_t *samples,
+		    unsigned count, struct perf_latency *latency)
+{
+	char full_name[128];
+
+	assert(count > 0);
+
+	qsort(samples, count, sizeof(*samples), compare_int64);
+	latency->p50 = percentile_usec(samples, count, 0.5);
+	latency->p99 = percentile_usec(samples, count, 0.99);
+	latency->max = samples[count - 1] / 1000.0;
+
+	snprintf(full_name, sizeof(full_name), "%s p50", name);
+	perf_report_value(test, full_name, "usec", count, latency->p50);
+	snprintf(full_name, sizeof(full_name), "%s p99", name);
+	perf_report_value(test, full_name, "usec", count, latency->p99);
+}
+
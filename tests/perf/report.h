@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2009  VMware, Inc.  All Rights Reserved.
+ * Copyright (C) 2021  Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * VMWARE BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+ * AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PERF_REPORT_H
+#define PERF_REPORT_H
+
+#include "piglit-util.h"
+
+/** The most samples a measurement is repeated for. */
+#define PERF_MAX_SAMPLES 64
+
+/** The most GPU counters attached to a measurement. */
+#define PERF_MAX_COUNTERS 16
+
+/**
+ * Statistics over the repeated samples of one measurement.
+ *
+ * Samples further than 3 standard deviations from the median, as estimated
+ * from the median absolute deviation, are rejected before the rest is
+ * computed.
+ */
+struct perf_stats {
+	unsigned num_samples;
+	unsigned num_rejected;
+	double median;
+	double mean;
+	double stddev;
+	double min;
+	double max;
+	/** stddev / mean */
+	double cv;
+	/** cv is over PIGLIT_PERF_MAX_CV */
+	bool noisy;
+	/** The mean clocks over the samples in MHz, 0 when unknown. */
+	double gpu_mhz;
+	double cpu_mhz;
+	/** The clocks didn't settle or moved, or something was throttled. */
+	bool unstable;
+};
+
+/** What the clocks and the throttling did during a measurement. */
+struct perf_conditions {
+	bool settled;
+	bool throttled;
+	double throttle_count;
+	unsigned readings;
+	double gpu_mhz_min, gpu_mhz_max, gpu_mhz_sum;
+	double cpu_mhz_min, cpu_mhz_max, cpu_mhz_sum;
+};
+
+unsigned
+perf_repeat_count(void);
+
+void
+perf_compute_stats(const double *samples, unsigned count,
+		   struct perf_stats *stats);
+
+bool
+perf_warm_up(double (*rate)(void *data), void *data);
+
+void
+perf_conditions_begin(struct perf_conditions *c, bool settled);
+
+void
+perf_conditions_sample(struct perf_conditions *c);
+
+void
+perf_conditions_end(const struct perf_conditions *c, struct perf_stats *stats);
+
+/**
+ * Return the seconds count iterations take, once the work they submit is
+ * done.
+ */
+typedef double (*perf_time_func)(unsigned count);
+
+double
+perf_measure_rate(perf_time_func f, double duration, struct perf_stats *stats);
+
+void
+perf_report(const char *test, const char *name, const char *unit,
+	    double scale, const struct perf_stats *stats);
+
+void
+perf_report_counter(const char *counter, const char *unit, double value);
+
+void
+perf_report_value(const char *test, const char *name, const char *unit,
+		  unsigned count, double value);
+
+/** Percentiles of a latency distribution, in microseconds. */
+struct perf_latency {
+	double p50;
+	double p99;
+	double max;
+};
+
+void
+perf_report_latency(const char *test, const char *name, int64_t *samples,
+		    unsigned count, struct perf_latency *latency);
+
+#endif /* PERF_REPORT_H */
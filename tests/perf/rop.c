@@ -0,0 +1,373 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the pixel rate of the render output stage over render target
+ * formats, blend equations and factors, logic ops and color write masks,
+ * to catch the formats whose blending falls onto slow paths.
+ *
+ * A constant color fragment shader fills render targets small enough to
+ * stay in the caches, so that the rate is that of the blending rather than
+ * of the memory.  Each format is measured:
+ *
+ *  - with each mode into one render target: opaque, blend equations and
+ *    factors, dual-source blending, logic ops and write masks
+ *  - opaque and alpha blended into 2, 4 and 8 render targets
+ *
+ * The sRGB format is measured with GL_FRAMEBUFFER_SRGB enabled and
+ * disabled.  Blending does not apply to the integer format and logic ops do
+ * not apply to the float formats, so those modes are skipped.
+ *
+ * Usage: rop [-format NAME] [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#undef NDEBUG
+#include <assert.h>
+#include "piglit-util-gl.h"
+
+static const char *only_format;
+static double duration = 0.1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 33;
+	config.supports_gl_core_version = 33;
+	config.window_width = 64;
+	config.window_height = 64;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-format") && i + 1 < argc) {
+			only_format = argv[++i];
+		} else if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "rop [-format NAME] [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Small enough to stay cached, so that we are not limited by bandwidth. */
+#define TARGET_SIZE 256
+#define MAX_TARGETS 8
+
+enum format_type {
+	TYPE_UNORM,
+	TYPE_FLOAT,
+	TYPE_UINT,
+};
+
+static const struct format {
+	const char *name;
+	GLenum internal_format;
+	enum format_type type;
+	/** Whether to enable GL_FRAMEBUFFER_SRGB. */
+	bool srgb;
+} formats[] = {
+	{ "rgba8", GL_RGBA8, TYPE_UNORM, false },
+	{ "srgb8_a8", GL_SRGB8_ALPHA8, TYPE_UNORM, true },
+	{ "srgb8_a8-linear", GL_SRGB8_ALPHA8, TYPE_UNORM, false },
+	{ "r8", GL_R8, TYPE_UNORM, false },
+	{ "rgb10_a2", GL_RGB10_A2, TYPE_UNORM, false },
+	{ "rgba16", GL_RGBA16, TYPE_UNORM, false },
+	{ "r11f_g11f_b10f", GL_R11F_G11F_B10F, TYPE_FLOAT, false },
+	{ "rg16f", GL_RG16F, TYPE_FLOAT, false },
+	{ "rgba16f", GL_RGBA16F, TYPE_FLOAT, false },
+	{ "rgba32f", GL_RGBA32F, TYPE_FLOAT, false },
+	{ "rgba8ui", GL_RGBA8UI, TYPE_UINT, false },
+};
+
+static const struct mode {
+	const char *name;
+	bool blend;
+	GLenum equation, src, dst;
+	/** Blend with the second color of the fragment shader. */
+	bool dual_source;
+	/** The logic op, or 0. */
+	GLenum logic_op;
+	/** The channels written, such as "rgba". */
+	const char *mask;
+} modes[] = {
+	{ "opaque", false, 0, 0, 0, false, 0, "rgba" },
+	{ "alpha", true, GL_FUNC_ADD, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+	  false, 0, "rgba" },
+	{ "premultiplied", true, GL_FUNC_ADD, GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+	  false, 0, "rgba" },
+	{ "additive", true, GL_FUNC_ADD, GL_ONE, GL_ONE, false, 0, "rgba" },
+	{ "subtract", true, GL_FUNC_REVERSE_SUBTRACT, GL_ONE, GL_ONE,
+	  false, 0, "rgba" },
+	{ "min", true, GL_MIN, GL_ONE, GL_ONE, false, 0, "rgba" },
+	{ "max", true, GL_MAX, GL_ONE, GL_ONE, false, 0, "rgba" },
+	{ "constant", true, GL_FUNC_ADD, GL_CONSTANT_COLOR,
+	  GL_ONE_MINUS_CONSTANT_COLOR, false, 0, "rgba" },
+	{ "dual-source", true, GL_FUNC_ADD, GL_SRC1_COLOR,
+	  GL_ONE_MINUS_SRC1_COLOR, true, 0, "rgba" },
+	{ "logic-xor", false, 0, 0, 0, false, GL_XOR, "rgba" },
+	{ "logic-and", false, 0, 0, 0, false, GL_AND, "rgba" },
+	{ "mask-rgb", false, 0, 0, 0, false, 0, "rgb" },
+	{ "mask-r", false, 0, 0, 0, false, 0, "r" },
+	{ "alpha-mask-rgb", true, GL_FUNC_ADD, GL_SRC_ALPHA,
+	  GL_ONE_MINUS_SRC_ALPHA, false, 0, "rgb" },
+};
+
+/* The render target counts of the sweep of the first two modes */
+static const unsigned counts[] = { 2, 4, 8 };
+
+static GLuint vao, fbo, prog;
+static GLuint textures[MAX_TARGETS];
+
+static GLuint
+build_program(const struct format *format, const struct mode *mode,
+	      unsigned count)
+{
+	const char *type = format->type == TYPE_UINT ? "uvec4" : "vec4";
+	const char *value = format->type == TYPE_UINT ?
+		"uvec4(128u, 64u, 192u, 128u)" :
+		"vec4(0.5, 0.25, 0.75, 0.5)";
+	char fs[2048];
+	unsigned offset, i;
+
+	offset = snprintf(fs, sizeof(fs), "#version 330\n");
+	if (mode->dual_source) {
+		offset += snprintf(fs + offset, sizeof(fs) - offset,
+				   "layout(location = 0, index = 0) out vec4 color0;\n"
+				   "layout(location = 0, index = 1) out vec4 color1;\n"
+				   "void main() {\n"
+				   "	color0 = %s;\n"
+				   "	color1 = %s.wzyx;\n"
+				   "}\n", value, value);
+	} else {
+		for (i = 0; i < count; i++) {
+			offset += snprintf(fs + offset, sizeof(fs) - offset,
+					   "layout(location = %u) out %s color%u;\n",
+					   i, type, i);
+		}
+		offset += snprintf(fs + offset, sizeof(fs) - offset,
+				   "void main() {\n");
+		for (i = 0; i < count; i++) {
+			offset += snprintf(fs + offset, sizeof(fs) - offset,
+					   "	color%u = %s;\n", i, value);
+		}
+		offset += snprintf(fs + offset, sizeof(fs) - offset, "}\n");
+	}
+	assert(offset < sizeof(fs));
+
+	return piglit_build_simple_program(
+		"#version 330\n"
+		"void main() {\n"
+		"	gl_Position = vec4(gl_VertexID % 2 == 1 ? 1.0 : -1.0,\n"
+		"			   gl_VertexID / 2 == 1 ? 1.0 : -1.0,\n"
+		"			   0.0, 1.0);\n"
+		"}\n", fs);
+}
+
+/**
+ * Set up count render targets of format and the state of mode.  Return
+ * false if the format is not renderable.
+ */
+static bool
+setup(const struct format *format, const struct mode *mode, unsigned count)
+{
+	static const GLenum buffers[MAX_TARGETS] = {
+		GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1,
+		GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3,
+		GL_COLOR_ATTACHMENT4, GL_COLOR_ATTACHMENT5,
+		GL_COLOR_ATTACHMENT6, GL_COLOR_ATTACHMENT7,
+	};
+	unsigned i;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glGenTextures(count, textures);
+	for (i = 0; i < count; i++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexStorage2D(GL_TEXTURE_2D, 1, format->internal_format,
+			       TARGET_SIZE, TARGET_SIZE);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, buffers[i],
+				       GL_TEXTURE_2D, textures[i], 0);
+	}
+	glDrawBuffers(count, buffers);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+	    GL_FRAMEBUFFER_COMPLETE)
+		return false;
+
+	prog = build_program(format, mode, count);
+	glUseProgram(prog);
+
+	if (mode->blend) {
+		glEnable(GL_BLEND);
+		glBlendEquation(mode->equation);
+		glBlendFunc(mode->src, mode->dst);
+		glBlendColor(0.25, 0.5, 0.75, 0.5);
+	}
+	if (mode->logic_op) {
+		glEnable(GL_COLOR_LOGIC_OP);
+		glLogicOp(mode->logic_op);
+	}
+	glColorMask(strchr(mode->mask, 'r') != NULL,
+		    strchr(mode->mask, 'g') != NULL,
+		    strchr(mode->mask, 'b') != NULL,
+		    strchr(mode->mask, 'a') != NULL);
+	if (format->srgb)
+		glEnable(GL_FRAMEBUFFER_SRGB);
+
+	return true;
+}
+
+static void
+teardown(unsigned count)
+{
+	unsigned i;
+
+	glDisable(GL_BLEND);
+	glDisable(GL_COLOR_LOGIC_OP);
+	glDisable(GL_FRAMEBUFFER_SRGB);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	for (i = 0; i < count; i++) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i,
+				       GL_TEXTURE_2D, 0, 0);
+	}
+	glDeleteTextures(count, textures);
+	glDeleteProgram(prog);
+	prog = 0;
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+}
+
+static void
+draw(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++)
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+/** Whether mode applies to format. */
+static bool
+supported(const struct format *format, const struct mode *mode)
+{
+	if (format->type == TYPE_UINT && mode->blend)
+		return false;
+	if (format->type == TYPE_FLOAT && mode->logic_op)
+		return false;
+	return true;
+}
+
+static void
+measure(const struct format *format, const struct mode *mode, unsigned count)
+{
+	const double pixels = (double)TARGET_SIZE * TARGET_SIZE;
+	char name[128];
+	double rate;
+
+	snprintf(name, sizeof(name), "%s %s x%u", format->name, mode->name,
+		 count);
+
+	if (!setup(format, mode, count)) {
+		printf("  %-16s, %-14s, %4u, unsupported\n", format->name,
+		       mode->name, count);
+		teardown(count);
+		return;
+	}
+
+	rate = perf_measure_gpu_rate(draw, duration) * pixels / 1e9;
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	perf_report("rop", name, "Gpixels/s", pixels / 1e9, perf_last_stats());
+
+	printf("  %-16s, %-14s, %4u, %10.2f\n", format->name, mode->name,
+	       count, rate);
+
+	teardown(count);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	unsigned i;
+
+	if (only_format) {
+		for (i = 0; i < ARRAY_SIZE(formats); i++) {
+			if (!strcmp(only_format, formats[i].name))
+				break;
+		}
+		if (i == ARRAY_SIZE(formats)) {
+			fprintf(stderr, "unknown format %s\n", only_format);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	}
+
+	piglit_require_extension("GL_ARB_texture_storage");
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenFramebuffers(1, &fbo);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	GLint max_targets, max_attachments, max_dual_source;
+
+	glGetIntegerv(GL_MAX_DRAW_BUFFERS, &max_targets);
+	glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &max_attachments);
+	glGetIntegerv(GL_MAX_DUAL_SOURCE_DRAW_BUFFERS, &max_dual_source);
+	max_targets = MIN3(max_targets, max_attachments, MAX_TARGETS);
+
+	printf("  %-16s, %-14s, %4s, %10s\n", "Format", "Mode", "MRTs",
+	       "Gpixels/s");
+
+	for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+		const struct format *format = &formats[f];
+
+		if (only_format && strcmp(only_format, format->name))
+			continue;
+
+		for (unsigned m = 0; m < ARRAY_SIZE(modes); m++) {
+			const struct mode *mode = &modes[m];
+
+			if (!supported(format, mode))
+				continue;
+			if (mode->dual_source && max_dual_source < 1)
+				continue;
+			measure(format, mode, 1);
+		}
+
+		/* The opaque and alpha modes into more render targets */
+		for (unsigned m = 0; m < 2; m++) {
+			if (!supported(format, &modes[m]))
+				continue;
+
+			for (unsigned c = 0; c < ARRAY_SIZE(counts); c++) {
+				if (counts[c] <= max_targets)
+					measure(format, &modes[m], counts[c]);
+			}
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
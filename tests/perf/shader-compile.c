@@ -0,0 +1,322 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure shader compile and link throughput over a corpus of shader_test
+ * files.
+ *
+ * The GLSL sections of every file are compiled and linked into a program.
+ * All of the programs are submitted before any is waited on, so with
+ * GL_KHR_parallel_shader_compile the driver may compile them in as many
+ * threads as it is allowed.  The latency of a program is the time from
+ * submitting its first shader to seeing GL_COMPLETION_STATUS_KHR set.
+ *
+ * Every cold pass appends a different comment to the sources so that no
+ * cache of the driver knows them.  Warm passes compile the sources of an
+ * untimed pass again, which the driver has just stored in its caches.
+ *
+ * Usage: shader-compile [-threads N] FILE.shader_test...
+ *
+ * for example:
+ *   find tests/spec/glsl-1.30 -name '*.shader_test' | \
+ *      xargs bin/shader-compile -threads 8
+ */
+
+#include <unistd.h>
+
+#include "common.h"
+#include "piglit-util-gl.h"
+#include "piglit-shader-test.h"
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 20;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+static const GLenum stages[] = {
+	GL_VERTEX_SHADER,
+	GL_TESS_CONTROL_SHADER,
+	GL_TESS_EVALUATION_SHADER,
+	GL_GEOMETRY_SHADER,
+	GL_FRAGMENT_SHADER,
+	GL_COMPUTE_SHADER,
+};
+
+static const char *section_names[] = {
+	"[vertex shader]",
+	"[tessellation control shader]",
+	"[tessellation evaluation shader]",
+	"[geometry shader]",
+	"[fragment shader]",
+	"[compute shader]",
+};
+
+struct program_source {
+	unsigned num_shaders;
+	GLenum stages[ARRAY_SIZE(stages)];
+	char *sources[ARRAY_SIZE(stages)];
+};
+
+struct pending_program {
+	GLuint prog;
+	int64_t start;
+};
+
+static struct program_source *corpus;
+static unsigned num_programs;
+static unsigned max_threads;
+static bool parallel;
+static unsigned nonce;
+
+static struct pending_program *pending;
+/* Latencies in seconds of every program of every timed pass. */
+static double *latencies;
+static unsigned num_latencies;
+
+static bool
+has_section(const char *text, const char *name)
+{
+	const char *s = text;
+
+	while ((s = strstr(s, name))) {
+		if (s == text || s[-1] == '\n')
+			return true;
+		s++;
+	}
+	return false;
+}
+
+static void
+load_corpus(int argc, char **argv)
+{
+	int i;
+	unsigned j;
+
+	corpus = calloc(argc, sizeof(*corpus));
+	for (i = 0; i < argc; i++) {
+		struct program_source *p = &corpus[num_programs];
+		char *text = piglit_load_text_file(argv[i], NULL);
+
+		if (!text) {
+			fprintf(stderr, "Could not read file \"%s\"\n",
+				argv[i]);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		/* Check for the sections first, the loader complains about
+		 * the ones it doesn't find.
+		 */
+		for (j = 0; j < ARRAY_SIZE(stages); j++) {
+			if (!has_section(text, section_names[j]))
+				continue;
+			if (!piglit_load_source_from_shader_test(
+				    argv[i], stages[j], false,
+				    &p->sources[p->num_shaders], NULL))
+				continue;
+			p->stages[p->num_shaders++] = stages[j];
+		}
+		free(text);
+
+		if (p->num_shaders)
+			num_programs++;
+	}
+
+	if (!num_programs) {
+		printf("No GLSL sections in the given files\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	pending = calloc(num_programs, sizeof(*pending));
+	latencies = calloc(num_programs * PERF_MAX_SAMPLES,
+			   sizeof(*latencies));
+}
+
+/**
+ * Compile and link every program of the corpus, return the number of
+ * programs per second.  The latency of each program is recorded if
+ * timed is set.
+ */
+static double
+compile_corpus(unsigned pass_nonce, bool timed)
+{
+	char suffix[64];
+	unsigned i, j, num_pending = num_programs;
+	int64_t start = piglit_time_get_nano();
+
+	snprintf(suffix, sizeof(suffix), "\n// shader-compile %u %u\n",
+		 (unsigned)getpid(), pass_nonce);
+
+	for (i = 0; i < num_programs; i++) {
+		const struct program_source *p = &corpus[i];
+
+		pending[i].start = piglit_time_get_nano();
+		pending[i].prog = glCreateProgram();
+		for (j = 0; j < p->num_shaders; j++) {
+			const GLchar *strings[2] = { p->sources[j], suffix };
+			GLuint shader = glCreateShader(p->stages[j]);
+
+			glShaderSource(shader, 2, strings, NULL);
+			glCompileShader(shader);
+			glAttachShader(pending[i].prog, shader);
+			/* Only deleted once the program is. */
+			glDeleteShader(shader);
+		}
+		glLinkProgram(pending[i].prog);
+	}
+
+	while (num_pending) {
+		for (i = 0; i < num_programs; i++) {
+			GLint done = GL_TRUE;
+
+			if (!pending[i].prog)
+				continue;
+			if (parallel)
+				glGetProgramiv(pending[i].prog,
+					       GL_COMPLETION_STATUS_KHR, &done);
+			if (!done)
+				continue;
+
+			/* Without the extension, this waits for the link. */
+			glGetProgramiv(pending[i].prog, GL_LINK_STATUS, &done);
+			if (timed) {
+				latencies[num_latencies++] =
+					(piglit_time_get_nano() -
+					 pending[i].start) * 0.000000001;
+			}
+			glDeleteProgram(pending[i].prog);
+			pending[i].prog = 0;
+			num_pending--;
+		}
+	}
+
+	return num_programs /
+	       ((piglit_time_get_nano() - start) * 0.000000001);
+}
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return x < y ? -1 : x > y;
+}
+
+static void
+report_latency(const char *name, const char *percentile, double value)
+{
+	struct perf_stats stats;
+	char full_name[64];
+
+	perf_compute_stats(&value, 1, &stats);
+	snprintf(full_name, sizeof(full_name), "%s, %s latency", name,
+		 percentile);
+	perf_report("shader-compile", full_name, "ms", 1000, &stats);
+}
+
+static void
+run(unsigned threads, bool warm)
+{
+	double samples[PERF_MAX_SAMPLES];
+	unsigned repeat = perf_repeat_count();
+	struct perf_stats stats;
+	char name[64];
+	unsigned r;
+
+	if (parallel)
+		glMaxShaderCompilerThreadsKHR(threads);
+
+	num_latencies = 0;
+	for (r = 0; r < repeat; r++) {
+		nonce++;
+		if (warm)
+			compile_corpus(nonce, false);
+		samples[r] = compile_corpus(nonce, true);
+	}
+	perf_compute_stats(samples, repeat, &stats);
+
+	qsort(latencies, num_latencies, sizeof(*latencies), compare_doubles);
+	double p50 = latencies[num_latencies / 2];
+	double p99 = latencies[MIN2(num_latencies * 99 / 100,
+				    num_latencies - 1)];
+
+	printf("  %-5s, %7u, %14.1f, %10.2f, %10.2f\n",
+	       warm ? "warm" : "cold", threads, stats.median,
+	       p50 * 1000, p99 * 1000);
+
+	snprintf(name, sizeof(name), "%s, %u threads",
+		 warm ? "warm" : "cold", threads);
+	perf_report("shader-compile", name, "programs/sec", 1, &stats);
+	report_latency(name, "p50", p50);
+	report_latency(name, "p99", p99);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+			max_threads = atoi(argv[++i]);
+		} else {
+			break;
+		}
+	}
+	if (i == argc) {
+		fprintf(stderr, "shader-compile [-threads N] "
+			"FILE.shader_test...\n");
+		exit(1);
+	}
+
+	load_corpus(argc - i, argv + i);
+
+	parallel = piglit_is_extension_supported(
+		"GL_KHR_parallel_shader_compile");
+	if (!max_threads)
+		max_threads = MIN2(sysconf(_SC_NPROCESSORS_ONLN), 16);
+	if (!parallel)
+		max_threads = 1;
+	max_threads = MAX2(max_threads, 1);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	unsigned n;
+
+	printf("  %u programs%s\n", num_programs,
+	       parallel ? "" : ", no GL_KHR_parallel_shader_compile");
+	printf("  %-5s, %7s, %14s, %10s, %10s\n", "Cache", "Threads",
+	       "Programs/sec", "p50 ms", "p99 ms");
+
+	for (n = 1; ; n = MIN2(n * 2, max_threads)) {
+		run(n, false);
+		run(n, true);
+		if (n == max_threads)
+			break;
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,302 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the distribution of the time the CPU takes to learn that the GPU
+ * is done, with these round trips:
+ *
+ *  - fence: glFenceSync and glClientWaitSync
+ *  - query: the result of a GL_SAMPLES_PASSED query around a small draw
+ *  - conditional: a draw conditional on such a query with GL_QUERY_WAIT,
+ *    then a fence wait
+ *  - finish: glFinish
+ *  - egl-fence: eglCreateSyncKHR and eglClientWaitSyncKHR, when the
+ *    context is an EGL one with EGL_KHR_fence_sync
+ *
+ * Each is measured on an idle GPU, and right after queuing BUSY_DRAWS
+ * expensive draws, whose own time is printed first; the busy latencies
+ * include it.  The median, 99th percentile and maximum of the samples are
+ * printed in microseconds, and the first two reported as " p50" and " p99"
+ * measurements.
+ *
+ * Usage: sync-latency [-samples N]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+#ifdef PIGLIT_HAS_EGL
+#include "piglit-util-egl.h"
+#endif
+
+#define DEFAULT_SAMPLES 1000
+
+static unsigned num_samples = DEFAULT_SAMPLES;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-samples") && i + 1 < argc) {
+			num_samples = MAX2(atoi(argv[++i]), 1);
+		} else {
+			fprintf(stderr, "sync-latency [-samples N]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Expensive full screen draws queued ahead of each busy sample. */
+#define BUSY_DRAWS 4
+/* Iterations run before the samples are taken. */
+#define WARMUP 10
+
+enum sync_op {
+	OP_FENCE,
+	OP_QUERY,
+	OP_CONDITIONAL,
+	OP_FINISH,
+	OP_EGL_FENCE,
+	OP_COUNT
+};
+
+static const char *op_names[OP_COUNT] = {
+	"fence",
+	"query",
+	"conditional",
+	"finish",
+	"egl-fence",
+};
+
+static const char *vs_source =
+	"#version 150\n"
+	"uniform float scale;\n"
+	"void main() {\n"
+	"	gl_Position = vec4(gl_VertexID == 1 ? 3.0 : -1.0,\n"
+	"			   gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0);\n"
+	"	gl_Position.xy = (gl_Position.xy + 1.0) * scale - 1.0;\n"
+	"}\n";
+
+static const char *fs_source =
+	"#version 150\n"
+	"uniform int loops;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	vec2 v = gl_FragCoord.xy;\n"
+	"	for (int i = 0; i < loops; i++)\n"
+	"		v = sin(v * 1.7 + v.yx);\n"
+	"	color = vec4(v, 0.0, 1.0);\n"
+	"}\n";
+
+static GLuint vao, prog, query;
+static GLint scale_loc, loops_loc;
+static int64_t *samples;
+
+#ifdef PIGLIT_HAS_EGL
+static EGLDisplay egl_dpy = EGL_NO_DISPLAY;
+static PFNEGLCREATESYNCKHRPROC create_sync;
+static PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync;
+static PFNEGLDESTROYSYNCKHRPROC destroy_sync;
+#endif
+
+/** Draw an expensive full screen triangle, or a small cheap one. */
+static void
+draw(bool small)
+{
+	glUniform1f(scale_loc, small ? 1.0 / 64 : 1.0);
+	glUniform1i(loops_loc, small ? 1 : 256);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void
+queue_busy_work(void)
+{
+	unsigned i;
+
+	for (i = 0; i < BUSY_DRAWS; i++)
+		draw(false);
+}
+
+static void
+fence_wait(void)
+{
+	GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(fence);
+}
+
+static void
+run_op(enum sync_op op)
+{
+	GLuint result;
+
+	switch (op) {
+	case OP_FENCE:
+		fence_wait();
+		break;
+	case OP_QUERY:
+		glBeginQuery(GL_SAMPLES_PASSED, query);
+		draw(true);
+		glEndQuery(GL_SAMPLES_PASSED);
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT, &result);
+		break;
+	case OP_CONDITIONAL:
+		glBeginQuery(GL_SAMPLES_PASSED, query);
+		draw(true);
+		glEndQuery(GL_SAMPLES_PASSED);
+		glBeginConditionalRender(query, GL_QUERY_WAIT);
+		draw(true);
+		glEndConditionalRender();
+		fence_wait();
+		break;
+	case OP_FINISH:
+		glFinish();
+		break;
+	case OP_EGL_FENCE: {
+#ifdef PIGLIT_HAS_EGL
+		EGLSyncKHR sync = create_sync(egl_dpy, EGL_SYNC_FENCE_KHR,
+					      NULL);
+
+		client_wait_sync(egl_dpy, sync, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR,
+				 EGL_FOREVER_KHR);
+		destroy_sync(egl_dpy, sync);
+#endif
+		break;
+	}
+	default:
+		assert(0);
+	}
+}
+
+static bool
+op_supported(enum sync_op op)
+{
+#ifdef PIGLIT_HAS_EGL
+	if (op == OP_EGL_FENCE)
+		return create_sync != NULL;
+#else
+	if (op == OP_EGL_FENCE)
+		return false;
+#endif
+	return true;
+}
+
+static void
+measure(enum sync_op op, bool busy)
+{
+	struct perf_latency latency;
+	char name[64];
+	unsigned i;
+
+	snprintf(name, sizeof(name), "%s %s", op_names[op],
+		 busy ? "busy" : "idle");
+
+	if (!op_supported(op)) {
+		printf("  %-18s, %10s, %10s, %10s\n", name, "-", "-", "-");
+		return;
+	}
+
+	for (i = 0; i < WARMUP + num_samples; i++) {
+		int64_t start;
+
+		/* Start from an idle GPU. */
+		glFinish();
+		if (busy)
+			queue_busy_work();
+
+		start = piglit_time_get_nano();
+		run_op(op);
+		if (i >= WARMUP)
+			samples[i - WARMUP] = piglit_time_get_nano() - start;
+	}
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	perf_report_latency("sync-latency", name, samples, num_samples,
+			    &latency);
+	printf("  %-18s, %10.1f, %10.1f, %10.1f\n", name, latency.p50,
+	       latency.p99, latency.max);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	prog = piglit_build_simple_program(vs_source, fs_source);
+	glUseProgram(prog);
+	scale_loc = glGetUniformLocation(prog, "scale");
+	loops_loc = glGetUniformLocation(prog, "loops");
+
+	/* The program only uses gl_VertexID. */
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenQueries(1, &query);
+
+	samples = malloc(num_samples * sizeof(*samples));
+
+#ifdef PIGLIT_HAS_EGL
+	egl_dpy = eglGetCurrentDisplay();
+	if (egl_dpy != EGL_NO_DISPLAY &&
+	    piglit_is_egl_extension_supported(egl_dpy, "EGL_KHR_fence_sync")) {
+		create_sync = (PFNEGLCREATESYNCKHRPROC)
+			eglGetProcAddress("eglCreateSyncKHR");
+		client_wait_sync = (PFNEGLCLIENTWAITSYNCKHRPROC)
+			eglGetProcAddress("eglClientWaitSyncKHR");
+		destroy_sync = (PFNEGLDESTROYSYNCKHRPROC)
+			eglGetProcAddress("eglDestroySyncKHR");
+	}
+#endif
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	int64_t start;
+	unsigned i;
+
+	/* The time of the busy work alone, for reference. */
+	for (i = 0; i < WARMUP; i++) {
+		glFinish();
+		start = piglit_time_get_nano();
+		queue_busy_work();
+		glFinish();
+	}
+	printf("Busy work: %.1f usec\n",
+	       (piglit_time_get_nano() - start) / 1000.0);
+
+	printf("  %-18s, %10s, %10s, %10s\n", "Round trip", "p50 usec",
+	       "p99 usec", "max usec");
+
+	for (i = 0; i < OP_COUNT; i++) {
+		measure(i, false);
+		measure(i, true);
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,497 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure texture sampling throughput.  A full screen triangle is drawn to
+ * a 1024x1024 framebuffer with a fragment shader doing TAPS lookups per
+ * fragment, for these parameters:
+ *
+ *  - format: uncompressed formats of 1 to 16 bytes per texel, and
+ *    compressed formats filled with random blocks
+ *  - filter: nearest, bilinear, trilinear and 2x to 16x anisotropic
+ *  - dimensionality: 2D, 2D array, 3D and cube map
+ *  - size: the width of the texture, which sets how much of it fits in
+ *    the caches
+ *  - pattern: coherent, where neighbouring fragments sample neighbouring
+ *    texels, or random
+ *  - lookup: textureGrad() or texelFetch()
+ *
+ * The lookups take explicit gradients, so that both patterns sample the
+ * same mipmap levels: level 0 for the nearest and bilinear filters, level
+ * 0 and 1 for trilinear, and level 0 with an N:1 footprint for Nx
+ * anisotropic.
+ *
+ * By default each parameter is swept on its own, with the others at
+ * RGBA8, bilinear, 2D, 1024, coherent and textureGrad().  With -matrix
+ * every combination is measured.  The results are in Gtexels/s, counting
+ * one texel per lookup.
+ *
+ * Usage: tex-sample [-duration SECONDS] [-matrix]
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+static bool matrix = false;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-matrix")) {
+			matrix = true;
+		} else {
+			fprintf(stderr,
+				"tex-sample [-duration SECONDS] [-matrix]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define FB_SIZE 1024
+/* Lookups per fragment. */
+#define TAPS 4
+/* Layers of the 2D array textures. */
+#define LAYERS 4
+
+static const struct {
+	const char *name;
+	GLenum internal_format;
+	/* Bytes per 4x4 block of a compressed format, 0 otherwise. */
+	unsigned block_bytes;
+	const char *extension;
+} formats[] = {
+	{ "RGBA8", GL_RGBA8, 0, NULL },
+	{ "R8", GL_R8, 0, NULL },
+	{ "RGBA16F", GL_RGBA16F, 0, NULL },
+	{ "RGBA32F", GL_RGBA32F, 0, NULL },
+	{ "DXT1", GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 8,
+	  "GL_EXT_texture_compression_s3tc" },
+	{ "DXT5", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 16,
+	  "GL_EXT_texture_compression_s3tc" },
+	{ "RGTC2", GL_COMPRESSED_RG_RGTC2, 16, NULL },
+	{ "BPTC", GL_COMPRESSED_RGBA_BPTC_UNORM, 16,
+	  "GL_ARB_texture_compression_bptc" },
+	{ "ETC2", GL_COMPRESSED_RGB8_ETC2, 8, "GL_ARB_ES3_compatibility" },
+};
+
+static const struct {
+	const char *name;
+	GLenum min_filter;
+	GLenum mag_filter;
+	/* Max anisotropy, and the ratio of the footprint on the texture. */
+	unsigned aniso;
+	/* Scale of both gradients, to select the mipmap levels. */
+	float lod_scale;
+} filters[] = {
+	{ "nearest", GL_NEAREST, GL_NEAREST, 1, 1.0 },
+	{ "bilinear", GL_LINEAR, GL_LINEAR, 1, 1.0 },
+	{ "trilinear", GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 1, 1.5 },
+	{ "aniso2x", GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 2, 1.0 },
+	{ "aniso4x", GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 4, 1.0 },
+	{ "aniso8x", GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 8, 1.0 },
+	{ "aniso16x", GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 16, 1.0 },
+};
+
+enum dim {
+	DIM_2D,
+	DIM_2D_ARRAY,
+	DIM_3D,
+	DIM_CUBE,
+	DIM_COUNT
+};
+
+static const struct {
+	const char *name;
+	GLenum target;
+	const char *sampler;
+	/* The lookups, with p the texture coordinates in [0, 1), dx and dy
+	 * the gradients of p, i the tap and size the size of the texture.
+	 */
+	const char *grad;
+	const char *fetch;
+} dims[DIM_COUNT] = {
+	{ "2D", GL_TEXTURE_2D, "sampler2D",
+	  "textureGrad(tex, p, dx, dy)",
+	  "texelFetch(tex, ivec2(p * size), 0)" },
+	{ "2D-array", GL_TEXTURE_2D_ARRAY, "sampler2DArray",
+	  "textureGrad(tex, vec3(p, float(i % 4)), dx, dy)",
+	  "texelFetch(tex, ivec3(ivec2(p * size), i % 4), 0)" },
+	{ "3D", GL_TEXTURE_3D, "sampler3D",
+	  "textureGrad(tex, vec3(p, fract(p.x + p.y)), vec3(dx, 0.0), "
+	  "vec3(dy, 0.0))",
+	  "texelFetch(tex, ivec3(vec3(p, fract(p.x + p.y)) * size), 0)" },
+	{ "cube", GL_TEXTURE_CUBE_MAP, "samplerCube",
+	  "textureGrad(tex, vec3(1.0, p * 2.0 - 1.0), vec3(0.0, dx * 2.0), "
+	  "vec3(0.0, dy * 2.0))",
+	  NULL },
+};
+
+/* The width of the textures.  The 3D textures and the faces of the cube
+ * maps are smaller, so that they have about as many texels as a 2D texture
+ * of that width.
+ */
+static const unsigned sizes[] = { 256, 1024, 2048 };
+
+static const char *pattern_names[] = { "coherent", "random" };
+static const char *lookup_names[] = { "grad", "fetch" };
+
+enum axis {
+	AXIS_FORMAT,
+	AXIS_FILTER,
+	AXIS_DIM,
+	AXIS_SIZE,
+	AXIS_PATTERN,
+	AXIS_LOOKUP,
+	AXIS_COUNT
+};
+
+static const unsigned axis_counts[AXIS_COUNT] = {
+	ARRAY_SIZE(formats),
+	ARRAY_SIZE(filters),
+	DIM_COUNT,
+	ARRAY_SIZE(sizes),
+	ARRAY_SIZE(pattern_names),
+	ARRAY_SIZE(lookup_names),
+};
+
+/* RGBA8, bilinear, 2D, 1024, coherent, grad */
+static const unsigned baseline[AXIS_COUNT] = { 0, 1, DIM_2D, 1, 0, 0 };
+
+static const char *fs_source =
+	"#version 150\n"
+	"uniform %s tex;\n"
+	"uniform float size;\n"
+	"uniform vec2 dx, dy;\n"
+	"out vec4 color;\n"
+	"vec2 hash(vec2 p) {\n"
+	"	p = vec2(dot(p, vec2(127.1, 311.7)), dot(p, vec2(269.5, 183.3)));\n"
+	"	return fract(sin(p) * 43758.5453);\n"
+	"}\n"
+	"void main() {\n"
+	"	vec4 sum = vec4(0.0);\n"
+	"	for (int i = 0; i < %d; i++) {\n"
+	"		vec2 p = %s;\n"
+	"		sum += %s;\n"
+	"	}\n"
+	"	color = sum;\n"
+	"}\n";
+
+static const char *coherent_coord =
+	"fract((gl_FragCoord.xy + float(i) * 0.25) * vec2(dx.x, dy.y))";
+static const char *random_coord =
+	"hash(gl_FragCoord.xy + float(i) * 17.0)";
+
+static const char *vs_source =
+	"#version 150\n"
+	"void main() {\n"
+	"	gl_Position = vec4(gl_VertexID == 1 ? 3.0 : -1.0,\n"
+	"			   gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0);\n"
+	"}\n";
+
+static GLuint vao, fbo, color_rb;
+static bool has_aniso;
+static GLint max_aniso = 1;
+
+/* The configuration being measured. */
+static unsigned cfg[AXIS_COUNT];
+
+static bool
+supported(void)
+{
+	const bool compressed = formats[cfg[AXIS_FORMAT]].block_bytes != 0;
+	const char *ext = formats[cfg[AXIS_FORMAT]].extension;
+
+	if (ext && !piglit_is_extension_supported(ext))
+		return false;
+	if (compressed && cfg[AXIS_DIM] != DIM_2D)
+		return false;
+	if ((GLint)filters[cfg[AXIS_FILTER]].aniso > max_aniso)
+		return false;
+	if (cfg[AXIS_LOOKUP] == 1) {
+		/* Fetches are unfiltered, don't repeat them per filter. */
+		return dims[cfg[AXIS_DIM]].fetch &&
+		       filters[cfg[AXIS_FILTER]].min_filter == GL_NEAREST;
+	}
+	return true;
+}
+
+static unsigned
+texture_width(void)
+{
+	const unsigned size = sizes[cfg[AXIS_SIZE]];
+
+	switch (cfg[AXIS_DIM]) {
+	case DIM_3D:
+		return 1 << (log2u(size) * 2 + 1) / 3;
+	case DIM_CUBE:
+		return size / 2;
+	default:
+		return size;
+	}
+}
+
+/** Create the texture of the current configuration, filled with noise. */
+static GLuint
+create_texture(void)
+{
+	const GLenum target = dims[cfg[AXIS_DIM]].target;
+	const GLenum ifmt = formats[cfg[AXIS_FORMAT]].internal_format;
+	const unsigned block_bytes = formats[cfg[AXIS_FORMAT]].block_bytes;
+	const unsigned width = texture_width();
+	const unsigned levels = log2u(width) + 1;
+	unsigned char *data;
+	unsigned i, level, depth;
+	GLuint tex;
+
+	glGenTextures(1, &tex);
+	glBindTexture(target, tex);
+
+	switch (cfg[AXIS_DIM]) {
+	case DIM_2D_ARRAY:
+		depth = LAYERS;
+		glTexStorage3D(target, levels, ifmt, width, width, depth);
+		break;
+	case DIM_3D:
+		depth = width;
+		glTexStorage3D(target, levels, ifmt, width, width, depth);
+		break;
+	default:
+		depth = 1;
+		glTexStorage2D(target, levels, ifmt, width, width);
+		break;
+	}
+
+	data = malloc((size_t)width * width * depth * 4);
+	for (i = 0; i < width * width * depth * 4; i++)
+		data[i] = rand();
+
+	if (block_bytes) {
+		/* Random blocks, there is no generating mipmaps for these. */
+		for (level = 0; level < levels; level++) {
+			const unsigned w = MAX2(width >> level, 1);
+			const unsigned blocks = (w + 3) / 4;
+
+			glCompressedTexSubImage2D(target, level, 0, 0, w, w,
+						  ifmt,
+						  blocks * blocks * block_bytes,
+						  data);
+		}
+	} else {
+		switch (cfg[AXIS_DIM]) {
+		case DIM_2D_ARRAY:
+		case DIM_3D:
+			glTexSubImage3D(target, 0, 0, 0, 0, width, width,
+					depth, GL_RGBA, GL_UNSIGNED_BYTE,
+					data);
+			break;
+		case DIM_CUBE:
+			for (i = 0; i < 6; i++) {
+				glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X +
+						i, 0, 0, 0, width, width,
+						GL_RGBA, GL_UNSIGNED_BYTE,
+						data);
+			}
+			break;
+		default:
+			glTexSubImage2D(target, 0, 0, 0, width, width,
+					GL_RGBA, GL_UNSIGNED_BYTE, data);
+			break;
+		}
+		glGenerateMipmap(target);
+	}
+	free(data);
+
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER,
+			filters[cfg[AXIS_FILTER]].min_filter);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER,
+			filters[cfg[AXIS_FILTER]].mag_filter);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_REPEAT);
+	if (has_aniso) {
+		glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+				filters[cfg[AXIS_FILTER]].aniso);
+	}
+
+	return tex;
+}
+
+static GLuint
+build_program(void)
+{
+	const bool fetch = cfg[AXIS_LOOKUP] == 1;
+	char fs[2048];
+	GLuint prog;
+
+	snprintf(fs, sizeof(fs), fs_source, dims[cfg[AXIS_DIM]].sampler,
+		 TAPS, cfg[AXIS_PATTERN] ? random_coord : coherent_coord,
+		 fetch ? dims[cfg[AXIS_DIM]].fetch : dims[cfg[AXIS_DIM]].grad);
+	prog = piglit_build_simple_program(vs_source, fs);
+	glUseProgram(prog);
+
+	/* The footprint of a fragment is lod_scale texels high and aniso
+	 * times that wide.
+	 */
+	const float width = texture_width();
+	const float scale = filters[cfg[AXIS_FILTER]].lod_scale / width;
+	glUniform1f(glGetUniformLocation(prog, "size"), width);
+	glUniform2f(glGetUniformLocation(prog, "dx"),
+		    scale * filters[cfg[AXIS_FILTER]].aniso, 0.0);
+	glUniform2f(glGetUniformLocation(prog, "dy"), 0.0, scale);
+	return prog;
+}
+
+static void
+draw(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++)
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void
+print_row(const char *rate)
+{
+	printf("  %-8s, %-9s, %-8s, %5u, %-8s, %-5s, %10s\n",
+	       formats[cfg[AXIS_FORMAT]].name, filters[cfg[AXIS_FILTER]].name,
+	       dims[cfg[AXIS_DIM]].name, sizes[cfg[AXIS_SIZE]],
+	       pattern_names[cfg[AXIS_PATTERN]], lookup_names[cfg[AXIS_LOOKUP]],
+	       rate);
+}
+
+/** Measure the current configuration and print and report its rate. */
+static void
+measure(void)
+{
+	const double texels = (double)FB_SIZE * FB_SIZE * TAPS;
+	GLuint tex, prog;
+	char name[128], rate_str[16];
+	double rate;
+
+	if (!supported()) {
+		print_row("-");
+		return;
+	}
+
+	tex = create_texture();
+	prog = build_program();
+	if (!piglit_check_gl_error(GL_NO_ERROR)) {
+		glDeleteTextures(1, &tex);
+		glDeleteProgram(prog);
+		print_row("-");
+		return;
+	}
+
+	rate = perf_measure_gpu_rate(draw, duration);
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	glDeleteTextures(1, &tex);
+	glDeleteProgram(prog);
+
+	snprintf(rate_str, sizeof(rate_str), "%.2f", rate * texels / 1e9);
+	print_row(rate_str);
+
+	snprintf(name, sizeof(name), "%s %s %s %u %s %s",
+		 formats[cfg[AXIS_FORMAT]].name, filters[cfg[AXIS_FILTER]].name,
+		 dims[cfg[AXIS_DIM]].name, sizes[cfg[AXIS_SIZE]],
+		 pattern_names[cfg[AXIS_PATTERN]],
+		 lookup_names[cfg[AXIS_LOOKUP]]);
+	perf_report("tex-sample", name, "Gtexels/s", texels / 1e9,
+		    perf_last_stats());
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	piglit_require_extension("GL_ARB_texture_storage");
+
+	has_aniso =
+		piglit_is_extension_supported("GL_EXT_texture_filter_anisotropic") ||
+		piglit_is_extension_supported("GL_ARB_texture_filter_anisotropic");
+	if (has_aniso)
+		glGetIntegerv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glGenRenderbuffers(1, &color_rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_rb);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, FB_SIZE, FB_SIZE);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				  GL_RENDERBUFFER, color_rb);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		piglit_report_result(PIGLIT_FAIL);
+	glViewport(0, 0, FB_SIZE, FB_SIZE);
+
+	/* The program only uses gl_VertexID. */
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	unsigned axis, i;
+
+	printf("  %-8s, %-9s, %-8s, %5s, %-8s, %-5s, %10s\n", "Format",
+	       "Filter", "Dim", "Size", "Pattern", "Op", "Gtexels/s");
+
+	if (matrix) {
+		/* Every combination, the last axis changing fastest. */
+		memset(cfg, 0, sizeof(cfg));
+		do {
+			measure();
+			for (axis = AXIS_COUNT; axis-- > 0;) {
+				if (++cfg[axis] < axis_counts[axis])
+					break;
+				cfg[axis] = 0;
+			}
+		} while (axis != ~0u);
+	} else {
+		memcpy(cfg, baseline, sizeof(cfg));
+		measure();
+
+		for (axis = 0; axis < AXIS_COUNT; axis++) {
+			for (i = 0; i < axis_counts[axis]; i++) {
+				if (i == baseline[axis])
+					continue;
+				memcpy(cfg, baseline, sizeof(cfg));
+				cfg[axis] = i;
+				measure();
+			}
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -320,6 +320,15 @@ piglit_display(void)
 				       "%.1f images/sec, %.1f MB/sec\n",
 				       mode_name[mode],
 				       SrcFormats[fmt].name, TexSize, TexSize, rate, mbPerSec);
+
+				if (TexSize <= maxSize) {
+					char name[128];
+					snprintf(name, sizeof(name), "%s(%s %d x %d)",
+						 mode_name[mode], SrcFormats[fmt].name,
+						 TexSize, TexSize);
+					perf_report("teximage", name, "images/sec", 1,
+						    perf_last_stats());
+				}
 			}
 
 			if (SrcFormats[fmt].full_test)
@@ -0,0 +1,477 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure texture upload speed over every combination of target, internal
+ * format, source format and type, size and upload path:
+ *
+ *  - TexImage:    glTexImage* over the same image
+ *  - TexSubImage: glTexSubImage* into an existing image
+ *  - PBO:         glTexSubImage* from a pixel unpack buffer
+ *  - TexStorage:  a new immutable texture filled with glTexSubImage*
+ *  - GenMipmap:   glTexSubImage* of the base level then glGenerateMipmap
+ *
+ * Each row of the output is one target, format and size, each column one
+ * path, in MB/s of level 0 data.  Rows are always in the same order and
+ * unsupported combinations print "-", so the output of two runs can be
+ * diffed directly.  A path much slower than the others of its row usually
+ * means the driver converts the data on the CPU.
+ *
+ * Usage: texupload [-duration SECONDS] [-target NAME] [-format SUBSTRING]
+ *
+ * where -target is one of 2D, 2D_ARRAY, 3D or CUBE_MAP and -format only
+ * keeps the formats whose description contains SUBSTRING.
+ */
+
+#include <string.h>
+#include "common.h"
+#include "piglit-util-gl.h"
+
+static double duration = 0.5;
+static const char *target_filter;
+static const char *format_filter;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 30;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-target") && i + 1 < argc) {
+			target_filter = argv[++i];
+		} else if (!strcmp(argv[i], "-format") && i + 1 < argc) {
+			format_filter = argv[++i];
+		} else {
+			fprintf(stderr, "texupload [-duration SECONDS] "
+				"[-target NAME] [-format SUBSTRING]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Uploads larger than this are skipped. */
+#define MAX_UPLOAD_SIZE (64 * 1024 * 1024)
+/* Layers of array and 3D textures. */
+#define NUM_LAYERS 8
+
+static const struct {
+	GLenum target;
+	const char *name;
+	unsigned layers;
+} targets[] = {
+	{ GL_TEXTURE_2D, "2D", 1 },
+	{ GL_TEXTURE_2D_ARRAY, "2D_ARRAY", NUM_LAYERS },
+	{ GL_TEXTURE_3D, "3D", NUM_LAYERS },
+	{ GL_TEXTURE_CUBE_MAP, "CUBE_MAP", 6 },
+};
+
+enum format_flags {
+	/* Can't be used with glGenerateMipmap */
+	NO_MIPMAP = 1 << 0,
+	/* Can't be used with 3D textures */
+	NO_3D = 1 << 1,
+};
+
+static const struct {
+	GLenum internal_format, format, type;
+	const char *name;
+	unsigned bytes_per_pixel;
+	unsigned flags;
+} formats[] = {
+	{ GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, "RGBA8 <- RGBA/ubyte", 4, 0 },
+	{ GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, "RGBA8 <- BGRA/ubyte", 4, 0 },
+	{ GL_RGBA8, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+	  "RGBA8 <- BGRA/8888_rev", 4, 0 },
+	{ GL_RGBA8, GL_RGB, GL_UNSIGNED_BYTE, "RGBA8 <- RGB/ubyte", 3, 0 },
+	{ GL_RGBA8, GL_RGBA, GL_FLOAT, "RGBA8 <- RGBA/float", 16, 0 },
+	{ GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, "RGB8 <- RGB/ubyte", 3, 0 },
+	{ GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE,
+	  "SRGB8_ALPHA8 <- RGBA/ubyte", 4, 0 },
+	{ GL_R8, GL_RED, GL_UNSIGNED_BYTE, "R8 <- RED/ubyte", 1, 0 },
+	{ GL_RG8, GL_RG, GL_UNSIGNED_BYTE, "RG8 <- RG/ubyte", 2, 0 },
+	{ GL_RGB565, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, "RGB565 <- RGB/565", 2,
+	  0 },
+	{ GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV,
+	  "RGB10_A2 <- RGBA/2101010_rev", 4, 0 },
+	{ GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, "RGBA16F <- RGBA/half", 8, 0 },
+	{ GL_RGBA16F, GL_RGBA, GL_FLOAT, "RGBA16F <- RGBA/float", 16, 0 },
+	{ GL_RGBA32F, GL_RGBA, GL_FLOAT, "RGBA32F <- RGBA/float", 16, 0 },
+	{ GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, "R11F_G11F_B10F <- RGB/float",
+	  12, 0 },
+	{ GL_RGBA8UI, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE,
+	  "RGBA8UI <- RGBA_INTEGER/ubyte", 4, NO_MIPMAP },
+	{ GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT,
+	  "DEPTH24 <- DEPTH/uint", 4, NO_MIPMAP | NO_3D },
+	{ GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT,
+	  "DEPTH32F <- DEPTH/float", 4, NO_MIPMAP | NO_3D },
+};
+
+static const unsigned sizes[] = { 64, 256, 1024 };
+
+enum upload_path {
+	PATH_TEXIMAGE,
+	PATH_TEXSUBIMAGE,
+	PATH_PBO,
+	PATH_TEXSTORAGE,
+	PATH_GENMIPMAP,
+	PATH_COUNT
+};
+
+static const char *path_names[PATH_COUNT] = {
+	"TexImage",
+	"TexSubImage",
+	"PBO",
+	"TexStorage",
+	"GenMipmap",
+};
+
+static GLubyte *data;
+static GLuint tex, pbo;
+
+/* The combination being measured. */
+static unsigned cur_target, cur_format, cur_size;
+
+static GLenum
+target(void)
+{
+	return targets[cur_target].target;
+}
+
+static unsigned
+layers(void)
+{
+	return targets[cur_target].layers;
+}
+
+static unsigned
+layer_size(void)
+{
+	return cur_size * cur_size * formats[cur_format].bytes_per_pixel;
+}
+
+static unsigned
+max_target_size(void)
+{
+	GLint max_size;
+
+	glGetIntegerv(target() == GL_TEXTURE_3D ? GL_MAX_3D_TEXTURE_SIZE :
+		      target() == GL_TEXTURE_CUBE_MAP ?
+		      GL_MAX_CUBE_MAP_TEXTURE_SIZE : GL_MAX_TEXTURE_SIZE,
+		      &max_size);
+	return max_size;
+}
+
+static unsigned
+num_levels(void)
+{
+	unsigned levels = 1;
+
+	while ((cur_size >> levels) > 0)
+		levels++;
+	return levels;
+}
+
+/** glTexImage* of one level, pixels may be NULL. */
+static void
+specify_level(unsigned level, const GLubyte *pixels)
+{
+	const unsigned w = MAX2(cur_size >> level, 1);
+	const unsigned d = target() == GL_TEXTURE_3D ?
+		MAX2(layers() >> level, 1) : layers();
+	const GLenum ifmt = formats[cur_format].internal_format;
+	const GLenum fmt = formats[cur_format].format;
+	const GLenum type = formats[cur_format].type;
+	unsigned face;
+
+	switch (target()) {
+	case GL_TEXTURE_2D:
+		glTexImage2D(GL_TEXTURE_2D, level, ifmt, w, w, 0, fmt, type,
+			     pixels);
+		break;
+	case GL_TEXTURE_CUBE_MAP:
+		for (face = 0; face < 6; face++) {
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+				     level, ifmt, w, w, 0, fmt, type,
+				     pixels ? pixels + face * layer_size() :
+				     NULL);
+		}
+		break;
+	default:
+		glTexImage3D(target(), level, ifmt, w, w, d, 0, fmt, type,
+			     pixels);
+		break;
+	}
+}
+
+/** glTexSubImage* of the whole of level 0. */
+static void
+upload_base_level(const GLubyte *pixels)
+{
+	const GLenum fmt = formats[cur_format].format;
+	const GLenum type = formats[cur_format].type;
+	unsigned face;
+
+	switch (target()) {
+	case GL_TEXTURE_2D:
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cur_size, cur_size,
+				fmt, type, pixels);
+		break;
+	case GL_TEXTURE_CUBE_MAP:
+		for (face = 0; face < 6; face++) {
+			glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+					0, 0, 0, cur_size, cur_size, fmt, type,
+					pixels + face * layer_size());
+		}
+		break;
+	default:
+		glTexSubImage3D(target(), 0, 0, 0, 0, cur_size, cur_size,
+				layers(), fmt, type, pixels);
+		break;
+	}
+}
+
+static void
+create_texture(void)
+{
+	glGenTextures(1, &tex);
+	glBindTexture(target(), tex);
+	glTexParameteri(target(), GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(target(), GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+static void
+upload_teximage(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++)
+		specify_level(0, data);
+	glFinish();
+}
+
+static void
+upload_texsubimage(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++)
+		upload_base_level(data);
+	glFinish();
+}
+
+static void
+upload_pbo(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++)
+		upload_base_level(NULL);
+	glFinish();
+}
+
+static void
+upload_texstorage(unsigned count)
+{
+	const GLenum ifmt = formats[cur_format].internal_format;
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glDeleteTextures(1, &tex);
+		create_texture();
+		if (target() == GL_TEXTURE_2D || target() == GL_TEXTURE_CUBE_MAP)
+			glTexStorage2D(target(), 1, ifmt, cur_size, cur_size);
+		else
+			glTexStorage3D(target(), 1, ifmt, cur_size, cur_size,
+				       layers());
+		upload_base_level(data);
+	}
+	glFinish();
+}
+
+static void
+upload_genmipmap(unsigned count)
+{
+	unsigned i;
+	for (i = 0; i < count; i++) {
+		upload_base_level(data);
+		glGenerateMipmap(target());
+	}
+	glFinish();
+}
+
+static const perf_rate_func path_funcs[PATH_COUNT] = {
+	upload_teximage,
+	upload_texsubimage,
+	upload_pbo,
+	upload_texstorage,
+	upload_genmipmap,
+};
+
+static bool
+path_supported(enum upload_path path)
+{
+	const unsigned flags = formats[cur_format].flags;
+
+	if (path == PATH_TEXSTORAGE &&
+	    !piglit_is_extension_supported("GL_ARB_texture_storage"))
+		return false;
+	if (path == PATH_GENMIPMAP && (flags & NO_MIPMAP))
+		return false;
+	return true;
+}
+
+/** Return the MB/s of path for the current combination, or 0 if it fails. */
+static double
+measure(enum upload_path path)
+{
+	const double bytes = (double)layer_size() * layers();
+	unsigned level;
+	double rate;
+
+	create_texture();
+	switch (path) {
+	case PATH_TEXSUBIMAGE:
+		specify_level(0, NULL);
+		break;
+	case PATH_PBO:
+		specify_level(0, NULL);
+		glGenBuffers(1, &pbo);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, data,
+			     GL_STATIC_DRAW);
+		break;
+	case PATH_GENMIPMAP:
+		for (level = 0; level < num_levels(); level++)
+			specify_level(level, NULL);
+		glTexParameteri(target(), GL_TEXTURE_MAX_LEVEL,
+				num_levels() - 1);
+		break;
+	default:
+		break;
+	}
+
+	rate = perf_measure_cpu_rate(path_funcs[path], duration);
+
+	if (pbo) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &pbo);
+		pbo = 0;
+	}
+	glDeleteTextures(1, &tex);
+	tex = 0;
+
+	/* Report the failure in the matrix instead of stopping. */
+	if (glGetError() != GL_NO_ERROR) {
+		while (glGetError() != GL_NO_ERROR)
+			;
+		return 0;
+	}
+	return rate * bytes / (1024.0 * 1024.0);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	unsigned i;
+
+	data = malloc(MAX_UPLOAD_SIZE);
+	/* Small values that are finite in every float and half float
+	 * format, and not all the same so drivers can't special case them.
+	 */
+	for (i = 0; i < MAX_UPLOAD_SIZE; i++)
+		data[i] = (i * 7) & 0x3f;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	unsigned p, s;
+
+	printf("  %-8s, %-30s, %5s", "Target", "Format", "Size");
+	for (p = 0; p < PATH_COUNT; p++)
+		printf(", %11s", path_names[p]);
+	printf("   (MB/s)\n");
+
+	for (cur_target = 0; cur_target < ARRAY_SIZE(targets); cur_target++) {
+		if (target_filter &&
+		    strcmp(target_filter, targets[cur_target].name))
+			continue;
+
+		for (cur_format = 0; cur_format < ARRAY_SIZE(formats);
+		     cur_format++) {
+			if (format_filter &&
+			    !strstr(formats[cur_format].name, format_filter))
+				continue;
+
+			for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+				enum upload_path path;
+				bool valid;
+
+				cur_size = sizes[s];
+				valid = cur_size <= max_target_size() &&
+					layer_size() * layers() <=
+					MAX_UPLOAD_SIZE &&
+					!(target() == GL_TEXTURE_3D &&
+					  (formats[cur_format].flags & NO_3D));
+
+				printf("  %-8s, %-30s, %5u",
+				       targets[cur_target].name,
+				       formats[cur_format].name, cur_size);
+
+				for (path = 0; path < PATH_COUNT; path++) {
+					double mb_per_sec;
+					char name[128];
+
+					if (!valid || !path_supported(path)) {
+						printf(", %11s", "-");
+						continue;
+					}
+
+					mb_per_sec = measure(path);
+					if (!mb_per_sec) {
+						printf(", %11s", "error");
+						continue;
+					}
+					printf(", %11.1f", mb_per_sec);
+
+					snprintf(name, sizeof(name),
+						 "%s %s %u %s",
+						 targets[cur_target].name,
+						 formats[cur_format].name,
+						 cur_size, path_names[path]);
+					perf_report("texupload", name, "MB/sec",
+						    (double)layer_size() *
+						    layers() /
+						    (1024.0 * 1024.0),
+						    perf_last_stats());
+				}
+				printf("\n");
+			}
+		}
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
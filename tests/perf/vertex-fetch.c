@@ -0,0 +1,337 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the vertex fetch rate of vertex attribute formats, to size the
+ * vertex formats of each GPU.
+ *
+ * The vertex shader reads all of its attributes and sums them into a
+ * position that is clipped, so that the rate is that of the fetch rather
+ * than of the rasterization.  The attributes are described with the column
+ * headers of piglit-vbo.cpp, such as "0/ushort_norm/vec4", and each format
+ * is measured:
+ *
+ *  - with 1, 4, 8 and 16 attributes, interleaved in a buffer with no
+ *    padding between the vertices
+ *  - with 8 attributes in separate buffers, and in either layout with the
+ *    stride of the vertices padded to 64 bytes
+ *  - with 8 interleaved attributes advancing per instance, with divisors 1
+ *    and 4, in draws of 16 vertices per instance
+ *
+ * Usage: vertex-fetch [-format NAME] [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#undef NDEBUG
+#include <assert.h>
+#include "piglit-util-gl.h"
+#include "piglit-vbo.h"
+
+static const char *only_format;
+static double duration = 0.1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 33;
+	config.supports_gl_core_version = 33;
+	config.window_width = 64;
+	config.window_height = 64;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-format") && i + 1 < argc) {
+			only_format = argv[++i];
+		} else if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "vertex-fetch [-format NAME] "
+				"[-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define NUM_VERTICES (64 * 1024)
+#define VERTICES_PER_INSTANCE 16
+#define MAX_ATTRIBS 16
+#define PADDED_STRIDE 64
+
+static const struct format {
+	const char *name;
+	/** The GL and GLSL types of a piglit-vbo column header. */
+	const char *column;
+	/** How the shader turns the attribute into a vec4. */
+	const char *to_vec4;
+	/** GL version required, for the doubles. */
+	unsigned gl_version;
+} formats[] = {
+	{ "float", "float/vec4", "%s", 33 },
+	{ "half", "half/vec4", "%s", 33 },
+	{ "unorm8", "ubyte_norm/vec4", "%s", 33 },
+	{ "snorm16", "short_norm/vec4", "%s", 33 },
+	{ "unorm2_10_10_10", "uint2_10_10_10_norm/vec4", "%s", 33 },
+	{ "snorm2_10_10_10", "int2_10_10_10_norm/vec4", "%s", 33 },
+	{ "double", "double/dvec2", "vec4(vec2(%s), 0, 0)", 41 },
+	{ "int", "int/ivec4", "vec4(%s)", 33 },
+	{ "uint8", "ubyte/uvec4", "vec4(%s)", 33 },
+};
+
+static const unsigned counts[] = { 1, 4, 8, 16 };
+
+struct config {
+	unsigned count;
+	bool separate;
+	bool padded;
+	unsigned divisor;
+};
+
+/* The counts of the sweep, then the layouts and divisors at 8 attributes */
+static const struct config layouts[] = {
+	{ 8, true, false, 0 },
+	{ 8, false, true, 0 },
+	{ 8, true, true, 0 },
+	{ 8, false, false, 1 },
+	{ 8, false, false, 4 },
+};
+
+static GLuint vao, prog;
+static GLuint buffers[MAX_ATTRIBS];
+static unsigned num_buffers;
+static unsigned divisor;
+
+static GLuint
+build_program(const struct format *format, unsigned count)
+{
+	char vs[4096], value[64];
+	unsigned offset, i;
+
+	offset = snprintf(vs, sizeof(vs), "#version %u\n",
+			  format->gl_version == 41 ? 410 : 330);
+	for (i = 0; i < count; i++) {
+		const char *type = strchr(format->column, '/') + 1;
+
+		offset += snprintf(vs + offset, sizeof(vs) - offset,
+				   "layout(location = %u) in %s attr%u;\n",
+				   i, type, i);
+	}
+	offset += snprintf(vs + offset, sizeof(vs) - offset,
+			   "void main() {\n"
+			   "	vec4 sum = vec4(0);\n");
+	for (i = 0; i < count; i++) {
+		char name[16];
+
+		snprintf(name, sizeof(name), "attr%u", i);
+		snprintf(value, sizeof(value), format->to_vec4, name);
+		offset += snprintf(vs + offset, sizeof(vs) - offset,
+				   "	sum += %s;\n", value);
+	}
+	/* w = -1 clips every point. */
+	offset += snprintf(vs + offset, sizeof(vs) - offset,
+			   "	gl_Position = vec4(sum.x + sum.y + sum.z + "
+			   "sum.w, 0, 0, -1);\n"
+			   "}\n");
+	assert(offset < sizeof(vs));
+
+	return piglit_build_simple_program(vs,
+		"#version 330\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	color = vec4(1);\n"
+		"}\n");
+}
+
+static GLuint
+create_buffer(size_t size)
+{
+	GLuint buffer;
+	void *data = malloc(size);
+
+	/* Small normal floats, whatever the type. */
+	memset(data, 0x3c, size);
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+	free(data);
+	return buffer;
+}
+
+/**
+ * Set up the program and the buffers of count attributes of format, laid
+ * out as config says.  Return the bytes fetched per vertex.
+ */
+static size_t
+setup(const struct format *format, const struct config *config)
+{
+	struct piglit_vbo_attrib attribs[MAX_ATTRIBS];
+	char columns[MAX_ATTRIBS * 32];
+	size_t stride = 0, offset = 0, bytes = 0;
+	unsigned i, pos = 0;
+
+	prog = build_program(format, config->count);
+	glUseProgram(prog);
+
+	for (i = 0; i < config->count; i++) {
+		pos += snprintf(columns + pos, sizeof(columns) - pos, "%u/%s ",
+				i, format->column);
+	}
+	piglit_vbo_parse_columns(prog, columns, attribs, config->count);
+
+	for (i = 0; i < config->count; i++)
+		bytes += attribs[i].bytes;
+
+	if (!config->separate) {
+		stride = config->padded ? ALIGN(bytes, PADDED_STRIDE) : bytes;
+		buffers[0] = create_buffer(stride * NUM_VERTICES);
+		num_buffers = 1;
+	}
+
+	for (i = 0; i < config->count; i++) {
+		if (config->separate) {
+			stride = config->padded ? PADDED_STRIDE :
+				attribs[i].bytes;
+			buffers[i] = create_buffer(stride * NUM_VERTICES);
+			num_buffers = i + 1;
+			offset = 0;
+		}
+		piglit_vbo_attrib_pointer(&attribs[i], stride, offset);
+		glVertexAttribDivisor(attribs[i].index, config->divisor);
+		offset += attribs[i].bytes;
+	}
+
+	divisor = config->divisor;
+	return bytes;
+}
+
+static void
+teardown(unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++) {
+		glVertexAttribDivisor(i, 0);
+		glDisableVertexAttribArray(i);
+	}
+	glDeleteBuffers(num_buffers, buffers);
+	glDeleteProgram(prog);
+}
+
+static void
+draw(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		if (divisor) {
+			glDrawArraysInstanced(GL_POINTS, 0,
+					      VERTICES_PER_INSTANCE,
+					      NUM_VERTICES /
+					      VERTICES_PER_INSTANCE);
+		} else {
+			glDrawArrays(GL_POINTS, 0, NUM_VERTICES);
+		}
+	}
+}
+
+static void
+measure(const struct format *format, const struct config *config)
+{
+	const char *layout = config->separate ? "separate" : "interleaved";
+	char name[128], stride[16];
+	double rate;
+	size_t bytes;
+
+	bytes = setup(format, config);
+	rate = perf_measure_gpu_rate(draw, duration) * NUM_VERTICES / 1e6;
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	snprintf(stride, sizeof(stride), "%s", config->padded ? "padded" :
+		 "tight");
+	snprintf(name, sizeof(name), "%s x%u %s %s div%u", format->name,
+		 config->count, layout, stride, config->divisor);
+	perf_report("vertex-fetch", name, "Mverts/s", NUM_VERTICES / 1e6,
+		    perf_last_stats());
+
+	printf("  %-16s, %5u, %11s, %6s, %7u, %6zu, %10.1f, %8.1f\n",
+	       format->name, config->count, layout, stride, config->divisor,
+	       bytes, rate, rate * bytes / 1000);
+
+	teardown(config->count);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	unsigned i;
+
+	if (only_format) {
+		for (i = 0; i < ARRAY_SIZE(formats); i++) {
+			if (!strcmp(only_format, formats[i].name))
+				break;
+		}
+		if (i == ARRAY_SIZE(formats)) {
+			fprintf(stderr, "unknown format %s\n", only_format);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	}
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	GLint max_attribs;
+
+	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &max_attribs);
+
+	printf("  %-16s, %5s, %11s, %6s, %7s, %6s, %10s, %8s\n", "Format",
+	       "Count", "Layout", "Stride", "Divisor", "Bytes", "Mverts/s",
+	       "GB/s");
+
+	for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+		const struct format *format = &formats[f];
+
+		if (only_format && strcmp(only_format, format->name))
+			continue;
+		if (piglit_get_gl_version() < format->gl_version) {
+			printf("  %-16s, skipped, requires GL %u.%u\n",
+			       format->name, format->gl_version / 10,
+			       format->gl_version % 10);
+			continue;
+		}
+
+		for (unsigned c = 0; c < ARRAY_SIZE(counts); c++) {
+			struct config config = { counts[c], false, false, 0 };
+
+			if (counts[c] <= max_attribs)
+				measure(format, &config);
+		}
+		for (unsigned l = 0; l < ARRAY_SIZE(layouts); l++)
+			measure(format, &layouts[l]);
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,388 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Measure the transform feedback capture rate, in vertices and bytes per
+ * second, of points with rasterizer discard:
+ *
+ *  - 1 to 16 vec4 outputs interleaved in one buffer
+ *  - 1 to 4 vec4 outputs in separate buffers
+ *  - 4 vec4 outputs written by a geometry shader emitting 1, 4 or 16
+ *    vertices per input point
+ *  - 4 interleaved vec4 outputs with the capture paused and resumed every
+ *    4096 or 64 vertices
+ *  - 4 interleaved vec4 outputs captured and then drawn again, with a
+ *    GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN query read back for the count
+ *    or with glDrawTransformFeedback
+ *
+ * The captures are timed on the GPU, and the captures followed by a draw on
+ * the CPU up to a glFinish, so that the stall of reading the query counts.
+ * Pausing and glDrawTransformFeedback need GL_ARB_transform_feedback2.
+ *
+ * Usage: xfb [-duration SECONDS]
+ */
+
+#include <string.h>
+#include "common.h"
+#undef NDEBUG
+#include <assert.h>
+#include "piglit-util-gl.h"
+
+static double duration = 0.1;
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 32;
+	config.supports_gl_core_version = 32;
+	config.window_width = 64;
+	config.window_height = 64;
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-duration") && i + 1 < argc) {
+			duration = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "xfb [-duration SECONDS]\n");
+			exit(1);
+		}
+	}
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Vertices captured per draw, whatever the amplification */
+#define NUM_VERTICES (64 * 1024)
+#define MAX_OUTPUTS 16
+
+enum consume {
+	CONSUME_NONE,
+	CONSUME_QUERY,
+	CONSUME_DRAW_XFB,
+};
+
+static const struct config {
+	/** vec4 outputs per vertex */
+	unsigned outputs;
+	bool separate;
+	/** Vertices the geometry shader emits per input point, or 0 */
+	unsigned amplify;
+	/** Vertices between pauses, or 0 */
+	unsigned pause_every;
+	enum consume consume;
+} configs[] = {
+	{ 1, false, 0, 0, CONSUME_NONE },
+	{ 2, false, 0, 0, CONSUME_NONE },
+	{ 4, false, 0, 0, CONSUME_NONE },
+	{ 8, false, 0, 0, CONSUME_NONE },
+	{ 16, false, 0, 0, CONSUME_NONE },
+	{ 1, true, 0, 0, CONSUME_NONE },
+	{ 2, true, 0, 0, CONSUME_NONE },
+	{ 4, true, 0, 0, CONSUME_NONE },
+	{ 4, false, 1, 0, CONSUME_NONE },
+	{ 4, false, 4, 0, CONSUME_NONE },
+	{ 4, false, 16, 0, CONSUME_NONE },
+	{ 4, false, 0, 4096, CONSUME_NONE },
+	{ 4, false, 0, 64, CONSUME_NONE },
+	{ 4, false, 0, 0, CONSUME_QUERY },
+	{ 4, false, 0, 0, CONSUME_DRAW_XFB },
+};
+
+static GLuint vao, consume_vao, query, xfb;
+static GLuint capture_prog, consume_prog;
+static GLuint buffers[MAX_OUTPUTS];
+static unsigned num_buffers;
+static const struct config *cur;
+static bool have_xfb2;
+
+/** Append the declarations of the outputs, named v0, v1, ... */
+static unsigned
+declare_outputs(char *code, unsigned offset, size_t size, unsigned outputs)
+{
+	for (unsigned i = 0; i < outputs; i++) {
+		offset += snprintf(code + offset, size - offset,
+				   "out vec4 v%u;\n", i);
+	}
+	return offset;
+}
+
+static GLuint
+build_capture_program(const struct config *config)
+{
+	const char *varyings[MAX_OUTPUTS];
+	char names[MAX_OUTPUTS][8];
+	char vs[4096], gs[4096];
+	unsigned offset, i;
+	GLuint prog;
+
+	if (config->amplify) {
+		snprintf(vs, sizeof(vs),
+			 "#version 150\n"
+			 "out vec4 seed;\n"
+			 "void main() {\n"
+			 "	seed = vec4(float(gl_VertexID));\n"
+			 "}\n");
+
+		offset = snprintf(gs, sizeof(gs),
+				  "#version 150\n"
+				  "layout(points) in;\n"
+				  "layout(points, max_vertices = %u) out;\n"
+				  "in vec4 seed[];\n", config->amplify);
+		offset = declare_outputs(gs, offset, sizeof(gs),
+					 config->outputs);
+		offset += snprintf(gs + offset, sizeof(gs) - offset,
+				   "void main() {\n"
+				   "	for (int j = 0; j < %u; j++) {\n",
+				   config->amplify);
+		for (i = 0; i < config->outputs; i++) {
+			offset += snprintf(gs + offset, sizeof(gs) - offset,
+					   "		v%u = seed[0] + vec4(j, %u, 0, 1);\n",
+					   i, i);
+		}
+		offset += snprintf(gs + offset, sizeof(gs) - offset,
+				   "		EmitVertex();\n"
+				   "	}\n"
+				   "}\n");
+		assert(offset < sizeof(gs));
+
+		prog = piglit_build_simple_program_unlinked_multiple_shaders(
+			GL_VERTEX_SHADER, vs, GL_GEOMETRY_SHADER, gs, 0);
+	} else {
+		offset = snprintf(vs, sizeof(vs), "#version 150\n");
+		offset = declare_outputs(vs, offset, sizeof(vs),
+					 config->outputs);
+		offset += snprintf(vs + offset, sizeof(vs) - offset,
+				   "void main() {\n"
+				   "	float id = float(gl_VertexID);\n");
+		for (i = 0; i < config->outputs; i++) {
+			offset += snprintf(vs + offset, sizeof(vs) - offset,
+					   "	v%u = vec4(id, %u, 0, 1);\n", i, i);
+		}
+		offset += snprintf(vs + offset, sizeof(vs) - offset, "}\n");
+		assert(offset < sizeof(vs));
+
+		prog = piglit_build_simple_program_unlinked(vs, NULL);
+	}
+
+	for (i = 0; i < config->outputs; i++) {
+		snprintf(names[i], sizeof(names[i]), "v%u", i);
+		varyings[i] = names[i];
+	}
+	glTransformFeedbackVaryings(prog, config->outputs, varyings,
+				    config->separate ? GL_SEPARATE_ATTRIBS :
+				    GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(prog);
+	if (!piglit_link_check_status(prog))
+		piglit_report_result(PIGLIT_FAIL);
+	return prog;
+}
+
+static void
+setup(const struct config *config)
+{
+	size_t vertex_size = config->outputs * 4 * sizeof(float);
+	unsigned i;
+
+	capture_prog = build_capture_program(config);
+
+	if (config->consume == CONSUME_DRAW_XFB)
+		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, xfb);
+
+	num_buffers = config->separate ? config->outputs : 1;
+	glGenBuffers(num_buffers, buffers);
+	for (i = 0; i < num_buffers; i++) {
+		glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, buffers[i]);
+		glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER,
+			     NUM_VERTICES * (config->separate ?
+					     4 * sizeof(float) : vertex_size),
+			     NULL, GL_DYNAMIC_COPY);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, buffers[i]);
+	}
+
+	if (config->consume != CONSUME_NONE) {
+		glBindVertexArray(consume_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, vertex_size, 0);
+		glEnableVertexAttribArray(0);
+		glBindVertexArray(vao);
+	}
+
+	cur = config;
+}
+
+static void
+teardown(void)
+{
+	for (unsigned i = 0; i < num_buffers; i++)
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, i, 0);
+	if (cur->consume == CONSUME_DRAW_XFB)
+		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+	glDeleteBuffers(num_buffers, buffers);
+	glDeleteProgram(capture_prog);
+}
+
+static void
+capture(void)
+{
+	const unsigned input = cur->amplify ? NUM_VERTICES / cur->amplify :
+				NUM_VERTICES;
+	const unsigned step = cur->pause_every ? cur->pause_every : input;
+
+	glUseProgram(capture_prog);
+	glBeginTransformFeedback(GL_POINTS);
+	for (unsigned first = 0; first < input; first += step) {
+		if (first)
+			glResumeTransformFeedback();
+		glDrawArrays(GL_POINTS, first, MIN2(step, input - first));
+		if (first + step < input)
+			glPauseTransformFeedback();
+	}
+	glEndTransformFeedback();
+}
+
+static void
+draw(unsigned count)
+{
+	for (unsigned i = 0; i < count; i++) {
+		GLuint written;
+
+		switch (cur->consume) {
+		case CONSUME_NONE:
+			capture();
+			break;
+		case CONSUME_QUERY:
+			glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN,
+				     query);
+			capture();
+			glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+			glGetQueryObjectuiv(query, GL_QUERY_RESULT, &written);
+
+			glUseProgram(consume_prog);
+			glBindVertexArray(consume_vao);
+			glDrawArrays(GL_POINTS, 0, written);
+			glBindVertexArray(vao);
+			break;
+		case CONSUME_DRAW_XFB:
+			capture();
+
+			glUseProgram(consume_prog);
+			glBindVertexArray(consume_vao);
+			glDrawTransformFeedback(GL_POINTS, xfb);
+			glBindVertexArray(vao);
+			break;
+		}
+	}
+}
+
+static void
+measure(const struct config *config)
+{
+	static const char *consume_names[] = { "-", "query", "draw-xfb" };
+	const double bytes = NUM_VERTICES * config->outputs * 16.0;
+	char name[128], bytes_name[160];
+	double rate;
+
+	setup(config);
+
+	if (config->consume == CONSUME_NONE)
+		rate = perf_measure_gpu_rate(draw, duration);
+	else
+		rate = perf_measure_cpu_rate(draw, duration);
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	snprintf(name, sizeof(name), "%ux vec4 %s amplify%u pause%u %s",
+		 config->outputs,
+		 config->separate ? "separate" : "interleaved",
+		 config->amplify, config->pause_every,
+		 consume_names[config->consume]);
+	snprintf(bytes_name, sizeof(bytes_name), "%s bytes", name);
+	perf_report("xfb", name, "Mverts/s", NUM_VERTICES / 1e6,
+		    perf_last_stats());
+	perf_report("xfb", bytes_name, "GB/s", bytes / 1e9,
+		    perf_last_stats());
+
+	printf("  %7u, %11s, %7u, %6u, %8s, %10.1f, %6.2f\n",
+	       config->outputs, config->separate ? "separate" : "interleaved",
+	       config->amplify, config->pause_every,
+	       consume_names[config->consume], rate * NUM_VERTICES / 1e6,
+	       rate * bytes / 1e9);
+
+	teardown();
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	have_xfb2 = piglit_get_gl_version() >= 40 ||
+		    piglit_is_extension_supported("GL_ARB_transform_feedback2");
+
+	glGenVertexArrays(1, &vao);
+	glGenVertexArrays(1, &consume_vao);
+	glBindVertexArray(vao);
+	glGenQueries(1, &query);
+	if (have_xfb2)
+		glGenTransformFeedbacks(1, &xfb);
+
+	/* w = -1 clips every point. */
+	consume_prog = piglit_build_simple_program_unlinked(
+		"#version 150\n"
+		"in vec4 v;\n"
+		"void main() {\n"
+		"	gl_Position = vec4(v.xyz, -1);\n"
+		"}\n", NULL);
+	glBindAttribLocation(consume_prog, 0, "v");
+	glLinkProgram(consume_prog);
+	if (!piglit_link_check_status(consume_prog))
+		piglit_report_result(PIGLIT_FAIL);
+
+	glEnable(GL_RASTERIZER_DISCARD);
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	GLint max_interleaved, max_separate;
+
+	glGetIntegerv(GL_MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS,
+		      &max_interleaved);
+	glGetIntegerv(GL_MAX_TRANSFORM_FEEDBACK_SEPARATE_ATTRIBS,
+		      &max_separate);
+
+	printf("  %7s, %11s, %7s, %6s, %8s, %10s, %6s\n", "Outputs", "Layout",
+	       "Amplify", "Pause", "Consume", "Mverts/s", "GB/s");
+
+	for (unsigned c = 0; c < ARRAY_SIZE(configs); c++) {
+		const struct config *config = &configs[c];
+
+		if (config->separate ? config->outputs > max_separate :
+		    config->outputs * 4 > max_interleaved)
+			continue;
+		if (!have_xfb2 && (config->pause_every ||
+				   config->consume == CONSUME_DRAW_XFB))
+			continue;
+
+		measure(config);
+	}
+
+	exit(0);
+	return PIGLIT_SKIP;
+}
@@ -0,0 +1,199 @@
+# encoding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+"""Assemble the SPIR-V of the shader tests ahead of running them.
+
+The SPIR-V sections of every .shader_test and .shader_test.spv file are
+assembled into a directory laid out like the PIGLIT_SPIRV_CACHE of
+piglit_assemble_spirv() in tests/util/piglit-shader.c: a file per source,
+named after the FNV-1a hash of the assembler and the source. shader_runner
+then loads the binaries instead of running the assembler, and "piglit run"
+points it at the directory of the build.
+
+manifest.txt lists the file of each section and the script it is from.
+Files that are no longer in it are removed.
+"""
+
+import argparse
+import io
+import multiprocessing
+import os
+import struct
+import subprocess
+import sys
+
+_SECTIONS = (
+    b'[vertex shader spirv]',
+    b'[tessellation control shader spirv]',
+    b'[tessellation evaluation shader spirv]',
+    b'[geometry shader spirv]',
+    b'[fragment shader spirv]',
+    b'[compute shader spirv]',
+)
+
+_MAGIC = b'PSPV'
+
+
+def _lines(text):
+    """Split text after each newline, which is all shader_runner splits on."""
+    lines = [l + b'\n' for l in text.split(b'\n')]
+    lines[-1] = lines[-1][:-1]
+    return [l for l in lines if l]
+
+
+def sections(text):
+    """Yield the source of each SPIR-V section of a shader_test, as
+    shader_runner passes it to piglit_assemble_spirv().
+    """
+    lines = _lines(text)
+    i = 0
+    while i < len(lines):
+        header = lines[i]
+        i += 1
+        if header.startswith(b'[test]'):
+            return
+        if not header.startswith(_SECTIONS):
+            continue
+        start = i
+        while i < len(lines) and not lines[i].startswith(b'['):
+            i += 1
+        if i > start:
+            yield strip_comments(b''.join(lines[start:i]))
+
+
+def strip_comments(source):
+    """Remove the lines starting with '#', like assemble_spirv() does."""
+    out = []
+    for line in _lines(source):
+        if line.startswith(b'#'):
+            # A comment without a newline ends the source
+            if not line.endswith(b'\n'):
+                break
+            continue
+        out.append(line)
+    return b''.join(out)
+
+
+def cache_name(key):
+    """Return the name of the cache file of key, see spirv_cache_path()."""
+    value = 0xcbf29ce484222325
+    for byte in bytearray(key):
+        value ^= byte
+        value = (value * 0x100000001b3) & 0xffffffffffffffff
+    return '{:016x}.spv'.format(value)
+
+
+def is_cached(path, key):
+    """Return whether the cache file at path holds the binary of key."""
+    try:
+        with open(path, 'rb') as f:
+            header = f.read(len(_MAGIC) + 8)
+            if len(header) != len(_MAGIC) + 8 or not header.startswith(_MAGIC):
+                return False
+            length = struct.unpack('=Q', header[len(_MAGIC):])[0]
+            return length == len(key) and f.read(length) == key
+    except OSError:
+        return False
+
+
+def assemble(job):
+    """Assemble the source of job into its cache file, if needed.
+
+    Returns an error message, or None.
+    """
+    assembler, path, key, source, script = job
+    if is_cached(path, key):
+        return None
+
+    proc = subprocess.Popen(
+        [assembler, '--target-env', 'opengl4.5', '-o', '-', '-'],
+        stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    binary, err = proc.communicate(source)
+    if proc.returncode != 0 or not binary:
+        return '{}: {}'.format(script, err.decode('utf-8', 'replace').strip())
+
+    # Written under a name of its own and renamed, like spirv_cache_store()
+    tmp = '{}.{}.tmp'.format(path, os.getpid())
+    with open(tmp, 'wb') as f:
+        f.write(_MAGIC)
+        f.write(struct.pack('=Q', len(key)))
+        f.write(key)
+        f.write(struct.pack('=Q', len(binary)))
+        f.write(binary)
+    os.rename(tmp, path)
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--assembler', default='spirv-as',
+                        help='the spirv-as to assemble with')
+    parser.add_argument('--key', default='spirv-as',
+                        help='the assembler the binaries are stored for, '
+                             'SPIRV-Tools when shader_runner is built with '
+                             'the library')
+    parser.add_argument('output')
+    parser.add_argument('directories', nargs='+')
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.output):
+        os.makedirs(args.output)
+
+    jobs = {}
+    manifest = []
+    for directory in args.directories:
+        for dirpath, _, filenames in os.walk(directory):
+            for filename in sorted(filenames):
+                if not filename.endswith(('.shader_test',
+                                          '.shader_test.spv')):
+                    continue
+                script = os.path.join(dirpath, filename)
+                with open(script, 'rb') as f:
+                    text = f.read()
+                for source in sections(text):
+                    key = args.key.encode('utf-8') + b'\0' + source
+                    name = cache_name(key)
+                    manifest.append('{} {}'.format(name, script))
+                    jobs.setdefault(name, (
+                        args.assembler, os.path.join(args.output, name), key,
+                        source, script))
+
+    pool = multiprocessing.Pool()
+    errors = [e for e in pool.map(assemble, jobs.values(), chunksize=16) if e]
+    pool.close()
+    pool.join()
+    for error in errors:
+        print('Not precompiled: {}'.format(error), file=sys.stderr)
+
+    for name in os.listdir(args.output):
+        if name.endswith('.spv') and name not in jobs:
+            os.unlink(os.path.join(args.output, name))
+
+    manifest.sort()
+    path = os.path.join(args.output, 'manifest.txt')
+    with io.open(path, 'wt', encoding='utf-8') as f:
+        for line in manifest:
+            f.write(line)
+            f.write('\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -30,7 +30,8 @@ with profile.test_list.group_manager(
         g(['arb_shader_image_load_store-coherency', '--quick'], 'coherency')
         g(['arb_shader_image_load_store-host-mem-barrier', '--quick'],
           'host-mem-barrier')
-        g(['arb_shader_image_load_store-max-size', '--quick'], 'max-size')
+        g(['arb_shader_image_load_store-max-size', '--quick'], 'max-size',
+          resource_class='vram')
         g(['arb_shader_image_load_store-semantics', '--quick'], 'semantics')
         g(['arb_shader_image_load_store-shader-mem-barrier', '--quick'],
           'shader-mem-barrier')
@@ -70,12 +71,14 @@ with profile.test_list.group_manager(
         grouptools.join('spec', 'ARB_texture_multisample')) as g:
     with profile.test_list.allow_reassignment:
         size_arg = ['--texsize', '512']
+        # These textures are small enough for a few to run at once
+        vram = {'resource_class': 'vram', 'resource_weight': 0.25}
         g(['arb_texture_multisample-large-float-texture'] + size_arg,
-          'large-float-texture', run_concurrent=False)
+          'large-float-texture', **vram)
         g(['arb_texture_multisample-large-float-texture', '--array'] +
-          size_arg, 'large-float-texture-array', run_concurrent=False)
+          size_arg, 'large-float-texture-array', **vram)
         g(['arb_texture_multisample-large-float-texture', '--fp16'] +
-          size_arg, 'large-float-texture-fp16', run_concurrent=False)
+          size_arg, 'large-float-texture-fp16', **vram)
         g(['arb_texture_multisample-large-float-texture', '--array',
            '--fp16'] + size_arg,
-          'large-float-texture-array-fp16', run_concurrent=False)
+          'large-float-texture-array-fp16', **vram)
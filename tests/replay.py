@@ -52,6 +52,10 @@ Optionally, in piglit.conf one could set also the following:
 [replay]:gfxrecon-replay_bin -- Path to the gfxrecon-replay (GFXReconstruct) executable.
 [replay]:gfxrecon-replay_extra_args -- Space-separated list of extra command line arguments for gfxrecon-replay.
 [replay]:loop_times -- Number of times to replay the last frame in profile mode
+[replay]:warmup_frames -- Number of those replays left out of the frame time statistics
+[replay]:iterations -- Number of times to profile each trace, the frame times of all of them are reported
+[replay]:warmup_iterations -- Number of those iterations left out of the frame time statistics
+[replay]:prefetch -- Number of traces to download ahead of the one replaying
 
 Alternatively (or in addition, since environment variables have precedence),
 one could set:
@@ -65,17 +69,31 @@ PIGLIT_REPLAY_GFXRECON_INFO_BINARY -- environment equivalent of [replay]:gfxreco
 PIGLIT_REPLAY_GFXRECON_REPLAY_BINARY -- environment equivalent of [replay]:gfxrecon-replay_bin
 PIGLIT_REPLAY_GFXRECON_REPLAY_EXTRA_ARGS -- environment equivalent of [replay]:gfxrecon-replay_extra_args
 PIGLIT_REPLAY_LOOP_TIMES -- environment equivalent of [replay]:loop_times
+PIGLIT_REPLAY_WARMUP_FRAMES -- environment equivalent of [replay]:warmup_frames
+PIGLIT_REPLAY_ITERATIONS -- environment equivalent of [replay]:iterations
+PIGLIT_REPLAY_WARMUP_ITERATIONS -- environment equivalent of [replay]:warmup_iterations
+PIGLIT_REPLAY_PREFETCH -- environment equivalent of [replay]:prefetch
+
+With the profile subcommand each trace reports the mean, p50, p90 and p99 of
+its frame times as metrics. apitrace, GFXReconstruct and ANGLE traces can be
+profiled; GFXReconstruct only reports the mean frame time of each iteration.
+Run piglit with --perf-baseline to fail the traces whose frame times regressed
+by more than --perf-threshold.
 
 """
 
 import collections
+import subprocess
 
 from os import path
 
 from framework import core, exceptions, grouptools, profile, status
+from framework.replay import download_utils
+from framework.replay import frame_times
 from framework.replay import query_traces_yaml as qty
+from framework.replay.programs import parsers
 from framework.test.base import DummyTest
-from framework.test.piglit_test import PiglitReplayerTest
+from framework.test.piglit_test import PiglitReplayerTest, TEST_BIN_DIR
 
 __all__ = ['profile']
 
@@ -95,6 +113,42 @@ _EXTRA_ARGS = core.get_option('PIGLIT_REPLAY_EXTRA_ARGS',
                               ('replay', 'extra_args'),
                               default='').split()
 
+_PREFETCH = int(core.get_option('PIGLIT_REPLAY_PREFETCH',
+                                ('replay', 'prefetch'),
+                                default='0'))
+
+# The options of replayer.py download
+_DOWNLOAD_PARSERS = [parsers.DOWNLOAD_URL,
+                     parsers.DOWNLOAD_CACHING_PROXY_URL,
+                     parsers.DOWNLOAD_FORCE,
+                     parsers.DOWNLOAD_MINIO_HOST,
+                     parsers.DOWNLOAD_MINIO_BUCKET,
+                     parsers.DOWNLOAD_ROLE_SESSION_NAME,
+                     parsers.DOWNLOAD_JWT,
+                     parsers.DOWNLOAD_CACHE,
+                     parsers.DB_PATH]
+
+
+def _download_args(args):
+    """Return the arguments in args that replayer.py download takes."""
+    takes_value = {}
+    for parser in _DOWNLOAD_PARSERS:
+        for action in parser._actions:  # pylint: disable=protected-access
+            for option in action.option_strings:
+                takes_value[option] = action.nargs != 0
+
+    result = []
+    args = iter(args)
+    for arg in args:
+        option = arg.partition('=')[0]
+        if option not in takes_value:
+            continue
+        result.append(arg)
+        if takes_value[option] and '=' not in arg:
+            result.append(next(args, ''))
+    return result
+
+
 class ReplayProfile(object):
 
     def __init__(self, subcommand, filename, device_name):
@@ -131,21 +185,47 @@ class ReplayProfile(object):
         """
         PiglitReplayerTest.RESULTS_PATH = self.results_dir
 
+        # A forced download replaces a prefetched trace anyway
+        forced = ('-w' in self.extra_args or
+                  '--force-download' in self.extra_args)
+        if _PREFETCH > 0 and not forced:
+            traces = [t.trace_path for _, t in self.itertests()
+                      if isinstance(t, PiglitReplayerTest)]
+            PiglitReplayerTest.PREFETCHER = download_utils.Prefetcher(
+                traces, fetch=self._download, ahead=_PREFETCH,
+                jobs=_PREFETCH)
+
     def teardown(self):
-        pass
+        if PiglitReplayerTest.PREFETCHER is not None:
+            PiglitReplayerTest.PREFETCHER.shutdown()
+            PiglitReplayerTest.PREFETCHER = None
+
+    def _download(self, trace_path):
+        """Download a trace like the replayer would before replaying it.
+
+        This runs in its own process to keep its output out of the log.
+        """
+        subprocess.run(
+            [path.join(TEST_BIN_DIR, 'replayer.py'), 'download'] +
+            _download_args(self.extra_args) + [trace_path],
+            stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+            check=False)
 
     def _itertests(self):
         """Always iterates tests instead of using the forced test_list."""
         def _iter():
-            # When profiling, only run apitrace traces
-            trace_extensions = ".trace" if self.subcommand == 'profile' else None
+            # When profiling, only run the traces whose backends can profile
+            trace_extensions = (frame_times.PROFILE_EXTENSIONS
+                                if self.subcommand == 'profile' else None)
             for t in qty.traces(self.yaml, trace_extensions=trace_extensions, device_name=self.device_name, checksum=True):
                 group_path = path.join('trace', self.device_name, t['path'])
                 k = grouptools.from_path(group_path)
                 trace_extra_args = [t['path']]
                 if self.subcommand == 'compare':
                     trace_extra_args.append(t['checksum'])
-                v = PiglitReplayerTest(self.subcommand, self.extra_args + trace_extra_args)
+                v = PiglitReplayerTest(self.subcommand,
+                                       self.extra_args + trace_extra_args,
+                                       trace_path=t['path'])
                 yield k, v
 
         for k, v in self.filters.run(_iter()):
@@ -23,18 +23,22 @@
 
 import argparse
 import gzip
+import io
+import json
+import multiprocessing
 import os
 import sys
 import xml.etree.ElementTree as et
+from xml.sax.saxutils import quoteattr
 
 sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
 
 from framework.test.piglit_test import (
-    PiglitGLTest, PiglitCLTest, ASMParserTest, BuiltInConstantsTest,
-    CLProgramTester, VkRunnerTest
+    PiglitGLTest, PiglitCLTest, ASMParserTest, MultiASMParserTest,
+    BuiltInConstantsTest, CLProgramTester, VkRunnerTest, MultiVkRunnerTest
 )
 from framework.test.shader_test import ShaderTest, MultiShaderTest
-from framework.test.glsl_parser_test import GLSLParserTest
+from framework.test.glsl_parser_test import GLSLParserTest, MultiGLSLParserTest
 from framework.profile import load_test_profile
 from framework.options import OPTIONS
 
@@ -42,12 +46,16 @@ from framework.options import OPTIONS
 def parser():
     """Parse command line arguments."""
     parser = argparse.ArgumentParser()
-    parser.add_argument('name')
-    parser.add_argument('input')
-    parser.add_argument('output')
+    parser.add_argument('profiles', nargs='+', metavar='name input output',
+                        help='the name, python file and XML file of each '
+                             'profile to serialize')
     parser.add_argument('--no-process-isolation', action='store_true')
     parser.add_argument('--glsl-arb-compat', action='store_true')
     args = parser.parse_args()
+    if len(args.profiles) % 3:
+        parser.error('each profile needs a name, an input and an output')
+    args.profiles = [args.profiles[i:i + 3]
+                     for i in range(0, len(args.profiles), 3)]
     return args
 
 
@@ -70,79 +78,170 @@ def _serialize_skips(test, elem):
             et.SubElement(elem, 'option', name=f, value=repr(value))
 
 
+# The number of tests in each gzip member of the XML file
+TESTS_PER_MEMBER = 256
+
+
+def _write_member(f, data, mtime):
+    """Write data to f as a gzip member, return its offset and length."""
+    start = f.tell()
+    with gzip.GzipFile(fileobj=f, mode='wb', mtime=mtime) as g:
+        g.write(data)
+    return [start, f.tell() - start]
+
+
+def _write_xml(name, count, elements, outfile, mtime):
+    """Write the test list elements to outfile, and an index of it.
+
+    The elements are written as they come, so the whole list is never held
+    in memory. The file is made of several gzip members, which gzip readers
+    see as one stream, each holding TESTS_PER_MEMBER tests. The index, in
+    outfile.index, lists each test and where its element is, so that
+    XMLProfile can filter tests by name without parsing the whole file, and
+    then only decompress and parse the members holding the tests it needs.
+    """
+    index = {'members': [], 'tests': []}
+
+    with open(outfile, 'wb') as f:
+        index['members'].append(_write_member(
+            f,
+            "<?xml version='1.0' encoding='utf-8'?>\n"
+            "<PiglitTestList count={} name={}>".format(
+                quoteattr(str(count)), quoteattr(name)).encode('utf-8'),
+            mtime))
+
+        data = io.BytesIO()
+        for elem in elements:
+            if len(index['tests']) % TESTS_PER_MEMBER == 0 and data.tell():
+                index['members'].append(
+                    _write_member(f, data.getvalue(), mtime))
+                data = io.BytesIO()
+            start = data.tell()
+            data.write(et.tostring(elem, encoding='unicode').encode('utf-8'))
+            index['tests'].append([elem.attrib['name'],
+                                   len(index['members']), start,
+                                   data.tell() - start])
+        if data.tell():
+            index['members'].append(_write_member(f, data.getvalue(), mtime))
+
+        index['members'].append(_write_member(f, b'</PiglitTestList>', mtime))
+        index['size'] = f.tell()
+        index['count'] = len(index['tests'])
+
+    with open(outfile + '.index', 'w') as f:
+        json.dump(index, f)
+
+
+def _element(name, test):
+    """Return the XML element of test, or None if it can't be serialized."""
+    if isinstance(test, PiglitGLTest):
+        elem = et.Element('Test', type='gl', name=name)
+        if test.require_platforms:
+            et.SubElement(elem, 'option', name='require_platforms',
+                          value=repr(test.require_platforms))
+        if test.exclude_platforms:
+            et.SubElement(elem, 'option', name='exclude_platforms',
+                          value=repr(test.exclude_platforms))
+        if test.isolate_in_host:
+            et.SubElement(elem, 'option', name='isolate_in_host',
+                          value=repr(test.isolate_in_host))
+        if test.parallel_subtests:
+            et.SubElement(elem, 'option', name='parallel_subtests',
+                          value=repr(test.parallel_subtests))
+        _serialize_skips(test, elem)
+    elif isinstance(test, BuiltInConstantsTest):
+        elem = et.Element('Test', type='gl_builtin', name=name)
+    elif isinstance(test, GLSLParserTest):
+        elem = et.Element('Test', type='glsl_parser', name=name)
+        _serialize_skips(test, elem)
+    elif isinstance(test, ASMParserTest):
+        elem = et.Element('Test', type='asm_parser', name=name)
+        et.SubElement(elem, 'option', name='type_',
+                      value=repr(test.command[1]))
+        et.SubElement(elem, 'option', name='filename',
+                      value=repr(test.filename))
+        return elem
+    elif isinstance(test, MultiASMParserTest):
+        elem = et.Element('Test', type='multi_asm_parser', name=name)
+        et.SubElement(elem, 'option', name='type_',
+                      value=repr(test.type_))
+        et.SubElement(elem, 'option', name='filenames',
+                      value=repr(test.filenames))
+        et.SubElement(elem, 'option', name='extensions',
+                      value=repr(test.extensions))
+        return elem
+    elif isinstance(test, ShaderTest):
+        elem = et.Element('Test', type='shader', name=name)
+        _serialize_skips(test, elem)
+    elif isinstance(test, MultiShaderTest):
+        elem = et.Element('Test', type='multi_shader', name=name)
+        et.SubElement(elem, 'option', name='prog', value=repr(test.prog))
+        et.SubElement(elem, 'option', name='files', value=repr(test.files))
+        et.SubElement(elem, 'option', name='subtests', value=repr(test.subtests))
+        skips = et.SubElement(elem, 'Skips')
+        for s in test.skips:
+            skip = et.SubElement(skips, 'Skip')
+            _serialize_skips(s, skip)
+        return elem
+    elif isinstance(test, MultiGLSLParserTest):
+        elem = et.Element('Test', type='multi_glsl_parser', name=name)
+        et.SubElement(elem, 'option', name='prog', value=repr(test.prog))
+        et.SubElement(elem, 'option', name='version', value=repr(test.version))
+        et.SubElement(elem, 'option', name='tests', value=repr(test.tests))
+        et.SubElement(elem, 'option', name='subtests', value=repr(test.subtests))
+        skips = et.SubElement(elem, 'Skips')
+        for s in test.skips:
+            skip = et.SubElement(skips, 'Skip')
+            _serialize_skips(s, skip)
+        return elem
+    elif isinstance(test, CLProgramTester):
+        elem = et.Element('Test', type='cl_prog', name=name)
+        et.SubElement(elem, 'option', name='filename',
+                      value=repr(test.filename))
+        return elem
+    elif isinstance(test, PiglitCLTest):
+        elem = et.Element('Test', type='cl', name=name)
+        et.SubElement(elem, 'option', name='command', value=repr(test._command))
+        return elem
+    elif isinstance(test, MultiVkRunnerTest):
+        elem = et.Element('Test', type='multi_vkrunner', name=name)
+        et.SubElement(elem, 'option', name='filenames',
+                      value=repr(test.filenames))
+        return elem
+    elif isinstance(test, VkRunnerTest):
+        elem = et.Element('Test', type='vkrunner', name=name)
+        et.SubElement(elem, 'option', name='filename',
+                      value=repr(test.filename))
+        return elem
+    else:
+        return None
+
+    et.SubElement(elem, 'option', name='command', value=repr(test._command))
+    et.SubElement(elem, 'option', name='run_concurrent',
+                  value=repr(test.run_concurrent))
+    if test.cwd:
+        et.SubElement(elem, 'option', name='cwd', value=test.cwd)
+    if test.resource_class:
+        et.SubElement(elem, 'option', name='resource_class',
+                      value=repr(test.resource_class))
+        et.SubElement(elem, 'option', name='resource_weight',
+                      value=repr(test.resource_weight))
+    if test.env:
+        env = et.SubElement(elem, 'environment')
+        for k, v in test.env.items():
+            et.SubElement(env, 'env', name=k, value=v)
+    return elem
+
+
 def serializer(name, profile, outfile):
     """Take each test in the profile and write it out into the xml."""
-    # TODO: This is going to take a lot of memory
-    root = et.Element('PiglitTestList', count=str(len(profile)),
-                      name=name)
-    for name, test in profile.itertests():
-        if isinstance(test, PiglitGLTest):
-            elem = et.SubElement(root, 'Test', type='gl', name=name)
-            if test.require_platforms:
-                et.SubElement(elem, 'option', name='require_platforms',
-                              value=repr(test.require_platforms))
-            if test.exclude_platforms:
-                et.SubElement(elem, 'option', name='exclude_platforms',
-                              value=repr(test.exclude_platforms))
-            _serialize_skips(test, elem)
-        elif isinstance(test, BuiltInConstantsTest):
-            elem = et.SubElement(root, 'Test', type='gl_builtin', name=name)
-        elif isinstance(test, GLSLParserTest):
-            elem = et.SubElement(root, 'Test', type='glsl_parser', name=name)
-            _serialize_skips(test, elem)
-        elif isinstance(test, ASMParserTest):
-            elem = et.SubElement(root, 'Test', type='asm_parser', name=name)
-            et.SubElement(elem, 'option', name='type_',
-                          value=repr(test.command[1]))
-            et.SubElement(elem, 'option', name='filename',
-                          value=repr(test.filename))
-            continue
-        elif isinstance(test, ShaderTest):
-            elem = et.SubElement(root, 'Test', type='shader', name=name)
-            _serialize_skips(test, elem)
-        elif isinstance(test, MultiShaderTest):
-            elem = et.SubElement(root, 'Test', type='multi_shader', name=name)
-            et.SubElement(elem, 'option', name='prog', value=repr(test.prog))
-            et.SubElement(elem, 'option', name='files', value=repr(test.files))
-            et.SubElement(elem, 'option', name='subtests', value=repr(test.subtests))
-            skips = et.SubElement(elem, 'Skips')
-            for s in test.skips:
-                skip = et.SubElement(skips, 'Skip')
-                _serialize_skips(s, skip)
-            continue
-        elif isinstance(test, CLProgramTester):
-            elem = et.SubElement(root, 'Test', type='cl_prog', name=name)
-            et.SubElement(elem, 'option', name='filename',
-                          value=repr(test.filename))
-            continue
-        elif isinstance(test, PiglitCLTest):
-            elem = et.SubElement(root, 'Test', type='cl', name=name)
-            et.SubElement(elem, 'option', name='command', value=repr(test._command))
-            continue
-        elif isinstance(test, VkRunnerTest):
-            elem = et.SubElement(root, 'Test', type='vkrunner', name=name)
-            et.SubElement(elem, 'option', name='filename',
-                          value=repr(test.filename))
-            continue
-        else:
-            continue
+    elements = (_element(n, t) for n, t in profile.itertests())
 
-        et.SubElement(elem, 'option', name='command', value=repr(test._command))
-        et.SubElement(elem, 'option', name='run_concurrent',
-                      value=repr(test.run_concurrent))
-        if test.cwd:
-            et.SubElement(elem, 'option', name='cwd', value=test.cwd)
-        if test.env:
-            env = et.SubElement(elem, 'environment')
-            for k, v in test.env.items():
-                et.SubElement(env, 'env', name=k, value=v)
-
-    tree = et.ElementTree(root)
     reproducible_mtime = None
     if 'SOURCE_DATE_EPOCH' in os.environ:
-        reproducible_mtime=os.environ['SOURCE_DATE_EPOCH']
-    with gzip.GzipFile(outfile, 'wb', mtime=reproducible_mtime) as f:
-        tree.write(f, encoding='utf-8', xml_declaration=True)
+        reproducible_mtime = int(os.environ['SOURCE_DATE_EPOCH'])
+    _write_xml(name, len(profile), (e for e in elements if e is not None),
+               outfile, reproducible_mtime)
 
 
 def main():
@@ -150,8 +249,26 @@ def main():
     OPTIONS.process_isolation = not args.no_process_isolation
     if args.glsl_arb_compat:
         os.environ['PIGLIT_FORCE_GLSLPARSER_DESKTOP'] = 'true'
-    profile = load_test_profile(args.input, python=True)
-    serializer(args.name, profile, args.output)
+
+    # The profiles are all loaded here first, most of them are copies of
+    # another one, which is then only built once. They are then written by
+    # a child process each, which shares them with this one.
+    jobs = [(name, load_test_profile(input_, python=True), output)
+            for name, input_, output in args.profiles]
+
+    if len(jobs) == 1 or 'fork' not in multiprocessing.get_all_start_methods():
+        for job in jobs:
+            serializer(*job)
+        return
+
+    context = multiprocessing.get_context('fork')
+    workers = [context.Process(target=serializer, args=job) for job in jobs]
+    for worker in workers:
+        worker.start()
+    for worker in workers:
+        worker.join()
+    if any(w.exitcode != 0 for w in workers):
+        sys.exit(1)
 
 
 if __name__ == '__main__':
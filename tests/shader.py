@@ -7,7 +7,8 @@ import os
 from framework.options import OPTIONS
 from framework import grouptools
 from framework.profile import TestProfile
-from framework.test.shader_test import ShaderTest, MultiShaderTest
+from framework.test.shader_test import (
+    BUNDLE_NAME, ShaderTest, MultiShaderTest, read_bundle)
 from .py_modules.constants import GENERATED_TESTS_DIR, TESTS_DIR
 
 __all__ = ['profile']
@@ -22,30 +23,38 @@ gen_basepath = os.path.relpath(os.path.join(GENERATED_TESTS_DIR, '..'), basepath
 
 for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
     isgenerated = basedir == GENERATED_TESTS_DIR
-    for dirpath, _, filenames in os.walk(basedir):
+    for dirpath, dirnames, filenames in os.walk(basedir):
+        # The benchmarks of generated_tests/perf are run by the perf profile
+        if isgenerated and dirpath == basedir and 'perf' in dirnames:
+            dirnames.remove('perf')
         groupname = grouptools.from_path(os.path.relpath(dirpath, basedir))
-        for filename in filenames:
-            testname, ext = os.path.splitext(filename)
-            if ext == '.shader_test':
-                dirname = os.path.relpath(dirpath, basepath)
-                filepath = os.path.join(dirname, filename)
-                if isgenerated:
-                    installpath = os.path.relpath(filepath, gen_basepath)
-                else:
-                    installpath = None
-
-                if OPTIONS.process_isolation:
-                    test = ShaderTest.new(filepath, installpath)
-                else:
-                    shader_tests[groupname].append((filepath, installpath))
-                    continue
+        tests = [(os.path.splitext(f)[0], f) for f in filenames
+                 if f.endswith('.shader_test')]
+
+        # Run the tests of the bundle of a directory instead of its files, if
+        # the build wrote one, the files are then never opened.
+        if isgenerated and BUNDLE_NAME in filenames:
+            bundle = os.path.join(dirpath, BUNDLE_NAME)
+            tests = [(r['name'], '{}#{}'.format(BUNDLE_NAME, i))
+                     for i, r in enumerate(read_bundle(bundle))]
+
+        for testname, filename in tests:
+            dirname = os.path.relpath(dirpath, basepath)
+            filepath = os.path.join(dirname, filename)
+            if isgenerated:
+                installpath = os.path.relpath(filepath, gen_basepath)
             else:
+                installpath = None
+
+            if not OPTIONS.process_isolation:
+                shader_tests[groupname].append(
+                    (filepath, installpath, testname))
                 continue
 
             group = grouptools.join(groupname, testname)
             assert group not in profile.test_list, group
 
-            profile.test_list[group] = test
+            profile.test_list[group] = ShaderTest.new(filepath, installpath)
 
 # Because we need to handle duplicate group names in TESTS and GENERATED_TESTS
 # this dictionary is constructed, then added to the actual test dictionary.
@@ -54,16 +63,15 @@ for group, files in shader_tests.items():
 
     # This makes the xml output reproducible, as os.walk() order is random
     files.sort()
-    # We'll end up with a list of tuples, split that into two list
-    files, installedfiles = list(zip(*files))
+    # We'll end up with a list of tuples, split that into three lists
+    files, installedfiles, testnames = list(zip(*files))
     files = list(files)
     installedfiles = list(installedfiles)
 
     # If there is only one file in the directory use a normal shader_test.
     # Otherwise use a MultiShaderTest
     if len(files) == 1:
-        group = grouptools.join(
-            group, os.path.basename(os.path.splitext(files[0])[0]))
+        group = grouptools.join(group, testnames[0])
         profile.test_list[group] = ShaderTest.new(files[0], installedfiles[0])
     else:
         if all(i is None for i in installedfiles):
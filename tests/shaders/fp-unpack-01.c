@@ -154,8 +154,7 @@ pack(float *packed, const float *color, GLenum type)
 
 	switch (type) {
 	case GL_HALF_FLOAT:
-		for (i = 0; i < 4; i++)
-			us[i] = piglit_half_from_float(color[i]);
+		piglit_half_from_float_array(us, color, 4);
 
 		p[0] = (us[0]) | (us[1] << 16);
 		p[1] = (us[2]) | (us[3] << 16);
@@ -37,6 +37,14 @@
 
 #include "shader_runner_vs_passthrough_spv.h"
 
+#ifdef PIGLIT_USE_OPENGL
+#include "../perf/common.h"
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#endif
+
 #define DEFAULT_WINDOW_WIDTH 250
 #define DEFAULT_WINDOW_HEIGHT 250
 
@@ -58,7 +66,11 @@ PIGLIT_GL_TEST_CONFIG_BEGIN
 	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
 	config.khr_no_error_support = PIGLIT_NO_ERRORS;
 
-	if (argc > 1) {
+	/* In -server mode the first argument may be an option, in which
+	 * case the context is created for the defaults and will be
+	 * re-created as soon as a test needs something else.
+	 */
+	if (argc > 1 && argv[1][0] != '-') {
 		bool spirv = spirv_replaces_glsl;
 
 		for (int i = 1; i < argc; ++i) {
@@ -75,6 +87,16 @@ PIGLIT_GL_TEST_CONFIG_BEGIN
 
 	current_config = config;
 
+	/* Running several tests, the context of each configuration is kept
+	 * for the later tests needing it again.
+	 */
+	if (argc > 2)
+		piglit_reuse_gl_contexts = true;
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-server"))
+			piglit_reuse_gl_contexts = true;
+	}
+
 PIGLIT_GL_TEST_CONFIG_END
 
 static const char passthrough_vertex_shader_source[] =
@@ -138,6 +160,69 @@ static char *text = NULL;
 static const char *test_start = NULL;
 static unsigned test_start_line_num = 0;
 
+/**
+ * Commands of the [test] section that are decoded once by
+ * compile_test_commands() instead of on every pass of piglit_display().
+ * Anything not listed here is kept as TEST_OP_SCRIPT and handed to the
+ * generic text parser.
+ */
+enum test_opcode {
+	TEST_OP_SCRIPT = 0,
+	TEST_OP_CLEAR,
+	TEST_OP_CLEAR_COLOR,
+	TEST_OP_CLEAR_DEPTH,
+	TEST_OP_DRAW_RECT,
+	TEST_OP_DRAW_ARRAYS,
+	TEST_OP_PROBE_RGBA,
+	TEST_OP_PROBE_RGB,
+	TEST_OP_PROBE_RECT_RGBA,
+	TEST_OP_PROBE_ALL_RGBA,
+	TEST_OP_PROBE_ALL_RGB,
+	TEST_OP_BENCHMARK_DRAW_RECT,
+	TEST_OP_BENCHMARK_COMPUTE,
+};
+
+struct test_command {
+	enum test_opcode op;
+	unsigned line_num;
+	const char *line;
+
+	/* Set on the first and last command of a run of color probes
+	 * that can share a single framebuffer readback.
+	 */
+	bool probe_batch_begin;
+	bool probe_batch_end;
+
+	/* Set on the last command of a run of SSBO, atomic counter and
+	 * transform feedback buffer probes, which share one copy of the
+	 * buffer they probe.
+	 */
+	bool buffer_probe_end;
+
+	union {
+		float f[8];
+		struct {
+			int x, y, w, h;
+			float color[4];
+		} rect;
+		struct {
+			GLenum mode;
+			int first;
+			int count;
+		} draw;
+		struct {
+			float rect[4];
+			GLuint groups[3];
+			/* Draws or dispatches per measured iteration. */
+			unsigned iterations;
+		} benchmark;
+	} args;
+};
+
+static char *test_command_text = NULL;
+static struct test_command *test_commands = NULL;
+static unsigned num_test_commands = 0;
+
 static GLuint vertex_shaders[256];
 static unsigned num_vertex_shaders = 0;
 static GLuint tess_ctrl_shaders[256];
@@ -152,6 +237,21 @@ static GLuint compute_shaders[256];
 static unsigned num_compute_shaders = 0;
 static int num_uniform_blocks;
 static GLuint *uniform_block_bos;
+
+/**
+ * CPU copy of the contents of a uniform block buffer.  The "uniform"
+ * commands write into it, and the range they wrote is uploaded once
+ * before the next command that may use the buffer.
+ */
+struct uniform_block_shadow {
+	char *data;
+	GLint size;
+	/** Range to upload, empty when dirty_begin >= dirty_end. */
+	GLint dirty_begin;
+	GLint dirty_end;
+};
+static struct uniform_block_shadow *uniform_block_shadows;
+static bool uniform_blocks_dirty;
 static int *uniform_block_indexes; /* ubo block index, indexed by ubo binding */
 static GLenum geometry_layout_input_type = GL_TRIANGLES;
 static GLenum geometry_layout_output_type = GL_TRIANGLE_STRIP;
@@ -206,10 +306,34 @@ static size_t elements_buffer_size;
 
 static bool use_get_program_binary = false;
 
+/* Directory of the on-disk program binary cache, NULL when disabled. */
+static const char *program_cache_dir = NULL;
+static bool shaders_deferred = false;
+
+/* Whether the driver compiles and links in the background, in which case
+ * every compile and link is started before any status is queried.
+ */
+static bool parallel_shader_compile = false;
+
 static bool ignore_missing_uniforms = false;
 
 static bool report_subtests = false;
 
+static bool server_mode = false;
+
+/* Whether -profile was given, and the time of each step and command of the
+ * test is reported.
+ */
+static bool profile_mode = false;
+
+/* Whether GL_TIME_ELAPSED queries can be used. */
+static bool timer_query_supported = false;
+
+/* Prefix of the names of the metrics reported by -profile and the
+ * benchmark commands, the test name when running several tests.
+ */
+static const char *metric_prefix = NULL;
+
 struct specialization_list {
 	size_t buffer_size;
 	size_t n_entries;
@@ -220,6 +344,112 @@ struct specialization_list {
 static struct specialization_list
 specializations[SHADER_TYPES];
 
+/**
+ * Memory that lives as long as the test file being run: the test commands,
+ * uniform block shadows, uniform location table, include paths, element
+ * and specialization lists.  It is bump-allocated from blocks, which
+ * reset_file_arena() releases all at once before the next file instead of
+ * freeing each allocation.
+ */
+struct arena_block {
+	struct arena_block *next;
+	size_t size;
+	size_t used;
+};
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT 16
+#define ARENA_HEADER_SIZE ALIGN(sizeof(struct arena_block), ARENA_ALIGNMENT)
+
+/** The block being allocated from, followed by the full ones. */
+static struct arena_block *file_arena;
+
+static void *
+file_arena_alloc(size_t size)
+{
+	struct arena_block *block = file_arena;
+	void *ptr;
+
+	size = ALIGN(MAX2(size, 1), ARENA_ALIGNMENT);
+	if (block == NULL || block->size - block->used < size) {
+		size_t block_size = MAX2(size, ARENA_BLOCK_SIZE);
+
+		block = malloc(ARENA_HEADER_SIZE + block_size);
+		if (block == NULL) {
+			fprintf(stderr, "%s: allocation failed.\n", __func__);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+		block->size = block_size;
+		block->used = 0;
+		block->next = file_arena;
+		file_arena = block;
+	}
+
+	ptr = (char *) block + ARENA_HEADER_SIZE + block->used;
+	block->used += size;
+	return ptr;
+}
+
+static void *
+file_arena_calloc(size_t count, size_t size)
+{
+	void *ptr = file_arena_alloc(count * size);
+
+	memset(ptr, 0, count * size);
+	return ptr;
+}
+
+/**
+ * Grow an array allocated from the arena, like realloc().  The old array
+ * is only given back by the next reset.
+ */
+static void *
+file_arena_grow(void *ptr, size_t old_size, size_t new_size)
+{
+	void *new_ptr = file_arena_alloc(new_size);
+
+	if (ptr != NULL)
+		memcpy(new_ptr, ptr, MIN2(old_size, new_size));
+	return new_ptr;
+}
+
+static char *
+file_arena_strndup(const char *str, size_t len)
+{
+	char *copy = file_arena_alloc(len + 1);
+
+	memcpy(copy, str, len);
+	copy[len] = '\0';
+	return copy;
+}
+
+/**
+ * Release everything allocated from the arena.  The first standard-sized
+ * block is kept for the next file, so that small files don't allocate at
+ * all.
+ */
+static void
+reset_file_arena(void)
+{
+	struct arena_block *keep = NULL;
+
+	while (file_arena != NULL) {
+		struct arena_block *next = file_arena->next;
+
+		if (keep == NULL && file_arena->size == ARENA_BLOCK_SIZE)
+			keep = file_arena;
+		else
+			free(file_arena);
+		file_arena = next;
+	}
+
+	if (keep != NULL) {
+		keep->next = NULL;
+		keep->used = 0;
+	}
+	file_arena = keep;
+}
+
 static struct texture_binding {
 	GLuint obj;
 	unsigned width;
@@ -516,12 +746,188 @@ target_to_short_name(GLenum target)
 }
 
 
+static void
+start_compile_shader(GLuint shader)
+{
+	if (num_shader_include_paths) {
+		glCompileShaderIncludeARB(shader, num_shader_include_paths,
+					  (const char **) shader_include_path, NULL);
+	} else
+		glCompileShader(shader);
+}
+
 static enum piglit_result
-compile_glsl(GLenum target)
+check_compile_status(GLuint shader, GLenum target)
 {
-	GLuint shader = glCreateShader(target);
 	GLint ok;
 
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+
+	if (!ok) {
+		GLchar *info;
+		GLint size;
+
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &size);
+		info = malloc(size);
+
+		glGetShaderInfoLog(shader, size, NULL, info);
+
+		fprintf(stderr, "Failed to compile %s: %s\n",
+			target_to_short_name(target),
+			info);
+
+		free(info);
+		return PIGLIT_FAIL;
+	}
+
+	return PIGLIT_PASS;
+}
+
+static enum piglit_result
+compile_shader(GLuint shader, GLenum target)
+{
+	enum piglit_result result;
+
+	piglit_trace_begin("compile");
+	start_compile_shader(shader);
+	result = check_compile_status(shader, target);
+	piglit_trace_end();
+
+	return result;
+}
+
+static uint64_t
+fnv1a_64(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= UINT64_C(0x100000001b3);
+	}
+
+	return hash;
+}
+
+static uint64_t
+fnv1a_64_str(uint64_t hash, const char *str)
+{
+	/* Include the terminator so that consecutive strings can't
+	 * alias each other.
+	 */
+	return fnv1a_64(hash, str ? str : "", str ? strlen(str) + 1 : 1);
+}
+
+/**
+ * Compiled GLSL shaders kept from one test file to the next when several
+ * files run in the same process, so that a stage whose source is the same
+ * as in a previous file isn't compiled again.
+ */
+struct cached_shader {
+	GLenum target;
+	uint64_t hash;
+	/** The source, with the #version line added by compile_glsl(). */
+	char *source;
+	GLuint shader;
+	/** Whether the shader is used by the current test. */
+	bool in_use;
+	/** Whether the shader compiled, false until it was checked. */
+	bool compiled;
+};
+
+#define MAX_CACHED_SHADERS 64
+
+static struct cached_shader shader_cache[MAX_CACHED_SHADERS];
+static unsigned num_cached_shaders;
+static bool use_shader_cache = false;
+
+static struct cached_shader *
+find_cached_shader(GLenum target, uint64_t hash, const char *source)
+{
+	for (unsigned i = 0; i < num_cached_shaders; i++) {
+		if (shader_cache[i].target == target &&
+		    shader_cache[i].hash == hash &&
+		    strcmp(shader_cache[i].source, source) == 0)
+			return &shader_cache[i];
+	}
+
+	return NULL;
+}
+
+static struct cached_shader *
+cached_shader_of(GLuint shader)
+{
+	for (unsigned i = 0; i < num_cached_shaders; i++) {
+		if (shader_cache[i].shader == shader)
+			return &shader_cache[i];
+	}
+
+	return NULL;
+}
+
+static bool
+is_compiled_cached_shader(GLuint shader)
+{
+	struct cached_shader *cached = cached_shader_of(shader);
+
+	return cached != NULL && cached->compiled;
+}
+
+static void
+remove_cached_shader(struct cached_shader *cached)
+{
+	glDeleteShader(cached->shader);
+	free(cached->source);
+	*cached = shader_cache[--num_cached_shaders];
+}
+
+/**
+ * Delete a shader the current test is done with, unless it compiled and
+ * is kept in the cache for the next tests.
+ */
+static void
+release_shader(GLuint shader)
+{
+	struct cached_shader *cached = cached_shader_of(shader);
+
+	if (cached == NULL) {
+		glDeleteShader(shader);
+		return;
+	}
+
+	if (!cached->compiled) {
+		GLint ok = 0;
+
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+		cached->compiled = ok;
+	}
+
+	if (cached->compiled)
+		cached->in_use = false;
+	else
+		remove_cached_shader(cached);
+}
+
+/**
+ * Drop every cached shader, before the context they belong to goes away.
+ */
+static void
+forget_shader_cache(void)
+{
+	while (num_cached_shaders > 0)
+		remove_cached_shader(&shader_cache[0]);
+}
+
+static enum piglit_result
+compile_glsl(GLenum target)
+{
+	GLuint shader;
+	char version_string[100] = "";
+	struct cached_shader *cached = NULL;
+	char *cache_source = NULL;
+	uint64_t cache_hash = 0;
+	bool deferred;
+
 	if (spirv_in_use) {
 		printf("Cannot mix SPIRV and non-SPIRV shaders\n");
 		return PIGLIT_FAIL;
@@ -570,16 +976,46 @@ compile_glsl(GLenum target)
 	}
 
 	if (!strstr(shader_string, "#version ")) {
-		char *shader_strings[2];
-		char version_string[100];
-		GLint shader_string_sizes[2];
-
 		/* Add a #version directive based on the GLSL requirement. */
 		sprintf(version_string, "#version %d", glsl_req_version.num);
 		if (glsl_req_version.es && glsl_req_version.num != 100) {
 			strcat(version_string, " es");
 		}
 		strcat(version_string, "\n");
+	}
+
+	if (use_shader_cache && num_shader_include_paths == 0) {
+		size_t version_length = strlen(version_string);
+
+		cache_source = malloc(version_length + shader_string_size + 1);
+		if (cache_source == NULL)
+			piglit_report_result(PIGLIT_FAIL);
+		memcpy(cache_source, version_string, version_length);
+		memcpy(cache_source + version_length, shader_string,
+		       shader_string_size);
+		cache_source[version_length + shader_string_size] = '\0';
+		cache_hash = fnv1a_64_str(UINT64_C(0xcbf29ce484222325),
+					  cache_source);
+
+		cached = find_cached_shader(target, cache_hash, cache_source);
+		if (cached != NULL && cached->in_use)
+			cached = NULL;
+	}
+
+	if (cached != NULL) {
+		/* Already compiled by a previous test. */
+		free(cache_source);
+		cached->in_use = true;
+		shader = cached->shader;
+		goto add_shader;
+	}
+
+	shader = glCreateShader(target);
+
+	if (version_string[0] != '\0') {
+		char *shader_strings[2];
+		GLint shader_string_sizes[2];
+
 		shader_strings[0] = version_string;
 		shader_string_sizes[0] = strlen(version_string);
 		shader_strings[1] = shader_string;
@@ -595,31 +1031,42 @@ compile_glsl(GLenum target)
 				    &shader_string_size);
 	}
 
-	if (num_shader_include_paths) {
-		glCompileShaderIncludeARB(shader, num_shader_include_paths,
-					  (const char **) shader_include_path, NULL);
-	} else
-		glCompileShader(shader);
-
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
-
-	if (!ok) {
-		GLchar *info;
-		GLint size;
-
-		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &size);
-		info = malloc(size);
-
-		glGetShaderInfoLog(shader, size, NULL, info);
-
-		fprintf(stderr, "Failed to compile %s: %s\n",
-			target_to_short_name(target),
-			info);
+	/* With the program cache enabled, compilation is deferred to
+	 * link_and_use_shaders() so that it can be skipped entirely when a
+	 * binary of the program is found.  With parallel compilation, it is
+	 * deferred so that all the stages compile at once.
+	 */
+	deferred = (program_cache_dir != NULL &&
+		    num_shader_include_paths == 0) ||
+		   parallel_shader_compile;
+	if (deferred) {
+		shaders_deferred = true;
+	} else {
+		enum piglit_result result = compile_shader(shader, target);
+		if (result != PIGLIT_PASS) {
+			free(cache_source);
+			return result;
+		}
+	}
 
-		free(info);
-		return PIGLIT_FAIL;
+	/* Whether a deferred shader compiles is checked when the test is
+	 * done with it.
+	 */
+	if (cache_source != NULL) {
+		if (num_cached_shaders < MAX_CACHED_SHADERS) {
+			cached = &shader_cache[num_cached_shaders++];
+			cached->target = target;
+			cached->hash = cache_hash;
+			cached->source = cache_source;
+			cached->shader = shader;
+			cached->in_use = true;
+			cached->compiled = !deferred;
+		} else {
+			free(cache_source);
+		}
 	}
 
+add_shader:
 	switch (target) {
 	case GL_VERTEX_SHADER:
 		vertex_shaders[num_vertex_shaders] = shader;
@@ -681,6 +1128,9 @@ compile_and_bind_program(GLenum target, const char *start, int len)
 	return PIGLIT_PASS;
 }
 
+static void
+forget_uniform_locations(void);
+
 static bool
 program_binary_save_restore(bool script_command)
 {
@@ -772,6 +1222,7 @@ program_binary_save_restore(bool script_command)
 	if (!piglit_check_gl_error(GL_NO_ERROR))
 		piglit_report_result(PIGLIT_FAIL);
 	prog = new_prog;
+	forget_uniform_locations();
 
 	return true;
 }
@@ -908,13 +1359,24 @@ assemble_spirv(GLenum target)
 	return specialize_spirv(target, shader);
 }
 
+/* Separate programs whose link was started by process_shader() and not
+ * checked yet by link_sso().
+ */
+static struct {
+	GLenum target;
+	GLuint prog;
+} pending_sso_links[SHADER_TYPES];
+static unsigned num_pending_sso_links;
+
+/**
+ * Check the link of the separate program for the stage target, which is
+ * in prog, and use it in the pipeline.
+ */
 static enum piglit_result
 link_sso(GLenum target)
 {
 	GLint ok;
 
-	glLinkProgram(prog);
-
 	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
 	if (ok) {
 		link_ok = true;
@@ -1630,7 +2092,8 @@ leave_state(enum states state, const char *line, const char *script_name)
 		glNamedStringARB(GL_SHADER_INCLUDE_ARB, path_name_len, shader_string,
 				 line - shader_string - path_name_len, shader_string + path_name_len);
 
-		shader_include_names[num_shader_includes] = strndup(shader_string, path_name_len);
+		shader_include_names[num_shader_includes] =
+			file_arena_strndup(shader_string, path_name_len);
 		num_shader_includes++;
 		assert(num_shader_includes <= 256);
 
@@ -1658,17 +2121,15 @@ leave_state(enum states state, const char *line, const char *script_name)
 			num_shader_include_paths++;
 		} while (cursor && cursor < line);
 
-		shader_include_path = calloc(num_shader_include_paths, sizeof(char *));
+		shader_include_path = file_arena_calloc(num_shader_include_paths,
+						       sizeof(char *));
 
 		cursor = shader_string;
 		for (unsigned i = 0; i < num_shader_include_paths; i++) {
 			char *line_end = strchr(cursor, '\n');
 			unsigned path_len = line_end - cursor - 1;
-			char *path = malloc(path_len + 1);
-			path[path_len] = '\0';
 
-			memcpy(path, cursor, path_len);
-			shader_include_path[i] = path;
+			shader_include_path[i] = file_arena_strndup(cursor, path_len);
 			cursor = line_end + 1;
 		}
 
@@ -1724,56 +2185,310 @@ process_shader(GLenum target, unsigned num_shaders, GLuint *shaders)
 	glBindAttribLocation(prog, PIGLIT_ATTRIB_POS, "piglit_vertex");
 	glBindAttribLocation(prog, PIGLIT_ATTRIB_TEX, "piglit_texcoord");
 
+	/* The link is only checked once every stage started linking, so
+	 * that they can link in parallel.
+	 */
 	if (sso_in_use) {
-		return link_sso(target);
+		glLinkProgram(prog);
+		piglit_gl_invalidate_program();
+		forget_uniform_locations();
+
+		pending_sso_links[num_pending_sso_links].target = target;
+		pending_sso_links[num_pending_sso_links].prog = prog;
+		num_pending_sso_links++;
 	}
 	return PIGLIT_PASS;
 }
 
 
+static const struct {
+	GLenum target;
+	GLuint *shaders;
+	unsigned *num_shaders;
+} shader_lists[] = {
+	{ GL_VERTEX_SHADER, vertex_shaders, &num_vertex_shaders },
+	{ GL_TESS_CONTROL_SHADER, tess_ctrl_shaders, &num_tess_ctrl_shaders },
+	{ GL_TESS_EVALUATION_SHADER, tess_eval_shaders, &num_tess_eval_shaders },
+	{ GL_GEOMETRY_SHADER, geometry_shaders, &num_geometry_shaders },
+	{ GL_FRAGMENT_SHADER, fragment_shaders, &num_fragment_shaders },
+	{ GL_COMPUTE_SHADER, compute_shaders, &num_compute_shaders },
+};
+
 static enum piglit_result
-link_and_use_shaders(void)
+compile_deferred_shaders(void)
 {
-	enum piglit_result result;
-	unsigned i;
-	GLenum err;
-	GLint ok;
+	for (unsigned i = 0; i < ARRAY_SIZE(shader_lists); i++) {
+		for (unsigned j = 0; j < *shader_lists[i].num_shaders; j++) {
+			if (!is_compiled_cached_shader(shader_lists[i].shaders[j]))
+				start_compile_shader(shader_lists[i].shaders[j]);
+		}
+	}
 
-	if ((num_vertex_shaders == 0)
-	    && (num_fragment_shaders == 0)
-	    && (num_tess_ctrl_shaders == 0)
-	    && (num_tess_eval_shaders == 0)
-	    && (num_geometry_shaders == 0)
-	    && (num_compute_shaders == 0))
-		return PIGLIT_PASS;
+	for (unsigned i = 0; i < ARRAY_SIZE(shader_lists); i++) {
+		for (unsigned j = 0; j < *shader_lists[i].num_shaders; j++) {
+			if (is_compiled_cached_shader(shader_lists[i].shaders[j]))
+				continue;
 
-	if (!sso_in_use)
+			enum piglit_result result =
+				check_compile_status(shader_lists[i].shaders[j],
+						     shader_lists[i].target);
+			if (result != PIGLIT_PASS)
+				return result;
+		}
+	}
+
+	return PIGLIT_PASS;
+}
+
+/**
+ * Compute the cache key of the program made of the (not yet compiled)
+ * shaders in shader_lists.
+ *
+ * The key covers the shader sources, the program parameters set by
+ * process_shader() and the strings identifying the driver.
+ * SHADER_RUNNER_PROGRAM_CACHE_BUILD_ID can be used to add a driver build
+ * id when GL_VERSION doesn't already contain one.
+ */
+static uint64_t
+program_cache_key(void)
+{
+	uint64_t key = UINT64_C(0xcbf29ce484222325);
+	const GLint params[] = {
+		separable_program,
+		geometry_layout_input_type,
+		geometry_layout_output_type,
+		geometry_layout_vertices_out,
+	};
+
+	key = fnv1a_64_str(key, (const char *) glGetString(GL_VENDOR));
+	key = fnv1a_64_str(key, (const char *) glGetString(GL_RENDERER));
+	key = fnv1a_64_str(key, (const char *) glGetString(GL_VERSION));
+	key = fnv1a_64_str(key, getenv("SHADER_RUNNER_PROGRAM_CACHE_BUILD_ID"));
+	key = fnv1a_64(key, params, sizeof(params));
+
+	for (unsigned i = 0; i < ARRAY_SIZE(shader_lists); i++) {
+		for (unsigned j = 0; j < *shader_lists[i].num_shaders; j++) {
+			const GLuint shader = shader_lists[i].shaders[j];
+			GLint length = 0;
+			char *source;
+
+			glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &length);
+			source = calloc(1, MAX2(length, 1));
+			glGetShaderSource(shader, length, NULL, source);
+
+			key = fnv1a_64(key, &shader_lists[i].target,
+				       sizeof(shader_lists[i].target));
+			key = fnv1a_64_str(key, source);
+			free(source);
+		}
+	}
+
+	return key;
+}
+
+static void
+program_cache_path(char *path, size_t size, uint64_t key)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "%016" PRIx64 ".bin", key);
+	piglit_join_paths(path, size, 2, program_cache_dir, name);
+}
+
+/**
+ * Try to load the program identified by \p key into \p program.
+ *
+ * Returns false if there is no usable entry, in which case the program
+ * has to be compiled and linked the usual way.
+ */
+static bool
+program_cache_restore(GLuint program, uint64_t key)
+{
+	char path[4096];
+	uint32_t header[2];
+	void *binary;
+	GLint ok = 0;
+	FILE *f;
+
+	program_cache_path(path, sizeof(path), key);
+	f = fopen(path, "rb");
+	if (f == NULL)
+		return false;
+
+	/* The header holds the binary format and the binary length. */
+	if (fread(header, sizeof(header), 1, f) != 1 || header[1] == 0) {
+		fclose(f);
+		return false;
+	}
+
+	binary = malloc(header[1]);
+	if (binary == NULL || fread(binary, header[1], 1, f) != 1) {
+		free(binary);
+		fclose(f);
+		return false;
+	}
+	fclose(f);
+
+#ifdef PIGLIT_USE_OPENGL
+	glProgramBinary(program, header[0], binary, header[1]);
+#else
+	glProgramBinaryOES(program, header[0], binary, header[1]);
+#endif
+	free(binary);
+
+	/* A binary may legitimately be rejected, for instance after a
+	 * driver update that didn't change any of the strings in the key.
+	 */
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	piglit_reset_gl_error();
+	return ok;
+}
+
+static void
+program_cache_store(GLuint program, uint64_t key)
+{
+	char path[4096], tmp_path[4096 + 32];
+	uint32_t header[2];
+	GLint binary_length = 0;
+	GLenum binary_format;
+	void *binary;
+	FILE *f;
+
+#ifdef PIGLIT_USE_OPENGL
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+#else
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &binary_length);
+#endif
+	if (binary_length <= 0) {
+		piglit_reset_gl_error();
+		return;
+	}
+
+	binary = malloc(binary_length);
+	if (binary == NULL)
+		return;
+
+#ifdef PIGLIT_USE_OPENGL
+	glGetProgramBinary(program, binary_length, &binary_length,
+			   &binary_format, binary);
+#else
+	glGetProgramBinaryOES(program, binary_length, &binary_length,
+			      &binary_format, binary);
+#endif
+	if (!piglit_check_gl_error(GL_NO_ERROR)) {
+		free(binary);
+		return;
+	}
+
+	/* Write to a temporary file and rename it, so that concurrent
+	 * shader_runner processes never see a partial entry.
+	 */
+	program_cache_path(path, sizeof(path), key);
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%" PRIu64 ".tmp", path,
+		 (uint64_t) piglit_time_get_nano());
+
+	header[0] = binary_format;
+	header[1] = binary_length;
+
+	f = fopen(tmp_path, "wb");
+	if (f != NULL) {
+		bool written = fwrite(header, sizeof(header), 1, f) == 1 &&
+			fwrite(binary, binary_length, 1, f) == 1;
+
+		if (fclose(f) == 0 && written)
+			written = rename(tmp_path, path) == 0;
+		if (!written)
+			remove(tmp_path);
+	}
+
+	free(binary);
+}
+
+static enum piglit_result
+link_and_use_shaders(void)
+{
+	enum piglit_result result;
+	unsigned i;
+	GLenum err;
+	GLint ok;
+	uint64_t cache_key = 0;
+	bool use_cache = false;
+	bool restored = false;
+
+	if ((num_vertex_shaders == 0)
+	    && (num_fragment_shaders == 0)
+	    && (num_tess_ctrl_shaders == 0)
+	    && (num_tess_eval_shaders == 0)
+	    && (num_geometry_shaders == 0)
+	    && (num_compute_shaders == 0))
+		return PIGLIT_PASS;
+
+	if (!sso_in_use)
 		prog = glCreateProgram();
 
-	result = process_shader(GL_VERTEX_SHADER, num_vertex_shaders, vertex_shaders);
-	if (result != PIGLIT_PASS)
-		goto cleanup;
-	result = process_shader(GL_TESS_CONTROL_SHADER, num_tess_ctrl_shaders, tess_ctrl_shaders);
-	if (result != PIGLIT_PASS)
-		goto cleanup;
-	result = process_shader(GL_TESS_EVALUATION_SHADER, num_tess_eval_shaders, tess_eval_shaders);
-	if (result != PIGLIT_PASS)
-		goto cleanup;
-	result = process_shader(GL_GEOMETRY_SHADER, num_geometry_shaders, geometry_shaders);
-	if (result != PIGLIT_PASS)
-		goto cleanup;
-	result = process_shader(GL_FRAGMENT_SHADER, num_fragment_shaders, fragment_shaders);
-	if (result != PIGLIT_PASS)
-		goto cleanup;
-	result = process_shader(GL_COMPUTE_SHADER, num_compute_shaders, compute_shaders);
-	if (result != PIGLIT_PASS)
-		goto cleanup;
+	if (shaders_deferred) {
+		shaders_deferred = false;
 
-	if (!sso_in_use) {
+		/* Separate shader objects are linked one stage at a
+		 * time by process_shader(), so they aren't cached.
+		 */
+		use_cache = !sso_in_use && program_cache_dir != NULL &&
+			    num_shader_include_paths == 0;
+		if (use_cache) {
+			cache_key = program_cache_key();
+			if (separable_program)
+				glProgramParameteri(prog, GL_PROGRAM_SEPARABLE, GL_TRUE);
+			restored = program_cache_restore(prog, cache_key);
+		}
+
+		if (!restored) {
+			result = compile_deferred_shaders();
+			if (result != PIGLIT_PASS)
+				goto cleanup;
+		}
+	}
+
+	if (!restored) {
+		result = process_shader(GL_VERTEX_SHADER, num_vertex_shaders, vertex_shaders);
+		if (result != PIGLIT_PASS)
+			goto cleanup;
+		result = process_shader(GL_TESS_CONTROL_SHADER, num_tess_ctrl_shaders, tess_ctrl_shaders);
+		if (result != PIGLIT_PASS)
+			goto cleanup;
+		result = process_shader(GL_TESS_EVALUATION_SHADER, num_tess_eval_shaders, tess_eval_shaders);
+		if (result != PIGLIT_PASS)
+			goto cleanup;
+		result = process_shader(GL_GEOMETRY_SHADER, num_geometry_shaders, geometry_shaders);
+		if (result != PIGLIT_PASS)
+			goto cleanup;
+		result = process_shader(GL_FRAGMENT_SHADER, num_fragment_shaders, fragment_shaders);
+		if (result != PIGLIT_PASS)
+			goto cleanup;
+		result = process_shader(GL_COMPUTE_SHADER, num_compute_shaders, compute_shaders);
+		if (result != PIGLIT_PASS)
+			goto cleanup;
+
+		for (i = 0; i < num_pending_sso_links; i++) {
+			prog = pending_sso_links[i].prog;
+			result = link_sso(pending_sso_links[i].target);
+			if (result != PIGLIT_PASS)
+				break;
+		}
+		num_pending_sso_links = 0;
+		if (result != PIGLIT_PASS)
+			goto cleanup;
+	}
+
+	if (!sso_in_use && !restored) {
 		if (separable_program)
 			glProgramParameteri(prog, GL_PROGRAM_SEPARABLE, GL_TRUE);
+		if (use_cache)
+			glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+					    GL_TRUE);
 
 		glLinkProgram(prog);
+		piglit_gl_invalidate_program();
+		forget_uniform_locations();
 	}
 
 	if (!sso_in_use) {
@@ -1782,6 +2497,8 @@ link_and_use_shaders(void)
 		glGetProgramiv(prog, GL_LINK_STATUS, &ok);
 		if (ok) {
 			link_ok = true;
+			if (use_cache && !restored)
+				program_cache_store(prog, cache_key);
 		} else {
 			GLint size;
 
@@ -1813,32 +2530,32 @@ link_and_use_shaders(void)
 
 cleanup:
 	for (i = 0; i < num_vertex_shaders; i++) {
-		glDeleteShader(vertex_shaders[i]);
+		release_shader(vertex_shaders[i]);
 	}
 	num_vertex_shaders = 0;
 
 	for (i = 0; i < num_tess_ctrl_shaders; i++) {
-		glDeleteShader(tess_ctrl_shaders[i]);
+		release_shader(tess_ctrl_shaders[i]);
 	}
 	num_tess_ctrl_shaders = 0;
 
 	for (i = 0; i < num_tess_eval_shaders; i++) {
-		glDeleteShader(tess_eval_shaders[i]);
+		release_shader(tess_eval_shaders[i]);
 	}
 	num_tess_eval_shaders = 0;
 
 	for (i = 0; i < num_geometry_shaders; i++) {
-		glDeleteShader(geometry_shaders[i]);
+		release_shader(geometry_shaders[i]);
 	}
 	num_geometry_shaders = 0;
 
 	for (i = 0; i < num_fragment_shaders; i++) {
-		glDeleteShader(fragment_shaders[i]);
+		release_shader(fragment_shaders[i]);
 	}
 	num_fragment_shaders = 0;
 
 	for (i = 0; i < num_compute_shaders; i++) {
-		glDeleteShader(compute_shaders[i]);
+		release_shader(compute_shaders[i]);
 	}
 	num_compute_shaders = 0;
 
@@ -1891,16 +2608,22 @@ process_specialization(enum states state, const char *line)
 	}
 
 	if (list->n_entries >= list->buffer_size) {
+		size_t old_size = list->buffer_size;
+
 		if (list->buffer_size == 0)
 			list->buffer_size = 1;
 		else
 			list->buffer_size *= 2;
-		list->indices = realloc(list->indices,
-					(sizeof list->indices[0]) *
-					list->buffer_size);
-		list->values = realloc(list->values,
-				       (sizeof list->values[0]) *
-				       list->buffer_size);
+		list->indices = file_arena_grow(list->indices,
+						(sizeof list->indices[0]) *
+						old_size,
+						(sizeof list->indices[0]) *
+						list->buffer_size);
+		list->values = file_arena_grow(list->values,
+					       (sizeof list->values[0]) *
+					       old_size,
+					       (sizeof list->values[0]) *
+					       list->buffer_size);
 	}
 
 	if (parse_uints(next, list->indices + list->n_entries, 1, &next) != 1)
@@ -1932,6 +2655,193 @@ process_specialization(enum states state, const char *line)
 	return PIGLIT_FAIL;
 }
 
+/*
+ * Shader test bundles
+ *
+ * A .shader_bundle file holds the shader tests of a directory of generated
+ * tests, written by tests/bundle_shader_tests.py.  A test in a bundle is
+ * named by the path of the bundle, '#' and its index, and its text is read
+ * from the bundle, which is mapped once per process.  The file starts with
+ * struct bundle_header in the byte order of the machine that wrote it; the
+ * table of struct bundle_entry it points to gives the text and the name of
+ * each test, each terminated by '\0'.  The requirements are only read by
+ * the Python framework.
+ */
+#define BUNDLE_MAGIC       "PSHBNDL"
+#define BUNDLE_VERSION     1
+#define BUNDLE_BYTE_ORDER  0x01020304
+#define BUNDLE_SUFFIX      ".shader_bundle"
+
+struct bundle_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t num_entries;
+	uint64_t entries_offset;
+	uint64_t requirements_offset;
+	uint64_t requirements_size;
+};
+
+struct bundle_entry {
+	uint64_t text_offset;
+	uint64_t text_size;
+	uint64_t name_offset;
+	uint64_t name_size;
+};
+
+static char *bundle_path = NULL;
+static char *bundle_data = NULL;
+static size_t bundle_size = 0;
+static bool bundle_mapped = false;
+
+static void
+unmap_bundle(void)
+{
+	if (bundle_data != NULL) {
+#ifdef HAVE_SYS_MMAN_H
+		if (bundle_mapped)
+			munmap(bundle_data, bundle_size);
+		else
+#endif
+			free(bundle_data);
+	}
+
+	free(bundle_path);
+	bundle_path = NULL;
+	bundle_data = NULL;
+	bundle_mapped = false;
+}
+
+static bool
+map_bundle(const char *path)
+{
+	FILE *file;
+
+	if (bundle_path != NULL && !strcmp(bundle_path, path))
+		return true;
+	unmap_bundle();
+
+	file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+	fseek(file, 0, SEEK_END);
+	bundle_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+#ifdef HAVE_SYS_MMAN_H
+	if (bundle_size > 0) {
+		bundle_data = mmap(NULL, bundle_size, PROT_READ, MAP_PRIVATE,
+				   fileno(file), 0);
+		if (bundle_data == MAP_FAILED)
+			bundle_data = NULL;
+		else
+			bundle_mapped = true;
+	}
+#endif
+	if (bundle_data == NULL) {
+		bundle_data = malloc(bundle_size);
+		if (fread(bundle_data, 1, bundle_size, file) != bundle_size) {
+			free(bundle_data);
+			bundle_data = NULL;
+		}
+	}
+	fclose(file);
+
+	if (bundle_data == NULL)
+		return false;
+	bundle_path = strdup(path);
+	return true;
+}
+
+/* Return the string of size bytes at offset in the bundle, or NULL if it
+ * isn't in the bundle or isn't terminated.
+ */
+static const char *
+bundle_string(uint64_t offset, uint64_t size)
+{
+	if (offset > bundle_size || size == 0 || size > bundle_size - offset ||
+	    bundle_data[offset + size - 1] != '\0')
+		return NULL;
+	return bundle_data + offset;
+}
+
+/**
+ * Find the test named by script_name in its bundle.
+ *
+ * Returns false if script_name isn't a test of a bundle, and the text, its
+ * length and the name of the test otherwise.  An invalid bundle fails the
+ * test.
+ */
+static bool
+find_bundle_entry(const char *script_name, const char **text,
+		  size_t *text_length, const char **name)
+{
+	const char *suffix = strstr(script_name, BUNDLE_SUFFIX "#");
+	struct bundle_header header;
+	struct bundle_entry entry;
+	unsigned long long index;
+	size_t path_length;
+	char *path;
+	bool mapped;
+
+	if (suffix == NULL)
+		return false;
+
+	path_length = suffix - script_name + strlen(BUNDLE_SUFFIX);
+	path = malloc(path_length + 1);
+	memcpy(path, script_name, path_length);
+	path[path_length] = '\0';
+	index = strtoull(suffix + strlen(BUNDLE_SUFFIX "#"), NULL, 10);
+	mapped = map_bundle(path);
+	free(path);
+	if (!mapped) {
+		printf("could not read the bundle of \"%s\"\n", script_name);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	if (bundle_size < sizeof(header))
+		goto invalid;
+	memcpy(&header, bundle_data, sizeof(header));
+	if (memcmp(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) ||
+	    header.version != BUNDLE_VERSION ||
+	    header.byte_order != BUNDLE_BYTE_ORDER ||
+	    index >= header.num_entries ||
+	    header.entries_offset > bundle_size ||
+	    (bundle_size - header.entries_offset) / sizeof(entry) <= index)
+		goto invalid;
+
+	memcpy(&entry, bundle_data + header.entries_offset +
+	       index * sizeof(entry), sizeof(entry));
+	*text = bundle_string(entry.text_offset, entry.text_size);
+	*name = bundle_string(entry.name_offset, entry.name_size);
+	if (*text == NULL || *name == NULL)
+		goto invalid;
+	*text_length = entry.text_size - 1;
+	return true;
+
+invalid:
+	printf("\"%s\" is not in a valid shader test bundle\n", script_name);
+	piglit_report_result(PIGLIT_FAIL);
+}
+
+/* Load the text of a test, from its file or its bundle. */
+static char *
+load_script(const char *script_name, unsigned *size)
+{
+	const char *entry_text, *entry_name;
+	size_t entry_length;
+	char *text;
+
+	if (!find_bundle_entry(script_name, &entry_text, &entry_length,
+			       &entry_name))
+		return piglit_load_text_file(script_name, size);
+
+	text = malloc(entry_length + 1);
+	memcpy(text, entry_text, entry_length + 1);
+	*size = entry_length;
+	return text;
+}
+
 static char *
 spirv_replacement_script(const char *script_name)
 {
@@ -1964,13 +2874,17 @@ process_elements(enum states state, const char *line)
 			return PIGLIT_PASS;
 
 		if (num_elements >= elements_buffer_size) {
+			size_t old_size = elements_buffer_size;
+
 			if (elements_buffer_size == 0)
 				elements_buffer_size = 1;
 			else
 				elements_buffer_size *= 2;
-			elements_buffer = realloc(elements_buffer,
-						  elements_buffer_size *
-						  sizeof *elements_buffer);
+			elements_buffer = file_arena_grow(elements_buffer,
+							  old_size *
+							  sizeof *elements_buffer,
+							  elements_buffer_size *
+							  sizeof *elements_buffer);
 		}
 
 		unsigned val;
@@ -1991,7 +2905,7 @@ process_test_script(const char *script_name)
 {
 	unsigned text_size;
 	unsigned line_num;
-	text = piglit_load_text_file(script_name, &text_size);
+	text = load_script(script_name, &text_size);
 	enum states state = none;
 	const char *line = text;
 	enum piglit_result result;
@@ -2242,7 +3156,7 @@ parse_required_config(struct requirement_parse_results *results,
 		      bool force_spirv)
 {
 	unsigned text_size;
-	char *text = piglit_load_text_file(script_name, &text_size);
+	char *text = load_script(script_name, &text_size);
 	const char *line = text;
 	bool in_requirement_section = false;
 
@@ -2469,6 +3383,96 @@ check_texture_handle_support(void)
 		piglit_report_result(PIGLIT_SKIP);
 }
 
+/**
+ * Where a uniform named by the script lives in a program, looked up once
+ * per program and name rather than for every "uniform" command.
+ */
+struct uniform_location {
+	GLuint prog;
+	char *name;
+
+	/** Whether the UBO lookup was done, and what it found. */
+	bool ubo_known;
+	bool in_ubo;
+	GLuint uniform_index;
+	/** Not including the array index of the block. */
+	GLint block_index;
+	GLint offset;
+
+	/** Whether the glGetUniformLocation() lookup was done. */
+	bool loc_known;
+	GLint loc;
+};
+
+/** Open addressing hash table of uniform locations. */
+static struct uniform_location *uniform_locations;
+/** Size of uniform_locations, a power of two, or 0. */
+static unsigned uniform_locations_size;
+static unsigned num_uniform_locations;
+
+/**
+ * Forget every uniform location, after a program was linked or deleted.
+ * The table is left in the file arena.
+ */
+static void
+forget_uniform_locations(void)
+{
+	uniform_locations = NULL;
+	uniform_locations_size = 0;
+	num_uniform_locations = 0;
+}
+
+static struct uniform_location *
+uniform_location_slot(GLuint prog, const char *name)
+{
+	unsigned mask = uniform_locations_size - 1;
+	uint64_t hash = fnv1a_64(UINT64_C(0xcbf29ce484222325),
+				 &prog, sizeof(prog));
+	unsigned i = fnv1a_64_str(hash, name) & mask;
+
+	while (uniform_locations[i].name &&
+	       (uniform_locations[i].prog != prog ||
+		strcmp(uniform_locations[i].name, name) != 0))
+		i = (i + 1) & mask;
+
+	return &uniform_locations[i];
+}
+
+/**
+ * Find the location of the uniform called name in prog, adding an entry
+ * with nothing known yet if there is none.
+ */
+static struct uniform_location *
+find_uniform_location(GLuint prog, const char *name)
+{
+	struct uniform_location *entry;
+
+	/* Keep the table at most half full. */
+	if (2 * (num_uniform_locations + 1) > uniform_locations_size) {
+		struct uniform_location *old = uniform_locations;
+		unsigned old_size = uniform_locations_size;
+
+		uniform_locations_size = MAX2(2 * old_size, 64);
+		uniform_locations = file_arena_calloc(uniform_locations_size,
+						      sizeof(*uniform_locations));
+
+		for (unsigned i = 0; i < old_size; i++) {
+			if (old[i].name)
+				*uniform_location_slot(old[i].prog,
+						       old[i].name) = old[i];
+		}
+	}
+
+	entry = uniform_location_slot(prog, name);
+	if (!entry->name) {
+		entry->prog = prog;
+		entry->name = file_arena_strndup(name, strlen(name));
+		num_uniform_locations++;
+	}
+
+	return entry;
+}
+
 static bool
 get_indexes_and_offset_from_ubo(char *name, struct block_info block_data,
 				GLuint *uniform_index_out,
@@ -2491,7 +3495,9 @@ set_ubo_uniform(char *name, const char *type,
 	GLuint uniform_index;
 	GLint block_index;
 	GLint offset;
+	struct uniform_block_shadow *shadow;
 	char *data;
+	size_t size = 0;
 	float f[16];
 	double d[16];
 	int ints[16];
@@ -2504,53 +3510,63 @@ set_ubo_uniform(char *name, const char *type,
 		return false;
 	}
 
-	glBindBuffer(GL_UNIFORM_BUFFER,
-		     uniform_block_bos[block_index]);
-	data = glMapBuffer(GL_UNIFORM_BUFFER, GL_WRITE_ONLY);
-	data += offset;
+	shadow = &uniform_block_shadows[block_index];
+	data = shadow->data + offset;
 
 	if (parse_str(type, "float", NULL)) {
 		parse_floats(line, f, 1, NULL);
-		memcpy(data, f, sizeof(float));
+		size = sizeof(float);
+		memcpy(data, f, size);
 	} else if (parse_str(type, "int64_t", NULL)) {
 		parse_int64s(line, int64s, 1, NULL);
-		memcpy(data, int64s, sizeof(int64_t));
+		size = sizeof(int64_t);
+		memcpy(data, int64s, size);
 	} else if (parse_str(type, "uint64_t", NULL)) {
 		parse_uint64s(line, uint64s, 1, NULL);
-		memcpy(data, uint64s, sizeof(uint64_t));
+		size = sizeof(uint64_t);
+		memcpy(data, uint64s, size);
 	} else if (parse_str(type, "int", NULL)) {
 		parse_ints(line, ints, 1, NULL);
-		memcpy(data, ints, sizeof(int));
+		size = sizeof(int);
+		memcpy(data, ints, size);
 	} else if (parse_str(type, "uint", NULL)) {
 		parse_uints(line, uints, 1, NULL);
-		memcpy(data, uints, sizeof(int));
+		size = sizeof(int);
+		memcpy(data, uints, size);
 	} else if (parse_str(type, "double", NULL)) {
 		parse_doubles(line, d, 1, NULL);
-		memcpy(data, d, sizeof(double));
+		size = sizeof(double);
+		memcpy(data, d, size);
 	} else if (parse_str(type, "vec", NULL)) {
 		int elements = type[3] - '0';
 		parse_floats(line, f, elements, NULL);
-		memcpy(data, f, elements * sizeof(float));
+		size = elements * sizeof(float);
+		memcpy(data, f, size);
 	} else if (parse_str(type, "ivec", NULL)) {
 		int elements = type[4] - '0';
 		parse_ints(line, ints, elements, NULL);
-		memcpy(data, ints, elements * sizeof(int));
+		size = elements * sizeof(int);
+		memcpy(data, ints, size);
 	} else if (parse_str(type, "uvec", NULL)) {
 		int elements = type[4] - '0';
 		parse_uints(line, uints, elements, NULL);
-		memcpy(data, uints, elements * sizeof(unsigned));
+		size = elements * sizeof(unsigned);
+		memcpy(data, uints, size);
 	} else if (parse_str(type, "i64vec", NULL)) {
 		int elements = type[6] - '0';
 		parse_int64s(line, int64s, elements, NULL);
-		memcpy(data, int64s, elements * sizeof(int64_t));
+		size = elements * sizeof(int64_t);
+		memcpy(data, int64s, size);
 	} else if (parse_str(type, "u64vec", NULL)) {
 		int elements = type[6] - '0';
 		parse_uint64s(line, uint64s, elements, NULL);
-		memcpy(data, uint64s, elements * sizeof(uint64_t));
+		size = elements * sizeof(uint64_t);
+		memcpy(data, uint64s, size);
 	} else if (parse_str(type, "dvec", NULL)) {
 		int elements = type[4] - '0';
 		parse_doubles(line, d, elements, NULL);
-		memcpy(data, d, elements * sizeof(double));
+		size = elements * sizeof(double);
+		memcpy(data, d, size);
 	} else if (parse_str(type, "mat", NULL)) {
 		GLint matrix_stride, row_major;
 		int cols = type[3] - '0';
@@ -2592,6 +3608,12 @@ set_ubo_uniform(char *name, const char *type,
 				}
 			}
 		}
+
+		if (row_major)
+			size = matrix_stride * (rows - 1) + cols;
+		else
+			size = matrix_stride * (cols - 1) + rows;
+		size *= sizeof(float);
 	} else if (parse_str(type, "dmat", NULL)) {
 		GLint matrix_stride, row_major;
 		int cols = type[4] - '0';
@@ -2633,102 +3655,163 @@ set_ubo_uniform(char *name, const char *type,
 				}
 			}
 		}
+
+		if (row_major)
+			size = matrix_stride * (rows - 1) + cols;
+		else
+			size = matrix_stride * (cols - 1) + rows;
+		size *= sizeof(double);
 	} else if (parse_str(type, "handle", NULL)) {
 		check_unsigned_support();
 		check_texture_handle_support();
 		parse_uints(line, uints, 1, NULL);
 		GLuint64 handle = get_resident_handle(uints[0])->handle;
-		memcpy(data, &handle, sizeof(uint64_t));
+		size = sizeof(uint64_t);
+		memcpy(data, &handle, size);
 	} else {
 		printf("unknown uniform type \"%s\" for \"%s\"\n", type, name);
 		piglit_report_result(PIGLIT_FAIL);
 	}
 
-	glUnmapBuffer(GL_UNIFORM_BUFFER);
+	if (shadow->dirty_begin >= shadow->dirty_end) {
+		shadow->dirty_begin = offset;
+		shadow->dirty_end = offset + (GLint) size;
+	} else {
+		shadow->dirty_begin = MIN2(shadow->dirty_begin, offset);
+		shadow->dirty_end = MAX2(shadow->dirty_end,
+					 offset + (GLint) size);
+	}
+	uniform_blocks_dirty = true;
 
 	return true;
 }
 
 /*
- * Get the uniform_index, block_index and offset of a given
- * uniform. By default it gets those values using the uniform name. If
- * force_no_names mode is active, it uses the current values stored at
- * @block_data. On the latter, uniform index is not filled up.
+ * Query the uniform_index, block_index and offset of the uniform called
+ * uniform_name in the program.  The block index doesn't include the array
+ * index of the block.  Returns false if the uniform is not in a block.
  */
 static bool
-get_indexes_and_offset_from_ubo(char *name, struct block_info block_data,
-				GLuint *uniform_index_out,
-				GLint *block_index_out,
-				GLint *offset_out)
+query_ubo_uniform(const char *uniform_name, GLuint *uniform_index_out,
+		  GLint *block_index_out, GLint *offset_out)
 {
+	char name[512];
+	const char *names[] = { name };
 	GLuint uniform_index = 0;
 	GLint block_index;
 	GLint offset;
-	int name_len = strlen(name);
+	int name_len;
 	GLint array_index = 0;
 
-	if (!num_uniform_blocks)
-		return false;
+	/* The index is stripped from a copy, the caller may still need to
+	 * look up the whole name outside of the blocks.
+	 */
+	snprintf(name, sizeof(name), "%s", uniform_name);
+	name_len = strlen(name);
 
-	if (!force_no_names) {
-		/* if the uniform is an array, strip the index, as GL
-		   prevents non-zero indexes from matching a name */
-		if (name[name_len - 1] == ']') {
-			int i;
+	/* if the uniform is an array, strip the index, as GL
+	   prevents non-zero indexes from matching a name */
+	if (name[name_len - 1] == ']') {
+		int i;
 
-			for (i = name_len - 1; (i > 0) && isdigit(name[i-1]); --i)
-				/* empty */;
+		for (i = name_len - 1; (i > 0) && isdigit(name[i-1]); --i)
+			/* empty */;
 
-			array_index = strtol(&name[i], NULL, 0);
+		array_index = strtol(&name[i], NULL, 0);
 
-			if (i) {
-				i--;
-				if (name[i] != '[') {
-					printf("cannot parse uniform \"%s\"\n", name);
-					piglit_report_result(PIGLIT_FAIL);
-				}
-				name[i] = 0;
+		if (i) {
+			i--;
+			if (name[i] != '[') {
+				printf("cannot parse uniform \"%s\"\n", name);
+				piglit_report_result(PIGLIT_FAIL);
 			}
-
+			name[i] = 0;
 		}
 
-		glGetUniformIndices(prog, 1, (const char **)&name, &uniform_index);
-		if (uniform_index == GL_INVALID_INDEX) {
-			printf("cannot get index of uniform \"%s\"\n", name);
-			piglit_report_result(PIGLIT_FAIL);
-		}
+	}
 
-		glGetActiveUniformsiv(prog, 1, &uniform_index,
-				      GL_UNIFORM_BLOCK_INDEX, &block_index);
+	glGetUniformIndices(prog, 1, names, &uniform_index);
+	if (uniform_index == GL_INVALID_INDEX) {
+		printf("cannot get index of uniform \"%s\"\n", name);
+		piglit_report_result(PIGLIT_FAIL);
+	}
 
-		if (block_index == -1)
-			return false;
+	glGetActiveUniformsiv(prog, 1, &uniform_index,
+			      GL_UNIFORM_BLOCK_INDEX, &block_index);
 
-		GLint array_size;
-		glGetActiveUniformsiv(prog, 1, &uniform_index, GL_UNIFORM_SIZE, &array_size);
+	if (block_index == -1)
+		return false;
 
-		if (array_index > array_size) {
-			printf("attempt to access beyond uniform \"%s\" array size (%d)\n",
-			       name, array_size);
-			return false;
-		}
+	GLint array_size;
+	glGetActiveUniformsiv(prog, 1, &uniform_index, GL_UNIFORM_SIZE, &array_size);
 
-		/* if the uniform block is an array, then GetActiveUniformsiv with
-		 * UNIFORM_BLOCK_INDEX will have given us the index of the first
-		 * element in the array.
-		 */
-		block_index += block_data.array_index;
+	if (array_index > array_size) {
+		printf("attempt to access beyond uniform \"%s\" array size (%d)\n",
+		       name, array_size);
+		return false;
+	}
+
+	glGetActiveUniformsiv(prog, 1, &uniform_index,
+			      GL_UNIFORM_OFFSET, &offset);
+
+	if (uniform_name[name_len - 1] == ']') {
+		GLint stride;
 
 		glGetActiveUniformsiv(prog, 1, &uniform_index,
-				      GL_UNIFORM_OFFSET, &offset);
+				      GL_UNIFORM_ARRAY_STRIDE, &stride);
+		offset += stride * array_index;
+	}
 
-		if (name[name_len - 1] == ']') {
-			GLint stride;
+	*uniform_index_out = uniform_index;
+	*block_index_out = block_index;
+	*offset_out = offset;
 
-			glGetActiveUniformsiv(prog, 1, &uniform_index,
-					      GL_UNIFORM_ARRAY_STRIDE, &stride);
-			offset += stride * array_index;
+	return true;
+}
+
+/*
+ * Get the uniform_index, block_index and offset of a given
+ * uniform. By default it gets those values using the uniform name,
+ * querying them once per program. If force_no_names mode is active,
+ * it uses the current values stored at @block_data. On the latter,
+ * uniform index is not filled up.
+ */
+static bool
+get_indexes_and_offset_from_ubo(char *name, struct block_info block_data,
+				GLuint *uniform_index_out,
+				GLint *block_index_out,
+				GLint *offset_out)
+{
+	GLuint uniform_index = 0;
+	GLint block_index;
+	GLint offset;
+
+	if (!num_uniform_blocks)
+		return false;
+
+	if (!force_no_names) {
+		struct uniform_location *cached =
+			find_uniform_location(prog, name);
+
+		if (!cached->ubo_known) {
+			cached->in_ubo =
+				query_ubo_uniform(name, &cached->uniform_index,
+						  &cached->block_index,
+						  &cached->offset);
+			cached->ubo_known = true;
 		}
+
+		if (!cached->in_ubo)
+			return false;
+
+		uniform_index = cached->uniform_index;
+		offset = cached->offset;
+
+		/* if the uniform block is an array, then GetActiveUniformsiv with
+		 * UNIFORM_BLOCK_INDEX will have given us the index of the first
+		 * element in the array.
+		 */
+		block_index = cached->block_index + block_data.array_index;
 	} else {
 		if (block_data.binding < 0) {
 			printf("if you force to use a explicit ubo binding, you "
@@ -2784,12 +3867,18 @@ set_uniform(const char *line, struct block_info block_data)
 		loc = strtol(name, NULL, 0);
 	} else {
 		GLuint prog;
+		struct uniform_location *cached;
 
 		if (set_ubo_uniform(name, type, line, block_data))
 			return;
 
 		glGetIntegerv(GL_CURRENT_PROGRAM, (GLint *) &prog);
-		loc = glGetUniformLocation(prog, name);
+		cached = find_uniform_location(prog, name);
+		if (!cached->loc_known) {
+			cached->loc = glGetUniformLocation(prog, name);
+			cached->loc_known = true;
+		}
+		loc = cached->loc;
 		if (loc < 0) {
 			if (ignore_missing_uniforms)
 				return;
@@ -3130,10 +4219,8 @@ static void
 free_subroutine_uniforms(void)
 {
 	int sidx;
-	for (sidx = 0; sidx < 4; sidx++) {
-		free(subuniform_locations[sidx]);
+	for (sidx = 0; sidx < 4; sidx++)
 		subuniform_locations[sidx] = NULL;
-	}
 }
 
 static void
@@ -3189,9 +4276,9 @@ set_subroutine_uniform(const char *line)
 			piglit_report_result(PIGLIT_FAIL);
 		}
 
-		subuniform_locations[sidx] = calloc(num_subuniform_locations[sidx], sizeof(GLuint));
-		if (!subuniform_locations[sidx])
-			piglit_report_result(PIGLIT_FAIL);
+		subuniform_locations[sidx] =
+			file_arena_calloc(num_subuniform_locations[sidx],
+					  sizeof(GLuint));
 	}
 
 	loc = glGetSubroutineUniformLocation(prog, ptype, name);
@@ -4686,6 +5773,110 @@ draw_instanced_rect(int primcount, float x, float y, float w, float h)
 	glDisableClientState(GL_VERTEX_ARRAY);
 }
 
+/* The tiles drawn by the last "draw tiles", which "probe tiles" checks. */
+static struct {
+	int w, h;
+	unsigned count;
+	unsigned per_row;
+} tiles;
+
+static void
+tile_position(unsigned tile, int *x, int *y)
+{
+	*x = (tile % tiles.per_row) * tiles.w;
+	*y = (tile / tiles.per_row) * tiles.h;
+}
+
+/**
+ * Handle "draw tiles W H N": draw N tiles of W x H pixels with a single
+ * instanced draw.  The tiles are laid out in rows from the bottom left
+ * corner of the window, as many per row as fit.
+ *
+ * All the instances are drawn over the first tile; the vertex shader moves
+ * each one to its place with the piglit_tile_size (the size of a tile in
+ * clip coordinates) and piglit_tiles_per_row uniforms set here:
+ *
+ *   ivec2 tile = ivec2(gl_InstanceID % piglit_tiles_per_row,
+ *                      gl_InstanceID / piglit_tiles_per_row);
+ *   gl_Position = piglit_vertex + vec4(vec2(tile) * piglit_tile_size,
+ *                                      0.0, 0.0);
+ *
+ * The values each tile tests are usually read from arrays in a uniform
+ * block indexed by gl_InstanceID, and set with "uniform" commands on the
+ * array elements.
+ */
+static enum piglit_result
+draw_tiles(const char *rest)
+{
+	int x, y;
+	GLint loc;
+
+	REQUIRE(sscanf(rest, "%d %d %u", &tiles.w, &tiles.h,
+		       &tiles.count) == 3 &&
+		tiles.w > 0 && tiles.h > 0 && tiles.count > 0,
+		"Invalid draw tiles command at: %s\n", rest);
+
+	tiles.per_row = piglit_width / tiles.w;
+	if (tiles.per_row == 0) {
+		printf("tiles of width %d don't fit in the window\n", tiles.w);
+		return PIGLIT_FAIL;
+	}
+	tile_position(tiles.count - 1, &x, &y);
+	if (y + tiles.h > piglit_height) {
+		printf("%u tiles of %dx%d don't fit in the window\n",
+		       tiles.count, tiles.w, tiles.h);
+		return PIGLIT_FAIL;
+	}
+
+	loc = glGetUniformLocation(prog, "piglit_tile_size");
+	if (loc != -1)
+		glUniform2f(loc, 2.0 * tiles.w / piglit_width,
+			    2.0 * tiles.h / piglit_height);
+	loc = glGetUniformLocation(prog, "piglit_tiles_per_row");
+	if (loc != -1)
+		glUniform1i(loc, tiles.per_row);
+
+	piglit_draw_rect_custom(-1.0, -1.0,
+				2.0 * tiles.w / piglit_width,
+				2.0 * tiles.h / piglit_height,
+				false, tiles.count);
+	return PIGLIT_PASS;
+}
+
+/**
+ * Handle "probe tiles rgba R G B A": check that every tile of the last
+ * "draw tiles" is the color, with one read back of the framebuffer.
+ */
+static enum piglit_result
+probe_tiles(const char *rest)
+{
+	enum piglit_result result = PIGLIT_PASS;
+	float expected[4];
+	unsigned i;
+
+	REQUIRE(parse_floats(rest, expected, 4, NULL) == 4,
+		"Invalid probe tiles command at: %s\n", rest);
+
+	if (tiles.count == 0) {
+		printf("probe tiles without draw tiles\n");
+		return PIGLIT_FAIL;
+	}
+
+	piglit_probe_batch_begin(0, 0, read_width, read_height);
+	for (i = 0; i < tiles.count; i++) {
+		int x, y;
+
+		tile_position(i, &x, &y);
+		if (!piglit_probe_rect_rgba(x, y, tiles.w, tiles.h,
+					    expected)) {
+			printf("  in tile %u\n", i);
+			result = PIGLIT_FAIL;
+		}
+	}
+	piglit_probe_batch_end();
+
+	return result;
+}
 
 static GLenum
 decode_drawing_mode(const char *mode_str)
@@ -4882,12 +6073,15 @@ setup_ubos(void)
 	if (num_uniform_blocks == 0)
 		return;
 
-	uniform_block_bos = calloc(num_uniform_blocks, sizeof(GLuint));
+	uniform_block_bos = file_arena_calloc(num_uniform_blocks,
+					      sizeof(GLuint));
 	glGenBuffers(num_uniform_blocks, uniform_block_bos);
+	uniform_block_shadows = file_arena_calloc(num_uniform_blocks,
+						  sizeof(*uniform_block_shadows));
 
 	int max_ubos;
 	glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &max_ubos);
-	uniform_block_indexes = calloc(max_ubos, sizeof(int));
+	uniform_block_indexes = file_arena_calloc(max_ubos, sizeof(int));
 
 	for (i = 0; i < num_uniform_blocks; i++) {
 		GLint size;
@@ -4896,8 +6090,12 @@ setup_ubos(void)
 		glGetActiveUniformBlockiv(prog, i, GL_UNIFORM_BLOCK_DATA_SIZE,
 					  &size);
 
+		uniform_block_shadows[i].data = file_arena_calloc(1, size);
+		uniform_block_shadows[i].size = size;
+
 		glBindBuffer(GL_UNIFORM_BUFFER, uniform_block_bos[i]);
-		glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_STATIC_DRAW);
+		glBufferData(GL_UNIFORM_BUFFER, size,
+			     uniform_block_shadows[i].data, GL_STATIC_DRAW);
 
 		if (!force_no_names) {
 			glUniformBlockBinding(prog, i, i);
@@ -4929,6 +6127,28 @@ teardown_fbos(void)
 	read_fbo = 0;
 }
 
+/**
+ * Upload the ranges of the uniform blocks written since the last flush.
+ */
+static void
+flush_ubos(void)
+{
+	for (int i = 0; i < num_uniform_blocks; i++) {
+		struct uniform_block_shadow *shadow = &uniform_block_shadows[i];
+		GLint begin = MAX2(shadow->dirty_begin, 0);
+		GLint end = MIN2(shadow->dirty_end, shadow->size);
+
+		if (begin < end) {
+			glBindBuffer(GL_UNIFORM_BUFFER, uniform_block_bos[i]);
+			glBufferSubData(GL_UNIFORM_BUFFER, begin, end - begin,
+					shadow->data + begin);
+		}
+		shadow->dirty_begin = shadow->dirty_end = 0;
+	}
+
+	uniform_blocks_dirty = false;
+}
+
 static void
 teardown_ubos(void)
 {
@@ -4937,9 +6157,9 @@ teardown_ubos(void)
 	}
 
 	glDeleteBuffers(num_uniform_blocks, uniform_block_bos);
-	free(uniform_block_bos);
 	uniform_block_bos = NULL;
-	free(uniform_block_indexes);
+	uniform_block_shadows = NULL;
+	uniform_blocks_dirty = false;
 	uniform_block_indexes = NULL;
 	num_uniform_blocks = 0;
 }
@@ -4956,17 +6176,11 @@ teardown_atomics(void)
 static void
 teardown_shader_include_paths(void)
 {
-	for (unsigned i = 0; i < num_shader_include_paths; i++)
-		free(shader_include_path[i]);
-
-	for (unsigned i = 0; i < num_shader_includes; i++) {
+	for (unsigned i = 0; i < num_shader_includes; i++)
 		glDeleteNamedStringARB(-1, shader_include_names[i]);
-		free(shader_include_names[i]);
-	}
 
 	num_shader_includes = 0;
 	num_shader_include_paths = 0;
-	free(shader_include_path);
 	shader_include_path = NULL;
 }
 
@@ -5104,11 +6318,71 @@ draw_elements_common(int basevertex, int count)
 	return result;
 }
 
+/**
+ * Copy of the buffer read by the current run of buffer probes, so that
+ * the run maps it once rather than once per probe.
+ */
+static struct {
+	GLenum target;
+	GLuint buf;
+	GLsizeiptr size;
+	void *data;
+} probed_buffer;
+
+static void
+forget_probed_buffer(void)
+{
+	free(probed_buffer.data);
+	memset(&probed_buffer, 0, sizeof(probed_buffer));
+}
+
+/**
+ * Return the size bytes at offset in buf, which must be bound to target.
+ * The whole buffer is read the first time a run of probes asks for it.
+ * Returns NULL if the buffer can't be mapped or the range is outside it.
+ */
+static const void *
+read_probed_buffer(GLenum target, GLuint buf, GLintptr offset,
+		   GLsizeiptr size)
+{
+	if (probed_buffer.data == NULL || probed_buffer.buf != buf ||
+	    probed_buffer.target != target) {
+		GLint buf_size = 0;
+		void *p;
+
+		forget_probed_buffer();
+
+		glGetBufferParameteriv(target, GL_BUFFER_SIZE, &buf_size);
+		if (buf_size <= 0)
+			return NULL;
+
+		p = glMapBufferRange(target, 0, buf_size, GL_MAP_READ_BIT);
+		if (!p)
+			return NULL;
+
+		probed_buffer.data = malloc(buf_size);
+		if (probed_buffer.data)
+			memcpy(probed_buffer.data, p, buf_size);
+		glUnmapBuffer(target);
+		if (!probed_buffer.data)
+			return NULL;
+
+		probed_buffer.target = target;
+		probed_buffer.buf = buf;
+		probed_buffer.size = buf_size;
+	}
+
+	if (offset < 0 || offset + size > probed_buffer.size)
+		return NULL;
+
+	return (const char *) probed_buffer.data + offset;
+}
+
 static bool
 probe_atomic_counter(unsigned buffer_num, GLint counter_num, const char *op,
 		     uint32_t value, bool uses_layout_qualifiers)
 {
-        uint32_t *p;
+	const uint32_t *p;
 	uint32_t observed;
 	enum comparison cmp;
 	bool result;
@@ -5117,9 +6391,9 @@ probe_atomic_counter(unsigned buffer_num, GLint counter_num, const char *op,
 		"Invalid comparison operation at: %s\n", op);
 
 	glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, atomics_bos[buffer_num]);
-	p = glMapBufferRange(GL_ATOMIC_COUNTER_BUFFER,
-			     uses_layout_qualifiers ? counter_num : counter_num * sizeof(uint32_t),
-			     sizeof(uint32_t), GL_MAP_READ_BIT);
+	p = read_probed_buffer(GL_ATOMIC_COUNTER_BUFFER, atomics_bos[buffer_num],
+			       uses_layout_qualifiers ? counter_num : counter_num * sizeof(uint32_t),
+			       sizeof(uint32_t));
 
         if (!p) {
                 printf("Couldn't map atomic counter to verify expected value.\n");
@@ -5139,18 +6413,16 @@ probe_atomic_counter(unsigned buffer_num, GLint counter_num, const char *op,
 			       counter_num, comparison_string(cmp));
 		printf("  Reference: %u\n", value);
 		printf("  Observed:  %u\n", observed);
-		glUnmapBuffer(GL_ATOMIC_COUNTER_BUFFER);
 		return false;
 	}
 
-	glUnmapBuffer(GL_ATOMIC_COUNTER_BUFFER);
 	return true;
 }
 
 static bool
 probe_ssbo_uint(GLint ssbo_index, GLint ssbo_offset, const char *op, uint32_t value)
 {
-	uint32_t *p;
+	const uint32_t *p;
 	uint32_t observed;
 	enum comparison cmp;
 	bool result;
@@ -5159,8 +6431,8 @@ probe_ssbo_uint(GLint ssbo_index, GLint ssbo_offset, const char *op, uint32_t va
 		"Invalid comparison operation at: %s\n", op);
 
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
-	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, ssbo_offset,
-			     sizeof(uint32_t), GL_MAP_READ_BIT);
+	p = read_probed_buffer(GL_SHADER_STORAGE_BUFFER, ssbo[ssbo_index],
+			       ssbo_offset, sizeof(uint32_t));
 
 	if (!p) {
 		printf("Couldn't map ssbo to verify expected value.\n");
@@ -5175,18 +6447,16 @@ probe_ssbo_uint(GLint ssbo_index, GLint ssbo_offset, const char *op, uint32_t va
 		       ssbo_offset, comparison_string(cmp));
 		printf("  Reference: %u\n", value);
 		printf("  Observed:  %u\n", observed);
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 		return false;
 	}
 
-	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	return true;
 }
 
 static bool
 probe_ssbo_uint64(GLint ssbo_index, GLint ssbo_offset, const char *op, uint64_t value)
 {
-	uint64_t *p;
+	const uint64_t *p;
 	uint64_t observed;
 	enum comparison cmp;
 	bool result;
@@ -5195,8 +6465,8 @@ probe_ssbo_uint64(GLint ssbo_index, GLint ssbo_offset, const char *op, uint64_t
 		"Invalid comparison operation at: %s\n", op);
 
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
-	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, ssbo_offset,
-			     sizeof(uint64_t), GL_MAP_READ_BIT);
+	p = read_probed_buffer(GL_SHADER_STORAGE_BUFFER, ssbo[ssbo_index],
+			       ssbo_offset, sizeof(uint64_t));
 
 	if (!p) {
 		printf("Couldn't map ssbo to verify expected value.\n");
@@ -5211,18 +6481,16 @@ probe_ssbo_uint64(GLint ssbo_index, GLint ssbo_offset, const char *op, uint64_t
 		       ssbo_offset, comparison_string(cmp));
 		printf("  Reference: %"PRIu64"\n", value);
 		printf("  Observed:  %"PRIu64"\n", observed);
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 		return false;
 	}
 
-	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	return true;
 }
 
 static bool
 probe_ssbo_int(GLint ssbo_index, GLint ssbo_offset, const char *op, int32_t value)
 {
-	int32_t *p;
+	const int32_t *p;
 	int32_t observed;
 	enum comparison cmp;
 	bool result;
@@ -5231,8 +6499,8 @@ probe_ssbo_int(GLint ssbo_index, GLint ssbo_offset, const char *op, int32_t valu
 		"Invalid comparison operation at: %s\n", op);
 
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
-	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, ssbo_offset,
-			     sizeof(uint32_t), GL_MAP_READ_BIT);
+	p = read_probed_buffer(GL_SHADER_STORAGE_BUFFER, ssbo[ssbo_index],
+			       ssbo_offset, sizeof(uint32_t));
 
 	if (!p) {
 		printf("Couldn't map ssbo to verify expected value.\n");
@@ -5247,18 +6515,16 @@ probe_ssbo_int(GLint ssbo_index, GLint ssbo_offset, const char *op, int32_t valu
 		       ssbo_offset, comparison_string(cmp));
 		printf("  Reference: %d\n", value);
 		printf("  Observed:  %d\n", observed);
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 		return false;
 	}
 
-	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	return true;
 }
 
 static bool
 probe_ssbo_int64(GLint ssbo_index, GLint ssbo_offset, const char *op, int64_t value)
 {
-	int64_t *p;
+	const int64_t *p;
 	int64_t observed;
 	enum comparison cmp;
 	bool result;
@@ -5267,8 +6533,8 @@ probe_ssbo_int64(GLint ssbo_index, GLint ssbo_offset, const char *op, int64_t va
 		"Invalid comparison operation at: %s\n", op);
 
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
-	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, ssbo_offset,
-			     sizeof(uint64_t), GL_MAP_READ_BIT);
+	p = read_probed_buffer(GL_SHADER_STORAGE_BUFFER, ssbo[ssbo_index],
+			       ssbo_offset, sizeof(uint64_t));
 
 	if (!p) {
 		printf("Couldn't map ssbo to verify expected value.\n");
@@ -5283,18 +6549,16 @@ probe_ssbo_int64(GLint ssbo_index, GLint ssbo_offset, const char *op, int64_t va
 		       ssbo_offset, comparison_string(cmp));
 		printf("  Reference: %"PRId64"\n", value);
 		printf("  Observed:  %"PRId64"\n", observed);
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 		return false;
 	}
 
-	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
 	return true;
 }
 
 static bool
 probe_ssbo_double(GLint ssbo_index, GLint ssbo_offset, const char *op, double value)
 {
-	double *p;
+	const double *p;
 	double observed;
 	enum comparison cmp;
 	bool result;
@@ -5303,8 +6567,42 @@ probe_ssbo_double(GLint ssbo_index, GLint ssbo_offset, const char *op, double va
 		"Invalid comparison operation at: %s\n", op);
 
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
-	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, ssbo_offset,
-			     sizeof(double), GL_MAP_READ_BIT);
+	p = read_probed_buffer(GL_SHADER_STORAGE_BUFFER, ssbo[ssbo_index],
+			       ssbo_offset, sizeof(double));
+
+	if (!p) {
+		printf("Couldn't map ssbo to verify expected value.\n");
+		return false;
+	}
+
+	observed = *p;
+	result = compare_double(value, observed, cmp);
+
+	if (!result) {
+		printf("SSBO %d test failed: Reference %s Observed\n",
+		       ssbo_offset, comparison_string(cmp));
+		printf("  Reference: %g\n", value);
+		printf("  Observed:  %g\n", observed);
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+probe_ssbo_float(GLint ssbo_index, GLint ssbo_offset, const char *op, float value)
+{
+	const float *p;
+	float observed;
+	enum comparison cmp;
+	bool result;
+
+	REQUIRE(parse_comparison_op(op, &cmp, NULL),
+		"Invalid comparison operation at: %s\n", op);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
+	p = read_probed_buffer(GL_SHADER_STORAGE_BUFFER, ssbo[ssbo_index],
+			       ssbo_offset, sizeof(float));
 
 	if (!p) {
 		printf("Couldn't map ssbo to verify expected value.\n");
@@ -5314,164 +6612,989 @@ probe_ssbo_double(GLint ssbo_index, GLint ssbo_offset, const char *op, double va
 	observed = *p;
 	result = compare_double(value, observed, cmp);
 
-	if (!result) {
-		printf("SSBO %d test failed: Reference %s Observed\n",
-		       ssbo_offset, comparison_string(cmp));
-		printf("  Reference: %g\n", value);
-		printf("  Observed:  %g\n", observed);
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-		return false;
-	}
+	if (!result) {
+		printf("SSBO %d test failed: Reference %s Observed\n",
+		       ssbo_offset, comparison_string(cmp));
+		printf("  Reference: %g\n", value);
+		printf("  Observed:  %g\n", observed);
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Compute programs used by "verify ssbo", one per element type, built the
+ * first time they are needed in the current context.
+ */
+enum verify_type {
+	VERIFY_UINT,
+	VERIFY_INT,
+	VERIFY_FLOAT,
+	VERIFY_TYPES,
+};
+
+static const char *const verify_type_names[VERIFY_TYPES] = {
+	"uint", "int", "float",
+};
+
+static GLuint verify_programs[VERIFY_TYPES];
+static GLuint verify_result_buffer;
+
+#define VERIFY_LOCAL_SIZE 64
+#define VERIFY_MAX_GROUPS 65535
+
+static GLuint
+get_verify_program(enum verify_type type, GLuint first_binding)
+{
+	static const char *const mismatch[VERIFY_TYPES] = {
+		"observed[i] != expected[i]",
+		"observed[i] != expected[i]",
+		"!(abs(observed[i] - expected[i]) <= tolerance)",
+	};
+	char *source;
+
+	if (verify_programs[type])
+		return verify_programs[type];
+
+	(void)!asprintf(&source,
+		"%s\n"
+		"layout(local_size_x = %d) in;\n"
+		"layout(std430, binding = %u) readonly buffer Observed {\n"
+		"	%s observed[];\n"
+		"};\n"
+		"layout(std430, binding = %u) readonly buffer Expected {\n"
+		"	%s expected[];\n"
+		"};\n"
+		"layout(std430, binding = %u) buffer Result {\n"
+		"	uint mismatches;\n"
+		"	uint first_mismatch;\n"
+		"};\n"
+		"uniform uint count;\n"
+		"uniform float tolerance;\n"
+		"\n"
+		"void main()\n"
+		"{\n"
+		"	uint stride = gl_NumWorkGroups.x * gl_WorkGroupSize.x;\n"
+		"\n"
+		"	for (uint i = gl_GlobalInvocationID.x; i < count; i += stride) {\n"
+		"		if (%s) {\n"
+		"			atomicAdd(mismatches, 1u);\n"
+		"			atomicMin(first_mismatch, i);\n"
+		"		}\n"
+		"	}\n"
+		"}\n",
+		gl_version.es ? "#version 310 es" : "#version 430",
+		VERIFY_LOCAL_SIZE,
+		first_binding, verify_type_names[type],
+		first_binding + 1, verify_type_names[type],
+		first_binding + 2,
+		mismatch[type]);
+
+	verify_programs[type] =
+		piglit_build_simple_program_multiple_shaders(GL_COMPUTE_SHADER,
+							     source, 0);
+	free(source);
+
+	return verify_programs[type];
+}
+
+/**
+ * Delete the "verify ssbo" programs, before the context they belong to
+ * goes away.
+ */
+static void
+forget_verify_programs(void)
+{
+	for (unsigned i = 0; i < VERIFY_TYPES; i++) {
+		if (verify_programs[i])
+			glDeleteProgram(verify_programs[i]);
+		verify_programs[i] = 0;
+	}
+
+	if (verify_result_buffer)
+		glDeleteBuffers(1, &verify_result_buffer);
+	verify_result_buffer = 0;
+}
+
+struct saved_ssbo_binding {
+	GLint buffer;
+	GLint64 start;
+	GLint64 size;
+};
+
+static void
+save_ssbo_binding(GLuint index, struct saved_ssbo_binding *saved)
+{
+	glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, index,
+			&saved->buffer);
+	glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, index,
+			  &saved->start);
+	glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, index,
+			  &saved->size);
+}
+
+static void
+restore_ssbo_binding(GLuint index, const struct saved_ssbo_binding *saved)
+{
+	if (saved->size)
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index,
+				  saved->buffer, saved->start, saved->size);
+	else
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index,
+				 saved->buffer);
+}
+
+static bool
+read_ssbo_element(GLuint buffer, unsigned index, void *data)
+{
+	const void *p;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, index * 4, 4,
+			     GL_MAP_READ_BIT);
+	if (!p)
+		return false;
+
+	memcpy(data, p, 4);
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	return true;
+}
+
+/**
+ * Compare the first \p count elements of two SSBOs on the GPU, so that only
+ * the number of mismatches and the index of the first one are read back.
+ * Float elements match when they differ by at most \p tolerance.
+ */
+static bool
+verify_ssbo(const char *type_name, GLint ssbo_index, GLint expected_index,
+	    unsigned count, float tolerance)
+{
+	enum verify_type type = VERIFY_TYPES;
+	struct saved_ssbo_binding saved[3];
+	GLint max_bindings = 0, old_prog = 0, size;
+	GLuint first_binding, verify_prog;
+	const uint32_t *p;
+	uint32_t mismatches, first_mismatch;
+	static const uint32_t result_init[2] = { 0, UINT32_MAX };
+
+	for (unsigned i = 0; i < VERIFY_TYPES; i++) {
+		if (strcmp(type_name, verify_type_names[i]) == 0)
+			type = i;
+	}
+
+	REQUIRE(type != VERIFY_TYPES,
+		"Invalid verify ssbo type: %s\n", type_name);
+	REQUIRE(ssbo_index >= 0 && ssbo_index < (int) ARRAY_SIZE(ssbo) &&
+		expected_index >= 0 && expected_index < (int) ARRAY_SIZE(ssbo),
+		"verify ssbo index out of range\n");
+
+	for (unsigned i = 0; i < 2; i++) {
+		GLuint buffer = ssbo[i ? expected_index : ssbo_index];
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glGetBufferParameteriv(GL_SHADER_STORAGE_BUFFER,
+				       GL_BUFFER_SIZE, &size);
+		if ((GLint64) count * 4 > size) {
+			printf("verify ssbo: ssbo %d holds fewer than %u "
+			       "elements\n", i ? expected_index : ssbo_index,
+			       count);
+			return false;
+		}
+	}
+
+	if (count == 0)
+		return true;
+
+	/* Use the last bindings, which tests are the least likely to use,
+	 * and put back whatever was bound there afterwards.
+	 */
+	glGetIntegerv(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS, &max_bindings);
+	REQUIRE(max_bindings >= 3,
+		"verify ssbo needs 3 shader storage buffer bindings\n");
+	first_binding = max_bindings - 3;
+
+	verify_prog = get_verify_program(type, first_binding);
+	if (!verify_prog) {
+		printf("verify ssbo: couldn't build the comparison program\n");
+		return false;
+	}
+
+	if (!verify_result_buffer)
+		glGenBuffers(1, &verify_result_buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, verify_result_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(result_init),
+		     result_init, GL_STREAM_READ);
+
+	for (unsigned i = 0; i < 3; i++)
+		save_ssbo_binding(first_binding + i, &saved[i]);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &old_prog);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, first_binding,
+			 ssbo[ssbo_index]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, first_binding + 1,
+			 ssbo[expected_index]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, first_binding + 2,
+			 verify_result_buffer);
+
+	glUseProgram(verify_prog);
+	glUniform1ui(glGetUniformLocation(verify_prog, "count"), count);
+	glUniform1f(glGetUniformLocation(verify_prog, "tolerance"), tolerance);
+
+	/* Make the writes of the test visible to the comparison. */
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	glDispatchCompute(MIN2((count + VERIFY_LOCAL_SIZE - 1) /
+			       VERIFY_LOCAL_SIZE, VERIFY_MAX_GROUPS), 1, 1);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	glUseProgram(old_prog);
+	for (unsigned i = 0; i < 3; i++)
+		restore_ssbo_binding(first_binding + i, &saved[i]);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, verify_result_buffer);
+	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(result_init),
+			     GL_MAP_READ_BIT);
+	if (!p) {
+		printf("Couldn't map the verify ssbo result.\n");
+		return false;
+	}
+	mismatches = p[0];
+	first_mismatch = p[1];
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+
+	if (mismatches == 0)
+		return true;
+
+	printf("SSBO %d doesn't match SSBO %d: %u of %u %s elements differ\n",
+	       ssbo_index, expected_index, mismatches, count, type_name);
+
+	union { uint32_t u; int32_t i; float f; } observed, expected;
+	if (read_ssbo_element(ssbo[ssbo_index], first_mismatch, &observed) &&
+	    read_ssbo_element(ssbo[expected_index], first_mismatch, &expected)) {
+		printf("  First mismatch at element %u:\n", first_mismatch);
+		switch (type) {
+		case VERIFY_UINT:
+			printf("  Expected: %u\n", expected.u);
+			printf("  Observed: %u\n", observed.u);
+			break;
+		case VERIFY_INT:
+			printf("  Expected: %d\n", expected.i);
+			printf("  Observed: %d\n", observed.i);
+			break;
+		default:
+			printf("  Expected: %g\n", expected.f);
+			printf("  Observed: %g\n", observed.f);
+			break;
+		}
+	}
+
+	return false;
+}
+
+GLenum piglit_xfb_primitive_mode(GLenum draw_arrays_mode)
+{
+	switch (draw_arrays_mode) {
+	case GL_POINTS:
+		return GL_POINTS;
+	case GL_LINES:
+	case GL_LINE_LOOP:
+	case GL_LINE_STRIP:
+	case GL_LINES_ADJACENCY:
+	case GL_LINE_STRIP_ADJACENCY:
+		return GL_LINES;
+	case GL_TRIANGLES:
+	case GL_TRIANGLE_STRIP:
+	case GL_TRIANGLE_FAN:
+	case GL_TRIANGLES_ADJACENCY:
+	case GL_TRIANGLE_STRIP_ADJACENCY:
+		return GL_TRIANGLES;
+	}
+
+	printf("glDrawArrays mode %s not supported for a transform feedback operation\n",
+	       piglit_get_gl_enum_name(draw_arrays_mode));
+	piglit_report_result(PIGLIT_FAIL);
+}
+
+static void
+begin_query(GLenum query_type)
+{
+	unsigned idx = query_index(query_type);
+	if (queries[idx] == 0)
+		glGenQueries(1, &queries[idx]);
+	glBeginQuery(query_type, queries[idx]);
+}
+
+static void
+piglit_xfb_draw_arrays(GLenum mode, int first, size_t count)
+{
+	GLenum primitive_mode = piglit_xfb_primitive_mode(mode);
+
+	begin_query(GL_PRIMITIVES_GENERATED);
+	begin_query(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+
+	glEnable(GL_RASTERIZER_DISCARD);
+
+	/* We don't need to call glBindBufferBase here, it is done on
+	 * the "xfb buffer object" command
+	 */
+
+	glBeginTransformFeedback(primitive_mode);
+	glDrawArrays(mode, first, count);
+	glEndTransformFeedback();
+
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	glFlush();
+
+	glEndQuery(GL_PRIMITIVES_GENERATED);
+	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+}
+
+static bool
+probe_xfb_float(GLuint buf, unsigned n, float expected)
+{
+	const float *p;
+	bool result;
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, buf);
+	p = read_probed_buffer(GL_TRANSFORM_FEEDBACK_BUFFER, buf,
+			       n * sizeof(float), sizeof(float));
+	if (!p) {
+		printf("Couldn't map xfb buffer %u\n", buf);
+		return false;
+	}
+	result = fabsf(expected - *p) < piglit_tolerance[0];
+	if (!result) {
+		printf("xfb buffer %i[%i]: %f, Expected: %f\n",
+		       buf, n, *p, expected);
+	}
+
+	return result;
+}
+
+static bool
+probe_xfb_double(GLuint buf, unsigned n, double expected)
+{
+	const double *p;
+	bool result;
+
+	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, buf);
+	p = read_probed_buffer(GL_TRANSFORM_FEEDBACK_BUFFER, buf,
+			       n * sizeof(double), sizeof(double));
+	if (!p) {
+		printf("Couldn't map xfb buffer %u\n", buf);
+		return false;
+	}
+	result = fabs(expected - *p) < piglit_tolerance[0];
+	if (!result) {
+		printf("xfb buffer %i[%i]: %lf, Expected: %lf\n",
+		       buf, n, *p, expected);
+	}
+
+	return result;
+}
+
+static void
+free_test_commands(void)
+{
+	test_commands = NULL;
+	test_command_text = NULL;
+	num_test_commands = 0;
+}
+
+/**
+ * Decode the operands of \p cmd if it is one of the commands with a
+ * dedicated opcode.  Lines that don't match exactly (including the
+ * variants that share a prefix, like "draw rect ortho") are left as
+ * TEST_OP_SCRIPT so they keep going through the generic parser.
+ */
+static void
+compile_test_command(struct test_command *cmd)
+{
+	const char *line = cmd->line;
+	const char *rest;
+	char s[32];
+
+	cmd->op = TEST_OP_SCRIPT;
+	memset(&cmd->args, 0, sizeof(cmd->args));
+
+	if (parse_str(line, "clear color ", &rest)) {
+		parse_floats(rest, cmd->args.f, 4, NULL);
+		cmd->op = TEST_OP_CLEAR_COLOR;
+	} else if (parse_str(line, "clear depth ", &rest)) {
+		parse_floats(rest, cmd->args.f, 1, NULL);
+		cmd->op = TEST_OP_CLEAR_DEPTH;
+	} else if (parse_str(line, "clear", NULL)) {
+		cmd->op = TEST_OP_CLEAR;
+	} else if (parse_str(line, "draw rect ", &rest)) {
+		if (parse_str(rest, "tex ", NULL) ||
+		    parse_str(rest, "ortho ", NULL) ||
+		    parse_str(rest, "patch ", NULL))
+			return;
+
+		parse_floats(rest, cmd->args.f, 4, NULL);
+		cmd->op = TEST_OP_DRAW_RECT;
+	} else if (parse_str(line, "draw arrays ", &rest)) {
+		if (parse_str(rest, "instanced ", NULL) ||
+		    sscanf(rest, "%31s %d %d", s, &cmd->args.draw.first,
+			   &cmd->args.draw.count) != 3)
+			return;
+
+		cmd->args.draw.mode = decode_drawing_mode(s);
+		cmd->op = TEST_OP_DRAW_ARRAYS;
+	} else if (parse_str(line, "probe rgba ", &rest)) {
+		parse_floats(rest, cmd->args.f, 6, NULL);
+		cmd->op = TEST_OP_PROBE_RGBA;
+	} else if (parse_str(line, "probe rgb ", &rest)) {
+		parse_floats(rest, cmd->args.f, 5, NULL);
+		cmd->op = TEST_OP_PROBE_RGB;
+	} else if (sscanf(line, "probe rect rgba "
+			  "( %d , %d , %d , %d ) "
+			  "( %f , %f , %f , %f )",
+			  &cmd->args.rect.x, &cmd->args.rect.y,
+			  &cmd->args.rect.w, &cmd->args.rect.h,
+			  cmd->args.rect.color + 0, cmd->args.rect.color + 1,
+			  cmd->args.rect.color + 2,
+			  cmd->args.rect.color + 3) == 8) {
+		cmd->op = TEST_OP_PROBE_RECT_RGBA;
+	} else if (parse_str(line, "probe all rgba ", &rest)) {
+		parse_floats(rest, cmd->args.f, 4, NULL);
+		cmd->op = TEST_OP_PROBE_ALL_RGBA;
+	} else if (parse_str(line, "probe all rgb ", &rest)) {
+		parse_floats(rest, cmd->args.f, 3, NULL);
+		cmd->op = TEST_OP_PROBE_ALL_RGB;
+	} else if (parse_str(line, "benchmark draw rect ", &rest)) {
+		float *r = cmd->args.benchmark.rect;
+		int n = sscanf(rest, "%f %f %f %f iterations %u",
+			       &r[0], &r[1], &r[2], &r[3],
+			       &cmd->args.benchmark.iterations);
+
+		if (n != 4 && n != 5)
+			return;
+		if (n == 4)
+			cmd->args.benchmark.iterations = 1;
+		cmd->op = TEST_OP_BENCHMARK_DRAW_RECT;
+	} else if (parse_str(line, "benchmark compute ", &rest)) {
+		GLuint *g = cmd->args.benchmark.groups;
+		int n = sscanf(rest, "%u %u %u iterations %u",
+			       &g[0], &g[1], &g[2],
+			       &cmd->args.benchmark.iterations);
+
+		if (n != 3 && n != 4)
+			return;
+		if (n == 3)
+			cmd->args.benchmark.iterations = 1;
+		cmd->op = TEST_OP_BENCHMARK_COMPUTE;
+	}
+}
+
+static bool
+is_benchmark(const struct test_command *cmd)
+{
+	return cmd->op == TEST_OP_BENCHMARK_DRAW_RECT ||
+	       cmd->op == TEST_OP_BENCHMARK_COMPUTE;
+}
+
+static bool
+is_color_probe(const struct test_command *cmd)
+{
+	switch (cmd->op) {
+	case TEST_OP_PROBE_RGBA:
+	case TEST_OP_PROBE_RGB:
+	case TEST_OP_PROBE_RECT_RGBA:
+	case TEST_OP_PROBE_ALL_RGBA:
+	case TEST_OP_PROBE_ALL_RGB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Whether the command only sets uniforms, so that uploading the uniform
+ * blocks can wait until after it.
+ */
+static bool
+is_uniform_command(const struct test_command *cmd)
+{
+	return cmd->op == TEST_OP_SCRIPT &&
+	       (parse_str(cmd->line, "uniform ", NULL) ||
+		parse_str(cmd->line, "block ", NULL) ||
+		parse_str(cmd->line, "ubo array index ", NULL));
+}
+
+static bool
+is_buffer_probe(const struct test_command *cmd)
+{
+	return cmd->op == TEST_OP_SCRIPT &&
+	       (parse_str(cmd->line, "probe ssbo ", NULL) ||
+		parse_str(cmd->line, "probe atomic counter ", NULL) ||
+		parse_str(cmd->line, "probe xfb buffer ", NULL));
+}
+
+/**
+ * Find the runs of consecutive color probes.  Since nothing can render in
+ * between, each run can be checked against one copy of the framebuffer
+ * instead of reading it back once per probe.
+ */
+static void
+mark_probe_batches(void)
+{
+	unsigned i = 0;
+
+	while (i < num_test_commands) {
+		unsigned end = i;
+
+		while (end < num_test_commands &&
+		       is_color_probe(&test_commands[end]))
+			end++;
+
+		if (end - i >= 2) {
+			test_commands[i].probe_batch_begin = true;
+			test_commands[end - 1].probe_batch_end = true;
+		}
+
+		i = MAX2(end, i + 1);
+	}
+
+	for (i = 0; i < num_test_commands; i++) {
+		if (is_buffer_probe(&test_commands[i]) &&
+		    (i + 1 == num_test_commands ||
+		     !is_buffer_probe(&test_commands[i + 1])))
+			test_commands[i].buffer_probe_end = true;
+	}
+}
+
+/**
+ * Split the [test] section into an array of commands.
+ *
+ * This is done once per test from init_test(): every line is copied and
+ * NUL-terminated a single time, blank lines and comments are dropped, and
+ * the common commands get their operands pre-parsed.
+ */
+static void
+compile_test_commands(void)
+{
+	unsigned line_num = test_start_line_num;
+	unsigned max_commands = 1;
+	char *p;
+
+	free_test_commands();
+
+	if (test_start == NULL)
+		return;
+
+	test_command_text = file_arena_strndup(test_start, strlen(test_start));
+	for (p = test_command_text; *p; p++) {
+		if (*p == '\n')
+			max_commands++;
+	}
+
+	test_commands = file_arena_calloc(max_commands, sizeof(*test_commands));
+
+	p = test_command_text;
+	while (p[0] != '\0') {
+		const char *line;
+		char *end;
+
+		parse_whitespace(p, &line);
+		end = (char *) strchrnul(line, '\n');
+
+		/* If strchrnul found a newline, then skip it */
+		p = end[0] != '\0' ? end + 1 : end;
+		*end = '\0';
+
+		if (line[0] != '\0' && line[0] != '#') {
+			struct test_command *cmd =
+				&test_commands[num_test_commands++];
+
+			cmd->line = line;
+			cmd->line_num = line_num;
+			compile_test_command(cmd);
+		}
+
+		line_num++;
+	}
+
+	mark_probe_batches();
+}
+
+#ifdef PIGLIT_USE_OPENGL
+/* Seconds each benchmark measurement runs for, at least. */
+#define BENCHMARK_DURATION 0.5
+
+/* The benchmark command being measured. */
+static const struct test_command *benchmark_cmd;
+
+static void
+benchmark_draw_rect(unsigned count)
+{
+	const float *r = benchmark_cmd->args.benchmark.rect;
+	unsigned n = count * benchmark_cmd->args.benchmark.iterations;
+
+	for (unsigned i = 0; i < n; i++)
+		piglit_draw_rect(r[0], r[1], r[2], r[3]);
+}
+
+static void
+benchmark_compute(unsigned count)
+{
+	const GLuint *g = benchmark_cmd->args.benchmark.groups;
+	unsigned n = count * benchmark_cmd->args.benchmark.iterations;
+
+	/* Unlike the compute command, the dispatches are let to overlap,
+	 * there is only a barrier after the last one.
+	 */
+	for (unsigned i = 0; i < n; i++)
+		glDispatchCompute(g[0], g[1], g[2]);
+	glMemoryBarrier(GL_ALL_BARRIER_BITS);
+}
+
+/**
+ * Run one of
+ *
+ *   benchmark draw rect X Y W H [iterations N]
+ *   benchmark compute X Y Z [iterations N]
+ *
+ * and measure how many of the draws or dispatches per second the GPU runs,
+ * with perf_measure_gpu_rate() like the benchmarks of tests/perf, N at a
+ * time.  The rate is reported as a metric in a PIGLIT: line, and written to
+ * PIGLIT_PERF_JSON and PIGLIT_PERF_CSV when they are set.
+ */
+static void
+run_benchmark(const struct test_command *cmd)
+{
+	const bool draw = cmd->op == TEST_OP_BENCHMARK_DRAW_RECT;
+	const char *unit = draw ? "draws/sec" : "dispatches/sec";
+	unsigned iterations = cmd->args.benchmark.iterations;
+	const struct perf_stats *stats;
+	char name[512];
+	double rate;
+
+	if (!timer_query_supported) {
+		printf("benchmark commands need GL 3.3 or "
+		       "GL_ARB_timer_query\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	if (draw)
+		program_subroutine_uniforms();
+
+	benchmark_cmd = cmd;
+	rate = perf_measure_gpu_rate(draw ? benchmark_draw_rect :
+				     benchmark_compute, BENCHMARK_DURATION);
+	rate *= iterations;
+	stats = perf_last_stats();
+
+	/* The line without "benchmark ", which stays the same when lines
+	 * are added to the test.
+	 */
+	snprintf(name, sizeof(name), "%s%s%s",
+		 metric_prefix ? metric_prefix : "", metric_prefix ? " " : "",
+		 cmd->line + strlen("benchmark "));
+
+	printf("line %u: %.1f %s%s\n", cmd->line_num, rate, unit,
+	       stats->noisy ? " (noisy)" : "");
+	printf("PIGLIT: {\"metrics\": {\"%s\": {\"value\": %.9g, "
+	       "\"unit\": \"%s\", \"stddev\": %.9g, \"cv\": %.4f, "
+	       "\"samples\": %u, \"noisy\": %s}}}\n",
+	       name, rate, unit, stats->stddev * iterations, stats->cv,
+	       stats->num_samples, stats->noisy ? "true" : "false");
+	fflush(stdout);
+
+	perf_report("shader_runner", name, unit, iterations, stats);
+}
+#endif
+
+static enum piglit_result
+execute_test_command(const struct test_command *cmd, GLbitfield *clear_bits)
+{
+	enum piglit_result result = PIGLIT_PASS;
+	const float *c = cmd->args.f;
+
+	switch (cmd->op) {
+	case TEST_OP_CLEAR:
+		glClear(*clear_bits);
+		break;
+	case TEST_OP_CLEAR_COLOR:
+		glClearColor(c[0], c[1], c[2], c[3]);
+		*clear_bits |= GL_COLOR_BUFFER_BIT;
+		break;
+	case TEST_OP_CLEAR_DEPTH:
+		glClearDepth(c[0]);
+		*clear_bits |= GL_DEPTH_BUFFER_BIT;
+		break;
+	case TEST_OP_DRAW_RECT:
+		result = program_must_be_in_use();
+		program_subroutine_uniforms();
+		piglit_draw_rect(c[0], c[1], c[2], c[3]);
+		break;
+	case TEST_OP_DRAW_ARRAYS:
+		result = draw_arrays_common(cmd->args.draw.first,
+					    cmd->args.draw.count);
+		glDrawArrays(cmd->args.draw.mode, cmd->args.draw.first,
+			     cmd->args.draw.count);
+		break;
+	case TEST_OP_PROBE_RGBA:
+		if (!piglit_probe_pixel_rgba((int) c[0], (int) c[1], &c[2]))
+			result = PIGLIT_FAIL;
+		break;
+	case TEST_OP_PROBE_RGB:
+		if (!piglit_probe_pixel_rgb((int) c[0], (int) c[1], &c[2]))
+			result = PIGLIT_FAIL;
+		break;
+	case TEST_OP_PROBE_RECT_RGBA:
+		if (!piglit_probe_rect_rgba(cmd->args.rect.x, cmd->args.rect.y,
+					    cmd->args.rect.w, cmd->args.rect.h,
+					    cmd->args.rect.color))
+			result = PIGLIT_FAIL;
+		break;
+	case TEST_OP_PROBE_ALL_RGBA:
+		if (!piglit_probe_rect_rgba(0, 0, read_width, read_height, c))
+			result = PIGLIT_FAIL;
+		break;
+	case TEST_OP_PROBE_ALL_RGB:
+		if (!piglit_probe_rect_rgb(0, 0, read_width, read_height, c))
+			result = PIGLIT_FAIL;
+		break;
+	case TEST_OP_BENCHMARK_DRAW_RECT:
+	case TEST_OP_BENCHMARK_COMPUTE:
+		result = program_must_be_in_use();
+#ifdef PIGLIT_USE_OPENGL
+		if (result == PIGLIT_PASS)
+			run_benchmark(cmd);
+#else
+		printf("benchmark commands need desktop GL\n");
+		piglit_report_result(PIGLIT_SKIP);
+#endif
+		break;
+	case TEST_OP_SCRIPT:
+		assert(!"script commands are handled by piglit_display()");
+		break;
+	}
+
+	return result;
+}
+
+/**
+ * Time spent in a step of loading the test file or in a [test] command,
+ * with -profile.
+ */
+struct profile_entry {
+	const char *label;
+	/* 0 for the loading steps. */
+	unsigned line_num;
+	unsigned runs;
+	int64_t cpu_nsec;
+	int64_t gpu_nsec;
+	/* GL_TIME_ELAPSED query of the last run, or 0. */
+	GLuint query;
+};
+
+enum profile_step {
+	PROFILE_PARSE,
+	PROFILE_LINK,
+	PROFILE_VERTEX_DATA,
+	PROFILE_NUM_STEPS
+};
+
+#define PROFILE_REPORTED 20
+
+static struct profile_entry profile_steps[PROFILE_NUM_STEPS];
+/* One entry per test command, allocated from the file arena. */
+static struct profile_entry *profile_commands;
+static unsigned profile_num_commands;
+/* Whether the commands are timed on the GPU too. */
+static bool profile_gpu = false;
 
-	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-	return true;
+static void
+profile_step_begin(int64_t *start)
+{
+	if (profile_mode)
+		*start = piglit_time_get_nano();
 }
 
-static bool
-probe_ssbo_float(GLint ssbo_index, GLint ssbo_offset, const char *op, float value)
+static void
+profile_step_end(enum profile_step step, int64_t start)
 {
-	float *p;
-	float observed;
-	enum comparison cmp;
-	bool result;
+	static const char *const names[] = {
+		"parse and compile", "link", "vertex data",
+	};
 
-	REQUIRE(parse_comparison_op(op, &cmp, NULL),
-		"Invalid comparison operation at: %s\n", op);
+	if (!profile_mode)
+		return;
 
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo[ssbo_index]);
-	p = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, ssbo_offset,
-			     sizeof(float), GL_MAP_READ_BIT);
+	profile_steps[step].label = names[step];
+	profile_steps[step].runs++;
+	profile_steps[step].cpu_nsec += piglit_time_get_nano() - start;
+	profile_steps[step].gpu_nsec = -1;
+}
 
-	if (!p) {
-		printf("Couldn't map ssbo to verify expected value.\n");
-		return false;
-	}
+static void
+profile_command_begin(const struct test_command *cmd, int64_t *start)
+{
+	struct profile_entry *entry;
 
-	observed = *p;
-	result = compare_double(value, observed, cmp);
+	if (!profile_mode)
+		return;
 
-	if (!result) {
-		printf("SSBO %d test failed: Reference %s Observed\n",
-		       ssbo_offset, comparison_string(cmp));
-		printf("  Reference: %g\n", value);
-		printf("  Observed:  %g\n", observed);
-		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-		return false;
+	if (profile_commands == NULL) {
+		profile_num_commands = num_test_commands;
+		profile_commands = file_arena_calloc(profile_num_commands,
+						     sizeof(*profile_commands));
 	}
+	entry = &profile_commands[cmd - test_commands];
+	entry->label = cmd->line;
+	entry->line_num = cmd->line_num;
 
-	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-	return true;
+	/* The benchmarks use GL_TIME_ELAPSED queries of their own. */
+	if (profile_gpu && !is_benchmark(cmd)) {
+		if (entry->query == 0)
+			glGenQueries(1, &entry->query);
+		glBeginQuery(GL_TIME_ELAPSED, entry->query);
+	}
+	*start = piglit_time_get_nano();
 }
 
-GLenum piglit_xfb_primitive_mode(GLenum draw_arrays_mode)
+static void
+profile_command_end(const struct test_command *cmd, int64_t start)
 {
-	switch (draw_arrays_mode) {
-	case GL_POINTS:
-		return GL_POINTS;
-	case GL_LINES:
-	case GL_LINE_LOOP:
-	case GL_LINE_STRIP:
-	case GL_LINES_ADJACENCY:
-	case GL_LINE_STRIP_ADJACENCY:
-		return GL_LINES;
-	case GL_TRIANGLES:
-	case GL_TRIANGLE_STRIP:
-	case GL_TRIANGLE_FAN:
-	case GL_TRIANGLES_ADJACENCY:
-	case GL_TRIANGLE_STRIP_ADJACENCY:
-		return GL_TRIANGLES;
-	}
+	struct profile_entry *entry;
 
-	printf("glDrawArrays mode %s not supported for a transform feedback operation\n",
-	       piglit_get_gl_enum_name(draw_arrays_mode));
-	piglit_report_result(PIGLIT_FAIL);
+	if (!profile_mode)
+		return;
+
+	entry = &profile_commands[cmd - test_commands];
+	entry->runs++;
+	entry->cpu_nsec += piglit_time_get_nano() - start;
+	if (profile_gpu && !is_benchmark(cmd))
+		glEndQuery(GL_TIME_ELAPSED);
+	else
+		entry->gpu_nsec = -1;
 }
 
-static void
-begin_query(GLenum query_type)
+static int64_t
+profile_entry_nsec(const struct profile_entry *entry)
 {
-	unsigned idx = query_index(query_type);
-	if (queries[idx] == 0)
-		glGenQueries(1, &queries[idx]);
-	glBeginQuery(query_type, queries[idx]);
+	return MAX2(entry->cpu_nsec, entry->gpu_nsec);
 }
 
-static void
-piglit_xfb_draw_arrays(GLenum mode, int first, size_t count)
+static int
+compare_profile_entries(const void *a, const void *b)
 {
-	GLenum primitive_mode = piglit_xfb_primitive_mode(mode);
+	int64_t a_nsec = profile_entry_nsec(*(const struct profile_entry **) a);
+	int64_t b_nsec = profile_entry_nsec(*(const struct profile_entry **) b);
 
-	begin_query(GL_PRIMITIVES_GENERATED);
-	begin_query(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+	return a_nsec < b_nsec ? 1 : a_nsec > b_nsec ? -1 : 0;
+}
 
-	glEnable(GL_RASTERIZER_DISCARD);
+static void
+print_profile_metric(const struct profile_entry *entry, const char *clock,
+		     int64_t nsec, bool first)
+{
+	printf("%s\"%s%s", first ? "" : ", ",
+	       metric_prefix ? metric_prefix : "", metric_prefix ? " " : "");
+	if (entry->line_num)
+		printf("line %u", entry->line_num);
+	else
+		printf("%s", entry->label);
+	printf(" %s\": {\"value\": %.0f, \"unit\": \"ns\", "
+	       "\"samples\": %u}", clock, (double) nsec / entry->runs,
+	       entry->runs);
+}
 
-	/* We don't need to call glBindBufferBase here, it is done on
-	 * the "xfb buffer object" command
-	 */
+/**
+ * Collect the GPU times of the last pass over the test commands, and print
+ * the steps and commands that took the longest, as a table and as metrics
+ * in a PIGLIT: line.  Times are the totals over all the passes, and the
+ * metrics their means.
+ */
+static void
+report_profile(void)
+{
+	struct profile_entry **sorted;
+	unsigned num_entries = 0;
+	unsigned i;
 
-	glBeginTransformFeedback(primitive_mode);
-	glDrawArrays(mode, first, count);
-	glEndTransformFeedback();
+	if (!profile_mode)
+		return;
 
-	glDisable(GL_RASTERIZER_DISCARD);
+	sorted = malloc((PROFILE_NUM_STEPS + profile_num_commands) *
+			sizeof(*sorted));
+	if (sorted == NULL)
+		return;
 
-	glFlush();
+	for (i = 0; i < PROFILE_NUM_STEPS; i++) {
+		if (profile_steps[i].runs)
+			sorted[num_entries++] = &profile_steps[i];
+	}
+	for (i = 0; profile_commands && i < profile_num_commands; i++) {
+		struct profile_entry *entry = &profile_commands[i];
 
-	glEndQuery(GL_PRIMITIVES_GENERATED);
-	glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
-}
+		if (!entry->runs)
+			continue;
+		if (entry->query) {
+			GLuint64 nsec = 0;
 
-static bool
-probe_xfb_float(GLuint buf, unsigned n, float expected)
-{
-	float *p;
-	bool result;
-	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, buf);
-	p = glMapBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, n * sizeof(float),
-			     sizeof(float), GL_MAP_READ_BIT);
-	if (!p) {
-		printf("Couldn't map xfb buffer %u\n", buf);
-		return false;
+			glGetQueryObjectui64v(entry->query, GL_QUERY_RESULT,
+					      &nsec);
+			entry->gpu_nsec += nsec;
+		}
+		sorted[num_entries++] = entry;
+	}
+	qsort(sorted, num_entries, sizeof(*sorted), compare_profile_entries);
+	num_entries = MIN2(num_entries, PROFILE_REPORTED);
+
+	printf("%6s %12s %12s  %s\n", "Line", "CPU usec", "GPU usec",
+	       "Command");
+	for (i = 0; i < num_entries; i++) {
+		const struct profile_entry *entry = sorted[i];
+		char gpu[32] = "-";
+
+		if (entry->gpu_nsec >= 0)
+			snprintf(gpu, sizeof(gpu), "%.1f",
+				 entry->gpu_nsec / 1000.0);
+		if (entry->line_num)
+			printf("%6u", entry->line_num);
+		else
+			printf("%6s", "-");
+		printf(" %12.1f %12s  %.60s\n", entry->cpu_nsec / 1000.0, gpu,
+		       entry->label);
 	}
-	result = fabsf(expected - *p) < piglit_tolerance[0];
-	if (!result) {
-		printf("xfb buffer %i[%i]: %f, Expected: %f\n",
-		       buf, n, *p, expected);
+
+	printf("PIGLIT: {\"metrics\": {");
+	for (i = 0; i < num_entries; i++) {
+		print_profile_metric(sorted[i], "cpu", sorted[i]->cpu_nsec,
+				     i == 0);
+		if (sorted[i]->gpu_nsec >= 0)
+			print_profile_metric(sorted[i], "gpu",
+					     sorted[i]->gpu_nsec, false);
 	}
+	printf("}}\n");
+	fflush(stdout);
 
-	glUnmapBuffer(GL_TRANSFORM_FEEDBACK_BUFFER);
-	return result;
+	free(sorted);
 }
 
-static bool
-probe_xfb_double(GLuint buf, unsigned n, double expected)
+/**
+ * Forget the times of the test that ran, before the next one.
+ */
+static void
+teardown_profile(void)
 {
-	double *p;
-	bool result;
-
-	glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, buf);
-	p = glMapBufferRange(GL_TRANSFORM_FEEDBACK_BUFFER, n * sizeof(double),
-			     sizeof(double), GL_MAP_READ_BIT);
-	if (!p) {
-		printf("Couldn't map xfb buffer %u\n", buf);
-		return false;
-	}
-	result = fabs(expected - *p) < piglit_tolerance[0];
-	if (!result) {
-		printf("xfb buffer %i[%i]: %lf, Expected: %lf\n",
-		       buf, n, *p, expected);
+	for (unsigned i = 0; profile_commands && i < profile_num_commands; i++) {
+		if (profile_commands[i].query)
+			glDeleteQueries(1, &profile_commands[i].query);
 	}
-
-	glUnmapBuffer(GL_TRANSFORM_FEEDBACK_BUFFER);
-	return result;
+	profile_commands = NULL;
+	profile_num_commands = 0;
+	memset(profile_steps, 0, sizeof(profile_steps));
 }
 
 enum piglit_result
 piglit_display(void)
 {
-	const char *line, *next_line, *rest;
-	unsigned line_num;
+	const char *line, *rest;
+	const struct test_command *cmd;
 	enum piglit_result full_result = PIGLIT_PASS;
 	GLbitfield clear_bits = 0;
 	bool link_error_expected = false;
@@ -5483,9 +7606,8 @@ piglit_display(void)
 		return PIGLIT_PASS;
 	}
 
-	next_line = test_start;
-	line_num = test_start_line_num;
-	while (next_line[0] != '\0') {
+	for (cmd = test_commands;
+	     cmd < test_commands + num_test_commands; cmd++) {
 		float c[32];
 		double d[4];
 		int x, y, z, w, h, l, tex, level;
@@ -5494,19 +7616,19 @@ piglit_display(void)
 		uint64_t luy, luz;
 		char s[300]; // 300 for safety
 		enum piglit_result result = PIGLIT_PASS;
+		int64_t start = 0;
 
-		parse_whitespace(next_line, &line);
+		line = cmd->line;
+		profile_command_begin(cmd, &start);
 
-		next_line = strchrnul(next_line, '\n');
+		if (uniform_blocks_dirty && !is_uniform_command(cmd))
+			flush_ubos();
 
-		/* Duplicate the line to make it null terminated */
-		line = strndup(line, next_line - line);
-
-		/* If strchrnul found a newline, then skip it */
-		if (next_line[0] != '\0')
-			next_line++;
+		if (cmd->probe_batch_begin)
+			piglit_probe_batch_begin(0, 0, read_width, read_height);
 
-		if (line[0] == '\0') {
+		if (cmd->op != TEST_OP_SCRIPT) {
+			result = execute_test_command(cmd, &clear_bits);
 		} else if (sscanf(line, "active shader program %s", s) == 1) {
 			switch (get_shader_from_string(s, &x)) {
 			case GL_VERTEX_SHADER:
@@ -5644,6 +7766,11 @@ piglit_display(void)
 						2.0 * (c[2] / piglit_width),
 						2.0 * (c[3] / piglit_height), false,
 						instance_count);
+		} else if (parse_str(line, "draw tiles ", &rest)) {
+			result = program_must_be_in_use();
+			program_subroutine_uniforms();
+			if (result == PIGLIT_PASS)
+				result = draw_tiles(rest);
 		} else if (parse_str(line, "draw instanced rect ", &rest)) {
 			int primcount;
 
@@ -6043,6 +8170,14 @@ piglit_display(void)
 				  &x, &y, s, &c[0]) == 4) {
 			if (!probe_ssbo_float(x, y, s, c[0]))
 				result = PIGLIT_FAIL;
+		} else if (sscanf(line, "verify ssbo %31s %d %d %u %f",
+				  s, &x, &y, &ux, &c[0]) == 5) {
+			if (!verify_ssbo(s, x, y, ux, c[0]))
+				result = PIGLIT_FAIL;
+		} else if (sscanf(line, "verify ssbo %31s %d %d %u",
+				  s, &x, &y, &ux) == 4) {
+			if (!verify_ssbo(s, x, y, ux, 0.0))
+				result = PIGLIT_FAIL;
 		} else if (sscanf(line,
 				  "relative probe rgba ( %f , %f ) "
 				  "( %f , %f , %f , %f )",
@@ -6140,6 +8275,8 @@ piglit_display(void)
 				fprintf(stderr, "glPolygonMode error\n");
 				piglit_report_result(PIGLIT_FAIL);
 			}
+		} else if (parse_str(line, "probe tiles rgba ", &rest)) {
+			result = probe_tiles(rest);
 		} else if (parse_str(line, "probe all rgba ", &rest)) {
 			parse_floats(rest, c, 4, NULL);
 			if (result != PIGLIT_FAIL &&
@@ -6585,14 +8722,17 @@ piglit_display(void)
 			piglit_report_result(PIGLIT_FAIL);
 		}
 
-		free((void*) line);
+		if (cmd->probe_batch_end)
+			piglit_probe_batch_end();
+		if (cmd->buffer_probe_end)
+			forget_probed_buffer();
+
+		profile_command_end(cmd, start);
 
 		if (result != PIGLIT_PASS) {
-			printf("Test failure on line %u\n", line_num);
+			printf("Test failure on line %u\n", cmd->line_num);
 			full_result = result;
 		}
-
-		line_num++;
 	}
 
 	if (!link_ok && !link_error_expected) {
@@ -6600,6 +8740,7 @@ piglit_display(void)
 	}
 
 	piglit_present_results();
+	report_profile();
 
 	if (piglit_automatic) {
 		unsigned i;
@@ -6613,6 +8754,8 @@ piglit_display(void)
 		for (i = 0; i < ARRAY_SIZE(texture_bindings); i++)
 			clear_texture_binding(i);
 
+		forget_uniform_locations();
+
 		if (prog != 0) {
 			glDeleteProgram(prog);
 			glUseProgram(0);
@@ -6623,6 +8766,8 @@ piglit_display(void)
 
 		if (pipeline != 0)
 			glDeleteProgramPipelines(1, &pipeline);
+
+		free_test_commands();
 	}
 
 	free(text);
@@ -6645,12 +8790,22 @@ static enum piglit_result
 init_test(const char *file)
 {
 	enum piglit_result result;
+	int64_t start = 0;
 
+	profile_step_begin(&start);
 	result = process_test_script(file);
 	if (result != PIGLIT_PASS)
 		return result;
 
+	compile_test_commands();
+	profile_step_end(PROFILE_PARSE, start);
+
+	/* Includes the compiles deferred to it. */
+	profile_step_begin(&start);
+	piglit_trace_begin("link");
 	result = link_and_use_shaders();
+	piglit_trace_end();
+	profile_step_end(PROFILE_LINK, start);
 	if (result != PIGLIT_PASS)
 		return result;
 
@@ -6662,6 +8817,7 @@ init_test(const char *file)
 		if (result != PIGLIT_PASS)
 			return result;
 
+		profile_step_begin(&start);
 		bind_vao_if_supported();
 
 		num_vbo_rows = setup_vbo_from_text(sso_in_use ? sso_vertex_prog : prog,
@@ -6670,6 +8826,7 @@ init_test(const char *file)
 
 		if (num_elements > 0)
 			setup_elements_buffer();
+		profile_step_end(PROFILE_VERTEX_DATA, start);
 	}
 	setup_ubos();
 	return PIGLIT_PASS;
@@ -6692,6 +8849,9 @@ recreate_gl_context(char *exec_arg, int param_argc, char **param_argv)
 	argv[argc-2] = "-fbo";
 	argv[argc-1] = "-report-subtests";
 
+	forget_shader_cache();
+	forget_verify_programs();
+
 	if (gl_fw->destroy)
 		gl_fw->destroy(gl_fw);
 	gl_fw = NULL;
@@ -6734,6 +8894,271 @@ validate_current_gl_context(const char *filename)
 	return true;
 }
 
+/**
+ * Reset the global state left over by the previous test and run
+ * \p filename in the current GL context.
+ *
+ * This is used whenever more than one test is run by the same process.
+ * The name used to report the test is written to \p testname, which must
+ * be able to hold at least 4096 characters.
+ */
+static enum piglit_result
+run_test_file(const char *filename, const float *default_piglit_tolerance,
+	      bool es, char *testname)
+{
+	enum piglit_result result;
+	const char *hit;
+	const char *entry_text, *entry_name;
+	size_t entry_length;
+	char *ext;
+	int j;
+
+	memcpy(piglit_tolerance, default_piglit_tolerance,
+	       sizeof(piglit_tolerance));
+
+	/* Drop what the previous test allocated from the file arena. */
+	free_test_commands();
+	free_subroutine_uniforms();
+	forget_uniform_locations();
+	memset(specializations, 0, sizeof(specializations));
+	elements_buffer = NULL;
+	elements_buffer_size = 0;
+	num_elements = 0;
+	memset(&tiles, 0, sizeof(tiles));
+	reset_file_arena();
+
+	/* Clear global variables to defaults. */
+	test_start = NULL;
+	assert(num_vertex_shaders == 0);
+	assert(num_tess_ctrl_shaders == 0);
+	assert(num_tess_eval_shaders == 0);
+	assert(num_geometry_shaders == 0);
+	assert(num_fragment_shaders == 0);
+	assert(num_compute_shaders == 0);
+	assert(num_uniform_blocks == 0);
+	assert(uniform_block_bos == NULL);
+	assert(uniform_block_indexes == NULL);
+	geometry_layout_input_type = GL_TRIANGLES;
+	geometry_layout_output_type = GL_TRIANGLE_STRIP;
+	geometry_layout_vertices_out = 0;
+	memset(atomics_bos, 0, sizeof(atomics_bos));
+	memset(ssbo, 0, sizeof(ssbo));
+	for (j = 0; j < ARRAY_SIZE(subuniform_locations); j++)
+		assert(subuniform_locations[j] == NULL);
+	memset(num_subuniform_locations, 0, sizeof(num_subuniform_locations));
+	shader_string = NULL;
+	shader_string_size = 0;
+	vertex_data_start = NULL;
+	vertex_data_end = NULL;
+	prog = 0;
+	shaders_deferred = false;
+	sso_vertex_prog = 0;
+	sso_tess_control_prog = 0;
+	sso_tess_eval_prog = 0;
+	sso_geometry_prog = 0;
+	sso_fragment_prog = 0;
+	sso_compute_prog = 0;
+	num_vbo_rows = 0;
+	vbo_present = false;
+	link_ok = false;
+	prog_in_use = false;
+	sso_in_use = false;
+	separable_program = false;
+	prog_err_info = NULL;
+	vao = 0;
+
+	/* Clear GL states to defaults. */
+	glClearColor(0, 0, 0, 0);
+# if PIGLIT_USE_OPENGL
+	glClearDepth(1);
+# else
+	glClearDepthf(1.0);
+# endif
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram(0);
+	glDisable(GL_DEPTH_TEST);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (!es)
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	for (int k = 0; k < gl_max_clip_planes; k++) {
+		static const GLdouble zero[4];
+
+		if (!piglit_is_core_profile && !es)
+			glClipPlane(GL_CLIP_PLANE0 + k, zero);
+		glDisable(GL_CLIP_PLANE0 + k);
+	}
+
+	if (!(es) && (gl_version.num >= 20 ||
+	     piglit_is_extension_supported("GL_ARB_vertex_program")))
+		glDisable(GL_PROGRAM_POINT_SIZE);
+
+	for (int i = 0; i < 16; i++)
+		glDisableVertexAttribArray(i);
+
+	if (!piglit_is_core_profile && !es) {
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		glShadeModel(GL_SMOOTH);
+		glDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
+	}
+
+	if (piglit_is_extension_supported("GL_ARB_vertex_program")) {
+		glDisable(GL_VERTEX_PROGRAM_ARB);
+		glBindProgramARB(GL_VERTEX_PROGRAM_ARB, 0);
+	}
+	if (piglit_is_extension_supported("GL_ARB_fragment_program")) {
+		glDisable(GL_FRAGMENT_PROGRAM_ARB);
+		glBindProgramARB(GL_FRAGMENT_PROGRAM_ARB, 0);
+	}
+	if (piglit_is_extension_supported("GL_ARB_separate_shader_objects")) {
+		if (!pipeline)
+			glGenProgramPipelines(1, &pipeline);
+		glBindProgramPipeline(0);
+	}
+
+	if (piglit_is_extension_supported("GL_EXT_provoking_vertex"))
+		glProvokingVertexEXT(GL_LAST_VERTEX_CONVENTION_EXT);
+
+# if PIGLIT_USE_OPENGL
+	if (gl_version.num >= 40 ||
+	    piglit_is_extension_supported("GL_ARB_tessellation_shader")) {
+		static float ones[] = {1, 1, 1, 1};
+		glPatchParameteri(GL_PATCH_VERTICES, 3);
+		glPatchParameterfv(GL_PATCH_DEFAULT_OUTER_LEVEL, ones);
+		glPatchParameterfv(GL_PATCH_DEFAULT_INNER_LEVEL, ones);
+	}
+# else
+	/* Ideally one would use the following code:
+	 *
+	 * if (gl_version.num >= 32) {
+	 *         glPatchParameteri(GL_PATCH_VERTICES, 3);
+	 * }
+	 *
+	 * however, that doesn't work with mesa because those
+	 * symbols apparently need to be exported, but that
+	 * breaks non-gles builds.
+	 *
+	 * It seems rather unlikely that an implementation
+	 * would have GLES 3.2 support but not
+	 * OES_tessellation_shader.
+	 */
+	if (piglit_is_extension_supported("GL_OES_tessellation_shader")) {
+		glPatchParameteriOES(GL_PATCH_VERTICES_OES, 3);
+	}
+# endif
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	/* Strip the file path. */
+	hit = strrchr(filename, PIGLIT_PATH_SEP);
+	if (hit)
+		strcpy(testname, hit+1);
+	else
+		strcpy(testname, filename);
+
+	/* Strip the file extension. */
+	ext = strstr(testname, ".shader_test");
+	if (ext && !ext[12])
+		*ext = 0;
+
+	/* A test of a bundle is named by the bundle. */
+	if (find_bundle_entry(filename, &entry_text, &entry_length,
+			      &entry_name))
+		strcpy(testname, entry_name);
+
+	/* Print the name before we start the test, that way if
+	 * the test fails we can still resume and know which
+	 * test failed */
+	printf("PIGLIT TEST: %i - %s\n", test_num, testname);
+	fprintf(stderr, "PIGLIT TEST: %i - %s\n", test_num, testname);
+	test_num++;
+	metric_prefix = testname;
+
+	/* Run the test. */
+	result = init_test(filename);
+
+	if (result == PIGLIT_PASS) {
+		piglit_trace_begin("piglit_display");
+		result = piglit_display();
+		piglit_trace_end();
+	}
+
+	/* destroy GL objects? */
+	teardown_ubos();
+	teardown_atomics();
+	teardown_fbos();
+	teardown_shader_include_paths();
+	teardown_xfb();
+	teardown_profile();
+
+	return result;
+}
+
+/**
+ * Run tests whose paths are read from stdin, one per line, until EOF.
+ *
+ * The GL context is kept for as long as the requirements of the incoming
+ * tests allow it; when a test needs a different one the process is
+ * re-initialized with that test as the first file, and keeps reading stdin
+ * afterwards.  A subtest result line is flushed after every test so that
+ * the caller can feed the next path as soon as the previous one is done.
+ */
+static void
+run_test_server(char *exec_arg, char *first_file,
+		const float *default_piglit_tolerance, bool es)
+{
+	char filename[4096], testname[4096];
+	char *next_file = first_file;
+	enum piglit_result result;
+
+	for (;;) {
+		if (next_file == NULL) {
+			if (fgets(filename, sizeof(filename), stdin) == NULL)
+				break;
+
+			filename[strcspn(filename, "\r\n")] = '\0';
+			if (filename[0] == '\0')
+				continue;
+
+			/* The context was created for first_file, so only
+			 * the tests read from stdin need to be checked.
+			 */
+			if (!validate_current_gl_context(filename)) {
+				char *args[8];
+				int num_args = 0;
+
+				args[num_args++] = filename;
+				args[num_args++] = "-server";
+				if (force_glsl)
+					args[num_args++] = "-glsl";
+				if (spirv_replaces_glsl)
+					args[num_args++] = "-spirv";
+				if (ignore_missing_uniforms)
+					args[num_args++] = "-ignore-missing-uniforms";
+				if (use_get_program_binary)
+					args[num_args++] = "-get-program-binary";
+				if (profile_mode)
+					args[num_args++] = "-profile";
+
+				recreate_gl_context(exec_arg, num_args, args);
+			}
+
+			next_file = filename;
+		}
+
+		result = run_test_file(next_file, default_piglit_tolerance,
+				       es, testname);
+		piglit_report_subtest_result(result, "%s", testname);
+		next_file = NULL;
+	}
+
+	exit(0);
+}
+
 void
 piglit_init(int argc, char **argv)
 {
@@ -6755,6 +9180,9 @@ piglit_init(int argc, char **argv)
 
 	force_no_names = piglit_strip_arg(&argc, argv, "-force-no-names");
 	spirv_replaces_glsl = piglit_strip_arg(&argc, argv, "-spirv");
+	server_mode = piglit_strip_arg(&argc, argv, "-server");
+	profile_mode = piglit_strip_arg(&argc, argv, "-profile") ||
+		piglit_env_var_as_boolean("SHADER_RUNNER_PROFILE", false);
 
 	if (force_glsl && spirv_replaces_glsl) {
 		printf("Options -glsl and -spirv can't be used at the same time\n");
@@ -6764,10 +9192,11 @@ piglit_init(int argc, char **argv)
 	if (spirv_replaces_glsl)
 		force_no_names = true;
 
-	if (argc < 2) {
+	if (argc < 2 && !server_mode) {
 		printf("usage: shader_runner <test.shader_test> [-auto] [-fbo] [-png]"
 		"[-rlimit <AS-limit>] [-samples=<N>] [-khr_no_error] [-compat] [-report-subtests]"
-		"[-glsl] [-ignore-missing-uniforms] [-force-no-names] [-spirv]\n");
+		"[-glsl] [-ignore-missing-uniforms] [-force-no-names] [-spirv] [-profile]\n"
+		"       shader_runner -server [<first.shader_test>] [options]\n");
 		exit(1);
 	}
 
@@ -6838,6 +9267,28 @@ piglit_init(int argc, char **argv)
 		              &gl_num_program_binary_formats);
 #endif
 
+	/* The program cache is opt-in and silently disabled when binaries
+	 * can't be retrieved.
+	 */
+	program_cache_dir = getenv("SHADER_RUNNER_PROGRAM_CACHE_DIR");
+	if (program_cache_dir != NULL &&
+	    (program_cache_dir[0] == '\0' || gl_num_program_binary_formats == 0))
+		program_cache_dir = NULL;
+
+	if (piglit_is_extension_supported("GL_KHR_parallel_shader_compile") ||
+	    piglit_is_extension_supported("GL_ARB_parallel_shader_compile")) {
+		/* Let the driver pick the number of threads. */
+		glMaxShaderCompilerThreadsKHR(0xffffffff);
+		parallel_shader_compile = true;
+	}
+
+#ifdef PIGLIT_USE_OPENGL
+	timer_query_supported =
+		gl_version.num >= 33 ||
+		piglit_is_extension_supported("GL_ARB_timer_query");
+#endif
+	profile_gpu = profile_mode && timer_query_supported;
+
 	if (use_get_program_binary) {
 		if (gl_num_program_binary_formats == 0) {
 			printf("Trying to use get_program_binary, but "
@@ -6846,178 +9297,29 @@ piglit_init(int argc, char **argv)
 		}
 	}
 
+	if (server_mode || argc > 2)
+		use_shader_cache = true;
+
+	if (server_mode)
+		run_test_server(argv[0], argc > 1 ? argv[1] : NULL,
+				default_piglit_tolerance, es);
+
 	/* Run multiple tests per session. */
 	if (argc > 2) {
-		char testname[4096], *ext;
-		int i, j;
+		char testname[4096];
+		int i;
 		enum piglit_result all = PIGLIT_PASS;
 
 		for (i = 1; i < argc; i++) {
-			const char *hit, *filename = argv[i];
-
-			memcpy(piglit_tolerance, default_piglit_tolerance,
-			       sizeof(piglit_tolerance));
-
-			for (unsigned i = 0; i < ARRAY_SIZE(specializations); i++) {
-				free(specializations[i].indices);
-				free(specializations[i].values);
-			}
-			memset(specializations, 0, sizeof(specializations));
+			const char *filename = argv[i];
 
 			/* Re-initialize the GL context if a different GL config is required. */
 			if (!validate_current_gl_context(filename))
 				recreate_gl_context(argv[0], argc - i, argv + i);
 
-			/* Clear global variables to defaults. */
-			test_start = NULL;
-			assert(num_vertex_shaders == 0);
-			assert(num_tess_ctrl_shaders == 0);
-			assert(num_tess_eval_shaders == 0);
-			assert(num_geometry_shaders == 0);
-			assert(num_fragment_shaders == 0);
-			assert(num_compute_shaders == 0);
-			assert(num_uniform_blocks == 0);
-			assert(uniform_block_bos == NULL);
-			assert(uniform_block_indexes == NULL);
-			geometry_layout_input_type = GL_TRIANGLES;
-			geometry_layout_output_type = GL_TRIANGLE_STRIP;
-			geometry_layout_vertices_out = 0;
-			memset(atomics_bos, 0, sizeof(atomics_bos));
-			memset(ssbo, 0, sizeof(ssbo));
-			for (j = 0; j < ARRAY_SIZE(subuniform_locations); j++)
-				assert(subuniform_locations[j] == NULL);
-			memset(num_subuniform_locations, 0, sizeof(num_subuniform_locations));
-			shader_string = NULL;
-			shader_string_size = 0;
-			vertex_data_start = NULL;
-			vertex_data_end = NULL;
-			prog = 0;
-			sso_vertex_prog = 0;
-			sso_tess_control_prog = 0;
-			sso_tess_eval_prog = 0;
-			sso_geometry_prog = 0;
-			sso_fragment_prog = 0;
-			sso_compute_prog = 0;
-			num_vbo_rows = 0;
-			vbo_present = false;
-			link_ok = false;
-			prog_in_use = false;
-			sso_in_use = false;
-			separable_program = false;
-			prog_err_info = NULL;
-			vao = 0;
-
-			/* Clear GL states to defaults. */
-			glClearColor(0, 0, 0, 0);
-# if PIGLIT_USE_OPENGL
-			glClearDepth(1);
-# else
-			glClearDepthf(1.0);
-# endif
-			glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
-			glActiveTexture(GL_TEXTURE0);
-			glUseProgram(0);
-			glDisable(GL_DEPTH_TEST);
-			glBindBuffer(GL_ARRAY_BUFFER, 0);
-			if (!es)
-				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-			for (int k = 0; k < gl_max_clip_planes; k++) {
-				static const GLdouble zero[4];
-
-				if (!piglit_is_core_profile && !es)
-					glClipPlane(GL_CLIP_PLANE0 + k, zero);
-				glDisable(GL_CLIP_PLANE0 + k);
-			}
-
-			if (!(es) && (gl_version.num >= 20 ||
-			     piglit_is_extension_supported("GL_ARB_vertex_program")))
-				glDisable(GL_PROGRAM_POINT_SIZE);
-
-			for (int i = 0; i < 16; i++)
-				glDisableVertexAttribArray(i);
-
-			if (!piglit_is_core_profile && !es) {
-				glMatrixMode(GL_PROJECTION);
-				glLoadIdentity();
-				glMatrixMode(GL_MODELVIEW);
-				glLoadIdentity();
-				glShadeModel(GL_SMOOTH);
-				glDisable(GL_VERTEX_PROGRAM_TWO_SIDE);
-			}
-
-			if (piglit_is_extension_supported("GL_ARB_vertex_program")) {
-				glDisable(GL_VERTEX_PROGRAM_ARB);
-				glBindProgramARB(GL_VERTEX_PROGRAM_ARB, 0);
-			}
-			if (piglit_is_extension_supported("GL_ARB_fragment_program")) {
-				glDisable(GL_FRAGMENT_PROGRAM_ARB);
-				glBindProgramARB(GL_FRAGMENT_PROGRAM_ARB, 0);
-			}
-			if (piglit_is_extension_supported("GL_ARB_separate_shader_objects")) {
-				if (!pipeline)
-					glGenProgramPipelines(1, &pipeline);
-				glBindProgramPipeline(0);
-			}
-
-			if (piglit_is_extension_supported("GL_EXT_provoking_vertex"))
-				glProvokingVertexEXT(GL_LAST_VERTEX_CONVENTION_EXT);
-
-# if PIGLIT_USE_OPENGL
-			if (gl_version.num >= 40 ||
-			    piglit_is_extension_supported("GL_ARB_tessellation_shader")) {
-				static float ones[] = {1, 1, 1, 1};
-				glPatchParameteri(GL_PATCH_VERTICES, 3);
-				glPatchParameterfv(GL_PATCH_DEFAULT_OUTER_LEVEL, ones);
-				glPatchParameterfv(GL_PATCH_DEFAULT_INNER_LEVEL, ones);
-			}
-# else
-			/* Ideally one would use the following code:
-			 *
-			 * if (gl_version.num >= 32) {
-			 *         glPatchParameteri(GL_PATCH_VERTICES, 3);
-			 * }
-			 *
-			 * however, that doesn't work with mesa because those
-			 * symbols apparently need to be exported, but that
-			 * breaks non-gles builds.
-			 *
-			 * It seems rather unlikely that an implementation
-			 * would have GLES 3.2 support but not
-			 * OES_tessellation_shader.
-			 */
-			if (piglit_is_extension_supported("GL_OES_tessellation_shader")) {
-				glPatchParameteriOES(GL_PATCH_VERTICES_OES, 3);
-			}
-# endif
-
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-			/* Strip the file path. */
-			hit = strrchr(filename, PIGLIT_PATH_SEP);
-			if (hit)
-				strcpy(testname, hit+1);
-			else
-				strcpy(testname, filename);
-
-			/* Strip the file extension. */
-			ext = strstr(testname, ".shader_test");
-			if (ext && !ext[12])
-				*ext = 0;
+			result = run_test_file(filename, default_piglit_tolerance,
+					       es, testname);
 
-			/* Print the name before we start the test, that way if
-			 * the test fails we can still resume and know which
-			 * test failed */
-			printf("PIGLIT TEST: %i - %s\n", test_num, testname);
-			fprintf(stderr, "PIGLIT TEST: %i - %s\n", test_num, testname);
-			test_num++;
-
-			/* Run the test. */
-			result = init_test(filename);
-
-			if (result == PIGLIT_PASS) {
-				result = piglit_display();
-			}
 			/* Use subtest when running with more than one test,
 			 * but use regular test result when running with just
 			 * one.  This allows the standard process-at-a-time
@@ -7029,13 +9331,6 @@ piglit_init(int argc, char **argv)
 			} else {
 				piglit_merge_result(&all, result);
 			}
-
-			/* destroy GL objects? */
-			teardown_ubos();
-			teardown_atomics();
-			teardown_fbos();
-			teardown_shader_include_paths();
-			teardown_xfb();
 		}
 		if (!report_subtests)
 			piglit_report_result(all);
@@ -28,6 +28,7 @@
  */
 
 #include "common.h"
+#include <inttypes.h>
 
 char *
 concat(char *hunk0, ...)
@@ -246,6 +247,211 @@ get_stage_idx(const struct image_stage_info *stage)
         return ffs(stage->bit) - 1;
 }
 
+/*
+ * Program binary cache.
+ *
+ * The tests in this directory build the same handful of programs for
+ * every format, target and stage they cover, and many of them are run
+ * as separate binaries.  When PIGLIT_GL_PROGRAM_CACHE names an existing
+ * directory the linked programs are stored there and later requests
+ * for the same program, in any process, load the binary instead of
+ * compiling and linking the sources again.
+ *
+ * A cache file holds the magic, the length of the key, the key, the
+ * binary format and the binary.  The key is made of the strings
+ * identifying the driver followed by the stage and source of every
+ * shader, and is compared in full when loading.
+ */
+
+#define PROGRAM_CACHE_MAGIC "PGLB"
+
+static const char *
+program_cache_dir(void)
+{
+        static const char *dir;
+        static bool initialized;
+
+        if (!initialized) {
+                GLint num_formats = 0;
+
+                initialized = true;
+                dir = getenv("PIGLIT_GL_PROGRAM_CACHE");
+
+                if (dir && dir[0] &&
+                    (piglit_get_gl_version() >= 41 ||
+                     piglit_is_extension_supported(
+                             "GL_ARB_get_program_binary")))
+                        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS,
+                                      &num_formats);
+
+                if (num_formats <= 0)
+                        dir = NULL;
+        }
+
+        return dir;
+}
+
+static char *
+program_cache_key(char **sources, size_t *length)
+{
+        const char *strings[] = {
+                (const char *)glGetString(GL_VENDOR),
+                (const char *)glGetString(GL_RENDERER),
+                (const char *)glGetString(GL_VERSION)
+        };
+        char *key = hunk("");
+        unsigned i;
+
+        for (i = 0; i < ARRAY_SIZE(strings); ++i)
+                key = concat(key, hunk(strings[i] ? strings[i] : ""), NULL);
+
+        for (i = 0; i < 6; ++i) {
+                if (sources[i]) {
+                        char *stage = NULL;
+
+                        (void)!asprintf(&stage, "stage %u", i);
+                        key = concat(key, stage, hunk(sources[i]), NULL);
+                }
+        }
+
+        *length = strlen(key);
+        return key;
+}
+
+static char *
+program_cache_path(const char *dir, const char *key, size_t length)
+{
+        /* 64-bit FNV-1a, the key itself is compared when loading. */
+        uint64_t hash = 0xcbf29ce484222325ull;
+        char *path;
+        size_t i;
+
+        for (i = 0; i < length; i++) {
+                hash ^= (unsigned char)key[i];
+                hash *= 0x100000001b3ull;
+        }
+
+        path = malloc(strlen(dir) + 32);
+        sprintf(path, "%s/%016" PRIx64 ".bin", dir, hash);
+        return path;
+}
+
+/**
+ * Try to load the program cached as \a path into \a prog.  Returns
+ * false if there is no usable entry.
+ */
+static bool
+program_cache_load(GLuint prog, const char *path,
+                   const char *key, size_t key_length)
+{
+        char magic[4];
+        uint64_t stored_key_length, length = 0;
+        uint32_t binary_format = 0;
+        char *stored_key = NULL;
+        void *binary = NULL;
+        GLint status = 0;
+        FILE *file;
+        bool valid;
+
+        file = fopen(path, "rb");
+        if (file == NULL)
+                return false;
+
+        valid = fread(magic, sizeof(magic), 1, file) == 1 &&
+                !memcmp(magic, PROGRAM_CACHE_MAGIC, sizeof(magic)) &&
+                fread(&stored_key_length, sizeof(stored_key_length),
+                      1, file) == 1 &&
+                stored_key_length == key_length;
+        if (valid) {
+                stored_key = malloc(key_length);
+                valid = fread(stored_key, 1, key_length, file) == key_length &&
+                        !memcmp(stored_key, key, key_length) &&
+                        fread(&binary_format, sizeof(binary_format),
+                              1, file) == 1 &&
+                        fread(&length, sizeof(length), 1, file) == 1 &&
+                        length > 0 && length <= INT32_MAX;
+        }
+        if (valid) {
+                binary = malloc(length);
+                valid = fread(binary, 1, length, file) == length;
+        }
+
+        fclose(file);
+        free(stored_key);
+
+        if (valid) {
+                glProgramBinary(prog, binary_format, binary, length);
+
+                /* The driver may reject a binary it produced itself,
+                 * for instance after an update that didn't change any
+                 * of the strings in the key.
+                 */
+                glGetProgramiv(prog, GL_LINK_STATUS, &status);
+                piglit_reset_gl_error();
+                valid = status;
+        }
+
+        free(binary);
+        return valid;
+}
+
+static void
+program_cache_store(GLuint prog, const char *path,
+                    const char *key, size_t key_length)
+{
+        const uint64_t stored_key_length = key_length;
+        GLint binary_length = 0;
+        GLenum binary_format;
+        uint32_t format;
+        uint64_t length;
+        char *tmp_path;
+        void *binary;
+        FILE *file;
+        bool ok;
+
+        glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+        if (binary_length <= 0) {
+                piglit_reset_gl_error();
+                return;
+        }
+
+        binary = malloc(binary_length);
+        glGetProgramBinary(prog, binary_length, &binary_length,
+                           &binary_format, binary);
+        if (!piglit_check_gl_error(GL_NO_ERROR)) {
+                free(binary);
+                return;
+        }
+
+        format = binary_format;
+        length = binary_length;
+
+        /* Write to a file of our own and rename it, so that
+         * concurrent tests never see a partial file.
+         */
+        tmp_path = malloc(strlen(path) + 32);
+        sprintf(tmp_path, "%s.%" PRIx64 ".tmp", path,
+                (uint64_t)piglit_time_get_nano());
+
+        file = fopen(tmp_path, "wb");
+        if (file != NULL) {
+                ok = fwrite(PROGRAM_CACHE_MAGIC, 4, 1, file) == 1 &&
+                     fwrite(&stored_key_length, sizeof(stored_key_length),
+                            1, file) == 1 &&
+                     fwrite(key, 1, key_length, file) == key_length &&
+                     fwrite(&format, sizeof(format), 1, file) == 1 &&
+                     fwrite(&length, sizeof(length), 1, file) == 1 &&
+                     fwrite(binary, 1, length, file) == length;
+                ok = fclose(file) == 0 && ok;
+
+                if (!ok || rename(tmp_path, path) != 0)
+                        remove(tmp_path);
+        }
+
+        free(tmp_path);
+        free(binary);
+}
+
 /**
  * Generate a full program pipeline using the shader code provided in
  * the \a sources array.
@@ -267,22 +473,42 @@ generate_program_v(const struct grid_info grid, const char **sources)
                  /* Make sure there is always a vertex and fragment
                   * shader if we're doing graphics. */
                  (grid.stages & graphic_stages ? basic_stages : 0));
+        const char *cache_dir = program_cache_dir();
+        char *stage_sources[6] = { NULL };
+        char *key = NULL, *path = NULL;
+        size_t key_length = 0;
         GLuint prog = glCreateProgram();
         const struct image_stage_info *stage;
+        unsigned i;
 
         for (stage = known_image_stages(); stage->stage; ++stage) {
                 if (stages & stage->bit) {
-                        char *source = generate_stage_source(
-                                grid, stage->stage,
-                                sources[get_stage_idx(stage)]);
-                        GLuint shader = piglit_compile_shader_text_nothrow(
-                                stage->stage, source, true);
+                        const unsigned idx = get_stage_idx(stage);
+
+                        assert(idx < ARRAY_SIZE(stage_sources));
+                        stage_sources[idx] = generate_stage_source(
+                                grid, stage->stage, sources[idx]);
+                }
+        }
+
+        if (cache_dir) {
+                key = program_cache_key(stage_sources, &key_length);
+                path = program_cache_path(cache_dir, key, key_length);
 
-                        free(source);
+                if (program_cache_load(prog, path, key, key_length))
+                        goto out;
+        }
+
+        for (stage = known_image_stages(); stage->stage; ++stage) {
+                if (stages & stage->bit) {
+                        GLuint shader = piglit_compile_shader_text_nothrow(
+                                stage->stage,
+                                stage_sources[get_stage_idx(stage)], true);
 
                         if (!shader) {
                                 glDeleteProgram(prog);
-                                return 0;
+                                prog = 0;
+                                goto out;
                         }
 
                         glAttachShader(prog, shader);
@@ -292,13 +518,28 @@ generate_program_v(const struct grid_info grid, const char **sources)
 
         glBindAttribLocation(prog, PIGLIT_ATTRIB_POS, "piglit_vertex");
         glBindAttribLocation(prog, PIGLIT_ATTRIB_TEX, "piglit_texcoord");
+
+        if (cache_dir)
+                glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                    GL_TRUE);
+
         glLinkProgram(prog);
 
         if (!piglit_link_check_status(prog)) {
                 glDeleteProgram(prog);
-                return 0;
+                prog = 0;
+                goto out;
         }
 
+        if (cache_dir)
+                program_cache_store(prog, path, key, key_length);
+
+out:
+        for (i = 0; i < ARRAY_SIZE(stage_sources); ++i)
+                free(stage_sources[i]);
+        free(key);
+        free(path);
+
         return prog;
 }
 
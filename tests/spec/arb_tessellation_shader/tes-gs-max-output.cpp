@@ -35,7 +35,8 @@
  * - number of output components per vertex
  *
  * Verification works by rendering points and writing to an SSBO from the
- * fragment shader.
+ * fragment shader. Test cases are drawn in batches that fill the SSBO, each
+ * at its own offset, so that each batch is read back once.
  */
 
 #include "piglit-util-gl.h"
@@ -267,14 +268,16 @@ static const char fs_text[] =
 	"  ivec2 data[];\n"
 	"} ssbo;\n"
 	"\n"
+	"uniform int u_base;\n"
+	"\n"
 	GEN_SEQUENCE
 	"\n"
 	"void main() {\n"
 	"  int id = gs_ps_data[0];\n"
 	"  int screen_id = int(gl_FragCoord.y) * " STR(WINDOW_SIZE) " + int(gl_FragCoord.x);\n"
 	"  if (screen_id != id %% (" STR(WINDOW_SIZE * WINDOW_SIZE) ")) {\n"
-	"    ssbo.data[id].x = 1000;\n"
-	"    ssbo.data[id].y = screen_id;\n"
+	"    ssbo.data[u_base + id].x = 1000;\n"
+	"    ssbo.data[u_base + id].y = screen_id;\n"
 	"    out_color = vec4(0.1, 0, 0, 1);\n"
 	"    return;\n"
 	"  }\n"
@@ -282,15 +285,15 @@ static const char fs_text[] =
 	"  int val = id;\n"
 	"  for (int j = 0; j <= NUM_EXTRA_COMPONENTS; ++j) {\n"
 	"    if (val != gs_ps_data[j]) {\n"
-	"      ssbo.data[id].x = 2000 + j;\n"
-	"      ssbo.data[id].y = gs_ps_data[j];\n"
+	"      ssbo.data[u_base + id].x = 2000 + j;\n"
+	"      ssbo.data[u_base + id].y = gs_ps_data[j];\n"
 	"      out_color = vec4(0, 0.1, 0, 1);\n"
 	"      return;\n"
 	"    }\n"
 	"    val = seq_next(val);\n"
 	"  }\n"
 	"\n"
-	"  ssbo.data[id].x = 1;\n"
+	"  ssbo.data[u_base + id].x = 1;\n"
 	"  out_color = vec4(0, 0, 0, 1);\n"
 	"}\n";
 
@@ -404,18 +407,22 @@ add_testcase(const struct testcase *tc)
 	testcases.push_back(*tc);
 }
 
-static bool
-run_testcase(const struct testcase *tc)
+static unsigned
+final_points(const struct testcase *tc)
 {
-	unsigned final_points = tc->num_instances * tc->num_patches * tc->tessfactor_u *
-				tc->tessfactor_v * tc->num_invocations * tc->num_outputs;
-	unsigned bufsize = 2 * sizeof(int32_t) * final_points;
+	return tc->num_instances * tc->num_patches * tc->tessfactor_u *
+	       tc->tessfactor_v * tc->num_invocations * tc->num_outputs;
+}
 
+/**
+ * Draw a test case, whose fragment shader writes its results from element
+ * base of the SSBO on.
+ */
+static void
+draw_testcase(const struct testcase *tc, unsigned base)
+{
 	print_testcase(tc);
 
-	glClearColor(0, 0, 0, 1);
-	glClear(GL_COLOR_BUFFER_BIT);
-
 	geometryshaderkey gskey;
 	gskey.num_invocations = tc->num_invocations;
 	gskey.num_outputs = tc->num_outputs;
@@ -425,14 +432,34 @@ run_testcase(const struct testcase *tc)
 	assert(progit != testprograms.end());
 
 	glUseProgram(progit->second);
-	glPatchParameteri(GL_PATCH_VERTICES, 1);
 	glUniform1i(glGetUniformLocation(progit->second, "u_tessfactor_u"),
 		    tc->tessfactor_u);
 	glUniform1i(glGetUniformLocation(progit->second, "u_tessfactor_v"),
 		    tc->tessfactor_v);
 	glUniform1i(glGetUniformLocation(progit->second, "u_verts_per_instance"),
 		    tc->num_patches);
+	glUniform1i(glGetUniformLocation(progit->second, "u_base"), base);
+
+	glDrawArraysInstanced(GL_PATCHES, 0, tc->num_patches, tc->num_instances);
+}
+
+/**
+ * Run the test cases [first, last), whose final points fit in the SSBO
+ * together.  The successful fragments of all of them add black, so the
+ * window is probed once and the SSBO read back once for the batch.
+ */
+static bool
+run_batch(unsigned first, unsigned last)
+{
+	unsigned total = 0;
+	for (unsigned i = first; i < last; ++i)
+		total += final_points(&testcases[i]);
+	unsigned bufsize = 2 * sizeof(int32_t) * total;
+
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
 
+	glPatchParameteri(GL_PATCH_VERTICES, 1);
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssbo);
 
 	memset(buffer_copy, 0, bufsize);
@@ -441,7 +468,11 @@ run_testcase(const struct testcase *tc)
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_ONE, GL_ONE);
 
-	glDrawArraysInstanced(GL_PATCHES, 0, tc->num_patches, tc->num_instances);
+	unsigned base = 0;
+	for (unsigned i = first; i < last; ++i) {
+		draw_testcase(&testcases[i], base);
+		base += final_points(&testcases[i]);
+	}
 
 	glDisable(GL_BLEND);
 
@@ -456,12 +487,25 @@ run_testcase(const struct testcase *tc)
 
 	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bufsize, buffer_copy);
 
-	for (unsigned i = 0; i < final_points; ++i) {
-		if (buffer_copy[2 * i] != 1) {
-			printf("Error @ %d: %d %d\n", i,
-			       buffer_copy[2 * i], buffer_copy[2 * i + 1]);
+	base = 0;
+	for (unsigned i = first; i < last; ++i) {
+		unsigned points = final_points(&testcases[i]);
+		bool case_ok = true;
+
+		for (unsigned j = 0; j < points; ++j) {
+			const int32_t *data = &buffer_copy[2 * (base + j)];
+
+			if (data[0] != 1) {
+				printf("Error @ %d: %d %d\n", j, data[0], data[1]);
+				case_ok = false;
+			}
+		}
+		if (!case_ok) {
+			printf("Failed ");
+			print_testcase(&testcases[i]);
 			ok = false;
 		}
+		base += points;
 	}
 
 	return ok;
@@ -825,10 +869,21 @@ piglit_display(void)
 {
 	bool pass = true;
 
+	unsigned first = 0;
+	unsigned points = 0;
 	for (unsigned i = 0; i < testcases.size(); ++i) {
-		if (!run_testcase(&testcases[i]))
-			pass = false;
+		unsigned tc_points = final_points(&testcases[i]);
+
+		if (points + tc_points > max_final_points) {
+			if (!run_batch(first, i))
+				pass = false;
+			first = i;
+			points = 0;
+		}
+		points += tc_points;
 	}
+	if (first < testcases.size() && !run_batch(first, testcases.size()))
+		pass = false;
 
 	if (!piglit_check_gl_error(GL_NO_ERROR))
 		pass = false;
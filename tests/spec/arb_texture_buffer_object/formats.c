@@ -455,9 +455,8 @@ test_format(int format_index)
 
 	case GL_HALF_FLOAT: {
 		unsigned short hf_data[ARRAY_SIZE(float_data)];
-		for (i = 0; i < ARRAY_SIZE(float_data); i++) {
-			hf_data[i] = piglit_half_from_float(float_data[i]);
-		}
+		piglit_half_from_float_array(hf_data, float_data,
+					     ARRAY_SIZE(float_data));
 		glBufferData(GL_TEXTURE_BUFFER, sizeof(hf_data), hf_data,
 			     GL_STATIC_READ);
 		data_components = ARRAY_SIZE(float_data);
@@ -1375,36 +1375,106 @@ create_view(const struct format_info *view_format, GLuint tex)
 	return view;
 }
 
-static GLuint
-create_program(const struct format_info *view_format)
+/*
+ * The sampling programs only depend on the view format, and many format
+ * pairs share a view format, so each is only built once.
+ */
+static struct {
+	const char **fs;
+	GLuint prog;
+} programs[64];
+static unsigned num_programs;
+
+static void
+use_program(const struct format_info *view_format)
 {
-	GLuint prog = piglit_build_simple_program(vs, *view_format->fs);
+	GLuint prog;
+	unsigned i;
+
+	for (i = 0; i < num_programs; i++) {
+		if (programs[i].fs == view_format->fs) {
+			glUseProgram(programs[i].prog);
+			return;
+		}
+	}
 
+	prog = piglit_build_simple_program(vs, *view_format->fs);
 	glUseProgram(prog);
 	glUniform1i(glGetUniformLocation(prog, "s"), 0);
-	return prog;
+
+	assert(num_programs < ARRAY_SIZE(programs));
+	programs[num_programs].fs = view_format->fs;
+	programs[num_programs].prog = prog;
+	num_programs++;
 }
 
+/*
+ * Each sampling test draws its result to a pixel of its own, and the
+ * pixels are all checked with one readback when the window is full or
+ * the tests are done.
+ */
+static char (*pending_names)[128];
+static unsigned num_pending, max_pending;
+
 static void
-test_by_sampling(const char *test_name,
-		 const struct format_info *vformat,
-		 enum piglit_result *all)
+check_pending_results(enum piglit_result *all)
 {
-	GLuint prog;
-	bool pass;
-	enum piglit_result one_result;
+	const unsigned rows = (num_pending + piglit_width - 1) / piglit_width;
+	unsigned i;
 
-	prog = create_program(vformat);
+	if (num_pending == 0)
+		return;
 
-	/* Draw only one pixel. We don't need more. */
-	piglit_draw_rect(-1, -1, 2.0/TEX_SIZE, 2.0/TEX_SIZE);
-	pass = piglit_probe_pixel_rgba_silent(0, 0, green, NULL);
+	piglit_probe_batch_begin(0, 0, piglit_width, rows);
+	for (i = 0; i < num_pending; i++) {
+		bool pass = piglit_probe_pixel_rgba_silent(i % piglit_width,
+							   i / piglit_width,
+							   green, NULL);
+		enum piglit_result one_result = pass ? PIGLIT_PASS : PIGLIT_FAIL;
 
-	one_result = pass ? PIGLIT_PASS : PIGLIT_FAIL;
-	piglit_report_subtest_result(one_result, "%s", test_name);
-	piglit_merge_result(all, one_result);
+		piglit_report_subtest_result(one_result, "%s",
+					     pending_names[i]);
+		piglit_merge_result(all, one_result);
+	}
+	piglit_probe_batch_end();
 
-	glDeleteProgram(prog);
+	num_pending = 0;
+}
+
+/* Draw the result of the test with the current program to its pixel. */
+static void
+draw_result(const char *test_name, enum piglit_result *all)
+{
+	unsigned x, y;
+
+	if (num_pending == (unsigned) (piglit_width * piglit_height))
+		check_pending_results(all);
+
+	if (num_pending == max_pending) {
+		max_pending = MAX2(2 * max_pending, 256);
+		pending_names = realloc(pending_names,
+					max_pending * sizeof(*pending_names));
+	}
+
+	x = num_pending % piglit_width;
+	y = num_pending / piglit_width;
+	snprintf(pending_names[num_pending], sizeof(pending_names[0]), "%s",
+		 test_name);
+	num_pending++;
+
+	/* Draw only one pixel. We don't need more. */
+	piglit_draw_rect(-1 + 2.0 * x / piglit_width,
+			 -1 + 2.0 * y / piglit_height,
+			 2.0 / piglit_width, 2.0 / piglit_height);
+}
+
+static void
+test_by_sampling(const char *test_name,
+		 const struct format_info *vformat,
+		 enum piglit_result *all)
+{
+	use_program(vformat);
+	draw_result(test_name, all);
 }
 
 static bool
@@ -1931,19 +2001,9 @@ test_clear_by_sampling(const char *test_name,
 		       enum piglit_result *all)
 {
 	GLuint prog;
-	bool pass;
-	enum piglit_result one_result;
 
 	prog = create_test_clear_program(base, vformat);
-
-	/* Draw only one pixel. We don't need more. */
-	piglit_draw_rect(-1, -1, 2.0/TEX_SIZE, 2.0/TEX_SIZE);
-	pass = piglit_probe_pixel_rgba_silent(0, 0, green, NULL);
-
-	one_result = pass ? PIGLIT_PASS : PIGLIT_FAIL;
-	piglit_report_subtest_result(one_result, "%s", test_name);
-	piglit_merge_result(all, one_result);
-
+	draw_result(test_name, all);
 	glDeleteProgram(prog);
 }
 
@@ -2162,6 +2222,8 @@ piglit_display(void)
 		}
 	}
 
+	check_pending_results(&result);
+
 	piglit_report_result(result);
 	return PIGLIT_FAIL; /* unreachable */
 }
@@ -50,7 +50,15 @@ gl_create_mem_obj_from_vk_mem(struct vk_ctx *ctx,
 	int fd;
 	GLint dedicated = vk_mem_obj->dedicated ? GL_TRUE : GL_FALSE;
 
-	PFN_vkGetMemoryFdKHR _vkGetMemoryFdKHR =
+	PFN_vkGetMemoryFdKHR _vkGetMemoryFdKHR;
+
+	/* The memory of a pool is imported once for all its objects. */
+	if (vk_mem_obj->pool && vk_mem_obj->pool->gl_mem_obj) {
+		*gl_mem_obj = vk_mem_obj->pool->gl_mem_obj;
+		return true;
+	}
+
+	_vkGetMemoryFdKHR =
 		(PFN_vkGetMemoryFdKHR)vkGetDeviceProcAddr(ctx->dev,
 				"vkGetMemoryFdKHR");
 
@@ -76,7 +84,13 @@ gl_create_mem_obj_from_vk_mem(struct vk_ctx *ctx,
 	if (!glIsMemoryObjectEXT(*gl_mem_obj))
 		return false;
 
-	return glGetError() == GL_NO_ERROR;
+	if (glGetError() != GL_NO_ERROR)
+		return false;
+
+	if (vk_mem_obj->pool)
+		vk_mem_obj->pool->gl_mem_obj = *gl_mem_obj;
+
+	return true;
 }
 
 bool
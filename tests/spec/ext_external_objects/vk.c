@@ -26,6 +26,10 @@
  *    Topi Pohjolainen <topi.pohjolainen@intel.com>
  */
 
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
 #include "vk.h"
 
 #ifndef VK_NULL_HANDLE
@@ -255,6 +259,171 @@ fill_uuid(VkPhysicalDevice pdev, uint8_t *deviceUUID, uint8_t *driverUUID)
 	memcpy(driverUUID, devProp.driverUUID, VK_UUID_SIZE);
 }
 
+/* Pipeline cache files are named after the device and driver UUIDs, next
+ * to a lock file that serializes the processes saving them. */
+static char *
+get_pipeline_cache_path(struct vk_ctx *ctx, const char *dir)
+{
+	char *path = malloc(strlen(dir) + 4 * VK_UUID_SIZE + 8);
+	char *p = path + sprintf(path, "%s/", dir);
+	int i;
+
+	for (i = 0; i < VK_UUID_SIZE; i++)
+		p += sprintf(p, "%02x", ctx->deviceUUID[i]);
+	p += sprintf(p, "-");
+	for (i = 0; i < VK_UUID_SIZE; i++)
+		p += sprintf(p, "%02x", ctx->driverUUID[i]);
+	sprintf(p, ".bin");
+
+	return path;
+}
+
+static int
+lock_pipeline_cache(const char *path, int operation)
+{
+	char *lock_path = NULL;
+	int fd;
+
+	(void)!asprintf(&lock_path, "%s.lock", path);
+	fd = open(lock_path, O_RDWR | O_CREAT, 0666);
+	free(lock_path);
+
+	if (fd >= 0 && flock(fd, operation) != 0) {
+		close(fd);
+		fd = -1;
+	}
+
+	return fd;
+}
+
+static void *
+read_pipeline_cache_file(const char *path, size_t *size)
+{
+	void *data = NULL;
+	FILE *file;
+	long length;
+
+	*size = 0;
+	file = fopen(path, "rb");
+	if (file == NULL)
+		return NULL;
+
+	if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) > 0 &&
+	    fseek(file, 0, SEEK_SET) == 0) {
+		data = malloc(length);
+		if (fread(data, 1, length, file) == (size_t)length) {
+			*size = length;
+		} else {
+			free(data);
+			data = NULL;
+		}
+	}
+
+	fclose(file);
+	return data;
+}
+
+static void
+write_pipeline_cache_file(const char *path, const void *data, size_t size)
+{
+	char *tmp_path = NULL;
+	FILE *file;
+	bool ok;
+
+	/* Readers don't take the lock, so they must never see a partial
+	 * file. */
+	(void)!asprintf(&tmp_path, "%s.tmp", path);
+	file = fopen(tmp_path, "wb");
+	if (file != NULL) {
+		ok = fwrite(data, 1, size, file) == size;
+		ok = fclose(file) == 0 && ok;
+
+		if (!ok || rename(tmp_path, path) != 0)
+			remove(tmp_path);
+	}
+	free(tmp_path);
+}
+
+static void
+create_pipeline_cache(struct vk_ctx *ctx)
+{
+	const char *dir = getenv("PIGLIT_VK_PIPELINE_CACHE");
+	VkPipelineCacheCreateInfo cache_info;
+	size_t size;
+	void *data;
+
+	if (!dir || !dir[0])
+		return;
+
+	ctx->pipeline_cache_path = get_pipeline_cache_path(ctx, dir);
+	data = read_pipeline_cache_file(ctx->pipeline_cache_path, &size);
+
+	/* The driver checks the header of the data and ignores data
+	 * that was made by another device or driver version. */
+	memset(&cache_info, 0, sizeof cache_info);
+	cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cache_info.initialDataSize = size;
+	cache_info.pInitialData = data;
+
+	if (vkCreatePipelineCache(ctx->dev, &cache_info, 0,
+				  &ctx->pipeline_cache) != VK_SUCCESS) {
+		cache_info.initialDataSize = 0;
+		cache_info.pInitialData = NULL;
+		if (vkCreatePipelineCache(ctx->dev, &cache_info, 0,
+					  &ctx->pipeline_cache) != VK_SUCCESS)
+			ctx->pipeline_cache = VK_NULL_HANDLE;
+	}
+
+	free(data);
+}
+
+static void
+save_pipeline_cache(struct vk_ctx *ctx)
+{
+	VkPipelineCacheCreateInfo cache_info;
+	VkPipelineCache disk_cache;
+	void *disk_data, *data;
+	size_t disk_size, size = 0;
+	int lock;
+
+	lock = lock_pipeline_cache(ctx->pipeline_cache_path, LOCK_EX);
+	if (lock < 0)
+		return;
+
+	/* Keep the pipelines other processes saved since we loaded the
+	 * file. */
+	disk_data = read_pipeline_cache_file(ctx->pipeline_cache_path,
+					     &disk_size);
+	if (disk_data) {
+		memset(&cache_info, 0, sizeof cache_info);
+		cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cache_info.initialDataSize = disk_size;
+		cache_info.pInitialData = disk_data;
+
+		if (vkCreatePipelineCache(ctx->dev, &cache_info, 0,
+					  &disk_cache) == VK_SUCCESS) {
+			vkMergePipelineCaches(ctx->dev, ctx->pipeline_cache,
+					      1, &disk_cache);
+			vkDestroyPipelineCache(ctx->dev, disk_cache, 0);
+		}
+	}
+
+	if (vkGetPipelineCacheData(ctx->dev, ctx->pipeline_cache,
+				   &size, NULL) == VK_SUCCESS && size > 0) {
+		data = malloc(size);
+		if (vkGetPipelineCacheData(ctx->dev, ctx->pipeline_cache,
+					   &size, data) == VK_SUCCESS &&
+		    (size != disk_size || !disk_data ||
+		     memcmp(data, disk_data, size)))
+			write_pipeline_cache_file(ctx->pipeline_cache_path,
+						  data, size);
+		free(data);
+	}
+
+	free(disk_data);
+	close(lock);
+}
+
 static VkCommandPool
 create_cmd_pool(struct vk_ctx *ctx)
 {
@@ -776,7 +945,7 @@ create_pipeline(struct vk_ctx *ctx,
 	pipeline_info.stageCount = 2;
 	pipeline_info.pStages = sdr_stages;
 
-	if (vkCreateGraphicsPipelines(ctx->dev, 0, 1,
+	if (vkCreateGraphicsPipelines(ctx->dev, ctx->pipeline_cache, 1,
 				      &pipeline_info, 0, &renderer->pipeline) !=
 			VK_SUCCESS) {
 		fprintf(stderr, "Failed to create graphics pipeline.\n");
@@ -1054,6 +1223,7 @@ vk_init_ctx(struct vk_ctx *ctx)
 	}
 
 	fill_uuid(ctx->pdev, ctx->deviceUUID, ctx->driverUUID);
+	create_pipeline_cache(ctx);
 	return true;
 
 fail:
@@ -1125,6 +1295,15 @@ vk_cleanup_ctx(struct vk_ctx *ctx)
 		ctx->n_dev_exts = 0;
 	}
 
+	if (ctx->pipeline_cache != VK_NULL_HANDLE) {
+		save_pipeline_cache(ctx);
+		vkDestroyPipelineCache(ctx->dev, ctx->pipeline_cache, 0);
+		ctx->pipeline_cache = VK_NULL_HANDLE;
+	}
+
+	free(ctx->pipeline_cache_path);
+	ctx->pipeline_cache_path = NULL;
+
 	if (ctx->dev != VK_NULL_HANDLE) {
 		vkDestroyDevice(ctx->dev, 0);
 		ctx->dev = VK_NULL_HANDLE;
@@ -1136,9 +1315,9 @@ vk_cleanup_ctx(struct vk_ctx *ctx)
 	}
 }
 
-bool
-vk_create_ext_image(struct vk_ctx *ctx,
-		    struct vk_image_props *props, struct vk_image_obj *img)
+static bool
+create_ext_image(struct vk_ctx *ctx,
+		 struct vk_image_props *props, struct vk_image_obj *img)
 {
 	VkExternalMemoryImageCreateInfo ext_img_info;
 	VkImageCreateInfo img_info;
@@ -1169,7 +1348,17 @@ vk_create_ext_image(struct vk_ctx *ctx,
 	 */
 	img_info.flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
 
-	if (vkCreateImage(ctx->dev, &img_info, 0, &img->img) != VK_SUCCESS)
+	img->mobj.pool = NULL;
+	img->mobj.offset = 0;
+
+	return vkCreateImage(ctx->dev, &img_info, 0, &img->img) == VK_SUCCESS;
+}
+
+bool
+vk_create_ext_image(struct vk_ctx *ctx,
+		    struct vk_image_props *props, struct vk_image_obj *img)
+{
+	if (!create_ext_image(ctx, props, img))
 		goto fail;
 
 	if(!alloc_image_memory(ctx, img))
@@ -1185,6 +1374,129 @@ fail:
 	return false;
 }
 
+/* Size of the memory of a pool, unless its first object needs more. */
+#define VK_MEM_POOL_SIZE (64 * 1024 * 1024)
+
+static bool
+alloc_pool_memory(struct vk_ctx *ctx, struct vk_mem_pool *pool,
+		  const VkMemoryRequirements *mem_reqs)
+{
+	VkPhysicalDeviceProperties pdev_props;
+	VkMemoryRequirements pool_reqs = *mem_reqs;
+
+	pool_reqs.size = MAX2(mem_reqs->size, VK_MEM_POOL_SIZE);
+
+	pool->mem = alloc_memory(ctx, true, &pool_reqs,
+				 VK_NULL_HANDLE, VK_NULL_HANDLE,
+				 mem_reqs->memoryTypeBits &
+				 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (pool->mem == VK_NULL_HANDLE)
+		return false;
+
+	/* Linear and optimal images may end up next to each other. */
+	vkGetPhysicalDeviceProperties(ctx->pdev, &pdev_props);
+
+	pool->size = pool_reqs.size;
+	pool->used = 0;
+	pool->granularity = pdev_props.limits.bufferImageGranularity;
+	pool->type_idx = get_memory_type_idx(ctx->pdev, mem_reqs,
+					     mem_reqs->memoryTypeBits &
+					     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	return true;
+}
+
+/* Bind the image to a range of the pool, or return false if it has to
+ * have memory of its own. */
+static bool
+bind_pool_memory(struct vk_ctx *ctx, struct vk_mem_pool *pool,
+		 struct vk_image_obj *img_obj)
+{
+	VkMemoryDedicatedRequirements ded_reqs;
+	VkImageMemoryRequirementsInfo2 req_info2;
+	VkMemoryRequirements2 mem_reqs2;
+	const VkMemoryRequirements *reqs = &mem_reqs2.memoryRequirements;
+	VkDeviceSize alignment, offset;
+
+	memset(&ded_reqs, 0, sizeof ded_reqs);
+	ded_reqs.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+
+	memset(&req_info2, 0, sizeof req_info2);
+	req_info2.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+	req_info2.image = img_obj->img;
+
+	memset(&mem_reqs2, 0, sizeof mem_reqs2);
+	mem_reqs2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+	mem_reqs2.pNext = &ded_reqs;
+
+	vkGetImageMemoryRequirements2(ctx->dev, &req_info2, &mem_reqs2);
+	if (ded_reqs.requiresDedicatedAllocation ||
+	    ded_reqs.prefersDedicatedAllocation)
+		return false;
+
+	if (pool->mem == VK_NULL_HANDLE &&
+	    !alloc_pool_memory(ctx, pool, reqs))
+		return false;
+
+	if (!(reqs->memoryTypeBits & (1u << pool->type_idx)))
+		return false;
+
+	alignment = MAX2(reqs->alignment, pool->granularity);
+	offset = (pool->used + alignment - 1) / alignment * alignment;
+	if (offset + reqs->size > pool->size)
+		return false;
+
+	if (vkBindImageMemory(ctx->dev, img_obj->img, pool->mem, offset) !=
+	    VK_SUCCESS)
+		return false;
+
+	img_obj->mobj.mem = pool->mem;
+	img_obj->mobj.mem_sz = pool->size;
+	img_obj->mobj.dedicated = false;
+	img_obj->mobj.pool = pool;
+	img_obj->mobj.offset = offset;
+
+	pool->used = offset + reqs->size;
+	pool->num_allocs++;
+	return true;
+}
+
+bool
+vk_create_ext_image_from_pool(struct vk_ctx *ctx,
+			      struct vk_mem_pool *pool,
+			      struct vk_image_props *props,
+			      struct vk_image_obj *img)
+{
+	if (!create_ext_image(ctx, props, img))
+		goto fail;
+
+	if (!bind_pool_memory(ctx, pool, img) &&
+	    !alloc_image_memory(ctx, img))
+		goto fail;
+
+	return true;
+
+fail:
+	fprintf(stderr, "Failed to create external image.\n");
+	vk_destroy_ext_image(ctx, img);
+	img->img = VK_NULL_HANDLE;
+	img->mobj.mem = VK_NULL_HANDLE;
+	return false;
+}
+
+void
+vk_destroy_mem_pool(struct vk_ctx *ctx,
+		    struct vk_mem_pool *pool)
+{
+	if (pool->mem != VK_NULL_HANDLE) {
+		vkFreeMemory(ctx->dev, pool->mem, 0);
+		pool->mem = VK_NULL_HANDLE;
+	}
+
+	pool->size = 0;
+	pool->used = 0;
+	pool->num_allocs = 0;
+}
+
 bool
 vk_create_ext_buffer(struct vk_ctx *ctx,
 		     uint32_t sz,
@@ -1213,7 +1525,16 @@ vk_destroy_ext_image(struct vk_ctx *ctx, struct vk_image_obj *img_obj)
 		img_obj->img = VK_NULL_HANDLE;
 	}
 
-	if (img_obj->mobj.mem != VK_NULL_HANDLE) {
+	if (img_obj->mobj.pool != NULL) {
+		struct vk_mem_pool *pool = img_obj->mobj.pool;
+
+		if (--pool->num_allocs == 0)
+			pool->used = 0;
+
+		img_obj->mobj.pool = NULL;
+		img_obj->mobj.offset = 0;
+		img_obj->mobj.mem = VK_NULL_HANDLE;
+	} else if (img_obj->mobj.mem != VK_NULL_HANDLE) {
 		vkFreeMemory(ctx->dev, img_obj->mobj.mem, 0);
 		img_obj->mobj.mem = VK_NULL_HANDLE;
 	}
@@ -1415,7 +1736,7 @@ vk_create_compute_pipeline(struct vk_ctx *ctx,
 	pipeline_info.stage.module = cp->cs;
 	pipeline_info.stage.pName = "main";
 	pipeline_info.layout = cp->pipeline_layout;
-	if (vkCreateComputePipelines(ctx->dev, 0, 1, &pipeline_info, 0, &cp->pipeline) != VK_SUCCESS) {
+	if (vkCreateComputePipelines(ctx->dev, ctx->pipeline_cache, 1, &pipeline_info, 0, &cp->pipeline) != VK_SUCCESS) {
 		fprintf(stderr, "Failed to create graphics pipeline.\n");
 		cp->pipeline = VK_NULL_HANDLE;
 		goto fail;
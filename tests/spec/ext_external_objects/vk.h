@@ -47,6 +47,11 @@ struct vk_ctx
 
 	uint8_t deviceUUID[VK_UUID_SIZE];
 	uint8_t driverUUID[VK_UUID_SIZE];
+
+	/* Pipeline cache loaded from and saved to pipeline_cache_path when
+	 * PIGLIT_VK_PIPELINE_CACHE is set, VK_NULL_HANDLE otherwise. */
+	VkPipelineCache pipeline_cache;
+	char *pipeline_cache_path;
 };
 
 struct vk_image_props
@@ -69,10 +74,33 @@ struct vk_image_props
 	bool need_export;
 };
 
+struct vk_mem_pool;
+
 struct vk_mem_obj {
 	VkDeviceMemory mem;
 	VkDeviceSize mem_sz;
 	bool dedicated;
+
+	/* Set when the object is a range of a pool's memory, which mem and
+	 * mem_sz then describe as a whole. */
+	struct vk_mem_pool *pool;
+	VkDeviceSize offset;
+};
+
+/* Exportable memory shared by the objects of a test, so that the memory is
+ * allocated, exported and imported by GL once rather than once per object.
+ * The ranges are handed out in order and the pool starts over from the
+ * beginning once they have all been released. */
+struct vk_mem_pool {
+	VkDeviceMemory mem;
+	VkDeviceSize size;
+	VkDeviceSize used;
+	VkDeviceSize granularity;
+	uint32_t type_idx;
+	unsigned num_allocs;
+
+	/* GL memory object the memory was imported as, 0 until then. */
+	unsigned gl_mem_obj;
 };
 
 struct vk_image_obj {
@@ -168,6 +196,16 @@ vk_create_ext_image(struct vk_ctx *ctx,
 		    struct vk_image_props *props,
 		    struct vk_image_obj *img_obj);
 
+bool
+vk_create_ext_image_from_pool(struct vk_ctx *ctx,
+			      struct vk_mem_pool *pool,
+			      struct vk_image_props *props,
+			      struct vk_image_obj *img);
+
+void
+vk_destroy_mem_pool(struct vk_ctx *ctx,
+		    struct vk_mem_pool *pool);
+
 bool
 vk_create_ext_buffer(struct vk_ctx *ctx,
 		     uint32_t sz,
@@ -43,6 +43,7 @@ static GLenum gl_target = GL_TEXTURE_2D;
 static struct vk_ctx vk_core;
 static struct vk_image_props vk_img_props;
 static struct vk_image_obj vk_img_obj;
+static struct vk_mem_pool vk_mem_pool;
 static GLuint gl_mem_obj;
 static GLuint gl_tex;
 static GLuint gl_fbo;
@@ -174,7 +175,11 @@ run_subtest(int case_num)
 		return PIGLIT_SKIP;
 	}
 
-	if (!vk_create_ext_image(&vk_core, &vk_img_props, &vk_img_obj)) {
+	/* The images of all the subtests share the memory of one pool, which
+	 * is only exported and imported by GL once.
+	 */
+	if (!vk_create_ext_image_from_pool(&vk_core, &vk_mem_pool,
+					   &vk_img_props, &vk_img_obj)) {
 		piglit_report_subtest_result(PIGLIT_FAIL,
 					     "%s: Failed to create external Vulkan image.",
 					     vk_gl_format[case_num].name);
@@ -192,7 +197,7 @@ run_subtest(int case_num)
 	}
 
 	if (!gl_gen_tex_from_mem_obj(&vk_img_props, vk_gl_format[case_num].glformat,
-				     gl_mem_obj, 0,
+				     gl_mem_obj, vk_img_obj.mobj.offset,
 				     &gl_tex)) {
 		piglit_report_subtest_result(PIGLIT_FAIL,
 					     "%s: Failed to create texture from GL memory object.",
@@ -283,6 +288,7 @@ run_subtest(int case_num)
 
 	piglit_present_results();
 
+	glDeleteTextures(1, &gl_tex);
 	vk_destroy_ext_image(&vk_core, &vk_img_obj);
 
 	return subtest_result;
@@ -348,6 +354,12 @@ gl_draw_texture(enum fragment_type fs_type, uint32_t w, uint32_t h)
 static void
 cleanup(void *data)
 {
+	if (vk_mem_pool.gl_mem_obj)
+		glDeleteMemoryObjectsEXT(1, &vk_mem_pool.gl_mem_obj);
+	if (gl_mem_obj && gl_mem_obj != vk_mem_pool.gl_mem_obj)
+		glDeleteMemoryObjectsEXT(1, &gl_mem_obj);
+
+	vk_destroy_mem_pool(&vk_core, &vk_mem_pool);
 	vk_cleanup_ctx(&vk_core);
 
 	glDeleteFramebuffers(1, &gl_fbo);
@@ -221,6 +221,271 @@ DownsampleProg::run(const Fbo *src_fbo, int dest_width, int dest_height,
 	glDisable(GL_FRAMEBUFFER_SRGB);
 }
 
+AccuracyProg::AccuracyProg()
+	: error_prog(0),
+	  reduce_prog(0),
+	  vertex_buf(0),
+	  vao(0),
+	  pattern_width(0),
+	  pattern_height(0),
+	  num_levels(0)
+{
+}
+
+bool
+AccuracyProg::is_supported()
+{
+	return piglit_is_extension_supported("GL_ARB_texture_float");
+}
+
+/**
+ * Return false if the framebuffers can't be set up, the CPU has to
+ * measure the accuracy then.
+ */
+bool
+AccuracyProg::compile(int pattern_width, int pattern_height, bool srgb)
+{
+	static const char *vert =
+		"#version 120\n"
+		"attribute vec2 pos;\n"
+		"void main()\n"
+		"{\n"
+		"  gl_Position = vec4(pos, 0.0, 1.0);\n"
+		"}\n";
+
+	/* gl_FragData[0] holds the sums of the squared errors and
+	 * gl_FragData[1] the counts of the unlit, totally lit and
+	 * partially lit components, in x, y and z.
+	 */
+	static const char *error_frag_template =
+		"#version 120\n"
+		"uniform sampler2DRect samp;\n"
+		"float srgb_to_linear(float x)\n"
+		"{\n"
+		"  if (x <= 0.0405)\n"
+		"    return x / 12.92;\n"
+		"  return pow((x + 0.055) / 1.055, 2.4);\n"
+		"}\n"
+		"void record(float ref, float test, bool linearize,\n"
+		"            inout vec3 sums, inout vec3 counts)\n"
+		"{\n"
+		"  if (linearize) {\n"
+		"    ref = srgb_to_linear(ref);\n"
+		"    test = srgb_to_linear(test);\n"
+		"  }\n"
+		"  float error = test - ref;\n"
+		"  vec3 class_mask;\n"
+		"  if (ref <= 0.0) {\n"
+		"    class_mask = vec3(1.0, 0.0, 0.0);\n"
+		"  } else if (ref >= 1.0) {\n"
+		"    class_mask = vec3(0.0, 1.0, 0.0);\n"
+		"  } else {\n"
+		"    class_mask = vec3(0.0, 0.0, 1.0);\n"
+		"    /* See Test::measure_accuracy_cpu() */\n"
+		"    if (linearize) {\n"
+		"      float error_srgb = test - srgb_to_linear(ref);\n"
+		"      if (abs(error_srgb) < abs(error))\n"
+		"        error = error_srgb;\n"
+		"    }\n"
+		"  }\n"
+		"  sums += class_mask * error * error;\n"
+		"  counts += class_mask;\n"
+		"}\n"
+		"void main()\n"
+		"{\n"
+		"  bool srgb = %s;\n"
+		"  vec3 sums = vec3(0.0);\n"
+		"  vec3 counts = vec3(0.0);\n"
+		"  vec2 p = gl_FragCoord.xy;\n"
+		"  vec4 test = texture2DRect(samp, p);\n"
+		"  vec4 ref = texture2DRect(samp, p + vec2(%d.0, 0.0));\n"
+		"  record(ref.r, test.r, srgb, sums, counts);\n"
+		"  record(ref.g, test.g, srgb, sums, counts);\n"
+		"  record(ref.b, test.b, srgb, sums, counts);\n"
+		"  record(ref.a, test.a, false, sums, counts);\n"
+		"  gl_FragData[0] = vec4(sums, 0.0);\n"
+		"  gl_FragData[1] = vec4(counts, 0.0);\n"
+		"}\n";
+
+	static const char *reduce_frag =
+		"#version 120\n"
+		"uniform sampler2DRect sums_samp;\n"
+		"uniform sampler2DRect counts_samp;\n"
+		"uniform vec2 src_size;\n"
+		"void main()\n"
+		"{\n"
+		"  vec2 base = floor(gl_FragCoord.xy) * 4.0;\n"
+		"  vec4 sums = vec4(0.0);\n"
+		"  vec4 counts = vec4(0.0);\n"
+		"  for (int i = 0; i < 4; ++i) {\n"
+		"    for (int j = 0; j < 4; ++j) {\n"
+		"      vec2 p = base + vec2(i, j) + 0.5;\n"
+		"      if (all(lessThan(p, src_size))) {\n"
+		"        sums += texture2DRect(sums_samp, p);\n"
+		"        counts += texture2DRect(counts_samp, p);\n"
+		"      }\n"
+		"    }\n"
+		"  }\n"
+		"  gl_FragData[0] = sums;\n"
+		"  gl_FragData[1] = counts;\n"
+		"}\n";
+	static const GLenum draw_buffers[2] = {
+		GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1
+	};
+	char *error_frag;
+
+	this->pattern_width = pattern_width;
+	this->pattern_height = pattern_height;
+
+	if (asprintf(&error_frag, error_frag_template,
+		     srgb ? "true" : "false", pattern_width) == -1)
+		piglit_report_result(PIGLIT_FAIL);
+
+	/* Compile programs */
+	error_prog = piglit_build_simple_program_unlinked(vert, error_frag);
+	free(error_frag);
+	reduce_prog = piglit_build_simple_program_unlinked(vert, reduce_frag);
+	glBindAttribLocation(error_prog, 0, "pos");
+	glBindAttribLocation(reduce_prog, 0, "pos");
+	glLinkProgram(error_prog);
+	glLinkProgram(reduce_prog);
+	if (!piglit_link_check_status(error_prog) ||
+	    !piglit_link_check_status(reduce_prog)) {
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	/* Set up uniforms */
+	glUseProgram(error_prog);
+	glUniform1i(glGetUniformLocation(error_prog, "samp"), 0);
+	glUseProgram(reduce_prog);
+	glUniform1i(glGetUniformLocation(reduce_prog, "sums_samp"), 0);
+	glUniform1i(glGetUniformLocation(reduce_prog, "counts_samp"), 1);
+
+	/* Set up the framebuffers.  The images are copied as they
+	 * are stored in the window, like glReadPixels() would read
+	 * them.
+	 */
+	FboConfig images_config(0, 2 * pattern_width, pattern_height);
+	images_config.num_tex_attachments = 1;
+	images_config.num_rb_attachments = 0;
+	images_config.color_internalformat = GL_RGBA8;
+	images_config.combine_depth_stencil = false;
+	images_config.depth_internalformat = GL_NONE;
+	images_config.stencil_internalformat = GL_NONE;
+	if (!images_fbo.try_setup(images_config))
+		return false;
+
+	FboConfig level_config = images_config;
+	level_config.num_tex_attachments = 2;
+	level_config.tex_attachment[1] = GL_COLOR_ATTACHMENT1;
+	level_config.color_internalformat = GL_RGBA32F;
+	level_config.width = pattern_width;
+	level_config.height = pattern_height;
+	for (num_levels = 0; num_levels < MAX_LEVELS; ) {
+		if (!level_fbos[num_levels].try_setup(level_config))
+			return false;
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER,
+				  level_fbos[num_levels].handle);
+		glDrawBuffers(2, draw_buffers);
+		num_levels++;
+
+		if (level_config.width == 1 && level_config.height == 1)
+			break;
+		level_config.width = (level_config.width + 3) / 4;
+		level_config.height = (level_config.height + 3) / 4;
+	}
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, piglit_winsys_fbo);
+
+	/* Set up vertex array object */
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	/* Set up vertex input buffer */
+	float vertex_data[4][2] = {
+		{ -1, -1 },
+		{  1, -1 },
+		{  1,  1 },
+		{ -1,  1 }
+	};
+	glGenBuffers(1, &vertex_buf);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buf);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_data), vertex_data,
+		     GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2*sizeof(float),
+			      (void *) 0);
+
+	return true;
+}
+
+/**
+ * Draw a quad covering dst with prog, sampling the color textures of
+ * src.
+ */
+void
+AccuracyProg::draw(GLint prog, const Fbo *src, Fbo *dst)
+{
+	for (int i = 0; i < src->config.num_tex_attachments; i++) {
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_RECTANGLE, src->color_tex[i]);
+	}
+
+	glUseProgram(prog);
+	if (prog == reduce_prog) {
+		glUniform2f(glGetUniformLocation(prog, "src_size"),
+			    src->config.width, src->config.height);
+	}
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst->handle);
+	dst->set_viewport();
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void
+AccuracyProg::release_fbos()
+{
+	images_fbo.release();
+	for (int i = 0; i < num_levels; i++)
+		level_fbos[i].release();
+	num_levels = 0;
+}
+
+/**
+ * Measure the test image (on the left of the window) against the
+ * reference image (on its right), adding the results to the Stats.
+ */
+void
+AccuracyProg::run(Stats *unlit, Stats *totally_lit, Stats *partially_lit)
+{
+	float sums[4], counts[4];
+	const Fbo *last = &level_fbos[num_levels - 1];
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, piglit_winsys_fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, images_fbo.handle);
+	glBlitFramebuffer(0, 0, 2 * pattern_width, pattern_height,
+			  0, 0, 2 * pattern_width, pattern_height,
+			  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	draw(error_prog, &images_fbo, &level_fbos[0]);
+	for (int i = 1; i < num_levels; i++)
+		draw(reduce_prog, &level_fbos[i - 1], &level_fbos[i]);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, last->handle);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, 1, 1, GL_RGBA, GL_FLOAT, sums);
+	glReadBuffer(GL_COLOR_ATTACHMENT1);
+	glReadPixels(0, 0, 1, 1, GL_RGBA, GL_FLOAT, counts);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+	glViewport(0, 0, piglit_width, piglit_height);
+
+	unlit->record_sum(counts[0], sums[0]);
+	totally_lit->record_sum(counts[1], sums[1]);
+	partially_lit->record_sum(counts[2], sums[2]);
+}
+
 Stats::Stats()
 	: count(0), sum_squared_error(0.0)
 {
@@ -264,6 +529,8 @@ Test::Test(TestPattern *pattern, ManifestProgram *manifest_program,
 	  supersample_factor(0),
 	  srgb(srgb),
 	  downsample_prog(),
+	  gpu_accuracy(false),
+	  accuracy_prog(),
 	  filter_mode(GL_NONE)
 {
 }
@@ -271,6 +538,14 @@ Test::Test(TestPattern *pattern, ManifestProgram *manifest_program,
 Test::~Test() {
 	delete pattern;
 	delete manifest_program;
+
+	/* The next Test, with another sample count, reuses these. */
+	test_fbo.release();
+	multisample_fbo.release();
+	resolve_fbo.release();
+	supersample_fbo.release();
+	downsample_fbo.release();
+	accuracy_prog.release_fbos();
 }
 
 void
@@ -312,6 +587,10 @@ Test::init(int num_samples, bool small, bool combine_depth_stencil,
 
 	pattern->compile();
 	downsample_prog.compile(supersample_factor);
+	gpu_accuracy = AccuracyProg::is_supported() &&
+		!piglit_env_var_as_boolean("PIGLIT_MSAA_CPU_ACCURACY",
+					   false) &&
+		accuracy_prog.compile(pattern_width, pattern_height, srgb);
 	if (manifest_program)
 		manifest_program->compile();
 
@@ -489,17 +768,14 @@ Test::draw_reference_image()
 }
 
 /**
- * Measure the accuracy of MSAA downsampling.  Pixels that are fully
- * on or off in the reference image are required to be fully on or off
- * in the test image.  Pixels that are not fully on or off in the
- * reference image may be at any grayscale level; we mesaure the RMS
- * error between the reference image and the test image.
+ * Compare the test image with the reference image in the window on
+ * the CPU, adding the errors of each color component to the Stats of
+ * its class.
  */
-bool
-Test::measure_accuracy()
+void
+Test::measure_accuracy_cpu(Stats *unlit_stats, Stats *totally_lit_stats,
+			   Stats *partially_lit_stats)
 {
-	bool pass = true;
-
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, piglit_winsys_fbo);
 			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, piglit_winsys_fbo);
 			glViewport(0, 0, piglit_width, piglit_height);
@@ -512,9 +788,6 @@ Test::measure_accuracy()
 	glReadPixels(0, 0, pattern_width, pattern_height, GL_RGBA,
 		     GL_FLOAT, test_data);
 
-	Stats unlit_stats;
-	Stats partially_lit_stats;
-	Stats totally_lit_stats;
 	for (int y = 0; y < pattern_height; ++y) {
 		for (int x = 0; x < pattern_width; ++x) {
 			for (int c = 0; c < 4; ++c) {
@@ -530,9 +803,9 @@ Test::measure_accuracy()
 					test = piglit_srgb_to_linear(test);
 				}
 				if (ref <= 0.0)
-					unlit_stats.record(test - ref);
+					unlit_stats->record(test - ref);
 				else if (ref >= 1.0)
-					totally_lit_stats.record(test - ref);
+					totally_lit_stats->record(test - ref);
 				else {
 					float error = test - ref;
 					if (srgb && c < 3) {
@@ -554,12 +827,39 @@ Test::measure_accuracy()
 						if (fabsf(error_srgb) < fabsf(error))
 							error = error_srgb;
 					}
-					partially_lit_stats.record(error);
+					partially_lit_stats->record(error);
 				}
 			}
 		}
 	}
 
+	delete[] reference_data;
+	delete[] test_data;
+}
+
+/**
+ * Measure the accuracy of MSAA downsampling.  Pixels that are fully
+ * on or off in the reference image are required to be fully on or off
+ * in the test image.  Pixels that are not fully on or off in the
+ * reference image may be at any grayscale level; we mesaure the RMS
+ * error between the reference image and the test image.
+ */
+bool
+Test::measure_accuracy()
+{
+	bool pass = true;
+
+	Stats unlit_stats;
+	Stats partially_lit_stats;
+	Stats totally_lit_stats;
+	if (gpu_accuracy) {
+		accuracy_prog.run(&unlit_stats, &totally_lit_stats,
+				  &partially_lit_stats);
+	} else {
+		measure_accuracy_cpu(&unlit_stats, &totally_lit_stats,
+				     &partially_lit_stats);
+	}
+
 	double error_threshold;
 	if (test_resolve) {
 		/* For depth and stencil resolves, the implementation
@@ -620,8 +920,6 @@ Test::measure_accuracy()
 	printf("The error threshold for partially lit pixels is %f\n",
                error_threshold);
 	pass = partially_lit_stats.is_better_than(error_threshold) && pass;
-	delete[] reference_data;
-	delete[] test_data;
 
 	return pass;
 }
@@ -78,6 +78,15 @@ public:
 		sum_squared_error += error * error;
 	}
 
+	/**
+	 * Record count errors at once, given the sum of their squares.
+	 */
+	void record_sum(int count, double sum_squared_error)
+	{
+		this->count += count;
+		this->sum_squared_error += sum_squared_error;
+	}
+
 	void summarize();
 
 	bool is_perfect();
@@ -89,6 +98,46 @@ private:
 	double sum_squared_error;
 };
 
+/**
+ * Programs we use to measure the accuracy of the test image on the
+ * GPU, so that only the resulting Stats are read back.
+ *
+ * The first pass classifies each color component of each pixel the way
+ * Test::measure_accuracy() does, writing the squared error and count of
+ * every class to two float buffers.  The following passes sum blocks
+ * of 4x4 pixels of these until a single pixel is left.
+ */
+class AccuracyProg
+{
+public:
+	AccuracyProg();
+
+	static bool is_supported();
+	bool compile(int pattern_width, int pattern_height, bool srgb);
+	void run(Stats *unlit, Stats *totally_lit, Stats *partially_lit);
+	void release_fbos();
+
+private:
+	enum { MAX_LEVELS = 16 };
+
+	void draw(GLint prog, const piglit_util_fbo::Fbo *src,
+		  piglit_util_fbo::Fbo *dst);
+
+	GLint error_prog;
+	GLint reduce_prog;
+	GLuint vertex_buf;
+	GLuint vao;
+	int pattern_width;
+	int pattern_height;
+
+	/** The test and reference images, side by side. */
+	piglit_util_fbo::Fbo images_fbo;
+
+	/** The per-pixel errors, then each reduction of them. */
+	piglit_util_fbo::Fbo level_fbos[MAX_LEVELS];
+	int num_levels;
+};
+
 /**
  * This data structure wraps up all the data we need to keep track of
  * to run the test.
@@ -119,6 +168,9 @@ private:
 	void downsample_color(int downsampled_width, int downsampled_height);
 	void show(piglit_util_fbo::Fbo *src_fbo, int x_offset, int y_offset);
 	void draw_pattern(int x_offset, int y_offset, int width, int height);
+	void measure_accuracy_cpu(Stats *unlit_stats,
+				  Stats *totally_lit_stats,
+				  Stats *partially_lit_stats);
 
 	/** The test pattern to draw. */
 	piglit_util_test_pattern::TestPattern *pattern;
@@ -175,6 +227,15 @@ private:
 	bool srgb;
 	DownsampleProg downsample_prog;
 
+	/**
+	 * True if measure_accuracy() uses accuracy_prog, false if it
+	 * compares the images on the CPU.  The CPU is used when
+	 * floating point textures aren't supported, or when
+	 * PIGLIT_MSAA_CPU_ACCURACY is set to debug the measurement.
+	 */
+	bool gpu_accuracy;
+	AccuracyProg accuracy_prog;
+
 	/**
 	 * Filter mode to use when downsampling the image
 	 */
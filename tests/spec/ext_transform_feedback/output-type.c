@@ -26,8 +26,13 @@
  *
  * Test that writing a variable with a specific GLSL type into a TFB buffer
  * works as expected.
+ *
+ * The test name given on the command line selects one entry of the table
+ * below.  With "batch", all the entries are run as subtests, packed into
+ * as few programs as the transform feedback limits allow.
  */
 
+#include <ctype.h>
 #include "piglit-util-gl.h"
 
 PIGLIT_GL_TEST_CONFIG_BEGIN
@@ -1463,6 +1468,313 @@ GLuint prog;
 
 #define NUM_VERTICES 3
 
+/**
+ * Batched mode ("batch" on the command line): every table entry is run
+ * as a subtest, with as many entries as fit packed into each program.
+ * The varyings of entry i get a "_i" suffix so that the entries' shaders
+ * can be concatenated, and buffer j of a batch holds the buffer j slice
+ * of each of its entries one after another, so that a single map of each
+ * buffer verifies the whole batch.
+ */
+#define NUM_TESTS (ARRAY_SIZE(tests) - 1)
+
+struct batch {
+	GLuint prog;
+	unsigned first, count; /* range of batch_members */
+	unsigned num_buffers;
+	unsigned num_elements[MAX_BUFFERS];
+};
+
+static bool batch_mode;
+static bool batch_pass = true;
+static struct batch batches[NUM_TESTS];
+static unsigned num_batches;
+static unsigned batch_members[NUM_TESTS];
+static unsigned num_batch_members;
+static unsigned offsets[NUM_TESTS][MAX_BUFFERS];
+
+static unsigned
+num_buffers_used(const struct test_desc *t)
+{
+	unsigned i, n = 1;
+
+	for (i = 0; i < t->num_varyings; i++) {
+		if (!strcmp(t->varyings[i], "gl_NextBuffer"))
+			n++;
+	}
+	return n;
+}
+
+/**
+ * Return true if the identifier of \a len characters at \a ident is the
+ * base name of one of the varyings of \a t.
+ */
+static bool
+is_varying_name(const struct test_desc *t, const char *ident, size_t len)
+{
+	unsigned i;
+
+	for (i = 0; i < t->num_varyings; i++) {
+		const char *name = t->varyings[i];
+
+		if (strncmp(name, "gl_", 3) != 0 &&
+		    strcspn(name, "[") == len && !strncmp(name, ident, len))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Copy \a len characters of \a src, adding the "_<index>" suffix to
+ * every varying of \a t.
+ */
+static char *
+rename_varyings(const struct test_desc *t, unsigned index,
+		const char *src, size_t len)
+{
+	char *dst = calloc(1, len * 12 + 1);
+	char *p = dst;
+	size_t i = 0;
+
+	while (i < len) {
+		size_t n = 0;
+
+		if (!isalpha(src[i]) && src[i] != '_') {
+			*p++ = src[i++];
+			continue;
+		}
+
+		while (i + n < len && (isalnum(src[i + n]) || src[i + n] == '_'))
+			n++;
+		memcpy(p, src + i, n);
+		p += n;
+		if (is_varying_name(t, src + i, n))
+			p += sprintf(p, "_%u", index);
+		i += n;
+	}
+	return dst;
+}
+
+static char *
+batch_vs_text(const struct batch *b)
+{
+	char *decls = strdup(""), *body = strdup(""), *vs, *tmp;
+	unsigned version = 110;
+	unsigned i;
+
+	for (i = b->first; i < b->first + b->count; i++) {
+		unsigned index = batch_members[i];
+		const struct test_desc *t = &tests[index];
+		const char *start = strchr(t->vs, '\n') + 1;
+		const char *main_start = strstr(start, "void main() {");
+		const char *code = strstr(main_start, "gl_Position = ftransform();") +
+				   strlen("gl_Position = ftransform();");
+		const char *end = strrchr(code, '}');
+		char *d, *c;
+		unsigned v;
+
+		if (sscanf(t->vs, "#version %u", &v) == 1)
+			version = MAX2(version, v);
+
+		d = rename_varyings(t, index, start, main_start - start);
+		c = rename_varyings(t, index, code, end - code);
+		(void)!asprintf(&tmp, "%s%s\n", decls, d);
+		free(decls);
+		decls = tmp;
+		(void)!asprintf(&tmp, "%s%s\n", body, c);
+		free(body);
+		body = tmp;
+		free(d);
+		free(c);
+	}
+
+	(void)!asprintf(&vs,
+			"#version %u\n"
+			"%s"
+			"void main() {\n"
+			"  gl_Position = ftransform();\n"
+			"%s"
+			"}\n",
+			version, decls, body);
+	free(decls);
+	free(body);
+	return vs;
+}
+
+/**
+ * Link a program for \a b.  If it doesn't link, which may happen when the
+ * entries together use more varying slots than the implementation has,
+ * split the batch in two and try again.  An entry that fails to link on
+ * its own is reported as a failed subtest.
+ */
+static void
+build_batch(struct batch b)
+{
+	const char *varyings[MAX_VARYINGS * NUM_TESTS + MAX_BUFFERS];
+	unsigned num_varyings = 0;
+	unsigned i, j, k;
+	GLuint vs;
+	char *text;
+
+	for (j = 0; j < b.num_buffers; j++) {
+		if (j > 0)
+			varyings[num_varyings++] = "gl_NextBuffer";
+
+		for (i = b.first; i < b.first + b.count; i++) {
+			unsigned index = batch_members[i];
+			const struct test_desc *t = &tests[index];
+			unsigned buffer = 0;
+
+			for (k = 0; k < t->num_varyings; k++) {
+				const char *name = t->varyings[k];
+				size_t len = strcspn(name, "[");
+				char *renamed;
+
+				if (!strcmp(name, "gl_NextBuffer")) {
+					buffer++;
+					continue;
+				}
+				if (buffer != j)
+					continue;
+
+				if (!strncmp(name, "gl_", 3)) {
+					renamed = strdup(name);
+				} else {
+					(void)!asprintf(&renamed, "%.*s_%u%s",
+							(int)len, name, index,
+							name + len);
+				}
+				varyings[num_varyings++] = renamed;
+			}
+		}
+	}
+
+	text = batch_vs_text(&b);
+	vs = piglit_compile_shader_text_nothrow(GL_VERTEX_SHADER, text, false);
+	free(text);
+
+	b.prog = glCreateProgram();
+	if (vs) {
+		glAttachShader(b.prog, vs);
+		glDeleteShader(vs);
+	}
+	glTransformFeedbackVaryings(b.prog, num_varyings, varyings,
+				    GL_INTERLEAVED_ATTRIBS_EXT);
+	glLinkProgram(b.prog);
+
+	for (i = 0; i < num_varyings; i++) {
+		if (strcmp(varyings[i], "gl_NextBuffer") != 0)
+			free((char *)varyings[i]);
+	}
+
+	if (vs && piglit_link_check_status_quiet(b.prog)) {
+		batches[num_batches++] = b;
+		return;
+	}
+	glDeleteProgram(b.prog);
+
+	if (b.count == 1) {
+		piglit_report_subtest_result(PIGLIT_FAIL, "%s",
+					     tests[batch_members[b.first]].name);
+		batch_pass = false;
+		return;
+	}
+
+	{
+		struct batch first = b, second = b;
+
+		first.count = b.count / 2;
+		second.first = b.first + first.count;
+		second.count = b.count - first.count;
+
+		for (k = 0; k < 2; k++) {
+			struct batch *half = k ? &second : &first;
+
+			half->num_buffers = 0;
+			memset(half->num_elements, 0, sizeof(half->num_elements));
+			for (i = half->first; i < half->first + half->count; i++) {
+				unsigned index = batch_members[i];
+
+				half->num_buffers = MAX2(half->num_buffers,
+							 num_buffers_used(&tests[index]));
+				for (j = 0; j < MAX_BUFFERS; j++) {
+					offsets[index][j] = half->num_elements[j];
+					half->num_elements[j] +=
+						tests[index].num_elements[j];
+				}
+			}
+		}
+		build_batch(first);
+		build_batch(second);
+	}
+}
+
+static void
+batch_init(void)
+{
+	bool es, has_tf3, has_glsl130;
+	int major, minor, maxcomps, maxbufs = 1;
+	struct batch b = { 0 };
+	unsigned i, j;
+
+	piglit_require_gl_version(15);
+	piglit_require_transform_feedback();
+	piglit_require_vertex_shader();
+
+	piglit_get_glsl_version(&es, &major, &minor);
+	has_glsl130 = major * 100 + minor >= 130;
+	has_tf3 = piglit_is_extension_supported("GL_ARB_transform_feedback3");
+	glGetIntegerv(GL_MAX_TRANSFORM_FEEDBACK_INTERLEAVED_COMPONENTS, &maxcomps);
+	if (has_tf3)
+		glGetIntegerv(GL_MAX_TRANSFORM_FEEDBACK_BUFFERS, &maxbufs);
+
+	for (i = 0; i < NUM_TESTS; i++) {
+		const struct test_desc *t = &tests[i];
+		unsigned num_buffers = num_buffers_used(t);
+		bool fits = true;
+
+		for (j = 0; j < MAX_BUFFERS; j++) {
+			if (t->num_elements[j] > maxcomps)
+				fits = false;
+		}
+
+		if ((!t->is_floating_point && !has_glsl130) ||
+		    (t->is_transform_feedback3 && !has_tf3) ||
+		    num_buffers > maxbufs || !fits) {
+			piglit_report_subtest_result(PIGLIT_SKIP, "%s", t->name);
+			continue;
+		}
+
+		/* Start a new batch when this entry would overflow a buffer. */
+		for (j = 0; j < MAX_BUFFERS; j++) {
+			if (b.num_elements[j] + t->num_elements[j] > maxcomps)
+				break;
+		}
+		if (j < MAX_BUFFERS) {
+			build_batch(b);
+			memset(&b, 0, sizeof(b));
+			b.first = num_batch_members;
+		}
+
+		batch_members[num_batch_members++] = i;
+		b.count++;
+		b.num_buffers = MAX2(b.num_buffers, num_buffers);
+		for (j = 0; j < MAX_BUFFERS; j++) {
+			offsets[i][j] = b.num_elements[j];
+			b.num_elements[j] += t->num_elements[j];
+		}
+	}
+	if (b.count)
+		build_batch(b);
+
+	printf("Running %u tests in %u programs\n", num_batch_members,
+	       num_batches);
+
+	piglit_ortho_projection(piglit_width, piglit_height, GL_FALSE);
+	glClearColor(0.2, 0.2, 0.2, 1.0);
+	glEnableClientState(GL_VERTEX_ARRAY);
+}
+
 void piglit_init(int argc, char **argv)
 {
 	GLuint vs;
@@ -1470,6 +1782,12 @@ void piglit_init(int argc, char **argv)
 	int maxcomps;
 	float *data;
 
+	if (argc > 1 && !strcmp(argv[1], "batch")) {
+		batch_mode = true;
+		batch_init();
+		return;
+	}
+
 	/* Parse params. */
 	for (i = 1; i < argc; i++) {
 		struct test_desc *t;
@@ -1563,6 +1881,108 @@ test_ready:
 	glEnableClientState(GL_VERTEX_ARRAY);
 }
 
+static void
+batch_run(const struct batch *b, const float *verts)
+{
+	GLuint bufs[MAX_BUFFERS];
+	bool pass[NUM_TESTS];
+	unsigned i, j, v, e;
+
+	glGenBuffers(MAX_BUFFERS, bufs);
+	for (j = 0; j < b->num_buffers; j++) {
+		unsigned size = b->num_elements[j] * NUM_VERTICES;
+		float *data;
+
+		if (!size)
+			continue;
+
+		data = malloc(size * sizeof(float));
+		for (i = 0; i < size; i++)
+			data[i] = DEFAULT_VALUE;
+
+		glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER_EXT, bufs[j]);
+		glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER_EXT,
+			     size * sizeof(float), data, GL_STREAM_READ);
+		glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER_EXT, j, bufs[j]);
+		free(data);
+	}
+
+	glUseProgram(b->prog);
+	glBeginTransformFeedback(GL_TRIANGLES);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glVertexPointer(2, GL_FLOAT, 0, verts);
+	glDrawArrays(GL_TRIANGLES, 0, NUM_VERTICES);
+	glEndTransformFeedback();
+
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	for (i = b->first; i < b->first + b->count; i++)
+		pass[batch_members[i]] = true;
+
+	for (j = 0; j < b->num_buffers; j++) {
+		const unsigned stride = b->num_elements[j];
+		const float *ptr_float;
+		const GLint *ptr_int;
+
+		if (!stride)
+			continue;
+
+		glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER_EXT, bufs[j]);
+		ptr_float = glMapBuffer(GL_TRANSFORM_FEEDBACK_BUFFER_EXT,
+					GL_READ_ONLY);
+		ptr_int = (const GLint *)ptr_float;
+
+		for (i = b->first; i < b->first + b->count; i++) {
+			unsigned index = batch_members[i];
+			const struct test_desc *t = &tests[index];
+
+			for (v = 0; v < NUM_VERTICES; v++) {
+				for (e = 0; e < t->num_elements[j]; e++) {
+					unsigned k = v * stride +
+						     offsets[index][j] + e;
+
+					if (t->is_floating_point) {
+						float value = t->expected_float[j][e];
+
+						if (fabs(ptr_float[k] - value) > 0.01) {
+							printf("%s: Buffer[%i][%i]: %f,  Expected: %f\n",
+							       t->name, j,
+							       v * t->num_elements[j] + e,
+							       ptr_float[k], value);
+							pass[index] = false;
+						}
+					} else {
+						GLint value = t->expected_int[j][e];
+
+						if (ptr_int[k] != value) {
+							printf("%s: Buffer[%i][%i]: %i,  Expected: %i\n",
+							       t->name, j,
+							       v * t->num_elements[j] + e,
+							       ptr_int[k], value);
+							pass[index] = false;
+						}
+					}
+				}
+			}
+		}
+		glUnmapBuffer(GL_TRANSFORM_FEEDBACK_BUFFER_EXT);
+		if (!piglit_check_gl_error(GL_NO_ERROR))
+			piglit_report_result(PIGLIT_FAIL);
+	}
+
+	for (i = b->first; i < b->first + b->count; i++) {
+		unsigned index = batch_members[i];
+
+		piglit_report_subtest_result(pass[index] ? PIGLIT_PASS
+							 : PIGLIT_FAIL,
+					     "%s", tests[index].name);
+		batch_pass = batch_pass && pass[index];
+	}
+
+	glDeleteBuffers(MAX_BUFFERS, bufs);
+}
+
 enum piglit_result piglit_display(void)
 {
 	GLboolean pass = GL_TRUE;
@@ -1578,6 +1998,17 @@ enum piglit_result piglit_display(void)
 
 	glClear(GL_COLOR_BUFFER_BIT);
 
+	if (batch_mode) {
+		glLoadIdentity();
+		for (i = 0; i < num_batches; i++)
+			batch_run(&batches[i], verts);
+		piglit_present_results();
+
+		if (!num_batches && batch_pass)
+			return PIGLIT_SKIP;
+		return batch_pass ? PIGLIT_PASS : PIGLIT_FAIL;
+	}
+
 	/* Render into TFBO. */
 	glLoadIdentity();
 	glUseProgram(prog);
@@ -32,6 +32,9 @@
  * - number of invocations (GS instances)
  * - number of output vertices per invocation
  * - number of output components per vertex
+ *
+ * Test cases are rendered to the layers of an array texture in batches, so
+ * that each batch is read back once.
  */
 
 #include "piglit-util-gl.h"
@@ -40,6 +43,7 @@
 #include <vector>
 
 #define WINDOW_SIZE 256
+#define BATCH_LAYERS 64
 
 PIGLIT_GL_TEST_CONFIG_BEGIN
 
@@ -283,8 +287,8 @@ add_testcase(const struct testcase *tc)
 	testcases.push_back(*tc);
 }
 
-static bool
-run_testcase(const struct testcase *tc)
+static void
+draw_testcase(const struct testcase *tc)
 {
 	print_testcase(tc);
 
@@ -304,8 +308,13 @@ run_testcase(const struct testcase *tc)
 		    tc->num_points);
 
 	glDrawArraysInstanced(GL_POINTS, 0, tc->num_points, tc->num_instances);
+}
 
+static bool
+check_testcase(const struct testcase *tc, const GLubyte *layer)
+{
 	float *expected = new float[WINDOW_SIZE * WINDOW_SIZE * 4];
+	float *observed = new float[WINDOW_SIZE * WINDOW_SIZE * 4];
 	unsigned num_total =
 		tc->num_instances * tc->num_points * tc->num_invocations * tc->num_outputs;
 	memset(expected, 0, sizeof(float) * WINDOW_SIZE * WINDOW_SIZE * 4);
@@ -315,12 +324,58 @@ run_testcase(const struct testcase *tc)
 			expected[4 * i + 1] = 1.0;
 		expected[4 * i + 3] = 1.0;
 	}
-
-	int result = piglit_probe_image_rgba(0, 0, WINDOW_SIZE, WINDOW_SIZE, expected);
+	for (unsigned i = 0; i < WINDOW_SIZE * WINDOW_SIZE * 4; ++i)
+		observed[i] = layer[i] / 255.0;
+
+	int result = piglit_compare_images_color(0, 0, WINDOW_SIZE, WINDOW_SIZE, 4,
+						 piglit_tolerance, expected,
+						 observed);
+	if (!result) {
+		printf("Failed ");
+		print_testcase(tc);
+	}
 	delete[] expected;
+	delete[] observed;
 	return result;
 }
 
+/**
+ * Run the test cases [first, last) into the layers of tex, and read them
+ * back at once.
+ */
+static bool
+run_batch(GLuint fbo, GLuint tex, unsigned first, unsigned last)
+{
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+	for (unsigned i = first; i < last; ++i) {
+		glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+					  tex, 0, i - first);
+		draw_testcase(&testcases[i]);
+	}
+
+	GLubyte *layers = new GLubyte[BATCH_LAYERS * WINDOW_SIZE * WINDOW_SIZE * 4];
+	bool ok = true;
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+	glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE, layers);
+
+	for (unsigned i = first; i < last; ++i) {
+		if (!check_testcase(&testcases[i], layers + (i - first) *
+				    WINDOW_SIZE * WINDOW_SIZE * 4))
+			ok = false;
+	}
+	delete[] layers;
+
+	/* Show the last test case of the batch. */
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, piglit_winsys_fbo);
+	glBlitFramebuffer(0, 0, WINDOW_SIZE, WINDOW_SIZE,
+			  0, 0, WINDOW_SIZE, WINDOW_SIZE,
+			  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, piglit_winsys_fbo);
+	return ok;
+}
+
 static void
 generate_testcases_max(const testcase &tc, bool explicit_instances, bool explicit_points)
 {
@@ -535,12 +590,24 @@ enum piglit_result
 piglit_display(void)
 {
 	bool pass = true;
+	GLuint fbo, tex;
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, WINDOW_SIZE, WINDOW_SIZE,
+		     BATCH_LAYERS, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glGenFramebuffers(1, &fbo);
 
-	for (unsigned i = 0; i < testcases.size(); ++i) {
-		if (!run_testcase(&testcases[i]))
+	for (unsigned i = 0; i < testcases.size(); i += BATCH_LAYERS) {
+		unsigned last = MIN2(i + BATCH_LAYERS, testcases.size());
+
+		if (!run_batch(fbo, tex, i, last))
 			pass = false;
 	}
 
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteTextures(1, &tex);
+
 	if (!piglit_check_gl_error(GL_NO_ERROR))
 		pass = false;
 
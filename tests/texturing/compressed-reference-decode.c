@@ -0,0 +1,227 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file compressed-reference-decode.c
+ *
+ * Upload an image of random compressed blocks, read it back decoded with
+ * glGetTexImage() and compare every texel against piglit's reference
+ * decoder, so that all the modes and index values of the format are
+ * checked rather than a few texels of known color.
+ */
+
+#include "piglit-util-gl.h"
+
+#define SIZE 64
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 10;
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGB | PIGLIT_GL_VISUAL_DOUBLE;
+	config.khr_no_error_support = PIGLIT_NO_ERRORS;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+struct format {
+	GLenum token;
+	const char **extension;
+	bool is_signed;
+};
+
+static const char *S3TC[] = {
+	"GL_EXT_texture_compression_s3tc",
+	NULL
+};
+
+static const char *RGTC[] = {
+	"GL_ARB_texture_compression_rgtc",
+	NULL
+};
+
+static const char *RGTC_signed[] = {
+	"GL_ARB_texture_compression_rgtc",
+	"GL_EXT_texture_snorm",
+	NULL
+};
+
+static const char *LATC[] = {
+	"GL_EXT_texture_compression_latc",
+	NULL
+};
+
+static const char *LATC_signed[] = {
+	"GL_EXT_texture_compression_latc",
+	"GL_EXT_texture_snorm",
+	NULL
+};
+
+static const char *BPTC[] = {
+	"GL_ARB_texture_compression_bptc",
+	NULL
+};
+
+static const char *ETC2[] = {
+	"GL_ARB_ES3_compatibility",
+	NULL
+};
+
+/* The sRGB formats are left out, their decoded values are the same. */
+static const struct format formats[] = {
+	{ GL_COMPRESSED_RGB_S3TC_DXT1_EXT, S3TC, false },
+	{ GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, S3TC, false },
+	{ GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, S3TC, false },
+	{ GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, S3TC, false },
+
+	{ GL_COMPRESSED_RED_RGTC1, RGTC, false },
+	{ GL_COMPRESSED_SIGNED_RED_RGTC1, RGTC_signed, true },
+	{ GL_COMPRESSED_RG_RGTC2, RGTC, false },
+	{ GL_COMPRESSED_SIGNED_RG_RGTC2, RGTC_signed, true },
+
+	{ GL_COMPRESSED_LUMINANCE_LATC1_EXT, LATC, false },
+	{ GL_COMPRESSED_SIGNED_LUMINANCE_LATC1_EXT, LATC_signed, true },
+	{ GL_COMPRESSED_LUMINANCE_ALPHA_LATC2_EXT, LATC, false },
+	{ GL_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2_EXT, LATC_signed, true },
+
+	{ GL_COMPRESSED_RGBA_BPTC_UNORM, BPTC, false },
+
+	{ GL_COMPRESSED_RGB8_ETC2, ETC2, false },
+	{ GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, ETC2, false },
+	{ GL_COMPRESSED_RGBA8_ETC2_EAC, ETC2, false },
+	{ GL_COMPRESSED_R11_EAC, ETC2, false },
+	{ GL_COMPRESSED_SIGNED_R11_EAC, ETC2, true },
+	{ GL_COMPRESSED_RG11_EAC, ETC2, false },
+	{ GL_COMPRESSED_SIGNED_RG11_EAC, ETC2, true },
+};
+
+static const struct format *format;
+
+enum piglit_result
+piglit_display(void)
+{
+	/* UNREACHED */
+	return PIGLIT_FAIL;
+}
+
+static void
+usage(char **argv)
+{
+	int i;
+
+	fprintf(stderr, "Usage: %s <format>\n", argv[0]);
+	fprintf(stderr, "format is one of:\n");
+	for (i = 0; i < ARRAY_SIZE(formats); i++) {
+		fprintf(stderr, "  %s\n",
+			piglit_get_gl_enum_name(formats[i].token));
+	}
+	exit(1);
+}
+
+/**
+ * Fill \a data with random blocks. BPTC blocks get one of the eight
+ * modes, the reserved mode decodes to transparent black.
+ */
+static void
+make_blocks(uint8_t *data, unsigned size)
+{
+	unsigned bw, bh, bytes, i;
+
+	piglit_get_compressed_block_size(format->token, &bw, &bh, &bytes);
+
+	srand(0);
+	for (i = 0; i < size; i++)
+		data[i] = rand() & 0xff;
+
+	if (format->token == GL_COMPRESSED_RGBA_BPTC_UNORM) {
+		for (i = 0; i < size; i += bytes) {
+			unsigned mode = (i / bytes) % 8;
+
+			data[i] = (data[i] & ~((2u << mode) - 1)) |
+				  (1u << mode);
+		}
+	}
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	float tolerance[4];
+	unsigned size;
+	float *expected, *observed;
+	uint8_t *data;
+	GLuint tex;
+	GLenum token;
+	int i;
+	bool pass;
+
+	if (argc != 2)
+		usage(argv);
+
+	token = piglit_get_gl_enum_from_name(argv[1]);
+	for (i = 0; i < ARRAY_SIZE(formats); i++) {
+		if (formats[i].token == token)
+			format = &formats[i];
+	}
+	if (!format)
+		usage(argv);
+
+	for (i = 0; format->extension[i]; i++)
+		piglit_require_extension(format->extension[i]);
+
+	size = piglit_compressed_image_size(format->token, SIZE, SIZE);
+	data = malloc(size);
+	expected = malloc(SIZE * SIZE * 4 * sizeof(float));
+	observed = malloc(SIZE * SIZE * 4 * sizeof(float));
+
+	make_blocks(data, size);
+	piglit_decompress_image(format->token, SIZE, SIZE, data, expected);
+
+	/* glGetTexImage() returns luminance in red only. */
+	if (format->extension == LATC || format->extension == LATC_signed) {
+		for (i = 0; i < SIZE * SIZE; i++)
+			expected[i * 4 + 1] = expected[i * 4 + 2] = 0.0;
+	}
+
+	/* Implementations may round the interpolated values differently. */
+	for (i = 0; i < 4; i++)
+		tolerance[i] = 2.0 / (format->is_signed ? 127.0 : 255.0);
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glCompressedTexImage2D(GL_TEXTURE_2D, 0, format->token, SIZE, SIZE, 0,
+			       size, data);
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, observed);
+
+	pass = piglit_compare_images_color(0, 0, SIZE, SIZE, 4, tolerance,
+					   expected, observed);
+
+	glDeleteTextures(1, &tex);
+	free(data);
+	free(expected);
+	free(observed);
+
+	piglit_report_result(pass ? PIGLIT_PASS : PIGLIT_FAIL);
+}
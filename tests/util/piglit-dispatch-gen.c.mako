@@ -24,8 +24,38 @@
  */
 
 <%block filter='fake_whitespace'>\
+#ifdef PIGLIT_DISPATCH_STATS
+static const char *const stats_names[] = {
+% for alias_set in gl_registry.command_alias_map:
+>-------"${alias_set.primary_command.name}",
+% endfor
+};
+
+static struct dispatch_stats dispatch_stats[ARRAY_SIZE(stats_names)];
+
+#endif
 % for alias_set in gl_registry.command_alias_map:
 <% f0 = alias_set.primary_command %>\
+#ifdef PIGLIT_DISPATCH_STATS
+static PFN${f0.name.upper()}PROC real_${f0.name};
+
+static ${f0.c_return_type} APIENTRY
+stats_${f0.name}(${f0.c_named_param_list})
+{
+>-------int64_t stats_start = stats_begin(&dispatch_stats[${loop.index}]);
+% if f0.c_return_type != 'void':
+>-------${f0.c_return_type} stats_ret = .
+% else:
+>-------.
+% endif
+................real_${f0.name}(${f0.c_untyped_param_list});
+>-------stats_end(&dispatch_stats[${loop.index}], stats_start);
+% if f0.c_return_type != 'void':
+>-------return stats_ret;
+% endif
+}
+#endif
+
 static void*
 resolve_${f0.name}(void)
 {
@@ -68,8 +98,8 @@ resolve_${f0.name}(void)
 % endif
 
 % endfor
->-------unsupported("${f0.name}");
->-------return piglit_dispatch_${f0.name};
+>-------return unsupported_function("${f0.name}",
+>------->-------(void *) piglit_dispatch_${f0.name});
 }
 
 static ${f0.c_return_type} APIENTRY
@@ -77,6 +107,10 @@ stub_${f0.name}(${f0.c_named_param_list})
 {
 >-------check_initialized();
 >-------piglit_dispatch_${f0.name} = resolve_${f0.name}();
+#ifdef PIGLIT_DISPATCH_STATS
+>-------real_${f0.name} = piglit_dispatch_${f0.name};
+>-------piglit_dispatch_${f0.name} = stats_${f0.name};
+#endif
 >-------
 % if f0.c_return_type != 'void':
 ........return .
@@ -95,6 +129,23 @@ static void reset_dispatch_pointers(void)
 % endfor
 }
 
+static void resolve_dispatch_pointers(void)
+{
+>-------void *func;
+
+% for alias_set in gl_registry.command_alias_map:
+<% f0 = alias_set.primary_command %>\
+>-------func = resolve_${f0.name}();
+>-------if (func) {
+#ifdef PIGLIT_DISPATCH_STATS
+>------->-------real_${f0.name} = func;
+>------->-------func = (void *) stats_${f0.name};
+#endif
+>------->-------piglit_dispatch_${f0.name} = func;
+>-------}
+% endfor
+}
+
 static const char * function_names[] = {
 % for command in gl_registry.commands:
 >-------"${command.name}",
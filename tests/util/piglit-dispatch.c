@@ -20,6 +20,8 @@
  * IN THE SOFTWARE.
  */
 
+#include <inttypes.h>
+
 #include "piglit-dispatch.h"
 #include "piglit-util-gl.h"
 
@@ -65,6 +67,13 @@ static bool is_initialized = false;
 
 static piglit_dispatch_api dispatch_api;
 
+/**
+ * True while resolve_dispatch_pointers() fills the whole table.  Functions
+ * that can't be resolved then keep their stub, so that the error is
+ * reported when (and only if) the test calls them.
+ */
+static bool resolving_all = false;
+
 /**
  * Generated code calls this function to verify that the dispatch
  * mechanism has been properly initialized.
@@ -88,7 +97,7 @@ static piglit_dispatch_function_ptr
 get_core_proc(const char *name, int gl_10x_version)
 {
 	piglit_dispatch_function_ptr function_pointer = get_core_proc_address(name, gl_10x_version);
-	if (function_pointer == NULL)
+	if (function_pointer == NULL && !resolving_all)
 		get_proc_address_failure(name);
 	return function_pointer;
 }
@@ -101,11 +110,24 @@ static piglit_dispatch_function_ptr
 get_ext_proc(const char *name)
 {
 	piglit_dispatch_function_ptr function_pointer = get_ext_proc_address(name);
-	if (function_pointer == NULL)
+	if (function_pointer == NULL && !resolving_all)
 		get_proc_address_failure(name);
 	return function_pointer;
 }
 
+/**
+ * Generated code calls this function when none of the requirements of a
+ * function are met.  \p stub is returned as the function's new dispatch
+ * pointer.
+ */
+static void *
+unsupported_function(const char *name, void *stub)
+{
+	if (!resolving_all)
+		unsupported(name);
+	return stub;
+}
+
 /**
  * Generated code calls this function to determine whether a given GL
  * version is supported.
@@ -126,8 +148,106 @@ check_extension(const char *name)
 	return piglit_is_extension_supported(name);
 }
 
+#ifdef PIGLIT_DISPATCH_STATS
+/**
+ * How many entry points report_dispatch_stats() prints.
+ */
+#define STATS_REPORTED 20
+
+/**
+ * The calls of an entry point, counted by its instrumented wrapper, and the
+ * time spent in the ones that were timed.
+ */
+struct dispatch_stats {
+	uint64_t calls;
+	uint64_t timed_calls;
+	int64_t timed_nsec;
+};
+
+/**
+ * One call out of stats_interval of each entry point is timed, so that
+ * reading the clock doesn't dominate the cost of cheap calls.
+ */
+static unsigned stats_interval = 16;
+
+static inline int64_t
+stats_begin(struct dispatch_stats *stats)
+{
+	if (stats->calls++ % stats_interval)
+		return 0;
+	return piglit_time_get_nano();
+}
+
+static inline void
+stats_end(struct dispatch_stats *stats, int64_t start)
+{
+	if (!start)
+		return;
+	stats->timed_calls++;
+	stats->timed_nsec += piglit_time_get_nano() - start;
+}
+#endif
+
 #include "piglit-dispatch-gen.c"
 
+#ifdef PIGLIT_DISPATCH_STATS
+/**
+ * The time spent in all the calls of an entry point, estimated from the
+ * ones that were timed.
+ */
+static double
+stats_total_nsec(const struct dispatch_stats *stats)
+{
+	if (!stats->timed_calls)
+		return 0.0;
+	return (double) stats->timed_nsec / stats->timed_calls * stats->calls;
+}
+
+static int
+compare_stats(const void *x, const void *y)
+{
+	double x_nsec = stats_total_nsec(&dispatch_stats[*(const unsigned *) x]);
+	double y_nsec = stats_total_nsec(&dispatch_stats[*(const unsigned *) y]);
+
+	return x_nsec < y_nsec ? 1 : x_nsec > y_nsec ? -1 : 0;
+}
+
+/**
+ * Print the entry points the test spent the most time in to stderr.
+ */
+static void
+report_dispatch_stats(void)
+{
+	static unsigned order[ARRAY_SIZE(dispatch_stats)];
+	uint64_t total_calls = 0;
+	unsigned i, count = 0;
+
+	for (i = 0; i < ARRAY_SIZE(dispatch_stats); i++) {
+		if (dispatch_stats[i].calls) {
+			order[count++] = i;
+			total_calls += dispatch_stats[i].calls;
+		}
+	}
+	if (!count)
+		return;
+
+	qsort(order, count, sizeof(order[0]), compare_stats);
+
+	fprintf(stderr, "piglit: %" PRIu64 " GL calls to %u functions, "
+		"1 in %u timed\n", total_calls, count, stats_interval);
+	fprintf(stderr, "  %-40s %12s %12s %12s\n", "Function", "Calls",
+		"ns/call", "Total ms");
+	for (i = 0; i < count && i < STATS_REPORTED; i++) {
+		const struct dispatch_stats *stats = &dispatch_stats[order[i]];
+		double nsec = stats_total_nsec(stats);
+
+		fprintf(stderr, "  %-40s %12" PRIu64 " %12.0f %12.3f\n",
+			stats_names[order[i]], stats->calls,
+			nsec / stats->calls, nsec / 1000000.0);
+	}
+}
+#endif
+
 /**
  * Initialize the dispatch mechanism.
  *
@@ -158,6 +278,17 @@ check_extension(const char *name)
  * get_core_proc() or get_ext_proc() unexpectedly returned NULL.  It
  * is passed the name of the function that was passed to
  * get_core_proc() or get_ext_proc().
+ *
+ * Functions are normally resolved by a stub on their first call.  If the
+ * PIGLIT_DISPATCH_EAGER environment variable is set to true, the whole
+ * dispatch table is resolved here instead, so that calls never go through
+ * a stub.  Errors for unsupported functions are still only reported if
+ * the test calls them.
+ *
+ * When piglit is configured with PIGLIT_DISPATCH_STATS, every call goes
+ * through a wrapper which counts it and times one call out of
+ * PIGLIT_DISPATCH_STATS_INTERVAL (16 by default), and the functions the
+ * test spent the most time in are printed to stderr when it exits.
  */
 void
 piglit_dispatch_init(piglit_dispatch_api api,
@@ -178,6 +309,16 @@ piglit_dispatch_init(piglit_dispatch_api api,
 		reset_dispatch_pointers();
 	}
 
+#ifdef PIGLIT_DISPATCH_STATS
+	if (!is_initialized) {
+		const char *interval = getenv("PIGLIT_DISPATCH_STATS_INTERVAL");
+
+		if (interval && atoi(interval) > 0)
+			stats_interval = atoi(interval);
+		atexit(report_dispatch_stats);
+	}
+#endif
+
 	is_initialized = true;
 
 	/* Store the GL version and extension string for use by
@@ -188,6 +329,12 @@ piglit_dispatch_init(piglit_dispatch_api api,
 	 * check_extension().
 	 */
 	gl_version = piglit_get_gl_version();
+
+	if (piglit_env_var_as_boolean("PIGLIT_DISPATCH_EAGER", false)) {
+		resolving_all = true;
+		resolve_dispatch_pointers();
+		resolving_all = false;
+	}
 }
 
 /**
@@ -28,9 +28,15 @@
  * new piglit test cases. These functions initialize a framebuffer
  * object based on parameters passed.
  */
+#include <vector>
 #include "piglit-fbo.h"
 using namespace piglit_util_fbo;
 
+/**
+ * The GL objects of released Fbos, with the storage they still have.
+ */
+static std::vector<Fbo> pool;
+
 FboConfig::FboConfig(int num_samples, int width, int height)
 	: num_samples(num_samples),
 	  num_rb_attachments(1),
@@ -59,16 +65,98 @@ Fbo::Fbo()
 	  handle(0),
 	  depth_rb(0),
 	  stencil_rb(0),
-	  gl_objects_generated(false)
+	  gl_objects_generated(false),
+	  storage_config(0, 0, 0),
+	  has_storage(false)
 {
 	memset(color_tex, 0, PIGLIT_MAX_COLOR_ATTACHMENTS * sizeof(GLuint));
 	memset(color_rb, 0, PIGLIT_MAX_COLOR_ATTACHMENTS * sizeof(GLuint));
 }
 
+static bool
+same_color_storage(const FboConfig &a, const FboConfig &b)
+{
+	return a.num_samples == b.num_samples &&
+		a.width == b.width &&
+		a.height == b.height &&
+		a.color_internalformat == b.color_internalformat;
+}
+
+static bool
+same_color_texture_storage(const FboConfig &a, const FboConfig &b)
+{
+	return same_color_storage(a, b) &&
+		a.use_rect == b.use_rect &&
+		a.layers == b.layers &&
+		a.color_format == b.color_format;
+}
+
+static GLenum
+depth_storage_format(const FboConfig &config)
+{
+	return config.combine_depth_stencil ? GL_DEPTH_STENCIL
+		: config.depth_internalformat;
+}
+
+static GLenum
+stencil_storage_format(const FboConfig &config)
+{
+	return config.combine_depth_stencil ? GL_NONE
+		: config.stencil_internalformat;
+}
+
+/**
+ * The target the color textures of config are bound to, which they
+ * keep for as long as they exist.
+ */
+static GLenum
+color_texture_target(const FboConfig &config)
+{
+	if (config.num_samples == 0)
+		return config.use_rect ? GL_TEXTURE_RECTANGLE : GL_TEXTURE_2D;
+	return config.layers ? GL_TEXTURE_2D_MULTISAMPLE_ARRAY
+		: GL_TEXTURE_2D_MULTISAMPLE;
+}
+
+static bool
+same_storage(const FboConfig &a, const FboConfig &b)
+{
+	return same_color_texture_storage(a, b) &&
+		a.num_rb_attachments == b.num_rb_attachments &&
+		a.num_tex_attachments == b.num_tex_attachments &&
+		depth_storage_format(a) == depth_storage_format(b) &&
+		stencil_storage_format(a) == stencil_storage_format(b);
+}
+
+/**
+ * Take the GL objects of a released Fbo whose textures can be used with
+ * new_config, preferring one whose storage it doesn't change, or
+ * generate new ones.
+ */
 void
-Fbo::generate_gl_objects(void)
+Fbo::generate_gl_objects(const FboConfig &new_config)
 {
 	GLint max_color_attachments;
+	size_t best = pool.size();
+
+	for (size_t i = 0; i < pool.size(); i++) {
+		const FboConfig &pooled = pool[i].storage_config;
+
+		if (color_texture_target(pooled) !=
+		    color_texture_target(new_config))
+			continue;
+		best = i;
+		if (same_storage(pooled, new_config))
+			break;
+	}
+
+	if (best < pool.size()) {
+		*this = pool[best];
+		pool.erase(pool.begin() + best);
+		reset_attachments();
+		return;
+	}
+
 	glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &max_color_attachments);
 	glGenFramebuffers(1, &handle);
 	glGenTextures(max_color_attachments, color_tex);
@@ -78,15 +166,75 @@ Fbo::generate_gl_objects(void)
 	gl_objects_generated = true;
 }
 
+/**
+ * Detach the buffers of the previous user of a pooled framebuffer and
+ * restore the default draw and read buffers, which new_config might not
+ * set.
+ */
+void
+Fbo::reset_attachments()
+{
+	static const GLenum draw_buffer = GL_COLOR_ATTACHMENT0;
+	GLint read_fbo;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, handle);
+
+	for (int i = 0; i < storage_config.num_rb_attachments; i++) {
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+					  storage_config.rb_attachment[i],
+					  GL_RENDERBUFFER, 0);
+	}
+	for (int i = 0; i < storage_config.num_tex_attachments; i++) {
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+					  storage_config.tex_attachment[i],
+					  GL_RENDERBUFFER, 0);
+	}
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+				  GL_RENDERBUFFER, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT,
+				  GL_RENDERBUFFER, 0);
+	glDrawBuffers(1, &draw_buffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, piglit_winsys_fbo);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, read_fbo);
+}
+
+/**
+ * Whether color_rb[index] already has the storage config asks for.
+ */
+bool
+Fbo::has_color_rb_storage(const FboConfig &config, int index) const
+{
+	return has_storage &&
+		storage_config.color_internalformat != GL_NONE &&
+		index < storage_config.num_rb_attachments &&
+		same_color_storage(storage_config, config);
+}
+
+/**
+ * Whether color_tex[index] already has the storage config asks for.
+ */
+bool
+Fbo::has_color_tex_storage(const FboConfig &config, int index) const
+{
+	return has_storage &&
+		storage_config.color_internalformat != GL_NONE &&
+		index < storage_config.num_tex_attachments &&
+		same_color_texture_storage(storage_config, config);
+}
+
 void
 Fbo::attach_color_renderbuffer(const FboConfig &config, int index)
 {
-	glBindRenderbuffer(GL_RENDERBUFFER, color_rb[index]);
-	glRenderbufferStorageMultisample(GL_RENDERBUFFER,
-					 config.num_samples,
-					 config.color_internalformat,
-					 config.width,
-					 config.height);
+	if (!has_color_rb_storage(config, index)) {
+		glBindRenderbuffer(GL_RENDERBUFFER, color_rb[index]);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER,
+						 config.num_samples,
+						 config.color_internalformat,
+						 config.width,
+						 config.height);
+	}
 	glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER,
 				  config.rb_attachment[index],
 				  GL_RENDERBUFFER, color_rb[index]);
@@ -99,15 +247,17 @@ Fbo::attach_color_texture(const FboConfig &config, int index)
 	glBindTexture(target, color_tex[index]);
 	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexImage2D(target,
-		     0 /* level */,
-		     config.color_internalformat,
-		     config.width,
-		     config.height,
-		     0 /* border */,
-		     config.color_format /* format */,
-		     GL_BYTE /* type */,
-		     NULL /* data */);
+	if (!has_color_tex_storage(config, index)) {
+		glTexImage2D(target,
+			     0 /* level */,
+			     config.color_internalformat,
+			     config.width,
+			     config.height,
+			     0 /* border */,
+			     config.color_format /* format */,
+			     GL_BYTE /* type */,
+			     NULL /* data */);
+	}
 	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER,
 			       config.tex_attachment[index],
 			       target,
@@ -118,14 +268,18 @@ Fbo::attach_color_texture(const FboConfig &config, int index)
 void
 Fbo::attach_multisample_color_texture(const FboConfig &config, int index)
 {
+	bool reuse = has_color_tex_storage(config, index);
+
 	if (config.layers == 0) {
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, color_tex[index]);
-		glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE,
-					config.num_samples,
-					config.color_internalformat,
-					config.width,
-					config.height,
-					GL_TRUE /* fixed sample locations */);
+		if (!reuse) {
+			glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE,
+						config.num_samples,
+						config.color_internalformat,
+						config.width,
+						config.height,
+						GL_TRUE /* fixed sample locations */);
+		}
 		glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER,
 				       config.tex_attachment[index],
 				       GL_TEXTURE_2D_MULTISAMPLE,
@@ -133,13 +287,15 @@ Fbo::attach_multisample_color_texture(const FboConfig &config, int index)
 				       0 /* level */);
 	} else {
 		glBindTexture(GL_TEXTURE_2D_MULTISAMPLE_ARRAY, color_tex[index]);
-		glTexImage3DMultisample(GL_TEXTURE_2D_MULTISAMPLE_ARRAY,
-					config.num_samples,
-					config.color_internalformat,
-					config.width,
-					config.height,
-					config.layers,
-					GL_TRUE /* fixed sample locations */);
+		if (!reuse) {
+			glTexImage3DMultisample(GL_TEXTURE_2D_MULTISAMPLE_ARRAY,
+						config.num_samples,
+						config.color_internalformat,
+						config.width,
+						config.height,
+						config.layers,
+						GL_TRUE /* fixed sample locations */);
+		}
 		glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER,
 					  config.tex_attachment[index],
 					  color_tex[index],
@@ -191,10 +347,22 @@ Fbo::setup(const FboConfig &new_config)
 bool
 Fbo::try_setup(const FboConfig &new_config)
 {
+	if (!gl_objects_generated)
+		generate_gl_objects(new_config);
+
 	this->config = new_config;
 
-	if (!gl_objects_generated)
-		generate_gl_objects();
+	/* Whether depth_rb and stencil_rb already have their storage */
+	bool same_size = has_storage &&
+		storage_config.num_samples == config.num_samples &&
+		storage_config.width == config.width &&
+		storage_config.height == config.height;
+	bool reuse_depth = same_size &&
+		depth_storage_format(storage_config) ==
+		depth_storage_format(config);
+	bool reuse_stencil = same_size &&
+		stencil_storage_format(storage_config) ==
+		stencil_storage_format(config);
 
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, handle);
 
@@ -223,41 +391,50 @@ Fbo::try_setup(const FboConfig &new_config)
 
 	/* Depth/stencil buffer(s) */
 	if (config.combine_depth_stencil) {
-		glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
-		glRenderbufferStorageMultisample(GL_RENDERBUFFER,
-						 config.num_samples,
-						 GL_DEPTH_STENCIL,
-						 config.width,
-						 config.height);
+		if (!reuse_depth) {
+			glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+			glRenderbufferStorageMultisample(GL_RENDERBUFFER,
+							 config.num_samples,
+							 GL_DEPTH_STENCIL,
+							 config.width,
+							 config.height);
+		}
 		glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER,
 					  GL_DEPTH_STENCIL_ATTACHMENT,
 					  GL_RENDERBUFFER, depth_rb);
 	} else {
 		if (config.stencil_internalformat != GL_NONE) {
-			glBindRenderbuffer(GL_RENDERBUFFER, stencil_rb);
-			glRenderbufferStorageMultisample(GL_RENDERBUFFER,
-							 config.num_samples,
-							 config.stencil_internalformat,
-							 config.width,
-							 config.height);
+			if (!reuse_stencil) {
+				glBindRenderbuffer(GL_RENDERBUFFER, stencil_rb);
+				glRenderbufferStorageMultisample(GL_RENDERBUFFER,
+								 config.num_samples,
+								 config.stencil_internalformat,
+								 config.width,
+								 config.height);
+			}
 			glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER,
 						  GL_STENCIL_ATTACHMENT,
 						  GL_RENDERBUFFER, stencil_rb);
 		}
 
 		if (config.depth_internalformat != GL_NONE) {
-			glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
-			glRenderbufferStorageMultisample(GL_RENDERBUFFER,
-							 config.num_samples,
-							 config.depth_internalformat,
-							 config.width,
-							 config.height);
+			if (!reuse_depth) {
+				glBindRenderbuffer(GL_RENDERBUFFER, depth_rb);
+				glRenderbufferStorageMultisample(GL_RENDERBUFFER,
+								 config.num_samples,
+								 config.depth_internalformat,
+								 config.width,
+								 config.height);
+			}
 			glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER,
 						  GL_DEPTH_ATTACHMENT,
 						  GL_RENDERBUFFER, depth_rb);
 		}
 	}
 
+	storage_config = config;
+	has_storage = true;
+
 	bool success = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER)
 		== GL_FRAMEBUFFER_COMPLETE;
 
@@ -266,6 +443,48 @@ Fbo::try_setup(const FboConfig &new_config)
 	return success;
 }
 
+/**
+ * Make the next setup() reallocate all the buffers, for tests that
+ * changed their storage themselves.
+ */
+void
+Fbo::invalidate()
+{
+	has_storage = false;
+}
+
+/**
+ * Hand the GL objects to the pool for the next Fbo to be set up, and
+ * forget them.  The Fbo can be set up again afterwards.
+ */
+void
+Fbo::release()
+{
+	if (gl_objects_generated)
+		pool.push_back(*this);
+	*this = Fbo();
+}
+
+/**
+ * Delete the GL objects of all the released Fbos.
+ */
+void
+Fbo::delete_pool()
+{
+	GLint max_color_attachments;
+	glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &max_color_attachments);
+
+	for (size_t i = 0; i < pool.size(); i++) {
+		Fbo &fbo = pool[i];
+		glDeleteFramebuffers(1, &fbo.handle);
+		glDeleteTextures(max_color_attachments, fbo.color_tex);
+		glDeleteRenderbuffers(max_color_attachments, fbo.color_rb);
+		glDeleteRenderbuffers(1, &fbo.depth_rb);
+		glDeleteRenderbuffers(1, &fbo.stencil_rb);
+	}
+	pool.clear();
+}
+
 void
 Fbo::set_viewport()
 {
@@ -130,6 +130,12 @@ namespace piglit_util_fbo {
 	 * For the supersampled framebuffer object we use a texture as the
 	 * backing store for the color buffer so that we can use a fragment
 	 * shader to blend down to the reference image.
+	 *
+	 * Setting up an Fbo again only reallocates the buffers whose
+	 * storage the new config changes.  release() hands the GL objects
+	 * to a pool, from which the next Fbo set up with the same config
+	 * takes them, so tests sweeping sample counts or formats don't keep
+	 * allocating and freeing the same buffers.
 	 */
 	class Fbo
 	{
@@ -140,6 +146,10 @@ namespace piglit_util_fbo {
 		void setup(const FboConfig &new_config);
 		bool try_setup(const FboConfig &new_config);
 
+		void invalidate();
+		void release();
+		static void delete_pool();
+
 		void set_viewport();
 
 		FboConfig config;
@@ -172,17 +182,29 @@ namespace piglit_util_fbo {
 		GLuint stencil_rb;
 
 	private:
-		void generate_gl_objects();
+		void generate_gl_objects(const FboConfig &new_config);
+		void reset_attachments();
 		void attach_color_renderbuffer(const FboConfig &config,
 					       int index);
 		void attach_color_texture(const FboConfig &config, int index);
 		void attach_multisample_color_texture(const FboConfig &config,
 						      int index);
+		bool has_color_rb_storage(const FboConfig &config,
+					  int index) const;
+		bool has_color_tex_storage(const FboConfig &config,
+					   int index) const;
 
 		/**
 		 * True if generate_gl_objects has been called and color_tex,
 		 * color_rb, depth_rb, and stencil_rb have been initialized.
 		 */
 		bool gl_objects_generated;
+
+		/**
+		 * The config the storage of the buffers was last allocated
+		 * with, if has_storage is true.
+		 */
+		FboConfig storage_config;
+		bool has_storage;
 	};
 }
@@ -120,32 +120,31 @@ void piglit_cl_program_test_init(const int argc,
 	}
 }
 
-/* Run by piglit_cl_framework_run() */
-enum piglit_result
-piglit_cl_program_test_run(const int argc,
-                           const char** argv,
-                           void* void_config,
-                           int version,
-                           cl_platform_id platform_id,
-                           cl_device_id device_id)
-{
-	enum piglit_result result;
-
-	struct piglit_cl_program_test_config* config = void_config;
-	struct piglit_cl_program_test_env env = {
-		.version = version,
-		.clc_version = 0,
-
-		.platform_id = NULL,
-		.device_id = NULL,
-
-		.context = NULL,
-
-		.program = NULL,
+/*
+ * A run of the test on a platform or device, from the creation of its
+ * context to the release of its program.  The build of the program is
+ * started by start_program_run() and waited for by finish_program_run(), so
+ * that the runs prepared ahead by piglit_cl_program_test_prepare() build
+ * while the earlier ones execute.
+ */
+struct program_run {
+	int version;
+	cl_platform_id platform_id;
+	cl_device_id device_id;
+	bool taken; /* Run by piglit_cl_program_test_run() */
+
+	enum piglit_result result; /* PIGLIT_PASS unless the run is over */
+	struct piglit_cl_program_test_env env;
+	struct piglit_cl_program_build* build;
+};
 
-		.kernel = NULL,
-	};
+static struct program_run* prepared_runs = NULL;
+static unsigned int num_prepared_runs = 0;
 
+static void
+start_program_run(struct piglit_cl_program_test_config* config,
+                  struct program_run* run)
+{
 	int i;
 	char* build_options = malloc(1 * sizeof(char));
 	unsigned int num_devices;
@@ -154,13 +153,19 @@ piglit_cl_program_test_run(const int argc,
 	build_options[0] = '\0';
 
 	/* Set environment */
-	env.platform_id = platform_id;
-	env.device_id = device_id;
-	env.version = version;
+	run->result = PIGLIT_PASS;
+	run->build = NULL;
+	run->env.version = run->version;
+	run->env.clc_version = 0;
+	run->env.platform_id = run->platform_id;
+	run->env.device_id = run->device_id;
+	run->env.context = NULL;
+	run->env.program = NULL;
+	run->env.kernel = NULL;
 
 	/* Get device ids */
 	if(config->run_per_platform) {
-		num_devices = piglit_cl_get_device_ids(platform_id,
+		num_devices = piglit_cl_get_device_ids(run->platform_id,
 		                                       CL_DEVICE_TYPE_ALL,
 		                                       &device_ids);
 	}
@@ -171,58 +176,65 @@ piglit_cl_program_test_run(const int argc,
 			int device_clc_version =
 				piglit_cl_get_device_cl_c_version(device_ids[i]);
 
-			if(device_clc_version < env.clc_version || env.clc_version == 0) {
-				env.clc_version = device_clc_version;
+			if(   device_clc_version < run->env.clc_version
+			   || run->env.clc_version == 0) {
+				run->env.clc_version = device_clc_version;
 			}
 		}
 	} else { // config->run_per_device
-		env.clc_version = piglit_cl_get_device_cl_c_version(device_id);
+		run->env.clc_version =
+			piglit_cl_get_device_cl_c_version(run->device_id);
 	}
-	if(env.clc_version > version) {
+	if(run->env.clc_version > run->version) {
 		printf("#   Lowering OpenCL C version to %d.%d because of OpenCL version.\n",
-		       version/10, version%10);
-		env.clc_version = version;
+		       run->version/10, run->version%10);
+		run->env.clc_version = run->version;
 	}
 	if(   config->clc_version_max > 0
-	   && env.clc_version > config->clc_version_max) {
+	   && run->env.clc_version > config->clc_version_max) {
 		printf("#   Lowering OpenCL C version to %d.%d because of clc_version_max.\n",
 		       config->clc_version_max/10, config->clc_version_max%10);
-		env.clc_version = config->clc_version_max;
+		run->env.clc_version = config->clc_version_max;
 	}
-	if(env.clc_version < config->clc_version_min) {
+	if(run->env.clc_version < config->clc_version_min) {
 		printf("Trying to run test with OpenCL C version (%d.%d) ""lower than clc_version_min: %d\n",
-		       env.clc_version/10, env.clc_version%10,
+		       run->env.clc_version/10, run->env.clc_version%10,
 		       config->clc_version_min);
-		return PIGLIT_SKIP;
+		run->result = PIGLIT_SKIP;
+		goto end;
 	}
 
 	printf("#   OpenCL C version: %d.%d\n",
-	       env.clc_version/10, env.clc_version%10);
+	       run->env.clc_version/10, run->env.clc_version%10);
 
 	/* Create context */
 	if(config->run_per_platform) {
-		env.context = piglit_cl_create_context(platform_id, device_ids,
-		                                       num_devices);
+		run->env.context = piglit_cl_create_context(run->platform_id,
+		                                            device_ids,
+		                                            num_devices);
 	} else { // config->run_per_device
-		env.context = piglit_cl_create_context(platform_id, &device_id, 1);
+		run->env.context = piglit_cl_create_context(run->platform_id,
+		                                            &run->device_id, 1);
 	}
 
 	if(config->need_image_support) {
 		bool image_support = false;
 		if(config->run_per_platform) {
-			image_support = piglit_cl_get_context_image_support(env.context);
+			image_support = piglit_cl_get_context_image_support(run->env.context);
 		} else { // config->run_per_device
-			image_support = piglit_cl_get_device_image_support(env.device_id);
+			image_support = piglit_cl_get_device_image_support(run->env.device_id);
 		}
 
 		if(!image_support) {
 			printf("Test need image support and none was found\n");
-			return PIGLIT_SKIP;
+			run->result = PIGLIT_SKIP;
+			goto end;
 		}
 	}
 
-	if(env.context == NULL) {
-		return PIGLIT_FAIL;
+	if(run->env.context == NULL) {
+		run->result = PIGLIT_FAIL;
+		goto end;
 	}
 
 	/* Set build options */
@@ -234,100 +246,77 @@ piglit_cl_program_test_run(const int argc,
 		free(old);
 	}
 
-	if(env.clc_version > 10) {
+	if(run->env.clc_version > 10) {
 		//If -cl-std was already in config->build_options, use what the test requested
 		if (!strstr(build_options, "-cl-std")){
 			char* template = " -cl-std=CL%d.%d";
 			char* old = build_options;
 			build_options = malloc((strlen(old) + strlen(template) + 1) * sizeof(char));
 			strcpy(build_options, old);
-			sprintf(build_options+strlen(old), template, env.clc_version/10,
-								     env.clc_version%10);
+			sprintf(build_options+strlen(old), template,
+			        run->env.clc_version/10,
+			        run->env.clc_version%10);
 			free(old);
 		}
 	}
 
 	printf("#   Build options: %s\n", build_options);
 
-	/* Create and build program */
+	/* Create program and start building it */
 	if(config->program_source != NULL) {
-		if(!config->expect_build_fail) {
-			env.program = piglit_cl_build_program_with_source(env.context,
-			                                                  1,
-			                                                  &config->program_source,
-			                                                  build_options);
-		} else {
-			env.program = piglit_cl_fail_build_program_with_source(env.context,
-			                                                       1,
-			                                                       &config->program_source,
-			                                                       build_options);
-		}
+		run->build = piglit_cl_start_build_program_with_source(run->env.context,
+		                                                       1,
+		                                                       &config->program_source,
+		                                                       build_options,
+		                                                       config->expect_build_fail);
 	} else if(config->program_source_file != NULL) {
 		unsigned int size;
 		char* program_source;
 
 		program_source = piglit_load_text_file(config->program_source_file, &size);
 		if(program_source != NULL && size > 0) {
-			if(!config->expect_build_fail) {
-				env.program = piglit_cl_build_program_with_source(env.context,
-				                                                  1,
-				                                                  &program_source,
-				                                                  build_options);
-			} else {
-				env.program = piglit_cl_fail_build_program_with_source(env.context,
-				                                                       1,
-				                                                       &program_source,
-				                                                       build_options);
-			}
+			run->build = piglit_cl_start_build_program_with_source(run->env.context,
+			                                                       1,
+			                                                       &program_source,
+			                                                       build_options,
+			                                                       config->expect_build_fail);
 		} else {
 			fprintf(stderr, "Program source file %s does not exists or is empty\n",
 			        config->program_source_file);
-			return PIGLIT_WARN;
+			run->result = PIGLIT_WARN;
 		}
 		free(program_source);
 	} else if(config->program_binary != NULL) {
 		size_t length = strlen((char*)config->program_binary);
 
-		if(!config->expect_build_fail) {
-			env.program = piglit_cl_build_program_with_binary(env.context,
-			                                                  &length,
-			                                                  &config->program_binary,
-			                                                  build_options);
-		} else {
-			env.program = piglit_cl_fail_build_program_with_binary(env.context,
-			                                                       &length,
-			                                                       &config->program_binary,
-			                                                       build_options);
-		}
+		run->build = piglit_cl_start_build_program_with_binary(run->env.context,
+		                                                       &length,
+		                                                       &config->program_binary,
+		                                                       build_options,
+		                                                       config->expect_build_fail);
 	} else if(config->program_binary_file != NULL) {
 		unsigned int length;
-		size_t* lengths = malloc(sizeof(size_t) * env.context->num_devices);
-		unsigned char** program_binaries = malloc(sizeof(unsigned char*) * env.context->num_devices);
+		size_t* lengths = malloc(sizeof(size_t) * run->env.context->num_devices);
+		unsigned char** program_binaries = malloc(sizeof(unsigned char*) * run->env.context->num_devices);
 
 		((char**)program_binaries)[0] =
 			piglit_load_text_file(config->program_binary_file, &length);
 		lengths[0] = length;
-		for(i = 1; i < env.context->num_devices; i++) {
+		for(i = 1; i < run->env.context->num_devices; i++) {
 			lengths[i] = lengths[0];
 			program_binaries[i] = program_binaries[0];
 		}
 
 		if(((char**)program_binaries)[0] != NULL && length > 0) {
-			if(!config->expect_build_fail) {
-				env.program = piglit_cl_build_program_with_binary(env.context,
-				                                                  lengths,
-				                                                  program_binaries,
-				                                                  build_options);
-			} else {
-				env.program = piglit_cl_fail_build_program_with_binary(env.context,
-				                                                       lengths,
-				                                                       program_binaries,
-				                                                       build_options);
-			}
+			run->build = piglit_cl_start_build_program_with_binary(run->env.context,
+			                                                       lengths,
+			                                                       program_binaries,
+			                                                       build_options,
+			                                                       config->expect_build_fail);
 		} else {
 			fprintf(stderr, "Program binary file %s does not exists or is empty\n",
 			        config->program_source_file);
-			return PIGLIT_WARN;
+			run->result = PIGLIT_WARN;
 		}
 
 		free(program_binaries[0]);
@@ -335,44 +324,123 @@ piglit_cl_program_test_run(const int argc,
 		free(lengths);
 	}
 
+end:
+	/* Release retrieved device IDs */
+	if(config->run_per_platform) {
+		free(device_ids);
+	}
+
 	free(build_options);
+}
+
+static enum piglit_result
+finish_program_run(const int argc,
+                   const char** argv,
+                   struct piglit_cl_program_test_config* config,
+                   struct program_run* run)
+{
+	enum piglit_result result = run->result;
+	struct piglit_cl_program_test_env* env = &run->env;
 
-	if(env.program == NULL) {
+	if(result != PIGLIT_PASS) {
+		goto end;
+	}
+
+	/* Wait for the program */
+	env->program = piglit_cl_finish_build_program(run->build);
+	if(env->program == NULL) {
 		result = PIGLIT_FAIL;
 		goto end;
 	}
 
 	/* Create kernel(s) */
 	if(config->kernel_name != NULL) {
-		env.kernel = piglit_cl_create_kernel(env.program, config->kernel_name);
+		env->kernel = piglit_cl_create_kernel(env->program,
+		                                      config->kernel_name);
 
-		if(env.kernel == NULL) {
+		if(env->kernel == NULL) {
 			result = PIGLIT_FAIL;
 			goto end;
 		}
 	}
 
 	/* Run the actual test */
-	result = config->_program_test(argc, argv, config, &env);
+	result = config->_program_test(argc, argv, config, env);
 
 end:
-        /* Release retrieved device IDs */
-        if(config->run_per_platform) {
-                free(device_ids);
-        }
-
 	/* Release kernel(s) */
-	if(env.kernel != NULL) {
-		clReleaseKernel(env.kernel);
+	if(env->kernel != NULL) {
+		clReleaseKernel(env->kernel);
 	}
 
 	/* Release program */
-	if (env.program != NULL) {
-		clReleaseProgram(env.program);
+	if (env->program != NULL) {
+		clReleaseProgram(env->program);
 	}
 
 	/* Release context */
-	piglit_cl_release_context(env.context);
+	if(env->context != NULL) {
+		piglit_cl_release_context(env->context);
+	}
 
 	return result;
 }
+
+/*
+ * Run by piglit_cl_framework_run() for each run before the first one, start
+ * building the program of the run.
+ */
+void
+piglit_cl_program_test_prepare(const int argc,
+                               const char** argv,
+                               void* void_config,
+                               int version,
+                               cl_platform_id platform_id,
+                               cl_device_id device_id)
+{
+	struct program_run* run;
+
+	prepared_runs = realloc(prepared_runs,
+	                        (num_prepared_runs + 1) * sizeof(*prepared_runs));
+	run = &prepared_runs[num_prepared_runs++];
+	run->version = version;
+	run->platform_id = platform_id;
+	run->device_id = device_id;
+	run->taken = false;
+
+	start_program_run(void_config, run);
+}
+
+/* Run by piglit_cl_framework_run() */
+enum piglit_result
+piglit_cl_program_test_run(const int argc,
+                           const char** argv,
+                           void* void_config,
+                           int version,
+                           cl_platform_id platform_id,
+                           cl_device_id device_id)
+{
+	struct piglit_cl_program_test_config* config = void_config;
+	struct program_run run;
+	unsigned int i;
+
+	/* Take the prepared run, or start one */
+	for(i = 0; i < num_prepared_runs; i++) {
+		if(   !prepared_runs[i].taken
+		   && prepared_runs[i].version == version
+		   && prepared_runs[i].platform_id == platform_id
+		   && prepared_runs[i].device_id == device_id) {
+			prepared_runs[i].taken = true;
+			run = prepared_runs[i];
+			break;
+		}
+	}
+	if(i == num_prepared_runs) {
+		run.version = version;
+		run.platform_id = platform_id;
+		run.device_id = device_id;
+		start_program_run(config, &run);
+	}
+
+	return finish_program_run(argc, argv, config, &run);
+}
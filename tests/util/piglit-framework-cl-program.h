@@ -94,6 +94,7 @@ PIGLIT_CL_DEFINE_TEST_CONFIG_END
 piglit_cl_get_empty_test_config_t piglit_cl_get_empty_program_test_config;
 piglit_cl_test_init_t piglit_cl_program_test_init;
 piglit_cl_test_run_t piglit_cl_program_test_run;
+piglit_cl_test_prepare_t piglit_cl_program_test_prepare;
 
 /**
  * \def PIGLIT_CL_PROGRAM_TEST_CONFIG_BEGIN
@@ -129,6 +130,7 @@ piglit_cl_test_run_t piglit_cl_program_test_run;
         config._program_test = piglit_cl_test;                               \
         config._init_test = config.init_func;                                \
         config.init_func = piglit_cl_program_test_init;                      \
+        config._test_prepare = piglit_cl_program_test_prepare;               \
                                                                              \
         PIGLIT_CL_TEST_CONFIG_END
 
@@ -23,6 +23,9 @@
 
 #include <stdlib.h>
 #include <regex.h>
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "piglit-framework-cl.h"
 
@@ -35,6 +38,7 @@ const struct piglit_cl_test_config_header
 
 	.run_per_platform = false,
 	.run_per_device = false,
+	.thread_safe = false,
 
 	.platform_regex = NULL,
 	.device_regex = NULL,
@@ -81,6 +85,141 @@ print_test_info(const struct piglit_cl_test_config_header* config,
 	}
 }
 
+/*
+ * A run of the test on one device.  With PIGLIT_CL_PARALLEL_DEVICES the runs
+ * of all devices are collected first and then started on a thread each.
+ * Otherwise they are collected if the runner prepares them, and run one
+ * after the other once all of them are prepared.
+ */
+struct device_run {
+	int version;
+	cl_platform_id platform_id;
+	cl_device_id device_id;
+	enum piglit_result result;
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_t thread;
+#endif
+};
+
+struct device_run_args {
+	int argc;
+	char** argv;
+	struct piglit_cl_test_config_header* config;
+	struct device_run* run;
+};
+
+static void*
+device_run_thread(void* data)
+{
+	struct device_run_args* args = data;
+
+	args->run->result = args->config->_test_run(args->argc,
+	                                            (const char**)args->argv,
+	                                            (void*)args->config,
+	                                            args->run->version,
+	                                            args->run->platform_id,
+	                                            args->run->device_id);
+	return NULL;
+}
+
+static bool
+get_parallel_devices_arg(const struct piglit_cl_test_config_header* config)
+{
+	const char* env = getenv("PIGLIT_CL_PARALLEL_DEVICES");
+
+	if(env == NULL || !strcmp(env, "") || !strcmp(env, "0")) {
+		return false;
+	}
+
+#ifdef PIGLIT_HAS_PTHREADS
+	if(!config->thread_safe) {
+		printf("# Test can not run devices in parallel, running them one after the other.\n");
+		return false;
+	}
+	return true;
+#else
+	printf("# Piglit was built without threads, running devices one after the other.\n");
+	return false;
+#endif
+}
+
+/* Run the collected device runs, each on its own thread */
+static enum piglit_result
+run_devices_in_parallel(int argc, char** argv,
+                        struct piglit_cl_test_config_header* config,
+                        struct device_run* runs, unsigned int num_runs)
+{
+	enum piglit_result result = PIGLIT_SKIP;
+	struct device_run_args* args = malloc(num_runs * sizeof(*args));
+	unsigned int i;
+
+	for(i = 0; i < num_runs; i++) {
+		args[i].argc = argc;
+		args[i].argv = argv;
+		args[i].config = config;
+		args[i].run = &runs[i];
+		runs[i].result = PIGLIT_FAIL;
+	}
+
+#ifdef PIGLIT_HAS_PTHREADS
+	for(i = 0; i < num_runs; i++) {
+		if(pthread_create(&runs[i].thread, NULL, device_run_thread,
+		                  &args[i])) {
+			fprintf(stderr, "Could not create a thread, running device in this one.\n");
+			device_run_thread(&args[i]);
+			runs[i].thread = pthread_self();
+		}
+	}
+	for(i = 0; i < num_runs; i++) {
+		if(!pthread_equal(runs[i].thread, pthread_self())) {
+			pthread_join(runs[i].thread, NULL);
+		}
+	}
+#else
+	for(i = 0; i < num_runs; i++) {
+		device_run_thread(&args[i]);
+	}
+#endif
+
+	for(i = 0; i < num_runs; i++) {
+		piglit_merge_result(&result, runs[i].result);
+	}
+
+	free(args);
+	return result;
+}
+
+/*
+ * Prepare all the collected device runs, then run them in order.  The work
+ * the runner starts in _test_prepare, like building the programs, overlaps
+ * the earlier runs.
+ */
+static enum piglit_result
+run_prepared_devices(int argc, char** argv,
+                     struct piglit_cl_test_config_header* config,
+                     struct device_run* runs, unsigned int num_runs)
+{
+	enum piglit_result result = PIGLIT_SKIP;
+	unsigned int i;
+
+	for(i = 0; i < num_runs; i++) {
+		config->_test_prepare(argc, (const char**)argv, (void*)config,
+		                      runs[i].version, runs[i].platform_id,
+		                      runs[i].device_id);
+	}
+	for(i = 0; i < num_runs; i++) {
+		piglit_merge_result(&result,
+		                    config->_test_run(argc,
+		                                      (const char**)argv,
+		                                      (void*)config,
+		                                      runs[i].version,
+		                                      runs[i].platform_id,
+		                                      runs[i].device_id));
+	}
+
+	return result;
+}
+
 /* Check extensions */
 
 bool check_platform_extensions(cl_platform_id platform_id, char* extensions)
@@ -222,6 +361,13 @@ int piglit_cl_framework_run(int argc, char** argv)
 		unsigned int num_platforms;
 		cl_platform_id* platform_ids = NULL;
 
+		bool parallel_devices = config->run_per_device &&
+		                        get_parallel_devices_arg(config);
+		bool collect_devices = parallel_devices ||
+		                       config->_test_prepare != NULL;
+		unsigned int num_device_runs = 0;
+		struct device_run* device_runs = NULL;
+
 		/* Create regexes */
 		if(   config->platform_regex != NULL
 		   && regcomp(&platform_regex, config->platform_regex, REG_EXTENDED | REG_NEWLINE)) {
@@ -380,19 +526,42 @@ int piglit_cl_framework_run(int argc, char** argv)
 					}
 
 					print_test_info(config, version, platform_id, device_id);
-					piglit_merge_result(&result,
-					                    config->_test_run(argc,
-					                                      (const char**)argv,
-					                                      (void*)config,
-					                                      final_version,
-					                                      platform_id,
-					                                      device_id));
+					if(collect_devices) {
+						num_device_runs++;
+						device_runs = realloc(device_runs,
+						                      num_device_runs * sizeof(struct device_run));
+						device_runs[num_device_runs - 1].version = final_version;
+						device_runs[num_device_runs - 1].platform_id = platform_id;
+						device_runs[num_device_runs - 1].device_id = device_id;
+					} else {
+						piglit_merge_result(&result,
+						                    config->_test_run(argc,
+						                                      (const char**)argv,
+						                                      (void*)config,
+						                                      final_version,
+						                                      platform_id,
+						                                      device_id));
+					}
 				}
 
 				free(device_ids);
 			}
 		}
 
+		if(num_device_runs > 0 && parallel_devices) {
+			printf("# Running on %u devices in parallel.\n", num_device_runs);
+			piglit_merge_result(&result,
+			                    run_devices_in_parallel(argc, argv, config,
+			                                            device_runs,
+			                                            num_device_runs));
+		} else if(num_device_runs > 0) {
+			piglit_merge_result(&result,
+			                    run_prepared_devices(argc, argv, config,
+			                                         device_runs,
+			                                         num_device_runs));
+		}
+		free(device_runs);
+
 		if(config->platform_regex != NULL) {
 			regfree(&platform_regex);
 		}
@@ -60,6 +60,23 @@ typedef enum piglit_result piglit_cl_test_run_t(const int argc,
                                                 cl_platform_id platform_id,
                                                 cl_device_id device_id);
 
+/**
+ * \brief Start the work of a test run ahead of it.
+ *
+ * Optional for test runners.  When the test runs on several devices one
+ * after the other, this is called with the arguments of every run before
+ * the first one, so that work like building programs can go on in the
+ * background while the earlier runs execute.  Each call is followed by a
+ * call to the \c piglit_cl_test_run_t of the runner with the same
+ * arguments.
+ */
+typedef void piglit_cl_test_prepare_t(const int argc,
+                                      const char** argv,
+                                      void* config,
+                                      int version,
+                                      cl_platform_id platform_id,
+                                      cl_device_id device_id);
+
 /**
  * \brief Initialize test configuration.
  *
@@ -97,11 +114,17 @@ typedef void piglit_cl_test_clean_t(const int argc,
         char* _filename; /**< Read-only test filename. (internal) */         \
         piglit_cl_test_run_t* _test_run;                                     \
           /**< Function pointer to run the test. (internal) */               \
+        piglit_cl_test_prepare_t* _test_prepare;                             \
+          /**< Function pointer to prepare the runs of the test.
+               (internal) */                                                 \
                                                                              \
         char* name; /**< Name of test. (optional) */                         \
                                                                              \
         bool run_per_platform; /**< Run test per platform. (optional) */     \
         bool run_per_device; /**< Run test per device. (optional) */         \
+        bool thread_safe;                                                    \
+          /**< \c _test_run can run for several devices at once, see
+               PIGLIT_CL_PARALLEL_DEVICES. (optional) */                     \
                                                                              \
         char* platform_regex;                                                \
           /**< Regex to filter platforms (optional) */                       \
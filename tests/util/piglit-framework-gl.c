@@ -37,6 +37,7 @@ const char *piglit_binary_name;
 bool piglit_dump_png = false;
 bool piglit_use_fbo = false;
 bool piglit_khr_no_error = false;
+bool piglit_reuse_gl_contexts = false;
 int piglit_automatic = 0;
 unsigned piglit_winsys_fbo = 0;
 
@@ -198,14 +199,101 @@ piglit_gl_process_args(int *argc, char *argv[],
 
 }
 
+static void (*traced_init)(int argc, char *argv[]);
+static enum piglit_result (*traced_display)(void);
+
+static void
+trace_init(int argc, char *argv[])
+{
+	piglit_trace_begin("piglit_init");
+	traced_init(argc, argv);
+	piglit_trace_end();
+}
+
+static enum piglit_result
+trace_display(void)
+{
+	enum piglit_result result;
+
+	piglit_trace_begin("piglit_display");
+	result = traced_display();
+	piglit_trace_end();
+
+	return result;
+}
+
+static enum piglit_result (*golden_display)(void);
+
+static enum piglit_result
+check_golden_display(void)
+{
+	enum piglit_result result = golden_display();
+
+	piglit_merge_result(&result, piglit_golden_result());
+	return result;
+}
+
+static enum piglit_result (*counted_display)(void);
+
+static enum piglit_result
+count_display(void)
+{
+	bool counting = piglit_perf_counters_begin();
+	enum piglit_result result = counted_display();
+
+	if (counting) {
+		piglit_perf_counters_end(NULL);
+		piglit_perf_counters_report();
+	}
+	return result;
+}
+
 void
 piglit_gl_test_run(int argc, char *argv[],
 		   const struct piglit_gl_test_config *config)
 {
+	static struct piglit_gl_test_config traced_config;
+	static struct piglit_gl_test_config golden_config;
+	static struct piglit_gl_test_config counted_config;
+
 	piglit_width = config->window_width;
 	piglit_height = config->window_height;
 
+	/* Record piglit_init and each piglit_display in the trace. */
+	if (getenv("PIGLIT_TRACE") != NULL) {
+		traced_config = *config;
+		traced_init = config->init;
+		traced_display = config->display;
+		if (config->init)
+			traced_config.init = trace_init;
+		if (config->display)
+			traced_config.display = trace_display;
+		config = &traced_config;
+	}
+
+	/* Fail the test when a frame it presents doesn't match the golden
+	 * images.
+	 */
+	if (piglit_golden_init(argc, argv) && config->display) {
+		golden_config = *config;
+		golden_display = config->display;
+		golden_config.display = check_golden_display;
+		config = &golden_config;
+	}
+
+	/* Add the GPU counters of PIGLIT_PERF_COUNTERS over each
+	 * piglit_display to the metrics of the result.
+	 */
+	if (getenv("PIGLIT_PERF_COUNTERS") != NULL && config->display) {
+		counted_config = *config;
+		counted_display = config->display;
+		counted_config.display = count_display;
+		config = &counted_config;
+	}
+
+	piglit_trace_begin("context creation");
 	gl_fw = piglit_gl_framework_factory(config);
+	piglit_trace_end();
 	if (gl_fw == NULL) {
 		printf("piglit: error: failed to create "
 		       "piglit_gl_framework\n");
@@ -261,15 +349,17 @@ piglit_present_results(void)
 			     base_format, GL_UNSIGNED_BYTE, image);
 		assert(glGetError() == GL_NO_ERROR);
 
-		(void)!asprintf(&filename, "%s%03d.png", fileprefix, frame++);
+		(void)!asprintf(&filename, "%s%03d", fileprefix, frame++);
 
-		printf("Writing %s...\n", filename);
-		piglit_write_png(filename, base_format, piglit_width,
-				 piglit_height, image, true);
+		/* Written on another thread, the image is copied. */
+		piglit_dump_image(filename, base_format, piglit_width,
+				  piglit_height, image, true);
 		free(filename);
 		free(image);
 	}
 
+	piglit_golden_check_frame();
+
 	if (!piglit_automatic)
 		piglit_swap_buffers();
 }
@@ -298,6 +388,40 @@ piglit_destroy_dma_buf(struct piglit_dma_buf *buf)
 		gl_fw->destroy_dma_buf(buf);
 }
 
+void *
+piglit_create_shared_context(void)
+{
+	if (!gl_fw->create_shared_context)
+		return NULL;
+
+	return gl_fw->create_shared_context(gl_fw);
+}
+
+bool
+piglit_make_shared_context_current(void *ctx)
+{
+	if (!gl_fw->make_shared_context_current)
+		return false;
+
+	return gl_fw->make_shared_context_current(gl_fw, ctx);
+}
+
+void
+piglit_destroy_shared_context(void *ctx)
+{
+	if (ctx && gl_fw->destroy_shared_context)
+		gl_fw->destroy_shared_context(gl_fw, ctx);
+}
+
+bool
+piglit_make_test_context_current(void)
+{
+	if (!gl_fw->make_test_context_current)
+		return false;
+
+	return gl_fw->make_test_context_current(gl_fw);
+}
+
 size_t
 piglit_get_selected_tests(const char ***selected_subtests)
 {
@@ -257,6 +257,20 @@ piglit_gl_test_run(int argc, char *argv[],
 #  define PIGLIT_EXTERN_C_END
 #endif
 
+/**
+ * The entry point of the tests, which is main() unless the test is built as
+ * a module for piglit-test-host (see PIGLIT_BUILD_TEST_MODULES). The host
+ * loads the module and calls this in its own process.
+ */
+#ifdef PIGLIT_TEST_MODULE
+#  define PIGLIT_GL_TEST_MAIN piglit_test_module_main
+#  define PIGLIT_GL_TEST_MAIN_DECL                                           \
+        int piglit_test_module_main(int argc, char *argv[]);
+#else
+#  define PIGLIT_GL_TEST_MAIN main
+#  define PIGLIT_GL_TEST_MAIN_DECL
+#endif
+
 #define PIGLIT_GL_TEST_CONFIG_BEGIN                                          \
                                                                              \
         PIGLIT_EXTERN_C_BEGIN                                                \
@@ -267,10 +281,12 @@ piglit_gl_test_run(int argc, char *argv[],
         enum piglit_result                                                   \
         piglit_display(void);                                                \
                                                                              \
+        PIGLIT_GL_TEST_MAIN_DECL                                             \
+                                                                             \
         PIGLIT_EXTERN_C_END                                                  \
                                                                              \
         int                                                                  \
-        main(int argc, char *argv[])                                         \
+        PIGLIT_GL_TEST_MAIN(int argc, char *argv[])                          \
         {                                                                    \
                 struct piglit_gl_test_config config;                         \
                                                                              \
@@ -302,6 +318,20 @@ extern int piglit_width;
 extern int piglit_height;
 extern bool piglit_use_fbo;
 extern bool piglit_khr_no_error;
+extern bool piglit_dump_png;
+
+/**
+ * When set, a destroyed waffle framework keeps its display and context, and
+ * a framework created later in the process with the same configuration and
+ * window size reuses them instead of creating new ones. This is only done on
+ * the gbm and surfaceless_egl platforms.
+ *
+ * This is for runners that run many tests in one process and create a new
+ * framework when a test needs another configuration. A reused context has
+ * its errors, program, framebuffer binding and viewport reset; the runner
+ * resets any other state its tests change.
+ */
+extern bool piglit_reuse_gl_contexts;
 extern unsigned int piglit_winsys_fbo;
 extern struct piglit_gl_framework *gl_fw;
 
@@ -349,4 +379,33 @@ piglit_create_dma_buf(unsigned w, unsigned h, unsigned fourcc,
 void
 piglit_destroy_dma_buf(struct piglit_dma_buf *buf);
 
+/**
+ * Create a context that shares objects with the test's context, for use by
+ * another thread. Returns NULL if the framework can't create one.
+ *
+ * On X11, tests creating contexts for other threads need to call
+ * XInitThreads() in their config block, before the display is opened.
+ */
+void *
+piglit_create_shared_context(void);
+
+/**
+ * Make ctx, from piglit_create_shared_context(), current in the calling
+ * thread, or release the current context if ctx is NULL. The context is
+ * made current without a drawable where the platform allows it, so
+ * rendering should go to a framebuffer object.
+ */
+bool
+piglit_make_shared_context_current(void *ctx);
+
+void
+piglit_destroy_shared_context(void *ctx);
+
+/**
+ * Make the test's own context and window current in the calling thread
+ * again, after piglit_make_shared_context_current().
+ */
+bool
+piglit_make_test_context_current(void);
+
 #endif /* PIGLIT_FRAMEWORK_H */
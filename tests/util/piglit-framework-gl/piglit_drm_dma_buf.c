@@ -36,9 +36,93 @@
 #include <xcb/dri2.h>
 #include <drm.h>
 #include <unistd.h>
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
 
 #define ALIGN(value, alignment) (((value) + alignment - 1) & ~(alignment - 1))
 
+/* Copies smaller than this aren't worth starting threads for. */
+#define COPY_THREAD_MIN_SIZE (4 * 1024 * 1024)
+#define COPY_MAX_THREADS 8
+
+struct piglit_drm_row_copy {
+	char *dst;
+	const unsigned char *src;
+	unsigned dst_stride;
+	unsigned src_stride;
+	unsigned row_size;
+	unsigned rows;
+};
+
+static void *
+piglit_drm_copy_row_range(void *data)
+{
+	const struct piglit_drm_row_copy *copy = data;
+	unsigned i;
+
+	for (i = 0; i < copy->rows; ++i) {
+		memcpy(copy->dst + i * copy->dst_stride,
+		       copy->src + i * copy->src_stride,
+		       copy->row_size);
+	}
+
+	return NULL;
+}
+
+/**
+ * Copy rows of row_size bytes into a mapped buffer.  Large copies are split
+ * over several threads, a single thread doesn't get near the bandwidth of
+ * write-combined mappings.
+ */
+static void
+piglit_drm_copy_rows(void *dst, unsigned dst_stride,
+		     const unsigned char *src, unsigned src_stride,
+		     unsigned row_size, unsigned rows)
+{
+	struct piglit_drm_row_copy copy = {
+		dst, src, dst_stride, src_stride, row_size, rows
+	};
+#ifdef PIGLIT_HAS_PTHREADS
+	struct piglit_drm_row_copy parts[COPY_MAX_THREADS];
+	pthread_t threads[COPY_MAX_THREADS];
+	bool started[COPY_MAX_THREADS];
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned n = CLAMP(cpus, 1, COPY_MAX_THREADS);
+	unsigned first = 0;
+	unsigned i;
+
+	n = MIN2(n, rows);
+	if ((size_t)row_size * rows < COPY_THREAD_MIN_SIZE || n < 2) {
+		piglit_drm_copy_row_range(&copy);
+		return;
+	}
+
+	for (i = 0; i < n; i++) {
+		parts[i] = copy;
+		parts[i].dst += (size_t)first * dst_stride;
+		parts[i].src += (size_t)first * src_stride;
+		parts[i].rows = rows / n + (i < rows % n);
+		first += parts[i].rows;
+
+		/* The last part is copied by this thread. */
+		started[i] = i < n - 1 &&
+			pthread_create(&threads[i], NULL,
+				       piglit_drm_copy_row_range,
+				       &parts[i]) == 0;
+		if (!started[i])
+			piglit_drm_copy_row_range(&parts[i]);
+	}
+
+	for (i = 0; i < n; i++) {
+		if (started[i])
+			pthread_join(threads[i], NULL);
+	}
+#else
+	piglit_drm_copy_row_range(&copy);
+#endif
+}
+
 struct piglit_drm_driver {
 	int fd;
 	char *name;
@@ -48,6 +132,11 @@ struct piglit_drm_driver {
 		  const unsigned char *src_data,
 		  struct piglit_dma_buf *buf);
 
+	/* Write src_data again into a buffer made by create. */
+	bool
+	(*fill)(unsigned fourcc, const unsigned char *src_data,
+		struct piglit_dma_buf *buf);
+
 	bool
 	(*export)(struct piglit_dma_buf *buf);
 
@@ -118,31 +207,29 @@ piglit_gbm_get(void)
 	return gbm;
 }
 
-static bool
-piglit_gbm_buf_create(unsigned w, unsigned h, unsigned fourcc,
-			const unsigned char *src_data, struct piglit_dma_buf *buf)
-{
-	unsigned i;
-	struct gbm_bo *bo;
-	uint32_t dst_stride;
-	struct gbm_device *gbm = piglit_gbm_get();
-	void *dst_data;
-	void *map_data = NULL;
+/* How the source data of a fourcc is laid out in the GBM bo. */
+struct piglit_gbm_buf_layout {
 	enum gbm_bo_format format;
-	unsigned cpp = 0, src_stride;
-	unsigned buf_w = w;
-	unsigned buf_h = h;
-	unsigned n_planes = 0;
+	unsigned cpp;
+	unsigned src_stride;
+	unsigned buf_w;
+	unsigned buf_h;
+	unsigned n_planes;
+};
 
-	if (!gbm || h % 2 || w % 2)
-		return false;
+static bool
+piglit_gbm_buf_layout(unsigned w, unsigned h, unsigned fourcc,
+		      struct piglit_gbm_buf_layout *l)
+{
+	l->buf_w = w;
+	l->buf_h = h;
 
 	switch (fourcc) {
 	case DRM_FORMAT_R8:
-		format = GBM_FORMAT_R8;
-		cpp = 1;
-		src_stride = cpp * w;
-		n_planes = 1;
+		l->format = GBM_FORMAT_R8;
+		l->cpp = 1;
+		l->src_stride = l->cpp * w;
+		l->n_planes = 1;
 		break;
 	case DRM_FORMAT_GR88:
 	case DRM_FORMAT_RG88:
@@ -150,17 +237,17 @@ piglit_gbm_buf_create(unsigned w, unsigned h, unsigned fourcc,
 	case DRM_FORMAT_YVYU:
 	case DRM_FORMAT_UYVY:
 	case DRM_FORMAT_VYUY:
-		format = GBM_FORMAT_GR88;
-		cpp = 2;
-		src_stride = cpp * w;
-		n_planes = 1;
+		l->format = GBM_FORMAT_GR88;
+		l->cpp = 2;
+		l->src_stride = l->cpp * w;
+		l->n_planes = 1;
 		break;
 	case DRM_FORMAT_RGB888:
 	case DRM_FORMAT_BGR888:
-		format = GBM_FORMAT_RGB888;
-		cpp = 3;
-		src_stride = cpp * w;
-		n_planes = 1;
+		l->format = GBM_FORMAT_RGB888;
+		l->cpp = 3;
+		l->src_stride = l->cpp * w;
+		l->n_planes = 1;
 		break;
 	case DRM_FORMAT_XRGB8888:
 	case DRM_FORMAT_XBGR8888:
@@ -172,32 +259,32 @@ piglit_gbm_buf_create(unsigned w, unsigned h, unsigned fourcc,
 	case DRM_FORMAT_BGRA8888:
 	case DRM_FORMAT_AYUV:
 	case DRM_FORMAT_XYUV8888:
-		format = GBM_BO_FORMAT_ARGB8888;
-		cpp = 4;
-		src_stride = cpp * w;
-		n_planes = 1;
+		l->format = GBM_BO_FORMAT_ARGB8888;
+		l->cpp = 4;
+		l->src_stride = l->cpp * w;
+		l->n_planes = 1;
 		break;
 	case DRM_FORMAT_Y410:
-		format = GBM_FORMAT_ABGR2101010;
-		cpp = 4;
-		src_stride = cpp * w;
-		n_planes = 1;
+		l->format = GBM_FORMAT_ABGR2101010;
+		l->cpp = 4;
+		l->src_stride = l->cpp * w;
+		l->n_planes = 1;
 		break;
 	case DRM_FORMAT_Y412:
 	case DRM_FORMAT_Y416:
-		format = GBM_BO_FORMAT_ARGB8888;
-		buf_w = w * 2;
-		cpp = 8;
-		src_stride = cpp * w;
-		n_planes = 1;
+		l->format = GBM_BO_FORMAT_ARGB8888;
+		l->buf_w = w * 2;
+		l->cpp = 8;
+		l->src_stride = l->cpp * w;
+		l->n_planes = 1;
 		break;
 	case DRM_FORMAT_Y210:
 	case DRM_FORMAT_Y212:
 	case DRM_FORMAT_Y216:
-		format = GBM_BO_FORMAT_ARGB8888;
-		cpp = 4;
-		src_stride = cpp * w;
-		n_planes = 1;
+		l->format = GBM_BO_FORMAT_ARGB8888;
+		l->cpp = 4;
+		l->src_stride = l->cpp * w;
+		l->n_planes = 1;
 		break;
 
 	/* For YUV formats, the U/V planes might have a greater relative
@@ -213,62 +300,58 @@ piglit_gbm_buf_create(unsigned w, unsigned h, unsigned fourcc,
 	 */
 	case DRM_FORMAT_NV12:
 	case DRM_FORMAT_NV21:
-		format = GBM_FORMAT_GR88;
-		buf_w = w / 2;
-		buf_h = h * 3 / 2;
-		src_stride = w;
-		cpp = 1;
-		n_planes = 2;
+		l->format = GBM_FORMAT_GR88;
+		l->buf_w = w / 2;
+		l->buf_h = h * 3 / 2;
+		l->src_stride = w;
+		l->cpp = 1;
+		l->n_planes = 2;
 		break;
 	case DRM_FORMAT_P010:
 	case DRM_FORMAT_P012:
 	case DRM_FORMAT_P016:
-		format = GBM_FORMAT_GR88;
-		buf_h = h * 3 / 2;
-		cpp = 2;
-		src_stride = cpp * w;
-		n_planes = 2;
+		l->format = GBM_FORMAT_GR88;
+		l->buf_h = h * 3 / 2;
+		l->cpp = 2;
+		l->src_stride = l->cpp * w;
+		l->n_planes = 2;
 		break;
 	case DRM_FORMAT_YUV420:
 	case DRM_FORMAT_YVU420:
-		format = GBM_FORMAT_GR88;
-		buf_w = w / 2;
-		buf_h = h * 2;    /* U/V not interleaved */
-		src_stride = w;
-		cpp = 1;
-		n_planes = 3;
+		l->format = GBM_FORMAT_GR88;
+		l->buf_w = w / 2;
+		l->buf_h = h * 2;    /* U/V not interleaved */
+		l->src_stride = w;
+		l->cpp = 1;
+		l->n_planes = 3;
 		break;
 	default:
 		fprintf(stderr, "invalid fourcc: %.4s\n", (char *)&fourcc);
 		return false;
 	}
 
-	bo = gbm_bo_create(gbm, buf_w, buf_h, format,
-			   GBM_BO_USE_RENDERING | GBM_BO_USE_LINEAR);
-	if (!bo)
-		return false;
+	return true;
+}
 
-	dst_data = gbm_bo_map(bo, 0, 0, buf_w, buf_h, GBM_BO_TRANSFER_WRITE,
-			      &dst_stride, &map_data);
-	if (!dst_data) {
-		fprintf(stderr, "Failed to map GBM bo\n");
-		gbm_bo_destroy(bo);
-		return NULL;
-	}
 
-	buf->w = w;
-	buf->h = h;
-	buf->n_planes = n_planes;
+static bool
+piglit_gbm_buf_fill(unsigned fourcc, const unsigned char *src_data,
+		    struct piglit_dma_buf *buf)
+{
+	struct gbm_bo *bo = buf->priv;
+	struct piglit_gbm_buf_layout l;
+	unsigned w = buf->w;
+	unsigned h = buf->h;
+	uint32_t dst_stride;
+	void *dst_data;
+	void *map_data = NULL;
+
+	if (!piglit_gbm_buf_layout(w, h, fourcc, &l))
+		return false;
+
+	buf->n_planes = l.n_planes;
 	buf->offset[0] = gbm_bo_get_offset(bo, 0);
 	buf->stride[0] = gbm_bo_get_stride_for_plane(bo, 0);
-	buf->fd = -1;
-	buf->priv = bo;
-
-	for (i = 0; i < h; ++i) {
-		memcpy((char *)dst_data + i * dst_stride,
-		       src_data + i * src_stride,
-		       w * cpp);
-	}
 
 	switch (fourcc) {
 	case DRM_FORMAT_NV12:
@@ -276,24 +359,11 @@ piglit_gbm_buf_create(unsigned w, unsigned h, unsigned fourcc,
 	case DRM_FORMAT_P010:
 	case DRM_FORMAT_P012:
 	case DRM_FORMAT_P016:
-		for (i = 0; i < h/2; ++i) {
-			memcpy(((char *)dst_data + dst_stride * h) + i * dst_stride,
-				(src_data + (w * h * cpp)) + i * src_stride, w * cpp);
-		}
 		buf->offset[1] = buf->stride[0] * h;
 		buf->stride[1] = buf->stride[0];
 		break;
 	case DRM_FORMAT_YUV420:
 	case DRM_FORMAT_YVU420:
-		for (i = 0; i < h/2; ++i) {
-			memcpy(((char *)dst_data + dst_stride * h) + i * dst_stride,
-				(src_data + (w*h)) + i * src_stride / 2, w / 2);
-		}
-		unsigned cpu_offset2 = dst_stride * h + dst_stride * h / 2;
-		for (i = 0; i < h/2; ++i) {
-			memcpy(((char *)dst_data + cpu_offset2) + i * dst_stride,
-				(src_data + (w*h) + (w*h/4)) + i * src_stride / 2, w / 2);
-		}
 		buf->offset[1] = buf->stride[0] * h;
 		buf->stride[1] = buf->stride[0];
 		buf->offset[2] = buf->stride[0] * h + buf->stride[0] * h / 2;
@@ -303,8 +373,78 @@ piglit_gbm_buf_create(unsigned w, unsigned h, unsigned fourcc,
 		break;
 	}
 
+	if (!src_data)
+		return true;
+
+	dst_data = gbm_bo_map(bo, 0, 0, l.buf_w, l.buf_h,
+			      GBM_BO_TRANSFER_WRITE, &dst_stride, &map_data);
+	if (!dst_data) {
+		fprintf(stderr, "Failed to map GBM bo\n");
+		return false;
+	}
+
+	piglit_drm_copy_rows(dst_data, dst_stride, src_data, l.src_stride,
+			     w * l.cpp, h);
+
+	switch (fourcc) {
+	case DRM_FORMAT_NV12:
+	case DRM_FORMAT_NV21:
+	case DRM_FORMAT_P010:
+	case DRM_FORMAT_P012:
+	case DRM_FORMAT_P016:
+		piglit_drm_copy_rows((char *)dst_data + dst_stride * h,
+				     dst_stride, src_data + (w * h * l.cpp),
+				     l.src_stride, w * l.cpp, h / 2);
+		break;
+	case DRM_FORMAT_YUV420:
+	case DRM_FORMAT_YVU420: {
+		unsigned cpu_offset2 = dst_stride * h + dst_stride * h / 2;
+
+		piglit_drm_copy_rows((char *)dst_data + dst_stride * h,
+				     dst_stride, src_data + (w * h),
+				     l.src_stride / 2, w / 2, h / 2);
+		piglit_drm_copy_rows((char *)dst_data + cpu_offset2,
+				     dst_stride, src_data + (w*h) + (w*h/4),
+				     l.src_stride / 2, w / 2, h / 2);
+		break;
+	}
+	default:
+		break;
+	}
+
 	gbm_bo_unmap(bo, map_data);
 
+	return true;
+}
+
+static bool
+piglit_gbm_buf_create(unsigned w, unsigned h, unsigned fourcc,
+			const unsigned char *src_data, struct piglit_dma_buf *buf)
+{
+	struct gbm_bo *bo;
+	struct gbm_device *gbm = piglit_gbm_get();
+	struct piglit_gbm_buf_layout l;
+
+	if (!gbm || h % 2 || w % 2)
+		return false;
+
+	if (!piglit_gbm_buf_layout(w, h, fourcc, &l))
+		return false;
+
+	bo = gbm_bo_create(gbm, l.buf_w, l.buf_h, l.format,
+			   GBM_BO_USE_RENDERING | GBM_BO_USE_LINEAR);
+	if (!bo)
+		return false;
+
+	buf->w = w;
+	buf->h = h;
+	buf->fd = -1;
+	buf->priv = bo;
+
+	if (!piglit_gbm_buf_fill(fourcc, src_data, buf)) {
+		gbm_bo_destroy(bo);
+		return false;
+	}
 
 	return true;
 }
@@ -390,6 +530,7 @@ piglit_drm_get_driver(void)
 #ifdef PIGLIT_HAS_GBM_BO_MAP
 	else if (true) {
 		drv.create = piglit_gbm_buf_create;
+		drv.fill = piglit_gbm_buf_fill;
 		drv.export = piglit_gbm_buf_export;
 		drv.destroy = piglit_gbm_buf_destroy;
 	}
@@ -418,57 +559,73 @@ piglit_drm_get_driver(void)
 	return NULL;
 }
 
-static bool
-drm_create_dma_buf_modifiers(unsigned w, unsigned h, unsigned fourcc,
-			     uint64_t modifier, const unsigned char *src_data,
-			     struct piglit_dma_buf *buf)
+static unsigned
+drm_cpp_for_modifiers_fourcc(unsigned fourcc)
 {
-	unsigned i;
-	struct gbm_bo *bo;
-	uint32_t dst_stride;
-	struct gbm_device *gbm = piglit_gbm_get();
-	void *dst_data;
-	void *map_data = NULL;
-	unsigned cpp = 0, src_stride;
-
-	if (!gbm)
-		return false;
-
 	switch (fourcc) {
 	case DRM_FORMAT_R8:
-		cpp = 1;
-		break;
+		return 1;
 	case DRM_FORMAT_R16:
-		cpp = 2;
-		break;
+		return 2;
 	case DRM_FORMAT_RGB888:
 	case DRM_FORMAT_BGR888:
-		cpp = 3;
-		break;
+		return 3;
 	case DRM_FORMAT_XBGR8888:
 	case DRM_FORMAT_XRGB8888:
 	case DRM_FORMAT_ABGR8888:
 	case DRM_FORMAT_ARGB8888:
-		cpp = 4;
-		break;
+		return 4;
 	default:
 		fprintf(stderr, "invalid fourcc: %.4s\n", (char *)&fourcc);
-		return false;
+		return 0;
 	}
+}
 
-	bo = gbm_bo_create_with_modifiers(gbm, w, h, fourcc, &modifier, 1);
-	if (!bo)
-		return false;
+static bool
+drm_fill_dma_buf_modifiers(unsigned fourcc, const unsigned char *src_data,
+			   struct piglit_dma_buf *buf)
+{
+	struct gbm_bo *bo = buf->priv;
+	unsigned cpp = drm_cpp_for_modifiers_fourcc(fourcc);
+	uint32_t dst_stride;
+	void *dst_data;
+	void *map_data = NULL;
 
-	dst_data = gbm_bo_map(bo, 0, 0, w, h, GBM_BO_TRANSFER_WRITE,
+	if (!src_data)
+		return true;
+
+	dst_data = gbm_bo_map(bo, 0, 0, buf->w, buf->h, GBM_BO_TRANSFER_WRITE,
 			      &dst_stride, &map_data);
 	if (!dst_data) {
 		fprintf(stderr, "Failed to map GBM bo\n");
-		gbm_bo_destroy(bo);
 		return false;
 	}
 
-	src_stride = cpp * w;
+	piglit_drm_copy_rows(dst_data, dst_stride, src_data, cpp * buf->w,
+			     cpp * buf->w, buf->h);
+
+	gbm_bo_unmap(bo, map_data);
+
+	return true;
+}
+
+static bool
+drm_create_dma_buf_modifiers(unsigned w, unsigned h, unsigned fourcc,
+			     uint64_t modifier, const unsigned char *src_data,
+			     struct piglit_dma_buf *buf)
+{
+	struct gbm_bo *bo;
+	struct gbm_device *gbm = piglit_gbm_get();
+
+	if (!gbm)
+		return false;
+
+	if (drm_cpp_for_modifiers_fourcc(fourcc) == 0)
+		return false;
+
+	bo = gbm_bo_create_with_modifiers(gbm, w, h, fourcc, &modifier, 1);
+	if (!bo)
+		return false;
 
 	buf->w = w;
 	buf->h = h;
@@ -483,17 +640,14 @@ drm_create_dma_buf_modifiers(unsigned w, unsigned h, unsigned fourcc,
 	buf->fd = -1;
 	buf->priv = bo;
 
-	for (i = 0; i < h; ++i) {
-		memcpy((char *)dst_data + i * dst_stride,
-		       src_data + i * src_stride,
-		       w * cpp);
+	if (!drm_fill_dma_buf_modifiers(fourcc, src_data, buf)) {
+		gbm_bo_destroy(bo);
+		return false;
 	}
 
-	gbm_bo_unmap(bo, map_data);
-
-
 	return true;
 }
+
 enum piglit_result
 piglit_drm_create_dma_buf_modifiers(unsigned w, unsigned h, unsigned fourcc,
 				    uint64_t modifier, const void *src_data,
@@ -570,3 +724,122 @@ piglit_drm_destroy_dma_buf(struct piglit_dma_buf *buf)
 	drv->destroy(buf);
 	free(buf);
 }
+
+struct piglit_dma_buf_pool_entry {
+	/* First, so that handles can be cast back to their entry. */
+	struct piglit_dma_buf buf;
+	unsigned fourcc;
+	uint64_t modifier;
+	bool in_use;
+	struct piglit_dma_buf_pool_entry *next;
+};
+
+struct piglit_dma_buf_pool {
+	struct piglit_dma_buf_pool_entry *entries;
+};
+
+struct piglit_dma_buf_pool *
+piglit_drm_dma_buf_pool_create(void)
+{
+	return calloc(1, sizeof(struct piglit_dma_buf_pool));
+}
+
+static bool
+drm_fill_pooled_dma_buf(const struct piglit_drm_driver *drv,
+			struct piglit_dma_buf_pool_entry *entry,
+			const unsigned char *src_data)
+{
+	if (entry->modifier == DRM_FORMAT_MOD_INVALID)
+		return drv->fill(entry->fourcc, src_data, &entry->buf);
+
+	return drm_fill_dma_buf_modifiers(entry->fourcc, src_data,
+					  &entry->buf);
+}
+
+enum piglit_result
+piglit_drm_dma_buf_pool_get(struct piglit_dma_buf_pool *pool,
+			    unsigned w, unsigned h, unsigned fourcc,
+			    uint64_t modifier, const void *src_data,
+			    struct piglit_dma_buf **buf)
+{
+	struct piglit_dma_buf_pool_entry *entry;
+	const struct piglit_drm_driver *drv = piglit_drm_get_driver();
+	bool created;
+
+	if (!drv)
+		return PIGLIT_SKIP;
+
+	for (entry = pool->entries; entry; entry = entry->next) {
+		if (entry->in_use || entry->buf.w != w || entry->buf.h != h ||
+		    entry->fourcc != fourcc || entry->modifier != modifier)
+			continue;
+
+		if (src_data && !drm_fill_pooled_dma_buf(drv, entry, src_data))
+			return PIGLIT_FAIL;
+
+		entry->in_use = true;
+		*buf = &entry->buf;
+		return PIGLIT_PASS;
+	}
+
+	entry = calloc(1, sizeof(*entry));
+	if (!entry)
+		return PIGLIT_FAIL;
+
+	if (modifier == DRM_FORMAT_MOD_INVALID)
+		created = drv->create(w, h, fourcc, src_data, &entry->buf);
+	else
+		created = drm_create_dma_buf_modifiers(w, h, fourcc, modifier,
+						       src_data, &entry->buf);
+	if (!created) {
+		free(entry);
+		return PIGLIT_FAIL;
+	}
+
+	if (!drv->export(&entry->buf)) {
+		drv->destroy(&entry->buf);
+		free(entry);
+		return PIGLIT_FAIL;
+	}
+
+	entry->fourcc = fourcc;
+	entry->modifier = modifier;
+	entry->in_use = true;
+	entry->next = pool->entries;
+	pool->entries = entry;
+
+	*buf = &entry->buf;
+	return PIGLIT_PASS;
+}
+
+void
+piglit_drm_dma_buf_pool_put(struct piglit_dma_buf_pool *pool,
+			    struct piglit_dma_buf *buf)
+{
+	struct piglit_dma_buf_pool_entry *entry =
+		(struct piglit_dma_buf_pool_entry *)buf;
+
+	if (buf)
+		entry->in_use = false;
+}
+
+void
+piglit_drm_dma_buf_pool_destroy(struct piglit_dma_buf_pool *pool)
+{
+	const struct piglit_drm_driver *drv = piglit_drm_get_driver();
+	struct piglit_dma_buf_pool_entry *entry, *next;
+
+	if (!pool)
+		return;
+
+	for (entry = pool->entries; entry; entry = next) {
+		next = entry->next;
+		if (entry->buf.fd >= 0)
+			close(entry->buf.fd);
+		if (drv)
+			drv->destroy(&entry->buf);
+		free(entry);
+	}
+
+	free(pool);
+}
@@ -48,4 +48,43 @@ piglit_drm_create_dma_buf_modifiers(unsigned w, unsigned h, unsigned fourcc,
 void
 piglit_drm_destroy_dma_buf(struct piglit_dma_buf *buf);
 
+/**
+ * A pool of dma buffers, for tests that go through many buffers of the same
+ * few sizes, formats and modifiers.
+ *
+ * The buffers are allocated and exported once per (size, fourcc, modifier)
+ * and handed out again after they are put back, so a test only pays for
+ * writing the new data.  DRM_FORMAT_MOD_INVALID gives the buffers of
+ * piglit_drm_create_dma_buf(), which supports more formats.
+ */
+struct piglit_dma_buf_pool;
+
+struct piglit_dma_buf_pool *
+piglit_drm_dma_buf_pool_create(void);
+
+/**
+ * Get a buffer that isn't in use from the pool, or a new one, and write
+ * src_data into it.  When src_data is NULL, a reused buffer keeps the data it
+ * had and the contents of a new one are undefined.
+ *
+ * The fd of the buffer belongs to the pool, importers must dup it if they
+ * take ownership.
+ */
+enum piglit_result
+piglit_drm_dma_buf_pool_get(struct piglit_dma_buf_pool *pool,
+			    unsigned w, unsigned h, unsigned fourcc,
+			    uint64_t modifier, const void *src_data,
+			    struct piglit_dma_buf **buf);
+
+/**
+ * Give buf back to the pool.  Images imported from it must not be used once
+ * it is handed out again.
+ */
+void
+piglit_drm_dma_buf_pool_put(struct piglit_dma_buf_pool *pool,
+			    struct piglit_dma_buf *buf);
+
+void
+piglit_drm_dma_buf_pool_destroy(struct piglit_dma_buf_pool *pool);
+
 #endif /* PIGLIT_DRM_DMA_BUF_H */
@@ -28,6 +28,9 @@
 #include "piglit_wfl_framework.h"
 
 
+/* The attachments of piglit_winsys_fbo */
+static GLuint fbo_tex, fbo_depth;
+
 static void
 destroy(struct piglit_gl_framework *gl_fw)
 {
@@ -36,6 +39,20 @@ destroy(struct piglit_gl_framework *gl_fw)
 	if (wfl_fw == NULL)
 		return;
 
+#ifndef PIGLIT_USE_OPENGL_ES1
+	/* The context may be reused by the next framework. */
+	if (piglit_reuse_gl_contexts && wfl_fw->context &&
+	    piglit_winsys_fbo) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &piglit_winsys_fbo);
+		glDeleteTextures(1, &fbo_tex);
+		glDeleteTextures(1, &fbo_depth);
+		piglit_winsys_fbo = 0;
+		fbo_tex = 0;
+		fbo_depth = 0;
+	}
+#endif
+
 	piglit_wfl_framework_teardown(wfl_fw);
 	free(wfl_fw);
 }
@@ -128,6 +145,8 @@ init_gl(struct piglit_wfl_framework *wfl_fw)
 		return false;
 	}
 
+	fbo_tex = tex;
+	fbo_depth = depth;
 	return true;
 #endif
 }
@@ -52,6 +52,17 @@ enter_event_loop(struct piglit_winsys_framework *winsys_fw)
 	exit(0);
 }
 
+/**
+ * Swap in -auto runs with PIGLIT_GBM_SKIP_SWAP. Nobody looks at the
+ * surface, so skip waffle's swap, which locks and releases the front buffer
+ * of the gbm surface, and only flush as the swap would.
+ */
+static void
+flush_only_swap_buffers(struct piglit_gl_framework *gl_fw)
+{
+	glFlush();
+}
+
 static void
 show_window(struct piglit_winsys_framework *winsys_fw)
 {
@@ -87,6 +98,10 @@ piglit_gbm_framework_create(const struct piglit_gl_test_config *test_config)
 
 	winsys_fw->show_window = show_window;
 	winsys_fw->enter_event_loop = enter_event_loop;
+	if (piglit_automatic && !piglit_dump_png &&
+	    !test_config->requires_displayed_window &&
+	    piglit_env_var_as_boolean("PIGLIT_GBM_SKIP_SWAP", false))
+		gl_fw->swap_buffers = flush_only_swap_buffers;
 	gl_fw->destroy = destroy;
 	piglit_set_destroy_func((void*)destroy, gl_fw);
 
@@ -44,6 +44,14 @@ piglit_gl_framework_factory(const struct piglit_gl_test_config *test_config)
 #ifdef PIGLIT_USE_WAFFLE
 	struct piglit_gl_framework *gl_fw = NULL;
 
+	/* -auto runs only read the window back, so with PIGLIT_AUTO_FBO they
+	 * render offscreen as with -fbo, without waiting for the window to be
+	 * mapped and exposed, unless the test needs the window.
+	 */
+	if (piglit_automatic &&
+	    piglit_env_var_as_boolean("PIGLIT_AUTO_FBO", false))
+		piglit_use_fbo = true;
+
 	if (piglit_use_fbo && !test_config->requires_displayed_window) {
 		gl_fw = piglit_fbo_framework_create(test_config);
 	}
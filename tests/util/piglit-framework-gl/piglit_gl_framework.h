@@ -78,6 +78,27 @@ struct piglit_gl_framework {
 
 	void
 	(*destroy_dma_buf)(struct piglit_dma_buf *buf);
+
+	/**
+	 * Create a context sharing objects with the test's context. May be
+	 * null.
+	 */
+	void *
+	(*create_shared_context)(struct piglit_gl_framework *gl_fw);
+
+	bool
+	(*make_shared_context_current)(struct piglit_gl_framework *gl_fw,
+				       void *ctx);
+
+	void
+	(*destroy_shared_context)(struct piglit_gl_framework *gl_fw,
+				  void *ctx);
+
+	/**
+	 * Make the test's context and window current again. May be null.
+	 */
+	bool
+	(*make_test_context_current)(struct piglit_gl_framework *gl_fw);
 };
 
 struct piglit_gl_framework*
@@ -23,6 +23,20 @@
 
 #include <stdio.h>
 
+#ifdef PIGLIT_HAS_EGL
+#	include "piglit-util-egl.h"
+#	include <waffle_surfaceless_egl.h>
+#	ifdef PIGLIT_HAS_GBM
+#		include <waffle_gbm.h>
+#	endif
+#	ifdef PIGLIT_HAS_WAYLAND
+#		include <waffle_wayland.h>
+#	endif
+#	ifdef PIGLIT_HAS_X11
+#		include <waffle_x11_egl.h>
+#	endif
+#endif
+
 #include "piglit-util-gl.h"
 #include "piglit-util-waffle.h"
 
@@ -34,6 +48,30 @@ enum context_flavor {
 	CONTEXT_GL_ES,
 };
 
+/**
+ * A context kept for reuse, see piglit_reuse_gl_contexts.
+ *
+ * The attribute list it was chosen with and the size of its window are the
+ * key. A NULL context records that no context could be created for them.
+ */
+struct pooled_context {
+	int32_t *attrib_list;
+	int window_width;
+	int window_height;
+
+	struct waffle_config *config;
+	struct waffle_context *context;
+	struct waffle_window *window;
+};
+
+#define CONTEXT_POOL_SIZE 8
+
+static struct {
+	struct waffle_display *display;
+	struct pooled_context entries[CONTEXT_POOL_SIZE];
+	unsigned count;
+} context_pool;
+
 static bool
 make_context_current_singlepass(struct piglit_wfl_framework *wfl_fw,
                                 const struct piglit_gl_test_config *test_config,
@@ -448,15 +486,194 @@ special_case_gl31(struct piglit_wfl_framework *wfl_fw,
 	waffle_window_destroy(wfl_fw->window);
 	waffle_context_destroy(wfl_fw->context);
 	waffle_config_destroy(wfl_fw->config);
+	free(wfl_fw->attrib_list);
 	wfl_fw->window = NULL;
 	wfl_fw->context = NULL;
 	wfl_fw->config = NULL;
+	wfl_fw->attrib_list = NULL;
 
 	return make_context_current_singlepass(
 			wfl_fw, &fallback_config, flavor,
 			partial_config_attrib_list);
 }
 
+/**
+ * Windows are kept with their context, so only the platforms on which the
+ * frameworks don't set up their windows further keep contexts.
+ */
+static bool
+platform_keeps_contexts(int32_t platform)
+{
+	return platform == WAFFLE_PLATFORM_GBM ||
+	       platform == WAFFLE_PLATFORM_SURFACELESS_EGL;
+}
+
+static bool
+is_reusing_contexts(const struct piglit_wfl_framework *wfl_fw)
+{
+	return piglit_reuse_gl_contexts && wfl_fw->display &&
+	       wfl_fw->display == context_pool.display;
+}
+
+static void
+destroy_pooled_context(struct pooled_context *entry)
+{
+	waffle_window_destroy(entry->window);
+	waffle_context_destroy(entry->context);
+	waffle_config_destroy(entry->config);
+	free(entry->attrib_list);
+}
+
+static void
+destroy_context_pool(void)
+{
+	unsigned i;
+
+	if (!context_pool.display)
+		return;
+
+	waffle_make_current(context_pool.display, NULL, NULL);
+	for (i = 0; i < context_pool.count; i++)
+		destroy_pooled_context(&context_pool.entries[i]);
+	context_pool.count = 0;
+
+	waffle_display_disconnect(context_pool.display);
+	context_pool.display = NULL;
+}
+
+static struct pooled_context *
+find_pooled_context(const int32_t attrib_list[], int width, int height)
+{
+	size_t size = (2 * waffle_attrib_list_length(attrib_list) + 1) *
+		      sizeof(int32_t);
+	unsigned i;
+
+	for (i = 0; i < context_pool.count; i++) {
+		struct pooled_context *entry = &context_pool.entries[i];
+
+		if (entry->window_width == width &&
+		    entry->window_height == height &&
+		    waffle_attrib_list_length(entry->attrib_list) ==
+		    waffle_attrib_list_length(attrib_list) &&
+		    memcmp(entry->attrib_list, attrib_list, size) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * Add a context to the pool, or a failure to create one if \a context is
+ * NULL. The oldest entry is destroyed if the pool is full. Takes ownership
+ * of everything passed.
+ */
+static void
+pool_context(int32_t *attrib_list, int width, int height,
+	     struct waffle_config *config, struct waffle_context *context,
+	     struct waffle_window *window)
+{
+	struct pooled_context *entry;
+
+	if (context_pool.count == CONTEXT_POOL_SIZE) {
+		destroy_pooled_context(&context_pool.entries[0]);
+		memmove(&context_pool.entries[0], &context_pool.entries[1],
+			(CONTEXT_POOL_SIZE - 1) * sizeof(context_pool.entries[0]));
+		context_pool.count--;
+	}
+
+	entry = &context_pool.entries[context_pool.count++];
+	entry->attrib_list = attrib_list;
+	entry->window_width = width;
+	entry->window_height = height;
+	entry->config = config;
+	entry->context = context;
+	entry->window = window;
+}
+
+static void
+dispatch_init(void)
+{
+#ifdef PIGLIT_USE_OPENGL
+	piglit_dispatch_default_init(PIGLIT_DISPATCH_GL);
+#elif defined(PIGLIT_USE_OPENGL_ES1)
+	piglit_dispatch_default_init(PIGLIT_DISPATCH_ES1);
+#elif defined(PIGLIT_USE_OPENGL_ES2) || defined(PIGLIT_USE_OPENGL_ES3)
+	piglit_dispatch_default_init(PIGLIT_DISPATCH_ES2);
+#else
+#	error
+#endif
+}
+
+/**
+ * Undo the state a previous test most commonly leaves in a reused context.
+ * Runners reusing contexts reset the rest of the state their tests change.
+ */
+static void
+reset_context_state(const struct piglit_gl_test_config *test_config)
+{
+	while (glGetError() != GL_NO_ERROR)
+		;
+
+#if defined(PIGLIT_USE_OPENGL)
+	if (piglit_get_gl_version() >= 20)
+		glUseProgram(0);
+	if (piglit_get_gl_version() >= 30 ||
+	    piglit_is_extension_supported("GL_ARB_framebuffer_object"))
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+#elif defined(PIGLIT_USE_OPENGL_ES2) || defined(PIGLIT_USE_OPENGL_ES3)
+	glUseProgram(0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+#endif
+
+	glViewport(0, 0, test_config->window_width, test_config->window_height);
+}
+
+/**
+ * Make a context of the pool current if one was created for the same
+ * attributes and window size. Returns false if the pool has none, and sets
+ * \a failed if creating one failed before.
+ */
+static bool
+make_pooled_context_current(struct piglit_wfl_framework *wfl_fw,
+                            const struct piglit_gl_test_config *test_config,
+                            const int32_t attrib_list[],
+                            const char *ctx_desc, bool *failed)
+{
+	struct pooled_context *entry;
+	unsigned index;
+
+	*failed = false;
+	entry = find_pooled_context(attrib_list, test_config->window_width,
+				    test_config->window_height);
+	if (!entry)
+		return false;
+
+	if (!entry->context) {
+		fprintf(stdout, "piglit: error: Failed to create "
+			"waffle_context for %s before\n", ctx_desc);
+		*failed = true;
+		return false;
+	}
+
+	wfl_fw->config = entry->config;
+	wfl_fw->context = entry->context;
+	wfl_fw->window = entry->window;
+	free(entry->attrib_list);
+
+	index = entry - context_pool.entries;
+	memmove(entry, entry + 1, (context_pool.count - index - 1) *
+		sizeof(*entry));
+	context_pool.count--;
+
+	wfl_checked_make_current(wfl_fw->display, wfl_fw->window,
+				 wfl_fw->context);
+	dispatch_init();
+	piglit_gl_invalidate_extensions();
+	reset_context_state(test_config);
+
+	return true;
+}
+
 static bool
 make_context_current_singlepass(struct piglit_wfl_framework *wfl_fw,
                                 const struct piglit_gl_test_config *test_config,
@@ -474,8 +691,24 @@ make_context_current_singlepass(struct piglit_wfl_framework *wfl_fw,
 	parse_test_config(test_config, flavor, ctx_desc, sizeof(ctx_desc),
 			  partial_config_attrib_list, &attrib_list);
 	assert(attrib_list);
+
+	if (is_reusing_contexts(wfl_fw)) {
+		bool failed;
+
+		if (make_pooled_context_current(wfl_fw, test_config,
+						attrib_list, ctx_desc,
+						&failed)) {
+			wfl_fw->attrib_list = attrib_list;
+			return true;
+		}
+		if (failed) {
+			free(attrib_list);
+			return false;
+		}
+	}
+
 	wfl_fw->config = waffle_config_choose(wfl_fw->display, attrib_list);
-	free(attrib_list);
+	wfl_fw->attrib_list = attrib_list;
 	if (!wfl_fw->config) {
 		/* Log this a little more quietly, as we expect this failure for
 		 * BAD_MATCH from trying to create (for example) ES1 contexts
@@ -507,15 +740,7 @@ make_context_current_singlepass(struct piglit_wfl_framework *wfl_fw,
 	                         wfl_fw->window,
 	                         wfl_fw->context);
 
-#ifdef PIGLIT_USE_OPENGL
-	piglit_dispatch_default_init(PIGLIT_DISPATCH_GL);
-#elif defined(PIGLIT_USE_OPENGL_ES1)
-	piglit_dispatch_default_init(PIGLIT_DISPATCH_ES1);
-#elif defined(PIGLIT_USE_OPENGL_ES2) || defined(PIGLIT_USE_OPENGL_ES3)
-	piglit_dispatch_default_init(PIGLIT_DISPATCH_ES2);
-#else
-#	error
-#endif
+	dispatch_init();
 
 	ok = check_gl_version(test_config, flavor, ctx_desc);
 	if (!ok)
@@ -535,9 +760,20 @@ fail:
 	waffle_context_destroy(wfl_fw->context);
 	waffle_config_destroy(wfl_fw->config);
 
+	/* The next framework needing the same context fails without
+	 * trying again.
+	 */
+	if (is_reusing_contexts(wfl_fw) && wfl_fw->attrib_list) {
+		pool_context(wfl_fw->attrib_list, test_config->window_width,
+			     test_config->window_height, NULL, NULL, NULL);
+	} else {
+		free(wfl_fw->attrib_list);
+	}
+
 	wfl_fw->window = NULL;
 	wfl_fw->context = NULL;
 	wfl_fw->config = NULL;
+	wfl_fw->attrib_list = NULL;
 
 	piglit_gl_invalidate_extensions();
 
@@ -620,6 +856,92 @@ make_context_current(struct piglit_wfl_framework *wfl_fw,
 }
 
 
+static void *
+create_shared_context(struct piglit_gl_framework *gl_fw)
+{
+	struct piglit_wfl_framework *wfl_fw = piglit_wfl_framework(gl_fw);
+
+	return waffle_context_create(wfl_fw->config, wfl_fw->context);
+}
+
+static bool
+make_shared_context_current(struct piglit_gl_framework *gl_fw, void *ctx)
+{
+	struct piglit_wfl_framework *wfl_fw = piglit_wfl_framework(gl_fw);
+
+	if (!ctx)
+		return waffle_make_current(wfl_fw->display, NULL, NULL);
+
+	/* Threads can't all bind the test's window on every platform, so
+	 * try without a window first, which needs surfaceless support.
+	 */
+	return waffle_make_current(wfl_fw->display, NULL, ctx) ||
+	       waffle_make_current(wfl_fw->display, wfl_fw->window, ctx);
+}
+
+static void
+destroy_shared_context(struct piglit_gl_framework *gl_fw, void *ctx)
+{
+	waffle_context_destroy(ctx);
+}
+
+static bool
+make_test_context_current(struct piglit_gl_framework *gl_fw)
+{
+	struct piglit_wfl_framework *wfl_fw = piglit_wfl_framework(gl_fw);
+
+	return waffle_make_current(wfl_fw->display, wfl_fw->window,
+				   wfl_fw->context);
+}
+
+/**
+ * Install the blob cache of PIGLIT_BLOB_CACHE_DIR on the EGL display of a
+ * newly connected waffle display, before any shader is compiled.
+ */
+static void
+install_blob_cache(struct piglit_wfl_framework *wfl_fw)
+{
+#ifdef PIGLIT_HAS_EGL
+	union waffle_native_display *n_display;
+	EGLDisplay egl_display = EGL_NO_DISPLAY;
+
+	if (!getenv("PIGLIT_BLOB_CACHE_DIR"))
+		return;
+
+	n_display = waffle_display_get_native(wfl_fw->display);
+	if (!n_display)
+		return;
+
+	switch (wfl_fw->platform) {
+#ifdef PIGLIT_HAS_GBM
+	case WAFFLE_PLATFORM_GBM:
+		egl_display = n_display->gbm->egl_display;
+		break;
+#endif
+#ifdef PIGLIT_HAS_WAYLAND
+	case WAFFLE_PLATFORM_WAYLAND:
+		egl_display = n_display->wayland->egl_display;
+		break;
+#endif
+#ifdef PIGLIT_HAS_X11
+	case WAFFLE_PLATFORM_X11_EGL:
+		egl_display = n_display->x11_egl->egl_display;
+		break;
+#endif
+	case WAFFLE_PLATFORM_SURFACELESS_EGL:
+		egl_display = n_display->surfaceless_egl->egl_display;
+		break;
+	default:
+		break;
+	}
+
+	free(n_display);
+
+	if (egl_display != EGL_NO_DISPLAY)
+		piglit_egl_install_blob_cache(egl_display);
+#endif
+}
+
 bool
 piglit_wfl_framework_init(struct piglit_wfl_framework *wfl_fw,
                           const struct piglit_gl_test_config *test_config,
@@ -649,8 +971,23 @@ piglit_wfl_framework_init(struct piglit_wfl_framework *wfl_fw,
 		return false;
 	}
 
+	wfl_fw->gl_fw.create_shared_context = create_shared_context;
+	wfl_fw->gl_fw.make_shared_context_current = make_shared_context_current;
+	wfl_fw->gl_fw.destroy_shared_context = destroy_shared_context;
+	wfl_fw->gl_fw.make_test_context_current = make_test_context_current;
+
 	wfl_fw->platform = platform;
-	wfl_fw->display = wfl_checked_display_connect(NULL);
+	if (context_pool.display) {
+		wfl_fw->display = context_pool.display;
+	} else {
+		wfl_fw->display = wfl_checked_display_connect(NULL);
+		install_blob_cache(wfl_fw);
+		if (piglit_reuse_gl_contexts &&
+		    platform_keeps_contexts(platform)) {
+			context_pool.display = wfl_fw->display;
+			atexit(destroy_context_pool);
+		}
+	}
 	make_context_current(wfl_fw, test_config, partial_config_attrib_list);
 
 	return true;
@@ -660,10 +997,32 @@ void
 piglit_wfl_framework_teardown(struct piglit_wfl_framework *wfl_fw)
 {
 	waffle_make_current(wfl_fw->display, NULL, NULL);
-	waffle_context_destroy(wfl_fw->context);
-	waffle_window_destroy(wfl_fw->window);
-	waffle_config_destroy(wfl_fw->config);
-	waffle_display_disconnect(wfl_fw->display);
+
+	if (wfl_fw->display && wfl_fw->display == context_pool.display) {
+		if (is_reusing_contexts(wfl_fw) && wfl_fw->context) {
+			pool_context(wfl_fw->attrib_list,
+				     wfl_fw->gl_fw.test_config->window_width,
+				     wfl_fw->gl_fw.test_config->window_height,
+				     wfl_fw->config, wfl_fw->context,
+				     wfl_fw->window);
+		} else {
+			waffle_context_destroy(wfl_fw->context);
+			waffle_window_destroy(wfl_fw->window);
+			waffle_config_destroy(wfl_fw->config);
+			free(wfl_fw->attrib_list);
+		}
+	} else {
+		waffle_context_destroy(wfl_fw->context);
+		waffle_window_destroy(wfl_fw->window);
+		waffle_config_destroy(wfl_fw->config);
+		free(wfl_fw->attrib_list);
+		waffle_display_disconnect(wfl_fw->display);
+	}
+
+	wfl_fw->context = NULL;
+	wfl_fw->window = NULL;
+	wfl_fw->config = NULL;
+	wfl_fw->attrib_list = NULL;
 
 	piglit_gl_framework_teardown(&wfl_fw->gl_fw);
 }
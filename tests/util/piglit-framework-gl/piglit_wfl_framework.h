@@ -39,6 +39,12 @@ struct piglit_wfl_framework {
 	struct waffle_config *config;
 	struct waffle_context *context;
 	struct waffle_window *window;
+
+	/**
+	 * The attributes the config was chosen with, the key of the context
+	 * when it is kept for reuse.
+	 */
+	int32_t *attrib_list;
 };
 
 /**
@@ -56,6 +62,10 @@ piglit_wfl_framework_init(struct piglit_wfl_framework *wfl_fw,
                           int32_t platform,
                           const int32_t partial_config_attrib_list[]);
 
+/**
+ * Destroy the context of the framework, or keep it and the display for the
+ * frameworks created later if piglit_reuse_gl_contexts is set.
+ */
 void
 piglit_wfl_framework_teardown(struct piglit_wfl_framework *wfl_fw);
 
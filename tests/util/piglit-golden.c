@@ -0,0 +1,640 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-golden.c
+ *
+ * Check the whole of every frame a test presents against golden images.
+ *
+ * When PIGLIT_GOLDEN_DIR is set, each frame passed to
+ * piglit_present_results() by a test run with -auto is split into tiles of
+ * PIGLIT_GOLDEN_TILE pixels (32 by default) and each tile is hashed, with a
+ * compute shader when GL 4.3 is available so that only the hashes are read
+ * back.
+ *
+ * With PIGLIT_GOLDEN_RECORD=1 the hashes are written to the manifest
+ * "<dir>/<name>.golden" and the frame to "<dir>/<name>-<frame>.rgba", in
+ * the raw format of piglit_dump_image().  Otherwise the hashes are compared
+ * with the manifest, and only the tiles whose hash differs are read back
+ * and compared with the recorded frame pixel by pixel, within
+ * piglit_tolerance.  The tiles that still differ are printed and fail the
+ * test, and the frame is dumped to "<name>-<frame>-observed" next to it.
+ *
+ * The name is PIGLIT_GOLDEN_NAME, or else made of the name of the binary
+ * and of its arguments that aren't options.
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piglit-util-gl.h"
+
+#define GOLDEN_GROUP_SIZE 64
+
+struct golden_frame {
+	int width, height, tile;
+	unsigned num_tiles;
+	uint64_t *hashes;
+};
+
+static const char *golden_dir;
+static char golden_name[256];
+static int tile_size = 32;
+static bool record;
+static unsigned frame;
+
+static struct golden_frame *manifest;
+static unsigned manifest_frames;
+static bool manifest_loaded;
+static FILE *manifest_out;
+
+static enum piglit_result golden_result = PIGLIT_PASS;
+
+/*
+ * The hash of a tile is the sum and the xor of the hashes of its pixels
+ * combined with their position in the tile, so that the pixels can be
+ * added up in any order, and gpu_golden_source has to match these.
+ */
+static uint32_t
+mix_pixel(uint32_t pixel, uint32_t index)
+{
+	uint32_t h = pixel ^ (index * 0x9e3779b9u);
+
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+static const char gpu_golden_source[] =
+	"#version 430\n"
+	"layout(local_size_x = 64) in;\n"
+	"layout(std430, binding = 0) readonly buffer pixels_buf {\n"
+	"	uint pixels[];\n"
+	"};\n"
+	"layout(std430, binding = 1) buffer hashes_buf {\n"
+	"	uint hashes[];\n"
+	"};\n"
+	"layout(location = 0) uniform ivec2 size;\n"
+	"layout(location = 1) uniform int tile;\n"
+	"uint mix_pixel(uint pixel, uint index)\n"
+	"{\n"
+	"	uint h = pixel ^ (index * 0x9e3779b9u);\n"
+	"	h ^= h >> 16;\n"
+	"	h *= 0x85ebca6bu;\n"
+	"	h ^= h >> 13;\n"
+	"	h *= 0xc2b2ae35u;\n"
+	"	h ^= h >> 16;\n"
+	"	return h;\n"
+	"}\n"
+	"void main()\n"
+	"{\n"
+	"	uint i = gl_GlobalInvocationID.x;\n"
+	"	if (i >= uint(size.x * size.y))\n"
+	"		return;\n"
+	"	int x = int(i) % size.x, y = int(i) / size.x;\n"
+	"	int tiles_x = (size.x + tile - 1) / tile;\n"
+	"	uint t = uint((y / tile) * tiles_x + x / tile);\n"
+	"	uint index = uint((y % tile) * tile + x % tile);\n"
+	"	atomicAdd(hashes[2u * t], mix_pixel(pixels[i], index));\n"
+	"	atomicXor(hashes[2u * t + 1u],\n"
+	"		  mix_pixel(pixels[i] ^ 0x5bd1e995u, index));\n"
+	"}\n";
+
+static GLuint
+gpu_golden_program(void)
+{
+	static GLuint prog;
+	static bool unavailable;
+	GLuint cs;
+
+	if (unavailable)
+		return 0;
+
+	/* The context may have been recreated since the last call. */
+	if (prog && glIsProgram(prog))
+		return prog;
+
+	if (piglit_is_gles() || piglit_get_gl_version() < 43) {
+		unavailable = true;
+		return 0;
+	}
+
+	cs = piglit_compile_shader_text_nothrow(GL_COMPUTE_SHADER,
+						gpu_golden_source, false);
+	if (!cs) {
+		unavailable = true;
+		return 0;
+	}
+
+	prog = glCreateProgram();
+	glAttachShader(prog, cs);
+	glLinkProgram(prog);
+	glDeleteShader(cs);
+
+	if (!piglit_link_check_status_quiet(prog)) {
+		glDeleteProgram(prog);
+		prog = 0;
+		unavailable = true;
+	}
+
+	return prog;
+}
+
+static unsigned
+count_tiles(int width, int height, int tile)
+{
+	return ((width + tile - 1) / tile) * ((height + tile - 1) / tile);
+}
+
+static void
+combine_hashes(const uint32_t *halves, unsigned num_tiles, uint64_t *hashes)
+{
+	for (unsigned i = 0; i < num_tiles; i++)
+		hashes[i] = (uint64_t) halves[2 * i + 1] << 32 | halves[2 * i];
+}
+
+/**
+ * Hash the tiles of the read framebuffer with a compute shader, so that
+ * only the hashes are read back.  Return false if this isn't available.
+ */
+static bool
+gpu_hash_tiles(int width, int height, uint64_t *hashes)
+{
+	const unsigned num_tiles = count_tiles(width, height, tile_size);
+	const GLuint num_pixels = width * height;
+	const GLuint num_groups = (num_pixels + GOLDEN_GROUP_SIZE - 1) /
+		GOLDEN_GROUP_SIZE;
+	GLuint prog, bufs[2];
+	GLint prev_prog, prev_pack;
+	GLint prev_ssbo[2];
+	GLint64 prev_start[2], prev_size[2];
+	uint32_t *halves;
+
+	if (num_groups > 65535)
+		return false;
+
+	prog = gpu_golden_program();
+	if (!prog)
+		return false;
+
+	halves = calloc(num_tiles, 2 * sizeof(uint32_t));
+	if (!halves)
+		return false;
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &prev_prog);
+	glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &prev_pack);
+	for (int i = 0; i < 2; i++) {
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, i,
+				&prev_ssbo[i]);
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, i,
+				  &prev_start[i]);
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, i,
+				  &prev_size[i]);
+	}
+
+	glGenBuffers(2, bufs);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, bufs[0]);
+	glBufferData(GL_PIXEL_PACK_BUFFER, num_pixels * 4, NULL,
+		     GL_STREAM_COPY);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, prev_pack);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bufs[0]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, bufs[1]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, num_tiles * 2 * sizeof(uint32_t),
+		     halves, GL_STREAM_READ);
+
+	glUseProgram(prog);
+	glUniform2i(0, width, height);
+	glUniform1i(1, tile_size);
+	glDispatchCompute(num_groups, 1, 1);
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+			   num_tiles * 2 * sizeof(uint32_t), halves);
+
+	glUseProgram(prev_prog);
+	for (int i = 0; i < 2; i++) {
+		if (prev_size[i])
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, i,
+					  prev_ssbo[i], prev_start[i],
+					  prev_size[i]);
+		else
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i,
+					 prev_ssbo[i]);
+	}
+	glDeleteBuffers(2, bufs);
+
+	combine_hashes(halves, num_tiles, hashes);
+	free(halves);
+	return true;
+}
+
+static uint32_t
+load_pixel(const GLubyte *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+/**
+ * Hash the tiles of an image read back with glReadPixels(), bottom row
+ * first, the same way as gpu_golden_source.
+ */
+static void
+cpu_hash_tiles(const GLubyte *pixels, int width, int height, uint64_t *hashes)
+{
+	const unsigned num_tiles = count_tiles(width, height, tile_size);
+	const int tiles_x = (width + tile_size - 1) / tile_size;
+	uint32_t *halves = calloc(num_tiles, 2 * sizeof(uint32_t));
+
+	if (!halves) {
+		fprintf(stderr, "golden: out of memory\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			uint32_t pixel = load_pixel(pixels + 4 * (y * width + x));
+			unsigned t = (y / tile_size) * tiles_x + x / tile_size;
+			uint32_t index = (y % tile_size) * tile_size +
+				x % tile_size;
+
+			halves[2 * t] += mix_pixel(pixel, index);
+			halves[2 * t + 1] ^= mix_pixel(pixel ^ 0x5bd1e995u,
+						       index);
+		}
+	}
+
+	combine_hashes(halves, num_tiles, hashes);
+	free(halves);
+}
+
+static GLubyte *
+read_frame(int width, int height)
+{
+	GLubyte *pixels = malloc((size_t) width * height * 4);
+
+	if (!pixels) {
+		fprintf(stderr, "golden: out of memory\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	return pixels;
+}
+
+static char *
+golden_path(const char *suffix)
+{
+	char *path;
+
+	if (asprintf(&path, "%s/%s%s", golden_dir, golden_name, suffix) < 0) {
+		fprintf(stderr, "golden: out of memory\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	return path;
+}
+
+static void
+load_manifest(void)
+{
+	char *path = golden_path(".golden");
+	FILE *f = fopen(path, "r");
+	struct golden_frame fr;
+	unsigned index;
+
+	manifest_loaded = true;
+	if (!f) {
+		fprintf(stderr, "golden: no manifest %s, not checking\n", path);
+		free(path);
+		return;
+	}
+
+	while (fscanf(f, " frame %u %d %d %d", &index, &fr.width, &fr.height,
+		      &fr.tile) == 4) {
+		if (index != manifest_frames || fr.width <= 0 ||
+		    fr.height <= 0 || fr.tile <= 0)
+			break;
+
+		fr.num_tiles = count_tiles(fr.width, fr.height, fr.tile);
+		fr.hashes = malloc(fr.num_tiles * sizeof(uint64_t));
+		if (!fr.hashes)
+			break;
+		for (unsigned i = 0; i < fr.num_tiles; i++) {
+			if (fscanf(f, " %" SCNx64, &fr.hashes[i]) != 1) {
+				fprintf(stderr, "golden: truncated %s\n", path);
+				piglit_report_result(PIGLIT_FAIL);
+			}
+		}
+
+		manifest = realloc(manifest,
+				   (manifest_frames + 1) * sizeof(*manifest));
+		if (!manifest)
+			break;
+		manifest[manifest_frames++] = fr;
+	}
+
+	fclose(f);
+	free(path);
+}
+
+static void
+write_golden_frame(const GLubyte *pixels, int width, int height,
+		   const uint64_t *hashes)
+{
+	const unsigned num_tiles = count_tiles(width, height, tile_size);
+	const int tiles_x = (width + tile_size - 1) / tile_size;
+	uint32_t header[4] = { PIGLIT_RAW_IMAGE_MAGIC, width, height, 4 };
+	char suffix[32];
+	char *path;
+	FILE *f;
+
+	if (!manifest_out) {
+		path = golden_path(".golden");
+		manifest_out = fopen(path, "w");
+		if (!manifest_out) {
+			fprintf(stderr, "golden: can't write %s\n", path);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+		free(path);
+	}
+
+	fprintf(manifest_out, "frame %u %d %d %d\n", frame, width, height,
+		tile_size);
+	for (unsigned i = 0; i < num_tiles; i++)
+		fprintf(manifest_out, "%016" PRIx64 "%c", hashes[i],
+			(i + 1) % tiles_x && i + 1 < num_tiles ? ' ' : '\n');
+	fflush(manifest_out);
+
+	/* The frame, top row first like piglit_dump_image(). */
+	snprintf(suffix, sizeof(suffix), "-%u.rgba", frame);
+	path = golden_path(suffix);
+	f = fopen(path, "wb");
+	if (!f || fwrite(header, sizeof(header), 1, f) != 1) {
+		fprintf(stderr, "golden: can't write %s\n", path);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+	for (int y = height - 1; y >= 0; y--) {
+		if (fwrite(pixels + (size_t) y * width * 4, width * 4, 1,
+			   f) != 1) {
+			fprintf(stderr, "golden: can't write %s\n", path);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	}
+	fclose(f);
+	free(path);
+}
+
+/**
+ * Compare tile t of the frame with the recorded frame, and print the
+ * pixels that are further apart than piglit_tolerance.  Return true if
+ * there are none.
+ */
+static bool
+compare_tile(FILE *golden, int width, int height, unsigned t)
+{
+	const int tiles_x = (width + tile_size - 1) / tile_size;
+	const int x0 = (t % tiles_x) * tile_size;
+	const int y0 = (t / tiles_x) * tile_size;
+	const int w = MIN2(tile_size, width - x0);
+	const int h = MIN2(tile_size, height - y0);
+	GLubyte observed[4 * 256], expected[4 * 256];
+	unsigned bad = 0;
+	int tolerance[4];
+	int first_x = 0, first_y = 0;
+	GLubyte first_observed[4], first_expected[4];
+
+	for (int c = 0; c < 4; c++)
+		tolerance[c] = (int) ceilf(piglit_tolerance[c] * 255.0f);
+
+	for (int y = y0; y < y0 + h; y++) {
+		long offset = 16 + ((long) (height - 1 - y) * width + x0) * 4;
+
+		glReadPixels(x0, y, w, 1, GL_RGBA, GL_UNSIGNED_BYTE, observed);
+		if (fseek(golden, offset, SEEK_SET) != 0 ||
+		    fread(expected, w * 4, 1, golden) != 1)
+			return false;
+
+		for (int x = 0; x < w; x++) {
+			const GLubyte *o = observed + 4 * x;
+			const GLubyte *e = expected + 4 * x;
+			bool differs = false;
+
+			for (int c = 0; c < 4; c++) {
+				if (abs(o[c] - e[c]) > tolerance[c])
+					differs = true;
+			}
+			if (!differs)
+				continue;
+			if (bad++ == 0) {
+				first_x = x0 + x;
+				first_y = y;
+				memcpy(first_observed, o, 4);
+				memcpy(first_expected, e, 4);
+			}
+		}
+	}
+
+	if (bad) {
+		printf("golden: frame %u tile at (%d, %d): %u pixels differ, "
+		       "first at (%d, %d)\n"
+		       "  Expected: %u %u %u %u\n"
+		       "  Observed: %u %u %u %u\n",
+		       frame, x0, y0, bad, first_x, first_y,
+		       first_expected[0], first_expected[1],
+		       first_expected[2], first_expected[3],
+		       first_observed[0], first_observed[1],
+		       first_observed[2], first_observed[3]);
+	}
+	return bad == 0;
+}
+
+static void
+check_golden_frame(int width, int height, const uint64_t *hashes)
+{
+	const struct golden_frame *fr;
+	unsigned num_mismatched = 0;
+	bool pass = true;
+	char suffix[32];
+	char *path;
+	FILE *golden;
+
+	if (!manifest_loaded)
+		load_manifest();
+	if (frame >= manifest_frames) {
+		if (manifest_frames)
+			fprintf(stderr, "golden: no frame %u in the "
+				"manifest\n", frame);
+		return;
+	}
+
+	fr = &manifest[frame];
+	if (fr->width != width || fr->height != height ||
+	    fr->tile != tile_size) {
+		printf("golden: frame %u is %dx%d in tiles of %d, the manifest "
+		       "has %dx%d in tiles of %d\n", frame, width, height,
+		       tile_size, fr->width, fr->height, fr->tile);
+		golden_result = PIGLIT_FAIL;
+		return;
+	}
+
+	for (unsigned t = 0; t < fr->num_tiles; t++) {
+		if (hashes[t] != fr->hashes[t])
+			num_mismatched++;
+	}
+	if (num_mismatched == 0)
+		return;
+
+	snprintf(suffix, sizeof(suffix), "-%u.rgba", frame);
+	path = golden_path(suffix);
+	golden = fopen(path, "rb");
+	if (!golden) {
+		printf("golden: %u tiles of frame %u differ and %s is "
+		       "missing\n", num_mismatched, frame, path);
+		golden_result = PIGLIT_FAIL;
+		free(path);
+		return;
+	}
+
+	for (unsigned t = 0; t < fr->num_tiles; t++) {
+		if (hashes[t] != fr->hashes[t] &&
+		    !compare_tile(golden, width, height, t))
+			pass = false;
+	}
+	fclose(golden);
+	free(path);
+
+	if (!pass) {
+		GLubyte *pixels = read_frame(width, height);
+		char *name;
+
+		if (asprintf(&name, "%s/%s-%u-observed", golden_dir,
+			     golden_name, frame) >= 0) {
+			piglit_dump_image(name, GL_RGBA, width, height,
+					  pixels, true);
+			free(name);
+		}
+		free(pixels);
+		golden_result = PIGLIT_FAIL;
+	}
+}
+
+/**
+ * Whether the frames are checked against golden images, and which.  Called
+ * with the command line of the test before the framework parses it.
+ */
+bool
+piglit_golden_init(int argc, char *argv[])
+{
+	const char *name = getenv("PIGLIT_GOLDEN_NAME");
+	const char *tile = getenv("PIGLIT_GOLDEN_TILE");
+	size_t len;
+
+	golden_dir = getenv("PIGLIT_GOLDEN_DIR");
+	if (!golden_dir || !golden_dir[0]) {
+		golden_dir = NULL;
+		return false;
+	}
+
+	record = piglit_env_var_as_boolean("PIGLIT_GOLDEN_RECORD", false);
+	if (tile)
+		tile_size = CLAMP(atoi(tile), 1, 256);
+
+	if (name) {
+		snprintf(golden_name, sizeof(golden_name), "%s", name);
+	} else {
+		const char *base = strrchr(argv[0], '/');
+
+		snprintf(golden_name, sizeof(golden_name), "%s",
+			 base ? base + 1 : argv[0]);
+		for (int i = 1; i < argc; i++) {
+			if (argv[i][0] == '-')
+				continue;
+			base = strrchr(argv[i], '/');
+			len = strlen(golden_name);
+			snprintf(golden_name + len, sizeof(golden_name) - len,
+				 "_%s", base ? base + 1 : argv[i]);
+		}
+		/* Strip potentially bad characters */
+		for (int i = 0; golden_name[i]; i++) {
+			if (!isalnum(golden_name[i]) && golden_name[i] != '-')
+				golden_name[i] = '_';
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Hash the frame being presented and record it, or check it against the
+ * golden manifest.
+ */
+void
+piglit_golden_check_frame(void)
+{
+	const int width = piglit_width, height = piglit_height;
+	const unsigned num_tiles = count_tiles(width, height, tile_size);
+	GLubyte *pixels = NULL;
+	uint64_t *hashes;
+
+	if (!golden_dir || !piglit_automatic)
+		return;
+
+	hashes = malloc(num_tiles * sizeof(*hashes));
+	if (!hashes) {
+		fprintf(stderr, "golden: out of memory\n");
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	/* Recording needs the pixels anyway. */
+	if (record || !gpu_hash_tiles(width, height, hashes)) {
+		pixels = read_frame(width, height);
+		cpu_hash_tiles(pixels, width, height, hashes);
+	}
+
+	if (record)
+		write_golden_frame(pixels, width, height, hashes);
+	else
+		check_golden_frame(width, height, hashes);
+
+	free(pixels);
+	free(hashes);
+	frame++;
+}
+
+/**
+ * PIGLIT_FAIL if a frame presented so far didn't match its golden image.
+ */
+enum piglit_result
+piglit_golden_result(void)
+{
+	return golden_result;
+}
@@ -0,0 +1,495 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-perf-counters.c
+ *
+ * Record GPU performance counters around the work of a test.
+ *
+ * PIGLIT_PERF_COUNTERS is a comma separated list of counter names.  The
+ * counters are found among those of GL_INTEL_performance_query, in the
+ * first query that has the first of them, or else among those of all the
+ * groups of GL_AMD_performance_monitor.  Names that aren't found are
+ * printed and left out.
+ *
+ * The counters are summed over the sessions between
+ * piglit_perf_counters_begin() and piglit_perf_counters_end(), except for
+ * the percentages, which are averaged.  Sessions nest: the outer session is
+ * stopped while an inner one counts, and the values of the inner one are
+ * also added to it.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piglit-util-gl.h"
+
+#define MAX_DEPTH 4
+
+enum backend {
+	BACKEND_NONE,
+	BACKEND_INTEL,
+	BACKEND_AMD,
+};
+
+struct counter {
+	struct piglit_perf_counter info;
+	/** The group of AMD counters. */
+	GLuint group;
+	GLuint id;
+	/** The offset and the type of INTEL counters in the query data. */
+	GLuint offset;
+	GLenum type;
+	double total;
+	unsigned sessions;
+};
+
+static enum backend backend;
+static bool initialized;
+static struct counter counters[PIGLIT_MAX_PERF_COUNTERS];
+static unsigned num_counters;
+
+static GLuint intel_query_id;
+static GLuint intel_query_size;
+static GLuint handle;
+
+static unsigned depth;
+static struct {
+	double total;
+	unsigned sessions;
+} marks[MAX_DEPTH][PIGLIT_MAX_PERF_COUNTERS];
+
+static bool
+add_counter(const char *name, const char *unit)
+{
+	struct counter *c;
+
+	if (num_counters == PIGLIT_MAX_PERF_COUNTERS)
+		return false;
+
+	c = &counters[num_counters++];
+	memset(c, 0, sizeof(*c));
+	snprintf(c->info.name, sizeof(c->info.name), "%s", name);
+	c->info.unit = unit;
+	return true;
+}
+
+static bool
+intel_find(GLuint query, const char *name)
+{
+	GLuint num, instances, caps, i;
+
+	glGetPerfQueryInfoINTEL(query, 0, NULL, &intel_query_size, &num,
+				&instances, &caps);
+	for (i = 1; i <= num; i++) {
+		char counter_name[256];
+		GLuint offset, size, type, data_type;
+		GLuint64 max;
+
+		glGetPerfCounterInfoINTEL(query, i,
+					  sizeof(counter_name), counter_name,
+					  0, NULL, &offset, &size, &type,
+					  &data_type, &max);
+		if (strcmp(counter_name, name) != 0)
+			continue;
+
+		if (!add_counter(name,
+				 type == GL_PERFQUERY_COUNTER_DURATION_RAW_INTEL ?
+				 "ns" :
+				 type == GL_PERFQUERY_COUNTER_DURATION_NORM_INTEL ?
+				 "%" : ""))
+			return true;
+		counters[num_counters - 1].id = i;
+		counters[num_counters - 1].offset = offset;
+		counters[num_counters - 1].type = data_type;
+		return true;
+	}
+	return false;
+}
+
+static bool
+intel_init(char **names, unsigned count)
+{
+	GLuint query = 0;
+	unsigned i;
+
+	if (!piglit_is_extension_supported("GL_INTEL_performance_query"))
+		return false;
+
+	/* All the counters have to be in one query. */
+	glGetFirstPerfQueryIdINTEL(&query);
+	while (query) {
+		if (intel_find(query, names[0]))
+			break;
+		glGetNextPerfQueryIdINTEL(query, &query);
+	}
+	if (!query)
+		return false;
+
+	intel_query_id = query;
+	for (i = 1; i < count; i++) {
+		if (!intel_find(query, names[i]))
+			fprintf(stderr, "perf counters: no %s in the query of %s\n",
+				names[i], names[0]);
+	}
+	glCreatePerfQueryINTEL(intel_query_id, &handle);
+	return true;
+}
+
+static bool
+amd_find(const char *name)
+{
+	GLint num_groups, num, max_active, g, i;
+	GLuint *groups, *ids;
+
+	glGetPerfMonitorGroupsAMD(&num_groups, 0, NULL);
+	groups = calloc(num_groups, sizeof(*groups));
+	glGetPerfMonitorGroupsAMD(NULL, num_groups, groups);
+
+	for (g = 0; g < num_groups; g++) {
+		glGetPerfMonitorCountersAMD(groups[g], &num, &max_active,
+					    0, NULL);
+		ids = calloc(num, sizeof(*ids));
+		glGetPerfMonitorCountersAMD(groups[g], NULL, NULL, num, ids);
+
+		for (i = 0; i < num; i++) {
+			char counter_name[256];
+			GLenum type;
+
+			glGetPerfMonitorCounterStringAMD(groups[g], ids[i],
+							 sizeof(counter_name),
+							 NULL, counter_name);
+			if (strcmp(counter_name, name) != 0)
+				continue;
+
+			glGetPerfMonitorCounterInfoAMD(groups[g], ids[i],
+						       GL_COUNTER_TYPE_AMD,
+						       &type);
+			if (add_counter(name, type == GL_PERCENTAGE_AMD ?
+					"%" : "")) {
+				counters[num_counters - 1].group = groups[g];
+				counters[num_counters - 1].id = ids[i];
+				counters[num_counters - 1].type = type;
+			}
+			free(ids);
+			free(groups);
+			return true;
+		}
+		free(ids);
+	}
+	free(groups);
+	return false;
+}
+
+static bool
+amd_init(char **names, unsigned count)
+{
+	unsigned i;
+
+	if (!piglit_is_extension_supported("GL_AMD_performance_monitor"))
+		return false;
+
+	for (i = 0; i < count; i++) {
+		if (!amd_find(names[i]))
+			fprintf(stderr, "perf counters: no counter %s\n",
+				names[i]);
+	}
+	if (!num_counters)
+		return false;
+
+	glGenPerfMonitorsAMD(1, &handle);
+	for (i = 0; i < num_counters; i++) {
+		glSelectPerfMonitorCountersAMD(handle, GL_TRUE,
+					       counters[i].group, 1,
+					       &counters[i].id);
+	}
+	return true;
+}
+
+/**
+ * Find the counters of PIGLIT_PERF_COUNTERS, once there is a context.
+ */
+static void
+init(void)
+{
+	const char *env = getenv("PIGLIT_PERF_COUNTERS");
+	char *list, *name, *saveptr;
+	char *names[PIGLIT_MAX_PERF_COUNTERS];
+	unsigned count = 0;
+
+	initialized = true;
+	if (!env || !*env)
+		return;
+
+	list = strdup(env);
+	for (name = strtok_r(list, ",", &saveptr);
+	     name && count < PIGLIT_MAX_PERF_COUNTERS;
+	     name = strtok_r(NULL, ",", &saveptr))
+		names[count++] = name;
+
+	if (count && intel_init(names, count)) {
+		backend = BACKEND_INTEL;
+	} else if (count && amd_init(names, count)) {
+		backend = BACKEND_AMD;
+	} else {
+		fprintf(stderr, "perf counters: none of %s are available\n",
+			env);
+		num_counters = 0;
+	}
+	free(list);
+}
+
+static void
+start(void)
+{
+	if (backend == BACKEND_INTEL)
+		glBeginPerfQueryINTEL(handle);
+	else
+		glBeginPerfMonitorAMD(handle);
+}
+
+static double
+intel_value(const unsigned char *data, const struct counter *c)
+{
+	switch (c->type) {
+	case GL_PERFQUERY_COUNTER_DATA_UINT32_INTEL:
+	case GL_PERFQUERY_COUNTER_DATA_BOOL32_INTEL:
+		return *(const uint32_t *)(data + c->offset);
+	case GL_PERFQUERY_COUNTER_DATA_UINT64_INTEL:
+		return *(const uint64_t *)(data + c->offset);
+	case GL_PERFQUERY_COUNTER_DATA_FLOAT_INTEL:
+		return *(const float *)(data + c->offset);
+	case GL_PERFQUERY_COUNTER_DATA_DOUBLE_INTEL:
+		return *(const double *)(data + c->offset);
+	default:
+		return 0;
+	}
+}
+
+static void
+intel_stop(void)
+{
+	unsigned char *data = calloc(1, intel_query_size);
+	GLuint written = 0;
+	unsigned i;
+
+	glEndPerfQueryINTEL(handle);
+	glGetPerfQueryDataINTEL(handle, GL_PERFQUERY_WAIT_INTEL,
+				intel_query_size, data, &written);
+	if (written) {
+		for (i = 0; i < num_counters; i++) {
+			counters[i].total += intel_value(data, &counters[i]);
+			counters[i].sessions++;
+		}
+	}
+	free(data);
+}
+
+static struct counter *
+amd_counter(GLuint group, GLuint id)
+{
+	unsigned i;
+
+	for (i = 0; i < num_counters; i++) {
+		if (counters[i].group == group && counters[i].id == id)
+			return &counters[i];
+	}
+	return NULL;
+}
+
+static void
+amd_stop(void)
+{
+	GLuint available = 0, size = 0, *data;
+	GLint written = 0, pos = 0;
+
+	glEndPerfMonitorAMD(handle);
+	glFinish();
+	while (!available) {
+		glGetPerfMonitorCounterDataAMD(handle,
+					       GL_PERFMON_RESULT_AVAILABLE_AMD,
+					       sizeof(available), &available,
+					       NULL);
+	}
+	glGetPerfMonitorCounterDataAMD(handle, GL_PERFMON_RESULT_SIZE_AMD,
+				       sizeof(size), &size, NULL);
+	data = calloc(1, size);
+	glGetPerfMonitorCounterDataAMD(handle, GL_PERFMON_RESULT_AMD, size,
+				       data, &written);
+
+	/* The counters are (group, counter, value) tuples. */
+	written /= sizeof(GLuint);
+	while (pos + 2 < written) {
+		struct counter *c = amd_counter(data[pos], data[pos + 1]);
+		GLenum type = c ? c->type : GL_UNSIGNED_INT;
+		double value;
+
+		pos += 2;
+		if (type == GL_UNSIGNED_INT64_AMD) {
+			uint64_t v;
+			memcpy(&v, &data[pos], sizeof(v));
+			value = v;
+			pos += 2;
+		} else if (type == GL_FLOAT || type == GL_PERCENTAGE_AMD) {
+			float v;
+			memcpy(&v, &data[pos], sizeof(v));
+			value = v;
+			pos++;
+		} else {
+			value = data[pos++];
+		}
+
+		if (c) {
+			c->total += value;
+			c->sessions++;
+		}
+	}
+	free(data);
+}
+
+static void
+stop(void)
+{
+	if (backend == BACKEND_INTEL)
+		intel_stop();
+	else
+		amd_stop();
+}
+
+/**
+ * Start counting, stopping the session this one is in for its duration.
+ *
+ * Return false when there is nothing to count, in which case
+ * piglit_perf_counters_end() mustn't be called.
+ */
+bool
+piglit_perf_counters_begin(void)
+{
+	unsigned i;
+
+	if (!initialized)
+		init();
+	if (!num_counters || depth == MAX_DEPTH)
+		return false;
+
+	if (depth)
+		stop();
+	for (i = 0; i < num_counters; i++) {
+		marks[depth][i].total = counters[i].total;
+		marks[depth][i].sessions = counters[i].sessions;
+	}
+	depth++;
+	start();
+	return true;
+}
+
+static double
+average(const struct counter *c, double total, unsigned sessions)
+{
+	if (strcmp(c->info.unit, "%") != 0)
+		return total;
+	return sessions ? total / sessions : 0;
+}
+
+/**
+ * Stop counting, and resume the session this one is in.
+ *
+ * The counters of this session are stored in values, when it isn't NULL,
+ * in the order of piglit_perf_counters().
+ */
+void
+piglit_perf_counters_end(double *values)
+{
+	unsigned i;
+
+	assert(depth > 0);
+	stop();
+	depth--;
+
+	if (values) {
+		for (i = 0; i < num_counters; i++) {
+			values[i] = average(&counters[i],
+					    counters[i].total - marks[depth][i].total,
+					    counters[i].sessions -
+					    marks[depth][i].sessions);
+		}
+	}
+
+	if (depth)
+		start();
+}
+
+/**
+ * Return the counters being recorded, and their number in count.
+ */
+const struct piglit_perf_counter *
+piglit_perf_counters(unsigned *count)
+{
+	static struct piglit_perf_counter infos[PIGLIT_MAX_PERF_COUNTERS];
+	unsigned i;
+
+	for (i = 0; i < num_counters; i++)
+		infos[i] = counters[i].info;
+	*count = num_counters;
+	return infos;
+}
+
+static void
+print_json_string(const char *s)
+{
+	putchar('"');
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\')
+			putchar('\\');
+		putchar(*s);
+	}
+	putchar('"');
+}
+
+/**
+ * Add the counters of all the sessions so far to the metrics of the result.
+ */
+void
+piglit_perf_counters_report(void)
+{
+	unsigned i;
+
+	if (!num_counters)
+		return;
+
+	printf("PIGLIT: {\"metrics\": {");
+	for (i = 0; i < num_counters; i++) {
+		printf("%s", i ? ", " : "");
+		print_json_string(counters[i].info.name);
+		printf(": {\"value\": %.9g, \"unit\": \"%s\", "
+		       "\"counter\": true}",
+		       average(&counters[i], counters[i].total,
+			       counters[i].sessions),
+		       counters[i].info.unit);
+	}
+	printf("}}\n");
+	fflush(stdout);
+}
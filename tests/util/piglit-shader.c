@@ -22,10 +22,15 @@
  */
 
 #include <errno.h>
+#include <inttypes.h>
 
 #include "piglit-util-gl.h"
 #include "piglit-subprocess.h"
 
+#ifdef PIGLIT_HAS_SPIRV_TOOLS
+#include <spirv-tools/libspirv.h>
+#endif
+
 void piglit_get_glsl_version(bool *es, int* major, int* minor)
 {
 	bool es_local;
@@ -131,11 +136,13 @@ piglit_compile_shader_text_nothrow(GLenum target, const char *text, bool err_to_
 
 	piglit_require_GLSL();
 
+	piglit_trace_begin("compile");
 	prog = glCreateShader(target);
 	glShaderSource(prog, 1, (const GLchar **) &text, NULL);
 	glCompileShader(prog);
 
 	glGetShaderiv(prog, GL_COMPILE_STATUS, &ok);
+	piglit_trace_end();
 
 	{
 		GLchar *info;
@@ -265,6 +272,24 @@ piglit_link_check_status_quiet(GLint prog)
 	return link_check_status(prog, stdout);
 }
 
+/**
+ * Link a program and check that it linked, recording both as one span of
+ * the trace since the driver may only finish linking when asked the status.
+ */
+static bool
+link_program(GLuint prog)
+{
+	bool ok;
+
+	piglit_trace_begin("link");
+	glLinkProgram(prog);
+	piglit_gl_invalidate_program();
+	ok = piglit_link_check_status(prog);
+	piglit_trace_end();
+
+	return ok;
+}
+
 
 GLint piglit_link_simple_program(GLint vs, GLint fs)
 {
@@ -285,9 +310,7 @@ GLint piglit_link_simple_program(GLint vs, GLint fs)
 	glBindAttribLocation(prog, PIGLIT_ATTRIB_POS, "piglit_vertex");
 	glBindAttribLocation(prog, PIGLIT_ATTRIB_TEX, "piglit_texcoord");
 
-	glLinkProgram(prog);
-
-	if (!piglit_link_check_status(prog)) {
+	if (!link_program(prog)) {
 		glDeleteProgram(prog);
 		prog = 0;
 	}
@@ -379,9 +402,7 @@ GLint piglit_link_simple_program_multiple_shaders(GLint shader1, ...)
 	glBindAttribLocation(prog, PIGLIT_ATTRIB_POS, "piglit_vertex");
 	glBindAttribLocation(prog, PIGLIT_ATTRIB_TEX, "piglit_texcoord");
 
-	glLinkProgram(prog);
-
-	if (!piglit_link_check_status(prog)) {
+	if (!link_program(prog)) {
 		glDeleteProgram(prog);
 		prog = 0;
 	}
@@ -479,9 +500,7 @@ piglit_build_simple_program_multiple_shaders(GLenum target1,
 	glBindAttribLocation(prog, PIGLIT_ATTRIB_POS, "piglit_vertex");
 	glBindAttribLocation(prog, PIGLIT_ATTRIB_TEX, "piglit_texcoord");
 
-	glLinkProgram(prog);
-
-	if (!piglit_link_check_status(prog)) {
+	if (!link_program(prog)) {
 		glDeleteProgram(prog);
 		prog = 0;
 		piglit_report_result(PIGLIT_FAIL);
@@ -502,10 +521,9 @@ piglit_build_compute_program(const char *source)
 	}
 
 	glAttachShader(prog, shader);
-	glLinkProgram(prog);
 	glDeleteShader(shader);
 
-	if (!piglit_link_check_status(prog)) {
+	if (!link_program(prog)) {
 		glDeleteProgram(prog);
 		return 0;
 	}
@@ -513,6 +531,172 @@ piglit_build_compute_program(const char *source)
 	return prog;
 }
 
+/*
+ * SPIR-V assembly cache.  When PIGLIT_SPIRV_CACHE names an existing
+ * directory, the binaries assembled by piglit_assemble_spirv() are stored
+ * there, keyed by the assembler and the source.  Later assemblies of the
+ * same source, from any process, read the stored binary instead of
+ * running the assembler again.
+ *
+ * A cache file holds the magic, the length of the key, the key and the
+ * binary.
+ */
+
+#define SPIRV_CACHE_MAGIC "PSPV"
+
+static char *
+spirv_cache_key(const char *assembler, size_t source_length,
+		const char *source, size_t *length)
+{
+	size_t assembler_length = strlen(assembler) + 1;
+	char *key = malloc(assembler_length + source_length);
+
+	memcpy(key, assembler, assembler_length);
+	memcpy(key + assembler_length, source, source_length);
+	*length = assembler_length + source_length;
+	return key;
+}
+
+static char *
+spirv_cache_path(const char *dir, const char *key, size_t length)
+{
+	/* 64-bit FNV-1a, the key itself is compared when loading */
+	uint64_t hash = 0xcbf29ce484222325ull;
+	char *path;
+	size_t i;
+
+	for (i = 0; i < length; i++) {
+		hash ^= (unsigned char) key[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	path = malloc(strlen(dir) + 32);
+	sprintf(path, "%s/%016" PRIx64 ".spv", dir, hash);
+	return path;
+}
+
+static bool
+spirv_cache_load(const char *path, const char *key, size_t key_length,
+		 uint8_t **binary, size_t *binary_length)
+{
+	char magic[4];
+	uint64_t stored_key_length, length;
+	char *stored_key = NULL;
+	FILE *file;
+	bool valid;
+
+	file = fopen(path, "rb");
+	if (file == NULL)
+		return false;
+
+	valid = fread(magic, sizeof(magic), 1, file) == 1 &&
+		!memcmp(magic, SPIRV_CACHE_MAGIC, sizeof(magic)) &&
+		fread(&stored_key_length, sizeof(stored_key_length), 1, file) == 1 &&
+		stored_key_length == key_length;
+	if (valid) {
+		stored_key = malloc(key_length);
+		valid = fread(stored_key, 1, key_length, file) == key_length &&
+			!memcmp(stored_key, key, key_length) &&
+			fread(&length, sizeof(length), 1, file) == 1 &&
+			length > 0;
+	}
+	if (valid) {
+		*binary = malloc(length);
+		valid = fread(*binary, 1, length, file) == length;
+		if (valid)
+			*binary_length = length;
+		else
+			free(*binary);
+	}
+
+	fclose(file);
+	free(stored_key);
+	return valid;
+}
+
+static void
+spirv_cache_store(const char *path, const char *key, size_t key_length,
+		  const uint8_t *binary, size_t binary_length)
+{
+	const uint64_t stored_key_length = key_length;
+	const uint64_t length = binary_length;
+	char *tmp_path;
+	FILE *file;
+	bool ok;
+
+	/* Write to a file of our own and rename it, so that concurrent
+	 * tests never see a partial file.
+	 */
+	tmp_path = malloc(strlen(path) + 32);
+	sprintf(tmp_path, "%s.%" PRIx64 ".tmp", path,
+		(uint64_t) piglit_time_get_nano());
+
+	file = fopen(tmp_path, "wb");
+	if (file != NULL) {
+		ok = fwrite(SPIRV_CACHE_MAGIC, 4, 1, file) == 1 &&
+		     fwrite(&stored_key_length, sizeof(stored_key_length), 1, file) == 1 &&
+		     fwrite(key, 1, key_length, file) == key_length &&
+		     fwrite(&length, sizeof(length), 1, file) == 1 &&
+		     fwrite(binary, 1, binary_length, file) == binary_length;
+		ok = fclose(file) == 0 && ok;
+
+		if (!ok || rename(tmp_path, path) != 0)
+			remove(tmp_path);
+	}
+	free(tmp_path);
+}
+
+#ifdef PIGLIT_HAS_SPIRV_TOOLS
+/**
+ * Assemble or validate with the SPIRV-Tools library rather than by
+ * running spirv-as and spirv-val.
+ */
+static bool
+spirv_tools_assemble(size_t source_length, const char *source,
+		     uint8_t **binary, size_t *binary_length)
+{
+	spv_context context = spvContextCreate(SPV_ENV_OPENGL_4_5);
+	spv_binary spirv = NULL;
+	spv_diagnostic diagnostic = NULL;
+	bool ok;
+
+	ok = spvTextToBinary(context, source, source_length, &spirv,
+			     &diagnostic) == SPV_SUCCESS;
+	if (ok) {
+		*binary_length = spirv->wordCount * sizeof(uint32_t);
+		*binary = malloc(*binary_length);
+		memcpy(*binary, spirv->code, *binary_length);
+	} else {
+		spvDiagnosticPrint(diagnostic);
+	}
+
+	spvBinaryDestroy(spirv);
+	spvDiagnosticDestroy(diagnostic);
+	spvContextDestroy(context);
+	return ok;
+}
+
+static bool
+spirv_tools_validate(const uint8_t *binary, size_t binary_length)
+{
+	spv_context context = spvContextCreate(SPV_ENV_OPENGL_4_5);
+	spv_const_binary_t spirv = {
+		(const uint32_t *) binary,
+		binary_length / sizeof(uint32_t),
+	};
+	spv_diagnostic diagnostic = NULL;
+	bool ok;
+
+	ok = spvValidate(context, &spirv, &diagnostic) == SPV_SUCCESS;
+	if (!ok)
+		spvDiagnosticPrint(diagnostic);
+
+	spvDiagnosticDestroy(diagnostic);
+	spvContextDestroy(context);
+	return ok;
+}
+#endif
+
 GLuint
 piglit_assemble_spirv(GLenum target,
 		      size_t source_length,
@@ -525,40 +709,89 @@ piglit_assemble_spirv(GLenum target,
 		"-",
 		NULL
 	};
+	const char *cache_dir = getenv("PIGLIT_SPIRV_CACHE");
+	char *cache_key = NULL;
+	char *cache_path = NULL;
+	size_t cache_key_length = 0;
+	bool in_process = false;
+
+#ifdef PIGLIT_HAS_SPIRV_TOOLS
+	/* An explicitly chosen assembler is still run. */
+	in_process = arguments[0] == NULL;
+#endif
 
 	if (arguments[0] == NULL)
 		arguments[0] = "spirv-as";
 
 	uint8_t *binary_source;
 	size_t binary_source_length;
-	bool res = piglit_subprocess(arguments,
-				     source_length,
-				     (const uint8_t *) source,
-				     &binary_source_length,
-				     &binary_source);
+	bool res = false;
+
+	if (cache_dir != NULL && cache_dir[0] != '\0') {
+		cache_key = spirv_cache_key(in_process ? "SPIRV-Tools" :
+					    arguments[0],
+					    source_length, source,
+					    &cache_key_length);
+		cache_path = spirv_cache_path(cache_dir, cache_key,
+					      cache_key_length);
+		res = spirv_cache_load(cache_path, cache_key, cache_key_length,
+				       &binary_source, &binary_source_length);
+	}
 
 	if (!res) {
-		fprintf(stderr, "spirv-as failed\n");
-		piglit_report_result(PIGLIT_FAIL);
+#ifdef PIGLIT_HAS_SPIRV_TOOLS
+		if (in_process)
+			res = spirv_tools_assemble(source_length, source,
+						   &binary_source,
+						   &binary_source_length);
+		else
+#endif
+			res = piglit_subprocess(arguments,
+						source_length,
+						(const uint8_t *) source,
+						&binary_source_length,
+						&binary_source);
+
+		if (!res) {
+			fprintf(stderr, "spirv-as failed\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		if (cache_path != NULL)
+			spirv_cache_store(cache_path, cache_key,
+					  cache_key_length, binary_source,
+					  binary_source_length);
 	}
 
+	free(cache_key);
+	free(cache_path);
+
 	if (getenv("PIGLIT_SPIRV_VALIDATE")) {
 		char *arguments[] = {
 			getenv("PIGLIT_SPIRV_VAL_BINARY"),
 			"--target-env", "opengl4.5",
 			NULL,
 		};
-
-		if (arguments[0] == NULL)
-			arguments[0] = "spirv-val";
-
-		uint8_t *validate_result;
-		size_t validate_result_length;
-		bool res = piglit_subprocess(arguments,
-					     binary_source_length,
-					     (const uint8_t *) binary_source,
-					     &validate_result_length,
-					     &validate_result);
+		bool res;
+
+#ifdef PIGLIT_HAS_SPIRV_TOOLS
+		if (arguments[0] == NULL) {
+			res = spirv_tools_validate(binary_source,
+						   binary_source_length);
+		} else
+#endif
+		{
+			if (arguments[0] == NULL)
+				arguments[0] = "spirv-val";
+
+			uint8_t *validate_result;
+			size_t validate_result_length;
+			res = piglit_subprocess(arguments,
+						binary_source_length,
+						(const uint8_t *) binary_source,
+						&validate_result_length,
+						&validate_result);
+		}
 
 		if (!res) {
 			fprintf(stderr, "spirv-val failed\n");
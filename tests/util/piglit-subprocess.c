@@ -29,11 +29,80 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <poll.h>
 #include <limits.h>
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#endif
+
+extern char **environ;
+
+/**
+ * Start the command with stdin_fd and stdout_fd as its standard input and
+ * output.  posix_spawn() doesn't duplicate the address space of the test,
+ * which fork() does at a cost that grows with the memory the GL driver
+ * mapped.
+ *
+ * Every other descriptor of the test is expected to be close-on-exec, or
+ * gets closed if the C library can do it.
+ */
+static bool
+spawn_child(char * const *arguments, int stdin_fd, int stdout_fd,
+	    pid_t *pid)
+{
+	posix_spawn_file_actions_t actions;
+	int err;
+
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, stdin_fd, STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&actions, stdout_fd, STDOUT_FILENO);
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP
+	posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+#endif
+
+	err = posix_spawnp(pid, arguments[0], &actions, NULL, arguments,
+			   environ);
+	posix_spawn_file_actions_destroy(&actions);
+
+	if (err != 0) {
+		fprintf(stderr, "%s: %s\n", arguments[0], strerror(err));
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+make_pipe(int fds[2])
+{
+	if (pipe(fds) == -1) {
+		fprintf(stderr, "pipe: %s\n", strerror(errno));
+		return false;
+	}
+
+	fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	return true;
+}
+
+static bool
+wait_child(pid_t pid)
+{
+	int status;
+
+	while (waitpid(pid, &status, 0 /* options */) == -1) {
+		if (errno != EINTR)
+			return false;
+	}
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
 
 static bool
 stream_data(pid_t pid,
@@ -45,7 +114,10 @@ stream_data(pid_t pid,
 	    uint8_t **output)
 {
 	bool ret = true;
-	size_t buf_size = 128;
+	/* Assemblers and compilers rarely output much more than their
+	 * input, so start there rather than growing from a few bytes.
+	 */
+	size_t buf_size = MAX2(input_size, 4096);
 
 	*output = malloc(buf_size);
 	*output_size = 0;
@@ -85,8 +157,8 @@ stream_data(pid_t pid,
 
 			if (pollfds[i].fd == from_child &&
 			    pollfds[i].revents) {
-				if (buf_size - *output_size < 128) {
-					buf_size *=2;
+				if (buf_size == *output_size) {
+					buf_size *= 2;
 					*output = realloc(*output, buf_size);
 				}
 				res = read(from_child,
@@ -108,6 +180,8 @@ stream_data(pid_t pid,
 				   pollfds[i].revents) {
 				res = write(to_child, input, input_size);
 				if (res < 0) {
+					if (errno == EAGAIN || errno == EINTR)
+						continue;
 					ret = false;
 					goto done;
 				}
@@ -133,6 +207,72 @@ stream_data(pid_t pid,
 	return ret;
 }
 
+#ifdef HAVE_MEMFD_CREATE
+/**
+ * Run the command with its output going to a memory file rather than a
+ * pipe.  Since the output never blocks the child, the input is simply
+ * written out, and once the child exited its whole output is read at once
+ * into a buffer of the right size.
+ */
+static bool
+run_to_memfd(char * const *arguments,
+	     int output_fd,
+	     size_t input_size,
+	     const uint8_t *input,
+	     size_t *output_size,
+	     uint8_t **output)
+{
+	int stdin_pipe[2];
+	struct stat st;
+	pid_t pid;
+	bool ret = true;
+
+	if (!make_pipe(stdin_pipe))
+		return false;
+
+	if (!spawn_child(arguments, stdin_pipe[0], output_fd, &pid)) {
+		close(stdin_pipe[0]);
+		close(stdin_pipe[1]);
+		return false;
+	}
+	close(stdin_pipe[0]);
+
+	while (input_size > 0) {
+		ssize_t res = write(stdin_pipe[1], input, input_size);
+
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+			ret = false;
+			break;
+		}
+		input += res;
+		input_size -= res;
+	}
+	close(stdin_pipe[1]);
+
+	if (!wait_child(pid) || !ret || fstat(output_fd, &st) == -1)
+		return false;
+
+	*output_size = st.st_size;
+	*output = malloc(MAX2(*output_size, 1));
+	for (size_t done = 0; done < *output_size;) {
+		ssize_t res = pread(output_fd, *output + done,
+				    *output_size - done, done);
+
+		if (res <= 0) {
+			if (res < 0 && errno == EINTR)
+				continue;
+			free(*output);
+			return false;
+		}
+		done += res;
+	}
+
+	return true;
+}
+#endif
+
 bool
 piglit_subprocess(char * const *arguments,
 		  size_t input_size,
@@ -144,53 +284,58 @@ piglit_subprocess(char * const *arguments,
 	int stdin_pipe[2];
 	int stdout_pipe[2];
 
-	if (pipe(stdin_pipe) == -1) {
-		fprintf(stderr, "pipe: %s\n", strerror(errno));
-		return false;
+#ifdef HAVE_MEMFD_CREATE
+	int output_fd = memfd_create("piglit-subprocess", MFD_CLOEXEC);
+
+	if (output_fd != -1) {
+		bool ret = run_to_memfd(arguments, output_fd,
+					input_size, input,
+					output_size, output);
+		close(output_fd);
+		return ret;
 	}
-	if (pipe(stdout_pipe) == -1) {
-		fprintf(stderr, "pipe: %s\n", strerror(errno));
+#endif
+
+	if (!make_pipe(stdin_pipe))
+		return false;
+	if (!make_pipe(stdout_pipe)) {
 		close(stdin_pipe[0]);
 		close(stdin_pipe[1]);
 		return false;
 	}
 
-	pid = fork();
-
-	if (pid < 0) {
-		fprintf(stderr, "fork failed: %s\n", strerror(errno));
-		return false;
-	} else if (pid == 0) {
-		dup2(stdin_pipe[0], STDIN_FILENO);
-		dup2(stdout_pipe[1], STDOUT_FILENO);
-		for (int i = 3; i < 256; i++)
-			close(i);
-		execvp(arguments[0], arguments);
-		fprintf(stderr, "%s: %s\n", arguments[0], strerror(errno));
-		_exit(EXIT_FAILURE);
-	} else {
+	if (!spawn_child(arguments, stdin_pipe[0], stdout_pipe[1], &pid)) {
 		close(stdin_pipe[0]);
+		close(stdin_pipe[1]);
+		close(stdout_pipe[0]);
 		close(stdout_pipe[1]);
+		return false;
+	}
 
-		bool ret = stream_data(pid,
-				       stdin_pipe[1],
-				       stdout_pipe[0],
-				       input_size, input,
-				       output_size, output);
+	close(stdin_pipe[0]);
+	close(stdout_pipe[1]);
 
-		int status;
-		while (waitpid(pid, &status, 0 /* options */) == -1);
+	/* Only write what fits in the pipe, so that a child that answers
+	 * before reading all its input doesn't deadlock with us.
+	 */
+	fcntl(stdin_pipe[1], F_SETFL, O_NONBLOCK);
 
-		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
-			if (ret)
-				free(*output);
-			return false;
-		}
+	bool ret = stream_data(pid,
+			       stdin_pipe[1],
+			       stdout_pipe[0],
+			       input_size, input,
+			       output_size, output);
 
-		return ret;
+	if (!wait_child(pid)) {
+		if (ret)
+			free(*output);
+		return false;
 	}
+
+	return ret;
 }
 
+
 #else /* _WIN32 */
 
 static bool
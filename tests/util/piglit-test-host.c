@@ -0,0 +1,512 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-test-host.c
+ *
+ * Run the tests built as modules (see PIGLIT_BUILD_TEST_MODULES) one after
+ * the other in this process, so that starting and linking a process and
+ * loading the GL libraries is done once instead of for every test.
+ *
+ * Each line of stdin is a test: the path of its module followed by the
+ * arguments of the test, starting with argv[0], separated by tabs. A line
+ * starting with a "fork" field runs the test in a child process instead,
+ * for tests that change the state of the process in ways the tests after
+ * them would notice. The test prints its output as it would on its own,
+ * then one of
+ *
+ *     PIGLIT-HOST: exit <status>
+ *     PIGLIT-HOST: signal <signal>
+ *     PIGLIT-HOST: unsupported <reason>
+ *
+ * is printed: the status the test would have exited with, the signal that
+ * killed a forked test, or why the module can't be run by the host, in
+ * which case the caller runs the executable of the test instead. A test that
+ * crashes in the host process takes the host with it.
+ *
+ * With -reuse-contexts the GL contexts of the tests are kept for the tests
+ * after them, see piglit_reuse_gl_contexts.
+ *
+ * With -fork-server <path> the host is a fork server instead: it listens on
+ * the Unix socket at path and forks a child for every test, which runs the
+ * test and exits, so that a crash only takes the test down. A client
+ * connects for each test and sends the line of the test with the ends of
+ * the pipes to use as stdout and stderr of the test (SCM_RIGHTS). The
+ * server replies with
+ *
+ *     pid <pid>
+ *
+ * once the child runs, and its "exit" or "signal" line once it is done, or
+ * with an "unsupported" line. The server loads each module once and keeps
+ * it, so the children only run the test. The GL display isn't opened before
+ * forking: its connection, or the DRM device, can't be shared between the
+ * children. It prints "ready" once it listens, and exits when stdin is
+ * closed.
+ */
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "piglit-util-gl.h"
+#include "piglit-framework-gl/piglit_gl_framework.h"
+
+#define MAX_ARGS 256
+
+typedef int (*test_main_func)(int argc, char *argv[]);
+
+static pthread_t host_thread;
+static jmp_buf test_done;
+static int test_status;
+
+/** The piglit_report_result_hook of the tests run in this process. */
+static void
+return_to_host(int status)
+{
+	/* The stack of the test can only be left from its own thread, from
+	 * any other piglit_report_result() exits.
+	 */
+	if (!pthread_equal(pthread_self(), host_thread))
+		return;
+
+	test_status = status;
+	longjmp(test_done, 1);
+}
+
+static int
+run_in_process(test_main_func test_main, int argc, char **argv)
+{
+	if (setjmp(test_done) == 0)
+		test_status = test_main(argc, argv);
+
+	/* The configuration the framework points at was on the stack of the
+	 * test, and the module is unloaded next.
+	 */
+	if (gl_fw) {
+		if (gl_fw->destroy)
+			gl_fw->destroy(gl_fw);
+		gl_fw = NULL;
+	}
+
+	return test_status;
+}
+
+static void
+run_forked(test_main_func test_main, int argc, char **argv)
+{
+	int wstatus;
+	pid_t pid;
+
+	fflush(stdout);
+	fflush(stderr);
+
+	pid = fork();
+	if (pid == 0) {
+		/* The contexts kept by this process can't be shared with
+		 * the child.
+		 */
+		piglit_reuse_gl_contexts = false;
+		piglit_report_result_hook = NULL;
+		exit(test_main(argc, argv));
+	}
+
+	if (pid < 0 || waitpid(pid, &wstatus, 0) < 0) {
+		printf("PIGLIT-HOST: unsupported fork failed: %s\n",
+		       strerror(errno));
+	} else if (WIFSIGNALED(wstatus)) {
+		printf("PIGLIT-HOST: signal %d\n", WTERMSIG(wstatus));
+	} else {
+		printf("PIGLIT-HOST: exit %d\n", WEXITSTATUS(wstatus));
+	}
+}
+
+/**
+ * Split the line of a test into args, the module followed by the arguments
+ * of the test and NULL. Return the number of args, or 0 if the line is
+ * invalid.
+ */
+static int
+parse_line(char *line, char **args, bool *isolate)
+{
+	char *arg;
+	int num_args = 0;
+
+	line[strcspn(line, "\r\n")] = '\0';
+	while ((arg = strsep(&line, "\t")) != NULL && num_args < MAX_ARGS)
+		args[num_args++] = arg;
+
+	*isolate = num_args > 0 && !strcmp(args[0], "fork");
+	if (*isolate)
+		memmove(args, args + 1, --num_args * sizeof(args[0]));
+
+	/* The module and argv[0] */
+	if (num_args < 2 || args[0][0] == '\0')
+		return 0;
+
+	args[num_args] = NULL;
+	return num_args;
+}
+
+static void
+run_line(char *line)
+{
+	char *args[MAX_ARGS + 1];
+	int num_args;
+	bool isolate;
+	test_main_func test_main;
+	void *module;
+
+	num_args = parse_line(line, args, &isolate);
+	if (num_args == 0) {
+		printf("PIGLIT-HOST: unsupported invalid line\n");
+		return;
+	}
+
+	module = dlopen(args[0], RTLD_NOW | RTLD_LOCAL);
+	if (module == NULL) {
+		printf("PIGLIT-HOST: unsupported %s\n", dlerror());
+		return;
+	}
+
+	test_main = (test_main_func) dlsym(module, "piglit_test_module_main");
+	if (test_main == NULL) {
+		printf("PIGLIT-HOST: unsupported %s is not a test module\n",
+		       args[0]);
+	} else if (isolate) {
+		run_forked(test_main, num_args - 1, args + 1);
+	} else {
+		int status = run_in_process(test_main, num_args - 1, args + 1);
+
+		fflush(stderr);
+		printf("PIGLIT-HOST: exit %d\n", status);
+	}
+
+	dlclose(module);
+}
+
+/** A module loaded by the fork server. */
+struct server_module {
+	struct server_module *next;
+	char *path;
+	void *handle;
+	test_main_func test_main;
+};
+
+/** A child of the fork server and the connection of its client. */
+struct server_child {
+	pid_t pid;
+	int conn;
+};
+
+static struct server_module *server_modules;
+static struct server_child *server_children;
+static unsigned num_server_children;
+static int server_fd = -1;
+static int sigchld_pipe[2] = { -1, -1 };
+
+static void
+sigchld_handler(int sig)
+{
+	int saved_errno = errno;
+
+	/* The pipe is non-blocking, a full pipe already wakes the loop. */
+	if (write(sigchld_pipe[1], "c", 1) < 0) {
+		/* Nothing to do */
+	}
+	errno = saved_errno;
+}
+
+/**
+ * Return the test main of the module at path, loading it the first time,
+ * or NULL and the reason in *error if it can't be run.
+ */
+static test_main_func
+get_server_module(const char *path, const char **error)
+{
+	struct server_module *m;
+	void *handle;
+	test_main_func test_main;
+
+	for (m = server_modules; m; m = m->next) {
+		if (!strcmp(m->path, path))
+			return m->test_main;
+	}
+
+	handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+	if (handle == NULL) {
+		*error = dlerror();
+		return NULL;
+	}
+
+	test_main = (test_main_func) dlsym(handle, "piglit_test_module_main");
+	if (test_main == NULL) {
+		*error = "not a test module";
+		dlclose(handle);
+		return NULL;
+	}
+
+	m = malloc(sizeof(*m));
+	m->path = strdup(path);
+	m->handle = handle;
+	m->test_main = test_main;
+	m->next = server_modules;
+	server_modules = m;
+	return test_main;
+}
+
+/** Receive the line and pipes of a test, and fork the child running it. */
+static void
+serve_request(int conn)
+{
+	char line[16384];
+	char cmsg_buf[CMSG_SPACE(2 * sizeof(int))];
+	struct iovec iov = { line, sizeof(line) - 1 };
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = cmsg_buf,
+		.msg_controllen = sizeof(cmsg_buf),
+	};
+	struct cmsghdr *cmsg;
+	char *args[MAX_ARGS + 1];
+	int fds[2] = { -1, -1 };
+	int num_args = 0;
+	bool isolate;
+	const char *error = "invalid request";
+	test_main_func test_main = NULL;
+	ssize_t len;
+	pid_t pid;
+	unsigned i;
+
+	len = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+	for (cmsg = CMSG_FIRSTHDR(&msg); len > 0 && cmsg;
+	     cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET &&
+		    cmsg->cmsg_type == SCM_RIGHTS &&
+		    cmsg->cmsg_len == CMSG_LEN(sizeof(fds)))
+			memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+	}
+
+	if (len > 0 && fds[0] >= 0 && line[len - 1] == '\n') {
+		line[len] = '\0';
+		/* Every test forks here, so "fork" is ignored. */
+		num_args = parse_line(line, args, &isolate);
+	}
+	if (num_args > 0)
+		test_main = get_server_module(args[0], &error);
+
+	if (test_main == NULL) {
+		dprintf(conn, "unsupported %s\n", error);
+		goto fail;
+	}
+
+	pid = fork();
+	if (pid == 0) {
+		/* In its own process group, so that it can be killed with
+		 * whatever it starts.
+		 */
+		setpgid(0, 0);
+		signal(SIGCHLD, SIG_DFL);
+		close(server_fd);
+		close(sigchld_pipe[0]);
+		close(sigchld_pipe[1]);
+		for (i = 0; i < num_server_children; i++)
+			close(server_children[i].conn);
+		close(conn);
+
+		dup2(fds[0], STDOUT_FILENO);
+		dup2(fds[1], STDERR_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+
+		piglit_report_result_hook = NULL;
+		exit(test_main(num_args - 1, args + 1));
+	}
+
+	if (pid < 0) {
+		dprintf(conn, "unsupported fork failed: %s\n",
+			strerror(errno));
+		goto fail;
+	}
+
+	close(fds[0]);
+	close(fds[1]);
+	dprintf(conn, "pid %d\n", (int) pid);
+
+	server_children = realloc(server_children,
+				  (num_server_children + 1) *
+				  sizeof(server_children[0]));
+	server_children[num_server_children].pid = pid;
+	server_children[num_server_children].conn = conn;
+	num_server_children++;
+	return;
+
+fail:
+	if (fds[0] >= 0)
+		close(fds[0]);
+	if (fds[1] >= 0)
+		close(fds[1]);
+	close(conn);
+}
+
+/** Report the status of the children that are done to their clients. */
+static void
+reap_children(void)
+{
+	int wstatus;
+	pid_t pid;
+	unsigned i;
+
+	while ((pid = waitpid(-1, &wstatus, WNOHANG)) > 0) {
+		for (i = 0; i < num_server_children; i++) {
+			if (server_children[i].pid == pid)
+				break;
+		}
+		if (i == num_server_children)
+			continue;
+
+		if (WIFSIGNALED(wstatus))
+			dprintf(server_children[i].conn, "signal %d\n",
+				WTERMSIG(wstatus));
+		else
+			dprintf(server_children[i].conn, "exit %d\n",
+				WEXITSTATUS(wstatus));
+		close(server_children[i].conn);
+		server_children[i] = server_children[--num_server_children];
+	}
+}
+
+static int
+run_fork_server(const char *path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	struct sigaction sa = { .sa_handler = sigchld_handler };
+	char buf[64];
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "socket path too long: %s\n", path);
+		return 1;
+	}
+	strcpy(addr.sun_path, path);
+
+	server_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	unlink(path);
+	if (server_fd < 0 ||
+	    bind(server_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+	    listen(server_fd, 64) < 0) {
+		fprintf(stderr, "cannot listen on %s: %s\n", path,
+			strerror(errno));
+		return 1;
+	}
+
+	if (pipe2(sigchld_pipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+		perror("pipe2");
+		return 1;
+	}
+	sa.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+	sigaction(SIGCHLD, &sa, NULL);
+
+	/* A client can't write to the socket once it is gone. */
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("ready\n");
+	fflush(stdout);
+
+	for (;;) {
+		struct pollfd pfds[3] = {
+			{ .fd = server_fd, .events = POLLIN },
+			{ .fd = sigchld_pipe[0], .events = POLLIN },
+			{ .fd = STDIN_FILENO, .events = POLLIN },
+		};
+
+		if (poll(pfds, 3, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("poll");
+			return 1;
+		}
+
+		if (pfds[1].revents) {
+			while (read(sigchld_pipe[0], buf, sizeof(buf)) > 0)
+				;
+			reap_children();
+		}
+
+		if (pfds[0].revents & POLLIN) {
+			int conn = accept4(server_fd, NULL, NULL,
+					   SOCK_CLOEXEC);
+
+			if (conn >= 0)
+				serve_request(conn);
+		}
+
+		/* The caller closed stdin, the children still running are
+		 * left to finish on their own.
+		 */
+		if (pfds[2].revents &&
+		    read(STDIN_FILENO, buf, sizeof(buf)) <= 0)
+			break;
+	}
+
+	unlink(path);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	char line[16384];
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-reuse-contexts")) {
+			piglit_reuse_gl_contexts = true;
+		} else if (!strcmp(argv[i], "-fork-server") && i + 1 < argc) {
+			return run_fork_server(argv[++i]);
+		} else {
+			fprintf(stderr, "usage: %s [-reuse-contexts] "
+				"[-fork-server <path>]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	host_thread = pthread_self();
+	piglit_report_result_hook = return_to_host;
+
+	while (fgets(line, sizeof(line), stdin) != NULL) {
+		run_line(line);
+		fflush(stdout);
+	}
+
+	return 0;
+}
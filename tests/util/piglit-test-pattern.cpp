@@ -47,6 +47,10 @@ void Triangles::compile()
 		{  0.0,  1.0 },
 		{  0.5, -1.0 }
 	};
+	struct vertex_attributes {
+		float pos_within_tri[2];
+		float tri_num;
+	};
 
 	/* Number of triangle instances across (and down) */
 	int tris_across = 8;
@@ -71,10 +75,11 @@ void Triangles::compile()
 		"uniform int tris_across;\n"
 		"uniform float final_scale;\n"
 		"uniform mat4 proj;\n"
-		"uniform int tri_num; /* [0, num_tris) */\n"
+		"attribute float tri_num_attr; /* [0, num_tris) */\n"
 		"\n"
 		"void main()\n"
 		"{\n"
+		"  int tri_num = int(tri_num_attr);\n"
 		"  vec2 pos = tri_scale * pos_within_tri;\n"
 		"  float rotation = rotation_delta * tri_num;\n"
 		"  pos = mat2(cos(rotation), sin(rotation),\n"
@@ -100,6 +105,7 @@ void Triangles::compile()
 	GLint fs = piglit_compile_shader_text(GL_FRAGMENT_SHADER, frag);
 	glAttachShader(prog, fs);
 	glBindAttribLocation(prog, 0, "pos_within_tri");
+	glBindAttribLocation(prog, 1, "tri_num_attr");
 	glLinkProgram(prog);
 	if (!piglit_link_check_status(prog)) {
 		piglit_report_result(PIGLIT_FAIL);
@@ -113,20 +119,37 @@ void Triangles::compile()
 	glUniform1i(glGetUniformLocation(prog, "tris_across"), tris_across);
 	glUniform1f(glGetUniformLocation(prog, "final_scale"), final_scale);
 	proj_loc = glGetUniformLocation(prog, "proj");
-	tri_num_loc = glGetUniformLocation(prog, "tri_num");
 
 	/* Set up vertex array object */
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 
-	/* Set up vertex input buffer */
+	/* Set up vertex input buffer, with every triangle of the
+	 * pattern so that draw() needs a single draw call.
+	 */
+	vertex_attributes *vertex_data = new vertex_attributes[3 * num_tris];
+	for (int tri_num = 0; tri_num < num_tris; ++tri_num) {
+		for (int v = 0; v < 3; ++v) {
+			vertex_attributes *vertex = &vertex_data[3 * tri_num + v];
+			vertex->pos_within_tri[0] = pos_within_tri[v][0];
+			vertex->pos_within_tri[1] = pos_within_tri[v][1];
+			vertex->tri_num = tri_num;
+		}
+	}
 	glGenBuffers(1, &vertex_buf);
 	glBindBuffer(GL_ARRAY_BUFFER, vertex_buf);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(pos_within_tri), pos_within_tri,
-		     GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, 3 * num_tris * sizeof(vertex_data[0]),
+		     vertex_data, GL_STATIC_DRAW);
+	delete[] vertex_data;
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, ARRAY_SIZE(pos_within_tri[0]), GL_FLOAT,
-			      GL_FALSE, sizeof(pos_within_tri[0]), (void *) 0);
+			      GL_FALSE, sizeof(vertex_attributes),
+			      (void *) offsetof(vertex_attributes,
+						pos_within_tri));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE,
+			      sizeof(vertex_attributes),
+			      (void *) offsetof(vertex_attributes, tri_num));
 }
 
 void Triangles::draw(const float (*proj)[4])
@@ -136,10 +159,7 @@ void Triangles::draw(const float (*proj)[4])
 	glUseProgram(prog);
 	glUniformMatrix4fv(proj_loc, 1, GL_TRUE, &proj[0][0]);
 	glBindVertexArray(vao);
-	for (int tri_num = 0; tri_num < num_tris; ++tri_num) {
-		glUniform1i(tri_num_loc, tri_num);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
-	}
+	glDrawArrays(GL_TRIANGLES, 0, 3 * num_tris);
 }
 
 
@@ -152,13 +172,15 @@ InterpolationTestPattern::InterpolationTestPattern(const char *frag)
 void
 InterpolationTestPattern::compile()
 {
-	static struct vertex_attributes {
+	static const float pos_within_tri[][2] = {
+		{ -0.5, -1.0 },
+		{  0.0,  1.0 },
+		{  0.5, -1.0 }
+	};
+	struct vertex_attributes {
 		float pos_within_tri[2];
 		float barycentric_coords[3];
-	} vertex_data[] = {
-		{ { -0.5, -1.0 }, { 1, 0, 0 } },
-		{ {  0.0,  1.0 }, { 0, 1, 0 } },
-		{ {  0.5, -1.0 }, { 0, 0, 1 } }
+		float tri_num;
 	};
 
 	/* Number of triangle instances across (and down) */
@@ -189,11 +211,12 @@ InterpolationTestPattern::compile()
 		"uniform int tris_across;\n"
 		"uniform float final_scale;\n"
 		"uniform mat4 proj;\n"
-		"uniform int tri_num; /* [0, num_tris) */\n"
+		"attribute float tri_num_attr; /* [0, num_tris) */\n"
 		"uniform ivec2 viewport_size;\n"
 		"\n"
 		"void main()\n"
 		"{\n"
+		"  int tri_num = int(tri_num_attr);\n"
 		"  vec2 pos = tri_scale * pos_within_tri;\n"
 		"  float rotation = rotation_delta * tri_num;\n"
 		"  pos = mat2(cos(rotation), sin(rotation),\n"
@@ -217,6 +240,7 @@ InterpolationTestPattern::compile()
 	glAttachShader(prog, fs);
 	glBindAttribLocation(prog, 0, "pos_within_tri");
 	glBindAttribLocation(prog, 1, "in_barycentric_coords");
+	glBindAttribLocation(prog, 2, "tri_num_attr");
 	glLinkProgram(prog);
 	if (!piglit_link_check_status(prog)) {
 		piglit_report_result(PIGLIT_FAIL);
@@ -230,28 +254,45 @@ InterpolationTestPattern::compile()
 	glUniform1i(glGetUniformLocation(prog, "tris_across"), tris_across);
 	glUniform1f(glGetUniformLocation(prog, "final_scale"), final_scale);
 	proj_loc = glGetUniformLocation(prog, "proj");
-	tri_num_loc = glGetUniformLocation(prog, "tri_num");
 	viewport_size_loc = glGetUniformLocation(prog, "viewport_size");
 
 	/* Set up vertex array object */
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 
-	/* Set up vertex input buffer */
+	/* Set up vertex input buffer, with every triangle like
+	 * Triangles::compile() does.
+	 */
+	vertex_attributes *vertex_data = new vertex_attributes[3 * num_tris];
+	for (int tri_num = 0; tri_num < num_tris; ++tri_num) {
+		for (int v = 0; v < 3; ++v) {
+			vertex_attributes *vertex = &vertex_data[3 * tri_num + v];
+			vertex->pos_within_tri[0] = pos_within_tri[v][0];
+			vertex->pos_within_tri[1] = pos_within_tri[v][1];
+			for (int c = 0; c < 3; ++c)
+				vertex->barycentric_coords[c] = c == v;
+			vertex->tri_num = tri_num;
+		}
+	}
 	glGenBuffers(1, &vertex_buf);
 	glBindBuffer(GL_ARRAY_BUFFER, vertex_buf);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_data), vertex_data,
-		     GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, 3 * num_tris * sizeof(vertex_data[0]),
+		     vertex_data, GL_STATIC_DRAW);
+	delete[] vertex_data;
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, ARRAY_SIZE(vertex_data[0].pos_within_tri),
-			      GL_FLOAT, GL_FALSE, sizeof(vertex_data[0]),
+	glVertexAttribPointer(0, ARRAY_SIZE(pos_within_tri[0]),
+			      GL_FLOAT, GL_FALSE, sizeof(vertex_attributes),
 			      (void *) offsetof(vertex_attributes,
 						pos_within_tri));
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, ARRAY_SIZE(vertex_data[0].barycentric_coords),
-			      GL_FLOAT, GL_FALSE, sizeof(vertex_data[0]),
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
+			      sizeof(vertex_attributes),
 			      (void *) offsetof(vertex_attributes,
 						barycentric_coords));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE,
+			      sizeof(vertex_attributes),
+			      (void *) offsetof(vertex_attributes, tri_num));
 }
 
 
@@ -476,8 +517,7 @@ Sunburst::Sunburst()
 	: out_type(GL_UNSIGNED_NORMALIZED),
 	  compute_depth(false),
 	  prog(0),
-	  rotation_loc(0),
-	  vert_depth_loc(0),
+	  vert_depth_scale_loc(0),
 	  frag_depth_loc(0),
 	  proj_loc(0),
 	  draw_colors_loc(0),
@@ -514,13 +554,16 @@ Sunburst::get_out_type_glsl() const
 
 void Sunburst::compile()
 {
-	static struct vertex_attributes {
+	static const float pos_within_tri[][2] = {
+		{ -0.3, -0.8 },
+		{  0.0,  1.0 },
+		{  0.3, -0.8 }
+	};
+	struct vertex_attributes {
 		float pos_within_tri[2];
 		float barycentric_coords[3];
-	} vertex_data[] = {
-		{ { -0.3, -0.8 }, { 1, 0, 0 } },
-		{ {  0.0,  1.0 }, { 0, 1, 0 } },
-		{ {  0.3, -0.8 }, { 0, 0, 1 } }
+		float rotation;
+		float depth;
 	};
         bool need_glsl130 = out_type == GL_INT || out_type == GL_UNSIGNED_INT;
 
@@ -535,9 +578,10 @@ void Sunburst::compile()
 		"#version %s\n"
 		"attribute vec2 pos_within_tri;\n"
 		"attribute vec3 in_barycentric_coords;\n"
+		"attribute float rotation;\n"
+		"attribute float tri_depth;\n"
 		"varying vec3 barycentric_coords;\n"
-		"uniform float rotation;\n"
-		"uniform float vert_depth;\n"
+		"uniform float vert_depth_scale;\n"
 		"uniform mat4 proj;\n"
 		"\n"
 		"void main()\n"
@@ -545,7 +589,8 @@ void Sunburst::compile()
 		"  vec2 pos = pos_within_tri;\n"
 		"  pos = mat2(cos(rotation), sin(rotation),\n"
 		"             -sin(rotation), cos(rotation)) * pos;\n"
-		"  gl_Position = proj * vec4(pos, vert_depth, 1.0);\n"
+		"  gl_Position =\n"
+		"    proj * vec4(pos, vert_depth_scale * tri_depth, 1.0);\n"
 		"  barycentric_coords = in_barycentric_coords;\n"
 		"}\n";
 
@@ -595,6 +640,8 @@ void Sunburst::compile()
 
 	glBindAttribLocation(prog, 0, "pos_within_tri");
 	glBindAttribLocation(prog, 1, "in_barycentric_coords");
+	glBindAttribLocation(prog, 2, "rotation");
+	glBindAttribLocation(prog, 3, "tri_depth");
 	if (need_glsl130) {
 		glBindFragDataLocation(prog, 0, "frag_out");
 	}
@@ -605,10 +652,9 @@ void Sunburst::compile()
 
 	/* Set up uniforms */
 	glUseProgram(prog);
-	rotation_loc = glGetUniformLocation(prog, "rotation");
-	vert_depth_loc = glGetUniformLocation(prog, "vert_depth");
+	vert_depth_scale_loc = glGetUniformLocation(prog, "vert_depth_scale");
 	frag_depth_loc = glGetUniformLocation(prog, "frag_depth");
-	glUniform1f(vert_depth_loc, 0.0);
+	glUniform1f(vert_depth_scale_loc, 0.0);
 	glUniform1f(frag_depth_loc, 0.0);
 	proj_loc = glGetUniformLocation(prog, "proj");
 	draw_colors_loc = glGetUniformLocation(prog, "draw_colors");
@@ -617,20 +663,56 @@ void Sunburst::compile()
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 
-	/* Set up vertex input buffer */
+	/* Set up vertex input buffer.  Triangle i is at vertex 3 * i,
+	 * with its rotation and the depth DepthSunburst draws it at.
+	 *
+	 * Note: with num_tris == 7, the depths are 3/4, 1/2, 1/4, 0,
+	 * -1/4, -1/2 and -3/4.
+	 */
+	vertex_attributes *vertex_data = new vertex_attributes[3 * num_tris];
+	for (int i = 0; i < num_tris; ++i) {
+		for (int v = 0; v < 3; ++v) {
+			vertex_attributes *vertex = &vertex_data[3 * i + v];
+			vertex->pos_within_tri[0] = pos_within_tri[v][0];
+			vertex->pos_within_tri[1] = pos_within_tri[v][1];
+			for (int c = 0; c < 3; ++c)
+				vertex->barycentric_coords[c] = c == v;
+			vertex->rotation = M_PI * 2.0 * i / num_tris;
+			vertex->depth = tri_depth(i);
+		}
+	}
 	glGenBuffers(1, &vertex_buf);
 	glBindBuffer(GL_ARRAY_BUFFER, vertex_buf);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_data), vertex_data,
-		     GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, 3 * num_tris * sizeof(vertex_data[0]),
+		     vertex_data, GL_STATIC_DRAW);
+	delete[] vertex_data;
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, ARRAY_SIZE(vertex_data[0].pos_within_tri),
-			      GL_FLOAT, GL_FALSE, sizeof(vertex_data[0]),
+	glVertexAttribPointer(0, ARRAY_SIZE(pos_within_tri[0]),
+			      GL_FLOAT, GL_FALSE, sizeof(vertex_attributes),
 			      (void *) 0);
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, ARRAY_SIZE(vertex_data[0].barycentric_coords),
-			      GL_FLOAT, GL_FALSE, sizeof(vertex_data[0]),
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
+			      sizeof(vertex_attributes),
 			      (void *) offsetof(vertex_attributes,
 						barycentric_coords));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE,
+			      sizeof(vertex_attributes),
+			      (void *) offsetof(vertex_attributes, rotation));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE,
+			      sizeof(vertex_attributes),
+			      (void *) offsetof(vertex_attributes, depth));
+}
+
+
+/**
+ * The depth of triangle i of the sunburst in DepthSunburst.
+ */
+float
+Sunburst::tri_depth(int i) const
+{
+	return float(num_tris - i * 2 - 1) / (num_tris + 1);
 }
 
 
@@ -689,10 +771,7 @@ ColorGradientSunburst::draw_with_scale_and_offset(const float (*proj)[4],
 	glUniformMatrix3x4fv(draw_colors_loc, 1, GL_FALSE,
 			     &draw_colors[0][0]);
 	glBindVertexArray(vao);
-	for (int i = 0; i < num_tris; ++i) {
-		glUniform1f(rotation_loc, M_PI * 2.0 * i / num_tris);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
-	}
+	glDrawArrays(GL_TRIANGLES, 0, 3 * num_tris);
 }
 
 
@@ -715,9 +794,11 @@ StencilSunburst::draw(const float (*proj)[4])
 	glUniformMatrix4fv(proj_loc, 1, GL_TRUE, &proj[0][0]);
 	glBindVertexArray(vao);
 	for (int i = 0; i < num_tris; ++i) {
+		/* The stencil reference can't come from the vertex
+		 * buffer, so this takes a draw call per triangle.
+		 */
 		glStencilFunc(GL_ALWAYS, i+1, 0xff);
-		glUniform1f(rotation_loc, M_PI * 2.0 * i / num_tris);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glDrawArrays(GL_TRIANGLES, 3 * i, 3);
 	}
 
 	glDisable(GL_STENCIL_TEST);
@@ -741,26 +822,34 @@ DepthSunburst::draw(const float (*proj)[4])
 	glUseProgram(prog);
 	glUniformMatrix4fv(proj_loc, 1, GL_TRUE, &proj[0][0]);
 	glBindVertexArray(vao);
+
+	/* Draw triangles in a haphazard order so we can verify that
+	 * depth comparisons sort them out properly.
+	 */
+	GLint *first = new GLint[num_tris];
+	GLsizei *count = new GLsizei[num_tris];
 	for (int i = 0; i < num_tris; ++i) {
-		/* Draw triangles in a haphazard order so we can
-		 * verify that depth comparisons sort them out
-		 * properly.
-		 */
-		int triangle_to_draw = (i * 3) % num_tris;
+		first[i] = 3 * ((i * 3) % num_tris);
+		count[i] = 3;
+	}
 
-		/* Note: with num_tris == 7, this causes us to draw
-		 * triangles at depths of 3/4, 1/2, -1/4, 0, 1/4, 1/2,
-		 * and 3/4.
+	if (compute_depth) {
+		/* The fragment shader depth is a uniform, so that it
+		 * is exactly the same for every fragment.
 		 */
-		glUniform1f(compute_depth ? frag_depth_loc : vert_depth_loc,
-			    float(num_tris - triangle_to_draw * 2 - 1)
-			    / (num_tris + 1));
-
-		glUniform1f(rotation_loc,
-			    M_PI * 2.0 * triangle_to_draw / num_tris);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
+		for (int i = 0; i < num_tris; ++i) {
+			glUniform1f(frag_depth_loc, tri_depth(first[i] / 3));
+			glDrawArrays(GL_TRIANGLES, first[i], count[i]);
+		}
+	} else {
+		glUniform1f(vert_depth_scale_loc, 1.0);
+		glMultiDrawArrays(GL_TRIANGLES, first, count, num_tris);
+		glUniform1f(vert_depth_scale_loc, 0.0);
 	}
 
+	delete[] first;
+	delete[] count;
+
 	glDisable(GL_DEPTH_TEST);
 }
 
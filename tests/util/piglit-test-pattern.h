@@ -124,6 +124,9 @@ namespace piglit_util_test_pattern
 	 * at a different angle.  This ensures that the image will have a
 	 * large number of edges at different angles, so that we'll thoroughly
 	 * exercise antialiasing.
+	 *
+	 * All the triangles are in one vertex buffer, along with the number
+	 * of their triangle, and drawn with a single draw call.
 	 */
 	class Triangles : public TestPattern
 	{
@@ -136,7 +139,6 @@ namespace piglit_util_test_pattern
 		GLuint vertex_buf;
 		GLuint vao;
 		GLint proj_loc;
-		GLint tri_num_loc;
 		int num_tris;
 	};
 
@@ -230,6 +232,10 @@ namespace piglit_util_test_pattern
 	 * thoroughly exercise antialiasing.
 	 *
 	 * This program is further specialized into depth and stencil variants.
+	 *
+	 * The triangles are in one vertex buffer, along with their rotation
+	 * and depth, so that the variants draw them without updating any
+	 * uniforms in between.
 	 */
 	class Sunburst : public TestPattern
 	{
@@ -256,9 +262,10 @@ namespace piglit_util_test_pattern
 		bool compute_depth;
 
 	protected:
+		float tri_depth(int i) const;
+
 		GLint prog;
-		GLint rotation_loc;
-		GLint vert_depth_loc;
+		GLint vert_depth_scale_loc;
 		GLint frag_depth_loc;
 		GLint proj_loc;
 		GLint draw_colors_loc;
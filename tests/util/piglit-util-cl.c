@@ -22,6 +22,9 @@
  */
 
 #include <inttypes.h>
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
 
 #include "piglit-util-cl.h"
 
@@ -73,25 +76,39 @@ static float float_from_cl_half(uint32_t in)
 	return convert.val;
 }
 
-bool piglit_cl_probe_half(cl_half value, cl_half expect, uint32_t ulp)
+bool piglit_cl_compare_half(cl_half value, cl_half expect, uint32_t ulp)
 {
 	// after conversion to float the last 13 digits are 0, adjust ulp
+	return piglit_cl_compare_floating(float_from_cl_half(value),
+	                                  float_from_cl_half(expect),
+	                                  ulp * 8192);
+}
+
+bool piglit_cl_probe_half(cl_half value, cl_half expect, uint32_t ulp)
+{
 	return piglit_cl_probe_floating(float_from_cl_half(value),
 	                                float_from_cl_half(expect),
 	                                ulp * 8192);
 }
 
-bool piglit_cl_probe_floating(float value, float expect, uint32_t ulp)
+/* expect is correctly rounded, 1 ULP is the distance to next
+ * representable value */
+static float float_tolerance(float expect, uint32_t ulp)
 {
-	float diff;
-	union {
-		float f;
-		uint32_t u;
-	} v, e;
+	float direction = signbit(expect) ?  -INFINITY : INFINITY;
+	float one_ulp = nextafterf(expect, direction) - expect;
+	return fabsf(ulp * one_ulp);
+}
 
-	v.f = value;
-	e.f = expect;
+static double double_tolerance(double expect, uint64_t ulp)
+{
+	double direction = signbit(expect) ?  -INFINITY : INFINITY;
+	double one_ulp = nextafter(expect, direction) - expect;
+	return fabs(ulp * one_ulp);
+}
 
+bool piglit_cl_compare_floating(float value, float expect, uint32_t ulp)
+{
 	/* Treat infinity and nan separately */
 	if (probe_float_check_nan_inf(value, expect)) {
 		return true;
@@ -102,34 +119,30 @@ bool piglit_cl_probe_floating(float value, float expect, uint32_t ulp)
 		return true;
 	}
 
-	/* expect is correctly rounded, 1 ULP is the distance to next
-	 * representable value */
-	float direction = signbit(expect) ?  -INFINITY : INFINITY;
-	float one_ulp = nextafterf(expect, direction) - expect;
-	float tolerance = fabsf(ulp * one_ulp);
-
-	diff = fabsf(value - expect);
-
-	if (diff > tolerance || isnan(value)) {
-		printf("Expecting %f (0x%x) with tolerance %f (%u ulps), but got %f (0x%x)\n",
-		       e.f, e.u, tolerance, ulp, v.f, v.u);
-		return false;
-	}
-
-	return true;
+	return !(fabsf(value - expect) > float_tolerance(expect, ulp) ||
+	         isnan(value));
 }
 
-bool piglit_cl_probe_double(double value, double expect, uint64_t ulp)
+bool piglit_cl_probe_floating(float value, float expect, uint32_t ulp)
 {
-	double diff;
 	union {
-		double f;
-		uint64_t u;
+		float f;
+		uint32_t u;
 	} v, e;
 
+	if (piglit_cl_compare_floating(value, expect, ulp)) {
+		return true;
+	}
+
 	v.f = value;
 	e.f = expect;
+	printf("Expecting %f (0x%x) with tolerance %f (%u ulps), but got %f (0x%x)\n",
+	       e.f, e.u, float_tolerance(expect, ulp), ulp, v.f, v.u);
+	return false;
+}
 
+bool piglit_cl_compare_double(double value, double expect, uint64_t ulp)
+{
 	/* Treat infinity and nan separately */
 	if (probe_float_check_nan_inf(value, expect)) {
 		return true;
@@ -139,20 +152,26 @@ bool piglit_cl_probe_double(double value, double expect, uint64_t ulp)
 		return true;
 	}
 
-	double direction = signbit(expect) ?  -INFINITY : INFINITY;
-	double one_ulp = nextafter(expect, direction) - expect;
-	double tolerance = fabs(ulp * one_ulp);
+	return !(fabs(value - expect) > double_tolerance(expect, ulp) ||
+	         isnan(value));
+}
 
-	diff = fabs(value - expect);
+bool piglit_cl_probe_double(double value, double expect, uint64_t ulp)
+{
+	union {
+		double f;
+		uint64_t u;
+	} v, e;
 
-	if(diff > tolerance || isnan(value)) {
-		printf("Expecting %f (0x%" PRIx64") with tolerance %f (%" PRIu64"), but got %f (0x%" PRIx64")\n",
-		       e.f, e.u, tolerance, ulp, v.f, v.u);
-		return false;
+	if (piglit_cl_compare_double(value, expect, ulp)) {
+		return true;
 	}
 
-	return true;
-
+	v.f = value;
+	e.f = expect;
+	printf("Expecting %f (0x%" PRIx64") with tolerance %f (%" PRIu64"), but got %f (0x%" PRIx64")\n",
+	       e.f, e.u, double_tolerance(expect, ulp), ulp, v.f, v.u);
+	return false;
 }
 
 cl_half convert_cl_half(double in)
@@ -845,101 +864,403 @@ piglit_cl_release_context(piglit_cl_context context)
 	free(context);
 }
 
-cl_program
-piglit_cl_build_program_with_source_extended(piglit_cl_context context,
-                                             cl_uint count, char** strings,
-                                             const char* options, bool fail)
+/*
+ * Program binary cache.  When PIGLIT_CL_PROGRAM_CACHE names an existing
+ * directory, the binaries of programs built from source are stored there,
+ * keyed by the source, the build options and the name, version and driver
+ * version of every device of the context.  Later builds with the same key
+ * are created from the stored binaries instead of being compiled again.
+ *
+ * A cache file holds the magic and version, the key, the number of devices,
+ * the length of each binary and the binaries, in the order of the devices of
+ * the context.
+ */
+
+#define PROGRAM_CACHE_MAGIC "PCLC"
+#define PROGRAM_CACHE_VERSION 1
+
+static void
+program_cache_append(char** key, size_t* length, const char* str)
 {
+	size_t str_length = strlen(str) + 1;
+
+	*key = realloc(*key, *length + str_length);
+	memcpy(*key + *length, str, str_length);
+	*length += str_length;
+}
+
+static void
+program_cache_append_device_info(char** key, size_t* length,
+                                 cl_device_id device, cl_device_info param)
+{
+	char* info = piglit_cl_get_device_info(device, param);
+
+	program_cache_append(key, length, info);
+	free(info);
+}
+
+static char*
+program_cache_key(piglit_cl_context context, cl_uint count, char** strings,
+                  const char* options, size_t* length)
+{
+	char* key = NULL;
+	unsigned int i;
+
+	*length = 0;
+	for(i = 0; i < count; i++) {
+		program_cache_append(&key, length, strings[i]);
+	}
+	program_cache_append(&key, length, options != NULL ? options : "");
+
+	for(i = 0; i < context->num_devices; i++) {
+		program_cache_append_device_info(&key, length,
+		                                 context->device_ids[i],
+		                                 CL_DEVICE_NAME);
+		program_cache_append_device_info(&key, length,
+		                                 context->device_ids[i],
+		                                 CL_DEVICE_VERSION);
+		program_cache_append_device_info(&key, length,
+		                                 context->device_ids[i],
+		                                 CL_DRIVER_VERSION);
+	}
+
+	return key;
+}
+
+static char*
+program_cache_path(const char* dir, const char* key, size_t length)
+{
+	/* 64-bit FNV-1a, the key itself is compared when loading */
+	uint64_t hash = 0xcbf29ce484222325ull;
+	char* path;
+	size_t i;
+
+	for(i = 0; i < length; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	path = malloc(strlen(dir) + 32);
+	sprintf(path, "%s/%016" PRIx64 ".clbin", dir, hash);
+	return path;
+}
+
+static cl_program
+program_cache_load(piglit_cl_context context, const char* path,
+                   const char* key, size_t key_length, const char* options)
+{
+	FILE* file;
+	char magic[4];
+	uint32_t version, num_devices = 0;
+	uint64_t stored_key_length;
+	char* stored_key = NULL;
+	size_t* lengths = NULL;
+	unsigned char** binaries = NULL;
+	cl_program program = NULL;
 	cl_int errNo;
-	cl_program program;
+	unsigned int i;
+	bool valid;
 
-	program = clCreateProgramWithSource(context->cl_ctx,
-	                                    count,
-	                                    (const char**)strings,
-	                                    NULL,
-	                                    &errNo);
-	if(errNo != CL_SUCCESS) {
-		fprintf(stderr,
-		        "Could not create program with source: %s\n",
-		        piglit_cl_get_error_name(errNo));
+	file = fopen(path, "rb");
+	if(file == NULL) {
 		return NULL;
 	}
 
-	errNo = clBuildProgram(program,
-	                       context->num_devices,
-	                       context->device_ids,
-	                       options,
-	                       NULL,
-	                       NULL);
-	if(   (!fail && errNo != CL_SUCCESS)
-	   || ( fail && errNo == CL_SUCCESS)) {
-		int i;
+	valid =    fread(magic, sizeof(magic), 1, file) == 1
+	        && !memcmp(magic, PROGRAM_CACHE_MAGIC, sizeof(magic))
+	        && fread(&version, sizeof(version), 1, file) == 1
+	        && version == PROGRAM_CACHE_VERSION
+	        && fread(&stored_key_length, sizeof(stored_key_length), 1, file) == 1
+	        && stored_key_length == key_length;
+	if(valid) {
+		stored_key = malloc(key_length);
+		valid =    fread(stored_key, 1, key_length, file) == key_length
+		        && !memcmp(stored_key, key, key_length)
+		        && fread(&num_devices, sizeof(num_devices), 1, file) == 1
+		        && num_devices == context->num_devices;
+	}
+	if(valid) {
+		lengths = calloc(num_devices, sizeof(size_t));
+		binaries = calloc(num_devices, sizeof(unsigned char*));
+		for(i = 0; valid && i < num_devices; i++) {
+			uint64_t length;
+
+			valid =    fread(&length, sizeof(length), 1, file) == 1
+			        && length > 0;
+			lengths[i] = length;
+		}
+		for(i = 0; valid && i < num_devices; i++) {
+			binaries[i] = malloc(lengths[i]);
+			valid = fread(binaries[i], 1, lengths[i], file) == lengths[i];
+		}
+	}
+	fclose(file);
+
+	if(valid) {
+		program = clCreateProgramWithBinary(context->cl_ctx,
+		                                    num_devices,
+		                                    context->device_ids,
+		                                    lengths,
+		                                    (const unsigned char**)binaries,
+		                                    NULL,
+		                                    &errNo);
+		if(errNo != CL_SUCCESS) {
+			program = NULL;
+		} else if(clBuildProgram(program, num_devices, context->device_ids,
+		                         options, NULL, NULL) != CL_SUCCESS) {
+			clReleaseProgram(program);
+			program = NULL;
+		}
+	}
 
-		fprintf(stderr,
-		        !fail ? "Could not build program: %s\n"
-		              : "Program built when it should have failed: %s\n",
-		        piglit_cl_get_error_name(errNo));
+	if(binaries != NULL) {
+		for(i = 0; i < num_devices; i++) {
+			free(binaries[i]);
+		}
+	}
+	free(binaries);
+	free(lengths);
+	free(stored_key);
 
-		/*printf("Build log for source:\n");
-		for(i = 0; i < count; i++) {
-			printf("%s\n", strings[i]);
-		}*/
+	return program;
+}
 
-		for(i = 0; i < context->num_devices; i++) {
-			char* device_name = piglit_cl_get_device_info(context->device_ids[i],
-			                                              CL_DEVICE_NAME);
-			char* log = piglit_cl_get_program_build_info(program,
-			                                             context->device_ids[i],
-			                                             CL_PROGRAM_BUILD_LOG);
+static void
+program_cache_store(piglit_cl_context context, cl_program program,
+                    const char* path, const char* key, size_t key_length)
+{
+	const uint32_t version = PROGRAM_CACHE_VERSION;
+	const uint32_t num_devices = context->num_devices;
+	cl_device_id* devices;
+	size_t* sizes;
+	unsigned char** binaries;
+	unsigned int* order;
+	char* tmp_path;
+	FILE* file;
+	unsigned int i, j;
+	bool ok;
+
+	devices = piglit_cl_get_program_info(program, CL_PROGRAM_DEVICES);
+	sizes = piglit_cl_get_program_info(program, CL_PROGRAM_BINARY_SIZES);
+	binaries = calloc(num_devices, sizeof(unsigned char*));
+	order = calloc(num_devices, sizeof(unsigned int));
+
+	/* The program may list the devices in another order */
+	ok = true;
+	for(i = 0; ok && i < num_devices; i++) {
+		for(j = 0; j < num_devices; j++) {
+			if(devices[j] == context->device_ids[i]) {
+				break;
+			}
+		}
+		ok = j < num_devices && sizes[j] > 0;
+		order[i] = j;
+	}
 
-			printf("Build log for device %s:\n -------- \n%s\n -------- \n",
-			       device_name,
-			       log);
+	if(ok) {
+		for(i = 0; i < num_devices; i++) {
+			binaries[i] = malloc(sizes[i]);
+		}
+		ok = clGetProgramInfo(program, CL_PROGRAM_BINARIES,
+		                      num_devices * sizeof(unsigned char*),
+		                      binaries, NULL) == CL_SUCCESS;
+	}
 
-			free(device_name);
-			free(log);
+	if(ok) {
+		/* Write to a file of our own and rename it, so that
+		 * concurrent tests never see a partial file.
+		 */
+		tmp_path = malloc(strlen(path) + 32);
+		sprintf(tmp_path, "%s.%" PRIx64 ".tmp", path,
+		        (uint64_t)piglit_time_get_nano());
+
+		file = fopen(tmp_path, "wb");
+		if(file != NULL) {
+			const uint64_t stored_key_length = key_length;
+
+			ok =    fwrite(PROGRAM_CACHE_MAGIC, 4, 1, file) == 1
+			     && fwrite(&version, sizeof(version), 1, file) == 1
+			     && fwrite(&stored_key_length, sizeof(stored_key_length), 1, file) == 1
+			     && fwrite(key, 1, key_length, file) == key_length
+			     && fwrite(&num_devices, sizeof(num_devices), 1, file) == 1;
+			for(i = 0; ok && i < num_devices; i++) {
+				const uint64_t length = sizes[order[i]];
+
+				ok = fwrite(&length, sizeof(length), 1, file) == 1;
+			}
+			for(i = 0; ok && i < num_devices; i++) {
+				ok = fwrite(binaries[order[i]], 1, sizes[order[i]],
+				            file) == sizes[order[i]];
+			}
+			ok = fclose(file) == 0 && ok;
+
+			if(!ok || rename(tmp_path, path) != 0) {
+				remove(tmp_path);
+			}
 		}
+		free(tmp_path);
+	}
 
-		clReleaseProgram(program);
-		return NULL;
+	for(i = 0; i < num_devices; i++) {
+		free(binaries[i]);
 	}
+	free(binaries);
+	free(order);
+	free(sizes);
+	free(devices);
+}
 
-	return program;
+/*
+ * A build of a program that runs while the caller goes on.  With threads the
+ * build is started with a notify callback, so the implementation may return
+ * from clBuildProgram before it is done, otherwise the build is done when it
+ * is started.
+ */
+struct piglit_cl_program_build {
+	piglit_cl_context context;
+	cl_program program; /* NULL if the build could not be started */
+	cl_int error; /* What clBuildProgram returned */
+	bool fail;
+	bool from_binary;
+
+	char* cache_key;
+	char* cache_path;
+	size_t cache_key_length;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool done;
+#endif
+};
+
+#ifdef PIGLIT_HAS_PTHREADS
+static void CL_CALLBACK
+program_build_notify(cl_program program, void* user_data)
+{
+	struct piglit_cl_program_build* build = user_data;
+
+	pthread_mutex_lock(&build->mutex);
+	build->done = true;
+	pthread_cond_broadcast(&build->cond);
+	pthread_mutex_unlock(&build->mutex);
 }
+#endif
 
-cl_program
-piglit_cl_build_program_with_source(piglit_cl_context context, cl_uint count,
-                                    char** strings, const char* options)
+static struct piglit_cl_program_build*
+program_build_create(piglit_cl_context context, bool fail, bool from_binary)
 {
-	return piglit_cl_build_program_with_source_extended(context, count, strings, options, false);
+	struct piglit_cl_program_build* build = calloc(1, sizeof(*build));
+
+	build->context = context;
+	build->fail = fail;
+	build->from_binary = from_binary;
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_init(&build->mutex, NULL);
+	pthread_cond_init(&build->cond, NULL);
+	build->done = true;
+#endif
+	return build;
 }
 
-cl_program
-piglit_cl_fail_build_program_with_source(piglit_cl_context context,
-                                         cl_uint count, char** strings,
-                                         const char* options)
+static void
+program_build_start(struct piglit_cl_program_build* build,
+                    const char* options)
 {
-	return piglit_cl_build_program_with_source_extended(context, count, strings, options, true);
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&build->mutex);
+	build->done = false;
+	pthread_mutex_unlock(&build->mutex);
+
+	build->error = clBuildProgram(build->program,
+	                              build->context->num_devices,
+	                              build->context->device_ids,
+	                              options,
+	                              program_build_notify,
+	                              build);
+
+	/* The callback is only called for builds that started */
+	if(build->error != CL_SUCCESS) {
+		pthread_mutex_lock(&build->mutex);
+		build->done = true;
+		pthread_mutex_unlock(&build->mutex);
+	}
+#else
+	build->error = clBuildProgram(build->program,
+	                              build->context->num_devices,
+	                              build->context->device_ids,
+	                              options,
+	                              NULL,
+	                              NULL);
+#endif
 }
 
-cl_program
-piglit_cl_build_program_with_binary_extended(piglit_cl_context context,
-                                             size_t* lengths,
-                                             unsigned char** binaries,
-                                             const char* options, bool fail)
+struct piglit_cl_program_build*
+piglit_cl_start_build_program_with_source(piglit_cl_context context,
+                                          cl_uint count, char** strings,
+                                          const char* options, bool fail)
 {
 	cl_int errNo;
-	cl_program program;
+	struct piglit_cl_program_build* build =
+		program_build_create(context, fail, false);
+	const char* cache_dir = getenv("PIGLIT_CL_PROGRAM_CACHE");
+
+	/* Programs that should fail to build are always compiled */
+	if(!fail && cache_dir != NULL && cache_dir[0] != '\0') {
+		build->cache_key = program_cache_key(context, count, strings,
+		                                     options,
+		                                     &build->cache_key_length);
+		build->cache_path = program_cache_path(cache_dir,
+		                                       build->cache_key,
+		                                       build->cache_key_length);
+
+		build->program = program_cache_load(context, build->cache_path,
+		                                    build->cache_key,
+		                                    build->cache_key_length,
+		                                    options);
+		if(build->program != NULL) {
+			free(build->cache_path);
+			build->cache_path = NULL;
+			return build;
+		}
+	}
+
+	build->program = clCreateProgramWithSource(context->cl_ctx,
+	                                           count,
+	                                           (const char**)strings,
+	                                           NULL,
+	                                           &errNo);
+	if(errNo != CL_SUCCESS) {
+		fprintf(stderr,
+		        "Could not create program with source: %s\n",
+		        piglit_cl_get_error_name(errNo));
+		build->program = NULL;
+		return build;
+	}
+
+	program_build_start(build, options);
+	return build;
+}
+
+struct piglit_cl_program_build*
+piglit_cl_start_build_program_with_binary(piglit_cl_context context,
+                                          size_t* lengths,
+                                          unsigned char** binaries,
+                                          const char* options, bool fail)
+{
+	cl_int errNo;
+	struct piglit_cl_program_build* build =
+		program_build_create(context, fail, true);
 
 	cl_int* binary_status = malloc(sizeof(cl_int) * context->num_devices);
 
-	program = clCreateProgramWithBinary(context->cl_ctx,
-	                                    context->num_devices,
-	                                    context->device_ids,
-	                                    lengths,
-	                                    (const unsigned char**)binaries,
-	                                    binary_status,
-	                                    &errNo);
+	build->program = clCreateProgramWithBinary(context->cl_ctx,
+	                                           context->num_devices,
+	                                           context->device_ids,
+	                                           lengths,
+	                                           (const unsigned char**)binaries,
+	                                           binary_status,
+	                                           &errNo);
 	if(errNo != CL_SUCCESS) {
 		int i;
 
@@ -960,18 +1281,54 @@ piglit_cl_build_program_with_binary_extended(piglit_cl_context context,
 		}
 
 		free(binary_status);
-		return NULL;
+		build->program = NULL;
+		return build;
 	}
 	free(binary_status);
 
-	errNo = clBuildProgram(program,
-	                       context->num_devices,
-	                       context->device_ids,
-	                       options,
-	                       NULL,
-	                       NULL);
-	if(   (!fail && errNo != CL_SUCCESS)
-	   || ( fail && errNo == CL_SUCCESS)) {
+	program_build_start(build, options);
+	return build;
+}
+
+cl_program
+piglit_cl_finish_build_program(struct piglit_cl_program_build* build)
+{
+	piglit_cl_context context = build->context;
+	cl_program program = build->program;
+	cl_int errNo = build->error;
+	bool fail = build->fail;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&build->mutex);
+	while(!build->done) {
+		pthread_cond_wait(&build->cond, &build->mutex);
+	}
+	pthread_mutex_unlock(&build->mutex);
+#endif
+
+	/*
+	 * A build that was started returns CL_SUCCESS, whether it
+	 * succeeds is only known from its status on each device.
+	 */
+	if(program != NULL && errNo == CL_SUCCESS) {
+		int i;
+
+		for(i = 0; i < context->num_devices; i++) {
+			cl_build_status* status =
+				piglit_cl_get_program_build_info(program,
+				                                 context->device_ids[i],
+				                                 CL_PROGRAM_BUILD_STATUS);
+
+			if(status == NULL || *status != CL_BUILD_SUCCESS) {
+				errNo = CL_BUILD_PROGRAM_FAILURE;
+			}
+			free(status);
+		}
+	}
+
+	if(   program != NULL
+	   && (   (!fail && errNo != CL_SUCCESS)
+	       || ( fail && errNo == CL_SUCCESS))) {
 		int i;
 
 		fprintf(stderr,
@@ -979,7 +1336,9 @@ piglit_cl_build_program_with_binary_extended(piglit_cl_context context,
 		              : "Program built when it should have failed: %s\n",
 		        piglit_cl_get_error_name(errNo));
 
-		printf("Build log for binaries.\n");
+		if(build->from_binary) {
+			printf("Build log for binaries.\n");
+		}
 
 		for(i = 0; i < context->num_devices; i++) {
 			char* device_name = piglit_cl_get_device_info(context->device_ids[i],
@@ -997,12 +1356,61 @@ piglit_cl_build_program_with_binary_extended(piglit_cl_context context,
 		}
 
 		clReleaseProgram(program);
-		return NULL;
+		program = NULL;
+	} else if(program != NULL && build->cache_path != NULL) {
+		program_cache_store(context, program, build->cache_path,
+		                    build->cache_key, build->cache_key_length);
 	}
 
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_cond_destroy(&build->cond);
+	pthread_mutex_destroy(&build->mutex);
+#endif
+	free(build->cache_key);
+	free(build->cache_path);
+	free(build);
+
 	return program;
 }
 
+cl_program
+piglit_cl_build_program_with_source_extended(piglit_cl_context context,
+                                             cl_uint count, char** strings,
+                                             const char* options, bool fail)
+{
+	return piglit_cl_finish_build_program(
+		piglit_cl_start_build_program_with_source(context, count,
+		                                          strings, options,
+		                                          fail));
+}
+
+cl_program
+piglit_cl_build_program_with_source(piglit_cl_context context, cl_uint count,
+                                    char** strings, const char* options)
+{
+	return piglit_cl_build_program_with_source_extended(context, count, strings, options, false);
+}
+
+cl_program
+piglit_cl_fail_build_program_with_source(piglit_cl_context context,
+                                         cl_uint count, char** strings,
+                                         const char* options)
+{
+	return piglit_cl_build_program_with_source_extended(context, count, strings, options, true);
+}
+
+cl_program
+piglit_cl_build_program_with_binary_extended(piglit_cl_context context,
+                                             size_t* lengths,
+                                             unsigned char** binaries,
+                                             const char* options, bool fail)
+{
+	return piglit_cl_finish_build_program(
+		piglit_cl_start_build_program_with_binary(context, lengths,
+		                                          binaries, options,
+		                                          fail));
+}
+
 cl_program
 piglit_cl_build_program_with_binary(piglit_cl_context context, size_t* lengths,
                                     unsigned char** binaries,
@@ -1059,6 +1467,24 @@ piglit_cl_write_buffer(cl_command_queue command_queue, cl_mem buffer,
 	return true;
 }
 
+bool
+piglit_cl_enqueue_write_buffer(cl_command_queue command_queue, cl_mem buffer,
+                               size_t offset, size_t cb, const void *ptr)
+{
+	cl_int errNo;
+
+	errNo = clEnqueueWriteBuffer(command_queue, buffer, CL_FALSE, offset, cb,
+	                             ptr, 0, NULL, NULL);
+	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
+		fprintf(stderr,
+		        "Could not enqueue buffer write: %s\n",
+		        piglit_cl_get_error_name(errNo));
+		return false;
+	}
+
+	return true;
+}
+
 bool
 piglit_cl_write_whole_buffer(cl_command_queue command_queue, cl_mem buffer,
                              const void *ptr)
@@ -1092,6 +1518,24 @@ piglit_cl_read_buffer(cl_command_queue command_queue, cl_mem buffer,
 	return true;
 }
 
+bool
+piglit_cl_enqueue_read_buffer(cl_command_queue command_queue, cl_mem buffer,
+                              size_t offset, size_t cb, void *ptr)
+{
+	cl_int errNo;
+
+	errNo = clEnqueueReadBuffer(command_queue, buffer, CL_FALSE, offset, cb,
+	                            ptr, 0, NULL, NULL);
+	if(!piglit_cl_check_error(errNo, CL_SUCCESS)) {
+		fprintf(stderr,
+		        "Could not enqueue buffer read: %s\n",
+		        piglit_cl_get_error_name(errNo));
+		return false;
+	}
+
+	return true;
+}
+
 bool
 piglit_cl_read_whole_buffer(cl_command_queue command_queue, cl_mem buffer,
                             void *ptr)
@@ -90,18 +90,36 @@ bool piglit_cl_probe_uinteger(uint64_t value,
  */
 bool piglit_cl_probe_half(cl_half value, cl_half expect, uint32_t ulp);
 
+/**
+ * \brief Check like piglit_cl_probe_half(), but without printing a message
+ *        when \c value is out of tolerance.
+ */
+bool piglit_cl_compare_half(cl_half value, cl_half expect, uint32_t ulp);
+
 /**
  * \brief Probe floating-point \c value if it compares equal to \c expect with
  *        tolerance \c ulp.
  */
 bool piglit_cl_probe_floating(float value, float expect, uint32_t ulp);
 
+/**
+ * \brief Check like piglit_cl_probe_floating(), but without printing a
+ *        message when \c value is out of tolerance.
+ */
+bool piglit_cl_compare_floating(float value, float expect, uint32_t ulp);
+
 /**
  * \brief Probe double \c value if it compares equal to \c expect with
  *        tolerance \c ulp.
  */
 bool piglit_cl_probe_double(double value, double expect, uint64_t ulp);
 
+/**
+ * \brief Check like piglit_cl_probe_double(), but without printing a
+ *        message when \c value is out of tolerance.
+ */
+bool piglit_cl_compare_double(double value, double expect, uint64_t ulp);
+
 /**
  * \brief Check for unexpected GL error and report it.
  *
@@ -486,6 +504,65 @@ piglit_cl_fail_build_program_with_binary(piglit_cl_context context,
                                          unsigned char** binaries,
                                          const char* options);
 
+/**
+ * \brief A program build started by
+ * \c piglit_cl_start_build_program_with_source or
+ * \c piglit_cl_start_build_program_with_binary.
+ */
+struct piglit_cl_program_build;
+
+/**
+ * \brief Create a program with source and start building it.
+ *
+ * Like \c piglit_cl_build_program_with_source, but the build may still be
+ * running when this returns.  It must be passed to
+ * \c piglit_cl_finish_build_program once.
+ *
+ * @param context      Context on which to create and build program.
+ * @param count        Number of strings in \c strings.
+ * @param string       Array of pointers to NULL-terminated source strings.
+ * @param options      NULL-terminated string that describes build options.
+ * @param fail         \c true if the build is expected to fail.
+ * @return             The started build.
+ */
+struct piglit_cl_program_build*
+piglit_cl_start_build_program_with_source(piglit_cl_context context,
+                                          cl_uint count,
+                                          char** strings,
+                                          const char* options,
+                                          bool fail);
+
+/**
+ * \brief Create a program with binary and start building it.
+ *
+ * Like \c piglit_cl_build_program_with_binary, but the build may still be
+ * running when this returns.  It must be passed to
+ * \c piglit_cl_finish_build_program once.
+ *
+ * @param context      Context on which to create and build program.
+ * @param lengths      Lengths of binaries in \c binaries.
+ * @param binaries     Array of pointers to binaries.
+ * @param options      NULL-terminated string that describes build options.
+ * @param fail         \c true if the build is expected to fail.
+ * @return             The started build.
+ */
+struct piglit_cl_program_build*
+piglit_cl_start_build_program_with_binary(piglit_cl_context context,
+                                          size_t* lengths,
+                                          unsigned char** binaries,
+                                          const char* options,
+                                          bool fail);
+
+/**
+ * \brief Wait for a started program build and free it.
+ *
+ * @param build        Build to wait for.
+ * @return             The program, as \c piglit_cl_build_program_with_source
+ *                     and the other build functions return it.
+ */
+cl_program
+piglit_cl_finish_build_program(struct piglit_cl_program_build* build);
+
 /**
  * \brief Create a buffer.
  *
@@ -516,6 +593,26 @@ piglit_cl_write_buffer(cl_command_queue command_queue,
                        size_t cb,
                        const void *ptr);
 
+/**
+ * \brief Non-blocking write to a buffer.
+ *
+ * \c ptr must stay valid until the write has completed, for example after
+ * \c clFinish on \c command_queue.
+ *
+ * @param command_queue  Command queue to enqueue operation on.
+ * @param buffer         Memory buffer to write to.
+ * @param offset         Offset in buffer.
+ * @param cb             Size of data in bytes.
+ * @param ptr            Pointer to data to be written to buffer.
+ * @return               \c true on success, \c false otherwise.
+ */
+bool
+piglit_cl_enqueue_write_buffer(cl_command_queue command_queue,
+                               cl_mem buffer,
+                               size_t offset,
+                               size_t cb,
+                               const void *ptr);
+
 /**
  * \brief Blocking write to a whole buffer.
  *
@@ -549,6 +646,26 @@ piglit_cl_read_buffer(cl_command_queue command_queue,
                       size_t cb,
                       void *ptr);
 
+/**
+ * \brief Non-blocking read from a buffer.
+ *
+ * The data in \c ptr is only valid once the read has completed, for example
+ * after \c clFinish on \c command_queue.
+ *
+ * @param command_queue  Command queue to enqueue operation on.
+ * @param buffer         Memory buffer to read from.
+ * @param offset         Offset in buffer.
+ * @param cb             Size of data in bytes.
+ * @param ptr            Pointer to data to be written from buffer.
+ * @return               \c true on success, \c false otherwise.
+ */
+bool
+piglit_cl_enqueue_read_buffer(cl_command_queue command_queue,
+                              cl_mem buffer,
+                              size_t offset,
+                              size_t cb,
+                              void *ptr);
+
 /**
  * \brief Blocking read from a whole buffer.
  *
@@ -0,0 +1,997 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-util-compressed.c
+ *
+ * Reference decoders for compressed texture formats.
+ *
+ * Each decoder turns one 4x4 block into the RGBA texels the specification
+ * of the format defines, so that tests can compare whole images the GL
+ * decodes against them instead of probing a few texels of known value.
+ * The decoders are written from the specifications of the formats rather
+ * than for speed; a whole image of a test decodes in far less time than it
+ * takes to draw it.
+ */
+
+#include "piglit-util-gl.h"
+
+#define BLOCK_TEXELS 16
+
+/** Decode a block into texels[y * 4 + x]. */
+typedef void (*decode_block_func)(const uint8_t *block,
+				  float texels[BLOCK_TEXELS][4]);
+
+static uint64_t
+load_le64(const uint8_t *p)
+{
+	uint64_t v = 0;
+	int i;
+
+	for (i = 7; i >= 0; i--)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+static uint64_t
+load_be64(const uint8_t *p)
+{
+	uint64_t v = 0;
+	int i;
+
+	for (i = 0; i < 8; i++)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+static int
+clamp_int(int x, int min, int max)
+{
+	return x < min ? min : x > max ? max : x;
+}
+
+/*
+ * S3TC and RGTC, from EXT_texture_compression_s3tc and
+ * ARB_texture_compression_rgtc.
+ */
+
+static void
+unpack_565(uint16_t c, float rgb[3])
+{
+	rgb[0] = ((c >> 11) & 0x1f) / 31.0f;
+	rgb[1] = ((c >> 5) & 0x3f) / 63.0f;
+	rgb[2] = (c & 0x1f) / 31.0f;
+}
+
+/**
+ * Decode the color half of a DXT block. Three color mode with a
+ * transparent black fourth color is only possible in DXT1 blocks.
+ */
+static void
+decode_dxt_color(const uint8_t *block, bool dxt1, bool dxt1_alpha,
+		 float texels[BLOCK_TEXELS][4])
+{
+	const uint16_t c0 = block[0] | block[1] << 8;
+	const uint16_t c1 = block[2] | block[3] << 8;
+	const uint32_t bits = block[4] | block[5] << 8 | block[6] << 16 |
+			      (uint32_t) block[7] << 24;
+	float palette[4][4];
+	int i, c;
+
+	unpack_565(c0, palette[0]);
+	unpack_565(c1, palette[1]);
+	for (i = 0; i < 4; i++)
+		palette[i][3] = 1.0f;
+
+	if (!dxt1 || c0 > c1) {
+		for (c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+	} else {
+		for (c = 0; c < 3; c++) {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0.0f;
+		}
+		if (dxt1_alpha)
+			palette[3][3] = 0.0f;
+	}
+
+	for (i = 0; i < BLOCK_TEXELS; i++)
+		memcpy(texels[i], palette[(bits >> (2 * i)) & 3],
+		       sizeof(texels[i]));
+}
+
+/**
+ * Decode a block of 8-bit endpoints and 3-bit indices, as DXT5 alpha and
+ * RGTC channels are, into \a channel of the texels.
+ */
+static void
+decode_rgtc_channel(const uint8_t *block, bool is_signed,
+		    float texels[BLOCK_TEXELS][4], int channel)
+{
+	const uint64_t bits = load_le64(block) >> 16;
+	int e0, e1, max;
+	float palette[8];
+	int i;
+
+	if (is_signed) {
+		e0 = MAX2((int8_t) block[0], -127);
+		e1 = MAX2((int8_t) block[1], -127);
+		max = 127;
+	} else {
+		e0 = block[0];
+		e1 = block[1];
+		max = 255;
+	}
+
+	palette[0] = e0;
+	palette[1] = e1;
+	if (e0 > e1) {
+		for (i = 1; i < 7; i++)
+			palette[i + 1] = ((7 - i) * e0 + i * e1) / 7.0f;
+	} else {
+		for (i = 1; i < 5; i++)
+			palette[i + 1] = ((5 - i) * e0 + i * e1) / 5.0f;
+		palette[6] = is_signed ? -max : 0;
+		palette[7] = max;
+	}
+
+	for (i = 0; i < BLOCK_TEXELS; i++)
+		texels[i][channel] = palette[(bits >> (3 * i)) & 7] / max;
+}
+
+static void
+set_default_rgba(float texels[BLOCK_TEXELS][4])
+{
+	int i;
+
+	for (i = 0; i < BLOCK_TEXELS; i++) {
+		texels[i][0] = texels[i][1] = texels[i][2] = 0.0f;
+		texels[i][3] = 1.0f;
+	}
+}
+
+static void
+decode_dxt1_rgb(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_dxt_color(block, true, false, texels);
+}
+
+static void
+decode_dxt1_rgba(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_dxt_color(block, true, true, texels);
+}
+
+static void
+decode_dxt3(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	const uint64_t alpha = load_le64(block);
+	int i;
+
+	decode_dxt_color(block + 8, false, false, texels);
+	for (i = 0; i < BLOCK_TEXELS; i++)
+		texels[i][3] = ((alpha >> (4 * i)) & 0xf) / 15.0f;
+}
+
+static void
+decode_dxt5(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_dxt_color(block + 8, false, false, texels);
+	decode_rgtc_channel(block, false, texels, 3);
+}
+
+static void
+decode_rgtc1(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	set_default_rgba(texels);
+	decode_rgtc_channel(block, false, texels, 0);
+}
+
+static void
+decode_signed_rgtc1(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	set_default_rgba(texels);
+	decode_rgtc_channel(block, true, texels, 0);
+}
+
+static void
+decode_rgtc2(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	set_default_rgba(texels);
+	decode_rgtc_channel(block, false, texels, 0);
+	decode_rgtc_channel(block + 8, false, texels, 1);
+}
+
+static void
+decode_signed_rgtc2(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	set_default_rgba(texels);
+	decode_rgtc_channel(block, true, texels, 0);
+	decode_rgtc_channel(block + 8, true, texels, 1);
+}
+
+/** LATC is RGTC with red replicated to green and blue, and green to alpha. */
+static void
+latc_swizzle(float texels[BLOCK_TEXELS][4], bool has_alpha)
+{
+	int i;
+
+	for (i = 0; i < BLOCK_TEXELS; i++) {
+		texels[i][3] = has_alpha ? texels[i][1] : 1.0f;
+		texels[i][1] = texels[i][2] = texels[i][0];
+	}
+}
+
+static void
+decode_latc1(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_rgtc1(block, texels);
+	latc_swizzle(texels, false);
+}
+
+static void
+decode_signed_latc1(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_signed_rgtc1(block, texels);
+	latc_swizzle(texels, false);
+}
+
+static void
+decode_latc2(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_rgtc2(block, texels);
+	latc_swizzle(texels, true);
+}
+
+static void
+decode_signed_latc2(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_signed_rgtc2(block, texels);
+	latc_swizzle(texels, true);
+}
+
+/*
+ * BPTC unorm (BC7), from ARB_texture_compression_bptc.
+ */
+
+struct bptc_mode {
+	int n_subsets;
+	int n_partition_bits;
+	int n_rotation_bits;
+	int n_index_selection_bits;
+	int n_color_bits;
+	int n_alpha_bits;
+	bool has_endpoint_pbits;
+	bool has_shared_pbits;
+	int n_index_bits;
+	int n_secondary_index_bits;
+};
+
+static const struct bptc_mode bptc_modes[] = {
+	{ 3, 4, 0, 0, 4, 0, true,  false, 3, 0 },
+	{ 2, 6, 0, 0, 6, 0, false, true,  3, 0 },
+	{ 3, 6, 0, 0, 5, 0, false, false, 2, 0 },
+	{ 2, 6, 0, 0, 7, 0, true,  false, 2, 0 },
+	{ 1, 0, 2, 1, 5, 6, false, false, 2, 3 },
+	{ 1, 0, 2, 0, 7, 8, false, false, 2, 2 },
+	{ 1, 0, 0, 0, 7, 7, true,  false, 4, 0 },
+	{ 2, 6, 0, 0, 5, 5, true,  false, 2, 0 },
+};
+
+/** Bit n set if texel n is in the second subset. */
+static const uint16_t bptc_partitions2[64] = {
+	0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+	0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+	0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+	0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+	0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+	0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+	0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+	0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+};
+
+/** The subset of texel n in bits 2n and 2n + 1. */
+static const uint32_t bptc_partitions3[64] = {
+	0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8,
+	0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+	0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090,
+	0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+	0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0,
+	0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+	0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400,
+	0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+	0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424,
+	0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+	0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0,
+	0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+	0xaa444444, 0x54a854a8, 0x95809580, 0x96969600,
+	0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+	0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000,
+	0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254,
+};
+
+/** The anchor texel of the second subset of two subset partitions. */
+static const uint8_t bptc_anchors2[64] = {
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+	15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+	 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+/** The anchor texels of the second and third subsets of three subsets. */
+static const uint8_t bptc_anchors3[2][64] = {
+	{
+		 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+		 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+		 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+		 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+	},
+	{
+		15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+		15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+		15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+		15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+	},
+};
+
+static const uint8_t bptc_weights2[4] = { 0, 21, 43, 64 };
+static const uint8_t bptc_weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint8_t bptc_weights4[16] = {
+	0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+struct bit_reader {
+	const uint8_t *data;
+	int offset;
+};
+
+static unsigned
+read_bits(struct bit_reader *r, int n_bits)
+{
+	unsigned value = 0;
+	int i;
+
+	for (i = 0; i < n_bits; i++, r->offset++)
+		value |= ((r->data[r->offset / 8] >> (r->offset % 8)) & 1) << i;
+	return value;
+}
+
+static int
+bptc_subset(const struct bptc_mode *mode, int partition, int texel)
+{
+	switch (mode->n_subsets) {
+	case 2:
+		return (bptc_partitions2[partition] >> texel) & 1;
+	case 3:
+		return (bptc_partitions3[partition] >> (2 * texel)) & 3;
+	default:
+		return 0;
+	}
+}
+
+static bool
+bptc_is_anchor(const struct bptc_mode *mode, int partition, int texel)
+{
+	switch (mode->n_subsets) {
+	case 2:
+		return texel == 0 || texel == bptc_anchors2[partition];
+	case 3:
+		return texel == 0 || texel == bptc_anchors3[0][partition] ||
+		       texel == bptc_anchors3[1][partition];
+	default:
+		return texel == 0;
+	}
+}
+
+static int
+bptc_interpolate(int e0, int e1, int index, int n_index_bits)
+{
+	const uint8_t *weights = n_index_bits == 2 ? bptc_weights2 :
+				 n_index_bits == 3 ? bptc_weights3 :
+				 bptc_weights4;
+
+	return ((64 - weights[index]) * e0 + weights[index] * e1 + 32) >> 6;
+}
+
+static void
+decode_bptc_unorm(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	struct bit_reader r = { block, 0 };
+	const struct bptc_mode *mode;
+	int endpoints[3][2][4];
+	uint8_t indices[2][BLOCK_TEXELS];
+	int mode_index, partition, rotation, index_selection;
+	int subset, e, c, i, n_bits;
+
+	for (mode_index = 0; mode_index < 8; mode_index++) {
+		if (block[0] & (1 << mode_index))
+			break;
+	}
+
+	/* Reserved modes decode to transparent black. */
+	if (mode_index == 8) {
+		memset(texels, 0, sizeof(float) * BLOCK_TEXELS * 4);
+		return;
+	}
+
+	mode = &bptc_modes[mode_index];
+	read_bits(&r, mode_index + 1);
+	partition = read_bits(&r, mode->n_partition_bits);
+	rotation = read_bits(&r, mode->n_rotation_bits);
+	index_selection = read_bits(&r, mode->n_index_selection_bits);
+
+	for (c = 0; c < 3; c++) {
+		for (subset = 0; subset < mode->n_subsets; subset++) {
+			for (e = 0; e < 2; e++)
+				endpoints[subset][e][c] =
+					read_bits(&r, mode->n_color_bits);
+		}
+	}
+
+	for (subset = 0; subset < mode->n_subsets; subset++) {
+		for (e = 0; e < 2; e++)
+			endpoints[subset][e][3] =
+				read_bits(&r, mode->n_alpha_bits);
+	}
+
+	n_bits = mode->n_color_bits;
+	if (mode->has_endpoint_pbits || mode->has_shared_pbits) {
+		unsigned pbits[3][2];
+
+		for (subset = 0; subset < mode->n_subsets; subset++) {
+			if (mode->has_endpoint_pbits) {
+				pbits[subset][0] = read_bits(&r, 1);
+				pbits[subset][1] = read_bits(&r, 1);
+			} else {
+				pbits[subset][0] = pbits[subset][1] =
+					read_bits(&r, 1);
+			}
+		}
+
+		for (subset = 0; subset < mode->n_subsets; subset++) {
+			for (e = 0; e < 2; e++) {
+				for (c = 0; c < 4; c++) {
+					endpoints[subset][e][c] =
+						endpoints[subset][e][c] << 1 |
+						pbits[subset][e];
+				}
+			}
+		}
+		n_bits++;
+	}
+
+	/* Expand the endpoints to 8 bits by replicating their top bits. */
+	for (subset = 0; subset < mode->n_subsets; subset++) {
+		for (e = 0; e < 2; e++) {
+			for (c = 0; c < 4; c++) {
+				int bits = c < 3 ? n_bits :
+					   mode->n_alpha_bits ?
+					   mode->n_alpha_bits +
+					   (n_bits - mode->n_color_bits) : 0;
+				int v = endpoints[subset][e][c];
+
+				if (bits == 0)
+					v = 255;
+				else
+					v = (v << (8 - bits)) |
+					    (v >> (2 * bits - 8));
+				endpoints[subset][e][c] = v & 0xff;
+			}
+		}
+	}
+
+	for (i = 0; i < BLOCK_TEXELS; i++) {
+		n_bits = mode->n_index_bits;
+		if (bptc_is_anchor(mode, partition, i))
+			n_bits--;
+		indices[0][i] = read_bits(&r, n_bits);
+	}
+
+	for (i = 0; mode->n_secondary_index_bits && i < BLOCK_TEXELS; i++) {
+		n_bits = mode->n_secondary_index_bits;
+		if (i == 0)
+			n_bits--;
+		indices[1][i] = read_bits(&r, n_bits);
+	}
+
+	for (i = 0; i < BLOCK_TEXELS; i++) {
+		const int (*ep)[4] = endpoints[bptc_subset(mode, partition, i)];
+		int color_index = indices[0][i];
+		int alpha_index = indices[0][i];
+		int color_bits = mode->n_index_bits;
+		int alpha_bits = mode->n_index_bits;
+		int rgba[4];
+		float tmp;
+
+		if (mode->n_secondary_index_bits) {
+			alpha_index = indices[1][i];
+			alpha_bits = mode->n_secondary_index_bits;
+			if (index_selection) {
+				color_index = indices[1][i];
+				color_bits = mode->n_secondary_index_bits;
+				alpha_index = indices[0][i];
+				alpha_bits = mode->n_index_bits;
+			}
+		}
+
+		for (c = 0; c < 3; c++)
+			rgba[c] = bptc_interpolate(ep[0][c], ep[1][c],
+						   color_index, color_bits);
+		rgba[3] = bptc_interpolate(ep[0][3], ep[1][3],
+					   alpha_index, alpha_bits);
+
+		for (c = 0; c < 4; c++)
+			texels[i][c] = rgba[c] / 255.0f;
+
+		if (rotation) {
+			tmp = texels[i][3];
+			texels[i][3] = texels[i][rotation - 1];
+			texels[i][rotation - 1] = tmp;
+		}
+	}
+}
+
+/*
+ * ETC2 and EAC, from the OpenGL ES 3.0 specification.
+ */
+
+static const int etc1_modifiers[8][2] = {
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 },
+	{ 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 },
+};
+
+static const int etc2_distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+static const int eac_modifiers[16][8] = {
+	{ -3, -6,  -9, -15, 2, 5, 8, 14 },
+	{ -3, -7, -10, -13, 2, 6, 9, 12 },
+	{ -2, -5,  -8, -13, 1, 4, 7, 12 },
+	{ -2, -4,  -6, -13, 1, 3, 5, 12 },
+	{ -3, -6,  -8, -12, 2, 5, 7, 11 },
+	{ -3, -7,  -9, -11, 2, 6, 8, 10 },
+	{ -4, -7,  -8, -11, 3, 6, 7, 10 },
+	{ -3, -5,  -8, -11, 2, 4, 7, 10 },
+	{ -2, -6,  -8, -10, 1, 5, 7,  9 },
+	{ -2, -5,  -8, -10, 1, 4, 7,  9 },
+	{ -2, -4,  -8, -10, 1, 3, 7,  9 },
+	{ -2, -5,  -7, -10, 1, 4, 6,  9 },
+	{ -3, -4,  -7, -10, 2, 3, 6,  9 },
+	{ -1, -2,  -3, -10, 0, 1, 2,  9 },
+	{ -4, -6,  -8,  -9, 3, 5, 7,  8 },
+	{ -3, -5,  -7,  -9, 2, 4, 6,  8 },
+};
+
+/** The 2-bit index of a texel; the block stores them column by column. */
+static int
+etc_index(uint64_t v, int x, int y)
+{
+	const int i = x * 4 + y;
+
+	return ((v >> (16 + i)) & 1) << 1 | ((v >> i) & 1);
+}
+
+static int
+extend_4(int x)
+{
+	return x << 4 | x;
+}
+
+static int
+extend_5(int x)
+{
+	return x << 3 | x >> 2;
+}
+
+static int
+sign_extend_3(int x)
+{
+	return x & 4 ? x - 8 : x;
+}
+
+static void
+set_texel_rgb(float texel[4], int r, int g, int b)
+{
+	texel[0] = clamp_int(r, 0, 255) / 255.0f;
+	texel[1] = clamp_int(g, 0, 255) / 255.0f;
+	texel[2] = clamp_int(b, 0, 255) / 255.0f;
+	texel[3] = 1.0f;
+}
+
+/**
+ * Decode the T and H modes, which pick each texel from four paint
+ * colors. With \a punchthrough, the third one is transparent black.
+ */
+static void
+decode_etc2_paint(uint64_t v, const int paint[4][3], bool punchthrough,
+		  float texels[BLOCK_TEXELS][4])
+{
+	int x, y;
+
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 4; x++) {
+			const int index = etc_index(v, x, y);
+			float *texel = texels[y * 4 + x];
+
+			if (punchthrough && index == 2)
+				memset(texel, 0, sizeof(float) * 4);
+			else
+				set_texel_rgb(texel, paint[index][0],
+					      paint[index][1], paint[index][2]);
+		}
+	}
+}
+
+static void
+decode_etc2_t(uint64_t v, bool punchthrough, float texels[BLOCK_TEXELS][4])
+{
+	const int d = etc2_distances[((v >> 34) & 3) << 1 | ((v >> 32) & 1)];
+	const int c1[3] = {
+		extend_4(((v >> 59) & 3) << 2 | ((v >> 56) & 3)),
+		extend_4((v >> 52) & 0xf),
+		extend_4((v >> 48) & 0xf),
+	};
+	const int c2[3] = {
+		extend_4((v >> 44) & 0xf),
+		extend_4((v >> 40) & 0xf),
+		extend_4((v >> 36) & 0xf),
+	};
+	int paint[4][3];
+	int c;
+
+	for (c = 0; c < 3; c++) {
+		paint[0][c] = c1[c];
+		paint[1][c] = c2[c] + d;
+		paint[2][c] = c2[c];
+		paint[3][c] = c2[c] - d;
+	}
+
+	decode_etc2_paint(v, (const int (*)[3]) paint, punchthrough, texels);
+}
+
+static void
+decode_etc2_h(uint64_t v, bool punchthrough, float texels[BLOCK_TEXELS][4])
+{
+	const int r1 = (v >> 59) & 0xf;
+	const int g1 = ((v >> 56) & 7) << 1 | ((v >> 52) & 1);
+	const int b1 = ((v >> 51) & 1) << 3 | ((v >> 47) & 7);
+	const int r2 = (v >> 43) & 0xf;
+	const int g2 = (v >> 39) & 0xf;
+	const int b2 = (v >> 35) & 0xf;
+	const int order = (r1 << 8 | g1 << 4 | b1) >= (r2 << 8 | g2 << 4 | b2);
+	const int d = etc2_distances[((v >> 34) & 1) << 2 |
+				     ((v >> 32) & 1) << 1 | order];
+	const int c1[3] = { extend_4(r1), extend_4(g1), extend_4(b1) };
+	const int c2[3] = { extend_4(r2), extend_4(g2), extend_4(b2) };
+	int paint[4][3];
+	int c;
+
+	for (c = 0; c < 3; c++) {
+		paint[0][c] = c1[c] + d;
+		paint[1][c] = c1[c] - d;
+		paint[2][c] = c2[c] + d;
+		paint[3][c] = c2[c] - d;
+	}
+
+	decode_etc2_paint(v, (const int (*)[3]) paint, punchthrough, texels);
+}
+
+static void
+decode_etc2_planar(uint64_t v, float texels[BLOCK_TEXELS][4])
+{
+	const int o[3] = {
+		(v >> 57) & 0x3f,
+		((v >> 56) & 1) << 6 | ((v >> 49) & 0x3f),
+		((v >> 48) & 1) << 5 | ((v >> 43) & 3) << 3 | ((v >> 39) & 7),
+	};
+	const int h[3] = {
+		((v >> 34) & 0x1f) << 1 | ((v >> 32) & 1),
+		(v >> 25) & 0x7f,
+		(v >> 19) & 0x3f,
+	};
+	const int vv[3] = {
+		(v >> 13) & 0x3f,
+		(v >> 6) & 0x7f,
+		v & 0x3f,
+	};
+	int ext[3][3];
+	int x, y, c;
+
+	/* Red and blue have 6 bits, green 7. */
+	for (c = 0; c < 3; c++) {
+		const int bits = c == 1 ? 7 : 6;
+
+		ext[0][c] = o[c] << (8 - bits) | o[c] >> (2 * bits - 8);
+		ext[1][c] = h[c] << (8 - bits) | h[c] >> (2 * bits - 8);
+		ext[2][c] = vv[c] << (8 - bits) | vv[c] >> (2 * bits - 8);
+	}
+
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 4; x++) {
+			int rgb[3];
+
+			for (c = 0; c < 3; c++) {
+				rgb[c] = (x * (ext[1][c] - ext[0][c]) +
+					  y * (ext[2][c] - ext[0][c]) +
+					  4 * ext[0][c] + 2) >> 2;
+			}
+			set_texel_rgb(texels[y * 4 + x], rgb[0], rgb[1], rgb[2]);
+		}
+	}
+}
+
+/**
+ * Decode an ETC2 RGB block. With \a punchthrough, the bit selecting the
+ * individual mode of ETC1 instead says whether the block is opaque.
+ */
+static void
+decode_etc2_rgb_block(const uint8_t *block, bool punchthrough,
+		      float texels[BLOCK_TEXELS][4])
+{
+	const uint64_t v = load_be64(block);
+	const bool diff_bit = (v >> 33) & 1;
+	const bool differential = punchthrough || diff_bit;
+	const bool transparent = punchthrough && !diff_bit;
+	const bool flip = (v >> 32) & 1;
+	const int table[2] = { (v >> 37) & 7, (v >> 34) & 7 };
+	int base[2][3];
+	int x, y, c;
+
+	if (differential) {
+		for (c = 0; c < 3; c++) {
+			const int b = (v >> (59 - 8 * c)) & 0x1f;
+			const int d = sign_extend_3((v >> (56 - 8 * c)) & 7);
+
+			if (b + d < 0 || b + d > 31) {
+				if (c == 0)
+					decode_etc2_t(v, transparent, texels);
+				else if (c == 1)
+					decode_etc2_h(v, transparent, texels);
+				else
+					decode_etc2_planar(v, texels);
+				return;
+			}
+
+			base[0][c] = extend_5(b);
+			base[1][c] = extend_5(b + d);
+		}
+	} else {
+		for (c = 0; c < 3; c++) {
+			base[0][c] = extend_4((v >> (60 - 8 * c)) & 0xf);
+			base[1][c] = extend_4((v >> (56 - 8 * c)) & 0xf);
+		}
+	}
+
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 4; x++) {
+			const int sub = flip ? y >= 2 : x >= 2;
+			const int index = etc_index(v, x, y);
+			float *texel = texels[y * 4 + x];
+			int m = etc1_modifiers[table[sub]][index & 1];
+
+			if (index & 2)
+				m = -m;
+
+			/* Non-opaque blocks replace the small modifiers
+			 * with 0 and transparent black.
+			 */
+			if (transparent && !(index & 1)) {
+				if (index == 2) {
+					memset(texel, 0, sizeof(float) * 4);
+					continue;
+				}
+				m = 0;
+			}
+
+			set_texel_rgb(texel, base[sub][0] + m,
+				      base[sub][1] + m, base[sub][2] + m);
+		}
+	}
+}
+
+/**
+ * Decode an EAC block into \a channel. \a bits is 8 for the alpha of
+ * ETC2 RGBA8 and 11 for R11 and RG11.
+ */
+static void
+decode_eac_channel(const uint8_t *block, int bits, bool is_signed,
+		   float texels[BLOCK_TEXELS][4], int channel)
+{
+	const uint64_t v = load_be64(block);
+	const int multiplier = block[1] >> 4;
+	const int *modifiers = eac_modifiers[block[1] & 0xf];
+	int x, y;
+
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 4; x++) {
+			const int i = x * 4 + y;
+			const int m = modifiers[(v >> (45 - 3 * i)) & 7];
+			float value;
+
+			if (bits == 8) {
+				value = clamp_int(block[0] + m * multiplier,
+						  0, 255) / 255.0f;
+			} else if (is_signed) {
+				int base = MAX2((int8_t) block[0], -127);
+				int s = base * 8 +
+					m * (multiplier ? multiplier * 8 : 1);
+
+				value = clamp_int(s, -1023, 1023) / 1023.0f;
+			} else {
+				int u = block[0] * 8 + 4 +
+					m * (multiplier ? multiplier * 8 : 1);
+
+				value = clamp_int(u, 0, 2047) / 2047.0f;
+			}
+
+			texels[y * 4 + x][channel] = value;
+		}
+	}
+}
+
+static void
+decode_etc2_rgb8(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_etc2_rgb_block(block, false, texels);
+}
+
+static void
+decode_etc2_rgb8_punchthrough(const uint8_t *block,
+			      float texels[BLOCK_TEXELS][4])
+{
+	decode_etc2_rgb_block(block, true, texels);
+}
+
+static void
+decode_etc2_rgba8(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	decode_etc2_rgb_block(block + 8, false, texels);
+	decode_eac_channel(block, 8, false, texels, 3);
+}
+
+static void
+decode_eac_r11(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	set_default_rgba(texels);
+	decode_eac_channel(block, 11, false, texels, 0);
+}
+
+static void
+decode_eac_signed_r11(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	set_default_rgba(texels);
+	decode_eac_channel(block, 11, true, texels, 0);
+}
+
+static void
+decode_eac_rg11(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	set_default_rgba(texels);
+	decode_eac_channel(block, 11, false, texels, 0);
+	decode_eac_channel(block + 8, 11, false, texels, 1);
+}
+
+static void
+decode_eac_signed_rg11(const uint8_t *block, float texels[BLOCK_TEXELS][4])
+{
+	set_default_rgba(texels);
+	decode_eac_channel(block, 11, true, texels, 0);
+	decode_eac_channel(block + 8, 11, true, texels, 1);
+}
+
+static decode_block_func
+get_block_decoder(GLenum format)
+{
+	switch (format) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		return decode_dxt1_rgb;
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+		return decode_dxt1_rgba;
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+		return decode_dxt3;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		return decode_dxt5;
+	case GL_COMPRESSED_RED_RGTC1:
+		return decode_rgtc1;
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+		return decode_signed_rgtc1;
+	case GL_COMPRESSED_RG_RGTC2:
+		return decode_rgtc2;
+	case GL_COMPRESSED_SIGNED_RG_RGTC2:
+		return decode_signed_rgtc2;
+	case GL_COMPRESSED_LUMINANCE_LATC1_EXT:
+		return decode_latc1;
+	case GL_COMPRESSED_SIGNED_LUMINANCE_LATC1_EXT:
+		return decode_signed_latc1;
+	case GL_COMPRESSED_LUMINANCE_ALPHA_LATC2_EXT:
+		return decode_latc2;
+	case GL_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2_EXT:
+		return decode_signed_latc2;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		return decode_bptc_unorm;
+	case GL_COMPRESSED_RGB8_ETC2:
+	case GL_COMPRESSED_SRGB8_ETC2:
+		return decode_etc2_rgb8;
+	case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+	case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+		return decode_etc2_rgb8_punchthrough;
+	case GL_COMPRESSED_RGBA8_ETC2_EAC:
+	case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+		return decode_etc2_rgba8;
+	case GL_COMPRESSED_R11_EAC:
+		return decode_eac_r11;
+	case GL_COMPRESSED_SIGNED_R11_EAC:
+		return decode_eac_signed_r11;
+	case GL_COMPRESSED_RG11_EAC:
+		return decode_eac_rg11;
+	case GL_COMPRESSED_SIGNED_RG11_EAC:
+		return decode_eac_signed_rg11;
+	default:
+		return NULL;
+	}
+}
+
+bool
+piglit_is_compressed_format_decodable(GLenum format)
+{
+	return get_block_decoder(format) != NULL;
+}
+
+bool
+piglit_decompress_image(GLenum format, unsigned width, unsigned height,
+			const void *data, float *rgba)
+{
+	const decode_block_func decode = get_block_decoder(format);
+	const uint8_t *block = data;
+	float texels[BLOCK_TEXELS][4];
+	unsigned bw, bh, bytes;
+	unsigned bx, by, x, y;
+
+	if (!decode)
+		return false;
+
+	piglit_get_compressed_block_size(format, &bw, &bh, &bytes);
+
+	for (by = 0; by < height; by += 4) {
+		for (bx = 0; bx < width; bx += 4, block += bytes) {
+			decode(block, texels);
+
+			for (y = 0; y < 4 && by + y < height; y++) {
+				for (x = 0; x < 4 && bx + x < width; x++) {
+					memcpy(&rgba[((by + y) * width +
+						      bx + x) * 4],
+					       texels[y * 4 + x],
+					       sizeof(texels[0]));
+				}
+			}
+		}
+	}
+
+	return true;
+}
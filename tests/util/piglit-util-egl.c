@@ -21,6 +21,10 @@
  * USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "piglit-util-egl.h"
 
 const char* piglit_get_egl_error_name(EGLint error) {
@@ -201,3 +205,153 @@ piglit_egl_bind_api(EGLenum api)
 	assert(0);
 	return false;
 }
+
+static char *blob_cache_dir;
+
+/**
+ * Return the path of the file of the blob cache entry for \a key, named by
+ * its 64-bit FNV-1a hash.
+ */
+static char *
+blob_cache_path(const void *key, EGLsizeiANDROID key_size)
+{
+	const uint8_t *bytes = key;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	char *path;
+	EGLsizeiANDROID i;
+
+	for (i = 0; i < key_size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	if (asprintf(&path, "%s/%016llx", blob_cache_dir,
+		     (unsigned long long) hash) < 0)
+		return NULL;
+
+	return path;
+}
+
+/**
+ * Store an entry as the size of its key, the key and the value, unless an
+ * entry of the same hash is already stored.
+ */
+static void
+blob_cache_set(const void *key, EGLsizeiANDROID key_size,
+	       const void *value, EGLsizeiANDROID value_size)
+{
+	char *path = blob_cache_path(key, key_size);
+	char *tmp_path = NULL;
+	uint32_t stored_key_size = key_size;
+	FILE *f;
+	bool ok;
+	int fd;
+
+	if (!path || access(path, F_OK) == 0)
+		goto out;
+
+	if (asprintf(&tmp_path, "%s.XXXXXX", path) < 0) {
+		tmp_path = NULL;
+		goto out;
+	}
+
+	fd = mkstemp(tmp_path);
+	if (fd < 0)
+		goto out;
+
+	f = fdopen(fd, "wb");
+	if (!f) {
+		close(fd);
+		unlink(tmp_path);
+		goto out;
+	}
+
+	ok = fwrite(&stored_key_size, sizeof(stored_key_size), 1, f) == 1 &&
+	     fwrite(key, 1, key_size, f) == (size_t) key_size &&
+	     fwrite(value, 1, value_size, f) == (size_t) value_size;
+	ok = fclose(f) == 0 && ok;
+
+	/* Readers see either no entry or all of it. */
+	if (!ok || rename(tmp_path, path) != 0)
+		unlink(tmp_path);
+
+out:
+	free(tmp_path);
+	free(path);
+}
+
+static EGLsizeiANDROID
+blob_cache_get(const void *key, EGLsizeiANDROID key_size,
+	       void *value, EGLsizeiANDROID value_size)
+{
+	char *path = blob_cache_path(key, key_size);
+	EGLsizeiANDROID result = 0;
+	uint32_t stored_key_size;
+	void *stored_key = NULL;
+	long size;
+	FILE *f;
+
+	f = path ? fopen(path, "rb") : NULL;
+	free(path);
+	if (!f)
+		return 0;
+
+	/* Another key with the same hash may be stored. */
+	if (fread(&stored_key_size, sizeof(stored_key_size), 1, f) != 1 ||
+	    stored_key_size != (uint32_t) key_size)
+		goto out;
+
+	stored_key = malloc(key_size);
+	if (fread(stored_key, 1, key_size, f) != (size_t) key_size ||
+	    memcmp(stored_key, key, key_size) != 0)
+		goto out;
+
+	if (fseek(f, 0, SEEK_END) != 0)
+		goto out;
+	size = ftell(f) - (long) sizeof(stored_key_size) - key_size;
+	if (size <= 0)
+		goto out;
+
+	/* A value that doesn't fit is only sized, as the extension says. */
+	if (size <= value_size &&
+	    (fseek(f, sizeof(stored_key_size) + key_size, SEEK_SET) != 0 ||
+	     fread(value, 1, size, f) != (size_t) size))
+		goto out;
+
+	result = size;
+
+out:
+	free(stored_key);
+	fclose(f);
+	return result;
+}
+
+bool
+piglit_egl_install_blob_cache(EGLDisplay dpy)
+{
+	const char *dir = getenv("PIGLIT_BLOB_CACHE_DIR");
+	PFNEGLSETBLOBCACHEFUNCSANDROIDPROC peglSetBlobCacheFuncs;
+
+	if (!dir || !dir[0])
+		return false;
+
+	if (!piglit_is_egl_extension_supported(dpy, "EGL_ANDROID_blob_cache"))
+		return false;
+
+	peglSetBlobCacheFuncs = (PFNEGLSETBLOBCACHEFUNCSANDROIDPROC)
+		eglGetProcAddress("eglSetBlobCacheFuncsANDROID");
+	if (!peglSetBlobCacheFuncs)
+		return false;
+
+	if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+		fprintf(stderr, "piglit: failed to create blob cache "
+			"directory %s: %s\n", dir, strerror(errno));
+		return false;
+	}
+
+	if (!blob_cache_dir)
+		blob_cache_dir = strdup(dir);
+
+	peglSetBlobCacheFuncs(dpy, blob_cache_set, blob_cache_get);
+	return eglGetError() == EGL_SUCCESS;
+}
@@ -113,6 +113,21 @@ void piglit_require_egl_extension(EGLDisplay dpy, const char *name);
 bool
 piglit_egl_bind_api(EGLenum api);
 
+/**
+ * \brief Back the blob cache of \a dpy with PIGLIT_BLOB_CACHE_DIR.
+ *
+ * If PIGLIT_BLOB_CACHE_DIR names a directory and \a dpy supports
+ * EGL_ANDROID_blob_cache, install blob cache functions which keep each blob
+ * the driver sets in a file of that directory, so that the shaders compiled
+ * by one test process are found by the next ones. Processes share the
+ * directory without locking: an entry is written to a temporary file and
+ * renamed into place, and its key is stored with it and compared on lookup.
+ *
+ * \a dpy must be initialized. Return true if the cache was installed.
+ */
+bool
+piglit_egl_install_blob_cache(EGLDisplay dpy);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
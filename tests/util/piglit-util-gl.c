@@ -23,6 +23,19 @@
 
 #include "piglit-util-gl.h"
 #include <ctype.h>
+#include <limits.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PIGLIT_COMPARE_SSE2
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PIGLIT_COMPARE_NEON
+#endif
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
@@ -35,6 +48,28 @@
  */
 static const char **gl_extensions = NULL;
 
+/* Size of the vertices and texture coordinates of a rect. */
+#define RECT_VERTS_SIZE (sizeof(GLfloat) * 4 * 4)
+#define RECT_SIZE (RECT_VERTS_SIZE + sizeof(GLfloat) * 4 * 2)
+
+/* Rects drawn from the rect buffer before it is orphaned. */
+#define RECT_BUFFER_RECTS 256
+
+/**
+ * The objects piglit_draw_rect_from_arrays() draws with, and what it found
+ * out about the last program it drew with.  These belong to the current
+ * context, piglit_gl_invalidate_extensions() forgets them.
+ */
+static struct {
+	GLuint buf;
+	GLuint vao;
+	/** Where the next rect goes in buf, in rects. */
+	unsigned next;
+
+	GLuint prog;
+	bool prog_has_vertex;
+} rect_cache;
+
 static const float color_wheel[4][4] = {
 	{1, 0, 0, 1}, /* red */
 	{0, 1, 0, 1}, /* green */
@@ -121,6 +156,9 @@ void piglit_gl_invalidate_extensions()
 		free(gl_extensions);
 		gl_extensions = NULL;
 	}
+
+	/* The objects piglit draws rects with belong to the context. */
+	memset(&rect_cache, 0, sizeof(rect_cache));
 }
 
 bool piglit_is_extension_supported(const char *name)
@@ -428,6 +466,174 @@ piglit_float_from_half(unsigned short val)
 	return f32.f;
 }
 
+/*
+ * Bulk versions of the conversions above, for whole images.  With F16C,
+ * or NEON on aarch64, the halves are converted four at a time; the blocks
+ * where the hardware conversion could give a different result than the
+ * scalar functions are converted one by one.
+ */
+
+void
+piglit_half_from_float_array(unsigned short *dst, const float *src,
+			     size_t count)
+{
+	size_t i = 0;
+
+#if defined(__F16C__)
+	/* Rounding toward zero gives the same halves as
+	 * piglit_half_from_float() except for NaNs and for the values that
+	 * overflow, which it turns into infinities.
+	 */
+	const __m128i abs_mask = _mm_set1_epi32(0x7fffffff);
+	const __m128i max_finite = _mm_set1_epi32(0x477fffff);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 v = _mm_loadu_ps(src + i);
+		__m128i a = _mm_and_si128(_mm_castps_si128(v), abs_mask);
+
+		if (_mm_movemask_epi8(_mm_cmpgt_epi32(a, max_finite))) {
+			for (unsigned j = 0; j < 4; j++)
+				dst[i + j] = piglit_half_from_float(src[i + j]);
+			continue;
+		}
+
+		_mm_storel_epi64((__m128i *) (dst + i),
+				 _mm_cvtps_ph(v, _MM_FROUND_TO_ZERO));
+	}
+#endif
+
+	for (; i < count; i++)
+		dst[i] = piglit_half_from_float(src[i]);
+}
+
+void
+piglit_float_from_half_array(float *dst, const unsigned short *src,
+			     size_t count)
+{
+	size_t i = 0;
+
+	/* The hardware conversions only differ from piglit_float_from_half()
+	 * on signaling NaNs, so blocks with an infinity or a NaN are left to
+	 * it.
+	 */
+#if defined(__F16C__)
+	const __m128i exp_mask = _mm_set1_epi16(0x7c00);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i h = _mm_loadl_epi64((const __m128i *) (src + i));
+		__m128i e = _mm_and_si128(h, exp_mask);
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(e, exp_mask)) & 0xff) {
+			for (unsigned j = 0; j < 4; j++)
+				dst[i + j] = piglit_float_from_half(src[i + j]);
+			continue;
+		}
+
+		_mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+	}
+#elif defined(PIGLIT_COMPARE_NEON)
+	const uint16x4_t exp_mask = vdup_n_u16(0x7c00);
+
+	for (; i + 4 <= count; i += 4) {
+		uint16x4_t h = vld1_u16(src + i);
+
+		if (vmaxv_u16(vceq_u16(vand_u16(h, exp_mask), exp_mask))) {
+			for (unsigned j = 0; j < 4; j++)
+				dst[i + j] = piglit_float_from_half(src[i + j]);
+			continue;
+		}
+
+		vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(h)));
+	}
+#endif
+
+	for (; i < count; i++)
+		dst[i] = piglit_float_from_half(src[i]);
+}
+
+/**
+ * Convert floats to normalized integers of \p type, one of GL_BYTE,
+ * GL_UNSIGNED_BYTE, GL_SHORT and GL_UNSIGNED_SHORT, clamping and
+ * rounding to the nearest value.
+ */
+void
+piglit_float_to_norm_array(void *dst, GLenum type, const float *src,
+			   size_t count)
+{
+	size_t i;
+
+#define TO_UNORM(T, max) do {						\
+		T *d = dst;						\
+		for (i = 0; i < count; i++) {				\
+			const float x = CLAMP(src[i], 0.0f, 1.0f);	\
+			d[i] = (T) (x * (max) + 0.5f);			\
+		}							\
+	} while (0)
+#define TO_SNORM(T, max) do {						\
+		T *d = dst;						\
+		for (i = 0; i < count; i++) {				\
+			const float x = CLAMP(src[i], -1.0f, 1.0f);	\
+			d[i] = (T) (x * (max) + (x < 0 ? -0.5f : 0.5f)); \
+		}							\
+	} while (0)
+
+	switch (type) {
+	case GL_UNSIGNED_BYTE:
+		TO_UNORM(GLubyte, 255.0f);
+		break;
+	case GL_UNSIGNED_SHORT:
+		TO_UNORM(GLushort, 65535.0f);
+		break;
+	case GL_BYTE:
+		TO_SNORM(GLbyte, 127.0f);
+		break;
+	case GL_SHORT:
+		TO_SNORM(GLshort, 32767.0f);
+		break;
+	default:
+		assert(!"unsupported normalized type");
+	}
+
+#undef TO_UNORM
+#undef TO_SNORM
+}
+
+/**
+ * Convert normalized integers of \p type, as in
+ * piglit_float_to_norm_array(), to floats.
+ */
+void
+piglit_norm_to_float_array(float *dst, GLenum type, const void *src,
+			   size_t count)
+{
+	size_t i;
+
+#define FROM_NORM(T, max) do {						\
+		const T *s = src;					\
+		for (i = 0; i < count; i++)				\
+			dst[i] = MAX2(s[i] * (1.0f / (max)), -1.0f);	\
+	} while (0)
+
+	switch (type) {
+	case GL_UNSIGNED_BYTE:
+		FROM_NORM(GLubyte, 255.0f);
+		break;
+	case GL_UNSIGNED_SHORT:
+		FROM_NORM(GLushort, 65535.0f);
+		break;
+	case GL_BYTE:
+		FROM_NORM(GLbyte, 127.0f);
+		break;
+	case GL_SHORT:
+		FROM_NORM(GLshort, 32767.0f);
+		break;
+	default:
+		assert(!"unsupported normalized type");
+	}
+
+#undef FROM_NORM
+}
+
 /**
  * Return block size info for a specific texture compression format.
  * \param  bw returns the block width, in pixels
@@ -664,6 +870,81 @@ required_gl_version_from_glsl_version(unsigned glsl_version)
 	}
 }
 
+void
+piglit_gl_invalidate_program(void)
+{
+	rect_cache.prog = 0;
+}
+
+static bool
+program_has_piglit_vertex(GLuint prog)
+{
+	if (prog != rect_cache.prog) {
+		rect_cache.prog = prog;
+		rect_cache.prog_has_vertex =
+			glGetAttribLocation(prog, "piglit_vertex") != -1;
+	}
+	return rect_cache.prog_has_vertex;
+}
+
+/**
+ * Bind the rect buffer and vertex array, creating them if needed, and
+ * return the offset in the buffer to upload the next rect to.  The
+ * bindings they replace are returned in old_vao and old_buf.
+ *
+ * Each rect goes after the previous one, so uploading it doesn't wait for
+ * the draws of the previous ones.  Once the buffer is full it gets new
+ * storage and the rects start over at its beginning.
+ */
+static GLintptr
+bind_rect_buffer(GLuint *old_vao, GLuint *old_buf)
+{
+	/* Tests may delete every object, or make another context current
+	 * without telling piglit.
+	 */
+	if (rect_cache.buf && (!glIsBuffer(rect_cache.buf) ||
+			       (rect_cache.vao &&
+				!glIsVertexArray(rect_cache.vao))))
+		rect_cache.buf = 0;
+
+	if (rect_cache.buf == 0) {
+		rect_cache.vao = 0;
+
+		/* Vertex array objects were added in both OpenGL 3.0 and
+		 * OpenGL ES 3.0.  The use of VAOs is required in desktop
+		 * OpenGL 3.1 (without GL_ARB_compatibility) and all desktop
+		 * OpenGL core profiles.  If the functionality is supported,
+		 * just use it.
+		 */
+		if (piglit_get_gl_version() >= 30
+		    || piglit_is_extension_supported("GL_OES_vertex_array_object")
+		    || piglit_is_extension_supported("GL_ARB_vertex_array_object")) {
+			glGenVertexArrays(1, &rect_cache.vao);
+		}
+
+		/* Assume that VBOs are supported in any implementation that
+		 * uses shaders.
+		 */
+		glGenBuffers(1, &rect_cache.buf);
+		rect_cache.next = RECT_BUFFER_RECTS;
+	}
+
+	if (rect_cache.vao) {
+		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, (GLint *) old_vao);
+		glBindVertexArray(rect_cache.vao);
+	}
+	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, (GLint *) old_buf);
+	glBindBuffer(GL_ARRAY_BUFFER, rect_cache.buf);
+
+	if (rect_cache.next == RECT_BUFFER_RECTS) {
+		glBufferData(GL_ARRAY_BUFFER, RECT_SIZE * RECT_BUFFER_RECTS,
+			     NULL, GL_STREAM_DRAW);
+		rect_cache.next = 0;
+	}
+
+	return RECT_SIZE * rect_cache.next++;
+}
+
 /**
  * Call glDrawArrays.  verts is expected to be
  *
@@ -684,6 +965,8 @@ piglit_draw_rect_from_arrays(const void *verts, const void *tex,
 	bool gles = piglit_is_gles();
 	int version = piglit_get_gl_version();
 
+	piglit_trace_begin("draw");
+
 	if (gles) {
 		use_fixed_function_attributes = (version < 20);
 	}  else if (version >= 20 ||
@@ -709,7 +992,7 @@ piglit_draw_rect_from_arrays(const void *verts, const void *tex,
 		 * profile.
 		 */
 		use_fixed_function_attributes = ((prog == 0)
-			|| glGetAttribLocation(prog, "piglit_vertex") == -1)
+			|| !program_has_piglit_vertex(prog))
 			&& !piglit_is_core_profile;
 	} else {
 		use_fixed_function_attributes = true;
@@ -748,58 +1031,32 @@ piglit_draw_rect_from_arrays(const void *verts, const void *tex,
 		if (tex)
 			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 	} else {
-		GLuint buf = 0;
+		GLubyte data[RECT_SIZE] = { 0 };
 		GLuint old_buf = 0;
-		GLuint vao = 0;
 		GLuint old_vao = 0;
+		GLintptr offset;
 
-		/* Vertex array objects were added in both OpenGL 3.0 and
-		 * OpenGL ES 3.0.  The use of VAOs is required in desktop
-		 * OpenGL 3.1 (without GL_ARB_compatibility) and all desktop
-		 * OpenGL core profiles.  If the functionality is supported,
-		 * just use it.
-		 */
-		if (piglit_get_gl_version() >= 30
-		    || piglit_is_extension_supported("GL_OES_vertex_array_object")
-		    || piglit_is_extension_supported("GL_ARB_vertex_array_object")) {
-			glGetIntegerv(GL_VERTEX_ARRAY_BINDING,
-				      (GLint *) &old_vao);
-			glGenVertexArrays(1, &vao);
-			glBindVertexArray(vao);
-		}
+		offset = bind_rect_buffer(&old_vao, &old_buf);
 
-		/* Assume that VBOs are supported in any implementation that
-		 * uses shaders.
-		 */
-		glGetIntegerv(GL_ARRAY_BUFFER_BINDING,
-			      (GLint *) &old_buf);
-		glGenBuffers(1, &buf);
-		glBindBuffer(GL_ARRAY_BUFFER, buf);
-		glBufferData(GL_ARRAY_BUFFER,
-			     (sizeof(GLfloat) * 4 * 4)
-			     + (sizeof(GLfloat) * 4 * 2),
-			     NULL,
-			     GL_STATIC_DRAW);
+		/* Upload the rect at once. */
+		if (verts)
+			memcpy(data, verts, RECT_VERTS_SIZE);
+		if (tex)
+			memcpy(data + RECT_VERTS_SIZE, tex,
+			       RECT_SIZE - RECT_VERTS_SIZE);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, RECT_SIZE, data);
 
 		if (verts) {
-			glBufferSubData(GL_ARRAY_BUFFER,
-					0,
-					sizeof(GLfloat) * 4 * 4,
-					verts);
 			glVertexAttribPointer(PIGLIT_ATTRIB_POS, 4, GL_FLOAT,
 					      GL_FALSE, 0,
-					      BUFFER_OFFSET(0));
+					      BUFFER_OFFSET(offset));
 			glEnableVertexAttribArray(PIGLIT_ATTRIB_POS);
 		}
 
 		if (tex) {
-			glBufferSubData(GL_ARRAY_BUFFER,
-					sizeof(GLfloat) * 4 * 4,
-					sizeof(GLfloat) * 4 * 2,
-					tex);
 			glVertexAttribPointer(PIGLIT_ATTRIB_TEX, 2, GL_FLOAT,
 					      GL_FALSE, 0,
-					      BUFFER_OFFSET(sizeof(GLfloat) * 4 * 4));
+					      BUFFER_OFFSET(offset + RECT_VERTS_SIZE));
 			glEnableVertexAttribArray(PIGLIT_ATTRIB_TEX);
 		}
 
@@ -827,13 +1084,12 @@ piglit_draw_rect_from_arrays(const void *verts, const void *tex,
 			glDisableVertexAttribArray(PIGLIT_ATTRIB_TEX);
 
 		glBindBuffer(GL_ARRAY_BUFFER, old_buf);
-		glDeleteBuffers(1, &buf);
 
-		if (vao != 0) {
+		if (rect_cache.vao)
 			glBindVertexArray(old_vao);
-			glDeleteVertexArrays(1, &vao);
-		}
 	}
+
+	piglit_trace_end();
 }
 
 /**
@@ -1074,6 +1330,92 @@ piglit_get_luminance_intensity_bits(GLenum internalformat, int *bits)
 	return false;
 }
 
+/* Scratch memory reused across readbacks instead of a malloc/free pair for
+ * every probe.  One buffer per purpose, as a float probe on GLES needs both
+ * at the same time.
+ */
+struct scratch_buffer {
+	void *data;
+	size_t size;
+};
+
+static struct scratch_buffer scratch_ubyte;
+static struct scratch_buffer scratch_float;
+
+static void *
+scratch_get(struct scratch_buffer *scratch, size_t size)
+{
+	if (size > scratch->size) {
+		free(scratch->data);
+		scratch->data = malloc(size);
+		scratch->size = size;
+	}
+	return scratch->data;
+}
+
+/* RGBA copy of the read framebuffer taken by piglit_probe_batch_begin(). */
+static struct {
+	bool active;
+	GLint x, y;
+	GLsizei width, height;
+	GLfloat *pixels;
+} probe_batch;
+
+static bool
+probe_batch_contains(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	return probe_batch.active &&
+		x >= probe_batch.x && y >= probe_batch.y &&
+		x + width <= probe_batch.x + probe_batch.width &&
+		y + height <= probe_batch.y + probe_batch.height;
+}
+
+/* Copy the first comps channels of a region of the batch snapshot. */
+static void
+probe_batch_read(GLint x, GLint y, GLsizei width, GLsizei height,
+		 int comps, GLfloat *pixels)
+{
+	for (int j = 0; j < height; j++) {
+		const GLfloat *row = probe_batch.pixels +
+			4 * ((y - probe_batch.y + j) * probe_batch.width +
+			     (x - probe_batch.x));
+
+		for (int i = 0; i < width; i++) {
+			for (int c = 0; c < comps; c++)
+				*pixels++ = row[4 * i + c];
+		}
+	}
+}
+
+/**
+ * Read the given region of the read framebuffer once, and serve the probes
+ * that fall inside of it from that copy until piglit_probe_batch_end().
+ *
+ * This is only valid as long as nothing renders to or rebinds the read
+ * framebuffer in the meantime.  Probes outside of the region keep reading
+ * the framebuffer directly.
+ */
+void
+piglit_probe_batch_begin(int x, int y, int w, int h)
+{
+	piglit_probe_batch_end();
+
+	probe_batch.pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
+	probe_batch.x = x;
+	probe_batch.y = y;
+	probe_batch.width = w;
+	probe_batch.height = h;
+	probe_batch.active = true;
+}
+
+void
+piglit_probe_batch_end(void)
+{
+	free(probe_batch.pixels);
+	probe_batch.pixels = NULL;
+	probe_batch.active = false;
+}
+
 /* Wrapper around glReadPixels that always returns floats; reads and converts
  * GL_UNSIGNED_BYTE on GLES.  If pixels == NULL, malloc a float array of the
  * appropriate size, otherwise use the one provided. */
@@ -1088,23 +1430,158 @@ piglit_read_pixels_float(GLint x, GLint y, GLsizei width, GLsizei height,
 	if (!pixels)
 		pixels = malloc(width * height * comps * sizeof(GLfloat));
 
+	if ((format == GL_RED || format == GL_RG ||
+	     format == GL_RGB || format == GL_RGBA) &&
+	    probe_batch_contains(x, y, width, height)) {
+		probe_batch_read(x, y, width, height, comps, pixels);
+		return pixels;
+	}
+
 	if (!piglit_is_gles()) {
+		piglit_trace_begin("readback");
 		glReadPixels(x, y, width, height, format, GL_FLOAT, pixels);
+		piglit_trace_end();
 		return pixels;
 	}
 
-	pixels_b = malloc(width * height * 4 * sizeof(GLubyte));
+	pixels_b = scratch_get(&scratch_ubyte,
+			       width * height * 4 * sizeof(GLubyte));
+	piglit_trace_begin("readback");
 	glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels_b);
+	piglit_trace_end();
 	k = 0;
 	for (i = 0; i < width * height; i++) {
 		for (j = 0; j < comps; j++) {
 			pixels[k++] = pixels_b[i*4+j] / 255.0f;
 		}
 	}
-	free(pixels_b);
 	return pixels;
 }
 
+struct piglit_readback {
+	GLsizei width, height;
+	int comps;
+
+	GLuint pbo;
+	GLsync fence;
+	const GLfloat *map;
+
+	/* Used when PBOs can't be used for the readback. */
+	GLfloat *pixels;
+};
+
+static bool
+can_read_pixels_async(void)
+{
+	static int supported = -1;
+
+	if (supported == -1) {
+		supported = !piglit_is_gles() &&
+			(piglit_get_gl_version() >= 44 ||
+			 (piglit_is_extension_supported("GL_ARB_buffer_storage") &&
+			  piglit_is_extension_supported("GL_ARB_sync")));
+	}
+	return supported;
+}
+
+/**
+ * Queue a readback of the given region as floats, like
+ * piglit_read_pixels_float(), without waiting for rendering to finish.
+ *
+ * On desktop GL with ARB_buffer_storage the pixels are written to a
+ * persistently mapped pixel pack buffer and a fence is inserted, so the
+ * CPU only blocks in piglit_readback_wait().  Elsewhere this falls back to
+ * a synchronous read.
+ */
+struct piglit_readback *
+piglit_read_pixels_float_async(GLint x, GLint y, GLsizei width, GLsizei height,
+			       GLenum format)
+{
+	struct piglit_readback *rb = calloc(1, sizeof(*rb));
+	GLsizeiptr size;
+	GLint prev_pbo;
+
+	rb->width = width;
+	rb->height = height;
+	rb->comps = piglit_num_components(format);
+
+	if (!can_read_pixels_async() ||
+	    probe_batch_contains(x, y, width, height)) {
+		rb->pixels = piglit_read_pixels_float(x, y, width, height,
+						      format, NULL);
+		return rb;
+	}
+
+	size = (GLsizeiptr) width * height * rb->comps * sizeof(GLfloat);
+
+	glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &prev_pbo);
+	glGenBuffers(1, &rb->pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+	glBufferStorage(GL_PIXEL_PACK_BUFFER, size, NULL,
+			GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT |
+			GL_MAP_COHERENT_BIT | GL_CLIENT_STORAGE_BIT);
+	rb->map = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size,
+				   GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT |
+				   GL_MAP_COHERENT_BIT);
+	glReadPixels(x, y, width, height, format, GL_FLOAT, NULL);
+	rb->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, prev_pbo);
+
+	return rb;
+}
+
+/**
+ * Wait for a readback queued by piglit_read_pixels_float_async() and return
+ * its pixels.  The returned memory is owned by \p rb and stays valid until
+ * piglit_readback_destroy().
+ */
+const GLfloat *
+piglit_readback_wait(struct piglit_readback *rb)
+{
+	if (rb->fence) {
+		GLenum status;
+
+		do {
+			status = glClientWaitSync(rb->fence,
+						  GL_SYNC_FLUSH_COMMANDS_BIT,
+						  1000000000);
+		} while (status == GL_TIMEOUT_EXPIRED);
+
+		glDeleteSync(rb->fence);
+		rb->fence = NULL;
+
+		if (status == GL_WAIT_FAILED) {
+			fprintf(stderr, "Waiting for a readback failed\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	}
+
+	return rb->pbo ? rb->map : rb->pixels;
+}
+
+void
+piglit_readback_destroy(struct piglit_readback *rb)
+{
+	if (!rb)
+		return;
+
+	if (rb->fence)
+		glDeleteSync(rb->fence);
+
+	if (rb->pbo) {
+		GLint prev_pbo;
+
+		glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &prev_pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, prev_pbo);
+		glDeleteBuffers(1, &rb->pbo);
+	}
+
+	free(rb->pixels);
+	free(rb);
+}
+
 static bool
 can_probe_ubyte()
 {
@@ -1195,6 +1672,271 @@ piglit_compare_pixels_float(const float *color1, const float *color2,
 	return true;
 }
 
+/**
+ * Whether any of the 4 * nvec floats of a and b differ by more than the
+ * matching element of tolerance.
+ */
+static inline bool
+block_differs_float(const float *a, const float *b, const float *tolerance,
+		    int nvec)
+{
+#if defined(PIGLIT_COMPARE_SSE2)
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	__m128 over = _mm_setzero_ps();
+
+	for (int v = 0; v < nvec; v++) {
+		__m128 diff = _mm_sub_ps(_mm_loadu_ps(a + 4 * v),
+					 _mm_loadu_ps(b + 4 * v));
+		over = _mm_or_ps(over,
+				 _mm_cmpgt_ps(_mm_and_ps(diff, abs_mask),
+					      _mm_loadu_ps(tolerance + 4 * v)));
+	}
+	return _mm_movemask_ps(over) != 0;
+#elif defined(PIGLIT_COMPARE_NEON)
+	uint32x4_t over = vdupq_n_u32(0);
+
+	for (int v = 0; v < nvec; v++) {
+		float32x4_t diff = vabdq_f32(vld1q_f32(a + 4 * v),
+					     vld1q_f32(b + 4 * v));
+		over = vorrq_u32(over,
+				 vcgtq_f32(diff, vld1q_f32(tolerance + 4 * v)));
+	}
+	return vmaxvq_u32(over) != 0;
+#else
+	bool over = false;
+
+	for (int i = 0; i < 4 * nvec; i++)
+		over |= fabsf(a[i] - b[i]) > tolerance[i];
+	return over;
+#endif
+}
+
+/**
+ * Compare a span of \p count pixels with piglit_compare_pixels_float().
+ *
+ * Pixel i of the span is read at observed[i * observed_stride] and
+ * expected[i * expected_stride]; an expected_stride of 0 compares every
+ * pixel against the same color.  Spans of up to 4 floats per pixel are
+ * compared 4 pixels at a time with SIMD where available.
+ *
+ * \param mismatch_count  if not NULL, receives the number of mismatching
+ *                        pixels.  If NULL, stop at the first mismatch.
+ * \return the index of the first mismatching pixel, or -1.
+ */
+int
+piglit_compare_pixel_span_float(const float *observed, size_t observed_stride,
+				const float *expected, size_t expected_stride,
+				const float *tolerance, int num_components,
+				int count, int *mismatch_count)
+{
+	const size_t stride = observed_stride;
+	int first = -1, mismatches = 0, i = 0;
+
+	if (stride >= 1 && stride <= 4 && stride >= num_components &&
+	    (expected_stride == 0 || expected_stride == stride)) {
+		/* Tolerance and constant color tiled over 4 pixels, ignored
+		 * components padded so that they never mismatch.
+		 */
+		float tol[16], color[16];
+
+		for (int k = 0; k < 4 * stride; k++) {
+			const int c = k % stride;
+
+			tol[k] = c < num_components ? tolerance[c] : INFINITY;
+			color[k] = c < num_components && expected_stride == 0 ?
+				expected[c] : 0.0f;
+		}
+
+		for (; i + 4 <= count; i += 4) {
+			const float *e = expected_stride ?
+				expected + i * stride : color;
+
+			if (!block_differs_float(observed + i * stride, e, tol,
+						 stride))
+				continue;
+
+			for (int p = i; p < i + 4; p++) {
+				if (piglit_compare_pixels_float(
+					    observed + p * stride,
+					    expected + p * expected_stride,
+					    tolerance, num_components))
+					continue;
+
+				if (first < 0)
+					first = p;
+				mismatches++;
+			}
+
+			if (first >= 0 && !mismatch_count)
+				return first;
+		}
+	}
+
+	for (; i < count; i++) {
+		if (piglit_compare_pixels_float(observed + i * observed_stride,
+						expected + i * expected_stride,
+						tolerance, num_components))
+			continue;
+
+		if (first < 0)
+			first = i;
+		mismatches++;
+
+		if (!mismatch_count)
+			return first;
+	}
+
+	if (mismatch_count)
+		*mismatch_count = mismatches;
+	return first;
+}
+
+/**
+ * Whether any of the 4 RGBA pixels at a differ from the tiled color by
+ * more than the tiled tolerance.
+ */
+static inline bool
+block_differs_ubyte(const GLubyte *a, const GLubyte *color,
+		    const GLubyte *tolerance)
+{
+#if defined(PIGLIT_COMPARE_SSE2)
+	const __m128i va = _mm_loadu_si128((const __m128i *) a);
+	const __m128i vc = _mm_loadu_si128((const __m128i *) color);
+	const __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vc),
+					  _mm_subs_epu8(vc, va));
+	const __m128i over =
+		_mm_subs_epu8(diff,
+			      _mm_loadu_si128((const __m128i *) tolerance));
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(over,
+						_mm_setzero_si128())) != 0xffff;
+#elif defined(PIGLIT_COMPARE_NEON)
+	const uint8x16_t diff = vabdq_u8(vld1q_u8(a), vld1q_u8(color));
+
+	return vmaxvq_u8(vcgtq_u8(diff, vld1q_u8(tolerance))) != 0;
+#else
+	bool over = false;
+
+	for (int i = 0; i < 16; i++)
+		over |= abs((int)a[i] - (int)color[i]) > tolerance[i];
+	return over;
+#endif
+}
+
+/**
+ * Like piglit_compare_pixel_span_float() for a span of RGBA ubyte pixels
+ * compared against a single color.
+ */
+static int
+compare_pixel_span_ubyte(const GLubyte *observed, const GLubyte *expected,
+			 const GLubyte *tolerance, int num_components,
+			 int count, int *mismatch_count)
+{
+	GLubyte tol[16], color[16];
+	int first = -1, mismatches = 0, i = 0;
+
+	for (int k = 0; k < 16; k++) {
+		const int c = k % 4;
+
+		tol[k] = c < num_components ? tolerance[c] : 255;
+		color[k] = c < num_components ? expected[c] : 0;
+	}
+
+	for (; i + 4 <= count; i += 4) {
+		if (!block_differs_ubyte(observed + i * 4, color, tol))
+			continue;
+
+		for (int p = i; p < i + 4; p++) {
+			if (compare_pixels_ubyte(observed + p * 4, expected,
+						 tolerance, num_components))
+				continue;
+
+			if (first < 0)
+				first = p;
+			mismatches++;
+		}
+
+		if (first >= 0 && !mismatch_count)
+			return first;
+	}
+
+	for (; i < count; i++) {
+		if (compare_pixels_ubyte(observed + i * 4, expected,
+					 tolerance, num_components))
+			continue;
+
+		if (first < 0)
+			first = i;
+		mismatches++;
+
+		if (!mismatch_count)
+			return first;
+	}
+
+	if (mismatch_count)
+		*mismatch_count = mismatches;
+	return first;
+}
+
+/**
+ * How many mismatching pixels the probes print before they stop, from
+ * PIGLIT_PROBE_FAILURES. With "all" they print the first one and count
+ * all of them instead.
+ */
+static int probe_failure_limit;
+static bool probe_count_all;
+
+static void
+probe_failures_init(void)
+{
+	static bool initialized = false;
+	const char *env;
+
+	if (initialized)
+		return;
+	initialized = true;
+
+	probe_failure_limit = 1;
+	env = getenv("PIGLIT_PROBE_FAILURES");
+	if (env == NULL)
+		return;
+
+	if (!strcmp(env, "all")) {
+		probe_count_all = true;
+		probe_failure_limit = INT_MAX;
+	} else if (atoi(env) > 0) {
+		probe_failure_limit = atoi(env);
+	}
+}
+
+/** Whether a probe prints the mismatching pixel after \p failures others. */
+static bool
+probe_prints_failure(int failures)
+{
+	probe_failures_init();
+	return probe_count_all ? failures == 0 : failures < probe_failure_limit;
+}
+
+/** Whether a probe that found \p failures mismatching pixels stops. */
+static bool
+probe_stops(int failures)
+{
+	probe_failures_init();
+	return failures >= probe_failure_limit;
+}
+
+/** Print how many of the \p pixels of a probe mismatched. */
+static void
+probe_report_failures(int failures, int pixels)
+{
+	probe_failures_init();
+	if (probe_count_all && failures > 0)
+		printf("  %d of %d pixels mismatched\n", failures, pixels);
+	else if (probe_failure_limit > 1 && failures >= probe_failure_limit)
+		printf("  Stopped after %d mismatched pixels of %d\n",
+		       failures, pixels);
+}
+
 int
 piglit_probe_pixel_rgb_silent(int x, int y, const float* expected, float *out_probe)
 {
@@ -1294,20 +2036,67 @@ probe_rect_ubyte(int x, int y, int w, int h, int num_components,
 		 const float *fexpected, size_t x_pitch, size_t y_pitch,
 		 bool silent)
 {
-	int i, j;
+	int i, j, failures = 0;
 	GLubyte *probe;
 	GLubyte *pixels;
 	GLubyte tolerance[4];
 	GLubyte expected[4];
 
+	probe_failures_init();
 	array_float_to_ubyte_roundup(num_components, piglit_tolerance,
 				     tolerance);
 	if (x_pitch == 0 && y_pitch == 0)
 		array_float_to_ubyte(num_components, fexpected, expected);
 
 	/* RGBA readbacks are likely to be faster */
-	pixels = malloc(w*h*4);
-	glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	pixels = scratch_get(&scratch_ubyte, w*h*4);
+	if (probe_batch_contains(x, y, w, h)) {
+		/* The snapshot holds unorm8 values converted to float,
+		 * rounding gives back the exact bytes.
+		 */
+		for (j = 0; j < h; j++) {
+			const GLfloat *row = probe_batch.pixels +
+				4 * ((y - probe_batch.y + j) * probe_batch.width +
+				     (x - probe_batch.x));
+
+			for (i = 0; i < w * 4; i++)
+				pixels[j * w * 4 + i] = row[i] * 255.0f + 0.5f;
+		}
+	} else {
+		piglit_trace_begin("readback");
+		glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		piglit_trace_end();
+	}
+
+	if (x_pitch == 0 && y_pitch == 0) {
+		for (j = 0; j < h && !probe_stops(failures); j++) {
+			i = 0;
+			while (i < w && !probe_stops(failures)) {
+				int mismatches = 1;
+				int k = compare_pixel_span_ubyte(
+					&pixels[(j*w+i)*4], expected,
+					tolerance, num_components, w - i,
+					probe_count_all && !silent ?
+					&mismatches : NULL);
+				if (k < 0)
+					break;
+				i += k;
+
+				if (silent)
+					return false;
+				if (probe_prints_failure(failures)) {
+					print_bad_pixel_ubyte(
+						x + i, y + j, num_components,
+						expected, &pixels[(j*w+i)*4]);
+				}
+				failures += mismatches;
+				i = probe_count_all ? w : i + 1;
+			}
+		}
+
+		probe_report_failures(failures, w * h);
+		return failures == 0;
+	}
 
 	for (j = 0; j < h; j++) {
 		for (i = 0; i < w; i++) {
@@ -1324,18 +2113,21 @@ probe_rect_ubyte(int x, int y, int w, int h, int num_components,
 						 num_components))
 				continue;
 
-			if (!silent) {
+			if (silent)
+				return false;
+			if (probe_prints_failure(failures)) {
 				print_bad_pixel_ubyte(
 					x + i, y + j, num_components,
 					expected, probe);
 			}
-			free(pixels);
-			return false;
+			if (probe_stops(++failures))
+				goto done;
 		}
 	}
 
-	free(pixels);
-	return true;
+done:
+	probe_report_failures(failures, w * h);
+	return failures == 0;
 }
 
 static bool
@@ -1343,31 +2135,42 @@ probe_rect_float(int x, int y, int w, int h, int num_components,
 		 const float *fexpected, size_t x_pitch, size_t y_pitch,
 		 bool silent)
 {
-	float *pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
-
-	for (int j = 0; j < h; j++) {
-		for (int i = 0; i < w; i++) {
-			float *probe = &pixels[(j*w+i)*4];
-			const float *pexp = fexpected + i * x_pitch +
-							j * y_pitch;
-
-			if (piglit_compare_pixels_float(probe, pexp,
-						 piglit_tolerance,
-						 num_components))
-				continue;
+	float *pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA,
+			scratch_get(&scratch_float, w * h * 4 * sizeof(float)));
+	int failures = 0;
+
+	probe_failures_init();
+	for (int j = 0; j < h && !probe_stops(failures); j++) {
+		int i = 0;
+
+		while (i < w && !probe_stops(failures)) {
+			const float *expected = fexpected + j * y_pitch +
+				i * x_pitch;
+			int mismatches = 1;
+			int k = piglit_compare_pixel_span_float(
+				&pixels[(j*w+i)*4], 4, expected, x_pitch,
+				piglit_tolerance, num_components, w - i,
+				probe_count_all && !silent ?
+				&mismatches : NULL);
+			if (k < 0)
+				break;
+			i += k;
 
-			if (!silent) {
+			if (silent)
+				return false;
+			if (probe_prints_failure(failures)) {
 				print_bad_pixel_float(x + i, y + j,
 						      num_components,
-						      fexpected, probe);
+						      expected + k * x_pitch,
+						      &pixels[(j*w+i)*4]);
 			}
-			free(pixels);
-			return false;
+			failures += mismatches;
+			i = probe_count_all ? w : i + 1;
 		}
 	}
 
-	free(pixels);
-	return true;
+	probe_report_failures(failures, w * h);
+	return failures == 0;
 }
 
 static bool
@@ -1395,7 +2198,7 @@ piglit_probe_rect_rgb_silent(int x, int y, int w, int h, const float *expected)
 int
 piglit_probe_rect_r_ubyte(int x, int y, int w, int h, GLubyte expected)
 {
-	int i, j, w_aligned;
+	int i, j, w_aligned, failures = 0;
 	GLubyte *pixels;
 	GLubyte tolerance = ceil(piglit_tolerance[0] * 255);
 
@@ -1408,18 +2211,21 @@ piglit_probe_rect_r_ubyte(int x, int y, int w, int h, GLubyte expected)
 		for (i = 0; i < w; i++) {
 			GLubyte probe = pixels[j*w_aligned+i];
 
-			if (abs((int)probe - (int)expected) >= tolerance) {
+			if (abs((int)probe - (int)expected) < tolerance)
+				continue;
+
+			if (probe_prints_failure(failures))
 				print_bad_pixel_ubyte(x + i, y + j, 1,
 						      &expected, &probe);
-
-				free(pixels);
-				return 0;
-			}
+			if (probe_stops(++failures))
+				goto done;
 		}
 	}
 
+done:
+	probe_report_failures(failures, w * h);
 	free(pixels);
-	return 1;
+	return failures == 0;
 }
 
 int
@@ -1467,7 +2273,7 @@ piglit_probe_rects_equal(int x1, int y1, int x2, int y2,
 int
 piglit_probe_rect_halves_equal_rgba(int x, int y, int w, int h)
 {
-	int i, j, p;
+	int i, j, p, failures = 0;
 	GLfloat probe1[4];
 	GLfloat probe2[4];
 	GLubyte *pixels = malloc(w*h*4*sizeof(GLubyte));
@@ -1488,19 +2294,24 @@ piglit_probe_rect_halves_equal_rgba(int x, int y, int w, int h)
 						 piglit_tolerance, 4))
 				continue;
 
-			printf("Probe color at (%i,%i)\n", x+i, x+j);
-			printf("  Left: %f %f %f %f\n",
-			       probe1[0], probe1[1], probe1[2], probe1[3]);
-			printf("  Right: %f %f %f %f\n",
-			       probe2[0], probe2[1], probe2[2], probe2[3]);
-
-			free(pixels);
-			return 0;
+			if (probe_prints_failure(failures)) {
+				printf("Probe color at (%i,%i)\n", x+i, x+j);
+				printf("  Left: %f %f %f %f\n",
+				       probe1[0], probe1[1], probe1[2],
+				       probe1[3]);
+				printf("  Right: %f %f %f %f\n",
+				       probe2[0], probe2[1], probe2[2],
+				       probe2[3]);
+			}
+			if (probe_stops(++failures))
+				goto done;
 		}
 	}
 
+done:
+	probe_report_failures(failures, w / 2 * h);
 	free(pixels);
-	return 1;
+	return failures == 0;
 }
 
 int
@@ -1528,7 +2339,7 @@ int piglit_probe_rect_rgba_varying(int x, int y, int w, int h,
 int
 piglit_probe_rect_rgba_int(int x, int y, int w, int h, const int *expected)
 {
-	int i, j, p;
+	int i, j, p, failures = 0;
 	GLint *probe;
 	GLint *pixels = malloc(w*h*4*sizeof(int));
 
@@ -1539,29 +2350,35 @@ piglit_probe_rect_rgba_int(int x, int y, int w, int h, const int *expected)
 			probe = &pixels[(j*w+i)*4];
 
 			for (p = 0; p < 4; ++p) {
-				if (probe[p] != expected[p]) {
-					printf("Probe color at (%d,%d)\n", x+i, y+j);
-					printf("  Expected: %d %d %d %d\n",
-					       expected[0], expected[1], expected[2], expected[3]);
-					printf("  Observed: %d %d %d %d\n",
-					       probe[0], probe[1], probe[2], probe[3]);
-
-					free(pixels);
-					return 0;
-				}
+				if (probe[p] != expected[p])
+					break;
+			}
+			if (p == 4)
+				continue;
+
+			if (probe_prints_failure(failures)) {
+				printf("Probe color at (%d,%d)\n", x+i, y+j);
+				printf("  Expected: %d %d %d %d\n",
+				       expected[0], expected[1], expected[2], expected[3]);
+				printf("  Observed: %d %d %d %d\n",
+				       probe[0], probe[1], probe[2], probe[3]);
 			}
+			if (probe_stops(++failures))
+				goto done;
 		}
 	}
 
+done:
+	probe_report_failures(failures, w * h);
 	free(pixels);
-	return 1;
+	return failures == 0;
 }
 
 int
 piglit_probe_rect_rgba_uint(int x, int y, int w, int h,
 			    const unsigned int *expected)
 {
-	int i, j, p;
+	int i, j, p, failures = 0;
 	GLuint *probe;
 	GLuint *pixels = malloc(w*h*4*sizeof(unsigned int));
 
@@ -1572,22 +2389,28 @@ piglit_probe_rect_rgba_uint(int x, int y, int w, int h,
 			probe = &pixels[(j*w+i)*4];
 
 			for (p = 0; p < 4; ++p) {
-				if (probe[p] != expected[p]) {
-					printf("Probe color at (%d,%d)\n", x+i, y+j);
-					printf("  Expected: %u %u %u %u\n",
-					       expected[0], expected[1], expected[2], expected[3]);
-					printf("  Observed: %u %u %u %u\n",
-					       probe[0], probe[1], probe[2], probe[3]);
-
-					free(pixels);
-					return 0;
-				}
+				if (probe[p] != expected[p])
+					break;
+			}
+			if (p == 4)
+				continue;
+
+			if (probe_prints_failure(failures)) {
+				printf("Probe color at (%d,%d)\n", x+i, y+j);
+				printf("  Expected: %u %u %u %u\n",
+				       expected[0], expected[1], expected[2], expected[3]);
+				printf("  Observed: %u %u %u %u\n",
+				       probe[0], probe[1], probe[2], probe[3]);
 			}
+			if (probe_stops(++failures))
+				goto done;
 		}
 	}
 
+done:
+	probe_report_failures(failures, w * h);
 	free(pixels);
-	return 1;
+	return failures == 0;
 }
 
 /**
@@ -1603,6 +2426,7 @@ piglit_probe_rect_two_rgb(int x, int y, int w, int h,
 {
 	/* RGBA readbacks are likely to be faster */
 	float *pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
+	int failures = 0;
 
 	for (int j = 0; j < h; j++) {
 		for (int i = 0; i < w; i++) {
@@ -1614,22 +2438,25 @@ piglit_probe_rect_two_rgb(int x, int y, int w, int h,
 						 piglit_tolerance, 3))
 				continue;
 
-			printf("Probe color at (%i,%i)\n", x + i, y + j);
-			printf("  Expected either:");
-			print_components_float(expected1, 3);
-			printf("\n  or:");
-			print_components_float(expected2, 3);
-			printf("\n  Observed:");
-			print_components_float(probe, 3);
-			printf("\n");
-
-			free(pixels);
-			return false;
+			if (probe_prints_failure(failures)) {
+				printf("Probe color at (%i,%i)\n", x + i, y + j);
+				printf("  Expected either:");
+				print_components_float(expected1, 3);
+				printf("\n  or:");
+				print_components_float(expected2, 3);
+				printf("\n  Observed:");
+				print_components_float(probe, 3);
+				printf("\n");
+			}
+			if (probe_stops(++failures))
+				goto done;
 		}
 	}
 
+done:
+	probe_report_failures(failures, w * h);
 	free(pixels);
-	return true;
+	return failures == 0;
 }
 
 /**
@@ -1706,32 +2533,46 @@ piglit_compare_images_color(int x, int y, int w, int h, int num_components,
 			    const float *expected_image,
 			    const float *observed_image)
 {
-	int i, j;
-	for (j = 0; j < h; j++) {
-		for (i = 0; i < w; i++) {
+	int failures = 0;
+
+	probe_failures_init();
+	for (int j = 0; j < h && !probe_stops(failures); j++) {
+		const size_t row = ((j + y) * w + x) * num_components;
+		int i = 0;
+
+		while (i < w && !probe_stops(failures)) {
+			int mismatches = 1;
+			int k = piglit_compare_pixel_span_float(
+				&observed_image[row + i * num_components],
+				num_components,
+				&expected_image[row + i * num_components],
+				num_components, tolerance, num_components,
+				w - i, probe_count_all ? &mismatches : NULL);
+			if (k < 0)
+				break;
+			i += k;
+
 			const float *expected =
-				&expected_image[((j + y) * w + i + x) *
-						num_components];
+				&expected_image[row + i * num_components];
 			const float *probe =
-				&observed_image[((j + y) * w + i + x) *
-						num_components];
-
-			if (piglit_compare_pixels_float(probe, expected, tolerance,
-						 num_components))
-				continue;
-
-			printf("Probe at (%i,%i)\n", x+i, y+j);
-			printf("  Expected:");
-			print_components_float(expected, num_components);
-			printf("\n  Observed:");
-			print_components_float(probe, num_components);
-			printf("\n");
+				&observed_image[row + i * num_components];
 
-			return 0;
+			if (probe_prints_failure(failures)) {
+				printf("Probe at (%i,%i)\n", x+i, y+j);
+				printf("  Expected:");
+				print_components_float(expected,
+						       num_components);
+				printf("\n  Observed:");
+				print_components_float(probe, num_components);
+				printf("\n");
+			}
+			failures += mismatches;
+			i = probe_count_all ? w : i + 1;
 		}
 	}
 
-	return 1;
+	probe_report_failures(failures, w * h);
+	return failures == 0;
 }
 
 /**
@@ -1739,6 +2580,168 @@ piglit_compare_images_color(int x, int y, int w, int h, int num_components,
  * framebuffer with the given in-memory floating-point image of
  * dimensions w*h.
  */
+/* Smaller images are cheaper to compare on the CPU. */
+#define GPU_COMPARE_MIN_PIXELS (128 * 128)
+#define GPU_COMPARE_GROUP_SIZE 64
+
+static const char gpu_compare_source[] =
+	"#version 430\n"
+	"layout(local_size_x = 64) in;\n"
+	"layout(std430, binding = 0) readonly buffer observed_buf {\n"
+	"	float observed[];\n"
+	"};\n"
+	"layout(std430, binding = 1) readonly buffer expected_buf {\n"
+	"	float expected[];\n"
+	"};\n"
+	"layout(std430, binding = 2) buffer result_buf {\n"
+	"	uint mismatches;\n"
+	"	uint first_mismatch;\n"
+	"};\n"
+	"layout(location = 0) uniform uint num_pixels;\n"
+	"layout(location = 1) uniform int num_components;\n"
+	"layout(location = 2) uniform vec4 tolerance;\n"
+	"void main()\n"
+	"{\n"
+	"	uint i = gl_GlobalInvocationID.x;\n"
+	"	bool bad = false;\n"
+	"	if (i >= num_pixels)\n"
+	"		return;\n"
+	"	for (int c = 0; c < num_components; c++) {\n"
+	"		uint k = i * uint(num_components) + uint(c);\n"
+	"		if (abs(observed[k] - expected[k]) > tolerance[c])\n"
+	"			bad = true;\n"
+	"	}\n"
+	"	if (bad) {\n"
+	"		atomicAdd(mismatches, 1u);\n"
+	"		atomicMin(first_mismatch, i);\n"
+	"	}\n"
+	"}\n";
+
+static GLuint
+gpu_compare_program(void)
+{
+	static GLuint prog;
+	static bool unavailable;
+	GLuint cs;
+
+	if (unavailable)
+		return 0;
+
+	/* The context may have been recreated since the last call. */
+	if (prog && glIsProgram(prog))
+		return prog;
+
+	if (piglit_is_gles() || piglit_get_gl_version() < 43 ||
+	    !piglit_env_var_as_boolean("PIGLIT_GPU_IMAGE_COMPARE", true)) {
+		unavailable = true;
+		return 0;
+	}
+
+	cs = piglit_compile_shader_text_nothrow(GL_COMPUTE_SHADER,
+						gpu_compare_source, false);
+	if (!cs) {
+		unavailable = true;
+		return 0;
+	}
+
+	prog = glCreateProgram();
+	glAttachShader(prog, cs);
+	glLinkProgram(prog);
+	glDeleteShader(cs);
+
+	if (!piglit_link_check_status_quiet(prog)) {
+		glDeleteProgram(prog);
+		prog = 0;
+		unavailable = true;
+	}
+
+	return prog;
+}
+
+/**
+ * Compare the read framebuffer against a float image without reading it
+ * back: the pixels are packed into a buffer object and compared by a
+ * compute shader, and only the mismatch count is returned to the CPU.
+ *
+ * \return true if every pixel matched, false if some did not or if the
+ * comparison could not be done on the GPU.  The caller should then do the
+ * regular CPU comparison, which also prints the diagnostics.
+ */
+static bool
+gpu_probe_image_color(int x, int y, int w, int h, GLenum format, int c,
+		      const float *tolerance, const float *image)
+{
+	const GLuint num_pixels = w * h;
+	const GLuint num_groups = (num_pixels + GPU_COMPARE_GROUP_SIZE - 1) /
+		GPU_COMPARE_GROUP_SIZE;
+	const GLsizeiptr size = (GLsizeiptr) num_pixels * c * sizeof(float);
+	const GLuint result_init[2] = { 0, ~0u };
+	GLuint result[2];
+	GLuint prog, bufs[3];
+	GLint prev_prog, prev_pack;
+	GLint prev_ssbo[3];
+	GLint64 prev_start[3], prev_size[3];
+	float tol[4] = { 0 };
+
+	if (num_pixels < GPU_COMPARE_MIN_PIXELS || num_groups > 65535)
+		return false;
+
+	prog = gpu_compare_program();
+	if (!prog)
+		return false;
+
+	memcpy(tol, tolerance, c * sizeof(float));
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &prev_prog);
+	glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &prev_pack);
+	for (int i = 0; i < 3; i++) {
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, i,
+				&prev_ssbo[i]);
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, i,
+				  &prev_start[i]);
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, i,
+				  &prev_size[i]);
+	}
+
+	glGenBuffers(3, bufs);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, bufs[0]);
+	glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_COPY);
+	glReadPixels(x, y, w, h, format, GL_FLOAT, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, prev_pack);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, bufs[0]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, bufs[1]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, image, GL_STREAM_DRAW);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, bufs[2]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(result_init),
+		     result_init, GL_STREAM_READ);
+
+	glUseProgram(prog);
+	glUniform1ui(0, num_pixels);
+	glUniform1i(1, c);
+	glUniform4fv(2, 1, tol);
+	glDispatchCompute(num_groups, 1, 1);
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(result),
+			   result);
+
+	glUseProgram(prev_prog);
+	for (int i = 0; i < 3; i++) {
+		if (prev_size[i])
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, i,
+					  prev_ssbo[i], prev_start[i],
+					  prev_size[i]);
+		else
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i,
+					 prev_ssbo[i]);
+	}
+	glDeleteBuffers(3, bufs);
+
+	return result[0] == 0;
+}
+
 int
 piglit_probe_image_color(int x, int y, int w, int h, GLenum format,
 			 const float *image)
@@ -1757,6 +2760,9 @@ piglit_probe_image_color(int x, int y, int w, int h, GLenum format,
 		format = GL_LUMINANCE;
 	}
 
+	if (gpu_probe_image_color(x, y, w, h, format, c, tolerance, image))
+		return 1;
+
 	pixels = piglit_read_pixels_float(x, y, w, h, format, NULL);
 
 	result = piglit_compare_images_color(0, 0, w, h, c, tolerance, image,
@@ -1786,23 +2792,28 @@ piglit_compare_images_ubyte(int x, int y, int w, int h,
 			    const GLubyte *expected_image,
 			    const GLubyte *observed_image)
 {
-	int i, j;
+	int i, j, failures = 0;
 	for (j = 0; j < h; j++) {
 		for (i = 0; i < w; i++) {
 			const GLubyte expected = expected_image[j*w+i];
 			const GLubyte probe = observed_image[j*w+i];
 
-			if (probe != expected) {
+			if (probe == expected)
+				continue;
+
+			if (probe_prints_failure(failures)) {
 				printf("Probe at (%i,%i)\n", x+i, y+j);
 				printf("  Expected: %d\n", expected);
 				printf("  Observed: %d\n", probe);
-
-				return 0;
 			}
+			if (probe_stops(++failures))
+				goto done;
 		}
 	}
 
-	return 1;
+done:
+	probe_report_failures(failures, w * h);
+	return failures == 0;
 }
 
 /**
@@ -1904,7 +2915,9 @@ piglit_probe_image_ubyte(int x, int y, int w, int h, GLenum format,
 
 	array_float_to_ubyte_roundup(4, piglit_tolerance, tolerance);
 
+	piglit_trace_begin("readback");
 	glReadPixels(x, y, w, h, format, GL_UNSIGNED_BYTE, pixels);
+	piglit_trace_end();
 
 	for (j = 0; j < h; j++) {
 		for (i = 0; i < w; i++) {
@@ -2105,7 +3118,7 @@ int piglit_probe_texel_rect_rgba(int target, int level, int x, int y,
 {
 	GLfloat *buffer;
 	GLfloat *probe;
-	int i, j;
+	int i, j, failures = 0;
 	GLint width;
 	GLint height;
 
@@ -2136,17 +3149,19 @@ int piglit_probe_texel_rect_rgba(int target, int level, int x, int y,
 						 piglit_tolerance, 4))
 				continue;
 
-			print_bad_pixel_float(i, j, 4,
-					      expected,
-					      probe);
-
-			free(buffer);
-			return 0;
+			if (probe_prints_failure(failures))
+				print_bad_pixel_float(i, j, 4,
+						      expected,
+						      probe);
+			if (probe_stops(++failures))
+				goto done;
 		}
 	}
 
+done:
+	probe_report_failures(failures, w * h);
 	free(buffer);
-	return 1;
+	return failures == 0;
 }
 
 /**
@@ -2175,7 +3190,7 @@ int piglit_probe_texel_volume_rgba(int target, int level, int x, int y, int z,
 {
 	GLfloat *buffer;
 	GLfloat *probe;
-	int i, j, k;
+	int i, j, k, failures = 0;
 	GLint width;
 	GLint height;
 	GLint depth;
@@ -2211,22 +3226,25 @@ int piglit_probe_texel_volume_rgba(int target, int level, int x, int y, int z,
 							 piglit_tolerance, 4))
 					continue;
 
-				printf("Probe color at (%i,%i,%i)\n",
-				       i, j, k);
-				printf("  Expected: ");
-				print_components_float(expected, 4);
-				printf("\n  Observed: ");
-				print_components_float(probe, 4);
-				printf("\n");
-
-				free(buffer);
-				return 0;
+				if (probe_prints_failure(failures)) {
+					printf("Probe color at (%i,%i,%i)\n",
+					       i, j, k);
+					printf("  Expected: ");
+					print_components_float(expected, 4);
+					printf("\n  Observed: ");
+					print_components_float(probe, 4);
+					printf("\n");
+				}
+				if (probe_stops(++failures))
+					goto done;
 			}
 		}
 	}
 
+done:
+	probe_report_failures(failures, w * h * d);
 	free(buffer);
-	return 1;
+	return failures == 0;
 }
 
 /**
@@ -2474,6 +3492,147 @@ piglit_draw_triangle_z(float z, float x1, float y1, float x2, float y2,
 	glDisableClientState(GL_VERTEX_ARRAY);
 }
 
+/**
+ * Fill \p count texels of \p texel_size bytes with copies of \p texel,
+ * doubling the filled part with each memcpy.
+ */
+static void
+fill_texels(void *dst, const void *texel, size_t texel_size, size_t count)
+{
+	char *d = dst;
+	size_t filled = 1;
+
+	if (count == 0)
+		return;
+
+	memcpy(d, texel, texel_size);
+	while (filled < count) {
+		size_t n = MIN2(filled, count - filled);
+
+		memcpy(d + filled * texel_size, d, n * texel_size);
+		filled += n;
+	}
+}
+
+/**
+ * Description of the images made by the texture helpers, either
+ * quadrants or a checkerboard of tiles, in four texel values.  It is also
+ * the key of the image cache, so unused bytes must be zero.
+ */
+struct pattern_image {
+	/** Tile size, or 0 to split the image in four quadrants. */
+	unsigned tile_w, tile_h;
+	unsigned w, h;
+	unsigned texel_size;
+	/** Bottom-left, bottom-right, top-left and top-right texels. */
+	uint8_t texels[4][16];
+};
+
+static void
+fill_pattern_row(char *row, const struct pattern_image *key,
+		 const void *left, const void *right)
+{
+	const size_t ts = key->texel_size;
+	unsigned x;
+
+	if (key->tile_w == 0) {
+		fill_texels(row, left, ts, key->w / 2);
+		fill_texels(row + key->w / 2 * ts, right, ts,
+			    key->w - key->w / 2);
+		return;
+	}
+
+	for (x = 0; x < key->w; x += key->tile_w) {
+		fill_texels(row + x * ts, (x / key->tile_w) & 1 ? right : left,
+			    ts, MIN2(key->tile_w, key->w - x));
+	}
+}
+
+static void
+fill_pattern_image(char *data, const struct pattern_image *key)
+{
+	const size_t stride = (size_t) key->w * key->texel_size;
+	/* The first row of the top half, or of the second row of tiles. */
+	const unsigned top = key->tile_h ? key->tile_h : key->h / 2;
+	unsigned y;
+
+	fill_pattern_row(data, key, key->texels[0], key->texels[1]);
+	if (top < key->h)
+		fill_pattern_row(data + top * stride, key,
+				 key->texels[2], key->texels[3]);
+
+	for (y = 1; y < key->h; y++) {
+		bool is_top = key->tile_h ? (y / key->tile_h) & 1 : y >= top;
+
+		if (y != top)
+			memcpy(data + y * stride,
+			       data + (is_top ? top : 0) * stride, stride);
+	}
+}
+
+/**
+ * Images made by the texture helpers.  Tests sweeping over formats ask
+ * for the same image again and again, so the last few are kept, up to
+ * IMAGE_CACHE_BYTES (a larger image is kept alone).
+ */
+#define IMAGE_CACHE_ENTRIES 8
+#define IMAGE_CACHE_BYTES (32 * 1024 * 1024)
+
+static struct {
+	struct pattern_image key;
+	void *data;
+	size_t size;
+} image_cache[IMAGE_CACHE_ENTRIES];
+static unsigned image_cache_next;
+static size_t image_cache_bytes;
+
+static void
+image_cache_evict(unsigned i)
+{
+	free(image_cache[i].data);
+	image_cache_bytes -= image_cache[i].size;
+	image_cache[i].data = NULL;
+	image_cache[i].size = 0;
+}
+
+/**
+ * Return the image described by \p key.  It stays valid until the next
+ * call.
+ */
+static const void *
+get_pattern_image(const struct pattern_image *key)
+{
+	const size_t size = (size_t) key->w * key->h * key->texel_size;
+	unsigned i;
+	void *data;
+
+	for (i = 0; i < IMAGE_CACHE_ENTRIES; i++) {
+		if (image_cache[i].data &&
+		    memcmp(&image_cache[i].key, key, sizeof(*key)) == 0)
+			return image_cache[i].data;
+	}
+
+	/* Evict the oldest images until this one fits. */
+	for (i = 0; i < IMAGE_CACHE_ENTRIES &&
+	     image_cache_bytes + size > IMAGE_CACHE_BYTES; i++)
+		image_cache_evict((image_cache_next + i) % IMAGE_CACHE_ENTRIES);
+	if (image_cache[image_cache_next].data)
+		image_cache_evict(image_cache_next);
+
+	data = malloc(MAX2(size, 1));
+	if (data == NULL)
+		piglit_report_result(PIGLIT_FAIL);
+	fill_pattern_image(data, key);
+
+	image_cache[image_cache_next].key = *key;
+	image_cache[image_cache_next].data = data;
+	image_cache[image_cache_next].size = size;
+	image_cache_bytes += size;
+	image_cache_next = (image_cache_next + 1) % IMAGE_CACHE_ENTRIES;
+
+	return data;
+}
+
 /**
  * Generate an extended checkerboard texture where the color of each quadrant
  * in a 2x2 block of tiles can be specified individually.
@@ -2515,56 +3674,28 @@ piglit_quads_texture(GLuint tex, unsigned level,
 		     const float *tl, const float *tr)
 {
 	static const GLfloat border_color[4] = { 1.0, 0.0, 0.0, 1.0 };
-	unsigned i;
-	unsigned j;
-	void *tex_data;
-	char *texel;
-	unsigned pixel_size;
-	GLubyte bl_b[4], br_b[4], tl_b[4], tr_b[4];
-	const void *bl_data, *br_data, *tl_data, *tr_data;
-
+	const float *colors[4] = { bl, br, tl, tr };
+	struct pattern_image key;
+	const void *tex_data;
+	unsigned i, j;
+
+	memset(&key, 0, sizeof(key));
+	key.tile_w = horiz_square_size;
+	key.tile_h = vert_square_size;
+	key.w = width;
+	key.h = height;
 	if (piglit_is_gles()) {
-		pixel_size = 4 * sizeof(GLubyte);
+		key.texel_size = 4 * sizeof(GLubyte);
 		for (i = 0; i < 4; i++) {
-			bl_b[i] = bl[i] * 255;
-			br_b[i] = br[i] * 255;
-			tl_b[i] = tl[i] * 255;
-			tr_b[i] = tr[i] * 255;
+			for (j = 0; j < 4; j++)
+				key.texels[i][j] = colors[i][j] * 255;
 		}
-		bl_data = bl_b;
-		br_data = br_b;
-		tl_data = tl_b;
-		tr_data = tr_b;
 	} else {
-		pixel_size = 4 * sizeof(float);
-		bl_data = bl;
-		br_data = br;
-		tl_data = tl;
-		tr_data = tr;
-	}
-	texel = tex_data = malloc(width * height * pixel_size);
-
-	for (i = 0; i < height; i++) {
-		const unsigned row = i / vert_square_size;
-
-		for (j = 0; j < width; j++) {
-			const unsigned col = j / horiz_square_size;
-
-			if (row & 1) {
-				if (col & 1)
-					memcpy(texel, tr_data, pixel_size);
-				else
-					memcpy(texel, tl_data, pixel_size);
-			} else {
-				if (col & 1)
-					memcpy(texel, br_data, pixel_size);
-				else
-					memcpy(texel, bl_data, pixel_size);
-			}
-
-			texel += pixel_size;
-		}
+		key.texel_size = 4 * sizeof(float);
+		for (i = 0; i < 4; i++)
+			memcpy(key.texels[i], colors[i], 4 * sizeof(float));
 	}
+	tex_data = get_pattern_image(&key);
 
 	if (tex == 0) {
 		glGenTextures(1, &tex);
@@ -2595,8 +3726,6 @@ piglit_quads_texture(GLuint tex, unsigned level,
 	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA,
 		     piglit_is_gles() ? GL_UNSIGNED_BYTE : GL_FLOAT, tex_data);
 
-	free(tex_data);
-
 	return tex;
 }
 
@@ -2650,7 +3779,7 @@ GLuint
 piglit_miptree_texture()
 {
 	GLfloat *data;
-	int size, i, level;
+	int size, level;
 	GLuint tex;
 
 	glGenTextures(1, &tex);
@@ -2665,10 +3794,8 @@ piglit_miptree_texture()
 		size = 8 >> level;
 
 		data = malloc(size*size*4*sizeof(GLfloat));
-		for (i = 0; i < size * size; ++i) {
-			memcpy(data + 4 * i, color_wheel[level],
-			       4 * sizeof(GLfloat));
-		}
+		fill_texels(data, color_wheel[level], 4 * sizeof(GLfloat),
+			    size * size);
 		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA,
 			     size, size, 0, GL_RGBA, GL_FLOAT, data);
 		free(data);
@@ -2676,30 +3803,17 @@ piglit_miptree_texture()
 	return tex;
 }
 
-/**
- * Generates an image of the given size with quadrants of red, green,
- * blue and white.
- * Note that for compressed teximages, where the blocking would be
- * problematic, we assign the whole layers at w == 4 to red, w == 2 to
- * green, and w == 1 to blue.
- *
- * \param internalFormat  either GL_RGBA or a specific compressed format
- * \param w  the width in texels
- * \param h  the height in texels
- * \param alpha  if TRUE, use varied alpha values, else all alphas = 1
- * \param basetype  either GL_UNSIGNED_NORMALIZED, GL_SIGNED_NORMALIZED
- *                  or GL_FLOAT
- */
-GLfloat *
-piglit_rgbw_image(GLenum internalFormat, int w, int h,
-		  GLboolean alpha, GLenum basetype)
+static const GLfloat *
+get_rgbw_image(GLenum internalFormat, int w, int h,
+	       GLboolean alpha, GLenum basetype)
 {
 	float red[4]   = {1.0, 0.0, 0.0, 0.0};
 	float green[4] = {0.0, 1.0, 0.0, 0.25};
 	float blue[4]  = {0.0, 0.0, 1.0, 0.5};
 	float white[4] = {1.0, 1.0, 1.0, 1.0};
-	GLfloat *data;
-	int x, y;
+	const float *colors[4] = { red, green, blue, white };
+	struct pattern_image key;
+	int x;
 
 	if (!alpha) {
 		red[3] = 1.0;
@@ -2734,97 +3848,111 @@ piglit_rgbw_image(GLenum internalFormat, int w, int h,
 		assert(0);
 	}
 
-	data = malloc(w * h * 4 * sizeof(GLfloat));
-
-	for (y = 0; y < h; y++) {
-		for (x = 0; x < w; x++) {
-			const int size = w > h ? w : h;
-			const float *color;
-
-			if (x < w / 2 && y < h / 2)
-				color = red;
-			else if (y < h / 2)
-				color = green;
-			else if (x < w / 2)
-				color = blue;
-			else
-				color = white;
-
-			switch (internalFormat) {
-			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-			case GL_COMPRESSED_RGB_FXT1_3DFX:
-			case GL_COMPRESSED_RGBA_FXT1_3DFX:
-			case GL_COMPRESSED_RED_RGTC1:
-			case GL_COMPRESSED_SIGNED_RED_RGTC1:
-			case GL_COMPRESSED_RG_RGTC2:
-			case GL_COMPRESSED_SIGNED_RG_RGTC2:
-			case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
-			case GL_COMPRESSED_RGBA_BPTC_UNORM:
-			case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
-			case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
-			case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
-				if (size == 4)
-					color = red;
-				else if (size == 2)
-					color = green;
-				else if (size == 1)
-					color = blue;
-				break;
-			default:
-				break;
-			}
-
-			memcpy(data + (y * w + x) * 4, color,
-			       4 * sizeof(float));
+	switch (internalFormat) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGB_FXT1_3DFX:
+	case GL_COMPRESSED_RGBA_FXT1_3DFX:
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_SIGNED_RG_RGTC2:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+	case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+	case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT: {
+		const int size = w > h ? w : h;
+		const float *solid = NULL;
+
+		if (size == 4)
+			solid = red;
+		else if (size == 2)
+			solid = green;
+		else if (size == 1)
+			solid = blue;
+
+		if (solid) {
+			for (x = 0; x < 4; x++)
+				colors[x] = solid;
 		}
+		break;
+	}
+	default:
+		break;
 	}
 
-	return data;
+	memset(&key, 0, sizeof(key));
+	key.w = w;
+	key.h = h;
+	key.texel_size = 4 * sizeof(float);
+	for (x = 0; x < 4; x++)
+		memcpy(key.texels[x], colors[x], 4 * sizeof(float));
+
+	return get_pattern_image(&key);
 }
 
-GLubyte *
-piglit_rgbw_image_ubyte(int w, int h, GLboolean alpha)
+static const GLubyte *
+get_rgbw_image_ubyte(int w, int h, GLboolean alpha)
 {
-	GLubyte red[4]   = {255, 0, 0, 0};
-	GLubyte green[4] = {0, 255, 0, 64};
-	GLubyte blue[4]  = {0, 0, 255, 128};
-	GLubyte white[4] = {255, 255, 255, 255};
-	GLubyte *data;
-	int x, y;
+	struct pattern_image key = {
+		.w = w,
+		.h = h,
+		.texel_size = 4 * sizeof(GLubyte),
+		.texels = {
+			{255, 0, 0, 0},
+			{0, 255, 0, 64},
+			{0, 0, 255, 128},
+			{255, 255, 255, 255},
+		},
+	};
 
 	if (!alpha) {
-		red[3] = 255;
-		green[3] = 255;
-		blue[3] = 255;
-		white[3] = 255;
+		key.texels[0][3] = 255;
+		key.texels[1][3] = 255;
+		key.texels[2][3] = 255;
 	}
 
-	data = malloc(w * h * 4 * sizeof(GLubyte));
+	return get_pattern_image(&key);
+}
 
-	for (y = 0; y < h; y++) {
-		for (x = 0; x < w; x++) {
-			const GLubyte *color;
-
-			if (x < w / 2 && y < h / 2)
-				color = red;
-			else if (y < h / 2)
-				color = green;
-			else if (x < w / 2)
-				color = blue;
-			else
-				color = white;
+/**
+ * Generates an image of the given size with quadrants of red, green,
+ * blue and white.
+ * Note that for compressed teximages, where the blocking would be
+ * problematic, we assign the whole layers at w == 4 to red, w == 2 to
+ * green, and w == 1 to blue.
+ *
+ * \param internalFormat  either GL_RGBA or a specific compressed format
+ * \param w  the width in texels
+ * \param h  the height in texels
+ * \param alpha  if TRUE, use varied alpha values, else all alphas = 1
+ * \param basetype  either GL_UNSIGNED_NORMALIZED, GL_SIGNED_NORMALIZED
+ *                  or GL_FLOAT
+ */
+GLfloat *
+piglit_rgbw_image(GLenum internalFormat, int w, int h,
+		  GLboolean alpha, GLenum basetype)
+{
+	GLfloat *data = malloc(w * h * 4 * sizeof(GLfloat));
 
-			memcpy(data + (y * w + x) * 4, color,
-			       4 * sizeof(GLubyte));
-		}
-	}
+	memcpy(data, get_rgbw_image(internalFormat, w, h, alpha, basetype),
+	       w * h * 4 * sizeof(GLfloat));
+	return data;
+}
+
+GLubyte *
+piglit_rgbw_image_ubyte(int w, int h, GLboolean alpha)
+{
+	GLubyte *data = malloc(w * h * 4 * sizeof(GLubyte));
 
+	memcpy(data, get_rgbw_image_ubyte(w, h, alpha),
+	       w * h * 4 * sizeof(GLubyte));
 	return data;
 }
 
@@ -2875,19 +4003,18 @@ piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 	}
 
 	for (level = 0, size = w > h ? w : h; size > 0; level++, size >>= 1) {
-		void *data;
+		const void *data;
 
 		if (teximage_type == GL_UNSIGNED_BYTE)
-			data = piglit_rgbw_image_ubyte(w, h, alpha);
+			data = get_rgbw_image_ubyte(w, h, alpha);
 		else
-			data = piglit_rgbw_image(internalFormat, w, h,
-			                         alpha, basetype);
+			data = get_rgbw_image(internalFormat, w, h,
+					      alpha, basetype);
 
 		glTexImage2D(GL_TEXTURE_2D, level,
 			     internalFormat,
 			     w, h, 0,
 			     GL_RGBA, teximage_type, data);
-		free(data);
 
 		if (!mip)
 			break;
@@ -3100,17 +4227,20 @@ piglit_depth_texture(GLenum target, GLenum internalformat, int w, int h, int d,
 	}
 
 	for (level = 0, size = w > h ? w : h; size > 0; level++, size >>= 1) {
-		for (y = 0; y < h; y++) {
-			for (x = 0; x < w; x++) {
-				float val = (float)(x) / (w - 1);
-				if (f)
-					f[y * w + x] = val;
-				else if (f2)
-					f2[(y * w + x)*2] = val;
-				else if (i)
-					i[y * w + x] = 0xffffff00 * val;
-			}
+		/* Every row is the same gradient. */
+		const size_t stride = w * (f2 ? 2 * sizeof(float) : sizeof(float));
+
+		for (x = 0; x < w; x++) {
+			float val = (float)(x) / (w - 1);
+			if (f)
+				f[x] = val;
+			else if (f2)
+				f2[x * 2] = val;
+			else if (i)
+				i[x] = 0xffffff00 * val;
 		}
+		for (y = 1; y < h; y++)
+			memcpy((char *) data + y * stride, data, stride);
 
 		switch (target) {
 		case GL_TEXTURE_1D:
@@ -3168,7 +4298,7 @@ piglit_array_texture(GLenum target, GLenum internalformat,
 		     int w, int h, int d, GLboolean mip)
 {
 	float *data;
-	int size, i, level, layer;
+	int size, level, layer;
 	GLuint tex;
 	GLenum type = GL_FLOAT, format = GL_RGBA;
 
@@ -3212,12 +4342,10 @@ piglit_array_texture(GLenum target, GLenum internalformat,
 
 		for (layer = 0; layer < d; layer++) {
 			/* Set whole layer to one color */
-			for (i = 0; i < w * h; i++) {
-				memcpy(data + 4 * i,
-				       color_wheel[layer %
-						   ARRAY_SIZE(color_wheel)],
-				       sizeof(color_wheel[0]));
-			}
+			fill_texels(data,
+				    color_wheel[layer %
+						ARRAY_SIZE(color_wheel)],
+				    sizeof(color_wheel[0]), w * h);
 
 			if (target == GL_TEXTURE_1D_ARRAY) {
 				glTexSubImage2D(target, level,
@@ -3642,3 +4770,17 @@ piglit_linear_to_srgb(float x)
    else
       return 1.0f;
 }
+
+void
+piglit_srgb_to_linear_array(float *dst, const float *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = piglit_srgb_to_linear(src[i]);
+}
+
+void
+piglit_linear_to_srgb_array(float *dst, const float *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = piglit_linear_to_srgb(src[i]);
+}
@@ -76,6 +76,12 @@ bool piglit_is_extension_supported(const char *name);
  */
 void piglit_gl_invalidate_extensions();
 
+/**
+ * Forget what piglit_draw_rect() found out about the programs it drew with.
+ * Call after relinking the current program outside of the piglit helpers.
+ */
+void piglit_gl_invalidate_program(void);
+
 /**
  * \brief Convert a GL error to a string.
  *
@@ -174,6 +180,37 @@ int piglit_compare_pixels(int x, int y, const float *expected, const float *prob
 GLfloat *piglit_read_pixels_float(GLint x, GLint y, GLsizei width, GLsizei height,
 				  GLenum format, GLfloat *pixels);
 
+struct piglit_readback;
+struct piglit_readback *
+piglit_read_pixels_float_async(GLint x, GLint y, GLsizei width, GLsizei height,
+			       GLenum format);
+const GLfloat *piglit_readback_wait(struct piglit_readback *rb);
+void piglit_readback_destroy(struct piglit_readback *rb);
+
+/**
+ * Verify the readbacks of the cases of a test on a worker thread while the
+ * next cases render, see piglit-verify-queue.c.
+ */
+typedef enum piglit_result (*piglit_verify_func)(const GLfloat *pixels,
+						 int width, int height,
+						 void *data);
+
+struct piglit_verify_queue;
+struct piglit_verify_queue *piglit_verify_queue_create(unsigned depth);
+void piglit_verify_queue_submit(struct piglit_verify_queue *q,
+				const char *subtest, int x, int y, int w, int h,
+				GLenum format, piglit_verify_func verify,
+				void *data);
+enum piglit_result piglit_verify_queue_finish(struct piglit_verify_queue *q);
+
+/**
+ * Serve the color probes that fall inside of the given rectangle from a
+ * single readback, until piglit_probe_batch_end() is called.  Nothing
+ * may draw to the read framebuffer in between.
+ */
+void piglit_probe_batch_begin(int x, int y, int w, int h);
+void piglit_probe_batch_end(void);
+
 /**
  * Compare two adjacent in-memory floating-point images.
  * Adjacent means: y1 == y2 && x1 == x2 - w;
@@ -192,6 +229,12 @@ int piglit_compare_images_color(int x, int y, int w, int h, int num_components,
 				const float *observed_image);
 bool piglit_compare_pixels_float(const float *color1, const float *color2,
 				 const float *tolerance, int components);
+int piglit_compare_pixel_span_float(const float *observed,
+				    size_t observed_stride,
+				    const float *expected,
+				    size_t expected_stride,
+				    const float *tolerance, int num_components,
+				    int count, int *mismatch_count);
 int piglit_probe_image_color(int x, int y, int w, int h, GLenum format, const float *image);
 int piglit_probe_image_rgb(int x, int y, int w, int h, const float *image);
 int piglit_probe_image_rgba(int x, int y, int w, int h, const float *image);
@@ -261,6 +304,14 @@ void piglit_draw_rect_from_arrays(const void *verts, const void *tex,
 
 unsigned short piglit_half_from_float(float val);
 float piglit_float_from_half(unsigned short val);
+void piglit_half_from_float_array(unsigned short *dst, const float *src,
+				  size_t count);
+void piglit_float_from_half_array(float *dst, const unsigned short *src,
+				  size_t count);
+void piglit_float_to_norm_array(void *dst, GLenum type, const float *src,
+				size_t count);
+void piglit_norm_to_float_array(float *dst, GLenum type, const void *src,
+				size_t count);
 
 /**
  * Wrapper for piglit_half_from_float() which allows using an exact
@@ -341,6 +392,26 @@ unsigned
 piglit_compressed_pixel_offset(GLenum format, unsigned width,
 			       unsigned x, unsigned y);
 
+/**
+ * Whether piglit_decompress_image() has a reference decoder for \a format.
+ */
+bool
+piglit_is_compressed_format_decodable(GLenum format);
+
+/**
+ * Decode a \a width x \a height image of compressed \a format into RGBA
+ * floats, in the order of its rows in \a data, as the specification of the
+ * format defines the values of its texels. Missing components are 0, and
+ * 1 for alpha; luminance is replicated to red, green and blue, and sRGB
+ * values are not converted.
+ *
+ * The S3TC, RGTC, LATC, BPTC unorm, ETC2 and EAC formats are supported.
+ * Return false for other formats.
+ */
+bool
+piglit_decompress_image(GLenum format, unsigned width, unsigned height,
+			const void *data, float *rgba);
+
 void
 piglit_visualize_image(float *img, GLenum base_internal_format,
 		       int image_width, int image_height,
@@ -348,6 +419,8 @@ piglit_visualize_image(float *img, GLenum base_internal_format,
 
 float piglit_srgb_to_linear(float x);
 float piglit_linear_to_srgb(float x);
+void piglit_srgb_to_linear_array(float *dst, const float *src, size_t count);
+void piglit_linear_to_srgb_array(float *dst, const float *src, size_t count);
 
 extern GLfloat cube_face_texcoords[6][4][3];
 extern const char *cube_face_names[6];
@@ -379,6 +452,49 @@ void
 piglit_write_png(const char *filename, GLenum base_format,
                  int width, int height, GLubyte *data, bool flip_y);
 
+/**
+ * The first word of the raw files of piglit_dump_image(), "PRAW" when read
+ * as little-endian.
+ */
+#define PIGLIT_RAW_IMAGE_MAGIC 0x57415250
+
+void
+piglit_dump_image(const char *name, GLenum base_format,
+                  int width, int height, const GLubyte *data, bool flip_y);
+
+void
+piglit_dump_image_flush(void);
+
+bool
+piglit_golden_init(int argc, char *argv[]);
+
+void
+piglit_golden_check_frame(void);
+
+enum piglit_result
+piglit_golden_result(void);
+
+/** The most counters PIGLIT_PERF_COUNTERS can select. */
+#define PIGLIT_MAX_PERF_COUNTERS 16
+
+struct piglit_perf_counter {
+	char name[64];
+	/** "%", "ns" or "" for counts. */
+	const char *unit;
+};
+
+bool
+piglit_perf_counters_begin(void);
+
+void
+piglit_perf_counters_end(double *values);
+
+const struct piglit_perf_counter *
+piglit_perf_counters(unsigned *count);
+
+void
+piglit_perf_counters_report(void);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
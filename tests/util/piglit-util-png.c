@@ -24,13 +24,19 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #ifdef PIGLIT_HAS_PNG
 #include <png.h>
 #endif
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
 
 #include <piglit/gl_wrap.h>
+#include "piglit-util-gl.h"
 
 #define aborts(s) _abortf("piglit_write_png: %s", s)
 #define abortf(s, ...) _abortf("piglit_write_png" s, __VA_ARGS__)
@@ -45,22 +51,49 @@ _abortf(const char *s, ...)
 	abort();
 }
 
-/* Write a PNG file.
+/**
+ * The zlib compression level of the PNG files, from PIGLIT_PNG_COMPRESSION.
  *
- * \param filename    The filename to write (i.e. "foo.png")
- * \param base_format GL_RGBA or GL_RGB
- * \param width       The width of the image
- * \param height      The height of the image
- * \param data        The image data stored as unsigned bytes
- * \param flip_y      Whether to flip the image upside down (for FBO data)
+ * 0 stores the image uncompressed, 1 is the fastest and 9 the smallest.
+ * Unset or invalid values keep the default of zlib.
  */
-void
-piglit_write_png(const char *filename,
-		 GLenum base_format,
-		 int width,
-		 int height,
-		 GLubyte *data,
-		 bool flip_y)
+static int
+png_compression_level(void)
+{
+	static int level = -2;
+
+	if (level == -2) {
+		const char *str = getenv("PIGLIT_PNG_COMPRESSION");
+		char *end;
+
+		level = -1;
+		if (str) {
+			long l = strtol(str, &end, 10);
+			if (end != str && *end == '\0' && l >= 0 && l <= 9)
+				level = l;
+		}
+	}
+
+	return level;
+}
+
+static int
+bytes_per_pixel(GLenum base_format)
+{
+	switch (base_format) {
+	case GL_RGBA:
+		return 4;
+	case GL_RGB:
+		return 3;
+	default:
+		abortf("unknown format %04x", base_format);
+		return 0;
+	}
+}
+
+static void
+write_png(const char *filename, GLenum base_format, int width, int height,
+	  const GLubyte *data, bool flip_y)
 {
 #ifndef PIGLIT_HAS_PNG
 	aborts("Piglit not built with libpng support.");
@@ -68,24 +101,13 @@ piglit_write_png(const char *filename,
 	FILE *fp;
 	png_structp png;
 	png_infop info;
-	GLubyte *row;
-	int bytes;
+	const GLubyte *row;
+	int bytes = bytes_per_pixel(base_format);
 	int color_type;
+	int level = png_compression_level();
 	int y;
 
-	switch (base_format) {
-	case GL_RGBA:
-		color_type = PNG_COLOR_TYPE_RGB_ALPHA;
-		bytes = 4;
-		break;
-	case GL_RGB:
-		color_type = PNG_COLOR_TYPE_RGB;
-		bytes = 3;
-		break;
-	default:
-		abortf("unknown format %04x", base_format);
-		break;
-	}
+	color_type = bytes == 4 ? PNG_COLOR_TYPE_RGB_ALPHA : PNG_COLOR_TYPE_RGB;
 
 	fp = fopen(filename, "wb");
 	if (!fp)
@@ -108,6 +130,13 @@ piglit_write_png(const char *filename,
 	if (setjmp(png_jmpbuf(png)))
 		aborts("Write error");
 
+	if (level >= 0) {
+		png_set_compression_level(png, level);
+		/* Filtering only pays off when zlib tries hard. */
+		if (level <= 1)
+			png_set_filter(png, 0, PNG_FILTER_NONE);
+	}
+
 	png_set_IHDR(png, info, width, height,
 		     8, color_type, PNG_INTERLACE_NONE,
 		     PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
@@ -118,18 +147,232 @@ piglit_write_png(const char *filename,
 		row = data + (height * width * bytes);
 		for (y = 0; y < height; ++y) {
 			row -= width * bytes;
-			png_write_row(png, row);
+			png_write_row(png, (png_const_bytep)row);
 		}
 	} else {
 		row = data;
 		for (y = 0; y < height; ++y) {
-			png_write_row(png, row);
+			png_write_row(png, (png_const_bytep)row);
 			row += width * bytes;
 		}
 	}
 
 	png_write_end(png, 0);
+	png_destroy_write_struct(&png, &info);
+
+	fclose(fp);
+#endif
+}
+
+/**
+ * Write the header of piglit_dump_image() and the rows, top row first.
+ */
+static void
+write_raw(const char *filename, GLenum base_format, int width, int height,
+	  const GLubyte *data, bool flip_y)
+{
+	int bytes = bytes_per_pixel(base_format);
+	size_t stride = (size_t)width * bytes;
+	uint32_t header[4] = { PIGLIT_RAW_IMAGE_MAGIC, width, height, bytes };
+	FILE *fp;
+	int y;
+
+	fp = fopen(filename, "wb");
+	if (!fp)
+		abortf("failed to open `%s'", filename);
+
+	if (fwrite(header, sizeof(header), 1, fp) != 1)
+		aborts("Write error");
+
+	if (flip_y) {
+		for (y = height - 1; y >= 0; y--) {
+			if (fwrite(data + y * stride, stride, 1, fp) != 1)
+				aborts("Write error");
+		}
+	} else if (height && fwrite(data, stride * height, 1, fp) != 1) {
+		aborts("Write error");
+	}
 
 	fclose(fp);
+}
+
+/* Write a PNG file.
+ *
+ * The compression level is taken from PIGLIT_PNG_COMPRESSION, see
+ * piglit_dump_image().
+ *
+ * \param filename    The filename to write (i.e. "foo.png")
+ * \param base_format GL_RGBA or GL_RGB
+ * \param width       The width of the image
+ * \param height      The height of the image
+ * \param data        The image data stored as unsigned bytes
+ * \param flip_y      Whether to flip the image upside down (for FBO data)
+ */
+void
+piglit_write_png(const char *filename,
+		 GLenum base_format,
+		 int width,
+		 int height,
+		 GLubyte *data,
+		 bool flip_y)
+{
+	write_png(filename, base_format, width, height, data, flip_y);
+}
+
+struct dump_job {
+	struct dump_job *next;
+	char *filename;
+	bool raw;
+	GLenum base_format;
+	int width, height;
+	bool flip_y;
+	GLubyte data[];
+};
+
+static void
+write_job(struct dump_job *job)
+{
+	if (job->raw)
+		write_raw(job->filename, job->base_format, job->width,
+			  job->height, job->data, job->flip_y);
+	else
+		write_png(job->filename, job->base_format, job->width,
+			  job->height, job->data, job->flip_y);
+	free(job->filename);
+	free(job);
+}
+
+#ifdef PIGLIT_HAS_PTHREADS
+static pthread_mutex_t dump_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dump_queued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t dump_written = PTHREAD_COND_INITIALIZER;
+static struct dump_job *dump_head, **dump_tail = &dump_head;
+static unsigned dump_pending;
+static bool dump_thread_started;
+static pthread_t dump_thread;
+
+static void *
+dump_thread_func(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&dump_lock);
+	for (;;) {
+		struct dump_job *job;
+
+		while (!dump_head)
+			pthread_cond_wait(&dump_queued, &dump_lock);
+
+		job = dump_head;
+		dump_head = job->next;
+		if (!dump_head)
+			dump_tail = &dump_head;
+
+		pthread_mutex_unlock(&dump_lock);
+		write_job(job);
+		pthread_mutex_lock(&dump_lock);
+
+		dump_pending--;
+		pthread_cond_broadcast(&dump_written);
+	}
+
+	return NULL;
+}
+
+/** Queue job on the writer thread, return false if there is none. */
+static bool
+queue_job(struct dump_job *job)
+{
+	bool queued = true;
+
+	pthread_mutex_lock(&dump_lock);
+	if (!dump_thread_started) {
+		if (pthread_create(&dump_thread, NULL, dump_thread_func,
+				   NULL) == 0) {
+			pthread_detach(dump_thread);
+			/* Tests leave through exit(), from
+			 * piglit_report_result() or main().
+			 */
+			atexit(piglit_dump_image_flush);
+			dump_thread_started = true;
+		} else {
+			queued = false;
+		}
+	}
+
+	if (queued) {
+		job->next = NULL;
+		*dump_tail = job;
+		dump_tail = &job->next;
+		dump_pending++;
+		pthread_cond_signal(&dump_queued);
+	}
+	pthread_mutex_unlock(&dump_lock);
+
+	return queued;
+}
+#endif
+
+/**
+ * Wait until the images queued by piglit_dump_image() are written.
+ *
+ * This runs at exit, tests only need it to read back what they dumped.
+ */
+void
+piglit_dump_image_flush(void)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&dump_lock);
+	while (dump_pending)
+		pthread_cond_wait(&dump_written, &dump_lock);
+	pthread_mutex_unlock(&dump_lock);
+#endif
+}
+
+/**
+ * Write an image like piglit_write_png(), on a background thread.
+ *
+ * The image is copied, so data can be reused as soon as this returns, and
+ * written to "<name>.png". PIGLIT_PNG_COMPRESSION selects the zlib level,
+ * 0 to store the image uncompressed or 1 for the fastest compression.
+ *
+ * When PIGLIT_DUMP_FORMAT is "raw" the image is written uncompressed to
+ * "<name>.rgba" instead, which doesn't need libpng: four native-endian
+ * uint32_t, PIGLIT_RAW_IMAGE_MAGIC, the width, the height and the bytes per
+ * pixel, followed by the rows, top row first.
+ *
+ * Without pthreads the image is written before this returns.
+ */
+void
+piglit_dump_image(const char *name, GLenum base_format, int width,
+		  int height, const GLubyte *data, bool flip_y)
+{
+	size_t size = (size_t)width * height * bytes_per_pixel(base_format);
+	const char *format = getenv("PIGLIT_DUMP_FORMAT");
+	struct dump_job *job;
+
+	job = malloc(sizeof(*job) + size);
+	if (!job)
+		aborts("out of memory");
+
+	job->raw = format && !strcmp(format, "raw");
+	job->base_format = base_format;
+	job->width = width;
+	job->height = height;
+	job->flip_y = flip_y;
+	memcpy(job->data, data, size);
+
+	job->filename = malloc(strlen(name) + sizeof(".rgba"));
+	if (!job->filename)
+		aborts("out of memory");
+	strcpy(job->filename, name);
+	strcat(job->filename, job->raw ? ".rgba" : ".png");
+
+	printf("Writing %s...\n", job->filename);
+
+#ifdef PIGLIT_HAS_PTHREADS
+	if (queue_job(job))
+		return;
 #endif
+	write_job(job);
 }
@@ -31,6 +31,7 @@
 #ifdef __linux__
 #include <sys/types.h>
 #include <sys/syscall.h>
+#include <dirent.h>
 #endif
 
 #include <assert.h>
@@ -236,10 +237,100 @@ typedef struct {
 
 static piglit_cleanup_function cleanup_functions[PIGLIT_MAX_CLEANUP_FUNC];
 
+void (*piglit_report_result_hook)(int status);
+
+#ifdef PIGLIT_HAS_POSIX_TIMER_NOTIFY_THREAD
+/** The timer of piglit_set_timeout(), if it was called. */
+static timer_t timeout_timer;
+static bool timeout_armed = false;
+#endif
+
+#ifdef __linux__
+#define PIGLIT_MAX_DRM_CLIENTS 16
+#define PIGLIT_MAX_DRM_ENGINES 16
+
+/**
+ * Report the GPU time of each engine used by the DRM clients of this
+ * process, as the drm-engine-<name> keys of their /proc/self/fdinfo give
+ * it, so piglit can tell GPU bound tests. Nothing is printed without a DRM
+ * client or on kernels without these keys.
+ */
+static void
+report_gpu_usage(void)
+{
+	unsigned long long clients[PIGLIT_MAX_DRM_CLIENTS];
+	char engines[PIGLIT_MAX_DRM_ENGINES][32];
+	unsigned long long busy[PIGLIT_MAX_DRM_ENGINES];
+	unsigned num_clients = 0, num_engines = 0, i;
+	struct dirent *entry;
+	DIR *dir = opendir("/proc/self/fdinfo");
+
+	if (!dir)
+		return;
+
+	while ((entry = readdir(dir))) {
+		char path[64], line[256], name[32];
+		unsigned long long client = 0, value;
+		bool has_client = false, counted = false;
+		FILE *f;
+
+		if (entry->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "/proc/self/fdinfo/%s",
+			 entry->d_name);
+		f = fopen(path, "r");
+		if (!f)
+			continue;
+
+		while (fgets(line, sizeof(line), f)) {
+			if (sscanf(line, "drm-client-id: %llu", &client) == 1) {
+				/* Each client counts once, whatever the
+				 * number of its fds.
+				 */
+				for (i = 0; i < num_clients; i++) {
+					if (clients[i] == client)
+						counted = true;
+				}
+				if (counted || num_clients == PIGLIT_MAX_DRM_CLIENTS)
+					break;
+				clients[num_clients++] = client;
+				has_client = true;
+			} else if (has_client && strstr(line, " ns") &&
+				   sscanf(line, "drm-engine-%31[^:]: %llu",
+					  name, &value) == 2) {
+				for (i = 0; i < num_engines; i++) {
+					if (!strcmp(engines[i], name))
+						break;
+				}
+				if (i == num_engines) {
+					if (num_engines == PIGLIT_MAX_DRM_ENGINES)
+						continue;
+					strcpy(engines[num_engines], name);
+					busy[num_engines++] = 0;
+				}
+				busy[i] += value;
+			}
+		}
+		fclose(f);
+	}
+	closedir(dir);
+
+	if (num_engines == 0)
+		return;
+
+	printf("PIGLIT: {\"gpu\": {");
+	for (i = 0; i < num_engines; i++) {
+		printf("%s\"%s\": %llu", i ? ", " : "", engines[i], busy[i]);
+	}
+	printf("}}\n");
+}
+#endif
+
 void
 piglit_report_result(enum piglit_result result)
 {
 	const char *result_str = piglit_result_to_string(result);
+	int status;
 
 #ifdef PIGLIT_HAS_POSIX_TIMER_NOTIFY_THREAD
 	/* Ensure we only report one result in case we race with timeout */
@@ -249,22 +340,43 @@ piglit_report_result(enum piglit_result result)
 
 	fflush(stderr);
 
+#ifdef __linux__
+	report_gpu_usage();
+#endif
 	printf("PIGLIT: {\"result\": \"%s\" }\n", result_str);
 	fflush(stdout);
 
 	for (int8_t i = 0; i < PIGLIT_MAX_CLEANUP_FUNC; i++) {
 		if (cleanup_functions[i].func)
 			cleanup_functions[i].func(cleanup_functions[i].data);
+		cleanup_functions[i].func = NULL;
 	}
 
 	switch(result) {
 	case PIGLIT_PASS:
 	case PIGLIT_SKIP:
 	case PIGLIT_WARN:
-		exit(0);
+		status = 0;
+		break;
 	default:
-		exit(1);
+		status = 1;
+		break;
+	}
+
+	if (piglit_report_result_hook) {
+#ifdef PIGLIT_HAS_POSIX_TIMER_NOTIFY_THREAD
+		/* The tests run after this one mustn't time out with it, and
+		 * report results too.
+		 */
+		if (timeout_armed) {
+			timer_delete(timeout_timer);
+			timeout_armed = false;
+		}
+		pthread_mutex_unlock(&result_lock);
+#endif
+		piglit_report_result_hook(status);
 	}
+	exit(status);
 }
 
 #ifdef PIGLIT_HAS_POSIX_TIMER_NOTIFY_THREAD
@@ -289,26 +401,52 @@ piglit_set_timeout(double seconds, enum piglit_result timeout_result)
 	struct itimerspec spec = {
 		.it_value = { .tv_sec = sec, .tv_nsec = (seconds - sec) * 1e9 },
 	};
-	timer_t timerid;
-	timer_create(CLOCK_MONOTONIC, &sev, &timerid);
-	timer_settime(timerid, 0, &spec, NULL);
+	if (timeout_armed)
+		timer_delete(timeout_timer);
+	timer_create(CLOCK_MONOTONIC, &sev, &timeout_timer);
+	timer_settime(timeout_timer, 0, &spec, NULL);
+	timeout_armed = true;
 #else
 	piglit_logi("Cannot abort this test for timeout on this platform");
 #endif
 }
 
+/**
+ * When the subtest being run started, in piglit_time_get_nano() time, or -1
+ * if that isn't known. The time of a subtest is the time since the start of
+ * the test or the previous subtest result, unless
+ * piglit_run_selected_subtests() runs it.
+ */
+static int64_t subtest_start = -1;
+
 void
 piglit_report_subtest_result(enum piglit_result result, const char *format, ...)
 {
 	const char *result_str = piglit_result_to_string(result);
+	int64_t now = piglit_time_get_nano();
 	va_list ap;
 
 	va_start(ap, format);
 
+	/* Keep the line whole when several threads report subtests. */
+#ifdef _WIN32
+	_lock_file(stdout);
+#else
+	flockfile(stdout);
+#endif
 	printf("PIGLIT: {\"subtest\": {\"");
 	vprintf(format, ap);
-	printf("\" : \"%s\"}}\n", result_str);
+	printf("\" : \"%s\"}", result_str);
+	if (subtest_start >= 0)
+		printf(", \"time\": %.6f", (now - subtest_start) / 1e9);
+	printf("}\n");
+	subtest_start = now;
 	fflush(stdout);
+#ifdef _WIN32
+	_unlock_file(stdout);
+#else
+	funlockfile(stdout);
+#endif
 
 	va_end(ap);
 }
@@ -364,6 +502,7 @@ piglit_general_init(void)
 {
 	piglit_disable_error_message_boxes();
 	piglit_set_line_buffering();
+	subtest_start = piglit_time_get_nano();
 }
 
 
@@ -688,6 +827,96 @@ piglit_delay_ns(int64_t time_ns)
 	return end - start;
 }
 
+static FILE *trace_file;
+static bool trace_first_event = true;
+
+static int
+trace_pid(void)
+{
+#ifdef _WIN32
+	return GetCurrentProcessId();
+#else
+	return getpid();
+#endif
+}
+
+static void
+trace_close(void)
+{
+	fputs("\n]\n", trace_file);
+	fclose(trace_file);
+	trace_file = NULL;
+}
+
+/**
+ * Open the PIGLIT_TRACE file the first time a span is recorded, with %p
+ * replaced by the process id so that concurrent tests don't share a file.
+ */
+static FILE *
+trace_get_file(void)
+{
+	static bool checked = false;
+	const char *path;
+	const char *p;
+	char *name;
+
+	if (checked)
+		return trace_file;
+	checked = true;
+
+	path = getenv("PIGLIT_TRACE");
+	if (path == NULL || path[0] == '\0')
+		return NULL;
+
+	p = strstr(path, "%p");
+	if (p != NULL)
+		(void)!asprintf(&name, "%.*s%d%s", (int) (p - path), path,
+				trace_pid(), p + 2);
+	else
+		name = strdup(path);
+
+	trace_file = fopen(name, "w");
+	if (trace_file == NULL) {
+		fprintf(stderr, "piglit: can't open trace file %s: %s\n",
+			name, strerror(errno));
+	} else {
+		fputs("[", trace_file);
+		atexit(trace_close);
+	}
+	free(name);
+
+	return trace_file;
+}
+
+static void
+trace_event(char phase, const char *name)
+{
+	FILE *f = trace_get_file();
+
+	if (f == NULL)
+		return;
+
+	fprintf(f, "%s\n{\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+		trace_first_event ? "" : ",", phase,
+		piglit_time_get_nano() / 1000.0, trace_pid(), trace_pid());
+	if (name != NULL)
+		fprintf(f, ",\"name\":\"%s\"", name);
+	fputs("}", f);
+	trace_first_event = false;
+}
+
+void
+piglit_trace_begin(const char *name)
+{
+	trace_event('B', name);
+}
+
+void
+piglit_trace_end(void)
+{
+	trace_event('E', NULL);
+}
+
 /**
  * Search for an argument with the given name in the argument list.
  * If it is found, remove it and return true.
@@ -857,6 +1086,7 @@ piglit_run_selected_subtests(const struct piglit_subtest *all_subtests,
 			const struct piglit_subtest *subtest =
 				piglit_find_subtest(all_subtests, name);
 
+			subtest_start = piglit_time_get_nano();
 			subtest_result = subtest->subtest_func(subtest->data);
 			piglit_report_subtest_result(subtest_result, "%s",
 						     subtest->name);
@@ -865,7 +1095,10 @@ piglit_run_selected_subtests(const struct piglit_subtest *all_subtests,
 		}
 	} else {
 		for (int i = 0; !PIGLIT_SUBTEST_END(&all_subtests[i]); i++) {
-			const enum piglit_result subtest_result =
+			enum piglit_result subtest_result;
+
+			subtest_start = piglit_time_get_nano();
+			subtest_result =
 				all_subtests[i].subtest_func(all_subtests[i].data);
 			piglit_report_subtest_result(subtest_result, "%s",
 						     all_subtests[i].name);
@@ -412,6 +412,13 @@ void piglit_merge_result(enum piglit_result *all, enum piglit_result subtest);
 const char * piglit_result_to_string(enum piglit_result result);
 void piglit_set_destroy_func(void (*destroy)(void*), void *data);
 NORETURN void piglit_report_result(enum piglit_result result);
+
+/**
+ * If set, piglit_report_result() calls this with the exit status of the
+ * result once it is reported, and exits only if it returns. The test host
+ * (piglit-test-host) sets it to get back to its loop instead of exiting.
+ */
+extern void (*piglit_report_result_hook)(int status);
 void piglit_set_timeout(double seconds, enum piglit_result timeout_result);
 void piglit_report_subtest_result(enum piglit_result result,
 				  const char *format, ...) PRINTFLIKE(2, 3);
@@ -490,6 +497,23 @@ piglit_time_get_nano(void);
 int64_t
 piglit_delay_ns(int64_t time_ns);
 
+/**
+ * \brief Start a span of the trace written to PIGLIT_TRACE.
+ *
+ * The trace is a JSON array of Chrome trace events, which chrome://tracing
+ * and Perfetto can open.  Spans nest and are closed by piglit_trace_end().
+ * \p name must not need escaping in JSON.  This does nothing when
+ * PIGLIT_TRACE isn't set.
+ */
+void
+piglit_trace_begin(const char *name);
+
+/**
+ * \brief End the span started by the last unmatched piglit_trace_begin().
+ */
+void
+piglit_trace_end(void);
+
 const char**
 piglit_split_string_to_array(const char *string, const char *separators);
 
@@ -40,7 +40,9 @@
  * ATTRNAME is the name of the vertex attribute to be bound to this
  * column, ARRAY_INDEX is the index, GL_TYPE is the GL type of data
  * that follows ("half", "float", "double", "byte", "ubyte", "short",
- * "ushort", "int" or "uint"), GLSL_TYPE is the GLSL type of the data
+ * "ushort", "int", "uint", "int2_10_10_10" or "uint2_10_10_10", the
+ * integer ones with a "_norm" suffix when they are normalized), GLSL_TYPE
+ * is the GLSL type of the data
  * ("int", "uint", "float", "double", "ivec"*, "uvec"*, "vec"*,
  * "dvec"*, "mat"*, "dmat"*) and MATRIX_COLUMN is the column number of
  * the data in case of being a matrix. [ARRAY_INDEX] is optional and
@@ -65,7 +67,8 @@
  *   \endverbatim
  *
  * The data follows the column headers in space-separated form.  "#"
- * can be used for comments, as in shell scripts.
+ * can be used for comments, as in shell scripts.  The 4 components of the
+ * packed 2_10_10_10 types are given as a single 32-bit word.
  *
  * To process textual vertex data, call the function
  * setup_vbo_from_text(), passing the int identifying the linked
@@ -75,6 +78,17 @@
  * If an error occurs, setup_vbo_from_text() will print out a
  * description of the error and exit with PIGLIT_FAIL.
  *
+ * If the PIGLIT_VBO_CACHE_DIR environment variable names a directory,
+ * the parsed data is also saved there in a binary form, keyed by a hash
+ * of the text.  Later runs with the same text map that file and pass it
+ * straight to glBufferData() instead of parsing the text again.  The text
+ * remains the source of truth; the cache files can be deleted at any
+ * time.
+ *
+ * piglit_vbo_parse_columns() only parses a column header line, for the
+ * tests that lay the data out in buffers of their own, and
+ * piglit_vbo_attrib_pointer() points each attribute at it.
+ *
  * For the first example above, the call to setup_vbo_from_text() is
  * roughly equivalent to the following GL operations:
  *
@@ -126,12 +140,22 @@
  * \endcode
  */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <errno.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "piglit-util.h"
 #include "piglit-util-gl.h"
@@ -142,11 +166,13 @@
  */
 static bool
 decode_type(const char *type,
-	    GLenum *gl_type, size_t *gl_type_size, GLenum *glsl_type)
+	    GLenum *gl_type, size_t *gl_type_size, GLenum *glsl_type,
+	    bool *normalized)
 {
 	assert(type);
 	assert(gl_type);
 	assert(gl_type_size);
+	assert(normalized);
 
 	static struct type_table_entry {
 		const char *type; /* NULL means end of table */
@@ -163,16 +189,27 @@ decode_type(const char *type,
 		{ "half",    GL_HALF_FLOAT,	2,	GL_FLOAT	},
 		{ "float",   GL_FLOAT,		4,	GL_FLOAT	},
 		{ "double",  GL_DOUBLE,		8,	GL_DOUBLE	},
+		{ "int2_10_10_10", GL_INT_2_10_10_10_REV, 4, GL_FLOAT	},
+		{ "uint2_10_10_10", GL_UNSIGNED_INT_2_10_10_10_REV, 4, GL_FLOAT },
 		{ NULL,      0,			0,	0		},
 	};
 
+	std::string name(type);
+	const std::string norm("_norm");
+
+	*normalized = name.size() > norm.size() &&
+		name.compare(name.size() - norm.size(), norm.size(),
+			     norm) == 0;
+	if (*normalized)
+		name.resize(name.size() - norm.size());
 
 	for (int i = 0; type_table[i].type; ++i) {
-		if (0 == strcmp(type, type_table[i].type)) {
+		if (name == type_table[i].type) {
 			*gl_type = type_table[i].gl_type;
 			*gl_type_size = type_table[i].gl_type_size;
 			if (glsl_type)
-				*glsl_type = type_table[i].glsl_type;
+				*glsl_type = *normalized ? GL_FLOAT :
+					type_table[i].glsl_type;
 			return true;
 		}
 	}
@@ -181,6 +218,14 @@ decode_type(const char *type,
 }
 
 
+static bool
+is_packed_type(GLenum data_type)
+{
+	return data_type == GL_INT_2_10_10_10_REV ||
+		data_type == GL_UNSIGNED_INT_2_10_10_10_REV;
+}
+
+
 /**
  * Convert a GLSL type name string to its basic GLenum type.
  */
@@ -262,6 +307,15 @@ cleanup:
 }
 
 
+/**
+ * Parser for the values of one attribute in a data row, see
+ * vertex_attrib_description::parse.
+ */
+typedef bool (*attrib_parse_func)(const char **text, char *data);
+
+static attrib_parse_func
+select_parser(GLenum data_type, size_t rows);
+
 /**
  * Description of a vertex attribute, built from its column header
  */
@@ -269,9 +323,26 @@ class vertex_attrib_description
 {
 public:
 	vertex_attrib_description(GLuint prog, const char *text);
-	bool parse_datum(const char **text, void *data) const;
+	void describe(struct piglit_vbo_attrib *attrib) const;
 	void setup(size_t *offset, size_t stride) const;
 
+	/**
+	 * Number of bytes of this attribute in each row.
+	 */
+	size_t size() const
+	{
+		return is_packed_type(this->data_type) ?
+			this->data_type_size : this->rows * this->data_type_size;
+	}
+
+	/**
+	 * Parse the rows values of this attribute from a data row and
+	 * store them at data.  On failure, print a description of the
+	 * problem, leave text pointing at the offending value and
+	 * return false.
+	 */
+	attrib_parse_func parse;
+
 	/**
 	 * GL data type of this attribute.
 	 */
@@ -287,6 +358,11 @@ public:
 	 */
 	GLenum glsl_data_type;
 
+	/**
+	 * Whether the integer data is normalized to [0, 1] or [-1, 1].
+	 */
+	bool normalized;
+
 	/**
 	 * Index of the array for this attribute.
 	 */
@@ -405,11 +481,20 @@ vertex_attrib_description::vertex_attrib_description(GLuint prog,
 
 	if (!decode_type(type_str.c_str(),
 			 &this->data_type, &this->data_type_size,
-			 glsl_data_type)) {
+			 glsl_data_type, &this->normalized)) {
 		printf("Unrecognized GL type: %s\n", type_str.c_str());
 		piglit_report_result(PIGLIT_FAIL);
 	}
 
+	if (this->normalized &&
+	    (this->glsl_data_type != GL_FLOAT ||
+	     this->data_type == GL_HALF_FLOAT ||
+	     this->data_type == GL_FLOAT || this->data_type == GL_DOUBLE)) {
+		printf("Only integer types read as floats can be normalized."
+		       "  Got: %s\n", text);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
 	if (*endptr != '\0') {
 		const char *third_slash = strchr(second_slash + 1, '/');
 		this->matrix_index = strtoul(third_slash + 1, &endptr, 10);
@@ -463,6 +548,15 @@ vertex_attrib_description::vertex_attrib_description(GLuint prog,
 		       (unsigned long) this->cols);
 		piglit_report_result(PIGLIT_FAIL);
 	}
+
+	if (is_packed_type(this->data_type) &&
+	    (this->rows != 4 || this->glsl_data_type != GL_FLOAT)) {
+		printf("Packed types must be read as 4 floats.  Got: %s\n",
+		       text);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	this->parse = select_parser(this->data_type, this->rows);
 }
 
 
@@ -471,15 +565,19 @@ vertex_attrib_description::vertex_attrib_description(GLuint prog,
  * data rows, and store it in the location pointed to by \c data.
  * Update \c text to point to the next character of input.
  *
+ * The type is a template parameter so that the switch below folds
+ * away, leaving a single parse function per type.
+ *
  * If there is a parse failure, print a description of the problem and
  * then return false.  Otherwise return true.
  */
-bool
-vertex_attrib_description::parse_datum(const char **text, void *data) const
+template<GLenum data_type>
+static bool
+parse_datum(const char **text, void *data)
 {
 	char *endptr;
 	errno = 0;
-	switch (this->data_type) {
+	switch (data_type) {
 	case GL_HALF_FLOAT: {
 		unsigned short value = strtohf_hex(*text, &endptr);
 		if (errno == ERANGE) {
@@ -571,62 +669,102 @@ vertex_attrib_description::parse_datum(const char **text, void *data) const
 }
 
 
+/**
+ * Parse the count values of an attribute of the given type.
+ */
+template<GLenum data_type, size_t type_size, unsigned count>
+static bool
+parse_values(const char **text, char *data)
+{
+	for (unsigned i = 0; i < count; ++i) {
+		if (!parse_datum<data_type>(text, data + i * type_size))
+			return false;
+	}
+	return true;
+}
+
+
+#define PARSERS(data_type, type_size) {				\
+		parse_values<data_type, type_size, 1>,		\
+		parse_values<data_type, type_size, 2>,		\
+		parse_values<data_type, type_size, 3>,		\
+		parse_values<data_type, type_size, 4>,		\
+	}
+
+/**
+ * Select the parse function for rows values of the given type, once
+ * per column instead of once per value.
+ */
+static attrib_parse_func
+select_parser(GLenum data_type, size_t rows)
+{
+	static const attrib_parse_func byte_parsers[] = PARSERS(GL_BYTE, 1);
+	static const attrib_parse_func ubyte_parsers[] =
+		PARSERS(GL_UNSIGNED_BYTE, 1);
+	static const attrib_parse_func short_parsers[] = PARSERS(GL_SHORT, 2);
+	static const attrib_parse_func ushort_parsers[] =
+		PARSERS(GL_UNSIGNED_SHORT, 2);
+	static const attrib_parse_func int_parsers[] = PARSERS(GL_INT, 4);
+	static const attrib_parse_func uint_parsers[] =
+		PARSERS(GL_UNSIGNED_INT, 4);
+	static const attrib_parse_func half_parsers[] =
+		PARSERS(GL_HALF_FLOAT, 2);
+	static const attrib_parse_func float_parsers[] = PARSERS(GL_FLOAT, 4);
+	static const attrib_parse_func double_parsers[] =
+		PARSERS(GL_DOUBLE, 8);
+
+	assert(rows >= 1 && rows <= 4);
+
+	switch (data_type) {
+	case GL_BYTE:		return byte_parsers[rows - 1];
+	case GL_UNSIGNED_BYTE:	return ubyte_parsers[rows - 1];
+	case GL_SHORT:		return short_parsers[rows - 1];
+	case GL_UNSIGNED_SHORT:	return ushort_parsers[rows - 1];
+	case GL_INT:		return int_parsers[rows - 1];
+	case GL_UNSIGNED_INT:	return uint_parsers[rows - 1];
+	case GL_HALF_FLOAT:	return half_parsers[rows - 1];
+	case GL_FLOAT:		return float_parsers[rows - 1];
+	case GL_DOUBLE:		return double_parsers[rows - 1];
+	/* A packed attribute is a single word. */
+	case GL_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+				return uint_parsers[0];
+	default:
+		assert(!"Unexpected data type");
+		return NULL;
+	}
+}
+
+#undef PARSERS
+
+
+/**
+ * Describe this attribute for piglit_vbo_attrib_pointer().
+ */
+void
+vertex_attrib_description::describe(struct piglit_vbo_attrib *attrib) const
+{
+	attrib->index = this->index + this->matrix_index
+		+ this->array_index * this->cols;
+	attrib->size = this->rows;
+	attrib->data_type = this->data_type;
+	attrib->glsl_data_type = this->glsl_data_type;
+	attrib->normalized = this->normalized;
+	attrib->bytes = this->size();
+}
+
+
 /**
  * Execute the necessary GL calls to bind this attribute to its data.
  */
 void
 vertex_attrib_description::setup(size_t *offset, size_t stride) const
 {
-	GLuint actual_index = this->index + this->matrix_index
-		+ this->array_index * this->cols;
-	switch (this->glsl_data_type) {
-	case GL_FLOAT:
-		glVertexAttribPointer(actual_index, this->rows,
-				      this->data_type, GL_FALSE, stride,
-				      (void *) *offset);
-		break;
-	case GL_DOUBLE:
-		if (piglit_is_gles()
-		    || !piglit_is_extension_supported("GL_ARB_vertex_attrib_64bit")) {
-			fprintf(stderr,"vertex_attrib_description fail. no 64-bit float support\n");
-			return;
-		}
-		if (this->data_type != GL_DOUBLE) {
-			fprintf(stderr,"vertex_attrib_description fail. the GL"
-				" type must be 'GL_DOUBLE' and it is '%s'\n",
-				piglit_get_prim_name(this->data_type));
-			return;
-		}
-		glVertexAttribLPointer(actual_index, this->rows,
-				       this->data_type, stride,
-				       (void *) *offset);
-		break;
-	default:
-		if (piglit_is_gles() && piglit_get_gl_version() < 30) {
-			fprintf(stderr,"vertex_attrib_description fail. no int support\n");
-			return;
-		}
-		switch (this->data_type) {
-		case GL_BYTE:
-		case GL_UNSIGNED_BYTE:
-		case GL_SHORT:
-		case GL_UNSIGNED_SHORT:
-		case GL_INT:
-		case GL_UNSIGNED_INT:
-			break;
-		default:
-			fprintf(stderr,"vertex_attrib_description fail. the GL"
-				" type '%s' is incompatible\n",
-				piglit_get_prim_name(this->data_type));
-			return;
-		}
-		glVertexAttribIPointer(actual_index, this->rows,
-				       this->data_type, stride,
-				       (void *) *offset);
-		break;
-	}
-	glEnableVertexAttribArray(actual_index);
-	*offset += this->rows * this->data_type_size;
+	struct piglit_vbo_attrib attrib;
+
+	describe(&attrib);
+	piglit_vbo_attrib_pointer(&attrib, stride, *offset);
+	*offset += attrib.bytes;
 }
 
 
@@ -639,18 +777,34 @@ class vbo_data
 {
 public:
 	vbo_data(std::string const &text, GLuint prog);
+	vbo_data(const std::string &columns, size_t num_rows, GLuint prog);
 	size_t setup() const;
+	size_t setup(const void *data) const;
+	size_t describe(struct piglit_vbo_attrib *attribs,
+			size_t max_attribs) const;
+	bool write_cache(const char *path, uint64_t text_hash,
+			 size_t text_size) const;
+
+	/**
+	 * Number of bytes in each row of raw_data.
+	 */
+	size_t stride;
 
 private:
 	void parse_header_line(const std::string &line, GLuint prog);
 	void parse_data_line(const std::string &line, unsigned int line_num);
-	void parse_line(std::string line, unsigned int line_num, GLuint prog);
+	void parse_line(std::string &line, unsigned int line_num, GLuint prog);
 
 	/**
 	 * True if the header line has already been parsed.
 	 */
 	bool header_seen;
 
+	/**
+	 * The column header line, without comments.
+	 */
+	std::string columns;
+
 	/**
 	 * Description of each attribute.
 	 */
@@ -661,11 +815,6 @@ private:
 	 */
 	std::vector<char> raw_data;
 
-	/**
-	 * Number of bytes in each row of raw_data.
-	 */
-	size_t stride;
-
 	/**
 	 * Number of rows in raw_data.
 	 */
@@ -673,7 +822,6 @@ private:
 };
 
 
-
 static bool
 is_blank_line(const std::string &line)
 {
@@ -710,7 +858,7 @@ vbo_data::parse_header_line(const std::string &line, GLuint prog)
 			vertex_attrib_description desc(
 				prog, column_header.c_str());
 			attribs.push_back(desc);
-			this->stride += desc.rows * desc.data_type_size;
+			this->stride += desc.size();
 			pos = column_header_end + 1;
 		}
 	}
@@ -733,16 +881,13 @@ vbo_data::parse_data_line(const std::string &line, unsigned int line_num)
 
 	const char *line_ptr = line.c_str();
 	for (size_t i = 0; i < this->attribs.size(); ++i) {
-		for (size_t j = 0; j < this->attribs[i].rows; ++j) {
-			if (!this->attribs[i].parse_datum(&line_ptr,
-							  data_ptr)) {
-				printf("At line %u of [vertex data] section\n",
-				       line_num);
-				printf("Offending text: %s\n", line_ptr);
-				piglit_report_result(PIGLIT_FAIL);
-			}
-			data_ptr += this->attribs[i].data_type_size;
+		if (!this->attribs[i].parse(&line_ptr, data_ptr)) {
+			printf("At line %u of [vertex data] section\n",
+			       line_num);
+			printf("Offending text: %s\n", line_ptr);
+			piglit_report_result(PIGLIT_FAIL);
 		}
+		data_ptr += this->attribs[i].size();
 	}
 
 	++this->num_rows;
@@ -756,10 +901,12 @@ vbo_data::parse_data_line(const std::string &line, unsigned int line_num)
  * then exit with PIGLIT_FAIL.
  */
 void
-vbo_data::parse_line(std::string line, unsigned int line_num, GLuint prog)
+vbo_data::parse_line(std::string &line, unsigned int line_num, GLuint prog)
 {
 	/* Ignore end-of-line comments */
-	line = line.substr(0, line.find('#'));
+	size_t comment = line.find('#');
+	if (comment != std::string::npos)
+		line.resize(comment);
 
 	/* Ignore blank or comment-only lines */
 	if (is_blank_line(line))
@@ -767,6 +914,7 @@ vbo_data::parse_line(std::string line, unsigned int line_num, GLuint prog)
 
 	if (!this->header_seen) {
 		this->header_seen = true;
+		this->columns = line;
 		parse_header_line(line, prog);
 	} else {
 		parse_data_line(line, line_num);
@@ -781,33 +929,70 @@ vbo_data::parse_line(std::string line, unsigned int line_num, GLuint prog)
  * then exit with PIGLIT_FAIL.
  */
 vbo_data::vbo_data(const std::string &text, GLuint prog)
-	: header_seen(false), stride(0), num_rows(0)
+	: stride(0), header_seen(false), num_rows(0)
 {
 	unsigned int line_num = 1;
+	const size_t max_rows = std::count(text.begin(), text.end(), '\n') + 1;
+
+	/* Reused for every line, so that only the first ones allocate. */
+	std::string line;
 
 	size_t pos = 0;
 	while (pos < text.size()) {
 		size_t end_of_line = text.find('\n', pos);
 		if (end_of_line == std::string::npos)
 			end_of_line = text.size();
-		parse_line(text.substr(pos, end_of_line), line_num++, prog);
+		line.assign(text, pos, end_of_line - pos);
+		parse_line(line, line_num++, prog);
 		pos = end_of_line + 1;
+
+		/* Size raw_data for every remaining line once the
+		 * header line gave us the stride.
+		 */
+		if (this->header_seen && this->raw_data.capacity() == 0)
+			this->raw_data.reserve(this->stride * max_rows);
 	}
 }
 
 
+/**
+ * Set up the attributes from a column header line whose num_rows rows
+ * of data are already in binary form, and will be passed to
+ * setup(const void *).
+ *
+ * If there is a parse failure, print a description of the problem and
+ * then exit with PIGLIT_FAIL.
+ */
+vbo_data::vbo_data(const std::string &columns, size_t num_rows, GLuint prog)
+	: stride(0), header_seen(true), columns(columns), num_rows(num_rows)
+{
+	parse_header_line(columns, prog);
+}
+
+
 /**
  * Execute the necessary GL commands to set up the vertex data passed
  * to the constructor.
  */
 size_t
 vbo_data::setup() const
+{
+	return setup(this->raw_data.empty() ? NULL : &this->raw_data[0]);
+}
+
+
+/**
+ * Execute the necessary GL commands to set up the vertex data, using
+ * the num_rows rows found at data.
+ */
+size_t
+vbo_data::setup(const void *data) const
 {
 	GLuint buffer_handle;
 	glGenBuffers(1, &buffer_handle);
 	glBindBuffer(GL_ARRAY_BUFFER, buffer_handle);
 	glBufferData(GL_ARRAY_BUFFER, this->stride * this->num_rows,
-		     &this->raw_data[0], GL_STATIC_DRAW);
+		     data, GL_STATIC_DRAW);
 
 	size_t offset = 0;
 	for (size_t i = 0; i < attribs.size(); ++i)
@@ -819,6 +1004,190 @@ vbo_data::setup() const
 }
 
 
+/**
+ * Describe up to max_attribs of the attributes in attribs, and return
+ * their number.
+ */
+size_t
+vbo_data::describe(struct piglit_vbo_attrib *attribs, size_t max_attribs) const
+{
+	size_t count = std::min(max_attribs, this->attribs.size());
+
+	for (size_t i = 0; i < count; ++i)
+		this->attribs[i].describe(&attribs[i]);
+	return count;
+}
+
+
+/**
+ * Header of a PIGLIT_VBO_CACHE_DIR file.  It is followed by the column
+ * header line, padded to a multiple of 8 bytes, and then by the
+ * num_rows * stride bytes of vertex data as passed to glBufferData().
+ *
+ * The files are only meant to be read back on the machine that wrote
+ * them, so everything is in host byte order.
+ */
+struct vbo_cache_header {
+	char magic[4];
+	uint32_t version;
+	uint64_t text_hash;
+	uint64_t text_size;
+	uint64_t columns_size;
+	uint64_t stride;
+	uint64_t num_rows;
+};
+
+static const char vbo_cache_magic[4] = { 'P', 'V', 'B', 'O' };
+static const uint32_t vbo_cache_version = 1;
+
+static uint64_t
+hash_text(const std::string &text)
+{
+	/* 64-bit FNV-1a */
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (size_t i = 0; i < text.size(); ++i) {
+		hash ^= (unsigned char) text[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static std::string
+vbo_cache_path(const char *dir, uint64_t text_hash)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "/vbo-%016" PRIx64 ".bin", text_hash);
+	return std::string(dir) + name;
+}
+
+static size_t
+vbo_cache_data_offset(size_t columns_size)
+{
+	return sizeof(vbo_cache_header) + ALIGN(columns_size, 8);
+}
+
+/**
+ * Write the parsed data to a cache file.  As with any cache, failures
+ * are not errors, the next run will simply parse the text again.
+ */
+bool
+vbo_data::write_cache(const char *path, uint64_t text_hash,
+		      size_t text_size) const
+{
+	vbo_cache_header header;
+	const size_t data_size = this->stride * this->num_rows;
+	const size_t padding = ALIGN(this->columns.size(), 8) -
+		this->columns.size();
+	static const char zeros[8] = { 0 };
+
+	memcpy(header.magic, vbo_cache_magic, sizeof(header.magic));
+	header.version = vbo_cache_version;
+	header.text_hash = text_hash;
+	header.text_size = text_size;
+	header.columns_size = this->columns.size();
+	header.stride = this->stride;
+	header.num_rows = this->num_rows;
+
+	/* Write to a temporary file and rename it, so that concurrent
+	 * tests never see a partial entry.
+	 */
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%" PRIu64 ".tmp",
+		 (uint64_t) piglit_time_get_nano());
+	std::string tmp_path = std::string(path) + suffix;
+
+	FILE *f = fopen(tmp_path.c_str(), "wb");
+	if (f == NULL)
+		return false;
+
+	bool written = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(this->columns.data(), 1, this->columns.size(), f) ==
+			this->columns.size() &&
+		fwrite(zeros, 1, padding, f) == padding &&
+		(data_size == 0 ||
+		 fwrite(&this->raw_data[0], data_size, 1, f) == 1);
+
+	if (fclose(f) == 0 && written)
+		written = rename(tmp_path.c_str(), path) == 0;
+	if (!written)
+		remove(tmp_path.c_str());
+	return written;
+}
+
+/**
+ * Set up the vertex data from a cache file if there is a valid one for
+ * this text.
+ *
+ * \return false if there is no usable cache file, in which case nothing
+ * was set up.
+ */
+static bool
+setup_vbo_from_cache(GLuint prog, const char *path, uint64_t text_hash,
+		     size_t text_size, size_t *num_rows)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 ||
+	    (size_t) st.st_size < sizeof(vbo_cache_header)) {
+		close(fd);
+		return false;
+	}
+
+	const size_t file_size = st.st_size;
+#ifndef _WIN32
+	void *map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return false;
+	const char *file = (const char *) map;
+#else
+	std::vector<char> contents(file_size);
+	const bool read_all =
+		read(fd, &contents[0], file_size) == (int) file_size;
+	close(fd);
+	if (!read_all)
+		return false;
+	const char *file = &contents[0];
+#endif
+
+	vbo_cache_header header;
+	memcpy(&header, file, sizeof(header));
+
+	bool valid = memcmp(header.magic, vbo_cache_magic,
+			    sizeof(header.magic)) == 0 &&
+		header.version == vbo_cache_version &&
+		header.text_hash == text_hash &&
+		header.text_size == text_size &&
+		header.columns_size < file_size &&
+		header.stride != 0 &&
+		file_size - vbo_cache_data_offset(header.columns_size) ==
+			header.stride * header.num_rows;
+
+	if (valid) {
+		std::string columns(file + sizeof(header),
+				    header.columns_size);
+		vbo_data data(columns, header.num_rows, prog);
+
+		valid = data.stride == header.stride;
+		if (valid) {
+			*num_rows = data.setup(
+				file +
+				vbo_cache_data_offset(header.columns_size));
+		}
+	}
+
+#ifndef _WIN32
+	munmap(map, file_size);
+#endif
+	return valid;
+}
+
+
 /**
  * Set up a vertex buffer object for the program prog based on the
  * data encoded in text_start.  text_end indicates the end of the text
@@ -835,5 +1204,96 @@ setup_vbo_from_text(GLuint prog, const char *text_start, const char *text_end)
 	if (text_end == NULL)
 		text_end = text_start + strlen(text_start);
 	std::string text(text_start, text_end);
-	return vbo_data(text, prog).setup();
+
+	const char *cache_dir = getenv("PIGLIT_VBO_CACHE_DIR");
+	if (cache_dir == NULL || *cache_dir == '\0')
+		return vbo_data(text, prog).setup();
+
+	const uint64_t text_hash = hash_text(text);
+	const std::string path = vbo_cache_path(cache_dir, text_hash);
+	size_t num_rows;
+
+	if (setup_vbo_from_cache(prog, path.c_str(), text_hash, text.size(),
+				 &num_rows))
+		return num_rows;
+
+	vbo_data data(text, prog);
+	data.write_cache(path.c_str(), text_hash, text.size());
+	return data.setup();
+}
+
+
+/**
+ * Parse the column header line columns, in the format of the first line
+ * of the vertex data, for the program prog.  Describe up to max_attribs of
+ * its attributes in attribs and return their number.
+ *
+ * If there is a parse failure, print a description of the problem and
+ * then exit with PIGLIT_FAIL.
+ */
+unsigned
+piglit_vbo_parse_columns(GLuint prog, const char *columns,
+			 struct piglit_vbo_attrib *attribs,
+			 unsigned max_attribs)
+{
+	return vbo_data(columns, 0, prog).describe(attribs, max_attribs);
+}
+
+
+/**
+ * Point attrib at the data at offset in the buffer bound to
+ * GL_ARRAY_BUFFER, stride bytes apart, and enable it.
+ */
+void
+piglit_vbo_attrib_pointer(const struct piglit_vbo_attrib *attrib,
+			  size_t stride, size_t offset)
+{
+	switch (attrib->glsl_data_type) {
+	case GL_FLOAT:
+		glVertexAttribPointer(attrib->index, attrib->size,
+				      attrib->data_type,
+				      attrib->normalized ? GL_TRUE : GL_FALSE,
+				      stride, (void *) offset);
+		break;
+	case GL_DOUBLE:
+		if (piglit_is_gles()
+		    || !piglit_is_extension_supported("GL_ARB_vertex_attrib_64bit")) {
+			fprintf(stderr,"vertex_attrib_description fail. no 64-bit float support\n");
+			return;
+		}
+		if (attrib->data_type != GL_DOUBLE) {
+			fprintf(stderr,"vertex_attrib_description fail. the GL"
+				" type must be 'GL_DOUBLE' and it is '%s'\n",
+				piglit_get_prim_name(attrib->data_type));
+			return;
+		}
+		glVertexAttribLPointer(attrib->index, attrib->size,
+				       attrib->data_type, stride,
+				       (void *) offset);
+		break;
+	default:
+		if (piglit_is_gles() && piglit_get_gl_version() < 30) {
+			fprintf(stderr,"vertex_attrib_description fail. no int support\n");
+			return;
+		}
+		switch (attrib->data_type) {
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+			break;
+		default:
+			fprintf(stderr,"vertex_attrib_description fail. the GL"
+				" type '%s' is incompatible\n",
+				piglit_get_prim_name(attrib->data_type));
+			return;
+		}
+		glVertexAttribIPointer(attrib->index, attrib->size,
+				       attrib->data_type, stride,
+				       (void *) offset);
+		break;
+	}
+	glEnableVertexAttribArray(attrib->index);
 }
@@ -27,9 +27,35 @@
 extern "C" {
 #endif
 
+/**
+ * A vertex attribute of a column header, as passed to
+ * glVertexAttrib*Pointer().
+ */
+struct piglit_vbo_attrib {
+	GLuint index;
+	GLint size;
+	GLenum data_type;
+	/** GL_FLOAT, GL_DOUBLE, GL_INT or GL_UNSIGNED_INT, as read by the
+	 * shader, which selects the glVertexAttrib*Pointer() to use.
+	 */
+	GLenum glsl_data_type;
+	bool normalized;
+	/** Number of bytes of the attribute per vertex. */
+	size_t bytes;
+};
+
 size_t
 setup_vbo_from_text(GLuint prog, const char *text_start, const char *text_end);
 
+unsigned
+piglit_vbo_parse_columns(GLuint prog, const char *columns,
+			 struct piglit_vbo_attrib *attribs,
+			 unsigned max_attribs);
+
+void
+piglit_vbo_attrib_pointer(const struct piglit_vbo_attrib *attrib,
+			  size_t stride, size_t offset);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
@@ -0,0 +1,275 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-verify-queue.c
+ *
+ * Overlap the rendering of the cases of a test with the verification of
+ * the cases rendered before.
+ *
+ * A case is submitted once rendered: its readback is queued with
+ * piglit_read_pixels_float_async(), and once up to depth more cases have
+ * been submitted the readback is waited for and its pixels handed to a
+ * worker thread that calls the verify function of the case.  The GL calls
+ * all stay on the thread of the test, the worker only reads the pixels.
+ *
+ * The subtest results are reported in the order the cases were submitted,
+ * as the verifications complete.  Without pthreads the verify functions
+ * run when the readbacks are waited for.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
+#include "piglit-util-gl.h"
+
+struct verify_job {
+	struct verify_job *next;
+	/** The next job for the worker */
+	struct verify_job *next_work;
+
+	char *subtest;
+	struct piglit_readback *rb;
+	const GLfloat *pixels;
+	int width, height;
+	piglit_verify_func verify;
+	void *data;
+
+	bool done;
+	enum piglit_result result;
+};
+
+struct piglit_verify_queue {
+	unsigned depth;
+
+	/** The submitted jobs not reported yet, in order */
+	struct verify_job *head, **tail;
+	/** The first job whose readback wasn't waited for */
+	struct verify_job *unsent;
+	unsigned num_unsent;
+
+	enum piglit_result result;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_t lock;
+	pthread_cond_t queued, verified;
+	struct verify_job *work_head, **work_tail;
+	pthread_t thread;
+	bool has_thread;
+	bool quit;
+#endif
+};
+
+static void
+run_job(struct verify_job *job)
+{
+	job->result = job->verify(job->pixels, job->width, job->height,
+				  job->data);
+}
+
+#ifdef PIGLIT_HAS_PTHREADS
+static void *
+worker_func(void *arg)
+{
+	struct piglit_verify_queue *q = arg;
+
+	pthread_mutex_lock(&q->lock);
+	for (;;) {
+		struct verify_job *job;
+
+		while (!q->work_head && !q->quit)
+			pthread_cond_wait(&q->queued, &q->lock);
+		if (!q->work_head)
+			break;
+
+		job = q->work_head;
+		q->work_head = job->next_work;
+		if (!q->work_head)
+			q->work_tail = &q->work_head;
+
+		pthread_mutex_unlock(&q->lock);
+		run_job(job);
+		pthread_mutex_lock(&q->lock);
+
+		job->done = true;
+		pthread_cond_broadcast(&q->verified);
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	return NULL;
+}
+#endif
+
+/**
+ * Create a queue that keeps the readbacks of up to depth cases in flight
+ * before waiting for them.
+ */
+struct piglit_verify_queue *
+piglit_verify_queue_create(unsigned depth)
+{
+	struct piglit_verify_queue *q = calloc(1, sizeof(*q));
+
+	q->depth = depth;
+	q->tail = &q->head;
+	q->result = PIGLIT_SKIP;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->queued, NULL);
+	pthread_cond_init(&q->verified, NULL);
+	q->work_tail = &q->work_head;
+	q->has_thread = pthread_create(&q->thread, NULL, worker_func, q) == 0;
+#endif
+
+	return q;
+}
+
+/** Wait for the readback of the first unsent job and hand it to verify. */
+static void
+send_job(struct piglit_verify_queue *q)
+{
+	struct verify_job *job = q->unsent;
+
+	job->pixels = piglit_readback_wait(job->rb);
+	q->unsent = job->next;
+	q->num_unsent--;
+
+#ifdef PIGLIT_HAS_PTHREADS
+	if (q->has_thread) {
+		pthread_mutex_lock(&q->lock);
+		job->next_work = NULL;
+		*q->work_tail = job;
+		q->work_tail = &job->next_work;
+		pthread_cond_signal(&q->queued);
+		pthread_mutex_unlock(&q->lock);
+		return;
+	}
+#endif
+	run_job(job);
+	job->done = true;
+}
+
+/**
+ * Report the results of the verified jobs at the head of the queue, and
+ * with wait, wait for all the sent jobs to be verified first.
+ */
+static void
+report_jobs(struct piglit_verify_queue *q, bool wait)
+{
+	for (;;) {
+		struct verify_job *job = q->head;
+		bool done;
+
+		if (!job || job == q->unsent)
+			break;
+
+#ifdef PIGLIT_HAS_PTHREADS
+		pthread_mutex_lock(&q->lock);
+		while (wait && !job->done)
+			pthread_cond_wait(&q->verified, &q->lock);
+		done = job->done;
+		pthread_mutex_unlock(&q->lock);
+#else
+		done = job->done;
+#endif
+		if (!done)
+			break;
+
+		piglit_report_subtest_result(job->result, "%s", job->subtest);
+		piglit_merge_result(&q->result, job->result);
+
+		q->head = job->next;
+		if (!q->head)
+			q->tail = &q->head;
+		piglit_readback_destroy(job->rb);
+		free(job->subtest);
+		free(job);
+	}
+}
+
+/**
+ * Submit a case rendered to the given rectangle of the read framebuffer.
+ *
+ * verify is called with the pixels of the rectangle as floats of format,
+ * and data, once the readback completes, on another thread.  It must not
+ * call GL, and owns data.  Its result is reported as the subtest named
+ * subtest, in order with the other cases of the queue.
+ */
+void
+piglit_verify_queue_submit(struct piglit_verify_queue *q, const char *subtest,
+			   int x, int y, int w, int h, GLenum format,
+			   piglit_verify_func verify, void *data)
+{
+	struct verify_job *job = calloc(1, sizeof(*job));
+
+	job->subtest = strdup(subtest);
+	job->rb = piglit_read_pixels_float_async(x, y, w, h, format);
+	job->width = w;
+	job->height = h;
+	job->verify = verify;
+	job->data = data;
+
+	*q->tail = job;
+	q->tail = &job->next;
+	if (!q->unsent)
+		q->unsent = job;
+	q->num_unsent++;
+
+	while (q->num_unsent > q->depth)
+		send_job(q);
+	report_jobs(q, false);
+}
+
+/**
+ * Verify the cases left, report their results and destroy the queue.
+ * Return the results of all the cases merged.
+ */
+enum piglit_result
+piglit_verify_queue_finish(struct piglit_verify_queue *q)
+{
+	enum piglit_result result;
+
+	while (q->unsent)
+		send_job(q);
+	report_jobs(q, true);
+
+#ifdef PIGLIT_HAS_PTHREADS
+	if (q->has_thread) {
+		pthread_mutex_lock(&q->lock);
+		q->quit = true;
+		pthread_cond_signal(&q->queued);
+		pthread_mutex_unlock(&q->lock);
+		pthread_join(q->thread, NULL);
+	}
+	pthread_cond_destroy(&q->verified);
+	pthread_cond_destroy(&q->queued);
+	pthread_mutex_destroy(&q->lock);
+#endif
+
+	result = q->result;
+	free(q);
+	return result;
+}
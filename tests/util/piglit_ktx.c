@@ -26,6 +26,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "config.h"
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
 #include "piglit_ktx.h"
 #include "piglit-util-gl.h"
 
@@ -51,6 +56,21 @@ struct piglit_ktx {
 	/** \brief The raw KTX data. */
 	void *data;
 
+	/** \brief Whether data is a mapping of the file, of mapped_size. */
+	bool mapped;
+	size_t mapped_size;
+
+	/** \brief Upload the images through a pixel unpack buffer. */
+	bool use_pbo;
+
+	/**
+	 * \brief What the image data pointers are relative to while loading.
+	 *
+	 * This is data while a pixel unpack buffer with a copy of data is
+	 * bound, NULL otherwise.
+	 */
+	const uint8_t *upload_base;
+
 	/**
 	 * \brief Array of images.
 	 *
@@ -82,6 +102,11 @@ piglit_ktx_destroy(struct piglit_ktx *self)
 	if (self->images != NULL)
 		free(self->images);
 
+#ifdef HAVE_SYS_MMAN_H
+	if (self->mapped)
+		munmap(self->data, self->mapped_size);
+	else
+#endif
 	if (self->data)
 		free(self->data);
 
@@ -432,17 +457,32 @@ piglit_ktx_read_file(const char *filename)
 	if (error)
 		goto bad_read;
 
-	self->data = malloc(self->info.size);
-	if (self->data == NULL)
-		goto out_of_memory;
-
+#ifdef HAVE_SYS_MMAN_H
 	/*
-	 * On Unix, one should mmap() here rather than copy. But this code
-	 * needs to support Windows too.
+	 * The images point into the mapping, so the file is only read as the
+	 * images are uploaded.
 	 */
-	size_read = fread(self->data, 1, self->info.size, file);
-	if (size_read < self->info.size)
-		goto bad_read;
+	if (self->info.size > 0) {
+		self->data = mmap(NULL, self->info.size, PROT_READ,
+				  MAP_PRIVATE, fileno(file), 0);
+		if (self->data == MAP_FAILED) {
+			self->data = NULL;
+		} else {
+			self->mapped = true;
+			self->mapped_size = self->info.size;
+		}
+	}
+#endif
+
+	if (self->data == NULL) {
+		self->data = malloc(self->info.size);
+		if (self->data == NULL)
+			goto out_of_memory;
+
+		size_read = fread(self->data, 1, self->info.size, file);
+		if (size_read < self->info.size)
+			goto bad_read;
+	}
 
 	ok = piglit_ktx_parse_data(self);
 	goto end;
@@ -569,6 +609,22 @@ piglit_ktx_get_image(struct piglit_ktx *self,
 		return &self->images[miplevel];
 }
 
+/**
+ * \brief The pixels argument of glTexImage() for img.
+ *
+ * When uploading through a pixel unpack buffer this is the offset of the
+ * image in the buffer.
+ */
+static const void *
+piglit_ktx_image_pixels(const struct piglit_ktx *self,
+			const struct piglit_ktx_image *img)
+{
+	if (self->upload_base == NULL)
+		return img->data;
+
+	return (const void *)((const uint8_t *) img->data - self->upload_base);
+}
+
 static bool
 piglit_ktx_load_cubeface(struct piglit_ktx *self,
                          int image,
@@ -576,6 +632,7 @@ piglit_ktx_load_cubeface(struct piglit_ktx *self,
 {
 	const struct piglit_ktx_info *info = &self->info;
 	const struct piglit_ktx_image *img = &self->images[image];
+	const void *pixels = piglit_ktx_image_pixels(self, img);
 
 	GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + (image % 6);
 	int level = image / 6;
@@ -588,7 +645,7 @@ piglit_ktx_load_cubeface(struct piglit_ktx *self,
 				       img->pixel_height,
 				       0 /*border*/,
 				       img->size,
-				       img->data);
+				       pixels);
 	else
 		glTexImage2D(face,
 			     level,
@@ -598,7 +655,7 @@ piglit_ktx_load_cubeface(struct piglit_ktx *self,
 			     0 /*border*/,
 			     info->gl_format,
 			     info->gl_type,
-			     img->data);
+			     pixels);
 
 	*gl_error = glGetError();
 	return *gl_error == 0;
@@ -611,6 +668,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 {
 	const struct piglit_ktx_info *info = &self->info;
 	const struct piglit_ktx_image *img = &self->images[image];
+	const void *pixels = piglit_ktx_image_pixels(self, img);
 	int level = image;
 
 	switch (info->target) {
@@ -624,7 +682,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_width,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       pixels);
 		else
 			glTexImage1D(info->target,
 				     level,
@@ -633,7 +691,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     pixels);
 		break;
 	case GL_TEXTURE_1D_ARRAY:
 	case GL_TEXTURE_2D:
@@ -646,7 +704,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_height,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       pixels);
 		else
 			glTexImage2D(info->target,
 				     level,
@@ -656,7 +714,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     pixels);
 		break;
 	case GL_TEXTURE_CUBE_MAP_ARRAY:
 		if (piglit_is_gles())
@@ -675,7 +733,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_depth,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       pixels);
 		else
 			glTexImage3D(info->target,
 				     level,
@@ -686,7 +744,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     pixels);
 		break;
 	default:
 		*gl_error = 0;
@@ -743,6 +801,22 @@ target_to_texture_binding(GLuint target)
 	return 0;
 }
 
+static bool
+piglit_ktx_has_pbo(void)
+{
+	if (piglit_is_gles())
+		return piglit_get_gl_version() >= 30;
+
+	return piglit_get_gl_version() >= 21 ||
+	       piglit_is_extension_supported("GL_ARB_pixel_buffer_object");
+}
+
+void
+piglit_ktx_set_use_pbo(struct piglit_ktx *self, bool use_pbo)
+{
+	self->use_pbo = use_pbo;
+}
+
 bool
 piglit_ktx_load_texture(struct piglit_ktx *self,
 			GLuint *tex_name,
@@ -769,6 +843,13 @@ piglit_ktx_load_texture(struct piglit_ktx *self,
 	 */
 	GLint old_unpack_alignment;
 
+	/*
+	 * The pixel unpack buffer the images are uploaded from, and the one
+	 * bound before this function call.
+	 */
+	GLuint pbo = 0;
+	GLint old_unpack_buffer = 0;
+
 	bool made_texture = false;
 
 	bool ok = true;
@@ -809,6 +890,21 @@ piglit_ktx_load_texture(struct piglit_ktx *self,
 	if (my_gl_error)
 		goto fail;
 
+	if (self->use_pbo && piglit_ktx_has_pbo()) {
+		glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING,
+			      &old_unpack_buffer);
+		glGenBuffers(1, &pbo);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, info->size, self->data,
+			     GL_STATIC_DRAW);
+
+		my_gl_error = glGetError();
+		if (my_gl_error)
+			goto fail;
+
+		self->upload_base = self->data;
+	}
+
 	for (i = 0; i < info->num_images; ++i) {
 		ok = piglit_ktx_load_image(self, i, &my_gl_error);
 		if (!ok)
@@ -833,6 +929,12 @@ cleanup:
 	while (glGetError())
 		;;
 
+	if (pbo != 0) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, old_unpack_buffer);
+		glDeleteBuffers(1, &pbo);
+		self->upload_base = NULL;
+	}
+
 	glBindTexture(info->target, old_bound_tex);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, old_unpack_alignment);
 	return ok;
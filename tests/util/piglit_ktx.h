@@ -191,7 +191,8 @@ piglit_ktx_destroy(struct piglit_ktx *self);
 /**
  * \brief Read KTX data from a file.
  *
- * The file is read until EOF.
+ * The file is read until EOF. Where mmap() is available the file is mapped
+ * rather than copied, and the image data points into the mapping.
  *
  * Return null on error, including I/O error and invalid data.
  */
@@ -249,6 +250,17 @@ piglit_ktx_get_image(struct piglit_ktx *self,
 		     int miplevel,
 		     int cube_face);
 
+/**
+ * \brief Upload the images of piglit_ktx_load_texture() through a pixel
+ * unpack buffer.
+ *
+ * The KTX data is copied into one buffer object, from which the images are
+ * uploaded. This is ignored if the context doesn't support pixel buffer
+ * objects.
+ */
+void
+piglit_ktx_set_use_pbo(struct piglit_ktx *self, bool use_pbo);
+
 /**
  * \brief Load texture into the GL with glTexImage().
  *
@@ -153,3 +153,12 @@ unsigned float3_to_r11g11b10f(const float rgb[3])
           ((f32_to_uf11(rgb[1]) & 0x7ff) << 11) |
           ((f32_to_uf10(rgb[2]) & 0x3ff) << 22);
 }
+
+/* Pack count RGB triples. */
+void float3_to_r11g11b10f_array(unsigned *dst, const float *src, size_t count)
+{
+   size_t i;
+
+   for (i = 0; i < count; i++)
+      dst[i] = float3_to_r11g11b10f(src + 3 * i);
+}
@@ -24,6 +24,8 @@
 #ifndef R11G11B10F_H
 #define R11G11B10F_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -31,6 +33,8 @@ extern "C" {
 unsigned f32_to_uf11(float val);
 unsigned f32_to_uf10(float val);
 unsigned float3_to_r11g11b10f(const float rgb[3]);
+void float3_to_r11g11b10f_array(unsigned *dst, const float *src,
+				size_t count);
 
 #ifdef __cplusplus
 }
@@ -130,8 +130,7 @@ unsigned float3_to_rgb9e5(const float rgb[3])
    exp_shared = MAX2(-RGB9E5_EXP_BIAS-1, FloorLog2(maxrgb)) + 1 + RGB9E5_EXP_BIAS;
    assert(exp_shared <= RGB9E5_MAX_VALID_BIASED_EXP);
    assert(exp_shared >= 0);
-   /* This pow function could be replaced by a table. */
-   denom = pow(2, exp_shared - RGB9E5_EXP_BIAS - RGB9E5_MANTISSA_BITS);
+   denom = ldexp(1.0, exp_shared - RGB9E5_EXP_BIAS - RGB9E5_MANTISSA_BITS);
 
    maxm = (int) floor(maxrgb / denom + 0.5);
    if (maxm == MAX_RGB9E5_MANTISSA+1) {
@@ -169,9 +168,27 @@ void rgb9e5_to_float3(unsigned rgb, float retval[3])
 
    v.raw = rgb;
    exponent = v.field.biasedexponent - RGB9E5_EXP_BIAS - RGB9E5_MANTISSA_BITS;
-   scale = (float) pow(2, exponent);
+   scale = ldexpf(1.0f, exponent);
 
    retval[0] = v.field.r * scale;
    retval[1] = v.field.g * scale;
    retval[2] = v.field.b * scale;
 }
+
+/* Unpack count values to RGB triples. */
+void rgb9e5_to_float3_array(float *dst, const unsigned *src, size_t count)
+{
+   size_t i;
+
+   for (i = 0; i < count; i++)
+      rgb9e5_to_float3(src[i], dst + 3 * i);
+}
+
+/* Pack count RGB triples. */
+void float3_to_rgb9e5_array(unsigned *dst, const float *src, size_t count)
+{
+   size_t i;
+
+   for (i = 0; i < count; i++)
+      dst[i] = float3_to_rgb9e5(src + 3 * i);
+}
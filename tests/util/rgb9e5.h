@@ -24,12 +24,16 @@
 #ifndef RGB9E5_H
 #define RGB9E5_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void rgb9e5_to_float3(unsigned rgb, float retval[3]);
 unsigned float3_to_rgb9e5(const float rgb[3]);
+void rgb9e5_to_float3_array(float *dst, const unsigned *src, size_t count);
+void float3_to_rgb9e5_array(unsigned *dst, const float *src, size_t count);
 
 #ifdef __cplusplus
 }
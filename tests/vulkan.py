@@ -2,17 +2,21 @@
 # -*- coding: utf-8 -*-
 """All Vulkan tests that come with piglit, using default settings."""
 
+import collections
 import os
 
+from framework.options import OPTIONS
 from framework.profile import TestProfile
 from framework import grouptools
-from framework.test.piglit_test import VkRunnerTest
+from framework.test.piglit_test import VkRunnerTest, MultiVkRunnerTest
 from .py_modules.constants import TESTS_DIR, GENERATED_TESTS_DIR
 
 __all__ = ['profile']
 
 profile = TestProfile()
 
+vk_tests = collections.defaultdict(list)
+
 # Find and add all shader tests.
 for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
     _basedir = os.path.join(basedir, 'vulkan')
@@ -24,8 +28,26 @@ for basedir in [TESTS_DIR, GENERATED_TESTS_DIR]:
             testname, ext = os.path.splitext(filename)
             if ext != '.vk_shader_test':
                 continue
+            if not OPTIONS.process_isolation:
+                vk_tests[groupname].append(os.path.join(dirname, filename))
+                continue
+
             test = VkRunnerTest(os.path.join(dirname, filename))
             group = grouptools.join(groupname, testname)
             assert group not in profile.test_list, group
 
             profile.test_list[group] = test
+
+# Without process isolation the files of a directory are run by a single
+# vkrunner, as for the shader_runner tests.
+for group, files in vk_tests.items():
+    assert group not in profile.test_list, 'duplicate group: {}'.format(group)
+
+    # This makes the xml output reproducible, as os.walk() order is random
+    files.sort()
+    if len(files) == 1:
+        group = grouptools.join(
+            group, os.path.splitext(os.path.basename(files[0]))[0])
+        profile.test_list[group] = VkRunnerTest(files[0])
+    else:
+        profile.test_list[group] = MultiVkRunnerTest(files)
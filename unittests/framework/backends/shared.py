@@ -36,7 +36,7 @@ INITIAL_METADATA = {
 # changes. This does not contain piglit specific objects, only strings, floats,
 # ints, and Nones (instead of JSON's null)
 JSON = {
-    "results_version": 10,
+    "results_version": 11,
     "time_elapsed": {
         "start": 1469638791.2351687,
         "__type__": "TimeAttribute",
@@ -0,0 +1,117 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the binary backend."""
+
+import copy
+import json
+from unittest import mock
+
+import pytest
+
+from framework import backends
+from framework import exceptions
+from framework import results
+
+from . import shared
+
+# pylint: disable=no-self-use,protected-access
+
+
+@pytest.fixture(scope='module', autouse=True)
+def mock_compression():
+    with mock.patch.dict(backends.binary.compression.os.environ,
+                         {'PIGLIT_COMPRESSION': 'none'}):
+        yield
+
+
+def _encode(obj):
+    return json.loads(json.dumps(obj, default=backends.json.piglit_encoder))
+
+
+class TestBinaryBackend(object):
+    """Tests for the BinaryBackend class."""
+
+    def test_finalize(self, tmpdir):
+        """finalize writes a results.pbr that loads back."""
+        test = backends.binary.BinaryBackend(str(tmpdir))
+        test.initialize(shared.INITIAL_METADATA)
+        with test.write_test('a@b') as t:
+            t(results.TestResult('fail'))
+        test.finalize()
+
+        assert tmpdir.join('results.pbr').check()
+        assert not tmpdir.join('tests').check()
+
+        result = backends.load(str(tmpdir))
+        assert result.tests['a@b'].result == 'fail'
+
+    def test_no_tests(self, tmpdir):
+        """finalize raises when no tests were run."""
+        test = backends.binary.BinaryBackend(str(tmpdir))
+        test.initialize(shared.INITIAL_METADATA)
+        with pytest.raises(exceptions.PiglitUserError):
+            test.finalize()
+
+
+class TestWriteResults(object):
+    """Tests for the write_results function."""
+
+    @pytest.fixture
+    def result(self):
+        test = results.TestResult('pass')
+        test.returncode = -6
+        test.subtests['x'] = 'fail'
+        test.subtests.set_time('x', 0.5)
+        failed = results.TestResult('crash')
+        failed.out = 'first run'
+        test.add_attempt(failed)
+
+        data = copy.deepcopy(shared.JSON)
+        data.pop('totals', None)
+        data['tests']['group@test'] = test.to_json()
+        return results.TestrunResult.from_dict(data)
+
+    def test_round_trip(self, tmpdir, result):
+        """The loaded results are the ones that were written."""
+        path = str(tmpdir.join('results.pbr'))
+        backends.binary.write_results(result, path)
+
+        loaded = backends.load(path)
+        assert _encode(loaded.to_json()) == _encode(result.to_json())
+
+    def test_smaller_than_json(self, tmpdir, result):
+        """Repeated strings are only stored once."""
+        for i in range(100):
+            test = results.TestResult('pass')
+            test.command = 'bin/foo -auto -fbo'
+            test.environment = 'PIGLIT_PLATFORM="gbm"'
+            result.tests['group@test{}'.format(i)] = test
+
+        backends.binary.write_results(result, str(tmpdir.join('r.pbr')))
+        backends.json.write_results(result, str(tmpdir.join('r.json')))
+        assert tmpdir.join('r.pbr').size() * 4 < tmpdir.join('r.json').size()
+
+    def test_bad_magic(self, tmpdir):
+        """A file that isn't in the binary format is a fatal error."""
+        tmpdir.join('results.pbr').write('not results')
+        with pytest.raises(exceptions.PiglitFatalError):
+            backends.load(str(tmpdir.join('results.pbr')))
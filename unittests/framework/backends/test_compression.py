@@ -63,6 +63,18 @@ def _has_xz_bin():
     return True
 
 
+def _has_zstd():
+    """Check for the zstandard module or a zstd binary."""
+    if compression._ZSTD_MODULE:
+        return True
+    try:
+        subprocess.check_call(['zstd', '--version'],
+                              stdout=subprocess.DEVNULL)
+    except (subprocess.CalledProcessError, OSError):
+        return False
+    return True
+
+
 @pytest.fixture
 def env():
     with mock.patch.dict('os.environ'):
@@ -174,6 +186,32 @@ class TestXZBin(object):
         assert actual == 'foo'
 
 
+@pytest.mark.skipif(not _has_zstd(), reason='zstd is not available')
+class TestZstd(object):
+    """Tests for zstd compression."""
+
+    def test_roundtrip(self, tmpdir):
+        """Text written with zst compression is read back."""
+        testfile = tmpdir.join('test.zst')
+        with compression.COMPRESSORS['zst'](str(testfile)) as f:
+            f.write('foo')
+
+        with compression.DECOMPRESSORS['zst'](str(testfile)) as f:
+            actual = f.read()
+
+        assert actual == 'foo'
+
+    def test_extension(self, tmpdir, config):
+        """write_compressed gives zst compressed files a .zst suffix."""
+        tmpdir.chdir()
+        config.set('core', 'compression', 'zst')
+
+        with abstract.write_compressed('results.txt.xz') as f:
+            f.write('foo')
+
+        assert 'results.txt.zst' in os.listdir('.')
+
+
 class TestGetMode(object):
     """Tests for the compression.get_mode function."""
 
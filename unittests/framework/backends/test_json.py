@@ -67,7 +67,7 @@ class TestJSONBackend(object):
         """Tests for the write_test method."""
 
         def test_write(self, tmpdir):
-            """The write method should create a file."""
+            """The write method should create the log."""
             p = str(tmpdir)
             test = backends.json.JSONBackend(p)
             test.initialize(shared.INITIAL_METADATA)
@@ -75,7 +75,7 @@ class TestJSONBackend(object):
             with test.write_test('bar') as t:
                 t(results.TestResult())
 
-            assert tmpdir.join('tests/0.json').check()
+            assert tmpdir.join('tests', backends.json.LOG_NAME).check()
 
         def test_load(self, tmpdir):
             """Test that the written JSON can be loaded.
@@ -91,8 +91,19 @@ class TestJSONBackend(object):
             with test.write_test('bar') as t:
                 t(results.TestResult())
 
-            with tmpdir.join('tests/0.json').open('r') as f:
-                json.load(f)
+            records = list(backends.json._read_log(
+                str(tmpdir.join('tests', backends.json.LOG_NAME))))
+            assert [list(r.keys()) for r in records] == [['bar'], ['bar']]
+
+        def test_incomplete_first(self, tmpdir):
+            """The test is logged as incomplete before it has a result."""
+            p = str(tmpdir)
+            test = backends.json.JSONBackend(p)
+            test.initialize(shared.INITIAL_METADATA)
+
+            with test.write_test('bar'):
+                resumed = backends.json._resume(p)
+                assert resumed.tests['bar'].result == 'incomplete'
 
     class TestFinalize(object):
         """Tests for the finalize method."""
@@ -218,6 +229,55 @@ class TestResume(object):
             {'group1/test1', 'group1/test2', 'group2/test3'}
 
 
+    def test_load_last_result(self, tmpdir):
+        """backends.json._resume: only the last record of a test counts."""
+        f = str(tmpdir)
+        backend = backends.json.JSONBackend(f)
+        backend.initialize(shared.INITIAL_METADATA)
+        with backend.write_test("group1/test1") as t:
+            t(results.TestResult('fail'))
+        with backend.write_test("group1/test2") as t:
+            t(results.TestResult('pass'))
+        test = backends.json._resume(f)
+
+        assert test.tests['group1/test1'].result == 'fail'
+        assert test.tests['group1/test2'].result == 'pass'
+
+    def test_load_truncated(self, tmpdir):
+        """backends.json._resume: ignores a record cut short by a crash."""
+        f = str(tmpdir)
+        backend = backends.json.JSONBackend(f)
+        backend.initialize(shared.INITIAL_METADATA)
+        with backend.write_test("group1/test1") as t:
+            t(results.TestResult('fail'))
+        with backend.write_test("group1/test2") as t:
+            t(results.TestResult('pass'))
+        backend._close_log()
+        log = tmpdir.join('tests', backends.json.LOG_NAME)
+        log.write_binary(log.read_binary()[:-10])
+        test = backends.json._resume(f)
+
+        assert test.tests['group1/test1'].result == 'fail'
+        assert test.tests['group1/test2'].result == 'incomplete'
+
+    def test_load_legacy_files(self, tmpdir):
+        """backends.json._resume: loads one file per test results."""
+        f = str(tmpdir)
+        backend = backends.json.JSONBackend(f)
+        backend.initialize(shared.INITIAL_METADATA)
+        tmpdir.join('tests', '0.json').write(json.dumps(
+            {'group1/test1': results.TestResult('incomplete').to_json()},
+            default=backends.json.piglit_encoder))
+        tmpdir.join('tests', '1.json').write(json.dumps(
+            {'group1/test2': results.TestResult('pass').to_json()},
+            default=backends.json.piglit_encoder))
+        with backend.write_test("group1/test1") as t:
+            t(results.TestResult('fail'))
+        test = backends.json._resume(f)
+
+        assert test.tests['group1/test1'].result == 'fail'
+        assert test.tests['group1/test2'].result == 'pass'
+
     def test_load_incomplete(self, tmpdir):
         """backends.json._resume: loads incomplete results.
 
@@ -243,6 +303,118 @@ class TestResume(object):
             {'group1/test1', 'group1/test2', 'group2/test3', 'group2/test4'}
 
 
+class TestResumeState(object):
+    """Tests for the resume_state function."""
+
+    @pytest.fixture
+    def run(self, tmpdir):
+        """A run that crashed while writing the result of group2/test4."""
+        backend = backends.json.JSONBackend(str(tmpdir))
+        backend.initialize(shared.INITIAL_METADATA)
+        with mock.patch('framework.backends.json.CHECKPOINT_INTERVAL', 0):
+            with backend.write_test("group1/test1") as t:
+                t(results.TestResult('fail'))
+            with backend.write_test("group1/test2") as t:
+                pass
+        with backend.write_test("group2/test3") as t:
+            t(results.TestResult('pass'))
+        with backend.write_test("group2/test4") as t:
+            t(results.TestResult('pass'))
+        backend._close_log()
+        log = tmpdir.join('tests', backends.json.LOG_NAME)
+        log.write_binary(log.read_binary()[:-10])
+        return tmpdir
+
+    def test_finished(self, run):
+        """The tests with a final result are excluded."""
+        test, exclude = backends.json.resume_state(str(run))
+
+        assert test.name == shared.INITIAL_METADATA['name']
+        assert exclude == {'group1/test1', 'group2/test3'}
+
+    def test_no_retry(self, run):
+        """With no_retry the incomplete tests are excluded as well."""
+        _, exclude = backends.json.resume_state(str(run), no_retry=True)
+
+        assert exclude == {'group1/test1', 'group1/test2', 'group2/test3',
+                           'group2/test4'}
+
+    def test_checkpoint(self, run):
+        """The tests after the checkpoint are added to it."""
+        backends.json.resume_state(str(run))
+        names, offset = backends.json._read_checkpoint(str(run.join('tests')))
+
+        assert names == ['group1/test1', 'group2/test3']
+        assert offset == run.join('tests', backends.json.LOG_NAME).size()
+
+    def test_resumed_results(self, run):
+        """The records of the resumed run follow the cut off one."""
+        backends.json.resume_state(str(run))
+        backend = backends.json.JSONBackend(str(run))
+        with backend.write_test("group2/test4") as t:
+            t(results.TestResult('warn'))
+        test = backends.json._resume(str(run))
+
+        assert test.tests['group2/test4'].result == 'warn'
+
+
+class TestBlobs(object):
+    """Tests for the blobs of the results file."""
+
+    warning = 'Mesa warning: this warning is printed by every single test\n'
+
+    @pytest.fixture
+    def result_dir(self, tmpdir):
+        test = backends.json.JSONBackend(str(tmpdir))
+        test.initialize(shared.INITIAL_METADATA)
+        for name in ['a', 'b', 'c']:
+            result = results.TestResult('pass')
+            result.err = self.warning
+            result.out = 'short'
+            with test.write_test(name) as t:
+                t(result)
+        test.finalize(
+            {'time_elapsed':
+                results.TimeAttribute(start=0.0, end=1.0).to_json()})
+        return tmpdir
+
+    def test_stored_once(self, result_dir):
+        """A string shared by several tests is stored once."""
+        with result_dir.join('results.json').open('r') as f:
+            json_ = json.load(f)
+        assert list(json_['blobs'].values()) == [self.warning]
+        refs = {json.dumps(t['err']) for t in json_['tests'].values()}
+        assert len(refs) == 1
+
+    def test_short_inline(self, result_dir):
+        """Short strings are kept in the tests."""
+        with result_dir.join('results.json').open('r') as f:
+            json_ = json.load(f)
+        assert json_['tests']['a']['out'] == 'short'
+
+    def test_loaded(self, result_dir):
+        """The references are replaced when loading."""
+        test = backends.json.load_results(str(result_dir), 'none')
+        assert test.tests['b'].err == self.warning
+        assert test.tests['b'].out == 'short'
+
+    def test_write_results(self, tmpdir):
+        """write_results stores blobs that load back."""
+        run = results.TestrunResult()
+        run.name = 'name'
+        result = results.TestResult('fail')
+        result.environment = 'PIGLIT_PLATFORM="gbm" ' * 4
+        run.tests['a'] = result
+        p = tmpdir.join('results.json')
+        backends.json.write_results(run, str(p))
+
+        with p.open('r') as f:
+            json_ = json.load(f)
+        assert json_['blobs']
+        json_ = backends.json._expand_blobs(json_)
+        assert json_['tests']['a']['environment'] == result.environment
+
+
 class TestLoadResults(object):
     """Tests for the load_results function."""
 
@@ -269,6 +441,37 @@ class TestLoadResults(object):
         assert isinstance(backends.json.load_results(str(p), 'none'),
                           results.TestrunResult)
 
+    def test_index_written(self, tmpdir):
+        """backends.json.load_results: writes an index next to the file."""
+        p = tmpdir.join('results.json')
+        p.write(json.dumps(shared.JSON))
+        backends.json.load_results(str(p), 'none')
+        assert tmpdir.join('.results.json.index').check()
+
+    def test_index_loaded(self, tmpdir):
+        """backends.json.load_results: uses the index once it exists."""
+        p = tmpdir.join('results.json')
+        p.write(json.dumps(shared.JSON))
+        expected = backends.json.load_results(str(p), 'none')
+        test = backends.json.load_results(str(p), 'none')
+
+        name = next(iter(expected.tests))
+        assert isinstance(test.tests[name], results.LazyTestResult)
+        assert test.tests[name].result == expected.tests[name].result
+        assert test.tests[name].out == expected.tests[name].out
+        assert test.totals == expected.totals
+
+    def test_index_out_of_date(self, tmpdir):
+        """backends.json.load_results: ignores an index of another file."""
+        p = tmpdir.join('results.json')
+        p.write(json.dumps(shared.JSON))
+        backends.json.load_results(str(p), 'none')
+        p.write(json.dumps(shared.JSON) + ' ')
+        test = backends.json.load_results(str(p), 'none')
+
+        assert not isinstance(next(iter(test.tests.values())),
+                              results.LazyTestResult)
+
 
 class TestWriteResults(object):
     """Tests for the write_results function."""
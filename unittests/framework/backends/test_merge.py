@@ -0,0 +1,158 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+
+"""Tests for merging results files."""
+
+import io
+import json
+from unittest import mock
+
+import pytest
+
+from framework import backends
+from framework import exceptions
+from framework import results
+from framework.backends import merge
+
+from . import shared
+
+# pylint: disable=no-self-use,protected-access
+
+
+@pytest.fixture(scope='module', autouse=True)
+def mock_compression():
+    with mock.patch.dict(backends.json.compression.os.environ,
+                         {'PIGLIT_COMPRESSION': 'none'}):
+        yield
+
+
+def _run(path, tests, name='name'):
+    """Write a results file with tests, a dict of name to status."""
+    backend = backends.json.JSONBackend(str(path))
+    metadata = dict(shared.INITIAL_METADATA)
+    metadata['name'] = name
+    backend.initialize(metadata)
+    for test, status in tests.items():
+        result = results.TestResult(status)
+        result.out = 'the output of {}\n'.format(test) * 4
+        with backend.write_test(test) as t:
+            t(result)
+    backend.finalize(
+        {'time_elapsed': results.TimeAttribute(start=1.0, end=2.0).to_json()})
+    return str(path.join('results.json'))
+
+
+class TestStream(object):
+    """Tests for the _Stream class."""
+
+    def test_values(self):
+        """members and value read an object member by member."""
+        doc = {'a': [1, 2.5, None], 'b': {'c': 'd'}, 'e': 123456}
+        stream = merge._Stream(io.StringIO(json.dumps(doc, indent=4)))
+        stream._CHUNK = 3
+        read = {}
+        for key in stream.members():
+            read[key] = stream.value()
+        assert read == doc
+
+    def test_empty(self):
+        stream = merge._Stream(io.StringIO(' { } '))
+        assert list(stream.members()) == []
+
+
+class TestMerge(object):
+    """Tests for the merge function."""
+
+    def test_finalize_sorted(self, tmpdir):
+        """The tests of a results file are written sorted by name."""
+        path = _run(tmpdir, {'c': 'pass', 'a': 'pass', 'b': 'fail'})
+        with open(path) as f:
+            assert list(json.load(f)['tests']) == ['a', 'b', 'c']
+
+    def test_merge(self, tmpdir):
+        """The tests of all of the files are in the output."""
+        one = _run(tmpdir.mkdir('one'), {'a': 'pass', 'c': 'fail'})
+        two = _run(tmpdir.mkdir('two'), {'b': 'skip', 'd': 'pass'})
+        out = merge.merge([one, two], str(tmpdir.join('out.json')))
+
+        result = backends.load(out)
+        assert sorted(result.tests) == ['a', 'b', 'c', 'd']
+        assert result.tests['c'].result == 'fail'
+        assert result.tests['d'].out == 'the output of d\n' * 4
+        assert result.name == 'name'
+
+    def test_directories(self, tmpdir):
+        """Results directories can be given."""
+        _run(tmpdir.mkdir('one'), {'a': 'pass'})
+        _run(tmpdir.mkdir('two'), {'b': 'pass'})
+        out = merge.merge([str(tmpdir.join('one')), str(tmpdir.join('two'))],
+                          str(tmpdir.join('out.json')), name='merged')
+        result = backends.load(out)
+        assert sorted(result.tests) == ['a', 'b']
+        assert result.name == 'merged'
+
+    @pytest.mark.parametrize('policy, expected', [
+        ('worst', 'fail'),
+        ('best', 'pass'),
+        ('first', 'skip'),
+        ('last', 'pass'),
+    ])
+    def test_policy(self, tmpdir, policy, expected):
+        """Duplicates are resolved by the policy."""
+        paths = [_run(tmpdir.mkdir(str(i)), {'a': s})
+                 for i, s in enumerate(['skip', 'fail', 'pass'])]
+        out = merge.merge(paths, str(tmpdir.join('out.json')), policy)
+        assert backends.load(out).tests['a'].result == expected
+
+    def test_policy_error(self, tmpdir):
+        """The error policy makes duplicates fatal."""
+        paths = [_run(tmpdir.mkdir(str(i)), {'a': 'pass'}) for i in range(2)]
+        with pytest.raises(exceptions.PiglitFatalError):
+            merge.merge(paths, str(tmpdir.join('out.json')), 'error')
+        assert not tmpdir.join('out.json').check()
+
+    def test_unsorted(self, tmpdir):
+        """Files whose tests aren't sorted are still merged."""
+        one = _run(tmpdir.mkdir('one'), {'a': 'pass', 'c': 'pass'})
+        with open(one) as f:
+            data = json.load(f)
+        data['tests'] = dict(reversed(list(data['tests'].items())))
+        with open(one, 'w') as f:
+            json.dump(data, f)
+        two = _run(tmpdir.mkdir('two'), {'b': 'pass'})
+
+        out = merge.merge([one, two], str(tmpdir.join('out.json')))
+        with open(out) as f:
+            assert list(json.load(f)['tests']) == ['a', 'b', 'c']
+
+    def test_time(self, tmpdir):
+        """The time of the merged run spans the runs."""
+        one = _run(tmpdir.mkdir('one'), {'a': 'pass'})
+        two = _run(tmpdir.mkdir('two'), {'b': 'pass'})
+        with open(two) as f:
+            data = json.load(f)
+        data['time_elapsed']['end'] = 5.0
+        with open(two, 'w') as f:
+            json.dump(data, f)
+
+        out = merge.merge([one, two], str(tmpdir.join('out.json')))
+        assert backends.load(out).time_elapsed.delta == '0:00:04'
@@ -105,6 +105,14 @@ class TestGFXReconstructBackend(object):
                 '''.format(version, version)
                 ret.stdout = bytearray(textwrap.dedent(version_output), 'utf-8')
 
+            return ret
+        elif '--measurement-frame-range' in cmd:
+            # VK profile
+            ret = subprocess.CompletedProcess(cmd, 0)
+            ret.stdout = bytearray('35.650065 fps, 0.280504 seconds, '
+                                   '10 frames, 1 loop, framerange 1-10\n',
+                                   'utf-8')
+            ret.stderr = b''
             return ret
         elif cmd[0].endswith(self.gfxrecon_replay):
             # VK replay
@@ -328,6 +336,23 @@ class TestGFXReconstructBackend(object):
         for call in calls.split(','):
             assert path.exists(snapshot_prefix + call + '.png')
 
+    def test_dump_vk_raw_images(self):
+        """Tests for the dump method: raw images.
+
+        Check the screenshots are left as BMPs instead of being encoded to PNG
+        when raw images are requested.
+
+        """
+        calls = self.vk_trace_calls
+        trace_path = self.vk_trace_path
+        test = backends.gfxreconstruct.GFXReconstructBackend(
+            trace_path, calls=calls.split(','), raw_images=True)
+        assert test.dump()
+        snapshot_prefix = trace_path + '-'
+        for call in calls.split(','):
+            assert path.exists(snapshot_prefix + call + '.bmp')
+            assert not path.exists(snapshot_prefix + call + '.png')
+
     def test_dump_vk_wrong_call(self):
         """Tests for the dump method: explicit invalid call.
 
@@ -436,3 +461,29 @@ class TestGFXReconstructBackend(object):
             stdout=subprocess.PIPE, stderr=sys.stderr)
         for call in calls.split(','):
             assert not path.exists(snapshot_prefix + call + '.png')
+
+    def test_profile_vk(self):
+        """Tests for the profile method.
+
+        Check the mean frame time of the measurement range reported by
+        gfxrecon-replay, leaving out the first frame.
+
+        """
+        trace_path = self.vk_trace_path
+        test = backends.gfxreconstruct.GFXReconstructBackend(trace_path)
+        assert test.profile() == [28050400]
+        self.m_gfxreconstruct_subprocess_run.assert_called_with(
+            [self.gfxrecon_replay,
+             '--measurement-frame-range', '1-' + self.vk_trace_last_call,
+             trace_path],
+            stdout=subprocess.PIPE, stderr=subprocess.PIPE, env=None)
+
+    @pytest.mark.raises(exception=backends.DumpBackendError)
+    def test_profile_vk_last_frame_fails(self):
+        """Tests for the profile method: the call to figure out the last frame
+        fails.
+
+        """
+        test = backends.gfxreconstruct.GFXReconstructBackend(
+            self.vk_last_frame_fails_trace_path)
+        test.profile()
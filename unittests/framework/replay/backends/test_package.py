@@ -45,6 +45,9 @@ class TestBackend():
     def dump(self):
         return [self._trace_path]
 
+    def profile(self):
+        return [len(self._trace_path)]
+
 # Prevent pytest from trying to collect TestBackend as tests:
 TestBackend.__test__ = False
 
@@ -91,3 +94,23 @@ class TestDump(object):
         implemented.
         """
         backends.dump('foo.test_backend')
+
+
+class TestProfile(object):
+    """Tests for the profile function."""
+
+    @pytest.mark.parametrize("backend", [
+        (TestBackend),
+    ])
+    def test_basic(self, mock_backend):  # pylint: disable=unused-argument
+        """backends.profile: works as expected."""
+        p = 'foo.test_backend'
+        test = backends.profile(p)
+        assert [len(p)] == test
+
+    @pytest.mark.raises(exception=backends.DumpBackendError)
+    def test_unknown(self):
+        """backends.profile(): An error is raised if no backend is registered
+        for an extension.
+        """
+        backends.profile('foo.test_extension')
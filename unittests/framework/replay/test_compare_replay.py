@@ -32,6 +32,7 @@ import contextlib
 import io
 import os
 
+from concurrent.futures import Future
 from os import path
 
 from framework import exceptions, status
@@ -40,22 +41,45 @@ from framework.replay import compare_replay
 from framework.replay.options import OPTIONS
 
 
+class _SerialExecutor(object):
+    """An executor running the jobs in this process as they are submitted."""
+
+    def __init__(self, max_workers, initializer, initargs):
+        initializer(*initargs)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        pass
+
+    def submit(self, fn, *args):
+        future = Future()
+        future.set_result(fn(*args))
+        return future
+
+
 class TestCompareReplay(object):
     """Tests for compare_replay methods."""
 
     @staticmethod
-    def _create_dump(trace_path, results_path, calls):
+    def _create_dump(trace_path, results_path, calls, ext='.png'):
         p = path.join(results_path,
-                      path.basename(trace_path) + '-' + str(calls) + '.png')
+                      path.basename(trace_path) + '-' + str(calls) + ext)
         os.makedirs(path.dirname(p), exist_ok=True)
         with open(p, 'w') as f:
             f.write('content')
 
     @staticmethod
-    def mock_backends_dump(trace_path, results_path, calls):
+    def mock_backends_dump(trace_path, results_path, calls, **kwargs):
         if trace_path.endswith('KhronosGroup-Vulkan-Tools/amd/polaris10/vkcube.gfxr'):
             TestCompareReplay._create_dump(trace_path, results_path, 99)
 
+            return True
+        elif trace_path.endswith('raw/image.gfxr'):
+            assert kwargs.get('raw_images')
+            TestCompareReplay._create_dump(trace_path, results_path, 5, '.bmp')
+
             return True
         elif trace_path.endswith('pathfinder/demo.trace'):
             TestCompareReplay._create_dump(trace_path, results_path, 78)
@@ -83,6 +107,8 @@ class TestCompareReplay(object):
         elif image_file.endswith(
                 'pathfinder/demo.trace-78.png'):
             return 'e624d76c70cc3c532f4f54439e13659a'
+        elif image_file.endswith('raw/image.gfxr-5.bmp'):
+            return '917cbbf4f09dd62ea26d247a1c70c16e'
         else:
             raise exceptions.PiglitFatalError(
                 'Non treated image file: {}'.format(image_file))
@@ -134,6 +160,8 @@ class TestCompareReplay(object):
         OPTIONS.device_name = 'test-device'
         OPTIONS.db_path = tmpdir.mkdir('db-path').strpath
         OPTIONS.results_path = tmpdir.mkdir('results').strpath
+        OPTIONS.jobs = 1
+        OPTIONS.gpus = []
         self.trace_path = 'KhronosGroup-Vulkan-Tools/amd/polaris10/vkcube.gfxr'
         self.exp_checksum = '917cbbf4f09dd62ea26d247a1c70c16e'
         self.results_partial_path = path.join('results/trace',
@@ -241,6 +269,44 @@ class TestCompareReplay(object):
                      '  ' + self.trace_path + '\n'
                      '\n')
 
+    def test_from_yaml_jobs(self, mocker):
+        """compare_replay.from_yaml: traces checked in jobs print like when checked one after the other"""
+
+        mocker.patch('framework.replay.compare_replay.ProcessPoolExecutor',
+                     _SerialExecutor)
+        environ = mocker.patch.dict(os.environ, clear=False)
+
+        serial = io.StringIO()
+        with contextlib.redirect_stdout(serial):
+            assert (compare_replay.from_yaml('two-traces.yml')
+                    is status.PASS)
+
+        OPTIONS.jobs = 2
+        OPTIONS.gpus = ['1002:73bf']
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            assert (compare_replay.from_yaml('two-traces.yml')
+                    is status.PASS)
+        assert f.getvalue() == serial.getvalue()
+        assert self.m_backends_dump.call_count == 4
+        assert environ['DRI_PRIME'] == '1002:73bf'
+        assert environ['MESA_VK_DEVICE_SELECT'] == '1002:73bf'
+
+    def test_from_yaml_jobs_fail(self, mocker):
+        """compare_replay.from_yaml: the result of traces checked in jobs is kept"""
+
+        mocker.patch('framework.replay.compare_replay.ProcessPoolExecutor',
+                     _SerialExecutor)
+        mocker.patch(
+            'framework.replay.compare_replay.hexdigest_from_image',
+            return_value='00000000000000000000000000000000')
+
+        OPTIONS.jobs = 2
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            assert (compare_replay.from_yaml('two-traces.yml')
+                    is status.FAIL)
+
     def test_trace_success(self):
         """compare_replay.trace: compare a trace successfully"""
 
@@ -330,6 +396,20 @@ class TestCompareReplay(object):
                           '"image_render": "' + final_image_pathlib.strpath +
                           '"}], "result": "fail"}\n')
 
+    def test_trace_raw_image(self, mocker):
+        """compare_replay.trace: a matching raw image is removed without being encoded"""
+
+        m_encode_png = mocker.patch(
+            'framework.replay.compare_replay._encode_png')
+        trace_path = 'raw/image.gfxr'
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            assert (compare_replay.trace(trace_path, self.exp_checksum)
+                    is status.PASS)
+        m_encode_png.assert_not_called()
+        assert not self.tmpdir.join(self.results_partial_path,
+                                    'raw/image.gfxr-5.bmp').check()
+
     @pytest.mark.parametrize('trace_path', [
         ('glmark2/jellyfish.rdc'),
         ('unimplemented/backend.vktrace'),
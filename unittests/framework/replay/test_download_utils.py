@@ -113,6 +113,7 @@ class TestDownloadUtils(object):
         self.trace_file = tmpdir.join(self.trace_path)
         OPTIONS.set_download_url(self.url)
         OPTIONS.download['force'] = False
+        OPTIONS.download['cache_dir'] = None
         OPTIONS.db_path = tmpdir.strpath
         requests_mock.get(self.full_url, text='remote')
         requests_mock.head(self.full_url, text='remote')
@@ -277,6 +278,46 @@ class TestDownloadUtils(object):
         download_utils.download(self.full_url, self.trace_file, None)
         assert Path(self.trace_file).exists()
 
+    def test_ensure_file_verified_once(self, create_mock_response, mocker):
+        """download_utils.ensure_file: Check a downloaded file isn't hashed again"""
+
+        etag = MockedResponse.header_scenarios()["With etag"]["etag"]
+        create_mock_response(self.full_url, {"etag": etag})
+        download_utils.ensure_file(self.trace_path)
+        assert path.exists(str(self.trace_file) + '.verified')
+
+        calc_etags = mocker.patch('framework.replay.download_utils.calc_etags')
+        download_utils.ensure_file(self.trace_path)
+        calc_etags.assert_not_called()
+
+    def test_ensure_file_changed_is_verified(self, create_mock_response, mocker):
+        """download_utils.ensure_file: Check a file changed after its download is hashed again"""
+
+        etag = MockedResponse.header_scenarios()["With etag"]["etag"]
+        create_mock_response(self.full_url, {"etag": etag})
+        download_utils.ensure_file(self.trace_path)
+        self.trace_file.write("local")
+
+        with pytest.raises(exceptions.PiglitFatalError):
+            download_utils.ensure_file(self.trace_path)
+
+    def test_ensure_file_from_cache(self, create_mock_response, requests_mock,
+                                    tmpdir):
+        """download_utils.ensure_file: Check a cached file isn't downloaded again"""
+
+        OPTIONS.download['cache_dir'] = tmpdir.join('cache').strpath
+        etag = MockedResponse.header_scenarios()["With etag"]["etag"]
+        create_mock_response(self.full_url, {"etag": etag})
+        download_utils.ensure_file(self.trace_path)
+        assert path.exists(download_utils.get_cache().path(etag))
+
+        OPTIONS.db_path = tmpdir.join('other').strpath
+        requests_mock.reset_mock()
+        download_utils.ensure_file(self.trace_path)
+        assert Path(OPTIONS.db_path, self.trace_path).read_bytes() == \
+            MockedResponseData.binary_data
+        assert [r.method for r in requests_mock.request_history] == ['HEAD']
+
     def test_minio_authorization(self, requests_mock):
         """download_utils.ensure_file: Check we send the authentication headers to MinIO"""
         requests_mock.post(self.url, text=ASSUME_ROLE_RESPONSE)
@@ -343,3 +384,50 @@ class TestGetChunkSize(object):
         """get_chunk_size: Test various filesize and chunk combinations"""
         result = download_utils.get_chunk_size(filesize, number_of_chunks)
         assert result == expected_chunk_size, f"Expected {expected_chunk_size / 1024 / 1024} MB but got {result / 1024 / 1024} MB"
+
+
+class TestPrefetcher(object):
+    """Tests for the Prefetcher class."""
+
+    @staticmethod
+    def drain(prefetcher):
+        # pylint: disable=protected-access
+        prefetcher._executor.shutdown(wait=True)
+
+    def test_fetches_ahead(self):
+        """download_utils.Prefetcher: Check only the next files are fetched"""
+        fetched = []
+        prefetcher = download_utils.Prefetcher(
+            ['a', 'b', 'c', 'd', 'e'], fetch=fetched.append, ahead=2, jobs=1)
+        prefetcher.wait('a')
+        self.drain(prefetcher)
+
+        assert fetched == ['a', 'b', 'c']
+
+    def test_wait_fetches_more(self):
+        """download_utils.Prefetcher: Check waiting moves the files fetched ahead"""
+        fetched = []
+        prefetcher = download_utils.Prefetcher(
+            ['a', 'b', 'c', 'd', 'e'], fetch=fetched.append, ahead=1, jobs=1)
+        prefetcher.wait('c')
+        self.drain(prefetcher)
+
+        assert fetched == ['a', 'b', 'c', 'd']
+
+    def test_failure_is_left_to_user(self):
+        """download_utils.Prefetcher: Check a failed fetch doesn't raise"""
+        def fetch(_):
+            raise exceptions.PiglitFatalError('missing')
+
+        prefetcher = download_utils.Prefetcher(['a'], fetch=fetch)
+        prefetcher.wait('a')
+
+    def test_unknown_file(self):
+        """download_utils.Prefetcher: Check waiting on another file returns"""
+        fetched = []
+        prefetcher = download_utils.Prefetcher(
+            ['a'], fetch=fetched.append, ahead=0)
+        prefetcher.wait('b')
+        self.drain(prefetcher)
+
+        assert fetched == ['a']
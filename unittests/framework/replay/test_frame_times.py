@@ -28,6 +28,7 @@
 
 import contextlib
 import io
+import json
 from os import path
 from subprocess import CompletedProcess
 
@@ -45,9 +46,10 @@ class TestFrameTimes(object):
         return self._cmd
 
     def mock_profile(self, trace_path):
-        backends.apitrace._run_command(self._cmd.args, self._env)
+        backends.abstract.DumpBackend._run_profile_command(self._cmd.args,
+                                                           self._env)
         if trace_path.endswith('KhronosGroup-Vulkan-Tools/amd/polaris10/vkcube.gfxr'):
-            return None
+            raise backends.DumpBackendError('vkcube.gfxr failed')
         elif trace_path.endswith('pathfinder/demo.trace'):
             return [0, 1, 2, 3, 4, 5, 6, 7, 8, 9]
         else:
@@ -115,11 +117,11 @@ class TestFrameTimes(object):
         self._cmd = CompletedProcess(["command", "args"], 0, "stdout", "stderr")
         self._env = {}
         self.m_subprocess_run = mocker.patch(
-            "framework.replay.backends.apitrace.subprocess.run",
+            "framework.replay.backends.abstract.subprocess.run",
             side_effect=self.mock_run,
         )
         self.m_profile = mocker.patch(
-            "framework.replay.frame_times.APITraceBackend.profile",
+            "framework.replay.frame_times.backends.profile",
             side_effect=self.mock_profile,
         )
         self.tmpdir = tmpdir
@@ -135,18 +137,32 @@ class TestFrameTimes(object):
         s = f.getvalue()
         assert s == ''
 
-    @pytest.mark.parametrize("trace_path", ["one-trace.yml", "two-traces.yml"])
-    def test_from_yaml_traces(self, trace_path):
-        """frame_times.from_yaml: profile using a YAML files with one or more trace path"""
+    def test_from_yaml_one_trace(self):
+        """frame_times.from_yaml: profile using a YAML file with one trace path"""
 
         f = io.StringIO()
         with contextlib.redirect_stdout(f):
-            assert frame_times.from_yaml(trace_path) is status.PASS
+            assert frame_times.from_yaml('one-trace.yml') is status.PASS
         self.m_qty_load_yaml.assert_called_once()
         self.m_ensure_file.assert_called_once()
         self.m_profile.assert_called_once()
         s: list[str] = f.getvalue().splitlines()
-        assert s[-1] == f"[frame_times] {len(self.exp_frame_times)}"
+        assert f"[frame_times] {len(self.exp_frame_times)}" in s
+        assert s[-1].startswith("[frame_times] mean: ")
+
+    def test_from_yaml_two_traces(self):
+        """frame_times.from_yaml: profile the traces of every backend, one of
+        them failing"""
+
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            assert frame_times.from_yaml('two-traces.yml') is status.CRASH
+        self.m_qty_load_yaml.assert_called_once()
+        assert self.m_ensure_file.call_count == 2
+        assert self.m_profile.call_count == 2
+        s: list[str] = f.getvalue().splitlines()
+        assert f"[frame_times] {len(self.exp_frame_times)}" in s
+        assert s[-1] == "[frame_times] error"
 
     def test_trace_success(self):
         """frame_times.trace: profile a trace successfully"""
@@ -159,11 +175,36 @@ class TestFrameTimes(object):
         self.m_ensure_file.assert_called_once()
         self.m_profile.assert_called_once()
         s = f.getvalue()
-        assert s.endswith('PIGLIT: '
-                          '{"images": [{'
-                          '"image_desc": "' + self.trace_path + '", '
-                          '"frame_times": ' + str(self.exp_frame_times) +
-                          '}], "result": "pass"}\n')
+        assert s.endswith('\n')
+        output = json.loads(s.splitlines()[-1][len('PIGLIT: '):])
+        assert output['result'] == 'pass'
+        assert output['images'] == [{'image_desc': self.trace_path,
+                                     'frame_times': self.exp_frame_times}]
+        # The first 5 frames are left out as warm up
+        assert output['metrics']['frame_time_mean']['value'] == 7.0
+        assert output['metrics']['frame_time_mean']['samples'] == 5
+
+    def test_trace_iterations(self, mocker):
+        """frame_times.trace: profile a trace several times, leaving out the
+        warm up iterations"""
+
+        mocker.patch('framework.replay.frame_times._ITERATIONS', '3')
+        mocker.patch('framework.replay.frame_times._WARMUP_ITERATIONS', '1')
+        self.m_profile.side_effect = [[100] * 10,
+                                      self.exp_frame_times,
+                                      self.exp_frame_times]
+        f = io.StringIO()
+        with contextlib.redirect_stdout(f):
+            assert (frame_times.trace(self.trace_path)
+                    is status.PASS)
+        assert self.m_profile.call_count == 3
+        s = f.getvalue()
+        output = json.loads(s.splitlines()[-1][len('PIGLIT: '):])
+        assert output['images'][0]['frame_times'] == ([100] * 10 +
+                                                      self.exp_frame_times * 2)
+        # The first iteration and 5 frames of the others are left out
+        assert output['metrics']['frame_time_mean']['value'] == 7.0
+        assert output['metrics']['frame_time_mean']['samples'] == 10
 
     def test_trace_fail(self):
         """frame_times.trace: fail profiling a trace"""
@@ -198,3 +239,38 @@ class TestFrameTimes(object):
         s = f.getvalue()
         assert stderr_msg.decode() in s
         assert stdout_msg.decode() in s
+
+
+class TestFrameTimeStats(object):
+    """Tests for frame_times.frame_time_stats."""
+
+    def test_stats(self):
+        """frame_times.frame_time_stats: mean, variance and percentiles"""
+
+        metrics = frame_times.frame_time_stats([2, 4, 4, 4, 5, 5, 7, 9])
+        mean = metrics['frame_time_mean']
+        assert mean['value'] == 5.0
+        assert mean['variance'] == pytest.approx(32 / 7)
+        assert mean['samples'] == 8
+        # t(0.975, 7) * stddev / sqrt(8)
+        assert mean['ci'] == pytest.approx(2.365 * (32 / 7) ** 0.5 / 8 ** 0.5)
+        assert mean['unit'] == 'ns'
+        assert metrics['frame_time_p50']['value'] == 4.5
+        assert metrics['frame_time_p90']['value'] == pytest.approx(7.6)
+        assert metrics['frame_time_p99']['value'] == pytest.approx(8.86)
+
+    def test_warmup(self):
+        """frame_times.frame_time_stats: the warm up frames are left out"""
+
+        metrics = frame_times.frame_time_stats([100, 100, 1, 1], warmup=2)
+        assert metrics['frame_time_mean']['value'] == 1.0
+        assert metrics['frame_time_mean']['samples'] == 2
+        assert metrics['frame_time_mean']['ci'] == 0.0
+        assert not metrics['frame_time_mean']['noisy']
+
+    def test_warmup_longer_than_frames(self):
+        """frame_times.frame_time_stats: all the frames are used if they are all warm up"""
+
+        metrics = frame_times.frame_time_stats([3], warmup=5)
+        assert metrics['frame_time_mean']['value'] == 3.0
+        assert metrics['frame_time_p99']['value'] == 3.0
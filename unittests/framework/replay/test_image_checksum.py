@@ -25,9 +25,12 @@
 
 """Tests for replayer's image_checksum module."""
 
+import hashlib
+
 import pytest
 
 import PIL
+import PIL.Image
 
 from framework.replay import image_checksum
 
@@ -39,3 +42,36 @@ def test_hexdigest_from_image_UnidentifiedImageError(tmpdir):
     f = tmpdir.join("image.png")
     f.write("content")
     image_checksum.hexdigest_from_image(f.strpath)
+
+
+def _image(mode):
+    # Larger than a chunk, so that the pixels are hashed in several
+    size = (300, 200)
+    data = bytes(range(256)) * (size[0] * size[1] * len(mode) // 256 + 1)
+    return PIL.Image.frombytes(mode, size, data[:size[0] * size[1] * len(mode)])
+
+
+@pytest.mark.parametrize('mode', ['RGB', 'RGBA'])
+def test_hexdigest_from_image_tobytes(tmpdir, mode):
+    """image_checksum.hexdigest_from_image: Check the checksum is the MD5 of the pixels"""
+
+    image = _image(mode)
+    f = tmpdir.join("image.png")
+    image.save(f.strpath)
+
+    assert (image_checksum.hexdigest_from_image(f.strpath) ==
+            hashlib.md5(image.tobytes()).hexdigest())
+
+
+@pytest.mark.parametrize('mode', ['RGB', 'RGBA'])
+def test_hexdigest_from_image_raw(tmpdir, mode):
+    """image_checksum.hexdigest_from_image: Check a BMP has the checksum of the PNG encoded from it"""
+
+    bmp = tmpdir.join("image.bmp")
+    png = tmpdir.join("image.png")
+    _image(mode).save(bmp.strpath)
+    with PIL.Image.open(bmp.strpath) as image:
+        image.save(png.strpath)
+
+    assert (image_checksum.hexdigest_from_image(bmp.strpath) ==
+            image_checksum.hexdigest_from_image(png.strpath))
@@ -0,0 +1,103 @@
+# coding=utf-8
+#
+# Copyright © 2026 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included
+# in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+# OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+# ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# SPDX-License-Identifier: MIT
+
+
+"""Tests for replayer's trace_cache module."""
+
+import os
+
+import pytest
+
+from framework.replay import trace_cache
+
+# pylint: disable=invalid-name
+# pylint: disable=no-self-use
+
+
+@pytest.mark.parametrize("size, expected", [
+    ("0", 0),
+    ("512", 512),
+    ("4K", 4096),
+    ("50G", 50 << 30),
+    ("2MiB", 2 << 20),
+    ("1 t", 1 << 40),
+])
+def test_parse_size(size, expected):
+    """trace_cache.parse_size: Check sizes with and without units"""
+    assert trace_cache.parse_size(size) == expected
+
+
+@pytest.mark.raises(exception=ValueError)
+def test_parse_size_invalid():
+    """trace_cache.parse_size: Check an invalid size raises"""
+    trace_cache.parse_size("lots")
+
+
+class TestTraceCache(object):
+    """Tests for trace_cache.TraceCache."""
+
+    @pytest.fixture(autouse=True)
+    def setup(self, tmpdir):
+        self.tmpdir = tmpdir
+        self.cache = trace_cache.TraceCache(tmpdir.join('cache').strpath)
+
+    def trace(self, name, size):
+        trace = self.tmpdir.join(name)
+        trace.write(b'x' * size, mode='wb')
+        return trace.strpath
+
+    def test_get_missing(self):
+        """TraceCache.get: Check an uncached trace isn't placed"""
+        dest = self.tmpdir.join('dest').strpath
+        assert self.cache.get('"abc"', dest) is None
+        assert not os.path.exists(dest)
+
+    def test_put_get(self):
+        """TraceCache.get: Check a cached trace is placed without copying"""
+        self.cache.put('"ABC"', self.trace('a', 10))
+        dest = self.tmpdir.join('dest').strpath
+
+        assert self.cache.get('abc', dest) in ('reflink', 'hardlink')
+        with open(dest, 'rb') as f:
+            assert f.read() == b'x' * 10
+
+    def test_evicts_least_recently_used(self):
+        """TraceCache.evict: Check the least recently used traces go first"""
+        self.cache.max_size = 25
+        for etag in ('aa', 'bb'):
+            self.cache.put(etag, self.trace(etag, 10))
+            os.utime(self.cache.path(etag), ns=(0, 0))
+        self.cache.get('aa', self.tmpdir.join('dest').strpath)
+
+        self.cache.put('cc', self.trace('cc', 10))
+
+        assert os.path.exists(self.cache.path('aa'))
+        assert not os.path.exists(self.cache.path('bb'))
+        assert os.path.exists(self.cache.path('cc'))
+
+    def test_keeps_new_trace(self):
+        """TraceCache.evict: Check a trace larger than the cache is kept"""
+        self.cache.max_size = 5
+        self.cache.put('aa', self.trace('aa', 10))
+        assert os.path.exists(self.cache.path('aa'))
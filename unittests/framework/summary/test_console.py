@@ -141,3 +141,72 @@ class TestPrintResult(object):
         actual, _ = capsys.readouterr()
 
         assert expected == actual
+
+
+class TestPrintPerf(object):
+    """Tests for the _print_perf function."""
+
+    def test_basic(self, capsys):
+        """summary.console_._print_perf: prints the change from the first run.
+        """
+        reses = []
+        for value in [100.0, 90.0]:
+            res = results.TestrunResult()
+            res.tests[grouptools.join('perf', 'foo')] = \
+                results.TestResult('pass')
+            res.tests[grouptools.join('perf', 'foo')].metrics['1M'] = {
+                'value': value, 'unit': 'ms'}
+            res.tests['bar'] = results.TestResult('pass')
+            reses.append(res)
+
+        expected = 'perf/foo: 1M: 100 ms, 90 ms (+10.0%)\n'
+        console_._print_perf(common.Results(reses))
+        actual, _ = capsys.readouterr()
+
+        assert expected == actual
+
+
+class TestPrintResources(object):
+    """Tests for the _print_resources function."""
+
+    def test_basic(self, capsys):
+        """summary.console_._print_resources: prints each run's usage."""
+        reses = []
+        for utime in [1.0, 2.0]:
+            res = results.TestrunResult()
+            res.tests['foo'] = results.TestResult('pass')
+            res.tests['foo'].resources.update(
+                utime=utime, maxrss=1 << 21, gpu={'render': 5e8})
+            res.tests['bar'] = results.TestResult('pass')
+            reses.append(res)
+
+        expected = ('foo: user: 1 s, 2 s\n'
+                    'foo: max rss: 2 MiB, 2 MiB\n'
+                    'foo: gpu render: 0.5 s, 0.5 s\n')
+        console_._print_resources(common.Results(reses))
+        actual, _ = capsys.readouterr()
+
+        assert expected == actual
+
+
+class TestPrintTime(object):
+    """Tests for the _print_time function."""
+
+    def test_basic(self, capsys):
+        """summary.console_._print_time: prints the slowest tests with their
+        change from the first run.
+        """
+        reses = []
+        for name, seconds in [('old', 2.0), ('new', 1.0)]:
+            res = results.TestrunResult()
+            res.name = name
+            res.tests[grouptools.join('a', 'foo')] = results.TestResult('pass')
+            res.tests[grouptools.join('a', 'foo')].time.end = seconds
+            reses.append(res)
+
+        console_._print_time(common.Results(reses), 20)
+        actual, _ = capsys.readouterr()
+
+        assert 'slowest tests:\n    a/foo: 2.00 s, 1.00 s (-50.0%)\n' in actual
+        assert 'slowest subtests' not in actual
+        assert '    a (new):       0       0       1       0       0\n' in actual
@@ -83,7 +83,9 @@ class TestFeatResult(object):
         result.name = 'foo'
 
         with mock.patch('framework.summary.feature.profile.load_test_profile',
-                        mock.Mock(return_value=PROFILE)):
+                        mock.Mock(return_value=PROFILE)), \
+                mock.patch.dict('os.environ', {'PIGLIT_CACHE_DIR': str(
+                    tmpdir_factory.mktemp('cache'))}):
             return feature.FeatResults([result], str(p))
 
     def test_basic(self, feature):
@@ -103,3 +105,37 @@ class TestFeatResult(object):
         """feat_status is populated."""
         assert feature.feat_status == \
             {'foo': {'spec@gl-1.0': 'pass', 'spec@gl-2.0': 'fail'}}
+
+
+class TestFeatureIndex(object):
+    """Tests for feature_index."""
+
+    @pytest.fixture(autouse=True)
+    def cache_dir(self, tmpdir):
+        with mock.patch.dict('os.environ',
+                             {'PIGLIT_CACHE_DIR': str(tmpdir.join('cache'))}):
+            yield
+
+    def test_members(self):
+        """A feature has the tests included and not excluded."""
+        data = {'f': {'include_tests': 'gl-1.0', 'exclude_tests': '@[cd]$',
+                      'target_rate': 50}}
+        assert feature.feature_index(PROFILE, data) == \
+            {'f': {'spec@gl-1.0@a', 'spec@gl-1.0@b'}}
+
+    def test_cached(self):
+        """The regexes aren't matched again for the same profile."""
+        feature.feature_index(PROFILE, DATA)
+        with mock.patch('framework.summary.feature.profile.RegexFilter',
+                        side_effect=AssertionError):
+            index = feature.feature_index(PROFILE, DATA)
+        assert index['spec@gl-2.0'] == \
+            {grouptools.join('spec@gl-2.0', t) for t in 'abcd'}
+
+    def test_changed(self):
+        """Changed feature descriptions aren't taken from the cache."""
+        feature.feature_index(PROFILE, DATA)
+        data = {'spec@gl-1.0': dict(DATA['spec@gl-1.0'], exclude_tests='a')}
+        assert feature.feature_index(PROFILE, data) == \
+            {'spec@gl-1.0': {'spec@gl-1.0@b', 'spec@gl-1.0@c',
+                             'spec@gl-1.0@d'}}
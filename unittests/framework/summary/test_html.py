@@ -23,9 +23,13 @@
 
 # pylint: disable=protected-access
 
+import json
 import os
 
-from framework.summary import html_
+import pytest
+
+from framework import results, status
+from framework.summary import common, html_
 
 
 def test_copy_static(tmpdir):
@@ -34,3 +38,71 @@ def test_copy_static(tmpdir):
     html_._copy_static_files(str(tmpdir))
     assert os.path.exists('index.css'), 'index.css not created correctly'
     assert os.path.exists('result.css'), 'result.css not created correctly'
+
+
+def test_digests_roundtrip(tmpdir):
+    """summary.html_._load_digests: loads what _write_digests wrote"""
+    html_._write_digests(str(tmpdir), {'a/b.html': 1})
+    assert html_._load_digests(str(tmpdir)) == {'a/b.html': 1}
+
+
+def test_digests_missing(tmpdir):
+    """summary.html_._load_digests: returns nothing without digests"""
+    assert html_._load_digests(str(tmpdir)) == {}
+
+
+def test_digest_changes_with_result():
+    """summary.html_._test_digest: depends on the result of the test"""
+    assert html_._test_digest(results.TestResult('pass')) != \
+        html_._test_digest(results.TestResult('fail'))
+
+
+class TestClientSide(object):
+    """Tests for the client side summary."""
+
+    @staticmethod
+    def _load(path, callback):
+        """Return the arguments of the call in a data script."""
+        text = path.read()
+        prefix = 'piglit.{}('.format(callback)
+        assert text.startswith(prefix)
+        return json.loads('[' + text[len(prefix):-len(');\n')] + ']')
+
+    @pytest.fixture
+    def summary(self, tmpdir, mocker):
+        mocker.patch('framework.summary.html_._SHARD_SIZE', 2)
+        run = results.TestrunResult()
+        run.name = 'run'
+        for name in ['a@b', 'a@c', 'd', 'e@f']:
+            run.tests[name] = results.TestResult('pass')
+        run.tests['e@f'].subtests['g'] = 'fail'
+        run.tests['d'].result = 'skip'
+        run.calculate_group_totals()
+
+        html_._make_client_side(common.Results([run]), str(tmpdir),
+                                frozenset([status.SKIP]), jobs=1)
+        return tmpdir
+
+    def test_index(self, summary):
+        """summary.html_._make_client_side: writes the status of every test
+        """
+        index = self._load(summary.join('data', 'index.js'), 'index')[0]
+        assert index['tests'] == ['a@b', 'a@c', 'd', 'e@f@g']
+        assert [index['statuses'][c] for c in index['results'][0]] == \
+            ['pass', 'pass', 'skip', 'fail']
+        assert index['pages']['problems'] == [3]
+        assert index['groups']['a'] == [['pass', '2/2']]
+
+    def test_shards(self, summary):
+        """summary.html_._make_client_side: splits the details by name"""
+        index = self._load(summary.join('data', 'index.js'), 'index')[0]
+        assert index['shards'] == [['a@b', 'e@f']]
+
+        _, _, data = self._load(summary.join('data', 'tests-0-1.js'), 'shard')
+        assert list(data) == ['e@f']
+        assert data['e@f']['subtests']['g'] == 'fail'
+
+    def test_page(self, summary):
+        """summary.html_._make_client_side: copies the page and its script"""
+        assert summary.join('index.html').check()
+        assert summary.join('summary.js').check()
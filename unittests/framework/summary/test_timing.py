@@ -0,0 +1,90 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for framework.summary.timing."""
+
+from framework import results
+from framework import grouptools
+from framework.summary import timing
+
+# pylint: disable=no-self-use
+
+
+def _result(status, seconds):
+    result = results.TestResult(status)
+    result.time.end = seconds
+    return result
+
+
+def _testrun(times, name='run'):
+    res = results.TestrunResult()
+    res.name = name
+    for test, (status, seconds) in times.items():
+        res.tests[test] = _result(status, seconds)
+    return res
+
+
+class TestTiming(object):
+    """Tests for the Timing class."""
+
+    def test_groups(self):
+        """The time of a group is the sum of the tests in it at any depth."""
+        inst = timing.Timing(_testrun({
+            grouptools.join('a', 'b', 'c'): ('pass', 1.0),
+            grouptools.join('a', 'd'): ('pass', 2.0),
+        }))
+        assert inst.groups[grouptools.join('a', 'b')] == 1.0
+        assert inst.groups['a'] == 3.0
+
+    def test_lost(self):
+        """The time of tests that timed out or crashed is counted as lost."""
+        inst = timing.Timing(_testrun({
+            'a': ('timeout', 10.0),
+            'b': ('crash', 2.0),
+            'c': ('fail', 1.0),
+        }))
+        assert inst.lost == {'timeout': 10.0, 'crash': 2.0}
+        assert inst.total == 13.0
+
+    def test_subtests(self):
+        """Subtests are listed with the times their test recorded."""
+        res = _testrun({'a': ('pass', 3.0)})
+        res.tests['a'].subtests['x'] = 'pass'
+        res.tests['a'].subtests.set_time('x', 2.5)
+        inst = timing.Timing(res)
+        assert inst.subtests == {grouptools.join('a', 'x'): 2.5}
+
+    def test_histogram(self):
+        """Each test of the group is counted in the bucket of its time."""
+        inst = timing.Timing(_testrun({
+            grouptools.join('a', 'b'): ('pass', 0.05),
+            grouptools.join('a', 'c'): ('pass', 0.5),
+            grouptools.join('a', 'd'): ('pass', 100.0),
+            'ab': ('pass', 5.0),
+        }))
+        assert inst.histogram('a') == [1, 1, 0, 0, 1]
+
+
+def test_slowest():
+    """The slowest names are those that took longest in any run."""
+    first = timing.Timing(_testrun({'a': ('pass', 1.0), 'b': ('pass', 2.0)}))
+    second = timing.Timing(_testrun({'a': ('pass', 3.0), 'c': ('pass', 0.5)}))
+    assert timing.slowest([first, second], 'tests', 2) == ['a', 'b']
@@ -21,8 +21,10 @@
 
 """ Tests for the exectest module """
 
+import gzip
 import os
 import textwrap
+import threading
 try:
     import subprocess32 as subprocess
 except ImportError:
@@ -144,6 +146,7 @@ class TestTest(object):
                 # mock out subprocess.Popen with our proxy object
                 mock_subp = mocker.patch('framework.test.base.subprocess')
                 mock_subp.Popen = proxy
+                mocker.patch('framework.test.base._Popen', proxy)
                 mock_subp.TimeoutExpired = subprocess.TimeoutExpired
                 test.run()
 
@@ -189,6 +192,117 @@ class TestTest(object):
             test.run()
             assert test.result.result is status.TIMEOUT
 
+    @skip.posix
+    class TestProcessLoop(object):
+        """Tests for Test._run_command with OPTIONS.process_loop."""
+
+        @pytest.fixture(autouse=True)
+        def process_loop(self, mocker):
+            mocker.patch.object(base.OPTIONS, 'process_loop', True)
+
+        def test_output(self):
+            """stdout, stderr and the returncode are collected."""
+            test = _Test(['sh', '-c', 'echo out; echo err >&2; exit 3'])
+            test.run()
+            assert test.result.out == 'out\n'
+            assert test.result.err == 'err\n'
+            assert test.result.returncode == 3
+
+        def test_concurrent(self):
+            """Tests waited on from several threads get their own output."""
+            tests = [_Test(['sh', '-c', 'sleep 0.1; echo {}'.format(i)])
+                     for i in range(8)]
+            threads = [threading.Thread(target=t.run) for t in tests]
+            for t in threads:
+                t.start()
+            for t in threads:
+                t.join()
+            assert [t.result.out for t in tests] == \
+                ['{}\n'.format(i) for i in range(8)]
+
+        @pytest.mark.timeout(6)
+        def test_timeout(self):
+            """Tests running longer than the timeout are killed."""
+            test = _Test(['sleep', '60'])
+            test.timeout = 1
+            test.run()
+            assert test.result.result is status.TIMEOUT
+
+        def test_resources(self):
+            """The resource usage of the process is recorded."""
+            test = _Test(['sh', '-c', 'exit 0'])
+            test.run()
+            assert set(test.result.resources) == {
+                'utime', 'stime', 'maxrss', 'nvcsw', 'nivcsw'}
+            assert test.result.resources['maxrss'] > 0
+
+    @skip.posix
+    class TestOutputLimit(object):
+        """Tests for Test._run_command with OPTIONS.output_limit."""
+
+        @pytest.fixture(autouse=True)
+        def output_limit(self, mocker):
+            mocker.patch.object(base.OPTIONS, 'output_limit', 64)
+
+        def test_short(self):
+            """Output under the limit is kept whole."""
+            test = _Test(['sh', '-c', 'echo out; echo err >&2'])
+            test.run()
+            assert test.result.out == 'out\n'
+            assert test.result.err == 'err\n'
+
+        def test_cut(self):
+            """The head, the tail and the PIGLIT lines are kept."""
+            test = _Test(['sh', '-c',
+                          'echo first; seq 1000; '
+                          'echo \'PIGLIT: {"result": "fail" }\'; '
+                          'seq 1000; echo last'])
+            test.run()
+            out = test.result.out
+            assert out.startswith('first\n1\n')
+            assert out.endswith('1000\nlast\n')
+            assert 'bytes of output omitted' in out
+            assert '\nPIGLIT: {"result": "fail" }\n' in out
+            assert len(out) < 512
+
+        def test_spill(self, mocker, tmpdir):
+            """The whole output of a test that was cut is spilled."""
+            mocker.patch.object(base.OPTIONS, 'output_spill_dir',
+                                str(tmpdir))
+            test = _Test(['sh', '-c', 'seq 1000'])
+            test.run()
+            spilled = tmpdir.listdir()
+            assert len(spilled) == 1
+            assert str(spilled[0]) in test.result.out
+            with gzip.open(str(spilled[0]), 'rt') as f:
+                assert f.read() == ''.join(
+                    '{}\n'.format(i) for i in range(1, 1001))
+
+        def test_no_spill_under_limit(self, mocker, tmpdir):
+            """Nothing is spilled for output that wasn't cut."""
+            mocker.patch.object(base.OPTIONS, 'output_spill_dir',
+                                str(tmpdir))
+            test = _Test(['sh', '-c', 'seq 20'])
+            test.run()
+            assert tmpdir.listdir() == []
+
+    @skip.posix
+    class TestResources(object):
+        """Tests for the resource usage of Test._run_command."""
+
+        def test_recorded(self):
+            """The resource usage of the process is recorded."""
+            test = _Test(['sh', '-c', 'exit 0'])
+            test.run()
+            assert test.result.resources['maxrss'] > 0
+            assert test.result.resources['utime'] >= 0
+
+        def test_returncode(self):
+            """The returncode is kept when reaping with wait4."""
+            test = _Test(['sh', '-c', 'exit 3'])
+            test.run()
+            assert test.result.returncode == 3
+
     class TestExecuteTraceback(object):
         """Test.execute tests for Traceback handling."""
 
@@ -231,6 +345,34 @@ class TestTest(object):
             assert shared_test.exception != ''
             assert isinstance(shared_test.exception, str)
 
+    class TestAdaptiveTimeout(object):
+        """Tests for Test.execute with OPTIONS.adaptive_timeout."""
+
+        @pytest.fixture(autouse=True)
+        def timeouts(self, mocker):
+            mocker.patch.object(base.OPTIONS, 'adaptive_timeout', 'history')
+            mocker.patch.object(base, '_ADAPTIVE_TIMEOUTS', {'a': 5.0})
+
+        @pytest.mark.parametrize('name, timeout, expected', [
+            ('a', None, 5.0),
+            ('a', 60, 5.0),
+            ('a', 2, 2),
+            ('b', 60, 60),
+            ('b', None, None),
+        ])
+        def test_timeout(self, name, timeout, expected):
+            """The shorter of the adaptive and usual timeouts is used."""
+            assert base._adaptive_timeout(name, timeout) == expected
+
+        def test_execute(self, mocker):
+            """execute() sets the timeout of the test before running it."""
+            test = _Test(['foo'])
+            test.run = mocker.Mock()
+            test.execute('a', mocker.Mock(spec=log.BaseLog),
+                         {'dmesg': mocker.Mock(spec=dmesg.BaseDmesg),
+                          'monitor': mocker.Mock(spec=monitoring.Monitoring)})
+            assert test.timeout == 5.0
+
     class TestCommand(object):
         """Tests for Test.command."""
 
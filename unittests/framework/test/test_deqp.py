@@ -26,6 +26,9 @@ tests
 
 """
 
+import os
+import stat
+import sys
 import textwrap
 
 import pytest
@@ -35,6 +38,7 @@ from framework import grouptools
 from framework import profile
 from framework import status
 from framework.test import deqp
+from .. import skip
 
 # pylint:disable=invalid-name,no-self-use
 
@@ -61,6 +65,145 @@ class TestMakeProfile(object):
         assert expected in self.profile.test_list
 
 
+class TestMakeBatches(object):
+    """Tests for deqp.make_batches."""
+
+    def test_by_group(self):
+        """Cases are batched by group, named after the group."""
+        batches = list(deqp.make_batches(
+            ['a.b.c1', 'a.b.c2', 'a.d.c3']))
+        assert batches == [
+            (grouptools.join('a', 'b'), ('a.b.c1', 'a.b.c2')),
+            (grouptools.join('a', 'd'), ('a.d.c3',)),
+        ]
+
+    def test_split(self, mocker):
+        """Groups longer than the batch time are split."""
+        mocker.patch('framework.test.deqp._BATCH_TIME', 10)
+        durations = {
+            grouptools.join('a', 'b', 'c1'): 6.0,
+            grouptools.join('a', 'b', 'c2'): 6.0,
+            grouptools.join('a', 'b', 'c3'): 2.0,
+        }
+        batches = list(deqp.make_batches(['a.b.c1', 'a.b.c2', 'a.b.c3'],
+                                         durations))
+        assert batches == [
+            (grouptools.join('a', 'b'), ('a.b.c1',)),
+            (grouptools.join('a', 'b#2'), ('a.b.c2', 'a.b.c3')),
+        ]
+
+    def test_batched_durations(self, mocker):
+        """Durations of a previous batched run are found."""
+        mocker.patch('framework.test.deqp._BATCH_TIME', 10)
+        durations = {
+            grouptools.join('a', 'b', 'c1'): 6.0,
+            grouptools.join('a', 'b#2', 'c2'): 6.0,
+        }
+        batches = list(deqp.make_batches(['a.b.c1', 'a.b.c2'], durations))
+        assert len(batches) == 2
+
+
+@skip.posix
+class TestBatch(object):
+    """Tests for running a batch of cases in one process."""
+
+    _DEQP = textwrap.dedent("""\
+        import os
+        import sys
+        import time
+
+        arg = [a for a in sys.argv if a.startswith('--deqp-caselist-file=')]
+        with open(arg[0].split('=', 1)[1]) as f:
+            cases = f.read().split()
+        print('dEQP Core 2014.x (0xcafebabe) starting..')
+        for case in cases:
+            print("Test case '{}'..".format(case), flush=True)
+            if case.endswith('crash'):
+                os.abort()
+            elif case.endswith('hang'):
+                time.sleep(60)
+            elif case.endswith('skip'):
+                print('  NotSupported (Not supported)')
+            else:
+                print('  Pass (Pass)')
+        print('DONE!')
+    """)
+
+    @pytest.fixture
+    def test_class(self, tmpdir):
+        bin_ = tmpdir.join('deqp-fake')
+        bin_.write('#!{}\n{}'.format(sys.executable, self._DEQP))
+        os.chmod(str(bin_), stat.S_IRWXU)
+
+        class _Test(deqp.DEQPBaseTest):
+            deqp_bin = str(bin_)
+            extra_args = []
+
+        return _Test
+
+    def test_pass(self, test_class):
+        """Each case is a subtest."""
+        test = test_class(('a.b.c1', 'a.b.c2', 'a.b.skip'))
+        test.run()
+        assert dict(test.result.subtests) == {
+            'c1': status.PASS, 'c2': status.PASS, 'skip': status.SKIP}
+        assert test.result.result is status.PASS
+        assert len(test.result.pid) == 1
+
+    def test_crash(self, test_class):
+        """A crash is recorded and the run resumed from the next case."""
+        test = test_class(('a.b.c1', 'a.b.crash', 'a.b.c2'))
+        test.run()
+        assert dict(test.result.subtests) == {
+            'c1': status.PASS, 'crash': status.CRASH, 'c2': status.PASS}
+        assert test.result.result is status.CRASH
+        assert len(test.result.pid) == 2
+
+    @pytest.mark.timeout(10)
+    def test_timeout(self, test_class):
+        """The timeout applies to each case."""
+        test = test_class(('a.b.c1', 'a.b.hang', 'a.b.c2'))
+        test.timeout = 1
+        test.run()
+        assert dict(test.result.subtests) == {
+            'c1': status.PASS, 'hang': status.TIMEOUT, 'c2': status.PASS}
+
+
+@skip.posix
+class TestGenCaselistTxt(object):
+    """Tests for the gen_caselist_txt function."""
+
+    _DEQP = textwrap.dedent("""\
+        with open('calls', 'a') as f:
+            f.write('x')
+        with open('cases.txt', 'w') as f:
+            f.write('TEST: a.b.c\\n')
+    """)
+
+    @pytest.fixture
+    def bin_(self, tmpdir, mocker):
+        mocker.patch.dict('os.environ',
+                          {'PIGLIT_CACHE_DIR': str(tmpdir.join('cache'))})
+        bin_ = tmpdir.join('deqp-fake')
+        bin_.write('#!{}\n{}'.format(sys.executable, self._DEQP))
+        os.chmod(str(bin_), stat.S_IRWXU)
+        return bin_
+
+    def test_cached(self, bin_):
+        """The binary is only run the first time."""
+        deqp.gen_caselist_txt(str(bin_), 'cases.txt', [])
+        path = deqp.gen_caselist_txt(str(bin_), 'cases.txt', [])
+        assert bin_.dirpath('calls').read() == 'x'
+        assert os.path.exists(path)
+
+    def test_stale(self, bin_):
+        """The binary is run again when the caselist changed."""
+        deqp.gen_caselist_txt(str(bin_), 'cases.txt', [])
+        bin_.dirpath('cases.txt').write('')
+        deqp.gen_caselist_txt(str(bin_), 'cases.txt', [])
+        assert bin_.dirpath('calls').read() == 'xx'
+
+
 class TestIterDeqpTestCases(object):
     """Tests for iter_deqp_test_cases."""
 
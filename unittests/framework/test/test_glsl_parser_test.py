@@ -493,3 +493,82 @@ def test_add_compatibility_requirement_binary(version, extension, tmpdir,
     # The compat extension was added to the slow skipping (C level)
     # requirements
     assert extension in test.command
+
+
+class TestMultiGLSLParserTest(object):
+    """Tests for the MultiGLSLParserTest class."""
+
+    @staticmethod
+    def write_config(filename, version='1.10', extra=''):
+        filename.write(textwrap.dedent("""\
+            // [config]
+            // expect_result: pass
+            // glsl_version: {}
+            // {}
+            // [end config]""".format(version, extra)))
+
+    @pytest.fixture
+    def inst(self, tmpdir):
+        """A fixture that creates an instance to test."""
+        one = tmpdir.join('foo.vert')
+        self.write_config(one, extra='check_link: true')
+        two = tmpdir.join('Bar.frag')
+        self.write_config(two, extra='require_extensions: GL_ARB_foo')
+
+        return glsl.MultiGLSLParserTest.new([str(one), str(two)])
+
+    def test_command(self, inst):
+        command = inst.command
+        assert os.path.basename(command[0]) == 'glslparsertest'
+        assert command[1:3] == ['--batch', '1.10']
+        assert os.path.basename(command[3]) == 'foo.vert'
+        assert command[4:8] == ['pass', '1.10', '--check-link', '--']
+        assert os.path.basename(command[8]) == 'Bar.frag'
+        assert command[9:] == ['pass', '1.10', 'GL_ARB_foo']
+
+    def test_subtests(self, inst):
+        assert inst.subtests == ['foo.vert', 'bar.frag']
+
+    def test_resume(self, inst):
+        actual = inst._resume(1)  # pylint: disable=protected-access
+        assert os.path.basename(actual[0]) == 'glslparsertest'
+        assert actual[1:3] == ['--batch', '1.10']
+        assert os.path.basename(actual[3]) == 'Bar.frag'
+        assert '--' not in actual
+
+    def test_is_subtest(self, inst):
+        assert inst._is_subtest('PIGLIT TEST: 1 - bar.frag')  # pylint: disable=protected-access
+
+    def test_different_versions(self, tmpdir):
+        """Files that want different contexts can't share a batch."""
+        one = tmpdir.join('foo.vert')
+        self.write_config(one)
+        two = tmpdir.join('bar.vert')
+        self.write_config(two, version='1.20')
+
+        with pytest.raises(exceptions.PiglitInternalError):
+            glsl.MultiGLSLParserTest.new([str(one), str(two)])
+
+    def test_skips_left_out(self, inst, mocker):
+        """A file that skips in python isn't passed to glslparsertest."""
+        def test(self):
+            if 'GL_ARB_foo' in self.extensions:
+                raise _TestIsSkip('no foo')
+        mocker.patch('framework.test.opengl.FastSkip.test', test)
+
+        inst._process_skips()  # pylint: disable=protected-access
+        assert inst.result.subtests['bar.frag'] == 'skip'
+        assert inst.command[-1] == '--check-link'
+        assert '--' not in inst.command
+
+    def test_offline_no_skips(self, inst, mocker):
+        """Requirements aren't checked when compiling offline."""
+        def test(self):
+            raise _TestIsSkip('no context')
+        mocker.patch('framework.test.opengl.FastSkip.test', test)
+        mocker.patch.object(glsl.options.OPTIONS, 'glslparser_offline',
+                            'glslang')
+
+        inst._process_skips()  # pylint: disable=protected-access
+        assert inst.result.subtests['bar.frag'] != 'skip'
+        assert '--' in inst.command
@@ -0,0 +1,286 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the piglit_test module."""
+"""Tests for the perf module."""
+
+import io
+import json
+from unittest import mock
+
+import pytest
+
+from framework import results
+from framework import status
+from framework.options import _Options as Options
+from framework.test import perf
+
+# pylint: disable=no-self-use
+# pylint: disable=protected-access
+
+
+def _report(name, median, unit='MB/s', noisy=False, **extra):
+    report = {
+        'test': 'foo', 'name': name, 'unit': unit, 'samples': 5,
+        'rejected': 0, 'median': median, 'mean': median, 'stddev': 1.0,
+        'min': median, 'max': median, 'cv': 0.01, 'noisy': noisy}
+    report.update(extra)
+    return json.dumps(report) + '\n'
+
+
+def _baseline(**metrics):
+    result = results.TestResult()
+    for name, value in metrics.items():
+        result.metrics[name] = {'value': value, 'unit': 'MB/s',
+                                'noisy': name.startswith('noisy')}
+    run = results.TestrunResult()
+    run.tests['foo'] = result
+    return run
+
+
+class TestRelativeChange(object):
+    """Tests for the relative_change function."""
+
+    def test_rate(self):
+        """A higher rate is better."""
+        assert perf.relative_change(110.0, 100.0, 'MB/s') == \
+            pytest.approx(0.1)
+
+    def test_time(self):
+        """A longer time is worse."""
+        assert perf.relative_change(110.0, 100.0, 'ms') == \
+            pytest.approx(-0.1)
+
+    def test_latency(self):
+        """A longer latency, as reported by perf_report_latency(), is worse."""
+        assert perf.relative_change(110.0, 100.0, 'usec') == \
+            pytest.approx(-0.1)
+
+
+class TestCompareToBaseline(object):
+    """Tests for the compare_to_baseline function."""
+
+    @pytest.fixture(autouse=True)
+    def options(self, mocker):
+        opts = Options()
+        opts.perf_baseline = 'baseline.json'
+        mocker.patch('framework.test.perf.OPTIONS', opts)
+
+    @staticmethod
+    def _compare(value, ci, base_ci):
+        base = results.TestResult()
+        base.metrics['mean'] = {'value': 100.0, 'unit': 'ns', 'ci': base_ci,
+                                'noisy': True}
+        run = results.TestrunResult()
+        run.tests['foo'] = base
+        metrics = {'mean': {'value': value, 'unit': 'ns', 'ci': ci,
+                            'noisy': True}}
+        with mock.patch('framework.test.perf._get_baseline',
+                        return_value=run):
+            return perf.compare_to_baseline('foo', metrics)['mean']
+
+    def test_confidence_intervals_apart(self):
+        """A regression outside both confidence intervals fails, noisy or not."""
+        assert self._compare(120.0, 5.0, 5.0) is status.FAIL
+
+    def test_confidence_intervals_overlap(self):
+        """A regression within the confidence intervals warns."""
+        assert self._compare(120.0, 15.0, 10.0) is status.WARN
+
+    def test_no_baseline(self):
+        """Without a baseline run every metric passes."""
+        perf.OPTIONS.perf_baseline = None
+        assert perf.compare_to_baseline('foo', {'mean': {
+            'value': 1.0, 'unit': 'ns', 'noisy': False}}) == {
+                'mean': status.PASS}
+
+    def test_counter(self):
+        """A GPU counter gets its change but no subtest."""
+        base = results.TestResult()
+        base.metrics['draw: busy'] = {'value': 100.0, 'unit': '',
+                                      'counter': True}
+        run = results.TestrunResult()
+        run.tests['foo'] = base
+        metrics = {'draw: busy': {'value': 50.0, 'unit': '', 'noisy': False,
+                                  'counter': True}}
+        with mock.patch('framework.test.perf._get_baseline',
+                        return_value=run):
+            assert perf.compare_to_baseline('foo', metrics) == {}
+        assert metrics['draw: busy']['change'] == pytest.approx(-0.5)
+
+
+class TestPerfTest(object):
+    """Tests for the PerfTest class."""
+
+    @pytest.fixture
+    def test(self, mocker):
+        opts = Options()
+        opts.perf_baseline = 'baseline.json'
+        mocker.patch('framework.test.perf.OPTIONS', opts)
+
+        test = perf.PerfTest(['foo'])
+        test.name = 'foo'
+        test.result.returncode = 0
+        return test
+
+    def test_not_concurrent(self):
+        """Benchmarks never run concurrently."""
+        assert not perf.PerfTest(['foo'], run_concurrent=True).run_concurrent
+
+    def test_no_auto(self):
+        """-auto is not added to the command."""
+        assert '-auto' not in perf.PerfTest(['foo']).command
+
+    def test_read_metrics(self, test):
+        """The median of each report is the value of its metric."""
+        test._read_metrics(io.StringIO(_report('1M', 42.0) + 'garbage'))
+        assert test.result.metrics['1M'] == {
+            'value': 42.0, 'unit': 'MB/s', 'stddev': 1.0, 'cv': 0.01,
+            'samples': 5, 'noisy': False}
+
+    def test_pass_without_result_line(self, test):
+        """A benchmark that exits cleanly passes."""
+        with mock.patch('framework.test.perf._get_baseline',
+                        return_value=_baseline()):
+            test.interpret_result()
+        assert test.result.result is status.PASS
+
+    def test_skip(self, test):
+        """The result line of a benchmark that skips is used."""
+        test.result.out = 'PIGLIT: {"result": "skip"}\n'
+        test.interpret_result()
+        assert test.result.result is status.SKIP
+
+    def test_subtests(self, test):
+        """Each metric becomes a subtest, compared to the baseline."""
+        test._read_metrics(io.StringIO(
+            _report('same', 100.0) +
+            _report('slower', 90.0) +
+            _report('noisy', 90.0) +
+            _report('new', 90.0)))
+        with mock.patch('framework.test.perf._get_baseline',
+                        return_value=_baseline(same=99.0, slower=100.0,
+                                               noisy=100.0)):
+            test.interpret_result()
+
+        assert test.result.subtests['same'] is status.PASS
+        assert test.result.subtests['slower'] is status.FAIL
+        assert test.result.subtests['noisy'] is status.WARN
+        assert test.result.subtests['new'] is status.PASS
+        assert test.result.result is status.FAIL
+        assert test.result.metrics['slower']['change'] == pytest.approx(-0.1)
+        assert 'baseline' not in test.result.metrics['new']
+
+    def test_unstable(self, test):
+        """Unstable measurements warn, whether they regressed or not."""
+        test._read_metrics(io.StringIO(
+            _report('slower', 50.0, unstable=True, gpu_mhz=300) +
+            _report('same', 100.0, unstable=True)))
+        with mock.patch('framework.test.perf._get_baseline',
+                        return_value=_baseline(slower=100.0, same=100.0)):
+            test.interpret_result()
+
+        assert test.result.subtests['slower'] is status.WARN
+        assert test.result.subtests['same'] is status.WARN
+        assert test.result.metrics['slower']['gpu_mhz'] == 300
+
+    def test_threshold(self, test):
+        """Changes within the threshold pass."""
+        perf.OPTIONS.perf_threshold = 0.2
+        test._read_metrics(io.StringIO(_report('slower', 90.0)))
+        with mock.patch('framework.test.perf._get_baseline',
+                        return_value=_baseline(slower=100.0)):
+            test.interpret_result()
+        assert test.result.subtests['slower'] is status.PASS
+
+
+class TestPerfConfig(object):
+    """Tests for the perf_config function."""
+
+    def test_env(self):
+        """The variables after the name are the environment."""
+        assert perf.perf_config('on:mesa_glthread=true,FOO=a=b') == \
+            ['on', {'mesa_glthread': 'true', 'FOO': 'a=b'}]
+
+    def test_name_only(self):
+        """A configuration may add no variables."""
+        assert perf.perf_config('default') == ['default', {}]
+
+    def test_bad_assignment(self):
+        """A variable without a value is an error."""
+        with pytest.raises(ValueError):
+            perf.perf_config('on:mesa_glthread')
+
+
+class TestConfigMetrics(object):
+    """Tests for the config_metrics function."""
+
+    @staticmethod
+    def _run(value):
+        return {'draws': {'value': value, 'unit': 'draws/s', 'noisy': False}}
+
+    def test_delta(self):
+        """The change from the first configuration is paired by round."""
+        configs = [['off', {}], ['on', {}]]
+        runs = {
+            'off': [self._run(100.0), self._run(200.0)],
+            'on': [self._run(110.0), self._run(220.0)],
+        }
+        metrics = perf.config_metrics(configs, runs)
+
+        assert metrics['draws [off]']['value'] == pytest.approx(150.0)
+        assert 'delta' not in metrics['draws [off]']
+        assert metrics['draws [on]']['delta'] == pytest.approx(0.1)
+        # Both rounds changed alike, however far apart they were
+        assert metrics['draws [on]']['delta_ci'] == pytest.approx(0.0)
+
+
+class TestPerfTestConfigs(object):
+    """Tests for running a PerfTest under several configurations."""
+
+    def test_interleaved(self, mocker):
+        """The configurations alternate, in the opposite order every round."""
+        opts = Options()
+        opts.perf_configs = [['off', {'mesa_glthread': 'false'}],
+                             ['on', {'mesa_glthread': 'true'}]]
+        opts.perf_rounds = 3
+        mocker.patch('framework.test.perf.OPTIONS', opts)
+
+        order = []
+
+        def run_command(test, *args, **kwargs):
+            order.append(test.env['mesa_glthread'])
+            value = 110.0 if test.env['mesa_glthread'] == 'true' else 100.0
+            with open(test.env['PIGLIT_PERF_JSON'], 'w') as f:
+                f.write(_report('draws', value))
+            test.result.out = ''
+            test.result.returncode = 0
+
+        test = perf.PerfTest(['foo'])
+        with mock.patch('framework.test.piglit_test.PiglitBaseTest.'
+                        '_run_command', autospec=True,
+                        side_effect=run_command):
+            test._run_command()
+
+        assert order == ['false', 'true', 'true', 'false', 'false', 'true']
+        assert test.result.metrics['draws [on]']['delta'] == \
+            pytest.approx(0.1)
+        assert 'mesa_glthread' not in test.env
@@ -21,6 +21,8 @@
 
 """Tests for the piglit_test module."""
 
+import os
+import sys
 import textwrap
 from unittest import mock
 
@@ -29,7 +31,10 @@ import pytest
 from framework import status
 from framework.options import _Options as Options
 from framework.test.base import TestIsSkip as _TestIsSkip
-from framework.test.piglit_test import PiglitBaseTest, PiglitGLTest
+from framework.test.piglit_test import (PiglitBaseTest, PiglitGLTest,
+                                        MultiASMParserTest,
+                                        MultiVkRunnerTest, TestHost,
+                                        ForkServer)
 
 # pylint: disable=no-self-use
 # pylint: disable=protected-access
@@ -167,3 +172,423 @@ class TestPiglitGLTest(object):
             mock_options.env['PIGLIT_PLATFORM'] = 'gbm'
             test = PiglitGLTest(['foo'], exclude_platforms=['glx'])
             test.is_skip()
+
+    class TestHostModule(object):
+        """Tests for the host_module property."""
+
+        @pytest.fixture()
+        def mock_options(self):
+            with mock.patch('framework.test.piglit_test.options.OPTIONS',
+                            new_callable=Options) as m:
+                yield m
+
+        @pytest.fixture()
+        def bin_dir(self, tmpdir):
+            tmpdir.mkdir('modules').join('foo.so').write('')
+            with mock.patch('framework.test.piglit_test.TEST_BIN_DIR',
+                            str(tmpdir)):
+                yield tmpdir
+
+        def test_module(self, mock_options, bin_dir):
+            """is the module of the test with the test_host option."""
+            mock_options.test_host = True
+            test = PiglitGLTest(['foo'])
+            assert test.host_module == str(bin_dir.join('modules', 'foo.so'))
+
+        def test_no_option(self, mock_options, bin_dir):
+            """is None without the test_host option."""
+            test = PiglitGLTest(['foo'])
+            assert test.host_module is None
+
+    class TestParallelSubtests(object):
+        """Tests for running the subtests in chunks."""
+
+        @pytest.fixture()
+        def mock_options(self):
+            with mock.patch('framework.test.piglit_test.options.OPTIONS',
+                            new_callable=Options) as m:
+                m.jobs = 3
+                m.env['PIGLIT_PLATFORM'] = 'mock'
+                yield m
+
+        @pytest.fixture()
+        def fake(self, tmpdir):
+            """A fake test with the subtests a0 to a9.
+
+            a3 is selected with an option, a5 fails and a7 aborts.
+            """
+            fake = tmpdir.join('fake_test.py')
+            fake.write(textwrap.dedent("""\
+                import json
+                import os
+                import sys
+
+                names = ['a%d' % i for i in range(10)]
+                args = sys.argv[1:]
+                if '-list-subtests' in args:
+                    for n in names:
+                        print('opt: a3' if n == 'a3' else n)
+                    sys.exit(0)
+                sel = [args[i + 1] for i, a in enumerate(args)
+                       if a == '-subtest']
+                print('PIGLIT: {"enumerate subtests": %s}' % json.dumps(sel))
+                for s in sel:
+                    if s == 'a7':
+                        sys.stdout.flush()
+                        os.abort()
+                    name = 'a3' if s == 'opt' else s
+                    print('PIGLIT: {"subtest": {"%s": "%s"}, "time": 0.01}' %
+                          (name, 'fail' if s == 'a5' else 'pass'))
+                print('PIGLIT: {"result": "pass"}')
+                """))
+            return [sys.executable, str(fake)]
+
+        def test_statuses(self, mock_options, fake):
+            """Every subtest gets the status its process reported."""
+            test = PiglitGLTest(fake, parallel_subtests=True)
+            test.run()
+            assert test.result.subtests['a0'] is status.PASS
+            assert test.result.subtests['a3'] is status.PASS
+            assert test.result.subtests['a5'] is status.FAIL
+            assert test.result.subtests['a9'] is status.PASS
+
+        def test_crash(self, mock_options, fake):
+            """Only the subtest that crashed is marked crash."""
+            test = PiglitGLTest(fake, parallel_subtests=True)
+            test.run()
+            assert test.result.subtests['a7'] is status.CRASH
+            assert test.result.subtests['a8'] is status.PASS
+            assert test.result.result is status.CRASH
+
+        def test_times(self, mock_options, fake):
+            """The time the subtests report is kept."""
+            test = PiglitGLTest(fake, parallel_subtests=True)
+            test.run()
+            assert test.result.subtests.times['a1'] == 0.01
+
+        def test_not_listed(self, mock_options, tmpdir):
+            """A test that can't list its subtests is run as a whole."""
+            fake = tmpdir.join('fake_test.py')
+            fake.write(textwrap.dedent("""\
+                import sys
+
+                if '-list-subtests' in sys.argv:
+                    sys.exit(1)
+                print('PIGLIT: {"result": "pass"}')
+                """))
+            test = PiglitGLTest([sys.executable, str(fake)],
+                                parallel_subtests=True)
+            test.run()
+            assert test.result.result is status.PASS
+            assert not test.result.subtests
+
+        def test_not_built(self, mock_options, bin_dir):
+            """is None if the module wasn't built."""
+            mock_options.test_host = True
+            test = PiglitGLTest(['bar'])
+            assert test.host_module is None
+
+
+class TestMultiVkRunnerTest(object):
+    """Tests for the MultiVkRunnerTest class."""
+
+    @pytest.fixture()
+    def mock_options(self):
+        with mock.patch('framework.test.piglit_test.options.OPTIONS',
+                        new_callable=Options) as m:
+            m.env['PIGLIT_PLATFORM'] = 'mock'
+            yield m
+
+    @pytest.fixture()
+    def files(self, tmpdir):
+        """Scripts whose contents tell the fake vkrunner what to do."""
+        files = []
+        for name in ['a_pass', 'b_fail', 'c_pass', 'd_crash', 'e_pass',
+                     'f_skip']:
+            f = tmpdir.join(name + '.vk_shader_test')
+            f.write(name.split('_')[1])
+            files.append(str(f))
+        return files
+
+    @pytest.fixture()
+    def vkrunner(self, tmpdir):
+        """A fake vkrunner that prints the name of each script it runs."""
+        fake = tmpdir.join('vkrunner.py')
+        fake.write(textwrap.dedent("""\
+            import os
+            import sys
+
+            files = sys.argv[1:]
+            res = 'skip'
+            for f in files:
+                if len(files) > 1:
+                    print(f)
+                    sys.stdout.flush()
+                kind = open(f).read()
+                if kind == 'crash':
+                    os.abort()
+                if kind == 'fail':
+                    print('Probe color at (0, 0) failed')
+                    res = 'fail'
+                elif kind == 'skip':
+                    print('Missing required feature')
+                elif res != 'fail':
+                    res = 'pass'
+            print('PIGLIT: {"result": "%s"}' % res)
+            sys.exit(1 if res == 'fail' else 0)
+            """))
+        return [sys.executable, str(fake)]
+
+    def test_subtests(self, mock_options, files, vkrunner):
+        """Every script gets its own status."""
+        test = MultiVkRunnerTest(files)
+        test._command = vkrunner
+        test.run()
+        assert test.result.subtests['a_pass'] is status.PASS
+        assert test.result.subtests['b_fail'] is status.FAIL
+        assert test.result.subtests['f_skip'] is status.SKIP
+
+    def test_crash(self, mock_options, files, vkrunner):
+        """The scripts after one that crashed are still run."""
+        test = MultiVkRunnerTest(files)
+        test._command = vkrunner
+        test.run()
+        assert test.result.subtests['d_crash'] is status.CRASH
+        assert test.result.subtests['e_pass'] is status.PASS
+        assert test.result.result is status.CRASH
+
+
+class TestMultiASMParserTest(object):
+    """Tests for the MultiASMParserTest class."""
+
+    @pytest.fixture
+    def inst(self, tmpdir):
+        """A fixture that creates an instance to test."""
+        one = tmpdir.join('abs.txt')
+        one.write('!!ARBvp1.0\nEND\n')
+        two = tmpdir.join('Option.txt')
+        two.write('!!ARBvp1.0\n# REQUIRE GL_NV_vertex_program3\nEND\n')
+
+        return MultiASMParserTest.new(
+            'ARBvp1.0', [str(one), str(two)],
+            ['shaders/ARBvp1.0/abs.txt', 'shaders/ARBvp1.0/Option.txt'])
+
+    def test_new(self, inst):
+        assert inst.extensions == [[], ['GL_NV_vertex_program3']]
+        assert inst.subtests == ['abs.txt', 'option.txt']
+
+    def test_command(self, inst):
+        command = inst.command
+        assert os.path.basename(command[0]) == 'asmparsertest'
+        assert command[1:3] == ['--batch', 'ARBvp1.0']
+        assert command[3].endswith('abs.txt')
+        assert command[4].endswith('Option.txt')
+
+    def test_resume(self, inst):
+        actual = inst._resume(1)
+        assert actual[1:3] == ['--batch', 'ARBvp1.0']
+        assert len(actual) == 4
+        assert actual[3].endswith('Option.txt')
+
+    def test_skips_left_out(self, inst, mocker):
+        """A file that skips in python isn't passed to asmparsertest."""
+        def test(self):
+            if 'GL_NV_vertex_program3' in self.extensions:
+                raise _TestIsSkip('no vp3')
+        mocker.patch('framework.test.opengl.FastSkip.test', test)
+
+        inst._process_skips()
+        assert inst.result.subtests['option.txt'] == 'skip'
+        assert inst._expected == ['abs.txt']
+        assert inst.command[-1].endswith('abs.txt')
+
+
+class TestTestHost(object):
+    """Tests for the TestHost class."""
+
+    @pytest.fixture
+    def host(self, tmpdir):
+        """A host running a fake piglit-test-host.
+
+        The fake prints the arguments of each test, then takes the first one
+        as what the test does.
+        """
+        fake = tmpdir.join('fake_host.py')
+        fake.write(textwrap.dedent("""\
+            import os
+            import sys
+            import time
+
+            for line in sys.stdin:
+                fields = line.rstrip('\\n').split('\\t')
+                if fields[0] == 'fork':
+                    fields = fields[1:]
+                    if fields[2] == 'abort':
+                        print('PIGLIT-HOST: signal 6')
+                        sys.stdout.flush()
+                        continue
+                module, args = fields[0], fields[1:]
+                if module.endswith('.exe'):
+                    print('PIGLIT-HOST: unsupported not a test module')
+                    sys.stdout.flush()
+                    continue
+                print(' '.join(args))
+                if args[1] == 'abort':
+                    sys.stdout.flush()
+                    os.abort()
+                if args[1] == 'hang':
+                    sys.stdout.flush()
+                    time.sleep(60)
+                print('PIGLIT: {"result": "%s" }' % args[1])
+                print('PIGLIT-HOST: exit %d' % (args[1] != 'pass'))
+                sys.stdout.flush()
+            """))
+        host = TestHost([sys.executable, str(fake)], dict(os.environ))
+        yield host
+        host.close()
+
+    def test_pass(self, host):
+        ran = host.run('foo.so', ['foo', 'pass'])
+        assert ran.out == 'foo pass\nPIGLIT: {"result": "pass" }\n'
+        assert ran.returncode == 0
+        assert not ran.timed_out
+        assert ran.pid == host.proc.pid
+
+    def test_exit_status(self, host):
+        assert host.run('foo.so', ['foo', 'fail']).returncode == 1
+
+    def test_process_reused(self, host):
+        host.run('foo.so', ['foo', 'pass'])
+        pid = host.proc.pid
+        host.run('bar.so', ['bar', 'pass'])
+        assert host.proc.pid == pid
+
+    def test_unsupported(self, host):
+        assert host.run('foo.exe', ['foo', 'pass']) is None
+
+    def test_crash(self, host):
+        ran = host.run('foo.so', ['foo', 'abort'])
+        assert ran.out == 'foo abort\n'
+        assert ran.returncode < 0
+        assert host.proc is None
+
+    def test_restart_after_crash(self, host):
+        host.run('foo.so', ['foo', 'abort'])
+        assert host.run('bar.so', ['bar', 'pass']).returncode == 0
+
+    def test_forked_signal(self, host):
+        """The signal that killed a forked test is a negative return code."""
+        ran = host.run('foo.so', ['foo', 'abort'], isolate=True)
+        assert ran.returncode == -6
+        assert host.proc is not None
+
+    def test_timeout(self, host):
+        ran = host.run('foo.so', ['foo', 'hang'], timeout=0.5)
+        assert ran.out == 'foo hang\n'
+        assert ran.timed_out
+
+
+class TestForkServer(object):
+    """Tests for the ForkServer class."""
+
+    @pytest.fixture
+    def server(self, tmpdir):
+        """A server running a fake piglit-test-host -fork-server.
+
+        The fake forks a child for each test, which prints its arguments and
+        takes the first one as what the test does.
+        """
+        fake = tmpdir.join('fake_server.py')
+        fake.write(textwrap.dedent("""\
+            import array
+            import os
+            import socket
+            import sys
+            import threading
+            import time
+
+            srv = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            srv.bind(sys.argv[-1])
+            srv.listen(8)
+            print('ready')
+            sys.stdout.flush()
+
+            # Exit once stdin is closed
+            threading.Thread(target=lambda: (sys.stdin.read(), os._exit(0)),
+                             daemon=True).start()
+
+            while True:
+                conn, _ = srv.accept()
+                msg, anc, _, _ = conn.recvmsg(16384, socket.CMSG_SPACE(8))
+                fds = array.array('i')
+                fds.frombytes(anc[0][2])
+                fields = msg.decode().rstrip('\\n').split('\\t')
+                module, args = fields[0], fields[1:]
+                if module.endswith('.exe'):
+                    conn.sendall(b'unsupported not a test module\\n')
+                else:
+                    pid = os.fork()
+                    if pid == 0:
+                        os.setpgid(0, 0)
+                        os.dup2(fds[0], 1)
+                        os.dup2(fds[1], 2)
+                        print(' '.join(args))
+                        sys.stderr.write('err\\n')
+                        sys.stdout.flush()
+                        sys.stderr.flush()
+                        if args[1] == 'abort':
+                            os.abort()
+                        if args[1] == 'hang':
+                            time.sleep(60)
+                        os._exit(args[1] != 'pass')
+                    conn.sendall(b'pid %d\\n' % pid)
+                    os.close(fds[0])
+                    os.close(fds[1])
+                    _, status = os.waitpid(pid, 0)
+                    if os.WIFSIGNALED(status):
+                        conn.sendall(b'signal %d\\n' % os.WTERMSIG(status))
+                    else:
+                        conn.sendall(b'exit %d\\n' % os.WEXITSTATUS(status))
+                for fd in fds:
+                    try:
+                        os.close(fd)
+                    except OSError:
+                        pass
+                conn.close()
+            """))
+        server = ForkServer([sys.executable, str(fake)], dict(os.environ))
+        yield server
+        server.close()
+
+    def test_pass(self, server):
+        ran = server.run('foo.so', ['foo', 'pass'])
+        assert ran.out == 'foo pass\n'
+        assert ran.err == 'err\n'
+        assert ran.returncode == 0
+        assert not ran.timed_out
+
+    def test_exit_status(self, server):
+        assert server.run('foo.so', ['foo', 'fail']).returncode == 1
+
+    def test_child_per_test(self, server):
+        """Each test runs in its own child of the same server."""
+        first = server.run('foo.so', ['foo', 'pass'])
+        pid = server.proc.pid
+        second = server.run('foo.so', ['foo', 'pass'])
+        assert first.pid != second.pid
+        assert server.proc.pid == pid
+
+    def test_unsupported(self, server):
+        assert server.run('foo.exe', ['foo', 'pass']) is None
+
+    def test_crash(self, server):
+        """A crash is the test's, the server keeps running."""
+        ran = server.run('foo.so', ['foo', 'abort'])
+        assert ran.returncode == -6
+        assert server.proc.poll() is None
+
+    def test_timeout(self, server):
+        ran = server.run('foo.so', ['foo', 'hang'], timeout=0.5)
+        assert ran.out == 'foo hang\n'
+        assert ran.timed_out
+        assert ran.returncode == -9
@@ -22,11 +22,13 @@
 """ Provides tests for the shader_test module """
 
 import os
+import sys
 import textwrap
 from unittest import mock
 
 import pytest
 
+from framework import exceptions
 from framework import status
 from framework.test import shader_test
 
@@ -164,6 +166,21 @@ class TestConfigParsing(object):
 
         assert test.require_shader == 1.0
 
+    def test_reparse_changed(self, tmpdir):
+        """test.shader_test.Parser: parses a file again once it changed."""
+        p = tmpdir.join('test.shader_test')
+        p.write(textwrap.dedent("""\
+            [require]
+            GL >= 3.0
+            """))
+        assert shader_test.ShaderTest.new(str(p)).require_version == 3.0
+
+        p.write(textwrap.dedent("""\
+            [require]
+            GL >= 4.50
+            """))
+        assert shader_test.ShaderTest.new(str(p)).require_version == 4.5
+
     def test_ignore_directives(self, tmpdir):
         """There are some directives for shader_runner that are not interpreted
         by the python layer, they are only for the C layer. These should be
@@ -250,6 +267,28 @@ class TestMultiShaderTest(object):
         def test_extra(self, inst):
             assert inst.command[3] == '-auto'
 
+        def test_same_vertex_shader_together(self, tmpdir):
+            """Files with the same vertex shader are run one after the
+            other, in their original order otherwise.
+            """
+            for name, source in [('a', 'one'), ('b', 'two'), ('c', 'one')]:
+                tmpdir.join(name + '.shader_test').write(textwrap.dedent("""\
+                    [require]
+                    GLSL >= 1.30
+
+                    [vertex shader]
+                    {}
+
+                    [fragment shader]
+                    {}
+                    """.format(source, name)))
+
+            inst = shader_test.MultiShaderTest.new(
+                [str(tmpdir.join(n + '.shader_test')) for n in 'abc'])
+            assert [os.path.basename(c) for c in inst.command[1:4]] == \
+                ['a.shader_test', 'c.shader_test', 'b.shader_test']
+            assert inst.subtests == ['a', 'c', 'b']
+
     @pytest.fixture
     def inst(self, tmpdir):
         """A fixture that creates an instance to test."""
@@ -286,3 +325,125 @@ class TestMultiShaderTest(object):
         with mock.patch.object(inst.skips[0].info.core, 'shader_version', 3.0):
             inst._process_skips()
         assert dict(inst.result.subtests) == expected
+
+
+class TestBundle(object):
+    """Tests for bundles of shader tests."""
+
+    @pytest.fixture
+    def bundle(self, tmpdir):
+        files = []
+        for name, version in [('foo', '3.0'), ('bar', '4.0')]:
+            p = tmpdir.join(name + '.shader_test')
+            p.write(textwrap.dedent("""\
+                [require]
+                GLSL >= {}
+                GL_ARB_{}
+
+                [vertex shader]
+                """.format(version, name)))
+            files.append(str(p))
+        path = tmpdir.join(shader_test.BUNDLE_NAME)
+        shader_test.write_bundle(str(path), sorted(files))
+        return str(path)
+
+    def test_read(self, bundle):
+        tests = shader_test.read_bundle(bundle)
+        assert [t['name'] for t in tests] == ['bar', 'foo']
+        assert tests[1]['extensions'] == ['GL_ARB_foo']
+        assert tests[1]['shader_version'] == 3.0
+
+    def test_unchanged_not_written(self, bundle):
+        """A bundle written again with the same tests keeps its file."""
+        mtime = os.stat(bundle).st_mtime_ns
+        os.utime(bundle, ns=(0, 0))
+        shader_test.write_bundle(bundle, sorted(
+            os.path.join(os.path.dirname(bundle), n)
+            for n in ['bar.shader_test', 'foo.shader_test']))
+        assert os.stat(bundle).st_mtime_ns == 0
+        assert mtime != 0
+
+    def test_parser(self, bundle):
+        """Parser reads the requirements of a test of a bundle."""
+        parser = shader_test.Parser(bundle + '#1')
+        parser.parse()
+        assert parser.name == 'foo'
+        assert parser.extensions == {'GL_ARB_foo'}
+        assert parser.prog == 'shader_runner'
+
+    def test_multi_shader_test(self, bundle):
+        inst = shader_test.MultiShaderTest.new(
+            [bundle + '#0', bundle + '#1'])
+        assert inst.subtests == ['bar', 'foo']
+        assert inst.command[1].endswith(shader_test.BUNDLE_NAME + '#0')
+
+    def test_invalid(self, tmpdir):
+        p = tmpdir.join('other.shader_bundle')
+        p.write('not a bundle')
+        with pytest.raises(exceptions.PiglitFatalError):
+            shader_test.read_bundle(str(p))
+
+
+class TestShaderRunnerServer(object):
+    """Tests for the ShaderRunnerServer class."""
+
+    @pytest.fixture
+    def server(self, tmpdir):
+        """A server running a fake shader_runner.
+
+        The fake reports the contents of each file it is fed as the result,
+        except for a few special values that make it stop early.
+        """
+        fake = tmpdir.join('fake_runner.py')
+        fake.write(textwrap.dedent("""\
+            import os
+            import sys
+
+            for line in sys.stdin:
+                name = os.path.basename(line.strip())
+                with open(line.strip()) as f:
+                    result = f.read().strip()
+                print('PIGLIT TEST: 1 - ' + name)
+                if result == 'abort':
+                    sys.stdout.flush()
+                    os.abort()
+                if result == 'skip':
+                    print('PIGLIT: {"result": "skip" }')
+                    sys.exit(0)
+                print('PIGLIT: {"subtest": {"%s" : "%s"}}' % (name, result))
+                sys.stdout.flush()
+            """))
+        server = shader_test.ShaderRunnerServer(
+            [sys.executable, str(fake)], dict(os.environ))
+        yield server
+        server.close()
+
+    @staticmethod
+    def _file(tmpdir, name, contents):
+        tmpdir.join(name).write(contents)
+        return str(tmpdir.join(name))
+
+    def test_pass(self, server, tmpdir):
+        out = server.run(self._file(tmpdir, 'foo', 'pass'), 'foo')
+        assert out.endswith('PIGLIT: {"subtest": {"foo" : "pass"}}\n')
+
+    def test_process_reused(self, server, tmpdir):
+        server.run(self._file(tmpdir, 'foo', 'pass'), 'foo')
+        pid = server.proc.pid
+        server.run(self._file(tmpdir, 'bar', 'fail'), 'bar')
+        assert server.proc.pid == pid
+
+    def test_crash(self, server, tmpdir):
+        out = server.run(self._file(tmpdir, 'foo', 'abort'), 'foo')
+        assert out.endswith('PIGLIT: {"subtest": {"foo" : "crash"}}\n')
+        assert server.proc is None
+
+    def test_restart_after_crash(self, server, tmpdir):
+        server.run(self._file(tmpdir, 'foo', 'abort'), 'foo')
+        out = server.run(self._file(tmpdir, 'bar', 'pass'), 'bar')
+        assert out.endswith('PIGLIT: {"subtest": {"bar" : "pass"}}\n')
+
+    def test_early_exit_result(self, server, tmpdir):
+        out = server.run(self._file(tmpdir, 'foo', 'skip'), 'foo')
+        assert out.endswith('PIGLIT: {"subtest": {"foo" : "skip"}}\n')
+        assert '"result"' not in out
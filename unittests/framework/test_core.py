@@ -24,6 +24,7 @@
 import collections
 import errno
 import os
+import struct
 import textwrap
 from unittest import mock
 
@@ -318,3 +319,55 @@ class TestCheckDir(object):
         core.check_dir('foo', False)
 
         assert makedirs.called == 1
+
+
+class TestCache(object):
+    """Tests for core.load_cache and core.store_cache."""
+
+    @pytest.fixture(autouse=True)
+    def cache_dir(self, tmpdir):
+        with mock.patch.dict('os.environ',
+                             {'PIGLIT_CACHE_DIR': str(tmpdir.join('cache'))}):
+            yield tmpdir.join('cache')
+
+    def test_missing(self):
+        """core.load_cache: a missing cache is empty."""
+        assert core.load_cache('foo') == {}
+
+    def test_roundtrip(self):
+        """core.load_cache: returns what core.store_cache stored."""
+        core.store_cache('foo', {'a': [1, 2]})
+        assert core.load_cache('foo') == {'a': [1, 2]}
+
+    def test_invalid(self, cache_dir):
+        """core.load_cache: an unreadable cache is empty."""
+        cache_dir.ensure(dir=True).join('foo.json').write('{')
+        assert core.load_cache('foo') == {}
+
+
+class TestBinaryIdentity(object):
+    """Tests for core.binary_identity."""
+
+    def test_missing(self, tmpdir):
+        """core.binary_identity: a missing file has no identity."""
+        assert core.binary_identity(str(tmpdir.join('foo'))) is None
+
+    def test_changes(self, tmpdir):
+        """core.binary_identity: changes when the file does."""
+        f = tmpdir.join('foo')
+        f.write('#!/bin/sh\n')
+        before = core.binary_identity(str(f))
+        f.write('#!/bin/sh\ntrue\n')
+        assert core.binary_identity(str(f)) != before
+
+    def test_build_id(self, tmpdir):
+        """core.binary_identity: includes the build-id of an ELF file."""
+        note = struct.pack('<III', 4, 4, 3) + b'GNU\0' + b'\xde\xad\xbe\xef'
+        header = bytearray(64)
+        header[:6] = b'\x7fELF\x02\x01'
+        struct.pack_into('<Q', header, 0x20, 64)
+        struct.pack_into('<HH', header, 0x36, 56, 1)
+        phdr = struct.pack('<IIQQQQQQ', 4, 0, 120, 0, 0, len(note), 0, 4)
+        f = tmpdir.join('foo')
+        f.write_binary(bytes(header) + phdr + note)
+        assert core.binary_identity(str(f))[2] == 'deadbeef'
@@ -0,0 +1,149 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the coverage module."""
+
+import os
+import struct
+
+import pytest
+
+from framework import coverage
+from framework import exceptions
+
+from . import utils
+
+# pylint: disable=no-self-use,protected-access
+
+
+def _gcda(counters, version=b'B22*'):
+    """Return a .gcda file of one function with the arc counters."""
+    unit = 1 if version >= b'B2' else 4
+    data = struct.pack('<I', 0x67636461) + version[::-1] + b'\1\2\3\4'
+    if unit == 1:
+        data += b'\5\6\7\x08'
+    data += struct.pack('<Ii', 0x01000000, 12 // unit) + b'\0' * 12
+    if any(counters):
+        data += struct.pack('<Ii', 0x01a10000, 8 * len(counters) // unit)
+        data += b''.join(struct.pack('<Q', c) for c in counters)
+    else:
+        data += struct.pack('<Ii', 0x01a10000, -8 * len(counters) // unit)
+    return data
+
+
+class TestCovered(object):
+    """Tests for the _covered function."""
+
+    @pytest.mark.parametrize('version', [b'B22*', b'A94*', b'408*'])
+    @pytest.mark.parametrize('counters, expected', [
+        ([0, 0], False),
+        ([0, 3], True),
+    ])
+    def test_counters(self, tmpdir, version, counters, expected):
+        path = tmpdir.join('foo.c.gcda')
+        path.write_binary(_gcda(counters, version))
+        assert coverage._covered(str(path)) is expected
+
+    def test_not_gcda(self, tmpdir):
+        path = tmpdir.join('foo.c.gcda')
+        path.write_binary(b'not a gcda file')
+        assert coverage._covered(str(path)) is False
+
+
+class TestRecorder(object):
+    """Tests for the Recorder class."""
+
+    def test_record(self, tmpdir):
+        """The objects with counters that aren't 0 are recorded."""
+        test = utils.Test(['foo'])
+        recorder = coverage.Recorder(str(tmpdir))
+        with recorder.record('a@b', test):
+            prefix = test.env['GCOV_PREFIX']
+            build = os.path.join(prefix, 'build', 'src', 'x.p')
+            os.makedirs(build)
+            with open(os.path.join(build, 'x.c.gcda'), 'wb') as f:
+                f.write(_gcda([1]))
+            with open(os.path.join(build, 'y.c.gcda'), 'wb') as f:
+                f.write(_gcda([0]))
+
+        assert 'GCOV_PREFIX' not in test.env
+        assert not os.path.exists(prefix)
+        assert coverage.load(str(tmpdir)) == {'a@b': ['/build/src/x.p/x.c']}
+
+    def test_load_missing(self, tmpdir):
+        with pytest.raises(exceptions.PiglitFatalError):
+            coverage.load(str(tmpdir))
+
+
+def test_changed_files():
+    diff = '\n'.join([
+        'diff --git a/src/x.c b/src/x.c',
+        '--- a/src/x.c',
+        '+++ b/src/x.c',
+        '@@ -1 +1 @@',
+        '--- a/src/gone.c',
+        '+++ /dev/null',
+        '--- /dev/null',
+        '+++ b/src/new.c\t2026-01-01',
+    ])
+    assert coverage.changed_files(diff) == \
+        ['src/gone.c', 'src/new.c', 'src/x.c']
+
+
+class TestSelect(object):
+    """Tests for the select function."""
+
+    coverage = {
+        'a': ['/build/src/intel/libx.a.p/x.c'],
+        'b': ['/build/src/amd/liby.a.p/y.c'],
+        'c': ['/build/src/intel/libx.a.p/x.c', '/build/src/amd/liby.a.p/y.c'],
+    }
+
+    def _selected(self, changes, sample=0.0, names=('a', 'b', 'c')):
+        filter_ = coverage.select(self.coverage, changes, sample)
+        return [n for n in names if filter_(n, None)]
+
+    def test_changed(self):
+        assert self._selected(['src/intel/x.c']) == ['a', 'c']
+
+    def test_other_directory(self):
+        """A file of the same name in another directory isn't matched."""
+        assert self._selected(['src/amd/y.c', 'src/intel/x.c']) == \
+            ['a', 'b', 'c']
+        assert self._selected(['src/amd/x.c']) == ['a', 'b', 'c']
+
+    def test_unknown_file(self):
+        """A change to a file no test ran, such as a header, runs all."""
+        assert self._selected(['src/intel/x.h']) == ['a', 'b', 'c']
+
+    def test_new_test(self):
+        """Tests without coverage are run."""
+        assert self._selected(['src/amd/y.c'], names=['a', 'b', 'd']) == \
+            ['b', 'd']
+
+    def test_sample(self):
+        """The sample of the other tests is stable and about sample big."""
+        names = ['t{}'.format(i) for i in range(1000)]
+        self.coverage = dict(self.coverage)
+        self.coverage.update((n, []) for n in names)
+        first = self._selected(['src/amd/y.c'], 0.1, names)
+        assert first == self._selected(['src/amd/y.c'], 0.1, names)
+        assert 50 < len(first) < 150
@@ -27,8 +27,10 @@ which allows us to test all classes on all platforms, including windows.
 """
 
 import collections
+import os
 import re
 import sys
+import threading
 from unittest import mock
 
 import pytest
@@ -291,6 +293,132 @@ class TestLinuxDmesg(object):
             assert repr(dmesg.LinuxDmesg()) == 'LinuxDmesg()'
 
 
+class TestParseKmsg(object):
+    """Tests for the parse_kmsg function."""
+
+    def test_record(self):
+        """Records are formatted like dmesg prints them."""
+        assert dmesg.parse_kmsg('3,42,5140900,-;i915: oops') == \
+            [(42, '[    5.140900] i915: oops')]
+
+    def test_context(self):
+        """The context lines of a record are skipped."""
+        assert dmesg.parse_kmsg(
+            '4,1,10,-;usb: reset\n SUBSYSTEM=usb\n DEVICE=c189:1\n') == \
+            [(1, '[    0.000010] usb: reset')]
+
+    def test_level(self):
+        """Only the levels LinuxDmesg reads are kept."""
+        assert dmesg.parse_kmsg('6,1,10,-;info\n5,2,20,-;notice\n'
+                                '15,3,30,-;user debug\n') == \
+            [(2, '[    0.000020] notice')]
+
+    def test_fields(self):
+        """Fields after the flags are ignored."""
+        assert dmesg.parse_kmsg('0,7,1000000,c,caller=T1;panic') == \
+            [(7, '[    1.000000] panic')]
+
+    def test_malformed(self):
+        """Lines that aren't records are skipped."""
+        assert dmesg.parse_kmsg('garbage\nx,y,z,-;message\n') == []
+
+
+class _PipeKmsgDmesg(dmesg.KmsgDmesg):
+    """KmsgDmesg reading from a pipe instead of /dev/kmsg."""
+
+    def _open(self):
+        read, self.kmsg = os.pipe()
+        os.set_blocking(read, False)
+        return read
+
+    def log(self, sequence, message, level=3):
+        os.write(self.kmsg, '{},{},{},-;{}\n'.format(
+            level, sequence, sequence * 1000, message).encode('utf-8'))
+
+
+class TestKmsgDmesg(object):
+    """Tests for the KmsgDmesg class."""
+
+    @pytest.fixture
+    def kmsg(self):
+        test = _PipeKmsgDmesg()
+        yield test
+        test.close()
+        os.close(test.kmsg)
+
+    def test_messages_of_test(self, kmsg):
+        """Messages logged between the start and end are added."""
+        kmsg.log(1, 'before')
+        kmsg.update_dmesg()
+        kmsg.log(2, 'during')
+        result = kmsg.update_result(results.TestResult(status.PASS))
+        kmsg.log(3, 'after')
+
+        assert result.dmesg == '[    0.002000] during'
+        assert result.result is status.DMESG_WARN
+
+    def test_no_messages(self, kmsg):
+        """Without new messages the result is unchanged."""
+        kmsg.log(1, 'before')
+        kmsg.update_dmesg()
+        result = results.TestResult(status.PASS)
+        result.dmesg = mock.sentinel.dmesg
+        kmsg.update_result(result)
+
+        assert result.dmesg is mock.sentinel.dmesg
+        assert result.result is status.PASS
+
+    def test_concurrent(self, kmsg):
+        """Each test gets the messages logged while it ran."""
+        first = threading.Event()
+        second = threading.Event()
+        done = threading.Event()
+        results_ = {}
+
+        def test_a():
+            kmsg.update_dmesg()
+            kmsg.log(1, 'a only')
+            first.set()
+            second.wait()
+            results_['a'] = kmsg.update_result(results.TestResult('pass'))
+            done.set()
+
+        def test_b():
+            first.wait()
+            kmsg.update_dmesg()
+            kmsg.log(2, 'both')
+            second.set()
+            done.wait()
+            kmsg.log(3, 'b only')
+            results_['b'] = kmsg.update_result(results.TestResult('pass'))
+
+        threads = [threading.Thread(target=t) for t in (test_a, test_b)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        assert results_['a'].dmesg == \
+            '[    0.001000] a only\n[    0.002000] both'
+        assert results_['b'].dmesg == \
+            '[    0.002000] both\n[    0.003000] b only'
+
+    def test_pruned(self, kmsg):
+        """Messages no running test needs are dropped."""
+        kmsg.update_dmesg()
+        kmsg.log(1, 'during')
+        kmsg.update_result(results.TestResult(status.PASS))
+
+        assert not kmsg._messages  # pylint: disable=protected-access
+
+    def test_concurrent_attribute(self, kmsg):
+        assert kmsg.concurrent
+        assert not dmesg.LinuxDmesg.concurrent
+
+    def test_repr(self, kmsg):
+        assert repr(kmsg) == 'KmsgDmesg()'
+
+
 class TestDummyDmesg(object):
     """Tests for the DummyDmesg class."""
     _Namespace = collections.namedtuple('_Namespace', ['dmesg', 'result'])
@@ -352,3 +480,14 @@ class TestGetDmesg(object):
         # We don't want a subclass, we want the *exact* class. This is a
         # unittest after all
         assert type(actual) == expected  # pylint: disable=unidiomatic-typecheck
+
+    def test_kmsg_fallback(self, mocker):
+        """LinuxDmesg is used when /dev/kmsg can't be read."""
+        mocker.patch('framework.dmesg.sys.platform', 'linux')
+        mocker.patch('framework.dmesg.KmsgDmesg.KMSG', '/nonexistent/kmsg')
+
+        with mock.patch('framework.dmesg.subprocess.check_output',
+                        mock.Mock(return_value=b'[1.0]foo')):
+            actual = dmesg.get_dmesg(not_dummy=True)
+
+        assert type(actual) == dmesg.LinuxDmesg  # pylint: disable=unidiomatic-typecheck
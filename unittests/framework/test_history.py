@@ -0,0 +1,145 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+
+"""Tests for the history module."""
+
+import pytest
+
+from framework import history, profile
+from framework.results import TestResult, TestrunResult, TimeAttribute
+
+# pylint: disable=no-self-use,protected-access
+
+
+def _run(name, start, tests):
+    """Return a TestrunResult of tests, a dict of name to (status, time)."""
+    run = TestrunResult()
+    run.name = name
+    run.time_elapsed = TimeAttribute(start=start, end=start + 10)
+    for test, (status, duration) in tests.items():
+        result = TestResult(status)
+        result.time = TimeAttribute(start=0.0, end=duration)
+        run.tests[test] = result
+    return run
+
+
+@pytest.fixture
+def store(tmpdir):
+    with history.History(str(tmpdir.join('history.db'))) as store:
+        yield store
+
+
+class TestHistory(object):
+    """Tests for the History class."""
+
+    def test_transitions(self, store):
+        """The runs where the status changed are returned, oldest first."""
+        store.add(_run('1', 100.0, {'a': ('pass', 1.0)}))
+        store.add(_run('3', 300.0, {'a': ('fail', 1.0)}))
+        store.add(_run('2', 200.0, {'a': ('pass', 1.0)}))
+        store.add(_run('4', 400.0, {'b': ('pass', 1.0)}))
+        store.add(_run('5', 500.0, {'a': ('fail', 1.0)}))
+        assert store.transitions('a') == [
+            ('1', 100.0, None, 'pass'),
+            ('3', 300.0, 'pass', 'fail'),
+        ]
+
+    def test_missing(self, store):
+        assert store.transitions('a') == []
+
+    def test_subtests(self, store):
+        """Subtests are stored under their full name."""
+        run = _run('1', 100.0, {'a': ('pass', 4.0)})
+        run.tests['a'].subtests['x'] = 'pass'
+        run.tests['a'].subtests['y'] = 'fail'
+        store.add(run)
+        assert store.results('a@y') == [('1', 100.0, 'fail', 2.0)]
+
+    def test_durations(self, store):
+        """Percentiles of the durations are returned."""
+        for i in range(5):
+            store.add(_run(str(i), i, {'a': ('pass', float(i))}))
+        durations = store.durations('a', (0.5, 1.0))
+        assert durations == {0.5: 2.0, 1.0: 4.0}
+
+    def test_latest_durations(self, store):
+        """The median duration of the last runs is returned."""
+        for i in range(10):
+            store.add(_run(str(i), i, {'a': ('pass', float(i))}))
+        assert store.latest_durations(3) == {'a': 8.0}
+
+    def test_latest_durations_subtests(self, store):
+        """The durations of subtests are also added up under their test."""
+        for i in range(3):
+            run = _run(str(i), i, {'a': ('pass', 2.0 * (i + 1))})
+            run.tests['a'].subtests['x'] = 'pass'
+            run.tests['a'].subtests['y'] = 'pass'
+            store.add(run)
+        assert store.latest_durations(3, 1.0) == {
+            'a': 6.0, 'a@x': 3.0, 'a@y': 3.0}
+
+    def test_latest_statuses(self, store):
+        """The statuses of the last runs are returned, oldest first."""
+        store.add(_run('1', 100.0, {'a': ('fail', 1.0)}))
+        store.add(_run('3', 300.0, {'a': ('pass', 1.0)}))
+        store.add(_run('2', 200.0, {'a': ('crash', 1.0), 'b': ('pass', 1.0)}))
+        assert store.latest_statuses(2) == {'a': ['crash', 'pass'],
+                                            'b': ['pass']}
+
+    def test_latest_statuses_subtests(self, store):
+        """Tests recorded as subtests get the worst status of them."""
+        run = _run('1', 100.0, {'a': ('fail', 2.0)})
+        run.tests['a'].subtests['x'] = 'pass'
+        run.tests['a'].subtests['y'] = 'fail'
+        store.add(run)
+        assert store.latest_statuses()['a'] == ['fail']
+
+    def test_reopen(self, tmpdir):
+        """The runs are kept when the history is opened again."""
+        path = str(tmpdir.join('history.db'))
+        with history.History(path) as store:
+            store.add(_run('1', 100.0, {'a': ('pass', 1.0)}))
+        with history.History(path) as store:
+            store.add(_run('2', 200.0, {'a': ('pass', 1.0)}))
+            assert [r[1] for r in store.runs()] == ['1', '2']
+
+
+def test_is_history(tmpdir, store):
+    store.add(_run('1', 100.0, {'a': ('pass', 1.0)}))
+    assert history.is_history(store.path)
+    tmpdir.join('results.json').write('{}')
+    assert not history.is_history(str(tmpdir.join('results.json')))
+
+
+def test_schedule_from(store, mocker):
+    """load_durations reads the durations of a history."""
+    mocker.patch.dict(profile._DURATIONS, clear=True)
+    store.add(_run('1', 100.0, {'a': ('pass', 3.0)}))
+    assert profile.load_durations(store.path) == {'a': 3.0}
+
+
+def test_timeouts(store):
+    """Timeouts are a multiple of the durations, between floor and ceiling."""
+    store.add(_run('1', 100.0, {'a': ('pass', 0.1), 'b': ('pass', 2.0),
+                                'c': ('pass', 100.0)}))
+    assert history.timeouts(store.path, 10, 5, 60) == {
+        'a': 5, 'b': 20.0, 'c': 60}
@@ -25,6 +25,7 @@ import collections
 import io
 import sys
 import threading
+import time
 
 import pytest
 
@@ -195,3 +196,95 @@ class TestDummyLog(object):
 
             actual = sys.stdout.read()
             assert actual == ''
+
+
+class TestRenderer(object):
+    """Tests for the status line of QuietLog printed by a thread."""
+
+    @pytest.fixture(autouse=True, scope='function')
+    def mock_stdout(self, mocker):
+        mocker.patch.object(sys, 'stdout', io.StringIO())
+
+    def test_log_doesnt_print(self, log_state):  # pylint: disable=redefined-outer-name
+        """With a renderer log() leaves the printing to it."""
+        log_state['renderer'] = None
+        quiet = log.QuietLog(log_state, threading.Lock())
+        quiet.start(None)
+        quiet.log('pass')
+        sys.stdout.seek(0)
+
+        assert sys.stdout.read() == ''
+
+    def test_prints(self):
+        """The renderer prints the line after a test ends."""
+        logger = log.LogManager('quiet', 1)
+        log_inst = logger.get()
+        log_inst.start(None)
+        log_inst.log('pass')
+        time.sleep(3 / log._Renderer.RATE)
+        log_inst.summary()
+        sys.stdout.seek(0)
+
+        lines = sys.stdout.read().split('\n')
+        assert lines[0].rstrip() == '[1/1] pass: 1'
+        assert not logger._state['renderer'].is_alive()
+
+
+class TestNote(object):
+    """Tests for LogManager.note."""
+
+    @pytest.fixture(autouse=True, scope='function')
+    def mock_stdout(self, mocker):
+        mocker.patch.object(sys, 'stdout', io.StringIO())
+
+    def test_note(self):
+        """The message is printed on its own line, padded over the status."""
+        logger = log.LogManager('verbose', 1)
+        logger._state['lastlength'] = 12
+        logger.note('regression')
+        assert sys.stdout.getvalue() == 'regression  \n'
+        assert logger._state['lastlength'] == 0
+
+    def test_dummy(self):
+        logger = log.LogManager('dummy', 1)
+        logger.note('regression')
+        assert sys.stdout.getvalue() == ''
+
+
+class TestHTTPLog(object):
+    """Tests for the HTTPLog class."""
+
+    @pytest.fixture
+    def http_state(self, log_state):  # pylint: disable=redefined-outer-name
+        log_state.update(total=4, start=time.monotonic(), running={},
+                         durations={})
+        return log_state
+
+    def test_durations(self, http_state):  # pylint: disable=redefined-outer-name
+        """The duration of each test is recorded."""
+        l = log.HTTPLog(http_state, threading.Lock())
+        l.start('foo')
+        l.log('pass')
+
+        assert list(http_state['durations']) == ['foo']
+        assert http_state['durations']['foo'] >= 0
+        assert http_state['running'] == {}
+
+    def test_summary_eta(self, http_state):  # pylint: disable=redefined-outer-name
+        """The throughput and ETA follow from the completed tests."""
+        http_state['start'] -= 10
+        http_state['complete'] = 2
+        http_state['running']['bar'] = time.monotonic() - 1
+
+        summary = log.HTTPLogServer.RequestHandler._summary(http_state)
+
+        assert summary['throughput'] == pytest.approx(0.2, rel=0.01)
+        assert summary['eta'] == pytest.approx(10, rel=0.01)
+        assert summary['running']['bar'] == pytest.approx(1, abs=0.5)
+
+    def test_summary_no_eta(self, http_state):  # pylint: disable=redefined-outer-name
+        """Before a test completes there is no estimate."""
+        summary = log.HTTPLogServer.RequestHandler._summary(http_state)
+
+        assert summary['throughput'] is None
+        assert summary['eta'] is None
@@ -24,6 +24,8 @@
 This provides tests for the framework.monitoring modules.
 """
 
+import time
+
 import pytest
 
 from framework import exceptions
@@ -173,3 +175,97 @@ class TestMonitoring(object):
         self.monitoring.check_monitoring()
 
         assert self.monitoring.abort_needed is False
+
+    @skip.linux
+    def test_thread_error(self, tmpdir):
+        """monitoring.Monitoring: the thread finds an error on a file."""
+        p = tmpdir.join('foo')
+        p.write(self.init_contents)
+        self.monitoring.POLL_INTERVAL = 0.01
+        self.monitoring.add_rule('error_file',
+                                 'file',
+                                 str(p),
+                                 self.regex)
+        self.monitoring.start()
+
+        p.write(self.error_contents)
+        for _ in range(500):
+            if self.monitoring.abort_needed:
+                break
+            time.sleep(0.01)
+        self.monitoring.stop()
+
+        assert self.monitoring.abort_needed is True
+
+    @skip.linux
+    def test_thread_check_ignored(self, tmpdir):
+        """monitoring.Monitoring: check_monitoring is left to the thread."""
+        p = tmpdir.join('foo')
+        p.write(self.init_contents)
+        self.monitoring.POLL_INTERVAL = 60
+        self.monitoring.add_rule('error_file',
+                                 'file',
+                                 str(p),
+                                 self.regex)
+        self.monitoring.start()
+
+        p.write(self.error_contents)
+        self.monitoring.check_monitoring()
+        assert self.monitoring.abort_needed is False
+
+        # stop() checks the sources a last time
+        self.monitoring.stop()
+        assert self.monitoring.abort_needed is True
+
+
+class TestGpuHangMonitor(object):
+    """Tests for the GpuHangMonitor class."""
+
+    @pytest.fixture(autouse=True)
+    def intervals(self, mocker):
+        mocker.patch.object(monitoring.GpuHangMonitor, 'POLL_INTERVAL', 0.01)
+        mocker.patch.object(monitoring.GpuHangMonitor, 'RECOVERY_TIME', 0.05)
+
+    @staticmethod
+    def _until(condition):
+        for _ in range(500):
+            if condition():
+                return True
+            time.sleep(0.01)
+        return False
+
+    def test_counter(self, tmpdir):
+        """A counter going up is a hang, and tests wait for recovery."""
+        counter = tmpdir.join('reset_info')
+        counter.write('full gpu reset = 0\n')
+        hangs = monitoring.GpuHangMonitor([str(counter)])
+        try:
+            start = hangs.wait()
+            assert not hangs.hung_since(start)
+
+            counter.write('full gpu reset = 1\n')
+            assert self._until(lambda: hangs.hung_since(start))
+            assert hangs.wait() == start + 1
+        finally:
+            hangs.stop()
+
+    def test_new_file(self, tmpdir):
+        """A glob matching a new file is a hang."""
+        hangs = monitoring.GpuHangMonitor([str(tmpdir.join('devcd*'))])
+        try:
+            tmpdir.mkdir('devcd1')
+            assert self._until(lambda: hangs.hangs == 1)
+        finally:
+            hangs.stop()
+
+    def test_counter_down(self, tmpdir):
+        """A counter going down, such as after a reload, isn't a hang."""
+        counter = tmpdir.join('reset_info')
+        counter.write('5')
+        hangs = monitoring.GpuHangMonitor([str(counter)])
+        try:
+            counter.write('0')
+            time.sleep(0.1)
+            assert hangs.hangs == 0
+        finally:
+            hangs.stop()
@@ -21,11 +21,21 @@
 
 """ Provides test for the framework.profile modules """
 
+import contextlib
+import functools
+import gzip
+import os
+import threading
+import time
+import xml.etree.ElementTree as et
+
 import pytest
 
 from framework import exceptions
 from framework import grouptools
 from framework import profile
+from framework import status
+from framework.test.piglit_test import PiglitGLTest
 from . import utils
 
 # pylint: disable=invalid-name,no-self-use,protected-access
@@ -107,6 +117,18 @@ class TestTestProfile(object):
             assert fixture.test_list == new.test_list
             assert fixture.test_list is not new.test_list
 
+        def test_test_list_independent(self, fixture):
+            """The copies of test_list can be modified independently."""
+            new = fixture.copy()
+            del new.test_list['bar']
+            new.test_list['oink'] = utils.Test(['oink'])
+            with fixture.test_list.allow_reassignment:
+                fixture.test_list['foo'] = utils.Test(['foo', 'quick'])
+
+            assert set(fixture.test_list) == {'foo', 'bar'}
+            assert set(new.test_list) == {'foo', 'oink'}
+            assert new.test_list['foo'].command == ['foo']
+
 
 class TestTestDict(object):
     """Tests for the TestDict object."""
@@ -268,6 +290,31 @@ class TestRegexFilter(object):
             test = profile.RegexFilter([r'fob', r'bar'])
             assert not test('foobob', None)
 
+        def test_exact(self):
+            """An anchored name only matches that name."""
+            test = profile.RegexFilter([r'^spec@glsl-1\.10@foo$'])
+            assert test('spec@glsl-1.10@foo', None)
+            assert test('Spec@GLSL-1.10@foo', None)
+            assert not test('spec@glsl-1.10@foo@bar', None)
+            assert not test('spec@glsl-1.10@fo', None)
+
+        def test_prefix(self):
+            """A prefix matches every name starting with it."""
+            test = profile.RegexFilter([r'^spec@foo', r'^deqp@'])
+            assert test('spec@foo', None)
+            assert test('spec@foobar@baz', None)
+            assert test('deqp@a', None)
+            assert not test('deqp', None)
+            assert not test('spec@fo', None)
+
+        def test_mixed(self):
+            """Literals and regexes can be used together."""
+            test = profile.RegexFilter([r'^a@b$', r'c.*d', r'(x)\1'])
+            assert test('a@b', None)
+            assert test('z@cd', None)
+            assert test('xx', None)
+            assert not test('a@x', None)
+
     class TestInverse(object):
         """Tests for inverse set to True."""
 
@@ -285,3 +332,379 @@ class TestRegexFilter(object):
             """Returns False when the test matches any regex."""
             test = profile.RegexFilter([r'fob', r'bar'], inverse=True)
             assert test('foobob', None)
+
+
+class TestThreadBudget(object):
+    """Tests for the thread_budget function."""
+
+    @pytest.fixture(autouse=True)
+    def env(self, mocker):
+        mocker.patch.dict('os.environ', {'GALLIUM_DRIVER': 'llvmpipe'},
+                          clear=True)
+        mocker.patch('framework.profile.os.cpu_count', return_value=16)
+
+    def test_hardware(self, mocker):
+        """Nothing changes without a software rasterizer."""
+        mocker.patch.dict('os.environ', {'GALLIUM_DRIVER': 'iris'})
+        assert profile.thread_budget('some', None) == (None, None, None)
+
+    def test_jobs(self):
+        """The cores are shared out between the given jobs."""
+        assert profile.thread_budget('all', 4) == (4, 4, 4)
+
+    def test_threads(self, mocker):
+        """Without jobs, LP_NUM_THREADS sets the number of jobs."""
+        mocker.patch.dict('os.environ', {'LP_NUM_THREADS': '4'})
+        assert profile.thread_budget('all', None) == (4, 4, 4)
+
+    def test_serial(self):
+        """The tests that aren't run concurrently get a larger share."""
+        assert profile.thread_budget('some', None) == (12, 1, 4)
+        assert profile.thread_budget('none', None) == (None, None, 16)
+
+    def test_budget(self, mocker):
+        """PIGLIT_THREAD_BUDGET overrides the number of cores."""
+        mocker.patch.dict('os.environ', {'PIGLIT_THREAD_BUDGET': '0'})
+        assert profile.thread_budget('all', None) == (None, None, None)
+
+
+class TestDevices(object):
+    """Tests for parse_device and Devices."""
+
+    def test_node(self):
+        """A path is used as WAFFLE_GBM_DEVICE."""
+        assert profile.parse_device('/dev/dri/renderD129') == \
+            {'WAFFLE_GBM_DEVICE': '/dev/dri/renderD129'}
+
+    def test_assignments(self):
+        """Assignments are set as they are."""
+        assert profile.parse_device('DRI_PRIME=1,FOO=a=b') == \
+            {'DRI_PRIME': '1', 'FOO': 'a=b'}
+
+    def test_invalid(self):
+        """An assignment without a variable is an error."""
+        with pytest.raises(exceptions.PiglitFatalError):
+            profile.parse_device('=1')
+
+    def test_pinned(self):
+        """A thread keeps the device it was given first."""
+        devices = profile.Devices(['DRI_PRIME=1', 'DRI_PRIME=2'])
+        tests = [utils.Test(['foo']) for _ in range(3)]
+        assert [devices.pin(t) for t in tests] == ['DRI_PRIME=1'] * 3
+        assert all(t.env == {'DRI_PRIME': '1'} for t in tests)
+
+    def test_threads(self):
+        """The threads are given the devices in turn."""
+        devices = profile.Devices(['DRI_PRIME=1', 'DRI_PRIME=2'])
+        pinned = []
+
+        def run():
+            pinned.append(devices.pin(utils.Test(['foo'])))
+
+        threads = [threading.Thread(target=run) for _ in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert sorted(pinned) == ['DRI_PRIME=1', 'DRI_PRIME=1',
+                                  'DRI_PRIME=2', 'DRI_PRIME=2']
+
+    def test_own_env(self):
+        """The environment of a test wins over the one of its device."""
+        test = utils.Test(['foo'])
+        test.env['DRI_PRIME'] = '0'
+        profile.Devices(['DRI_PRIME=1']).pin(test)
+        assert test.env == {'DRI_PRIME': '0'}
+
+
+class TestResourceGate(object):
+    """Tests for the ResourceGate class."""
+
+    @staticmethod
+    def _run(tests):
+        """Run tests at once, returning the most that were in the gate."""
+        gate = profile.ResourceGate()
+        lock = threading.Lock()
+        inside = [0, 0]
+        barrier = threading.Barrier(len(tests), timeout=1)
+
+        def run(test):
+            try:
+                barrier.wait()
+            except threading.BrokenBarrierError:
+                pass
+            with gate.admit(test):
+                with lock:
+                    inside[0] += 1
+                    inside[1] = max(inside)
+                time.sleep(0.05)
+                with lock:
+                    inside[0] -= 1
+
+        threads = [threading.Thread(target=run, args=(t, )) for t in tests]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        return inside[1]
+
+    def test_heavy(self):
+        """Tests that use all of a resource run one at a time."""
+        assert self._run([utils.Test(['a'], resource_class='vram'),
+                          utils.Test(['b'], resource_class='vram')]) == 1
+
+    def test_shares(self):
+        """Tests whose shares fit run at once."""
+        assert self._run([
+            utils.Test(['a'], resource_class='vram', resource_weight=0.5),
+            utils.Test(['b'], resource_class='vram', resource_weight=0.5),
+        ]) == 2
+
+    def test_other_class(self):
+        """Tests of other classes or of none aren't held back."""
+        assert self._run([
+            utils.Test(['a'], resource_class='vram'),
+            utils.Test(['b'], resource_class='host_memory'),
+            utils.Test(['c']),
+        ]) == 3
+
+
+class TestRetry(object):
+    """Tests for running the tests that failed again at the end of run()."""
+
+    class _Backend(object):
+        def __init__(self):
+            self.written = {}
+
+        @contextlib.contextmanager
+        def write_test(self, name):
+            yield functools.partial(self.written.__setitem__, name)
+
+    @pytest.fixture(autouse=True)
+    def retries(self, mocker):
+        mocker.patch('framework.profile.OPTIONS.retries', 2)
+
+    def _run(self, statuses):
+        """Run a test that ends with each of statuses in turn."""
+        statuses = iter(statuses)
+        test = utils.Test(['foo'], run_concurrent=True)
+
+        def run():
+            test.result.result = next(statuses)
+
+        test.run = run
+        prof = profile.TestProfile()
+        prof.test_list['group/test'] = test
+        backend = self._Backend()
+        profile.run([prof], 'dummy', backend, 'some', 2)
+        return backend.written['group/test']
+
+    def test_pass(self):
+        """A test that passes is run once."""
+        result = self._run(['pass'])
+        assert result.result is status.PASS
+        assert result.attempts == []
+
+    def test_flaky(self):
+        """A test that passes when run again keeps its failure."""
+        result = self._run(['fail', 'pass'])
+        assert result.result is status.PASS
+        assert [str(a['result']) for a in result.attempts] == ['fail']
+
+    def test_retries(self):
+        """A test is run at most OPTIONS.retries more times."""
+        result = self._run(['crash', 'fail', 'crash', 'pass'])
+        assert result.result is status.CRASH
+        assert [str(a['result']) for a in result.attempts] == \
+            ['crash', 'fail']
+
+    def test_disabled(self, mocker):
+        """Without OPTIONS.retries failures are final."""
+        mocker.patch('framework.profile.OPTIONS.retries', 0)
+        result = self._run(['fail', 'pass'])
+        assert result.result is status.FAIL
+        assert result.attempts == []
+
+
+class TestGpuHang(object):
+    """Tests for run() with OPTIONS.gpu_hang_detection."""
+
+    class _Hangs(object):
+        """A GpuHangMonitor that sees a hang during the first test."""
+
+        def __init__(self):
+            self.hangs = 0
+            self.waits = 0
+
+        def wait(self):
+            self.waits += 1
+            return self.hangs
+
+        def hung_since(self, hangs):
+            self.hangs = 1
+            return hangs == 0
+
+        def stop(self):
+            pass
+
+    def test_rerun(self, mocker):
+        """A test running during a hang is run again once it recovered."""
+        hangs = self._Hangs()
+        mocker.patch('framework.profile.OPTIONS.gpu_hang_detection', True)
+        mocker.patch('framework.profile.GpuHangMonitor', lambda: hangs)
+        statuses = iter(['timeout', 'pass'])
+        test = utils.Test(['foo'])
+
+        def run():
+            test.result.result = next(statuses)
+
+        test.run = run
+        prof = profile.TestProfile()
+        prof.test_list['group/test'] = test
+        backend = TestRetry._Backend()
+        profile.run([prof], 'dummy', backend, 'some', 2)
+
+        result = backend.written['group/test']
+        assert result.result is status.PASS
+        assert [str(a['result']) for a in result.attempts] == ['timeout']
+        assert hangs.waits == 2
+
+
+class TestOrderByPriority(object):
+    """Tests for the order_by_priority function."""
+
+    def test_order(self):
+        """Failures come first, then status changes, in their order."""
+        tests = [(n, None) for n in ['a', 'b', 'c', 'd', 'e']]
+        statuses = {
+            'b': ['pass', 'fail', 'pass'],
+            'c': ['fail'],
+            'd': ['pass', 'pass'],
+            'e': ['pass', 'crash'],
+        }
+        assert [n for n, _ in profile.order_by_priority(tests, statuses)] == \
+            ['c', 'e', 'b', 'a', 'd']
+
+    def test_no_statuses(self):
+        tests = [('a', None), ('b', None)]
+        assert profile.order_by_priority(iter(tests), None) == tests
+
+
+class TestMaxRegressions(object):
+    """Tests for run() with OPTIONS.prioritize and max_regressions."""
+
+    def test_stop(self, mocker):
+        """The run stops once there are max_regressions regressions."""
+        mocker.patch('framework.profile.OPTIONS.prioritize', 'history')
+        mocker.patch('framework.profile.OPTIONS.max_regressions', 1)
+        mocker.patch('framework.profile.load_statuses', return_value={
+            'a': ['pass'], 'b': ['pass'], 'c': ['fail']})
+        ran = []
+        prof = profile.TestProfile()
+        for name in ['a', 'b', 'c']:
+            test = utils.Test(['foo'])
+
+            def run(test=test, name=name):
+                ran.append(name)
+                test.result.result = 'fail'
+
+            test.run = run
+            prof.test_list[name] = test
+        backend = TestRetry._Backend()
+
+        with pytest.raises(exceptions.PiglitAbort):
+            profile.run([prof], 'dummy', backend, 'none', 1)
+        # c failed last time, so it runs first and isn't a regression
+        assert ran == ['c', 'a']
+        assert sorted(backend.written) == ['a', 'c']
+
+
+class TestOrderByDuration(object):
+    """Tests for the order_by_duration function."""
+
+    def test_no_durations(self):
+        """Without durations the profile order is kept."""
+        tests = [('a', None), ('b', None), ('c', None)]
+        assert profile.order_by_duration(iter(tests), None) == tests
+
+    def test_longest_first(self):
+        """Tests are sorted by decreasing duration."""
+        tests = [('a', None), ('b', None), ('c', None)]
+        durations = {'a': 1.0, 'b': 10.0, 'c': 5.0}
+        assert [n for n, _ in profile.order_by_duration(tests, durations)] \
+            == ['b', 'c', 'a']
+
+    def test_unknown_median(self):
+        """Tests without a duration are put with the median one."""
+        tests = [('a', None), ('new', None), ('b', None), ('c', None)]
+        durations = {'a': 1.0, 'b': 10.0, 'c': 5.0}
+        assert [n for n, _ in profile.order_by_duration(tests, durations)] \
+            == ['b', 'new', 'c', 'a']
+
+
+class TestXMLProfile(object):
+    """Tests for the XMLProfile class."""
+
+    @pytest.fixture
+    def xml(self, tmpdir, mocker):
+        """Serialize a profile larger than one gzip member."""
+        from tests import serializer
+
+        mocker.patch('tests.serializer.TESTS_PER_MEMBER', 4)
+        prof = profile.TestProfile()
+        for i in range(10):
+            prof.test_list[grouptools.join('group', 'test{}'.format(i))] = \
+                PiglitGLTest(['test{}'.format(i)], run_concurrent=i % 2)
+        filename = str(tmpdir.join('tests.xml.gz'))
+        serializer.serializer('tests', prof, filename)
+        return filename
+
+    @staticmethod
+    def _tests(filename, filters=()):
+        prof = profile.XMLProfile(filename)
+        prof.filters.extend(filters)
+        return [(n, t.command, t.run_concurrent)
+                for n, t in prof.itertests()]
+
+    def test_gzip(self, xml):
+        """The file is still a single gzip stream of XML."""
+        with gzip.open(xml, 'rt') as f:
+            root = et.parse(f).getroot()
+        assert len(root) == 10
+        assert root.attrib['count'] == '10'
+
+    def test_len(self, xml):
+        """The number of tests is read from the index."""
+        assert len(profile.XMLProfile(xml)) == 10
+
+    def test_same_tests(self, xml):
+        """The index gives the same tests as parsing the file."""
+        expected = self._tests(xml)
+        os.unlink(xml + '.index')
+        assert self._tests(xml) == expected
+
+    def test_filtered(self, xml):
+        """Name filters are applied using the index."""
+        filters = [profile.RegexFilter([r'test[15]$'])]
+        expected = self._tests(xml, filters)
+        assert [n for n, _, _ in expected] == \
+            [grouptools.join('group', 'test1'),
+             grouptools.join('group', 'test5')]
+        os.unlink(xml + '.index')
+        assert self._tests(xml, filters) == expected
+
+    def test_forced(self, xml, mocker):
+        """Only the tests of the forced test list are created."""
+        make_test = mocker.patch('framework.profile.make_test',
+                                 side_effect=profile.make_test)
+        prof = profile.XMLProfile(xml)
+        prof.forced_test_list = [grouptools.join('group', 'test3'),
+                                 grouptools.join('group', 'test1')]
+        assert [n for n, _ in prof.itertests()] == prof.forced_test_list
+        assert make_test.call_count == 2
+
+    def test_stale_index(self, xml):
+        """An index that doesn't match the file is ignored."""
+        with open(xml, 'ab') as f:
+            f.write(gzip.compress(b''))
+        assert len(self._tests(xml)) == 10
@@ -0,0 +1,202 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the resultcache module."""
+
+import os
+from unittest import mock
+
+import pytest
+
+from framework import dmesg, log, monitoring, resultcache, status
+from framework.results import TestResult
+
+from . import utils
+
+# pylint: disable=no-self-use,protected-access
+
+
+@pytest.fixture
+def cache(tmpdir):
+    return resultcache.ResultCache(str(tmpdir), 'driver')
+
+
+@pytest.fixture
+def binary(tmpdir):
+    path = tmpdir.join('bin', 'test')
+    path.write('binary', ensure=True)
+    return str(path)
+
+
+def _result(result):
+    res = TestResult(result)
+    res.out = 'output'
+    res.returncode = 0
+    return res
+
+
+class TestKey(object):
+    """Tests for ResultCache.key."""
+
+    def test_same(self, cache, binary):
+        """The same test has the same key."""
+        assert (cache.key(utils.Test([binary, '-auto'])) ==
+                cache.key(utils.Test([binary, '-auto'])))
+
+    def test_command(self, cache, binary):
+        """The arguments are part of the key."""
+        assert (cache.key(utils.Test([binary, '-auto'])) !=
+                cache.key(utils.Test([binary, '-fbo'])))
+
+    def test_env(self, cache, binary):
+        """The environment of the test is part of the key."""
+        assert (cache.key(utils.Test([binary])) !=
+                cache.key(utils.Test([binary], env={'FOO': '1'})))
+
+    def test_binary_changed(self, cache, binary):
+        """Changing the executable changes the key."""
+        key = cache.key(utils.Test([binary]))
+        with open(binary, 'w') as f:
+            f.write('rebuilt binary')
+        assert cache.key(utils.Test([binary])) != key
+
+    def test_input_changed(self, cache, binary, tmpdir):
+        """Changing a file named on the command line changes the key."""
+        shader = tmpdir.join('test.shader_test')
+        shader.write('[test]')
+        key = cache.key(utils.Test([binary, str(shader)]))
+        shader.write('[test]\ndraw rect -1 -1 2 2')
+        assert cache.key(utils.Test([binary, str(shader)])) != key
+
+    def test_not_cached(self, cache, binary):
+        """Tests that set cache_results to False have no key."""
+        test = utils.Test([binary])
+        test.cache_results = False
+        assert cache.key(test) is None
+
+
+class TestLoadStore(object):
+    """Tests for ResultCache.load and ResultCache.store."""
+
+    def test_roundtrip(self, cache):
+        """A stored result is loaded and tagged."""
+        cache.store('key', _result(status.FAIL))
+        result = cache.load('key')
+        assert result.result is status.FAIL
+        assert result.out == 'output'
+        assert result.resources['cached'] is True
+
+    def test_miss(self, cache):
+        """Nothing is loaded for a key that wasn't stored."""
+        assert cache.load('key') is None
+
+    @pytest.mark.parametrize('result', [status.CRASH, status.TIMEOUT,
+                                        status.DMESG_FAIL])
+    def test_not_stored(self, cache, result):
+        """Results that may not come from the test are not stored."""
+        cache.store('key', _result(result))
+        assert cache.load('key') is None
+
+    def test_exception(self, cache):
+        """Failures of piglit itself are not stored."""
+        result = _result(status.FAIL)
+        result.exception = 'Exception'
+        cache.store('key', result)
+        assert cache.load('key') is None
+
+    def test_refresh(self, cache, tmpdir):
+        """A refreshing cache stores results but doesn't load them."""
+        refresh = resultcache.ResultCache(str(tmpdir), 'driver', refresh=True)
+        refresh.store('key', _result(status.PASS))
+        assert refresh.load('key') is None
+        assert cache.load('key').result is status.PASS
+
+    def test_driver(self, cache, tmpdir):
+        """The results of another driver are not loaded."""
+        cache.store('key', _result(status.PASS))
+        other = resultcache.ResultCache(str(tmpdir), 'other')
+        assert other.load('key') is None
+
+    def test_prune(self, tmpdir):
+        """Only the results of the last few drivers are kept."""
+        for i in range(resultcache._KEEP_DRIVERS + 2):
+            resultcache.ResultCache(str(tmpdir), 'driver{}'.format(i))
+            os.utime(str(tmpdir.join('driver{}'.format(i))), (i, i))
+        resultcache.ResultCache(str(tmpdir), 'driver0')
+        assert len(tmpdir.listdir()) == resultcache._KEEP_DRIVERS
+        assert tmpdir.join('driver0').check()
+        assert not tmpdir.join('driver1').check()
+
+
+class TestExecute(object):
+    """Tests for the use of the cache by Test.execute."""
+
+    @pytest.fixture(autouse=True)
+    def patch(self, tmpdir):
+        with mock.patch.dict('os.environ',
+                             {'PIGLIT_CACHE_DIR': str(tmpdir)}), \
+                mock.patch('framework.resultcache.driver_identity',
+                           return_value='driver'), \
+                mock.patch('framework.resultcache._CACHE', None), \
+                mock.patch('framework.resultcache.OPTIONS.result_cache', 'on'):
+            yield
+
+    @staticmethod
+    def _execute(binary):
+        test = utils.Test([binary])
+        test.run = mock.Mock(side_effect=lambda: setattr(
+            test.result, 'result', status.PASS))
+        dmesg_ = mock.Mock(spec=dmesg.BaseDmesg)
+        dmesg_.update_result.side_effect = lambda r: r
+        test.execute('test', mock.Mock(spec=log.BaseLog),
+                     {'dmesg': dmesg_,
+                      'monitor': mock.Mock(spec=monitoring.Monitoring)})
+        return test
+
+    def test_hit(self, binary):
+        """The second run of a test reuses the result of the first."""
+        assert self._execute(binary).run.called
+        test = self._execute(binary)
+        assert not test.run.called
+        assert test.result.result is status.PASS
+
+    def test_refresh(self, binary):
+        """With refresh every test is run."""
+        self._execute(binary)
+        with mock.patch('framework.resultcache._CACHE', None), \
+                mock.patch('framework.resultcache.OPTIONS.result_cache',
+                           'refresh'):
+            assert self._execute(binary).run.called
+
+    def test_driver_changed(self, binary):
+        """A new driver runs every test again."""
+        self._execute(binary)
+        with mock.patch('framework.resultcache._CACHE', None), \
+                mock.patch('framework.resultcache.driver_identity',
+                           return_value='rebuilt'):
+            assert self._execute(binary).run.called
+
+    def test_no_driver(self, binary):
+        """Nothing is cached when the driver can't be identified."""
+        with mock.patch('framework.resultcache.driver_identity',
+                        return_value=None):
+            self._execute(binary)
+            assert self._execute(binary).run.called
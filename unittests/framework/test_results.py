@@ -21,6 +21,8 @@
 
 """Tests for the results module."""
 
+import collections
+
 import pytest
 
 from framework import exceptions
@@ -76,6 +78,24 @@ class TestSubtests(object):
 
         assert test['foo'] is status.PASS
 
+    def test_times(self, subtest):
+        """results.Subtests.from_dict: restores the times of subtests"""
+        subtest['foo'] = status.PASS
+        subtest['bar'] = status.FAIL
+        subtest.set_time('Foo', 1.5)
+        test = results.Subtests.from_dict(subtest.to_json())
+
+        assert test.times == {'foo': 1.5}
+        assert dict(test) == dict(subtest)
+
+    def test_delete_time(self, subtest):
+        """results.Subtests.__delitem__: removes the time of the subtest"""
+        subtest['foo'] = status.PASS
+        subtest.set_time('foo', 1.5)
+        del subtest['foo']
+
+        assert subtest.times == {}
+
 
 class TestTestResult(object):
     """Tests for the TestResult class."""
@@ -111,6 +131,10 @@ class TestTestResult(object):
                     'exception': 'an exception',
                     'dmesg': 'this is dmesg',
                     'pid': [1934],
+                    'metrics': {
+                        '1M': {'value': 4.5, 'unit': 'GB/s'},
+                    },
+                    'resources': {'utime': 0.5, 'maxrss': 4096},
                 }
 
                 cls.test = results.TestResult.from_dict(cls.dict)
@@ -167,6 +191,14 @@ class TestTestResult(object):
                 """sets pid properly."""
                 assert self.test.pid == self.dict['pid']
 
+            def test_metrics(self):
+                """sets metrics properly."""
+                assert self.test.metrics == self.dict['metrics']
+
+            def test_resources(self):
+                """sets resources properly."""
+                assert self.test.resources == self.dict['resources']
+
         class TestResult(object):
             """Tests for TestResult.result getter and setter methods."""
 
@@ -228,6 +260,8 @@ class TestTestResult(object):
             test.dmesg = 'this is dmesg'
             test.pid = 1934
             test.traceback = 'a traceback'
+            test.metrics['1M'] = {'value': 4.5, 'unit': 'GB/s'}
+            test.resources['utime'] = 0.5
 
             cls.test = test
             cls.json = test.to_json()
@@ -280,6 +314,14 @@ class TestTestResult(object):
             """results.TestResult.to_json: Adds the traceback attribute"""
             assert self.test.traceback == self.json['traceback']
 
+        def test_metrics(self):
+            """results.TestResult.to_json: Adds the metrics attribute"""
+            assert self.test.metrics == self.json['metrics']
+
+        def test_resources(self):
+            """results.TestResult.to_json: Adds the resources attribute"""
+            assert self.test.resources == self.json['resources']
+
     class TestUpdate(object):
         """Tests for TestResult.update."""
 
@@ -295,6 +337,78 @@ class TestTestResult(object):
             test.update({'subtest': {'result': 'incomplete'}})
             assert test.subtests['result'] == 'incomplete'
 
+        def test_subtest_time(self):
+            """results.TestResult.update: the time of a subtest is stored"""
+            test = results.TestResult('pass')
+            test.update({'subtest': {'Foo': 'pass'}, 'time': 0.25})
+            assert test.subtests['foo'] is status.PASS
+            assert test.subtests.times == {'foo': 0.25}
+
+        def test_gpu(self):
+            """results.TestResult.update: gpu usage is stored"""
+            test = results.TestResult('pass')
+            test.update({'gpu': {'render': 1000}})
+            assert test.resources['gpu'] == {'render': 1000}
+
+        def test_metrics(self):
+            """results.TestResult.update: metrics are stored without a result"""
+            test = results.TestResult('pass')
+            test.update({'metrics': {'line 3 cpu': {'value': 10, 'unit': 'ns'}}})
+            assert test.result == 'pass'
+            assert test.metrics['line 3 cpu'] == {'value': 10, 'unit': 'ns'}
+
+    class TestAddRusage(object):
+        """Tests for TestResult.add_rusage."""
+
+        Rusage = collections.namedtuple(
+            'Rusage', ['ru_utime', 'ru_stime', 'ru_maxrss', 'ru_nvcsw',
+                       'ru_nivcsw'])
+
+        def test_accumulates(self, mocker):
+            """results.TestResult.add_rusage: sums the processes of a test"""
+            mocker.patch('framework.results.sys.platform', 'linux')
+            test = results.TestResult('pass')
+            test.add_rusage(self.Rusage(1.0, 0.5, 100, 2, 3))
+            test.add_rusage(self.Rusage(2.0, 0.25, 50, 1, 1))
+
+            assert test.resources == {
+                'utime': 3.0, 'stime': 0.75, 'maxrss': 100 * 1024,
+                'nvcsw': 3, 'nivcsw': 4}
+
+    class TestAddAttempt(object):
+        """Tests for TestResult.add_attempt."""
+
+        def test_kept(self):
+            """results.TestResult.add_attempt: keeps the status and output"""
+            first = results.TestResult('fail')
+            first.out = 'first'
+            first.command = 'foo'
+            test = results.TestResult('pass')
+            test.add_attempt(first)
+
+            assert len(test.attempts) == 1
+            assert test.attempts[0]['result'] is status.FAIL
+            assert test.attempts[0]['out'] == 'first'
+            assert 'command' not in test.attempts[0]
+
+        def test_oldest_first(self):
+            """results.TestResult.add_attempt: keeps the earlier attempts"""
+            first = results.TestResult('crash')
+            second = results.TestResult('fail')
+            second.add_attempt(first)
+            test = results.TestResult('pass')
+            test.add_attempt(second)
+
+            assert [a['result'] for a in test.attempts] == \
+                [status.CRASH, status.FAIL]
+
+        def test_json(self):
+            """results.TestResult.add_attempt: attempts survive to_json"""
+            test = results.TestResult('pass')
+            test.add_attempt(results.TestResult('fail'))
+            loaded = results.TestResult.from_dict(test.to_json())
+            assert loaded.attempts == test.attempts
+
     class TestTotals(object):
         """Test the totals generated by TestrunResult.calculate_group_totals().
         """
@@ -384,6 +498,38 @@ class TestTestResult(object):
                 dict(expect)
 
 
+class TestLazyTestResult(object):
+    """Tests for the LazyTestResult class."""
+
+    @staticmethod
+    def make(calls):
+        full = results.TestResult('fail')
+        full.out = 'stdout'
+        full.command = 'foo -auto'
+
+        def load():
+            calls.append(None)
+            return full.to_json()
+
+        eager = {k: v for k, v in full.to_json().items()
+                 if k in results.LazyTestResult.EAGER}
+        return results.LazyTestResult.from_dict(eager, load)
+
+    def test_eager_without_load(self):
+        """The result is available without loading anything."""
+        calls = []
+        assert self.make(calls).result is status.FAIL
+        assert not calls
+
+    def test_lazy_loaded(self):
+        """The text fields are loaded on first use."""
+        calls = []
+        test = self.make(calls)
+        assert test.out == 'stdout'
+        assert test.command == 'foo -auto'
+        assert len(calls) == 1
+
+
 class TestStringDescriptor(object):
     """Test class for StringDescriptor."""
 
@@ -0,0 +1,184 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the shadercache module."""
+
+import json
+import os
+import tarfile
+
+import pytest
+
+from framework import exceptions, shadercache
+from framework.results import TestResult
+
+# pylint: disable=no-self-use
+
+
+@pytest.fixture
+def env(mocker):
+    env = {}
+    mocker.patch('framework.shadercache.OPTIONS.env', env)
+    return env
+
+
+@pytest.fixture
+def seed(tmpdir):
+    tmpdir.join('seed', 'mesa_shader_cache', 'index').write(
+        'entry', ensure=True)
+    return tmpdir.join('seed')
+
+
+class TestSetup(object):
+    """Tests for setup."""
+
+    def test_inherit(self, env, tmpdir):
+        """The environment is left alone by default."""
+        assert shadercache.setup('inherit', str(tmpdir)) is None
+        assert env == {}
+
+    def test_cold(self, env, tmpdir):
+        """A cold cache is a new directory in the results."""
+        stale = tmpdir.join('shader-cache', 'stale')
+        stale.write('stale', ensure=True)
+
+        directory = shadercache.setup('cold', str(tmpdir))
+
+        assert directory == str(tmpdir.join('shader-cache'))
+        assert os.listdir(directory) == []
+        assert env['MESA_SHADER_CACHE_DIR'] == directory
+        assert env['__GL_SHADER_DISK_CACHE_PATH'] == directory
+        assert env['MESA_SHADER_CACHE_SHOW_STATS'] == 'true'
+
+    def test_resume(self, env, tmpdir):
+        """A resumed run keeps the cache it had."""
+        tmpdir.join('shader-cache', 'entry').write('entry', ensure=True)
+
+        directory = shadercache.setup('cold', str(tmpdir), resume=True)
+
+        assert os.listdir(directory) == ['entry']
+
+    def test_seed_directory(self, env, tmpdir, seed):
+        """A seeded cache is a copy of the directory."""
+        results = tmpdir.join('results')
+        directory = shadercache.setup('seed', str(results), str(seed))
+
+        assert directory == str(results.join('shader-cache'))
+        assert results.join('shader-cache', 'mesa_shader_cache',
+                            'index').read() == 'entry'
+        assert seed.join('mesa_shader_cache', 'index').check()
+
+    @pytest.mark.parametrize('arcname', ['.', 'shader-cache'])
+    def test_seed_archive(self, env, tmpdir, seed, arcname):
+        """A seeded cache is restored from an archive of the cache or of its
+        directory.
+        """
+        archive = str(tmpdir.join('cache.tar.gz'))
+        with tarfile.open(archive, 'w:gz') as tar:
+            tar.add(str(seed), arcname=arcname)
+        results = tmpdir.join('results')
+
+        shadercache.setup('seed', str(results), archive)
+
+        assert results.join('shader-cache', 'mesa_shader_cache',
+                            'index').read() == 'entry'
+
+    def test_seed_bad_source(self, env, tmpdir):
+        """Seeding from a file that isn't an archive is an error."""
+        tmpdir.join('cache').write('not an archive')
+        with pytest.raises(exceptions.PiglitFatalError):
+            shadercache.setup('seed', str(tmpdir.join('results')),
+                              str(tmpdir.join('cache')))
+
+    def test_shared(self, env, tmpdir):
+        """A shared cache is used where it is."""
+        shared = tmpdir.join('shared')
+        directory = shadercache.setup('shared', str(tmpdir.join('results')),
+                                      str(shared))
+
+        assert directory == str(shared)
+        assert shared.check(dir=True)
+        assert env['MESA_SHADER_CACHE_DIR'] == str(shared)
+
+    @pytest.mark.parametrize('mode', ['seed', 'shared'])
+    def test_needs_dir(self, env, tmpdir, mode):
+        """The seed and shared modes need a directory."""
+        with pytest.raises(exceptions.PiglitFatalError):
+            shadercache.setup(mode, str(tmpdir))
+
+
+class TestParseStats(object):
+    """Tests for parse_stats."""
+
+    def test_none(self):
+        """Output without stats has none."""
+        assert shadercache.parse_stats('PIGLIT: {"result": "pass" }') is None
+
+    def test_sum(self):
+        """The stats of each cache of the process are added up."""
+        output = ('disk shader cache:  hits = 3, misses = 1\n'
+                  'PIGLIT: {"result": "pass" }\n'
+                  'disk shader cache:  hits = 2, misses = 0\n')
+        assert shadercache.parse_stats(output) == {'hits': 5, 'misses': 1}
+
+
+class TestTotals(object):
+    """Tests for Totals."""
+
+    @staticmethod
+    def _result(hits, misses, cached=False):
+        result = TestResult('pass')
+        result.resources['shader_cache'] = {'hits': hits, 'misses': misses}
+        if cached:
+            result.resources['cached'] = True
+        return result
+
+    def test_add(self):
+        """The stats of the results are added up."""
+        totals = shadercache.Totals()
+        totals.add(self._result(3, 1))
+        totals.add(self._result(1, 3))
+        totals.add(TestResult('pass'))
+
+        assert (totals.hits, totals.misses, totals.tests) == (4, 4, 2)
+        assert str(totals) == \
+            'shader cache: 4 hits, 4 misses (50.0% hit rate)'
+
+    def test_cached(self):
+        """Results from the result cache aren't counted."""
+        totals = shadercache.Totals()
+        totals.add(self._result(3, 1, cached=True))
+
+        assert totals.tests == 0
+
+    def test_write(self, mocker, tmpdir):
+        """The totals are written to the results."""
+        mocker.patch('framework.shadercache.OPTIONS.shader_cache', 'cold')
+        totals = shadercache.Totals()
+        totals.add(self._result(3, 1))
+
+        totals.write(str(tmpdir), '/cache')
+
+        with open(str(tmpdir.join('shader-cache.json'))) as f:
+            data = json.load(f)
+        assert data['mode'] == 'cold'
+        assert data['directory'] == '/cache'
+        assert (data['hits'], data['misses'], data['tests']) == (3, 1, 1)
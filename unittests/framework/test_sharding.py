@@ -0,0 +1,97 @@
+# coding=utf-8
+# Copyright (c) 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests for the framework.sharding module."""
+
+import contextlib
+
+from framework import sharding
+from framework import status
+from framework.log import DummyLog
+
+# pylint: disable=invalid-name,no-self-use,protected-access
+
+
+class TestWorkQueue(object):
+    """Tests for the WorkQueue class."""
+
+    def test_take_in_order(self):
+        """Tests are handed out in order, in chunks."""
+        q = sharding.WorkQueue(['a', 'b', 'c'])
+        assert q.take('w1', 2) == (['a', 'b'], ['a', 'b'])
+        assert q.take('w2', 2) == (['c'], ['c'])
+
+    def test_steal(self):
+        """Once all tests are handed out, running ones are handed out again."""
+        q = sharding.WorkQueue(['a', 'b'])
+        q.take('w1', 2)
+        assert q.take('w2', 1) == (['a'], [])
+
+    def test_no_steal_from_self(self):
+        """A worker doesn't get a test it is already running."""
+        q = sharding.WorkQueue(['a'])
+        q.take('w1', 1)
+        assert q.take('w1', 1) == ([], [])
+
+    def test_max_copies(self):
+        """A test isn't run by more than MAX_COPIES workers."""
+        q = sharding.WorkQueue(['a'])
+        for i in range(sharding.MAX_COPIES):
+            q.take('w{}'.format(i), 1)
+        assert q.take('other', 1) == ([], [])
+
+    def test_complete_first_only(self):
+        """Only the first result of a test counts."""
+        q = sharding.WorkQueue(['a'])
+        q.take('w1', 1)
+        q.take('w2', 1)
+        assert q.complete('a')
+        assert not q.complete('a')
+        assert q.finished
+
+
+class _Backend(object):
+    def __init__(self):
+        self.written = {}
+
+    @contextlib.contextmanager
+    def write_test(self, name):
+        yield lambda r: self.written.setdefault(name, []).append(r)
+
+
+class _Log(object):
+    def get(self):
+        return DummyLog(None, None)
+
+
+class TestCoordinator(object):
+    """Tests for the Coordinator class."""
+
+    def test_report_first_result_wins(self):
+        """A result coming back from a second worker is dropped."""
+        backend = _Backend()
+        c = sharding.Coordinator(['a'], backend, _Log())
+        c.assign('w1', 1)
+        c.assign('w2', 1)
+        c.report('a', {'result': 'pass'})
+        c.report('a', {'result': 'fail'})
+        assert len(backend.written['a']) == 1
+        assert backend.written['a'][0].result == status.PASS
@@ -21,6 +21,7 @@
 
 """Test the wflinfo module."""
 
+import struct
 import subprocess
 import textwrap
 from unittest import mock
@@ -45,6 +46,13 @@ def _has_wflinfo():
     return True
 
 
+@pytest.fixture(autouse=True)
+def cache_dir(tmpdir):
+    """Keep the profiles cached by one test from the others."""
+    with mock.patch.dict('os.environ', {'PIGLIT_CACHE_DIR': str(tmpdir)}):
+        yield
+
+
 @pytest.mark.skipif(not _has_wflinfo(), reason="Tests require wflinfo binary.")
 class TestWflInfo(object):
     """Tests for the WflInfo class."""
@@ -352,3 +360,88 @@ class TestWflInfo(object):
             gracefully.
             """
             assert inst.core.shader_version == 0.0
+
+
+class TestElfBuildId(object):
+    """Tests for wflinfo._elf_build_id."""
+
+    def test_build_id(self, tmpdir):
+        """The build-id note of a 64-bit ELF file is found."""
+        note = struct.pack('<III', 4, 4, 3) + b'GNU\0' + b'\x12\x34\x56\x78'
+        header = (b'\x7fELF\x02\x01' + b'\0' * 26 + struct.pack('<Q', 64) +
+                  b'\0' * 14 + struct.pack('<HH', 56, 1) + b'\0' * 6)
+        phdr = struct.pack('<IIQQQQQQ', 4, 0, 120, 0, 0, len(note), 0, 4)
+        f = tmpdir.join('libfoo.so')
+        f.write_binary(header + phdr + note)
+
+        assert wflinfo._elf_build_id(str(f)) == '12345678'
+
+    def test_not_elf(self, tmpdir):
+        """Files that aren't ELF have no build-id."""
+        f = tmpdir.join('libfoo.so')
+        f.write('INPUT(libfoo.so.1)')
+
+        assert wflinfo._elf_build_id(str(f)) is None
+
+
+class TestCache(object):
+    """Tests for the profiles cached between runs."""
+
+    OUTPUT = textwrap.dedent("""\
+        OpenGL version string: 4.6 (Core Profile) Mesa 24.0.0
+        OpenGL shading language version string: 4.60
+        OpenGL extensions: GL_foobar
+    """).encode('utf-8')
+
+    @pytest.fixture(autouse=True)
+    def patch(self):
+        self.check_output = mock.Mock(return_value=self.OUTPUT)
+        with mock.patch.dict('framework.wflinfo.OPTIONS.env',
+                             {'PIGLIT_PLATFORM': 'gbm'}), \
+                mock.patch('framework.wflinfo._driver_files',
+                           mock.Mock(return_value=[('libEGL_mesa.so', None)])), \
+                mock.patch('framework.wflinfo._elf_build_id',
+                           mock.Mock(return_value='0123')), \
+                mock.patch('framework.wflinfo.subprocess.check_output',
+                           self.check_output), \
+                mock.patch('framework.wflinfo.WflInfo._WflInfo__shared_state',
+                           {}):
+            yield
+
+    @staticmethod
+    def next_run():
+        return mock.patch('framework.wflinfo.WflInfo._WflInfo__shared_state',
+                          {})
+
+    def test_probes_all_profiles(self):
+        """A miss probes every profile, without a call for the identity."""
+        assert wflinfo.WflInfo().core.api_version == 4.6
+
+        apis = sorted(c[0][0][c[0][0].index('--api') + 1:]
+                      for c in self.check_output.call_args_list)
+        assert apis == [['gl', '--profile', 'compat'],
+                        ['gl', '--profile', 'core'],
+                        ['gl', '--profile', 'none'],
+                        ['gles1'], ['gles2']]
+
+    def test_hit(self):
+        """A later run gets every profile without calling wflinfo."""
+        wflinfo.WflInfo().core
+        calls = self.check_output.call_count
+
+        with self.next_run():
+            info = wflinfo.WflInfo()
+            assert info.compat.shader_version == 4.6
+            assert info.es2.extensions == {'GL_foobar'}
+        assert self.check_output.call_count == calls
+
+    def test_driver_changed(self):
+        """A driver with another build-id is probed again."""
+        wflinfo.WflInfo().core
+        calls = self.check_output.call_count
+
+        with self.next_run(), \
+                mock.patch('framework.wflinfo._elf_build_id',
+                           mock.Mock(return_value='4567')):
+            wflinfo.WflInfo().core
+        assert self.check_output.call_count == 2 * calls
@@ -0,0 +1,129 @@
+# encoding=utf-8
+# Copyright © 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Tests from generated_tests/modules/clpack.py"""
+
+import struct
+
+import pytest
+
+# pylint can't figure out the sys.path manipulation.
+from generated_tests.modules import clpack  # pylint: disable=import-error,wrong-import-order
+
+
+def unpack(packed):
+    """Return the config, source and data of a packed test."""
+    fields = clpack._HEADER.unpack_from(packed)
+    magic, version, byte_order = fields[:3]
+    config_offset, config_size, source_offset, source_size, \
+        data_offset, data_size = fields[3:]
+
+    assert magic == clpack.MAGIC
+    assert version == clpack.VERSION
+    assert byte_order == clpack.BYTE_ORDER
+    assert data_offset % 16 == 0
+
+    config = packed[config_offset:config_offset + config_size]
+    source = packed[source_offset:source_offset + source_size]
+    data = packed[data_offset:data_offset + data_size]
+    assert config.endswith(b'\0')
+
+    return config[:-1].decode('utf-8'), source, data
+
+
+class TestPack(object):
+    """Tests for clpack.pack."""
+
+    def test_float_buffer(self):
+        """Buffer values are replaced by a reference to the data."""
+        config, _, data = unpack(clpack.pack(
+            '[test]\narg_in: 1 buffer float[2] 1.5 -2\n', False))
+
+        assert config == '[test]\narg_in: 1 buffer float[2] packed 0\n'
+        assert data[:8] == struct.pack('=2f', 1.5, -2)
+
+    def test_tolerance_is_kept(self):
+        """The tolerance of an out argument stays after the reference."""
+        config, _, _ = unpack(clpack.pack(
+            'arg_out: 0 buffer double[1] 0.5 tolerance 4 ulp', False))
+
+        assert config == 'arg_out: 0 buffer double[1] packed 0 tolerance 4 ulp'
+
+    def test_vec3_padding(self):
+        """3-component vectors are padded to 4."""
+        _, _, data = unpack(clpack.pack(
+            'arg_in: 0 buffer int3[1] 1 2 3', False))
+
+        assert data[:16] == struct.pack('=4i', 1, 2, 3, 0)
+
+    def test_values_are_aligned(self):
+        """Every value starts at a multiple of 16 bytes."""
+        config, _, _ = unpack(clpack.pack(
+            'arg_in: 0 buffer char[1] 1\narg_in: 1 buffer char[1] 2', False))
+
+        assert config.split('\n')[1] == 'arg_in: 1 buffer char[1] packed 16'
+
+    @pytest.mark.parametrize("type_, token, expected", [
+        ('int', '0x10', struct.pack('=i', 16)),
+        ('int', '010', struct.pack('=i', 8)),
+        ('char', '-1', struct.pack('=b', -1)),
+        ('uint', '4294967296', struct.pack('=I', 0)),
+        ('long', '18446744073709551615', struct.pack('=q', -1)),
+        ('float', '1e39', struct.pack('=f', float('inf'))),
+        ('float', '-inf', struct.pack('=f', float('-inf'))),
+        ('double', '0x1.8p1', struct.pack('=d', 3.0)),
+    ])
+    def test_conversion(self, type_, token, expected):
+        """Values are converted like cl-program-tester converts them."""
+        _, _, data = unpack(clpack.pack(
+            'arg_in: 0 buffer {}[1] {}'.format(type_, token), False))
+
+        assert data[:len(expected)] == expected
+
+    @pytest.mark.parametrize("line", [
+        'arg_in: 0 buffer half[1] 1.0',
+        'arg_in: 0 buffer float[2] 1.0',
+        'arg_in: 0 buffer float[1] random',
+        'arg_in: 0 buffer int[2] repeat 1',
+        'arg_in: 0 buffer uint[1] -1',
+        'arg_in: 0 buffer float[1] 1.0 # comment',
+        'arg_in: 0 int 5',
+    ])
+    def test_unpacked(self, line):
+        """What can't be packed exactly stays as it is."""
+        config, _, data = unpack(clpack.pack(line, False))
+
+        assert config == line
+        assert data == b''
+
+    def test_source(self):
+        """The comment config is cut from the source, keeping line numbers."""
+        text = ('/*!\n[config]\n[test]\narg_in: 0 buffer int[1] 1\n!*/\n'
+                'kernel void k() {}\n')
+        config, source, _ = unpack(clpack.pack(text, True))
+
+        assert config == '\n[config]\n[test]\narg_in: 0 buffer int[1] packed 0\n'
+        assert source == b'\n\n\n\n\nkernel void k() {}\n\0'
+
+    def test_no_comment_config(self):
+        """A program without comment config can't be packed."""
+        with pytest.raises(ValueError):
+            clpack.pack('kernel void k() {}\n', True)
@@ -0,0 +1,167 @@
+# encoding=utf-8
+# Copyright © 2026 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+
+"""Tests from generated_tests/modules/utils.py"""
+
+import os
+from unittest import mock
+
+import pytest
+
+# pylint can't figure out the sys.path manipulation.
+from generated_tests.modules import utils  # pylint: disable=import-error,wrong-import-order
+
+
+class TestOpenIfChanged(object):
+    """Tests for utils.open_if_changed."""
+
+    def test_writes_new(self, tmpdir):
+        """A file that doesn't exist is written."""
+        name = str(tmpdir.join('test'))
+        with utils.open_if_changed(name) as f:
+            f.write('foo\n')
+
+        assert tmpdir.join('test').read() == 'foo\n'
+
+    def test_written_on_close(self, tmpdir):
+        """Nothing is written before the file is closed."""
+        name = str(tmpdir.join('test'))
+        f = utils.open_if_changed(name)
+        f.write('foo\n')
+        assert not tmpdir.join('test').check()
+
+        f.close()
+        assert tmpdir.join('test').read() == 'foo\n'
+
+    def test_unchanged_not_written(self, tmpdir):
+        """A file with the same contents isn't written again."""
+        test = tmpdir.join('test')
+        test.write('foo\n')
+        os.utime(str(test), (0, 0))
+
+        with utils.open_if_changed(str(test)) as f:
+            f.write('foo\n')
+
+        assert test.mtime() == 0
+
+    def test_changed_written(self, tmpdir):
+        """A file with other contents is replaced."""
+        test = tmpdir.join('test')
+        test.write('foo\n')
+
+        with utils.open_if_changed(str(test)) as f:
+            f.write('bar\n')
+
+        assert test.read() == 'bar\n'
+
+    def test_binary(self, tmpdir):
+        """Bytes are written in binary mode."""
+        name = str(tmpdir.join('test'))
+        with utils.open_if_changed(name, 'wb') as f:
+            f.write(b'\0\1')
+
+        assert tmpdir.join('test').read_binary() == b'\0\1'
+
+    def test_not_written_on_error(self, tmpdir):
+        """A file isn't written if an exception leaves the with block."""
+        name = str(tmpdir.join('test'))
+        with pytest.raises(RuntimeError):
+            with utils.open_if_changed(name) as f:
+                f.write('foo\n')
+                raise RuntimeError
+
+        assert not tmpdir.join('test').check()
+
+
+class TestShard(object):
+    """Tests for utils.shard."""
+
+    def test_no_shard(self):
+        """Without PIGLIT_GEN_SHARD every item is made."""
+        with mock.patch.dict('os.environ', clear=True):
+            assert list(utils.shard(range(5))) == [0, 1, 2, 3, 4]
+
+    @pytest.mark.parametrize("shard, expected", [
+        ('0/2', [0, 2, 4]),
+        ('1/2', [1, 3]),
+        ('2/3', [2]),
+    ])
+    def test_shard(self, shard, expected):
+        """A shard makes every count-th item from its index."""
+        with mock.patch.dict('os.environ', {'PIGLIT_GEN_SHARD': shard}):
+            assert list(utils.shard(range(5))) == expected
+
+    def test_invalid(self):
+        """An index past the count is an error."""
+        with mock.patch.dict('os.environ', {'PIGLIT_GEN_SHARD': '2/2'}):
+            with pytest.raises(ValueError):
+                list(utils.shard(range(5)))
+
+
+class TestCached(object):
+    """Tests for utils.cached."""
+
+    @staticmethod
+    def cache_dir(tmpdir):
+        return mock.patch.dict(
+            'os.environ', {'PIGLIT_GEN_CACHE_DIR': str(tmpdir.join('cache'))})
+
+    def test_computed_once(self, tmpdir):
+        """The value is computed once and loaded after that."""
+        source = tmpdir.join('source.py')
+        source.write('a = 1\n')
+        compute = mock.Mock(return_value={'a': [1, 2]})
+
+        with self.cache_dir(tmpdir):
+            assert utils.cached('test', [str(source)], compute) == {'a': [1, 2]}
+            assert utils.cached('test', [str(source)], compute) == {'a': [1, 2]}
+        assert compute.call_count == 1
+
+    def test_source_changed(self, tmpdir):
+        """The value is computed again when a source changes."""
+        source = tmpdir.join('source.py')
+        source.write('a = 1\n')
+
+        with self.cache_dir(tmpdir):
+            utils.cached('test', [str(source)], lambda: 1)
+            source.write('a = 2\n')
+            assert utils.cached('test', [str(source)], lambda: 2) == 2
+
+    def test_version_changed(self, tmpdir):
+        """The value is computed again when the version changes."""
+        source = tmpdir.join('source.py')
+        source.write('a = 1\n')
+
+        with self.cache_dir(tmpdir):
+            utils.cached('test', [str(source)], lambda: 1, '1.0')
+            assert utils.cached('test', [str(source)], lambda: 2, '2.0') == 2
+
+    def test_corrupt(self, tmpdir):
+        """A cache that can't be loaded is replaced."""
+        source = tmpdir.join('source.py')
+        source.write('a = 1\n')
+        tmpdir.join('cache').mkdir()
+        tmpdir.join('cache', 'test.pickle').write('garbage')
+
+        with self.cache_dir(tmpdir):
+            assert utils.cached('test', [str(source)], lambda: 3) == 3
+            assert utils.cached('test', [str(source)], lambda: 4) == 3